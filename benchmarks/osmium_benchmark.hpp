@@ -0,0 +1,728 @@
+#ifndef OSMIUM_BENCHMARK_HPP
+#define OSMIUM_BENCHMARK_HPP
+
+/*
+
+  A small benchmark harness with an interface modelled after Google
+  Benchmark. Command line options and the JSON output use the same names,
+  so tools written for Google Benchmark results can be used on the output.
+
+  Define a benchmark as a function taking a State:
+
+      static void my_benchmark(osmium_benchmark::State& state) {
+          // setup (not timed)
+          while (state.keep_running()) {
+              // code to time
+          }
+          state.set_items_processed(state.iterations() * ...);
+      }
+      OSMIUM_BENCHMARK(my_benchmark)->arg(10)->arg(100);
+
+  and call osmium_benchmark::run_benchmarks(argc, argv) from main().
+
+  On Linux the hardware performance counters (cycles, instructions, cache
+  misses, dTLB misses, branch misses) can be collected for the timed code
+  with --benchmark_perf_counters=all (or a comma separated list of names).
+  They are reported per iteration as user counters. This needs access to
+  perf_event_open(2), see /proc/sys/kernel/perf_event_paranoid.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/version.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace osmium_benchmark {
+
+    /**
+     * Hardware performance counters for the calling thread and all
+     * threads it starts later (like the pool threads). Only available
+     * on Linux.
+     */
+    class PerfCounters {
+
+        struct counter_def {
+            const char* name;
+            uint32_t type;
+            uint64_t config;
+        };
+
+        static const std::vector<counter_def>& definitions() {
+#ifdef __linux__
+            static const std::vector<counter_def> defs = {
+                {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {"cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                {"dtlb_misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                                                    (PERF_COUNT_HW_CACHE_OP_READ << 8U) |
+                                                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U)},
+                {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+            };
+#else
+            static const std::vector<counter_def> defs;
+#endif
+            return defs;
+        }
+
+        std::vector<std::string> m_names;
+        std::vector<int> m_fds;
+
+        int open_counter(const counter_def& def) {
+#ifdef __linux__
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = def.type;
+            attr.config = def.config;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            const auto fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd < 0) {
+                throw std::runtime_error{std::string{"Can not open perf counter '"} + def.name + "': " + std::strerror(errno)};
+            }
+            return fd;
+#else
+            (void)def;
+            throw std::runtime_error{"Perf counters are only available on Linux"};
+#endif
+        }
+
+    public:
+
+        /// A reading of all counters.
+        struct reading {
+            std::vector<uint64_t> value;
+            std::vector<uint64_t> enabled;
+            std::vector<uint64_t> running;
+        };
+
+        /**
+         * Open the counters.
+         *
+         * @param names Comma separated list of counter names or "all".
+         * @throws std::runtime_error If a counter is unknown or can not
+         *         be opened.
+         */
+        explicit PerfCounters(const std::string& names) {
+            std::istringstream in{names};
+            std::string name;
+            while (std::getline(in, name, ',')) {
+                bool found = false;
+                for (const auto& def : definitions()) {
+                    if (name == "all" || name == def.name) {
+                        m_fds.push_back(open_counter(def));
+                        m_names.emplace_back(def.name);
+                        found = true;
+                    }
+                }
+                if (!found) {
+                    throw std::runtime_error{"Unknown perf counter: '" + name + "'"};
+                }
+            }
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        PerfCounters(PerfCounters&&) = delete;
+        PerfCounters& operator=(PerfCounters&&) = delete;
+
+        ~PerfCounters() noexcept {
+#ifdef __linux__
+            for (const auto fd : m_fds) {
+                ::close(fd);
+            }
+#endif
+        }
+
+        const std::vector<std::string>& names() const noexcept {
+            return m_names;
+        }
+
+        reading read() const {
+            reading r;
+#ifdef __linux__
+            for (const auto fd : m_fds) {
+                uint64_t data[3] = {0, 0, 0};
+                if (::read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+                    data[0] = data[1] = data[2] = 0;
+                }
+                r.value.push_back(data[0]);
+                r.enabled.push_back(data[1]);
+                r.running.push_back(data[2]);
+            }
+#endif
+            return r;
+        }
+
+        /**
+         * The counts between two readings. If the kernel had to multiplex
+         * the counters, the counts are scaled up.
+         */
+        static std::vector<double> difference(const reading& start, const reading& end) {
+            std::vector<double> result;
+            for (std::size_t i = 0; i < end.value.size(); ++i) {
+                auto value = static_cast<double>(end.value[i] - start.value[i]);
+                const auto running = end.running[i] - start.running[i];
+                if (running > 0) {
+                    value *= static_cast<double>(end.enabled[i] - start.enabled[i]) / static_cast<double>(running);
+                }
+                result.push_back(value);
+            }
+            return result;
+        }
+
+    }; // class PerfCounters
+
+    /**
+     * The state of one benchmark run handed to the benchmark function.
+     */
+    class State {
+
+        using clock = std::chrono::steady_clock;
+
+        std::vector<int64_t> m_args;
+        uint64_t m_max_iterations;
+        uint64_t m_iterations = 0;
+
+        clock::time_point m_start_real{};
+        std::clock_t m_start_cpu = 0;
+        double m_real_time = 0.0;
+        double m_cpu_time = 0.0;
+        bool m_started = false;
+        bool m_timing = false;
+
+        int64_t m_items_processed = 0;
+        int64_t m_bytes_processed = 0;
+        std::map<std::string, double> m_counters;
+        std::string m_label;
+
+        const PerfCounters* m_perf;
+        PerfCounters::reading m_perf_start;
+        std::vector<double> m_perf_values;
+
+        void start_timer() {
+            m_timing = true;
+            m_start_cpu = std::clock();
+            m_start_real = clock::now();
+            if (m_perf) {
+                m_perf_start = m_perf->read();
+            }
+        }
+
+        void stop_timer() {
+            PerfCounters::reading perf_end;
+            if (m_perf) {
+                perf_end = m_perf->read();
+            }
+            const auto now = clock::now();
+            m_cpu_time += static_cast<double>(std::clock() - m_start_cpu) / CLOCKS_PER_SEC;
+            m_real_time += std::chrono::duration<double>(now - m_start_real).count();
+            m_timing = false;
+            if (m_perf) {
+                const auto values = PerfCounters::difference(m_perf_start, perf_end);
+                m_perf_values.resize(values.size());
+                for (std::size_t i = 0; i < values.size(); ++i) {
+                    m_perf_values[i] += values[i];
+                }
+            }
+        }
+
+    public:
+
+        State(std::vector<int64_t> args, const uint64_t max_iterations, const PerfCounters* perf = nullptr) :
+            m_args(std::move(args)),
+            m_max_iterations(max_iterations),
+            m_perf(perf) {
+        }
+
+        /**
+         * Call this in a while loop around the code to be timed. The
+         * timer starts on the first call and stops when it returns false.
+         */
+        bool keep_running() {
+            if (!m_started) {
+                m_started = true;
+                start_timer();
+            }
+            if (m_iterations < m_max_iterations) {
+                ++m_iterations;
+                return true;
+            }
+            if (m_timing) {
+                stop_timer();
+            }
+            return false;
+        }
+
+        /// Stop the timer for some setup code inside the loop.
+        void pause_timing() {
+            if (m_timing) {
+                stop_timer();
+            }
+        }
+
+        /// Start the timer again after pause_timing().
+        void resume_timing() {
+            if (!m_timing) {
+                start_timer();
+            }
+        }
+
+        /// The argument with the given index set with Benchmark::arg().
+        int64_t range(const std::size_t index = 0) const {
+            return index < m_args.size() ? m_args[index] : 0;
+        }
+
+        uint64_t iterations() const noexcept {
+            return m_iterations;
+        }
+
+        void set_items_processed(const int64_t items) noexcept {
+            m_items_processed = items;
+        }
+
+        void set_bytes_processed(const int64_t bytes) noexcept {
+            m_bytes_processed = bytes;
+        }
+
+        void set_label(const std::string& label) {
+            m_label = label;
+        }
+
+        /// User defined counters reported with the results.
+        std::map<std::string, double>& counters() noexcept {
+            return m_counters;
+        }
+
+        const std::map<std::string, double>& counters() const noexcept {
+            return m_counters;
+        }
+
+        double real_time() const noexcept {
+            return m_real_time;
+        }
+
+        double cpu_time() const noexcept {
+            return m_cpu_time;
+        }
+
+        int64_t items_processed() const noexcept {
+            return m_items_processed;
+        }
+
+        int64_t bytes_processed() const noexcept {
+            return m_bytes_processed;
+        }
+
+        const std::string& label() const noexcept {
+            return m_label;
+        }
+
+        /**
+         * The perf counter values summed over all timed code in the
+         * order of PerfCounters::names(). Empty if no perf counters are
+         * used.
+         */
+        const std::vector<double>& perf_values() const noexcept {
+            return m_perf_values;
+        }
+
+    }; // class State
+
+    using benchmark_function = std::function<void(State&)>;
+
+    /**
+     * A registered benchmark with its argument sets.
+     */
+    class Benchmark {
+
+        std::string m_name;
+        benchmark_function m_function;
+        std::vector<std::vector<int64_t>> m_args;
+
+    public:
+
+        Benchmark(std::string name, benchmark_function function) :
+            m_name(std::move(name)),
+            m_function(std::move(function)) {
+        }
+
+        /// Run the benchmark (also) with this argument.
+        Benchmark* arg(const int64_t value) {
+            m_args.push_back({value});
+            return this;
+        }
+
+        /// Run the benchmark (also) with these arguments.
+        Benchmark* args(std::vector<int64_t> values) {
+            m_args.push_back(std::move(values));
+            return this;
+        }
+
+        const std::string& name() const noexcept {
+            return m_name;
+        }
+
+        const benchmark_function& function() const noexcept {
+            return m_function;
+        }
+
+        std::vector<std::vector<int64_t>> arg_sets() const {
+            if (m_args.empty()) {
+                return {{}};
+            }
+            return m_args;
+        }
+
+    }; // class Benchmark
+
+    namespace detail {
+
+        inline std::vector<std::unique_ptr<Benchmark>>& benchmarks() {
+            static std::vector<std::unique_ptr<Benchmark>> list;
+            return list;
+        }
+
+        struct result {
+            std::string name;
+            uint64_t iterations = 0;
+            double real_time = 0.0; // seconds for all iterations
+            double cpu_time = 0.0;  // seconds for all iterations
+            int64_t items_processed = 0;
+            int64_t bytes_processed = 0;
+            std::map<std::string, double> counters;
+            std::string label;
+        };
+
+        inline std::string full_name(const Benchmark& benchmark, const std::vector<int64_t>& args) {
+            std::string name = benchmark.name();
+            for (const auto arg : args) {
+                name += '/';
+                name += std::to_string(arg);
+            }
+            return name;
+        }
+
+        inline result run_once(const Benchmark& benchmark, const std::vector<int64_t>& args, const uint64_t iterations, const PerfCounters* perf) {
+            State state{args, iterations, perf};
+            benchmark.function()(state);
+
+            result r;
+            r.name = full_name(benchmark, args);
+            r.iterations = state.iterations();
+            r.real_time = state.real_time();
+            r.cpu_time = state.cpu_time();
+            r.items_processed = state.items_processed();
+            r.bytes_processed = state.bytes_processed();
+            r.counters = state.counters();
+            r.label = state.label();
+
+            // Perf counters are reported per iteration like Google
+            // Benchmark does.
+            if (perf && r.iterations > 0) {
+                const auto& values = state.perf_values();
+                const auto n = static_cast<double>(r.iterations);
+                for (std::size_t i = 0; i < values.size(); ++i) {
+                    r.counters[perf->names()[i]] = values[i] / n;
+                }
+                if (r.counters.count("cycles") && r.counters.count("instructions") && r.counters["cycles"] > 0) {
+                    r.counters["ipc"] = r.counters["instructions"] / r.counters["cycles"];
+                }
+            }
+
+            return r;
+        }
+
+        // Increase the number of iterations until the run takes at least
+        // min_time seconds (like Google Benchmark does).
+        inline result run(const Benchmark& benchmark, const std::vector<int64_t>& args, const double min_time, const PerfCounters* perf) {
+            constexpr const uint64_t max_iterations = 1000000000;
+            uint64_t iterations = 1;
+            while (true) {
+                auto r = run_once(benchmark, args, iterations, perf);
+                if (r.real_time >= min_time || iterations >= max_iterations) {
+                    return r;
+                }
+                double multiplier = min_time * 1.4 / std::max(r.real_time, 1e-9);
+                if (r.real_time / min_time <= 0.1) {
+                    multiplier = std::min(multiplier, 10.0);
+                }
+                const auto next = static_cast<uint64_t>(static_cast<double>(iterations) * multiplier);
+                iterations = std::min(max_iterations, std::max(iterations + 1, next));
+            }
+        }
+
+        inline std::string json_escape(const std::string& str) {
+            std::string out;
+            for (const char c : str) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                }
+                out += c;
+            }
+            return out;
+        }
+
+        inline std::string current_date() {
+            const std::time_t now = std::time(nullptr);
+            char buffer[32];
+            std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+            return buffer;
+        }
+
+        inline void write_json(std::ostream& out, const std::vector<result>& results) {
+            out << std::setprecision(10);
+            out << "{\n  \"context\": {\n"
+                << "    \"date\": \"" << current_date() << "\",\n"
+                << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+                << "    \"library\": \"libosmium\",\n"
+                << "    \"library_version\": \"" LIBOSMIUM_VERSION_STRING "\",\n"
+#ifdef NDEBUG
+                << "    \"library_build_type\": \"release\"\n"
+#else
+                << "    \"library_build_type\": \"debug\"\n"
+#endif
+                << "  },\n  \"benchmarks\": [";
+
+            bool first = true;
+            for (const auto& r : results) {
+                const auto n = static_cast<double>(r.iterations);
+                out << (first ? "\n" : ",\n");
+                first = false;
+                out << "    {\n"
+                    << "      \"name\": \"" << json_escape(r.name) << "\",\n"
+                    << "      \"run_name\": \"" << json_escape(r.name) << "\",\n"
+                    << "      \"run_type\": \"iteration\",\n"
+                    << "      \"iterations\": " << r.iterations << ",\n"
+                    << "      \"real_time\": " << (r.real_time * 1e9 / n) << ",\n"
+                    << "      \"cpu_time\": " << (r.cpu_time * 1e9 / n) << ",\n"
+                    << "      \"time_unit\": \"ns\"";
+                if (r.items_processed > 0 && r.real_time > 0) {
+                    out << ",\n      \"items_per_second\": " << (static_cast<double>(r.items_processed) / r.real_time);
+                }
+                if (r.bytes_processed > 0 && r.real_time > 0) {
+                    out << ",\n      \"bytes_per_second\": " << (static_cast<double>(r.bytes_processed) / r.real_time);
+                }
+                for (const auto& counter : r.counters) {
+                    out << ",\n      \"" << json_escape(counter.first) << "\": " << counter.second;
+                }
+                if (!r.label.empty()) {
+                    out << ",\n      \"label\": \"" << json_escape(r.label) << '"';
+                }
+                out << "\n    }";
+            }
+            out << "\n  ]\n}\n";
+        }
+
+        inline std::string human_rate(double value) {
+            const char* units[] = {"", "k", "M", "G", "T"};
+            std::size_t unit = 0;
+            while (value >= 1000.0 && unit < 4) {
+                value /= 1000.0;
+                ++unit;
+            }
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(2) << value << units[unit];
+            return out.str();
+        }
+
+        inline void write_console_header(std::ostream& out) {
+            out << std::left << std::setw(48) << "Benchmark"
+                << std::right << std::setw(14) << "Time"
+                << std::setw(14) << "CPU"
+                << std::setw(14) << "Iterations"
+                << "  UserCounters...\n"
+                << std::string(104, '-') << '\n';
+        }
+
+        inline void write_console(std::ostream& out, const result& r) {
+            const auto n = static_cast<double>(r.iterations);
+            out << std::left << std::setw(48) << r.name
+                << std::right << std::fixed << std::setprecision(0)
+                << std::setw(11) << (r.real_time * 1e9 / n) << " ns"
+                << std::setw(11) << (r.cpu_time * 1e9 / n) << " ns"
+                << std::setw(14) << r.iterations;
+            if (r.items_processed > 0 && r.real_time > 0) {
+                out << "  items_per_second=" << human_rate(static_cast<double>(r.items_processed) / r.real_time) << "/s";
+            }
+            if (r.bytes_processed > 0 && r.real_time > 0) {
+                out << "  bytes_per_second=" << human_rate(static_cast<double>(r.bytes_processed) / r.real_time) << "B/s";
+            }
+            for (const auto& counter : r.counters) {
+                out << "  " << counter.first << '=' << human_rate(counter.second);
+            }
+            if (!r.label.empty()) {
+                out << "  " << r.label;
+            }
+            out << '\n';
+        }
+
+        inline bool get_option(const std::string& arg, const char* name, std::string& value) {
+            const std::string prefix = std::string{"--"} + name + "=";
+            if (arg.compare(0, prefix.size(), prefix) != 0) {
+                return false;
+            }
+            value = arg.substr(prefix.size());
+            return true;
+        }
+
+    } // namespace detail
+
+    /**
+     * Register a benchmark. Use the OSMIUM_BENCHMARK() macro for plain
+     * functions or call this directly, for instance with a lambda.
+     */
+    inline Benchmark* register_benchmark(const std::string& name, benchmark_function function) {
+        detail::benchmarks().emplace_back(new Benchmark{name, std::move(function)});
+        return detail::benchmarks().back().get();
+    }
+
+    /**
+     * Run all registered benchmarks matching the filter. Understands
+     * these command line options:
+     *
+     * --benchmark_filter=REGEX        Only run matching benchmarks
+     * --benchmark_format=console|json Output format on stdout
+     * --benchmark_out=FILE            Also write JSON results to FILE
+     * --benchmark_min_time=SECONDS    Minimum time per benchmark (0.5)
+     * --benchmark_list_tests          Only list the benchmark names
+     * --benchmark_perf_counters=LIST  Collect these hardware perf
+     *                                 counters (comma separated names
+     *                                 or "all", Linux only)
+     *
+     * @returns Exit code for main().
+     */
+    inline int run_benchmarks(int argc, char* argv[]) {
+        std::string filter{"."};
+        std::string format{"console"};
+        std::string out_file;
+        double min_time = 0.5;
+        bool list_only = false;
+        std::string perf_counters;
+
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg{argv[i]};
+            std::string value;
+            if (detail::get_option(arg, "benchmark_filter", value)) {
+                filter = value;
+            } else if (detail::get_option(arg, "benchmark_format", value)) {
+                format = value;
+            } else if (detail::get_option(arg, "benchmark_out", value)) {
+                out_file = value;
+            } else if (detail::get_option(arg, "benchmark_min_time", value)) {
+                min_time = std::stod(value);
+            } else if (detail::get_option(arg, "benchmark_perf_counters", value)) {
+                perf_counters = value;
+            } else if (arg == "--benchmark_list_tests") {
+                list_only = true;
+            } else {
+                std::cerr << "Unknown option: " << arg << '\n'
+                          << "Usage: " << argv[0] << " [--benchmark_filter=REGEX] [--benchmark_format=console|json]"
+                          << " [--benchmark_out=FILE] [--benchmark_min_time=SECONDS] [--benchmark_list_tests]"
+                          << " [--benchmark_perf_counters=all|cycles,instructions,cache_misses,dtlb_misses,branch_misses]\n";
+                return 1;
+            }
+        }
+
+        if (format != "console" && format != "json") {
+            std::cerr << "Unknown format: " << format << '\n';
+            return 1;
+        }
+
+        std::unique_ptr<PerfCounters> perf;
+        if (!perf_counters.empty() && !list_only) {
+            try {
+                perf.reset(new PerfCounters{perf_counters});
+            } catch (const std::runtime_error& e) {
+                std::cerr << e.what() << '\n';
+                return 1;
+            }
+        }
+
+        const std::regex filter_regex{filter};
+        const bool console = (format == "console");
+
+        if (console && !list_only) {
+            detail::write_console_header(std::cout);
+        }
+
+        std::vector<detail::result> results;
+        for (const auto& benchmark : detail::benchmarks()) {
+            for (const auto& args : benchmark->arg_sets()) {
+                const auto name = detail::full_name(*benchmark, args);
+                if (!std::regex_search(name, filter_regex)) {
+                    continue;
+                }
+                if (list_only) {
+                    std::cout << name << '\n';
+                    continue;
+                }
+                results.push_back(detail::run(*benchmark, args, min_time, perf.get()));
+                if (console) {
+                    detail::write_console(std::cout, results.back());
+                }
+            }
+        }
+
+        if (list_only) {
+            return 0;
+        }
+
+        if (!console) {
+            detail::write_json(std::cout, results);
+        }
+
+        if (!out_file.empty()) {
+            std::ofstream out{out_file};
+            detail::write_json(out, results);
+            if (!out) {
+                std::cerr << "Error writing to '" << out_file << "'\n";
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+} // namespace osmium_benchmark
+
+#define OSMIUM_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define OSMIUM_BENCHMARK_CONCAT(a, b) OSMIUM_BENCHMARK_CONCAT_IMPL(a, b)
+
+/// Register the function as a benchmark. Arguments can be added with
+/// ->arg() and ->args().
+#define OSMIUM_BENCHMARK(func) \
+    static ::osmium_benchmark::Benchmark* OSMIUM_BENCHMARK_CONCAT(osmium_benchmark_registered_, __LINE__) = \
+        ::osmium_benchmark::register_benchmark(#func, func)
+
+#endif // OSMIUM_BENCHMARK_HPP
@@ -0,0 +1,344 @@
+/*
+
+  This benchmark runs the multipolygon assembler on a fixed corpus of
+  synthetic relations which are known to be hard for it: relations with
+  thousands of rings, with thousands of inner rings, with rings made up
+  of many ways, with rings touching each other, and with a single way
+  touching itself many times. A simple relation is included as baseline.
+
+  Every relation is assembled several times (default 20, set with the
+  first argument) with a new Assembler each time. For every relation this
+  prints the 50th, 90th, and 99th percentile and the maximum of the
+  assembly time, which code path the assembler took ("simple" if no rings
+  touch, "touching" or "complex" otherwise, "none" if it gave up before
+  building rings), and the number of nodes, segments, outer and inner
+  rings, and touching locations from the area_stats. The last columns show
+  how the time was split between sorting the segments, checking for
+  intersections, and building the rings. Relations the assembler couldn't
+  build an area from are marked "FAILED", some of the cases are expected
+  to fail, but they should fail fast.
+
+  Run it before and after changes to the assembler to find regressions
+  in any of these cases. It doesn't need any data files.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/stats.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using location_list = std::vector<osmium::Location>;
+
+// All coordinates are integers in the internal Location format so that
+// touching rings share exactly the same locations.
+const int32_t base_x = 80000000;
+const int32_t base_y = 480000000;
+
+/**
+ * A multipolygon relation with its member ways.
+ */
+class RelationCase {
+
+    std::string m_name;
+    osmium::memory::Buffer m_buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<std::size_t> m_way_offsets;
+    std::vector<const char*> m_roles;
+    std::size_t m_relation_offset = 0;
+    osmium::object_id_type m_next_node_id = 1;
+
+public:
+
+    explicit RelationCase(std::string name) :
+        m_name(std::move(name)) {
+    }
+
+    void add_way(const location_list& locations, const char* role) {
+        {
+            osmium::builder::WayBuilder builder{m_buffer};
+            builder.set_id(static_cast<osmium::object_id_type>(m_way_offsets.size() + 1));
+            osmium::builder::WayNodeListBuilder nodes{builder};
+            for (const auto& location : locations) {
+                nodes.add_node_ref(m_next_node_id++, location);
+            }
+        }
+        m_way_offsets.push_back(m_buffer.commit());
+        m_roles.push_back(role);
+    }
+
+    void add_relation() {
+        {
+            osmium::builder::RelationBuilder builder{m_buffer};
+            builder.set_id(1);
+            {
+                osmium::builder::RelationMemberListBuilder members{builder};
+                for (std::size_t i = 0; i < m_roles.size(); ++i) {
+                    members.add_member(osmium::item_type::way, static_cast<osmium::object_id_type>(i + 1), m_roles[i]);
+                }
+            }
+            osmium::builder::TagListBuilder tags{builder};
+            tags.add_tag("type", "multipolygon");
+            tags.add_tag("landuse", "forest");
+        }
+        m_relation_offset = m_buffer.commit();
+    }
+
+    const std::string& name() const noexcept {
+        return m_name;
+    }
+
+    const osmium::Relation& relation() const {
+        return m_buffer.get<osmium::Relation>(m_relation_offset);
+    }
+
+    std::vector<const osmium::Way*> ways() const {
+        std::vector<const osmium::Way*> ways;
+        for (const auto offset : m_way_offsets) {
+            ways.push_back(&m_buffer.get<osmium::Way>(offset));
+        }
+        return ways;
+    }
+
+}; // class RelationCase
+
+location_list square(const int32_t x, const int32_t y, const int32_t size) {
+    return {{x, y}, {x + size, y}, {x + size, y + size}, {x, y + size}, {x, y}};
+}
+
+location_list circle(const int32_t radius, const uint32_t num_nodes) {
+    location_list locations;
+    for (uint32_t n = 0; n < num_nodes; ++n) {
+        const double angle = 2 * 3.14159265358979 * n / num_nodes;
+        locations.emplace_back(base_x + static_cast<int32_t>(radius * std::cos(angle)),
+                               base_y + static_cast<int32_t>(radius * std::sin(angle)));
+    }
+    locations.push_back(locations.front());
+    return locations;
+}
+
+// One outer ring, the assembler takes the simple path.
+RelationCase simple_case() {
+    RelationCase rc{"simple"};
+    rc.add_way(circle(1000000, 1000), "outer");
+    rc.add_relation();
+    return rc;
+}
+
+// One large outer ring split into 100 ways which have to be joined.
+RelationCase split_outer_case() {
+    RelationCase rc{"split_outer"};
+    const auto ring = circle(1000000, 10000);
+    for (std::size_t start = 0; start + 1 < ring.size(); start += 100) {
+        const auto end = std::min(start + 101, ring.size());
+        rc.add_way(location_list(ring.begin() + static_cast<std::ptrdiff_t>(start), ring.begin() + static_cast<std::ptrdiff_t>(end)), "outer");
+    }
+    rc.add_relation();
+    return rc;
+}
+
+// 4096 separate outer rings.
+RelationCase many_outers_case() {
+    RelationCase rc{"many_outers"};
+    for (int32_t y = 0; y < 64; ++y) {
+        for (int32_t x = 0; x < 64; ++x) {
+            rc.add_way(square(base_x + x * 2000, base_y + y * 2000, 1000), "outer");
+        }
+    }
+    rc.add_relation();
+    return rc;
+}
+
+// One outer ring with 2500 inner rings.
+RelationCase many_inners_case() {
+    RelationCase rc{"many_inners"};
+    rc.add_way(square(base_x, base_y, 102000), "outer");
+    for (int32_t y = 0; y < 50; ++y) {
+        for (int32_t x = 0; x < 50; ++x) {
+            rc.add_way(square(base_x + 1000 + x * 2000, base_y + 1000 + y * 2000, 1000), "inner");
+        }
+    }
+    rc.add_relation();
+    return rc;
+}
+
+// One outer ring with a diagonal chain of 80 inner rings, every inner
+// ring touches the next one at a corner.
+RelationCase touching_inners_case() {
+    RelationCase rc{"touching_inners"};
+    rc.add_way(square(base_x, base_y, 82000), "outer");
+    for (int32_t i = 0; i < 80; ++i) {
+        rc.add_way(square(base_x + 1000 + i * 1000, base_y + 1000 + i * 1000, 1000), "inner");
+    }
+    rc.add_relation();
+    return rc;
+}
+
+// Outer rings in a checkerboard pattern touching at their corners. The
+// assembler can't decide which rings belong together here. With a size of
+// 40 there are more touching locations than it is willing to handle at
+// all, so this checks how fast it gives up.
+RelationCase touching_outers_case(const char* name, const int32_t size) {
+    RelationCase rc{name};
+    for (int32_t y = 0; y < size; ++y) {
+        for (int32_t x = y % 2; x < size; x += 2) {
+            rc.add_way(square(base_x + x * 1000, base_y + y * 1000, 1000), "outer");
+        }
+    }
+    rc.add_relation();
+    return rc;
+}
+
+// A single closed way forming a chain of 90 diamonds, it touches itself
+// at every point where two diamonds meet.
+RelationCase self_touching_case() {
+    RelationCase rc{"self_touching"};
+    const int32_t num = 90;
+    const int32_t d = 1000;
+    location_list locations;
+    for (int32_t i = 0; i < num; ++i) {
+        locations.emplace_back(base_x + 2 * i * d, base_y);
+        locations.emplace_back(base_x + 2 * i * d + d, base_y + d);
+    }
+    for (int32_t i = num; i > 0; --i) {
+        locations.emplace_back(base_x + 2 * i * d, base_y);
+        locations.emplace_back(base_x + 2 * i * d - d, base_y - d);
+    }
+    locations.push_back(locations.front());
+    rc.add_way(locations, "outer");
+    rc.add_relation();
+    return rc;
+}
+
+struct case_result {
+    std::vector<double> micros;
+    osmium::area::area_stats stats;
+    std::size_t failed = 0;
+};
+
+case_result run(const RelationCase& rc, const int runs) {
+    const auto ways = rc.ways();
+    osmium::area::AssemblerConfig config;
+    config.create_empty_areas = false;
+    osmium::memory::Buffer out_buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    case_result result;
+    for (int i = 0; i < runs; ++i) {
+        osmium::area::Assembler assembler{config};
+
+        const auto start = std::chrono::steady_clock::now();
+        const bool ok = assembler(rc.relation(), ways, out_buffer);
+        const auto stop = std::chrono::steady_clock::now();
+
+        result.micros.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+        if (!ok) {
+            ++result.failed;
+        }
+        if (i == 0) {
+            result.stats = assembler.stats();
+        }
+        out_buffer.clear();
+    }
+
+    std::sort(result.micros.begin(), result.micros.end());
+    return result;
+}
+
+double percentile(const std::vector<double>& sorted, const double p) {
+    const auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+
+const char* assembler_path(const osmium::area::area_stats& stats) noexcept {
+    if (stats.area_really_complex_case) {
+        return "complex";
+    }
+    if (stats.area_touching_rings_case) {
+        return "touching";
+    }
+    if (stats.area_simple_case) {
+        return "simple";
+    }
+    return "none";
+}
+
+int percent_of(const uint64_t part, const uint64_t total) noexcept {
+    return total ? static_cast<int>(100 * part / total) : 0;
+}
+
+void print_header() {
+    std::cout << "case                 p50_us    p90_us    p99_us    max_us  path      nodes  segments  outer  inner  touching  sort%  isect%  rings%\n";
+}
+
+void print_result(const RelationCase& rc, const case_result& result) {
+    const auto& s = result.stats;
+    std::cout << std::left << std::setw(17) << rc.name() << std::right
+              << std::fixed << std::setprecision(0)
+              << std::setw(10) << percentile(result.micros, 50)
+              << std::setw(10) << percentile(result.micros, 90)
+              << std::setw(10) << percentile(result.micros, 99)
+              << std::setw(10) << result.micros.back()
+              << "  " << std::left << std::setw(8) << assembler_path(s) << std::right
+              << std::setw(7) << s.nodes
+              << std::setw(10) << s.segments
+              << std::setw(7) << s.outer_rings
+              << std::setw(7) << s.inner_rings
+              << std::setw(10) << s.touching_rings
+              << std::setw(7) << percent_of(s.time_sort, s.time_total)
+              << std::setw(8) << percent_of(s.time_intersections, s.time_total)
+              << std::setw(8) << percent_of(s.time_rings_simple + s.time_rings_complex, s.time_total)
+              << (result.failed ? "  FAILED" : "")
+              << '\n';
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2) {
+        std::cerr << "Usage: " << argv[0] << " [RUNS]\n";
+        return 1;
+    }
+
+    const int runs = argc == 2 ? std::max(1, std::atoi(argv[1])) : 20;
+
+    try {
+        std::vector<RelationCase> corpus;
+        corpus.push_back(simple_case());
+        corpus.push_back(split_outer_case());
+        corpus.push_back(many_outers_case());
+        corpus.push_back(many_inners_case());
+        corpus.push_back(touching_inners_case());
+        corpus.push_back(touching_outers_case("touching_outers", 10));
+        corpus.push_back(touching_outers_case("too_many_touching", 40));
+        corpus.push_back(self_touching_case());
+
+        std::cout << "runs per case: " << runs << "\n";
+        print_header();
+
+        for (const auto& rc : corpus) {
+            print_result(rc, run(rc, runs));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
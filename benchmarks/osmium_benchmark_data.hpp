@@ -0,0 +1,281 @@
+#ifndef OSMIUM_BENCHMARK_DATA_HPP
+#define OSMIUM_BENCHMARK_DATA_HPP
+
+/*
+
+  Reproducible synthetic OSM data for the benchmarks. All data is created
+  from a fixed seed with a simple PRNG (not <random>, whose distributions
+  differ between standard libraries), so every build on every platform
+  benchmarks exactly the same data.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osmium_benchmark {
+
+    /**
+     * Small deterministic PRNG (xorshift64*).
+     */
+    class Random {
+
+        uint64_t m_state;
+
+    public:
+
+        explicit Random(const uint64_t seed = 0x9e3779b97f4a7c15ULL) noexcept :
+            m_state(seed ? seed : 1) {
+        }
+
+        uint64_t next() noexcept {
+            m_state ^= m_state >> 12U;
+            m_state ^= m_state << 25U;
+            m_state ^= m_state >> 27U;
+            return m_state * 0x2545f4914f6cdd1dULL;
+        }
+
+        /// Random number in [0, n).
+        uint32_t uniform(const uint32_t n) noexcept {
+            return static_cast<uint32_t>((next() >> 32U) % n);
+        }
+
+    }; // class Random
+
+    namespace detail {
+
+        struct tag_template {
+            const char* key;
+            const char* values[4];
+        };
+
+        inline const tag_template& random_tag(Random& random) {
+            static const tag_template tags[] = {
+                {"highway",  {"residential", "service", "track", "motorway"}},
+                {"building", {"yes", "house", "residential", "garage"}},
+                {"name",     {"Main Street", "Hauptstrasse", "Rue de la Paix", "Station"}},
+                {"amenity",  {"parking", "bench", "restaurant", "school"}},
+                {"surface",  {"asphalt", "gravel", "paved", "unpaved"}},
+                {"natural",  {"tree", "water", "wood", "scrub"}},
+                {"source",   {"survey", "bing", "gps", "import"}},
+                {"oneway",   {"yes", "no", "-1", "yes"}}
+            };
+            return tags[random.uniform(sizeof(tags) / sizeof(tags[0]))];
+        }
+
+        inline void add_random_tags(osmium::builder::Builder& parent, Random& random, const uint32_t count) {
+            if (count == 0) {
+                return;
+            }
+            osmium::builder::TagListBuilder builder{parent};
+            for (uint32_t i = 0; i < count; ++i) {
+                const auto& tag = random_tag(random);
+                builder.add_tag(tag.key, tag.values[random.uniform(4)]);
+            }
+        }
+
+        inline osmium::Location grid_location(const osmium::object_id_type id) noexcept {
+            // Nodes on a grid of 1000 columns around (8.0, 48.0).
+            const auto n = static_cast<int32_t>(id - 1);
+            return osmium::Location{80000000 + (n % 1000) * 1000, 480000000 + (n / 1000) * 1000};
+        }
+
+    } // namespace detail
+
+    /**
+     * Add nodes with ids 1 to count on a grid. Every node gets up to
+     * max_tags (random) tags, but only about one in five nodes is tagged
+     * at all, like in real OSM data.
+     */
+    inline void add_nodes(osmium::memory::Buffer& buffer, const std::size_t count, const uint32_t max_tags = 4, const uint64_t seed = 1) {
+        Random random{seed};
+        for (std::size_t i = 1; i <= count; ++i) {
+            {
+                osmium::builder::NodeBuilder builder{buffer};
+                builder.set_id(static_cast<osmium::object_id_type>(i))
+                       .set_version(static_cast<osmium::object_version_type>(1 + random.uniform(5)))
+                       .set_changeset(static_cast<osmium::changeset_id_type>(1000 + random.uniform(100000)))
+                       .set_timestamp(static_cast<uint32_t>(1300000000 + random.uniform(300000000)))
+                       .set_uid(static_cast<osmium::user_id_type>(1 + random.uniform(1000)))
+                       .set_location(detail::grid_location(static_cast<osmium::object_id_type>(i)));
+                builder.set_user("benchmark");
+                const uint32_t num_tags = (max_tags > 0 && random.uniform(5) == 0) ? 1 + random.uniform(max_tags) : 0;
+                detail::add_random_tags(builder, random, num_tags);
+            }
+            buffer.commit();
+        }
+    }
+
+    /**
+     * Add count ways with ids 1 to count, each with 2 to max_nodes
+     * nodes taken from the grid created by add_nodes() with num_nodes
+     * nodes. Every way has 1 to 4 tags.
+     */
+    inline void add_ways(osmium::memory::Buffer& buffer, const std::size_t count, const std::size_t num_nodes, const uint32_t max_nodes = 20, const uint64_t seed = 2) {
+        Random random{seed};
+        for (std::size_t i = 1; i <= count; ++i) {
+            {
+                osmium::builder::WayBuilder builder{buffer};
+                builder.set_id(static_cast<osmium::object_id_type>(i))
+                       .set_version(1)
+                       .set_changeset(static_cast<osmium::changeset_id_type>(1000 + random.uniform(100000)))
+                       .set_timestamp(static_cast<uint32_t>(1300000000 + random.uniform(300000000)))
+                       .set_uid(static_cast<osmium::user_id_type>(1 + random.uniform(1000)));
+                builder.set_user("benchmark");
+                {
+                    osmium::builder::WayNodeListBuilder nodes{builder};
+                    const uint32_t num = 2 + random.uniform(max_nodes - 1);
+                    auto id = static_cast<osmium::object_id_type>(1 + random.uniform(static_cast<uint32_t>(num_nodes - num)));
+                    for (uint32_t n = 0; n < num; ++n) {
+                        nodes.add_node_ref(id + n);
+                    }
+                }
+                detail::add_random_tags(builder, random, 1 + random.uniform(4));
+            }
+            buffer.commit();
+        }
+    }
+
+    /**
+     * Add count multipolygon relations with ids 1 to count, each with
+     * 1 to 10 way members.
+     */
+    inline void add_relations(osmium::memory::Buffer& buffer, const std::size_t count, const std::size_t num_ways, const uint64_t seed = 3) {
+        Random random{seed};
+        for (std::size_t i = 1; i <= count; ++i) {
+            {
+                osmium::builder::RelationBuilder builder{buffer};
+                builder.set_id(static_cast<osmium::object_id_type>(i))
+                       .set_version(1);
+                builder.set_user("benchmark");
+                {
+                    osmium::builder::RelationMemberListBuilder members{builder};
+                    const uint32_t num = 1 + random.uniform(10);
+                    for (uint32_t n = 0; n < num; ++n) {
+                        members.add_member(osmium::item_type::way,
+                                           static_cast<osmium::object_id_type>(1 + random.uniform(static_cast<uint32_t>(num_ways))),
+                                           n == 0 ? "outer" : "inner");
+                    }
+                }
+                {
+                    osmium::builder::TagListBuilder tags{builder};
+                    tags.add_tag("type", "multipolygon");
+                    tags.add_tag("landuse", "forest");
+                }
+            }
+            buffer.commit();
+        }
+    }
+
+    /**
+     * The kinds of multipolygons used in the area assembly benchmarks.
+     */
+    enum class polygon_class {
+        simple      = 0, // one outer ring
+        with_holes  = 1, // one outer ring with 4 inner rings
+        multi_outer = 2  // 5 separate outer rings
+    };
+
+    /**
+     * A multipolygon relation with its member ways. Each ring is one
+     * closed way with nodes_per_ring nodes.
+     */
+    class MultipolygonData {
+
+        osmium::memory::Buffer m_buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        std::size_t m_relation_offset = 0;
+        std::vector<std::size_t> m_way_offsets;
+
+        osmium::object_id_type m_next_node_id = 1;
+
+        void add_ring(const osmium::object_id_type id, const double cx, const double cy, const double radius, const uint32_t nodes_per_ring, const bool clockwise) {
+            {
+                osmium::builder::WayBuilder builder{m_buffer};
+                builder.set_id(id);
+                osmium::builder::WayNodeListBuilder nodes{builder};
+                const auto first_id = m_next_node_id;
+                for (uint32_t n = 0; n < nodes_per_ring; ++n) {
+                    const double angle = 2 * 3.14159265358979 * n / nodes_per_ring * (clockwise ? -1 : 1);
+                    nodes.add_node_ref(m_next_node_id++, osmium::Location{cx + radius * std::cos(angle), cy + radius * std::sin(angle)});
+                }
+                nodes.add_node_ref(first_id, osmium::Location{cx + radius, cy});
+            }
+            m_way_offsets.push_back(m_buffer.commit());
+        }
+
+    public:
+
+        MultipolygonData(const polygon_class type, const uint32_t nodes_per_ring) {
+            std::vector<const char*> roles;
+            osmium::object_id_type way_id = 1;
+
+            switch (type) {
+                case polygon_class::simple:
+                    add_ring(way_id++, 8.0, 48.0, 0.1, nodes_per_ring, false);
+                    roles.push_back("outer");
+                    break;
+                case polygon_class::with_holes:
+                    add_ring(way_id++, 8.0, 48.0, 0.1, nodes_per_ring, false);
+                    roles.push_back("outer");
+                    for (int i = 0; i < 4; ++i) {
+                        add_ring(way_id++, 8.0 + (i % 2 ? 0.04 : -0.04), 48.0 + (i / 2 ? 0.04 : -0.04), 0.01, nodes_per_ring, true);
+                        roles.push_back("inner");
+                    }
+                    break;
+                case polygon_class::multi_outer:
+                    for (int i = 0; i < 5; ++i) {
+                        add_ring(way_id++, 8.0 + i * 0.3, 48.0, 0.1, nodes_per_ring, false);
+                        roles.push_back("outer");
+                    }
+                    break;
+            }
+
+            {
+                osmium::builder::RelationBuilder builder{m_buffer};
+                builder.set_id(1);
+                {
+                    osmium::builder::RelationMemberListBuilder members{builder};
+                    for (std::size_t i = 0; i < roles.size(); ++i) {
+                        members.add_member(osmium::item_type::way, static_cast<osmium::object_id_type>(i + 1), roles[i]);
+                    }
+                }
+                osmium::builder::TagListBuilder tags{builder};
+                tags.add_tag("type", "multipolygon");
+                tags.add_tag("landuse", "forest");
+            }
+            m_relation_offset = m_buffer.commit();
+        }
+
+        const osmium::Relation& relation() const {
+            return m_buffer.get<osmium::Relation>(m_relation_offset);
+        }
+
+        std::vector<const osmium::Way*> ways() const {
+            std::vector<const osmium::Way*> ways;
+            for (const auto offset : m_way_offsets) {
+                ways.push_back(&m_buffer.get<osmium::Way>(offset));
+            }
+            return ways;
+        }
+
+        std::size_t num_nodes() const noexcept {
+            return static_cast<std::size_t>(m_next_node_id - 1);
+        }
+
+    }; // class MultipolygonData
+
+} // namespace osmium_benchmark
+
+#endif // OSMIUM_BENCHMARK_DATA_HPP
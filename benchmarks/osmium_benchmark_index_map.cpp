@@ -1,5 +1,27 @@
 /*
 
+  This benchmark fills a node location index with all nodes from the input
+  file and looks up the locations of all way nodes.
+
+  Called with the OSM file and the index type (see the map factory for the
+  names) it does this in one pass with the NodeLocationsForWays handler
+  like a normal program would. Use it together with the "time" command.
+
+  With a third argument it runs two separate phases: First all nodes are
+  read and stored in the index, then the file is read again and the
+  locations of all way nodes are looked up. The argument is the access
+  hint (normal, sequential, random, or willneed) given to the index for the
+  lookups, for indexes based on memory mappings this is passed on to the
+  kernel with madvise(). For each phase this reports the run time, the
+  number of major and minor page faults, how much data was read from and
+  written to storage, and the peak resident memory. It also reports the
+  memory limit of the cgroup the program runs in (Linux only).
+
+  This is most useful for file-backed indexes like sparse_file_array and
+  dense_file_array which are larger than the memory available, run it
+  under a cgroup memory limit (for instance with "systemd-run --user
+  --scope -p MemoryMax=1G") to simulate that.
+
   The code in this file is released into the Public Domain.
 
 */
@@ -8,19 +30,214 @@
 #include <osmium/handler/node_locations_for_ways.hpp>
 #include <osmium/index/map/all.hpp>
 #include <osmium/io/any_input.hpp>
+#include <osmium/util/memory_mapping.hpp>
 #include <osmium/visitor.hpp>
 
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
 
+#ifndef _WIN32
+# include <sys/resource.h>
+#endif
+
 using index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
 
 using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
 
+struct resource_usage {
+    std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+    int64_t major_faults = 0;
+    int64_t minor_faults = 0;
+    int64_t max_rss_kb = 0;
+    int64_t read_bytes = -1;
+    int64_t write_bytes = -1;
+};
+
+// Read a "key: value" line from a file in /proc.
+int64_t read_proc_value(const char* filename, const std::string& key) {
+    std::ifstream file{filename};
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':') {
+            return std::atoll(line.c_str() + key.size() + 1);
+        }
+    }
+    return -1;
+}
+
+resource_usage get_resource_usage() {
+    resource_usage usage;
+#ifndef _WIN32
+    rusage ru{};
+    if (::getrusage(RUSAGE_SELF, &ru) == 0) {
+        usage.major_faults = ru.ru_majflt;
+        usage.minor_faults = ru.ru_minflt;
+        usage.max_rss_kb = ru.ru_maxrss;
+    }
+#endif
+#ifdef __linux__
+    // Bytes actually read from and written to storage, not counting
+    // anything served from the page cache.
+    usage.read_bytes = read_proc_value("/proc/self/io", "read_bytes");
+    usage.write_bytes = read_proc_value("/proc/self/io", "write_bytes");
+#endif
+    return usage;
+}
+
+std::string megabytes(const int64_t bytes) {
+    if (bytes < 0) {
+        return "n/a";
+    }
+    return std::to_string(bytes / (1024 * 1024));
+}
+
+void print_phase(const char* name, const resource_usage& start, const resource_usage& end) {
+    const double seconds = std::chrono::duration<double>(end.time - start.time).count();
+    const bool have_io = start.read_bytes >= 0 && end.read_bytes >= 0;
+
+    std::cout << "phase=" << name
+              << " seconds=" << seconds
+              << " major_faults=" << (end.major_faults - start.major_faults)
+              << " minor_faults=" << (end.minor_faults - start.minor_faults)
+              << " read_mb=" << megabytes(have_io ? end.read_bytes - start.read_bytes : -1)
+              << " write_mb=" << megabytes(have_io ? end.write_bytes - start.write_bytes : -1)
+              << " max_rss_mb=" << end.max_rss_kb / 1024
+              << "\n";
+}
+
+// Memory limit of the cgroup this process is in. Returns "unlimited" if
+// there is none or "n/a" if it can't be found out.
+std::string cgroup_memory_limit() {
+#ifdef __linux__
+    std::ifstream cgroups{"/proc/self/cgroup"};
+    std::string line;
+    while (std::getline(cgroups, line)) {
+        // Lines look like "0::/path" for cgroup v2 and like
+        // "4:memory:/path" for the v1 memory controller.
+        const auto first = line.find(':');
+        const auto second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+        const auto controllers = line.substr(first + 1, second - first - 1);
+        const auto path = line.substr(second + 1);
+
+        std::string limit;
+        if (controllers.empty()) {
+            std::ifstream file{"/sys/fs/cgroup" + path + "/memory.max"};
+            std::getline(file, limit);
+        } else if (controllers == "memory") {
+            std::ifstream file{"/sys/fs/cgroup/memory" + path + "/memory.limit_in_bytes"};
+            std::getline(file, limit);
+            // cgroup v1 reports "no limit" as a huge number.
+            if (!limit.empty() && std::atoll(limit.c_str()) >= (INT64_C(1) << 60)) {
+                limit = "max";
+            }
+        }
+        if (limit == "max") {
+            return "unlimited";
+        }
+        if (!limit.empty()) {
+            return megabytes(std::atoll(limit.c_str())) + "MB";
+        }
+    }
+#endif
+    return "n/a";
+}
+
+osmium::MemoryMapping::access_hint parse_access_hint(const std::string& name) {
+    if (name == "normal") {
+        return osmium::MemoryMapping::access_hint::normal;
+    }
+    if (name == "sequential") {
+        return osmium::MemoryMapping::access_hint::sequential;
+    }
+    if (name == "random") {
+        return osmium::MemoryMapping::access_hint::random;
+    }
+    if (name == "willneed") {
+        return osmium::MemoryMapping::access_hint::willneed;
+    }
+    throw std::invalid_argument{"Unknown access hint '" + name + "' (use normal, sequential, random, or willneed)"};
+}
+
+void run_combined(const std::string& input_filename, index_type& index) {
+    osmium::io::Reader reader{input_filename};
+
+    location_handler_type location_handler{index};
+    location_handler.ignore_errors();
+
+    osmium::apply(reader, location_handler);
+    reader.close();
+}
+
+void run_phases(const std::string& input_filename, const std::string& location_store, index_type& index, const osmium::MemoryMapping::access_hint lookup_hint, const std::string& hint_name) {
+    std::cout << "input=" << input_filename
+              << " index=" << location_store
+              << " lookup_hint=" << hint_name
+              << " memory_limit=" << cgroup_memory_limit()
+              << "\n";
+
+    uint64_t nodes = 0;
+    const auto fill_start = get_resource_usage();
+    {
+        index.set_access_hint(osmium::MemoryMapping::access_hint::sequential);
+        osmium::io::Reader reader{input_filename, osmium::osm_entity_bits::node};
+        while (const osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                if (node.id() >= 0) {
+                    index.set(node.positive_id(), node.location());
+                    ++nodes;
+                }
+            }
+        }
+        reader.close();
+        index.sort();
+        index.build_search_layout();
+    }
+    const auto fill_end = get_resource_usage();
+    print_phase("fill", fill_start, fill_end);
+
+    uint64_t ways = 0;
+    uint64_t lookups = 0;
+    uint64_t missing = 0;
+    const auto lookup_start = get_resource_usage();
+    {
+        index.set_access_hint(lookup_hint);
+        osmium::io::Reader reader{input_filename, osmium::osm_entity_bits::way};
+        while (const osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& way : buffer.select<osmium::Way>()) {
+                ++ways;
+                for (const auto& node_ref : way.nodes()) {
+                    ++lookups;
+                    if (node_ref.ref() < 0 || !index.get_noexcept(node_ref.positive_ref()).valid()) {
+                        ++missing;
+                    }
+                }
+            }
+        }
+        reader.close();
+    }
+    const auto lookup_end = get_resource_usage();
+    print_phase("lookup", lookup_start, lookup_end);
+
+    std::cout << "nodes=" << nodes
+              << " ways=" << ways
+              << " lookups=" << lookups
+              << " missing=" << missing
+              << " index_mb=" << megabytes(static_cast<int64_t>(index.used_memory()))
+              << "\n";
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " OSMFILE FORMAT\n";
+    if (argc < 3 || argc > 4) {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE FORMAT [LOOKUP_HINT]\n";
         return 1;
     }
 
@@ -28,15 +245,15 @@ int main(int argc, char* argv[]) {
         const std::string input_filename{argv[1]};
         const std::string location_store{argv[2]};
 
-        osmium::io::Reader reader{input_filename};
-
         const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
         std::unique_ptr<index_type> index = map_factory.create_map(location_store);
-        location_handler_type location_handler{*index};
-        location_handler.ignore_errors();
 
-        osmium::apply(reader, location_handler);
-        reader.close();
+        if (argc == 4) {
+            const std::string hint_name{argv[3]};
+            run_phases(input_filename, location_store, *index, parse_access_hint(hint_name), hint_name);
+        } else {
+            run_combined(input_filename, *index);
+        }
     } catch (const std::exception& e) {
         std::cerr << e.what() << '\n';
         return 1;
@@ -44,4 +261,3 @@ int main(int argc, char* argv[]) {
 
     return 0;
 }
-
@@ -0,0 +1,184 @@
+/*
+
+  This benchmark measures how the read throughput scales with the number of
+  threads in the pool, the sizes of the queues between the reader stages,
+  and whether PBF blobs are decoded in the pool threads or in the parser
+  thread. This is what the OSMIUM_POOL_THREADS, OSMIUM_MAX_*_QUEUE_SIZE,
+  and OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING environment variables
+  configure.
+
+  The input file is read completely for every configuration and the objects
+  are counted. For every run this prints the number of objects per second,
+  the speedup against one pool thread, the parallel efficiency (speedup per
+  thread), the CPU time used as percentage of the wall clock time, and how
+  busy the pool threads were.
+
+  All data has to go through the single read thread and the single parser
+  thread which splits the input into blobs. Runs where more pool threads
+  didn't help and the pool threads were mostly idle are marked with
+  "framing-bound", from there on adding threads is a waste.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/io/any_input.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct run_config {
+    int threads;
+    std::size_t queue_size;
+    bool pool_parsing;
+};
+
+struct run_result {
+    uint64_t objects = 0;
+    double seconds = 0.0;
+    double cpu_seconds = 0.0;
+    double pool_utilization = 0.0;
+    uint64_t input_queue_full = 0;
+    uint64_t input_queue_empty = 0;
+};
+
+// The Reader and Pool read these settings from the environment when they
+// are created.
+void set_environment(const run_config& config) {
+    const auto queue_size = std::to_string(config.queue_size);
+    setenv("OSMIUM_MAX_INPUT_QUEUE_SIZE", queue_size.c_str(), 1);
+    setenv("OSMIUM_MAX_OSMDATA_QUEUE_SIZE", queue_size.c_str(), 1);
+    setenv("OSMIUM_MAX_WORK_QUEUE_SIZE", queue_size.c_str(), 1);
+    setenv("OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING", config.pool_parsing ? "yes" : "no", 1);
+}
+
+run_result run(const osmium::io::File& file, const run_config& config) {
+    set_environment(config);
+
+    run_result result;
+
+    const auto start_cpu = std::clock();
+    const auto start = std::chrono::steady_clock::now();
+
+    osmium::thread::Pool pool{config.threads};
+    osmium::io::Reader reader{file, pool};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        result.objects += static_cast<uint64_t>(std::distance(buffer.begin(), buffer.end()));
+    }
+
+    const auto reader_stats = reader.stats();
+    result.input_queue_full = reader_stats.input_queue.full_count;
+    result.input_queue_empty = reader_stats.input_queue.empty_count;
+    result.pool_utilization = pool.stats().utilization();
+    reader.close();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cpu_seconds = static_cast<double>(std::clock() - start_cpu) / CLOCKS_PER_SEC;
+
+    return result;
+}
+
+void print_header() {
+    std::cout << "parsing  queue threads      objects/s  speedup  efficiency   cpu%  pool_util  inq_full inq_empty\n";
+}
+
+void print_result(const run_config& config, const run_result& result, const double base_rate, const bool framing_bound) {
+    const double rate = result.seconds > 0 ? static_cast<double>(result.objects) / result.seconds : 0.0;
+    const double speedup = base_rate > 0 ? rate / base_rate : 0.0;
+
+    std::cout << std::fixed
+              << std::setw(7) << (config.pool_parsing ? "pool" : "parser")
+              << std::setw(7) << config.queue_size
+              << std::setw(8) << config.threads
+              << std::setw(15) << std::setprecision(0) << rate
+              << std::setw(9) << std::setprecision(2) << speedup
+              << std::setw(12) << std::setprecision(2) << speedup / config.threads
+              << std::setw(7) << std::setprecision(0) << (result.seconds > 0 ? 100.0 * result.cpu_seconds / result.seconds : 0.0)
+              << std::setw(11) << std::setprecision(2) << result.pool_utilization
+              << std::setw(10) << result.input_queue_full
+              << std::setw(10) << result.input_queue_empty
+              << (framing_bound ? "  framing-bound" : "")
+              << '\n';
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE [MAX_THREADS]\n";
+        return 1;
+    }
+
+    try {
+        const osmium::io::File file{argv[1]};
+
+        int max_threads = argc == 3 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+        max_threads = std::max(1, std::min(max_threads, static_cast<int>(osmium::thread::detail::max_pool_threads)));
+
+        std::vector<int> thread_counts;
+        for (int n = 1; n < max_threads; n *= 2) {
+            thread_counts.push_back(n);
+        }
+        thread_counts.push_back(max_threads);
+
+        const std::vector<std::size_t> queue_sizes = {4, 20, 100};
+
+        // Read the file once so that it is in the page cache for all runs.
+        run(file, run_config{1, 20, true});
+
+        std::cout << "file: " << argv[1] << "\n";
+        print_header();
+
+        int framing_bound_threads = 0;
+        for (const auto queue_size : queue_sizes) {
+            // Baseline: all blobs are decoded in the parser thread, the
+            // number of pool threads doesn't matter.
+            const run_config parser_config{1, queue_size, false};
+            const auto parser_result = run(file, parser_config);
+
+            double base_rate = 0.0;
+            double previous_rate = 0.0;
+            for (const auto threads : thread_counts) {
+                const run_config config{threads, queue_size, true};
+                const auto result = run(file, config);
+                const double rate = static_cast<double>(result.objects) / result.seconds;
+                if (base_rate == 0.0) {
+                    base_rate = rate;
+                }
+
+                // More threads didn't give at least 10% more throughput
+                // and the pool threads were idle most of the time: they are
+                // waiting for the read and parser threads to give them work.
+                const bool framing_bound = previous_rate > 0.0 &&
+                                           rate < previous_rate * 1.1 &&
+                                           result.pool_utilization < 0.75;
+                if (framing_bound && (framing_bound_threads == 0 || threads < framing_bound_threads)) {
+                    framing_bound_threads = threads;
+                }
+
+                print_result(config, result, base_rate, framing_bound);
+                previous_rate = rate;
+            }
+            print_result(parser_config, parser_result, base_rate, false);
+        }
+
+        if (framing_bound_threads > 0) {
+            std::cout << "\nThroughput is limited by the read and parser threads from "
+                      << framing_bound_threads << " pool threads on.\n";
+        } else {
+            std::cout << "\nThroughput still scaled at " << max_threads << " pool threads.\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,508 @@
+/*
+
+  Micro benchmarks for the core parts of Libosmium on reproducible
+  synthetic data. See osmium_benchmark.hpp for the command line options.
+  Use --benchmark_format=json or --benchmark_out=FILE to get the results
+  in machine-readable form.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include "osmium_benchmark.hpp"
+#include "osmium_benchmark_data.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/index/map/all.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/io/any_output.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/tags/taglist.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/lockfree_queue.hpp>
+#include <osmium/thread/queue.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // The data set used for the PBF and output benchmarks.
+    const osmium::memory::Buffer& sample_data() {
+        static const osmium::memory::Buffer buffer = [] {
+            osmium::memory::Buffer data{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+            osmium_benchmark::add_nodes(data, 100000);
+            osmium_benchmark::add_ways(data, 10000, 100000);
+            osmium_benchmark::add_relations(data, 1000, 10000);
+            return data;
+        }();
+        return buffer;
+    }
+
+    osmium::memory::Buffer copy_buffer(const osmium::memory::Buffer& buffer) {
+        osmium::memory::Buffer copy{buffer.committed(), osmium::memory::Buffer::auto_grow::yes};
+        copy.add_buffer(buffer);
+        copy.commit();
+        return copy;
+    }
+
+    /*************************************************************************
+     *
+     * Building objects in and iterating over buffers
+     *
+     *************************************************************************/
+
+    enum {
+        build_count = 10000
+    };
+
+    void add_node_with_tags(osmium::memory::Buffer& buffer, const osmium::object_id_type id, const int64_t num_tags) {
+        static const char* keys[] = {"highway", "building", "name", "amenity", "surface", "natural", "source", "oneway"};
+        {
+            osmium::builder::NodeBuilder builder{buffer};
+            builder.set_id(id)
+                   .set_version(1)
+                   .set_changeset(1000)
+                   .set_timestamp(1500000000)
+                   .set_uid(1)
+                   .set_location(osmium::Location{8.0, 48.0});
+            builder.set_user("benchmark");
+            if (num_tags > 0) {
+                osmium::builder::TagListBuilder tags{builder};
+                for (int64_t i = 0; i < num_tags; ++i) {
+                    tags.add_tag(keys[i % 8], "value");
+                }
+            }
+        }
+        buffer.commit();
+    }
+
+    void buffer_build_nodes(osmium_benchmark::State& state) {
+        const auto num_tags = state.range(0);
+        osmium::memory::Buffer buffer{16 * 1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        std::size_t bytes = 0;
+        while (state.keep_running()) {
+            buffer.clear();
+            for (int i = 1; i <= build_count; ++i) {
+                add_node_with_tags(buffer, i, num_tags);
+            }
+            bytes += buffer.committed();
+        }
+        state.set_items_processed(static_cast<int64_t>(state.iterations()) * build_count);
+        state.set_bytes_processed(static_cast<int64_t>(bytes));
+    }
+    OSMIUM_BENCHMARK(buffer_build_nodes)->arg(0)->arg(2)->arg(8)->arg(32);
+
+    void buffer_build_ways(osmium_benchmark::State& state) {
+        const auto num_nodes = state.range(0);
+        osmium::memory::Buffer buffer{64 * 1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        std::size_t bytes = 0;
+        while (state.keep_running()) {
+            buffer.clear();
+            for (int i = 1; i <= build_count; ++i) {
+                {
+                    osmium::builder::WayBuilder builder{buffer};
+                    builder.set_id(i).set_version(1);
+                    builder.set_user("benchmark");
+                    {
+                        osmium::builder::WayNodeListBuilder nodes{builder};
+                        for (int64_t n = 0; n < num_nodes; ++n) {
+                            nodes.add_node_ref(i + n);
+                        }
+                    }
+                    osmium::builder::TagListBuilder tags{builder};
+                    tags.add_tag("highway", "residential");
+                }
+                buffer.commit();
+            }
+            bytes += buffer.committed();
+        }
+        state.set_items_processed(static_cast<int64_t>(state.iterations()) * build_count);
+        state.set_bytes_processed(static_cast<int64_t>(bytes));
+    }
+    OSMIUM_BENCHMARK(buffer_build_ways)->arg(2)->arg(20)->arg(200);
+
+    // Build into a buffer starting with the given size which has to grow
+    // (auto_grow::yes) or chain new buffers (auto_grow::internal).
+    void buffer_grow(osmium_benchmark::State& state) {
+        const auto initial_size = static_cast<std::size_t>(state.range(0));
+        const auto mode = state.range(1) ? osmium::memory::Buffer::auto_grow::internal
+                                         : osmium::memory::Buffer::auto_grow::yes;
+        std::size_t capacity = 0;
+        while (state.keep_running()) {
+            osmium::memory::Buffer buffer{initial_size, mode};
+            for (int i = 1; i <= build_count; ++i) {
+                add_node_with_tags(buffer, i, 4);
+            }
+            capacity = buffer.capacity();
+        }
+        state.set_items_processed(static_cast<int64_t>(state.iterations()) * build_count);
+        state.counters()["capacity"] = static_cast<double>(capacity);
+        state.set_label(state.range(1) ? "internal" : "yes");
+    }
+    OSMIUM_BENCHMARK(buffer_grow)->args({4096, 0})->args({1024 * 1024, 0})->args({16 * 1024 * 1024, 0})->args({4096, 1});
+
+    struct purge_callback {
+        void moving_in_buffer(std::size_t /*old_offset*/, std::size_t /*new_offset*/) noexcept {
+        }
+    };
+
+    // Purge a buffer where every n-th object is marked as removed.
+    void buffer_purge_removed(osmium_benchmark::State& state) {
+        const auto& data = sample_data();
+        const auto every = state.range(0);
+        purge_callback callback;
+        while (state.keep_running()) {
+            state.pause_timing();
+            auto buffer = copy_buffer(data);
+            int64_t n = 0;
+            for (auto& object : buffer.select<osmium::OSMObject>()) {
+                if (n++ % every == 0) {
+                    object.set_removed(true);
+                }
+            }
+            state.resume_timing();
+
+            buffer.purge_removed(&callback);
+        }
+        state.set_items_processed(static_cast<int64_t>(state.iterations()) * std::distance(data.begin(), data.end()));
+        state.set_bytes_processed(static_cast<int64_t>(state.iterations() * data.committed()));
+    }
+    OSMIUM_BENCHMARK(buffer_purge_removed)->arg(1)->arg(2)->arg(10)->arg(1000);
+
+    template <typename TItem>
+    void buffer_iterate(osmium_benchmark::State& state) {
+        const auto& data = sample_data();
+        int64_t items = 0;
+        std::size_t size = 0;
+        while (state.keep_running()) {
+            for (const auto& item : data.select<TItem>()) {
+                size += item.byte_size();
+                ++items;
+            }
+        }
+        if (size == 0) {
+            std::cerr << "no items found\n";
+        }
+        state.set_items_processed(items);
+    }
+
+    void register_buffer_benchmarks() {
+        osmium_benchmark::register_benchmark("buffer_iterate/all", buffer_iterate<osmium::memory::Item>);
+        osmium_benchmark::register_benchmark("buffer_iterate/objects", buffer_iterate<osmium::OSMObject>);
+        osmium_benchmark::register_benchmark("buffer_iterate/nodes", buffer_iterate<osmium::Node>);
+        osmium_benchmark::register_benchmark("buffer_iterate/ways", buffer_iterate<osmium::Way>);
+        osmium_benchmark::register_benchmark("buffer_iterate/relations", buffer_iterate<osmium::Relation>);
+    }
+
+    /*************************************************************************
+     *
+     * PBF decoding of single blobs
+     *
+     *************************************************************************/
+
+    class PBFSample {
+
+        std::string m_data;
+        std::vector<osmium::io::detail::pbf_blob_position> m_blobs;
+        std::vector<int64_t> m_objects;
+
+    public:
+
+        PBFSample() {
+            const std::string filename{"osmium_benchmark_suite.osm.pbf"};
+            {
+                osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+                writer(copy_buffer(sample_data()));
+                writer.close();
+            }
+
+            std::ifstream file{filename, std::ios::binary};
+            m_data.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+            file.close();
+            std::remove(filename.c_str());
+
+            m_blobs = osmium::io::detail::find_pbf_blobs(m_data.data(), m_data.size());
+            m_blobs.erase(m_blobs.begin()); // the OSMHeader blob
+
+            for (std::size_t i = 0; i < m_blobs.size(); ++i) {
+                const auto buffer = decode(i);
+                m_objects.push_back(std::distance(buffer.begin(), buffer.end()));
+            }
+        }
+
+        std::size_t size() const noexcept {
+            return m_blobs.size();
+        }
+
+        std::size_t blob_size(const std::size_t n) const noexcept {
+            return m_blobs[n].size;
+        }
+
+        int64_t objects(const std::size_t n) const noexcept {
+            return m_objects[n];
+        }
+
+        osmium::memory::Buffer decode(const std::size_t n) const {
+            const auto& blob = m_blobs[n];
+            osmium::io::detail::PBFDataBlobDecoder decoder{
+                osmium::io::detail::pbf_blob_data{nullptr, protozero::data_view{m_data.data() + blob.offset, blob.size}},
+                osmium::osm_entity_bits::all,
+                osmium::io::read_meta::yes};
+            return decoder();
+        }
+
+    }; // class PBFSample
+
+    void pbf_decode_blob(osmium_benchmark::State& state) {
+        static const PBFSample sample;
+
+        int64_t objects = 0;
+        int64_t bytes = 0;
+        std::size_t n = 0;
+        while (state.keep_running()) {
+            const auto buffer = sample.decode(n);
+            objects += sample.objects(n);
+            bytes += static_cast<int64_t>(sample.blob_size(n));
+            n = (n + 1) % sample.size();
+        }
+        state.set_items_processed(objects);
+        state.set_bytes_processed(bytes);
+    }
+
+    /*************************************************************************
+     *
+     * Location index set and get for all map types
+     *
+     *************************************************************************/
+
+    using map_factory_type = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>;
+
+    enum {
+        index_size = 1000000,
+        lookups_per_iteration = 1024
+    };
+
+    // Ids with gaps like in real data.
+    std::vector<osmium::unsigned_object_id_type> index_ids() {
+        osmium_benchmark::Random random{4};
+        std::vector<osmium::unsigned_object_id_type> ids;
+        ids.reserve(index_size);
+        osmium::unsigned_object_id_type id = 0;
+        for (int i = 0; i < index_size; ++i) {
+            id += 1 + random.uniform(3);
+            ids.push_back(id);
+        }
+        return ids;
+    }
+
+    void index_set(osmium_benchmark::State& state, const std::string& map_type) {
+        const auto ids = index_ids();
+        while (state.keep_running()) {
+            auto index = map_factory_type::instance().create_map(map_type);
+            for (const auto id : ids) {
+                index->set(id, osmium::Location{int32_t(id), int32_t(id)});
+            }
+            index->sort();
+        }
+        state.set_items_processed(static_cast<int64_t>(state.iterations()) * index_size);
+    }
+
+    void index_get(osmium_benchmark::State& state, const std::string& map_type) {
+        const auto ids = index_ids();
+        auto index = map_factory_type::instance().create_map(map_type);
+        for (const auto id : ids) {
+            index->set(id, osmium::Location{int32_t(id), int32_t(id)});
+        }
+        index->sort();
+
+        osmium_benchmark::Random random{5};
+        std::vector<osmium::unsigned_object_id_type> lookups;
+        for (int i = 0; i < 64 * lookups_per_iteration; ++i) {
+            lookups.push_back(ids[random.uniform(index_size)]);
+        }
+
+        int64_t sum = 0;
+        std::size_t n = 0;
+        while (state.keep_running()) {
+            for (int i = 0; i < lookups_per_iteration; ++i) {
+                sum += index->get_noexcept(lookups[n]).x();
+                n = (n + 1) % lookups.size();
+            }
+        }
+        if (sum == 0) {
+            std::cerr << "no locations found\n";
+        }
+        state.set_items_processed(static_cast<int64_t>(state.iterations()) * lookups_per_iteration);
+    }
+
+    void register_index_benchmarks() {
+        for (const auto& map_type : map_factory_type::instance().map_types()) {
+            // File based maps need a file name, they are benchmarked
+            // with osmium_benchmark_index_map on real data.
+            if (map_type.find("file") != std::string::npos) {
+                continue;
+            }
+            osmium_benchmark::register_benchmark("index_set/" + map_type, [map_type](osmium_benchmark::State& state) {
+                index_set(state, map_type);
+            });
+            osmium_benchmark::register_benchmark("index_get/" + map_type, [map_type](osmium_benchmark::State& state) {
+                index_get(state, map_type);
+            });
+        }
+    }
+
+    /*************************************************************************
+     *
+     * Tags filter throughput
+     *
+     *************************************************************************/
+
+    void tags_filter(osmium_benchmark::State& state) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium_benchmark::add_nodes(buffer, 100000, 6);
+
+        osmium::TagsFilter filter{false};
+        filter.add_rule(false, osmium::TagMatcher{"highway", "motorway"});
+        filter.add_rule(true, osmium::TagMatcher{"highway"});
+        filter.add_rule(true, osmium::TagMatcher{"amenity", osmium::StringMatcher::list{{"restaurant", "school"}}});
+        filter.add_rule(true, osmium::TagMatcher{osmium::StringMatcher::prefix{"build"}});
+
+        int64_t matches = 0;
+        int64_t nodes = 0;
+        while (state.keep_running()) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                if (osmium::tags::match_any_of(node.tags(), filter)) {
+                    ++matches;
+                }
+                ++nodes;
+            }
+        }
+        state.set_items_processed(nodes);
+        state.counters()["match_ratio"] = nodes ? static_cast<double>(matches) / static_cast<double>(nodes) : 0.0;
+    }
+    OSMIUM_BENCHMARK(tags_filter);
+
+    /*************************************************************************
+     *
+     * Area assembly by kind of multipolygon
+     *
+     *************************************************************************/
+
+    void area_assembly(osmium_benchmark::State& state) {
+        const osmium_benchmark::MultipolygonData data{static_cast<osmium_benchmark::polygon_class>(state.range(0)),
+                                                      static_cast<uint32_t>(state.range(1))};
+        const auto ways = data.ways();
+
+        osmium::area::AssemblerConfig config;
+        osmium::memory::Buffer out_buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        while (state.keep_running()) {
+            osmium::area::Assembler assembler{config};
+            assembler(data.relation(), ways, out_buffer);
+            out_buffer.clear();
+        }
+        state.set_items_processed(static_cast<int64_t>(state.iterations()));
+        state.counters()["nodes"] = static_cast<double>(data.num_nodes());
+
+        static const char* labels[] = {"simple", "with_holes", "multi_outer"};
+        state.set_label(labels[state.range(0)]);
+    }
+    OSMIUM_BENCHMARK(area_assembly)->args({0, 100})->args({1, 100})->args({2, 100})->args({0, 10000});
+
+    /*************************************************************************
+     *
+     * Output format encoding (through the Writer to /dev/null)
+     *
+     *************************************************************************/
+
+    void output_encoding(osmium_benchmark::State& state, const std::string& format) {
+        const auto& data = sample_data();
+        const auto objects = std::distance(data.begin(), data.end());
+
+        while (state.keep_running()) {
+            state.pause_timing();
+            auto buffer = copy_buffer(data);
+            state.resume_timing();
+
+            osmium::io::Writer writer{osmium::io::File{"/dev/null", format}, osmium::io::overwrite::allow};
+            writer(std::move(buffer));
+            writer.close();
+        }
+        state.set_items_processed(static_cast<int64_t>(state.iterations()) * objects);
+        state.set_bytes_processed(static_cast<int64_t>(state.iterations() * data.committed()));
+    }
+
+    void register_output_benchmarks() {
+        for (const std::string format : {"opl", "xml", "pbf", "pbf,pbf_compression=none", "o5m", "geojsonseq", "parquet", "debug,color=false"}) {
+            osmium_benchmark::register_benchmark("output_encoding/" + format, [format](osmium_benchmark::State& state) {
+                output_encoding(state, format);
+            });
+        }
+    }
+
+    /*************************************************************************
+     *
+     * Queue throughput with one producer and one consumer
+     *
+     *************************************************************************/
+
+    template <typename TQueue>
+    void queue_throughput(osmium_benchmark::State& state) {
+        const auto count = state.range(0);
+        TQueue queue{static_cast<std::size_t>(state.range(1)), "benchmark"};
+
+        while (state.keep_running()) {
+            std::thread producer{[&queue, count] {
+                for (int64_t i = 0; i < count; ++i) {
+                    queue.push(i);
+                }
+            }};
+            int64_t value = 0;
+            for (int64_t i = 0; i < count; ++i) {
+                queue.wait_and_pop(value);
+            }
+            producer.join();
+        }
+        state.set_items_processed(static_cast<int64_t>(state.iterations()) * count);
+    }
+
+    void register_queue_benchmarks() {
+        osmium_benchmark::register_benchmark("queue_throughput/Queue", queue_throughput<osmium::thread::Queue<int64_t>>)
+            ->args({100000, 20})->args({100000, 1000});
+        osmium_benchmark::register_benchmark("queue_throughput/LockFreeQueue", queue_throughput<osmium::thread::LockFreeQueue<int64_t>>)
+            ->args({100000, 20})->args({100000, 1000});
+    }
+
+} // anonymous namespace
+
+OSMIUM_BENCHMARK(pbf_decode_blob);
+
+int main(int argc, char* argv[]) {
+    register_buffer_benchmarks();
+    register_index_benchmarks();
+    register_output_benchmarks();
+    register_queue_benchmarks();
+
+    try {
+        return osmium_benchmark::run_benchmarks(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,17 @@
+#!/bin/sh
+#
+#  run_benchmark_assembler.sh
+#
+#  Runs the area assembler on a corpus of pathological multipolygon
+#  relations. Doesn't need the files in DATA_DIR.
+#
+
+set -e
+
+BENCHMARK_NAME=assembler
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+$CMD
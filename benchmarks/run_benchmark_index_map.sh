@@ -2,6 +2,13 @@
 #
 #  run_benchmark_index_map.sh
 #
+#  Set OSMIUM_BENCHMARK_MEMORY_LIMIT (for instance to "1G") to run the
+#  index fill and the way lookups as separate phases in a cgroup with that
+#  memory limit (needs systemd-run). This reports page faults and I/O per
+#  phase. Set OSMIUM_BENCHMARK_LOOKUP_HINTS to a list of access hints to
+#  compare (default "random") and OSMIUM_BENCHMARK_MAPS to the index types
+#  to use.
+#
 
 set -e
 
@@ -12,7 +19,19 @@ BENCHMARK_NAME=index_map
 CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
 
 #MAPS="sparse_mem_map sparse_mem_table sparse_mem_array sparse_mmap_array sparse_file_array dense_mem_array dense_mmap_array dense_file_array"
-MAPS="sparse_mem_map sparse_mem_table sparse_mem_array sparse_mmap_array sparse_file_array"
+MAPS=${OSMIUM_BENCHMARK_MAPS:-"sparse_mem_map sparse_mem_table sparse_mem_array sparse_mmap_array sparse_file_array"}
+
+if [ -n "$OSMIUM_BENCHMARK_MEMORY_LIMIT" ]; then
+    LIMIT_CMD="systemd-run --user --scope --quiet -p MemoryMax=$OSMIUM_BENCHMARK_MEMORY_LIMIT -p MemorySwapMax=0"
+    for data in $OB_DATA_FILES; do
+        for map in $MAPS; do
+            for hint in ${OSMIUM_BENCHMARK_LOOKUP_HINTS:-random}; do
+                $LIMIT_CMD $CMD $data $map $hint | sed -e "s%$DATA_DIR/%%"
+            done
+        done
+    done
+    exit 0
+fi
 
 echo "# file size num mem time cpu_kernel cpu_user cpu_percent cmd options"
 for data in $OB_DATA_FILES; do
@@ -0,0 +1,20 @@
+#!/bin/sh
+#
+#  run_benchmark_scaling.sh
+#
+#  Will read each input file with different numbers of pool threads and
+#  queue sizes and report how the throughput scales.
+#
+
+set -e
+
+BENCHMARK_NAME=scaling
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+for data in $OB_DATA_FILES; do
+    $CMD $data | sed -e "s%$DATA_DIR/%%"
+done
+
@@ -0,0 +1,26 @@
+#!/bin/sh
+#
+#  run_benchmark_suite.sh
+#
+#  Runs the micro benchmarks on synthetic data. They don't need the files
+#  in DATA_DIR. Results are written as JSON to stdout in the same format
+#  Google Benchmark uses, so they can be compared with its tools.
+#
+#  Set OSMIUM_BENCHMARK_PERF_COUNTERS to "all" or a comma separated list of
+#  counter names to also collect hardware performance counters (Linux only).
+#
+
+set -e
+
+BENCHMARK_NAME=suite
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+if [ -n "$OSMIUM_BENCHMARK_PERF_COUNTERS" ]; then
+    $CMD --benchmark_format=json --benchmark_perf_counters=$OSMIUM_BENCHMARK_PERF_COUNTERS
+else
+    $CMD --benchmark_format=json
+fi
+
@@ -46,6 +46,10 @@
 
 // The functions in this class will be called for each object in the input
 // and will write a (changed) copy of those objects to the given buffer.
+// They show how to use the builders to create objects field by field. If you
+// only want to change the tags, the osmium::builder::copy_with_new_tags()
+// function does the same much faster, because it copies everything except
+// the tags as whole blocks of memory.
 class RewriteHandler : public osmium::handler::Handler {
 
     osmium::memory::Buffer& m_buffer;
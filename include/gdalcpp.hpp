@@ -44,6 +44,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <cstdint>
 #include <algorithm>
+#include <cstddef>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -358,6 +359,10 @@ namespace gdalcpp {
             return *this;
         }
 
+        bool auto_transactions() const noexcept {
+            return m_max_edit_count != 0;
+        }
+
         Dataset& disable_auto_transactions() {
             if (m_max_edit_count != 0 && m_edit_count > 0) {
                 commit_transaction();
@@ -512,6 +517,74 @@ namespace gdalcpp {
 
     }; // class Feature
 
+    /**
+     * Collects features and adds them to their layers in batches of the
+     * configured size. If auto transactions are not enabled on the
+     * dataset, each batch is added in a single transaction. Features still
+     * in the batch are added when flush() is called or the batch is
+     * destroyed.
+     */
+    class FeatureBatch {
+
+        Dataset& m_dataset;
+        std::vector<Feature> m_features;
+        std::size_t m_batch_size;
+
+    public:
+
+        explicit FeatureBatch(Dataset& dataset, std::size_t batch_size = 10000) :
+            m_dataset(dataset),
+            m_batch_size(batch_size == 0 ? 1 : batch_size) {
+            m_features.reserve(m_batch_size);
+        }
+
+        FeatureBatch(const FeatureBatch&) = delete;
+        FeatureBatch& operator=(const FeatureBatch&) = delete;
+
+        FeatureBatch(FeatureBatch&&) = delete;
+        FeatureBatch& operator=(FeatureBatch&&) = delete;
+
+        ~FeatureBatch() noexcept {
+            try {
+                flush();
+            } catch (...) {
+            }
+        }
+
+        std::size_t size() const noexcept {
+            return m_features.size();
+        }
+
+        void add(Feature&& feature) {
+            m_features.push_back(std::move(feature));
+            if (m_features.size() >= m_batch_size) {
+                flush();
+            }
+        }
+
+        void flush() {
+            if (m_features.empty()) {
+                return;
+            }
+
+            std::vector<Feature> features;
+            features.reserve(m_batch_size);
+            std::swap(features, m_features);
+
+            const bool own_transaction = !m_dataset.auto_transactions();
+            if (own_transaction) {
+                m_dataset.start_transaction();
+            }
+            for (auto& feature : features) {
+                feature.add_to_layer();
+            }
+            if (own_transaction) {
+                m_dataset.commit_transaction();
+            }
+        }
+
+    }; // class FeatureBatch
+
 } // namespace gdalcpp
 
 #endif // GDALCPP_HPP
@@ -0,0 +1,201 @@
+#ifndef OSMIUM_AREA_AREA_CACHE_HPP
+#define OSMIUM_AREA_AREA_CACHE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * Cache for areas assembled from multipolygon relations. It is
+         * used by the MultipolygonManager (see
+         * MultipolygonManager::set_cache()) to avoid assembling areas
+         * again when they can't have changed. This is useful when areas
+         * are updated from change files: Keep the cache around between
+         * runs and only relations whose geometry changed are assembled
+         * again.
+         *
+         * Entries are keyed on the relation id. Each entry remembers the
+         * version of the relation and a digest of the ids and versions
+         * of all member ways and the ids and locations of all their
+         * nodes. An entry is only used if version and digest both match,
+         * so any change to the relation, to one of the member ways, or
+         * to the location of any node results in a new assembly.
+         */
+        class AreaCache {
+
+            struct entry {
+                osmium::object_version_type version;
+                uint64_t digest;
+                std::vector<unsigned char> data;
+            }; // struct entry
+
+            std::unordered_map<osmium::object_id_type, entry> m_entries;
+
+            std::size_t m_hits = 0;
+            std::size_t m_misses = 0;
+
+            static void mix(uint64_t& hash, uint64_t value) noexcept {
+                hash ^= value;
+                hash *= 0x100000001b3ULL;
+                hash ^= hash >> 29U;
+            }
+
+        public:
+
+            AreaCache() = default;
+
+            /**
+             * Calculate the digest of the relation members used as part
+             * of the cache key.
+             */
+            static uint64_t digest(const std::vector<const osmium::Way*>& ways) noexcept {
+                uint64_t hash = 0xcbf29ce484222325ULL;
+                for (const osmium::Way* way : ways) {
+                    mix(hash, static_cast<uint64_t>(way->id()));
+                    mix(hash, way->version());
+                    for (const osmium::NodeRef& nr : way->nodes()) {
+                        mix(hash, static_cast<uint64_t>(nr.ref()));
+                        mix(hash, (static_cast<uint64_t>(static_cast<uint32_t>(nr.location().x())) << 32U) |
+                                  static_cast<uint32_t>(nr.location().y()));
+                    }
+                }
+                return hash;
+            }
+
+            /**
+             * Look up the areas for the relation. If they are found, they
+             * are added to the buffer and committed.
+             *
+             * @param id The id of the relation.
+             * @param version The version of the relation.
+             * @param digest The digest of the members (see digest()).
+             * @param out_buffer The buffer the areas are added to.
+             * @returns true if the relation was found in the cache.
+             */
+            bool lookup(osmium::object_id_type id, osmium::object_version_type version, uint64_t digest, osmium::memory::Buffer& out_buffer) {
+                const auto it = m_entries.find(id);
+                if (it == m_entries.end() || it->second.version != version || it->second.digest != digest) {
+                    ++m_misses;
+                    return false;
+                }
+
+                ++m_hits;
+                const auto& data = it->second.data;
+                if (!data.empty()) {
+                    std::copy(data.cbegin(), data.cend(), out_buffer.reserve_space(data.size()));
+                    out_buffer.commit();
+                }
+                return true;
+            }
+
+            /**
+             * Store the areas assembled for a relation in the cache. An
+             * existing entry for the same relation is replaced.
+             *
+             * @param id The id of the relation.
+             * @param version The version of the relation.
+             * @param digest The digest of the members (see digest()).
+             * @param data Pointer to the committed items (usually one Area)
+             *             assembled from the relation. Can be nullptr if
+             *             size is 0.
+             * @param size Size of the data in bytes.
+             */
+            void store(osmium::object_id_type id, osmium::object_version_type version, uint64_t digest, const unsigned char* data, std::size_t size) {
+                auto& e = m_entries[id];
+                e.version = version;
+                e.digest = digest;
+                e.data.assign(data, data + size);
+            }
+
+            /**
+             * Remove the entry for the relation with the given id, for
+             * instance because the relation was deleted.
+             */
+            void remove(osmium::object_id_type id) {
+                m_entries.erase(id);
+            }
+
+            /**
+             * Remove all entries.
+             */
+            void clear() {
+                m_entries.clear();
+            }
+
+            /// The number of relations in the cache.
+            std::size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            /// The number of successful lookups.
+            std::size_t hits() const noexcept {
+                return m_hits;
+            }
+
+            /// The number of lookups where the relation wasn't in the
+            /// cache or the cached entry was out of date.
+            std::size_t misses() const noexcept {
+                return m_misses;
+            }
+
+            /// The memory used by the cached area data (not including
+            /// the overhead of the map).
+            std::size_t used_memory() const noexcept {
+                std::size_t sum = 0;
+                for (const auto& e : m_entries) {
+                    sum += e.second.data.capacity();
+                }
+                return sum;
+            }
+
+        }; // class AreaCache
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_AREA_CACHE_HPP
@@ -0,0 +1,523 @@
+#ifndef OSMIUM_AREA_AREA_UPDATER_HPP
+#define OSMIUM_AREA_AREA_UPDATER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/assembler_config.hpp>
+#include <osmium/area/stats.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/handler/update_object_relations.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/index/object_store.hpp>
+#include <osmium/index/update_node_locations.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/storage/item_stash.hpp>
+#include <osmium/tags/taglist.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * What happened to an area in an update.
+         */
+        enum class area_change_type {
+            created  = 0,
+            modified = 1,
+            deleted  = 2
+        };
+
+        /**
+         * Statistics for one call of AreaUpdater::apply().
+         */
+        struct area_update_stats {
+            std::size_t nodes = 0; ///< Changed nodes
+            std::size_t ways = 0; ///< Changed ways
+            std::size_t relations = 0; ///< Changed relations
+            std::size_t affected_ways = 0; ///< Ways changed or with changed nodes
+            std::size_t affected_relations = 0; ///< Relations changed or with affected member ways
+            std::size_t created = 0; ///< Areas created
+            std::size_t modified = 0; ///< Areas modified
+            std::size_t deleted = 0; ///< Areas deleted
+            area_stats assembler; ///< Statistics of the assembler runs
+        }; // struct area_update_stats
+
+        /**
+         * Keeps areas up to date from change files without reading the
+         * complete data again. For every change, the areas which could
+         * have changed are found, assembled again, and reported as
+         * created, modified, or deleted.
+         *
+         * The updater works on persistent data kept from the initial
+         * import and updated by the updater itself:
+         *
+         * - A node location index with the locations of all nodes.
+         * - The four indexes of the UpdateObjectRelations handler. The
+         *   node to way and way to relation indexes are used to find the
+         *   ways and relations affected by changed nodes and ways.
+         * - An ObjectStore with the ways and relations from the initial
+         *   import. The store can't be updated, so the updater keeps the
+         *   ways and relations changed later in memory. After a restart
+         *   give it all change files applied since the store was written
+         *   with load(). Write a new store from time to time to keep
+         *   this small.
+         *
+         * Areas are created from closed ways and from multipolygon and
+         * boundary relations like the MultipolygonManager does. All
+         * objects must have positive ids.
+         *
+         * The updater doesn't know whether the assembly of an area
+         * succeeded in an earlier run, only whether the object it was
+         * created from could have been assembled. So an area reported
+         * as modified might not have existed before and an area reported
+         * as deleted might never have been created. Treat modifications
+         * as "create or replace" and ignore deletions of unknown areas.
+         *
+         * @code
+         * osmium::area::AreaUpdater updater{&store, locations, w2n, n2w, r2w, w2r, config};
+         * osmium::io::Reader reader{"changes.osc.gz"};
+         * updater.apply_source(reader, [&](osmium::area::area_change_type change, const osmium::Area& area) {
+         *     ...
+         * });
+         * @endcode
+         */
+        class AreaUpdater {
+
+        public:
+
+            using location_index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+            using relations_index_type = osmium::handler::UpdateObjectRelations::index_type;
+
+        private:
+
+            using id_list = std::vector<osmium::unsigned_object_id_type>;
+            using handle_map = std::unordered_map<osmium::unsigned_object_id_type, osmium::ItemStash::handle_type>;
+
+            const osmium::index::ObjectStore* m_store;
+            location_index_type& m_locations;
+            relations_index_type& m_index_w2n;
+            relations_index_type& m_index_n2w;
+            relations_index_type& m_index_r2w;
+            relations_index_type& m_index_w2r;
+            AssemblerConfig m_assembler_config;
+            osmium::TagsFilter m_filter;
+
+            // Ways and relations changed after the store was written,
+            // including deleted ones.
+            osmium::ItemStash m_stash;
+            handle_map m_ways;
+            handle_map m_relations;
+
+            // Member ways with node locations for the assembler.
+            osmium::memory::Buffer m_member_ways{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+            // The area given to the callback.
+            osmium::memory::Buffer m_output{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+            static void sort_unique(id_list& ids) {
+                std::sort(ids.begin(), ids.end());
+                ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            }
+
+            void remember(const osmium::OSMObject& object) {
+                auto& map = object.type() == osmium::item_type::way ? m_ways : m_relations;
+                const auto it = map.find(object.positive_id());
+                if (it != map.end()) {
+                    m_stash.remove_item(it->second);
+                    it->second = m_stash.add_item(object);
+                } else {
+                    map.emplace(object.positive_id(), m_stash.add_item(object));
+                }
+            }
+
+            // The latest version of an object, which might be deleted.
+            const osmium::OSMObject* latest(const osmium::item_type type, const osmium::unsigned_object_id_type id) const {
+                const auto& map = type == osmium::item_type::way ? m_ways : m_relations;
+                const auto it = map.find(id);
+                if (it != map.end()) {
+                    return &m_stash.get<osmium::OSMObject>(it->second);
+                }
+                return m_store ? m_store->get_noexcept(type, static_cast<osmium::object_id_type>(id)) : nullptr;
+            }
+
+            const osmium::Way* current_way(const osmium::unsigned_object_id_type id) const {
+                const auto* object = latest(osmium::item_type::way, id);
+                return object && object->visible() ? static_cast<const osmium::Way*>(object) : nullptr;
+            }
+
+            const osmium::Relation* current_relation(const osmium::unsigned_object_id_type id) const {
+                const auto* object = latest(osmium::item_type::relation, id);
+                return object && object->visible() ? static_cast<const osmium::Relation*>(object) : nullptr;
+            }
+
+            // Copy the way into m_member_ways and set the node locations
+            // from the index.
+            std::size_t add_way_with_locations(const osmium::Way& way) {
+                const auto offset = m_member_ways.committed();
+                m_member_ways.add_item(way);
+                m_member_ways.commit();
+                for (auto& node_ref : m_member_ways.get<osmium::Way>(offset).nodes()) {
+                    node_ref.set_location(m_locations.get_noexcept(node_ref.positive_ref()));
+                }
+                return offset;
+            }
+
+            bool relation_is_area(const osmium::Relation& relation) const {
+                const char* type = relation.tags().get_value_by_key("type");
+                if (type == nullptr || (std::strcmp(type, "multipolygon") != 0 && std::strcmp(type, "boundary") != 0)) {
+                    return false;
+                }
+                return osmium::tags::match_any_of(relation.tags(), m_filter);
+            }
+
+            // The way must have its locations set.
+            bool way_is_area(const osmium::Way& way) const {
+                if (way.nodes().size() <= 3 ||
+                    !way.nodes().front().location() ||
+                    !way.nodes().back().location() ||
+                    !way.ends_have_same_location()) {
+                    return false;
+                }
+                return !way.tags().has_tag("area", "no") &&
+                       osmium::tags::match_any_of(way.tags(), m_filter);
+            }
+
+            // Collect the member ways with their locations. Returns false
+            // if the relation has no way members or some are missing.
+            bool get_member_ways(const osmium::Relation& relation, std::vector<const osmium::Way*>& ways) {
+                m_member_ways.clear();
+                std::vector<std::size_t> offsets;
+                for (const auto& member : relation.members()) {
+                    if (member.type() == osmium::item_type::way) {
+                        const auto* way = current_way(member.positive_ref());
+                        if (!way) {
+                            return false;
+                        }
+                        offsets.push_back(add_way_with_locations(*way));
+                    }
+                }
+                for (const auto offset : offsets) {
+                    ways.push_back(&m_member_ways.get<osmium::Way>(offset));
+                }
+                return !ways.empty();
+            }
+
+            // Could an area have been created from the way or relation
+            // with the current data?
+            bool has_area(const osmium::item_type type, const osmium::unsigned_object_id_type id) {
+                if (type == osmium::item_type::way) {
+                    const auto* way = current_way(id);
+                    if (!way) {
+                        return false;
+                    }
+                    m_member_ways.clear();
+                    return way_is_area(m_member_ways.get<osmium::Way>(add_way_with_locations(*way)));
+                }
+
+                const auto* relation = current_relation(id);
+                std::vector<const osmium::Way*> ways;
+                return relation && relation_is_area(*relation) && get_member_ways(*relation, ways);
+            }
+
+            bool assemble_way(const osmium::unsigned_object_id_type id, area_stats& stats) {
+                const auto* way = current_way(id);
+                if (!way) {
+                    return false;
+                }
+                m_member_ways.clear();
+                const auto& way_with_locations = m_member_ways.get<osmium::Way>(add_way_with_locations(*way));
+                if (!way_is_area(way_with_locations)) {
+                    return false;
+                }
+
+                try {
+                    Assembler assembler{m_assembler_config};
+                    const bool okay = assembler(way_with_locations, m_output);
+                    stats += assembler.stats();
+                    return okay;
+                } catch (const osmium::invalid_location&) {
+                    return false;
+                }
+            }
+
+            bool assemble_relation(const osmium::unsigned_object_id_type id, area_stats& stats) {
+                const auto* relation = current_relation(id);
+                std::vector<const osmium::Way*> ways;
+                if (!relation || !relation_is_area(*relation) || !get_member_ways(*relation, ways)) {
+                    return false;
+                }
+
+                try {
+                    Assembler assembler{m_assembler_config};
+                    const bool okay = assembler(*relation, ways, m_output);
+                    stats += assembler.stats();
+                    return okay;
+                } catch (const osmium::invalid_location&) {
+                    return false;
+                }
+            }
+
+            template <typename TFunc>
+            void update_area(const osmium::item_type type, const osmium::unsigned_object_id_type id, const bool had_area, TFunc& func, area_update_stats& stats) {
+                m_output.clear();
+                const bool okay = type == osmium::item_type::way ? assemble_way(id, stats.assembler)
+                                                                 : assemble_relation(id, stats.assembler);
+                if (okay) {
+                    if (had_area) {
+                        ++stats.modified;
+                        func(area_change_type::modified, m_output.get<osmium::Area>(0));
+                    } else {
+                        ++stats.created;
+                        func(area_change_type::created, m_output.get<osmium::Area>(0));
+                    }
+                    return;
+                }
+
+                if (!had_area) {
+                    return;
+                }
+
+                m_output.clear();
+                {
+                    osmium::builder::AreaBuilder builder{m_output};
+                    const auto* object = latest(type, id);
+                    if (object) {
+                        builder.initialize_from_object(*object);
+                    } else {
+                        builder.set_id(osmium::object_id_to_area_id(static_cast<osmium::object_id_type>(id), type));
+                    }
+                    builder.set_visible(false);
+                }
+                m_output.commit();
+                ++stats.deleted;
+                func(area_change_type::deleted, m_output.get<osmium::Area>(0));
+            }
+
+        public:
+
+            /**
+             * Create an AreaUpdater.
+             *
+             * @param store The store with the ways and relations of the
+             *              initial import. Can be nullptr, then all ways
+             *              and relations must be given to load().
+             * @param locations Node location index. It is updated.
+             * @param w2n Index from ways to their nodes.
+             * @param n2w Index from nodes to the ways they are in.
+             * @param r2w Index from relations to their way members.
+             * @param w2r Index from ways to the relations they are in.
+             * @param assembler_config Configuration for the assembler.
+             *                         Areas that can't be assembled are
+             *                         never created, the setting
+             *                         create_empty_areas is ignored.
+             * @param filter Tags needed on closed ways or relations to
+             *               build the area, like in the
+             *               MultipolygonManager.
+             */
+            AreaUpdater(const osmium::index::ObjectStore* store,
+                        location_index_type& locations,
+                        relations_index_type& w2n,
+                        relations_index_type& n2w,
+                        relations_index_type& r2w,
+                        relations_index_type& w2r,
+                        const AssemblerConfig& assembler_config = AssemblerConfig{},
+                        osmium::TagsFilter filter = osmium::TagsFilter{true}) :
+                m_store(store),
+                m_locations(locations),
+                m_index_w2n(w2n),
+                m_index_n2w(n2w),
+                m_index_r2w(r2w),
+                m_index_w2r(w2r),
+                m_assembler_config(assembler_config),
+                m_filter(std::move(filter)) {
+                m_assembler_config.create_empty_areas = false;
+            }
+
+            /**
+             * Remember the ways and relations in the buffer without
+             * updating any indexes or creating areas. Use this after a
+             * restart for the change files applied since the store was
+             * written (in the order they were applied) or, without a
+             * store, for all ways and relations of the initial import.
+             */
+            void load(const osmium::memory::Buffer& buffer) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (object.id() > 0 && (object.type() == osmium::item_type::way || object.type() == osmium::item_type::relation)) {
+                        remember(object);
+                    }
+                }
+            }
+
+            /**
+             * Apply the changes in the buffer (usually the contents of a
+             * change file) to the indexes and the remembered objects and
+             * call func(area_change_type, const osmium::Area&) for every
+             * area that was created, modified, or deleted. Deleted areas
+             * are given as areas without rings with the visible flag
+             * unset. The area reference is only valid inside func.
+             *
+             * The changes must all be in one buffer, so that a change to
+             * a node and a way containing it results in only one update
+             * of the area.
+             *
+             * @returns Statistics about this update.
+             */
+            template <typename TFunc>
+            area_update_stats apply(const osmium::memory::Buffer& changes, TFunc&& func) {
+                area_update_stats stats;
+
+                id_list nodes;
+                id_list ways;
+                id_list relations;
+                for (const auto& object : changes.select<osmium::OSMObject>()) {
+                    if (object.id() <= 0) {
+                        continue;
+                    }
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            nodes.push_back(object.positive_id());
+                            break;
+                        case osmium::item_type::way:
+                            ways.push_back(object.positive_id());
+                            break;
+                        case osmium::item_type::relation:
+                            relations.push_back(object.positive_id());
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                sort_unique(nodes);
+                sort_unique(ways);
+                sort_unique(relations);
+                stats.nodes = nodes.size();
+                stats.ways = ways.size();
+                stats.relations = relations.size();
+
+                // Find the affected objects through the indexes before
+                // they are updated. Ways and relations getting new members
+                // are in the changes themselves.
+                id_list affected_ways{ways};
+                for (const auto id : nodes) {
+                    const auto way_ids = m_index_n2w.get_all(id);
+                    affected_ways.insert(affected_ways.end(), way_ids.cbegin(), way_ids.cend());
+                }
+                sort_unique(affected_ways);
+
+                id_list affected_relations{relations};
+                for (const auto id : affected_ways) {
+                    const auto relation_ids = m_index_w2r.get_all(id);
+                    affected_relations.insert(affected_relations.end(), relation_ids.cbegin(), relation_ids.cend());
+                }
+                sort_unique(affected_relations);
+
+                stats.affected_ways = affected_ways.size();
+                stats.affected_relations = affected_relations.size();
+
+                std::vector<bool> way_had_area;
+                way_had_area.reserve(affected_ways.size());
+                for (const auto id : affected_ways) {
+                    way_had_area.push_back(has_area(osmium::item_type::way, id));
+                }
+
+                std::vector<bool> relation_had_area;
+                relation_had_area.reserve(affected_relations.size());
+                for (const auto id : affected_relations) {
+                    relation_had_area.push_back(has_area(osmium::item_type::relation, id));
+                }
+
+                // Update everything.
+                osmium::index::update_node_locations(m_locations, changes);
+                m_locations.commit_updates();
+                {
+                    osmium::handler::UpdateObjectRelations handler{m_index_w2n, m_index_n2w, m_index_r2w, m_index_w2r};
+                    osmium::apply(changes, handler);
+                    handler.finish();
+                }
+                load(changes);
+
+                // Assemble the areas again.
+                for (std::size_t i = 0; i < affected_ways.size(); ++i) {
+                    update_area(osmium::item_type::way, affected_ways[i], way_had_area[i], func, stats);
+                }
+                for (std::size_t i = 0; i < affected_relations.size(); ++i) {
+                    update_area(osmium::item_type::relation, affected_relations[i], relation_had_area[i], func, stats);
+                }
+
+                return stats;
+            }
+
+            /**
+             * Read all changes from the source (usually an
+             * osmium::io::Reader reading a change file) and apply them.
+             * See apply() for details.
+             */
+            template <typename TSource, typename TFunc>
+            area_update_stats apply_source(TSource& source, TFunc&& func) {
+                osmium::memory::Buffer changes{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    changes.add_buffer(buffer);
+                    changes.commit();
+                }
+                return apply(changes, std::forward<TFunc>(func));
+            }
+
+            /// The number of ways and relations kept in memory.
+            std::size_t num_remembered() const noexcept {
+                return m_ways.size() + m_relations.size();
+            }
+
+        }; // class AreaUpdater
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_AREA_UPDATER_HPP
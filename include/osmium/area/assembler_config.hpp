@@ -35,11 +35,14 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/util/compatibility.hpp>
 
+#include <cstddef>
+
 namespace osmium {
 
     namespace area {
 
         class ProblemReporter;
+        class SegmentCache;
 
         /**
          * Configuration for osmium::area::Assembler objects. Create this
@@ -124,6 +127,33 @@ namespace osmium {
              */
             bool ignore_invalid_locations = false;
 
+            /**
+             * If a multipolygon has at least this many segments, the
+             * assembler builds an index over the segments to find the
+             * rings enclosing other rings. This takes a bit of extra time
+             * and memory, but avoids quadratic runtime for huge
+             * multipolygons with thousands of rings. Set to 0 to always
+             * use the index.
+             */
+            std::size_t segment_index_threshold = 10000;
+
+            /**
+             * Use a sweep line algorithm when checking for intersections
+             * between segments. It finds the same intersections as the
+             * default algorithm, but is much faster for polygons with
+             * many long or overlapping segments, such as big coastline
+             * relations. It has some overhead for smaller polygons.
+             */
+            bool sweep_line_intersections = false;
+
+            /**
+             * Optional pointer to a cache for the segments of member ways.
+             * Use it if the same ways are part of many multipolygons, see
+             * SegmentCache for details. It must outlive all assemblers
+             * using this config.
+             */
+            SegmentCache* segment_cache = nullptr;
+
             AssemblerConfig() noexcept = default;
 
             /**
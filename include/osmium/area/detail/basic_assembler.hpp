@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/area/assembler_config.hpp>
 #include <osmium/area/detail/node_ref_segment.hpp>
 #include <osmium/area/detail/proto_ring.hpp>
+#include <osmium/area/detail/segment_index.hpp>
 #include <osmium/area/detail/segment_list.hpp>
 #include <osmium/area/problem_reporter.hpp>
 #include <osmium/area/stats.hpp>
@@ -106,6 +107,9 @@ namespace osmium {
 
                 static constexpr const std::size_t max_split_locations = 100ULL;
 
+                // Maximum number of unused rings kept for reuse by reset().
+                static constexpr const std::size_t max_free_rings = 1000ULL;
+
                 // Maximum recursion depth, stops complex multipolygons from
                 // breaking everything.
                 enum : unsigned {
@@ -156,15 +160,28 @@ namespace osmium {
                 // List of segments (connection between two nodes)
                 SegmentList m_segment_list;
 
+                // Index over the segments for find_enclosing_ring(), only
+                // built for large multipolygons
+                SegmentIndex m_segment_index;
+
                 // The rings we are building from the segments
                 std::list<ProtoRing> m_rings;
 
+                // Rings not used any more. Their list nodes are moved back
+                // into m_rings when a new ring is needed, so they don't have
+                // to be allocated again.
+                std::list<ProtoRing> m_free_rings;
+
                 // All node locations
                 std::vector<slocation> m_locations;
 
                 // All locations where more than two segments start/end
                 std::vector<Location> m_split_locations;
 
+                // Start and end locations of open rings, used when joining
+                // them in the complex case
+                std::vector<location_to_ring_map> m_xrings;
+
                 // Statistics
                 area_stats m_stats;
 
@@ -290,6 +307,18 @@ namespace osmium {
                     }
                 }
 
+                // Add a new ring with the segment, reusing a free ring if
+                // there is one.
+                ProtoRing* new_ring(NodeRefSegment* segment) {
+                    if (m_free_rings.empty()) {
+                        m_rings.emplace_back(segment);
+                    } else {
+                        m_rings.splice(m_rings.end(), m_free_rings, m_free_rings.begin());
+                        m_rings.back().reinit(segment);
+                    }
+                    return &m_rings.back();
+                }
+
                 ProtoRing* find_enclosing_ring(NodeRefSegment* segment) {
                     if (debug()) {
                         std::cerr << "    Looking for ring enclosing " << *segment << "\n";
@@ -309,6 +338,17 @@ namespace osmium {
 
                     rings_stack outer_rings;
                     while (segment >= &m_segment_list.front()) {
+                        // All segments from here on start before the
+                        // location, so they are only interesting if they
+                        // end to the right of it. Use the index to skip
+                        // all others.
+                        if (!m_segment_index.empty() && segment->first().location() < location) {
+                            auto pos = static_cast<std::size_t>(segment - &m_segment_list.front());
+                            if (!m_segment_index.find_previous(pos, location.x())) {
+                                break;
+                            }
+                            segment = &m_segment_list[pos];
+                        }
                         if (!segment->is_direction_done()) {
                             --segment;
                             continue;
@@ -427,8 +467,7 @@ namespace osmium {
                     }
                     segment->mark_direction_done();
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = new_ring(segment);
                     if (outer_ring) {
                         if (debug()) {
                             std::cerr << "    This is an inner ring. Outer ring is " << *outer_ring << "\n";
@@ -478,8 +517,7 @@ namespace osmium {
                         segment->reverse();
                     }
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = new_ring(segment);
 
                     const osmium::Location& first_location = node.location(m_segment_list);
                     osmium::Location last_location = segment->stop().location();
@@ -619,8 +657,8 @@ namespace osmium {
                     }
                 }
 
-                std::vector<location_to_ring_map> create_location_to_ring_map(open_ring_its_type& open_ring_its) const {
-                    std::vector<location_to_ring_map> xrings;
+                void create_location_to_ring_map(open_ring_its_type& open_ring_its, std::vector<location_to_ring_map>& xrings) const {
+                    xrings.clear();
                     xrings.reserve(open_ring_its.size() * 2);
 
                     for (auto it = open_ring_its.begin(); it != open_ring_its.end(); ++it) {
@@ -632,8 +670,6 @@ namespace osmium {
                     }
 
                     std::stable_sort(xrings.begin(), xrings.end());
-
-                    return xrings;
                 }
 
                 void merge_two_rings(open_ring_its_type& open_ring_its, const location_to_ring_map& m1, const location_to_ring_map& m2) {
@@ -655,7 +691,7 @@ namespace osmium {
                     }
 
                     open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r2));
-                    m_rings.erase(r2);
+                    m_free_rings.splice(m_free_rings.end(), m_rings, r2);
 
                     if (r1->closed()) {
                         open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r1));
@@ -671,7 +707,8 @@ namespace osmium {
                         std::cerr << "    Trying to merge " << open_ring_its.size() << " open rings (try_to_merge)\n";
                     }
 
-                    std::vector<location_to_ring_map> xrings = create_location_to_ring_map(open_ring_its);
+                    auto& xrings = m_xrings;
+                    create_location_to_ring_map(open_ring_its, xrings);
 
                     auto it = xrings.cbegin();
                     while (it != xrings.cend()) {
@@ -724,6 +761,11 @@ namespace osmium {
 
                 using location_set = std::vector<osmium::Location>;
 
+                // Used in join_connected_rings(), members so that their
+                // memory can be reused.
+                std::vector<candidate> m_candidates;
+                location_set m_loc_done;
+
                 void find_candidates(std::vector<candidate>& candidates, location_set& loc_done, const std::vector<location_to_ring_map>& xrings, const candidate& cand, unsigned depth = 0) {
                     if (depth > max_depth) {
                         throw exceeded_max_depth{};
@@ -817,7 +859,8 @@ namespace osmium {
                         std::cerr << "    Trying to merge " << open_ring_its.size() << " open rings (join_connected_rings)\n";
                     }
 
-                    std::vector<location_to_ring_map> xrings = create_location_to_ring_map(open_ring_its);
+                    auto& xrings = m_xrings;
+                    create_location_to_ring_map(open_ring_its, xrings);
 
                     const auto ring_min = std::min_element(xrings.begin(), xrings.end(), [](const location_to_ring_map& lhs, const location_to_ring_map& rhs) {
                         return lhs.ring().min_segment() < rhs.ring().min_segment();
@@ -837,11 +880,13 @@ namespace osmium {
 
                     // Locations we have visited while finding candidates, used
                     // to detect loops.
-                    location_set loc_done;
+                    auto& loc_done = m_loc_done;
+                    loc_done.clear();
 
                     loc_done.push_back(cand.stop_location);
 
-                    std::vector<candidate> candidates;
+                    auto& candidates = m_candidates;
+                    candidates.clear();
                     try {
                         find_candidates(candidates, loc_done, xrings, cand);
                     } catch (const exceeded_max_depth&) {
@@ -1024,20 +1069,38 @@ namespace osmium {
                  * Create rings from segments.
                  */
                 bool create_rings() {
+                    uint64_t time = 0;
+                    bool result = false;
+                    {
+                        const stage_timer stage{time};
+                        result = create_rings_impl();
+                    }
+                    m_stats.add_assembly_time(time);
+                    return result;
+                }
+
+                bool create_rings_impl() {
                     m_stats.nodes += m_segment_list.size();
 
                     // Sort the list of segments (from left to right and bottom
                     // to top).
                     osmium::Timer timer_sort;
-                    m_segment_list.sort();
+                    {
+                        const stage_timer stage{m_stats.time_sort};
+                        m_segment_list.sort();
+                    }
                     timer_sort.stop();
 
                     // Remove duplicate segments. Removal is in pairs, so if there
                     // are two identical segments, they will both be removed. If
                     // there are three, two will be removed and one remains.
                     osmium::Timer timer_dupl;
-                    m_segment_list.erase_duplicate_segments(m_config.problem_reporter, m_stats.duplicate_segments, m_stats.overlapping_segments);
+                    {
+                        const stage_timer stage{m_stats.time_duplicate_segments};
+                        m_segment_list.erase_duplicate_segments(m_config.problem_reporter, m_stats.duplicate_segments, m_stats.overlapping_segments);
+                    }
                     timer_dupl.stop();
+                    m_stats.segments += m_segment_list.size();
 
                     // If there are no segments left at this point, this isn't
                     // a valid area.
@@ -1060,7 +1123,10 @@ namespace osmium {
                     // In the future this could be improved by trying to fix those
                     // cases.
                     osmium::Timer timer_intersection;
-                    m_stats.intersections = m_segment_list.find_intersections(m_config.problem_reporter);
+                    {
+                        const stage_timer stage{m_stats.time_intersections};
+                        m_stats.intersections = m_segment_list.find_intersections(m_config.problem_reporter, m_config.sweep_line_intersections);
+                    }
                     timer_intersection.stop();
 
                     if (m_stats.intersections) {
@@ -1072,18 +1138,23 @@ namespace osmium {
                     // use this list later to quickly find which segment(s) fits
                     // onto a known segment.
                     osmium::Timer timer_locations_list;
-                    create_locations_list();
-                    timer_locations_list.stop();
-
-                    // Find all locations where more than two segments start or
-                    // end. We call those "split" locations. If there are any
-                    // "spike" segments found while doing this, we know the area
-                    // geometry isn't valid and return.
                     osmium::Timer timer_split;
-                    if (!find_split_locations()) {
-                        return false;
+                    {
+                        const stage_timer stage{m_stats.time_locations};
+                        timer_locations_list.start();
+                        create_locations_list();
+                        timer_locations_list.stop();
+
+                        // Find all locations where more than two segments start or
+                        // end. We call those "split" locations. If there are any
+                        // "spike" segments found while doing this, we know the area
+                        // geometry isn't valid and return.
+                        timer_split.start();
+                        if (!find_split_locations()) {
+                            return false;
+                        }
+                        timer_split.stop();
                     }
-                    timer_split.stop();
 
                     // Now report all split locations to the problem reporter.
                     m_stats.touching_rings += m_split_locations.size();
@@ -1110,6 +1181,10 @@ namespace osmium {
                     // whether there were any split locations or not. If there
                     // are no splits, we use the faster "simple algorithm", if
                     // there are, we use the slower "complex algorithm".
+                    if (m_segment_list.size() >= m_config.segment_index_threshold) {
+                        m_segment_index.build(m_segment_list);
+                    }
+
                     osmium::Timer timer;
                     if (m_split_locations.empty()) {
                         if (debug()) {
@@ -1118,7 +1193,10 @@ namespace osmium {
                         ++m_stats.area_simple_case;
 
                         timer.start();
-                        create_rings_simple_case();
+                        {
+                            const stage_timer stage{m_stats.time_rings_simple};
+                            create_rings_simple_case();
+                        }
                         timer.stop();
                     } else if (m_split_locations.size() > max_split_locations) {
                         if (m_config.debug_level > 0) {
@@ -1138,8 +1216,11 @@ namespace osmium {
                         ++m_stats.area_touching_rings_case;
 
                         timer.start();
-                        if (!create_rings_complex_case()) {
-                            return false;
+                        {
+                            const stage_timer stage{m_stats.time_rings_complex};
+                            if (!create_rings_complex_case()) {
+                                return false;
+                            }
                         }
                         timer.stop();
                     }
@@ -1148,7 +1229,10 @@ namespace osmium {
                     // member roles are correctly tagged.
                     if (m_config.check_roles && m_stats.from_relations) {
                         osmium::Timer timer_roles;
-                        check_inner_outer_roles();
+                        {
+                            const stage_timer stage{m_stats.time_roles};
+                            check_inner_outer_roles();
+                        }
                         timer_roles.stop();
                     }
 
@@ -1190,6 +1274,7 @@ namespace osmium {
                 explicit BasicAssembler(const config_type& config) :
                     m_config(config),
                     m_segment_list(config.debug_level > 1) {
+                    m_segment_list.set_cache(config.segment_cache);
 #ifdef OSMIUM_WITH_TIMER
                     init_header();
 #endif
@@ -1215,6 +1300,29 @@ namespace osmium {
                     return m_stats;
                 }
 
+                /**
+                 * Reset the assembler so it can be used to assemble the
+                 * next area. This also resets the statistics. The memory
+                 * allocated for segments and locations is kept, so reusing
+                 * an assembler is cheaper than creating a new one for each
+                 * area.
+                 */
+                void reset() {
+                    m_segment_list.clear();
+                    m_segment_index.clear();
+                    m_free_rings.splice(m_free_rings.end(), m_rings);
+                    while (m_free_rings.size() > max_free_rings) {
+                        m_free_rings.pop_back();
+                    }
+                    m_locations.clear();
+                    m_split_locations.clear();
+                    m_xrings.clear();
+                    m_candidates.clear();
+                    m_loc_done.clear();
+                    m_stats = area_stats{};
+                    m_num_members = 0;
+                }
+
             }; // class BasicAssembler
 
         } // namespace detail
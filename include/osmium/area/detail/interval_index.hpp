@@ -0,0 +1,188 @@
+#ifndef OSMIUM_AREA_DETAIL_INTERVAL_INDEX_HPP
+#define OSMIUM_AREA_DETAIL_INTERVAL_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        namespace detail {
+
+            /**
+             * Dynamic set of closed intervals [lo, hi] with integer
+             * coordinates which can be searched for all intervals
+             * overlapping a query interval. Intervals are identified by
+             * ids from 0 to the size given in the constructor.
+             *
+             * All interval end points must be known in advance. They are
+             * used to set up a segment tree which answers the question
+             * "which intervals contain point p". Together with an ordered
+             * set of the lower end points this finds all overlapping
+             * intervals: An interval overlaps [lo, hi] if it contains lo
+             * or if its lower end point is in (lo, hi].
+             */
+            class IntervalIndex {
+
+                // Sorted unique coordinates of all interval end points.
+                std::vector<int32_t> m_coordinates;
+
+                // Number of leaves in the segment tree (a power of two).
+                std::size_t m_leaves = 1;
+
+                // Ids of the intervals stored in the segment tree nodes.
+                // Removed intervals are left in here and cleaned up
+                // lazily.
+                std::vector<std::vector<uint32_t>> m_nodes;
+
+                // Lower end points of all active intervals.
+                std::set<std::pair<int32_t, uint32_t>> m_lower;
+
+                // Lower end point of each interval.
+                std::vector<int32_t> m_lo;
+
+                // Is the interval with this id in the index?
+                std::vector<bool> m_active;
+
+                std::size_t leaf(int32_t coordinate) const noexcept {
+                    const auto it = std::lower_bound(m_coordinates.cbegin(), m_coordinates.cend(), coordinate);
+                    assert(it != m_coordinates.cend() && *it == coordinate);
+                    return static_cast<std::size_t>(std::distance(m_coordinates.cbegin(), it));
+                }
+
+            public:
+
+                /**
+                 * Constructor.
+                 *
+                 * @param coordinates All end points of intervals that will
+                 *                    be added. The order doesn't matter,
+                 *                    duplicates are allowed.
+                 * @param size Ids of intervals must be smaller than this.
+                 */
+                IntervalIndex(std::vector<int32_t> coordinates, std::size_t size) :
+                    m_coordinates(std::move(coordinates)),
+                    m_lo(size),
+                    m_active(size, false) {
+                    std::sort(m_coordinates.begin(), m_coordinates.end());
+                    m_coordinates.erase(std::unique(m_coordinates.begin(), m_coordinates.end()), m_coordinates.end());
+                    while (m_leaves < m_coordinates.size()) {
+                        m_leaves *= 2;
+                    }
+                    m_nodes.resize(m_leaves * 2);
+                }
+
+                /**
+                 * Add interval [lo, hi] with the given id. Both end points
+                 * must have been in the coordinates given to the
+                 * constructor.
+                 */
+                void insert(uint32_t id, int32_t lo, int32_t hi) {
+                    assert(id < m_active.size());
+                    assert(!m_active[id]);
+                    assert(lo <= hi);
+
+                    m_active[id] = true;
+                    m_lo[id] = lo;
+                    m_lower.emplace(lo, id);
+
+                    std::size_t l = leaf(lo) + m_leaves;
+                    std::size_t r = leaf(hi) + m_leaves + 1;
+                    while (l < r) {
+                        if (l & 1U) {
+                            m_nodes[l++].push_back(id);
+                        }
+                        if (r & 1U) {
+                            m_nodes[--r].push_back(id);
+                        }
+                        l /= 2;
+                        r /= 2;
+                    }
+                }
+
+                /**
+                 * Remove the interval with the given id.
+                 */
+                void erase(uint32_t id) {
+                    assert(id < m_active.size());
+                    if (m_active[id]) {
+                        m_active[id] = false;
+                        m_lower.erase(std::make_pair(m_lo[id], id));
+                    }
+                }
+
+                /**
+                 * Call func(id) for each interval in the index that
+                 * overlaps the closed interval [lo, hi]. The lower end
+                 * point must have been in the coordinates given to the
+                 * constructor. The order in which the intervals are
+                 * visited is unspecified.
+                 */
+                template <typename TFunc>
+                void for_each_overlapping(int32_t lo, int32_t hi, TFunc&& func) {
+                    // intervals containing lo
+                    for (std::size_t node = leaf(lo) + m_leaves; node > 0; node /= 2) {
+                        auto& ids = m_nodes[node];
+                        ids.erase(std::remove_if(ids.begin(), ids.end(), [this](uint32_t id) {
+                            return !m_active[id];
+                        }), ids.end());
+                        for (const auto id : ids) {
+                            func(id);
+                        }
+                    }
+
+                    // intervals starting in (lo, hi]
+                    const auto end = m_lower.upper_bound(std::make_pair(hi, static_cast<uint32_t>(-1)));
+                    for (auto it = m_lower.upper_bound(std::make_pair(lo, static_cast<uint32_t>(-1))); it != end; ++it) {
+                        func(it->second);
+                    }
+                }
+
+            }; // class IntervalIndex
+
+        } // namespace detail
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_DETAIL_INTERVAL_INDEX_HPP
@@ -0,0 +1,143 @@
+#ifndef OSMIUM_AREA_DETAIL_SEGMENT_INDEX_HPP
+#define OSMIUM_AREA_DETAIL_SEGMENT_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/detail/segment_list.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        namespace detail {
+
+            /**
+             * Index over the x coordinates of the second locations of all
+             * segments in a sorted SegmentList. It is used to speed up the
+             * search for the ring enclosing a location in the assembler:
+             * Instead of looking at every segment before a location only
+             * those segments that reach far enough to the right to border
+             * the location vertically are visited.
+             *
+             * The index is a binary tree of maximum values with the
+             * segments as leaves, so each lookup is O(log n).
+             */
+            class SegmentIndex {
+
+                // Number of leaves in the tree (a power of two).
+                std::size_t m_leaves = 0;
+
+                // The tree: Node n has children 2n and 2n+1, the root is
+                // node 1, leaves start at m_leaves.
+                std::vector<int32_t> m_tree;
+
+            public:
+
+                SegmentIndex() = default;
+
+                /**
+                 * Build index for the segments in the list. The list must
+                 * be sorted and must not change while the index is used.
+                 */
+                void build(const SegmentList& segments) {
+                    m_leaves = 1;
+                    while (m_leaves < segments.size()) {
+                        m_leaves *= 2;
+                    }
+
+                    m_tree.assign(m_leaves * 2, std::numeric_limits<int32_t>::min());
+                    for (std::size_t n = 0; n < segments.size(); ++n) {
+                        m_tree[m_leaves + n] = segments[n].second().location().x();
+                    }
+                    for (std::size_t n = m_leaves - 1; n > 0; --n) {
+                        m_tree[n] = std::max(m_tree[2 * n], m_tree[2 * n + 1]);
+                    }
+                }
+
+                void clear() {
+                    m_leaves = 0;
+                    m_tree.clear();
+                }
+
+                bool empty() const noexcept {
+                    return m_tree.empty();
+                }
+
+                /**
+                 * Find the segment with the largest index not larger than
+                 * pos whose second location has an x coordinate larger
+                 * than x.
+                 *
+                 * @param pos Start looking at this index. Will be set to
+                 *            the index of the segment found.
+                 * @param x The x coordinate.
+                 * @returns true if a segment was found, false otherwise.
+                 */
+                bool find_previous(std::size_t& pos, int32_t x) const noexcept {
+                    assert(pos < m_leaves);
+                    std::size_t node = m_leaves + pos;
+                    if (m_tree[node] > x) {
+                        return true;
+                    }
+
+                    while (node > 1) {
+                        if ((node & 1U) && m_tree[node - 1] > x) {
+                            node = node - 1;
+                            while (node < m_leaves) {
+                                node = m_tree[2 * node + 1] > x ? 2 * node + 1 : 2 * node;
+                            }
+                            pos = node - m_leaves;
+                            return true;
+                        }
+                        node /= 2;
+                    }
+
+                    return false;
+                }
+
+            }; // class SegmentIndex
+
+        } // namespace detail
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_DETAIL_SEGMENT_INDEX_HPP
@@ -33,8 +33,10 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/area/detail/interval_index.hpp>
 #include <osmium/area/detail/node_ref_segment.hpp>
 #include <osmium/area/problem_reporter.hpp>
+#include <osmium/area/segment_cache.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
@@ -44,12 +46,17 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <numeric>
+#include <queue>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -86,6 +93,8 @@ namespace osmium {
 
                 slist_type m_segments{};
 
+                SegmentCache* m_cache = nullptr;
+
                 bool m_debug;
 
                 static role_type parse_role(const char* role) noexcept {
@@ -114,6 +123,17 @@ namespace osmium {
                 }
 
                 uint32_t extract_segments_from_way_impl(ProblemReporter* problem_reporter, uint64_t& duplicate_nodes, const osmium::Way& way, role_type role) {
+                    if (m_cache) {
+                        const bool found = m_cache->lookup(way, [&](const osmium::NodeRef& nr1, const osmium::NodeRef& nr2) {
+                            m_segments.emplace_back(nr1, nr2, role, &way);
+                        });
+                        if (found) {
+                            return 0;
+                        }
+                    }
+
+                    const auto first_segment = m_segments.size();
+                    const auto old_duplicate_nodes = duplicate_nodes;
                     uint32_t invalid_locations = 0;
 
                     osmium::NodeRef previous_nr;
@@ -138,9 +158,90 @@ namespace osmium {
                         previous_nr = nr;
                     }
 
+                    if (m_cache && invalid_locations == 0 && duplicate_nodes == old_duplicate_nodes) {
+                        m_cache->store(way, m_segments.cbegin() + static_cast<std::ptrdiff_t>(first_segment), m_segments.cend());
+                    }
+
                     return invalid_locations;
                 }
 
+                bool check_intersection(const NodeRefSegment& s1, const NodeRefSegment& s2, ProblemReporter* problem_reporter) const {
+                    assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+
+                    const osmium::Location intersection{calculate_intersection(s1, s2)};
+                    if (!intersection) {
+                        return false;
+                    }
+
+                    if (m_debug) {
+                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
+                    }
+                    if (problem_reporter) {
+                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
+                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
+                    }
+                    return true;
+                }
+
+                /**
+                 * Find intersection between segments by sweeping a line
+                 * over the segments in x direction. The segments crossing
+                 * the sweep line are kept in an IntervalIndex by their y
+                 * ranges, so only segment pairs with overlapping bounding
+                 * boxes are looked at.
+                 */
+                uint32_t find_intersections_sweep_line(ProblemReporter* problem_reporter) const {
+                    std::vector<int32_t> coordinates;
+                    coordinates.reserve(m_segments.size() * 2);
+                    for (const auto& segment : m_segments) {
+                        coordinates.push_back(segment.first().location().y());
+                        coordinates.push_back(segment.second().location().y());
+                    }
+
+                    IntervalIndex index{std::move(coordinates), m_segments.size()};
+
+                    // Segments crossing the sweep line ordered by the x
+                    // coordinate of their end.
+                    using end_type = std::pair<int32_t, uint32_t>;
+                    std::priority_queue<end_type, std::vector<end_type>, std::greater<end_type>> ends;
+
+                    std::vector<std::pair<uint32_t, uint32_t>> candidates;
+
+                    assert(m_segments.size() < std::numeric_limits<uint32_t>::max());
+                    for (uint32_t n = 0; n < static_cast<uint32_t>(m_segments.size()); ++n) {
+                        const NodeRefSegment& segment = m_segments[n];
+                        const int32_t x = segment.first().location().x();
+                        while (!ends.empty() && ends.top().first < x) {
+                            index.erase(ends.top().second);
+                            ends.pop();
+                        }
+
+                        const int32_t y1 = segment.first().location().y();
+                        const int32_t y2 = segment.second().location().y();
+                        const int32_t y_min = std::min(y1, y2);
+                        const int32_t y_max = std::max(y1, y2);
+                        index.for_each_overlapping(y_min, y_max, [&candidates, n](uint32_t other) {
+                            candidates.emplace_back(other, n);
+                        });
+
+                        index.insert(n, y_min, y_max);
+                        ends.emplace(segment.second().location().x(), n);
+                    }
+
+                    // Check candidates in the same order as the simple
+                    // algorithm does
+                    std::sort(candidates.begin(), candidates.end());
+
+                    uint32_t found_intersections = 0;
+                    for (const auto& candidate : candidates) {
+                        if (check_intersection(m_segments[candidate.first], m_segments[candidate.second], problem_reporter)) {
+                            ++found_intersections;
+                        }
+                    }
+
+                    return found_intersections;
+                }
+
             public:
 
                 explicit SegmentList(bool debug) noexcept :
@@ -160,6 +261,14 @@ namespace osmium {
                     return m_segments.size();
                 }
 
+                /**
+                 * Remove all segments. The allocated memory is kept for
+                 * reuse.
+                 */
+                void clear() noexcept {
+                    m_segments.clear();
+                }
+
                 /// Is the segment list empty?
                 bool empty() const noexcept {
                     return m_segments.empty();
@@ -210,6 +319,16 @@ namespace osmium {
                     m_debug = debug;
                 }
 
+                /**
+                 * Use the cache for the segments extracted from ways.
+                 *
+                 * @param cache Pointer to the cache or nullptr to not use
+                 *              a cache.
+                 */
+                void set_cache(SegmentCache* cache) noexcept {
+                    m_cache = cache;
+                }
+
                 /// Sort the list of segments.
                 void sort() {
                     std::sort(m_segments.begin(), m_segments.end());
@@ -312,13 +431,22 @@ namespace osmium {
                  *
                  * @param problem_reporter Any intersections found are
                  *                         reported to this object.
+                 * @param sweep_line Use the sweep line algorithm which is
+                 *                   faster for large numbers of segments
+                 *                   with overlapping x ranges. Both
+                 *                   algorithms report the same
+                 *                   intersections in the same order.
                  * @returns true if there are intersections.
                  */
-                uint32_t find_intersections(ProblemReporter* problem_reporter) const {
+                uint32_t find_intersections(ProblemReporter* problem_reporter, bool sweep_line = false) const {
                     if (m_segments.empty()) {
                         return 0;
                     }
 
+                    if (sweep_line) {
+                        return find_intersections_sweep_line(problem_reporter);
+                    }
+
                     uint32_t found_intersections = 0;
 
                     for (auto it1 = m_segments.cbegin(); it1 != m_segments.cend() - 1; ++it1) {
@@ -326,24 +454,12 @@ namespace osmium {
                         for (auto it2 = it1+1; it2 != m_segments.end(); ++it2) {
                             const NodeRefSegment& s2 = *it2;
 
-                            assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
-
                             if (outside_x_range(s2, s1)) {
                                 break;
                             }
 
-                            if (y_range_overlap(s1, s2)) {
-                                osmium::Location intersection{calculate_intersection(s1, s2)};
-                                if (intersection) {
-                                    ++found_intersections;
-                                    if (m_debug) {
-                                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
-                                    }
-                                    if (problem_reporter) {
-                                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
-                                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
-                                    }
-                                }
+                            if (y_range_overlap(s1, s2) && check_intersection(s1, s2, problem_reporter)) {
+                                ++found_intersections;
                             }
                         }
                     }
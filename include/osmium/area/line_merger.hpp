@@ -0,0 +1,379 @@
+#ifndef OSMIUM_AREA_LINE_MERGER_HPP
+#define OSMIUM_AREA_LINE_MERGER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/detail/node_ref_segment.hpp>
+#include <osmium/area/detail/proto_ring.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * Merges the segments of a large number of ways into lines and
+         * rings. This is what the Assembler does for the ways of one
+         * multipolygon relation, but for large, global data sets like
+         * all coastline ways or all ways of a waterway network.
+         *
+         * The ways are split into segments (in parallel), the segments
+         * are sorted (in parallel) and duplicate segments removed. Then
+         * the segments are joined at their end points: Lines continue
+         * through locations where exactly two segments meet and end at
+         * all other locations. Lines which end where they started are
+         * rings. Node ids are not used, only locations, so all ways
+         * must have valid locations.
+         *
+         * @code
+         * osmium::area::LineMerger merger;
+         * merger.add_ways(buffer);
+         * merger.merge();
+         * osmium::memory::Buffer out{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+         * merger.create_ways(out);
+         * @endcode
+         */
+        class LineMerger {
+
+            using segment_type = osmium::area::detail::NodeRefSegment;
+
+            // One end of a segment. The index is the number of the segment
+            // times two plus 0 for the first or 1 for the second node of
+            // the segment.
+            struct endpoint {
+                osmium::Location location;
+                std::size_t index;
+
+                bool operator<(const endpoint& other) const noexcept {
+                    return location == other.location ? index < other.index : location < other.location;
+                }
+            }; // struct endpoint
+
+            osmium::thread::Pool* m_pool;
+
+            std::vector<segment_type> m_segments;
+
+            // Segment end points sorted by location.
+            std::vector<endpoint> m_endpoints;
+
+            // Position of each segment end point in m_endpoints.
+            std::vector<std::size_t> m_endpoint_pos;
+
+            std::list<osmium::area::detail::ProtoRing> m_lines;
+
+            std::size_t m_invalid_segments = 0;
+            std::size_t m_duplicate_segments = 0;
+            std::size_t m_rings = 0;
+
+            static bool is_degenerate(const segment_type& segment) noexcept {
+                return segment.first().location() == segment.second().location();
+            }
+
+            // Fill segments for the way into out. Segments with invalid
+            // locations are left degenerate. Returns their number.
+            static std::size_t extract_segments(const osmium::Way& way, segment_type* out) noexcept {
+                std::size_t invalid = 0;
+                const auto& nodes = way.nodes();
+                for (std::size_t i = 1; i < nodes.size(); ++i) {
+                    if (nodes[i - 1].location().valid() && nodes[i].location().valid()) {
+                        out[i - 1] = segment_type{nodes[i - 1], nodes[i], osmium::area::detail::role_type::unknown, nullptr};
+                    } else {
+                        out[i - 1] = segment_type{};
+                        ++invalid;
+                    }
+                }
+                return invalid;
+            }
+
+            void remove_degenerate_segments(std::size_t first) {
+                m_segments.erase(std::remove_if(m_segments.begin() + static_cast<std::ptrdiff_t>(first), m_segments.end(), is_degenerate), m_segments.end());
+            }
+
+            // If exactly two segments meet at the location of the end
+            // point at position pos, set other to the position of the
+            // other end point there and return true.
+            bool other_endpoint(std::size_t pos, std::size_t& other) const noexcept {
+                const auto& location = m_endpoints[pos].location;
+                const auto same = [&](std::size_t p) {
+                    return p < m_endpoints.size() && m_endpoints[p].location == location;
+                };
+                const bool left = pos > 0 && same(pos - 1);
+                const bool right = same(pos + 1);
+                if (left == right) {
+                    return false;
+                }
+                if (left) {
+                    if (pos > 1 && same(pos - 2)) {
+                        return false;
+                    }
+                    other = pos - 1;
+                } else {
+                    if (same(pos + 2)) {
+                        return false;
+                    }
+                    other = pos + 1;
+                }
+                return true;
+            }
+
+            // Start a new line with the segment with the given end at
+            // the start and follow it as far as possible.
+            void build_line(std::size_t index) {
+                segment_type* segment = &m_segments[index / 2];
+                if (segment->is_reverse() != (index % 2 == 1)) {
+                    segment->reverse();
+                }
+                m_lines.emplace_back(segment);
+                auto& line = m_lines.back();
+
+                while (true) {
+                    const std::size_t stop_index = index / 2 * 2 + (segment->is_reverse() ? 0 : 1);
+                    std::size_t other = 0;
+                    if (!other_endpoint(m_endpoint_pos[stop_index], other)) {
+                        break;
+                    }
+                    index = m_endpoints[other].index;
+                    segment = &m_segments[index / 2];
+                    if (segment->is_done()) {
+                        break;
+                    }
+                    if (segment->is_reverse() != (index % 2 == 1)) {
+                        segment->reverse();
+                    }
+                    line.add_segment_back(segment);
+                }
+
+                if (line.closed()) {
+                    ++m_rings;
+                }
+            }
+
+        public:
+
+            /**
+             * Create a LineMerger.
+             *
+             * @param pool The thread pool used for extracting and sorting
+             *             segments.
+             */
+            explicit LineMerger(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) :
+                m_pool(&pool) {
+            }
+
+            LineMerger(const LineMerger&) = delete;
+            LineMerger& operator=(const LineMerger&) = delete;
+
+            LineMerger(LineMerger&&) = delete;
+            LineMerger& operator=(LineMerger&&) = delete;
+
+            ~LineMerger() noexcept = default;
+
+            /**
+             * Add the segments of a way. The way is not needed any more
+             * after this call.
+             */
+            void add_way(const osmium::Way& way) {
+                if (way.nodes().size() < 2) {
+                    return;
+                }
+                const auto first = m_segments.size();
+                m_segments.resize(first + way.nodes().size() - 1);
+                m_invalid_segments += extract_segments(way, &m_segments[first]);
+                remove_degenerate_segments(first);
+            }
+
+            /**
+             * Add the segments of all ways in the buffer. The segments
+             * are extracted in parallel using the thread pool. The buffer
+             * is not needed any more after this call.
+             */
+            void add_ways(const osmium::memory::Buffer& buffer) {
+                struct job {
+                    const osmium::Way* way;
+                    std::size_t offset;
+                };
+
+                const auto first = m_segments.size();
+                std::size_t size = first;
+                std::vector<job> jobs;
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    if (way.nodes().size() > 1) {
+                        jobs.push_back(job{&way, size});
+                        size += way.nodes().size() - 1;
+                    }
+                }
+                m_segments.resize(size);
+
+                std::atomic<std::size_t> invalid{0};
+                m_pool->parallel_for(jobs.begin(), jobs.end(), [this, &invalid](const job& j) {
+                    invalid += extract_segments(*j.way, &m_segments[j.offset]);
+                });
+                m_invalid_segments += invalid;
+                remove_degenerate_segments(first);
+            }
+
+            /**
+             * Sort the segments, remove duplicates and join the segments
+             * into lines and rings. Call this after adding all ways. The
+             * results of a previous call are discarded.
+             */
+            void merge() {
+                m_lines.clear();
+                m_rings = 0;
+
+                osmium::thread::parallel_stable_sort(m_segments.begin(), m_segments.end(), std::less<segment_type>{}, *m_pool);
+                const auto last = std::unique(m_segments.begin(), m_segments.end());
+                m_duplicate_segments += static_cast<std::size_t>(std::distance(last, m_segments.end()));
+                m_segments.erase(last, m_segments.end());
+                for (auto& segment : m_segments) {
+                    segment = segment_type{segment.first(), segment.second(), osmium::area::detail::role_type::unknown, nullptr};
+                }
+
+                m_endpoints.clear();
+                m_endpoints.reserve(m_segments.size() * 2);
+                for (std::size_t i = 0; i < m_segments.size(); ++i) {
+                    m_endpoints.push_back(endpoint{m_segments[i].first().location(), i * 2});
+                    m_endpoints.push_back(endpoint{m_segments[i].second().location(), i * 2 + 1});
+                }
+                osmium::thread::parallel_stable_sort(m_endpoints.begin(), m_endpoints.end(), std::less<endpoint>{}, *m_pool);
+
+                m_endpoint_pos.resize(m_endpoints.size());
+                for (std::size_t pos = 0; pos < m_endpoints.size(); ++pos) {
+                    m_endpoint_pos[m_endpoints[pos].index] = pos;
+                }
+
+                // Lines start at all locations where not exactly two
+                // segments meet.
+                for (std::size_t pos = 0; pos < m_endpoints.size(); ++pos) {
+                    std::size_t other = 0;
+                    const auto index = m_endpoints[pos].index;
+                    if (!m_segments[index / 2].is_done() && !other_endpoint(pos, other)) {
+                        build_line(index);
+                    }
+                }
+
+                // All remaining segments are part of rings where exactly
+                // two segments meet at each location.
+                for (std::size_t i = 0; i < m_segments.size(); ++i) {
+                    if (!m_segments[i].is_done()) {
+                        build_line(i * 2);
+                    }
+                }
+            }
+
+            /// The number of segments (after removing duplicates in merge()).
+            std::size_t num_segments() const noexcept {
+                return m_segments.size();
+            }
+
+            /// The number of segments dropped because of invalid locations.
+            std::size_t invalid_segments() const noexcept {
+                return m_invalid_segments;
+            }
+
+            /// The number of duplicate segments removed in merge().
+            std::size_t duplicate_segments() const noexcept {
+                return m_duplicate_segments;
+            }
+
+            /// The number of lines (including rings) found by merge().
+            std::size_t num_lines() const noexcept {
+                return m_lines.size();
+            }
+
+            /// The number of closed rings found by merge().
+            std::size_t num_rings() const noexcept {
+                return m_rings;
+            }
+
+            /**
+             * Add one way for each line found by merge() to the buffer.
+             * The ways have consecutive ids starting at first_id and no
+             * tags. Rings are closed ways.
+             *
+             * @param buffer The buffer to add the ways to.
+             * @param first_id Id of the first way.
+             * @param rings_only Only add rings, not open lines.
+             */
+            void create_ways(osmium::memory::Buffer& buffer, osmium::object_id_type first_id = 1, bool rings_only = false) const {
+                auto id = first_id;
+                for (const auto& line : m_lines) {
+                    if (rings_only && !line.closed()) {
+                        continue;
+                    }
+                    {
+                        osmium::builder::WayBuilder builder{buffer};
+                        builder.set_id(id++);
+                        osmium::builder::WayNodeListBuilder wnl_builder{builder};
+                        wnl_builder.add_node_ref(line.get_node_ref_start());
+                        for (const auto* segment : line.segments()) {
+                            wnl_builder.add_node_ref(segment->stop());
+                        }
+                    }
+                    buffer.commit();
+                }
+            }
+
+            /// Remove all segments and results.
+            void clear() {
+                m_lines.clear();
+                m_segments.clear();
+                m_endpoints.clear();
+                m_endpoint_pos.clear();
+                m_invalid_segments = 0;
+                m_duplicate_segments = 0;
+                m_rings = 0;
+            }
+
+        }; // class LineMerger
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_LINE_MERGER_HPP
@@ -33,9 +33,11 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/area/area_cache.hpp>
 #include <osmium/area/stats.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/relations/manager_util.hpp>
@@ -45,12 +47,18 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/tags/taglist.hpp>
 #include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -82,6 +90,152 @@ namespace osmium {
 
             osmium::TagsFilter m_filter;
 
+            enum {
+                initial_buffer_size = 10UL * 1024UL,
+                default_max_pending = 1000
+            };
+
+            struct assembly_result {
+                osmium::memory::Buffer buffer;
+                area_stats stats;
+            }; // struct assembly_result
+
+            // Assembly task run in the thread pool. It gets a copy of
+            // the relation and its member ways (or of the closed way)
+            // because they are removed from the stash as soon as the
+            // relation is complete.
+            class assembly_task {
+
+                assembler_config_type m_config;
+                osmium::memory::Buffer m_input;
+
+            public:
+
+                assembly_task(const assembler_config_type& config, osmium::memory::Buffer&& input) :
+                    m_config(config),
+                    m_input(std::move(input)) {
+                }
+
+                // Each worker thread reuses its assembler (and the memory
+                // allocated by it) for all tasks. The assembler refers to
+                // the config, so the config is copied into the thread
+                // local one for each task.
+                static TAssembler& thread_assembler(const assembler_config_type& config) {
+                    static thread_local assembler_config_type thread_config;
+                    static thread_local std::unique_ptr<TAssembler> assembler;
+                    thread_config = config;
+                    if (assembler) {
+                        assembler->reset();
+                    } else {
+                        assembler.reset(new TAssembler{thread_config});
+                    }
+                    return *assembler;
+                }
+
+                assembly_result operator()() {
+                    assembly_result result{osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes}, area_stats{}};
+                    try {
+                        auto& assembler = thread_assembler(m_config);
+                        if (m_input.get<osmium::memory::Item>(0).type() == osmium::item_type::relation) {
+                            std::vector<const osmium::Way*> ways;
+                            for (const auto& way : m_input.select<osmium::Way>()) {
+                                ways.push_back(&way);
+                            }
+                            assembler(m_input.get<osmium::Relation>(0), ways, result.buffer);
+                        } else {
+                            assembler(m_input.get<osmium::Way>(0), result.buffer);
+                        }
+                        result.stats = assembler.stats();
+                    } catch (const osmium::invalid_location&) {
+                        // XXX ignore
+                    }
+                    return result;
+                }
+
+            }; // class assembly_task
+
+            osmium::thread::Pool* m_pool = nullptr;
+
+            std::size_t m_max_pending = default_max_pending;
+
+            // Result of an assembly task and, if it is to be stored in the
+            // cache, the key for it.
+            struct pending_result {
+                std::future<assembly_result> future;
+                bool store_in_cache;
+                osmium::object_id_type id;
+                osmium::object_version_type version;
+                uint64_t digest;
+            }; // struct pending_result
+
+            // Results of assembly tasks in the order they were submitted.
+            std::deque<pending_result> m_pending;
+
+            AreaCache* m_cache = nullptr;
+
+            // Assembler reused for all areas assembled in the thread
+            // calling the handler, so the memory it allocates for its
+            // segments, rings, and locations is only allocated once.
+            std::unique_ptr<TAssembler> m_assembler;
+
+            TAssembler& assembler() {
+                // The assembler refers to the config, so it has to be
+                // created again if this manager was moved.
+                if (!m_assembler || &m_assembler->config() != &m_assembler_config) {
+                    m_assembler.reset(new TAssembler{m_assembler_config});
+                } else {
+                    m_assembler->reset();
+                }
+                return *m_assembler;
+            }
+
+            void submit(osmium::memory::Buffer&& input, bool store_in_cache = false, osmium::object_id_type id = 0, osmium::object_version_type version = 0, uint64_t digest = 0) {
+                m_pending.push_back(pending_result{m_pool->submit(assembly_task{m_assembler_config, std::move(input)}), store_in_cache, id, version, digest});
+                add_results(false);
+            }
+
+            // Add the areas for the relation from the cache to the output
+            // if they are there. If there are pending assembly tasks, the
+            // areas are queued behind them to keep the order.
+            bool add_from_cache(const osmium::Relation& relation, uint64_t digest) {
+                if (m_pending.empty()) {
+                    return m_cache->lookup(relation.id(), relation.version(), digest, this->buffer());
+                }
+
+                assembly_result result{osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes}, area_stats{}};
+                if (!m_cache->lookup(relation.id(), relation.version(), digest, result.buffer)) {
+                    return false;
+                }
+
+                std::promise<assembly_result> promise;
+                promise.set_value(std::move(result));
+                m_pending.push_back(pending_result{promise.get_future(), false, 0, 0, 0});
+                add_results(false);
+                return true;
+            }
+
+            // Add results of finished assembly tasks to the output buffer
+            // keeping the order. If wait is set, wait for all tasks,
+            // otherwise only wait if there are too many pending tasks.
+            void add_results(bool wait) {
+                while (!m_pending.empty()) {
+                    auto& pending = m_pending.front();
+                    if (!wait && m_pending.size() < m_max_pending &&
+                        pending.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                        return;
+                    }
+                    assembly_result result{pending.future.get()};
+                    if (pending.store_in_cache) {
+                        m_cache->store(pending.id, pending.version, pending.digest, result.buffer.data(), result.buffer.committed());
+                    }
+                    m_pending.pop_front();
+                    m_stats += result.stats;
+                    this->buffer().add_buffer(result.buffer);
+                    this->buffer().commit();
+                    this->possibly_flush();
+                }
+            }
+
         public:
 
             /**
@@ -98,9 +252,51 @@ namespace osmium {
                 m_filter(std::move(filter)) {
             }
 
+            /**
+             * Assemble the areas in the given thread pool instead of in the
+             * thread calling the handler. The areas are still added to the
+             * output in the same order as without the pool. Statistics (see
+             * stats()) are only complete after the output was flushed.
+             *
+             * @param pool The thread pool. It must outlive this manager.
+             * @param max_pending The maximum number of assembly tasks
+             *                    submitted to the pool but not yet added
+             *                    to the output. If there are more, the
+             *                    manager waits for the oldest one.
+             */
+            void set_thread_pool(osmium::thread::Pool& pool, std::size_t max_pending = default_max_pending) {
+                m_pool = &pool;
+                m_max_pending = max_pending > 0 ? max_pending : 1;
+            }
+
+            /**
+             * Use the cache for areas assembled from relations. Relations
+             * found in the cache with the same version and unchanged
+             * member ways and node locations are not assembled again,
+             * their cached areas are added to the output instead. All
+             * other relations are assembled as usual and the results are
+             * stored in the cache. Areas created from closed ways are not
+             * cached.
+             *
+             * @param cache The cache. It must outlive this manager.
+             */
+            void set_cache(AreaCache& cache) noexcept {
+                m_cache = &cache;
+            }
+
+            /**
+             * Wait for all pending assembly tasks and add their results to
+             * the output buffer. This is called automatically before the
+             * output buffer is flushed or read.
+             */
+            void finish_pending() {
+                add_results(true);
+            }
+
             /**
              * Access the aggregated statistics generated by the assemblers
-             * called from the manager.
+             * called from the manager. This includes the time spent in the
+             * different stages of the assembly and the time histogram.
              */
             const area_stats& stats() const noexcept {
                 return m_stats;
@@ -142,13 +338,37 @@ namespace osmium {
                     }
                 }
 
+                uint64_t digest = 0;
+                if (m_cache) {
+                    digest = AreaCache::digest(ways);
+                    if (add_from_cache(relation, digest)) {
+                        return;
+                    }
+                }
+
+                if (m_pool) {
+                    osmium::memory::Buffer input{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                    input.add_item(relation);
+                    for (const osmium::Way* way : ways) {
+                        input.add_item(*way);
+                    }
+                    input.commit();
+                    submit(std::move(input), m_cache != nullptr, relation.id(), relation.version(), digest);
+                    return;
+                }
+
+                const auto start = this->buffer().committed();
                 try {
-                    TAssembler assembler{m_assembler_config};
-                    assembler(relation, ways, this->buffer());
-                    m_stats += assembler.stats();
+                    auto& mp_assembler = assembler();
+                    mp_assembler(relation, ways, this->buffer());
+                    m_stats += mp_assembler.stats();
                 } catch (const osmium::invalid_location&) {
                     // XXX ignore
                 }
+
+                if (m_cache) {
+                    m_cache->store(relation.id(), relation.version(), digest, this->buffer().data() + start, this->buffer().committed() - start);
+                }
             }
 
             void after_way(const osmium::Way& way) {
@@ -170,9 +390,17 @@ namespace osmium {
                             return;
                         }
 
-                        TAssembler assembler{m_assembler_config};
-                        assembler(way, this->buffer());
-                        m_stats += assembler.stats();
+                        if (m_pool) {
+                            osmium::memory::Buffer input{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                            input.add_item(way);
+                            input.commit();
+                            submit(std::move(input));
+                            return;
+                        }
+
+                        auto& mp_assembler = assembler();
+                        mp_assembler(way, this->buffer());
+                        m_stats += mp_assembler.stats();
                         this->possibly_flush();
                     }
                 } catch (const osmium::invalid_location&) {
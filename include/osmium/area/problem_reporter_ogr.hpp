@@ -51,62 +51,189 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/node_ref_list.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/util.hpp>
 
 #include <gdalcpp.hpp>
 
+#include <cstddef>
+#include <exception>
+#include <future>
 #include <memory>
+#include <utility>
 
 namespace osmium {
 
     namespace area {
 
+        /**
+         * Where the ProblemReporterOGR writes the problems to the dataset.
+         */
+        enum class ogr_writer_mode {
+
+            /// Write in the thread reporting the problems.
+            same_thread = 0,
+
+            /// Write in a dedicated thread fed through a queue. The
+            /// dataset must not be used by anybody else until the
+            /// reporter is closed.
+            background_thread = 1
+
+        }; // enum class ogr_writer_mode
+
         /**
          * Report problems when assembling areas by adding them to
          * layers in an OGR datasource.
+         *
+         * The features are added to the layers in batches (see
+         * gdalcpp::FeatureBatch), so they will only show up in the
+         * dataset after close() is called or the reporter is destroyed.
+         * With ogr_writer_mode::background_thread only the geometries are
+         * created in the thread reporting the problem, the features are
+         * written in a separate thread.
          */
         class ProblemReporterOGR : public ProblemReporter {
 
+            // Everything needed to write one problem. A record without
+            // layer tells the writer thread to stop.
+            struct problem {
+                gdalcpp::Layer* layer = nullptr;
+                std::unique_ptr<OGRGeometry> geometry{};
+                const char* problem_type = nullptr;
+                osmium::item_type object_type = osmium::item_type::undefined;
+                osmium::object_id_type object_id = 0;
+                std::size_t nodes = 0;
+                osmium::object_id_type id1 = 0;
+                osmium::object_id_type id2 = 0;
+            };
+
+            enum {
+                max_queue_size = 10000
+            };
+
             osmium::geom::OGRFactory<> m_ogr_factory;
 
             gdalcpp::Layer m_layer_perror;
             gdalcpp::Layer m_layer_lerror;
             gdalcpp::Layer m_layer_ways;
 
-            void set_object(gdalcpp::Feature& feature) {
-                const char t[2] = {osmium::item_type_to_char(m_object_type), '\0'};
+            gdalcpp::FeatureBatch m_batch;
+
+            ogr_writer_mode m_mode;
+            bool m_closed = false;
+
+            osmium::thread::Queue<problem> m_queue{max_queue_size, "ogr_problems"};
+            std::future<bool> m_writer_done{};
+            osmium::thread::thread_handler m_writer{};
+
+            void write_problem(problem& p) {
+                gdalcpp::Feature feature{*p.layer, std::move(p.geometry)};
+                const char t[2] = {osmium::item_type_to_char(p.object_type), '\0'};
                 feature.set_field("obj_type", t);
-                feature.set_field("obj_id", int32_t(m_object_id));
-                feature.set_field("nodes", int32_t(m_nodes));
+                feature.set_field("obj_id", int32_t(p.object_id));
+                feature.set_field("nodes", int32_t(p.nodes));
+                if (p.layer == &m_layer_ways) {
+                    feature.set_field("way_id", int32_t(p.id1));
+                } else {
+                    feature.set_field("id1", double(p.id1));
+                    feature.set_field("id2", double(p.id2));
+                    feature.set_field("problem", p.problem_type);
+                }
+                m_batch.add(std::move(feature));
+            }
+
+            // The writer thread keeps taking problems from the queue after
+            // an error so that the reporting thread never blocks forever.
+            void run_writer(std::promise<bool> done) {
+                osmium::thread::set_thread_name("_osmium_ogr");
+
+                std::exception_ptr exception;
+                problem p;
+                do {
+                    m_queue.wait_and_pop(p);
+                    if (p.layer && !exception) {
+                        try {
+                            write_problem(p);
+                        } catch (...) {
+                            exception = std::current_exception();
+                        }
+                    }
+                } while (p.layer);
+
+                if (!exception) {
+                    try {
+                        m_batch.flush();
+                    } catch (...) {
+                        exception = std::current_exception();
+                    }
+                }
+
+                if (exception) {
+                    done.set_exception(exception);
+                } else {
+                    done.set_value(true);
+                }
+            }
+
+            void add(gdalcpp::Layer& layer, std::unique_ptr<OGRGeometry>&& geometry, const char* problem_type, osmium::object_id_type id1, osmium::object_id_type id2) {
+                problem p;
+                p.layer = &layer;
+                p.geometry = std::move(geometry);
+                p.problem_type = problem_type;
+                p.object_type = m_object_type;
+                p.object_id = m_object_id;
+                p.nodes = m_nodes;
+                p.id1 = id1;
+                p.id2 = id2;
+
+                if (m_mode == ogr_writer_mode::background_thread) {
+                    m_queue.push(std::move(p));
+                } else {
+                    write_problem(p);
+                }
             }
 
             void write_point(const char* problem_type, osmium::object_id_type id1, osmium::object_id_type id2, osmium::Location location) {
-                gdalcpp::Feature feature{m_layer_perror, m_ogr_factory.create_point(location)};
-                set_object(feature);
-                feature.set_field("id1", double(id1));
-                feature.set_field("id2", double(id2));
-                feature.set_field("problem", problem_type);
-                feature.add_to_layer();
+                add(m_layer_perror, m_ogr_factory.create_point(location), problem_type, id1, id2);
             }
 
             void write_line(const char* problem_type, osmium::object_id_type id1, osmium::object_id_type id2, osmium::Location loc1, osmium::Location loc2) {
                 auto ogr_linestring = std::unique_ptr<OGRLineString>{new OGRLineString{}};
                 ogr_linestring->addPoint(loc1.lon(), loc1.lat());
                 ogr_linestring->addPoint(loc2.lon(), loc2.lat());
+                add(m_layer_lerror, std::move(ogr_linestring), problem_type, id1, id2);
+            }
 
-                gdalcpp::Feature feature{m_layer_lerror, std::move(ogr_linestring)};
-                set_object(feature);
-                feature.set_field("id1", static_cast<double>(id1));
-                feature.set_field("id2", static_cast<double>(id2));
-                feature.set_field("problem", problem_type);
-                feature.add_to_layer();
+            void write_way(const char* problem_type, const osmium::Way& way) {
+                if (way.nodes().size() < 2) {
+                    return;
+                }
+                try {
+                    add(m_layer_lerror, m_ogr_factory.create_linestring(way), problem_type, way.id(), 0);
+                } catch (const osmium::geometry_error&) {
+                    // XXX
+                }
             }
 
         public:
 
-            explicit ProblemReporterOGR(gdalcpp::Dataset& dataset) :
+            /**
+             * Create the problem reporter and the layers "perrors",
+             * "lerrors", and "ways" in the dataset.
+             *
+             * @param dataset The dataset the problems are written to.
+             * @param mode Where the problems are written.
+             * @param batch_size The number of features added to the
+             *                   dataset in one go (and one transaction
+             *                   unless auto transactions are enabled on
+             *                   the dataset).
+             */
+            explicit ProblemReporterOGR(gdalcpp::Dataset& dataset, ogr_writer_mode mode = ogr_writer_mode::same_thread, std::size_t batch_size = 10000) :
                 m_layer_perror(dataset, "perrors", wkbPoint),
                 m_layer_lerror(dataset, "lerrors", wkbLineString),
-                m_layer_ways(dataset, "ways", wkbLineString) {
+                m_layer_ways(dataset, "ways", wkbLineString),
+                m_batch(dataset, batch_size),
+                m_mode(mode) {
 
                 // 64bit integers are not supported in GDAL < 2, so we
                 // are using a workaround here in fields where we expect
@@ -135,6 +262,47 @@ namespace osmium {
                     .add_field("way_id", OFTInteger, 10)
                     .add_field("nodes", OFTInteger, 8)
                 ;
+
+                if (m_mode == ogr_writer_mode::background_thread) {
+                    std::promise<bool> done;
+                    m_writer_done = done.get_future();
+                    m_writer = osmium::thread::thread_handler{&ProblemReporterOGR::run_writer, this, std::move(done)};
+                }
+            }
+
+            ProblemReporterOGR(const ProblemReporterOGR&) = delete;
+            ProblemReporterOGR& operator=(const ProblemReporterOGR&) = delete;
+
+            ProblemReporterOGR(ProblemReporterOGR&&) = delete;
+            ProblemReporterOGR& operator=(ProblemReporterOGR&&) = delete;
+
+            ~ProblemReporterOGR() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Write all outstanding problems to the dataset and stop the
+             * writer thread if there is one. No problems must be reported
+             * after this.
+             *
+             * @throws gdalcpp::gdal_error if writing failed.
+             */
+            void close() {
+                if (m_closed) {
+                    return;
+                }
+                m_closed = true;
+
+                if (m_mode == ogr_writer_mode::background_thread) {
+                    m_queue.push(problem{});
+                    m_writer_done.get();
+                } else {
+                    m_batch.flush();
+                }
             }
 
             void report_duplicate_node(osmium::object_id_type node_id1, osmium::object_id_type node_id2, osmium::Location location) override {
@@ -173,51 +341,15 @@ namespace osmium {
             }
 
             void report_way_in_multiple_rings(const osmium::Way& way) override {
-                if (way.nodes().size() < 2) {
-                    return;
-                }
-                try {
-                    gdalcpp::Feature feature{m_layer_lerror, m_ogr_factory.create_linestring(way)};
-                    set_object(feature);
-                    feature.set_field("id1", int32_t(way.id()));
-                    feature.set_field("id2", 0);
-                    feature.set_field("problem", "way_in_multiple_rings");
-                    feature.add_to_layer();
-                } catch (const osmium::geometry_error&) {
-                    // XXX
-                }
+                write_way("way_in_multiple_rings", way);
             }
 
             void report_inner_with_same_tags(const osmium::Way& way) override {
-                if (way.nodes().size() < 2) {
-                    return;
-                }
-                try {
-                    gdalcpp::Feature feature{m_layer_lerror, m_ogr_factory.create_linestring(way)};
-                    set_object(feature);
-                    feature.set_field("id1", int32_t(way.id()));
-                    feature.set_field("id2", 0);
-                    feature.set_field("problem", "inner_with_same_tags");
-                    feature.add_to_layer();
-                } catch (const osmium::geometry_error&) {
-                    // XXX
-                }
+                write_way("inner_with_same_tags", way);
             }
 
             void report_duplicate_way(const osmium::Way& way) override {
-                if (way.nodes().size() < 2) {
-                    return;
-                }
-                try {
-                    gdalcpp::Feature feature{m_layer_lerror, m_ogr_factory.create_linestring(way)};
-                    set_object(feature);
-                    feature.set_field("id1", int32_t(way.id()));
-                    feature.set_field("id2", 0);
-                    feature.set_field("problem", "duplicate_way");
-                    feature.add_to_layer();
-                } catch (const osmium::geometry_error&) {
-                    // XXX
-                }
+                write_way("duplicate_way", way);
             }
 
             void report_way(const osmium::Way& way) override {
@@ -230,10 +362,7 @@ namespace osmium {
                     return;
                 }
                 try {
-                    gdalcpp::Feature feature{m_layer_ways, m_ogr_factory.create_linestring(way)};
-                    set_object(feature);
-                    feature.set_field("way_id", int32_t(way.id()));
-                    feature.add_to_layer();
+                    add(m_layer_ways, m_ogr_factory.create_linestring(way), nullptr, way.id(), 0);
                 } catch (const osmium::geometry_error&) {
                     // XXX
                 }
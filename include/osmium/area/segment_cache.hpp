@@ -0,0 +1,196 @@
+#ifndef OSMIUM_AREA_SEGMENT_CACHE_HPP
+#define OSMIUM_AREA_SEGMENT_CACHE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * Cache for the segments extracted from ways by the area
+         * assemblers. Ways shared by many multipolygon relations, like
+         * administrative boundaries, only have their node locations
+         * checked and their segments extracted once. Set the
+         * segment_cache member of the AssemblerConfig to use it.
+         *
+         * Entries are keyed on the way id and version. The cache doesn't
+         * look at the node locations, so only use it as long as the
+         * locations don't change, usually for one run. Only ways without
+         * invalid locations and without duplicate nodes are cached, so
+         * the problems found in other ways are still reported for every
+         * relation.
+         *
+         * The segments of all ways are kept in one vector, each way only
+         * once. If the maximum number of segments is reached, no further
+         * ways are added.
+         *
+         * All functions are thread-safe, the cache can be shared between
+         * assemblers running in a thread pool.
+         */
+        class SegmentCache {
+
+            struct entry {
+                osmium::object_version_type version;
+                std::size_t offset;
+                std::size_t size;
+            }; // struct entry
+
+            mutable std::mutex m_mutex;
+
+            std::unordered_map<osmium::object_id_type, entry> m_entries;
+
+            std::vector<std::pair<osmium::NodeRef, osmium::NodeRef>> m_segments;
+
+            std::size_t m_max_segments;
+
+            std::size_t m_hits = 0;
+            std::size_t m_misses = 0;
+
+        public:
+
+            enum : std::size_t {
+                default_max_segments = 1024UL * 1024UL
+            };
+
+            /**
+             * Constructor.
+             *
+             * @param max_segments The maximum number of segments stored
+             *                     in the cache for all ways together.
+             */
+            explicit SegmentCache(std::size_t max_segments = default_max_segments) :
+                m_max_segments(max_segments) {
+            }
+
+            /**
+             * Look up the segments of the way. If they are found, func is
+             * called as func(const NodeRef&, const NodeRef&) with the two
+             * ends of each segment in order. This happens while the cache
+             * is locked, so func should only copy the data.
+             *
+             * @returns true if the way was found in the cache.
+             */
+            template <typename TFunc>
+            bool lookup(const osmium::Way& way, TFunc&& func) {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                const auto it = m_entries.find(way.id());
+                if (it == m_entries.end() || it->second.version != way.version()) {
+                    ++m_misses;
+                    return false;
+                }
+
+                ++m_hits;
+                const auto end = it->second.offset + it->second.size;
+                for (std::size_t n = it->second.offset; n < end; ++n) {
+                    func(m_segments[n].first, m_segments[n].second);
+                }
+                return true;
+            }
+
+            /**
+             * Store the segments of the way. Nothing is stored if the way
+             * is already in the cache or if the cache is full.
+             *
+             * @param way The way.
+             * @param begin, end Range of segments with member functions
+             *                   first() and second() returning the node
+             *                   refs at both ends.
+             * @returns true if the segments were stored.
+             */
+            template <typename TIterator>
+            bool store(const osmium::Way& way, TIterator begin, TIterator end) {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                const auto size = static_cast<std::size_t>(std::distance(begin, end));
+                if (m_segments.size() + size > m_max_segments || m_entries.count(way.id()) > 0) {
+                    return false;
+                }
+
+                m_entries.emplace(way.id(), entry{way.version(), m_segments.size(), size});
+                for (; begin != end; ++begin) {
+                    m_segments.emplace_back(begin->first(), begin->second());
+                }
+                return true;
+            }
+
+            /**
+             * Remove all entries.
+             */
+            void clear() {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_entries.clear();
+                m_segments.clear();
+            }
+
+            /// The number of ways in the cache.
+            std::size_t size() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_entries.size();
+            }
+
+            /// The number of segments in the cache.
+            std::size_t num_segments() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_segments.size();
+            }
+
+            /// The number of successful lookups.
+            std::size_t hits() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_hits;
+            }
+
+            /// The number of lookups where the way wasn't in the cache.
+            std::size_t misses() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_misses;
+            }
+
+        }; // class SegmentCache
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_SEGMENT_CACHE_HPP
@@ -33,6 +33,9 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <ostream>
 
@@ -47,6 +50,12 @@ namespace osmium {
          * there were.
          */
         struct area_stats {
+
+            /// Number of buckets in the time_histogram.
+            enum {
+                time_histogram_size = 24
+            };
+
             uint64_t area_really_complex_case = 0; ///< Most difficult case with rings touching in multiple points
             uint64_t area_simple_case = 0; ///< Simple case, no touching rings
             uint64_t area_touching_rings_case = 0; ///< More difficult case with touching rings
@@ -71,6 +80,39 @@ namespace osmium {
             uint64_t ways_in_multiple_rings = 0; ///< Different segments of a way ended up in different rings
             uint64_t wrong_role = 0; ///< Member has wrong role (not "outer", "inner", or empty)
             uint64_t invalid_locations = 0; ///< Invalid location found
+            uint64_t segments = 0; ///< Number of segments after removing duplicates
+
+            // Time in nanoseconds spent in the different stages of the
+            // assembly. These are always collected.
+            uint64_t time_sort = 0; ///< Sorting segments
+            uint64_t time_duplicate_segments = 0; ///< Removing duplicate segments
+            uint64_t time_intersections = 0; ///< Checking for intersections
+            uint64_t time_locations = 0; ///< Creating locations list and finding split locations
+            uint64_t time_rings_simple = 0; ///< Building rings in the simple case
+            uint64_t time_rings_complex = 0; ///< Building rings in the complex case (touching rings)
+            uint64_t time_roles = 0; ///< Checking roles
+            uint64_t time_total = 0; ///< All of the above and some overhead
+
+            /**
+             * Histogram of the assembly times: Bucket 0 counts areas that
+             * took less than 1 microsecond, bucket n > 0 areas that took
+             * from 2^(n-1) to 2^n microseconds. The last bucket also counts
+             * everything slower.
+             */
+            std::array<uint64_t, time_histogram_size> time_histogram{{}};
+
+            /**
+             * Add assembly time (in nanoseconds) of an area to time_total
+             * and time_histogram.
+             */
+            void add_assembly_time(uint64_t nanoseconds) noexcept {
+                time_total += nanoseconds;
+                std::size_t bucket = 0;
+                for (uint64_t us = nanoseconds / 1000; us > 0 && bucket < time_histogram.size() - 1; us /= 2) {
+                    ++bucket;
+                }
+                ++time_histogram[bucket];
+            }
 
             area_stats& operator+=(const area_stats& other) noexcept {
                 area_really_complex_case += other.area_really_complex_case;
@@ -90,12 +132,25 @@ namespace osmium {
                 nodes += other.nodes;
                 open_rings += other.open_rings;
                 outer_rings += other.outer_rings;
+                overlapping_segments += other.overlapping_segments;
                 short_ways += other.short_ways;
                 single_way_in_mp_relation += other.single_way_in_mp_relation;
                 touching_rings += other.touching_rings;
                 ways_in_multiple_rings += other.ways_in_multiple_rings;
                 wrong_role += other.wrong_role;
-                invalid_locations += invalid_locations;
+                invalid_locations += other.invalid_locations;
+                segments += other.segments;
+                time_sort += other.time_sort;
+                time_duplicate_segments += other.time_duplicate_segments;
+                time_intersections += other.time_intersections;
+                time_locations += other.time_locations;
+                time_rings_simple += other.time_rings_simple;
+                time_rings_complex += other.time_rings_complex;
+                time_roles += other.time_roles;
+                time_total += other.time_total;
+                for (std::size_t n = 0; n < time_histogram.size(); ++n) {
+                    time_histogram[n] += other.time_histogram[n];
+                }
                 return *this;
             }
 
@@ -125,9 +180,52 @@ namespace osmium {
                        << " touching_rings=" << s.touching_rings
                        << " ways_in_multiple_rings=" << s.ways_in_multiple_rings
                        << " wrong_role=" << s.wrong_role
-                       << " invalid_locations=" << s.invalid_locations;
+                       << " invalid_locations=" << s.invalid_locations
+                       << " segments=" << s.segments
+                       << " time_sort=" << s.time_sort
+                       << " time_duplicate_segments=" << s.time_duplicate_segments
+                       << " time_intersections=" << s.time_intersections
+                       << " time_locations=" << s.time_locations
+                       << " time_rings_simple=" << s.time_rings_simple
+                       << " time_rings_complex=" << s.time_rings_complex
+                       << " time_roles=" << s.time_roles
+                       << " time_total=" << s.time_total;
         }
 
+        namespace detail {
+
+            /**
+             * Adds the time in nanoseconds between construction and
+             * destruction of this object to a counter.
+             */
+            class stage_timer {
+
+                using clock = std::chrono::steady_clock;
+
+                uint64_t& m_counter;
+                clock::time_point m_start;
+
+            public:
+
+                explicit stage_timer(uint64_t& counter) noexcept :
+                    m_counter(counter),
+                    m_start(clock::now()) {
+                }
+
+                stage_timer(const stage_timer&) = delete;
+                stage_timer& operator=(const stage_timer&) = delete;
+
+                stage_timer(stage_timer&&) = delete;
+                stage_timer& operator=(stage_timer&&) = delete;
+
+                ~stage_timer() noexcept {
+                    m_counter += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count());
+                }
+
+            }; // class stage_timer
+
+        } // namespace detail
+
     } // namespace area
 
 } // namespace osmium
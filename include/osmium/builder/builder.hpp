@@ -130,6 +130,21 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Reserve size bytes in the buffer and add them to the size of
+             * the current item and all parent items in one step. Use this
+             * instead of several reserve_space()/add_size() pairs if the
+             * size of the data to be added is known in advance.
+             *
+             * @returns Pointer to the reserved space. It is only valid until
+             *          the next call reserving space in the buffer.
+             */
+            unsigned char* reserve_and_add_size(std::size_t size) {
+                unsigned char* target = reserve_space(size);
+                add_size(static_cast<osmium::memory::item_size_type>(size));
+                return target;
+            }
+
             uint32_t size() const noexcept {
                 return item().byte_size();
             }
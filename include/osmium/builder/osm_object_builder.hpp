@@ -184,6 +184,61 @@ namespace osmium {
                 add_tag(tag.first, tag.second);
             }
 
+            /**
+             * Get the number of bytes a tag needs in the buffer. Use this
+             * together with reserve_tags() and write_tag().
+             *
+             * @param key_length Length of key (not including the \0 byte).
+             * @param value_length Length of value (not including the \0 byte).
+             * @throws std:length_error If the key or value is longer than
+             *         osmium::max_osm_string_length
+             */
+            static std::size_t tag_size(const std::size_t key_length, const std::size_t value_length) {
+                if (key_length > osmium::max_osm_string_length) {
+                    throw std::length_error{"OSM tag key is too long"};
+                }
+                if (value_length > osmium::max_osm_string_length) {
+                    throw std::length_error{"OSM tag value is too long"};
+                }
+                return key_length + 1 + value_length + 1;
+            }
+
+            /**
+             * Reserve space for several tags at once. This is faster than
+             * adding the tags one by one if all tags are known in advance,
+             * because the buffer capacity is only checked and the sizes of
+             * the parent items are only updated once.
+             *
+             * The space must be filled completely with write_tag() before
+             * anything else is added to the buffer.
+             *
+             * @param size The sum of tag_size() for all tags.
+             * @returns Pointer to the reserved space.
+             */
+            char* reserve_tags(const std::size_t size) {
+                return reinterpret_cast<char*>(reserve_and_add_size(size));
+            }
+
+            /**
+             * Write a tag into the space reserved by reserve_tags().
+             *
+             * @param target Where to write the tag.
+             * @param key Pointer to tag key.
+             * @param key_length Length of key (not including the \0 byte).
+             * @param value Pointer to tag value.
+             * @param value_length Length of value (not including the \0 byte).
+             * @returns Pointer to the space behind the tag.
+             */
+            static char* write_tag(char* target, const char* key, const std::size_t key_length, const char* value, const std::size_t value_length) noexcept {
+                std::memcpy(target, key, key_length);
+                target += key_length;
+                *target++ = '\0';
+                std::memcpy(target, value, value_length);
+                target += value_length;
+                *target++ = '\0';
+                return target;
+            }
+
         }; // class TagListBuilder
 
         template <typename T>
@@ -220,6 +275,24 @@ namespace osmium {
                 add_node_ref(NodeRef{ref, location});
             }
 
+            /**
+             * Add count node refs at once and return a pointer to the first
+             * one. The node refs are default constructed, set them by
+             * assigning to them. This is faster than adding the node refs
+             * one by one, because the buffer capacity is only checked and
+             * the sizes of the parent items are only updated once.
+             *
+             * The returned pointer is only valid until something else is
+             * added to the buffer.
+             */
+            osmium::NodeRef* add_node_refs(const std::size_t count) {
+                auto* refs = reinterpret_cast<osmium::NodeRef*>(reserve_and_add_size(count * sizeof(osmium::NodeRef)));
+                for (std::size_t i = 0; i < count; ++i) {
+                    new (&refs[i]) osmium::NodeRef{};
+                }
+                return refs;
+            }
+
         }; // class NodeRefListBuilder
 
         using WayNodeListBuilder = NodeRefListBuilder<WayNodeList>;
@@ -321,6 +394,58 @@ namespace osmium {
                 add_member(type, ref, role.data(), role.size(), full_member);
             }
 
+            /**
+             * Get the number of bytes a member (without full member object)
+             * needs in the buffer. Use this together with reserve_members()
+             * and write_member().
+             *
+             * @param role_length Length of the role (without \0 termination).
+             * @throws std:length_error If role_length is greater than
+             *         osmium::max_osm_string_length
+             */
+            static std::size_t member_size(const std::size_t role_length) {
+                if (role_length > osmium::max_osm_string_length) {
+                    throw std::length_error{"OSM relation member role is too long"};
+                }
+                return sizeof(RelationMember) + osmium::memory::padded_length(role_length + 1);
+            }
+
+            /**
+             * Reserve space for several members at once. This is faster
+             * than adding the members one by one if all members are known
+             * in advance, because the buffer capacity is only checked and
+             * the sizes of the parent items are only updated once.
+             *
+             * The space must be filled completely with write_member() before
+             * anything else is added to the buffer.
+             *
+             * @param size The sum of member_size() for all members.
+             * @returns Pointer to the reserved space.
+             */
+            unsigned char* reserve_members(const std::size_t size) {
+                return reserve_and_add_size(size);
+            }
+
+            /**
+             * Write a member into the space reserved by reserve_members().
+             *
+             * @param target Where to write the member.
+             * @param type The type (node, way, or relation).
+             * @param ref The ID of the member.
+             * @param role Pointer to the role of the member.
+             * @param role_length Length of the role (without \0 termination).
+             * @returns Pointer to the space behind the member.
+             */
+            static unsigned char* write_member(unsigned char* target, osmium::item_type type, object_id_type ref, const char* role, const std::size_t role_length) noexcept {
+                auto* member = new (target) osmium::RelationMember{ref, type};
+                member->set_role_size(osmium::string_size_type(role_length) + 1);
+                target += sizeof(RelationMember);
+                std::memcpy(target, role, role_length);
+                const auto padded = osmium::memory::padded_length(role_length + 1);
+                std::fill_n(target + role_length, padded - role_length, 0);
+                return target + padded;
+            }
+
         }; // class RelationMemberListBuilder
 
         class ChangesetDiscussionBuilder : public Builder {
@@ -508,6 +633,56 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Copy all attributes (id, version, changeset, timestamp, uid,
+             * visible flag, and the location of nodes) and the user name
+             * of the source object in one step instead of setting them one
+             * by one.
+             *
+             * Must be called at most once and before set_user() and
+             * before any sub-builders are used.
+             *
+             * @param source The object to copy from. It must not be in
+             *               the buffer this builder is writing to.
+             */
+            TDerived& copy_attributes(const T& source) {
+                assert(size() == sizeof(T) + min_size_for_user
+                       && "copy_attributes() must be called at most once and before set_user() and any sub-builders");
+                const auto header_size = static_cast<std::size_t>(source.subitems_position() - source.data());
+                assert(header_size >= size());
+                if (header_size > size()) {
+                    const auto space_needed = header_size - size();
+                    reserve_space(space_needed);
+                    add_size(static_cast<uint32_t>(space_needed));
+                }
+                // The Item header (with the size) is not copied.
+                std::copy_n(source.data() + sizeof(osmium::memory::Item),
+                            header_size - sizeof(osmium::memory::Item),
+                            object().data() + sizeof(osmium::memory::Item));
+                object().set_removed(source.removed());
+                object().set_diff(source.diff());
+
+                return static_cast<TDerived&>(*this);
+            }
+
+            /**
+             * Copy all sub-items (way node list, relation member list,
+             * rings of areas) of the source object except the tag list.
+             * They are copied as a whole without looking into them.
+             *
+             * @param source The object to copy from. It must not be in
+             *               the buffer this builder is writing to.
+             */
+            TDerived& copy_subitems_except_tags(const T& source) {
+                for (const auto& subitem : source) {
+                    if (subitem.type() != osmium::item_type::tag_list) {
+                        add_item(subitem);
+                    }
+                }
+
+                return static_cast<TDerived&>(*this);
+            }
+
         }; // class OSMObjectBuilder
 
         class NodeBuilder : public OSMObjectBuilder<NodeBuilder, Node> {
@@ -710,6 +885,59 @@ namespace osmium {
 
 #undef OSMIUM_FORWARD
 
+        namespace detail {
+
+            template <typename TBuilder, typename T, typename TFunc>
+            void copy_with_new_tags_impl(osmium::memory::Buffer& buffer, const T& object, TFunc&& func) {
+                TBuilder builder{buffer};
+                builder.copy_attributes(object);
+                builder.copy_subitems_except_tags(object);
+                TagListBuilder tl_builder{builder};
+                std::forward<TFunc>(func)(object.tags(), tl_builder);
+            }
+
+        } // namespace detail
+
+        /**
+         * Add a copy of an OSM object (node, way, relation, or area) with
+         * changed tags to the buffer and commit it. All attributes and
+         * sub-items except the tags are copied as whole blocks of memory,
+         * only the tag list is built anew by calling the function
+         *
+         * @code
+         * func(const osmium::TagList& old_tags, osmium::builder::TagListBuilder& builder)
+         * @endcode
+         *
+         * which should add the new tags to the builder. This is much faster
+         * than building the copy field by field.
+         *
+         * @param buffer The buffer to add the copy to.
+         * @param object The object to copy. It must not be in the same
+         *               buffer.
+         * @param func The function creating the new tags.
+         * @returns The offset of the new object in the buffer.
+         */
+        template <typename TFunc>
+        std::size_t copy_with_new_tags(osmium::memory::Buffer& buffer, const osmium::OSMObject& object, TFunc&& func) {
+            switch (object.type()) {
+                case osmium::item_type::node:
+                    detail::copy_with_new_tags_impl<NodeBuilder>(buffer, static_cast<const osmium::Node&>(object), std::forward<TFunc>(func));
+                    break;
+                case osmium::item_type::way:
+                    detail::copy_with_new_tags_impl<WayBuilder>(buffer, static_cast<const osmium::Way&>(object), std::forward<TFunc>(func));
+                    break;
+                case osmium::item_type::relation:
+                    detail::copy_with_new_tags_impl<RelationBuilder>(buffer, static_cast<const osmium::Relation&>(object), std::forward<TFunc>(func));
+                    break;
+                case osmium::item_type::area:
+                    detail::copy_with_new_tags_impl<AreaBuilder>(buffer, static_cast<const osmium::Area&>(object), std::forward<TFunc>(func));
+                    break;
+                default:
+                    throw std::invalid_argument{"copy_with_new_tags() needs a node, way, relation, or area"};
+            }
+            return buffer.commit();
+        }
+
     } // namespace builder
 
 } // namespace osmium
@@ -34,15 +34,16 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/handler.hpp>
+#include <osmium/memory/item_iterator.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
 
 #include <memory>
 #include <utility>
 
 namespace osmium {
 
-    class Node;
-    class Way;
-    class Relation;
     class Area;
     class Changeset;
 
@@ -79,6 +80,17 @@ namespace osmium {
                 virtual void changeset(const osmium::Changeset& /*changeset*/) {
                 }
 
+                // Called by osmium::apply() for runs of objects of the
+                // same type, so there is only one virtual call per run.
+                virtual void node_batch(const osmium::memory::ItemIteratorRange<const osmium::Node>& /*nodes*/) {
+                }
+
+                virtual void way_batch(const osmium::memory::ItemIteratorRange<const osmium::Way>& /*ways*/) {
+                }
+
+                virtual void relation_batch(const osmium::memory::ItemIteratorRange<const osmium::Relation>& /*relations*/) {
+                }
+
                 virtual void flush() {
                 }
 
@@ -146,6 +158,24 @@ auto _name_##_dispatch(THandler& handler, const osmium::_type_& object, long) ->
                     changeset_dispatch(m_handler, changeset, 0);
                 }
 
+                void node_batch(const osmium::memory::ItemIteratorRange<const osmium::Node>& nodes) final {
+                    for (const auto& node : nodes) {
+                        node_dispatch(m_handler, node, 0);
+                    }
+                }
+
+                void way_batch(const osmium::memory::ItemIteratorRange<const osmium::Way>& ways) final {
+                    for (const auto& way : ways) {
+                        way_dispatch(m_handler, way, 0);
+                    }
+                }
+
+                void relation_batch(const osmium::memory::ItemIteratorRange<const osmium::Relation>& relations) final {
+                    for (const auto& relation : relations) {
+                        relation_dispatch(m_handler, relation, 0);
+                    }
+                }
+
                 void flush() final {
                     flush_dispatch(m_handler, 0);
                 }
@@ -190,6 +220,18 @@ auto _name_##_dispatch(THandler& handler, const osmium::_type_& object, long) ->
                 m_impl->changeset(changeset);
             }
 
+            void node_batch(const osmium::memory::ItemIteratorRange<const osmium::Node>& nodes) {
+                m_impl->node_batch(nodes);
+            }
+
+            void way_batch(const osmium::memory::ItemIteratorRange<const osmium::Way>& ways) {
+                m_impl->way_batch(ways);
+            }
+
+            void relation_batch(const osmium::memory::ItemIteratorRange<const osmium::Relation>& relations) {
+                m_impl->relation_batch(relations);
+            }
+
             void flush() {
                 m_impl->flush();
             }
@@ -36,13 +36,20 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/area/assembler.hpp>
 #include <osmium/area/multipolygon_collector.hpp>
 #include <osmium/handler/node_locations_for_ways.hpp> // IWYU pragma: keep
+#include <osmium/io/add_locations_to_ways.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/io/reader.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/parallel_visitor.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
 
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -54,6 +61,52 @@ namespace osmium {
      */
     namespace experimental {
 
+        namespace detail {
+
+            // Handle the node locations of the buffer with a generic
+            // location handler on the calling thread.
+            template <typename TLocationHandler>
+            inline void flex_reader_add_locations(osmium::thread::Pool& /*pool*/,
+                                                  osmium::detail::parallel_apply_queue& /*queue*/,
+                                                  osmium::detail::parallel_apply_buffer& pending,
+                                                  TLocationHandler& location_handler) {
+                osmium::apply(*pending.buffer, location_handler);
+            }
+
+            // With the NodeLocationsForWays handler the node locations are
+            // stored on the calling thread and the locations are added to
+            // the ways on the thread pool.
+            template <typename TStoragePosIDs, typename TStorageNegIDs>
+            inline void flex_reader_add_locations(osmium::thread::Pool& pool,
+                                                  osmium::detail::parallel_apply_queue& queue,
+                                                  osmium::detail::parallel_apply_buffer& pending,
+                                                  osmium::handler::NodeLocationsForWays<TStoragePosIDs, TStorageNegIDs>& location_handler) {
+                if (osmium::io::detail::buffer_contains(*pending.buffer, osmium::item_type::node)) {
+                    // The index must not change while it is read.
+                    queue.wait();
+                    for (const auto& node : pending.buffer->select<osmium::Node>()) {
+                        location_handler.node(node);
+                    }
+                }
+                if (osmium::io::detail::buffer_contains(*pending.buffer, osmium::item_type::way)) {
+                    location_handler.prepare_for_lookups();
+                    osmium::io::detail::submit_add_locations(pool, pending, location_handler);
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Reads an OSM file adding node locations to ways and, if areas
+         * are requested, assembling multipolygons, all behind one read()
+         * call returning the buffers in order.
+         *
+         * The Reader decodes the input on its threads. If the location
+         * handler is a NodeLocationsForWays handler, the locations are
+         * added to the ways on the thread pool while the following
+         * buffers are read, so a few buffers are read ahead. Areas are
+         * assembled on the calling thread when a buffer is returned.
+         */
         template <typename TLocationHandler>
         class FlexReader {
 
@@ -66,15 +119,40 @@ namespace osmium {
             osmium::area::Assembler::config_type m_assembler_config;
             osmium::area::MultipolygonCollector<osmium::area::Assembler> m_collector;
 
+            osmium::thread::Pool& m_pool;
+
+            // Buffers read ahead with the tasks adding locations to
+            // their ways.
+            osmium::detail::parallel_apply_queue m_queue;
+            std::size_t m_max_pending;
+            bool m_input_done = false;
+
+            void read_ahead() {
+                while (!m_input_done && m_queue.size() <= m_max_pending) {
+                    osmium::memory::Buffer buffer = m_reader.read();
+                    if (!buffer) {
+                        m_input_done = true;
+                        return;
+                    }
+                    osmium::detail::parallel_apply_buffer pending{std::make_shared<osmium::memory::Buffer>(std::move(buffer)), {}};
+                    if (m_entities & (osmium::osm_entity_bits::node | osmium::osm_entity_bits::way)) {
+                        detail::flex_reader_add_locations(m_pool, m_queue, pending, m_location_handler);
+                    }
+                    m_queue.push(std::move(pending));
+                }
+            }
+
         public:
 
-            explicit FlexReader(const osmium::io::File& file, TLocationHandler& location_handler, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
+            explicit FlexReader(const osmium::io::File& file, TLocationHandler& location_handler, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) :
                 m_with_areas((entities & osmium::osm_entity_bits::area) != 0),
                 m_entities((entities & ~osmium::osm_entity_bits::area) | (m_with_areas ? osmium::osm_entity_bits::node | osmium::osm_entity_bits::way : osmium::osm_entity_bits::nothing)),
                 m_location_handler(location_handler),
                 m_reader(file, m_entities),
                 m_assembler_config(),
-                m_collector(m_assembler_config)
+                m_collector(m_assembler_config),
+                m_pool(pool),
+                m_max_pending(static_cast<std::size_t>(pool.num_threads()) * 2)
             {
                 m_location_handler.ignore_errors();
                 if (m_with_areas) {
@@ -84,29 +162,45 @@ namespace osmium {
                 }
             }
 
-            explicit FlexReader(const std::string& filename, TLocationHandler& location_handler, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
-                FlexReader(osmium::io::File(filename), location_handler, entities) {
+            explicit FlexReader(const std::string& filename, TLocationHandler& location_handler, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) :
+                FlexReader(osmium::io::File(filename), location_handler, entities, pool) {
             }
 
-            explicit FlexReader(const char* filename, TLocationHandler& location_handler, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
-                FlexReader(osmium::io::File(filename), location_handler, entities) {
+            explicit FlexReader(const char* filename, TLocationHandler& location_handler, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) :
+                FlexReader(osmium::io::File(filename), location_handler, entities, pool) {
             }
 
+            FlexReader(const FlexReader&) = delete;
+            FlexReader& operator=(const FlexReader&) = delete;
+
+            FlexReader(FlexReader&&) = delete;
+            FlexReader& operator=(FlexReader&&) = delete;
+
+            ~FlexReader() noexcept = default;
+
+            /**
+             * Read the next buffer with the locations added to the ways
+             * and the areas assembled from the ways in it appended.
+             *
+             * @returns Buffer, invalid at the end of the input.
+             */
             osmium::memory::Buffer read() {
-                osmium::memory::Buffer buffer = m_reader.read();
-
-                if (buffer) {
-                    if (m_with_areas) {
-                        std::vector<osmium::memory::Buffer> area_buffers;
-                        osmium::apply(buffer, m_location_handler, m_collector.handler([&area_buffers](osmium::memory::Buffer&& area_buffer) {
-                            area_buffers.push_back(std::move(area_buffer));
-                        }));
-                        for (const osmium::memory::Buffer& b : area_buffers) {
-                            buffer.add_buffer(b);
-                            buffer.commit();
-                        }
-                    } else if (m_entities & (osmium::osm_entity_bits::node | osmium::osm_entity_bits::way)) {
-                        osmium::apply(buffer, m_location_handler);
+                read_ahead();
+
+                if (m_queue.empty()) {
+                    return osmium::memory::Buffer{};
+                }
+
+                osmium::memory::Buffer buffer{std::move(*m_queue.pop())};
+
+                if (m_with_areas) {
+                    std::vector<osmium::memory::Buffer> area_buffers;
+                    osmium::apply(buffer, m_collector.handler([&area_buffers](osmium::memory::Buffer&& area_buffer) {
+                        area_buffers.push_back(std::move(area_buffer));
+                    }));
+                    for (const osmium::memory::Buffer& b : area_buffers) {
+                        buffer.add_buffer(b);
+                        buffer.commit();
                     }
                 }
 
@@ -118,11 +212,16 @@ namespace osmium {
             }
 
             void close() {
+                m_queue.wait();
+                while (!m_queue.empty()) {
+                    m_queue.pop();
+                }
+                m_input_done = true;
                 return m_reader.close();
             }
 
             bool eof() const {
-                return m_reader.eof();
+                return (m_input_done || m_reader.eof()) && m_queue.empty();
             }
 
             const osmium::area::MultipolygonCollector<osmium::area::Assembler>& collector() const {
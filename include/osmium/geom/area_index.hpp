@@ -0,0 +1,234 @@
+#ifndef OSMIUM_GEOM_AREA_INDEX_HPP
+#define OSMIUM_GEOM_AREA_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/polygon_index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Spatial index for finding the areas (for instance administrative
+         * boundaries or land use polygons) containing locations, for
+         * instance to tag each node with the boundaries it is in.
+         *
+         * Add the areas with add(), they are copied into the index so the
+         * buffers they are in can be released afterwards. Then call
+         * build() once, after that the index can be queried from any
+         * number of threads at the same time. Queries use a PolygonIndex,
+         * see there for details.
+         *
+         * Areas are identified by their position in the index, use
+         * area_id() to get the id of the osmium::Area.
+         */
+        class AreaIndex {
+
+            std::vector<ExtractPolygon> m_polygons;
+            std::vector<osmium::object_id_type> m_area_ids;
+            std::unique_ptr<PolygonIndex> m_index;
+            uint32_t m_resolution;
+
+        public:
+
+            /**
+             * Create an empty index.
+             *
+             * @param resolution Number of grid cells in each direction of
+             *                   the PolygonIndex.
+             */
+            explicit AreaIndex(uint32_t resolution = 256) :
+                m_resolution(resolution) {
+            }
+
+            /**
+             * Add an area to the index. Areas with invalid locations or
+             * rings with less than three locations are ignored.
+             *
+             * @returns true if the area was added.
+             * @throws std::logic_error if build() was already called.
+             */
+            bool add(const osmium::Area& area) {
+                if (m_index) {
+                    throw std::logic_error{"can not add areas to AreaIndex after build()"};
+                }
+                try {
+                    ExtractPolygon polygon{area};
+                    if (polygon.empty()) {
+                        return false;
+                    }
+                    m_polygons.push_back(std::move(polygon));
+                } catch (const std::invalid_argument&) {
+                    return false;
+                }
+                m_area_ids.push_back(area.id());
+                return true;
+            }
+
+            /**
+             * Add all areas in a buffer to the index.
+             *
+             * @returns The number of areas added.
+             * @throws std::logic_error if build() was already called.
+             */
+            std::size_t add(const osmium::memory::Buffer& buffer) {
+                std::size_t count = 0;
+                for (const auto& area : buffer.select<osmium::Area>()) {
+                    if (add(area)) {
+                        ++count;
+                    }
+                }
+                return count;
+            }
+
+            /**
+             * Build the index. Call this after adding all areas and
+             * before querying the index.
+             */
+            void build() {
+                m_index.reset(new PolygonIndex{std::move(m_polygons), m_resolution});
+                m_polygons.clear();
+            }
+
+            /// Has build() been called?
+            bool built() const noexcept {
+                return static_cast<bool>(m_index);
+            }
+
+            /// The number of areas in the index.
+            std::size_t size() const noexcept {
+                return m_area_ids.size();
+            }
+
+            /**
+             * The id of the osmium::Area with the given position in the
+             * index.
+             *
+             * @pre @code n < size() @endcode
+             */
+            osmium::object_id_type area_id(std::size_t n) const noexcept {
+                assert(n < m_area_ids.size());
+                return m_area_ids[n];
+            }
+
+            /**
+             * The PolygonIndex used for queries.
+             *
+             * @pre @code built() @endcode
+             */
+            const PolygonIndex& polygon_index() const noexcept {
+                assert(m_index);
+                return *m_index;
+            }
+
+            /**
+             * Call func with the position of each area containing the
+             * location in the index (in increasing order).
+             *
+             * @pre @code built() @endcode
+             */
+            template <typename TFunc>
+            void for_each_containing(const osmium::Location& location, TFunc&& func) const {
+                polygon_index().for_each_containing(location, std::forward<TFunc>(func));
+            }
+
+            /**
+             * Get the positions of all areas containing the location in
+             * the index (in increasing order). The vector is cleared
+             * first.
+             *
+             * @pre @code built() @endcode
+             */
+            void get_containing(const osmium::Location& location, std::vector<std::size_t>& areas) const {
+                polygon_index().get_containing(location, areas);
+            }
+
+            /**
+             * Query the index for many locations in parallel on the
+             * thread pool. Calls func(n, area) with the position n of the
+             * location in the vector and the position of each area
+             * containing it. The function is called from the worker
+             * threads (and the calling thread) at the same time, for each
+             * location the areas are in increasing order.
+             *
+             * @pre @code built() @endcode
+             */
+            template <typename TFunc>
+            void for_each_containing(osmium::thread::Pool& pool, const std::vector<osmium::Location>& locations, TFunc&& func) const {
+                const PolygonIndex& index = polygon_index();
+                const osmium::Location* const base = locations.data();
+                pool.parallel_for(locations.cbegin(), locations.cend(), [&](const osmium::Location& location) {
+                    const auto n = static_cast<std::size_t>(&location - base);
+                    index.for_each_containing(location, [&](std::size_t area) {
+                        func(n, area);
+                    });
+                });
+            }
+
+            /**
+             * Query the index for many locations in parallel on the
+             * thread pool.
+             *
+             * @returns For each location the positions of the areas
+             *          containing it (in increasing order).
+             * @pre @code built() @endcode
+             */
+            std::vector<std::vector<std::size_t>> get_containing(osmium::thread::Pool& pool, const std::vector<osmium::Location>& locations) const {
+                std::vector<std::vector<std::size_t>> result(locations.size());
+                for_each_containing(pool, locations, [&result](std::size_t n, std::size_t area) {
+                    result[n].push_back(area);
+                });
+                return result;
+            }
+
+        }; // class AreaIndex
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_AREA_INDEX_HPP
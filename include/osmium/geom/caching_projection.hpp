@@ -0,0 +1,189 @@
+#ifndef OSMIUM_GEOM_CACHING_PROJECTION_HPP
+#define OSMIUM_GEOM_CACHING_PROJECTION_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Wrapper around a projection that caches the projected coordinates
+         * of recently used locations. Use it as projection for the
+         * GeometryFactory if projecting is expensive (as it is with the
+         * proj-based Projection class) and many locations are used several
+         * times, for instance the nodes shared between ways or the nodes
+         * of ways that are also part of multipolygons.
+         *
+         * The cache is a fixed-size array indexed by a hash of the location.
+         * A location only replaces the one in its slot, so memory use is
+         * bounded and a lookup is a single comparison. The cache is keyed
+         * by location, not node id, so moved nodes are never a problem.
+         *
+         * This class is not thread safe, use one instance per thread (as
+         * with the GeometryFactory).
+         *
+         * Usage:
+         * @code
+         * using projection_type = osmium::geom::CachingProjection<osmium::geom::Projection>;
+         * osmium::geom::WKBFactory<projection_type> factory{projection_type{osmium::geom::Projection{25832}}};
+         * @endcode
+         */
+        template <typename TProjection>
+        class CachingProjection {
+
+            struct entry {
+                osmium::Location location{};
+                Coordinates coordinates{};
+            };
+
+            TProjection m_projection;
+            mutable std::vector<entry> m_cache;
+            mutable std::size_t m_hits = 0;
+            mutable std::size_t m_misses = 0;
+
+            static std::size_t round_to_power_of_two(std::size_t size) noexcept {
+                std::size_t n = 1;
+                while (n < size) {
+                    n <<= 1U;
+                }
+                return n;
+            }
+
+            std::size_t slot(const osmium::Location location) const noexcept {
+                const uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(location.x())) << 32U) |
+                                     static_cast<uint32_t>(location.y());
+                return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ULL) >> 32U) & (m_cache.size() - 1);
+            }
+
+        public:
+
+            /// Default number of cached locations.
+            enum : std::size_t {
+                default_cache_size = 1UL << 16U
+            };
+
+            /**
+             * Constructor for default initialized projection.
+             */
+            CachingProjection() :
+                m_projection(),
+                m_cache(default_cache_size) {
+            }
+
+            /**
+             * Constructor for explicitly initialized projection. The cache
+             * size is rounded up to the next power of two.
+             */
+            explicit CachingProjection(TProjection&& projection, std::size_t cache_size = default_cache_size) :
+                m_projection(std::move(projection)),
+                m_cache(round_to_power_of_two(cache_size)) {
+            }
+
+            /**
+             * Do coordinate transformation using the cache. The undefined
+             * location is never cached.
+             *
+             * @throws Any exception thrown by the underlying projection.
+             */
+            Coordinates operator()(osmium::Location location) const {
+                if (!location.is_defined()) {
+                    return m_projection(location);
+                }
+
+                auto& e = m_cache[slot(location)];
+                if (e.location == location) {
+                    ++m_hits;
+                    return e.coordinates;
+                }
+
+                ++m_misses;
+                const Coordinates c{m_projection(location)};
+                e.location = location;
+                e.coordinates = c;
+                return c;
+            }
+
+            int epsg() const noexcept {
+                return m_projection.epsg();
+            }
+
+            std::string proj_string() const {
+                return m_projection.proj_string();
+            }
+
+            /// The underlying projection.
+            const TProjection& projection() const noexcept {
+                return m_projection;
+            }
+
+            /// Number of slots in the cache.
+            std::size_t cache_size() const noexcept {
+                return m_cache.size();
+            }
+
+            /// Number of locations found in the cache.
+            std::size_t hits() const noexcept {
+                return m_hits;
+            }
+
+            /// Number of locations that had to be projected.
+            std::size_t misses() const noexcept {
+                return m_misses;
+            }
+
+            /// Remove all locations from the cache and reset the counters.
+            void clear() {
+                for (auto& e : m_cache) {
+                    e = entry{};
+                }
+                m_hits = 0;
+                m_misses = 0;
+            }
+
+        }; // class CachingProjection
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_CACHING_PROJECTION_HPP
@@ -34,6 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/geom/coordinates.hpp>
+#include <osmium/memory/buffer.hpp>
 #include <osmium/memory/collection.hpp>
 #include <osmium/memory/item.hpp>
 #include <osmium/osm/area.hpp>
@@ -48,7 +49,9 @@ DEALINGS IN THE SOFTWARE.
 #include <cstddef>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -141,23 +144,99 @@ namespace osmium {
 
         }; // class IdentityProjection
 
+        namespace detail {
+
+            /**
+             * Does the projection TProjection have an operator() for
+             * projecting many locations at once?
+             */
+            template <typename TProjection>
+            struct projects_many {
+
+                template <typename T>
+                static auto test(int) -> decltype(std::declval<const T&>()(static_cast<const osmium::Location*>(nullptr), static_cast<Coordinates*>(nullptr), std::size_t{0}), std::true_type{});
+
+                template <typename T>
+                static std::false_type test(...);
+
+                using type = decltype(test<TProjection>(0));
+
+            }; // struct projects_many
+
+        } // namespace detail
+
         /**
          * Geometry factory.
+         *
+         * If the projection has an operator() taking an array of locations
+         * (like the MercatorProjection), all locations of a linestring,
+         * polygon or ring are projected at once.
          */
         template <typename TGeomImpl, typename TProjection = IdentityProjection>
         class GeometryFactory {
 
+            // Buffers for projecting many locations at once. They are
+            // kept here so they don't have to be allocated for every
+            // geometry.
+            std::vector<osmium::Location> m_locations;
+            std::vector<Coordinates> m_coordinates;
+
             /**
-             * Add all points of an outer or inner ring to a multipolygon.
+             * Project the locations of the node refs from it to end and
+             * call func with the coordinates of each. If unique is set,
+             * consecutive node refs with the same location are used only
+             * once.
+             *
+             * @returns The number of points.
              */
-            void add_points(const osmium::NodeRefList& nodes) {
+            template <typename TIter, typename TFunc>
+            std::size_t add_locations(TIter it, TIter end, bool unique, TFunc&& func, std::true_type /*projects_many*/) {
+                m_locations.clear();
+                for (; it != end; ++it) {
+                    if (!unique || m_locations.empty() || m_locations.back() != it->location()) {
+                        m_locations.push_back(it->location());
+                    }
+                }
+                if (unique && !m_locations.empty() && !m_locations.front()) {
+                    // The single point version compares with an invalid
+                    // location first, so a first invalid location is
+                    // skipped there.
+                    m_locations.erase(m_locations.begin());
+                }
+                m_coordinates.resize(m_locations.size());
+                m_projection(m_locations.data(), m_coordinates.data(), m_locations.size());
+                for (const auto& c : m_coordinates) {
+                    func(c);
+                }
+                return m_coordinates.size();
+            }
+
+            template <typename TIter, typename TFunc>
+            std::size_t add_locations(TIter it, TIter end, bool unique, TFunc&& func, std::false_type /*projects_many*/) {
+                std::size_t num_points = 0;
                 osmium::Location last_location;
-                for (const osmium::NodeRef& node_ref : nodes) {
-                    if (last_location != node_ref.location()) {
-                        last_location = node_ref.location();
-                        m_impl.multipolygon_add_location(m_projection(last_location));
+                for (; it != end; ++it) {
+                    if (!unique || last_location != it->location()) {
+                        last_location = it->location();
+                        func(m_projection(last_location));
+                        ++num_points;
                     }
                 }
+                return num_points;
+            }
+
+            template <typename TIter, typename TFunc>
+            std::size_t add_locations(TIter it, TIter end, bool unique, TFunc&& func) {
+                return add_locations(it, end, unique, std::forward<TFunc>(func), typename detail::projects_many<TProjection>::type{});
+            }
+
+            /**
+             * Add all points of an outer or inner ring to a multipolygon.
+             */
+            void add_points(const osmium::NodeRefList& nodes) {
+                add_locations(nodes.cbegin(), nodes.cend(), true, [this](const Coordinates& c) {
+                    m_impl.multipolygon_add_location(c);
+                });
             }
 
             TProjection m_projection;
@@ -205,6 +284,11 @@ namespace osmium {
                 return m_projection.proj_string();
             }
 
+            /// The projection used by this factory.
+            const TProjection& projection() const noexcept {
+                return m_projection;
+            }
+
             /* Point */
 
             point_type create_point(const osmium::Location& location) const {
@@ -237,25 +321,16 @@ namespace osmium {
 
             template <typename TIter>
             size_t fill_linestring(TIter it, TIter end) {
-                size_t num_points = 0;
-                for (; it != end; ++it, ++num_points) {
-                    m_impl.linestring_add_location(m_projection(it->location()));
-                }
-                return num_points;
+                return add_locations(it, end, false, [this](const Coordinates& c) {
+                    m_impl.linestring_add_location(c);
+                });
             }
 
             template <typename TIter>
             size_t fill_linestring_unique(TIter it, TIter end) {
-                size_t num_points = 0;
-                osmium::Location last_location;
-                for (; it != end; ++it) {
-                    if (last_location != it->location()) {
-                        last_location = it->location();
-                        m_impl.linestring_add_location(m_projection(last_location));
-                        ++num_points;
-                    }
-                }
-                return num_points;
+                return add_locations(it, end, true, [this](const Coordinates& c) {
+                    m_impl.linestring_add_location(c);
+                });
             }
 
             linestring_type linestring_finish(size_t num_points) {
@@ -310,25 +385,16 @@ namespace osmium {
 
             template <typename TIter>
             size_t fill_polygon(TIter it, TIter end) {
-                size_t num_points = 0;
-                for (; it != end; ++it, ++num_points) {
-                    m_impl.polygon_add_location(m_projection(it->location()));
-                }
-                return num_points;
+                return add_locations(it, end, false, [this](const Coordinates& c) {
+                    m_impl.polygon_add_location(c);
+                });
             }
 
             template <typename TIter>
             size_t fill_polygon_unique(TIter it, TIter end) {
-                size_t num_points = 0;
-                osmium::Location last_location;
-                for (; it != end; ++it) {
-                    if (last_location != it->location()) {
-                        last_location = it->location();
-                        m_impl.polygon_add_location(m_projection(last_location));
-                        ++num_points;
-                    }
-                }
-                return num_points;
+                return add_locations(it, end, true, [this](const Coordinates& c) {
+                    m_impl.polygon_add_location(c);
+                });
             }
 
             polygon_type polygon_finish(size_t num_points) {
@@ -417,6 +483,61 @@ namespace osmium {
                 }
             }
 
+            /* Batches */
+
+            /**
+             * Create linestrings from all ways in the buffer and call
+             * func(way, linestring) for each of them. Ways for which no
+             * linestring can be created, because they have invalid
+             * locations or not enough points, are skipped. All other
+             * objects in the buffer are ignored.
+             *
+             * @returns The number of linestrings created.
+             */
+            template <typename TFunc>
+            std::size_t create_linestrings(const osmium::memory::Buffer& buffer, TFunc&& func, use_nodes un = use_nodes::unique, direction dir = direction::forward) {
+                std::size_t count = 0;
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    linestring_type linestring;
+                    try {
+                        linestring = create_linestring(way, un, dir);
+                    } catch (const osmium::geometry_error&) {
+                        continue;
+                    } catch (const osmium::invalid_location&) {
+                        continue;
+                    }
+                    func(way, std::move(linestring));
+                    ++count;
+                }
+                return count;
+            }
+
+            /**
+             * Create multipolygons from all areas in the buffer and call
+             * func(area, multipolygon) for each of them. Areas for which
+             * no multipolygon can be created are skipped. All other
+             * objects in the buffer are ignored.
+             *
+             * @returns The number of multipolygons created.
+             */
+            template <typename TFunc>
+            std::size_t create_multipolygons(const osmium::memory::Buffer& buffer, TFunc&& func) {
+                std::size_t count = 0;
+                for (const auto& area : buffer.select<osmium::Area>()) {
+                    multipolygon_type multipolygon;
+                    try {
+                        multipolygon = create_multipolygon(area);
+                    } catch (const osmium::geometry_error&) {
+                        continue;
+                    } catch (const osmium::invalid_location&) {
+                        continue;
+                    }
+                    func(area, std::move(multipolygon));
+                    ++count;
+                }
+                return count;
+            }
+
         }; // class GeometryFactory
 
     } // namespace geom
@@ -0,0 +1,172 @@
+#ifndef OSMIUM_GEOM_FIXED_POINT_HPP
+#define OSMIUM_GEOM_FIXED_POINT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/haversine.hpp>
+#include <osmium/geom/util.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * @brief Geometry functions working directly on the fixed-point
+         *        coordinates of osmium::Location.
+         *
+         * The predicates (orientation, overlaps, intersections) use 64 bit
+         * integer arithmetic on the x() and y() values and are exact. The
+         * length functions only convert to floating point where they need
+         * to. None of these functions check that the locations are valid
+         * unless noted otherwise.
+         */
+        namespace fixed_point {
+
+            /**
+             * The cross product of the vectors (b - a) and (c - a). It is
+             * positive if a, b, c are in counter-clockwise order, negative
+             * if they are in clockwise order, and zero if they are
+             * collinear. Exact for all valid locations.
+             */
+            inline int64_t cross(const osmium::Location& a, const osmium::Location& b, const osmium::Location& c) noexcept {
+                return (static_cast<int64_t>(b.x()) - a.x()) * (static_cast<int64_t>(c.y()) - a.y()) -
+                       (static_cast<int64_t>(b.y()) - a.y()) * (static_cast<int64_t>(c.x()) - a.x());
+            }
+
+            /**
+             * The orientation of the three locations: 1 if they are in
+             * counter-clockwise order, -1 if they are in clockwise order,
+             * 0 if they are collinear.
+             */
+            inline int orientation(const osmium::Location& a, const osmium::Location& b, const osmium::Location& c) noexcept {
+                const auto value = cross(a, b, c);
+                return (value > 0) - (value < 0);
+            }
+
+            /**
+             * Do the bounding boxes of the segments p0-p1 and q0-q1
+             * overlap? Boxes touching at the border overlap.
+             */
+            inline bool boxes_overlap(const osmium::Location& p0, const osmium::Location& p1,
+                                      const osmium::Location& q0, const osmium::Location& q1) noexcept {
+                return std::max(p0.x(), p1.x()) >= std::min(q0.x(), q1.x()) &&
+                       std::max(q0.x(), q1.x()) >= std::min(p0.x(), p1.x()) &&
+                       std::max(p0.y(), p1.y()) >= std::min(q0.y(), q1.y()) &&
+                       std::max(q0.y(), q1.y()) >= std::min(p0.y(), p1.y());
+            }
+
+            /**
+             * Do the segments p0-p1 and q0-q1 have at least one point in
+             * common? Segments touching in a point or overlapping collinear
+             * segments count as intersecting. This is an exact test which
+             * doesn't calculate the intersection point, so it can be used
+             * to quickly rule out intersections before doing more
+             * expensive work.
+             */
+            inline bool segments_intersect(const osmium::Location& p0, const osmium::Location& p1,
+                                           const osmium::Location& q0, const osmium::Location& q1) noexcept {
+                if (!boxes_overlap(p0, p1, q0, q1)) {
+                    return false;
+                }
+                const int o1 = orientation(p0, p1, q0);
+                const int o2 = orientation(p0, p1, q1);
+                const int o3 = orientation(q0, q1, p0);
+                const int o4 = orientation(q0, q1, p1);
+
+                if (o1 == 0 && o2 == 0) {
+                    // collinear segments with overlapping bounding boxes
+                    return true;
+                }
+                return o1 != o2 && o3 != o4;
+            }
+
+            /**
+             * Calculate the approximate distance in meters between two
+             * locations. This uses an equirectangular approximation at the
+             * mean latitude of the locations on the same sphere the
+             * haversine functions use. For the short segments found in
+             * OSM ways the difference to osmium::geom::haversine::distance()
+             * is negligible (well below 0.01% for segments shorter than
+             * 10km away from the poles), but it is much faster, because it
+             * needs only one cosine and one square root.
+             *
+             * @pre @code a.valid() && b.valid() @endcode
+             */
+            inline double approximate_distance(const osmium::Location& a, const osmium::Location& b) noexcept {
+                constexpr const double factor = osmium::geom::haversine::EARTH_RADIUS_IN_METERS * PI / 180.0 /
+                                                osmium::detail::coordinate_precision;
+                const int64_t mean_y = (static_cast<int64_t>(a.y()) + b.y()) / 2;
+                const double lat = static_cast<double>(mean_y) / osmium::detail::coordinate_precision;
+                const double dx = static_cast<double>(static_cast<int64_t>(b.x()) - a.x()) * std::cos(deg_to_rad(lat));
+                const double dy = static_cast<double>(static_cast<int64_t>(b.y()) - a.y());
+                return factor * std::sqrt(dx * dx + dy * dy);
+            }
+
+            /**
+             * Calculate the approximate length in meters of a node ref list
+             * (for instance the nodes of a way) by adding up the
+             * approximate_distance() of all segments.
+             *
+             * @throws osmium::invalid_location if any of the locations is
+             *         invalid.
+             */
+            inline double approximate_length(const osmium::NodeRefList& nrl) {
+                double sum_length = 0;
+
+                const auto* prev = nrl.begin();
+                for (const auto* it = prev; it != nrl.end(); ++it) {
+                    if (!it->location().valid()) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+                    if (it != prev) {
+                        sum_length += approximate_distance(prev->location(), it->location());
+                        prev = it;
+                    }
+                }
+
+                return sum_length;
+            }
+
+        } // namespace fixed_point
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_FIXED_POINT_HPP
@@ -65,6 +65,8 @@ DEALINGS IN THE SOFTWARE.
 #include <geos/geom/Point.h>
 #include <geos/geom/Polygon.h>
 #include <geos/geom/PrecisionModel.h>
+#include <geos/geom/prep/PreparedGeometry.h>
+#include <geos/geom/prep/PreparedGeometryFactory.h>
 #include <geos/util/GEOSException.h>
 
 #include <algorithm>
@@ -105,10 +107,20 @@ namespace osmium {
                 std::unique_ptr<geos::geom::GeometryFactory> m_our_geos_factory;
                 geos::geom::GeometryFactory* m_geos_factory;
 
-                std::unique_ptr<geos::geom::CoordinateSequence> m_coordinate_sequence;
+                // The coordinates of the linestring or ring currently
+                // being built. They are kept here across geometries, so
+                // that each coordinate sequence is allocated with its
+                // final size.
+                std::vector<geos::geom::Coordinate> m_coordinates;
                 std::vector<std::unique_ptr<geos::geom::LinearRing>> m_rings;
                 std::vector<std::unique_ptr<geos::geom::Polygon>> m_polygons;
 
+                geos::geom::CoordinateSequence* make_coordinate_sequence() {
+                    auto* coordinates = new std::vector<geos::geom::Coordinate>(m_coordinates);
+                    m_coordinates.clear();
+                    return m_geos_factory->getCoordinateSequenceFactory()->create(coordinates, 2);
+                }
+
             public:
 
                 using point_type        = std::unique_ptr<geos::geom::Point>;
@@ -152,24 +164,16 @@ namespace osmium {
                 /* LineString */
 
                 void linestring_start() {
-                    try {
-                        m_coordinate_sequence.reset(m_geos_factory->getCoordinateSequenceFactory()->create(static_cast<std::size_t>(0), 2));
-                    } catch (const geos::util::GEOSException& e) {
-                        THROW(osmium::geos_geometry_error(e.what()));
-                    }
+                    m_coordinates.clear();
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    try {
-                        m_coordinate_sequence->add(geos::geom::Coordinate{xy.x, xy.y});
-                    } catch (const geos::util::GEOSException& e) {
-                        THROW(osmium::geos_geometry_error(e.what()));
-                    }
+                    m_coordinates.emplace_back(xy.x, xy.y);
                 }
 
                 linestring_type linestring_finish(std::size_t /* num_points */) {
                     try {
-                        return linestring_type{m_geos_factory->createLineString(m_coordinate_sequence.release())};
+                        return linestring_type{m_geos_factory->createLineString(make_coordinate_sequence())};
                     } catch (const geos::util::GEOSException& e) {
                         THROW(osmium::geos_geometry_error(e.what()));
                     }
@@ -200,43 +204,31 @@ namespace osmium {
                 }
 
                 void multipolygon_outer_ring_start() {
-                    try {
-                        m_coordinate_sequence.reset(m_geos_factory->getCoordinateSequenceFactory()->create(static_cast<std::size_t>(0), 2));
-                    } catch (const geos::util::GEOSException& e) {
-                        THROW(osmium::geos_geometry_error(e.what()));
-                    }
+                    m_coordinates.clear();
                 }
 
                 void multipolygon_outer_ring_finish() {
                     try {
-                        m_rings.emplace_back(m_geos_factory->createLinearRing(m_coordinate_sequence.release()));
+                        m_rings.emplace_back(m_geos_factory->createLinearRing(make_coordinate_sequence()));
                     } catch (const geos::util::GEOSException& e) {
                         THROW(osmium::geos_geometry_error(e.what()));
                     }
                 }
 
                 void multipolygon_inner_ring_start() {
-                    try {
-                        m_coordinate_sequence.reset(m_geos_factory->getCoordinateSequenceFactory()->create(static_cast<std::size_t>(0), 2));
-                    } catch (const geos::util::GEOSException& e) {
-                        THROW(osmium::geos_geometry_error(e.what()));
-                    }
+                    m_coordinates.clear();
                 }
 
                 void multipolygon_inner_ring_finish() {
                     try {
-                        m_rings.emplace_back(m_geos_factory->createLinearRing(m_coordinate_sequence.release()));
+                        m_rings.emplace_back(m_geos_factory->createLinearRing(make_coordinate_sequence()));
                     } catch (const geos::util::GEOSException& e) {
                         THROW(osmium::geos_geometry_error(e.what()));
                     }
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    try {
-                        m_coordinate_sequence->add(geos::geom::Coordinate{xy.x, xy.y});
-                    } catch (const geos::util::GEOSException& e) {
-                        THROW(osmium::geos_geometry_error(e.what()));
-                    }
+                    m_coordinates.emplace_back(xy.x, xy.y);
                 }
 
                 multipolygon_type multipolygon_finish() {
@@ -260,6 +252,38 @@ namespace osmium {
         template <typename TProjection = IdentityProjection>
         using GEOSFactory = GeometryFactory<osmium::geom::detail::GEOSFactoryImpl, TProjection>;
 
+        namespace detail {
+
+            struct geos_prepared_geometry_deleter {
+
+                void operator()(const geos::geom::prep::PreparedGeometry* geometry) const noexcept {
+                    geos::geom::prep::PreparedGeometryFactory::destroy(geometry);
+                }
+
+            }; // struct geos_prepared_geometry_deleter
+
+        } // namespace detail
+
+        /// @deprecated
+        using geos_prepared_geometry = std::unique_ptr<const geos::geom::prep::PreparedGeometry, detail::geos_prepared_geometry_deleter>;
+
+        /**
+         * Prepare a GEOS geometry for repeated queries such as contains()
+         * or intersects(), for instance a multipolygon created by the
+         * GEOSFactory that many points are checked against. The prepared
+         * geometry references the original geometry, which must outlive
+         * it.
+         *
+         * @deprecated
+         */
+        inline geos_prepared_geometry prepare_geometry(const geos::geom::Geometry& geometry) {
+            try {
+                return geos_prepared_geometry{geos::geom::prep::PreparedGeometryFactory::prepare(&geometry)};
+            } catch (const geos::util::GEOSException& e) {
+                THROW(osmium::geos_geometry_error(e.what()));
+            }
+        }
+
     } // namespace geom
 
 } // namespace osmium
@@ -40,6 +40,8 @@ DEALINGS IN THE SOFTWARE.
 
 #include <cmath>
 #include <iterator>
+#include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -58,32 +60,102 @@ namespace osmium {
             /// @brief Earth's quadratic mean radius for WGS84
             constexpr const double EARTH_RADIUS_IN_METERS = 6372797.560856;
 
+            namespace detail {
+
+                // A point with its cosine of latitude, which is needed
+                // for both segments the point is part of.
+                struct haversine_point {
+
+                    double x;
+                    double y;
+                    double cos_y;
+
+                    explicit haversine_point(const osmium::geom::Coordinates& c) noexcept :
+                        x(c.x),
+                        y(c.y),
+                        cos_y(std::cos(deg_to_rad(c.y))) {
+                    }
+
+                }; // struct haversine_point
+
+                inline double distance(const haversine_point& p1, const haversine_point& p2) noexcept {
+                    double lonh = std::sin(deg_to_rad(p1.x - p2.x) * 0.5);
+                    lonh *= lonh;
+                    double lath = std::sin(deg_to_rad(p1.y - p2.y) * 0.5);
+                    lath *= lath;
+                    const double tmp = p1.cos_y * p2.cos_y;
+                    return 2.0 * EARTH_RADIUS_IN_METERS * std::asin(std::sqrt(lath + tmp * lonh));
+                }
+
+                // Call func(length) for each segment of the node list.
+                template <typename TFunction>
+                void for_each_segment(const osmium::NodeRefList& nrl, TFunction&& func) {
+                    if (nrl.size() < 2) {
+                        return;
+                    }
+                    const auto* it = nrl.begin();
+                    haversine_point prev{it->location()};
+                    for (++it; it != nrl.end(); ++it) {
+                        const haversine_point point{it->location()};
+                        std::forward<TFunction>(func)(distance(prev, point));
+                        prev = point;
+                    }
+                }
+
+            } // namespace detail
+
             /**
              * Calculate distance in meters between two sets of coordinates.
              *
              * @pre @code c1.valid() && c2.valid() @endcode
              */
             inline double distance(const osmium::geom::Coordinates& c1, const osmium::geom::Coordinates& c2) noexcept {
-                double lonh = std::sin(deg_to_rad(c1.x - c2.x) * 0.5);
-                lonh *= lonh;
-                double lath = std::sin(deg_to_rad(c1.y - c2.y) * 0.5);
-                lath *= lath;
-                const double tmp = std::cos(deg_to_rad(c1.y)) * std::cos(deg_to_rad(c2.y));
-                return 2.0 * EARTH_RADIUS_IN_METERS * std::asin(std::sqrt(lath + tmp * lonh));
+                return detail::distance(detail::haversine_point{c1}, detail::haversine_point{c2});
             }
 
             /**
-             * Calculate length of way.
+             * Calculate the lengths in meters of all segments of a node
+             * list and write them to the output iterator. A list with
+             * n nodes has n-1 segments, lists with less than two nodes
+             * have none. The results are the same as calling distance()
+             * for each pair of consecutive nodes, but the cosine of the
+             * latitude is only calculated once for each node.
+             *
+             * @returns The output iterator after the last length written.
+             * @throws osmium::invalid_location if a location is invalid.
              */
-            inline double distance(const osmium::WayNodeList& wnl) {
-                double sum_length = 0;
+            template <typename TOutputIterator>
+            TOutputIterator segment_distances(const osmium::NodeRefList& nrl, TOutputIterator out) {
+                detail::for_each_segment(nrl, [&out](double length) {
+                    *out = length;
+                    ++out;
+                });
+                return out;
+            }
 
-                for (const auto* it = wnl.begin(); it != wnl.end(); ++it) {
-                    if (std::next(it) != wnl.end()) {
-                        sum_length += distance(it->location(), std::next(it)->location());
-                    }
+            /**
+             * Calculate the lengths in meters of all segments of a node
+             * list.
+             *
+             * @throws osmium::invalid_location if a location is invalid.
+             */
+            inline std::vector<double> segment_distances(const osmium::NodeRefList& nrl) {
+                std::vector<double> lengths;
+                if (nrl.size() > 1) {
+                    lengths.reserve(nrl.size() - 1);
                 }
+                segment_distances(nrl, std::back_inserter(lengths));
+                return lengths;
+            }
 
+            /**
+             * Calculate length of way.
+             */
+            inline double distance(const osmium::WayNodeList& wnl) {
+                double sum_length = 0;
+                detail::for_each_segment(wnl, [&sum_length](double length) {
+                    sum_length += length;
+                });
                 return sum_length;
             }
 
@@ -92,13 +164,9 @@ namespace osmium {
              */
             inline double distance(const osmium::NodeRefList& nrl) {
                 double sum_length = 0;
-
-                for (const auto* it = nrl.begin(); it != nrl.end(); ++it) {
-                    if (std::next(it) != nrl.end()) {
-                        sum_length += distance(it->location(), std::next(it)->location());
-                    }
-                }
-
+                detail::for_each_segment(nrl, [&sum_length](double length) {
+                    sum_length += length;
+                });
                 return sum_length;
             }
 
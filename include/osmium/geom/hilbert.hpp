@@ -0,0 +1,92 @@
+#ifndef OSMIUM_GEOM_HILBERT_HPP
+#define OSMIUM_GEOM_HILBERT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/location.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Get the distance along a Hilbert curve of order 32 covering the
+         * full range of the unsigned 32bit x and y coordinates. Points
+         * close to each other usually have close indexes.
+         */
+        inline uint64_t hilbert_index(uint32_t x, uint32_t y) noexcept {
+            uint64_t index = 0;
+            for (uint32_t s = 1U << 31U; s > 0; s >>= 1U) {
+                const uint32_t rx = (x & s) ? 1 : 0;
+                const uint32_t ry = (y & s) ? 1 : 0;
+                index += static_cast<uint64_t>(s) * s * ((3U * rx) ^ ry);
+                // Rotate the quadrant, so the curve is continuous. Only
+                // the bits below s are used afterwards.
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = ~x;
+                        y = ~y;
+                    }
+                    using std::swap;
+                    swap(x, y);
+                }
+            }
+            return index;
+        }
+
+        /**
+         * Get the Hilbert curve index of a location (see above), used for
+         * sorting objects so that objects close to each other are close
+         * in the order, too.
+         *
+         * @returns The index or the maximum uint64_t value for invalid or
+         *          undefined locations, so they are sorted last.
+         */
+        inline uint64_t hilbert_index(const osmium::Location& location) noexcept {
+            if (!location.valid()) {
+                return std::numeric_limits<uint64_t>::max();
+            }
+            const auto offset = static_cast<int64_t>(1) << 31U;
+            return hilbert_index(static_cast<uint32_t>(static_cast<int64_t>(location.x()) + offset),
+                                 static_cast<uint32_t>(static_cast<int64_t>(location.y()) + offset));
+        }
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_HILBERT_HPP
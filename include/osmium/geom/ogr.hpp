@@ -51,6 +51,7 @@ DEALINGS IN THE SOFTWARE.
 #include <cstddef>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -70,10 +71,28 @@ namespace osmium {
 
             private:
 
-                linestring_type   m_linestring{nullptr};
                 multipolygon_type m_multipolygon{nullptr};
                 polygon_type      m_polygon{nullptr};
-                ring_type         m_ring{nullptr};
+
+                // The coordinates of the linestring or ring currently
+                // being built. They are kept here across geometries, so
+                // that each OGR geometry is allocated with its final size.
+                std::vector<double> m_x;
+                std::vector<double> m_y;
+
+                void add_location(const osmium::geom::Coordinates& xy) {
+                    m_x.push_back(xy.x);
+                    m_y.push_back(xy.y);
+                }
+
+                template <typename T>
+                std::unique_ptr<T> make_curve() {
+                    std::unique_ptr<T> curve{new T{}};
+                    curve->setPoints(static_cast<int>(m_x.size()), m_x.data(), m_y.data());
+                    m_x.clear();
+                    m_y.clear();
+                    return curve;
+                }
 
             public:
 
@@ -89,33 +108,32 @@ namespace osmium {
                 /* LineString */
 
                 void linestring_start() {
-                    m_linestring.reset(new OGRLineString{});
+                    m_x.clear();
+                    m_y.clear();
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    assert(!!m_linestring);
-                    m_linestring->addPoint(xy.x, xy.y);
+                    add_location(xy);
                 }
 
                 linestring_type linestring_finish(size_t /* num_points */) {
-                    assert(!!m_linestring);
-                    return std::move(m_linestring);
+                    return make_curve<OGRLineString>();
                 }
 
                 /* Polygon */
 
                 void polygon_start() {
-                    m_ring.reset(new OGRLinearRing{});
+                    m_x.clear();
+                    m_y.clear();
                 }
 
                 void polygon_add_location(const osmium::geom::Coordinates& xy) {
-                    assert(!!m_ring);
-                    m_ring->addPoint(xy.x, xy.y);
+                    add_location(xy);
                 }
 
                 polygon_type polygon_finish(size_t /* num_points */) {
                     auto polygon = std::unique_ptr<OGRPolygon>{new OGRPolygon{}};
-                    polygon->addRingDirectly(m_ring.release());
+                    polygon->addRingDirectly(make_curve<OGRLinearRing>().release());
                     return polygon;
                 }
 
@@ -136,29 +154,28 @@ namespace osmium {
                 }
 
                 void multipolygon_outer_ring_start() {
-                    m_ring.reset(new OGRLinearRing{});
+                    m_x.clear();
+                    m_y.clear();
                 }
 
                 void multipolygon_outer_ring_finish() {
                     assert(!!m_polygon);
-                    assert(!!m_ring);
-                    m_polygon->addRingDirectly(m_ring.release());
+                    m_polygon->addRingDirectly(make_curve<OGRLinearRing>().release());
                 }
 
                 void multipolygon_inner_ring_start() {
-                    m_ring.reset(new OGRLinearRing{});
+                    m_x.clear();
+                    m_y.clear();
                 }
 
                 void multipolygon_inner_ring_finish() {
                     assert(!!m_polygon);
-                    assert(!!m_ring);
-                    m_polygon->addRingDirectly(m_ring.release());
+                    m_polygon->addRingDirectly(make_curve<OGRLinearRing>().release());
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
                     assert(!!m_polygon);
-                    assert(!!m_ring);
-                    m_ring->addPoint(xy.x, xy.y);
+                    add_location(xy);
                 }
 
                 multipolygon_type multipolygon_finish() {
@@ -0,0 +1,210 @@
+#ifndef OSMIUM_GEOM_PIPELINE_HPP
+#define OSMIUM_GEOM_PIPELINE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/factory.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * A geometry created by the GeometryPipeline together with the
+         * type and id of the object it was created from.
+         */
+        template <typename TGeometry>
+        struct pipeline_geometry {
+            osmium::item_type type;
+            osmium::object_id_type id;
+            TGeometry geometry;
+        }; // struct pipeline_geometry
+
+        namespace detail {
+
+            template <typename TFactory>
+            class GeometryBlock {
+
+                using geometry_type = typename TFactory::linestring_type;
+
+                std::shared_ptr<osmium::memory::Buffer> m_buffer;
+                TFactory m_factory;
+                osmium::osm_entity_bits::type m_entities;
+
+            public:
+
+                GeometryBlock(osmium::memory::Buffer&& buffer, const TFactory& factory, osmium::osm_entity_bits::type entities) :
+                    m_buffer(std::make_shared<osmium::memory::Buffer>(std::move(buffer))),
+                    m_factory(factory),
+                    m_entities(entities) {
+                }
+
+                std::vector<pipeline_geometry<geometry_type>> operator()() {
+                    std::vector<pipeline_geometry<geometry_type>> result;
+
+                    for (const auto& object : m_buffer->select<osmium::OSMObject>()) {
+                        if (!(m_entities & osmium::osm_entity_bits::from_item_type(object.type()))) {
+                            continue;
+                        }
+                        try {
+                            switch (object.type()) {
+                                case osmium::item_type::node:
+                                    result.push_back({object.type(), object.id(), m_factory.create_point(static_cast<const osmium::Node&>(object))});
+                                    break;
+                                case osmium::item_type::way:
+                                    result.push_back({object.type(), object.id(), m_factory.create_linestring(static_cast<const osmium::Way&>(object))});
+                                    break;
+                                case osmium::item_type::area:
+                                    result.push_back({object.type(), object.id(), m_factory.create_multipolygon(static_cast<const osmium::Area&>(object))});
+                                    break;
+                                default:
+                                    break;
+                            }
+                        } catch (const osmium::geometry_error&) {
+                            // ignore objects without valid geometry
+                        } catch (const osmium::invalid_location&) {
+                            // ignore objects without valid geometry
+                        }
+                    }
+
+                    return result;
+                }
+
+            }; // class GeometryBlock
+
+        } // namespace detail
+
+        /**
+         * Creates geometries for all objects in buffers on the worker
+         * threads of a thread pool. For each buffer submitted a future
+         * is returned that will contain the geometries of the objects in
+         * the buffer in the order of the objects. Keep the futures in
+         * the order of the buffers to get the geometries in the order of
+         * the input.
+         *
+         * Points are created for nodes, linestrings for ways and
+         * multipolygons for areas. Objects for which no geometry can be
+         * created (because they have invalid locations or too few
+         * points) are left out.
+         *
+         * @code
+         * osmium::geom::WKBFactory<> factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex};
+         * osmium::geom::GeometryPipeline<decltype(factory)> pipeline{factory};
+         * std::deque<decltype(pipeline)::future_type> futures;
+         * while (auto buffer = reader.read()) {
+         *     // add node locations to the ways here
+         *     futures.push_back(pipeline.submit(std::move(buffer)));
+         * }
+         * for (auto& future : futures) {
+         *     for (const auto& geom : future.get()) {
+         *         ...
+         *     }
+         * }
+         * @endcode
+         *
+         * @tparam TFactory The GeometryFactory type. It is copied once for
+         *         each buffer, so it must not share any state (like an
+         *         output string) between copies. The point, linestring
+         *         and multipolygon types must be the same (they are the
+         *         same for the WKB, WKT and GeoJSON factories).
+         */
+        template <typename TFactory>
+        class GeometryPipeline {
+
+        public:
+
+            using geometry_type = typename TFactory::linestring_type;
+            using result_type = std::vector<pipeline_geometry<geometry_type>>;
+            using future_type = std::future<result_type>;
+
+        private:
+
+            static_assert(std::is_same<typename TFactory::point_type, geometry_type>::value &&
+                          std::is_same<typename TFactory::multipolygon_type, geometry_type>::value,
+                          "GeometryPipeline needs a factory with the same type for all geometries");
+
+            TFactory m_factory;
+            osmium::thread::Pool& m_pool;
+            osmium::osm_entity_bits::type m_entities;
+
+        public:
+
+            /**
+             * Create a GeometryPipeline.
+             *
+             * @param factory The factory used to create the geometries.
+             * @param entities Create geometries for these types of objects.
+             * @param pool The thread pool used.
+             */
+            explicit GeometryPipeline(const TFactory& factory,
+                                      osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::way | osmium::osm_entity_bits::area,
+                                      osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) :
+                m_factory(factory),
+                m_pool(pool),
+                m_entities(entities) {
+            }
+
+            /**
+             * Create geometries for all objects in the buffer. The work
+             * is done on the thread pool.
+             *
+             * @param buffer The buffer. It is moved into the task and
+             *               freed when the task is done.
+             * @returns A future with the geometries.
+             */
+            future_type submit(osmium::memory::Buffer&& buffer) {
+                return m_pool.submit(detail::GeometryBlock<TFactory>{std::move(buffer), m_factory, m_entities});
+            }
+
+        }; // class GeometryPipeline
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_PIPELINE_HPP
@@ -0,0 +1,528 @@
+#ifndef OSMIUM_GEOM_POLYGON_INDEX_HPP
+#define OSMIUM_GEOM_POLYGON_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/tile_cover.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * A (multi)polygon for checking whether locations are inside, for
+         * instance to define the region of an extract. It consists of any
+         * number of rings, a location is inside if it is inside an odd
+         * number of rings. This means outer and inner rings don't need to
+         * be distinguished. The edges of the rings are straight lines in
+         * WGS84 coordinates.
+         *
+         * An ExtractPolygon created from a Box uses Box::contains(), so
+         * locations on the border of the box are inside.
+         *
+         * Rings whose bounding box doesn't contain a location are skipped
+         * in contains(). For rings with many edges the edges are sorted
+         * into horizontal bands, so only the edges in the band of the
+         * location have to be checked.
+         */
+        class ExtractPolygon {
+
+            // Rings with at least this many edges get bands.
+            enum : std::size_t {
+                min_edges_for_bands = 64,
+                edges_per_band = 16
+            };
+
+            struct ring_info {
+                double min_x;
+                double min_y;
+                double max_x;
+                double max_y;
+                double band_height = 0.0; // no bands if 0
+                std::vector<uint32_t> band_offsets;
+                std::vector<uint32_t> band_edges;
+
+                std::size_t band(double y) const noexcept {
+                    const auto b = static_cast<int64_t>(std::floor((y - min_y) / band_height));
+                    return static_cast<std::size_t>(detail::clamp<int64_t>(b, 0, static_cast<int64_t>(band_offsets.size()) - 2));
+                }
+            }; // struct ring_info
+
+            std::vector<std::vector<Coordinates>> m_rings;
+            std::vector<ring_info> m_ring_info;
+            osmium::Box m_envelope;
+            bool m_is_box = false;
+
+            static ring_info make_ring_info(const std::vector<Coordinates>& ring) {
+                ring_info info;
+                info.min_x = info.max_x = ring.front().x;
+                info.min_y = info.max_y = ring.front().y;
+                for (const auto& c : ring) {
+                    info.min_x = std::min(info.min_x, c.x);
+                    info.min_y = std::min(info.min_y, c.y);
+                    info.max_x = std::max(info.max_x, c.x);
+                    info.max_y = std::max(info.max_y, c.y);
+                }
+
+                const std::size_t num_edges = ring.size() - 1;
+                if (num_edges < min_edges_for_bands || info.max_y <= info.min_y) {
+                    return info;
+                }
+
+                const std::size_t num_bands = num_edges / edges_per_band;
+                info.band_height = (info.max_y - info.min_y) / static_cast<double>(num_bands);
+                info.band_offsets.assign(num_bands + 1, 0);
+
+                // Counting sort of the edges into all bands they touch.
+                const auto for_each_band = [&](std::size_t i, uint32_t* offsets, std::vector<uint32_t>* edges) {
+                    const auto first = info.band(std::min(ring[i - 1].y, ring[i].y));
+                    const auto last = info.band(std::max(ring[i - 1].y, ring[i].y));
+                    for (auto b = first; b <= last; ++b) {
+                        if (edges) {
+                            (*edges)[offsets[b]++] = static_cast<uint32_t>(i);
+                        } else {
+                            ++offsets[b + 1];
+                        }
+                    }
+                };
+                for (std::size_t i = 1; i < ring.size(); ++i) {
+                    for_each_band(i, info.band_offsets.data(), nullptr);
+                }
+                for (std::size_t b = 1; b < info.band_offsets.size(); ++b) {
+                    info.band_offsets[b] += info.band_offsets[b - 1];
+                }
+                info.band_edges.resize(info.band_offsets.back());
+                std::vector<uint32_t> pos(info.band_offsets.cbegin(), info.band_offsets.cend() - 1);
+                for (std::size_t i = 1; i < ring.size(); ++i) {
+                    for_each_band(i, pos.data(), &info.band_edges);
+                }
+
+                return info;
+            }
+
+            // Does a ray from (x, y) in positive x direction cross the
+            // edge ending at ring[i]?
+            static bool crosses(const std::vector<Coordinates>& ring, std::size_t i, double x, double y) noexcept {
+                const auto& a = ring[i - 1];
+                const auto& b = ring[i];
+                return (a.y > y) != (b.y > y) &&
+                       x < a.x + (y - a.y) / (b.y - a.y) * (b.x - a.x);
+            }
+
+            static osmium::Location get_location(const osmium::Location& location) noexcept {
+                return location;
+            }
+
+            static osmium::Location get_location(const osmium::NodeRef& node_ref) noexcept {
+                return node_ref.location();
+            }
+
+            template <typename TIter>
+            void add_ring_impl(TIter begin, TIter end) {
+                std::vector<Coordinates> ring;
+                for (; begin != end; ++begin) {
+                    const osmium::Location location = get_location(*begin);
+                    if (!location.valid()) {
+                        throw std::invalid_argument{"invalid location in ring"};
+                    }
+                    ring.emplace_back(location.lon(), location.lat());
+                    m_envelope.extend(location);
+                }
+                if (ring.size() < 3) {
+                    throw std::invalid_argument{"ring needs at least three locations"};
+                }
+                if (ring.front().x != ring.back().x || ring.front().y != ring.back().y) {
+                    ring.push_back(ring.front());
+                }
+                m_ring_info.push_back(make_ring_info(ring));
+                m_rings.push_back(std::move(ring));
+                m_is_box = false;
+            }
+
+        public:
+
+            /**
+             * Create an empty polygon. Add rings with add_ring().
+             */
+            ExtractPolygon() = default;
+
+            /**
+             * Create a polygon from a box.
+             *
+             * @throws std::invalid_argument if the box is invalid.
+             */
+            explicit ExtractPolygon(const osmium::Box& box) {
+                if (!box.valid()) {
+                    throw std::invalid_argument{"invalid box for polygon"};
+                }
+                const auto bl = box.bottom_left();
+                const auto tr = box.top_right();
+                add_ring({bl, osmium::Location{tr.x(), bl.y()}, tr, osmium::Location{bl.x(), tr.y()}});
+                m_is_box = true;
+            }
+
+            /**
+             * Create a polygon from all outer and inner rings of an area.
+             *
+             * @throws std::invalid_argument if a ring has invalid locations
+             *         or less than three locations.
+             */
+            explicit ExtractPolygon(const osmium::Area& area) {
+                for (const auto& item : area) {
+                    if (item.type() == osmium::item_type::outer_ring ||
+                        item.type() == osmium::item_type::inner_ring) {
+                        add_ring(static_cast<const osmium::NodeRefList&>(item));
+                    }
+                }
+            }
+
+            /**
+             * Add a ring. It is closed if the first and last location are
+             * not the same.
+             *
+             * @throws std::invalid_argument if a ring has invalid locations
+             *         or less than three locations.
+             */
+            ExtractPolygon& add_ring(const std::vector<osmium::Location>& ring) {
+                add_ring_impl(ring.cbegin(), ring.cend());
+                return *this;
+            }
+
+            /**
+             * Add the locations of the node refs as ring.
+             *
+             * @throws std::invalid_argument if a ring has invalid locations
+             *         or less than three locations.
+             */
+            ExtractPolygon& add_ring(const osmium::NodeRefList& ring) {
+                add_ring_impl(ring.cbegin(), ring.cend());
+                return *this;
+            }
+
+            bool empty() const noexcept {
+                return m_rings.empty();
+            }
+
+            const std::vector<std::vector<Coordinates>>& rings() const noexcept {
+                return m_rings;
+            }
+
+            /**
+             * The bounding box of all rings. Invalid if there are no rings.
+             */
+            const osmium::Box& envelope() const noexcept {
+                return m_envelope;
+            }
+
+            /**
+             * Is the location inside this polygon?
+             *
+             * @pre @code location.valid() @endcode
+             */
+            bool contains(const osmium::Location& location) const noexcept {
+                assert(location.valid());
+                if (m_rings.empty() || !m_envelope.contains(location)) {
+                    return false;
+                }
+                if (m_is_box) {
+                    return true;
+                }
+
+                // Crossing number test. A ring whose bounding box doesn't
+                // contain the location is crossed an even number of times
+                // or not at all, so it can be skipped.
+                const double x = location.lon_without_check();
+                const double y = location.lat_without_check();
+                bool inside = false;
+                for (std::size_t r = 0; r < m_rings.size(); ++r) {
+                    const auto& ring = m_rings[r];
+                    const auto& info = m_ring_info[r];
+                    if (x < info.min_x || x > info.max_x || y < info.min_y || y > info.max_y) {
+                        continue;
+                    }
+                    if (info.band_height > 0.0) {
+                        const auto band = info.band(y);
+                        for (auto e = info.band_offsets[band]; e < info.band_offsets[band + 1]; ++e) {
+                            if (crosses(ring, info.band_edges[e], x, y)) {
+                                inside = !inside;
+                            }
+                        }
+                    } else {
+                        for (std::size_t i = 1; i < ring.size(); ++i) {
+                            if (crosses(ring, i, x, y)) {
+                                inside = !inside;
+                            }
+                        }
+                    }
+                }
+                return inside;
+            }
+
+        }; // class ExtractPolygon
+
+        /**
+         * An index for finding all polygons a location is in quickly,
+         * even for many polygons. A grid is laid over the bounding box of
+         * all polygons. For each cell the polygons covering the cell
+         * completely and those whose boundary passes through the cell are
+         * stored. Only the latter have to be checked with the (slow)
+         * point-in-polygon test.
+         *
+         * The index can not be changed after it is created.
+         */
+        class PolygonIndex {
+
+            struct entry {
+                uint32_t polygon;
+                bool inside;
+            }; // struct entry
+
+            std::vector<ExtractPolygon> m_polygons;
+            std::vector<std::size_t> m_offsets;
+            std::vector<entry> m_entries;
+            osmium::Box m_envelope;
+            double m_min_x = 0.0;
+            double m_min_y = 0.0;
+            double m_cell_width = 1.0;
+            double m_cell_height = 1.0;
+            int64_t m_cells;
+
+            int64_t cell_x(double x) const noexcept {
+                return detail::clamp<int64_t>(static_cast<int64_t>(std::floor((x - m_min_x) / m_cell_width)), 0, m_cells - 1);
+            }
+
+            int64_t cell_y(double y) const noexcept {
+                return detail::clamp<int64_t>(static_cast<int64_t>(std::floor((y - m_min_y) / m_cell_height)), 0, m_cells - 1);
+            }
+
+            // Find all cells covered by the polygon and add them to cells
+            // as pairs of cell number and entry.
+            void add_cells(uint32_t id, std::vector<std::pair<std::size_t, entry>>& cells) const {
+                const auto& polygon = m_polygons[id];
+                const auto& box = polygon.envelope();
+                const auto min_cx = cell_x(box.bottom_left().lon());
+                const auto max_cx = cell_x(box.top_right().lon());
+                const auto min_cy = cell_y(box.bottom_left().lat());
+                const auto max_cy = cell_y(box.top_right().lat());
+                const auto width = static_cast<std::size_t>(max_cx - min_cx + 1);
+
+                // 0 = outside, 1 = boundary, 2 = inside
+                std::vector<unsigned char> state(width * static_cast<std::size_t>(max_cy - min_cy + 1), 0);
+                const auto index = [&](int64_t x, int64_t y) -> unsigned char& {
+                    return state[static_cast<std::size_t>(y - min_cy) * width + static_cast<std::size_t>(x - min_cx)];
+                };
+
+                for (const auto& ring : polygon.rings()) {
+                    for (std::size_t i = 1; i < ring.size(); ++i) {
+                        detail::for_each_cell_on_segment(m_cells,
+                            (ring[i - 1].x - m_min_x) / m_cell_width, (ring[i - 1].y - m_min_y) / m_cell_height,
+                            (ring[i].x - m_min_x) / m_cell_width, (ring[i].y - m_min_y) / m_cell_height,
+                            [&](int64_t x, int64_t y) {
+                                index(x, y) = 1;
+                            });
+                    }
+                }
+
+                // Cells not touched by the boundary are inside if their
+                // center is inside. Find them row by row.
+                std::vector<double> crossings;
+                for (auto y = min_cy; y <= max_cy; ++y) {
+                    const double center_y = m_min_y + (static_cast<double>(y) + 0.5) * m_cell_height;
+                    crossings.clear();
+                    for (const auto& ring : polygon.rings()) {
+                        for (std::size_t i = 1; i < ring.size(); ++i) {
+                            const auto& a = ring[i - 1];
+                            const auto& b = ring[i];
+                            if ((a.y > center_y) != (b.y > center_y)) {
+                                crossings.push_back(a.x + (center_y - a.y) / (b.y - a.y) * (b.x - a.x));
+                            }
+                        }
+                    }
+                    std::sort(crossings.begin(), crossings.end());
+                    for (std::size_t i = 1; i < crossings.size(); i += 2) {
+                        for (auto x = min_cx; x <= max_cx; ++x) {
+                            const double center_x = m_min_x + (static_cast<double>(x) + 0.5) * m_cell_width;
+                            if (center_x > crossings[i - 1] && center_x < crossings[i] && index(x, y) == 0) {
+                                index(x, y) = 2;
+                            }
+                        }
+                    }
+                }
+
+                for (auto y = min_cy; y <= max_cy; ++y) {
+                    for (auto x = min_cx; x <= max_cx; ++x) {
+                        const auto s = index(x, y);
+                        if (s != 0) {
+                            cells.emplace_back(static_cast<std::size_t>(y * m_cells + x), entry{id, s == 2});
+                        }
+                    }
+                }
+            }
+
+        public:
+
+            /**
+             * Create an index of the polygons.
+             *
+             * @param polygons The polygons. Empty polygons never contain
+             *                 any location.
+             * @param resolution Number of grid cells in each direction.
+             *                   More cells make the index bigger, but
+             *                   fewer point-in-polygon tests are needed.
+             *
+             * @pre @code resolution > 0 @endcode
+             */
+            explicit PolygonIndex(std::vector<ExtractPolygon> polygons, uint32_t resolution = 256) :
+                m_polygons(std::move(polygons)),
+                m_cells(resolution) {
+                assert(resolution > 0);
+
+                for (const auto& polygon : m_polygons) {
+                    if (!polygon.empty()) {
+                        m_envelope.extend(polygon.envelope());
+                    }
+                }
+
+                m_offsets.assign(static_cast<std::size_t>(m_cells * m_cells) + 1, 0);
+                if (!m_envelope.valid()) {
+                    return;
+                }
+
+                m_min_x = m_envelope.bottom_left().lon();
+                m_min_y = m_envelope.bottom_left().lat();
+                const double width = m_envelope.top_right().lon() - m_min_x;
+                const double height = m_envelope.top_right().lat() - m_min_y;
+                if (width > 0) {
+                    m_cell_width = width / static_cast<double>(m_cells);
+                }
+                if (height > 0) {
+                    m_cell_height = height / static_cast<double>(m_cells);
+                }
+
+                std::vector<std::pair<std::size_t, entry>> cells;
+                for (uint32_t id = 0; id < m_polygons.size(); ++id) {
+                    if (!m_polygons[id].empty()) {
+                        add_cells(id, cells);
+                    }
+                }
+
+                // Counting sort of the entries by cell, keeping the order
+                // of the polygons in each cell.
+                for (const auto& c : cells) {
+                    ++m_offsets[c.first + 1];
+                }
+                for (std::size_t i = 1; i < m_offsets.size(); ++i) {
+                    m_offsets[i] += m_offsets[i - 1];
+                }
+                m_entries.resize(cells.size());
+                std::vector<std::size_t> pos(m_offsets.cbegin(), m_offsets.cend() - 1);
+                for (const auto& c : cells) {
+                    m_entries[pos[c.first]++] = c.second;
+                }
+            }
+
+            /**
+             * The number of polygons in the index.
+             */
+            std::size_t size() const noexcept {
+                return m_polygons.size();
+            }
+
+            /**
+             * Get the polygon with the specified id (its index in the
+             * vector the PolygonIndex was created from).
+             *
+             * @pre @code id < size() @endcode
+             */
+            const ExtractPolygon& polygon(std::size_t id) const noexcept {
+                assert(id < m_polygons.size());
+                return m_polygons[id];
+            }
+
+            /**
+             * Call func with the id of each polygon containing the
+             * location in increasing order of the ids. Nothing happens for
+             * an invalid location.
+             */
+            template <typename TFunc>
+            void for_each_containing(const osmium::Location& location, TFunc&& func) const {
+                if (!location.valid() || !m_envelope.valid() || !m_envelope.contains(location)) {
+                    return;
+                }
+                const auto cell = static_cast<std::size_t>(cell_y(location.lat_without_check()) * m_cells +
+                                                           cell_x(location.lon_without_check()));
+                for (auto i = m_offsets[cell]; i < m_offsets[cell + 1]; ++i) {
+                    const auto& e = m_entries[i];
+                    if (e.inside || m_polygons[e.polygon].contains(location)) {
+                        std::forward<TFunc>(func)(static_cast<std::size_t>(e.polygon));
+                    }
+                }
+            }
+
+            /**
+             * Get the ids of all polygons containing the location.
+             *
+             * @param location The location.
+             * @param ids The ids are added to this vector (in increasing
+             *            order). It is cleared first.
+             */
+            void get_containing(const osmium::Location& location, std::vector<std::size_t>& ids) const {
+                ids.clear();
+                for_each_containing(location, [&ids](std::size_t id) {
+                    ids.push_back(id);
+                });
+            }
+
+        }; // class PolygonIndex
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_POLYGON_INDEX_HPP
@@ -0,0 +1,280 @@
+#ifndef OSMIUM_GEOM_ROUTING_TOPOLOGY_HPP
+#define OSMIUM_GEOM_ROUTING_TOPOLOGY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/haversine.hpp>
+#include <osmium/index/id_set_concurrent.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * An edge of a routing graph: a part of a way between two
+         * vertices without any other vertex in between.
+         */
+        struct routing_edge {
+
+            /// The way this edge is part of.
+            osmium::object_id_type way_id;
+
+            /// The node this edge starts at.
+            osmium::object_id_type from_node;
+
+            /// The node this edge ends at.
+            osmium::object_id_type to_node;
+
+            /// The length of the edge in meters (see haversine::distance()).
+            double length;
+
+        }; // struct routing_edge
+
+        /**
+         * Finds the topology of a routing graph: Nodes that are used
+         * more than once (usually by several ways) or are the first or
+         * last node of a way are vertices, the parts of the ways between
+         * them are edges.
+         *
+         * This needs two passes over the ways. In the first pass call
+         * count() for all buffers, in the second pass call edges() for
+         * all buffers after the node locations have been set on the ways,
+         * for instance with the NodeLocationsForWays handler. Both
+         * functions can be called from several threads at the same time,
+         * the versions taking a thread pool do this for a range of
+         * buffers.
+         *
+         * How often a node is used is counted with two
+         * ConcurrentIdSetDense, one for nodes seen at least once, one for
+         * nodes seen at least twice. Nodes are identified by the absolute
+         * value of their Id (see NodeRef::positive_ref()).
+         *
+         * @code
+         * osmium::geom::RoutingTopology topology;
+         * topology.count(buffers, pool);
+         * // set node locations on the ways in the buffers here
+         * const auto edges = topology.edges(buffers, pool);
+         * @endcode
+         */
+        class RoutingTopology {
+
+            using id_set_type = osmium::index::ConcurrentIdSetDense<osmium::unsigned_object_id_type>;
+
+            id_set_type m_seen_once;
+            id_set_type m_seen_twice;
+
+            void count_node(const osmium::NodeRef& node_ref) {
+                if (!m_seen_once.check_and_set(node_ref.positive_ref())) {
+                    m_seen_twice.set(node_ref.positive_ref());
+                }
+            }
+
+            static bool has_valid_locations(const osmium::WayNodeList& nodes) noexcept {
+                return std::all_of(nodes.cbegin(), nodes.cend(), [](const osmium::NodeRef& node_ref) {
+                    return node_ref.location().valid();
+                });
+            }
+
+        public:
+
+            /**
+             * Create an empty topology.
+             *
+             * @param max_id All node Ids must be smaller than this (see
+             *               ConcurrentIdSetDense).
+             */
+            explicit RoutingTopology(std::size_t max_id = 1ULL << 36U) :
+                m_seen_once(max_id),
+                m_seen_twice(max_id) {
+            }
+
+            /**
+             * Count the nodes of the way. Can be called from several
+             * threads at the same time.
+             *
+             * @throws std::out_of_range if a node Id is too large.
+             */
+            void count(const osmium::Way& way) {
+                const auto& nodes = way.nodes();
+                if (nodes.empty()) {
+                    return;
+                }
+                for (const auto& node_ref : nodes) {
+                    count_node(node_ref);
+                }
+                m_seen_twice.set(nodes.front().positive_ref());
+                m_seen_twice.set(nodes.back().positive_ref());
+            }
+
+            /**
+             * Count the nodes of all ways in the buffer. Other objects
+             * are ignored. Can be called from several threads at the same
+             * time.
+             *
+             * @throws std::out_of_range if a node Id is too large.
+             */
+            void count(const osmium::memory::Buffer& buffer) {
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    count(way);
+                }
+            }
+
+            /**
+             * Count the nodes of all ways in all buffers of the range
+             * using the worker threads of the pool.
+             *
+             * @throws std::out_of_range if a node Id is too large.
+             */
+            template <typename TBuffers>
+            void count(const TBuffers& buffers, osmium::thread::Pool& pool) {
+                pool.parallel_for(buffers, [this](const osmium::memory::Buffer& buffer) {
+                    count(buffer);
+                });
+            }
+
+            /**
+             * Is this node a vertex, ie. is it used more than once or is
+             * it the first or last node of a way?
+             */
+            bool is_vertex(osmium::object_id_type id) const noexcept {
+                return m_seen_twice.get(static_cast<osmium::unsigned_object_id_type>(id < 0 ? -id : id));
+            }
+
+            /// The number of vertices found so far.
+            osmium::unsigned_object_id_type num_vertices() const noexcept {
+                return m_seen_twice.size();
+            }
+
+            /**
+             * Split the way at all vertices and append the resulting
+             * edges to the output iterator. Ways with less than two nodes
+             * or with invalid node locations are ignored. Can be called
+             * from several threads at the same time once all ways have
+             * been counted.
+             *
+             * @returns The output iterator after the last edge written.
+             */
+            template <typename TOutputIterator>
+            TOutputIterator edges(const osmium::Way& way, TOutputIterator out) const {
+                const auto& nodes = way.nodes();
+                if (nodes.size() < 2 || !has_valid_locations(nodes)) {
+                    return out;
+                }
+
+                const auto* start = nodes.cbegin();
+                haversine::detail::haversine_point prev{start->location()};
+                double length = 0.0;
+                for (const auto* it = std::next(start); it != nodes.cend(); ++it) {
+                    const haversine::detail::haversine_point point{it->location()};
+                    length += haversine::detail::distance(prev, point);
+                    prev = point;
+                    if (std::next(it) == nodes.cend() || is_vertex(it->ref())) {
+                        *out = routing_edge{way.id(), start->ref(), it->ref(), length};
+                        ++out;
+                        start = it;
+                        length = 0.0;
+                    }
+                }
+
+                return out;
+            }
+
+            /**
+             * Split all ways in the buffer at all vertices. Other objects
+             * are ignored. Can be called from several threads at the same
+             * time once all ways have been counted.
+             *
+             * @returns The edges in the order of the ways in the buffer.
+             */
+            std::vector<routing_edge> edges(const osmium::memory::Buffer& buffer) const {
+                std::vector<routing_edge> result;
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    edges(way, std::back_inserter(result));
+                }
+                return result;
+            }
+
+            /**
+             * Split all ways in all buffers of the range at all vertices
+             * using the worker threads of the pool.
+             *
+             * @returns The edges in the order of the buffers and the ways
+             *          in them.
+             */
+            template <typename TBuffers>
+            std::vector<routing_edge> edges(const TBuffers& buffers, osmium::thread::Pool& pool) const {
+                struct buffer_edges {
+                    const osmium::memory::Buffer* buffer;
+                    std::vector<routing_edge> edges;
+                };
+
+                std::vector<buffer_edges> parts;
+                for (const osmium::memory::Buffer& buffer : buffers) {
+                    parts.push_back(buffer_edges{&buffer, {}});
+                }
+
+                pool.parallel_for(parts, [this](buffer_edges& part) {
+                    part.edges = edges(*part.buffer);
+                });
+
+                std::size_t size = 0;
+                for (const auto& part : parts) {
+                    size += part.edges.size();
+                }
+
+                std::vector<routing_edge> result;
+                result.reserve(size);
+                for (const auto& part : parts) {
+                    result.insert(result.end(), part.edges.cbegin(), part.edges.cend());
+                }
+                return result;
+            }
+
+        }; // class RoutingTopology
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_ROUTING_TOPOLOGY_HPP
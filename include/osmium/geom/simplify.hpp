@@ -0,0 +1,420 @@
+#ifndef OSMIUM_GEOM_SIMPLIFY_HPP
+#define OSMIUM_GEOM_SIMPLIFY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace detail {
+
+            struct integer_point {
+                int64_t x;
+                int64_t y;
+            };
+
+            // Squared distance of point p from the segment a-b. The
+            // differences are calculated exactly in integers, only the
+            // products (which could overflow 64 bit) are done in double.
+            inline double squared_segment_distance(const integer_point& a, const integer_point& b, const integer_point& p) noexcept {
+                const auto dx = static_cast<double>(b.x - a.x);
+                const auto dy = static_cast<double>(b.y - a.y);
+                const auto px = static_cast<double>(p.x - a.x);
+                const auto py = static_cast<double>(p.y - a.y);
+
+                const double length2 = dx * dx + dy * dy;
+                const double dot = px * dx + py * dy;
+                if (length2 <= 0.0 || dot <= 0.0) {
+                    return px * px + py * py;
+                }
+                if (dot >= length2) {
+                    const auto qx = static_cast<double>(p.x - b.x);
+                    const auto qy = static_cast<double>(p.y - b.y);
+                    return qx * qx + qy * qy;
+                }
+                const double cross = dx * py - dy * px;
+                return cross * cross / length2;
+            }
+
+            inline double squared_segment_distance(const Coordinates& a, const Coordinates& b, const Coordinates& p) noexcept {
+                const double dx = b.x - a.x;
+                const double dy = b.y - a.y;
+                const double px = p.x - a.x;
+                const double py = p.y - a.y;
+
+                const double length2 = dx * dx + dy * dy;
+                const double dot = px * dx + py * dy;
+                if (length2 <= 0.0 || dot <= 0.0) {
+                    return px * px + py * py;
+                }
+                if (dot >= length2) {
+                    const double qx = p.x - b.x;
+                    const double qy = p.y - b.y;
+                    return qx * qx + qy * qy;
+                }
+                const double cross = dx * py - dy * px;
+                return cross * cross / length2;
+            }
+
+            /**
+             * Run the Douglas-Peucker algorithm down to a tolerance of 0
+             * and return the squared tolerance for each point below which
+             * it is kept. A point found as farthest point in a segment
+             * gets the smaller one of its distance and the value of the
+             * point which created the segment, because it can only be
+             * kept if that point is kept, too. So keeping all points with
+             * a value larger than some tolerance gives exactly the
+             * result of the normal algorithm with that tolerance.
+             */
+            template <typename TPoint>
+            std::vector<double> douglas_peucker_weights(const std::vector<TPoint>& points) {
+                std::vector<double> weights(points.size(), std::numeric_limits<double>::infinity());
+                if (points.size() < 3) {
+                    return weights;
+                }
+
+                struct segment {
+                    std::size_t first;
+                    std::size_t last;
+                    double weight;
+                };
+
+                // Explicit stack instead of recursion, ways can be long.
+                std::vector<segment> stack;
+                stack.push_back(segment{0, points.size() - 1, std::numeric_limits<double>::infinity()});
+
+                while (!stack.empty()) {
+                    const segment s = stack.back();
+                    stack.pop_back();
+
+                    if (s.last - s.first < 2) {
+                        continue;
+                    }
+
+                    std::size_t farthest = s.first + 1;
+                    double max_distance = -1.0;
+                    for (std::size_t i = s.first + 1; i < s.last; ++i) {
+                        const double distance = squared_segment_distance(points[s.first], points[s.last], points[i]);
+                        if (distance > max_distance) {
+                            max_distance = distance;
+                            farthest = i;
+                        }
+                    }
+
+                    const double weight = max_distance < s.weight ? max_distance : s.weight;
+                    weights[farthest] = weight;
+                    stack.push_back(segment{s.first, farthest, weight});
+                    stack.push_back(segment{farthest, s.last, weight});
+                }
+
+                return weights;
+            }
+
+        } // namespace detail
+
+        /**
+         * The result of simplifying a linestring or ring with all
+         * tolerances of a Simplifier: Which of the points are kept on
+         * which level. The levels are the indexes of the tolerances given
+         * to the Simplifier.
+         *
+         * The first and last points are always kept. The points kept on
+         * a level with a larger tolerance are a subset of the points kept
+         * on a level with a smaller tolerance.
+         */
+        class Simplification {
+
+            // Bit n is set if the point is kept on level n.
+            std::vector<uint32_t> m_levels;
+
+        public:
+
+            Simplification() = default;
+
+            explicit Simplification(std::vector<uint32_t>&& levels) noexcept :
+                m_levels(std::move(levels)) {
+            }
+
+            /// The number of points in the input.
+            std::size_t size() const noexcept {
+                return m_levels.size();
+            }
+
+            /// Was there any input?
+            bool empty() const noexcept {
+                return m_levels.empty();
+            }
+
+            /**
+             * Is the point with the given index kept on the given level?
+             */
+            bool keep(const std::size_t level, const std::size_t index) const noexcept {
+                return (m_levels[index] & (1U << level)) != 0;
+            }
+
+            /**
+             * The number of points kept on the given level.
+             */
+            std::size_t count(const std::size_t level) const noexcept {
+                std::size_t num = 0;
+                for (const auto bits : m_levels) {
+                    if (bits & (1U << level)) {
+                        ++num;
+                    }
+                }
+                return num;
+            }
+
+            /**
+             * Copy the points kept on the given level from the input to
+             * out. The input must be the same points the simplification
+             * was done with, for instance the NodeRefList or the vector
+             * of Coordinates.
+             *
+             * @code
+             * std::vector<osmium::NodeRef> nodes;
+             * simplification.copy(level, way.nodes().cbegin(), std::back_inserter(nodes));
+             * factory.linestring_start();
+             * const auto num_points = factory.fill_linestring_unique(nodes.cbegin(), nodes.cend());
+             * const auto linestring = factory.linestring_finish(num_points);
+             * @endcode
+             *
+             * @returns The output iterator after the last point copied.
+             */
+            template <typename TIterator, typename TOutputIterator>
+            TOutputIterator copy(const std::size_t level, TIterator input, TOutputIterator out) const {
+                for (const auto bits : m_levels) {
+                    if (bits & (1U << level)) {
+                        *out = *input;
+                        ++out;
+                    }
+                    ++input;
+                }
+                return out;
+            }
+
+        }; // class Simplification
+
+        /**
+         * Simplifies linestrings and rings with the Douglas-Peucker
+         * algorithm for several tolerances at once, for instance one
+         * for each zoom level of a tile set. The algorithm runs only
+         * once for each input, the work for each additional tolerance
+         * is only a comparison per point.
+         *
+         * NodeRefLists (way nodes and area rings) are simplified on the
+         * integer coordinates of their Locations, the tolerances are in
+         * degrees then. Projected Coordinates are simplified in doubles,
+         * the tolerances are in the units of the projection then.
+         *
+         * Closed rings are simplified like linestrings with the first
+         * and last point fixed. On large tolerances they can collapse to
+         * less than four points, check the count() of the level if you
+         * need valid polygons.
+         *
+         * The Simplifier doesn't change after construction, so the same
+         * object can be used from several threads.
+         */
+        class Simplifier {
+
+            std::vector<double> m_tolerances;
+
+            // Squared tolerances in Location units (for NodeRefLists)
+            // and in projected units (for Coordinates).
+            std::vector<double> m_location_tolerances;
+            std::vector<double> m_coordinates_tolerances;
+
+            template <typename TPoint>
+            Simplification simplify(const std::vector<TPoint>& points, const std::vector<double>& tolerances) const {
+                const auto weights = detail::douglas_peucker_weights(points);
+
+                std::vector<uint32_t> levels;
+                levels.reserve(weights.size());
+                for (const auto weight : weights) {
+                    uint32_t bits = 0;
+                    for (std::size_t level = 0; level < tolerances.size(); ++level) {
+                        if (weight > tolerances[level]) {
+                            bits |= 1U << level;
+                        }
+                    }
+                    levels.push_back(bits);
+                }
+
+                return Simplification{std::move(levels)};
+            }
+
+        public:
+
+            /// The maximum number of tolerances (levels).
+            enum : std::size_t {
+                max_levels = 32
+            };
+
+            /**
+             * Create a Simplifier.
+             *
+             * @param tolerances The tolerances, one for each level.
+             * @throws std::invalid_argument if there are no or more than
+             *         max_levels tolerances or if a tolerance is negative.
+             */
+            explicit Simplifier(std::vector<double> tolerances) :
+                m_tolerances(std::move(tolerances)) {
+                if (m_tolerances.empty() || m_tolerances.size() > max_levels) {
+                    throw std::invalid_argument{"Simplifier needs between 1 and 32 tolerances"};
+                }
+                for (const auto tolerance : m_tolerances) {
+                    if (!(tolerance >= 0.0)) {
+                        throw std::invalid_argument{"Simplifier tolerances must not be negative"};
+                    }
+                    const double location_tolerance = tolerance * osmium::detail::coordinate_precision;
+                    m_location_tolerances.push_back(location_tolerance * location_tolerance);
+                    m_coordinates_tolerances.push_back(tolerance * tolerance);
+                }
+            }
+
+            /// The number of levels (tolerances).
+            std::size_t num_levels() const noexcept {
+                return m_tolerances.size();
+            }
+
+            /// The tolerance of the given level.
+            double tolerance(const std::size_t level) const {
+                return m_tolerances.at(level);
+            }
+
+            /**
+             * Simplify a NodeRefList, for instance the nodes of a way or
+             * a ring of an area. The tolerances are in degrees.
+             *
+             * @throws osmium::invalid_location if a location is invalid.
+             */
+            Simplification operator()(const osmium::NodeRefList& nodes) const {
+                std::vector<detail::integer_point> points;
+                points.reserve(nodes.size());
+                for (const auto& node_ref : nodes) {
+                    const auto location = node_ref.location();
+                    if (!location.valid()) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+                    points.push_back(detail::integer_point{location.x(), location.y()});
+                }
+                return simplify(points, m_location_tolerances);
+            }
+
+            /**
+             * Simplify projected coordinates. The tolerances are in the
+             * units of the coordinates.
+             *
+             * @throws osmium::invalid_location if a coordinate is invalid.
+             */
+            Simplification operator()(const std::vector<Coordinates>& coordinates) const {
+                for (const auto& c : coordinates) {
+                    if (!c.valid()) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+                }
+                return simplify(coordinates, m_coordinates_tolerances);
+            }
+
+        }; // class Simplifier
+
+        /**
+         * A NodeRefList from a buffer together with its simplification.
+         */
+        struct simplified_nodes {
+            const osmium::NodeRefList* nodes;
+            Simplification simplification;
+        }; // struct simplified_nodes
+
+        /**
+         * Simplify the nodes of all ways and the rings of all areas in
+         * the buffer on the worker threads of the pool. The node
+         * locations must have been set on the ways.
+         *
+         * The result contains one entry for each way and one for each
+         * ring of each area in the order they are in the buffer. Use
+         * nodes->type() to find out whether an entry is for a way or
+         * for an outer or inner ring. The simplification of node lists
+         * with invalid locations is empty.
+         *
+         * @param buffer The buffer. Objects other than ways and areas
+         *               are ignored.
+         * @param simplifier The Simplifier with the tolerances.
+         * @param pool The thread pool to use.
+         */
+        inline std::vector<simplified_nodes> simplify(const osmium::memory::Buffer& buffer, const Simplifier& simplifier, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            std::vector<simplified_nodes> result;
+            for (const auto& item : buffer) {
+                if (item.type() == osmium::item_type::way) {
+                    result.push_back(simplified_nodes{&static_cast<const osmium::Way&>(item).nodes(), Simplification{}});
+                } else if (item.type() == osmium::item_type::area) {
+                    for (const auto& ring : static_cast<const osmium::Area&>(item)) {
+                        if (ring.type() == osmium::item_type::outer_ring || ring.type() == osmium::item_type::inner_ring) {
+                            result.push_back(simplified_nodes{&static_cast<const osmium::NodeRefList&>(ring), Simplification{}});
+                        }
+                    }
+                }
+            }
+
+            pool.parallel_for(result, [&simplifier](simplified_nodes& entry) {
+                try {
+                    entry.simplification = simplifier(*entry.nodes);
+                } catch (const osmium::invalid_location&) {
+                    // leave simplification empty
+                }
+            });
+
+            return result;
+        }
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_SIMPLIFY_HPP
@@ -0,0 +1,216 @@
+#ifndef OSMIUM_GEOM_TILE_BUCKETS_HPP
+#define OSMIUM_GEOM_TILE_BUCKETS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/tile.hpp>
+#include <osmium/geom/tile_cover.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace detail {
+
+            /// Number of objects for which the tiles are found in one task.
+            constexpr const std::size_t tile_buckets_slice_size = 1000;
+
+            // Find the tiles covered by each of the objects in a slice.
+            class TileCoverSlice {
+
+                const osmium::OSMObject* const* m_begin;
+                const osmium::OSMObject* const* m_end;
+                uint32_t m_zoom;
+                tile_cover_mode m_mode;
+
+            public:
+
+                TileCoverSlice(const osmium::OSMObject* const* begin, const osmium::OSMObject* const* end, uint32_t zoom, tile_cover_mode mode) noexcept :
+                    m_begin(begin),
+                    m_end(end),
+                    m_zoom(zoom),
+                    m_mode(mode) {
+                }
+
+                std::vector<std::vector<Tile>> operator()() const {
+                    TileCover cover{m_zoom};
+                    std::vector<std::vector<Tile>> result;
+                    result.reserve(static_cast<std::size_t>(m_end - m_begin));
+                    for (auto it = m_begin; it != m_end; ++it) {
+                        try {
+                            result.push_back(cover.object(**it, m_mode));
+                        } catch (const osmium::invalid_location&) {
+                            result.emplace_back();
+                        }
+                    }
+                    return result;
+                }
+
+            }; // class TileCoverSlice
+
+        } // namespace detail
+
+        /**
+         * Sorts objects into buckets, one for each tile they cover (see
+         * TileCover). Each bucket is a Buffer containing copies of the
+         * objects in the order they were added. Objects covering several
+         * tiles are copied into each of their buckets. Objects without
+         * valid locations and relations are not added to any bucket.
+         *
+         * @code
+         * osmium::geom::TileBuckets buckets{14};
+         * while (auto buffer = reader.read()) {
+         *     // add node locations to the ways here
+         *     buckets.add_buffer(buffer);
+         * }
+         * for (auto& bucket : buckets.buckets()) {
+         *     // bucket.first is the tile, bucket.second the buffer
+         * }
+         * @endcode
+         */
+        class TileBuckets {
+
+            std::map<Tile, osmium::memory::Buffer> m_buckets;
+            std::vector<const osmium::OSMObject*> m_objects;
+            TileCover m_cover;
+            tile_cover_mode m_mode;
+            std::size_t m_initial_buffer_size;
+
+            void add_to_buckets(const osmium::OSMObject& object, const std::vector<Tile>& tiles) {
+                for (const auto& tile : tiles) {
+                    auto it = m_buckets.find(tile);
+                    if (it == m_buckets.end()) {
+                        it = m_buckets.emplace(tile, osmium::memory::Buffer{m_initial_buffer_size, osmium::memory::Buffer::auto_grow::yes}).first;
+                    }
+                    it->second.add_item(object);
+                    it->second.commit();
+                }
+            }
+
+        public:
+
+            /**
+             * Create TileBuckets.
+             *
+             * @param zoom The zoom level of the tiles.
+             * @param mode How to find the tiles covered by ways and areas.
+             * @param initial_buffer_size The initial size of the buffers
+             *                            for the buckets.
+             *
+             * @pre @code zoom <= 30 @endcode
+             */
+            explicit TileBuckets(uint32_t zoom, tile_cover_mode mode = tile_cover_mode::exact, std::size_t initial_buffer_size = 64UL * 1024UL) :
+                m_cover(zoom),
+                m_mode(mode),
+                m_initial_buffer_size(initial_buffer_size) {
+            }
+
+            uint32_t zoom() const noexcept {
+                return m_cover.zoom();
+            }
+
+            /**
+             * Add the object to the buckets of all tiles it covers.
+             */
+            void add(const osmium::OSMObject& object) {
+                try {
+                    add_to_buckets(object, m_cover.object(object, m_mode));
+                } catch (const osmium::invalid_location&) {
+                    // objects without valid locations are not added
+                }
+            }
+
+            /**
+             * Add all objects in the buffer. The tiles covered by each
+             * object are found on the worker threads of the pool, the
+             * objects are then copied into the buckets on the calling
+             * thread in the order of the buffer.
+             */
+            void add_buffer(const osmium::memory::Buffer& buffer, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                m_objects.clear();
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    m_objects.push_back(&object);
+                }
+
+                std::vector<std::future<std::vector<std::vector<Tile>>>> futures;
+                for (std::size_t begin = 0; begin < m_objects.size(); begin += detail::tile_buckets_slice_size) {
+                    const std::size_t end = std::min(begin + detail::tile_buckets_slice_size, m_objects.size());
+                    futures.push_back(pool.submit(detail::TileCoverSlice{m_objects.data() + begin, m_objects.data() + end, zoom(), m_mode}));
+                }
+
+                std::size_t n = 0;
+                for (auto& future : futures) {
+                    for (const auto& tiles : future.get()) {
+                        add_to_buckets(*m_objects[n], tiles);
+                        ++n;
+                    }
+                }
+            }
+
+            /**
+             * Access the buckets.
+             */
+            std::map<Tile, osmium::memory::Buffer>& buckets() noexcept {
+                return m_buckets;
+            }
+
+            const std::map<Tile, osmium::memory::Buffer>& buckets() const noexcept {
+                return m_buckets;
+            }
+
+            /**
+             * Remove all buckets.
+             */
+            void clear() {
+                m_buckets.clear();
+            }
+
+        }; // class TileBuckets
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_TILE_BUCKETS_HPP
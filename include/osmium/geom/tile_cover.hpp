@@ -0,0 +1,359 @@
+#ifndef OSMIUM_GEOM_TILE_COVER_HPP
+#define OSMIUM_GEOM_TILE_COVER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/tile.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * How the tiles covered by a way or area are found.
+         */
+        enum class tile_cover_mode : bool {
+            bbox  = false, ///< All tiles covered by the bounding box.
+            exact = true   ///< Only tiles touched by the geometry.
+        }; // enum class tile_cover_mode
+
+        namespace detail {
+
+            // A position in the tile grid of a zoom level. The integer
+            // parts are the tile numbers.
+            struct tile_position {
+                double x;
+                double y;
+            }; // struct tile_position
+
+            /// Maximum latitude at which tiles are computed.
+            constexpr double max_tile_lat = 85.0511287798;
+
+            inline tile_position to_tile_position(uint32_t zoom, const osmium::Location& location) {
+                const double lat = clamp(location.lat(), -max_tile_lat, max_tile_lat);
+                const auto c = lonlat_to_mercator(Coordinates{location.lon(), lat});
+                const double n = num_tiles_in_zoom(zoom);
+                return tile_position{(c.x + max_coordinate_epsg3857) / (2 * max_coordinate_epsg3857) * n,
+                                     (max_coordinate_epsg3857 - c.y) / (2 * max_coordinate_epsg3857) * n};
+            }
+
+            inline int64_t tile_number(uint32_t zoom, double pos) noexcept {
+                return clamp<int64_t>(static_cast<int64_t>(std::floor(pos)), 0, num_tiles_in_zoom(zoom) - 1);
+            }
+
+            /**
+             * Call func(x, y) for all cells of a grid of num_cells x
+             * num_cells cells the line from (ax, ay) to (bx, by) passes
+             * through. Positions are in cell units, the integer parts are
+             * the cell numbers. Positions outside the grid are clamped to
+             * the border cells. This is the grid traversal algorithm by
+             * Amanatides and Woo.
+             */
+            template <typename TFunc>
+            inline void for_each_cell_on_segment(int64_t num_cells, double ax, double ay, double bx, double by, TFunc&& func) {
+                const auto cell = [num_cells](double pos) {
+                    return clamp<int64_t>(static_cast<int64_t>(std::floor(pos)), 0, num_cells - 1);
+                };
+
+                int64_t x = cell(ax);
+                int64_t y = cell(ay);
+                const int64_t end_x = cell(bx);
+                const int64_t end_y = cell(by);
+
+                const double dx = bx - ax;
+                const double dy = by - ay;
+                const int64_t step_x = dx > 0 ? 1 : -1;
+                const int64_t step_y = dy > 0 ? 1 : -1;
+
+                // Parameter t (from 0 at a to 1 at b) at which the line
+                // crosses the next vertical/horizontal cell border and
+                // the increment of t from one border to the next.
+                const double inf = 2.0;
+                double t_max_x = dx == 0 ? inf : ((step_x > 0 ? static_cast<double>(x + 1) : static_cast<double>(x)) - ax) / dx;
+                double t_max_y = dy == 0 ? inf : ((step_y > 0 ? static_cast<double>(y + 1) : static_cast<double>(y)) - ay) / dy;
+                const double t_delta_x = dx == 0 ? inf : 1.0 / std::abs(dx);
+                const double t_delta_y = dy == 0 ? inf : 1.0 / std::abs(dy);
+
+                func(x, y);
+                for (int64_t steps = std::abs(end_x - x) + std::abs(end_y - y); steps > 0; --steps) {
+                    if ((t_max_x < t_max_y && x != end_x) || y == end_y) {
+                        x += step_x;
+                        t_max_x += t_delta_x;
+                    } else {
+                        y += step_y;
+                        t_max_y += t_delta_y;
+                    }
+                    func(x, y);
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Finds all tiles in a zoom level covered by a location, box,
+         * way or area.
+         *
+         * Ways are rasterized segment by segment, so each tile one of the
+         * segments passes through is found. For areas this is done with
+         * the rings, the tiles in the inside of the area are added to
+         * those. In bbox mode all tiles inside the bounding box are used
+         * instead, which is faster but may find many more tiles.
+         *
+         * All functions return a reference to a vector of tiles sorted
+         * by the order defined on tiles with no duplicates. This vector
+         * is reused in the next call (so a TileCover object can be used
+         * for many objects without allocating memory).
+         *
+         * Latitudes outside the range of the Mercator projection are
+         * clamped to the top or bottom row of tiles.
+         */
+        class TileCover {
+
+            std::vector<Tile> m_tiles;
+            std::vector<detail::tile_position> m_positions;
+            std::vector<std::size_t> m_ring_ends;
+            std::vector<double> m_crossings;
+            uint32_t m_zoom;
+
+            void add(int64_t x, int64_t y) {
+                m_tiles.emplace_back(m_zoom, static_cast<uint32_t>(x), static_cast<uint32_t>(y));
+            }
+
+            const std::vector<Tile>& finish() {
+                std::sort(m_tiles.begin(), m_tiles.end());
+                m_tiles.erase(std::unique(m_tiles.begin(), m_tiles.end()), m_tiles.end());
+                return m_tiles;
+            }
+
+            // Add all tiles the line from a to b passes through.
+            void add_segment(const detail::tile_position& a, const detail::tile_position& b) {
+                detail::for_each_cell_on_segment(num_tiles_in_zoom(m_zoom), a.x, a.y, b.x, b.y, [this](int64_t x, int64_t y) {
+                    add(x, y);
+                });
+            }
+
+            // Convert locations of the node refs into tile positions (in
+            // m_positions) and add the tiles the segments go through.
+            void add_node_ref_list(const osmium::NodeRefList& nodes) {
+                const std::size_t first = m_positions.size();
+                for (const auto& node_ref : nodes) {
+                    m_positions.push_back(detail::to_tile_position(m_zoom, node_ref.location()));
+                }
+                if (m_positions.size() == first + 1) {
+                    add_segment(m_positions.back(), m_positions.back());
+                    return;
+                }
+                for (std::size_t i = first + 1; i < m_positions.size(); ++i) {
+                    add_segment(m_positions[i - 1], m_positions[i]);
+                }
+            }
+
+            // Add all tiles whose center is inside the rings. The rings
+            // are in m_positions, m_ring_ends has the end of each ring.
+            void add_inside() {
+                if (m_tiles.empty()) {
+                    return;
+                }
+                const auto minmax_y = std::minmax_element(m_tiles.cbegin(), m_tiles.cend(), [](const Tile& lhs, const Tile& rhs) {
+                    return lhs.y < rhs.y;
+                });
+                for (auto y = minmax_y.first->y; y <= minmax_y.second->y; ++y) {
+                    const double center_y = y + 0.5;
+                    m_crossings.clear();
+                    std::size_t begin = 0;
+                    for (const auto end : m_ring_ends) {
+                        for (std::size_t i = begin + 1; i < end; ++i) {
+                            const auto& a = m_positions[i - 1];
+                            const auto& b = m_positions[i];
+                            if ((a.y <= center_y) != (b.y <= center_y)) {
+                                m_crossings.push_back(a.x + (center_y - a.y) / (b.y - a.y) * (b.x - a.x));
+                            }
+                        }
+                        begin = end;
+                    }
+                    std::sort(m_crossings.begin(), m_crossings.end());
+                    for (std::size_t i = 1; i < m_crossings.size(); i += 2) {
+                        // tiles with center between the crossings
+                        const auto first = static_cast<int64_t>(std::ceil(m_crossings[i - 1] - 0.5));
+                        const auto last = static_cast<int64_t>(std::floor(m_crossings[i] - 0.5));
+                        for (int64_t x = std::max<int64_t>(first, 0); x <= last && x < num_tiles_in_zoom(m_zoom); ++x) {
+                            add(x, y);
+                        }
+                    }
+                }
+            }
+
+        public:
+
+            /**
+             * Create a TileCover for the specified zoom level.
+             *
+             * @pre @code zoom <= 30 @endcode
+             */
+            explicit TileCover(uint32_t zoom) noexcept :
+                m_zoom(zoom) {
+                assert(zoom <= Tile::max_zoom);
+            }
+
+            uint32_t zoom() const noexcept {
+                return m_zoom;
+            }
+
+            /**
+             * Get the tile containing the location.
+             *
+             * @throws osmium::invalid_location if the location is invalid.
+             */
+            const std::vector<Tile>& location(const osmium::Location& location) {
+                m_tiles.clear();
+                const auto pos = detail::to_tile_position(m_zoom, location);
+                add(detail::tile_number(m_zoom, pos.x), detail::tile_number(m_zoom, pos.y));
+                return m_tiles;
+            }
+
+            /**
+             * Get all tiles covered by the box. Returns no tiles for an
+             * invalid box.
+             */
+            const std::vector<Tile>& box(const osmium::Box& box) {
+                m_tiles.clear();
+                if (!box.valid()) {
+                    return m_tiles;
+                }
+                const auto bottom_left = detail::to_tile_position(m_zoom, box.bottom_left());
+                const auto top_right = detail::to_tile_position(m_zoom, box.top_right());
+                const auto max_y = detail::tile_number(m_zoom, bottom_left.y);
+                const auto max_x = detail::tile_number(m_zoom, top_right.x);
+                for (auto x = detail::tile_number(m_zoom, bottom_left.x); x <= max_x; ++x) {
+                    for (auto y = detail::tile_number(m_zoom, top_right.y); y <= max_y; ++y) {
+                        add(x, y);
+                    }
+                }
+                return m_tiles;
+            }
+
+            /**
+             * Get all tiles touched by the linestring of the node refs.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            const std::vector<Tile>& way(const osmium::NodeRefList& nodes, tile_cover_mode mode = tile_cover_mode::exact) {
+                if (mode == tile_cover_mode::bbox) {
+                    return box(nodes.envelope());
+                }
+                m_tiles.clear();
+                m_positions.clear();
+                add_node_ref_list(nodes);
+                return finish();
+            }
+
+            /**
+             * Get all tiles touched by the way.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            const std::vector<Tile>& way(const osmium::Way& way, tile_cover_mode mode = tile_cover_mode::exact) {
+                return this->way(way.nodes(), mode);
+            }
+
+            /**
+             * Get all tiles touched by or inside the area.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            const std::vector<Tile>& area(const osmium::Area& area, tile_cover_mode mode = tile_cover_mode::exact) {
+                if (mode == tile_cover_mode::bbox) {
+                    return box(area.envelope());
+                }
+                m_tiles.clear();
+                m_positions.clear();
+                m_ring_ends.clear();
+                for (const auto& item : area) {
+                    if (item.type() == osmium::item_type::outer_ring ||
+                        item.type() == osmium::item_type::inner_ring) {
+                        add_node_ref_list(static_cast<const osmium::NodeRefList&>(item));
+                        m_ring_ends.push_back(m_positions.size());
+                    }
+                }
+                add_inside();
+                return finish();
+            }
+
+            /**
+             * Get all tiles covered by the object. This is the tile of
+             * the location of a node, the tiles of a way or area. There
+             * are no tiles for relations and changesets.
+             *
+             * @throws osmium::invalid_location if any location is invalid.
+             */
+            const std::vector<Tile>& object(const osmium::OSMObject& object, tile_cover_mode mode = tile_cover_mode::exact) {
+                switch (object.type()) {
+                    case osmium::item_type::node:
+                        return location(static_cast<const osmium::Node&>(object).location());
+                    case osmium::item_type::way:
+                        return way(static_cast<const osmium::Way&>(object), mode);
+                    case osmium::item_type::area:
+                        return area(static_cast<const osmium::Area&>(object), mode);
+                    default:
+                        break;
+                }
+                m_tiles.clear();
+                return m_tiles;
+            }
+
+        }; // class TileCover
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_TILE_COVER_HPP
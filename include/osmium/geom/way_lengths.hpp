@@ -0,0 +1,95 @@
+#ifndef OSMIUM_GEOM_WAY_LENGTHS_HPP
+#define OSMIUM_GEOM_WAY_LENGTHS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/haversine.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace haversine {
+
+            namespace detail {
+
+                struct way_length {
+                    const osmium::Way* way;
+                    double length;
+                };
+
+            } // namespace detail
+
+            /**
+             * Calculate the lengths in meters of all ways in the buffer
+             * on the worker threads of the pool. The node locations must
+             * have been set on the ways, for instance with the
+             * NodeLocationsForWays handler. The lengths are the same as
+             * the ones from distance(way.nodes()).
+             *
+             * @param buffer The buffer with the ways. Other objects are
+             *               ignored.
+             * @param pool The thread pool to use.
+             * @returns The lengths in the order of the ways in the buffer.
+             * @throws osmium::invalid_location if a location is invalid.
+             */
+            inline std::vector<double> way_lengths(const osmium::memory::Buffer& buffer, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                std::vector<detail::way_length> ways;
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    ways.push_back(detail::way_length{&way, 0.0});
+                }
+
+                pool.parallel_for(ways, [](detail::way_length& entry) {
+                    entry.length = distance(entry.way->nodes());
+                });
+
+                std::vector<double> lengths;
+                lengths.reserve(ways.size());
+                for (const auto& entry : ways) {
+                    lengths.push_back(entry.length);
+                }
+                return lengths;
+            }
+
+        } // namespace haversine
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_WAY_LENGTHS_HPP
@@ -40,6 +40,7 @@ DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
 
 namespace osmium {
@@ -76,6 +77,24 @@ namespace osmium {
                 return out;
             }
 
+            /**
+             * Convert the binary data in str starting at offset to hex in
+             * place. No temporary string is needed for this.
+             */
+            inline void convert_to_hex_in_place(std::string& str, std::size_t offset = 0) {
+                static const char* lookup_hex = "0123456789ABCDEF";
+                const std::size_t size = str.size() - offset;
+                str.resize(offset + size * 2);
+
+                // Go backwards so that the binary data is read before it
+                // is overwritten.
+                for (std::size_t i = size; i > 0; --i) {
+                    const auto c = static_cast<unsigned int>(str[offset + i - 1]);
+                    str[offset + i * 2 - 1] = lookup_hex[ c        & 0xfU];
+                    str[offset + i * 2 - 2] = lookup_hex[(c >> 4U) & 0xfU];
+                }
+            }
+
             class WKBFactoryImpl {
 
                 /**
@@ -107,6 +126,7 @@ namespace osmium {
                 }; // enum class wkb_byte_order_type
 
                 std::string m_data;
+                std::string* m_output;
                 uint32_t m_points = 0;
                 int m_srid;
                 wkb_type m_wkb_type;
@@ -146,6 +166,31 @@ namespace osmium {
                     std::copy_n(reinterpret_cast<const char*>(&s), sizeof(uint32_t), &m_data[offset]);
                 }
 
+                // Return the geometry built in m_data or, if there is an
+                // output string, append it there. In that case m_data
+                // keeps its memory for the next geometry.
+                std::string finish() {
+                    if (m_output) {
+                        const std::size_t offset = m_output->size();
+                        m_output->append(m_data);
+                        if (m_out_type == out_type::hex) {
+                            convert_to_hex_in_place(*m_output, offset);
+                        }
+                        return std::string{};
+                    }
+
+                    std::string data;
+
+                    using std::swap;
+                    swap(data, m_data);
+
+                    if (m_out_type == out_type::hex) {
+                        convert_to_hex_in_place(data);
+                    }
+
+                    return data;
+                }
+
             public:
 
                 using point_type        = std::string;
@@ -154,7 +199,23 @@ namespace osmium {
                 using multipolygon_type = std::string;
                 using ring_type         = std::string;
 
-                explicit WKBFactoryImpl(int srid, wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary) :
+                /**
+                 * Constructor.
+                 *
+                 * @param srid The SRID of the geometries (from the
+                 *             projection).
+                 * @param wtype Create WKB or EWKB.
+                 * @param otype Create binary or hex output.
+                 * @param output If this is set, all geometries are
+                 *               appended to this string and the create
+                 *               functions return empty strings. This way
+                 *               the caller can reuse the same string for
+                 *               many geometries without any allocations
+                 *               per geometry. The string must outlive the
+                 *               factory.
+                 */
+                explicit WKBFactoryImpl(int srid, wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary, std::string* output = nullptr) :
+                    m_output(output),
                     m_srid(srid),
                     m_wkb_type(wtype),
                     m_out_type(otype) {
@@ -164,12 +225,15 @@ namespace osmium {
 
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
                     std::string data;
-                    header(data, wkbPoint, false);
-                    str_push(data, xy.x);
-                    str_push(data, xy.y);
+                    std::string& out = m_output ? *m_output : data;
+                    const std::size_t offset = out.size();
+
+                    header(out, wkbPoint, false);
+                    str_push(out, xy.x);
+                    str_push(out, xy.y);
 
                     if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
+                        convert_to_hex_in_place(out, offset);
                     }
 
                     return data;
@@ -189,16 +253,7 @@ namespace osmium {
 
                 linestring_type linestring_finish(std::size_t num_points) {
                     set_size(m_linestring_size_offset, num_points);
-                    std::string data;
-
-                    using std::swap;
-                    swap(data, m_data);
-
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    }
-
-                    return data;
+                    return finish();
                 }
 
                 /* MultiPolygon */
@@ -249,16 +304,7 @@ namespace osmium {
 
                 multipolygon_type multipolygon_finish() {
                     set_size(m_multipolygon_size_offset, m_polygons);
-                    std::string data;
-
-                    using std::swap;
-                    swap(data, m_data);
-
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    }
-
-                    return data;
+                    return finish();
                 }
 
             }; // class WKBFactoryImpl
@@ -67,6 +67,17 @@ namespace osmium {
          *
          * If you are working with changesets, implement the changeset()
          * function.
+         *
+         * Instead of node(), way(), or relation() you can also add the
+         * functions node_batch(), way_batch(), or relation_batch() to
+         * your handler. They are not defined in this class. When
+         * osmium::apply() finds them, it calls them with each run of
+         * consecutive objects of that type in a buffer as an
+         * osmium::memory::ItemIteratorRange<const osmium::Node> etc. The
+         * functions osm_object() and node() etc. are not called for
+         * these objects then. If any handler has batch functions, each
+         * handler gets a whole run of objects before the next handler
+         * sees it.
          */
         class Handler {
 
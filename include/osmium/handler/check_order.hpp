@@ -145,6 +145,27 @@ namespace osmium {
                 return m_max_relation_id;
             }
 
+            /**
+             * Take over the state of another CheckOrder handler which has
+             * seen the objects following the ones this handler has seen.
+             * This is used to combine the results of checking separate
+             * parts of the input in parallel. The caller is responsible for
+             * checking that the first object seen by the other handler is
+             * in order relative to this one.
+             */
+            void update(const CheckOrder& other) noexcept {
+                constexpr const auto unset = std::numeric_limits<osmium::object_id_type>::min();
+                if (other.m_max_node_id != unset) {
+                    m_max_node_id = other.m_max_node_id;
+                }
+                if (other.m_max_way_id != unset) {
+                    m_max_way_id = other.m_max_way_id;
+                }
+                if (other.m_max_relation_id != unset) {
+                    m_max_relation_id = other.m_max_relation_id;
+                }
+            }
+
         }; // class CheckOrder
 
     } // namespace handler
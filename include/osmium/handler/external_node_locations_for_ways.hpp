@@ -0,0 +1,278 @@
+#ifndef OSMIUM_HANDLER_EXTERNAL_NODE_LOCATIONS_FOR_WAYS_HPP
+#define OSMIUM_HANDLER_EXTERNAL_NODE_LOCATIONS_FOR_WAYS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/index/detail/external_sorter.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace osmium {
+
+    namespace handler {
+
+        namespace detail {
+
+            struct external_node_ref {
+                osmium::object_id_type id;
+                uint64_t position;
+            };
+
+            struct external_node_ref_order {
+                bool operator()(const external_node_ref& lhs, const external_node_ref& rhs) const noexcept {
+                    if (lhs.id != rhs.id) {
+                        return osmium::id_order{}(lhs.id, rhs.id);
+                    }
+                    return lhs.position < rhs.position;
+                }
+            };
+
+            struct external_location {
+                uint64_t position;
+                osmium::object_id_type id;
+                osmium::Location location;
+            };
+
+            struct external_location_order {
+                bool operator()(const external_location& lhs, const external_location& rhs) const noexcept {
+                    return lhs.position < rhs.position;
+                }
+            };
+
+        } // namespace detail
+
+        /**
+         * Handler to add node locations to ways without a random access
+         * node location index. Use this instead of NodeLocationsForWays if
+         * there is not enough memory for a location index. Instead of
+         * random accesses this needs disk space for temporary files and
+         * three passes over the data:
+         *
+         * 1. All ways are read. The node ids of all their node refs are
+         *    collected together with their position and sorted by node id
+         *    in an external sort.
+         * 2. All nodes are read, they must be ordered by id as in sorted
+         *    OSM files. They are merge-joined with the sorted node refs and
+         *    the locations found are sorted back into way order.
+         * 3. The ways are read again in the same order as in the first
+         *    pass and the locations are added to them.
+         *
+         * @code
+         * osmium::handler::ExternalNodeLocationsForWays handler;
+         * osmium::apply(way_reader1, handler);
+         * handler.start_node_pass();
+         * osmium::apply(node_reader, handler);
+         * handler.start_way_pass();
+         * osmium::apply(way_reader2, handler);
+         * @endcode
+         *
+         * Temporary files are created with tmpfile(3). About 40 bytes of
+         * disk space are needed per node ref.
+         */
+        class ExternalNodeLocationsForWays : public osmium::handler::Handler {
+
+        public:
+
+            enum class pass {
+                collect_node_refs = 0,
+                join_nodes        = 1,
+                add_locations     = 2
+            };
+
+        private:
+
+            osmium::detail::external_sorter<detail::external_node_ref, detail::external_node_ref_order> m_node_refs;
+            osmium::detail::external_sorter<detail::external_location, detail::external_location_order> m_locations;
+
+            detail::external_node_ref m_next_ref{0, 0};
+            uint64_t m_position = 0;
+            osmium::object_id_type m_last_node_id = 0;
+            pass m_pass = pass::collect_node_refs;
+            bool m_has_next_ref = false;
+            bool m_ignore_errors = false;
+
+            void next_ref() {
+                m_has_next_ref = m_node_refs.next(m_next_ref);
+            }
+
+            // Add all node refs to nodes with ids smaller than the given id
+            // (in id_order) as not found.
+            void add_missing_refs_before(const osmium::object_id_type id) {
+                while (m_has_next_ref && osmium::id_order{}(m_next_ref.id, id)) {
+                    m_locations.add(detail::external_location{m_next_ref.position, m_next_ref.id, osmium::Location{}});
+                    next_ref();
+                }
+            }
+
+            void check_pass(const pass expected, const char* function) const {
+                if (m_pass != expected) {
+                    throw std::logic_error{std::string{"ExternalNodeLocationsForWays::"} + function + "() called in wrong pass"};
+                }
+            }
+
+        public:
+
+            /**
+             * Create handler.
+             *
+             * @param memory Approximate amount of memory in bytes used for
+             *               each of the two sorts.
+             */
+            explicit ExternalNodeLocationsForWays(const std::size_t memory = 512UL * 1024UL * 1024UL) :
+                m_node_refs(memory / sizeof(detail::external_node_ref)),
+                m_locations(memory / sizeof(detail::external_location)) {
+            }
+
+            /**
+             * Do not throw an exception if the location of a node can not
+             * be found. The location of such node refs will be undefined.
+             */
+            void ignore_errors() {
+                m_ignore_errors = true;
+            }
+
+            /// The current pass.
+            pass current_pass() const noexcept {
+                return m_pass;
+            }
+
+            /// The number of node refs collected in the first pass.
+            uint64_t num_node_refs() const noexcept {
+                return m_position;
+            }
+
+            /**
+             * Call this after all ways have been read in the first pass
+             * and before reading the nodes.
+             */
+            void start_node_pass() {
+                check_pass(pass::collect_node_refs, "start_node_pass");
+                m_node_refs.finish();
+                next_ref();
+                m_pass = pass::join_nodes;
+            }
+
+            /**
+             * Call this after all nodes have been read and before reading
+             * the ways again.
+             */
+            void start_way_pass() {
+                check_pass(pass::join_nodes, "start_way_pass");
+                while (m_has_next_ref) {
+                    m_locations.add(detail::external_location{m_next_ref.position, m_next_ref.id, osmium::Location{}});
+                    next_ref();
+                }
+                m_locations.finish();
+                m_pass = pass::add_locations;
+            }
+
+            /**
+             * In the second pass: Join the node location with the node refs
+             * referring to it. Ignored in the other passes.
+             *
+             * @throws std::runtime_error if the nodes are not sorted by id.
+             */
+            void node(const osmium::Node& node) {
+                if (m_pass != pass::join_nodes) {
+                    return;
+                }
+
+                const auto id = node.id();
+                if (m_last_node_id != 0 && !osmium::id_order{}(m_last_node_id, id)) {
+                    throw std::runtime_error{"ExternalNodeLocationsForWays needs nodes sorted by id"};
+                }
+                m_last_node_id = id;
+
+                add_missing_refs_before(id);
+                while (m_has_next_ref && m_next_ref.id == id) {
+                    m_locations.add(detail::external_location{m_next_ref.position, id, node.location()});
+                    next_ref();
+                }
+            }
+
+            /**
+             * In the first pass: Collect the node refs of the way. In the
+             * third pass: Add the locations to the node refs. Ignored in
+             * the second pass.
+             *
+             * @throws osmium::not_found if a location could not be found
+             *         (unless ignore_errors() was called).
+             * @throws std::runtime_error if the ways are not in the same
+             *         order as in the first pass.
+             */
+            void way(osmium::Way& way) {
+                if (m_pass == pass::collect_node_refs) {
+                    for (const auto& node_ref : way.nodes()) {
+                        m_node_refs.add(detail::external_node_ref{node_ref.ref(), m_position++});
+                    }
+                    return;
+                }
+
+                if (m_pass != pass::add_locations) {
+                    return;
+                }
+
+                bool error = false;
+                detail::external_location location{0, 0, osmium::Location{}};
+                for (auto& node_ref : way.nodes()) {
+                    if (!m_locations.next(location) || location.id != node_ref.ref()) {
+                        throw std::runtime_error{"ExternalNodeLocationsForWays needs the ways in the same order in the first and third pass"};
+                    }
+                    node_ref.set_location(location.location);
+                    if (!location.location) {
+                        error = true;
+                    }
+                }
+                if (!m_ignore_errors && error) {
+                    throw osmium::not_found{"location for one or more nodes not found"};
+                }
+            }
+
+        }; // class ExternalNodeLocationsForWays
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_EXTERNAL_NODE_LOCATIONS_FOR_WAYS_HPP
@@ -0,0 +1,359 @@
+#ifndef OSMIUM_HANDLER_ID_RENUMBER_HPP
+#define OSMIUM_HANDLER_ID_RENUMBER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/hilbert.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/map/mapped_file_map.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * The order in which the IdRenumber handler assigns the new ids.
+         */
+        enum class renumber_order {
+
+            /// All objects in the order they appear in the input.
+            input = 0,
+
+            /**
+             * Nodes in the order in which they are first referenced from
+             * ways, nodes not referenced from any way after them. Ways
+             * and relations in input order.
+             */
+            first_reference = 1,
+
+            /**
+             * Nodes in the order of their locations along a Hilbert
+             * curve, ways in the order of the new id of their first
+             * node. Relations in input order.
+             */
+            hilbert = 2
+
+        }; // enum class renumber_order
+
+        /**
+         * Renumbers the ids of all nodes, ways, and relations starting
+         * from 1 for each type so that objects which are close together
+         * (depending on the renumber_order) get ids close together. This
+         * improves locality of lookups in indexes later. References from
+         * ways and relations are changed accordingly. Objects referenced
+         * but not in the input get new ids after all other objects of
+         * their type.
+         *
+         * This needs two passes over the input: In the first pass use
+         * this as a handler, then call prepare(). In the second pass call
+         * renumber() on all buffers and write them out. The
+         * renumber_file() function does all of this. The output has the
+         * same order as the input, so it isn't sorted by id any more
+         * unless the renumber_order is input.
+         *
+         * The mappings from old to new ids are kept in memory and can
+         * be written to files with write_maps().
+         *
+         * Note: Ids are handled by their absolute value, so the input
+         *       must not contain an id and its negation for the same
+         *       object type. All new ids are positive.
+         */
+        class IdRenumber : public osmium::handler::Handler {
+
+        public:
+
+            using id_map_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+
+        private:
+
+            using id_set_type = osmium::index::IdSetDense<osmium::unsigned_object_id_type>;
+
+            // Sort key and old id for each object in the first pass.
+            using entry_type = std::pair<uint64_t, osmium::unsigned_object_id_type>;
+
+            renumber_order m_order;
+
+            std::vector<entry_type> m_nodes;
+            std::vector<entry_type> m_ways;
+            std::vector<entry_type> m_relations;
+
+            // Nodes in the order they are first referenced by ways. Only
+            // used for renumber_order::first_reference.
+            std::vector<osmium::unsigned_object_id_type> m_node_ref_order;
+
+            id_set_type m_referenced_nodes;
+            id_set_type m_referenced_ways;
+            id_set_type m_referenced_relations;
+
+            id_map_type m_node_map;
+            id_map_type m_way_map;
+            id_map_type m_relation_map;
+
+            // Assign new ids to the old ids in the order of the entries,
+            // then to the referenced ids not yet assigned.
+            static void build_map(id_map_type& map, const std::vector<osmium::unsigned_object_id_type>& first_ids, const std::vector<entry_type>& entries, const id_set_type& referenced) {
+                id_set_type assigned;
+                osmium::unsigned_object_id_type next_id = 1;
+                const auto assign = [&](const osmium::unsigned_object_id_type old_id) {
+                    if (assigned.check_and_set(old_id)) {
+                        map.set(old_id, next_id++);
+                    }
+                };
+
+                for (const auto id : first_ids) {
+                    assign(id);
+                }
+                for (const auto& entry : entries) {
+                    assign(entry.second);
+                }
+                for (const auto id : referenced) {
+                    assign(id);
+                }
+                map.sort();
+            }
+
+            static void sort_by_key(std::vector<entry_type>& entries) {
+                std::stable_sort(entries.begin(), entries.end(), [](const entry_type& a, const entry_type& b) {
+                    return a.first < b.first;
+                });
+            }
+
+            template <typename T>
+            static void free_vector(std::vector<T>& vector) {
+                std::vector<T>{}.swap(vector);
+            }
+
+            static osmium::object_id_type lookup(const id_map_type& map, const osmium::object_id_type old_id) {
+                return static_cast<osmium::object_id_type>(map.get(static_cast<osmium::unsigned_object_id_type>(old_id < 0 ? -old_id : old_id)));
+            }
+
+        public:
+
+            explicit IdRenumber(const renumber_order order = renumber_order::input) :
+                m_order(order) {
+            }
+
+            renumber_order order() const noexcept {
+                return m_order;
+            }
+
+            void node(const osmium::Node& node) {
+                const uint64_t key = m_order == renumber_order::hilbert ? osmium::geom::hilbert_index(node.location()) : 0;
+                m_nodes.emplace_back(key, node.positive_id());
+            }
+
+            void way(const osmium::Way& way) {
+                uint64_t key = 0;
+                if (m_order == renumber_order::hilbert && !way.nodes().empty()) {
+                    // Replaced by the new id of the node in prepare().
+                    key = way.nodes().front().positive_ref();
+                }
+                m_ways.emplace_back(key, way.positive_id());
+
+                for (const auto& node_ref : way.nodes()) {
+                    if (m_referenced_nodes.check_and_set(node_ref.positive_ref()) && m_order == renumber_order::first_reference) {
+                        m_node_ref_order.push_back(node_ref.positive_ref());
+                    }
+                }
+            }
+
+            void relation(const osmium::Relation& relation) {
+                m_relations.emplace_back(0, relation.positive_id());
+
+                for (const auto& member : relation.members()) {
+                    switch (member.type()) {
+                        case osmium::item_type::node:
+                            m_referenced_nodes.set(member.positive_ref());
+                            break;
+                        case osmium::item_type::way:
+                            m_referenced_ways.set(member.positive_ref());
+                            break;
+                        case osmium::item_type::relation:
+                            m_referenced_relations.set(member.positive_ref());
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+
+            /**
+             * Assign the new ids. Call this after the first pass and
+             * before calling renumber(). Frees all memory used in the
+             * first pass.
+             */
+            void prepare() {
+                if (m_order == renumber_order::hilbert) {
+                    sort_by_key(m_nodes);
+                }
+                build_map(m_node_map, m_node_ref_order, m_nodes, m_referenced_nodes);
+                free_vector(m_node_ref_order);
+                free_vector(m_nodes);
+                m_referenced_nodes.clear();
+
+                if (m_order == renumber_order::hilbert) {
+                    for (auto& entry : m_ways) {
+                        const auto new_id = m_node_map.get_noexcept(entry.first);
+                        entry.first = new_id == osmium::index::empty_value<osmium::unsigned_object_id_type>() ? std::numeric_limits<uint64_t>::max() : new_id;
+                    }
+                    sort_by_key(m_ways);
+                }
+                build_map(m_way_map, {}, m_ways, m_referenced_ways);
+                free_vector(m_ways);
+                m_referenced_ways.clear();
+
+                build_map(m_relation_map, {}, m_relations, m_referenced_relations);
+                free_vector(m_relations);
+                m_referenced_relations.clear();
+            }
+
+            /**
+             * Get the new id for an object.
+             *
+             * @pre prepare() was called.
+             * @throws osmium::not_found If the object wasn't seen in the
+             *         first pass.
+             */
+            osmium::object_id_type new_id(const osmium::item_type type, const osmium::object_id_type old_id) const {
+                switch (type) {
+                    case osmium::item_type::node:
+                        return lookup(m_node_map, old_id);
+                    case osmium::item_type::way:
+                        return lookup(m_way_map, old_id);
+                    case osmium::item_type::relation:
+                        return lookup(m_relation_map, old_id);
+                    default:
+                        break;
+                }
+                return old_id;
+            }
+
+            /**
+             * Change the ids of all objects in the buffer and the ids
+             * they reference to the new ids.
+             *
+             * @pre prepare() was called.
+             * @throws osmium::not_found If an object or reference wasn't
+             *         seen in the first pass.
+             */
+            void renumber(osmium::memory::Buffer& buffer) const {
+                for (auto& object : buffer.select<osmium::OSMObject>()) {
+                    object.set_id(new_id(object.type(), object.id()));
+                    if (object.type() == osmium::item_type::way) {
+                        for (auto& node_ref : static_cast<osmium::Way&>(object).nodes()) {
+                            node_ref.set_ref(lookup(m_node_map, node_ref.ref()));
+                        }
+                    } else if (object.type() == osmium::item_type::relation) {
+                        for (auto& member : static_cast<osmium::Relation&>(object).members()) {
+                            member.set_ref(new_id(member.type(), member.ref()));
+                        }
+                    }
+                }
+            }
+
+            /// The map from old to new node ids.
+            const id_map_type& node_map() const noexcept {
+                return m_node_map;
+            }
+
+            /// The map from old to new way ids.
+            const id_map_type& way_map() const noexcept {
+                return m_way_map;
+            }
+
+            /// The map from old to new relation ids.
+            const id_map_type& relation_map() const noexcept {
+                return m_relation_map;
+            }
+
+            /**
+             * Write the maps from old to new ids into map files which can
+             * be opened with osmium::index::map::MappedFileMap.
+             *
+             * @pre prepare() was called.
+             * @throws std::system_error If a file could not be written.
+             */
+            void write_maps(const int node_fd, const int way_fd, const int relation_fd) const {
+                osmium::index::write_map_file(node_fd, m_node_map);
+                osmium::index::write_map_file(way_fd, m_way_map);
+                osmium::index::write_map_file(relation_fd, m_relation_map);
+            }
+
+            /**
+             * Renumber the input file writing the result to the writer.
+             * This reads the input twice, once as the first pass, then
+             * again renumbering all buffers. The writer is not closed.
+             */
+            void renumber_file(const osmium::io::File& input, osmium::io::Writer& writer) {
+                {
+                    osmium::io::Reader reader{input};
+                    osmium::apply(reader, *this);
+                    reader.close();
+                }
+
+                prepare();
+
+                osmium::io::Reader reader{input};
+                while (osmium::memory::Buffer buffer = reader.read()) {
+                    renumber(buffer);
+                    writer(std::move(buffer));
+                }
+                reader.close();
+            }
+
+        }; // class IdRenumber
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_ID_RENUMBER_HPP
@@ -0,0 +1,225 @@
+#ifndef OSMIUM_HANDLER_MULTI_EXTRACT_HPP
+#define OSMIUM_HANDLER_MULTI_EXTRACT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/polygon_index.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * Handler creating many extracts in a single pass over the input.
+         * Each extract is defined by a polygon (see
+         * osmium::geom::ExtractPolygon). The polygons are put into an
+         * osmium::geom::PolygonIndex, so the work needed for each node
+         * doesn't grow with the number of extracts.
+         *
+         * This implements the "simple" extract strategy: An extract
+         * contains
+         * - all nodes inside its polygon,
+         * - all ways with at least one of those nodes,
+         * - all relations with at least one of those nodes or ways or a
+         *   relation already in the extract as member.
+         *
+         * Ways and relations can be incomplete, ie. reference objects that
+         * are not in the extract. The input must be sorted in the usual
+         * order (nodes, then ways, then relations). Relations are only
+         * found through relation members that came earlier in the input.
+         *
+         * The objects of each extract are written to a Writer. Writers
+         * buffer the objects and encode the data in their own threads, so
+         * all extracts are written at the same time. The Writers are not
+         * closed by this handler.
+         *
+         * The ids of the objects in each extract are tracked in IdSets
+         * which can be accessed after the run. Negative ids are stored
+         * with their absolute value.
+         */
+        class MultiExtract : public osmium::handler::Handler {
+
+            using id_set_type = osmium::index::IdSetDense<osmium::unsigned_object_id_type>;
+
+            struct extract_data {
+                osmium::io::Writer* writer;
+                id_set_type nodes;
+                id_set_type ways;
+                id_set_type relations;
+
+                explicit extract_data(osmium::io::Writer* w) noexcept :
+                    writer(w) {
+                }
+            }; // struct extract_data
+
+            osmium::geom::PolygonIndex m_index;
+            std::vector<extract_data> m_extracts;
+
+            static void write(extract_data& extract, const osmium::OSMObject& object) {
+                if (extract.writer) {
+                    (*extract.writer)(object);
+                }
+            }
+
+            bool has_member(const extract_data& extract, const osmium::RelationMember& member) const noexcept {
+                const auto id = member.positive_ref();
+                switch (member.type()) {
+                    case osmium::item_type::node:
+                        return extract.nodes.get(id);
+                    case osmium::item_type::way:
+                        return extract.ways.get(id);
+                    case osmium::item_type::relation:
+                        return extract.relations.get(id);
+                    default:
+                        break;
+                }
+                return false;
+            }
+
+        public:
+
+            /**
+             * Create a MultiExtract handler.
+             *
+             * @param polygons The polygons of the extracts.
+             * @param writers One Writer for each polygon. A writer can be
+             *                nullptr, in that case only the ids of the
+             *                objects in the extract are collected.
+             * @param resolution Resolution of the grid in the
+             *                   PolygonIndex.
+             *
+             * @throws std::invalid_argument if the numbers of polygons and
+             *         writers differ.
+             */
+            MultiExtract(std::vector<osmium::geom::ExtractPolygon> polygons, const std::vector<osmium::io::Writer*>& writers, uint32_t resolution = 256) :
+                m_index(std::move(polygons), resolution) {
+                if (m_index.size() != writers.size()) {
+                    throw std::invalid_argument{"need the same number of polygons and writers"};
+                }
+                m_extracts.reserve(writers.size());
+                for (auto* writer : writers) {
+                    m_extracts.emplace_back(writer);
+                }
+            }
+
+            /**
+             * The number of extracts.
+             */
+            std::size_t size() const noexcept {
+                return m_extracts.size();
+            }
+
+            void node(const osmium::Node& node) {
+                m_index.for_each_containing(node.location(), [this, &node](std::size_t n) {
+                    auto& extract = m_extracts[n];
+                    extract.nodes.set(node.positive_id());
+                    write(extract, node);
+                });
+            }
+
+            void way(const osmium::Way& way) {
+                for (auto& extract : m_extracts) {
+                    for (const auto& node_ref : way.nodes()) {
+                        if (extract.nodes.get(node_ref.positive_ref())) {
+                            extract.ways.set(way.positive_id());
+                            write(extract, way);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            void relation(const osmium::Relation& relation) {
+                for (auto& extract : m_extracts) {
+                    for (const auto& member : relation.members()) {
+                        if (has_member(extract, member)) {
+                            extract.relations.set(relation.positive_id());
+                            write(extract, relation);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            /**
+             * The ids of the nodes in extract n.
+             *
+             * @pre @code n < size() @endcode
+             */
+            const id_set_type& node_ids(std::size_t n) const noexcept {
+                assert(n < m_extracts.size());
+                return m_extracts[n].nodes;
+            }
+
+            /**
+             * The ids of the ways in extract n.
+             *
+             * @pre @code n < size() @endcode
+             */
+            const id_set_type& way_ids(std::size_t n) const noexcept {
+                assert(n < m_extracts.size());
+                return m_extracts[n].ways;
+            }
+
+            /**
+             * The ids of the relations in extract n.
+             *
+             * @pre @code n < size() @endcode
+             */
+            const id_set_type& relation_ids(std::size_t n) const noexcept {
+                assert(n < m_extracts.size());
+                return m_extracts[n].relations;
+            }
+
+        }; // class MultiExtract
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_MULTI_EXTRACT_HPP
@@ -39,12 +39,18 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/node_locations_map.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
+#include <osmium/osm/node_locations_block.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -52,13 +58,101 @@ namespace osmium {
 
         using dummy_type = osmium::index::map::Dummy<osmium::unsigned_object_id_type, osmium::Location>;
 
+        namespace detail {
+
+            /**
+             * Small open addressing hash map from (the absolute value of)
+             * negative node ids to locations. Used by the NodeLocationsForWays
+             * handler if no index for negative ids was given. Negative ids
+             * are rare, usually only found in files created by editors, so
+             * this is optimized for a small number of entries. It doesn't
+             * allocate any memory until the first id is stored.
+             */
+            class NegativeIdLocations {
+
+                // Id 0 is never negative, so it marks unused slots.
+                using entry_type = std::pair<osmium::unsigned_object_id_type, osmium::Location>;
+
+                enum : std::size_t {
+                    min_capacity = 16
+                };
+
+                std::vector<entry_type> m_entries;
+                std::size_t m_size = 0;
+
+                std::size_t slot(const osmium::unsigned_object_id_type id) const noexcept {
+                    // Fibonacci hashing, capacity is always a power of 2.
+                    return static_cast<std::size_t>(static_cast<uint64_t>(id) * 0x9e3779b97f4a7c15ULL >> 32U) & (m_entries.size() - 1);
+                }
+
+                void insert(const osmium::unsigned_object_id_type id, const osmium::Location location) {
+                    std::size_t n = slot(id);
+                    while (m_entries[n].first != 0 && m_entries[n].first != id) {
+                        n = (n + 1) & (m_entries.size() - 1);
+                    }
+                    if (m_entries[n].first == 0) {
+                        ++m_size;
+                    }
+                    m_entries[n] = entry_type{id, location};
+                }
+
+                void grow() {
+                    std::vector<entry_type> old_entries(m_entries.empty() ? std::size_t(min_capacity) : m_entries.size() * 2);
+                    swap(old_entries, m_entries);
+                    m_size = 0;
+                    for (const auto& entry : old_entries) {
+                        if (entry.first != 0) {
+                            insert(entry.first, entry.second);
+                        }
+                    }
+                }
+
+            public:
+
+                std::size_t size() const noexcept {
+                    return m_size;
+                }
+
+                void set(const osmium::unsigned_object_id_type id, const osmium::Location location) {
+                    // Keep the load factor at 50% at most.
+                    if ((m_size + 1) * 2 > m_entries.size()) {
+                        grow();
+                    }
+                    insert(id, location);
+                }
+
+                osmium::Location get_noexcept(const osmium::unsigned_object_id_type id) const noexcept {
+                    if (m_size == 0) {
+                        return osmium::Location{};
+                    }
+                    for (std::size_t n = slot(id); m_entries[n].first != 0; n = (n + 1) & (m_entries.size() - 1)) {
+                        if (m_entries[n].first == id) {
+                            return m_entries[n].second;
+                        }
+                    }
+                    return osmium::Location{};
+                }
+
+                void clear() {
+                    m_entries.clear();
+                    m_entries.shrink_to_fit();
+                    m_size = 0;
+                }
+
+            }; // class NegativeIdLocations
+
+        } // namespace detail
+
         /**
          * Handler to retrieve locations from nodes and add them to ways.
          *
          * @tparam TStoragePosIDs Class that handles the actual storage of the node locations
          *                        (for positive IDs). It must support the set(id, value) and
          *                        get(id) methods.
-         * @tparam TStorageNegIDs Same but for negative IDs.
+         * @tparam TStorageNegIDs Same but for negative IDs. If this is the
+         *                        default dummy_type, locations of nodes
+         *                        with negative IDs are kept in a small
+         *                        internal hash map.
          */
         template <typename TStoragePosIDs, typename TStorageNegIDs = dummy_type>
         class NodeLocationsForWays : public osmium::handler::Handler {
@@ -74,6 +168,17 @@ namespace osmium {
             using index_pos_type = TStoragePosIDs;
             using index_neg_type = TStorageNegIDs;
 
+            /**
+             * Scratch space for the batched lookups in add_locations().
+             * It is kept between calls so it doesn't have to be allocated
+             * for every way.
+             */
+            struct lookup_buffers {
+                std::vector<osmium::unsigned_object_id_type> ids;
+                std::vector<osmium::Location> locations;
+                std::vector<osmium::NodeRef*> node_refs;
+            };
+
         private:
 
             /// Object that handles the actual storage of the node locations (with positive IDs).
@@ -82,12 +187,76 @@ namespace osmium {
             /// Object that handles the actual storage of the node locations (with negative IDs).
             TStorageNegIDs& m_storage_neg;
 
+            /// Storage for negative IDs if no index was given for them.
+            detail::NegativeIdLocations m_negative_locations;
+
             osmium::unsigned_object_id_type m_last_id = 0;
 
             bool m_ignore_errors = false;
 
             bool m_must_sort = false;
 
+            bool m_keep_existing_locations = false;
+
+            // Access hint last given to the indexes.
+            osmium::MemoryMapping::access_hint m_access_hint = osmium::MemoryMapping::access_hint::normal;
+
+            // Buffers for the batched lookups of positive ids in way().
+            lookup_buffers m_lookup_buffers;
+
+            // Store the locations of the nodes with the positive ids
+            // ids[begin] to ids[end - 1] in the storage.
+            void store_positive_run(const std::vector<osmium::object_id_type>& ids,
+                                    const std::vector<osmium::Location>& locations,
+                                    std::size_t begin,
+                                    std::size_t end) {
+                if (begin < end) {
+                    // Signed and unsigned variants of the same type can
+                    // alias each other and the ids are all positive.
+                    m_storage_pos.set_many(reinterpret_cast<const osmium::unsigned_object_id_type*>(ids.data() + begin),
+                                           locations.data() + begin,
+                                           end - begin);
+                }
+            }
+
+            using use_internal_neg = std::is_same<TStorageNegIDs, dummy_type>;
+
+            void set_negative(const osmium::unsigned_object_id_type id, const osmium::Location location, std::true_type /*internal*/) {
+                m_negative_locations.set(id, location);
+            }
+
+            void set_negative(const osmium::unsigned_object_id_type id, const osmium::Location location, std::false_type /*internal*/) {
+                m_storage_neg.set(id, location);
+            }
+
+            osmium::Location get_negative(const osmium::unsigned_object_id_type id, std::true_type /*internal*/) const noexcept {
+                return m_negative_locations.get_noexcept(id);
+            }
+
+            osmium::Location get_negative(const osmium::unsigned_object_id_type id, std::false_type /*internal*/) const {
+                return m_storage_neg.get_noexcept(id);
+            }
+
+            // Tell the indexes how they will be accessed from now on.
+            // Nodes usually come sorted by id and fill the indexes
+            // sequentially, the lookups for the ways are random.
+            void set_access_hint(const osmium::MemoryMapping::access_hint hint) {
+                if (m_access_hint != hint) {
+                    m_access_hint = hint;
+                    m_storage_pos.set_access_hint(hint);
+                    m_storage_neg.set_access_hint(hint);
+                }
+            }
+
+            // Called for each node. Only switches to sequential access
+            // before the first way, so files with nodes after ways don't
+            // toggle the hints all the time.
+            void start_node_phase() {
+                if (m_access_hint == osmium::MemoryMapping::access_hint::normal) {
+                    set_access_hint(osmium::MemoryMapping::access_hint::sequential);
+                }
+            }
+
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
             static dummy_type& get_dummy() {
@@ -115,10 +284,35 @@ namespace osmium {
                 m_ignore_errors = true;
             }
 
+            /**
+             * Do not look up the locations of node refs in ways which
+             * already have a valid location. This is useful when reading
+             * files with locations on ways: Only ways without locations
+             * need the node location index then.
+             */
+            void keep_existing_locations() {
+                m_keep_existing_locations = true;
+            }
+
+            /**
+             * Prepare the index for positive ids for the given number of
+             * nodes with ids up to max_id, for instance from the object
+             * counts in the file header (see
+             * osmium::io::Header::object_count()). This avoids regrowing
+             * the index while the nodes are read. Does nothing if the
+             * count is unknown (0).
+             */
+            void presize(const std::size_t count, const osmium::object_id_type max_id) {
+                if (count > 0 && max_id > 0) {
+                    m_storage_pos.presize(count, static_cast<osmium::unsigned_object_id_type>(max_id));
+                }
+            }
+
             /**
              * Store the location of the node in the storage.
              */
             void node(const osmium::Node& node) {
+                start_node_phase();
                 if (node.positive_id() < m_last_id) {
                     m_must_sort = true;
                 }
@@ -128,10 +322,40 @@ namespace osmium {
                 if (id >= 0) {
                     m_storage_pos.set(static_cast<osmium::unsigned_object_id_type>( id), node.location());
                 } else {
-                    m_storage_neg.set(static_cast<osmium::unsigned_object_id_type>(-id), node.location());
+                    set_negative(static_cast<osmium::unsigned_object_id_type>(-id), node.location(), use_internal_neg{});
                 }
             }
 
+            /**
+             * Store the locations of all nodes in the block in the storage.
+             * This is the same as calling node() for all nodes in the
+             * block, but it only looks at the id and location arrays and
+             * stores the locations of consecutive nodes with positive ids
+             * with one set_many() call on the index.
+             */
+            void node_locations(const osmium::NodeLocationsBlock& block) {
+                const auto& ids = block.ids();
+                const auto& locations = block.locations();
+
+                start_node_phase();
+                std::size_t run_start = 0;
+                for (std::size_t i = 0; i < ids.size(); ++i) {
+                    const auto id = ids[i];
+                    const auto positive_id = static_cast<osmium::unsigned_object_id_type>(id < 0 ? -id : id);
+                    if (positive_id < m_last_id) {
+                        m_must_sort = true;
+                    }
+                    m_last_id = positive_id;
+
+                    if (id < 0) {
+                        store_positive_run(ids, locations, run_start, i);
+                        set_negative(positive_id, locations[i], use_internal_neg{});
+                        run_start = i + 1;
+                    }
+                }
+                store_positive_run(ids, locations, run_start, ids.size());
+            }
+
             /**
              * Get location of node with given id.
              */
@@ -139,24 +363,60 @@ namespace osmium {
                 if (id >= 0) {
                     return m_storage_pos.get_noexcept(static_cast<osmium::unsigned_object_id_type>(id));
                 }
-                return m_storage_neg.get_noexcept(static_cast<osmium::unsigned_object_id_type>(-id));
+                return get_negative(static_cast<osmium::unsigned_object_id_type>(-id), use_internal_neg{});
             }
 
             /**
-             * Retrieve locations of all nodes in the way from storage and add
-             * them to the way object.
+             * Get the indexes ready for lookups: Sort them if the nodes
+             * didn't come in order and tell them about the random access.
+             * This is called by way(), call it yourself before using
+             * add_locations() from several threads.
              */
-            void way(osmium::Way& way) {
+            void prepare_for_lookups() {
                 if (m_must_sort) {
                     m_storage_pos.sort();
                     m_storage_neg.sort();
                     m_must_sort = false;
                     m_last_id = std::numeric_limits<osmium::unsigned_object_id_type>::max();
                 }
+                set_access_hint(osmium::MemoryMapping::access_hint::random);
+            }
+
+            /**
+             * Retrieve locations of all nodes in the way from storage and
+             * add them to the way object using the scratch space given.
+             *
+             * This only reads from the indexes, so after a call to
+             * prepare_for_lookups() it can be called from several threads
+             * at the same time, each with its own lookup_buffers, as long
+             * as no node locations are stored.
+             *
+             * @throws osmium::not_found if a location is missing and
+             *         ignore_errors() wasn't called.
+             */
+            void add_locations(osmium::Way& way, lookup_buffers& buffers) const {
                 bool error = false;
+                buffers.ids.clear();
+                buffers.node_refs.clear();
                 for (auto& node_ref : way.nodes()) {
-                    node_ref.set_location(get_node_location(node_ref.ref()));
-                    if (!node_ref.location()) {
+                    if (m_keep_existing_locations && node_ref.location().valid()) {
+                        continue;
+                    }
+                    if (node_ref.ref() >= 0) {
+                        buffers.ids.push_back(static_cast<osmium::unsigned_object_id_type>(node_ref.ref()));
+                        buffers.node_refs.push_back(&node_ref);
+                    } else {
+                        node_ref.set_location(get_node_location(node_ref.ref()));
+                        if (!node_ref.location()) {
+                            error = true;
+                        }
+                    }
+                }
+                buffers.locations.resize(buffers.ids.size());
+                m_storage_pos.get_many(buffers.ids.data(), buffers.locations.data(), buffers.ids.size());
+                for (std::size_t i = 0; i < buffers.node_refs.size(); ++i) {
+                    buffers.node_refs[i]->set_location(buffers.locations[i]);
+                    if (!buffers.locations[i]) {
                         error = true;
                     }
                 }
@@ -165,6 +425,19 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Retrieve locations of all nodes in the way from storage and add
+             * them to the way object.
+             *
+             * The locations for positive ids are looked up with a single
+             * get_many() call on the index, which allows the index to
+             * prefetch the memory.
+             */
+            void way(osmium::Way& way) {
+                prepare_for_lookups();
+                add_locations(way, m_lookup_buffers);
+            }
+
             /**
              * Call clear on the location indexes. Makes the
              * NodeLocationsForWays handler unusable. Used to explicitly free
@@ -173,6 +446,7 @@ namespace osmium {
             void clear() {
                 m_storage_pos.clear();
                 m_storage_neg.clear();
+                m_negative_locations.clear();
             }
 
         }; // class NodeLocationsForWays
@@ -0,0 +1,140 @@
+#ifndef OSMIUM_HANDLER_PARALLEL_CHECK_ORDER_HPP
+#define OSMIUM_HANDLER_PARALLEL_CHECK_ORDER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler/check_order.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace osmium {
+
+    namespace handler {
+
+        namespace detail {
+
+            inline void check_object_order(CheckOrder& check_order, const osmium::OSMObject& object) {
+                switch (object.type()) {
+                    case osmium::item_type::node:
+                        check_order.node(static_cast<const osmium::Node&>(object));
+                        break;
+                    case osmium::item_type::way:
+                        check_order.way(static_cast<const osmium::Way&>(object));
+                        break;
+                    case osmium::item_type::relation:
+                        check_order.relation(static_cast<const osmium::Relation&>(object));
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            inline CheckOrder check_buffer_order(const osmium::memory::Buffer& buffer) {
+                CheckOrder check_order;
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    check_object_order(check_order, object);
+                }
+                return check_order;
+            }
+
+        } // namespace detail
+
+        /**
+         * Check that the objects from the source are ordered correctly
+         * (see the CheckOrder class for what that means). The buffers are
+         * checked in parallel using the thread pool, the boundaries between
+         * the buffers are checked in order when the results come in.
+         *
+         * @tparam TSource Source of buffers, usually an osmium::io::Reader.
+         * @param source The source. Its read() function is called until it
+         *               returns an invalid buffer.
+         * @param pool The thread pool to use.
+         * @returns CheckOrder handler with the state after all objects.
+         * @throws out_of_order_error If the input is not in order. This is
+         *         always the first error in input order.
+         */
+        template <typename TSource>
+        CheckOrder check_order_parallel(TSource& source, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            using buffer_ptr = std::shared_ptr<osmium::memory::Buffer>;
+
+            CheckOrder check_order;
+            std::deque<std::pair<buffer_ptr, std::future<CheckOrder>>> pending;
+            const std::size_t max_pending = static_cast<std::size_t>(pool.num_threads()) * 2;
+
+            const auto finish_one = [&]() {
+                auto& front = pending.front();
+
+                // Check the boundary first, so that the error reported is
+                // always the first one in the input.
+                const auto objects = front.first->select<osmium::OSMObject>();
+                if (objects.begin() != objects.end()) {
+                    detail::check_object_order(check_order, *objects.begin());
+                }
+                check_order.update(front.second.get());
+                pending.pop_front();
+            };
+
+            while (auto buffer = source.read()) {
+                const buffer_ptr ptr = std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+                auto future = pool.submit([ptr]() {
+                    return detail::check_buffer_order(*ptr);
+                });
+                pending.emplace_back(ptr, std::move(future));
+                if (pending.size() > max_pending) {
+                    finish_one();
+                }
+            }
+
+            while (!pending.empty()) {
+                finish_one();
+            }
+
+            return check_order;
+        }
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_PARALLEL_CHECK_ORDER_HPP
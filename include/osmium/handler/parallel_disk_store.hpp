@@ -0,0 +1,230 @@
+#ifndef OSMIUM_HANDLER_PARALLEL_DISK_STORE_HPP
+#define OSMIUM_HANDLER_PARALLEL_DISK_STORE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * Writes OSM data in the Osmium-internal serialized format to disk
+         * like the DiskStore handler, but does the work in a thread pool.
+         * For each buffer a range of the data file is reserved (in the
+         * order of the calls), then a pool thread writes the buffer there
+         * with pwrite(2) and collects the offsets of the objects in its
+         * own segment. The segments are merged into the indexes given to
+         * the constructor in close(). The data file is the same as the
+         * one the DiskStore would write.
+         *
+         * The call operator can be called from several threads at the
+         * same time.
+         *
+         * Note: This handler will only work if either all object IDs are
+         *       positive or all object IDs are negative.
+         *
+         * Note: Not available on Windows, because there is no pwrite(2).
+         */
+        class ParallelDiskStore {
+
+            using offset_index_type = osmium::index::map::Map<unsigned_object_id_type, std::size_t>;
+            using element_type = std::pair<unsigned_object_id_type, std::size_t>;
+
+            // Offsets of the objects in one buffer.
+            struct segment {
+                std::vector<element_type> nodes;
+                std::vector<element_type> ways;
+                std::vector<element_type> relations;
+            }; // struct segment
+
+            struct write_task {
+
+                int fd;
+                std::size_t offset;
+                std::shared_ptr<const osmium::memory::Buffer> buffer;
+
+                segment operator()() const {
+                    osmium::io::detail::reliable_pwrite(fd, buffer->data(), buffer->committed(), offset);
+
+                    segment result;
+                    for (const auto& item : *buffer) {
+                        const auto item_offset = offset + static_cast<std::size_t>(item.data() - buffer->data());
+                        switch (item.type()) {
+                            case osmium::item_type::node:
+                                result.nodes.emplace_back(static_cast<const osmium::OSMObject&>(item).positive_id(), item_offset);
+                                break;
+                            case osmium::item_type::way:
+                                result.ways.emplace_back(static_cast<const osmium::OSMObject&>(item).positive_id(), item_offset);
+                                break;
+                            case osmium::item_type::relation:
+                                result.relations.emplace_back(static_cast<const osmium::OSMObject&>(item).positive_id(), item_offset);
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                    return result;
+                }
+
+            }; // struct write_task
+
+            int m_data_fd;
+
+            offset_index_type& m_node_index;
+            offset_index_type& m_way_index;
+            offset_index_type& m_relation_index;
+
+            osmium::thread::Pool& m_pool;
+            std::size_t m_max_in_flight;
+
+            std::atomic<std::size_t> m_offset{0};
+
+            std::mutex m_mutex;
+            std::deque<std::future<segment>> m_futures;
+            std::vector<segment> m_segments;
+
+            static void merge(offset_index_type& index, const std::vector<element_type>& elements) {
+                for (const auto& element : elements) {
+                    index.set(element.first, element.second);
+                }
+            }
+
+        public:
+
+            /**
+             * @param data_fd File descriptor of the data file. It must
+             *                support pwrite(2), so it can't be a pipe.
+             * @param node_index Index for the offsets of the nodes.
+             * @param way_index Index for the offsets of the ways.
+             * @param relation_index Index for the offsets of the relations.
+             * @param pool Thread pool used for writing.
+             */
+            ParallelDiskStore(int data_fd, offset_index_type& node_index, offset_index_type& way_index, offset_index_type& relation_index, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) :
+                m_data_fd(data_fd),
+                m_node_index(node_index),
+                m_way_index(way_index),
+                m_relation_index(relation_index),
+                m_pool(pool),
+                m_max_in_flight(static_cast<std::size_t>(pool.num_threads()) * 2) {
+            }
+
+            ParallelDiskStore(const ParallelDiskStore&) = delete;
+            ParallelDiskStore& operator=(const ParallelDiskStore&) = delete;
+
+            ParallelDiskStore(ParallelDiskStore&&) = delete;
+            ParallelDiskStore& operator=(ParallelDiskStore&&) = delete;
+
+            ~ParallelDiskStore() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Write the buffer to the data file. The work is done in the
+             * thread pool, this only blocks if too many buffers are in
+             * flight already.
+             *
+             * @throws std::system_error If there was an error writing an
+             *         earlier buffer.
+             */
+            void operator()(osmium::memory::Buffer&& buffer) {
+                const std::size_t size = buffer.committed();
+                const std::size_t offset = m_offset.fetch_add(size);
+                write_task task{m_data_fd, offset, std::make_shared<const osmium::memory::Buffer>(std::move(buffer))};
+
+                std::lock_guard<std::mutex> lock{m_mutex};
+                while (m_futures.size() >= m_max_in_flight) {
+                    auto future = std::move(m_futures.front());
+                    m_futures.pop_front();
+                    m_segments.push_back(future.get());
+                }
+                m_futures.push_back(m_pool.submit(std::move(task)));
+            }
+
+            /**
+             * The number of bytes of the data file reserved so far.
+             */
+            std::size_t size() const noexcept {
+                return m_offset;
+            }
+
+            /**
+             * Wait for all writes to finish and add the offsets of all
+             * objects to the indexes. This must be called before the
+             * indexes are used. It doesn't close the data file.
+             *
+             * @throws std::system_error If there was an error writing.
+             */
+            void close() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                while (!m_futures.empty()) {
+                    auto future = std::move(m_futures.front());
+                    m_futures.pop_front();
+                    m_segments.push_back(future.get());
+                }
+
+                for (const auto& segment : m_segments) {
+                    merge(m_node_index, segment.nodes);
+                    merge(m_way_index, segment.ways);
+                    merge(m_relation_index, segment.relations);
+                }
+                m_segments.clear();
+            }
+
+        }; // class ParallelDiskStore
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_PARALLEL_DISK_STORE_HPP
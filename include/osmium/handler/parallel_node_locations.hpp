@@ -0,0 +1,186 @@
+#ifndef OSMIUM_HANDLER_PARALLEL_NODE_LOCATIONS_HPP
+#define OSMIUM_HANDLER_PARALLEL_NODE_LOCATIONS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <type_traits>
+#include <utility>
+
+namespace osmium {
+
+    namespace handler {
+
+        namespace detail {
+
+            template <typename TStoragePosIDs, typename TStorageNegIDs>
+            class StoreNodeLocations {
+
+                osmium::memory::Buffer m_buffer;
+                TStoragePosIDs* m_storage_pos;
+                TStorageNegIDs* m_storage_neg;
+
+            public:
+
+                StoreNodeLocations(osmium::memory::Buffer&& buffer, TStoragePosIDs* storage_pos, TStorageNegIDs* storage_neg) :
+                    m_buffer(std::move(buffer)),
+                    m_storage_pos(storage_pos),
+                    m_storage_neg(storage_neg) {
+                }
+
+                void operator()() {
+                    for (const auto& node : m_buffer.select<osmium::Node>()) {
+                        const auto id = node.id();
+                        if (id >= 0) {
+                            m_storage_pos->set(static_cast<osmium::unsigned_object_id_type>( id), node.location());
+                        } else {
+                            m_storage_neg->set(static_cast<osmium::unsigned_object_id_type>(-id), node.location());
+                        }
+                    }
+                }
+
+            }; // class StoreNodeLocations
+
+        } // namespace detail
+
+        /**
+         * Stores the locations of all nodes in buffers in node location
+         * indexes using the threads of a thread pool. Each buffer is handled
+         * by one task, several buffers are handled at the same time.
+         *
+         * The indexes must support calling set() from several threads at
+         * the same time, for instance the ConcurrentDenseMmapArray. The
+         * nodes in different buffers should have different ids.
+         *
+         * After calling flush() the locations can be used, for instance with
+         * the NodeLocationsForWays handler.
+         *
+         * @tparam TStoragePosIDs Class that handles the actual storage of
+         *                        the node locations (for positive IDs).
+         * @tparam TStorageNegIDs Same but for negative IDs.
+         */
+        template <typename TStoragePosIDs, typename TStorageNegIDs = dummy_type>
+        class ParallelNodeLocations {
+
+            template <typename T>
+            using based_on_map = std::is_base_of<osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>, T>;
+
+            static_assert(based_on_map<TStoragePosIDs>::value, "Index class must be derived from osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>");
+            static_assert(based_on_map<TStorageNegIDs>::value, "Index class must be derived from osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>");
+
+            TStoragePosIDs& m_storage_pos;
+            TStorageNegIDs& m_storage_neg;
+            osmium::thread::Pool& m_pool;
+            std::deque<std::future<void>> m_futures;
+            std::size_t m_max_tasks;
+
+            static dummy_type& get_dummy() {
+                static dummy_type instance;
+                return instance;
+            }
+
+            void wait_for_oldest() {
+                auto future = std::move(m_futures.front());
+                m_futures.pop_front();
+                future.get();
+            }
+
+        public:
+
+            explicit ParallelNodeLocations(osmium::thread::Pool& pool,
+                                           TStoragePosIDs& storage_pos,
+                                           TStorageNegIDs& storage_neg = get_dummy()) :
+                m_storage_pos(storage_pos),
+                m_storage_neg(storage_neg),
+                m_pool(pool),
+                m_max_tasks(static_cast<std::size_t>(pool.num_threads()) * 2) {
+            }
+
+            ParallelNodeLocations(const ParallelNodeLocations&) = delete;
+            ParallelNodeLocations& operator=(const ParallelNodeLocations&) = delete;
+
+            ParallelNodeLocations(ParallelNodeLocations&&) = delete;
+            ParallelNodeLocations& operator=(ParallelNodeLocations&&) = delete;
+
+            ~ParallelNodeLocations() noexcept {
+                // The tasks reference the indexes, so they must be done
+                // before this object goes away.
+                for (auto& future : m_futures) {
+                    future.wait();
+                }
+            }
+
+            /**
+             * Store the locations of all nodes in the buffer. This returns
+             * as soon as the work is queued, unless too many buffers are
+             * in flight already. Other objects in the buffer are ignored.
+             *
+             * @throws Any exception thrown by the set() function of the
+             *         index for an earlier buffer.
+             */
+            void store(osmium::memory::Buffer&& buffer) {
+                while (m_futures.size() >= m_max_tasks) {
+                    wait_for_oldest();
+                }
+                m_futures.push_back(m_pool.submit(detail::StoreNodeLocations<TStoragePosIDs, TStorageNegIDs>{std::move(buffer), &m_storage_pos, &m_storage_neg}));
+            }
+
+            /**
+             * Wait until the locations of all buffers are stored.
+             *
+             * @throws Any exception thrown by the set() function of the
+             *         index.
+             */
+            void flush() {
+                while (!m_futures.empty()) {
+                    wait_for_oldest();
+                }
+            }
+
+        }; // class ParallelNodeLocations
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_PARALLEL_NODE_LOCATIONS_HPP
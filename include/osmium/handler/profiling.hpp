@@ -0,0 +1,494 @@
+#ifndef OSMIUM_HANDLER_PROFILING_HPP
+#define OSMIUM_HANDLER_PROFILING_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/memory/item_iterator.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# include <intrin.h>
+# define OSMIUM_HAS_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+# include <x86intrin.h>
+# define OSMIUM_HAS_RDTSC
+#endif
+
+namespace osmium {
+
+    namespace handler {
+
+        namespace detail {
+
+            /**
+             * Read a cheap monotonic tick counter. This is the time stamp
+             * counter of the CPU where available, otherwise a clock in
+             * nanoseconds.
+             */
+            inline uint64_t read_ticks() noexcept {
+#ifdef OSMIUM_HAS_RDTSC
+                return __rdtsc();
+#else
+                return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+            }
+
+        } // namespace detail
+
+        /**
+         * The handler callbacks measured by the ProfilingHandler.
+         */
+        enum class profiled_callback : std::size_t {
+            osm_object = 0,
+            node       = 1,
+            way        = 2,
+            relation   = 3,
+            area       = 4,
+            changeset  = 5,
+            flush      = 6
+        };
+
+        enum : std::size_t {
+            num_profiled_callbacks = 7
+        };
+
+        inline const char* profiled_callback_name(const profiled_callback callback) noexcept {
+            static const char* names[] = {
+                "osm_object",
+                "node",
+                "way",
+                "relation",
+                "area",
+                "changeset",
+                "flush"
+            };
+            return names[static_cast<std::size_t>(callback)];
+        }
+
+        /**
+         * One row of the profile: The numbers for one callback of one
+         * handler.
+         */
+        struct profile_row {
+
+            /// Name of the handler given to the ProfilingHandler.
+            std::string handler;
+
+            /// The callback.
+            profiled_callback callback;
+
+            /// Number of objects the callback was called for.
+            uint64_t calls;
+
+            /// Estimated total time spent in the callback.
+            std::chrono::nanoseconds time;
+
+        }; // struct profile_row
+
+        /**
+         * Collects the profile of any number of handlers wrapped in a
+         * ProfilingHandler.
+         *
+         * Calling a clock for every object would take longer than many
+         * handler callbacks, so only every sample_interval'th call of each
+         * callback is timed using the time stamp counter of the CPU (where
+         * available). The total time is then extrapolated from the samples.
+         * The number of calls is always exact. Flushes and batch callbacks
+         * (like node_batch()) are always timed.
+         *
+         * This is not thread safe. Use one profiler per thread.
+         *
+         * Example:
+         * @code
+         *     osmium::handler::HandlerProfiler profiler;
+         *     auto p1 = osmium::handler::make_profiling_handler(profiler, handler1, "handler1");
+         *     auto p2 = osmium::handler::make_profiling_handler(profiler, handler2, "handler2");
+         *     osmium::apply(reader, p1, p2);
+         *     std::cerr << profiler;
+         * @endcode
+         */
+        class HandlerProfiler {
+
+        public:
+
+            struct callback_stats {
+                uint64_t calls = 0;
+                uint64_t sampled_calls = 0;
+                uint64_t sampled_ticks = 0;
+            };
+
+            struct handler_stats {
+                std::string name;
+                callback_stats callbacks[num_profiled_callbacks];
+
+                explicit handler_stats(std::string&& n) :
+                    name(std::move(n)) {
+                }
+            };
+
+            enum : uint64_t {
+                default_sample_interval = 16
+            };
+
+        private:
+
+            using clock = std::chrono::steady_clock;
+
+            // Stats are referenced by the handlers, so they must not move.
+            std::deque<handler_stats> m_handlers;
+
+            uint64_t m_sample_mask;
+
+            clock::time_point m_start_time = clock::now();
+            uint64_t m_start_ticks = detail::read_ticks();
+
+            double nanoseconds_per_tick() const noexcept {
+#ifdef OSMIUM_HAS_RDTSC
+                const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start_time).count();
+                const auto ticks = detail::read_ticks() - m_start_ticks;
+                if (ns <= 0 || ticks == 0) {
+                    return 1.0;
+                }
+                return static_cast<double>(ns) / static_cast<double>(ticks);
+#else
+                return 1.0;
+#endif
+            }
+
+        public:
+
+            /**
+             * Create a profiler.
+             *
+             * @param sample_interval Time one in this many calls of each
+             *                        callback. Rounded down to a power of
+             *                        two. Use 1 to time every call.
+             */
+            explicit HandlerProfiler(uint64_t sample_interval = default_sample_interval) noexcept :
+                m_sample_mask(0) {
+                uint64_t interval = 1;
+                while (interval * 2 <= sample_interval) {
+                    interval *= 2;
+                }
+                m_sample_mask = interval - 1;
+            }
+
+            /**
+             * Add a handler to the profile. Usually this is called by the
+             * ProfilingHandler.
+             */
+            handler_stats& add_handler(std::string name) {
+                m_handlers.emplace_back(std::move(name));
+                return m_handlers.back();
+            }
+
+            uint64_t sample_mask() const noexcept {
+                return m_sample_mask;
+            }
+
+            /**
+             * Get the profile. There is one row for every callback which
+             * was called at least once for every handler in the order
+             * the handlers were added.
+             */
+            std::vector<profile_row> rows() const {
+                const double factor = nanoseconds_per_tick();
+                std::vector<profile_row> result;
+                for (const auto& handler : m_handlers) {
+                    for (std::size_t i = 0; i < num_profiled_callbacks; ++i) {
+                        const auto& stats = handler.callbacks[i];
+                        if (stats.calls == 0) {
+                            continue;
+                        }
+                        double ticks = 0.0;
+                        if (stats.sampled_calls > 0) {
+                            ticks = static_cast<double>(stats.sampled_ticks) *
+                                    static_cast<double>(stats.calls) /
+                                    static_cast<double>(stats.sampled_calls);
+                        }
+                        result.push_back(profile_row{handler.name,
+                                                     static_cast<profiled_callback>(i),
+                                                     stats.calls,
+                                                     std::chrono::nanoseconds{static_cast<int64_t>(ticks * factor)}});
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * Print the profile as a table with one line per handler and
+             * callback to the stream.
+             */
+            template <typename TChar, typename TTraits>
+            void print(std::basic_ostream<TChar, TTraits>& out) const {
+                const auto profile = rows();
+                int64_t total = 0;
+                for (const auto& row : profile) {
+                    total += row.time.count();
+                }
+
+                out << std::left << std::setw(24) << "handler" << ' '
+                    << std::setw(10) << "callback" << std::right
+                    << std::setw(14) << "calls"
+                    << std::setw(12) << "time [ms]"
+                    << std::setw(10) << "ns/call"
+                    << std::setw(8) << "%" << '\n';
+                for (const auto& row : profile) {
+                    const auto ns = row.time.count();
+                    out << std::left << std::setw(24) << row.handler << ' '
+                        << std::setw(10) << profiled_callback_name(row.callback) << std::right
+                        << std::setw(14) << row.calls
+                        << std::setw(12) << std::fixed << std::setprecision(1) << static_cast<double>(ns) / 1000000.0
+                        << std::setw(10) << std::setprecision(1) << static_cast<double>(ns) / static_cast<double>(row.calls)
+                        << std::setw(8) << std::setprecision(1) << (total > 0 ? 100.0 * static_cast<double>(ns) / static_cast<double>(total) : 0.0)
+                        << '\n';
+                }
+            }
+
+            /**
+             * Remove all numbers collected so far. The handlers stay
+             * registered.
+             */
+            void clear() noexcept {
+                for (auto& handler : m_handlers) {
+                    for (auto& stats : handler.callbacks) {
+                        stats = callback_stats{};
+                    }
+                }
+                m_start_time = clock::now();
+                m_start_ticks = detail::read_ticks();
+            }
+
+        }; // class HandlerProfiler
+
+        template <typename TChar, typename TTraits>
+        inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const HandlerProfiler& profiler) {
+            profiler.print(out);
+            return out;
+        }
+
+        /**
+         * Wraps a handler and records how often each of its callbacks is
+         * called and how long they take in a HandlerProfiler. Use it
+         * everywhere the handler would be used: In osmium::apply(), in a
+         * ChainHandler, or with DynamicHandler::set(). Callbacks the
+         * wrapped handler doesn't have (those inherited from
+         * osmium::handler::Handler) are not called and not recorded.
+         *
+         * The profiler and the handler must outlive this object.
+         */
+        template <typename THandler>
+        class ProfilingHandler : public osmium::handler::Handler {
+
+            THandler* m_handler;
+            HandlerProfiler::handler_stats* m_stats;
+            uint64_t m_sample_mask;
+
+            template <typename TFunc>
+            void measure(profiled_callback callback, TFunc&& func) {
+                auto& stats = m_stats->callbacks[static_cast<std::size_t>(callback)];
+                if ((stats.calls++ & m_sample_mask) != 0) {
+                    std::forward<TFunc>(func)();
+                    return;
+                }
+                const auto start = detail::read_ticks();
+                std::forward<TFunc>(func)();
+                stats.sampled_ticks += detail::read_ticks() - start;
+                ++stats.sampled_calls;
+            }
+
+            template <typename TFunc>
+            void measure_batch(profiled_callback callback, std::size_t count, TFunc&& func) {
+                auto& stats = m_stats->callbacks[static_cast<std::size_t>(callback)];
+                const auto start = detail::read_ticks();
+                std::forward<TFunc>(func)();
+                stats.sampled_ticks += detail::read_ticks() - start;
+                stats.calls += count;
+                stats.sampled_calls += count;
+            }
+
+            template <typename TObject>
+            void call_osm_object(TObject& object, std::true_type overridden) {
+                measure(profiled_callback::osm_object, [&] {
+                    osmium::detail::call_osm_object(*m_handler, object, overridden);
+                });
+            }
+
+            template <typename TObject>
+            void call_osm_object(TObject& /*object*/, std::false_type /*overridden*/) noexcept {
+            }
+
+#define OSMIUM_PROFILING_HANDLER_CALL(_name_) \
+            template <typename TObject> \
+            void call_##_name_(TObject& object, std::true_type overridden) { \
+                measure(profiled_callback::_name_, [&] { \
+                    osmium::detail::call_##_name_(*m_handler, object, overridden); \
+                }); \
+            } \
+            template <typename TObject> \
+            void call_##_name_(TObject& /*object*/, std::false_type /*overridden*/) noexcept { \
+            }
+
+            OSMIUM_PROFILING_HANDLER_CALL(node)
+            OSMIUM_PROFILING_HANDLER_CALL(way)
+            OSMIUM_PROFILING_HANDLER_CALL(relation)
+            OSMIUM_PROFILING_HANDLER_CALL(area)
+            OSMIUM_PROFILING_HANDLER_CALL(changeset)
+
+#undef OSMIUM_PROFILING_HANDLER_CALL
+
+            using handler_type = typename std::decay<THandler>::type;
+
+        public:
+
+            ProfilingHandler(HandlerProfiler& profiler, THandler& handler, std::string name) :
+                m_handler(&handler),
+                m_stats(&profiler.add_handler(std::move(name))),
+                m_sample_mask(profiler.sample_mask()) {
+            }
+
+            void osm_object(const osmium::OSMObject& object) {
+                call_osm_object(object, osmium::detail::overrides_osm_object<handler_type>{});
+            }
+
+            void osm_object(osmium::OSMObject& object) {
+                call_osm_object(object, osmium::detail::overrides_osm_object<handler_type>{});
+            }
+
+            void node(const osmium::Node& node) {
+                call_node(node, osmium::detail::overrides_node<handler_type>{});
+            }
+
+            void node(osmium::Node& node) {
+                call_node(node, osmium::detail::overrides_node<handler_type>{});
+            }
+
+            void way(const osmium::Way& way) {
+                call_way(way, osmium::detail::overrides_way<handler_type>{});
+            }
+
+            void way(osmium::Way& way) {
+                call_way(way, osmium::detail::overrides_way<handler_type>{});
+            }
+
+            void relation(const osmium::Relation& relation) {
+                call_relation(relation, osmium::detail::overrides_relation<handler_type>{});
+            }
+
+            void relation(osmium::Relation& relation) {
+                call_relation(relation, osmium::detail::overrides_relation<handler_type>{});
+            }
+
+            void area(const osmium::Area& area) {
+                call_area(area, osmium::detail::overrides_area<handler_type>{});
+            }
+
+            void area(osmium::Area& area) {
+                call_area(area, osmium::detail::overrides_area<handler_type>{});
+            }
+
+            void changeset(const osmium::Changeset& changeset) {
+                call_changeset(changeset, osmium::detail::overrides_changeset<handler_type>{});
+            }
+
+            void changeset(osmium::Changeset& changeset) {
+                call_changeset(changeset, osmium::detail::overrides_changeset<handler_type>{});
+            }
+
+            // The batch functions only exist if the wrapped handler has
+            // them, so osmium::apply() treats this handler like the
+            // wrapped one.
+
+            template <typename T = handler_type>
+            auto node_batch(const osmium::memory::ItemIteratorRange<const osmium::Node>& nodes) -> decltype(std::declval<T&>().node_batch(nodes), void()) {
+                measure_batch(profiled_callback::node, nodes.size(), [&] {
+                    m_handler->node_batch(nodes);
+                });
+            }
+
+            template <typename T = handler_type>
+            auto way_batch(const osmium::memory::ItemIteratorRange<const osmium::Way>& ways) -> decltype(std::declval<T&>().way_batch(ways), void()) {
+                measure_batch(profiled_callback::way, ways.size(), [&] {
+                    m_handler->way_batch(ways);
+                });
+            }
+
+            template <typename T = handler_type>
+            auto relation_batch(const osmium::memory::ItemIteratorRange<const osmium::Relation>& relations) -> decltype(std::declval<T&>().relation_batch(relations), void()) {
+                measure_batch(profiled_callback::relation, relations.size(), [&] {
+                    m_handler->relation_batch(relations);
+                });
+            }
+
+            void flush() {
+                measure_batch(profiled_callback::flush, 1, [&] {
+                    m_handler->flush();
+                });
+            }
+
+        }; // class ProfilingHandler
+
+        /**
+         * Wrap a handler in a ProfilingHandler.
+         *
+         * @param profiler The profiler collecting the numbers.
+         * @param handler The handler.
+         * @param name Name of the handler in the profile.
+         */
+        template <typename THandler>
+        ProfilingHandler<THandler> make_profiling_handler(HandlerProfiler& profiler, THandler& handler, std::string name) {
+            return ProfilingHandler<THandler>{profiler, handler, std::move(name)};
+        }
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_PROFILING_HPP
@@ -0,0 +1,165 @@
+#ifndef OSMIUM_HANDLER_UPDATE_OBJECT_RELATIONS_HPP
+#define OSMIUM_HANDLER_UPDATE_OBJECT_RELATIONS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/index/multimap/persistent.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * This handler keeps persistent indexes of the relations between
+         * ways and their nodes and between relations and their way members
+         * up to date. Use it first with the initial_load flag set on the
+         * complete data, afterwards without the flag on change files.
+         *
+         * All four indexes are needed, because when a way or relation
+         * changes, the old entries in the reverse indexes are found
+         * through the forward indexes.
+         *
+         * Note: This handler will only work if either all object IDs are
+         *       positive or all object IDs are negative.
+         */
+        class UpdateObjectRelations : public osmium::handler::Handler {
+
+        public:
+
+            using index_type = osmium::index::multimap::PersistentMultimap<unsigned_object_id_type, unsigned_object_id_type>;
+
+        private:
+
+            index_type& m_index_w2n;
+            index_type& m_index_n2w;
+            index_type& m_index_r2w;
+            index_type& m_index_w2r;
+
+            bool m_initial_load;
+
+            static void remove_all(index_type& forward, index_type& reverse, const unsigned_object_id_type id) {
+                for (const auto other_id : forward.get_all(id)) {
+                    forward.remove(id, other_id);
+                    reverse.remove(other_id, id);
+                }
+            }
+
+            void add(index_type& forward, index_type& reverse, const unsigned_object_id_type id, const unsigned_object_id_type other_id) {
+                if (m_initial_load) {
+                    forward.set(id, other_id);
+                    reverse.set(other_id, id);
+                } else {
+                    forward.add(id, other_id);
+                    reverse.add(other_id, id);
+                }
+            }
+
+            static void finish_index(index_type& index, bool initial_load) {
+                if (initial_load) {
+                    index.sort();
+                } else if (index.needs_compaction()) {
+                    index.compact();
+                }
+            }
+
+        public:
+
+            /**
+             * Constructor.
+             *
+             * @param w2n Index from ways to their nodes.
+             * @param n2w Index from nodes to the ways they are in.
+             * @param r2w Index from relations to their way members.
+             * @param w2r Index from ways to the relations they are in.
+             * @param initial_load Set this when loading the complete data
+             *                     into empty indexes. This is much faster
+             *                     than going through the update logs.
+             */
+            UpdateObjectRelations(index_type& w2n, index_type& n2w, index_type& r2w, index_type& w2r, bool initial_load = false) :
+                m_index_w2n(w2n),
+                m_index_n2w(n2w),
+                m_index_r2w(r2w),
+                m_index_w2r(w2r),
+                m_initial_load(initial_load) {
+            }
+
+            void way(const osmium::Way& way) {
+                const auto id = way.positive_id();
+                if (!m_initial_load) {
+                    remove_all(m_index_w2n, m_index_n2w, id);
+                }
+                if (way.visible()) {
+                    for (const auto& node_ref : way.nodes()) {
+                        add(m_index_w2n, m_index_n2w, id, node_ref.positive_ref());
+                    }
+                }
+            }
+
+            void relation(const osmium::Relation& relation) {
+                const auto id = relation.positive_id();
+                if (!m_initial_load) {
+                    remove_all(m_index_r2w, m_index_w2r, id);
+                }
+                if (relation.visible()) {
+                    for (const auto& member : relation.members()) {
+                        if (member.type() == osmium::item_type::way) {
+                            add(m_index_r2w, m_index_w2r, id, member.positive_ref());
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Call this after all data was read. After the initial load
+             * this sorts the indexes, after updates it compacts those
+             * indexes that need it.
+             */
+            void finish() {
+                finish_index(m_index_w2n, m_initial_load);
+                finish_index(m_index_n2w, m_initial_load);
+                finish_index(m_index_r2w, m_initial_load);
+                finish_index(m_index_w2r, m_initial_load);
+            }
+
+        }; // class UpdateObjectRelations
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_UPDATE_OBJECT_RELATIONS_HPP
@@ -39,6 +39,7 @@ DEALINGS IN THE SOFTWARE.
 #include <fcntl.h>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -47,10 +48,10 @@ namespace osmium {
 
         namespace detail {
 
-            template <typename T>
-            inline T* create_map_with_fd(const std::vector<std::string>& config) {
+            template <typename T, typename... TArgs>
+            inline T* create_map_with_fd(const std::vector<std::string>& config, TArgs&&... args) {
                 if (config.size() == 1) {
-                    return new T{};
+                    return new T{std::forward<TArgs>(args)...};
                 }
                 assert(config.size() > 1);
                 const std::string& filename = config[1];
@@ -58,7 +59,7 @@ namespace osmium {
                 if (fd == -1) {
                     throw std::runtime_error{std::string{"can't open file '"} + filename + "': " + std::strerror(errno)};
                 }
-                return new T{fd};
+                return new T{fd, std::forward<TArgs>(args)...};
             }
 
         } // namespace detail
@@ -0,0 +1,276 @@
+#ifndef OSMIUM_INDEX_DETAIL_EXTERNAL_SORTER_HPP
+#define OSMIUM_INDEX_DETAIL_EXTERNAL_SORTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Sorts any number of objects of type T using a limited amount of
+         * memory. Objects are collected in memory until the given number
+         * is reached, then they are sorted and written out to a temporary
+         * file. When all objects have been added, the sorted runs are merged
+         * while reading them back in using next().
+         *
+         * T must be trivially copyable, because it is written to disk as is.
+         */
+        template <typename T, typename TCompare = std::less<T>>
+        class external_sorter {
+
+            enum {
+                read_buffer_bytes = 1024UL * 1024UL
+            };
+
+            class run {
+
+                int m_fd;
+                std::vector<T> m_buffer;
+                std::size_t m_pos = 0;
+
+                void fill_buffer() {
+                    m_buffer.resize(read_buffer_bytes / sizeof(T) + 1);
+                    auto* data = reinterpret_cast<char*>(m_buffer.data());
+                    const std::size_t bytes = m_buffer.size() * sizeof(T);
+                    std::size_t offset = 0;
+                    while (offset < bytes) {
+                        const auto nread = osmium::io::detail::reliable_read(m_fd, data + offset, static_cast<unsigned int>(bytes - offset));
+                        if (nread == 0) {
+                            break;
+                        }
+                        offset += static_cast<std::size_t>(nread);
+                    }
+                    if (offset % sizeof(T) != 0) {
+                        throw std::runtime_error{"short read from external sort file"};
+                    }
+                    m_buffer.resize(offset / sizeof(T));
+                    m_pos = 0;
+                }
+
+            public:
+
+                explicit run(std::vector<T>& data) :
+                    m_fd(osmium::detail::create_tmp_file()) {
+                    osmium::io::detail::reliable_write(m_fd, reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+#ifdef _WIN32
+                    const auto result = _lseeki64(m_fd, 0, SEEK_SET);
+#else
+                    const auto result = ::lseek(m_fd, 0, SEEK_SET);
+#endif
+                    if (result != 0) {
+                        throw std::system_error{errno, std::system_category(), "lseek failed"};
+                    }
+                }
+
+                run(const run&) = delete;
+                run& operator=(const run&) = delete;
+
+                run(run&&) = delete;
+                run& operator=(run&&) = delete;
+
+                ~run() noexcept {
+#ifdef _WIN32
+                    _close(m_fd);
+#else
+                    ::close(m_fd);
+#endif
+                }
+
+                bool next(T& value) {
+                    if (m_pos == m_buffer.size()) {
+                        fill_buffer();
+                        if (m_buffer.empty()) {
+                            return false;
+                        }
+                    }
+                    value = m_buffer[m_pos++];
+                    return true;
+                }
+
+            }; // class run
+
+            using heap_element = std::pair<T, std::size_t>;
+
+            class heap_compare {
+
+                TCompare m_compare;
+
+            public:
+
+                explicit heap_compare(const TCompare& compare) :
+                    m_compare(compare) {
+                }
+
+                bool operator()(const heap_element& a, const heap_element& b) const {
+                    return m_compare(b.first, a.first);
+                }
+
+            }; // class heap_compare
+
+            std::vector<T> m_data;
+            std::vector<std::unique_ptr<run>> m_runs;
+            std::priority_queue<heap_element, std::vector<heap_element>, heap_compare> m_heap;
+            TCompare m_compare;
+            std::size_t m_max_in_memory;
+            std::size_t m_size = 0;
+            std::size_t m_data_pos = 0;
+            bool m_reading = false;
+
+            void write_run() {
+                std::sort(m_data.begin(), m_data.end(), m_compare);
+                m_runs.emplace_back(new run{m_data});
+                m_data.clear();
+            }
+
+        public:
+
+            /**
+             * Create an external sorter.
+             *
+             * @param max_in_memory Maximum number of objects kept in memory.
+             * @param compare Comparison function for objects.
+             */
+            explicit external_sorter(const std::size_t max_in_memory, const TCompare& compare = TCompare{}) :
+                m_heap(heap_compare{compare}),
+                m_compare(compare),
+                m_max_in_memory(std::max(max_in_memory, static_cast<std::size_t>(1))) {
+            }
+
+            /// The number of objects added.
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /// The number of runs written to disk so far.
+            std::size_t num_runs() const noexcept {
+                return m_runs.size();
+            }
+
+            /**
+             * Add an object.
+             *
+             * @pre finish() was not called yet.
+             */
+            void add(const T& value) {
+                if (m_reading) {
+                    throw std::logic_error{"external_sorter: add() called after finish()"};
+                }
+                if (m_data.size() == m_max_in_memory) {
+                    write_run();
+                }
+                m_data.push_back(value);
+                ++m_size;
+            }
+
+            /**
+             * Call this after all objects have been added. After that the
+             * objects can be read in sorted order using next().
+             */
+            void finish() {
+                if (m_reading) {
+                    return;
+                }
+                m_reading = true;
+
+                if (m_runs.empty()) {
+                    std::sort(m_data.begin(), m_data.end(), m_compare);
+                    return;
+                }
+
+                if (!m_data.empty()) {
+                    write_run();
+                }
+                m_data.shrink_to_fit();
+
+                T value;
+                for (std::size_t i = 0; i < m_runs.size(); ++i) {
+                    if (m_runs[i]->next(value)) {
+                        m_heap.emplace(value, i);
+                    }
+                }
+            }
+
+            /**
+             * Get the next object in sorted order.
+             *
+             * @pre finish() was called.
+             * @returns false if there are no more objects.
+             */
+            bool next(T& value) {
+                if (m_runs.empty()) {
+                    if (m_data_pos == m_data.size()) {
+                        return false;
+                    }
+                    value = m_data[m_data_pos++];
+                    return true;
+                }
+
+                if (m_heap.empty()) {
+                    return false;
+                }
+
+                const heap_element top = m_heap.top();
+                m_heap.pop();
+                value = top.first;
+
+                T next_value;
+                if (m_runs[top.second]->next(next_value)) {
+                    m_heap.emplace(next_value, top.second);
+                }
+
+                return true;
+            }
+
+        }; // class external_sorter
+
+    } // namespace detail
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_EXTERNAL_SORTER_HPP
@@ -0,0 +1,76 @@
+#ifndef OSMIUM_INDEX_DETAIL_HUGE_PAGES_OPTION_HPP
+#define OSMIUM_INDEX_DETAIL_HUGE_PAGES_OPTION_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/memory_mapping.hpp>
+
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Check whether the last element of a map config is a huge pages
+             * option: "huge_pages" (use MAP_HUGETLB if possible, transparent
+             * huge pages otherwise) or "transparent_huge_pages". If it is, it
+             * is removed from the config.
+             *
+             * @returns The huge pages mode from the option or
+             *          huge_pages_mode::none if there is no such option.
+             */
+            inline osmium::MemoryMapping::huge_pages_mode get_huge_pages_option(std::vector<std::string>& config) {
+                if (config.size() > 1) {
+                    if (config.back() == "huge_pages") {
+                        config.pop_back();
+                        return osmium::MemoryMapping::huge_pages_mode::hugetlb;
+                    }
+                    if (config.back() == "transparent_huge_pages") {
+                        config.pop_back();
+                        return osmium::MemoryMapping::huge_pages_mode::transparent;
+                    }
+                }
+                return osmium::MemoryMapping::huge_pages_mode::none;
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_HUGE_PAGES_OPTION_HPP
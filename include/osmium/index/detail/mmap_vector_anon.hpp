@@ -54,6 +54,10 @@ namespace osmium {
                 mmap_vector_base<T>() {
             }
 
+            explicit mmap_vector_anon(const osmium::MemoryMapping::huge_pages_mode huge_pages) :
+                mmap_vector_base<T>(osmium::detail::mmap_vector_size_increment, huge_pages) {
+            }
+
         }; // class mmap_vector_anon
 
     } // namespace detail
@@ -65,16 +65,20 @@ namespace osmium {
 
         public:
 
-            mmap_vector_base(const int fd, const std::size_t capacity, const std::size_t size = 0) :
+            mmap_vector_base(const int fd,
+                             const std::size_t capacity,
+                             const std::size_t size = 0,
+                             const osmium::MemoryMapping::huge_pages_mode huge_pages = osmium::MemoryMapping::huge_pages_mode::none) :
                 m_size(size),
-                m_mapping(capacity, osmium::MemoryMapping::mapping_mode::write_shared, fd) {
+                m_mapping(capacity, osmium::MemoryMapping::mapping_mode::write_shared, fd, 0, huge_pages) {
                 assert(size <= capacity);
                 std::fill(data() + size, data() + capacity, osmium::index::empty_value<T>());
                 shrink_to_fit();
             }
 
-            explicit mmap_vector_base(const std::size_t capacity = mmap_vector_size_increment) :
-                m_mapping(capacity) {
+            explicit mmap_vector_base(const std::size_t capacity = mmap_vector_size_increment,
+                                      const osmium::MemoryMapping::huge_pages_mode huge_pages = osmium::MemoryMapping::huge_pages_mode::none) :
+                m_mapping(capacity, huge_pages) {
                 std::fill_n(data(), capacity, osmium::index::empty_value<T>());
             }
 
@@ -90,6 +94,22 @@ namespace osmium {
                 m_mapping.unmap();
             }
 
+            osmium::MemoryMapping::huge_pages_mode huge_pages() const noexcept {
+                return m_mapping.huge_pages();
+            }
+
+            /**
+             * Tell the kernel how the memory is going to be accessed. The
+             * hint stays in effect when the vector grows.
+             */
+            void advise(const osmium::MemoryMapping::access_hint hint) noexcept {
+                m_mapping.advise(hint);
+            }
+
+            osmium::MemoryMapping::access_hint access() const noexcept {
+                return m_mapping.access();
+            }
+
             std::size_t capacity() const noexcept {
                 return m_mapping.size();
             }
@@ -65,17 +65,20 @@ namespace osmium {
 
         public:
 
-            mmap_vector_file() :
+            explicit mmap_vector_file(const osmium::MemoryMapping::huge_pages_mode huge_pages = osmium::MemoryMapping::huge_pages_mode::none) :
                 mmap_vector_base<T>(
                     osmium::detail::create_tmp_file(),
-                    osmium::detail::mmap_vector_size_increment) {
+                    osmium::detail::mmap_vector_size_increment,
+                    0,
+                    huge_pages) {
             }
 
-            explicit mmap_vector_file(const int fd) :
+            explicit mmap_vector_file(const int fd, const osmium::MemoryMapping::huge_pages_mode huge_pages = osmium::MemoryMapping::huge_pages_mode::none) :
                 mmap_vector_base<T>(
                     fd,
                     std::max(static_cast<std::size_t>(mmap_vector_size_increment), filesize(fd)),
-                    filesize(fd)) {
+                    filesize(fd),
+                    huge_pages) {
             }
 
         }; // class mmap_vector_file
@@ -0,0 +1,155 @@
+#ifndef OSMIUM_INDEX_DETAIL_SORT_BY_ID_HPP
+#define OSMIUM_INDEX_DETAIL_SORT_BY_ID_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            enum {
+                // Ranges smaller than this are sorted with std::sort.
+                sort_by_id_min_radix_size = 64,
+
+                // Don't use radix sort for whole ranges smaller than this.
+                sort_by_id_min_size = 64 * 1024
+            };
+
+            template <typename TIterator>
+            inline unsigned int radix_digit(const TIterator it, const unsigned int shift) noexcept {
+                return static_cast<unsigned int>((it->first >> shift) & 0xffU);
+            }
+
+            // In-place MSD radix sort (American flag sort) on the byte of
+            // the id at the given shift and all lower bytes.
+            template <typename TIterator>
+            void radix_sort_by_id(const TIterator first, const TIterator last, const unsigned int shift) {
+                const auto size = static_cast<std::size_t>(std::distance(first, last));
+                if (size < sort_by_id_min_radix_size) {
+                    std::sort(first, last);
+                    return;
+                }
+
+                std::size_t count[256] = {0};
+                for (auto it = first; it != last; ++it) {
+                    ++count[radix_digit(it, shift)];
+                }
+
+                std::size_t begin[256];
+                std::size_t next[256];
+                std::size_t sum = 0;
+                for (unsigned int digit = 0; digit < 256; ++digit) {
+                    begin[digit] = sum;
+                    next[digit] = sum;
+                    sum += count[digit];
+                }
+
+                for (unsigned int digit = 0; digit < 256; ++digit) {
+                    const std::size_t end = begin[digit] + count[digit];
+                    while (next[digit] < end) {
+                        const auto it = first + next[digit];
+                        const unsigned int d = radix_digit(it, shift);
+                        if (d == digit) {
+                            ++next[digit];
+                        } else {
+                            using std::swap;
+                            swap(*it, *(first + next[d]));
+                            ++next[d];
+                        }
+                    }
+                }
+
+                for (unsigned int digit = 0; digit < 256; ++digit) {
+                    if (count[digit] > 1) {
+                        const auto bucket_first = first + begin[digit];
+                        const auto bucket_last = bucket_first + count[digit];
+                        if (shift == 0) {
+                            // All ids in the bucket are the same, sort by value.
+                            std::sort(bucket_first, bucket_last);
+                        } else {
+                            radix_sort_by_id(bucket_first, bucket_last, shift - 8);
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Sort a range of std::pair<TId, TValue> with unsigned integral
+             * TId. The result is the same as with std::sort(), but large
+             * ranges are sorted with an in-place radix sort on the id, which
+             * is much faster than comparison based sorting for the billions
+             * of entries in typical indexes. Already sorted ranges (common
+             * when data is added in id order) are detected and not touched.
+             */
+            template <typename TIterator>
+            void sort_by_id(const TIterator first, const TIterator last) {
+                using id_type = typename std::iterator_traits<TIterator>::value_type::first_type;
+                static_assert(std::is_integral<id_type>::value && std::is_unsigned<id_type>::value, "id must be unsigned integral type");
+
+                if (std::is_sorted(first, last)) {
+                    return;
+                }
+
+                if (std::distance(first, last) < sort_by_id_min_size) {
+                    std::sort(first, last);
+                    return;
+                }
+
+                id_type id_bits = 0;
+                for (auto it = first; it != last; ++it) {
+                    id_bits |= it->first;
+                }
+
+                unsigned int shift = 0;
+                while (shift + 8 < sizeof(id_type) * 8 && (id_bits >> (shift + 8)) != 0) {
+                    shift += 8;
+                }
+
+                radix_sort_by_id(first, last, shift);
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_SORT_BY_ID_HPP
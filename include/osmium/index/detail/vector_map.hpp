@@ -33,20 +33,39 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/sort_by_id.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/compatibility.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 #include <algorithm>
 #include <cstddef>
 #include <memory>
 #include <utility>
+#include <vector>
 
 
 namespace osmium {
 
     namespace index {
 
+        namespace detail {
+
+            // Pass the access hint on to vectors based on memory mappings,
+            // other vectors (like std::vector) don't need it.
+            template <typename TVector>
+            auto advise_vector(TVector& vector, const osmium::MemoryMapping::access_hint hint, int /*dummy*/) -> decltype(vector.advise(hint), void()) {
+                vector.advise(hint);
+            }
+
+            template <typename TVector>
+            void advise_vector(TVector& /*vector*/, const osmium::MemoryMapping::access_hint /*hint*/, long /*dummy*/) { // NOLINT(google-runtime-int)
+            }
+
+        } // namespace detail
+
         namespace map {
 
             template <typename TVector, typename TId, typename TValue>
@@ -69,10 +88,30 @@ namespace osmium {
                     m_vector(fd) {
                 }
 
+                /**
+                 * Create the map using huge pages. Only available for
+                 * vectors based on memory mappings.
+                 */
+                explicit VectorBasedDenseMap(osmium::MemoryMapping::huge_pages_mode huge_pages) :
+                    m_vector(huge_pages) {
+                }
+
+                VectorBasedDenseMap(int fd, osmium::MemoryMapping::huge_pages_mode huge_pages) :
+                    m_vector(fd, huge_pages) {
+                }
+
                 void reserve(const std::size_t size) final {
                     m_vector.reserve(size);
                 }
 
+                void presize(const std::size_t /*count*/, const TId max_id) final {
+                    reserve(static_cast<std::size_t>(max_id) + 1);
+                }
+
+                void set_access_hint(const osmium::MemoryMapping::access_hint hint) final {
+                    osmium::index::detail::advise_vector(m_vector, hint, 0);
+                }
+
                 void set(const TId id, const TValue value) final {
                     if (size() <= id) {
                         m_vector.resize(id+1);
@@ -80,6 +119,31 @@ namespace osmium {
                     m_vector[id] = value;
                 }
 
+                /**
+                 * Set the values for several ids at once. The vector is
+                 * resized at most once for all of them.
+                 */
+                void set_many(const TId* ids, const TValue* values, const std::size_t count) final {
+                    if (count == 0) {
+                        return;
+                    }
+                    const TId max_id = *std::max_element(ids, ids + count);
+                    if (size() <= max_id) {
+                        m_vector.resize(max_id + 1);
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        m_vector[ids[i]] = values[i];
+                    }
+                }
+
+                void update(const TId id, const TValue value) final {
+                    // Removing an id that isn't in the map must not enlarge it.
+                    if (id >= m_vector.size() && value == osmium::index::empty_value<TValue>()) {
+                        return;
+                    }
+                    set(id, value);
+                }
+
                 TValue get(const TId id) const final {
                     if (id >= m_vector.size()) {
                         throw osmium::not_found{id};
@@ -98,6 +162,33 @@ namespace osmium {
                     return m_vector[id];
                 }
 
+                /**
+                 * Retrieve values for several ids at once. The memory for
+                 * the ids a few positions ahead is prefetched, so that the
+                 * cache misses for the lookups overlap.
+                 */
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    enum {
+                        prefetch_distance = 8
+                    };
+
+                    const std::size_t vector_size = m_vector.size();
+                    const TValue* data = m_vector.data();
+
+                    for (std::size_t i = 0; i < count && i < prefetch_distance; ++i) {
+                        if (ids[i] < vector_size) {
+                            OSMIUM_PREFETCH(data + ids[i]);
+                        }
+                    }
+
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + prefetch_distance < count && ids[i + prefetch_distance] < vector_size) {
+                            OSMIUM_PREFETCH(data + ids[i + prefetch_distance]);
+                        }
+                        values[i] = ids[i] < vector_size ? data[ids[i]] : osmium::index::empty_value<TValue>();
+                    }
+                }
+
                 std::size_t size() const final {
                     return m_vector.size();
                 }
@@ -160,12 +251,73 @@ namespace osmium {
 
                 vector_type m_vector;
 
+                // Log of updates not yet merged into m_vector.
+                std::vector<element_type> m_updates;
+
+                enum : std::size_t {
+                    // Number of elements in m_vector per leaf of the
+                    // search layout. 16 elements of 16 bytes are four
+                    // cache lines.
+                    search_block_size = 16
+                };
+
+                // Search layout built by build_search_layout(): The last
+                // id of each block of search_block_size elements in
+                // Eytzinger order (element 0 is unused) and the number of
+                // the block for each of them. Empty if there is no layout.
+                std::vector<TId> m_search_keys;
+                std::vector<std::size_t> m_search_blocks;
+
+                // Fill the Eytzinger layout in order for the subtree at
+                // node k.
+                void fill_search_layout(const std::size_t k, std::size_t& block) {
+                    if (k < m_search_keys.size()) {
+                        fill_search_layout(2 * k, block);
+                        const std::size_t last = std::min((block + 1) * search_block_size, std::size_t(m_vector.size())) - 1;
+                        m_search_keys[k] = m_vector[last].first;
+                        m_search_blocks[k] = block;
+                        ++block;
+                        fill_search_layout(2 * k + 1, block);
+                    }
+                }
+
+                void clear_search_layout() noexcept {
+                    m_search_keys.clear();
+                    m_search_blocks.clear();
+                }
+
                 typename vector_type::const_iterator find_id(const TId id) const noexcept {
                     const element_type element {
                         id,
                         osmium::index::empty_value<TValue>()
                     };
-                    return std::lower_bound(m_vector.begin(), m_vector.end(), element, [](const element_type& a, const element_type& b) {
+
+                    auto first = m_vector.begin();
+                    auto last = m_vector.end();
+
+                    if (!m_search_keys.empty()) {
+                        // Find the first block whose last id is >= id by
+                        // going down the implicit tree. This touches only
+                        // one cache line per level for the upper levels.
+                        const std::size_t n = m_search_keys.size();
+                        std::size_t k = 1;
+                        while (k < n) {
+                            k = 2 * k + (m_search_keys[k] < id ? 1 : 0);
+                        }
+                        // Go back up to the last node where we went left.
+                        while (k & 1U) {
+                            k >>= 1U;
+                        }
+                        k >>= 1U;
+                        if (k == 0) {
+                            return m_vector.end();
+                        }
+                        const std::size_t block = m_search_blocks[k];
+                        first = m_vector.begin() + block * search_block_size;
+                        last = m_vector.begin() + std::min((block + 1) * search_block_size, std::size_t(m_vector.size()));
+                    }
+
+                    return std::lower_bound(first, last, element, [](const element_type& a, const element_type& b) {
                         return a.first < b.first;
                     });
                 }
@@ -180,7 +332,12 @@ namespace osmium {
                     m_vector(fd) {
                 }
 
+                void set_access_hint(const osmium::MemoryMapping::access_hint hint) final {
+                    osmium::index::detail::advise_vector(m_vector, hint, 0);
+                }
+
                 void set(const TId id, const TValue value) final {
+                    clear_search_layout();
                     m_vector.push_back(element_type(id, value));
                 }
 
@@ -211,16 +368,121 @@ namespace osmium {
                 }
 
                 std::size_t used_memory() const final {
-                    return sizeof(element_type) * size();
+                    return sizeof(element_type) * size() +
+                           (sizeof(TId) + sizeof(std::size_t)) * m_search_keys.size();
                 }
 
                 void clear() final {
+                    clear_search_layout();
                     m_vector.clear();
                     m_vector.shrink_to_fit();
                 }
 
                 void sort() final {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    clear_search_layout();
+                    osmium::index::detail::sort_by_id(m_vector.begin(), m_vector.end());
+                }
+
+                /**
+                 * Build an additional search structure to speed up get()
+                 * on large maps. It is a static search tree over blocks
+                 * of the sorted data laid out in Eytzinger (breadth-first)
+                 * order, so lookups touch much fewer cache lines than a
+                 * binary search over the whole map. The data itself stays
+                 * as it is, the structure needs about 1/16 of the memory
+                 * of the map.
+                 *
+                 * Any change to the map (set(), sort(), commit_updates(),
+                 * clear()) removes the search structure, call this again
+                 * afterwards. If the data is changed through the
+                 * iterators, this must be called again, too.
+                 *
+                 * @pre The map must be sorted.
+                 */
+                void build_search_layout() final {
+                    clear_search_layout();
+                    const std::size_t num_blocks = (m_vector.size() + search_block_size - 1) / search_block_size;
+                    if (num_blocks < 2) {
+                        return;
+                    }
+                    m_search_keys.resize(num_blocks + 1);
+                    m_search_blocks.resize(num_blocks + 1);
+                    std::size_t block = 0;
+                    fill_search_layout(1, block);
+                }
+
+                /**
+                 * Is there a search structure built by
+                 * build_search_layout()?
+                 */
+                bool has_search_layout() const noexcept {
+                    return !m_search_keys.empty();
+                }
+
+                /**
+                 * Add the update to a log which is merged into the sorted
+                 * map by commit_updates().
+                 */
+                void update(const TId id, const TValue value) final {
+                    m_updates.emplace_back(id, value);
+                }
+
+                /**
+                 * Merge the log of updates into the map. Only the log is
+                 * sorted, it is then merged in place with the (already
+                 * sorted) map in linear time.
+                 *
+                 * @pre The map must be sorted.
+                 */
+                void commit_updates() final {
+                    if (m_updates.empty()) {
+                        return;
+                    }
+
+                    clear_search_layout();
+
+                    // Sort updates keeping only the last one for each id.
+                    std::stable_sort(m_updates.begin(), m_updates.end(), [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+                    std::size_t num_updates = 0;
+                    for (std::size_t i = 0; i < m_updates.size(); ++i) {
+                        if (i + 1 == m_updates.size() || m_updates[i + 1].first != m_updates[i].first) {
+                            m_updates[num_updates++] = m_updates[i];
+                        }
+                    }
+
+                    // Merge from the back into the enlarged vector, so that
+                    // no element is overwritten before it is moved.
+                    std::size_t in = m_vector.size();
+                    std::size_t out = in + num_updates;
+                    m_vector.resize(out);
+                    while (num_updates > 0) {
+                        const auto& upd = m_updates[num_updates - 1];
+                        if (in > 0 && m_vector[in - 1].first > upd.first) {
+                            m_vector[--out] = m_vector[--in];
+                        } else {
+                            if (in > 0 && m_vector[in - 1].first == upd.first) {
+                                --in; // replaced by the update
+                            }
+                            m_vector[--out] = upd;
+                            --num_updates;
+                        }
+                    }
+
+                    // Close the gap left by replaced elements and remove
+                    // deleted elements.
+                    std::size_t size = in;
+                    for (std::size_t i = out; i < m_vector.size(); ++i) {
+                        if (m_vector[i].second != osmium::index::empty_value<TValue>()) {
+                            m_vector[size++] = m_vector[i];
+                        }
+                    }
+                    std::fill(m_vector.begin() + size, m_vector.end(), osmium::index::empty_value<element_type>());
+                    m_vector.resize(size);
+
+                    m_updates.clear();
+                    m_updates.shrink_to_fit();
                 }
 
                 void dump_as_array(const int fd) final {
@@ -33,12 +33,14 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/sort_by_id.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/multimap.hpp>
 #include <osmium/io/detail/read_write.hpp>
 
 #include <algorithm>
 #include <cstddef>
+#include <iterator>
 #include <utility>
 
 namespace osmium {
@@ -121,21 +123,40 @@ namespace osmium {
                 }
 
                 void sort() final {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    osmium::index::detail::sort_by_id(m_vector.begin(), m_vector.end());
                 }
 
                 void remove(const TId id, const TValue value) {
                     const auto r = get_all(id);
                     for (auto it = r.first; it != r.second; ++it) {
                         if (it->second == value) {
-                            it->second = 0;
+                            it->second = osmium::index::empty_value<TValue>();
                             return;
                         }
                     }
                 }
 
                 void consolidate() {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    osmium::index::detail::sort_by_id(m_vector.begin(), m_vector.end());
+                }
+
+                /**
+                 * Merge the elements in the range [first, last), which must
+                 * be sorted by id, into this multimap, which must also be
+                 * sorted. This takes linear time, sorting everything again
+                 * would take O(n log n).
+                 */
+                template <typename TIterator>
+                void merge_sorted(TIterator first, TIterator last) {
+                    const auto old_size = m_vector.size();
+                    m_vector.reserve(old_size + static_cast<std::size_t>(std::distance(first, last)));
+                    for (; first != last; ++first) {
+                        m_vector.push_back(element_type(first->first, first->second));
+                    }
+                    const auto middle = std::next(m_vector.begin(), static_cast<std::ptrdiff_t>(old_size));
+                    std::inplace_merge(m_vector.begin(), middle, m_vector.end(), [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
                 }
 
                 void erase_removed() {
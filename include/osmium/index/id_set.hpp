@@ -35,11 +35,13 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/util/endian.hpp>
 
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <iterator>
 #include <memory>
@@ -79,6 +81,25 @@ namespace osmium {
              */
             virtual bool get(T id) const noexcept = 0;
 
+            /**
+             * Is any Id in the range [first, last] (both inclusive) in
+             * the set? This implementation checks all Ids in the range
+             * one by one, the implementations provided do better.
+             *
+             * @pre @code first <= last @endcode
+             */
+            virtual bool any_in_range(T first, T last) const noexcept {
+                assert(first <= last);
+                for (T id = first;; ++id) {
+                    if (get(id)) {
+                        return true;
+                    }
+                    if (id == last) {
+                        return false;
+                    }
+                }
+            }
+
             /**
              * Is the set empty?
              */
@@ -106,6 +127,58 @@ namespace osmium {
                 default_chunk_bits = 22U
             };
 
+            inline unsigned int popcount64(uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+                return static_cast<unsigned int>(__builtin_popcountll(value));
+#else
+                value = value - ((value >> 1U) & 0x5555555555555555ULL);
+                value = (value & 0x3333333333333333ULL) + ((value >> 2U) & 0x3333333333333333ULL);
+                value = (value + (value >> 4U)) & 0x0f0f0f0f0f0f0f0fULL;
+                return static_cast<unsigned int>((value * 0x0101010101010101ULL) >> 56U);
+#endif
+            }
+
+            // Number of trailing zero bits. Value must not be 0.
+            inline unsigned int ctz64(uint64_t value) noexcept {
+                assert(value != 0);
+#if defined(__GNUC__) || defined(__clang__)
+                return static_cast<unsigned int>(__builtin_ctzll(value));
+#else
+                unsigned int n = 0;
+                while ((value & 1U) == 0) {
+                    value >>= 1U;
+                    ++n;
+                }
+                return n;
+#endif
+            }
+
+            // Load 8 bytes of a bitmap as 64bit word. Bit n of the word is
+            // bit (n % 8) of byte (n / 8).
+            inline uint64_t load_bitmap_word(const unsigned char* data) noexcept {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+                uint64_t value;
+                std::memcpy(&value, data, sizeof(value));
+                return value;
+#else
+                uint64_t value = 0;
+                for (unsigned int i = 0; i < 8; ++i) {
+                    value |= static_cast<uint64_t>(data[i]) << (i * 8U);
+                }
+                return value;
+#endif
+            }
+
+            inline void store_bitmap_word(unsigned char* data, uint64_t value) noexcept {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+                std::memcpy(data, &value, sizeof(value));
+#else
+                for (unsigned int i = 0; i < 8; ++i) {
+                    data[i] = static_cast<unsigned char>(value >> (i * 8U));
+                }
+#endif
+            }
+
         } // namespace detail
 
         template <typename T, std::size_t chunk_bits = detail::default_chunk_bits>
@@ -126,28 +199,32 @@ namespace osmium {
             T m_value;
             T m_last;
 
+            // Find the next set bit starting at m_value. Looks at 64 bits
+            // at a time and skips chunks that are not allocated.
             void next() noexcept {
-                while (m_value != m_last && !m_set->get(m_value)) {
+                while (m_value < m_last) {
                     const T cid = id_set::chunk_id(m_value);
                     assert(cid < m_set->m_data.size());
-                    if (!m_set->m_data[cid]) {
-                        m_value = (cid + 1) << (chunk_bits + 3);
-                    } else {
-                        const auto slot = m_set->m_data[cid][id_set::offset(m_value)];
-                        if (slot == 0) {
-                            m_value += 8;
-                            m_value &= ~0x7ULL;
-                        } else {
-                            ++m_value;
-                        }
+                    const unsigned char* chunk = m_set->m_data[cid].get();
+                    if (!chunk) {
+                        m_value = static_cast<T>((cid + 1) << (chunk_bits + 3));
+                        continue;
+                    }
+                    const uint64_t word = detail::load_bitmap_word(chunk + (id_set::offset(m_value) & ~static_cast<std::size_t>(0x7U))) >> (m_value & 0x3fU);
+                    if (word != 0) {
+                        m_value += detail::ctz64(word);
+                        return;
                     }
+                    m_value = (m_value | 0x3fU) + 1;
                 }
+                m_value = m_last;
             }
 
         public:
 
             using iterator_category = std::forward_iterator_tag;
             using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
             using pointer           = value_type*;
             using reference         = value_type&;
 
@@ -199,6 +276,7 @@ namespace osmium {
 
             static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
             static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+            static_assert(chunk_bits >= 3, "Chunks must be at least 8 bytes");
 
             friend class IdSetDenseIterator<T, chunk_bits>;
 
@@ -240,6 +318,28 @@ namespace osmium {
                 return chunk[offset(id)];
             }
 
+            static T count_chunk(const unsigned char* chunk) noexcept {
+                T count = 0;
+                for (std::size_t i = 0; i < chunk_size; i += 8) {
+                    count += detail::popcount64(detail::load_bitmap_word(chunk + i));
+                }
+                return count;
+            }
+
+            // Combine the chunk of this set with the chunk of the other set
+            // word by word using the function. Returns the number of bits
+            // set in the result.
+            template <typename TFunc>
+            static T combine_chunk(unsigned char* chunk, const unsigned char* other_chunk, TFunc&& func) noexcept {
+                T count = 0;
+                for (std::size_t i = 0; i < chunk_size; i += 8) {
+                    const uint64_t word = func(detail::load_bitmap_word(chunk + i), detail::load_bitmap_word(other_chunk + i));
+                    detail::store_bitmap_word(chunk + i, word);
+                    count += detail::popcount64(word);
+                }
+                return count;
+            }
+
         public:
 
             using const_iterator = IdSetDenseIterator<T, chunk_bits>;
@@ -279,6 +379,18 @@ namespace osmium {
 
             ~IdSetDense() noexcept override = default;
 
+            /**
+             * Make room in the chunk directory for Ids up to max_id, so it
+             * doesn't have to grow while the set is filled. The chunks
+             * themselves are still only allocated when they are used.
+             */
+            void reserve(T max_id) {
+                const auto num_chunks = chunk_id(max_id) + 1;
+                if (m_data.size() < num_chunks) {
+                    m_data.resize(num_chunks);
+                }
+            }
+
             /**
              * Add the Id to the set if it is not already in there.
              *
@@ -336,6 +448,47 @@ namespace osmium {
                 return (r[offset(id)] & bitmask(id)) != 0;
             }
 
+            /**
+             * Is any Id in the range [first, last] (both inclusive) in
+             * the set? Chunks that are not allocated are skipped, the
+             * others are checked byte by byte.
+             *
+             * @pre @code first <= last @endcode
+             */
+            bool any_in_range(T first, T last) const noexcept final {
+                assert(first <= last);
+                T id = first;
+                while (true) {
+                    const auto cid = chunk_id(id);
+                    if (cid >= m_data.size()) {
+                        return false;
+                    }
+                    const T chunk_last = static_cast<T>((cid + 1) * chunk_size * 8 - 1);
+                    const T end = std::min(last, chunk_last);
+                    const unsigned char* chunk = m_data[cid].get();
+                    if (chunk) {
+                        const std::size_t first_byte = offset(id);
+                        const std::size_t last_byte = offset(end);
+                        for (std::size_t b = first_byte; b <= last_byte; ++b) {
+                            unsigned int byte = chunk[b];
+                            if (b == first_byte) {
+                                byte &= 0xffU << (id & 0x7U);
+                            }
+                            if (b == last_byte) {
+                                byte &= 0xffU >> (7U - (end & 0x7U));
+                            }
+                            if (byte != 0) {
+                                return true;
+                            }
+                        }
+                    }
+                    if (end == last) {
+                        return false;
+                    }
+                    id = end + 1;
+                }
+            }
+
             /**
              * Is the set empty?
              */
@@ -362,6 +515,99 @@ namespace osmium {
                 return m_data.size() * chunk_size;
             }
 
+            /**
+             * Add all Ids in the other set to this set (set union). Works
+             * on whole chunks 64 bits at a time.
+             */
+            void merge(const IdSetDense& other) {
+                if (other.m_data.size() > m_data.size()) {
+                    m_data.resize(other.m_data.size());
+                }
+                for (std::size_t cid = 0; cid < other.m_data.size(); ++cid) {
+                    const unsigned char* other_chunk = other.m_data[cid].get();
+                    if (!other_chunk) {
+                        continue;
+                    }
+                    auto& chunk = m_data[cid];
+                    if (!chunk) {
+                        chunk.reset(new unsigned char[chunk_size]);
+                        std::memcpy(chunk.get(), other_chunk, chunk_size);
+                        m_size += count_chunk(other_chunk);
+                    } else {
+                        m_size -= count_chunk(chunk.get());
+                        m_size += combine_chunk(chunk.get(), other_chunk, [](uint64_t a, uint64_t b) noexcept {
+                            return a | b;
+                        });
+                    }
+                }
+            }
+
+            /**
+             * Add the Ids first + n to the set for all bits n set in the
+             * word. Used to merge in sets with other storage 64 bits at a
+             * time.
+             *
+             * @pre @code first % 64 == 0 @endcode
+             */
+            void merge_word(T first, uint64_t word) {
+                assert((first & 0x3fU) == 0);
+                unsigned char* data = &get_element(first);
+                const uint64_t old_word = detail::load_bitmap_word(data);
+                detail::store_bitmap_word(data, old_word | word);
+                m_size += detail::popcount64(word & ~old_word);
+            }
+
+            /**
+             * Remove all Ids from this set that are not in the other set
+             * (set intersection). Works on whole chunks 64 bits at a time.
+             * Chunks that become empty are released.
+             */
+            void intersect(const IdSetDense& other) {
+                for (std::size_t cid = 0; cid < m_data.size(); ++cid) {
+                    auto& chunk = m_data[cid];
+                    if (!chunk) {
+                        continue;
+                    }
+                    m_size -= count_chunk(chunk.get());
+                    const unsigned char* other_chunk = cid < other.m_data.size() ? other.m_data[cid].get() : nullptr;
+                    if (!other_chunk) {
+                        chunk.reset();
+                        continue;
+                    }
+                    const T count = combine_chunk(chunk.get(), other_chunk, [](uint64_t a, uint64_t b) noexcept {
+                        return a & b;
+                    });
+                    if (count == 0) {
+                        chunk.reset();
+                    }
+                    m_size += count;
+                }
+            }
+
+            /**
+             * Remove all Ids in the other set from this set (set
+             * difference). Works on whole chunks 64 bits at a time. Chunks
+             * that become empty are released.
+             */
+            void subtract(const IdSetDense& other) {
+                const std::size_t num_chunks = std::min(m_data.size(), other.m_data.size());
+                for (std::size_t cid = 0; cid < num_chunks; ++cid) {
+                    auto& chunk = m_data[cid];
+                    const unsigned char* other_chunk = other.m_data[cid].get();
+                    if (!chunk || !other_chunk) {
+                        continue;
+                    }
+                    m_size -= count_chunk(chunk.get());
+                    const T count = combine_chunk(chunk.get(), other_chunk, [](uint64_t a, uint64_t b) noexcept {
+                        return a & ~b;
+                    });
+                    if (count == 0) {
+                        chunk.reset();
+                    }
+                    m_size += count;
+                }
+            }
+
             const_iterator begin() const {
                 return {this, 0, last()};
             }
@@ -370,6 +616,27 @@ namespace osmium {
                 return {this, last(), last()};
             }
 
+            /**
+             * The number of chunks (allocated or not) in this set. Used
+             * for serialization.
+             */
+            std::size_t num_chunks() const noexcept {
+                return m_data.size();
+            }
+
+            /**
+             * Get the raw bitmap data of chunk n. Bit (x % 8) of byte
+             * (x / 8) stands for the Id at position x in the chunk. Used
+             * for serialization.
+             *
+             * @returns Pointer to chunk_size bytes or nullptr if the chunk
+             *          is not allocated.
+             */
+            const unsigned char* chunk(std::size_t n) const noexcept {
+                assert(n < m_data.size());
+                return m_data[n].get();
+            }
+
         }; // class IdSetDense
 
         /**
@@ -402,6 +669,19 @@ namespace osmium {
                 return it != m_data.cend();
             }
 
+            /**
+             * Is any Id in the range [first, last] (both inclusive) in
+             * the set? Uses linear search.
+             *
+             * @pre @code first <= last @endcode
+             */
+            bool any_in_range(T first, T last) const noexcept final {
+                assert(first <= last);
+                return std::any_of(m_data.cbegin(), m_data.cend(), [first, last](T id) {
+                    return id >= first && id <= last;
+                });
+            }
+
             /**
              * Is the Id in the set? Uses a binary search. For larger sets
              * this might be more efficient than calling get(), the set
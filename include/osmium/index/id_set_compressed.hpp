@@ -0,0 +1,667 @@
+#ifndef OSMIUM_INDEX_ID_SET_COMPRESSED_HPP
+#define OSMIUM_INDEX_ID_SET_COMPRESSED_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            inline bool roaring_array_get(const uint16_t* first, const uint16_t* last, uint32_t value) noexcept {
+                return std::binary_search(first, last, static_cast<uint16_t>(value));
+            }
+
+            inline bool roaring_bitmap_get(const uint64_t* bitmap, uint32_t value) noexcept {
+                return (bitmap[value >> 6U] & (1ULL << (value & 0x3fU))) != 0;
+            }
+
+            // Index of the run containing the value or the first run
+            // after the value. Runs are stored as pairs of
+            // (start, length - 1).
+            inline std::size_t roaring_find_run(const uint16_t* runs, std::size_t num_runs, uint32_t value) noexcept {
+                std::size_t first = 0;
+                std::size_t last = num_runs;
+                while (first < last) {
+                    const std::size_t mid = first + (last - first) / 2;
+                    if (static_cast<uint32_t>(runs[mid * 2]) + runs[mid * 2 + 1] < value) {
+                        first = mid + 1;
+                    } else {
+                        last = mid;
+                    }
+                }
+                return first;
+            }
+
+            inline bool roaring_runs_get(const uint16_t* runs, std::size_t num_runs, uint32_t value) noexcept {
+                const auto n = roaring_find_run(runs, num_runs, value);
+                return n < num_runs && runs[n * 2] <= value;
+            }
+
+            /**
+             * Container for the lower 16 bits of the Ids in one block of
+             * an IdSetCompressed. Like in roaring bitmaps the values are
+             * stored in one of three ways depending on what needs the least
+             * memory: as sorted array of values, as bitmap with 65536 bits,
+             * or as sorted list of runs of consecutive values.
+             */
+            class roaring_container {
+
+            public:
+
+                enum class container_type : uint8_t {
+                    array  = 0,
+                    bitmap = 1,
+                    run    = 2
+                };
+
+                enum : uint32_t {
+                    /// Number of different values in a container.
+                    max_values = 1U << 16U,
+
+                    /// Maximum number of values in an array container.
+                    max_array_size = 4096U,
+
+                    /// Number of 64bit words in a bitmap container.
+                    bitmap_words = max_values / 64U
+                };
+
+            private:
+
+                // For array containers the values, for run containers
+                // pairs of (start, length - 1).
+                std::vector<uint16_t> m_data;
+
+                // Bits for bitmap containers.
+                std::vector<uint64_t> m_bitmap;
+
+                uint32_t m_count = 0;
+
+                container_type m_type = container_type::array;
+
+                std::size_t num_runs() const noexcept {
+                    return m_data.size() / 2;
+                }
+
+                uint16_t run_start(std::size_t n) const noexcept {
+                    return m_data[n * 2];
+                }
+
+                uint32_t run_end(std::size_t n) const noexcept {
+                    return static_cast<uint32_t>(m_data[n * 2]) + m_data[n * 2 + 1];
+                }
+
+                std::size_t find_run(uint32_t value) const noexcept {
+                    return roaring_find_run(m_data.data(), num_runs(), value);
+                }
+
+                // Call func(value) for each value in the container in order.
+                template <typename TFunc>
+                void for_each(TFunc&& func) const {
+                    switch (m_type) {
+                        case container_type::array:
+                            for (const auto value : m_data) {
+                                func(static_cast<uint32_t>(value));
+                            }
+                            break;
+                        case container_type::bitmap:
+                            for (uint32_t word = 0; word < bitmap_words; ++word) {
+                                uint64_t bits = m_bitmap[word];
+                                while (bits != 0) {
+                                    func(word * 64U + ctz64(bits));
+                                    bits &= bits - 1;
+                                }
+                            }
+                            break;
+                        case container_type::run:
+                            for (std::size_t n = 0; n < num_runs(); ++n) {
+                                for (uint32_t value = run_start(n); value <= run_end(n); ++value) {
+                                    func(value);
+                                }
+                            }
+                            break;
+                    }
+                }
+
+                void convert_to_array() {
+                    std::vector<uint16_t> data;
+                    data.reserve(m_count);
+                    for_each([&data](uint32_t value) {
+                        data.push_back(static_cast<uint16_t>(value));
+                    });
+                    using std::swap;
+                    swap(m_data, data);
+                    m_bitmap.clear();
+                    m_bitmap.shrink_to_fit();
+                    m_type = container_type::array;
+                }
+
+                void convert_to_bitmap() {
+                    std::vector<uint64_t> bitmap(bitmap_words, 0);
+                    for_each([&bitmap](uint32_t value) {
+                        bitmap[value >> 6U] |= 1ULL << (value & 0x3fU);
+                    });
+                    using std::swap;
+                    swap(m_bitmap, bitmap);
+                    m_data.clear();
+                    m_data.shrink_to_fit();
+                    m_type = container_type::bitmap;
+                }
+
+                void convert_to_runs() {
+                    std::vector<uint16_t> data;
+                    for_each([&data](uint32_t value) {
+                        if (!data.empty() && static_cast<uint32_t>(data[data.size() - 2]) + data.back() + 1 == value) {
+                            ++data.back();
+                        } else {
+                            data.push_back(static_cast<uint16_t>(value));
+                            data.push_back(0);
+                        }
+                    });
+                    data.shrink_to_fit();
+                    using std::swap;
+                    swap(m_data, data);
+                    m_bitmap.clear();
+                    m_bitmap.shrink_to_fit();
+                    m_type = container_type::run;
+                }
+
+                // Run containers are converted for modification.
+                void make_modifiable() {
+                    if (m_type == container_type::run) {
+                        if (m_count > max_array_size) {
+                            convert_to_bitmap();
+                        } else {
+                            convert_to_array();
+                        }
+                    }
+                }
+
+            public:
+
+                container_type type() const noexcept {
+                    return m_type;
+                }
+
+                /// The number of values in this container.
+                uint32_t count() const noexcept {
+                    return m_count;
+                }
+
+                bool get(uint32_t value) const noexcept {
+                    assert(value < max_values);
+                    switch (m_type) {
+                        case container_type::array:
+                            return roaring_array_get(m_data.data(), m_data.data() + m_data.size(), value);
+                        case container_type::bitmap:
+                            return roaring_bitmap_get(m_bitmap.data(), value);
+                        case container_type::run:
+                            return roaring_runs_get(m_data.data(), num_runs(), value);
+                    }
+                    return false;
+                }
+
+                /**
+                 * Add value to the container.
+                 *
+                 * @returns true if the value was added, false if it was
+                 *          already in the container.
+                 */
+                bool set(uint32_t value) {
+                    assert(value < max_values);
+                    if (get(value)) {
+                        return false;
+                    }
+                    make_modifiable();
+                    if (m_type == container_type::array) {
+                        if (m_data.size() == max_array_size) {
+                            convert_to_bitmap();
+                        } else {
+                            if (m_data.empty() || m_data.back() < value) {
+                                m_data.push_back(static_cast<uint16_t>(value));
+                            } else {
+                                m_data.insert(std::lower_bound(m_data.begin(), m_data.end(), static_cast<uint16_t>(value)), static_cast<uint16_t>(value));
+                            }
+                            ++m_count;
+                            return true;
+                        }
+                    }
+                    m_bitmap[value >> 6U] |= 1ULL << (value & 0x3fU);
+                    ++m_count;
+                    return true;
+                }
+
+                /**
+                 * Remove value from the container.
+                 *
+                 * @returns true if the value was removed, false if it was
+                 *          not in the container.
+                 */
+                bool unset(uint32_t value) {
+                    assert(value < max_values);
+                    if (!get(value)) {
+                        return false;
+                    }
+                    make_modifiable();
+                    --m_count;
+                    if (m_type == container_type::array) {
+                        m_data.erase(std::lower_bound(m_data.begin(), m_data.end(), static_cast<uint16_t>(value)));
+                        return true;
+                    }
+                    m_bitmap[value >> 6U] &= ~(1ULL << (value & 0x3fU));
+                    if (m_count <= max_array_size) {
+                        convert_to_array();
+                    }
+                    return true;
+                }
+
+                /**
+                 * Get the first value equal to or larger than the given
+                 * value.
+                 *
+                 * @returns value or max_values if there is none.
+                 */
+                uint32_t next(uint32_t value) const noexcept {
+                    switch (m_type) {
+                        case container_type::array: {
+                                const auto it = std::lower_bound(m_data.cbegin(), m_data.cend(), value, [](uint16_t a, uint32_t b) {
+                                    return a < b;
+                                });
+                                return it == m_data.cend() ? static_cast<uint32_t>(max_values) : *it;
+                            }
+                        case container_type::bitmap:
+                            while (value < max_values) {
+                                const uint64_t bits = m_bitmap[value >> 6U] >> (value & 0x3fU);
+                                if (bits != 0) {
+                                    return value + ctz64(bits);
+                                }
+                                value = (value | 0x3fU) + 1;
+                            }
+                            break;
+                        case container_type::run: {
+                                const auto n = find_run(value);
+                                if (n < num_runs()) {
+                                    return std::max(value, static_cast<uint32_t>(run_start(n)));
+                                }
+                            }
+                            break;
+                    }
+                    return max_values;
+                }
+
+                /**
+                 * Convert the container into the representation using the
+                 * least amount of memory.
+                 */
+                void optimize() {
+                    std::size_t runs = 0;
+                    uint32_t last = max_values + 1;
+                    for_each([&](uint32_t value) {
+                        if (value != last + 1) {
+                            ++runs;
+                        }
+                        last = value;
+                    });
+
+                    const std::size_t run_bytes = runs * 2 * sizeof(uint16_t);
+                    const std::size_t array_bytes = m_count * sizeof(uint16_t);
+                    const std::size_t bitmap_bytes = bitmap_words * sizeof(uint64_t);
+
+                    if (run_bytes < array_bytes && run_bytes < bitmap_bytes) {
+                        if (m_type != container_type::run) {
+                            convert_to_runs();
+                        }
+                    } else if (m_count <= max_array_size) {
+                        if (m_type != container_type::array) {
+                            convert_to_array();
+                        }
+                        m_data.shrink_to_fit();
+                    } else if (m_type != container_type::bitmap) {
+                        convert_to_bitmap();
+                    }
+                }
+
+                /**
+                 * The values of an array container or the runs as pairs
+                 * of (start, length - 1) of a run container. Empty for
+                 * bitmap containers. Used for serialization.
+                 */
+                const std::vector<uint16_t>& data() const noexcept {
+                    return m_data;
+                }
+
+                /**
+                 * The bits of a bitmap container. Empty for other
+                 * containers. Used for serialization.
+                 */
+                const std::vector<uint64_t>& bitmap() const noexcept {
+                    return m_bitmap;
+                }
+
+                std::size_t used_memory() const noexcept {
+                    return m_data.capacity() * sizeof(uint16_t) + m_bitmap.capacity() * sizeof(uint64_t);
+                }
+
+            }; // class roaring_container
+
+        } // namespace detail
+
+        template <typename T>
+        class IdSetCompressed;
+
+        /**
+         * Const_iterator for iterating over a IdSetCompressed.
+         */
+        template <typename T>
+        class IdSetCompressedIterator {
+
+            using id_set = IdSetCompressed<T>;
+
+            const id_set* m_set;
+            std::size_t m_block;
+            uint32_t m_value;
+
+            void next() noexcept {
+                while (m_block < m_set->m_blocks.size()) {
+                    m_value = m_set->m_blocks[m_block].container.next(m_value);
+                    if (m_value < detail::roaring_container::max_values) {
+                        return;
+                    }
+                    ++m_block;
+                    m_value = 0;
+                }
+                m_value = 0;
+            }
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            IdSetCompressedIterator(const id_set* set, std::size_t block) noexcept :
+                m_set(set),
+                m_block(block),
+                m_value(0) {
+                next();
+            }
+
+            IdSetCompressedIterator& operator++() noexcept {
+                if (m_block < m_set->m_blocks.size()) {
+                    ++m_value;
+                    next();
+                }
+                return *this;
+            }
+
+            IdSetCompressedIterator operator++(int) noexcept {
+                IdSetCompressedIterator tmp{*this};
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const IdSetCompressedIterator& rhs) const noexcept {
+                return m_set == rhs.m_set && m_block == rhs.m_block && m_value == rhs.m_value;
+            }
+
+            bool operator!=(const IdSetCompressedIterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            T operator*() const noexcept {
+                assert(m_block < m_set->m_blocks.size());
+                return (m_set->m_blocks[m_block].key << 16U) | m_value;
+            }
+
+        }; // class IdSetCompressedIterator
+
+        /**
+         * A set of Ids of the given type using compressed storage similar
+         * to roaring bitmaps. The Ids are split into blocks of 65536 Ids,
+         * each block stores the lower 16 bits of its Ids as sorted array,
+         * bitmap, or list of runs. Only blocks containing Ids are stored.
+         *
+         * This needs only a fraction of the memory of an IdSetDense for
+         * sparse or clustered sets (for instance all nodes in a small
+         * region) while still having fast lookups. Call optimize() after
+         * adding all Ids to convert blocks into runs where this saves
+         * memory.
+         *
+         * Setting Ids in ascending order is fastest.
+         */
+        template <typename T>
+        class IdSetCompressed : public IdSet<T> {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+
+            friend class IdSetCompressedIterator<T>;
+
+            struct block {
+                T key;
+                detail::roaring_container container;
+
+                explicit block(T k) :
+                    key(k),
+                    container() {
+                }
+            };
+
+            std::vector<block> m_blocks;
+            T m_size = 0;
+
+            static T key_of(T id) noexcept {
+                return id >> 16U;
+            }
+
+            static uint32_t value_of(T id) noexcept {
+                return static_cast<uint32_t>(id & 0xffffU);
+            }
+
+            const block* find_block(T key) const noexcept {
+                if (!m_blocks.empty() && m_blocks.back().key == key) {
+                    return &m_blocks.back();
+                }
+                const auto it = std::lower_bound(m_blocks.cbegin(), m_blocks.cend(), key, [](const block& b, T k) {
+                    return b.key < k;
+                });
+                if (it == m_blocks.cend() || it->key != key) {
+                    return nullptr;
+                }
+                return &*it;
+            }
+
+            block& get_block(T key) {
+                if (m_blocks.empty() || m_blocks.back().key < key) {
+                    m_blocks.emplace_back(key);
+                    return m_blocks.back();
+                }
+                if (m_blocks.back().key == key) {
+                    return m_blocks.back();
+                }
+                const auto it = std::lower_bound(m_blocks.begin(), m_blocks.end(), key, [](const block& b, T k) {
+                    return b.key < k;
+                });
+                if (it != m_blocks.end() && it->key == key) {
+                    return *it;
+                }
+                return *m_blocks.emplace(it, key);
+            }
+
+        public:
+
+            using const_iterator = IdSetCompressedIterator<T>;
+
+            /**
+             * Add the Id to the set if it is not already in there.
+             *
+             * @param id The Id to set.
+             * @returns true if the Id was added, false if it was already set.
+             */
+            bool check_and_set(T id) {
+                if (get_block(key_of(id)).container.set(value_of(id))) {
+                    ++m_size;
+                    return true;
+                }
+                return false;
+            }
+
+            /**
+             * Add the given Id to the set.
+             *
+             * @param id The Id to set.
+             */
+            void set(T id) final {
+                (void)check_and_set(id);
+            }
+
+            /**
+             * Remove the given Id from the set.
+             *
+             * @param id The Id to remove.
+             */
+            void unset(T id) {
+                const auto* b = find_block(key_of(id));
+                if (b && const_cast<block*>(b)->container.unset(value_of(id))) { // NOLINT(cppcoreguidelines-pro-type-const-cast)
+                    --m_size;
+                }
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept final {
+                const auto* b = find_block(key_of(id));
+                return b && b->container.get(value_of(id));
+            }
+
+            /**
+             * Is the set empty?
+             */
+            bool empty() const noexcept final {
+                return m_size == 0;
+            }
+
+            /**
+             * The number of Ids stored in the set.
+             */
+            T size() const noexcept {
+                return m_size;
+            }
+
+            /**
+             * Clear the set.
+             */
+            void clear() final {
+                m_blocks.clear();
+                m_blocks.shrink_to_fit();
+                m_size = 0;
+            }
+
+            /**
+             * Convert all blocks into the representation that needs the
+             * least amount of memory and remove empty blocks. Call this
+             * after all Ids have been set.
+             */
+            void optimize() {
+                m_blocks.erase(std::remove_if(m_blocks.begin(), m_blocks.end(), [](const block& b) {
+                    return b.container.count() == 0;
+                }), m_blocks.end());
+                for (auto& b : m_blocks) {
+                    b.container.optimize();
+                }
+                m_blocks.shrink_to_fit();
+            }
+
+            std::size_t used_memory() const noexcept final {
+                std::size_t memory = m_blocks.capacity() * sizeof(block);
+                for (const auto& b : m_blocks) {
+                    memory += b.container.used_memory();
+                }
+                return memory;
+            }
+
+            const_iterator begin() const {
+                return {this, 0};
+            }
+
+            const_iterator end() const {
+                return {this, m_blocks.size()};
+            }
+
+            /**
+             * The number of blocks in this set. Used for serialization.
+             */
+            std::size_t num_blocks() const noexcept {
+                return m_blocks.size();
+            }
+
+            /**
+             * The key (Id >> 16) of block n. Used for serialization.
+             */
+            T block_key(std::size_t n) const noexcept {
+                assert(n < m_blocks.size());
+                return m_blocks[n].key;
+            }
+
+            /**
+             * The container of block n. Used for serialization.
+             */
+            const detail::roaring_container& block_container(std::size_t n) const noexcept {
+                assert(n < m_blocks.size());
+                return m_blocks[n].container;
+            }
+
+        }; // class IdSetCompressed
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_SET_COMPRESSED_HPP
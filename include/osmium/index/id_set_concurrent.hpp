@@ -0,0 +1,369 @@
+#ifndef OSMIUM_INDEX_ID_SET_CONCURRENT_HPP
+#define OSMIUM_INDEX_ID_SET_CONCURRENT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * A set of Ids of the given type which can be filled from several
+         * threads at the same time. Storage is the same as in IdSetDense:
+         * chunks of bit fields allocated as needed. But the chunk
+         * directory has a fixed size, new chunks are installed with a
+         * compare-and-swap, and bits are set with an atomic fetch_or on
+         * 64bit words, so no locks are needed at all.
+         *
+         * The functions set(), check_and_set(), get(), and any_in_range()
+         * can be called concurrently. All other functions must only be
+         * called when no other thread is accessing the set. Use merge_into()
+         * after all threads are done to get a normal IdSetDense.
+         *
+         * The set can hold Ids up to (but not including) the max_id given
+         * in the constructor. The directory needs 8 bytes for every
+         * 2^(chunk_bits + 3) Ids even if nothing is stored in the set.
+         */
+        template <typename T, std::size_t chunk_bits = detail::default_chunk_bits>
+        class ConcurrentIdSetDense : public IdSet<T> {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+            static_assert(chunk_bits >= 3, "Chunks must be at least 8 bytes");
+
+            enum : std::size_t {
+                chunk_size = 1U << chunk_bits,
+                chunk_words = chunk_size / 8,
+                ids_per_chunk = chunk_size * 8
+            };
+
+            using word_type = std::atomic<uint64_t>;
+
+            std::unique_ptr<std::atomic<word_type*>[]> m_chunks;
+            std::size_t m_num_chunks;
+
+            static std::size_t chunk_id(T id) noexcept {
+                return static_cast<std::size_t>(id >> (chunk_bits + 3U));
+            }
+
+            static std::size_t word_offset(T id) noexcept {
+                return static_cast<std::size_t>((id >> 6U) & (chunk_words - 1));
+            }
+
+            static uint64_t bitmask(T id) noexcept {
+                return 1ULL << (id & 0x3fU);
+            }
+
+            word_type* chunk(std::size_t cid) const noexcept {
+                return m_chunks[cid].load(std::memory_order_acquire);
+            }
+
+            word_type* get_chunk(T id) {
+                const auto cid = chunk_id(id);
+                if (cid >= m_num_chunks) {
+                    throw std::out_of_range{"Id too large for ConcurrentIdSetDense"};
+                }
+
+                word_type* data = chunk(cid);
+                if (data) {
+                    return data;
+                }
+
+                // Several threads might get here at the same time for the
+                // same chunk. Only one of them wins, the others throw away
+                // their allocation and use the installed chunk.
+                std::unique_ptr<word_type[]> new_chunk{new word_type[chunk_words]};
+                for (std::size_t i = 0; i < chunk_words; ++i) {
+                    new_chunk[i].store(0, std::memory_order_relaxed);
+                }
+                if (m_chunks[cid].compare_exchange_strong(data, new_chunk.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    return new_chunk.release();
+                }
+                return data;
+            }
+
+            void release_chunks() noexcept {
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    delete[] m_chunks[cid].exchange(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+        public:
+
+            /**
+             * Create an empty set.
+             *
+             * @param max_id All Ids stored must be smaller than this. The
+             *               default of 2^36 (about 68 billion) is enough
+             *               for OSM object Ids for years to come.
+             */
+            explicit ConcurrentIdSetDense(std::size_t max_id = 1ULL << 36U) :
+                m_chunks(),
+                m_num_chunks((max_id + ids_per_chunk - 1) / ids_per_chunk) {
+                m_chunks.reset(new std::atomic<word_type*>[m_num_chunks]);
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    m_chunks[cid].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            ConcurrentIdSetDense(const ConcurrentIdSetDense&) = delete;
+            ConcurrentIdSetDense& operator=(const ConcurrentIdSetDense&) = delete;
+
+            ConcurrentIdSetDense(ConcurrentIdSetDense&&) = delete;
+            ConcurrentIdSetDense& operator=(ConcurrentIdSetDense&&) = delete;
+
+            ~ConcurrentIdSetDense() noexcept override {
+                release_chunks();
+            }
+
+            /**
+             * Add the Id to the set if it is not already in there. Can be
+             * called from several threads at the same time. If several
+             * threads add the same Id, exactly one of them gets true.
+             *
+             * @param id The Id to set.
+             * @returns true if the Id was added, false if it was already set.
+             * @throws std::out_of_range if the Id is not smaller than the
+             *         max_id set in the constructor.
+             */
+            bool check_and_set(T id) {
+                word_type& word = get_chunk(id)[word_offset(id)];
+                const uint64_t mask = bitmask(id);
+
+                // Avoid the (expensive) atomic write if the bit is already
+                // set, which is common when collecting referenced Ids.
+                if ((word.load(std::memory_order_relaxed) & mask) != 0) {
+                    return false;
+                }
+                return (word.fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+            }
+
+            /**
+             * Add the given Id to the set. Can be called from several
+             * threads at the same time.
+             *
+             * @param id The Id to set.
+             * @throws std::out_of_range if the Id is not smaller than the
+             *         max_id set in the constructor.
+             */
+            void set(T id) final {
+                (void)check_and_set(id);
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept final {
+                const auto cid = chunk_id(id);
+                if (cid >= m_num_chunks) {
+                    return false;
+                }
+                const word_type* data = chunk(cid);
+                if (!data) {
+                    return false;
+                }
+                return (data[word_offset(id)].load(std::memory_order_relaxed) & bitmask(id)) != 0;
+            }
+
+            /**
+             * Is any Id in the range [first, last] (both inclusive) in
+             * the set? Chunks that are not allocated are skipped, the
+             * others are checked 64 bits at a time.
+             *
+             * @pre @code first <= last @endcode
+             */
+            bool any_in_range(T first, T last) const noexcept final {
+                assert(first <= last);
+                T id = first;
+                while (true) {
+                    const auto cid = chunk_id(id);
+                    if (cid >= m_num_chunks) {
+                        return false;
+                    }
+                    const T chunk_last = static_cast<T>((cid + 1) * ids_per_chunk - 1);
+                    const T end = std::min(last, chunk_last);
+                    const word_type* data = chunk(cid);
+                    if (data) {
+                        const std::size_t first_word = word_offset(id);
+                        const std::size_t last_word = word_offset(end);
+                        for (std::size_t w = first_word; w <= last_word; ++w) {
+                            uint64_t word = data[w].load(std::memory_order_relaxed);
+                            if (w == first_word) {
+                                word &= ~0ULL << (id & 0x3fU);
+                            }
+                            if (w == last_word) {
+                                word &= ~0ULL >> (63U - (end & 0x3fU));
+                            }
+                            if (word != 0) {
+                                return true;
+                            }
+                        }
+                    }
+                    if (end == last) {
+                        return false;
+                    }
+                    id = end + 1;
+                }
+            }
+
+            /**
+             * Is the set empty? This has to look at all allocated chunks.
+             */
+            bool empty() const noexcept final {
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    const word_type* data = chunk(cid);
+                    if (!data) {
+                        continue;
+                    }
+                    for (std::size_t i = 0; i < chunk_words; ++i) {
+                        if (data[i].load(std::memory_order_relaxed) != 0) {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            }
+
+            /**
+             * The number of Ids stored in the set. There is no shared
+             * counter, because it would be a point of contention between
+             * threads, so this has to count the bits in all allocated
+             * chunks.
+             */
+            T size() const noexcept {
+                T count = 0;
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    const word_type* data = chunk(cid);
+                    if (!data) {
+                        continue;
+                    }
+                    for (std::size_t i = 0; i < chunk_words; ++i) {
+                        count += detail::popcount64(data[i].load(std::memory_order_relaxed));
+                    }
+                }
+                return count;
+            }
+
+            /**
+             * Clear the set. Must not be called while other threads are
+             * accessing the set.
+             */
+            void clear() final {
+                release_chunks();
+            }
+
+            std::size_t used_memory() const noexcept final {
+                std::size_t memory = m_num_chunks * sizeof(std::atomic<word_type*>);
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    if (chunk(cid)) {
+                        memory += chunk_size;
+                    }
+                }
+                return memory;
+            }
+
+            /**
+             * Call func(id) for each Id in the set in order. Must not be
+             * called while other threads are changing the set.
+             */
+            template <typename TFunc>
+            void for_each(TFunc&& func) const {
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    const word_type* data = chunk(cid);
+                    if (!data) {
+                        continue;
+                    }
+                    const T base = static_cast<T>(cid * ids_per_chunk);
+                    for (std::size_t i = 0; i < chunk_words; ++i) {
+                        uint64_t word = data[i].load(std::memory_order_relaxed);
+                        while (word != 0) {
+                            func(base + static_cast<T>(i * 64 + detail::ctz64(word)));
+                            word &= word - 1;
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Add all Ids in this set to the IdSetDense (set union). Works
+             * on whole chunks 64 bits at a time. Must not be called while
+             * other threads are changing this set.
+             */
+            void merge_into(IdSetDense<T, chunk_bits>& set) const {
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    const word_type* data = chunk(cid);
+                    if (!data) {
+                        continue;
+                    }
+                    for (std::size_t i = 0; i < chunk_words; ++i) {
+                        uint64_t word = data[i].load(std::memory_order_relaxed);
+                        if (word != 0) {
+                            set.merge_word(static_cast<T>(cid * ids_per_chunk + i * 64), word);
+                        }
+                    }
+                }
+            }
+
+        }; // class ConcurrentIdSetDense
+
+        /**
+         * ConcurrentIdSetDense for nodes, ways, and relations. Use this
+         * to collect referenced Ids from several threads at once:
+         *
+         * @code
+         * osmium::index::ConcurrentNWRIdSetDense ids;
+         * ...
+         * ids(osmium::item_type::node).set(node_ref.positive_ref());
+         * @endcode
+         */
+        using ConcurrentNWRIdSetDense = osmium::nwr_array<ConcurrentIdSetDense<osmium::unsigned_object_id_type>>;
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_SET_CONCURRENT_HPP
@@ -0,0 +1,439 @@
+#ifndef OSMIUM_INDEX_ID_SET_MAPPED_HPP
+#define OSMIUM_INDEX_ID_SET_MAPPED_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/id_set_compressed.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            enum : uint64_t {
+                // "OSMIDSD" + version
+                id_set_dense_magic      = 0x4f534d4944534401ULL,
+                // "OSMIDSC" + version
+                id_set_compressed_magic = 0x4f534d4944534301ULL
+            };
+
+            enum : std::size_t {
+                id_set_dense_header_words      = 4,
+                id_set_compressed_header_words = 3,
+                id_set_compressed_dir_words    = 3
+            };
+
+            inline void write_words(int fd, const std::vector<uint64_t>& words) {
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+            }
+
+            inline std::size_t words_for_shorts(std::size_t count) noexcept {
+                return (count * sizeof(uint16_t) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+            }
+
+            inline osmium::util::TypedMemoryMapping<uint64_t> map_id_set_file(int fd, uint64_t magic, std::size_t header_words) {
+                const auto size = osmium::file_size(fd);
+                if (size % sizeof(uint64_t) != 0 || size < header_words * sizeof(uint64_t)) {
+                    throw std::runtime_error{"Invalid id set file: wrong size"};
+                }
+                osmium::util::TypedMemoryMapping<uint64_t> mapping{size / sizeof(uint64_t), osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+                if (mapping.begin()[0] != magic) {
+                    throw std::runtime_error{"Invalid id set file: wrong type, version, or byte order"};
+                }
+                return mapping;
+            }
+
+        } // namespace detail
+
+        /**
+         * Write IdSetDense to a file. The file can be opened again with
+         * IdSetDenseMapped which works directly on the mapped file, so
+         * opening even large sets is instant. The file is written in
+         * native byte order.
+         *
+         * File layout (all 64bit words): magic, chunk_bits, number of
+         * Ids, number of chunks, chunk directory with the word offset of
+         * each chunk or 0 for chunks that are not allocated, chunk data.
+         *
+         * @param fd File descriptor open for writing.
+         * @param set The set to write.
+         * @throws std::system_error If the file could not be written.
+         */
+        template <typename T, std::size_t chunk_bits>
+        void write_id_set(int fd, const IdSetDense<T, chunk_bits>& set) {
+            const std::size_t chunk_bytes = std::size_t(1U) << chunk_bits;
+            const std::size_t chunk_words = chunk_bytes / sizeof(uint64_t);
+
+            std::vector<uint64_t> header;
+            header.reserve(detail::id_set_dense_header_words + set.num_chunks());
+            header.push_back(detail::id_set_dense_magic);
+            header.push_back(chunk_bits);
+            header.push_back(set.size());
+            header.push_back(set.num_chunks());
+
+            uint64_t offset = detail::id_set_dense_header_words + set.num_chunks();
+            for (std::size_t n = 0; n < set.num_chunks(); ++n) {
+                if (set.chunk(n)) {
+                    header.push_back(offset);
+                    offset += chunk_words;
+                } else {
+                    header.push_back(0);
+                }
+            }
+            detail::write_words(fd, header);
+
+            for (std::size_t n = 0; n < set.num_chunks(); ++n) {
+                if (set.chunk(n)) {
+                    osmium::io::detail::reliable_write(fd, set.chunk(n), chunk_bytes);
+                }
+            }
+        }
+
+        /**
+         * Write IdSetCompressed to a file. The file can be opened again
+         * with IdSetCompressedMapped. The file is written in native byte
+         * order. Call optimize() on the set before writing it to get the
+         * smallest file.
+         *
+         * File layout (all 64bit words): magic, number of Ids, number of
+         * blocks, block directory with three words per block (key, type
+         * | number of 16bit values << 8, word offset of data), block data
+         * padded to full words.
+         *
+         * @param fd File descriptor open for writing.
+         * @param set The set to write.
+         * @throws std::system_error If the file could not be written.
+         */
+        template <typename T>
+        void write_id_set(int fd, const IdSetCompressed<T>& set) {
+            std::vector<uint64_t> header;
+            header.reserve(detail::id_set_compressed_header_words + set.num_blocks() * detail::id_set_compressed_dir_words);
+            header.push_back(detail::id_set_compressed_magic);
+            header.push_back(set.size());
+            header.push_back(set.num_blocks());
+
+            uint64_t offset = detail::id_set_compressed_header_words + set.num_blocks() * detail::id_set_compressed_dir_words;
+            for (std::size_t n = 0; n < set.num_blocks(); ++n) {
+                const auto& container = set.block_container(n);
+                header.push_back(set.block_key(n));
+                header.push_back(static_cast<uint64_t>(container.type()) | (static_cast<uint64_t>(container.data().size()) << 8U));
+                header.push_back(offset);
+                offset += container.bitmap().size() + detail::words_for_shorts(container.data().size());
+            }
+            detail::write_words(fd, header);
+
+            std::vector<uint64_t> words;
+            for (std::size_t n = 0; n < set.num_blocks(); ++n) {
+                const auto& container = set.block_container(n);
+                if (!container.bitmap().empty()) {
+                    detail::write_words(fd, container.bitmap());
+                }
+                if (!container.data().empty()) {
+                    words.assign(detail::words_for_shorts(container.data().size()), 0);
+                    std::copy(container.data().cbegin(), container.data().cend(), reinterpret_cast<uint16_t*>(words.data()));
+                    detail::write_words(fd, words);
+                }
+            }
+        }
+
+        /**
+         * Read-only IdSet working directly on a memory mapped file written
+         * with write_id_set() from an IdSetDense. The chunk_bits of the
+         * file must match.
+         */
+        template <typename T, std::size_t chunk_bits = detail::default_chunk_bits>
+        class IdSetDenseMapped {
+
+            enum : std::size_t {
+                chunk_size = 1U << chunk_bits
+            };
+
+            osmium::util::TypedMemoryMapping<uint64_t> m_mapping;
+            const uint64_t* m_directory;
+            std::size_t m_num_chunks;
+
+            const unsigned char* chunk(std::size_t n) const noexcept {
+                const auto offset = m_directory[n];
+                if (offset == 0) {
+                    return nullptr;
+                }
+                return reinterpret_cast<const unsigned char*>(m_mapping.begin() + offset);
+            }
+
+        public:
+
+            /**
+             * Open set from file.
+             *
+             * @param fd File descriptor open for reading. The file can be
+             *           closed after the constructor returns.
+             * @throws std::runtime_error If the file is not a valid id set
+             *         file with the right chunk_bits.
+             * @throws std::system_error If the file could not be mapped.
+             */
+            explicit IdSetDenseMapped(int fd) :
+                m_mapping(detail::map_id_set_file(fd, detail::id_set_dense_magic, detail::id_set_dense_header_words)),
+                m_directory(m_mapping.begin() + detail::id_set_dense_header_words),
+                m_num_chunks(m_mapping.begin()[3]) {
+                if (m_mapping.begin()[1] != chunk_bits) {
+                    throw std::runtime_error{"Invalid id set file: wrong chunk size"};
+                }
+                if (m_num_chunks > m_mapping.size() - detail::id_set_dense_header_words) {
+                    throw std::runtime_error{"Invalid id set file: file too short"};
+                }
+                for (std::size_t n = 0; n < m_num_chunks; ++n) {
+                    if (m_directory[n] != 0 && m_directory[n] + chunk_size / sizeof(uint64_t) > m_mapping.size()) {
+                        throw std::runtime_error{"Invalid id set file: file too short"};
+                    }
+                }
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept {
+                const std::size_t cid = id >> (chunk_bits + 3U);
+                if (cid >= m_num_chunks) {
+                    return false;
+                }
+                const auto* data = chunk(cid);
+                if (!data) {
+                    return false;
+                }
+                return (data[(id >> 3U) & (chunk_size - 1U)] & (1U << (id & 0x7U))) != 0;
+            }
+
+            /**
+             * Is the set empty?
+             */
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            /**
+             * The number of Ids stored in the set.
+             */
+            T size() const noexcept {
+                return static_cast<T>(m_mapping.begin()[2]);
+            }
+
+            /**
+             * Call func(id) for each Id in the set in order.
+             */
+            template <typename TFunc>
+            void for_each(TFunc&& func) const {
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    const auto* data = chunk(cid);
+                    if (!data) {
+                        continue;
+                    }
+                    const T base = static_cast<T>(cid) * chunk_size * 8;
+                    for (std::size_t i = 0; i < chunk_size; i += 8) {
+                        uint64_t word = detail::load_bitmap_word(data + i);
+                        while (word != 0) {
+                            func(base + static_cast<T>(i * 8 + detail::ctz64(word)));
+                            word &= word - 1;
+                        }
+                    }
+                }
+            }
+
+        }; // class IdSetDenseMapped
+
+        /**
+         * Read-only IdSet working directly on a memory mapped file written
+         * with write_id_set() from an IdSetCompressed.
+         */
+        template <typename T>
+        class IdSetCompressedMapped {
+
+            using container_type = detail::roaring_container::container_type;
+
+            osmium::util::TypedMemoryMapping<uint64_t> m_mapping;
+            const uint64_t* m_directory;
+            std::size_t m_num_blocks;
+
+            const uint64_t* find_block(T key) const noexcept {
+                std::size_t first = 0;
+                std::size_t last = m_num_blocks;
+                while (first < last) {
+                    const std::size_t mid = first + (last - first) / 2;
+                    const auto* entry = m_directory + mid * detail::id_set_compressed_dir_words;
+                    if (entry[0] < key) {
+                        first = mid + 1;
+                    } else if (entry[0] > key) {
+                        last = mid;
+                    } else {
+                        return entry;
+                    }
+                }
+                return nullptr;
+            }
+
+            static container_type entry_type(const uint64_t* entry) noexcept {
+                return static_cast<container_type>(entry[1] & 0xffU);
+            }
+
+            static std::size_t entry_num_values(const uint64_t* entry) noexcept {
+                return static_cast<std::size_t>(entry[1] >> 8U);
+            }
+
+            const uint64_t* entry_data(const uint64_t* entry) const noexcept {
+                return m_mapping.begin() + entry[2];
+            }
+
+            const uint16_t* entry_shorts(const uint64_t* entry) const noexcept {
+                return reinterpret_cast<const uint16_t*>(entry_data(entry));
+            }
+
+        public:
+
+            /**
+             * Open set from file.
+             *
+             * @param fd File descriptor open for reading. The file can be
+             *           closed after the constructor returns.
+             * @throws std::runtime_error If the file is not a valid id set
+             *         file.
+             * @throws std::system_error If the file could not be mapped.
+             */
+            explicit IdSetCompressedMapped(int fd) :
+                m_mapping(detail::map_id_set_file(fd, detail::id_set_compressed_magic, detail::id_set_compressed_header_words)),
+                m_directory(m_mapping.begin() + detail::id_set_compressed_header_words),
+                m_num_blocks(m_mapping.begin()[2]) {
+                if (m_num_blocks > (m_mapping.size() - detail::id_set_compressed_header_words) / detail::id_set_compressed_dir_words) {
+                    throw std::runtime_error{"Invalid id set file: file too short"};
+                }
+                for (std::size_t n = 0; n < m_num_blocks; ++n) {
+                    const auto* entry = m_directory + n * detail::id_set_compressed_dir_words;
+                    const std::size_t words = entry_type(entry) == container_type::bitmap
+                                              ? static_cast<std::size_t>(detail::roaring_container::bitmap_words)
+                                              : detail::words_for_shorts(entry_num_values(entry));
+                    if (entry_type(entry) > container_type::run || entry[2] + words > m_mapping.size()) {
+                        throw std::runtime_error{"Invalid id set file: file too short or corrupt"};
+                    }
+                }
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept {
+                const auto* entry = find_block(id >> 16U);
+                if (!entry) {
+                    return false;
+                }
+                const auto value = static_cast<uint32_t>(id & 0xffffU);
+                switch (entry_type(entry)) {
+                    case container_type::array:
+                        return detail::roaring_array_get(entry_shorts(entry), entry_shorts(entry) + entry_num_values(entry), value);
+                    case container_type::bitmap:
+                        return detail::roaring_bitmap_get(entry_data(entry), value);
+                    case container_type::run:
+                        return detail::roaring_runs_get(entry_shorts(entry), entry_num_values(entry) / 2, value);
+                }
+                return false;
+            }
+
+            /**
+             * Is the set empty?
+             */
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            /**
+             * The number of Ids stored in the set.
+             */
+            T size() const noexcept {
+                return static_cast<T>(m_mapping.begin()[1]);
+            }
+
+            /**
+             * Call func(id) for each Id in the set in order.
+             */
+            template <typename TFunc>
+            void for_each(TFunc&& func) const {
+                for (std::size_t n = 0; n < m_num_blocks; ++n) {
+                    const auto* entry = m_directory + n * detail::id_set_compressed_dir_words;
+                    const T base = static_cast<T>(entry[0]) << 16U;
+                    const auto* shorts = entry_shorts(entry);
+                    switch (entry_type(entry)) {
+                        case container_type::array:
+                            for (std::size_t i = 0; i < entry_num_values(entry); ++i) {
+                                func(base | shorts[i]);
+                            }
+                            break;
+                        case container_type::bitmap:
+                            for (std::size_t i = 0; i < detail::roaring_container::bitmap_words; ++i) {
+                                uint64_t word = entry_data(entry)[i];
+                                while (word != 0) {
+                                    func(base | static_cast<T>(i * 64 + detail::ctz64(word)));
+                                    word &= word - 1;
+                                }
+                            }
+                            break;
+                        case container_type::run:
+                            for (std::size_t i = 0; i < entry_num_values(entry); i += 2) {
+                                const uint32_t end = static_cast<uint32_t>(shorts[i]) + shorts[i + 1];
+                                for (uint32_t value = shorts[i]; value <= end; ++value) {
+                                    func(base | value);
+                                }
+                            }
+                            break;
+                    }
+                }
+            }
+
+        }; // class IdSetCompressedMapped
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_SET_MAPPED_HPP
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/util/memory_mapping.hpp>
 #include <osmium/util/string.hpp>
 
 #include <algorithm>
@@ -122,9 +123,39 @@ namespace osmium {
                     // default implementation is empty
                 }
 
+                /**
+                 * Prepare the map for the given number of entries with ids
+                 * up to max_id, for instance from the object counts in the
+                 * file header. Dense maps reserve space by id, sparse maps
+                 * by number of entries, and maps that can do both decide
+                 * on the mode up front. The default implementation calls
+                 * reserve(count).
+                 *
+                 * @param count The number of entries expected.
+                 * @param max_id The largest id expected.
+                 */
+                virtual void presize(const std::size_t count, const TId /*max_id*/) {
+                    reserve(count);
+                }
+
                 /// Set the field with id to value.
                 virtual void set(const TId id, const TValue value) = 0;
 
+                /**
+                 * Set the values for several ids at once. This is the same
+                 * as calling set() for each id, but some implementations
+                 * can do this faster.
+                 *
+                 * @param ids Pointer to the ids.
+                 * @param values Pointer to the values.
+                 * @param count Number of ids (and values).
+                 */
+                virtual void set_many(const TId* ids, const TValue* values, const std::size_t count) {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        set(ids[i], values[i]);
+                    }
+                }
+
                 /**
                  * Retrieve value by id.
                  *
@@ -145,6 +176,23 @@ namespace osmium {
                  */
                 virtual TValue get_noexcept(const TId id) const noexcept = 0;
 
+                /**
+                 * Retrieve values for several ids at once. This is the same
+                 * as calling get_noexcept() for each id, but some
+                 * implementations can do this faster, for instance by
+                 * prefetching the memory for the next ids.
+                 *
+                 * @param ids Pointer to the ids to look for.
+                 * @param values Pointer to where the values will be written.
+                 *               Ids that are not found get the empty value.
+                 * @param count Number of ids (and values).
+                 */
+                virtual void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        values[i] = get_noexcept(ids[i]);
+                    }
+                }
+
                 /**
                  * Get the approximate number of items in the storage. The storage
                  * might allocate memory in blocks, so this size might not be
@@ -176,6 +224,57 @@ namespace osmium {
                     // default implementation is empty
                 }
 
+                /**
+                 * Build additional structures speeding up get() on large
+                 * maps. Call this after sort() when the map will be
+                 * used for lots of lookups. Changing the map again
+                 * removes them. Not all implementations need this.
+                 */
+                virtual void build_search_layout() {
+                    // default implementation is empty
+                }
+
+                /**
+                 * Tell the map how it is going to be accessed next, for
+                 * instance access_hint::sequential while it is filled
+                 * with ids in order and access_hint::random for lookups
+                 * afterwards. Maps based on memory mappings pass this on
+                 * to the kernel which adapts its readahead. This matters
+                 * most for file-backed maps larger than the main memory.
+                 * Not all implementations need this.
+                 */
+                virtual void set_access_hint(const osmium::MemoryMapping::access_hint /*hint*/) {
+                    // default implementation is empty
+                }
+
+                /**
+                 * Update the value for the id in an existing map, for
+                 * instance from a change file. Unlike set() this can be
+                 * used for ids already in the map. Set the value to the
+                 * empty value (see osmium::index::empty_value()) to remove
+                 * the id from the map.
+                 *
+                 * Call commit_updates() after all updates and before
+                 * reading from the map again. The result of lookups before
+                 * that is unspecified.
+                 *
+                 * The default implementation calls set(), which works for
+                 * all maps where set() overwrites existing values.
+                 */
+                virtual void update(const TId id, const TValue value) {
+                    set(id, value);
+                }
+
+                /**
+                 * Make all changes done with update() visible. If the same
+                 * id was updated several times, the last value is used.
+                 *
+                 * The default implementation calls sort().
+                 */
+                virtual void commit_updates() {
+                    sort();
+                }
+
                 // This function can usually be const in derived classes,
                 // but not always. It could, for instance, sort internal data.
                 // This is why it is not declared const here.
@@ -33,11 +33,17 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/map/compact_sparse_mem_array.hpp> // IWYU pragma: keep
+#include <osmium/index/map/compressed_sparse_mem_array.hpp> // IWYU pragma: keep
+#include <osmium/index/map/concurrent_dense_mmap_array.hpp> // IWYU pragma: keep
 #include <osmium/index/map/dense_file_array.hpp>  // IWYU pragma: keep
 #include <osmium/index/map/dense_mem_array.hpp>   // IWYU pragma: keep
 #include <osmium/index/map/dense_mmap_array.hpp>  // IWYU pragma: keep
 #include <osmium/index/map/dummy.hpp>             // IWYU pragma: keep
+#include <osmium/index/map/flat_hash_map.hpp>     // IWYU pragma: keep
 #include <osmium/index/map/flex_mem.hpp>          // IWYU pragma: keep
+#include <osmium/index/map/mapped_file_map.hpp>   // IWYU pragma: keep
+#include <osmium/index/map/quantized_dense_mem_array.hpp> // IWYU pragma: keep
 #include <osmium/index/map/sparse_file_array.hpp> // IWYU pragma: keep
 #include <osmium/index/map/sparse_mem_array.hpp>  // IWYU pragma: keep
 #include <osmium/index/map/sparse_mem_map.hpp>    // IWYU pragma: keep
@@ -0,0 +1,282 @@
+#ifndef OSMIUM_INDEX_MAP_COMPACT_SPARSE_MEM_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_COMPACT_SPARSE_MEM_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_COMPACT_SPARSE_MEM_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Sparse map from ids to values which only stores the lower 32
+             * bits of each id together with the value. The upper bits are
+             * kept in a directory with one entry for each run of ids with
+             * the same upper bits. For locations this needs 12 bytes per
+             * entry instead of the 16 bytes of the SparseMemArray, lookups
+             * are a binary search in the (tiny) directory and then in the
+             * run found.
+             *
+             * Ids set in ascending order are stored directly. If an id is
+             * set which is not larger than the previous one, you have to
+             * call sort() before looking up ids (as with the other sparse
+             * maps). Sorting needs memory for a temporary copy of the data
+             * with full ids. If an id is set several times, the last value
+             * wins. Setting the empty value removes the id on the next
+             * sort().
+             */
+            template <typename TId, typename TValue>
+            class CompactSparseMemArray : public osmium::index::map::Map<TId, TValue> {
+
+            public:
+
+                using element_type = typename std::pair<TId, TValue>;
+
+            private:
+
+                struct entry {
+                    uint32_t low_id;
+                    TValue value;
+                };
+
+                struct run {
+                    uint64_t high_id;
+                    std::size_t start;
+                };
+
+                std::vector<entry> m_entries;
+                std::vector<run> m_directory;
+                TId m_last_id{};
+                bool m_sorted = true;
+
+                static uint64_t high_bits(const TId id) noexcept {
+                    return static_cast<uint64_t>(id) >> 32U;
+                }
+
+                static uint32_t low_bits(const TId id) noexcept {
+                    return static_cast<uint32_t>(static_cast<uint64_t>(id) & 0xffffffffULL);
+                }
+
+                void append(const TId id, const TValue value) {
+                    const uint64_t high = high_bits(id);
+                    if (m_directory.empty() || m_directory.back().high_id != high) {
+                        m_directory.push_back(run{high, m_entries.size()});
+                    }
+                    m_entries.push_back(entry{low_bits(id), value});
+                    m_last_id = id;
+                }
+
+                // Call func(id, value) for all entries in the order they
+                // are stored in.
+                template <typename TFunc>
+                void for_each(TFunc&& func) const {
+                    for (auto it = m_directory.cbegin(); it != m_directory.cend(); ++it) {
+                        const std::size_t end = std::next(it) == m_directory.cend() ? m_entries.size() : std::next(it)->start;
+                        for (std::size_t i = it->start; i < end; ++i) {
+                            func(static_cast<TId>((it->high_id << 32U) | m_entries[i].low_id), m_entries[i].value);
+                        }
+                    }
+                }
+
+            public:
+
+                CompactSparseMemArray() = default;
+
+                CompactSparseMemArray(const CompactSparseMemArray&) = delete;
+                CompactSparseMemArray& operator=(const CompactSparseMemArray&) = delete;
+
+                CompactSparseMemArray(CompactSparseMemArray&&) noexcept = default;
+                CompactSparseMemArray& operator=(CompactSparseMemArray&&) noexcept = default;
+
+                ~CompactSparseMemArray() noexcept override = default;
+
+                void reserve(const std::size_t size) final {
+                    m_entries.reserve(size);
+                }
+
+                void set(const TId id, const TValue value) final {
+                    if (!m_entries.empty() && id <= m_last_id) {
+                        m_sorted = false;
+                    }
+                    append(id, value);
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const uint64_t high = high_bits(id);
+                    const auto it = std::lower_bound(m_directory.cbegin(), m_directory.cend(), high, [](const run& r, const uint64_t h) {
+                        return r.high_id < h;
+                    });
+                    if (it == m_directory.cend() || it->high_id != high) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+
+                    const auto first = m_entries.cbegin() + static_cast<std::ptrdiff_t>(it->start);
+                    const auto last = std::next(it) == m_directory.cend() ? m_entries.cend() : m_entries.cbegin() + static_cast<std::ptrdiff_t>(std::next(it)->start);
+                    const uint32_t low = low_bits(id);
+                    const auto result = std::lower_bound(first, last, low, [](const entry& e, const uint32_t l) {
+                        return e.low_id < l;
+                    });
+                    if (result == last || result->low_id != low) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return result->value;
+                }
+
+                std::size_t size() const final {
+                    return m_entries.size();
+                }
+
+                std::size_t used_memory() const final {
+                    return m_entries.size() * sizeof(entry) +
+                           m_directory.size() * sizeof(run);
+                }
+
+                void clear() final {
+                    m_entries.clear();
+                    m_entries.shrink_to_fit();
+                    m_directory.clear();
+                    m_directory.shrink_to_fit();
+                    m_last_id = TId{};
+                    m_sorted = true;
+                }
+
+                /**
+                 * Sort the entries if ids were set out of order. Of several
+                 * entries with the same id only the last one set is kept,
+                 * entries with the empty value are removed.
+                 */
+                void sort() final {
+                    if (m_sorted) {
+                        return;
+                    }
+
+                    std::vector<element_type> elements;
+                    elements.reserve(m_entries.size());
+                    for_each([&elements](const TId id, const TValue value) {
+                        elements.emplace_back(id, value);
+                    });
+                    std::stable_sort(elements.begin(), elements.end(), [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+
+                    m_entries.clear();
+                    m_directory.clear();
+                    for (auto it = elements.cbegin(); it != elements.cend(); ++it) {
+                        const auto next = std::next(it);
+                        if ((next == elements.cend() || next->first != it->first) &&
+                            it->second != osmium::index::empty_value<TValue>()) {
+                            append(it->first, it->second);
+                        }
+                    }
+                    m_entries.shrink_to_fit();
+                    m_directory.shrink_to_fit();
+                    m_sorted = true;
+                }
+
+                void dump_as_array(const int fd) final {
+                    sort();
+
+                    constexpr const std::size_t value_size = sizeof(TValue);
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / value_size;
+                    std::unique_ptr<TValue[]> output_buffer{new TValue[buffer_size]};
+                    std::fill_n(output_buffer.get(), buffer_size, osmium::index::empty_value<TValue>());
+
+                    std::size_t buffer_start_id = 0;
+                    std::size_t offset = 0;
+                    for_each([&](const TId id, const TValue value) {
+                        while (static_cast<std::size_t>(id) >= buffer_start_id + buffer_size) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.get()), buffer_size * value_size);
+                            std::fill_n(output_buffer.get(), buffer_size, osmium::index::empty_value<TValue>());
+                            buffer_start_id += buffer_size;
+                        }
+                        offset = static_cast<std::size_t>(id) - buffer_start_id;
+                        output_buffer[offset] = value;
+                        ++offset;
+                    });
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.get()), offset * value_size);
+                }
+
+                void dump_as_list(const int fd) final {
+                    sort();
+
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / sizeof(element_type);
+                    std::vector<element_type> output_buffer;
+                    output_buffer.reserve(buffer_size);
+
+                    for_each([&](const TId id, const TValue value) {
+                        output_buffer.emplace_back(id, value);
+                        if (output_buffer.size() == buffer_size) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.data()), output_buffer.size() * sizeof(element_type));
+                            output_buffer.clear();
+                        }
+                    });
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.data()), output_buffer.size() * sizeof(element_type));
+                }
+
+            }; // class CompactSparseMemArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompactSparseMemArray, compact_sparse_mem_array)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_COMPACT_SPARSE_MEM_ARRAY_HPP
@@ -0,0 +1,384 @@
+#ifndef OSMIUM_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Sparse map from ids to locations which stores the data
+             * compressed in memory. Entries are kept sorted by id in blocks
+             * of block_size entries. Inside a block the ids are stored as
+             * varint encoded differences to the previous id and the
+             * coordinates as zigzag varint encoded differences to the
+             * previous coordinates. The first entry of each block is stored
+             * with its full coordinates and its id is kept in a directory
+             * which is used for a binary search to find the block containing
+             * an id. Lookups then only have to decode a single block.
+             *
+             * For typical OSM data this needs about a third to a fifth of
+             * the memory of the SparseMemArray.
+             *
+             * Ids should be set in ascending order. Ids set out of order are
+             * kept uncompressed until sort() is called which merges them
+             * into the compressed data. As with the other sparse maps you
+             * have to call sort() before looking up ids in this case. If an
+             * id is set several times, the last value wins.
+             */
+            template <typename TId, typename TValue>
+            class CompressedSparseMemArray : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value, "TValue must be osmium::Location");
+
+            public:
+
+                /// Number of entries in each compressed block.
+                enum {
+                    block_size = 128
+                };
+
+                using element_type = typename std::pair<TId, TValue>;
+
+            private:
+
+                struct block_info {
+                    TId first_id;
+                    std::size_t offset;
+                };
+
+                std::vector<block_info> m_directory;
+                std::vector<unsigned char> m_data;
+                std::vector<element_type> m_unsorted;
+                std::size_t m_size = 0;
+                TId m_last_id{};
+                int32_t m_last_x = 0;
+                int32_t m_last_y = 0;
+
+                static void add_varint(std::vector<unsigned char>& data, uint64_t value) {
+                    while (value >= 0x80U) {
+                        data.push_back(static_cast<unsigned char>((value & 0x7fU) | 0x80U));
+                        value >>= 7U;
+                    }
+                    data.push_back(static_cast<unsigned char>(value));
+                }
+
+                static void add_zigzag(std::vector<unsigned char>& data, int64_t value) {
+                    add_varint(data, (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(value >> 63));
+                }
+
+                static uint64_t decode_varint(const unsigned char** data) noexcept {
+                    uint64_t value = 0;
+                    unsigned int shift = 0;
+                    while (**data & 0x80U) {
+                        value |= static_cast<uint64_t>(**data & 0x7fU) << shift;
+                        shift += 7;
+                        ++*data;
+                    }
+                    value |= static_cast<uint64_t>(**data) << shift;
+                    ++*data;
+                    return value;
+                }
+
+                static int64_t decode_zigzag(const unsigned char** data) noexcept {
+                    const uint64_t value = decode_varint(data);
+                    return static_cast<int64_t>(value >> 1U) ^ -static_cast<int64_t>(value & 1U);
+                }
+
+                // Decodes one entry. If first is true, this is the first entry
+                // of a block, id must already be set to the id from the
+                // directory and the coordinates are read as absolute values.
+                static void decode_entry(const unsigned char** data, bool first, TId& id, int32_t& x, int32_t& y) noexcept {
+                    if (first) {
+                        x = static_cast<int32_t>(decode_zigzag(data));
+                        y = static_cast<int32_t>(decode_zigzag(data));
+                    } else {
+                        id += static_cast<TId>(decode_varint(data));
+                        x = static_cast<int32_t>(x + decode_zigzag(data));
+                        y = static_cast<int32_t>(y + decode_zigzag(data));
+                    }
+                }
+
+                static void append(std::vector<block_info>& directory,
+                                   std::vector<unsigned char>& data,
+                                   std::size_t& size,
+                                   TId& last_id,
+                                   int32_t& last_x,
+                                   int32_t& last_y,
+                                   const TId id,
+                                   const TValue value) {
+                    if (size % block_size == 0) {
+                        directory.push_back(block_info{id, data.size()});
+                        add_zigzag(data, value.x());
+                        add_zigzag(data, value.y());
+                    } else {
+                        add_varint(data, static_cast<uint64_t>(id - last_id));
+                        add_zigzag(data, static_cast<int64_t>(value.x()) - last_x);
+                        add_zigzag(data, static_cast<int64_t>(value.y()) - last_y);
+                    }
+                    ++size;
+                    last_id = id;
+                    last_x = value.x();
+                    last_y = value.y();
+                }
+
+                // Call func(id, value) for all entries in the compressed data
+                // in order of their ids.
+                template <typename TFunc>
+                void for_each(TFunc&& func) const {
+                    std::size_t n = 0;
+                    for (const auto& block : m_directory) {
+                        const unsigned char* data = m_data.data() + block.offset;
+                        TId id = block.first_id;
+                        int32_t x = 0;
+                        int32_t y = 0;
+                        for (std::size_t i = 0; i < block_size && n < m_size; ++i, ++n) {
+                            decode_entry(&data, i == 0, id, x, y);
+                            func(id, TValue{x, y});
+                        }
+                    }
+                }
+
+            public:
+
+                CompressedSparseMemArray() = default;
+
+                CompressedSparseMemArray(const CompressedSparseMemArray&) = delete;
+                CompressedSparseMemArray& operator=(const CompressedSparseMemArray&) = delete;
+
+                CompressedSparseMemArray(CompressedSparseMemArray&&) noexcept = default;
+                CompressedSparseMemArray& operator=(CompressedSparseMemArray&&) noexcept = default;
+
+                ~CompressedSparseMemArray() noexcept override = default;
+
+                void set(const TId id, const TValue value) final {
+                    if (m_size > 0 && id <= m_last_id) {
+                        m_unsorted.emplace_back(id, value);
+                        return;
+                    }
+                    append(m_directory, m_data, m_size, m_last_id, m_last_x, m_last_y, id, value);
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    auto it = std::upper_bound(m_directory.cbegin(), m_directory.cend(), id, [](const TId a, const block_info& b) {
+                        return a < b.first_id;
+                    });
+                    if (it == m_directory.cbegin()) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    --it;
+
+                    const std::size_t start = static_cast<std::size_t>(it - m_directory.cbegin()) * block_size;
+                    const std::size_t count = std::min(static_cast<std::size_t>(block_size), m_size - start);
+                    const unsigned char* data = m_data.data() + it->offset;
+                    TId current_id = it->first_id;
+                    int32_t x = 0;
+                    int32_t y = 0;
+                    for (std::size_t i = 0; i < count; ++i) {
+                        decode_entry(&data, i == 0, current_id, x, y);
+                        if (current_id == id) {
+                            return TValue{x, y};
+                        }
+                        if (current_id > id) {
+                            break;
+                        }
+                    }
+
+                    return osmium::index::empty_value<TValue>();
+                }
+
+                std::size_t size() const final {
+                    return m_size + m_unsorted.size();
+                }
+
+                std::size_t used_memory() const final {
+                    return m_data.size() +
+                           m_directory.size() * sizeof(block_info) +
+                           m_unsorted.size() * sizeof(element_type);
+                }
+
+                void clear() final {
+                    m_directory.clear();
+                    m_directory.shrink_to_fit();
+                    m_data.clear();
+                    m_data.shrink_to_fit();
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+                    m_size = 0;
+                    m_last_id = TId{};
+                    m_last_x = 0;
+                    m_last_y = 0;
+                }
+
+                /**
+                 * Merge all ids set out of order into the compressed data.
+                 * The data is re-encoded into new blocks, so this needs
+                 * memory for the old and new compressed data at the same
+                 * time.
+                 */
+                void sort() final {
+                    if (m_unsorted.empty()) {
+                        return;
+                    }
+
+                    std::stable_sort(m_unsorted.begin(), m_unsorted.end(), [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+
+                    std::vector<block_info> directory;
+                    std::vector<unsigned char> data;
+                    data.reserve(m_data.size() + m_unsorted.size() * 4);
+                    std::size_t size = 0;
+                    TId last_id{};
+                    int32_t last_x = 0;
+                    int32_t last_y = 0;
+
+                    auto it = m_unsorted.cbegin();
+                    const auto end = m_unsorted.cend();
+
+                    // Appends the unsorted entries with ids smaller than or
+                    // equal to the given id. Of several entries with the same
+                    // id only the last one is kept.
+                    const auto add_unsorted_up_to = [&](const TId id) {
+                        while (it != end && it->first <= id) {
+                            auto next = std::next(it);
+                            if (next == end || next->first != it->first) {
+                                append(directory, data, size, last_id, last_x, last_y, it->first, it->second);
+                            }
+                            it = next;
+                        }
+                    };
+
+                    for_each([&](const TId id, const TValue value) {
+                        add_unsorted_up_to(id);
+                        if (size == 0 || last_id != id) {
+                            append(directory, data, size, last_id, last_x, last_y, id, value);
+                        }
+                    });
+                    if (it != end) {
+                        add_unsorted_up_to(std::prev(end)->first);
+                    }
+
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+                    data.shrink_to_fit();
+
+                    using std::swap;
+                    swap(m_directory, directory);
+                    swap(m_data, data);
+                    m_size = size;
+                    m_last_id = last_id;
+                    m_last_x = last_x;
+                    m_last_y = last_y;
+                }
+
+                void dump_as_array(const int fd) final {
+                    sort();
+
+                    constexpr const std::size_t value_size = sizeof(TValue);
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / value_size;
+                    std::unique_ptr<TValue[]> output_buffer{new TValue[buffer_size]};
+                    std::fill_n(output_buffer.get(), buffer_size, osmium::index::empty_value<TValue>());
+
+                    std::size_t buffer_start_id = 0;
+                    std::size_t offset = 0;
+                    for_each([&](const TId id, const TValue value) {
+                        while (static_cast<std::size_t>(id) >= buffer_start_id + buffer_size) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.get()), buffer_size * value_size);
+                            std::fill_n(output_buffer.get(), buffer_size, osmium::index::empty_value<TValue>());
+                            buffer_start_id += buffer_size;
+                        }
+                        offset = static_cast<std::size_t>(id) - buffer_start_id;
+                        output_buffer[offset] = value;
+                        ++offset;
+                    });
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.get()), offset * value_size);
+                }
+
+                void dump_as_list(const int fd) final {
+                    sort();
+
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / sizeof(element_type);
+                    std::vector<element_type> output_buffer;
+                    output_buffer.reserve(buffer_size);
+
+                    for_each([&](const TId id, const TValue value) {
+                        output_buffer.emplace_back(id, value);
+                        if (output_buffer.size() == buffer_size) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.data()), output_buffer.size() * sizeof(element_type));
+                            output_buffer.clear();
+                        }
+                    });
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.data()), output_buffer.size() * sizeof(element_type));
+                }
+
+            }; // class CompressedSparseMemArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedSparseMemArray, compressed_sparse_mem_array)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY_HPP
@@ -0,0 +1,237 @@
+#ifndef OSMIUM_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Dense map which can be filled from several threads at the
+             * same time. The ids are split into chunks of 2^20 ids, each
+             * chunk is an anonymous memory mapping allocated the first time
+             * an id in it is set. Lookup of the chunk and setting of values
+             * use atomic operations, so no locks are needed except when a
+             * new chunk is allocated. Threads should set disjoint ids,
+             * otherwise it is undefined which value wins.
+             *
+             * The value type must be 8 bytes and trivially copyable (like
+             * osmium::Location). Values are stored xor'ed with the empty
+             * value, so the fresh zero-filled pages of the mappings read as
+             * empty without having to be initialized.
+             *
+             * The map can hold ids up to 2^36 (about 68 billion).
+             */
+            template <typename TId, typename TValue>
+            class ConcurrentDenseMmapArray : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(sizeof(TValue) == sizeof(uint64_t), "TValue must be 8 bytes");
+                static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "std::atomic<uint64_t> must not have any overhead");
+
+                enum : std::size_t {
+                    chunk_bits = 20,
+                    chunk_size = 1UL << chunk_bits,
+                    max_chunks = 1UL << 16U
+                };
+
+                using slot_type = std::atomic<uint64_t>;
+
+                std::unique_ptr<std::atomic<slot_type*>[]> m_chunks;
+                std::vector<osmium::util::AnonymousMemoryMapping> m_mappings;
+                std::mutex m_mutex;
+                std::atomic<std::size_t> m_num_chunks{0};
+
+                static uint64_t empty_bits() noexcept {
+                    const TValue empty = osmium::index::empty_value<TValue>();
+                    uint64_t bits = 0;
+                    std::memcpy(&bits, &empty, sizeof(bits));
+                    return bits;
+                }
+
+                static uint64_t encode(const TValue value) noexcept {
+                    uint64_t bits = 0;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    return bits ^ empty_bits();
+                }
+
+                static TValue decode(const uint64_t bits) noexcept {
+                    const uint64_t value_bits = bits ^ empty_bits();
+                    TValue value;
+                    std::memcpy(static_cast<void*>(&value), &value_bits, sizeof(value));
+                    return value;
+                }
+
+                slot_type* chunk(std::size_t index) const noexcept {
+                    return m_chunks[index].load(std::memory_order_acquire);
+                }
+
+                slot_type* allocate_chunk(std::size_t index) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    slot_type* slots = chunk(index);
+                    if (slots) { // another thread was faster
+                        return slots;
+                    }
+
+                    m_mappings.emplace_back(chunk_size * sizeof(slot_type));
+                    slots = m_mappings.back().template get_addr<slot_type>();
+                    m_chunks[index].store(slots, std::memory_order_release);
+
+                    std::size_t num_chunks = m_num_chunks.load(std::memory_order_relaxed);
+                    if (num_chunks <= index) {
+                        m_num_chunks.store(index + 1, std::memory_order_relaxed);
+                    }
+
+                    return slots;
+                }
+
+            public:
+
+                using element_type = TValue;
+
+                ConcurrentDenseMmapArray() :
+                    m_chunks(new std::atomic<slot_type*>[max_chunks]) {
+                    for (std::size_t i = 0; i < max_chunks; ++i) {
+                        m_chunks[i].store(nullptr, std::memory_order_relaxed);
+                    }
+                }
+
+                /// The maximum id (plus 1) this map can store.
+                static constexpr std::size_t max_size() noexcept {
+                    return chunk_size * max_chunks;
+                }
+
+                /**
+                 * Set the field with id to value. This can be called from
+                 * several threads at the same time.
+                 *
+                 * @throws std::range_error if the id is larger than
+                 *         max_size().
+                 */
+                void set(const TId id, const TValue value) final {
+                    const std::size_t index = id >> chunk_bits;
+                    if (index >= max_chunks) {
+                        throw std::range_error{"id too large for ConcurrentDenseMmapArray"};
+                    }
+                    slot_type* slots = chunk(index);
+                    if (!slots) {
+                        slots = allocate_chunk(index);
+                    }
+                    slots[id & (chunk_size - 1)].store(encode(value), std::memory_order_relaxed);
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const std::size_t index = id >> chunk_bits;
+                    if (index >= max_chunks) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    const slot_type* slots = chunk(index);
+                    if (!slots) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return decode(slots[id & (chunk_size - 1)].load(std::memory_order_relaxed));
+                }
+
+                std::size_t size() const final {
+                    return m_num_chunks.load(std::memory_order_relaxed) * chunk_size;
+                }
+
+                std::size_t used_memory() const final {
+                    return m_mappings.size() * chunk_size * sizeof(slot_type);
+                }
+
+                /**
+                 * Clear memory used for this storage. This must not be
+                 * called while other threads are still setting values.
+                 */
+                void clear() final {
+                    for (std::size_t i = 0; i < max_chunks; ++i) {
+                        m_chunks[i].store(nullptr, std::memory_order_relaxed);
+                    }
+                    m_mappings.clear();
+                    m_num_chunks = 0;
+                }
+
+                void dump_as_array(const int fd) final {
+                    std::vector<TValue> values(chunk_size);
+                    const std::size_t num_chunks = m_num_chunks.load(std::memory_order_relaxed);
+                    for (std::size_t i = 0; i < num_chunks; ++i) {
+                        const slot_type* slots = chunk(i);
+                        for (std::size_t n = 0; n < chunk_size; ++n) {
+                            values[n] = slots ? decode(slots[n].load(std::memory_order_relaxed))
+                                              : osmium::index::empty_value<TValue>();
+                        }
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(values.data()), chunk_size * sizeof(TValue));
+                    }
+                }
+
+            }; // class ConcurrentDenseMmapArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::ConcurrentDenseMmapArray, concurrent_dense_mmap_array)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY_HPP
@@ -34,6 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/index/detail/create_map_with_fd.hpp>
+#include <osmium/index/detail/huge_pages_option.hpp>
 #include <osmium/index/detail/mmap_vector_file.hpp>
 #include <osmium/index/detail/vector_map.hpp>
 
@@ -51,10 +52,18 @@ namespace osmium {
             template <typename TId, typename TValue>
             using DenseFileArray = VectorBasedDenseMap<osmium::detail::mmap_vector_file<TValue>, TId, TValue>;
 
+            /**
+             * Config string for the map factory:
+             * "dense_file_array[,FILENAME][,transparent_huge_pages]". The
+             * "huge_pages" option is accepted as well, but file-backed
+             * mappings can only use transparent huge pages.
+             */
             template <typename TId, typename TValue>
             struct create_map<TId, TValue, DenseFileArray> {
                 DenseFileArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
-                    return osmium::index::detail::create_map_with_fd<DenseFileArray<TId, TValue>>(config);
+                    std::vector<std::string> map_config{config};
+                    const auto huge_pages = osmium::index::detail::get_huge_pages_option(map_config);
+                    return osmium::index::detail::create_map_with_fd<DenseFileArray<TId, TValue>>(map_config, huge_pages);
                 }
             };
 
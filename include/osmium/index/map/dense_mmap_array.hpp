@@ -35,9 +35,13 @@ DEALINGS IN THE SOFTWARE.
 
 #ifdef __linux__
 
+#include <osmium/index/detail/huge_pages_option.hpp>
 #include <osmium/index/detail/mmap_vector_anon.hpp> // IWYU pragma: keep
 #include <osmium/index/detail/vector_map.hpp>
 
+#include <string>
+#include <vector>
+
 #define OSMIUM_HAS_INDEX_MAP_DENSE_MMAP_ARRAY
 
 namespace osmium {
@@ -49,6 +53,18 @@ namespace osmium {
             template <typename TId, typename TValue>
             using DenseMmapArray = VectorBasedDenseMap<osmium::detail::mmap_vector_anon<TValue>, TId, TValue>;
 
+            /**
+             * Config string for the map factory:
+             * "dense_mmap_array[,huge_pages|,transparent_huge_pages]".
+             */
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, DenseMmapArray> {
+                DenseMmapArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    std::vector<std::string> map_config{config};
+                    return new DenseMmapArray<TId, TValue>{osmium::index::detail::get_huge_pages_option(map_config)};
+                }
+            };
+
         } // namespace map
 
     } // namespace index
@@ -0,0 +1,294 @@
+#ifndef OSMIUM_INDEX_MAP_FLAT_HASH_MAP_HPP
+#define OSMIUM_INDEX_MAP_FLAT_HASH_MAP_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/sort_by_id.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/compatibility.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_FLAT_HASH_MAP
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Hash map from ids to values using open addressing with linear
+             * probing. All elements are stored in one array of (id, value)
+             * pairs (16 bytes for locations), a slot is free if its value
+             * is the empty value. The array is kept at most 3/4 full, so
+             * this needs between 21 and 43 bytes per element (compared to
+             * about 48 bytes plus allocation overhead for the SparseMemMap)
+             * and lookups usually only touch one cache line.
+             *
+             * Ids can be set in any order and set() overwrites existing
+             * values, so this works well for random or interleaved set()
+             * and get(), for instance while applying change files. Setting
+             * the empty value removes the id.
+             *
+             * After the map is filled, get() can be called from several
+             * threads at the same time.
+             */
+            template <typename TId, typename TValue>
+            class FlatHashMap : public osmium::index::map::Map<TId, TValue> {
+
+            public:
+
+                using element_type = typename std::pair<TId, TValue>;
+
+            private:
+
+                enum : std::size_t {
+                    min_capacity = 16
+                };
+
+                std::vector<element_type> m_slots;
+                std::size_t m_size = 0;
+                std::size_t m_mask = 0;
+                unsigned int m_shift = 64;
+
+                static element_type free_slot() noexcept {
+                    return element_type{TId{}, osmium::index::empty_value<TValue>()};
+                }
+
+                static bool is_free(const element_type& slot) noexcept {
+                    return slot.second == osmium::index::empty_value<TValue>();
+                }
+
+                // Fibonacci hashing: the upper bits of the product are
+                // well mixed even for consecutive ids.
+                std::size_t home_slot(const TId id) const noexcept {
+                    return static_cast<std::size_t>((static_cast<uint64_t>(id) * 0x9e3779b97f4a7c15ULL) >> m_shift);
+                }
+
+                std::size_t find_slot(const TId id) const noexcept {
+                    std::size_t n = home_slot(id);
+                    while (!is_free(m_slots[n]) && m_slots[n].first != id) {
+                        n = (n + 1) & m_mask;
+                    }
+                    return n;
+                }
+
+                void rehash(std::size_t capacity) {
+                    std::vector<element_type> old_slots(capacity, free_slot());
+                    swap(old_slots, m_slots);
+                    m_mask = capacity - 1;
+                    m_shift = 64;
+                    while (capacity > 1) {
+                        capacity >>= 1U;
+                        --m_shift;
+                    }
+                    for (const auto& slot : old_slots) {
+                        if (!is_free(slot)) {
+                            m_slots[find_slot(slot.first)] = slot;
+                        }
+                    }
+                }
+
+                static std::size_t capacity_for(std::size_t size) noexcept {
+                    std::size_t capacity = min_capacity;
+                    while (capacity / 4 * 3 < size) {
+                        capacity <<= 1U;
+                    }
+                    return capacity;
+                }
+
+                // Remove the element in slot n and move later elements of
+                // the same probe sequence back, so no tombstones are needed.
+                void erase_slot(std::size_t n) noexcept {
+                    std::size_t next = (n + 1) & m_mask;
+                    while (!is_free(m_slots[next])) {
+                        const std::size_t home = home_slot(m_slots[next].first);
+                        // Move the element if its home slot is not in the
+                        // (cyclic) range (n, next].
+                        if (((next - home) & m_mask) >= ((next - n) & m_mask)) {
+                            m_slots[n] = m_slots[next];
+                            n = next;
+                        }
+                        next = (next + 1) & m_mask;
+                    }
+                    m_slots[n] = free_slot();
+                    --m_size;
+                }
+
+                std::vector<element_type> sorted_elements() const {
+                    std::vector<element_type> elements;
+                    elements.reserve(m_size);
+                    for (const auto& slot : m_slots) {
+                        if (!is_free(slot)) {
+                            elements.push_back(slot);
+                        }
+                    }
+                    osmium::index::detail::sort_by_id(elements.begin(), elements.end());
+                    return elements;
+                }
+
+            public:
+
+                FlatHashMap() = default;
+
+                void reserve(const std::size_t size) final {
+                    const std::size_t capacity = capacity_for(size);
+                    if (capacity > m_slots.size()) {
+                        rehash(capacity);
+                    }
+                }
+
+                void set(const TId id, const TValue value) final {
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        if (m_size > 0) {
+                            const std::size_t n = find_slot(id);
+                            if (!is_free(m_slots[n])) {
+                                erase_slot(n);
+                            }
+                        }
+                        return;
+                    }
+                    if (m_slots.size() / 4 * 3 <= m_size) {
+                        rehash(capacity_for(m_size + 1));
+                    }
+                    const std::size_t n = find_slot(id);
+                    if (is_free(m_slots[n])) {
+                        ++m_size;
+                    }
+                    m_slots[n] = element_type{id, value};
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    if (m_size == 0) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return m_slots[find_slot(id)].second;
+                }
+
+                /**
+                 * Retrieve values for several ids at once. The home slots
+                 * of the ids a few positions ahead are prefetched, so that
+                 * the cache misses for the lookups overlap.
+                 */
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    enum {
+                        prefetch_distance = 8
+                    };
+
+                    if (m_size == 0) {
+                        std::fill_n(values, count, osmium::index::empty_value<TValue>());
+                        return;
+                    }
+
+                    for (std::size_t i = 0; i < count && i < prefetch_distance; ++i) {
+                        OSMIUM_PREFETCH(m_slots.data() + home_slot(ids[i]));
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + prefetch_distance < count) {
+                            OSMIUM_PREFETCH(m_slots.data() + home_slot(ids[i + prefetch_distance]));
+                        }
+                        values[i] = m_slots[find_slot(ids[i])].second;
+                    }
+                }
+
+                std::size_t size() const noexcept final {
+                    return m_size;
+                }
+
+                std::size_t used_memory() const noexcept final {
+                    return sizeof(element_type) * m_slots.size();
+                }
+
+                void clear() final {
+                    m_slots.clear();
+                    m_slots.shrink_to_fit();
+                    m_size = 0;
+                    m_mask = 0;
+                    m_shift = 64;
+                }
+
+                void dump_as_array(const int fd) final {
+                    constexpr const std::size_t value_size = sizeof(TValue);
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / value_size;
+                    std::unique_ptr<TValue[]> output_buffer{new TValue[buffer_size]};
+                    std::fill_n(output_buffer.get(), buffer_size, osmium::index::empty_value<TValue>());
+
+                    std::size_t buffer_start_id = 0;
+                    std::size_t offset = 0;
+                    for (const auto& element : sorted_elements()) {
+                        while (static_cast<std::size_t>(element.first) >= buffer_start_id + buffer_size) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.get()), buffer_size * value_size);
+                            std::fill_n(output_buffer.get(), buffer_size, osmium::index::empty_value<TValue>());
+                            buffer_start_id += buffer_size;
+                        }
+                        offset = static_cast<std::size_t>(element.first) - buffer_start_id;
+                        output_buffer[offset] = element.second;
+                        ++offset;
+                    }
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.get()), offset * value_size);
+                }
+
+                void dump_as_list(const int fd) final {
+                    const auto elements = sorted_elements();
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(elements.data()), sizeof(element_type) * elements.size());
+                }
+
+            }; // class FlatHashMap
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::FlatHashMap, flat_hash)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_FLAT_HASH_MAP_HPP
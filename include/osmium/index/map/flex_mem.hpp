@@ -35,10 +35,14 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
 
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <future>
 #include <utility>
 #include <vector>
 
@@ -56,6 +60,11 @@ namespace osmium {
              * input data a sparse array will be used, if this becomes
              * inefficient, the class will switch automatically to a dense
              * index.
+             *
+             * If a thread pool is set with set_thread_pool(), sorting the
+             * sparse index and the switch to the dense index are done on
+             * the pool. The map must then not be used from a thread of the
+             * pool, because it waits for the tasks it submits.
              */
             template <typename TId, typename TValue>
             class FlexMem : public osmium::index::map::Map<TId, TValue> {
@@ -110,6 +119,9 @@ namespace osmium {
                 // Set to false in sparse mode and to true in dense mode.
                 bool m_dense;
 
+                // Optional thread pool for sort() and switch_to_dense().
+                osmium::thread::Pool* m_pool = nullptr;
+
                 static uint64_t block(const uint64_t id) noexcept {
                     return id >> bits;
                 }
@@ -157,6 +169,62 @@ namespace osmium {
                     m_dense_blocks[block(id)][offset(id)] = value;
                 }
 
+                // Copy all sparse entries with ids in the blocks first_block
+                // to last_block - 1 into the dense blocks. Calls for
+                // different ranges of blocks don't touch the same blocks,
+                // so they can run in parallel.
+                void fill_dense_blocks(const uint64_t first_block, const uint64_t last_block) {
+                    for (const auto& entry : m_sparse_entries) {
+                        const auto num = block(entry.id);
+                        if (num >= first_block && num < last_block) {
+                            auto& dense_block = m_dense_blocks[num];
+                            if (dense_block.empty()) {
+                                dense_block.assign(block_size, osmium::index::empty_value<TValue>());
+                            }
+                            dense_block[offset(entry.id)] = entry.value;
+                        }
+                    }
+                }
+
+                // Allocate the blocks first_block to last_block - 1.
+                void allocate_dense_blocks(const uint64_t first_block, const uint64_t last_block) {
+                    for (auto num = first_block; num < last_block; ++num) {
+                        if (m_dense_blocks[num].empty()) {
+                            m_dense_blocks[num].assign(block_size, osmium::index::empty_value<TValue>());
+                        }
+                    }
+                }
+
+                // Call func(first_block, last_block) for ranges covering
+                // the blocks 0 to num_blocks - 1. The ranges are handled
+                // in parallel on the pool if there is one.
+                template <typename TFunc>
+                void for_block_ranges(const uint64_t num_blocks, TFunc&& func) {
+                    const uint64_t num_ranges = m_pool ? std::min(static_cast<uint64_t>(m_pool->num_threads()), num_blocks) : 1;
+                    if (num_ranges < 2) {
+                        func(0, num_blocks);
+                        return;
+                    }
+
+                    std::vector<std::future<void>> futures;
+                    futures.reserve(num_ranges);
+                    for (uint64_t i = 0; i < num_ranges; ++i) {
+                        const uint64_t first = num_blocks * i / num_ranges;
+                        const uint64_t last = num_blocks * (i + 1) / num_ranges;
+                        futures.push_back(m_pool->submit([&func, first, last]() {
+                            func(first, last);
+                        }));
+                    }
+                    // Wait for all tasks before getting the results, so
+                    // no task is still running if one of them failed.
+                    for (auto& future : futures) {
+                        future.wait();
+                    }
+                    for (auto& future : futures) {
+                        future.get();
+                    }
+                }
+
                 TValue get_dense(const uint64_t id) const noexcept {
                     if (m_dense_blocks.size() <= block(id) || m_dense_blocks[block(id)].empty()) {
                         return osmium::index::empty_value<TValue>();
@@ -183,6 +251,66 @@ namespace osmium {
                     return m_dense;
                 }
 
+                /**
+                 * Use the threads of the pool for sorting the sparse index
+                 * and for switching to the dense index.
+                 *
+                 * @param pool The thread pool. It must outlive this map.
+                 */
+                void set_thread_pool(osmium::thread::Pool& pool) noexcept {
+                    m_pool = &pool;
+                }
+
+                /**
+                 * Reserve space for the given number of entries in sparse
+                 * mode. At most min_dense_entries are reserved, because
+                 * the index might switch to dense mode after that.
+                 */
+                void reserve(const std::size_t size) final {
+                    if (!m_dense) {
+                        m_sparse_entries.reserve(std::min(size, static_cast<std::size_t>(min_dense_entries)));
+                    }
+                }
+
+                /**
+                 * Decide on sparse or dense mode up front using the same
+                 * rule the map uses when switching automatically: If
+                 * there are at least min_dense_entries entries and more
+                 * than a third of all ids up to max_id are used, the dense
+                 * index is allocated with reserve_dense(), otherwise space
+                 * is reserved in the sparse index.
+                 */
+                void presize(const std::size_t count, const TId max_id) final {
+                    if (count >= static_cast<std::size_t>(min_dense_entries) &&
+                        static_cast<uint64_t>(max_id) < count * static_cast<uint64_t>(density_factor)) {
+                        reserve_dense(max_id);
+                    } else {
+                        reserve(count);
+                    }
+                }
+
+                /**
+                 * Switch to the dense index (see switch_to_dense()) and
+                 * allocate all blocks needed for ids up to max_id up front
+                 * (on the thread pool if there is one). Use this when you
+                 * know that the input is large and mostly dense, for
+                 * instance from the file size or the bounding box in the
+                 * file header, to avoid the stall when the map switches
+                 * to the dense index later.
+                 *
+                 * @param max_id The largest id expected.
+                 */
+                void reserve_dense(const uint64_t max_id) {
+                    switch_to_dense();
+                    const uint64_t num_blocks = block(max_id) + 1;
+                    if (m_dense_blocks.size() < num_blocks) {
+                        m_dense_blocks.resize(num_blocks);
+                    }
+                    for_block_ranges(num_blocks, [this](uint64_t first, uint64_t last) {
+                        allocate_dense_blocks(first, last);
+                    });
+                }
+
                 std::size_t size() const noexcept final {
                     if (m_dense) {
                         return m_dense_blocks.size() * block_size;
@@ -229,7 +357,41 @@ namespace osmium {
                 }
 
                 void sort() final {
-                    std::sort(m_sparse_entries.begin(), m_sparse_entries.end());
+                    if (m_pool) {
+                        osmium::thread::parallel_stable_sort(m_sparse_entries.begin(), m_sparse_entries.end(), std::less<entry>{}, *m_pool);
+                    } else {
+                        std::sort(m_sparse_entries.begin(), m_sparse_entries.end());
+                    }
+                }
+
+                void update(const TId id, const TValue value) final {
+                    if (m_dense) {
+                        set_dense(id, value);
+                    } else {
+                        m_sparse_entries.emplace_back(id, value);
+                    }
+                }
+
+                /**
+                 * In sparse mode sort the entries keeping only the last
+                 * update for each id and remove deleted entries.
+                 */
+                void commit_updates() final {
+                    if (m_dense) {
+                        return;
+                    }
+                    std::stable_sort(m_sparse_entries.begin(), m_sparse_entries.end());
+                    std::size_t size = 0;
+                    m_max_id = 0;
+                    for (std::size_t i = 0; i < m_sparse_entries.size(); ++i) {
+                        const auto& e = m_sparse_entries[i];
+                        if ((i + 1 == m_sparse_entries.size() || m_sparse_entries[i + 1].id != e.id) &&
+                            e.value != osmium::index::empty_value<TValue>()) {
+                            m_sparse_entries[size++] = e;
+                            m_max_id = e.id;
+                        }
+                    }
+                    m_sparse_entries.erase(m_sparse_entries.begin() + static_cast<std::ptrdiff_t>(size), m_sparse_entries.end());
                 }
 
                 /**
@@ -239,13 +401,23 @@ namespace osmium {
                  * efficient.
                  *
                  * Does nothing if the index is already in dense mode.
+                 *
+                 * If there is a thread pool, the entries are copied in
+                 * parallel, each thread filling its own range of blocks.
                  */
                 void switch_to_dense() {
                     if (m_dense) {
                         return;
                     }
-                    for (const auto& entry : m_sparse_entries) {
-                        set_dense(entry.id, entry.value);
+                    if (!m_sparse_entries.empty()) {
+                        const auto max = std::max_element(m_sparse_entries.begin(), m_sparse_entries.end());
+                        const uint64_t num_blocks = block(max->id) + 1;
+                        if (m_dense_blocks.size() < num_blocks) {
+                            m_dense_blocks.resize(num_blocks);
+                        }
+                        for_block_ranges(num_blocks, [this](uint64_t first, uint64_t last) {
+                            fill_dense_blocks(first, last);
+                        });
                     }
                     m_sparse_entries.clear();
                     m_sparse_entries.shrink_to_fit();
@@ -0,0 +1,479 @@
+#ifndef OSMIUM_INDEX_MAP_MAPPED_FILE_MAP_HPP
+#define OSMIUM_INDEX_MAP_MAPPED_FILE_MAP_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/vector_map.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <fcntl.h>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+#define OSMIUM_HAS_INDEX_MAP_MAPPED_FILE_MAP
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            enum : uint64_t {
+                // "OSMIDXM" + version
+                map_file_magic = 0x4f534d4944584d01ULL
+            };
+
+            enum : std::size_t {
+                map_file_header_words = 8,
+                map_file_header_size  = map_file_header_words * sizeof(uint64_t),
+
+                // Size of the chunks written in parallel
+                map_file_chunk_size = 64UL * 1024UL * 1024UL
+            };
+
+            enum class map_file_layout : uint64_t {
+                // Values indexed by id
+                dense_array = 1,
+                // Sorted list of (id, value) pairs
+                sorted_list = 2
+            };
+
+            inline void write_at(const int fd, const char* data, const std::size_t size, const std::size_t offset) {
+#ifndef _WIN32
+                osmium::io::detail::reliable_pwrite(fd, reinterpret_cast<const unsigned char*>(data), size, offset);
+#else
+                if (_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) == -1) {
+                    throw std::system_error{errno, std::system_category(), "Seek failed"};
+                }
+                osmium::io::detail::reliable_write(fd, data, size);
+#endif
+            }
+
+            struct map_file_write_task {
+
+                int fd;
+                const char* data;
+                std::size_t size;
+                std::size_t offset;
+
+                void operator()() const {
+                    write_at(fd, data, size, offset);
+                }
+
+            }; // struct map_file_write_task
+
+            // Write data to the file starting at the given offset. Large
+            // data is cut into chunks which are written in parallel from
+            // the pool threads with pwrite(). On Windows this writes
+            // everything in one go from the current thread.
+            inline void write_map_file_data(const int fd, const char* data, const std::size_t size, const std::size_t offset, osmium::thread::Pool& pool, const std::size_t max_chunk_size = map_file_chunk_size) {
+#ifndef _WIN32
+                if (size > max_chunk_size) {
+                    std::vector<std::future<void>> futures;
+                    for (std::size_t done = 0; done < size; done += max_chunk_size) {
+                        const auto chunk_size = std::min(size - done, max_chunk_size);
+                        futures.push_back(pool.submit(map_file_write_task{fd, data + done, chunk_size, offset + done}));
+                    }
+                    // Wait for all tasks before getting the results, so
+                    // no task is still running if one of them failed.
+                    for (auto& future : futures) {
+                        future.wait();
+                    }
+                    for (auto& future : futures) {
+                        future.get();
+                    }
+                    return;
+                }
+#else
+                (void)pool;
+                (void)max_chunk_size;
+#endif
+                write_at(fd, data, size, offset);
+            }
+
+            // Write the header to the beginning of the file. This is done
+            // after writing the data, so the header of an incomplete file
+            // is invalid.
+            template <typename TId, typename TValue>
+            void write_map_file_header(const int fd, const map_file_layout layout, const std::size_t element_size, const std::size_t count) {
+                const uint64_t header[map_file_header_words] = {
+                    map_file_magic,
+                    static_cast<uint64_t>(layout),
+                    sizeof(TId),
+                    sizeof(TValue),
+                    element_size,
+                    count,
+                    0,
+                    0
+                };
+                write_at(fd, reinterpret_cast<const char*>(header), sizeof(header), 0);
+            }
+
+        } // namespace detail
+
+        /**
+         * Write a dense map to a map file which can be opened again with
+         * MappedFileMap. The file starts with a header describing the
+         * contents, so it can be checked when it is opened, followed by
+         * the values in native byte order. Large maps are written in
+         * chunks in parallel from the threads of the pool.
+         *
+         * @param fd File descriptor of a new empty file open for writing.
+         * @param map The map to write.
+         * @param pool The thread pool used for writing.
+         * @throws std::system_error If the file could not be written.
+         */
+        template <typename TVector, typename TId, typename TValue>
+        void write_map_file(const int fd, const map::VectorBasedDenseMap<TVector, TId, TValue>& map, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            const std::size_t count = map.size();
+            if (count > 0) {
+                detail::write_map_file_data(fd, reinterpret_cast<const char*>(&*map.cbegin()), count * sizeof(TValue), detail::map_file_header_size, pool);
+            }
+            detail::write_map_file_header<TId, TValue>(fd, detail::map_file_layout::dense_array, sizeof(TValue), count);
+        }
+
+        /**
+         * Write a sparse map to a map file which can be opened again with
+         * MappedFileMap. See the function above for details.
+         *
+         * @pre The map must be sorted.
+         */
+        template <typename TId, typename TValue, template <typename...> class TVector>
+        void write_map_file(const int fd, const map::VectorBasedSparseMap<TId, TValue, TVector>& map, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            using element_type = typename map::VectorBasedSparseMap<TId, TValue, TVector>::element_type;
+            const std::size_t count = map.size();
+            if (count > 0) {
+                detail::write_map_file_data(fd, reinterpret_cast<const char*>(&*map.cbegin()), count * sizeof(element_type), detail::map_file_header_size, pool);
+            }
+            detail::write_map_file_header<TId, TValue>(fd, detail::map_file_layout::sorted_list, sizeof(element_type), count);
+        }
+
+        /**
+         * Write any other map supporting dump_as_list() to a map file
+         * which can be opened again with MappedFileMap. The list is
+         * written by the map itself, so this is not done in parallel.
+         *
+         * @pre The map must be sorted.
+         * @throws std::runtime_error If the map doesn't support
+         *         dump_as_list().
+         */
+        template <typename TId, typename TValue>
+        void write_map_file(const int fd, map::Map<TId, TValue>& map) {
+            using element_type = std::pair<TId, TValue>;
+
+            // Empty header as placeholder, dump_as_list() writes at the
+            // current file position after it.
+            const uint64_t placeholder[detail::map_file_header_words] = {0};
+            osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(placeholder), sizeof(placeholder));
+            map.dump_as_list(fd);
+            const std::size_t count = (osmium::file_size(fd) - detail::map_file_header_size) / sizeof(element_type);
+            detail::write_map_file_header<TId, TValue>(fd, detail::map_file_layout::sorted_list, sizeof(element_type), count);
+        }
+
+        /**
+         * Write a map to a map file and "seal" it, so that it can be
+         * opened by other processes with MappedFileMap at any time. The
+         * data is written to a temporary file "FILENAME.tmp" first which
+         * is synced to disk and then atomically renamed to the final name.
+         * Readers will either not find the file, or find it complete, and
+         * processes which still have an older version of the file mapped
+         * keep using that.
+         *
+         * All processes opening the same file with MappedFileMap share the
+         * pages of the file in the page cache, so the memory is only used
+         * once, regardless of the number of processes.
+         *
+         * @param filename Name of the map file.
+         * @param map The map to write, see write_map_file() for the maps
+         *            supported.
+         * @throws std::system_error If the file could not be written or
+         *         renamed.
+         */
+        template <typename TMap>
+        void seal_map_file(const std::string& filename, TMap& map) {
+            const std::string tmp_filename{filename + ".tmp"};
+            const int fd = osmium::io::detail::open_for_writing(tmp_filename, osmium::io::overwrite::allow);
+            try {
+                write_map_file(fd, map);
+                osmium::io::detail::reliable_fsync(fd);
+            } catch (...) {
+                ::close(fd);
+                std::remove(tmp_filename.c_str());
+                throw;
+            }
+            osmium::io::detail::reliable_close(fd);
+#ifdef _WIN32
+            // Rename doesn't replace existing files on Windows.
+            std::remove(filename.c_str());
+#endif
+            if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+                throw std::system_error{errno, std::system_category(), std::string{"Rename failed for '"} + tmp_filename + "'"};
+            }
+        }
+
+        namespace map {
+
+            /**
+             * Read-only map working directly on a memory mapped file
+             * written with write_map_file(). Opening the map is instant
+             * regardless of its size, the data is paged in by the
+             * kernel when it is used. Dense files are accessed by id,
+             * in sparse files the id is searched with a binary search.
+             *
+             * The sizes of the id and value types must match the ones
+             * the file was written with.
+             */
+            template <typename TId, typename TValue>
+            class MappedFileMap : public Map<TId, TValue> {
+
+                using element_type = std::pair<TId, TValue>;
+
+                osmium::util::MemoryMapping m_mapping;
+                detail::map_file_layout m_layout = detail::map_file_layout::dense_array;
+                std::size_t m_size = 0;
+
+                const uint64_t* header() const noexcept {
+                    return m_mapping.get_addr<const uint64_t>();
+                }
+
+                const char* data() const noexcept {
+                    return m_mapping.get_addr<const char>() + detail::map_file_header_size;
+                }
+
+                const TValue* values() const noexcept {
+                    return reinterpret_cast<const TValue*>(data());
+                }
+
+                const element_type* elements() const noexcept {
+                    return reinterpret_cast<const element_type*>(data());
+                }
+
+                static std::size_t check_file_size(const int fd) {
+                    const auto size = osmium::file_size(fd);
+                    if (size < detail::map_file_header_size) {
+                        throw std::runtime_error{"Invalid map file: file too short"};
+                    }
+                    return size;
+                }
+
+                void check_header(const std::size_t file_size) {
+                    if (header()[0] != detail::map_file_magic) {
+                        throw std::runtime_error{"Invalid map file: wrong type, version, or byte order"};
+                    }
+                    if (header()[2] != sizeof(TId) || header()[3] != sizeof(TValue)) {
+                        throw std::runtime_error{"Invalid map file: wrong id or value size"};
+                    }
+
+                    std::size_t element_size = 0;
+                    if (header()[1] == static_cast<uint64_t>(detail::map_file_layout::dense_array)) {
+                        m_layout = detail::map_file_layout::dense_array;
+                        element_size = sizeof(TValue);
+                    } else if (header()[1] == static_cast<uint64_t>(detail::map_file_layout::sorted_list)) {
+                        m_layout = detail::map_file_layout::sorted_list;
+                        element_size = sizeof(element_type);
+                    } else {
+                        throw std::runtime_error{"Invalid map file: unknown layout"};
+                    }
+                    if (header()[4] != element_size) {
+                        throw std::runtime_error{"Invalid map file: wrong element size"};
+                    }
+
+                    m_size = static_cast<std::size_t>(header()[5]);
+                    if (m_size > (file_size - detail::map_file_header_size) / element_size) {
+                        throw std::runtime_error{"Invalid map file: file too short"};
+                    }
+                }
+
+                static osmium::util::MemoryMapping map_file(const std::string& filename) {
+                    const int fd = ::open(filename.c_str(), O_RDONLY); // NOLINT(hicpp-signed-bitwise)
+                    if (fd == -1) {
+                        throw std::system_error{errno, std::system_category(), std::string{"can't open file '"} + filename + "'"};
+                    }
+                    try {
+                        osmium::util::MemoryMapping mapping{check_file_size(fd), osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+                        ::close(fd);
+                        return mapping;
+                    } catch (...) {
+                        ::close(fd);
+                        throw;
+                    }
+                }
+
+            public:
+
+                /**
+                 * Open map from file.
+                 *
+                 * @param fd File descriptor open for reading. The file can
+                 *           be closed after the constructor returns.
+                 * @throws std::runtime_error If the file is not a valid
+                 *         map file for these id and value types.
+                 * @throws std::system_error If the file could not be
+                 *         mapped.
+                 */
+                explicit MappedFileMap(const int fd) :
+                    m_mapping(check_file_size(fd), osmium::util::MemoryMapping::mapping_mode::readonly, fd) {
+                    check_header(m_mapping.size());
+                }
+
+                /**
+                 * Open map from the named file. The mapping is shared, so
+                 * several processes opening the same file use only one
+                 * copy of the data in memory. Use seal_map_file() to write
+                 * files which are opened while the writer is running.
+                 *
+                 * @param filename Name of the map file.
+                 * @throws std::runtime_error If the file is not a valid
+                 *         map file for these id and value types.
+                 * @throws std::system_error If the file could not be
+                 *         opened or mapped.
+                 */
+                explicit MappedFileMap(const std::string& filename) :
+                    m_mapping(map_file(filename)) {
+                    check_header(m_mapping.size());
+                }
+
+                /**
+                 * Is this a dense map accessed by id (or a sparse one)?
+                 */
+                bool is_dense() const noexcept {
+                    return m_layout == detail::map_file_layout::dense_array;
+                }
+
+                /**
+                 * The map is read-only.
+                 *
+                 * @throws std::runtime_error Always.
+                 */
+                void set(const TId /*id*/, const TValue /*value*/) final {
+                    throw std::runtime_error{"MappedFileMap is read-only"};
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    if (is_dense()) {
+                        if (id >= m_size) {
+                            return osmium::index::empty_value<TValue>();
+                        }
+                        return values()[id];
+                    }
+                    const element_type* const first = elements();
+                    const element_type* const last = first + m_size;
+                    const auto it = std::lower_bound(first, last, id, [](const element_type& element, const TId search_id) {
+                        return element.first < search_id;
+                    });
+                    if (it == last || it->first != id) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return it->second;
+                }
+
+                void set_access_hint(const osmium::MemoryMapping::access_hint hint) final {
+                    m_mapping.advise(hint);
+                }
+
+                /**
+                 * The number of entries in the file. For dense maps this
+                 * is the largest id plus one.
+                 */
+                std::size_t size() const final {
+                    return m_size;
+                }
+
+                /**
+                 * The map doesn't allocate any memory itself, but this
+                 * returns the size of the mapped data which will be in
+                 * memory if all of it is used.
+                 */
+                std::size_t used_memory() const final {
+                    return m_mapping.size();
+                }
+
+                /**
+                 * Unmap the file. The map is empty afterwards.
+                 */
+                void clear() final {
+                    m_mapping.unmap();
+                    m_size = 0;
+                }
+
+            }; // class MappedFileMap
+
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, MappedFileMap> {
+                MappedFileMap<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    if (config.size() < 2) {
+                        throw map_factory_error{"Need filename for map type 'mapped_file_map'"};
+                    }
+                    return new MappedFileMap<TId, TValue>{config[1]};
+                }
+            };
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::MappedFileMap, mapped_file_map)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_MAPPED_FILE_MAP_HPP
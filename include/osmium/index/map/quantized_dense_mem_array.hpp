@@ -0,0 +1,317 @@
+#ifndef OSMIUM_INDEX_MAP_QUANTIZED_DENSE_MEM_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_QUANTIZED_DENSE_MEM_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_QUANTIZED_DENSE_MEM_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Dense map from ids to locations which stores the coordinates
+             * with reduced precision. THE LOCATIONS RETURNED ARE NOT EXACT,
+             * only use this index where that doesn't matter, for instance
+             * for rendering.
+             *
+             * The ids are split into blocks of 64 ids. Each block has a
+             * "macro tile" whose origin is set from the first location
+             * stored in the block. For each id only the offset of the
+             * coordinates from this origin is stored as two 16 bit numbers
+             * in units of 2^precision_bits (by default 2^4 = 16) of the
+             * usual coordinate units of 1e-7 degrees. This needs a bit more than
+             * 4 bytes per id instead of the 8 bytes of the DenseMemArray.
+             *
+             * Each coordinate returned differs from the one stored by at
+             * most 2^(precision_bits-1) units, with the default precision
+             * this is 8e-7 degrees or less than 10cm. A tile spans about
+             * 65534 * 2^precision_bits units (about 0.1 degrees with the
+             * default precision) centered on the first location in the
+             * block. Locations outside that tile (because nodes with
+             * consecutive ids are far apart) and invalid locations are
+             * stored exactly in a separate hash map, which needs much more
+             * memory per entry. See outliers() for their number.
+             */
+            template <typename TId, typename TValue>
+            class QuantizedDenseMemArray : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value, "TValue must be osmium::Location");
+
+            public:
+
+                using element_type = TValue;
+
+                enum : std::size_t {
+                    block_bits = 6,
+                    block_size = 1UL << block_bits
+                };
+
+            private:
+
+                enum : uint32_t {
+                    empty_slot = 0,
+                    outlier_mark = 0xffffU,
+                    max_offset = 0xfffdU // stored + 1, so 0 and 0xffff are free
+                };
+
+                struct origin {
+                    int32_t x;
+                    int32_t y;
+                };
+
+                static constexpr const int32_t no_origin = std::numeric_limits<int32_t>::max();
+
+                std::vector<uint32_t> m_slots;
+                std::vector<origin> m_origins;
+                std::unordered_map<TId, TValue> m_outliers;
+                unsigned int m_precision_bits;
+
+                int32_t origin_for(const int32_t c) const noexcept {
+                    const int64_t o = static_cast<int64_t>(c) - (static_cast<int64_t>(max_offset / 2) << m_precision_bits);
+                    return static_cast<int32_t>(std::max(o, static_cast<int64_t>(std::numeric_limits<int32_t>::min())));
+                }
+
+                // Returns the offset of the coordinate from the origin
+                // plus 1 or 0 if it doesn't fit.
+                uint32_t quantize(const int32_t c, const int32_t o) const noexcept {
+                    const int64_t diff = static_cast<int64_t>(c) - o + ((1LL << m_precision_bits) >> 1U);
+                    if (diff < 0) {
+                        return 0;
+                    }
+                    const int64_t q = diff >> m_precision_bits;
+                    if (q > max_offset) {
+                        return 0;
+                    }
+                    return static_cast<uint32_t>(q) + 1;
+                }
+
+                int32_t dequantize(const uint32_t q, const int32_t o, const int32_t max_value) const noexcept {
+                    const int64_t c = static_cast<int64_t>(o) + (static_cast<int64_t>(q - 1) << m_precision_bits);
+                    return static_cast<int32_t>(std::min(std::max(c, static_cast<int64_t>(-max_value)), static_cast<int64_t>(max_value)));
+                }
+
+                uint32_t encode(const TId id, const TValue value) {
+                    if (!value.valid()) {
+                        return outlier_mark;
+                    }
+                    origin& o = m_origins[static_cast<std::size_t>(id) >> block_bits];
+                    if (o.x == no_origin) {
+                        o.x = origin_for(value.x());
+                        o.y = origin_for(value.y());
+                    }
+                    const uint32_t qx = quantize(value.x(), o.x);
+                    const uint32_t qy = quantize(value.y(), o.y);
+                    if (qx == 0 || qy == 0) {
+                        return outlier_mark;
+                    }
+                    return qx | (qy << 16U);
+                }
+
+                TValue decode(const TId id, const uint32_t slot) const {
+                    if (slot == empty_slot) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    if ((slot & 0xffffU) == outlier_mark) {
+                        const auto it = m_outliers.find(id);
+                        return it == m_outliers.end() ? osmium::index::empty_value<TValue>() : it->second;
+                    }
+                    const origin& o = m_origins[static_cast<std::size_t>(id) >> block_bits];
+                    return TValue{dequantize(slot & 0xffffU, o.x, 1800000000),
+                                  dequantize(slot >> 16U, o.y, 900000000)};
+                }
+
+            public:
+
+                /**
+                 * Create the map.
+                 *
+                 * @param precision_bits Coordinates are stored in units of
+                 *                       2^precision_bits * 1e-7 degrees.
+                 * @throws std::invalid_argument if precision_bits > 15.
+                 */
+                explicit QuantizedDenseMemArray(unsigned int precision_bits = 4) :
+                    m_precision_bits(precision_bits) {
+                    if (precision_bits > 15) {
+                        throw std::invalid_argument{"precision_bits for QuantizedDenseMemArray must be 15 or less"};
+                    }
+                }
+
+                /**
+                 * The largest difference between a coordinate stored in
+                 * the map and the one returned in units of 1e-7 degrees.
+                 * Outliers are returned exactly.
+                 */
+                int32_t max_error() const noexcept {
+                    return (1 << m_precision_bits) >> 1U;
+                }
+
+                /// The number of locations stored exactly in the hash map.
+                std::size_t outliers() const noexcept {
+                    return m_outliers.size();
+                }
+
+                void reserve(const std::size_t size) final {
+                    m_slots.reserve(size);
+                    m_origins.reserve((size + block_size - 1) / block_size);
+                }
+
+                void presize(const std::size_t /*count*/, const TId max_id) final {
+                    reserve(static_cast<std::size_t>(max_id) + 1);
+                }
+
+                void set(const TId id, const TValue value) final {
+                    const auto index = static_cast<std::size_t>(id);
+                    if (index >= m_slots.size()) {
+                        m_slots.resize(index + 1, empty_slot);
+                        m_origins.resize((index >> block_bits) + 1, origin{no_origin, no_origin});
+                    }
+                    if ((m_slots[index] & 0xffffU) == outlier_mark) {
+                        m_outliers.erase(id);
+                    }
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        m_slots[index] = empty_slot;
+                        return;
+                    }
+                    m_slots[index] = encode(id, value);
+                    if (m_slots[index] == outlier_mark) {
+                        m_outliers[id] = value;
+                    }
+                }
+
+                void update(const TId id, const TValue value) final {
+                    // Removing an id that isn't in the map must not enlarge it.
+                    if (static_cast<std::size_t>(id) >= m_slots.size() && value == osmium::index::empty_value<TValue>()) {
+                        return;
+                    }
+                    set(id, value);
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    if (static_cast<std::size_t>(id) >= m_slots.size()) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return decode(id, m_slots[static_cast<std::size_t>(id)]);
+                }
+
+                std::size_t size() const final {
+                    return m_slots.size();
+                }
+
+                std::size_t used_memory() const final {
+                    return m_slots.size() * sizeof(uint32_t) +
+                           m_origins.size() * sizeof(origin) +
+                           m_outliers.size() * (sizeof(typename std::unordered_map<TId, TValue>::value_type) + 2 * sizeof(void*));
+                }
+
+                void clear() final {
+                    m_slots.clear();
+                    m_slots.shrink_to_fit();
+                    m_origins.clear();
+                    m_origins.shrink_to_fit();
+                    m_outliers.clear();
+                }
+
+                void dump_as_array(const int fd) final {
+                    constexpr const std::size_t value_size = sizeof(TValue);
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / value_size;
+                    std::unique_ptr<TValue[]> output_buffer{new TValue[buffer_size]};
+
+                    for (std::size_t start = 0; start < m_slots.size(); start += buffer_size) {
+                        const std::size_t count = std::min(buffer_size, m_slots.size() - start);
+                        for (std::size_t i = 0; i < count; ++i) {
+                            output_buffer[i] = decode(static_cast<TId>(start + i), m_slots[start + i]);
+                        }
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.get()), count * value_size);
+                    }
+                }
+
+                void dump_as_list(const int fd) final {
+                    using list_element_type = std::pair<TId, TValue>;
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / sizeof(list_element_type);
+                    std::vector<list_element_type> output_buffer;
+                    output_buffer.reserve(buffer_size);
+
+                    for (std::size_t i = 0; i < m_slots.size(); ++i) {
+                        if (m_slots[i] == empty_slot) {
+                            continue;
+                        }
+                        const auto id = static_cast<TId>(i);
+                        output_buffer.emplace_back(id, decode(id, m_slots[i]));
+                        if (output_buffer.size() == buffer_size) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.data()), output_buffer.size() * sizeof(list_element_type));
+                            output_buffer.clear();
+                        }
+                    }
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.data()), output_buffer.size() * sizeof(list_element_type));
+                }
+
+            }; // class QuantizedDenseMemArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::QuantizedDenseMemArray, quantized_dense_mem_array)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_QUANTIZED_DENSE_MEM_ARRAY_HPP
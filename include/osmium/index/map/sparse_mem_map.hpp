@@ -76,6 +76,14 @@ namespace osmium {
                     m_elements[id] = value;
                 }
 
+                void update(const TId id, const TValue value) final {
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        m_elements.erase(id);
+                    } else {
+                        m_elements[id] = value;
+                    }
+                }
+
                 TValue get(const TId id) const final {
                     const auto it = m_elements.find(id);
                     if (it == m_elements.end()) {
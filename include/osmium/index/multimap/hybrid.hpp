@@ -60,6 +60,11 @@ namespace osmium {
                 typename extra_map_type::iterator m_begin_extra;
                 typename extra_map_type::iterator m_end_extra;
 
+                // The elements in the extra map have a different type
+                // (std::pair<const TId, TValue>), they are copied here
+                // to return a reference to them.
+                element_type m_extra_element;
+
             public:
 
                  HybridIterator(typename main_map_type::iterator begin_main,
@@ -105,7 +110,8 @@ namespace osmium {
 
                 const element_type& operator*() {
                     if (m_begin_main == m_end_main) {
-                        return *m_begin_extra;
+                        m_extra_element = *m_begin_extra;
+                        return m_extra_element;
                     } else {
                         return *m_begin_main;
                     }
@@ -126,6 +132,10 @@ namespace osmium {
                 main_map_type m_main;
                 extra_map_type m_extra;
 
+                // Is m_main sorted? Elements added with unsorted_set() are
+                // appended, so it isn't after those.
+                bool m_main_sorted = true;
+
             public:
 
                 using iterator       = HybridIterator<TId, TValue>;
@@ -152,6 +162,7 @@ namespace osmium {
 
                 void unsorted_set(const TId id, const TValue value) {
                     m_main.set(id, value);
+                    m_main_sorted = false;
                 }
 
                 void set(const TId id, const TValue value) final {
@@ -170,13 +181,22 @@ namespace osmium {
                     m_extra.remove(id, value);
                 }
 
+                /**
+                 * Move all elements from the extra map into the main map
+                 * and drop removed elements. The extra map is kept sorted,
+                 * so if the main map is sorted, too, it is merged in
+                 * linear time instead of sorting everything again. This
+                 * makes it cheap to consolidate often, for instance after
+                 * each change file applied.
+                 */
                 void consolidate() {
-                    m_main.erase_removed();
-                    for (const auto& element : m_extra) {
-                        m_main.set(element.first, element.second);
+                    if (!m_main_sorted) {
+                        m_main.sort();
+                        m_main_sorted = true;
                     }
+                    m_main.erase_removed();
+                    m_main.merge_sorted(m_extra.begin(), m_extra.end());
                     m_extra.clear();
-                    m_main.sort();
                 }
 
                 void dump_as_list(const int fd) final {
@@ -187,10 +207,12 @@ namespace osmium {
                 void clear() final {
                     m_main.clear();
                     m_extra.clear();
+                    m_main_sorted = true;
                 }
 
                 void sort() final {
                     m_main.sort();
+                    m_main_sorted = true;
                 }
 
             }; // class Hybrid
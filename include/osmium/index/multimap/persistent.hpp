@@ -0,0 +1,368 @@
+#ifndef OSMIUM_INDEX_MULTIMAP_PERSISTENT_HPP
+#define OSMIUM_INDEX_MULTIMAP_PERSISTENT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/mmap_vector_file.hpp>
+#include <osmium/index/detail/sort_by_id.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/multimap.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace multimap {
+
+            /**
+             * Multimap stored in files which can be updated efficiently,
+             * for instance to keep reverse indexes (node to ways, way to
+             * relations) up to date from change files.
+             *
+             * The data is kept in two memory mapped files: A sorted main
+             * file and a log of additions and removals in the order they
+             * happened. Lookups combine both. From time to time the log has
+             * to be merged into the main file by calling compact(). The
+             * function needs_compaction() tells you when this is a good
+             * idea.
+             *
+             * For the initial load use set() and call sort() when done.
+             * Afterwards use add() and remove().
+             *
+             * The files are given as file descriptors which must be opened
+             * read-write. They are not closed by this class. If the files
+             * are not empty, the data in them is used.
+             */
+            template <typename TId, typename TValue>
+            class PersistentMultimap : public Multimap<TId, TValue> {
+
+            public:
+
+                using element_type = typename std::pair<TId, TValue>;
+
+                /// Entry in the log.
+                struct log_entry {
+
+                    enum : uint32_t {
+                        op_add    = 1,
+                        op_remove = 2
+                    };
+
+                    TId id;
+                    TValue value;
+                    uint32_t op;
+
+                    log_entry() noexcept :
+                        id(),
+                        value(),
+                        op(0) {
+                    }
+
+                    log_entry(const TId i, const TValue v, uint32_t o) noexcept :
+                        id(i),
+                        value(v),
+                        op(o) {
+                    }
+
+                    bool operator==(const log_entry& other) const noexcept {
+                        return id == other.id && value == other.value && op == other.op;
+                    }
+
+                    bool operator!=(const log_entry& other) const noexcept {
+                        return !(*this == other);
+                    }
+
+                }; // struct log_entry
+
+                enum {
+                    /**
+                     * The log should be compacted if it has more entries
+                     * than the main data divided by this...
+                     */
+                    compaction_divisor = 16,
+
+                    /// ... but not before it has this many entries.
+                    min_compaction_size = 1024
+                };
+
+            private:
+
+                osmium::detail::mmap_vector_file<element_type> m_main;
+                osmium::detail::mmap_vector_file<log_entry> m_log;
+
+                // Positions of the log entries ordered by id and, for the
+                // same id, by position. Built when needed.
+                mutable std::vector<std::size_t> m_log_index;
+                mutable bool m_log_index_valid = false;
+
+                template <typename TVector>
+                static void truncate(TVector& vector, std::size_t size) {
+                    using value_type = typename std::decay<decltype(*vector.begin())>::type;
+                    std::fill(vector.begin() + size, vector.end(), osmium::index::empty_value<value_type>());
+                    vector.resize(size);
+                }
+
+                void build_log_index() const {
+                    m_log_index.resize(m_log.size());
+                    for (std::size_t i = 0; i < m_log_index.size(); ++i) {
+                        m_log_index[i] = i;
+                    }
+                    std::stable_sort(m_log_index.begin(), m_log_index.end(), [this](std::size_t a, std::size_t b) {
+                        return m_log[a].id < m_log[b].id;
+                    });
+                    m_log_index_valid = true;
+                }
+
+                void add_to_log(const TId id, const TValue value, uint32_t op) {
+                    m_log.push_back(log_entry{id, value, op});
+                    m_log_index_valid = false;
+                }
+
+            public:
+
+                /**
+                 * Create multimap using temporary files.
+                 */
+                PersistentMultimap() = default;
+
+                /**
+                 * Create multimap using the given files.
+                 *
+                 * @param main_fd File descriptor of the main data file.
+                 * @param log_fd File descriptor of the log file.
+                 */
+                PersistentMultimap(const int main_fd, const int log_fd) :
+                    m_main(main_fd),
+                    m_log(log_fd) {
+                }
+
+                /**
+                 * Set value for id when loading the data initially.
+                 * Call sort() after all data was loaded.
+                 */
+                void set(const TId id, const TValue value) final {
+                    m_main.push_back(element_type{id, value});
+                }
+
+                /**
+                 * Sort the main data and remove duplicates. Call this after
+                 * the initial load with set().
+                 */
+                void sort() final {
+                    osmium::index::detail::sort_by_id(m_main.begin(), m_main.end());
+                    const auto last = std::unique(m_main.begin(), m_main.end());
+                    truncate(m_main, static_cast<std::size_t>(last - m_main.begin()));
+                }
+
+                /**
+                 * Add the value for the id. Adding a value that is already
+                 * there has no effect.
+                 */
+                void add(const TId id, const TValue value) {
+                    add_to_log(id, value, log_entry::op_add);
+                }
+
+                /**
+                 * Remove the value for the id. Removing a value that isn't
+                 * there has no effect.
+                 */
+                void remove(const TId id, const TValue value) {
+                    add_to_log(id, value, log_entry::op_remove);
+                }
+
+                /**
+                 * Get all values for the id in order.
+                 */
+                std::vector<TValue> get_all(const TId id) const {
+                    std::vector<TValue> values;
+
+                    const auto range = std::equal_range(m_main.cbegin(), m_main.cend(), element_type{id, TValue{}}, [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+                    for (auto it = range.first; it != range.second; ++it) {
+                        values.push_back(it->second);
+                    }
+
+                    if (m_log.empty()) {
+                        return values;
+                    }
+
+                    if (!m_log_index_valid) {
+                        build_log_index();
+                    }
+
+                    auto it = std::lower_bound(m_log_index.cbegin(), m_log_index.cend(), id, [this](std::size_t pos, const TId i) {
+                        return m_log[pos].id < i;
+                    });
+                    for (; it != m_log_index.cend() && m_log[*it].id == id; ++it) {
+                        const auto& entry = m_log[*it];
+                        const auto vit = std::lower_bound(values.begin(), values.end(), entry.value);
+                        const bool found = vit != values.end() && *vit == entry.value;
+                        if (entry.op == log_entry::op_add && !found) {
+                            values.insert(vit, entry.value);
+                        } else if (entry.op == log_entry::op_remove && found) {
+                            values.erase(vit);
+                        }
+                    }
+
+                    return values;
+                }
+
+                /**
+                 * Get the number of entries in the main data plus the number
+                 * of entries in the log.
+                 */
+                std::size_t size() const final {
+                    return m_main.size() + m_log.size();
+                }
+
+                /// The number of entries in the log.
+                std::size_t log_size() const noexcept {
+                    return m_log.size();
+                }
+
+                std::size_t used_memory() const final {
+                    return sizeof(element_type) * m_main.size() +
+                           sizeof(log_entry) * m_log.size() +
+                           sizeof(std::size_t) * m_log_index.capacity();
+                }
+
+                void clear() final {
+                    truncate(m_main, 0);
+                    truncate(m_log, 0);
+                    m_log_index.clear();
+                    m_log_index.shrink_to_fit();
+                    m_log_index_valid = false;
+                }
+
+                /**
+                 * Is the log large enough compared to the main data that
+                 * compact() should be called?
+                 */
+                bool needs_compaction() const noexcept {
+                    return m_log.size() >= min_compaction_size &&
+                           m_log.size() > m_main.size() / compaction_divisor;
+                }
+
+                /**
+                 * Merge the log into the main data and clear the log. Only
+                 * the log is sorted, it is then merged in place with the
+                 * main data in linear time.
+                 */
+                void compact() {
+                    if (m_log.empty()) {
+                        return;
+                    }
+
+                    // Sort log by id and value keeping only the last entry
+                    // for each pair.
+                    std::vector<log_entry> ops(m_log.begin(), m_log.end());
+                    std::stable_sort(ops.begin(), ops.end(), [](const log_entry& a, const log_entry& b) {
+                        return element_type{a.id, a.value} < element_type{b.id, b.value};
+                    });
+                    std::size_t num_ops = 0;
+                    std::size_t num_adds = 0;
+                    for (std::size_t i = 0; i < ops.size(); ++i) {
+                        if (i + 1 == ops.size() || ops[i + 1].id != ops[i].id || ops[i + 1].value != ops[i].value) {
+                            if (ops[i].op == log_entry::op_add) {
+                                ++num_adds;
+                            }
+                            ops[num_ops++] = ops[i];
+                        }
+                    }
+
+                    // Merge from the back into the enlarged vector, so that
+                    // no element is overwritten before it is moved. Removed
+                    // elements are marked with the empty value.
+                    const auto removed = osmium::index::empty_value<element_type>();
+                    std::size_t in = m_main.size();
+                    std::size_t out = in + num_adds;
+                    m_main.resize(out);
+                    while (num_ops > 0) {
+                        const auto& op = ops[num_ops - 1];
+                        const element_type element{op.id, op.value};
+                        if (in > 0 && element < m_main[in - 1]) {
+                            m_main[--out] = m_main[--in];
+                            continue;
+                        }
+                        const bool found = in > 0 && m_main[in - 1] == element;
+                        if (found) {
+                            --in;
+                        }
+                        if (op.op == log_entry::op_add) {
+                            m_main[--out] = element;
+                        } else if (found) {
+                            m_main[--out] = removed;
+                        }
+                        --num_ops;
+                    }
+
+                    // Close the gap and remove the removed elements.
+                    std::size_t size = in;
+                    for (std::size_t i = out; i < m_main.size(); ++i) {
+                        if (m_main[i] != removed) {
+                            m_main[size++] = m_main[i];
+                        }
+                    }
+                    truncate(m_main, size);
+
+                    truncate(m_log, 0);
+                    m_log_index.clear();
+                    m_log_index_valid = false;
+                }
+
+                /// Iterate over the main data (not including the log).
+                typename osmium::detail::mmap_vector_file<element_type>::const_iterator begin() const {
+                    return m_main.cbegin();
+                }
+
+                typename osmium::detail::mmap_vector_file<element_type>::const_iterator end() const {
+                    return m_main.cend();
+                }
+
+            }; // class PersistentMultimap
+
+        } // namespace multimap
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MULTIMAP_PERSISTENT_HPP
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/sort_by_id.hpp>
 #include <osmium/index/multimap.hpp>
 #include <osmium/io/detail/read_write.hpp>
 
@@ -137,7 +138,7 @@ namespace osmium {
                     for (const auto& element : m_elements) {
                         v.emplace_back(element.first, element.second);
                     }
-                    std::sort(v.begin(), v.end());
+                    osmium::index::detail::sort_by_id(v.begin(), v.end());
                     osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(v.data()), sizeof(element_type) * v.size());
                 }
 
@@ -39,6 +39,18 @@ DEALINGS IN THE SOFTWARE.
 
 #define OSMIUM_WANT_NODE_LOCATION_MAPS
 
+#ifdef OSMIUM_HAS_INDEX_MAP_COMPACT_SPARSE_MEM_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompactSparseMemArray, compact_sparse_mem_array)
+#endif
+
+#ifdef OSMIUM_HAS_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedSparseMemArray, compressed_sparse_mem_array)
+#endif
+
+#ifdef OSMIUM_HAS_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::ConcurrentDenseMmapArray, concurrent_dense_mmap_array)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_DENSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseFileArray, dense_file_array)
 #endif
@@ -51,6 +63,18 @@ DEALINGS IN THE SOFTWARE.
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseMmapArray, dense_mmap_array)
 #endif
 
+#ifdef OSMIUM_HAS_INDEX_MAP_FLAT_HASH_MAP
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::FlatHashMap, flat_hash)
+#endif
+
+#ifdef OSMIUM_HAS_INDEX_MAP_MAPPED_FILE_MAP
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::MappedFileMap, mapped_file_map)
+#endif
+
+#ifdef OSMIUM_HAS_INDEX_MAP_QUANTIZED_DENSE_MEM_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::QuantizedDenseMemArray, quantized_dense_mem_array)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseFileArray, sparse_file_array)
 #endif
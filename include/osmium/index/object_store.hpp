@@ -0,0 +1,342 @@
+#ifndef OSMIUM_INDEX_OBJECT_STORE_HPP
+#define OSMIUM_INDEX_OBJECT_STORE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler/disk_store.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            inline std::string object_store_data_file(const std::string& directory) {
+                return directory + "/data.osm.ser";
+            }
+
+            inline std::string object_store_index_file(const std::string& directory, const osmium::item_type type) {
+                return directory + "/" + osmium::item_type_to_name(type) + "s.idx";
+            }
+
+        } // namespace detail
+
+        /**
+         * Writes OSM objects into a directory which can then be opened
+         * with an ObjectStore. The directory must exist. It will contain
+         * the objects in the Osmium-internal format in the file
+         * "data.osm.ser" as written by the DiskStore handler and sorted
+         * offset indexes in the files "nodes.idx", "ways.idx", and
+         * "relations.idx" (as written by dump_as_list() of the sparse
+         * maps). This is the same layout the osmium_dump_internal example
+         * creates.
+         *
+         * Every object (type and id) must only be added once. Only nodes,
+         * ways, and relations are stored.
+         */
+        class ObjectStoreWriter {
+
+            using offset_index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, std::size_t>;
+
+            std::string m_directory;
+            int m_data_fd;
+            offset_index_type m_node_index;
+            offset_index_type m_way_index;
+            offset_index_type m_relation_index;
+            osmium::handler::DiskStore m_disk_store;
+
+            void write_index(offset_index_type& index, const osmium::item_type type) const {
+                index.sort();
+                const int fd = osmium::io::detail::open_for_writing(detail::object_store_index_file(m_directory, type), osmium::io::overwrite::allow);
+                try {
+                    index.dump_as_list(fd);
+                } catch (...) {
+                    try {
+                        osmium::io::detail::reliable_close(fd);
+                    } catch (...) {
+                    }
+                    throw;
+                }
+                osmium::io::detail::reliable_close(fd);
+            }
+
+        public:
+
+            /**
+             * Create the files of the store in the directory. Existing
+             * files are overwritten.
+             *
+             * @throws std::system_error If the data file can't be opened.
+             */
+            explicit ObjectStoreWriter(const std::string& directory) :
+                m_directory(directory),
+                m_data_fd(osmium::io::detail::open_for_writing(detail::object_store_data_file(directory), osmium::io::overwrite::allow)),
+                m_disk_store(m_data_fd, m_node_index, m_way_index, m_relation_index) {
+            }
+
+            ObjectStoreWriter(const ObjectStoreWriter&) = delete;
+            ObjectStoreWriter& operator=(const ObjectStoreWriter&) = delete;
+
+            ObjectStoreWriter(ObjectStoreWriter&&) = delete;
+            ObjectStoreWriter& operator=(ObjectStoreWriter&&) = delete;
+
+            ~ObjectStoreWriter() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Add all objects in the buffer to the store.
+             */
+            void operator()(const osmium::memory::Buffer& buffer) {
+                m_disk_store(buffer);
+            }
+
+            /**
+             * Write the indexes and close all files. The store can only
+             * be opened after this was called.
+             *
+             * @throws std::system_error If there was an error writing.
+             */
+            void close() {
+                if (m_data_fd < 0) {
+                    return;
+                }
+                const int fd = m_data_fd;
+                m_data_fd = -1;
+                osmium::io::detail::reliable_close(fd);
+
+                write_index(m_node_index, osmium::item_type::node);
+                write_index(m_way_index, osmium::item_type::way);
+                write_index(m_relation_index, osmium::item_type::relation);
+            }
+
+        }; // class ObjectStoreWriter
+
+        /**
+         * Read-only access to OSM objects by type and id in a directory
+         * written by the ObjectStoreWriter (or the osmium_dump_internal
+         * example). The data file and the indexes are memory mapped, an
+         * object is found with a binary search in the index and returned
+         * as a reference into the mapping without any parsing or copying.
+         *
+         * All const member functions are thread-safe.
+         */
+        class ObjectStore {
+
+        public:
+
+            using element_type = std::pair<osmium::unsigned_object_id_type, std::size_t>;
+
+        private:
+
+            // Mapping of a file, empty files are not mapped at all.
+            template <typename T>
+            class mapped_file {
+
+                std::unique_ptr<osmium::util::TypedMemoryMapping<T>> m_mapping;
+                std::size_t m_size = 0;
+
+            public:
+
+                explicit mapped_file(const std::string& filename) {
+                    const int fd = osmium::io::detail::open_for_reading(filename);
+                    try {
+                        const auto file_size = osmium::file_size(fd);
+                        if (file_size % sizeof(T) != 0) {
+                            throw std::runtime_error{"Index file has wrong size (must be multiple of " + std::to_string(sizeof(T)) + ")."};
+                        }
+                        m_size = file_size / sizeof(T);
+                        if (m_size > 0) {
+                            m_mapping.reset(new osmium::util::TypedMemoryMapping<T>{m_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd});
+                        }
+                    } catch (...) {
+                        try {
+                            osmium::io::detail::reliable_close(fd);
+                        } catch (...) {
+                        }
+                        throw;
+                    }
+                    // The mapping stays valid after the file is closed.
+                    osmium::io::detail::reliable_close(fd);
+                }
+
+                const T* begin() const noexcept {
+                    return m_mapping ? m_mapping->begin() : nullptr;
+                }
+
+                const T* end() const noexcept {
+                    return begin() + m_size;
+                }
+
+                std::size_t size() const noexcept {
+                    return m_size;
+                }
+
+            }; // class mapped_file
+
+            mapped_file<unsigned char> m_data;
+            mapped_file<element_type> m_node_index;
+            mapped_file<element_type> m_way_index;
+            mapped_file<element_type> m_relation_index;
+
+            const mapped_file<element_type>* index(const osmium::item_type type) const noexcept {
+                switch (type) {
+                    case osmium::item_type::node:
+                        return &m_node_index;
+                    case osmium::item_type::way:
+                        return &m_way_index;
+                    case osmium::item_type::relation:
+                        return &m_relation_index;
+                    default:
+                        break;
+                }
+                return nullptr;
+            }
+
+        public:
+
+            /**
+             * Open the store in the directory.
+             *
+             * @throws std::system_error If a file can't be opened or mapped.
+             * @throws std::runtime_error If an index file is broken.
+             */
+            explicit ObjectStore(const std::string& directory) :
+                m_data(detail::object_store_data_file(directory)),
+                m_node_index(detail::object_store_index_file(directory, osmium::item_type::node)),
+                m_way_index(detail::object_store_index_file(directory, osmium::item_type::way)),
+                m_relation_index(detail::object_store_index_file(directory, osmium::item_type::relation)) {
+            }
+
+            /**
+             * The number of objects of the given type in the store.
+             */
+            std::size_t size(const osmium::item_type type) const noexcept {
+                const auto* idx = index(type);
+                return idx ? idx->size() : 0;
+            }
+
+            /**
+             * Get the object with the given type and id.
+             *
+             * The store uses positive ids (see the DiskStore handler), the
+             * sign of the id is ignored.
+             *
+             * @returns Pointer to the object in the mapped data or nullptr
+             *          if it is not in the store or the store is broken.
+             */
+            const osmium::OSMObject* get_noexcept(const osmium::item_type type, const osmium::object_id_type id) const noexcept {
+                const auto* idx = index(type);
+                if (!idx) {
+                    return nullptr;
+                }
+
+                const auto positive_id = static_cast<osmium::unsigned_object_id_type>(id < 0 ? -id : id);
+                const auto it = std::lower_bound(idx->begin(), idx->end(), positive_id, [](const element_type& element, const osmium::unsigned_object_id_type value) {
+                    return element.first < value;
+                });
+                if (it == idx->end() || it->first != positive_id) {
+                    return nullptr;
+                }
+
+                // Check the offset and the item found there, so that a
+                // broken store can not lead to reads outside the mapping.
+                const std::size_t offset = it->second;
+                if (offset % osmium::memory::align_bytes != 0 || offset > m_data.size() || m_data.size() - offset < sizeof(osmium::memory::Item)) {
+                    return nullptr;
+                }
+                const auto& item = *reinterpret_cast<const osmium::memory::Item*>(m_data.begin() + offset);
+                if (item.type() != type || item.byte_size() > m_data.size() - offset) {
+                    return nullptr;
+                }
+
+                return static_cast<const osmium::OSMObject*>(&item);
+            }
+
+            /**
+             * Get the object with the given type and id.
+             *
+             * @throws osmium::not_found If the object is not in the store.
+             */
+            const osmium::OSMObject& get(const osmium::item_type type, const osmium::object_id_type id) const {
+                const auto* object = get_noexcept(type, id);
+                if (!object) {
+                    throw osmium::not_found{std::string{osmium::item_type_to_name(type)} + " " + std::to_string(id) + " not found"};
+                }
+                return *object;
+            }
+
+            const osmium::Node& get_node(const osmium::object_id_type id) const {
+                return static_cast<const osmium::Node&>(get(osmium::item_type::node, id));
+            }
+
+            const osmium::Way& get_way(const osmium::object_id_type id) const {
+                return static_cast<const osmium::Way&>(get(osmium::item_type::way, id));
+            }
+
+            const osmium::Relation& get_relation(const osmium::object_id_type id) const {
+                return static_cast<const osmium::Relation&>(get(osmium::item_type::relation, id));
+            }
+
+        }; // class ObjectStore
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_OBJECT_STORE_HPP
@@ -41,6 +41,8 @@ DEALINGS IN THE SOFTWARE.
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <stdexcept>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -137,6 +139,14 @@ namespace osmium {
                     m_map.reserve(size);
                 }
 
+                const_iterator begin() const noexcept {
+                    return m_map.cbegin();
+                }
+
+                const_iterator end() const noexcept {
+                    return m_map.cend();
+                }
+
             }; // class flat_map
 
         } // namespace detail
@@ -263,6 +273,141 @@ namespace osmium {
         inline RelationsMapIndex::RelationsMapIndex(RelationsMapIndex&&) noexcept(std::is_nothrow_move_constructible<map_type>::value) = default;
         inline RelationsMapIndex& RelationsMapIndex::operator=(RelationsMapIndex&&) noexcept(std::is_nothrow_move_assignable<map_type>::value) = default;
 
+        /**
+         * Read-only index for looking up parent relation IDs given a member
+         * relation ID or the other way around using a compressed sparse row
+         * layout: An array indexed by the ID holds the offsets into a flat
+         * array of related IDs. Lookups are constant time and need only
+         * two memory accesses.
+         *
+         * The offset array needs 4 bytes for every ID up to the largest ID
+         * in the index, so this works best for dense ID ranges (like
+         * relation IDs in a planet file). Use RelationsMapIndex if memory
+         * is tight.
+         *
+         * Like the RelationsMapIndex you can not instantiate this yourself,
+         * create it from a RelationsMapStash:
+         *
+         * @code
+         * RelationsMapStash stash;
+         * ...
+         * const auto index = stash.build_member_to_parent_csr_index();
+         * @endcode
+         *
+         * The index is never changed after construction, so it can be used
+         * from several threads at the same time.
+         */
+        class RelationsMapCSRIndex {
+
+            friend class RelationsMapStash;
+
+            using map_type = detail::flat_map<osmium::unsigned_object_id_type, uint32_t,
+                                              osmium::unsigned_object_id_type, uint32_t>;
+
+            // Entry n contains the offset of the first related ID of ID n in
+            // m_values. The related IDs of ID n end at m_offsets[n + 1].
+            std::vector<uint32_t> m_offsets;
+
+            std::vector<uint32_t> m_values;
+
+            // The map must be sorted.
+            explicit RelationsMapCSRIndex(const map_type& map) {
+                if (map.size() > std::numeric_limits<uint32_t>::max()) {
+                    throw std::length_error{"RelationsMapCSRIndex can not hold more than 2^32 entries"};
+                }
+                if (map.empty()) {
+                    return;
+                }
+
+                const auto max_id = static_cast<std::size_t>((map.end() - 1)->key);
+                m_offsets.resize(max_id + 2);
+                m_values.reserve(map.size());
+
+                std::size_t id = 0;
+                for (const auto& p : map) {
+                    while (id <= p.key) {
+                        m_offsets[id++] = static_cast<uint32_t>(m_values.size());
+                    }
+                    m_values.push_back(p.value);
+                }
+                m_offsets[id] = static_cast<uint32_t>(m_values.size());
+            }
+
+        public:
+
+            RelationsMapCSRIndex() = delete;
+
+            RelationsMapCSRIndex(const RelationsMapCSRIndex&) = delete;
+            RelationsMapCSRIndex& operator=(const RelationsMapCSRIndex&) = delete;
+
+            RelationsMapCSRIndex(RelationsMapCSRIndex&&) noexcept = default;
+            RelationsMapCSRIndex& operator=(RelationsMapCSRIndex&&) noexcept = default;
+
+            ~RelationsMapCSRIndex() noexcept = default;
+
+            /**
+             * Find the given relation id in the index and call the given
+             * function with all related relation ids.
+             *
+             * @code
+             * osmium::unsigned_object_id_type id = 17;
+             * index.for_each(id, [](osmium::unsigned_object_id_type rid) {
+             *   ...
+             * });
+             * @endcode
+             *
+             * Complexity: Constant (plus linear in the number of results).
+             */
+            template <typename TFunc>
+            void for_each(const osmium::unsigned_object_id_type id, TFunc&& func) const {
+                if (id + 1 >= m_offsets.size()) {
+                    return;
+                }
+                const auto last = m_offsets[id + 1];
+                for (auto n = m_offsets[id]; n < last; ++n) {
+                    std::forward<TFunc>(func)(static_cast<osmium::unsigned_object_id_type>(m_values[n]));
+                }
+            }
+
+            /**
+             * How many related relation ids does the given id have?
+             *
+             * Complexity: Constant.
+             */
+            std::size_t count(const osmium::unsigned_object_id_type id) const noexcept {
+                if (id + 1 >= m_offsets.size()) {
+                    return 0;
+                }
+                return m_offsets[id + 1] - m_offsets[id];
+            }
+
+            /**
+             * Is this index empty?
+             *
+             * Complexity: Constant.
+             */
+            bool empty() const noexcept {
+                return m_values.empty();
+            }
+
+            /**
+             * How many entries are in this index?
+             *
+             * Complexity: Constant.
+             */
+            std::size_t size() const noexcept {
+                return m_values.size();
+            }
+
+            /**
+             * The amount of memory used by this index in bytes.
+             */
+            std::size_t used_memory() const noexcept {
+                return (m_offsets.capacity() + m_values.capacity()) * sizeof(uint32_t);
+            }
+
+        }; // class RelationsMapCSRIndex
+
         class RelationsMapIndexes {
 
             friend class RelationsMapStash;
@@ -421,6 +566,41 @@ namespace osmium {
                 return RelationsMapIndex{std::move(m_map)};
             }
 
+            /**
+             * Build a RelationsMapCSRIndex for member to parent lookups from
+             * the contents of this stash and return it.
+             *
+             * After you get the index you can not use the stash any more!
+             */
+            RelationsMapCSRIndex build_member_to_parent_csr_index() {
+                assert(m_valid && "You can't use the RelationsMap any more after calling build_member_to_parent_csr_index()");
+                m_map.sort_unique();
+#ifndef NDEBUG
+                m_valid = false;
+#endif
+                RelationsMapCSRIndex index{m_map};
+                m_map = map_type{};
+                return index;
+            }
+
+            /**
+             * Build a RelationsMapCSRIndex for parent to member lookups from
+             * the contents of this stash and return it.
+             *
+             * After you get the index you can not use the stash any more!
+             */
+            RelationsMapCSRIndex build_parent_to_member_csr_index() {
+                assert(m_valid && "You can't use the RelationsMap any more after calling build_parent_to_member_csr_index()");
+                m_map.flip_in_place();
+                m_map.sort_unique();
+#ifndef NDEBUG
+                m_valid = false;
+#endif
+                RelationsMapCSRIndex index{m_map};
+                m_map = map_type{};
+                return index;
+            }
+
             /**
              * Build indexes for member-to-parent and parent-to-member lookups
              * from the contents of this stash and return them.
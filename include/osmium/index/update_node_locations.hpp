@@ -0,0 +1,98 @@
+#ifndef OSMIUM_INDEX_UPDATE_NODE_LOCATIONS_HPP
+#define OSMIUM_INDEX_UPDATE_NODE_LOCATIONS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Apply the node changes in a buffer (usually read from an OSM
+         * change file) to a node location index. Nodes that are visible
+         * are set to their new location, deleted nodes are removed from the
+         * index. If a node is in the buffer several times, the last one
+         * wins. Nodes with negative ids are ignored.
+         *
+         * Call commit_updates() on the index after all changes have been
+         * applied and before using the index again.
+         *
+         * @tparam TMap Location index, derived from
+         *              osmium::index::map::Map<unsigned_object_id_type, Location>.
+         * @param index The index.
+         * @param changes Buffer with changes. Objects other than nodes are
+         *                ignored.
+         */
+        template <typename TMap>
+        void update_node_locations(TMap& index, const osmium::memory::Buffer& changes) {
+            for (const auto& node : changes.select<osmium::Node>()) {
+                if (node.id() < 0) {
+                    continue;
+                }
+                const auto id = static_cast<osmium::unsigned_object_id_type>(node.id());
+                if (node.visible()) {
+                    index.update(id, node.location());
+                } else {
+                    index.update(id, osmium::index::empty_value<osmium::Location>());
+                }
+            }
+        }
+
+        /**
+         * Apply the node changes from a source (usually an osmium::io::Reader
+         * reading an OSM change file) to a node location index and commit
+         * them. See the other overload of this function for the details.
+         *
+         * @tparam TMap Location index.
+         * @tparam TSource Source of buffers. Its read() function is called
+         *                 until it returns an invalid buffer.
+         */
+        template <typename TMap, typename TSource>
+        void update_node_locations(TMap& index, TSource& source) {
+            while (const auto buffer = source.read()) {
+                update_node_locations(index, buffer);
+            }
+            index.commit_updates();
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_UPDATE_NODE_LOCATIONS_HPP
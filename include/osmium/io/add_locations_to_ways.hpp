@@ -0,0 +1,170 @@
+#ifndef OSMIUM_IO_ADD_LOCATIONS_TO_WAYS_HPP
+#define OSMIUM_IO_ADD_LOCATIONS_TO_WAYS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/parallel_visitor.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            inline bool buffer_contains(const osmium::memory::Buffer& buffer, const osmium::item_type type) {
+                for (const auto& item : buffer) {
+                    if (item.type() == type) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            template <typename TStoragePosIDs, typename TStorageNegIDs>
+            inline void submit_add_locations(osmium::thread::Pool& pool,
+                                             osmium::detail::parallel_apply_buffer& pending,
+                                             const osmium::handler::NodeLocationsForWays<TStoragePosIDs, TStorageNegIDs>& handler) {
+                using iterator = osmium::memory::Buffer::iterator;
+                using lookup_buffers = typename osmium::handler::NodeLocationsForWays<TStoragePosIDs, TStorageNegIDs>::lookup_buffers;
+
+                const std::shared_ptr<osmium::memory::Buffer> buffer{pending.buffer};
+                iterator it = buffer->begin();
+                const iterator end = buffer->end();
+                while (it != end) {
+                    const iterator first = it;
+                    for (std::size_t n = 0; n < osmium::detail::apply_parallel_slice_size && it != end; ++n) {
+                        ++it;
+                    }
+                    const iterator last = it;
+                    pending.futures.push_back(pool.submit([buffer, first, last, &handler]() {
+                        lookup_buffers buffers;
+                        for (auto i = first; i != last; ++i) {
+                            if (i->type() == osmium::item_type::way) {
+                                handler.add_locations(static_cast<osmium::Way&>(*i), buffers);
+                            }
+                        }
+                    }));
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Read all buffers from the source, add the node locations to
+         * all ways, and hand the buffers in the original order to the
+         * writer. This does the same as applying the NodeLocationsForWays
+         * handler to all buffers before writing them, but only the node
+         * locations are stored in the index by the calling thread. The
+         * locations are added to the ways in parallel on the thread pool
+         * reading from the index concurrently. If the writer is an
+         * osmium::io::Writer, it encodes the buffers on its own pool.
+         *
+         * This is the usual pipeline to create files with locations on
+         * ways:
+         * @code
+         * osmium::io::Reader reader{input_file};
+         * osmium::io::Writer writer{osmium::io::File{"out.osm.pbf", "pbf,locations_on_ways=true"}, reader.header()};
+         * index_type index;
+         * osmium::handler::NodeLocationsForWays<index_type> handler{index};
+         * osmium::io::add_locations_to_ways(reader, writer, handler);
+         * writer.close();
+         * reader.close();
+         * @endcode
+         *
+         * The input should be sorted with all nodes before the ways as
+         * usual. If there are nodes after ways, this will wait for all
+         * ways read so far to get their locations before storing those
+         * nodes, because the index must not change while it is read.
+         *
+         * @param source Object with a read() function returning buffers,
+         *               usually an osmium::io::Reader.
+         * @param writer Function object called with each buffer (as
+         *               rvalue), usually an osmium::io::Writer.
+         * @param handler The handler with the location index. Settings
+         *                like ignore_errors() are honored.
+         * @param pool The thread pool to use.
+         *
+         * @throws osmium::not_found if a location is missing and
+         *         ignore_errors() wasn't called on the handler. Any
+         *         exception from the source or writer is also propagated.
+         */
+        template <typename TSource, typename TWriter, typename TStoragePosIDs, typename TStorageNegIDs>
+        inline void add_locations_to_ways(TSource& source,
+                                          TWriter& writer,
+                                          osmium::handler::NodeLocationsForWays<TStoragePosIDs, TStorageNegIDs>& handler,
+                                          osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            const auto max_pending = static_cast<std::size_t>(pool.num_threads()) * 2;
+            osmium::detail::parallel_apply_queue queue;
+
+            while (osmium::memory::Buffer buffer = source.read()) {
+                if (detail::buffer_contains(buffer, osmium::item_type::node)) {
+                    while (!queue.empty()) {
+                        writer(std::move(*queue.pop()));
+                    }
+                    for (const auto& node : buffer.select<osmium::Node>()) {
+                        handler.node(node);
+                    }
+                }
+
+                osmium::detail::parallel_apply_buffer pending{std::make_shared<osmium::memory::Buffer>(std::move(buffer)), {}};
+                if (detail::buffer_contains(*pending.buffer, osmium::item_type::way)) {
+                    handler.prepare_for_lookups();
+                    detail::submit_add_locations(pool, pending, handler);
+                }
+                queue.push(std::move(pending));
+
+                while (queue.size() > max_pending) {
+                    writer(std::move(*queue.pop()));
+                }
+            }
+
+            while (!queue.empty()) {
+                writer(std::move(*queue.pop()));
+            }
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_ADD_LOCATIONS_TO_WAYS_HPP
@@ -43,20 +43,28 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compressor.hpp>
+#include <osmium/io/detail/parallel_decompressor.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
+#include <osmium/io/source.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/util/file.hpp>
 
 #include <bzlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <limits>
 #include <string>
 #include <system_error>
+#include <utility>
+#include <vector>
 
 #ifndef _MSC_VER
 # include <unistd.h>
@@ -402,8 +410,236 @@ namespace osmium {
 
         }; // class Bzip2BufferDecompressor
 
+        /**
+         * Decompressor reading bzip2-compressed data from a Source.
+         * Several concatenated bzip2 streams are decompressed one after
+         * the other.
+         */
+        class Bzip2SourceDecompressor final : public Decompressor {
+
+            osmium::io::Source* m_source;
+            std::string m_input;
+            bz_stream m_bzstream;
+            std::size_t m_offset = 0;
+            bool m_initialized = false;
+            bool m_in_stream = false;
+            bool m_done = false;
+
+            void end_stream() noexcept {
+                if (m_initialized) {
+                    BZ2_bzDecompressEnd(&m_bzstream);
+                    m_initialized = false;
+                }
+            }
+
+        public:
+
+            /**
+             * Read from the source. The source must outlive the
+             * decompressor.
+             */
+            explicit Bzip2SourceDecompressor(osmium::io::Source& source) :
+                m_source(&source),
+                m_input(osmium::io::Decompressor::input_buffer_size, '\0'),
+                m_bzstream() {
+            }
+
+            Bzip2SourceDecompressor(const Bzip2SourceDecompressor&) = delete;
+            Bzip2SourceDecompressor& operator=(const Bzip2SourceDecompressor&) = delete;
+
+            Bzip2SourceDecompressor(Bzip2SourceDecompressor&&) = delete;
+            Bzip2SourceDecompressor& operator=(Bzip2SourceDecompressor&&) = delete;
+
+            ~Bzip2SourceDecompressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            std::string read() override {
+                std::string output;
+                if (m_done || !m_source) {
+                    return output;
+                }
+
+                output.resize(osmium::io::Decompressor::input_buffer_size);
+                char* out = &*output.begin();
+                unsigned int avail_out = static_cast<unsigned int>(output.size());
+
+                while (avail_out > 0) {
+                    if (m_bzstream.avail_in == 0) {
+                        const std::size_t nread = m_source->read(&*m_input.begin(), m_input.size());
+                        if (nread == 0) {
+                            if (m_in_stream) {
+                                throw bzip2_error{"bzip2 error: unexpected end of input", BZ_UNEXPECTED_EOF};
+                            }
+                            m_done = true;
+                            break;
+                        }
+                        m_offset += nread;
+                        set_offset(m_offset);
+                        m_bzstream.next_in = &*m_input.begin();
+                        m_bzstream.avail_in = static_cast<unsigned int>(nread);
+                    }
+
+                    // There is no way to reset a bz_stream, so it is
+                    // set up again for every stream.
+                    if (!m_in_stream) {
+                        end_stream();
+                        const int result = BZ2_bzDecompressInit(&m_bzstream, 0, 0);
+                        if (result != BZ_OK) {
+                            throw bzip2_error{"bzip2 error: decompression init failed: ", result};
+                        }
+                        m_initialized = true;
+                        m_in_stream = true;
+                    }
+
+                    m_bzstream.next_out = out;
+                    m_bzstream.avail_out = avail_out;
+                    const int result = BZ2_bzDecompress(&m_bzstream);
+                    out = m_bzstream.next_out;
+                    avail_out = m_bzstream.avail_out;
+
+                    if (result == BZ_STREAM_END) {
+                        m_in_stream = false;
+                    } else if (result != BZ_OK) {
+                        throw bzip2_error{"bzip2 error: decompress failed: ", result};
+                    }
+                }
+
+                output.resize(static_cast<std::size_t>(out - output.data()));
+                return output;
+            }
+
+            void close() override {
+                if (m_source) {
+                    osmium::io::Source* source = m_source;
+                    m_source = nullptr;
+                    end_stream();
+                    source->close();
+                }
+            }
+
+        }; // class Bzip2SourceDecompressor
+
         namespace detail {
 
+            /**
+             * Find the start of all bzip2 streams in a file consisting of
+             * several concatenated streams (as written by parallel
+             * compressors like pbzip2). Stream starts are found by looking
+             * for the stream header followed by the magic number of the
+             * first block (or of the end of stream for empty streams),
+             * which is always byte-aligned.
+             *
+             * @returns The streams or an empty vector if the data doesn't
+             *          start with a bzip2 stream.
+             */
+            inline std::vector<compressed_segment> find_bzip2_streams(const char* data, const std::size_t size) {
+                enum : std::size_t {
+                    magic_size = 10
+                };
+
+                const auto is_stream_start = [](const char* ptr) {
+                    return ptr[0] == 'B' && ptr[1] == 'Z' && ptr[2] == 'h' &&
+                           ptr[3] >= '1' && ptr[3] <= '9' &&
+                           (std::memcmp(ptr + 4, "\x31\x41\x59\x26\x53\x59", 6) == 0 ||
+                            std::memcmp(ptr + 4, "\x17\x72\x45\x38\x50\x90", 6) == 0);
+                };
+
+                std::vector<compressed_segment> streams;
+                if (size < magic_size || !is_stream_start(data)) {
+                    return streams;
+                }
+
+                std::size_t start = 0;
+                const char* const end = data + size - magic_size + 1;
+                for (const char* ptr = data + 1; ptr < end; ++ptr) {
+                    ptr = std::find(ptr, end, 'B');
+                    if (ptr == end) {
+                        break;
+                    }
+                    if (is_stream_start(ptr)) {
+                        const auto offset = static_cast<std::size_t>(ptr - data);
+                        streams.push_back(compressed_segment{start, offset - start});
+                        start = offset;
+                    }
+                }
+                streams.push_back(compressed_segment{start, size - start});
+
+                return streams;
+            }
+
+            /**
+             * Decompress a single complete bzip2 stream.
+             *
+             * @throws osmium::bzip2_error If the data could not be
+             *         decompressed.
+             */
+            inline std::string bzip2_decompress_stream(const char* data, const std::size_t size) {
+                assert(size < std::numeric_limits<unsigned int>::max());
+
+                bz_stream bzstream{};
+                bzstream.next_in = const_cast<char*>(data);
+                bzstream.avail_in = static_cast<unsigned int>(size);
+                int result = BZ2_bzDecompressInit(&bzstream, 0, 0);
+                if (result != BZ_OK) {
+                    throw bzip2_error{"bzip2 error: decompression init failed: ", result};
+                }
+
+                std::string output;
+                do {
+                    const std::size_t done = output.size();
+                    output.resize(done + std::max(size * 4, std::size_t(64 * 1024)));
+                    bzstream.next_out = &*output.begin() + done;
+                    bzstream.avail_out = static_cast<unsigned int>(output.size() - done);
+                    result = BZ2_bzDecompress(&bzstream);
+                    output.resize(static_cast<std::size_t>(bzstream.next_out - output.data()));
+                } while (result == BZ_OK && (bzstream.avail_in > 0 || bzstream.avail_out == 0));
+
+                BZ2_bzDecompressEnd(&bzstream);
+
+                if (result == BZ_OK) {
+                    throw bzip2_error{"bzip2 error: truncated stream", result};
+                }
+                if (result != BZ_STREAM_END) {
+                    throw bzip2_error{"bzip2 error: decompress failed: ", result};
+                }
+
+                return output;
+            }
+
+            enum : std::size_t {
+                // One block of the bzip2 block size used by the
+                // Bzip2Compressor (600k) per stream.
+                bzip2_parallel_block_size = 600U * 1000U
+            };
+
+            /**
+             * Compress a block of data into a single complete bzip2 stream.
+             *
+             * @throws osmium::bzip2_error If the data could not be
+             *         compressed.
+             */
+            inline std::string bzip2_compress_stream(const char* data, const std::size_t size) {
+                assert(size < std::numeric_limits<unsigned int>::max() / 2);
+
+                // Worst case size documented in the bzip2 manual.
+                unsigned int output_size = static_cast<unsigned int>(size + size / 100 + 600);
+                std::string output(output_size, '\0');
+                const int result = ::BZ2_bzBuffToBuffCompress(&*output.begin(), &output_size,
+                                                               const_cast<char*>(data), static_cast<unsigned int>(size),
+                                                               6, 0, 0);
+                if (result != BZ_OK) {
+                    throw bzip2_error{"bzip2 error: compress failed: ", result};
+                }
+                output.resize(output_size);
+
+                return output;
+            }
+
             // we want the register_compression() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_bzip2_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::bzip2,
@@ -412,9 +648,29 @@ namespace osmium {
                 [](const char* buffer, const std::size_t size) { return new osmium::io::Bzip2BufferDecompressor{buffer, size}; }
             );
 
+            const bool registered_bzip2_parallel_decompression = osmium::io::CompressionFactory::instance().register_parallel_decompression(osmium::io::file_compression::bzip2,
+                [](const char* buffer, const std::size_t size, osmium::thread::Pool& pool) -> osmium::io::Decompressor* {
+                    auto streams = find_bzip2_streams(buffer, size);
+                    if (streams.size() < 2) {
+                        return nullptr;
+                    }
+                    return new ParallelDecompressor{buffer, std::move(streams), bzip2_decompress_stream, pool};
+                }
+            );
+
+            const bool registered_bzip2_parallel_compression = osmium::io::CompressionFactory::instance().register_parallel_compression(osmium::io::file_compression::bzip2,
+                [](const int fd, const fsync sync, osmium::thread::Pool& pool) {
+                    return new ParallelCompressor{fd, sync, bzip2_compress_stream, pool, bzip2_parallel_block_size};
+                }
+            );
+
+            const bool registered_bzip2_source_decompression = osmium::io::CompressionFactory::instance().register_source_decompression(osmium::io::file_compression::bzip2,
+                [](osmium::io::Source& source) { return new osmium::io::Bzip2SourceDecompressor{source}; }
+            );
+
             // dummy function to silence the unused variable warning from above
             inline bool get_registered_bzip2_compression() noexcept {
-                return registered_bzip2_compression;
+                return registered_bzip2_compression && registered_bzip2_parallel_decompression && registered_bzip2_parallel_compression && registered_bzip2_source_decompression;
             }
 
         } // namespace detail
@@ -0,0 +1,216 @@
+#ifndef OSMIUM_IO_CHANGE_MERGER_HPP
+#define OSMIUM_IO_CHANGE_MERGER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/object_pointer_collection.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/util/misc.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /// Compare OSM objects by type and id only, in the usual order.
+            inline bool object_less_type_id(const osmium::OSMObject& lhs, const osmium::OSMObject& rhs) noexcept {
+                return const_tie(lhs.type(), lhs.id() > 0, lhs.positive_id()) <
+                       const_tie(rhs.type(), rhs.id() > 0, rhs.positive_id());
+            }
+
+        } // namespace detail
+
+        /**
+         * Merges changes (typically from .osc files) into a sorted stream
+         * of OSM data (typically a planet or extract file) without first
+         * reading all the data into memory.
+         *
+         * The changes are kept in memory. They are sorted and only the
+         * newest version of each object is kept. The data stream is then
+         * merge-joined with the changes: Objects without changes are
+         * passed through, changed objects are replaced by the new version,
+         * and deleted objects are dropped. If the data contains a newer
+         * version of an object than the changes, the data wins.
+         *
+         * The data must be sorted by type and id and must not contain
+         * several versions of the same object (ie. no history data).
+         *
+         * Usage:
+         * @code
+         * osmium::io::ChangeMerger merger;
+         * osmium::io::Reader change_reader{"changes.osc"};
+         * merger.add_changes(change_reader);
+         * change_reader.close();
+         *
+         * osmium::io::Reader reader{"planet.osm.pbf"};
+         * osmium::io::Writer writer{"new-planet.osm.pbf"};
+         * merger.merge(reader, writer);
+         * writer.close();
+         * reader.close();
+         * @endcode
+         *
+         * If a Reader and Writer are used, decoding the input and encoding
+         * the output happens in their own threads in parallel to the
+         * merge.
+         */
+        class ChangeMerger {
+
+            std::vector<osmium::memory::Buffer> m_buffers;
+            osmium::ObjectPointerCollection m_changes;
+            bool m_sorted = true;
+
+            void prepare() {
+                if (!m_sorted) {
+                    m_changes.sort(osmium::object_order_type_id_reverse_version{});
+                    m_changes.unique(osmium::object_equal_type_id{});
+                    m_sorted = true;
+                }
+            }
+
+            template <typename TOutput>
+            static void write(TOutput& output, const osmium::OSMObject& object) {
+                if (object.visible()) {
+                    output(object);
+                }
+            }
+
+        public:
+
+            ChangeMerger() = default;
+
+            /**
+             * Add changes from a buffer. The merger takes ownership of the
+             * buffer.
+             */
+            void add_changes(osmium::memory::Buffer&& buffer) {
+                if (!buffer) {
+                    return;
+                }
+                osmium::apply(buffer, m_changes);
+                m_buffers.push_back(std::move(buffer));
+                m_sorted = false;
+            }
+
+            /**
+             * Add all changes from a source, usually an osmium::io::Reader.
+             * The source must have a read() function returning buffers and
+             * an invalid buffer when there is no more data.
+             */
+            template <typename TSource>
+            void add_changes(TSource& source) {
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    add_changes(std::move(buffer));
+                }
+            }
+
+            /**
+             * The number of changed objects. After merge() (or sort())
+             * this is the number of objects with different type and id.
+             */
+            std::size_t size() const noexcept {
+                return m_changes.size();
+            }
+
+            /**
+             * Sort the changes and remove all but the newest version of each
+             * object. This is done automatically by merge(), but can be
+             * called earlier, for instance to get the number of distinct
+             * objects from size().
+             */
+            void sort() {
+                prepare();
+            }
+
+            /**
+             * Merge the data from the source with the changes and send all
+             * resulting objects to the output.
+             *
+             * @param source Source of the data, usually an
+             *               osmium::io::Reader. It must have a read()
+             *               function returning buffers and an invalid
+             *               buffer when there is no more data.
+             * @param output Called with each resulting object as a
+             *               const OSMObject&, for instance an
+             *               osmium::io::Writer.
+             */
+            template <typename TSource, typename TOutput>
+            void merge(TSource& source, TOutput&& output) {
+                prepare();
+
+                auto change = m_changes.cbegin();
+                const auto end = m_changes.cend();
+
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        while (change != end && detail::object_less_type_id(*change, object)) {
+                            write(output, *change);
+                            ++change;
+                        }
+                        if (change != end && !detail::object_less_type_id(object, *change)) {
+                            write(output, change->version() < object.version() ? object : *change);
+                            ++change;
+                        } else {
+                            output(object);
+                        }
+                    }
+                }
+
+                for (; change != end; ++change) {
+                    write(output, *change);
+                }
+            }
+
+            /**
+             * Remove all changes and free the memory used.
+             */
+            void clear() {
+                m_changes.clear();
+                m_buffers.clear();
+                m_sorted = true;
+            }
+
+        }; // class ChangeMerger
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_CHANGE_MERGER_HPP
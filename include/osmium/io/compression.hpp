@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
+#include <osmium/io/source.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/util/file.hpp>
 
@@ -49,9 +50,18 @@ DEALINGS IN THE SOFTWARE.
 #include <system_error>
 #include <tuple>
 #include <utility>
+#include <vector>
+
+#ifdef __linux__
+# include <fcntl.h>
+#endif
 
 namespace osmium {
 
+    namespace thread {
+        class Pool;
+    } // namespace thread
+
     namespace io {
 
         class Compressor {
@@ -80,6 +90,29 @@ namespace osmium {
 
             virtual void write(const std::string& data) = 0;
 
+            /**
+             * Write several blocks of data in this order. The default
+             * implementation calls write() for each block, compressors
+             * that can do better (for instance with a single system call)
+             * override this.
+             */
+            virtual void write_blocks(const std::vector<std::string>& blocks) {
+                for (const auto& block : blocks) {
+                    write(block);
+                }
+            }
+
+            /**
+             * Ask the compressor to start writeback to disk after every
+             * size bytes written and to drop the data written earlier from
+             * the page cache. This keeps large outputs from filling up the
+             * page cache. A size of 0 disables this. Compressors that can't
+             * do this ignore it.
+             */
+            virtual void set_write_behind(std::size_t size) {
+                (void)size;
+            }
+
             virtual void close() = 0;
 
             virtual std::size_t file_size() const {
@@ -143,8 +176,11 @@ namespace osmium {
         public:
 
             using create_compressor_type          = std::function<osmium::io::Compressor*(int, fsync)>;
+            using create_compressor_type_parallel = std::function<osmium::io::Compressor*(int, fsync, osmium::thread::Pool&)>;
             using create_decompressor_type_fd     = std::function<osmium::io::Decompressor*(int)>;
             using create_decompressor_type_buffer = std::function<osmium::io::Decompressor*(const char*, std::size_t)>;
+            using create_decompressor_type_parallel = std::function<osmium::io::Decompressor*(const char*, std::size_t, osmium::thread::Pool&)>;
+            using create_decompressor_type_source = std::function<osmium::io::Decompressor*(osmium::io::Source&)>;
 
         private:
 
@@ -154,8 +190,20 @@ namespace osmium {
 
             using compression_map_type = std::map<const osmium::io::file_compression, callbacks_type>;
 
+            using parallel_compression_map_type = std::map<const osmium::io::file_compression, create_decompressor_type_parallel>;
+
+            using parallel_compressor_map_type = std::map<const osmium::io::file_compression, create_compressor_type_parallel>;
+
+            using source_compression_map_type = std::map<const osmium::io::file_compression, create_decompressor_type_source>;
+
             compression_map_type m_callbacks;
 
+            parallel_compression_map_type m_parallel_callbacks;
+
+            parallel_compressor_map_type m_parallel_compressor_callbacks;
+
+            source_compression_map_type m_source_callbacks;
+
             CompressionFactory() = default;
 
             const callbacks_type& find_callbacks(const osmium::io::file_compression compression) const {
@@ -200,12 +248,73 @@ namespace osmium {
                 return m_callbacks.insert(cc).second;
             }
 
+            /**
+             * Register a function creating a decompressor that works on
+             * compressed data in memory using a thread pool to
+             * decompress independent parts of the data in parallel.
+             * This is optional, compressions without it are always
+             * decompressed on a single thread.
+             */
+            bool register_parallel_decompression(
+                osmium::io::file_compression compression,
+                const create_decompressor_type_parallel& create_decompressor_parallel) {
+
+                parallel_compression_map_type::value_type cc{compression, create_decompressor_parallel};
+
+                return m_parallel_callbacks.insert(cc).second;
+            }
+
+            /**
+             * Register a function creating a compressor that compresses
+             * independent blocks of the data in parallel using a thread
+             * pool. This is optional, compressions without it are always
+             * compressed on a single thread.
+             */
+            bool register_parallel_compression(
+                osmium::io::file_compression compression,
+                const create_compressor_type_parallel& create_compressor_parallel) {
+
+                parallel_compressor_map_type::value_type cc{compression, create_compressor_parallel};
+
+                return m_parallel_compressor_callbacks.insert(cc).second;
+            }
+
+            /**
+             * Register a function creating a decompressor that reads its
+             * input from a Source. This is needed for reading files with
+             * this compression from a Source given to the Reader.
+             */
+            bool register_source_decompression(
+                osmium::io::file_compression compression,
+                const create_decompressor_type_source& create_decompressor_source) {
+
+                source_compression_map_type::value_type cc{compression, create_decompressor_source};
+
+                return m_source_callbacks.insert(cc).second;
+            }
+
             template <typename... TArgs>
             std::unique_ptr<osmium::io::Compressor> create_compressor(const osmium::io::file_compression compression, TArgs&&... args) const {
                 const auto callbacks = find_callbacks(compression);
                 return std::unique_ptr<osmium::io::Compressor>(std::get<0>(callbacks)(std::forward<TArgs>(args)...));
             }
 
+            /**
+             * Create a compressor writing to fd that uses the thread pool
+             * to compress in parallel.
+             *
+             * @returns The compressor or nullptr if no parallel compressor
+             *          is registered for this compression. In that case
+             *          fd is still open.
+             */
+            std::unique_ptr<osmium::io::Compressor> create_parallel_compressor(const osmium::io::file_compression compression, const int fd, const fsync sync, osmium::thread::Pool& pool) const {
+                const auto it = m_parallel_compressor_callbacks.find(compression);
+                if (it == m_parallel_compressor_callbacks.end()) {
+                    return nullptr;
+                }
+                return std::unique_ptr<osmium::io::Compressor>(it->second(fd, sync, pool));
+            }
+
             std::unique_ptr<osmium::io::Decompressor> create_decompressor(const osmium::io::file_compression compression, const int fd) const {
                 const auto callbacks = find_callbacks(compression);
                 auto p = std::unique_ptr<osmium::io::Decompressor>(std::get<1>(callbacks)(fd));
@@ -218,13 +327,81 @@ namespace osmium {
                 return std::unique_ptr<osmium::io::Decompressor>(std::get<2>(callbacks)(buffer, size));
             }
 
+            /**
+             * Create a decompressor reading from the source. The source
+             * must outlive the decompressor.
+             *
+             * @throws unsupported_file_format_error If there is no
+             *         decompressor reading from a Source for this
+             *         compression.
+             */
+            std::unique_ptr<osmium::io::Decompressor> create_decompressor(const osmium::io::file_compression compression, osmium::io::Source& source) const {
+                const auto it = m_source_callbacks.find(compression);
+                if (it == m_source_callbacks.end()) {
+                    std::string error_message{"Reading compression '"};
+                    error_message += as_string(compression);
+                    error_message += "' from a source not supported by this binary";
+                    throw unsupported_file_format_error{error_message};
+                }
+                auto p = std::unique_ptr<osmium::io::Decompressor>(it->second(source));
+                p->set_file_size(source.size());
+                return p;
+            }
+
+            /**
+             * Create a decompressor for the data in the buffer that
+             * uses the thread pool to decompress in parallel.
+             *
+             * @returns The decompressor or nullptr if no parallel
+             *          decompressor is registered for this compression
+             *          or the data can not be split into independent
+             *          parts.
+             */
+            std::unique_ptr<osmium::io::Decompressor> create_parallel_decompressor(const osmium::io::file_compression compression, const char* buffer, const std::size_t size, osmium::thread::Pool& pool) const {
+                const auto it = m_parallel_callbacks.find(compression);
+                if (it == m_parallel_callbacks.end()) {
+                    return nullptr;
+                }
+                auto p = std::unique_ptr<osmium::io::Decompressor>(it->second(buffer, size, pool));
+                if (p) {
+                    p->set_file_size(size);
+                }
+                return p;
+            }
+
         }; // class CompressionFactory
 
         class NoCompressor final : public Compressor {
 
             std::size_t m_file_size = 0;
+            std::size_t m_write_behind = 0;
+            std::size_t m_synced = 0;
+            std::size_t m_dropped = 0;
             int m_fd;
 
+            // Start writeback of the data written since the last call
+            // if enough data has accumulated.
+            void write_behind() {
+#ifdef __linux__
+                if (m_write_behind == 0 || m_file_size - m_synced < m_write_behind) {
+                    return;
+                }
+
+                // Wait for the writeback of the previous range to finish
+                // and drop it from the page cache, then start writeback of
+                // the data written since.
+                if (m_synced > m_dropped) {
+                    if (::sync_file_range(m_fd, static_cast<off_t>(m_dropped), static_cast<off_t>(m_synced - m_dropped),
+                                          SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) == 0) { // NOLINT(hicpp-signed-bitwise)
+                        ::posix_fadvise(m_fd, static_cast<off_t>(m_dropped), static_cast<off_t>(m_synced - m_dropped), POSIX_FADV_DONTNEED);
+                    }
+                    m_dropped = m_synced;
+                }
+                ::sync_file_range(m_fd, static_cast<off_t>(m_synced), static_cast<off_t>(m_file_size - m_synced), SYNC_FILE_RANGE_WRITE);
+                m_synced = m_file_size;
+#endif
+            }
+
         public:
 
             NoCompressor(const int fd, const fsync sync) :
@@ -249,6 +426,27 @@ namespace osmium {
             void write(const std::string& data) override {
                 osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
                 m_file_size += data.size();
+                write_behind();
+            }
+
+            void write_blocks(const std::vector<std::string>& blocks) override {
+                osmium::io::detail::reliable_writev(m_fd, blocks);
+                for (const auto& block : blocks) {
+                    m_file_size += block.size();
+                }
+                write_behind();
+            }
+
+            void set_write_behind(std::size_t size) override {
+#ifdef __linux__
+                // Only useful for regular files
+                struct stat s; // NOLINT(cppcoreguidelines-pro-type-member-init)
+                if (::fstat(m_fd, &s) == 0 && S_ISREG(s.st_mode)) { // NOLINT(hicpp-signed-bitwise)
+                    m_write_behind = size;
+                }
+#else
+                (void)size;
+#endif
             }
 
             void close() override {
@@ -276,7 +474,8 @@ namespace osmium {
 
         class NoDecompressor final : public Decompressor {
 
-            int m_fd = -1;
+            std::unique_ptr<osmium::io::Source> m_owned_source;
+            osmium::io::Source* m_source = nullptr;
             const char* m_buffer = nullptr;
             std::size_t m_buffer_size = 0;
             std::size_t m_offset = 0;
@@ -284,7 +483,16 @@ namespace osmium {
         public:
 
             explicit NoDecompressor(const int fd) :
-                m_fd(fd) {
+                m_owned_source(new osmium::io::FdSource{fd}),
+                m_source(m_owned_source.get()) {
+            }
+
+            /**
+             * Read from the source. The source must outlive the
+             * decompressor.
+             */
+            explicit NoDecompressor(osmium::io::Source& source) :
+                m_source(&source) {
             }
 
             NoDecompressor(const char* buffer, const std::size_t size) :
@@ -315,10 +523,13 @@ namespace osmium {
                         m_buffer_size = 0;
                         buffer.append(m_buffer, size);
                     }
-                } else {
+                } else if (m_source) {
                     buffer.resize(osmium::io::Decompressor::input_buffer_size);
-                    const auto nread = detail::reliable_read(m_fd, &*buffer.begin(), osmium::io::Decompressor::input_buffer_size);
-                    buffer.resize(std::string::size_type(nread));
+                    const auto nread = m_source->read(&*buffer.begin(), osmium::io::Decompressor::input_buffer_size);
+                    buffer.resize(nread);
+                    if (nread > 0) {
+                        m_source->prefetch(m_offset + nread, osmium::io::Decompressor::input_buffer_size);
+                    }
                 }
 
                 m_offset += buffer.size();
@@ -328,10 +539,10 @@ namespace osmium {
             }
 
             void close() override {
-                if (m_fd >= 0) {
-                    const int fd = m_fd;
-                    m_fd = -1;
-                    osmium::io::detail::reliable_close(fd);
+                if (m_source) {
+                    osmium::io::Source* source = m_source;
+                    m_source = nullptr;
+                    source->close();
                 }
             }
 
@@ -347,9 +558,13 @@ namespace osmium {
                 [](const char* buffer, std::size_t size) { return new osmium::io::NoDecompressor{buffer, size}; }
             );
 
+            const bool registered_no_source_decompression = osmium::io::CompressionFactory::instance().register_source_decompression(osmium::io::file_compression::none,
+                [](osmium::io::Source& source) { return new osmium::io::NoDecompressor{source}; }
+            );
+
             // dummy function to silence the unused variable warning from above
             inline bool get_registered_no_compression() noexcept {
-                return registered_no_compression;
+                return registered_no_compression && registered_no_source_decompression;
             }
 
         } // namespace detail
@@ -62,6 +62,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstring>
 #include <iterator>
 #include <memory>
@@ -124,11 +125,6 @@ namespace osmium {
                     append_debug_encoded_string(*m_out, data, m_utf8_prefix, m_utf8_suffix);
                 }
 
-                template <typename... TArgs>
-                void output_formatted(const char* format, TArgs&&... args) {
-                    append_printf_formatted_string(*m_out, format, std::forward<TArgs>(args)...);
-                }
-
                 void write_color(const char* color) {
                     if (m_options.use_color) {
                         *m_out += color;
@@ -198,12 +194,9 @@ namespace osmium {
 
                 void write_counter(int width, int n) {
                     write_color(color_white);
-#pragma GCC diagnostic push
-#if !defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 7)
-#pragma GCC diagnostic ignored "-Wformat-truncation"
-#endif
-                    output_formatted("    %0*d: ", width, n++);
-#pragma GCC diagnostic pop
+                    *m_out += "    ";
+                    append_int_to_string(*m_out, n, width, '0');
+                    *m_out += ": ";
                     write_color(color_reset);
                 }
 
@@ -215,7 +208,7 @@ namespace osmium {
 
                 void write_timestamp(const osmium::Timestamp& timestamp) {
                     if (timestamp.valid()) {
-                        *m_out += timestamp.to_iso();
+                        output_timestamp(timestamp);
                         *m_out += " (";
                         output_int(timestamp.seconds_since_epoch());
                         *m_out += ')';
@@ -323,19 +316,23 @@ namespace osmium {
                     write_fieldname("crc32");
                     osmium::CRC<crc_type> crc32;
                     crc32.update(object);
-                    output_formatted("    %x\n", crc32().checksum());
+                    *m_out += "    ";
+                    append_hex_to_string(*m_out, static_cast<uint32_t>(crc32().checksum()));
+                    *m_out += '\n';
                 }
 
                 void write_crc32(const osmium::Changeset& object) {
                     write_fieldname("crc32");
                     osmium::CRC<crc_type> crc32;
                     crc32.update(object);
-                    output_formatted("      %x\n", crc32().checksum());
+                    *m_out += "      ";
+                    append_hex_to_string(*m_out, static_cast<uint32_t>(crc32().checksum()));
+                    *m_out += '\n';
                 }
 
             public:
 
-                DebugOutputBlock(osmium::memory::Buffer&& buffer, const debug_output_options& options) :
+                DebugOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const debug_output_options& options) :
                     OutputBlock(std::move(buffer)),
                     m_options(options),
                     m_utf8_prefix(options.use_color ? color_red  : ""),
@@ -397,7 +394,7 @@ namespace osmium {
                     for (const auto& node_ref : way.nodes()) {
                         write_diff();
                         write_counter(width, n++);
-                        output_formatted("%10lld", static_cast<long long>(node_ref.ref())); // NOLINT(google-runtime-int)
+                        append_int_to_string(*m_out, node_ref.ref(), 10);
                         if (node_ref.location().valid()) {
                             *m_out += " (";
                             node_ref.location().as_string(std::back_inserter(*m_out));
@@ -433,7 +430,9 @@ namespace osmium {
                         write_diff();
                         write_counter(width, n++);
                         *m_out += short_typename[item_type_to_nwr_index(member.type())];
-                        output_formatted(" %10lld ", static_cast<long long>(member.ref())); // NOLINT(google-runtime-int)
+                        *m_out += ' ';
+                        append_int_to_string(*m_out, member.ref(), 10);
+                        *m_out += ' ';
                         write_string(member.role());
                         *m_out += '\n';
                     }
@@ -492,13 +491,14 @@ namespace osmium {
 
                             write_comment_field("date");
                             write_timestamp(comment.date());
-                            output_formatted("      %*s", width, "");
+                            m_out->append(static_cast<std::size_t>(6 + width), ' ');
 
                             write_comment_field("user");
                             output_int(comment.uid());
                             *m_out += ' ';
                             write_string(comment.user());
-                            output_formatted("\n      %*s", width, "");
+                            *m_out += '\n';
+                            m_out->append(static_cast<std::size_t>(6 + width), ' ');
 
                             write_comment_field("text");
                             write_string(comment.text());
@@ -583,7 +583,12 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options}));
+                    write_shared_buffer(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)));
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    const std::size_t bytes = buffer->committed();
+                    send_to_output_queue_from_pool(DebugOutputBlock{buffer, m_options}, bytes);
                 }
 
             }; // class DebugOutputFormat
@@ -0,0 +1,235 @@
+#ifndef OSMIUM_IO_DETAIL_GEOJSONSEQ_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_GEOJSONSEQ_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/factory.hpp>
+#include <osmium/geom/geojson.hpp>
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/string_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            struct geojsonseq_output_options {
+
+                /// Which metadata of objects should be added?
+                osmium::metadata_options add_metadata;
+
+                /// Should nodes without tags be written out?
+                bool include_untagged_nodes = false;
+
+                /// Should each record start with the RS (0x1e) character?
+                bool print_record_separator = true;
+
+            }; // struct geojsonseq_output_options
+
+            /**
+             * Writes out one buffer with OSM data as GeoJSON Text Sequence
+             * (RFC 8142). Each node with a location, way with node
+             * locations, and area becomes one GeoJSON Feature on its own
+             * line with the tags as properties. Objects for which no
+             * geometry can be created are silently ignored, as are
+             * relations and changesets.
+             */
+            class GeoJSONSeqOutputBlock : public OutputBlock {
+
+                geojsonseq_output_options m_options;
+
+                osmium::geom::GeoJSONFactory<> m_factory;
+
+                void write_string(const char* str) {
+                    *m_out += '"';
+                    append_json_encoded_string(*m_out, str);
+                    *m_out += '"';
+                }
+
+                void write_property_int(const char* key, int64_t value) {
+                    *m_out += ",\"";
+                    *m_out += key;
+                    *m_out += "\":";
+                    output_int(value);
+                }
+
+                void write_feature(const osmium::OSMObject& object, const char* type, osmium::object_id_type id, const std::string& geometry) {
+                    if (m_options.print_record_separator) {
+                        *m_out += '\x1e';
+                    }
+                    *m_out += R"({"type":"Feature","geometry":)";
+                    *m_out += geometry;
+                    *m_out += R"(,"properties":{"@type":")";
+                    *m_out += type;
+                    *m_out += '"';
+                    write_property_int("@id", id);
+
+                    if (m_options.add_metadata.version()) {
+                        write_property_int("@version", object.version());
+                    }
+                    if (m_options.add_metadata.changeset()) {
+                        write_property_int("@changeset", object.changeset());
+                    }
+                    if (m_options.add_metadata.timestamp() && object.timestamp()) {
+                        *m_out += R"(,"@timestamp":")";
+                        output_timestamp(object.timestamp());
+                        *m_out += '"';
+                    }
+                    if (m_options.add_metadata.uid()) {
+                        write_property_int("@uid", object.uid());
+                    }
+                    if (m_options.add_metadata.user()) {
+                        *m_out += R"(,"@user":)";
+                        write_string(object.user());
+                    }
+
+                    for (const auto& tag : object.tags()) {
+                        *m_out += ',';
+                        write_string(tag.key());
+                        *m_out += ':';
+                        write_string(tag.value());
+                    }
+
+                    *m_out += "}}\n";
+                }
+
+            public:
+
+                GeoJSONSeqOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const geojsonseq_output_options& options) :
+                    OutputBlock(std::move(buffer)),
+                    m_options(options) {
+                }
+
+                std::string operator()() {
+                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+
+                    std::string out;
+                    using std::swap;
+                    swap(out, *m_out);
+
+                    return out;
+                }
+
+                void node(const osmium::Node& node) {
+                    if (!node.location().valid() || (node.tags().empty() && !m_options.include_untagged_nodes)) {
+                        return;
+                    }
+
+                    write_feature(node, "node", node.id(), m_factory.create_point(node.location()));
+                }
+
+                void way(const osmium::Way& way) {
+                    try {
+                        write_feature(way, "way", way.id(), m_factory.create_linestring(way));
+                    } catch (const osmium::geometry_error&) {
+                        // ignore ways without (enough) locations
+                    } catch (const osmium::invalid_location&) {
+                        // ignore ways without (enough) locations
+                    }
+                }
+
+                void area(const osmium::Area& area) {
+                    try {
+                        write_feature(area, area.from_way() ? "way" : "relation", area.orig_id(), m_factory.create_multipolygon(area));
+                    } catch (const osmium::geometry_error&) {
+                        // ignore invalid areas
+                    } catch (const osmium::invalid_location&) {
+                        // ignore invalid areas
+                    }
+                }
+
+            }; // class GeoJSONSeqOutputBlock
+
+            class GeoJSONSeqOutputFormat : public osmium::io::detail::OutputFormat {
+
+                geojsonseq_output_options m_options;
+
+            public:
+
+                GeoJSONSeqOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue) {
+                    m_options.add_metadata           = osmium::metadata_options{file.get("add_metadata", "false")};
+                    m_options.include_untagged_nodes = file.is_true("include_untagged_nodes");
+                    m_options.print_record_separator = file.is_not_false("print_record_separator");
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    write_shared_buffer(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)));
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    const std::size_t bytes = buffer->committed();
+                    send_to_output_queue_from_pool(GeoJSONSeqOutputBlock{buffer, m_options}, bytes);
+                }
+
+            }; // class GeoJSONSeqOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_geojsonseq_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::geojsonseq,
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::GeoJSONSeqOutputFormat(pool, file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_geojsonseq_output() noexcept {
+                return registered_geojsonseq_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_GEOJSONSEQ_OUTPUT_FORMAT_HPP
@@ -38,16 +38,21 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/thread/util.hpp>
 
 #include <array>
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <future>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace osmium {
@@ -63,7 +68,89 @@ namespace osmium {
                 std::promise<osmium::io::Header>& header_promise;
                 osmium::osm_entity_bits::type read_which_entities;
                 osmium::io::read_meta read_metadata;
-            };
+
+                // If this is not nullptr, the complete input is available
+                // in memory (usually because the file was memory mapped)
+                // and parsers supporting this can read it from here instead
+                // of from the input queue.
+                const char* mapped_data = nullptr;
+                std::size_t mapped_size = 0;
+
+                // The file being read. Parsers can use this to look up
+                // format-specific options. Can be nullptr.
+                const osmium::io::File* file = nullptr;
+
+                // If this is not nullptr, parsers should get the memory
+                // for their output buffers from this pool.
+                osmium::memory::BufferPool* buffer_pool = nullptr;
+
+                // If this is not nullptr, parsers supporting it should
+                // not build objects not matching this filter.
+                std::shared_ptr<const osmium::io::ReadFilter> read_filter{};
+
+                // If this is set, it is called every time data in the
+                // output queue might have become available.
+                std::function<void()> notify{};
+
+                // If this is not nullptr, tasks are submitted through this
+                // client of the pool instead of to the pool directly.
+                osmium::thread::PoolClient* pool_client = nullptr;
+
+                // If this is set, the parser runs in the thread of the
+                // Reader and all work is done right away in this thread
+                // instead of in the thread pool.
+                bool synchronous = false;
+
+                // The constructor takes only the arguments every parser
+                // needs, so that code creating parser_arguments with
+                // brace initialization keeps working. Set the other
+                // members afterwards.
+                parser_arguments(osmium::thread::Pool& new_pool,
+                                 future_string_queue_type& new_input_queue,
+                                 future_buffer_queue_type& new_output_queue,
+                                 std::promise<osmium::io::Header>& new_header_promise,
+                                 osmium::osm_entity_bits::type new_read_which_entities,
+                                 osmium::io::read_meta new_read_metadata) :
+                    pool(new_pool),
+                    input_queue(new_input_queue),
+                    output_queue(new_output_queue),
+                    header_promise(new_header_promise),
+                    read_which_entities(new_read_which_entities),
+                    read_metadata(new_read_metadata) {
+                }
+
+            }; // struct parser_arguments
+
+            /**
+             * Wraps a function returning a buffer so that it can run in the
+             * thread pool. The result is handed over through the promise
+             * and after that the notify function is called.
+             */
+            template <typename TFunction>
+            class notifying_task {
+
+                TFunction m_function;
+                std::promise<osmium::memory::Buffer> m_promise;
+                std::function<void()> m_notify;
+
+            public:
+
+                notifying_task(TFunction function, std::promise<osmium::memory::Buffer>&& promise, const std::function<void()>& notify) :
+                    m_function(std::move(function)),
+                    m_promise(std::move(promise)),
+                    m_notify(notify) {
+                }
+
+                void operator()() {
+                    try {
+                        m_promise.set_value(m_function());
+                    } catch (...) {
+                        m_promise.set_exception(std::current_exception());
+                    }
+                    m_notify();
+                }
+
+            }; // class notifying_task
 
             class Parser {
 
@@ -73,8 +160,22 @@ namespace osmium {
                 queue_wrapper<std::string> m_input_queue;
                 osmium::osm_entity_bits::type m_read_which_entities;
                 osmium::io::read_meta m_read_metadata;
+                const char* m_mapped_data;
+                std::size_t m_mapped_size;
+                const osmium::io::File* m_file;
+                osmium::memory::BufferPool* m_buffer_pool;
+                std::shared_ptr<const osmium::io::ReadFilter> m_read_filter;
+                std::function<void()> m_notify;
+                osmium::thread::PoolClient* m_pool_client;
+                bool m_synchronous;
                 bool m_header_is_done;
 
+                void notify() const {
+                    if (m_notify) {
+                        m_notify();
+                    }
+                }
+
             protected:
 
                 osmium::thread::Pool& get_pool() {
@@ -89,6 +190,65 @@ namespace osmium {
                     return m_read_metadata;
                 }
 
+                /**
+                 * Get pointer to the complete input data if it is available
+                 * in memory, nullptr otherwise. If this is available, the
+                 * input queue will not contain any data.
+                 */
+                const char* mapped_data() const noexcept {
+                    return m_mapped_data;
+                }
+
+                std::size_t mapped_size() const noexcept {
+                    return m_mapped_size;
+                }
+
+                /**
+                 * Get the value of an option set on the input file or the
+                 * empty string if it isn't set.
+                 */
+                std::string get_file_option(const std::string& key) const {
+                    if (!m_file) {
+                        return std::string{};
+                    }
+                    return m_file->get(key);
+                }
+
+                /**
+                 * Is the option on the input file set to a true value
+                 * ("true" or "yes")? Will return false if it isn't set.
+                 */
+                bool file_option_is_true(const std::string& key) const noexcept {
+                    return m_file && m_file->is_true(key);
+                }
+
+                /**
+                 * Get the pool output buffers should be taken from or
+                 * nullptr if there is none.
+                 */
+                osmium::memory::BufferPool* buffer_pool() const noexcept {
+                    return m_buffer_pool;
+                }
+
+                /**
+                 * Get the filter objects have to match or nullptr if
+                 * there is none.
+                 */
+                const std::shared_ptr<const osmium::io::ReadFilter>& read_filter() const noexcept {
+                    return m_read_filter;
+                }
+
+                /**
+                 * Set the name of the thread the parser runs in. Does
+                 * nothing if the parser runs synchronously in the thread
+                 * of the Reader.
+                 */
+                void set_thread_name(const char* name) const noexcept {
+                    if (!m_synchronous) {
+                        osmium::thread::set_thread_name(name);
+                    }
+                }
+
                 bool header_is_done() const noexcept {
                     return m_header_is_done;
                 }
@@ -112,10 +272,50 @@ namespace osmium {
                  */
                 void send_to_output_queue(osmium::memory::Buffer&& buffer) {
                     add_to_queue(m_output_queue, std::move(buffer));
+                    notify();
                 }
 
                 void send_to_output_queue(std::future<osmium::memory::Buffer>&& future) {
                     m_output_queue.push(std::move(future));
+                    notify();
+                }
+
+                template <typename TFunction>
+                std::future<typename std::result_of<TFunction()>::type> submit_to_pool(TFunction&& function) {
+                    if (m_synchronous) {
+                        std::packaged_task<typename std::result_of<TFunction()>::type()> task{std::forward<TFunction>(function)};
+                        auto future = task.get_future();
+                        task();
+                        return future;
+                    }
+                    if (m_pool_client) {
+                        return m_pool_client->submit(std::forward<TFunction>(function));
+                    }
+                    return m_pool.submit(std::forward<TFunction>(function));
+                }
+
+                /**
+                 * Run the function, which must return a buffer, in the
+                 * thread pool and add its result to the output queue.
+                 *
+                 * @param function The function.
+                 * @param bytes Size of the input data the function works
+                 *              on. This is used as an estimate for the size
+                 *              of the result in queues limited by bytes.
+                 */
+                template <typename TFunction>
+                void send_to_output_queue_from_pool(TFunction&& function, std::size_t bytes) {
+                    if (!m_notify) {
+                        m_output_queue.push(submit_to_pool(std::forward<TFunction>(function)), bytes);
+                        return;
+                    }
+
+                    // The future must be in the queue before the task can
+                    // call notify, otherwise the notification could get lost.
+                    std::promise<osmium::memory::Buffer> promise;
+                    m_output_queue.push(promise.get_future(), bytes);
+                    using task_type = notifying_task<typename std::decay<TFunction>::type>;
+                    submit_to_pool(task_type{std::forward<TFunction>(function), std::move(promise), m_notify});
                 }
 
             public:
@@ -127,6 +327,14 @@ namespace osmium {
                     m_input_queue(args.input_queue),
                     m_read_which_entities(args.read_which_entities),
                     m_read_metadata(args.read_metadata),
+                    m_mapped_data(args.mapped_data),
+                    m_mapped_size(args.mapped_size),
+                    m_file(args.file),
+                    m_buffer_pool(args.buffer_pool),
+                    m_read_filter(args.read_filter),
+                    m_notify(args.notify),
+                    m_pool_client(args.pool_client),
+                    m_synchronous(args.synchronous),
                     m_header_is_done(false) {
                 }
 
@@ -158,6 +366,7 @@ namespace osmium {
                     }
 
                     add_end_of_data_to_queue(m_output_queue);
+                    notify();
                 }
 
             }; // class Parser
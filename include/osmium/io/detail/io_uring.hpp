@@ -0,0 +1,666 @@
+#ifndef OSMIUM_IO_DETAIL_IO_URING_HPP
+#define OSMIUM_IO_DETAIL_IO_URING_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/writer_options.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+# include <sys/syscall.h>
+# if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#  define OSMIUM_IO_URING_AVAILABLE
+# endif
+#endif
+
+#ifdef OSMIUM_IO_URING_AVAILABLE
+# include <linux/io_uring.h>
+
+# include <cerrno>
+# include <cstdint>
+# include <cstring>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/uio.h>
+# include <system_error>
+# include <unistd.h>
+# include <vector>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            enum {
+                // Default number of reads or writes kept in flight
+                io_uring_default_queue_depth = 8
+            };
+
+            /**
+             * Get the number of requests kept in flight from the
+             * "io_uring_queue_depth" option of the file.
+             */
+            inline unsigned int io_uring_queue_depth(const osmium::io::File& file) {
+                const std::string value = file.get("io_uring_queue_depth");
+                if (value.empty()) {
+                    return io_uring_default_queue_depth;
+                }
+                const auto depth = std::atoi(value.c_str());
+                if (depth < 1 || depth > 256) {
+                    throw std::invalid_argument{"io_uring_queue_depth must be between 1 and 256"};
+                }
+                return static_cast<unsigned int>(depth);
+            }
+
+#ifdef OSMIUM_IO_URING_AVAILABLE
+
+            /**
+             * Minimal wrapper around a Linux io_uring using the raw system
+             * calls, so no liburing is needed. It is only used from a single
+             * thread.
+             */
+            class IoUring {
+
+                int m_fd = -1;
+
+                void* m_sq_ring = MAP_FAILED;
+                std::size_t m_sq_ring_size = 0;
+                void* m_cq_ring = MAP_FAILED;
+                std::size_t m_cq_ring_size = 0;
+                io_uring_sqe* m_sqes = nullptr;
+                std::size_t m_sqes_size = 0;
+
+                unsigned* m_sq_tail = nullptr;
+                unsigned* m_sq_mask = nullptr;
+                unsigned* m_sq_array = nullptr;
+                unsigned* m_cq_head = nullptr;
+                unsigned* m_cq_tail = nullptr;
+                unsigned* m_cq_mask = nullptr;
+                io_uring_cqe* m_cqes = nullptr;
+
+                unsigned int m_pending = 0;
+
+                template <typename T>
+                static T* at(void* base, uint32_t offset) noexcept {
+                    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+                }
+
+                static void* map(std::size_t size, int fd, off_t offset) {
+                    return ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset); // NOLINT(hicpp-signed-bitwise)
+                }
+
+                void cleanup() noexcept {
+                    if (m_sqes) {
+                        ::munmap(m_sqes, m_sqes_size);
+                    }
+                    if (m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring) {
+                        ::munmap(m_cq_ring, m_cq_ring_size);
+                    }
+                    if (m_sq_ring != MAP_FAILED) {
+                        ::munmap(m_sq_ring, m_sq_ring_size);
+                    }
+                    if (m_fd >= 0) {
+                        ::close(m_fd);
+                    }
+                }
+
+                int enter(unsigned int to_submit, unsigned int min_complete, unsigned int flags) noexcept {
+                    return static_cast<int>(::syscall(__NR_io_uring_enter, m_fd, to_submit, min_complete, flags, nullptr, 0));
+                }
+
+            public:
+
+                /**
+                 * Set up a ring with the given number of entries.
+                 *
+                 * @throws std::system_error if the kernel does not support
+                 *         io_uring or the setup failed.
+                 */
+                explicit IoUring(unsigned int entries) {
+                    io_uring_params params; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                    std::memset(&params, 0, sizeof(params));
+
+                    m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+                    if (m_fd < 0) {
+                        throw std::system_error{errno, std::system_category(), "io_uring_setup failed"};
+                    }
+
+                    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                    m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                    if (single_mmap) {
+                        m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+                    }
+
+                    m_sq_ring = map(m_sq_ring_size, m_fd, IORING_OFF_SQ_RING);
+                    if (m_sq_ring == MAP_FAILED) {
+                        const int error = errno;
+                        cleanup();
+                        throw std::system_error{error, std::system_category(), "mapping io_uring failed"};
+                    }
+                    m_cq_ring = single_mmap ? m_sq_ring : map(m_cq_ring_size, m_fd, IORING_OFF_CQ_RING);
+                    if (m_cq_ring == MAP_FAILED) {
+                        const int error = errno;
+                        cleanup();
+                        throw std::system_error{error, std::system_category(), "mapping io_uring failed"};
+                    }
+                    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+                    void* sqes = map(m_sqes_size, m_fd, IORING_OFF_SQES);
+                    if (sqes == MAP_FAILED) {
+                        const int error = errno;
+                        cleanup();
+                        throw std::system_error{error, std::system_category(), "mapping io_uring failed"};
+                    }
+                    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+                    m_sq_tail  = at<unsigned>(m_sq_ring, params.sq_off.tail);
+                    m_sq_mask  = at<unsigned>(m_sq_ring, params.sq_off.ring_mask);
+                    m_sq_array = at<unsigned>(m_sq_ring, params.sq_off.array);
+                    m_cq_head  = at<unsigned>(m_cq_ring, params.cq_off.head);
+                    m_cq_tail  = at<unsigned>(m_cq_ring, params.cq_off.tail);
+                    m_cq_mask  = at<unsigned>(m_cq_ring, params.cq_off.ring_mask);
+                    m_cqes     = at<io_uring_cqe>(m_cq_ring, params.cq_off.cqes);
+                }
+
+                IoUring(const IoUring&) = delete;
+                IoUring& operator=(const IoUring&) = delete;
+
+                IoUring(IoUring&&) = delete;
+                IoUring& operator=(IoUring&&) = delete;
+
+                ~IoUring() noexcept {
+                    cleanup();
+                }
+
+                /// The number of requests submitted but not completed yet.
+                unsigned int pending() const noexcept {
+                    return m_pending;
+                }
+
+                /**
+                 * Submit a readv or writev request for a single iovec. The
+                 * iovec must stay valid until the request has completed.
+                 */
+                void submit(uint8_t opcode, int fd, const iovec* iov, uint64_t offset, uint64_t user_data) {
+                    const unsigned tail = *m_sq_tail;
+                    const unsigned index = tail & *m_sq_mask;
+
+                    io_uring_sqe& sqe = m_sqes[index];
+                    std::memset(&sqe, 0, sizeof(sqe));
+                    sqe.opcode = opcode;
+                    sqe.fd = fd;
+                    sqe.addr = reinterpret_cast<uint64_t>(iov);
+                    sqe.len = 1;
+                    sqe.off = offset;
+                    sqe.user_data = user_data;
+
+                    m_sq_array[index] = index;
+                    __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+                    while (enter(1, 0, 0) < 0) {
+                        if (errno != EINTR && errno != EAGAIN) {
+                            throw std::system_error{errno, std::system_category(), "io_uring_enter failed"};
+                        }
+                    }
+                    ++m_pending;
+                }
+
+                /**
+                 * Wait for the next completion.
+                 *
+                 * @param user_data Set to the user data of the request.
+                 * @returns The result of the request (bytes transferred or
+                 *          negative errno).
+                 */
+                int wait(uint64_t* user_data) {
+                    while (true) {
+                        const unsigned head = *m_cq_head;
+                        if (head != __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) {
+                            const io_uring_cqe& cqe = m_cqes[head & *m_cq_mask];
+                            *user_data = cqe.user_data;
+                            const int result = cqe.res;
+                            __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+                            --m_pending;
+                            return result;
+                        }
+                        if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                            throw std::system_error{errno, std::system_category(), "io_uring_enter failed"};
+                        }
+                    }
+                }
+
+            }; // class IoUring
+
+            struct aligned_free {
+
+                void operator()(char* ptr) const noexcept {
+                    std::free(ptr); // NOLINT(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+                }
+
+            }; // struct aligned_free
+
+            enum : std::size_t {
+                // Alignment of buffers, offsets and sizes needed for O_DIRECT
+                io_uring_alignment = 4096
+            };
+
+            inline std::unique_ptr<char, aligned_free> allocate_aligned(std::size_t size) {
+                void* ptr = nullptr;
+                const int error = ::posix_memalign(&ptr, io_uring_alignment, size);
+                if (error != 0) {
+                    throw std::system_error{error, std::system_category(), "posix_memalign failed"};
+                }
+                return std::unique_ptr<char, aligned_free>{static_cast<char*>(ptr)};
+            }
+
+        } // namespace detail
+
+        /**
+         * Decompressor for uncompressed files which reads the file through
+         * an io_uring. Several aligned blocks are read ahead and kept in
+         * flight so the device sees a deeper queue than with synchronous
+         * reads. Optionally the file is opened with O_DIRECT bypassing
+         * the page cache.
+         *
+         * Only works with regular files. Use
+         * detail::create_uring_decompressor() which checks this.
+         */
+        class UringDecompressor final : public Decompressor {
+
+            struct request {
+                std::unique_ptr<char, detail::aligned_free> buffer;
+                iovec iov{};
+                std::size_t offset = 0; // offset of this block in the file
+                std::size_t size = 0; // bytes expected for this block
+                std::size_t done = 0; // bytes already read
+                bool complete = false;
+            };
+
+            osmium::io::detail::IoUring m_ring;
+            std::vector<request> m_requests;
+            int m_fd;
+            bool m_direct;
+            std::size_t m_size;
+            std::size_t m_submit_offset = 0;
+            std::size_t m_offset = 0;
+            std::size_t m_next = 0;
+
+            void submit_read(std::size_t index) {
+                auto& req = m_requests[index];
+                req.iov.iov_base = req.buffer.get() + req.done;
+                req.iov.iov_len = input_buffer_size - req.done;
+                m_ring.submit(IORING_OP_READV, m_fd, &req.iov, req.offset + req.done, index);
+            }
+
+            void submit_next(std::size_t index) {
+                auto& req = m_requests[index];
+                req.size = std::min(std::size_t(input_buffer_size), m_size - m_submit_offset);
+                req.offset = m_submit_offset;
+                req.done = 0;
+                req.complete = false;
+                submit_read(index);
+                m_submit_offset += req.size;
+            }
+
+            void wait_for(std::size_t index) {
+                while (!m_requests[index].complete) {
+                    uint64_t done_index = 0;
+                    const int result = m_ring.wait(&done_index);
+                    auto& req = m_requests[done_index];
+                    if (result < 0) {
+                        throw std::system_error{-result, std::system_category(), "Read failed"};
+                    }
+                    req.done += static_cast<std::size_t>(result);
+                    if (result == 0 || req.done >= req.size) {
+                        // A zero read means the file was truncated while
+                        // reading, return what we have.
+                        req.size = std::min(req.size, req.done);
+                        req.complete = true;
+                    } else {
+                        // Short read, read the rest of the block.
+                        submit_read(done_index);
+                    }
+                }
+            }
+
+        public:
+
+            UringDecompressor(int fd, bool direct, std::size_t size, unsigned int queue_depth) :
+                m_ring(queue_depth),
+                m_requests(queue_depth),
+                m_fd(fd),
+                m_direct(direct),
+                m_size(size) {
+                set_file_size(size);
+                for (auto& req : m_requests) {
+                    req.buffer = detail::allocate_aligned(input_buffer_size);
+                }
+                for (std::size_t i = 0; i < m_requests.size() && m_submit_offset < m_size; ++i) {
+                    submit_next(i);
+                }
+            }
+
+            UringDecompressor(const UringDecompressor&) = delete;
+            UringDecompressor& operator=(const UringDecompressor&) = delete;
+
+            UringDecompressor(UringDecompressor&&) = delete;
+            UringDecompressor& operator=(UringDecompressor&&) = delete;
+
+            ~UringDecompressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /// Is the file opened with O_DIRECT?
+            bool direct() const noexcept {
+                return m_direct;
+            }
+
+            std::string read() override {
+                std::string buffer;
+
+                if (m_fd < 0 || m_offset >= m_size) {
+                    return buffer;
+                }
+
+                wait_for(m_next);
+                auto& req = m_requests[m_next];
+                buffer.assign(req.buffer.get(), req.size);
+
+                if (req.size == 0) {
+                    // file was truncated
+                    m_size = m_offset;
+                    return buffer;
+                }
+
+                m_offset += req.size;
+                set_offset(m_offset);
+
+                if (m_submit_offset < m_size) {
+                    submit_next(m_next);
+                }
+                m_next = (m_next + 1) % m_requests.size();
+
+                return buffer;
+            }
+
+            void close() override {
+                if (m_fd >= 0) {
+                    // The kernel might still write into our buffers.
+                    while (m_ring.pending() > 0) {
+                        uint64_t index = 0;
+                        m_ring.wait(&index);
+                    }
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class UringDecompressor
+
+        /**
+         * Compressor for uncompressed files which writes the data through
+         * an io_uring. Up to the queue depth writes are kept in flight,
+         * each one holding its own copy of the data.
+         *
+         * Only works with regular files. Use
+         * detail::create_uring_compressor() which checks this.
+         */
+        class UringCompressor final : public Compressor {
+
+            struct request {
+                std::string data;
+                iovec iov{};
+                uint64_t offset = 0;
+            };
+
+            osmium::io::detail::IoUring m_ring;
+            std::vector<request> m_requests;
+            std::vector<std::size_t> m_free;
+            std::size_t m_file_size = 0;
+            int m_fd;
+
+            void submit_write(std::size_t index) {
+                auto& req = m_requests[index];
+                req.iov.iov_base = &req.data[0];
+                req.iov.iov_len = req.data.size();
+                m_ring.submit(IORING_OP_WRITEV, m_fd, &req.iov, req.offset, index);
+            }
+
+            void wait_one() {
+                uint64_t index = 0;
+                const int result = m_ring.wait(&index);
+                if (result < 0) {
+                    throw std::system_error{-result, std::system_category(), "Write failed"};
+                }
+                auto& req = m_requests[index];
+                if (static_cast<std::size_t>(result) < req.data.size()) {
+                    // Short write, write the rest.
+                    req.data.erase(0, static_cast<std::size_t>(result));
+                    req.offset += static_cast<uint64_t>(result);
+                    submit_write(index);
+                    return;
+                }
+                req.data.clear();
+                m_free.push_back(index);
+            }
+
+        public:
+
+            UringCompressor(int fd, fsync sync, unsigned int queue_depth) :
+                Compressor(sync),
+                m_ring(queue_depth),
+                m_requests(queue_depth),
+                m_fd(fd) {
+                for (std::size_t i = queue_depth; i > 0; --i) {
+                    m_free.push_back(i - 1);
+                }
+            }
+
+            UringCompressor(const UringCompressor&) = delete;
+            UringCompressor& operator=(const UringCompressor&) = delete;
+
+            UringCompressor(UringCompressor&&) = delete;
+            UringCompressor& operator=(UringCompressor&&) = delete;
+
+            ~UringCompressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            void write(const std::string& data) override {
+                if (data.empty()) {
+                    return;
+                }
+                while (m_free.empty()) {
+                    wait_one();
+                }
+                const std::size_t index = m_free.back();
+                m_free.pop_back();
+
+                auto& req = m_requests[index];
+                req.data = data;
+                req.offset = m_file_size;
+                m_file_size += data.size();
+                submit_write(index);
+            }
+
+            void close() override {
+                if (m_fd >= 0) {
+                    const int fd = m_fd;
+                    try {
+                        while (m_ring.pending() > 0) {
+                            wait_one();
+                        }
+                    } catch (...) {
+                        m_fd = -1;
+                        ::close(fd);
+                        throw;
+                    }
+                    m_fd = -1;
+                    if (do_fsync()) {
+                        osmium::io::detail::reliable_fsync(fd);
+                    }
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+            std::size_t file_size() const override {
+                return m_file_size;
+            }
+
+        }; // class UringCompressor
+
+        namespace detail {
+
+#endif // OSMIUM_IO_URING_AVAILABLE
+
+            /**
+             * Create a decompressor reading through an io_uring if the
+             * "io_uring" option is set on the file, the file is an
+             * uncompressed regular file, and io_uring is available. If the
+             * "direct_io" option is also set, the file is opened with
+             * O_DIRECT if the file system supports it.
+             *
+             * @returns The decompressor or nullptr if the normal way of
+             *          reading should be used.
+             * @throws std::system_error if the file can not be opened.
+             */
+            inline std::unique_ptr<osmium::io::Decompressor> create_uring_decompressor(const osmium::io::File& file) {
+#ifdef OSMIUM_IO_URING_AVAILABLE
+                if (!file.is_true("io_uring") ||
+                    file.compression() != file_compression::none ||
+                    file.buffer() ||
+                    file.filename().empty() ||
+                    file.filename() == "-" ||
+                    file.filename().find("://") != std::string::npos) {
+                    return nullptr;
+                }
+
+                const unsigned int queue_depth = io_uring_queue_depth(file);
+
+                bool direct = file.is_true("direct_io");
+                int fd = -1;
+                if (direct) {
+                    fd = ::open(file.filename().c_str(), O_RDONLY | O_DIRECT); // NOLINT(hicpp-signed-bitwise)
+                    if (fd < 0) {
+                        direct = false;
+                    }
+                }
+                if (fd < 0) {
+                    fd = osmium::io::detail::open_for_reading(file.filename());
+                }
+
+                struct stat s; // NOLINT(cppcoreguidelines-pro-type-member-init)
+                if (::fstat(fd, &s) != 0 || !S_ISREG(s.st_mode)) { // NOLINT(hicpp-signed-bitwise)
+                    osmium::io::detail::reliable_close(fd);
+                    return nullptr;
+                }
+
+                try {
+                    return std::unique_ptr<osmium::io::Decompressor>{new osmium::io::UringDecompressor{fd, direct, static_cast<std::size_t>(s.st_size), queue_depth}};
+                } catch (const std::system_error&) {
+                    // io_uring not supported by the kernel or not allowed
+                    osmium::io::detail::reliable_close(fd);
+                    return nullptr;
+                }
+#else
+                (void)file;
+                return nullptr;
+#endif
+            }
+
+            /**
+             * Create a compressor writing through an io_uring if the
+             * "io_uring" option is set on the file, the file is
+             * uncompressed, fd is a regular file, and io_uring is
+             * available.
+             *
+             * @returns The compressor or nullptr if the normal way of
+             *          writing should be used. In that case fd is still
+             *          open.
+             */
+            inline std::unique_ptr<osmium::io::Compressor> create_uring_compressor(const osmium::io::File& file, int fd, osmium::io::fsync sync) {
+#ifdef OSMIUM_IO_URING_AVAILABLE
+                if (!file.is_true("io_uring") || file.compression() != file_compression::none) {
+                    return nullptr;
+                }
+
+                const unsigned int queue_depth = io_uring_queue_depth(file);
+
+                struct stat s; // NOLINT(cppcoreguidelines-pro-type-member-init)
+                if (::fstat(fd, &s) != 0 || !S_ISREG(s.st_mode)) { // NOLINT(hicpp-signed-bitwise)
+                    return nullptr;
+                }
+
+                try {
+                    return std::unique_ptr<osmium::io::Compressor>{new osmium::io::UringCompressor{fd, sync, queue_depth}};
+                } catch (const std::system_error&) {
+                    // io_uring not supported by the kernel or not allowed
+                    return nullptr;
+                }
+#else
+                (void)file;
+                (void)fd;
+                (void)sync;
+                return nullptr;
+#endif
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_IO_URING_HPP
@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #ifdef OSMIUM_WITH_LZ4
 
 #include <cassert>
+#include <cstddef>
 #include <limits>
 #include <stdexcept>
 #include <string>
@@ -75,19 +76,20 @@ namespace osmium {
              * LZ4_MAX_INPUT_SIZE.
              *
              * @param input Data to compress.
+             * @param input_size Size of data to compress.
              * @param compression_level Compression level.
              * @returns Compressed data.
              */
-            inline std::string lz4_compress(const std::string& input, int compression_level = lz4_default_compression_level()) { // NOLINT(google-runtime-int)
-                assert(input.size() < LZ4_MAX_INPUT_SIZE);
-                const int output_size = ::LZ4_compressBound(static_cast<int>(input.size())); // NOLINT(google-runtime-int)
+            inline std::string lz4_compress(const char* input, std::size_t input_size, int compression_level = lz4_default_compression_level()) { // NOLINT(google-runtime-int)
+                assert(input_size < LZ4_MAX_INPUT_SIZE);
+                const int output_size = ::LZ4_compressBound(static_cast<int>(input_size)); // NOLINT(google-runtime-int)
 
                 std::string output(static_cast<std::size_t>(output_size), '\0');
 
                 const int result = ::LZ4_compress_fast( // NOLINT(google-runtime-int)
-                    input.data(),
+                    input,
                     &*output.begin(),
-                    static_cast<int>(input.size()),
+                    static_cast<int>(input_size),
                     output_size,
                     compression_level
                 );
@@ -102,22 +104,38 @@ namespace osmium {
             }
 
             /**
-             * Uncompress data using lz4.
+             * Compress data using lz4.
+             *
+             * Note that this function can not compress data larger than
+             * LZ4_MAX_INPUT_SIZE.
+             *
+             * @param input Data to compress.
+             * @param compression_level Compression level.
+             * @returns Compressed data.
+             */
+            inline std::string lz4_compress(const std::string& input, int compression_level = lz4_default_compression_level()) { // NOLINT(google-runtime-int)
+                return lz4_compress(input.data(), input.size(), compression_level);
+            }
+
+            /**
+             * Uncompress data using lz4 into output, which must have space
+             * for raw_size bytes. The memory doesn't have to be
+             * initialized.
              *
              * Note that this function can not uncompress data larger than
              * LZ4_MAX_INPUT_SIZE.
              *
              * @param input Compressed input data.
+             * @param input_size Size of compressed input data.
              * @param raw_size Size of uncompressed data.
-             * @param output Uncompressed result data.
-             * @returns Pointer and size to incompressed data.
+             * @param output Memory for uncompressed result data.
+             * @returns Size of uncompressed data (always raw_size).
+             * @throws io_error If the data could not be uncompressed.
              */
-            inline protozero::data_view lz4_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
-                output.resize(raw_size);
-
+            inline std::size_t lz4_uncompress(const char* input, unsigned long input_size, unsigned long raw_size, char* output) { // NOLINT(google-runtime-int)
                 const int result = ::LZ4_decompress_safe( // NOLINT(google-runtime-int)
                     input,
-                    &*output.begin(),
+                    output,
                     static_cast<int>(input_size),
                     static_cast<int>(raw_size)
                 );
@@ -130,6 +148,24 @@ namespace osmium {
                     throw io_error{"LZ4 decompression failed: data size does not match"};
                 }
 
+                return raw_size;
+            }
+
+            /**
+             * Uncompress data using lz4.
+             *
+             * Note that this function can not uncompress data larger than
+             * LZ4_MAX_INPUT_SIZE.
+             *
+             * @param input Compressed input data.
+             * @param raw_size Size of uncompressed data.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to incompressed data.
+             */
+            inline protozero::data_view lz4_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
+                output.resize(raw_size);
+                lz4_uncompress(input, input_size, raw_size, &*output.begin());
+
                 return protozero::data_view{output.data(), output.size()};
             }
 
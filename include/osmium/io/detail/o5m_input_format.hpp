@@ -39,7 +39,9 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
@@ -50,7 +52,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/timestamp.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
-#include <osmium/thread/util.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/util/delta.hpp>
 
 #include <protozero/exception.hpp>
@@ -62,6 +64,7 @@ DEALINGS IN THE SOFTWARE.
 #include <cstdint>
 #include <cstring>
 #include <future>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <string>
@@ -150,96 +153,47 @@ namespace osmium {
 
             }; // class ReferenceTable
 
-            class O5mParser final : public Parser {
-
-                enum {
-                    initial_buffer_size = 1024UL * 1024UL
-                };
-
-                osmium::io::Header m_header{};
-
-                osmium::memory::Buffer m_buffer{initial_buffer_size,
-                                                osmium::memory::Buffer::auto_grow::internal};
-
-                std::string m_input{};
-
-                const char* m_data;
-                const char* m_end;
-
-                ReferenceTable m_reference_table;
-
-                static int64_t zvarint(const char** data, const char* end) {
-                    return protozero::decode_zigzag64(protozero::decode_varint(data, end));
-                }
-
-                bool ensure_bytes_available(std::size_t need_bytes) {
-                    if ((m_end - m_data) >= static_cast<int64_t>(need_bytes)) {
-                        return true;
-                    }
-
-                    if (input_done() && (m_input.size() < need_bytes)) {
-                        return false;
-                    }
-
-                    m_input.erase(0, m_data - m_input.data());
-
-                    while (m_input.size() < need_bytes) {
-                        const std::string data{get_input()};
-                        if (input_done()) {
-                            return false;
-                        }
-                        m_input.append(data);
-                    }
-
-                    m_data = m_input.data();
-                    m_end = m_input.data() + m_input.size();
-
-                    return true;
-                }
-
-                void check_header_magic() {
-                    static const unsigned char header_magic[] = { 0xff, 0xe0, 0x04, 'o', '5' };
-
-                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic)) != 0) {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data += sizeof(header_magic);
-                }
-
-                void check_file_type() {
-                    if (*m_data == 'm') {         // o5m data file
-                        m_header.set_has_multiple_object_versions(false);
-                    } else if (*m_data == 'c') {  // o5c change file
-                        m_header.set_has_multiple_object_versions(true);
-                    } else {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data++;
-                }
-
-                void check_file_format_version() {
-                    if (*m_data != '2') {
-                        throw o5m_error{"wrong header magic"};
-                    }
+            enum class o5m_dataset_type : unsigned char {
+                node         = 0x10,
+                way          = 0x11,
+                relation     = 0x12,
+                bounding_box = 0xdb,
+                timestamp    = 0xdc,
+                header       = 0xe0,
+                sync         = 0xee,
+                jump         = 0xef,
+                reset        = 0xff
+            }; // enum class o5m_dataset_type
+
+            inline int64_t o5m_zvarint(const char** data, const char* end) {
+                return protozero::decode_zigzag64(protozero::decode_varint(data, end));
+            }
 
-                    m_data++;
+            /**
+             * Is this dataset an object of one of the types in read_types?
+             */
+            inline bool o5m_dataset_is_wanted(o5m_dataset_type type, osmium::osm_entity_bits::type read_types) noexcept {
+                switch (type) {
+                    case o5m_dataset_type::node:
+                        return (read_types & osmium::osm_entity_bits::node) != 0;
+                    case o5m_dataset_type::way:
+                        return (read_types & osmium::osm_entity_bits::way) != 0;
+                    case o5m_dataset_type::relation:
+                        return (read_types & osmium::osm_entity_bits::relation) != 0;
+                    default:
+                        break;
                 }
+                return false;
+            }
 
-                void decode_header() {
-                    if (! ensure_bytes_available(7)) { // overall length of header
-                        throw o5m_error{"file too short (incomplete header info)"};
-                    }
-
-                    check_header_magic();
-                    check_file_type();
-                    check_file_format_version();
-                }
+            /**
+             * Decodes the objects in o5m datasets. Holds the string
+             * reference table and the delta decoding state which are
+             * cleared at every reset dataset.
+             */
+            class O5mDecoder {
 
-                void mark_header_as_done() {
-                    set_header_value(m_header);
-                }
+                ReferenceTable m_reference_table;
 
                 osmium::DeltaDecode<osmium::object_id_type> m_delta_id;
 
@@ -251,21 +205,6 @@ namespace osmium {
                 osmium::DeltaDecode<osmium::object_id_type> m_delta_way_node_id;
                 std::array<osmium::DeltaDecode<osmium::object_id_type>, 3> m_delta_member_ids;
 
-                void reset() {
-                    m_reference_table.clear();
-
-                    m_delta_id.clear();
-                    m_delta_timestamp.clear();
-                    m_delta_changeset.clear();
-                    m_delta_lon.clear();
-                    m_delta_lat.clear();
-
-                    m_delta_way_node_id.clear();
-                    m_delta_member_ids[0].clear();
-                    m_delta_member_ids[1].clear();
-                    m_delta_member_ids[2].clear();
-                }
-
                 const char* decode_string(const char** dataptr, const char* const end) {
                     if (**dataptr == 0x00) { // get inline string
                         (*dataptr)++;
@@ -361,10 +300,10 @@ namespace osmium {
                         }
                         object.set_version(static_cast<object_version_type>(version));
 
-                        const auto timestamp = m_delta_timestamp.update(zvarint(dataptr, end));
+                        const auto timestamp = m_delta_timestamp.update(o5m_zvarint(dataptr, end));
                         if (timestamp != 0) { // has timestamp
                             object.set_timestamp(timestamp);
-                            object.set_changeset(m_delta_changeset.update(zvarint(dataptr, end)));
+                            object.set_changeset(m_delta_changeset.update(o5m_zvarint(dataptr, end)));
                             if (*dataptr != end) {
                                 const auto uid_user = decode_user(dataptr, end);
                                 object.set_uid(uid_user.first);
@@ -378,10 +317,10 @@ namespace osmium {
                     return user;
                 }
 
-                void decode_node(const char* data, const char* const end) {
-                    osmium::builder::NodeBuilder builder{m_buffer};
+                void decode_node(osmium::memory::Buffer& buffer, const char* data, const char* const end) {
+                    osmium::builder::NodeBuilder builder{buffer};
 
-                    builder.set_id(m_delta_id.update(zvarint(&data, end)));
+                    builder.set_id(m_delta_id.update(o5m_zvarint(&data, end)));
 
                     builder.set_user(decode_info(builder.object(), &data, end));
 
@@ -390,8 +329,8 @@ namespace osmium {
                         builder.set_visible(false);
                         builder.set_location(osmium::Location{});
                     } else {
-                        const auto lon = m_delta_lon.update(zvarint(&data, end));
-                        const auto lat = m_delta_lat.update(zvarint(&data, end));
+                        const auto lon = m_delta_lon.update(o5m_zvarint(&data, end));
+                        const auto lat = m_delta_lat.update(o5m_zvarint(&data, end));
                         builder.set_location(osmium::Location{lon, lat});
 
                         if (data != end) {
@@ -400,10 +339,10 @@ namespace osmium {
                     }
                 }
 
-                void decode_way(const char* data, const char* const end) {
-                    osmium::builder::WayBuilder builder{m_buffer};
+                void decode_way(osmium::memory::Buffer& buffer, const char* data, const char* const end) {
+                    osmium::builder::WayBuilder builder{buffer};
 
-                    builder.set_id(m_delta_id.update(zvarint(&data, end)));
+                    builder.set_id(m_delta_id.update(o5m_zvarint(&data, end)));
 
                     builder.set_user(decode_info(builder.object(), &data, end));
 
@@ -421,7 +360,7 @@ namespace osmium {
                             osmium::builder::WayNodeListBuilder wn_builder{builder};
 
                             while (data < end_refs) {
-                                wn_builder.add_node_ref(m_delta_way_node_id.update(zvarint(&data, end)));
+                                wn_builder.add_node_ref(m_delta_way_node_id.update(o5m_zvarint(&data, end)));
                             }
                         }
 
@@ -463,10 +402,10 @@ namespace osmium {
                     return {member_type, role};
                 }
 
-                void decode_relation(const char* data, const char* const end) {
-                    osmium::builder::RelationBuilder builder{m_buffer};
+                void decode_relation(osmium::memory::Buffer& buffer, const char* data, const char* const end) {
+                    osmium::builder::RelationBuilder builder{buffer};
 
-                    builder.set_id(m_delta_id.update(zvarint(&data, end)));
+                    builder.set_id(m_delta_id.update(o5m_zvarint(&data, end)));
 
                     builder.set_user(decode_info(builder.object(), &data, end));
 
@@ -484,7 +423,7 @@ namespace osmium {
                             osmium::builder::RelationMemberListBuilder rml_builder{builder};
 
                             while (data < end_refs) {
-                                const auto delta_id = zvarint(&data, end);
+                                const auto delta_id = o5m_zvarint(&data, end);
                                 if (data == end) {
                                     throw o5m_error{"relation member format error"};
                                 }
@@ -501,40 +440,265 @@ namespace osmium {
                     }
                 }
 
+            public:
+
+                void reset() {
+                    m_reference_table.clear();
+
+                    m_delta_id.clear();
+                    m_delta_timestamp.clear();
+                    m_delta_changeset.clear();
+                    m_delta_lon.clear();
+                    m_delta_lat.clear();
+
+                    m_delta_way_node_id.clear();
+                    m_delta_member_ids[0].clear();
+                    m_delta_member_ids[1].clear();
+                    m_delta_member_ids[2].clear();
+                }
+
+                /**
+                 * Decode the dataset of the given type if it is an object
+                 * of one of the requested types. Returns true if an object
+                 * was added to the buffer.
+                 *
+                 * If a read filter is given and the object doesn't match
+                 * it, the object is rolled back and false is returned. The
+                 * object has to be decoded anyway, because the o5m format
+                 * keeps state (deltas and the string reference table)
+                 * between objects.
+                 */
+                bool decode_object(o5m_dataset_type type, osmium::osm_entity_bits::type read_types, osmium::memory::Buffer& buffer, const char* data, const char* const end, const osmium::io::ReadFilter* read_filter = nullptr) {
+                    if (!o5m_dataset_is_wanted(type, read_types)) {
+                        return false;
+                    }
+                    switch (type) {
+                        case o5m_dataset_type::node:
+                            decode_node(buffer, data, end);
+                            break;
+                        case o5m_dataset_type::way:
+                            decode_way(buffer, data, end);
+                            break;
+                        default: // relation
+                            decode_relation(buffer, data, end);
+                            break;
+                    }
+                    if (read_filter && !read_filter->match(buffer.get<osmium::OSMObject>(buffer.committed()))) {
+                        buffer.rollback();
+                        return false;
+                    }
+                    return true;
+                }
+
+            }; // class O5mDecoder
+
+            /**
+             * Decodes a chunk of o5m datasets in a separate thread. The
+             * chunk always starts right after a reset dataset, so it can
+             * be decoded without any state from the datasets before it.
+             * Used in parallel mode of the O5mParser.
+             */
+            class O5mChunkDecoder {
+
+                enum {
+                    initial_buffer_size = 1024UL * 1024UL
+                };
+
+                std::string m_data;
+                osmium::memory::Buffer m_buffer;
+                osmium::osm_entity_bits::type m_read_types;
+                std::shared_ptr<const osmium::io::ReadFilter> m_read_filter;
+
+            public:
+
+                O5mChunkDecoder(std::string&& data, osmium::osm_entity_bits::type read_types, osmium::memory::BufferPool* buffer_pool, std::shared_ptr<const osmium::io::ReadFilter> read_filter = nullptr) :
+                    m_data(std::move(data)),
+                    m_buffer(buffer_pool ? buffer_pool->get(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes)
+                                         : osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes}),
+                    m_read_types(read_types),
+                    m_read_filter(std::move(read_filter)) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    O5mDecoder decoder;
+
+                    // The chunk was assembled by the O5mParser, so all
+                    // datasets in it are complete.
+                    const char* data = m_data.data();
+                    const char* const end = data + m_data.size();
+                    while (data != end) {
+                        const auto ds_type = static_cast<o5m_dataset_type>(*data++);
+                        if (ds_type == o5m_dataset_type::reset) {
+                            decoder.reset();
+                            continue;
+                        }
+                        const auto length = protozero::decode_varint(&data, end);
+                        if (decoder.decode_object(ds_type, m_read_types, m_buffer, data, data + length, m_read_filter.get())) {
+                            m_buffer.commit();
+                        }
+                        data += length;
+                    }
+
+                    return std::move(m_buffer);
+                }
+
+            }; // class O5mChunkDecoder
+
+            class O5mParser final : public Parser {
+
+                enum {
+                    initial_buffer_size = 1024UL * 1024UL
+                };
+
+                enum : std::size_t {
+                    // Minimum size of o5m chunks decoded in parallel
+                    chunk_size = 4UL * 1024UL * 1024UL
+                };
+
+                osmium::io::Header m_header{};
+
+                osmium::memory::Buffer m_buffer{initial_buffer_size,
+                                                osmium::memory::Buffer::auto_grow::internal};
+
+                std::string m_input{};
+
+                const char* m_data;
+                const char* m_end;
+
+                O5mDecoder m_decoder;
+
+                // Datasets collected for the next chunk in parallel mode
+                std::string m_chunk;
+
+                bool m_parallel = false;
+
+                bool ensure_bytes_available(std::size_t need_bytes) {
+                    if ((m_end - m_data) >= static_cast<int64_t>(need_bytes)) {
+                        return true;
+                    }
+
+                    if (input_done() && (m_input.size() < need_bytes)) {
+                        return false;
+                    }
+
+                    m_input.erase(0, m_data - m_input.data());
+
+                    while (m_input.size() < need_bytes) {
+                        const std::string data{get_input()};
+                        if (input_done()) {
+                            return false;
+                        }
+                        m_input.append(data);
+                    }
+
+                    m_data = m_input.data();
+                    m_end = m_input.data() + m_input.size();
+
+                    return true;
+                }
+
+                void check_header_magic() {
+                    static const unsigned char header_magic[] = { 0xff, 0xe0, 0x04, 'o', '5' };
+
+                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic)) != 0) {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data += sizeof(header_magic);
+                }
+
+                void check_file_type() {
+                    if (*m_data == 'm') {         // o5m data file
+                        m_header.set_has_multiple_object_versions(false);
+                    } else if (*m_data == 'c') {  // o5c change file
+                        m_header.set_has_multiple_object_versions(true);
+                    } else {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void check_file_format_version() {
+                    if (*m_data != '2') {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void decode_header() {
+                    if (! ensure_bytes_available(7)) { // overall length of header
+                        throw o5m_error{"file too short (incomplete header info)"};
+                    }
+
+                    check_header_magic();
+                    check_file_type();
+                    check_file_format_version();
+                }
+
+                void mark_header_as_done() {
+                    set_header_value(m_header);
+                }
+
                 void decode_bbox(const char* data, const char* const end) {
-                    const auto sw_lon = zvarint(&data, end);
-                    const auto sw_lat = zvarint(&data, end);
-                    const auto ne_lon = zvarint(&data, end);
-                    const auto ne_lat = zvarint(&data, end);
+                    const auto sw_lon = o5m_zvarint(&data, end);
+                    const auto sw_lat = o5m_zvarint(&data, end);
+                    const auto ne_lon = o5m_zvarint(&data, end);
+                    const auto ne_lat = o5m_zvarint(&data, end);
 
                     m_header.add_box(osmium::Box{osmium::Location{sw_lon, sw_lat},
                                                  osmium::Location{ne_lon, ne_lat}});
                 }
 
                 void decode_timestamp(const char* data, const char* const end) {
-                    const auto timestamp = osmium::Timestamp{zvarint(&data, end)}.to_iso();
+                    const auto timestamp = osmium::Timestamp{o5m_zvarint(&data, end)}.to_iso();
                     m_header.set("o5m_timestamp", timestamp);
                     m_header.set("timestamp", timestamp);
                 }
 
-                enum class dataset_type : unsigned char {
-                    node         = 0x10,
-                    way          = 0x11,
-                    relation     = 0x12,
-                    bounding_box = 0xdb,
-                    timestamp    = 0xdc,
-                    header       = 0xe0,
-                    sync         = 0xee,
-                    jump         = 0xef,
-                    reset        = 0xff
-                };
+                void submit_chunk() {
+                    const std::size_t bytes = m_chunk.size();
+                    send_to_output_queue_from_pool(O5mChunkDecoder{std::move(m_chunk), read_types(), buffer_pool(), read_filter()}, bytes);
+                    m_chunk.clear();
+                }
+
+                void add_to_chunk(o5m_dataset_type type, const char* data, uint64_t length) {
+                    m_chunk.push_back(static_cast<char>(type));
+                    protozero::write_varint(std::back_inserter(m_chunk), length);
+                    m_chunk.append(data, length);
+                }
+
+                // In parallel mode a reset ends the current chunk if it is
+                // large enough. Otherwise the reset is added to the chunk so
+                // the chunk decoder clears its state at the same place.
+                void handle_reset() {
+                    if (!m_parallel) {
+                        m_decoder.reset();
+                    } else if (m_chunk.size() >= chunk_size) {
+                        submit_chunk();
+                    } else if (!m_chunk.empty()) {
+                        m_chunk.push_back(static_cast<char>(o5m_dataset_type::reset));
+                    }
+                }
+
+                void decode_object(o5m_dataset_type type, uint64_t length) {
+                    mark_header_as_done();
+                    if (m_parallel) {
+                        if (o5m_dataset_is_wanted(type, read_types())) {
+                            add_to_chunk(type, m_data, length);
+                        }
+                    } else if (m_decoder.decode_object(type, read_types(), m_buffer, m_data, m_data + length, read_filter().get())) {
+                        m_buffer.commit();
+                    }
+                }
 
                 void decode_data() {
                     while (ensure_bytes_available(1)) {
-                        const auto ds_type = static_cast<dataset_type>(*m_data++);
-                        if (ds_type > dataset_type::jump) {
-                            if (ds_type == dataset_type::reset) {
-                                reset();
+                        const auto ds_type = static_cast<o5m_dataset_type>(*m_data++);
+                        if (ds_type > o5m_dataset_type::jump) {
+                            if (ds_type == o5m_dataset_type::reset) {
+                                handle_reset();
                             }
                         } else {
                             ensure_bytes_available(protozero::max_varint_length);
@@ -551,31 +715,15 @@ namespace osmium {
                             }
 
                             switch (ds_type) {
-                                case dataset_type::node:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::node) {
-                                        decode_node(m_data, m_data + length);
-                                        m_buffer.commit();
-                                    }
-                                    break;
-                                case dataset_type::way:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::way) {
-                                        decode_way(m_data, m_data + length);
-                                        m_buffer.commit();
-                                    }
-                                    break;
-                                case dataset_type::relation:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::relation) {
-                                        decode_relation(m_data, m_data + length);
-                                        m_buffer.commit();
-                                    }
+                                case o5m_dataset_type::node:
+                                case o5m_dataset_type::way:
+                                case o5m_dataset_type::relation:
+                                    decode_object(ds_type, length);
                                     break;
-                                case dataset_type::bounding_box:
+                                case o5m_dataset_type::bounding_box:
                                     decode_bbox(m_data, m_data + length);
                                     break;
-                                case dataset_type::timestamp:
+                                case o5m_dataset_type::timestamp:
                                     decode_timestamp(m_data, m_data + length);
                                     break;
                                 default:
@@ -596,6 +744,10 @@ namespace osmium {
                         }
                     }
 
+                    if (!m_chunk.empty()) {
+                        submit_chunk();
+                    }
+
                     if (m_buffer.committed() > 0) {
                         send_to_output_queue(std::move(m_buffer));
                     }
@@ -620,7 +772,9 @@ namespace osmium {
                 ~O5mParser() noexcept override = default;
 
                 void run() override {
-                    osmium::thread::set_thread_name("_osmium_o5m_in");
+                    set_thread_name("_osmium_o5m_in");
+
+                    m_parallel = file_option_is_true("parallel_parsing");
 
                     decode_header();
                     decode_data();
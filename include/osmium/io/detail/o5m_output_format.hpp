@@ -0,0 +1,436 @@
+#ifndef OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/delta.hpp>
+#include <osmium/visitor.hpp>
+
+#include <protozero/varint.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            // Implementation of the o5m/o5c file formats according to the
+            // description at https://wiki.openstreetmap.org/wiki/O5m .
+
+            struct o5m_output_options {
+
+                /// Which metadata of objects should be added?
+                osmium::metadata_options add_metadata;
+
+            }; // struct o5m_output_options
+
+            /**
+             * The encoder side of the o5m string reference table. It keeps
+             * track of which strings the decoder will have in its
+             * ReferenceTable, so that strings seen recently can be written
+             * as references into that table.
+             */
+            class OutputReferenceTable {
+
+                // The following settings are from the o5m description:
+
+                // The maximum number of entries in the table.
+                enum {
+                    number_of_entries = 15000U
+                };
+
+                // The maximum length of a string in the table including
+                // two \0 bytes.
+                enum {
+                    max_length = 250U + 2U
+                };
+
+                // Maps strings to the number of the entry they were last
+                // added as.
+                std::unordered_map<std::string, uint64_t> m_index;
+
+                uint64_t m_count = 0;
+
+            public:
+
+                void clear() {
+                    m_index.clear();
+                    m_count = 0;
+                }
+
+                /**
+                 * Return the index of the string for use in a reference
+                 * (1 is the string added last) or 0 if the string is not
+                 * available in the table.
+                 */
+                uint64_t find(const std::string& string) const {
+                    const auto it = m_index.find(string);
+                    if (it == m_index.end()) {
+                        return 0;
+                    }
+                    const auto index = m_count - it->second;
+                    return index <= number_of_entries ? index : 0;
+                }
+
+                /**
+                 * Add a string written inline to the table. Too long
+                 * strings are ignored like the decoder does.
+                 */
+                void add(const std::string& string) {
+                    if (string.size() <= max_length) {
+                        m_index[string] = m_count++;
+                    }
+                }
+
+                /**
+                 * Take up an entry in the table without making it available
+                 * for references.
+                 */
+                void skip() noexcept {
+                    ++m_count;
+                }
+
+            }; // class OutputReferenceTable
+
+            /**
+             * Writes out one buffer with OSM data in o5m format. Every block
+             * starts with a reset, so the blocks can be encoded
+             * independently of each other.
+             */
+            class O5mOutputBlock : public OutputBlock {
+
+                enum class dataset_type : unsigned char {
+                    node     = 0x10,
+                    way      = 0x11,
+                    relation = 0x12,
+                    reset    = 0xff
+                };
+
+                o5m_output_options m_options;
+
+                OutputReferenceTable m_reference_table;
+
+                // The contents of the dataset currently being encoded and
+                // a scratch string used to assemble strings.
+                std::string m_data;
+                std::string m_string;
+
+                osmium::DeltaEncode<osmium::object_id_type, int64_t> m_delta_id;
+
+                osmium::DeltaEncode<int64_t, int64_t> m_delta_timestamp;
+                osmium::DeltaEncode<osmium::changeset_id_type, int64_t> m_delta_changeset;
+                osmium::DeltaEncode<int64_t, int64_t> m_delta_lon;
+                osmium::DeltaEncode<int64_t, int64_t> m_delta_lat;
+
+                osmium::DeltaEncode<osmium::object_id_type, int64_t> m_delta_way_node_id;
+                std::array<osmium::DeltaEncode<osmium::object_id_type, int64_t>, 3> m_delta_member_ids;
+
+                static void write_varint(std::string& out, uint64_t value) {
+                    protozero::write_varint(std::back_inserter(out), value);
+                }
+
+                static void write_zvarint(std::string& out, int64_t value) {
+                    write_varint(out, protozero::encode_zigzag64(value));
+                }
+
+                // Write the string in m_string either as reference or
+                // inline.
+                void write_string() {
+                    const auto index = m_reference_table.find(m_string);
+                    if (index != 0) {
+                        write_varint(m_data, index);
+                        return;
+                    }
+                    m_data += '\0';
+                    m_data += m_string;
+                    m_reference_table.add(m_string);
+                }
+
+                void write_user(const osmium::OSMObject& object) {
+                    if (!m_options.add_metadata.uid() || object.uid() == 0) {
+                        // The anonymous user is always written inline,
+                        // because the decoder handles it specially.
+                        m_data.append(3, '\0');
+                        m_reference_table.skip();
+                        return;
+                    }
+
+                    m_string.clear();
+                    write_varint(m_string, object.uid());
+                    m_string += '\0';
+                    if (m_options.add_metadata.user()) {
+                        m_string += object.user();
+                    }
+                    m_string += '\0';
+                    write_string();
+                }
+
+                // Start a new dataset with the id and info section of the
+                // object.
+                void write_id_and_info(const osmium::OSMObject& object) {
+                    m_data.clear();
+
+                    write_zvarint(m_data, m_delta_id.update(object.id()));
+
+                    if (!m_options.add_metadata.any() || object.version() == 0) {
+                        m_data += '\0'; // no info section
+                        return;
+                    }
+
+                    write_varint(m_data, object.version());
+
+                    const int64_t timestamp = m_options.add_metadata.timestamp() ? uint32_t(object.timestamp()) : 0;
+                    write_zvarint(m_data, m_delta_timestamp.update(timestamp));
+                    if (timestamp == 0) {
+                        return;
+                    }
+
+                    const osmium::changeset_id_type changeset = m_options.add_metadata.changeset() ? object.changeset() : 0;
+                    write_zvarint(m_data, m_delta_changeset.update(changeset));
+                    write_user(object);
+                }
+
+                void write_tags(const osmium::TagList& tags) {
+                    for (const auto& tag : tags) {
+                        m_string.clear();
+                        m_string += tag.key();
+                        m_string += '\0';
+                        m_string += tag.value();
+                        m_string += '\0';
+                        write_string();
+                    }
+                }
+
+                // Insert the length of the reference section starting at
+                // the specified offset in m_data in front of it.
+                void finish_reference_section(std::size_t offset) {
+                    std::string length;
+                    write_varint(length, m_data.size() - offset);
+                    m_data.insert(offset, length);
+                }
+
+                void write_dataset(dataset_type type) {
+                    *m_out += static_cast<char>(type);
+                    write_varint(*m_out, m_data.size());
+                    *m_out += m_data;
+                }
+
+            public:
+
+                O5mOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const o5m_output_options& options) :
+                    OutputBlock(std::move(buffer)),
+                    m_options(options) {
+                }
+
+                std::string operator()() {
+                    *m_out += static_cast<char>(dataset_type::reset);
+
+                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+
+                    std::string out;
+                    using std::swap;
+                    swap(out, *m_out);
+
+                    return out;
+                }
+
+                void node(const osmium::Node& node) {
+                    write_id_and_info(node);
+
+                    if (node.visible()) {
+                        write_zvarint(m_data, m_delta_lon.update(node.location().x()));
+                        write_zvarint(m_data, m_delta_lat.update(node.location().y()));
+                        write_tags(node.tags());
+                    }
+
+                    write_dataset(dataset_type::node);
+                }
+
+                void way(const osmium::Way& way) {
+                    write_id_and_info(way);
+
+                    if (way.visible()) {
+                        const auto offset = m_data.size();
+                        for (const auto& node_ref : way.nodes()) {
+                            write_zvarint(m_data, m_delta_way_node_id.update(node_ref.ref()));
+                        }
+                        finish_reference_section(offset);
+                        write_tags(way.tags());
+                    }
+
+                    write_dataset(dataset_type::way);
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    write_id_and_info(relation);
+
+                    if (relation.visible()) {
+                        const auto offset = m_data.size();
+                        for (const auto& member : relation.members()) {
+                            const auto i = osmium::item_type_to_nwr_index(member.type());
+                            write_zvarint(m_data, m_delta_member_ids[i].update(member.ref()));
+                            m_string.clear();
+                            m_string += static_cast<char>('0' + i);
+                            m_string += member.role();
+                            m_string += '\0';
+                            write_string();
+                        }
+                        finish_reference_section(offset);
+                        write_tags(relation.tags());
+                    }
+
+                    write_dataset(dataset_type::relation);
+                }
+
+            }; // class O5mOutputBlock
+
+            class O5mOutputFormat : public osmium::io::detail::OutputFormat {
+
+                o5m_output_options m_options;
+
+                bool m_change_format;
+
+                static void write_varint(std::string& out, uint64_t value) {
+                    protozero::write_varint(std::back_inserter(out), value);
+                }
+
+                static void write_zvarint(std::string& out, int64_t value) {
+                    write_varint(out, protozero::encode_zigzag64(value));
+                }
+
+                static void write_dataset(std::string& out, unsigned char type, const std::string& data) {
+                    out += static_cast<char>(type);
+                    write_varint(out, data.size());
+                    out += data;
+                }
+
+            public:
+
+                O5mOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue),
+                    m_change_format(file.is_true("o5c_change_format")) {
+                    m_options.add_metadata = osmium::metadata_options{file.get("add_metadata")};
+                }
+
+                void write_header(const osmium::io::Header& header) final {
+                    std::string out{"\xff\xe0\x04o5"};
+                    out += m_change_format ? 'c' : 'm';
+                    out += '2';
+
+                    if (!header.boxes().empty()) {
+                        const osmium::Box box = header.joined_boxes();
+                        std::string data;
+                        write_zvarint(data, box.bottom_left().x());
+                        write_zvarint(data, box.bottom_left().y());
+                        write_zvarint(data, box.top_right().x());
+                        write_zvarint(data, box.top_right().y());
+                        write_dataset(out, 0xdb, data);
+                    }
+
+                    const std::string timestamp{header.get("o5m_timestamp", header.get("timestamp"))};
+                    if (!timestamp.empty()) {
+                        try {
+                            std::string data;
+                            write_zvarint(data, uint32_t(osmium::Timestamp{timestamp.c_str()}));
+                            write_dataset(out, 0xdc, data);
+                        } catch (const std::invalid_argument&) {
+                            // ignore timestamps we can't parse
+                        }
+                    }
+
+                    send_to_output_queue(std::move(out));
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    write_shared_buffer(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)));
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    const std::size_t bytes = buffer->committed();
+                    send_to_output_queue_from_pool(O5mOutputBlock{buffer, m_options}, bytes);
+                }
+
+                void write_end() final {
+                    send_to_output_queue(std::string{"\xfe"});
+                }
+
+            }; // class O5mOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_o5m_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::o5m,
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::O5mOutputFormat(pool, file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_o5m_output() noexcept {
+                return registered_o5m_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
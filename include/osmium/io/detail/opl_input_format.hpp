@@ -38,8 +38,11 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
-#include <osmium/thread/util.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/pool.hpp>
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -61,36 +64,36 @@ namespace osmium {
 
                 while (!worker.input_done()) {
                     std::string input{worker.get_input()};
-                    std::string::size_type ppos = 0;
+                    char* const begin = &input[0];
+                    char* const end = begin + input.size();
+                    char* ppos = begin;
 
                     if (!rest.empty()) {
-                        ppos = input.find_first_of("\n\r");
-                        if (ppos == std::string::npos) {
+                        const char* const pos = find_line_end(begin, end);
+                        if (pos == end) {
                             rest.append(input);
                             continue;
                         }
-                        rest.append(input, 0, ppos);
+                        rest.append(begin, static_cast<std::size_t>(pos - begin));
                         if (!rest.empty()) {
                             worker.parse_line(rest.data());
                             rest.clear();
                         }
-                        ++ppos;
+                        ppos += pos - begin + 1;
                     }
 
-                    for (auto pos = input.find_first_of("\n\r", ppos);
-                         pos != std::string::npos;
-                         pos = input.find_first_of("\n\r", ppos)) {
-                        const char* data = &input[ppos];
-                        input[pos] = '\0';
-                        if (data[0] != '\0') {
-                            worker.parse_line(data);
-                        }
-                        ppos = pos + 1;
-                        if (ppos >= input.size()) {
+                    while (ppos < end) {
+                        char* const pos = ppos + (find_line_end(ppos, end) - ppos);
+                        if (pos == end) {
                             break;
                         }
+                        *pos = '\0';
+                        if (*ppos != '\0') {
+                            worker.parse_line(ppos);
+                        }
+                        ppos = pos + 1;
                     }
-                    rest.assign(input, ppos, std::string::npos);
+                    rest.assign(ppos, static_cast<std::size_t>(end - ppos));
                 }
 
                 if (!rest.empty()) {
@@ -98,17 +101,121 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Count the non-empty lines in the data the same way
+             * line_by_line() does.
+             */
+            inline uint64_t count_opl_lines(const std::string& data) noexcept {
+                uint64_t count = 0;
+                const char* const end = data.data() + data.size();
+                for (const char* pos = data.data(); pos != end;) {
+                    const char* const line_end = find_line_end(pos, end);
+                    if (line_end != pos) {
+                        ++count;
+                    }
+                    pos = line_end == end ? end : line_end + 1;
+                }
+                return count;
+            }
+
+            /**
+             * Parses a chunk of complete OPL lines in a separate thread.
+             * Used in parallel mode of the OPLParser.
+             */
+            class OPLChunkParser {
+
+                enum {
+                    initial_buffer_size = 1024UL * 1024UL
+                };
+
+                std::string m_data;
+                osmium::memory::Buffer m_buffer;
+                uint64_t m_line_count;
+                osmium::osm_entity_bits::type m_read_types;
+                bool m_input_done = false;
+
+            public:
+
+                OPLChunkParser(std::string&& data, uint64_t line_count, osmium::osm_entity_bits::type read_types, osmium::memory::BufferPool* buffer_pool) :
+                    m_data(std::move(data)),
+                    m_buffer(buffer_pool ? buffer_pool->get(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes)
+                                         : osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes}),
+                    m_line_count(line_count),
+                    m_read_types(read_types) {
+                }
+
+                bool input_done() const noexcept {
+                    return m_input_done;
+                }
+
+                std::string get_input() {
+                    m_input_done = true;
+                    return std::move(m_data);
+                }
+
+                void parse_line(const char* data) {
+                    opl_parse_line(m_line_count, data, m_buffer, m_read_types);
+                    ++m_line_count;
+                }
+
+                osmium::memory::Buffer operator()() {
+                    line_by_line(*this);
+                    return std::move(m_buffer);
+                }
+
+            }; // class OPLChunkParser
+
             class OPLParser final : public Parser {
 
                 enum {
                     initial_buffer_size = 1024UL * 1024UL
                 };
 
+                enum : std::size_t {
+                    // Approximate size of OPL chunks parsed in parallel
+                    chunk_size = 1024UL * 1024UL
+                };
+
                 osmium::memory::Buffer m_buffer{initial_buffer_size,
                                                 osmium::memory::Buffer::auto_grow::internal};
 
                 uint64_t m_line_count = 0;
 
+                void submit_chunk(std::string&& chunk) {
+                    const uint64_t lines = count_opl_lines(chunk);
+                    const std::size_t bytes = chunk.size();
+                    send_to_output_queue_from_pool(OPLChunkParser{std::move(chunk), m_line_count, read_types(), buffer_pool()}, bytes);
+                    m_line_count += lines;
+                }
+
+                /**
+                 * Parse the input in parallel. The input is split into
+                 * chunks of complete lines which are parsed on the thread
+                 * pool.
+                 */
+                void run_parallel() {
+                    std::string data;
+
+                    while (!input_done()) {
+                        data.append(get_input());
+                        if (data.size() < chunk_size) {
+                            continue;
+                        }
+                        const auto pos = data.find_last_of("\n\r");
+                        if (pos == std::string::npos) {
+                            continue;
+                        }
+                        std::string rest{data, pos + 1};
+                        data.resize(pos + 1);
+                        submit_chunk(std::move(data));
+                        data = std::move(rest);
+                    }
+
+                    if (!data.empty()) {
+                        submit_chunk(std::move(data));
+                    }
+                }
+
             public:
 
                 explicit OPLParser(parser_arguments& args) :
@@ -135,7 +242,12 @@ namespace osmium {
                 }
 
                 void run() override {
-                    osmium::thread::set_thread_name("_osmium_opl_in");
+                    set_thread_name("_osmium_opl_in");
+
+                    if (file_option_is_true("parallel_parsing")) {
+                        run_parallel();
+                        return;
+                    }
 
                     line_by_line(*this);
 
@@ -56,6 +56,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
 
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
 #include <memory>
@@ -99,7 +100,9 @@ namespace osmium {
 
                 void write_field_timestamp(char c, const osmium::Timestamp& timestamp) {
                     *m_out += c;
-                    *m_out += timestamp.to_iso();
+                    if (timestamp.valid()) {
+                        output_timestamp(timestamp);
+                    }
                 }
 
                 void write_tags(const osmium::TagList& tags) {
@@ -173,12 +176,16 @@ namespace osmium {
 
             public:
 
-                OPLOutputBlock(osmium::memory::Buffer&& buffer, const opl_output_options& options) :
+                OPLOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const opl_output_options& options) :
                     OutputBlock(std::move(buffer)),
                     m_options(options) {
                 }
 
                 std::string operator()() {
+                    // The OPL output is usually a bit smaller than the
+                    // objects in the buffer.
+                    m_out->reserve(m_input_buffer->committed());
+
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
 
                     std::string out;
@@ -295,7 +302,12 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(buffer), m_options}));
+                    write_shared_buffer(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)));
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    const std::size_t bytes = buffer->committed();
+                    send_to_output_queue_from_pool(OPLOutputBlock{buffer, m_options}, bytes);
                 }
 
             }; // class OPLOutputFormat
@@ -48,8 +48,10 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iterator>
 #include <limits>
 #include <stdexcept>
@@ -131,9 +133,8 @@ namespace osmium {
              * string.
              */
             inline const char* opl_skip_section(const char** s) noexcept {
-                while (opl_non_empty(*s)) {
-                    ++*s;
-                }
+                // strcspn() is vectorized in most C libraries.
+                *s += std::strcspn(*s, " \t");
                 return *s;
             }
 
@@ -184,16 +185,17 @@ namespace osmium {
             inline void opl_parse_string(const char** data, std::string& result) {
                 const char* s = *data;
                 while (true) {
-                    if (*s == '\0' || *s == ' ' || *s == '\t' || *s == ',' || *s == '=') {
+                    // Append runs of characters that don't need any special
+                    // handling in one go. strcspn() is vectorized in most C
+                    // libraries.
+                    const std::size_t length = std::strcspn(s, " \t,=%");
+                    result.append(s, length);
+                    s += length;
+                    if (*s != '%') {
                         break;
                     }
-                    if (*s == '%') {
-                        ++s;
-                        opl_parse_escaped(&s, result);
-                    } else {
-                        result += *s;
-                        ++s;
-                    }
+                    ++s;
+                    opl_parse_escaped(&s, result);
                 }
                 *data = s;
             }
@@ -35,17 +35,22 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/handler.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/string_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/osm/timestamp.hpp>
 #include <osmium/thread/pool.hpp>
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace osmium {
@@ -62,37 +67,26 @@ namespace osmium {
 
             protected:
 
-                std::shared_ptr<osmium::memory::Buffer> m_input_buffer;
+                // This is only read, so it can be shared with other
+                // output formats encoding the same buffer.
+                std::shared_ptr<const osmium::memory::Buffer> m_input_buffer;
 
                 std::shared_ptr<std::string> m_out;
 
-                explicit OutputBlock(osmium::memory::Buffer&& buffer) :
-                    m_input_buffer(std::make_shared<osmium::memory::Buffer>(std::move(buffer))),
+                explicit OutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer) :
+                    m_input_buffer(std::move(buffer)),
                     m_out(std::make_shared<std::string>()) {
                 }
 
-                // Simple function to convert integer to string. This is much
-                // faster than using sprintf, but could be further optimized.
-                // See https://github.com/miloyip/itoa-benchmark .
+                // Convert integer to string without going through sprintf.
                 void output_int(int64_t value) {
-                    if (value < 0) {
-                        *m_out += '-';
-                        value = -value;
-                    }
-
-                    char temp[20];
-                    char *t = temp;
-                    do {
-                        *t++ = static_cast<char>(value % 10) + '0'; // NOLINT(bugprone-narrowing-conversions, cppcoreguidelines-narrowing-conversions)
-                        value /= 10;
-                    } while (value > 0);
+                    append_int_to_string(*m_out, value);
+                }
 
-                    const auto old_size = m_out->size();
-                    m_out->resize(old_size + (t - temp));
-                    char* data = &(*m_out)[old_size];
-                    do {
-                        *data++ = *--t;
-                    } while (t != temp);
+                // Write timestamp in ISO format. Writes
+                // "1970-01-01T00:00:00Z" for invalid timestamps.
+                void output_timestamp(const osmium::Timestamp& timestamp) {
+                    osmium::detail::add_iso_timestamp_to_string(uint32_t(timestamp), *m_out);
                 }
 
             }; // class OutputBlock;
@@ -110,6 +104,7 @@ namespace osmium {
 
                 osmium::thread::Pool& m_pool;
                 future_string_queue_type& m_output_queue;
+                bool m_synchronous = false;
 
                 /**
                  * Wrap the string into a future and add it to the output
@@ -119,6 +114,35 @@ namespace osmium {
                     add_to_queue(m_output_queue, std::move(data));
                 }
 
+                /**
+                 * Run the function in the thread pool. In synchronous mode
+                 * it is run right away in the current thread instead.
+                 */
+                template <typename TFunction>
+                std::future<typename std::result_of<TFunction()>::type> submit_to_pool(TFunction&& function) {
+                    if (m_synchronous) {
+                        std::packaged_task<typename std::result_of<TFunction()>::type()> task{std::forward<TFunction>(function)};
+                        auto future = task.get_future();
+                        task();
+                        return future;
+                    }
+                    return m_pool.submit(std::forward<TFunction>(function));
+                }
+
+                /**
+                 * Run the function, which must return a string, in the
+                 * thread pool and add its result to the output queue.
+                 *
+                 * @param function The function.
+                 * @param bytes Size of the input data the function works
+                 *              on. This is used as an estimate for the size
+                 *              of the result in queues limited by bytes.
+                 */
+                template <typename TFunction>
+                void send_to_output_queue_from_pool(TFunction&& function, std::size_t bytes) {
+                    m_output_queue.push(submit_to_pool(std::forward<TFunction>(function)), bytes);
+                }
+
             public:
 
                 OutputFormat(osmium::thread::Pool& pool, future_string_queue_type& output_queue) noexcept :
@@ -134,11 +158,45 @@ namespace osmium {
 
                 virtual ~OutputFormat() noexcept = default;
 
+                /**
+                 * Encode all data right away in the calling thread instead
+                 * of in the thread pool.
+                 */
+                void set_synchronous() noexcept {
+                    m_synchronous = true;
+                }
+
                 virtual void write_header(const osmium::io::Header& /*header*/) {
                 }
 
                 virtual void write_buffer(osmium::memory::Buffer&& /*buffer*/) = 0;
 
+                /**
+                 * Write a buffer that might be shared with other users, for
+                 * instance other Writers. The buffer is only read. The
+                 * default implementation copies it and calls
+                 * write_buffer(), formats able to encode directly from the
+                 * shared buffer override this.
+                 */
+                virtual void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) {
+                    osmium::memory::Buffer copy{buffer->committed(), osmium::memory::Buffer::auto_grow::no};
+                    copy.add_buffer(*buffer);
+                    copy.commit();
+                    write_buffer(std::move(copy));
+                }
+
+                /**
+                 * Write data already encoded in this format, for instance
+                 * complete data blobs for PBF files. The default
+                 * implementation throws, formats supporting this override
+                 * it.
+                 *
+                 * @throws osmium::io_error If the format doesn't support it.
+                 */
+                virtual void write_encoded(std::string&& /*data*/) {
+                    throw io_error{"Writing pre-encoded data is not supported for this output format"};
+                }
+
                 virtual void write_end() {
                 }
 
@@ -0,0 +1,202 @@
+#ifndef OSMIUM_IO_DETAIL_PARALLEL_COMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_PARALLEL_COMPRESSOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Compressor that splits the data into blocks of a fixed size,
+             * compresses the blocks independently in parallel on the
+             * thread pool, and writes the results in order. This only
+             * works for compression formats where the concatenation of
+             * the compressed blocks is valid compressed data, such as
+             * gzip members or bzip2 streams (the way pigz or lbzip2 work).
+             *
+             * Only a limited number of blocks are compressed ahead of the
+             * writer to keep memory use bounded.
+             */
+            class ParallelCompressor final : public osmium::io::Compressor {
+
+            public:
+
+                using compress_block_type = std::function<std::string(const char*, std::size_t)>;
+
+            private:
+
+                compress_block_type m_compress_block;
+                osmium::thread::Pool& m_pool;
+                std::deque<std::future<std::string>> m_results{};
+                std::string m_pending{};
+                std::size_t m_block_size;
+                std::size_t m_max_in_flight;
+                std::size_t m_file_size = 0;
+                int m_fd;
+                bool m_submitted = false;
+
+                void write_front() {
+                    const std::string data = m_results.front().get();
+                    m_results.pop_front();
+                    osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
+                    m_file_size += data.size();
+                }
+
+                void submit_block(std::string&& block) {
+                    while (m_results.size() >= m_max_in_flight) {
+                        write_front();
+                    }
+
+                    // The lambda is copied into the pool, so move the
+                    // block into a shared string only once.
+                    const auto data = std::make_shared<std::string>(std::move(block));
+                    const auto& compress_block = m_compress_block;
+                    m_results.push_back(m_pool.submit([compress_block, data]() {
+                        return compress_block(data->data(), data->size());
+                    }));
+                    m_submitted = true;
+                }
+
+            public:
+
+                /**
+                 * Construct compressor.
+                 *
+                 * @param fd File descriptor to write to.
+                 * @param sync Should fsync be called before closing?
+                 * @param compress_block Function compressing a single
+                 *                       block into a self-contained
+                 *                       unit of compressed data.
+                 * @param pool Thread pool to run compression on.
+                 * @param block_size Size of uncompressed blocks.
+                 */
+                ParallelCompressor(const int fd,
+                                   const fsync sync,
+                                   compress_block_type&& compress_block,
+                                   osmium::thread::Pool& pool,
+                                   const std::size_t block_size) :
+                    Compressor(sync),
+                    m_compress_block(std::move(compress_block)),
+                    m_pool(pool),
+                    m_block_size(block_size),
+                    m_max_in_flight(static_cast<std::size_t>(pool.num_threads()) * 2),
+                    m_fd(fd) {
+                    m_pending.reserve(block_size);
+                }
+
+                ParallelCompressor(const ParallelCompressor&) = delete;
+                ParallelCompressor& operator=(const ParallelCompressor&) = delete;
+
+                ParallelCompressor(ParallelCompressor&&) = delete;
+                ParallelCompressor& operator=(ParallelCompressor&&) = delete;
+
+                ~ParallelCompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                void write(const std::string& data) override {
+                    std::size_t pos = 0;
+                    while (pos < data.size()) {
+                        const std::size_t count = std::min(data.size() - pos, m_block_size - m_pending.size());
+                        m_pending.append(data, pos, count);
+                        pos += count;
+                        if (m_pending.size() == m_block_size) {
+                            std::string block;
+                            block.reserve(m_block_size);
+                            swap(block, m_pending);
+                            submit_block(std::move(block));
+                        }
+                    }
+                }
+
+                void close() override {
+                    if (m_fd >= 0) {
+                        // Always write at least one block, so that empty
+                        // output is still valid compressed data.
+                        if (!m_pending.empty() || !m_submitted) {
+                            submit_block(std::move(m_pending));
+                            m_pending.clear();
+                        }
+                        while (!m_results.empty()) {
+                            write_front();
+                        }
+
+                        const int fd = m_fd;
+                        m_fd = -1;
+
+                        // Do not sync or close stdout
+                        if (fd == 1) {
+                            return;
+                        }
+
+                        if (do_fsync()) {
+                            osmium::io::detail::reliable_fsync(fd);
+                        }
+                        osmium::io::detail::reliable_close(fd);
+                    }
+                }
+
+                std::size_t file_size() const override {
+                    return m_file_size;
+                }
+
+            }; // class ParallelCompressor
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PARALLEL_COMPRESSOR_HPP
@@ -0,0 +1,173 @@
+#ifndef OSMIUM_IO_DETAIL_PARALLEL_DECOMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_PARALLEL_DECOMPRESSOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Position and size of an independently decompressible
+             * segment (such as a gzip member or a bzip2 stream) inside
+             * a compressed buffer.
+             */
+            struct compressed_segment {
+                std::size_t offset;
+                std::size_t size;
+            }; // struct compressed_segment
+
+            /**
+             * Decompressor for compressed data in memory that consists
+             * of several independently compressed segments. The segments
+             * are decompressed in parallel on the thread pool and the
+             * results are handed out in order by read().
+             *
+             * Only a limited number of segments are decompressed ahead
+             * of the reader to keep memory use bounded.
+             */
+            class ParallelDecompressor final : public osmium::io::Decompressor {
+
+            public:
+
+                using decompress_segment_type = std::function<std::string(const char*, std::size_t)>;
+
+            private:
+
+                const char* m_buffer;
+                std::vector<compressed_segment> m_segments;
+                decompress_segment_type m_decompress_segment;
+                osmium::thread::Pool& m_pool;
+                std::deque<std::future<std::string>> m_results{};
+                std::size_t m_next_segment = 0;
+                std::size_t m_max_in_flight;
+
+                void submit_segments() {
+                    while (m_next_segment < m_segments.size() && m_results.size() < m_max_in_flight) {
+                        const auto data = m_buffer + m_segments[m_next_segment].offset;
+                        const auto size = m_segments[m_next_segment].size;
+                        const auto& decompress_segment = m_decompress_segment;
+                        m_results.push_back(m_pool.submit([decompress_segment, data, size]() {
+                            return decompress_segment(data, size);
+                        }));
+                        ++m_next_segment;
+                    }
+                }
+
+            public:
+
+                /**
+                 * Construct decompressor.
+                 *
+                 * @param buffer Compressed data. Must stay valid for the
+                 *               lifetime of this object.
+                 * @param segments Segments in the buffer in order.
+                 * @param decompress_segment Function decompressing a
+                 *                           single segment.
+                 * @param pool Thread pool to run decompression on.
+                 */
+                ParallelDecompressor(const char* buffer,
+                                     std::vector<compressed_segment>&& segments,
+                                     decompress_segment_type&& decompress_segment,
+                                     osmium::thread::Pool& pool) :
+                    m_buffer(buffer),
+                    m_segments(std::move(segments)),
+                    m_decompress_segment(std::move(decompress_segment)),
+                    m_pool(pool),
+                    m_max_in_flight(static_cast<std::size_t>(pool.num_threads()) * 2) {
+                }
+
+                ParallelDecompressor(const ParallelDecompressor&) = delete;
+                ParallelDecompressor& operator=(const ParallelDecompressor&) = delete;
+
+                ParallelDecompressor(ParallelDecompressor&&) = delete;
+                ParallelDecompressor& operator=(ParallelDecompressor&&) = delete;
+
+                ~ParallelDecompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                std::string read() override {
+                    std::string output;
+
+                    // An empty string signals the end of the data, so skip
+                    // over segments that decompress to nothing.
+                    while (output.empty()) {
+                        submit_segments();
+                        if (m_results.empty()) {
+                            break;
+                        }
+                        output = m_results.front().get();
+                        m_results.pop_front();
+                        const auto& segment = m_segments[m_next_segment - m_results.size() - 1];
+                        set_offset(segment.offset + segment.size);
+                    }
+
+                    return output;
+                }
+
+                void close() override {
+                    // Wait for all running tasks, they reference our buffer.
+                    for (auto& result : m_results) {
+                        result.wait();
+                    }
+                    m_results.clear();
+                    m_next_segment = m_segments.size();
+                }
+
+            }; // class ParallelDecompressor
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PARALLEL_DECOMPRESSOR_HPP
@@ -0,0 +1,744 @@
+#ifndef OSMIUM_IO_DETAIL_PARQUET_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_PARQUET_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/factory.hpp>
+#include <osmium/geom/wkb.hpp>
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/version.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Minimal writer for the Thrift compact protocol used for the
+             * page headers and the file metadata in Parquet files. Only
+             * the types needed for that are implemented.
+             */
+            class thrift_compact_writer {
+
+                std::string& m_out;
+                std::vector<int16_t> m_field_id_stack;
+                int16_t m_last_field_id = 0;
+
+                void write_field_header(int16_t id, uint8_t type) {
+                    const int delta = id - m_last_field_id;
+                    if (delta > 0 && delta <= 15) {
+                        m_out += static_cast<char>((delta << 4U) | type);
+                    } else {
+                        m_out += static_cast<char>(type);
+                        write_varint(zigzag(id));
+                    }
+                    m_last_field_id = id;
+                }
+
+            public:
+
+                enum type : uint8_t {
+                    type_bool_true  = 1,
+                    type_bool_false = 2,
+                    type_i32        = 5,
+                    type_i64        = 6,
+                    type_binary     = 8,
+                    type_list       = 9,
+                    type_struct     = 12
+                };
+
+                explicit thrift_compact_writer(std::string& out) :
+                    m_out(out) {
+                }
+
+                static uint64_t zigzag(int64_t value) noexcept {
+                    return (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(-static_cast<int64_t>(static_cast<uint64_t>(value) >> 63U));
+                }
+
+                void write_varint(uint64_t value) {
+                    while (value >= 0x80U) {
+                        m_out += static_cast<char>((value & 0x7fU) | 0x80U);
+                        value >>= 7U;
+                    }
+                    m_out += static_cast<char>(value);
+                }
+
+                void write_binary(const char* data, std::size_t size) {
+                    write_varint(size);
+                    m_out.append(data, size);
+                }
+
+                void write_binary(const std::string& str) {
+                    write_binary(str.data(), str.size());
+                }
+
+                void field_bool(int16_t id, bool value) {
+                    write_field_header(id, value ? type_bool_true : type_bool_false);
+                }
+
+                void field_i32(int16_t id, int32_t value) {
+                    write_field_header(id, type_i32);
+                    write_varint(zigzag(value));
+                }
+
+                void field_i64(int16_t id, int64_t value) {
+                    write_field_header(id, type_i64);
+                    write_varint(zigzag(value));
+                }
+
+                void field_binary(int16_t id, const std::string& value) {
+                    write_field_header(id, type_binary);
+                    write_binary(value);
+                }
+
+                // Start a list field. Elements have to be written with
+                // write_varint(zigzag()), write_binary(), or
+                // begin_struct()/end_struct().
+                void field_list(int16_t id, uint8_t element_type, std::size_t size) {
+                    write_field_header(id, type_list);
+                    if (size < 15) {
+                        m_out += static_cast<char>((size << 4U) | element_type);
+                    } else {
+                        m_out += static_cast<char>(0xf0U | element_type);
+                        write_varint(size);
+                    }
+                }
+
+                // Start a struct field.
+                void field_struct(int16_t id) {
+                    write_field_header(id, type_struct);
+                    begin_struct();
+                }
+
+                // Start a struct as list element or at the top level.
+                void begin_struct() {
+                    m_field_id_stack.push_back(m_last_field_id);
+                    m_last_field_id = 0;
+                }
+
+                void end_struct() {
+                    m_out += '\0'; // stop field
+                    if (!m_field_id_stack.empty()) {
+                        m_last_field_id = m_field_id_stack.back();
+                        m_field_id_stack.pop_back();
+                    }
+                }
+
+            }; // class thrift_compact_writer
+
+            namespace parquet {
+
+                // Constants from the Parquet format specification
+                // (parquet.thrift).
+                enum physical_type : int32_t {
+                    type_boolean    = 0,
+                    type_int32      = 1,
+                    type_int64      = 2,
+                    type_byte_array = 6
+                };
+
+                enum repetition_type : int32_t {
+                    required = 0,
+                    optional = 1,
+                    repeated = 2
+                };
+
+                enum converted_type : int32_t {
+                    none             = -1,
+                    utf8             = 0,
+                    map              = 1,
+                    map_key_value    = 2,
+                    timestamp_millis = 9,
+                    uint_32          = 13
+                };
+
+                enum encoding : int32_t {
+                    plain = 0,
+                    rle   = 3
+                };
+
+                inline void append_uint32_le(std::string& out, uint32_t value) {
+                    out += static_cast<char>(value & 0xffU);
+                    out += static_cast<char>((value >> 8U) & 0xffU);
+                    out += static_cast<char>((value >> 16U) & 0xffU);
+                    out += static_cast<char>((value >> 24U) & 0xffU);
+                }
+
+                inline void append_uint64_le(std::string& out, uint64_t value) {
+                    append_uint32_le(out, static_cast<uint32_t>(value & 0xffffffffU));
+                    append_uint32_le(out, static_cast<uint32_t>(value >> 32U));
+                }
+
+                /**
+                 * Description of a column (or group of columns) in the
+                 * schema of the file.
+                 */
+                struct schema_element {
+                    const char* name;
+                    int32_t type; // -1 for groups
+                    repetition_type repetition;
+                    converted_type converted;
+                    int32_t num_children;
+                    uint8_t max_repetition_level;
+                    uint8_t max_definition_level;
+                };
+
+                /**
+                 * Data and definition/repetition levels of one column in
+                 * one row group. All levels we need are 0 or 1.
+                 */
+                struct column {
+
+                    std::string values;
+                    std::vector<uint8_t> definition_levels;
+                    std::vector<uint8_t> repetition_levels;
+                    uint32_t num_values = 0;
+                    uint32_t num_bits = 0; // only used for boolean columns
+
+                    void add_int32(uint32_t value) {
+                        append_uint32_le(values, value);
+                        ++num_values;
+                    }
+
+                    void add_int64(uint64_t value) {
+                        append_uint64_le(values, value);
+                        ++num_values;
+                    }
+
+                    void add_bool(bool value) {
+                        if (num_bits % 8 == 0) {
+                            values += '\0';
+                        }
+                        if (value) {
+                            values.back() = static_cast<char>(values.back() | (1U << (num_bits % 8)));
+                        }
+                        ++num_bits;
+                        ++num_values;
+                    }
+
+                    void add_byte_array(const char* data, std::size_t size) {
+                        append_uint32_le(values, static_cast<uint32_t>(size));
+                        values.append(data, size);
+                        ++num_values;
+                    }
+
+                    void add_byte_array(const char* str) {
+                        add_byte_array(str, std::strlen(str));
+                    }
+
+                }; // struct column
+
+                // Encode levels (all 0 or 1) using the RLE part of the
+                // RLE/bit-packing hybrid encoding, prefixed by the length.
+                inline void append_levels(std::string& out, const std::vector<uint8_t>& levels) {
+                    std::string data;
+                    thrift_compact_writer writer{data};
+                    auto it = levels.begin();
+                    while (it != levels.end()) {
+                        auto run_end = it;
+                        while (run_end != levels.end() && *run_end == *it) {
+                            ++run_end;
+                        }
+                        writer.write_varint(static_cast<uint64_t>(run_end - it) << 1U);
+                        data += static_cast<char>(*it);
+                        it = run_end;
+                    }
+                    append_uint32_le(out, static_cast<uint32_t>(data.size()));
+                    out += data;
+                }
+
+                /**
+                 * Information about one column chunk needed for the file
+                 * metadata at the end of the file.
+                 */
+                struct column_chunk_info {
+                    std::size_t offset; // relative to start of row group
+                    std::size_t size;
+                    uint32_t num_values;
+                };
+
+                struct row_group_info {
+                    std::vector<column_chunk_info> columns;
+                    std::size_t size = 0;
+                    uint32_t num_rows = 0;
+                };
+
+            } // namespace parquet
+
+            struct parquet_output_options {
+
+                /// Which metadata of objects should be added?
+                osmium::metadata_options add_metadata;
+
+            }; // struct parquet_output_options
+
+            /**
+             * The schema of the Parquet files written. Some columns are
+             * only there if the metadata is written.
+             */
+            inline std::vector<parquet::schema_element> parquet_schema(const osmium::metadata_options& add_metadata) {
+                using namespace parquet; // NOLINT(google-build-using-namespace)
+
+                std::vector<schema_element> schema;
+                schema.push_back({"schema", -1, required, none, 0, 0, 0});
+                schema.push_back({"type", type_byte_array, required, utf8, 0, 0, 0});
+                schema.push_back({"id", type_int64, required, none, 0, 0, 0});
+                schema.push_back({"visible", type_boolean, required, none, 0, 0, 0});
+                if (add_metadata.version()) {
+                    schema.push_back({"version", type_int32, required, uint_32, 0, 0, 0});
+                }
+                if (add_metadata.changeset()) {
+                    schema.push_back({"changeset", type_int32, required, uint_32, 0, 0, 0});
+                }
+                if (add_metadata.timestamp()) {
+                    schema.push_back({"timestamp", type_int64, required, timestamp_millis, 0, 0, 0});
+                }
+                if (add_metadata.uid()) {
+                    schema.push_back({"uid", type_int32, required, uint_32, 0, 0, 0});
+                }
+                if (add_metadata.user()) {
+                    schema.push_back({"user", type_byte_array, required, utf8, 0, 0, 0});
+                }
+                schema.push_back({"tags", -1, required, map, 1, 0, 0});
+                schema.push_back({"key_value", -1, repeated, map_key_value, 2, 0, 0});
+                schema.push_back({"key", type_byte_array, required, utf8, 0, 1, 1});
+                schema.push_back({"value", type_byte_array, required, utf8, 0, 1, 1});
+                schema.push_back({"geometry", type_byte_array, optional, none, 0, 0, 1});
+
+                schema.front().num_children = static_cast<int32_t>(schema.size()) - 4;
+
+                return schema;
+            }
+
+            /**
+             * Writes out one buffer with OSM data as one row group of a
+             * Parquet file. Nodes, ways, relations, and areas become one
+             * row each with the geometry (if any) in WKB format.
+             */
+            class ParquetOutputBlock : public OutputBlock {
+
+                parquet_output_options m_options;
+
+                std::shared_ptr<std::promise<parquet::row_group_info>> m_row_group_info;
+
+                osmium::geom::WKBFactory<> m_factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::binary};
+
+                std::vector<parquet::column> m_columns;
+
+                uint32_t m_num_rows = 0;
+
+                void add_geometry(parquet::column& column, const std::string& wkb) {
+                    column.add_byte_array(wkb.data(), wkb.size());
+                    column.definition_levels.push_back(1);
+                }
+
+                void add_row(const osmium::OSMObject& object, const char* type, osmium::object_id_type id) {
+                    auto it = m_columns.begin();
+
+                    (it++)->add_byte_array(type);
+                    (it++)->add_int64(static_cast<uint64_t>(id));
+                    (it++)->add_bool(object.visible());
+                    if (m_options.add_metadata.version()) {
+                        (it++)->add_int32(object.version());
+                    }
+                    if (m_options.add_metadata.changeset()) {
+                        (it++)->add_int32(object.changeset());
+                    }
+                    if (m_options.add_metadata.timestamp()) {
+                        (it++)->add_int64(uint64_t(object.timestamp()) * 1000U);
+                    }
+                    if (m_options.add_metadata.uid()) {
+                        (it++)->add_int32(object.uid());
+                    }
+                    if (m_options.add_metadata.user()) {
+                        (it++)->add_byte_array(object.user());
+                    }
+
+                    auto& keys = *it++;
+                    auto& values = *it++;
+                    if (object.tags().empty()) {
+                        keys.definition_levels.push_back(0);
+                        keys.repetition_levels.push_back(0);
+                        values.definition_levels.push_back(0);
+                        values.repetition_levels.push_back(0);
+                    } else {
+                        uint8_t rep = 0;
+                        for (const auto& tag : object.tags()) {
+                            keys.add_byte_array(tag.key());
+                            keys.definition_levels.push_back(1);
+                            keys.repetition_levels.push_back(rep);
+                            values.add_byte_array(tag.value());
+                            values.definition_levels.push_back(1);
+                            values.repetition_levels.push_back(rep);
+                            rep = 1;
+                        }
+                    }
+
+                    ++m_num_rows;
+                }
+
+                parquet::column& geometry_column() {
+                    return m_columns.back();
+                }
+
+                void add_null_geometry() {
+                    geometry_column().definition_levels.push_back(0);
+                }
+
+                std::string encode() {
+                    std::string out;
+                    parquet::row_group_info info;
+                    info.num_rows = m_num_rows;
+
+                    const auto schema = parquet_schema(m_options.add_metadata);
+                    auto it = m_columns.begin();
+                    for (const auto& element : schema) {
+                        if (element.type < 0) {
+                            continue;
+                        }
+                        const auto& column = *it++;
+
+                        std::string page;
+                        if (element.max_repetition_level > 0) {
+                            parquet::append_levels(page, column.repetition_levels);
+                        }
+                        if (element.max_definition_level > 0) {
+                            parquet::append_levels(page, column.definition_levels);
+                        }
+                        page += column.values;
+
+                        const auto num_values = element.max_definition_level > 0 ? static_cast<uint32_t>(column.definition_levels.size())
+                                                                                 : column.num_values;
+
+                        const auto offset = out.size();
+                        thrift_compact_writer writer{out};
+                        writer.begin_struct(); // PageHeader
+                        writer.field_i32(1, 0); // DATA_PAGE
+                        writer.field_i32(2, static_cast<int32_t>(page.size()));
+                        writer.field_i32(3, static_cast<int32_t>(page.size()));
+                        writer.field_struct(5); // DataPageHeader
+                        writer.field_i32(1, static_cast<int32_t>(num_values));
+                        writer.field_i32(2, parquet::plain);
+                        writer.field_i32(3, parquet::rle);
+                        writer.field_i32(4, parquet::rle);
+                        writer.end_struct();
+                        writer.end_struct();
+                        out += page;
+
+                        info.columns.push_back({offset, out.size() - offset, num_values});
+                    }
+                    info.size = out.size();
+
+                    m_row_group_info->set_value(std::move(info));
+                    return out;
+                }
+
+            public:
+
+                ParquetOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const parquet_output_options& options, std::shared_ptr<std::promise<parquet::row_group_info>> row_group_info) :
+                    OutputBlock(std::move(buffer)),
+                    m_options(options),
+                    m_row_group_info(std::move(row_group_info)) {
+                }
+
+                std::string operator()() {
+                    try {
+                        for (const auto& element : parquet_schema(m_options.add_metadata)) {
+                            if (element.type >= 0) {
+                                m_columns.emplace_back();
+                            }
+                        }
+
+                        osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+
+                        return encode();
+                    } catch (...) {
+                        m_row_group_info->set_exception(std::current_exception());
+                        throw;
+                    }
+                }
+
+                void node(const osmium::Node& node) {
+                    add_row(node, "node", node.id());
+                    if (node.location().valid()) {
+                        add_geometry(geometry_column(), m_factory.create_point(node.location()));
+                    } else {
+                        add_null_geometry();
+                    }
+                }
+
+                void way(const osmium::Way& way) {
+                    add_row(way, "way", way.id());
+                    try {
+                        add_geometry(geometry_column(), m_factory.create_linestring(way));
+                    } catch (const osmium::geometry_error&) {
+                        add_null_geometry();
+                    } catch (const osmium::invalid_location&) {
+                        add_null_geometry();
+                    }
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    add_row(relation, "relation", relation.id());
+                    add_null_geometry();
+                }
+
+                void area(const osmium::Area& area) {
+                    add_row(area, area.from_way() ? "way" : "relation", area.orig_id());
+                    try {
+                        add_geometry(geometry_column(), m_factory.create_multipolygon(area));
+                    } catch (const osmium::geometry_error&) {
+                        add_null_geometry();
+                    } catch (const osmium::invalid_location&) {
+                        add_null_geometry();
+                    }
+                }
+
+            }; // class ParquetOutputBlock
+
+            /**
+             * Writes OSM data as Apache Parquet file. Each buffer is
+             * encoded on the thread pool as one row group, the file
+             * metadata is written at the end. The columns are "type",
+             * "id", "visible", the metadata as configured with the
+             * "add_metadata" option, "tags" (a map), and "geometry" (WKB,
+             * described in GeoParquet metadata). The data is not
+             * compressed.
+             */
+            class ParquetOutputFormat : public osmium::io::detail::OutputFormat {
+
+                parquet_output_options m_options;
+
+                std::vector<std::future<parquet::row_group_info>> m_row_groups;
+
+                std::string encode_file_metadata() {
+                    using namespace parquet; // NOLINT(google-build-using-namespace)
+
+                    const auto schema = parquet_schema(m_options.add_metadata);
+
+                    // Path in schema, physical type, and repetition of the
+                    // leaf columns.
+                    std::vector<std::vector<std::string>> paths;
+                    std::vector<int32_t> types;
+                    std::vector<std::string> path;
+                    std::vector<int32_t> children_left;
+                    for (std::size_t i = 1; i < schema.size(); ++i) {
+                        const auto& element = schema[i];
+                        path.emplace_back(element.name);
+                        if (element.type < 0) {
+                            children_left.push_back(element.num_children);
+                            continue;
+                        }
+                        paths.push_back(path);
+                        types.push_back(element.type);
+                        path.pop_back();
+                        while (!children_left.empty() && --children_left.back() == 0) {
+                            children_left.pop_back();
+                            path.pop_back();
+                        }
+                    }
+
+                    std::vector<row_group_info> row_groups;
+                    row_groups.reserve(m_row_groups.size());
+                    for (auto& future : m_row_groups) {
+                        row_groups.push_back(future.get());
+                    }
+                    m_row_groups.clear();
+
+                    int64_t num_rows = 0;
+                    for (const auto& row_group : row_groups) {
+                        num_rows += row_group.num_rows;
+                    }
+
+                    std::string out;
+                    thrift_compact_writer writer{out};
+
+                    writer.begin_struct(); // FileMetaData
+                    writer.field_i32(1, 1); // version
+
+                    writer.field_list(2, thrift_compact_writer::type_struct, schema.size());
+                    for (const auto& element : schema) {
+                        writer.begin_struct(); // SchemaElement
+                        if (element.type >= 0) {
+                            writer.field_i32(1, element.type);
+                        }
+                        if (&element != &schema.front()) {
+                            writer.field_i32(3, element.repetition);
+                        }
+                        writer.field_binary(4, element.name);
+                        if (element.type < 0) {
+                            writer.field_i32(5, element.num_children);
+                        }
+                        if (element.converted != none) {
+                            writer.field_i32(6, element.converted);
+                        }
+                        writer.end_struct();
+                    }
+
+                    writer.field_i64(3, num_rows);
+
+                    // Row groups without rows are left out, but the data
+                    // is still in the file, so we have to count the bytes.
+                    std::size_t num_row_groups = 0;
+                    for (const auto& row_group : row_groups) {
+                        if (row_group.num_rows > 0) {
+                            ++num_row_groups;
+                        }
+                    }
+
+                    std::size_t offset = 4; // magic at start of file
+                    writer.field_list(4, thrift_compact_writer::type_struct, num_row_groups);
+                    for (const auto& row_group : row_groups) {
+                        if (row_group.num_rows == 0) {
+                            offset += row_group.size;
+                            continue;
+                        }
+                        writer.begin_struct(); // RowGroup
+                        writer.field_list(1, thrift_compact_writer::type_struct, row_group.columns.size());
+                        for (std::size_t i = 0; i < row_group.columns.size(); ++i) {
+                            const auto& chunk = row_group.columns[i];
+                            const auto chunk_offset = static_cast<int64_t>(offset + chunk.offset);
+                            writer.begin_struct(); // ColumnChunk
+                            writer.field_i64(2, chunk_offset);
+                            writer.field_struct(3); // ColumnMetaData
+                            writer.field_i32(1, types[i]);
+                            writer.field_list(2, thrift_compact_writer::type_i32, 2);
+                            writer.write_varint(thrift_compact_writer::zigzag(plain));
+                            writer.write_varint(thrift_compact_writer::zigzag(rle));
+                            writer.field_list(3, thrift_compact_writer::type_binary, paths[i].size());
+                            for (const auto& name : paths[i]) {
+                                writer.write_binary(name);
+                            }
+                            writer.field_i32(4, 0); // UNCOMPRESSED
+                            writer.field_i64(5, chunk.num_values);
+                            writer.field_i64(6, static_cast<int64_t>(chunk.size));
+                            writer.field_i64(7, static_cast<int64_t>(chunk.size));
+                            writer.field_i64(9, chunk_offset);
+                            writer.end_struct();
+                            writer.end_struct();
+                        }
+                        writer.field_i64(2, static_cast<int64_t>(row_group.size));
+                        writer.field_i64(3, row_group.num_rows);
+                        writer.end_struct();
+                        offset += row_group.size;
+                    }
+
+                    // GeoParquet metadata, see https://geoparquet.org/
+                    writer.field_list(5, thrift_compact_writer::type_struct, 1);
+                    writer.begin_struct(); // KeyValue
+                    writer.field_binary(1, "geo");
+                    writer.field_binary(2, R"({"version":"1.0.0","primary_column":"geometry","columns":{"geometry":{"encoding":"WKB","geometry_types":[]}}})");
+                    writer.end_struct();
+
+                    writer.field_binary(6, "libosmium version " LIBOSMIUM_VERSION_STRING);
+                    writer.end_struct();
+
+                    return out;
+                }
+
+            public:
+
+                ParquetOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue) {
+                    m_options.add_metadata = osmium::metadata_options{file.get("add_metadata")};
+                }
+
+                void write_header(const osmium::io::Header& /*header*/) final {
+                    send_to_output_queue(std::string{"PAR1"});
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    write_shared_buffer(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)));
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    auto row_group_info = std::make_shared<std::promise<parquet::row_group_info>>();
+                    m_row_groups.push_back(row_group_info->get_future());
+                    const std::size_t bytes = buffer->committed();
+                    send_to_output_queue_from_pool(ParquetOutputBlock{buffer, m_options, std::move(row_group_info)}, bytes);
+                }
+
+                void write_end() final {
+                    std::string out{encode_file_metadata()};
+                    parquet::append_uint32_le(out, static_cast<uint32_t>(out.size()));
+                    out += "PAR1";
+                    send_to_output_queue(std::move(out));
+                }
+
+            }; // class ParquetOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_parquet_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::parquet,
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::ParquetOutputFormat(pool, file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_parquet_output() noexcept {
+                return registered_parquet_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PARQUET_OUTPUT_FORMAT_HPP
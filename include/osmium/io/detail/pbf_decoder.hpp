@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <limits>
@@ -48,26 +50,37 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/zlib.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/osm/object_comparisons.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/timestamp.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/tags/string_table_tags_filter.hpp>
 #include <osmium/util/delta.hpp>
+#include <osmium/util/trace.hpp>
 
 #ifdef OSMIUM_WITH_LZ4
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
+#include <protozero/exception.hpp>
 #include <protozero/iterators.hpp>
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
+#include <protozero/varint.hpp>
 
 namespace osmium {
 
@@ -82,6 +95,150 @@ namespace osmium {
             using protozero::data_view;
             using osm_string_len_type = std::pair<const char*, osmium::string_size_type>;
 
+            /**
+             * Decode the packed, zigzag-encoded and delta-encoded sint64
+             * values from a DenseNodes field into the output vector which
+             * will then contain the absolute values.
+             *
+             * This is the hot path of node decoding, so it works on all
+             * values of a group in tight loops instead of going through
+             * the protozero iterators value by value: Runs of eight
+             * single-byte varints (common for ids) are detected with one
+             * word-sized test, longer varints are decoded without bounds
+             * checks as long as enough data remains, and the zigzag
+             * decoding and prefix sum run as separate loops over the
+             * array which the compiler can optimize well.
+             *
+             * @throws protozero::exception If the data is not valid.
+             */
+            inline void decode_dense_delta_sint64(const data_view& data, std::vector<int64_t>& output) {
+                output.clear();
+                output.reserve(data.size());
+
+                const auto* ptr = reinterpret_cast<const uint8_t*>(data.data());
+                const auto* const end = ptr + data.size();
+
+                while (ptr != end) {
+                    if (end - ptr >= 8) {
+                        uint64_t word = 0;
+                        std::memcpy(&word, ptr, sizeof(word));
+                        if ((word & 0x8080808080808080ULL) == 0) {
+                            for (int i = 0; i < 8; ++i) {
+                                output.push_back(static_cast<int64_t>(ptr[i]));
+                            }
+                            ptr += 8;
+                            continue;
+                        }
+                    }
+
+                    uint64_t value = 0;
+                    if (end - ptr >= protozero::max_varint_length) {
+                        unsigned int shift = 0;
+                        uint8_t byte = 0;
+                        do {
+                            byte = *ptr++;
+                            value |= static_cast<uint64_t>(byte & 0x7fU) << shift;
+                            shift += 7;
+                        } while ((byte & 0x80U) && shift < 70);
+                        if (byte & 0x80U) {
+                            throw protozero::varint_too_long_exception{};
+                        }
+                    } else {
+                        const char* cptr = reinterpret_cast<const char*>(ptr);
+                        value = protozero::decode_varint(&cptr, reinterpret_cast<const char*>(end));
+                        ptr = reinterpret_cast<const uint8_t*>(cptr);
+                    }
+                    output.push_back(static_cast<int64_t>(value));
+                }
+
+                for (auto& value : output) {
+                    value = protozero::decode_zigzag64(static_cast<uint64_t>(value));
+                }
+
+                // Wrapping addition like in osmium::DeltaDecode.
+                uint64_t sum = 0;
+                for (auto& value : output) {
+                    sum += static_cast<uint64_t>(value);
+                    value = static_cast<int64_t>(sum);
+                }
+            }
+
+            /**
+             * Memory for uncompressed blob data. Unlike a std::string this
+             * is not zero-filled when it grows, which would be wasted work
+             * because the decompressor overwrites all of it anyway. The
+             * memory is kept when a smaller size is requested.
+             */
+            class uninitialized_buffer {
+
+                std::unique_ptr<char[]> m_data;
+                std::size_t m_capacity = 0;
+
+            public:
+
+                /**
+                 * Get memory for at least size bytes. The content is
+                 * undefined. The pointer is only valid until the next call.
+                 */
+                char* get(const std::size_t size) {
+                    if (size > m_capacity) {
+                        m_data.reset(new char[size]);
+                        m_capacity = size;
+                    }
+                    return m_data.get();
+                }
+
+            }; // class uninitialized_buffer
+
+            /**
+             * Working storage for decoding PBF blobs. Decoding a blob needs
+             * space for the uncompressed data, the string table and the
+             * DenseNodes arrays. Allocating these anew for every blob costs
+             * a lot of time in the allocator and in page faults when many
+             * threads are decoding, so each thread keeps one of these
+             * around (see thread_pbf_decoder_scratch()) and reuses it for
+             * all blobs it decodes. The capacity stays allocated for the
+             * lifetime of the thread.
+             */
+            struct pbf_decoder_scratch {
+
+                // Uncompressed blob data.
+                uninitialized_buffer uncompressed;
+
+                // String table of the current PrimitiveBlock.
+                std::vector<osm_string_len_type> stringtable;
+
+                // Nul-terminated copies of the strings in the string
+                // table. Only filled when a read filter needs them.
+                std::string stringtable_data;
+                std::vector<const char*> stringtable_cstrings;
+
+                // Tags filter of the read filter compiled against the
+                // string table.
+                osmium::StringTableTagsFilter tags_filter;
+
+                // Decoded ids and coordinates of the current DenseNodes.
+                std::vector<int64_t> dense_ids;
+                std::vector<int64_t> dense_lats;
+                std::vector<int64_t> dense_lons;
+
+                // Decoded timestamps of the current DenseNodes. Only
+                // filled when selecting versions at a point in time.
+                std::vector<int64_t> dense_timestamps;
+
+            }; // struct pbf_decoder_scratch
+
+            /**
+             * Get the PBF decoding scratch space of the current thread.
+             *
+             * Only one blob can be decoded at a time with this space, which
+             * is fine because blob decoding doesn't nest.
+             */
+            inline pbf_decoder_scratch& thread_pbf_decoder_scratch() {
+                static thread_local pbf_decoder_scratch scratch;
+                return scratch;
+            }
+
             class PBFPrimitiveBlockDecoder {
 
                 enum {
@@ -89,7 +246,7 @@ namespace osmium {
                 };
 
                 data_view m_data;
-                std::vector<osm_string_len_type> m_stringtable;
+                std::vector<osm_string_len_type>& m_stringtable;
 
                 int64_t m_lon_offset = 0;
                 int64_t m_lat_offset = 0;
@@ -98,10 +255,304 @@ namespace osmium {
 
                 osmium::osm_entity_bits::type m_read_types;
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+                osmium::memory::Buffer m_buffer;
 
                 osmium::io::read_meta m_read_metadata;
 
+                // Decoded ids and coordinates of the current DenseNodes.
+                std::vector<int64_t>& m_dense_ids;
+                std::vector<int64_t>& m_dense_lats;
+                std::vector<int64_t>& m_dense_lons;
+                std::vector<int64_t>& m_dense_timestamps;
+
+                using kv_type = protozero::iterator_range<protozero::pbf_reader::const_uint32_iterator>;
+
+                // Objects not matching this filter are not decoded.
+                const osmium::io::ReadFilter* m_read_filter;
+
+                std::string& m_stringtable_data;
+                std::vector<const char*>& m_stringtable_cstrings;
+
+                osmium::StringTableTagsFilter& m_tags_filter;
+
+                // Get a string from the string table as nul-terminated
+                // C string. The copies are made the first time this is
+                // called for a block.
+                const char* stringtable_cstring(const uint32_t sid) {
+                    if (m_stringtable_cstrings.size() != m_stringtable.size()) {
+                        m_stringtable_data.clear();
+                        for (const auto& str : m_stringtable) {
+                            m_stringtable_data.append(str.first, str.second);
+                            m_stringtable_data += '\0';
+                        }
+                        m_stringtable_cstrings.clear();
+                        const char* ptr = m_stringtable_data.data();
+                        for (const auto& str : m_stringtable) {
+                            m_stringtable_cstrings.push_back(ptr);
+                            ptr += str.second + 1;
+                        }
+                    }
+                    return m_stringtable_cstrings.at(sid);
+                }
+
+                // Match a tag against the tags filter. The results for
+                // each string are cached, so every rule is only evaluated
+                // once per string table entry.
+                bool match_tag(const uint32_t key, const uint32_t value) {
+                    return m_tags_filter(key, stringtable_cstring(key), value, stringtable_cstring(value));
+                }
+
+                bool filters(const osmium::item_type type) const noexcept {
+                    return m_read_filter && m_read_filter->filters(type);
+                }
+
+                bool filters_versions() const noexcept {
+                    return m_read_filter && m_read_filter->filters_versions();
+                }
+
+                static osmium::object_id_type get_object_id(protozero::pbf_message<OSMFormat::Node>& message) {
+                    return message.get_sint64();
+                }
+
+                template <typename TMessage>
+                static osmium::object_id_type get_object_id(protozero::pbf_message<TMessage>& message) {
+                    return message.get_int64();
+                }
+
+                // Get the id and timestamp of a Node, Way, or Relation
+                // message. The timestamp is 0 if there is no metadata.
+                template <typename TMessage>
+                std::pair<osmium::object_id_type, osmium::Timestamp> get_id_and_timestamp(const data_view& data) const {
+                    std::pair<osmium::object_id_type, osmium::Timestamp> result{0, osmium::Timestamp{}};
+
+                    // The id is field 1 in all messages, but it is a
+                    // sint64 in Node and an int64 in Way and Relation.
+                    const auto id_tag = static_cast<TMessage>(1);
+
+                    protozero::pbf_message<TMessage> pbf_object{data};
+                    while (pbf_object.next()) {
+                        switch (pbf_object.tag_and_type()) {
+                            case protozero::tag_and_type(id_tag, protozero::pbf_wire_type::varint):
+                                result.first = get_object_id(pbf_object);
+                                break;
+                            case protozero::tag_and_type(TMessage::optional_Info_info, protozero::pbf_wire_type::length_delimited):
+                                {
+                                    protozero::pbf_message<OSMFormat::Info> pbf_info{pbf_object.get_message()};
+                                    if (pbf_info.next(OSMFormat::Info::optional_int64_timestamp, protozero::pbf_wire_type::varint)) {
+                                        result.second = osmium::Timestamp{pbf_info.get_int64() * m_date_factor / 1000};
+                                    }
+                                }
+                                break;
+                            default:
+                                pbf_object.skip();
+                        }
+                    }
+
+                    return result;
+                }
+
+                /**
+                 * Check whether the version of a Node, Way, or Relation
+                 * message has to be decoded when only the latest versions
+                 * (at some point in time) are read. It is not if its
+                 * timestamp is after the point in time or if the next
+                 * object in the group is a later version of the same
+                 * object that is not. The group is copied so that looking
+                 * at the next object doesn't move it.
+                 */
+                template <typename TMessage>
+                bool keep_version(const data_view& data, protozero::pbf_message<OSMFormat::PrimitiveGroup> group, const OSMFormat::PrimitiveGroup tag) const {
+                    if (!filters_versions()) {
+                        return true;
+                    }
+
+                    const auto object = get_id_and_timestamp<TMessage>(data);
+                    if (!m_read_filter->match_timestamp(object.second)) {
+                        return false;
+                    }
+
+                    if (!group.next(tag, protozero::pbf_wire_type::length_delimited)) {
+                        return true;
+                    }
+
+                    const auto next = get_id_and_timestamp<TMessage>(group.get_view());
+                    return next.first != object.first || !m_read_filter->match_timestamp(next.second);
+                }
+
+                /**
+                 * Check whether the version of dense node n has to be
+                 * decoded. See keep_version(). The timestamps are only
+                 * taken into account if they have been decoded into
+                 * m_dense_timestamps.
+                 */
+                bool keep_dense_version(const std::size_t n) const noexcept {
+                    const bool has_timestamps = m_dense_timestamps.size() == m_dense_ids.size();
+                    if (has_timestamps && !m_read_filter->match_timestamp(osmium::Timestamp{m_dense_timestamps[n]})) {
+                        return false;
+                    }
+
+                    const auto next = n + 1;
+                    if (next == m_dense_ids.size() || m_dense_ids[next] != m_dense_ids[n]) {
+                        return true;
+                    }
+
+                    return has_timestamps && !m_read_filter->match_timestamp(osmium::Timestamp{m_dense_timestamps[next]});
+                }
+
+                bool tags_match(const kv_type& keys, const kv_type& vals) {
+                    auto vit = vals.begin();
+                    for (const auto key : keys) {
+                        if (vit == vals.end()) {
+                            // this is against the spec, must have same number of elements
+                            throw osmium::pbf_error{"PBF format error"};
+                        }
+                        if (match_tag(key, *vit++)) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                /**
+                 * Check whether a Node message must be decoded. This only
+                 * looks at the id, location, and tags and skips everything
+                 * else, so rejected nodes are never built.
+                 */
+                bool keep_node(const data_view& data) {
+                    if (!filters(osmium::item_type::node)) {
+                        return true;
+                    }
+
+                    osmium::object_id_type id = 0;
+                    kv_type keys;
+                    kv_type vals;
+                    int64_t lon = std::numeric_limits<int64_t>::max();
+                    int64_t lat = std::numeric_limits<int64_t>::max();
+
+                    protozero::pbf_message<OSMFormat::Node> pbf_node{data};
+                    while (pbf_node.next()) {
+                        switch (pbf_node.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                keys = pbf_node.get_packed_uint32();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                                vals = pbf_node.get_packed_uint32();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lat, protozero::pbf_wire_type::varint):
+                                lat = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lon, protozero::pbf_wire_type::varint):
+                                lon = pbf_node.get_sint64();
+                                break;
+                            default:
+                                pbf_node.skip();
+                        }
+                    }
+
+                    if (m_read_filter->filters_ids(osmium::item_type::node) &&
+                        !m_read_filter->match_id(osmium::item_type::node, id)) {
+                        return false;
+                    }
+
+                    if (m_read_filter->filters_locations()) {
+                        if (lon == std::numeric_limits<int64_t>::max() ||
+                            lat == std::numeric_limits<int64_t>::max() ||
+                            !m_read_filter->match_location(osmium::Location{convert_pbf_lon(lon), convert_pbf_lat(lat)})) {
+                            return false;
+                        }
+                    }
+
+                    return !m_read_filter->filters_tags(osmium::item_type::node) || tags_match(keys, vals);
+                }
+
+                /**
+                 * Check whether a Way or Relation message must be decoded.
+                 * This only looks at the id and tags and skips everything
+                 * else, so rejected objects are never built.
+                 */
+                template <typename TMessage>
+                bool keep_object(const data_view& data, const osmium::item_type type) {
+                    if (!filters(type)) {
+                        return true;
+                    }
+
+                    osmium::object_id_type id = 0;
+                    kv_type keys;
+                    kv_type vals;
+
+                    protozero::pbf_message<TMessage> pbf_object{data};
+                    while (pbf_object.next()) {
+                        switch (pbf_object.tag_and_type()) {
+                            case protozero::tag_and_type(TMessage::required_int64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_object.get_int64();
+                                break;
+                            case protozero::tag_and_type(TMessage::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                keys = pbf_object.get_packed_uint32();
+                                break;
+                            case protozero::tag_and_type(TMessage::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                                vals = pbf_object.get_packed_uint32();
+                                break;
+                            default:
+                                pbf_object.skip();
+                        }
+                    }
+
+                    if (m_read_filter->filters_ids(type) && !m_read_filter->match_id(type, id)) {
+                        return false;
+                    }
+
+                    return !m_read_filter->filters_tags(type) || tags_match(keys, vals);
+                }
+
+                /**
+                 * Check whether dense node n with its tags starting at
+                 * tag_it must be decoded. The iterator is not moved.
+                 */
+                bool keep_dense_node(const std::size_t n, const protozero::pbf_reader::const_int32_iterator tag_it, const protozero::pbf_reader::const_int32_iterator last) {
+                    if (m_read_filter->filters_ids(osmium::item_type::node) &&
+                        !m_read_filter->match_id(osmium::item_type::node, m_dense_ids[n])) {
+                        return false;
+                    }
+
+                    if (m_read_filter->filters_locations() &&
+                        !m_read_filter->match_location(osmium::Location{convert_pbf_lon(m_dense_lons[n]), convert_pbf_lat(m_dense_lats[n])})) {
+                        return false;
+                    }
+
+                    return !m_read_filter->filters_tags(osmium::item_type::node) || dense_node_tags_match(tag_it, last);
+                }
+
+                /**
+                 * Check whether the tags of a dense node starting at it
+                 * match the tags filter.
+                 */
+                bool dense_node_tags_match(protozero::pbf_reader::const_int32_iterator it, const protozero::pbf_reader::const_int32_iterator last) {
+                    while (it != last && *it != 0) {
+                        const auto key = static_cast<uint32_t>(*it++);
+                        if (it == last) {
+                            throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
+                        }
+                        if (match_tag(key, static_cast<uint32_t>(*it++))) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                // Move the iterator behind the tags of the current
+                // dense node.
+                static void skip_dense_node_tags(protozero::pbf_reader::const_int32_iterator& it, const protozero::pbf_reader::const_int32_iterator last) {
+                    while (it != last && *it != 0) {
+                        ++it;
+                    }
+                    if (it != last) {
+                        ++it;
+                    }
+                }
+
                 void decode_stringtable(const data_view& data) {
                     if (!m_stringtable.empty()) {
                         throw osmium::pbf_error{"more than one stringtable in pbf file"};
@@ -142,7 +593,15 @@ namespace osmium {
                     }
                 }
 
+                // The decoding functions are instantiated separately for
+                // reading with and without metadata, so that the checks
+                // for the metadata are not done for every object.
+                template <osmium::io::read_meta TReadMeta>
                 void decode_primitive_block_data() {
+                    // Types of objects decoded, to mark the buffer if
+                    // there is only one.
+                    osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
                     protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
                     while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
                         protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
@@ -150,36 +609,52 @@ namespace osmium {
                             switch (pbf_primitive_group.tag_and_type()) {
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
                                     if (m_read_types & osmium::osm_entity_bits::node) {
-                                        decode_node(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                        const auto object_data = pbf_primitive_group.get_view();
+                                        if (keep_node(object_data) &&
+                                            keep_version<OSMFormat::Node>(object_data, pbf_primitive_group, OSMFormat::PrimitiveGroup::repeated_Node_nodes)) {
+                                            decode_node<TReadMeta>(object_data);
+                                            m_buffer.commit();
+                                        }
+                                        types |= osmium::osm_entity_bits::node;
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
                                     if (m_read_types & osmium::osm_entity_bits::node) {
-                                        if (m_read_metadata == osmium::io::read_meta::yes) {
+                                        if (TReadMeta == osmium::io::read_meta::yes) {
                                             decode_dense_nodes(pbf_primitive_group.get_view());
                                         } else {
                                             decode_dense_nodes_without_metadata(pbf_primitive_group.get_view());
                                         }
                                         m_buffer.commit();
+                                        types |= osmium::osm_entity_bits::node;
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
                                     if (m_read_types & osmium::osm_entity_bits::way) {
-                                        decode_way(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                        const auto object_data = pbf_primitive_group.get_view();
+                                        if (keep_object<OSMFormat::Way>(object_data, osmium::item_type::way) &&
+                                            keep_version<OSMFormat::Way>(object_data, pbf_primitive_group, OSMFormat::PrimitiveGroup::repeated_Way_ways)) {
+                                            decode_way<TReadMeta>(object_data);
+                                            m_buffer.commit();
+                                        }
+                                        types |= osmium::osm_entity_bits::way;
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited):
                                     if (m_read_types & osmium::osm_entity_bits::relation) {
-                                        decode_relation(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                        const auto object_data = pbf_primitive_group.get_view();
+                                        if (keep_object<OSMFormat::Relation>(object_data, osmium::item_type::relation) &&
+                                            keep_version<OSMFormat::Relation>(object_data, pbf_primitive_group, OSMFormat::PrimitiveGroup::repeated_Relation_relations)) {
+                                            decode_relation<TReadMeta>(object_data);
+                                            m_buffer.commit();
+                                        }
+                                        types |= osmium::osm_entity_bits::relation;
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
@@ -189,6 +664,20 @@ namespace osmium {
                             }
                         }
                     }
+
+                    switch (types) {
+                        case osmium::osm_entity_bits::node:
+                            m_buffer.set_content_type(osmium::item_type::node);
+                            break;
+                        case osmium::osm_entity_bits::way:
+                            m_buffer.set_content_type(osmium::item_type::way);
+                            break;
+                        case osmium::osm_entity_bits::relation:
+                            m_buffer.set_content_type(osmium::item_type::relation);
+                            break;
+                        default:
+                            break;
+                    }
                 }
 
                 osm_string_len_type decode_info(const data_view& data, osmium::OSMObject& object) {
@@ -245,22 +734,32 @@ namespace osmium {
                     return user;
                 }
 
-                using kv_type = protozero::iterator_range<protozero::pbf_reader::const_uint32_iterator>;
-
                 void build_tag_list(osmium::builder::Builder& parent, const kv_type& keys, const kv_type& vals) {
-                    if (!keys.empty()) {
-                        osmium::builder::TagListBuilder builder{parent};
-                        auto kit = keys.begin();
-                        auto vit = vals.begin();
-                        while (kit != keys.end()) {
-                            if (vit == vals.end()) {
-                                // this is against the spec, must have same number of elements
-                                throw osmium::pbf_error{"PBF format error"};
-                            }
-                            const auto& k = m_stringtable.at(*kit++);
-                            const auto& v = m_stringtable.at(*vit++);
-                            builder.add_tag(k.first, k.second, v.first, v.second);
+                    if (keys.empty()) {
+                        return;
+                    }
+
+                    // First pass: check the tags and get their size, so
+                    // that the space for all of them can be reserved at
+                    // once.
+                    std::size_t size = 0;
+                    auto vit = vals.begin();
+                    for (const auto key : keys) {
+                        if (vit == vals.end()) {
+                            // this is against the spec, must have same number of elements
+                            throw osmium::pbf_error{"PBF format error"};
                         }
+                        size += osmium::builder::TagListBuilder::tag_size(m_stringtable.at(key).second,
+                                                                          m_stringtable.at(*vit++).second);
+                    }
+
+                    osmium::builder::TagListBuilder builder{parent};
+                    char* target = builder.reserve_tags(size);
+                    vit = vals.begin();
+                    for (const auto key : keys) {
+                        const auto& k = m_stringtable.at(key);
+                        const auto& v = m_stringtable.at(*vit++);
+                        target = osmium::builder::TagListBuilder::write_tag(target, k.first, k.second, v.first, v.second);
                     }
                 }
 
@@ -272,6 +771,7 @@ namespace osmium {
                     return int32_t((c * m_granularity + m_lat_offset) / resolution_convert);
                 }
 
+                template <osmium::io::read_meta TReadMeta>
                 void decode_node(const data_view& data) {
                     osmium::builder::NodeBuilder builder{m_buffer};
                     osmium::Node& node = builder.object();
@@ -296,7 +796,7 @@ namespace osmium {
                                 vals = pbf_node.get_packed_uint32();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Node::optional_Info_info, protozero::pbf_wire_type::length_delimited):
-                                if (m_read_metadata == osmium::io::read_meta::yes) {
+                                if (TReadMeta == osmium::io::read_meta::yes) {
                                     user = decode_info(pbf_node.get_view(), builder.object());
                                 } else {
                                     pbf_node.skip();
@@ -324,11 +824,14 @@ namespace osmium {
                         });
                     }
 
-                    builder.set_user(user.first, user.second);
+                    if (TReadMeta == osmium::io::read_meta::yes) {
+                        builder.set_user(user.first, user.second);
+                    }
 
                     build_tag_list(builder, keys, vals);
                 }
 
+                template <osmium::io::read_meta TReadMeta>
                 void decode_way(const data_view& data) {
                     osmium::builder::WayBuilder builder{m_buffer};
 
@@ -353,7 +856,7 @@ namespace osmium {
                                 vals = pbf_way.get_packed_uint32();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Way::optional_Info_info, protozero::pbf_wire_type::length_delimited):
-                                if (m_read_metadata == osmium::io::read_meta::yes) {
+                                if (TReadMeta == osmium::io::read_meta::yes) {
                                     user = decode_info(pbf_way.get_view(), builder.object());
                                 } else {
                                     pbf_way.skip();
@@ -373,24 +876,29 @@ namespace osmium {
                         }
                     }
 
-                    builder.set_user(user.first, user.second);
+                    if (TReadMeta == osmium::io::read_meta::yes) {
+                        builder.set_user(user.first, user.second);
+                    }
 
                     if (!refs.empty()) {
                         osmium::builder::WayNodeListBuilder wnl_builder{builder};
                         osmium::DeltaDecode<int64_t> ref;
                         if (lats.empty()) {
+                            osmium::NodeRef* node_ref = wnl_builder.add_node_refs(refs.size());
                             for (const auto ref_value : refs) {
-                                wnl_builder.add_node_ref(ref.update(ref_value));
+                                (node_ref++)->set_ref(ref.update(ref_value));
                             }
                         } else {
                             osmium::DeltaDecode<int64_t> lon;
                             osmium::DeltaDecode<int64_t> lat;
-                            while (!refs.empty() && !lons.empty() && !lats.empty()) {
-                                wnl_builder.add_node_ref(
+                            const auto count = std::min(refs.size(), std::min(lons.size(), lats.size()));
+                            osmium::NodeRef* node_ref = wnl_builder.add_node_refs(count);
+                            for (std::size_t i = 0; i < count; ++i) {
+                                *node_ref++ = osmium::NodeRef{
                                     ref.update(refs.front()),
                                     osmium::Location{convert_pbf_lon(lon.update(lons.front())),
                                                      convert_pbf_lat(lat.update(lats.front()))}
-                                );
+                                };
                                 refs.drop_front();
                                 lons.drop_front();
                                 lats.drop_front();
@@ -401,6 +909,7 @@ namespace osmium {
                     build_tag_list(builder, keys, vals);
                 }
 
+                template <osmium::io::read_meta TReadMeta>
                 void decode_relation(const data_view& data) {
                     osmium::builder::RelationBuilder builder{m_buffer};
 
@@ -425,7 +934,7 @@ namespace osmium {
                                 vals = pbf_relation.get_packed_uint32();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Relation::optional_Info_info, protozero::pbf_wire_type::length_delimited):
-                                if (m_read_metadata == osmium::io::read_meta::yes) {
+                                if (TReadMeta == osmium::io::read_meta::yes) {
                                     user = decode_info(pbf_relation.get_view(), builder.object());
                                 } else {
                                     pbf_relation.skip();
@@ -445,19 +954,35 @@ namespace osmium {
                         }
                     }
 
-                    builder.set_user(user.first, user.second);
+                    if (TReadMeta == osmium::io::read_meta::yes) {
+                        builder.set_user(user.first, user.second);
+                    }
 
                     if (!refs.empty()) {
                         osmium::builder::RelationMemberListBuilder rml_builder{builder};
-                        osmium::DeltaDecode<int64_t> ref;
-                        while (!roles.empty() && !refs.empty() && !types.empty()) {
-                            const auto& r = m_stringtable.at(roles.front());
-                            const int type = types.front();
+
+                        // First pass: check the members and get their size,
+                        // so that the space for all of them can be reserved
+                        // at once.
+                        const auto count = std::min(refs.size(), std::min(roles.size(), types.size()));
+                        std::size_t size = 0;
+                        auto rit = roles.begin();
+                        auto tit = types.begin();
+                        for (std::size_t i = 0; i < count; ++i) {
+                            const int type = *tit++;
                             if (type < 0 || type > 2) {
                                 throw osmium::pbf_error{"unknown relation member type"};
                             }
-                            rml_builder.add_member(
-                                osmium::item_type(type + 1),
+                            size += osmium::builder::RelationMemberListBuilder::member_size(m_stringtable.at(*rit++).second);
+                        }
+
+                        unsigned char* target = rml_builder.reserve_members(size);
+                        osmium::DeltaDecode<int64_t> ref;
+                        for (std::size_t i = 0; i < count; ++i) {
+                            const auto& r = m_stringtable.at(roles.front());
+                            target = osmium::builder::RelationMemberListBuilder::write_member(
+                                target,
+                                osmium::item_type(types.front() + 1),
                                 ref.update(refs.front()),
                                 r.first,
                                 r.second
@@ -472,14 +997,25 @@ namespace osmium {
                 }
 
                 void build_tag_list_from_dense_nodes(osmium::builder::NodeBuilder& builder, protozero::pbf_reader::const_int32_iterator& it, protozero::pbf_reader::const_int32_iterator last) {
-                    osmium::builder::TagListBuilder tl_builder{builder};
+                    // First pass: check the tags and get their size, so
+                    // that the space for all of them can be reserved at
+                    // once.
+                    const auto first = it;
+                    std::size_t size = 0;
                     while (it != last && *it != 0) {
                         const auto& k = m_stringtable.at(*it++);
                         if (it == last) {
                             throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
                         }
-                        const auto& v = m_stringtable.at(*it++);
-                        tl_builder.add_tag(k.first, k.second, v.first, v.second);
+                        size += osmium::builder::TagListBuilder::tag_size(k.second, m_stringtable.at(*it++).second);
+                    }
+
+                    osmium::builder::TagListBuilder tl_builder{builder};
+                    char* target = tl_builder.reserve_tags(size);
+                    for (auto tit = first; tit != it;) {
+                        const auto& k = m_stringtable.at(*tit++);
+                        const auto& v = m_stringtable.at(*tit++);
+                        target = osmium::builder::TagListBuilder::write_tag(target, k.first, k.second, v.first, v.second);
                     }
 
                     if (it != last) {
@@ -487,10 +1023,42 @@ namespace osmium {
                     }
                 }
 
+                // Do any of the ids in m_dense_ids match the id conditions
+                // of the read filter?
+                bool any_dense_id_matches() const noexcept {
+                    if (!m_read_filter || !m_read_filter->filters_ids(osmium::item_type::node)) {
+                        return true;
+                    }
+                    return std::any_of(m_dense_ids.cbegin(), m_dense_ids.cend(), [this](const int64_t id) {
+                        return m_read_filter->match_id(osmium::item_type::node, id);
+                    });
+                }
+
+                // Decode the ids and coordinates of DenseNodes. The ids
+                // are decoded first. If none of them matches the read
+                // filter, nothing else is decoded and false is returned.
+                bool decode_dense_coordinates(const data_view& ids, const data_view& lats, const data_view& lons) {
+                    decode_dense_delta_sint64(ids, m_dense_ids);
+                    if (!any_dense_id_matches()) {
+                        return false;
+                    }
+
+                    decode_dense_delta_sint64(lats, m_dense_lats);
+                    decode_dense_delta_sint64(lons, m_dense_lons);
+
+                    if (m_dense_lats.size() < m_dense_ids.size() ||
+                        m_dense_lons.size() < m_dense_ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+
+                    return true;
+                }
+
                 void decode_dense_nodes_without_metadata(const data_view& data) {
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> ids;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lats;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lons;
+                    data_view ids;
+                    data_view lats;
+                    data_view lons;
 
                     protozero::iterator_range<protozero::pbf_reader::const_int32_iterator>  tags;
 
@@ -498,13 +1066,13 @@ namespace osmium {
                     while (pbf_dense_nodes.next()) {
                         switch (pbf_dense_nodes.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
-                                ids = pbf_dense_nodes.get_packed_sint64();
+                                ids = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
-                                lats = pbf_dense_nodes.get_packed_sint64();
+                                lats = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
-                                lons = pbf_dense_nodes.get_packed_sint64();
+                                lons = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
                                 tags = pbf_dense_nodes.get_packed_int32();
@@ -514,33 +1082,32 @@ namespace osmium {
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    if (!decode_dense_coordinates(ids, lats, lons)) {
+                        return;
+                    }
+
+                    m_dense_timestamps.clear();
 
                     auto tag_it = tags.begin();
-
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                    const bool filter_nodes = filters(osmium::item_type::node);
+                    const bool filter_versions = filters_versions();
+
+                    for (std::size_t n = 0; n < m_dense_ids.size(); ++n) {
+                        if ((filter_nodes && !keep_dense_node(n, tag_it, tags.end())) ||
+                            (filter_versions && !keep_dense_version(n))) {
+                            skip_dense_node_tags(tag_it, tags.end());
+                            continue;
                         }
 
                         {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.front()));
-                            ids.drop_front();
+                            node.set_id(m_dense_ids[n]);
 
-                            const auto lon = dense_longitude.update(lons.front());
-                            lons.drop_front();
-                            const auto lat = dense_latitude.update(lats.front());
-                            lats.drop_front();
                             builder.object().set_location(osmium::Location{
-                                    convert_pbf_lon(lon),
-                                    convert_pbf_lat(lat)
+                                    convert_pbf_lon(m_dense_lons[n]),
+                                    convert_pbf_lat(m_dense_lats[n])
                             });
 
                             if (tag_it != tags.end()) {
@@ -555,9 +1122,9 @@ namespace osmium {
                 void decode_dense_nodes(const data_view& data) {
                     bool has_info = false;
 
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> ids;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lats;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lons;
+                    data_view ids;
+                    data_view lats;
+                    data_view lons;
 
                     protozero::iterator_range<protozero::pbf_reader::const_int32_iterator>  tags;
 
@@ -572,7 +1139,7 @@ namespace osmium {
                     while (pbf_dense_nodes.next()) {
                         switch (pbf_dense_nodes.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
-                                ids = pbf_dense_nodes.get_packed_sint64();
+                                ids = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::optional_DenseInfo_denseinfo, protozero::pbf_wire_type::length_delimited):
                                 {
@@ -605,10 +1172,10 @@ namespace osmium {
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
-                                lats = pbf_dense_nodes.get_packed_sint64();
+                                lats = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
-                                lons = pbf_dense_nodes.get_packed_sint64();
+                                lons = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
                                 tags = pbf_dense_nodes.get_packed_int32();
@@ -618,21 +1185,60 @@ namespace osmium {
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    if (!decode_dense_coordinates(ids, lats, lons)) {
+                        return;
+                    }
+
                     osmium::DeltaDecode<int64_t> dense_uid;
                     osmium::DeltaDecode<int64_t> dense_user_sid;
                     osmium::DeltaDecode<int64_t> dense_changeset;
                     osmium::DeltaDecode<int64_t> dense_timestamp;
 
+                    // The timestamps are needed up front to find the
+                    // versions current at the point in time.
+                    m_dense_timestamps.clear();
+                    const bool filter_versions = filters_versions();
+                    if (filter_versions && has_info && m_read_filter->point_in_time() != osmium::end_of_time()) {
+                        osmium::DeltaDecode<int64_t> timestamp;
+                        for (const auto value : timestamps) {
+                            m_dense_timestamps.push_back(timestamp.update(value) * m_date_factor / 1000);
+                        }
+                    }
+
                     auto tag_it = tags.begin();
+                    const bool filter_nodes = filters(osmium::item_type::node);
 
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                    for (std::size_t n = 0; n < m_dense_ids.size(); ++n) {
+                        if ((filter_nodes && !keep_dense_node(n, tag_it, tags.end())) ||
+                            (filter_versions && !keep_dense_version(n))) {
+                            // The metadata is delta encoded, so it has to
+                            // be decoded even for nodes that are skipped.
+                            if (has_info) {
+                                if (!versions.empty()) {
+                                    versions.drop_front();
+                                }
+                                if (!changesets.empty()) {
+                                    dense_changeset.update(changesets.front());
+                                    changesets.drop_front();
+                                }
+                                if (!timestamps.empty()) {
+                                    dense_timestamp.update(timestamps.front());
+                                    timestamps.drop_front();
+                                }
+                                if (!uids.empty()) {
+                                    dense_uid.update(uids.front());
+                                    uids.drop_front();
+                                }
+                                if (!visibles.empty()) {
+                                    visibles.drop_front();
+                                }
+                                if (!user_sids.empty()) {
+                                    dense_user_sid.update(user_sids.front());
+                                    user_sids.drop_front();
+                                }
+                            }
+                            skip_dense_node_tags(tag_it, tags.end());
+                            continue;
                         }
 
                         bool visible = true;
@@ -641,8 +1247,7 @@ namespace osmium {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.front()));
-                            ids.drop_front();
+                            node.set_id(m_dense_ids[n]);
 
                             if (has_info) {
                                 if (!versions.empty()) {
@@ -698,14 +1303,10 @@ namespace osmium {
 
                             // even if the node isn't visible, there's still a record
                             // of its lat/lon in the dense arrays.
-                            const auto lon = dense_longitude.update(lons.front());
-                            lons.drop_front();
-                            const auto lat = dense_latitude.update(lats.front());
-                            lats.drop_front();
                             if (visible) {
                                 builder.object().set_location(osmium::Location{
-                                        convert_pbf_lon(lon),
-                                        convert_pbf_lat(lat)
+                                        convert_pbf_lon(m_dense_lons[n]),
+                                        convert_pbf_lat(m_dense_lats[n])
                                 });
                             }
 
@@ -719,10 +1320,44 @@ namespace osmium {
 
             public:
 
-                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                /**
+                 * Construct a decoder for a PrimitiveBlock. The decoder
+                 * uses the scratch space for the string table and other
+                 * temporary data, so only one decoder can use the same
+                 * scratch space at a time.
+                 *
+                 * If a buffer pool is given, the output buffer is taken
+                 * from it. In that case the buffer grows as needed to hold
+                 * the whole block instead of being split up into nested
+                 * buffers, so that recycled buffers will usually be large
+                 * enough for the next block. The same happens if
+                 * single_buffer is set.
+                 *
+                 * If a read filter is given, objects not matching it are
+                 * not decoded.
+                 */
+                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, pbf_decoder_scratch& scratch, osmium::memory::BufferPool* buffer_pool = nullptr, const osmium::io::ReadFilter* read_filter = nullptr, bool single_buffer = false) :
                     m_data(data),
+                    m_stringtable(scratch.stringtable),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_buffer(buffer_pool ? buffer_pool->get(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes)
+                                         : osmium::memory::Buffer{initial_buffer_size, single_buffer ? osmium::memory::Buffer::auto_grow::yes
+                                                                                                     : osmium::memory::Buffer::auto_grow::internal}),
+                    m_read_metadata(read_metadata),
+                    m_dense_ids(scratch.dense_ids),
+                    m_dense_lats(scratch.dense_lats),
+                    m_dense_lons(scratch.dense_lons),
+                    m_dense_timestamps(scratch.dense_timestamps),
+                    m_read_filter(read_filter),
+                    m_stringtable_data(scratch.stringtable_data),
+                    m_stringtable_cstrings(scratch.stringtable_cstrings),
+                    m_tags_filter(scratch.tags_filter) {
+                    m_stringtable.clear();
+                    m_stringtable_cstrings.clear();
+                }
+
+                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                    PBFPrimitiveBlockDecoder(data, read_types, read_metadata, thread_pbf_decoder_scratch()) {
                 }
 
                 PBFPrimitiveBlockDecoder(const PBFPrimitiveBlockDecoder&) = delete;
@@ -736,7 +1371,14 @@ namespace osmium {
                 osmium::memory::Buffer operator()() {
                     try {
                         decode_primitive_block_metadata();
-                        decode_primitive_block_data();
+                        if (m_read_filter) {
+                            m_tags_filter.reset(m_read_filter->tags_filter(), m_stringtable.size());
+                        }
+                        if (m_read_metadata == osmium::io::read_meta::yes) {
+                            decode_primitive_block_data<osmium::io::read_meta::yes>();
+                        } else {
+                            decode_primitive_block_data<osmium::io::read_meta::no>();
+                        }
                     } catch (const std::out_of_range&) {
                         throw osmium::pbf_error{"string id out of range"};
                     }
@@ -746,7 +1388,7 @@ namespace osmium {
 
             }; // class PBFPrimitiveBlockDecoder
 
-            inline data_view decode_blob(const std::string& blob_data, std::string& output) {
+            inline data_view decode_blob(const data_view& blob_data, uninitialized_buffer& output) {
                 int32_t raw_size = 0;
                 protozero::data_view compressed_data;
                 pbf_compression use_compression = pbf_compression::none;
@@ -783,31 +1425,36 @@ namespace osmium {
                             throw osmium::pbf_error{"lz4 blobs not supported"};
 #endif
                         case protozero::tag_and_type(FileFormat::Blob::optional_bytes_zstd_data, protozero::pbf_wire_type::length_delimited):
+#ifdef OSMIUM_WITH_ZSTD
+                            use_compression = pbf_compression::zstd;
+                            compressed_data = pbf_blob.get_view();
+                            break;
+#else
                             throw osmium::pbf_error{"zstd blobs not supported"};
+#endif
                         default:
                             throw osmium::pbf_error{"unknown compression"};
                     }
                 }
 
                 if (!compressed_data.empty() && raw_size != 0) {
+                    const auto input_size = static_cast<unsigned long>(compressed_data.size()); // NOLINT(google-runtime-int)
+                    const auto output_size = static_cast<unsigned long>(raw_size); // NOLINT(google-runtime-int)
+                    char* const data = output.get(output_size);
                     switch (use_compression) {
                         case pbf_compression::none:
                             break;
                         case pbf_compression::zlib:
-                            return osmium::io::detail::zlib_uncompress_string(
-                                compressed_data.data(),
-                                static_cast<unsigned long>(compressed_data.size()), // NOLINT(google-runtime-int)
-                                static_cast<unsigned long>(raw_size), // NOLINT(google-runtime-int)
-                                output
-                            );
+                            return data_view{data, osmium::io::detail::zlib_uncompress(compressed_data.data(), input_size, output_size, data)};
                         case pbf_compression::lz4:
 #ifdef OSMIUM_WITH_LZ4
-                            return osmium::io::detail::lz4_uncompress_string(
-                                compressed_data.data(),
-                                static_cast<unsigned long>(compressed_data.size()), // NOLINT(google-runtime-int)
-                                static_cast<unsigned long>(raw_size), // NOLINT(google-runtime-int)
-                                output
-                            );
+                            return data_view{data, osmium::io::detail::lz4_uncompress(compressed_data.data(), input_size, output_size, data)};
+#else
+                            break;
+#endif
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            return data_view{data, osmium::io::detail::zstd_uncompress(compressed_data.data(), input_size, output_size, data)};
 #else
                             break;
 #endif
@@ -858,6 +1505,43 @@ namespace osmium {
                     return box;
             }
 
+            // Decode optional features "Count.Node=N", "MaxId.Way=N" etc.
+            // with the object counts and max ids into the header. Returns
+            // false if this is not such a feature.
+            inline bool decode_object_count_feature(osmium::io::Header& header, const std::string& feature) {
+                const auto dot = feature.find('.');
+                const auto eq = feature.find('=');
+                if (dot == std::string::npos || eq == std::string::npos || eq < dot) {
+                    return false;
+                }
+                const std::string kind{feature.substr(0, dot)};
+                if (kind != "Count" && kind != "MaxId") {
+                    return false;
+                }
+                const std::string name{feature.substr(dot + 1, eq - dot - 1)};
+                osmium::item_type type;
+                if (name == "Node") {
+                    type = osmium::item_type::node;
+                } else if (name == "Way") {
+                    type = osmium::item_type::way;
+                } else if (name == "Relation") {
+                    type = osmium::item_type::relation;
+                } else {
+                    return false;
+                }
+                const std::string value{feature.substr(eq + 1)};
+                if (value.empty() || value.size() > 18 || value.find_first_not_of("0123456789") != std::string::npos) {
+                    return false;
+                }
+                const auto number = std::stoull(value);
+                if (kind == "Count") {
+                    header.set_object_count(type, number);
+                } else {
+                    header.set_max_object_id(type, static_cast<osmium::object_id_type>(number));
+                }
+                return true;
+            }
+
             inline osmium::io::Header decode_header_block(const data_view& data) {
                 osmium::io::Header header;
                 int i = 0;
@@ -889,6 +1573,8 @@ namespace osmium {
                                 header.set("pbf_optional_feature_" + std::to_string(i++), opt);
                                 if (opt == "Sort.Type_then_ID") {
                                     header.set("sorting", "Type_then_ID");
+                                } else {
+                                    decode_object_count_feature(header, opt);
                                 }
                             }
                             break;
@@ -923,30 +1609,442 @@ namespace osmium {
              * @returns Header object
              * @throws osmium::pbf_error If there was a parsing error
              */
-            inline osmium::io::Header decode_header(const std::string& header_block_data) {
-                std::string output;
+            inline osmium::io::Header decode_header(const data_view& header_block_data) {
+                uninitialized_buffer output;
 
                 return decode_header_block(decode_blob(header_block_data, output));
             }
 
+            inline osmium::io::Header decode_header(const std::string& header_block_data) {
+                return decode_header(data_view{header_block_data.data(), header_block_data.size()});
+            }
+
+            // The size of the BlobHeader is encoded in 4 bytes in network
+            // byte order.
+            inline uint32_t decode_blob_header_size(const char* data) noexcept {
+                const auto* d = reinterpret_cast<const unsigned char*>(data);
+                return (static_cast<uint32_t>(d[3])) |
+                       (static_cast<uint32_t>(d[2]) <<  8U) |
+                       (static_cast<uint32_t>(d[1]) << 16U) |
+                       (static_cast<uint32_t>(d[0]) << 24U);
+            }
+
+            /**
+             * Hints about the contents of a Blob written by Osmium into the
+             * BlobHeader.indexdata field. They allow skipping Blobs without
+             * decompressing them.
+             */
+            struct pbf_blob_hints {
+
+                /// Were valid hints found in the BlobHeader?
+                bool valid = false;
+
+                /// Object types in the Blob.
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+                /// Does the Blob contain any nodes with tags?
+                bool has_tagged_nodes = true;
+
+                /// Are first_id, last_id, and sorted set?
+                bool has_ids = false;
+
+                /// Id of the first object in the Blob.
+                osmium::object_id_type first_id = 0;
+
+                /// Id of the last object in the Blob.
+                osmium::object_id_type last_id = 0;
+
+                /**
+                 * Are the objects in the Blob ordered by type and id
+                 * without duplicate ids? In that case the first object is
+                 * of the smallest type in types and the last one of the
+                 * largest type.
+                 */
+                bool sorted = false;
+
+            }; // struct pbf_blob_hints
+
+            /**
+             * Decode the hints in the BlobHeader.indexdata field. Other
+             * programs might use this field for something else, so
+             * anything that doesn't look like hints written by Osmium
+             * results in invalid (empty) hints.
+             */
+            inline pbf_blob_hints decode_blob_hints(const data_view& data) {
+                pbf_blob_hints hints;
+                bool is_osmium = false;
+
+                try {
+                    protozero::pbf_message<OsmiumFormat::BlobHints> pbf_hints{data};
+                    while (pbf_hints.next()) {
+                        switch (pbf_hints.tag_and_type()) {
+                            case protozero::tag_and_type(OsmiumFormat::BlobHints::required_string_generator, protozero::pbf_wire_type::length_delimited):
+                                is_osmium = pbf_hints.get_view() == data_view{"osmium", 6};
+                                break;
+                            case protozero::tag_and_type(OsmiumFormat::BlobHints::optional_uint32_types, protozero::pbf_wire_type::varint):
+                                hints.types = static_cast<osmium::osm_entity_bits::type>(pbf_hints.get_uint32() & osmium::osm_entity_bits::nwr);
+                                break;
+                            case protozero::tag_and_type(OsmiumFormat::BlobHints::optional_bool_has_tagged_nodes, protozero::pbf_wire_type::varint):
+                                hints.has_tagged_nodes = pbf_hints.get_bool();
+                                break;
+                            case protozero::tag_and_type(OsmiumFormat::BlobHints::optional_sint64_first_id, protozero::pbf_wire_type::varint):
+                                hints.first_id = pbf_hints.get_sint64();
+                                hints.has_ids = true;
+                                break;
+                            case protozero::tag_and_type(OsmiumFormat::BlobHints::optional_sint64_last_id, protozero::pbf_wire_type::varint):
+                                hints.last_id = pbf_hints.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OsmiumFormat::BlobHints::optional_bool_sorted, protozero::pbf_wire_type::varint):
+                                hints.sorted = pbf_hints.get_bool();
+                                break;
+                            default:
+                                pbf_hints.skip();
+                        }
+                    }
+                } catch (const protozero::exception&) {
+                    return pbf_blob_hints{};
+                }
+
+                if (!is_osmium) {
+                    return pbf_blob_hints{};
+                }
+
+                hints.valid = true;
+                return hints;
+            }
+
+            /**
+             * Decode the BlobHeader. Make sure it contains the expected
+             * type. Return the size of the following Blob.
+             *
+             * @param pbf_blob_header The BlobHeader message.
+             * @param expected_type "OSMHeader" or "OSMData".
+             * @param hints If this is not nullptr, the hints found in the
+             *              BlobHeader are stored here.
+             */
+            inline std::size_t decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>&& pbf_blob_header, const char* expected_type, pbf_blob_hints* hints = nullptr) {
+                protozero::data_view blob_header_type;
+                std::size_t blob_header_datasize = 0;
+
+                if (hints) {
+                    *hints = pbf_blob_hints{};
+                }
+
+                while (pbf_blob_header.next()) {
+                    switch (pbf_blob_header.tag_and_type()) {
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
+                            blob_header_type = pbf_blob_header.get_view();
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::optional_bytes_indexdata, protozero::pbf_wire_type::length_delimited):
+                            if (hints) {
+                                *hints = decode_blob_hints(pbf_blob_header.get_view());
+                            } else {
+                                pbf_blob_header.skip();
+                            }
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
+                            blob_header_datasize = pbf_blob_header.get_int32();
+                            break;
+                        default:
+                            pbf_blob_header.skip();
+                    }
+                }
+
+                if (blob_header_datasize == 0) {
+                    throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
+                }
+
+                if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size()) != 0) {
+                    throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                }
+
+                return blob_header_datasize;
+            }
+
+            /**
+             * Position of one Blob (not including the BlobHeader) inside
+             * PBF data and the hints from its BlobHeader.
+             */
+            struct pbf_blob_position {
+                std::size_t offset;
+                std::size_t size;
+                pbf_blob_hints hints;
+            };
+
+            /**
+             * Find all Blobs in PBF data available completely in memory
+             * (usually because it is memory mapped). Only the BlobHeaders
+             * are decoded, so this is fast even for huge files.
+             *
+             * @param data Pointer to start of data.
+             * @param size Size of data.
+             * @returns Vector with positions of all Blobs in the data. The
+             *          first one is always the OSMHeader blob.
+             * @throws osmium::pbf_error If the data is not valid PBF.
+             */
+            inline std::vector<pbf_blob_position> find_pbf_blobs(const char* data, const std::size_t size) {
+                std::vector<pbf_blob_position> blobs;
+                std::size_t offset = 0;
+
+                while (offset < size) {
+                    if (size - offset < sizeof(uint32_t)) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+
+                    const uint32_t header_size = decode_blob_header_size(data + offset);
+                    offset += sizeof(uint32_t);
+                    if (header_size > static_cast<uint32_t>(max_blob_header_size)) {
+                        throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                    }
+                    if (size - offset < header_size) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+
+                    pbf_blob_hints hints;
+                    const auto blob_size = decode_blob_header(
+                        protozero::pbf_message<FileFormat::BlobHeader>{data_view{data + offset, header_size}},
+                        blobs.empty() ? "OSMHeader" : "OSMData",
+                        &hints);
+                    offset += header_size;
+
+                    if (blob_size > max_uncompressed_blob_size) {
+                        throw osmium::pbf_error{std::string{"invalid blob size: "} +
+                                                std::to_string(blob_size)};
+                    }
+                    if (size - offset < blob_size) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+
+                    blobs.push_back(pbf_blob_position{offset, blob_size, hints});
+                    offset += blob_size;
+                }
+
+                if (blobs.empty()) {
+                    throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                }
+
+                return blobs;
+            }
+
+            /**
+             * Check the blob hints of all data Blobs found by
+             * find_pbf_blobs() to see whether the objects in the whole file
+             * are ordered by type and id. This is the case if every Blob
+             * says it is sorted internally and the last object in each Blob
+             * comes before the first object in the next one.
+             *
+             * @returns true if the order could be verified, false if it is
+             *          not sorted or there isn't enough information about
+             *          some Blob.
+             */
+            inline bool pbf_blobs_are_sorted(const std::vector<pbf_blob_position>& blobs) noexcept {
+                // Types in a sorted Blob are in the order of the entity
+                // bits, so the first object is of the type given by the
+                // lowest bit set, the last object of the highest bit set.
+                const auto first_type = [](osmium::osm_entity_bits::type types) noexcept {
+                    const auto bits = static_cast<uint32_t>(types);
+                    return bits & ~(bits - 1U);
+                };
+                const auto last_type = [](osmium::osm_entity_bits::type types) noexcept {
+                    auto bits = static_cast<uint32_t>(types);
+                    while (bits & (bits - 1U)) {
+                        bits &= bits - 1U;
+                    }
+                    return bits;
+                };
+
+                const pbf_blob_hints* prev = nullptr;
+                for (auto it = std::next(blobs.begin()); it != blobs.end(); ++it) {
+                    const auto& hints = it->hints;
+                    if (!hints.valid || !hints.has_ids || !hints.sorted) {
+                        return false;
+                    }
+                    if (prev) {
+                        const auto prev_type = last_type(prev->types);
+                        const auto type = first_type(hints.types);
+                        if (type < prev_type ||
+                            (type == prev_type && !osmium::id_order{}(prev->last_id, hints.first_id))) {
+                            return false;
+                        }
+                    }
+                    prev = &hints;
+                }
+
+                return true;
+            }
+
+            /**
+             * Summary of the contents of a data Blob: Which types of objects
+             * are in it and what the smallest and largest ids are.
+             */
+            struct pbf_blob_summary {
+
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+                osmium::object_id_type min_id = std::numeric_limits<osmium::object_id_type>::max();
+                osmium::object_id_type max_id = std::numeric_limits<osmium::object_id_type>::min();
+
+                void add(const osmium::osm_entity_bits::type type, const osmium::object_id_type id) noexcept {
+                    types |= type;
+                    if (id < min_id) {
+                        min_id = id;
+                    }
+                    if (id > max_id) {
+                        max_id = id;
+                    }
+                }
+
+            }; // struct pbf_blob_summary
+
+            template <typename TMessage, typename TEnum>
+            inline osmium::object_id_type decode_object_id(TMessage&& pbf_object, const TEnum id_tag, const bool zigzag) {
+                if (pbf_object.next(id_tag, protozero::pbf_wire_type::varint)) {
+                    return zigzag ? pbf_object.get_sint64() : pbf_object.get_int64();
+                }
+                throw osmium::pbf_error{"PBF format error: object without id"};
+            }
+
+            /**
+             * Decode just enough of a data Blob to find out which object
+             * types and ids are in it. Tags, metadata, locations etc. are
+             * not decoded.
+             *
+             * @param blob_data The Blob data.
+             * @throws osmium::pbf_error If there was a parsing error.
+             */
+            inline pbf_blob_summary decode_blob_summary(const data_view& blob_data) {
+                pbf_blob_summary summary;
+
+                auto& output = thread_pbf_decoder_scratch().uncompressed;
+                protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{decode_blob(blob_data, output)};
+                while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
+                    protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                    while (pbf_primitive_group.next()) {
+                        switch (pbf_primitive_group.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                                summary.add(osmium::osm_entity_bits::node,
+                                            decode_object_id(protozero::pbf_message<OSMFormat::Node>{pbf_primitive_group.get_message()}, OSMFormat::Node::required_sint64_id, true));
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
+                                {
+                                    protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{pbf_primitive_group.get_message()};
+                                    while (pbf_dense_nodes.next(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited)) {
+                                        osmium::DeltaDecode<int64_t> dense_id;
+                                        for (const auto id : pbf_dense_nodes.get_packed_sint64()) {
+                                            summary.add(osmium::osm_entity_bits::node, dense_id.update(id));
+                                        }
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
+                                summary.add(osmium::osm_entity_bits::way,
+                                            decode_object_id(protozero::pbf_message<OSMFormat::Way>{pbf_primitive_group.get_message()}, OSMFormat::Way::required_int64_id, false));
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited):
+                                summary.add(osmium::osm_entity_bits::relation,
+                                            decode_object_id(protozero::pbf_message<OSMFormat::Relation>{pbf_primitive_group.get_message()}, OSMFormat::Relation::required_int64_id, false));
+                                break;
+                            default:
+                                pbf_primitive_group.skip();
+                        }
+                    }
+                }
+
+                return summary;
+            }
+
+            /**
+             * A range of bytes inside a reference-counted string. This is
+             * used to hand out blob data without copying it out of the
+             * input chunk it was read in.
+             */
+            struct pbf_blob_data {
+
+                std::shared_ptr<const std::string> owner;
+                data_view data;
+
+            }; // struct pbf_blob_data
+
             class PBFDataBlobDecoder {
 
-                std::shared_ptr<std::string> m_input_buffer;
+                std::shared_ptr<const std::string> m_input_buffer;
+                data_view m_data;
                 osmium::osm_entity_bits::type m_read_types;
                 osmium::io::read_meta m_read_metadata;
+                osmium::memory::BufferPool* m_buffer_pool;
+                std::shared_ptr<const osmium::io::ReadFilter> m_read_filter;
+                uint64_t m_sequence = 0;
+                std::size_t m_input_end_offset = 0;
+                bool m_keep_source_data = false;
 
             public:
 
-                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
-                    m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))),
+                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr, std::shared_ptr<const osmium::io::ReadFilter> read_filter = nullptr) :
+                    m_input_buffer(std::make_shared<const std::string>(std::move(input_buffer))),
+                    m_data(m_input_buffer->data(), m_input_buffer->size()),
+                    m_read_types(read_types),
+                    m_read_metadata(read_metadata),
+                    m_buffer_pool(buffer_pool),
+                    m_read_filter(std::move(read_filter)) {
+                }
+
+                /**
+                 * Construct a decoder for blob data living inside a shared
+                 * string. The data is not copied, the decoder keeps a
+                 * reference to the string until it is destroyed.
+                 */
+                PBFDataBlobDecoder(pbf_blob_data&& blob, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr, std::shared_ptr<const osmium::io::ReadFilter> read_filter = nullptr) :
+                    m_input_buffer(std::move(blob.owner)),
+                    m_data(blob.data),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_read_metadata(read_metadata),
+                    m_buffer_pool(buffer_pool),
+                    m_read_filter(std::move(read_filter)) {
+                }
+
+                /**
+                 * Attach a copy of the (compressed) blob to the decoded
+                 * buffer with Buffer::set_source_data(). This only makes
+                 * sense if all objects and all metadata are decoded, so the
+                 * buffer contains everything that's in the blob.
+                 */
+                void keep_source_data() noexcept {
+                    m_keep_source_data = true;
+                }
+
+                /**
+                 * Set the sequence number of this blob used in the trace
+                 * events (see osmium/util/trace.hpp).
+                 */
+                void set_sequence(const uint64_t sequence) noexcept {
+                    m_sequence = sequence;
+                }
+
+                /**
+                 * Set the offset in the input just after this blob. It is
+                 * attached to the decoded buffer with
+                 * Buffer::set_input_end_offset().
+                 */
+                void set_input_end_offset(const std::size_t offset) noexcept {
+                    m_input_end_offset = offset;
                 }
 
                 osmium::memory::Buffer operator()() {
-                    std::string output;
-                    PBFPrimitiveBlockDecoder decoder{decode_blob(*m_input_buffer, output), m_read_types, m_read_metadata};
-                    return decoder();
+                    auto& scratch = thread_pbf_decoder_scratch();
+                    data_view data;
+                    {
+                        const osmium::util::TraceScope trace{osmium::util::trace_stage::decompress, m_sequence};
+                        data = decode_blob(m_data, scratch.uncompressed);
+                    }
+                    const osmium::util::TraceScope trace{osmium::util::trace_stage::decode, m_sequence};
+                    PBFPrimitiveBlockDecoder decoder{data, m_read_types, m_read_metadata, scratch, m_buffer_pool, m_read_filter.get(), m_keep_source_data};
+                    auto buffer = decoder();
+                    if (m_keep_source_data && buffer && !buffer.has_nested_buffers()) {
+                        buffer.set_source_data(std::make_shared<const std::string>(m_data.data(), m_data.size()));
+                    }
+                    if (buffer) {
+                        buffer.set_input_end_offset(m_input_end_offset);
+                    }
+                    return buffer;
                 }
 
             }; // class PBFDataBlobDecoder
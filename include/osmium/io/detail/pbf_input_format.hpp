@@ -39,10 +39,15 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
 #include <osmium/thread/pool.hpp>
-#include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/misc.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
@@ -51,10 +56,15 @@ DEALINGS IN THE SOFTWARE.
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -62,33 +72,131 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Parse the value of one of the options "pbf_blob_range" and
+             * "pbf_byte_range". It has the form "FIRST-LAST" describing the
+             * half-open range [FIRST, LAST). If LAST is missing the range
+             * extends to the end of the file.
+             *
+             * @throws std::invalid_argument If the value is not valid.
+             */
+            inline std::pair<uint64_t, uint64_t> parse_pbf_range_option(const std::string& value, const char* name) {
+                const auto is_number = [](const std::string& str) {
+                    return !str.empty() && str.size() < 20 &&
+                           str.find_first_not_of("0123456789") == std::string::npos;
+                };
+
+                const auto pos = value.find('-');
+                const std::string first{value.substr(0, pos)};
+                const std::string last{pos == std::string::npos ? std::string{} : value.substr(pos + 1)};
+                if (pos == std::string::npos || !is_number(first) || (!last.empty() && !is_number(last))) {
+                    throw std::invalid_argument{std::string{"Value for "} + name + " option must be of the form FIRST-LAST"};
+                }
+
+                const std::pair<uint64_t, uint64_t> range{std::stoull(first), last.empty() ? std::numeric_limits<uint64_t>::max() : std::stoull(last)};
+                if (range.first > range.second) {
+                    throw std::invalid_argument{std::string{"Value for "} + name + " option is not a valid range"};
+                }
+
+                return range;
+            }
+
             class PBFParser final : public Parser {
 
-                std::string m_input_buffer{};
+                // The input chunk we are currently reading from and the
+                // offset of the first byte in it that wasn't used yet.
+                std::shared_ptr<const std::string> m_input_chunk{std::make_shared<const std::string>()};
+                std::size_t m_input_offset = 0;
+
+                // Offset in the input file of the next byte to be read.
+                std::size_t m_file_offset = 0;
+
+                // Optional index of the data blobs in the file.
+                PBFBlobIndex m_blob_index{};
+                std::size_t m_blob_count = 0;
+
+                // Skip data blobs which, according to the hints in their
+                // BlobHeader, contain only nodes without tags.
+                bool m_skip_untagged_node_blobs = false;
+
+                // Attach the raw blobs to the decoded buffers, so they can
+                // be written out again without encoding.
+                bool m_keep_blobs = false;
+
+                // Data blobs ending before this offset in the input are
+                // skipped (see Reader::checkpoint()).
+                std::size_t m_resume_offset = 0;
+
+                // Only decode a sample of the data blobs, one in this
+                // many, see blob_is_sampled().
+                uint64_t m_sample_every = 1;
+                uint64_t m_sample_seed = 0;
+                bool m_sample_random = false;
+
+                // Only data blobs with numbers in the first range and
+                // starting (with their BlobHeader) at offsets in the
+                // second range are decoded, see blob_is_assigned().
+                std::pair<uint64_t, uint64_t> m_blob_range{0, std::numeric_limits<uint64_t>::max()};
+                std::pair<uint64_t, uint64_t> m_byte_range{0, std::numeric_limits<uint64_t>::max()};
+
+                std::size_t available_in_chunk() const noexcept {
+                    return m_input_chunk->size() - m_input_offset;
+                }
 
                 /**
                  * Read the given number of bytes from the input queue.
                  *
+                 * If the data is completely contained in the current input
+                 * chunk, no data is copied, the result refers to a range
+                 * inside that chunk. Only if the data straddles chunk
+                 * boundaries it is assembled into a new string.
+                 *
                  * @param size Number of bytes to read
-                 * @returns String with the data
+                 * @returns Data and the string owning it
                  * @throws osmium::pbf_error If size bytes can't be read
                  */
-                std::string read_from_input_queue(size_t size) {
-                    while (m_input_buffer.size() < size) {
-                        const std::string new_data{get_input()};
+                pbf_blob_data read_from_input_queue(std::size_t size) {
+                    if (available_in_chunk() == 0) {
+                        std::string new_data{get_input()};
                         if (input_done()) {
                             throw osmium::pbf_error{"truncated data (EOF encountered)"};
                         }
-                        m_input_buffer += new_data;
+                        m_input_chunk = std::make_shared<const std::string>(std::move(new_data));
+                        m_input_offset = 0;
                     }
 
-                    std::string output{m_input_buffer.substr(size)};
-                    m_input_buffer.resize(size);
+                    if (available_in_chunk() >= size) {
+                        const data_view view{m_input_chunk->data() + m_input_offset, size};
+                        m_input_offset += size;
+                        m_file_offset += size;
+                        return pbf_blob_data{m_input_chunk, view};
+                    }
 
-                    using std::swap;
-                    swap(output, m_input_buffer);
+                    std::string data;
+                    data.reserve(size);
+                    data.append(m_input_chunk->data() + m_input_offset, available_in_chunk());
 
-                    return output;
+                    while (data.size() < size) {
+                        std::string new_data{get_input()};
+                        if (input_done()) {
+                            throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                        }
+                        const std::size_t missing = size - data.size();
+                        if (new_data.size() > missing) {
+                            data.append(new_data.data(), missing);
+                            m_input_chunk = std::make_shared<const std::string>(std::move(new_data));
+                            m_input_offset = missing;
+                        } else {
+                            data.append(new_data);
+                            m_input_offset = m_input_chunk->size();
+                        }
+                    }
+
+                    m_file_offset += size;
+
+                    auto owner = std::make_shared<const std::string>(std::move(data));
+                    const data_view view{owner->data(), owner->size()};
+                    return pbf_blob_data{std::move(owner), view};
                 }
 
                 /**
@@ -100,12 +208,8 @@ namespace osmium {
 
                     try {
                         // size is encoded in network byte order
-                        const std::string input_data{read_from_input_queue(sizeof(size))};
-                        const char* d = input_data.data();
-                        size = (static_cast<uint32_t>(d[3])) |
-                               (static_cast<uint32_t>(d[2]) <<  8U) |
-                               (static_cast<uint32_t>(d[1]) << 16U) |
-                               (static_cast<uint32_t>(d[0]) << 24U);
+                        const auto input_data = read_from_input_queue(sizeof(size));
+                        size = decode_blob_header_size(input_data.data.data());
                     } catch (const osmium::pbf_error&) {
                         return 0; // EOF
                     }
@@ -117,39 +221,7 @@ namespace osmium {
                     return size;
                 }
 
-                /**
-                 * Decode the BlobHeader. Make sure it contains the expected
-                 * type. Return the size of the following Blob.
-                 */
-                static size_t decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>&& pbf_blob_header, const char* expected_type) {
-                    protozero::data_view blob_header_type;
-                    size_t blob_header_datasize = 0;
-
-                    while (pbf_blob_header.next()) {
-                        switch (pbf_blob_header.tag_and_type()) {
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
-                                blob_header_type = pbf_blob_header.get_view();
-                                break;
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
-                                blob_header_datasize = pbf_blob_header.get_int32();
-                                break;
-                            default:
-                                pbf_blob_header.skip();
-                        }
-                    }
-
-                    if (blob_header_datasize == 0) {
-                        throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
-                    }
-
-                    if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size()) != 0) {
-                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
-                    }
-
-                    return blob_header_datasize;
-                }
-
-                size_t check_type_and_get_blob_size(const char* expected_type) {
+                size_t check_type_and_get_blob_size(const char* expected_type, pbf_blob_hints* hints = nullptr) {
                     assert(expected_type);
 
                     const auto size = read_blob_header_size_from_file();
@@ -157,12 +229,12 @@ namespace osmium {
                         return 0;
                     }
 
-                    const std::string blob_header{read_from_input_queue(size)};
+                    const auto blob_header = read_from_input_queue(size);
 
-                    return decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>(blob_header), expected_type);
+                    return decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>(blob_header.data), expected_type, hints);
                 }
 
-                std::string read_from_input_queue_with_check(size_t size) {
+                pbf_blob_data read_from_input_queue_with_check(size_t size) {
                     if (size > max_uncompressed_blob_size) {
                         throw osmium::pbf_error{std::string{"invalid blob size: "} +
                                                 std::to_string(size)};
@@ -173,18 +245,229 @@ namespace osmium {
                 // Parse the header in the PBF OSMHeader blob.
                 void parse_header_blob() {
                     const auto size = check_type_and_get_blob_size("OSMHeader");
-                    osmium::io::Header header{decode_header(read_from_input_queue_with_check(size))};
+                    osmium::io::Header header{decode_header(read_from_input_queue_with_check(size).data)};
                     set_header_value(header);
                 }
 
+                /**
+                 * Can any object in a Blob with objects of the given types
+                 * and ids between min_id and max_id match the id
+                 * conditions of the read filter?
+                 */
+                bool ids_may_match(const osmium::osm_entity_bits::type types, const osmium::object_id_type min_id, const osmium::object_id_type max_id) const noexcept {
+                    const auto* filter = read_filter().get();
+                    if (!filter) {
+                        return true;
+                    }
+                    for (const auto type : {osmium::item_type::node, osmium::item_type::way, osmium::item_type::relation}) {
+                        if ((types & read_types() & osmium::osm_entity_bits::from_item_type(type)) &&
+                            (!filter->filters_ids(type) || filter->match_id_range(type, min_id, max_id))) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                /**
+                 * Check whether the next data blob, which is at the specified
+                 * offset and has the specified size, contains any of the
+                 * object types we are interested in. This uses the blob
+                 * index, if there is one, and the hints from the BlobHeader.
+                 * Always returns true if there is neither.
+                 *
+                 * @throws osmium::pbf_error If the index doesn't match the file.
+                 */
+                bool blob_is_needed(const std::size_t offset, const std::size_t size, const pbf_blob_hints& hints) {
+                    if (!m_blob_index.empty()) {
+                        if (m_blob_count >= m_blob_index.size()) {
+                            throw osmium::pbf_error{"PBF blob index does not match input file"};
+                        }
+
+                        const auto& entry = m_blob_index[m_blob_count++];
+                        if (entry.offset != offset || entry.size != size) {
+                            throw osmium::pbf_error{"PBF blob index does not match input file"};
+                        }
+
+                        if ((entry.entity_bits() & read_types()) == 0 ||
+                            !ids_may_match(entry.entity_bits(), entry.min_id, entry.max_id)) {
+                            return false;
+                        }
+                    }
+
+                    if (!hints.valid) {
+                        return true;
+                    }
+
+                    if ((hints.types & read_types()) == 0) {
+                        return false;
+                    }
+
+                    // The first and last ids are only the smallest and
+                    // largest ids if the Blob is sorted and contains only
+                    // one type with non-negative ids.
+                    if (hints.has_ids && hints.sorted && hints.first_id >= 0 &&
+                        (hints.types == osmium::osm_entity_bits::node ||
+                         hints.types == osmium::osm_entity_bits::way ||
+                         hints.types == osmium::osm_entity_bits::relation) &&
+                        !ids_may_match(hints.types, hints.first_id, hints.last_id)) {
+                        return false;
+                    }
+
+                    // Blobs with only untagged nodes are also not needed
+                    // if the read filter only keeps tagged nodes.
+                    const bool skip_untagged = m_skip_untagged_node_blobs ||
+                                               (read_filter() && read_filter()->filters_tags(osmium::item_type::node));
+
+                    return !(skip_untagged &&
+                             hints.types == osmium::osm_entity_bits::node &&
+                             !hints.has_tagged_nodes);
+                }
+
+                /**
+                 * Is the data blob with the given number (counting from 0)
+                 * in the sample to be decoded? Without a seed every n-th
+                 * blob is in the sample, with a seed each blob is in it
+                 * with a probability of 1/n. The choice only depends on
+                 * the seed and the blob number, so reading the same file
+                 * with the same seed always gives the same sample.
+                 */
+                bool blob_is_sampled(const uint64_t blob_number) const noexcept {
+                    if (m_sample_every <= 1) {
+                        return true;
+                    }
+                    if (!m_sample_random) {
+                        return blob_number % m_sample_every == 0;
+                    }
+
+                    // splitmix64
+                    uint64_t x = m_sample_seed + (blob_number + 1) * 0x9e3779b97f4a7c15ULL;
+                    x ^= x >> 30U;
+                    x *= 0xbf58476d1ce4e5b9ULL;
+                    x ^= x >> 27U;
+                    x *= 0x94d049bb133111ebULL;
+                    x ^= x >> 31U;
+                    return x % m_sample_every == 0;
+                }
+
+                /**
+                 * Is the data blob with the given number (counting from 0)
+                 * starting at the given offset in the file in the part of
+                 * the file assigned to this reader with the "pbf_blob_range"
+                 * and "pbf_byte_range" options?
+                 */
+                bool blob_is_assigned(const uint64_t blob_number, const std::size_t frame_offset) const noexcept {
+                    return blob_number >= m_blob_range.first && blob_number < m_blob_range.second &&
+                           frame_offset >= m_byte_range.first && frame_offset < m_byte_range.second;
+                }
+
+                // All blobs from this one on are outside the assigned range.
+                bool past_assigned_range(const uint64_t blob_number, const std::size_t frame_offset) const noexcept {
+                    return blob_number >= m_blob_range.second || frame_offset >= m_byte_range.second;
+                }
+
                 void parse_data_blobs() {
-                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
-                        std::string input_buffer{read_from_input_queue_with_check(size)};
+                    pbf_blob_hints hints;
+                    for (uint64_t sequence = 0;; ++sequence) {
+                        pbf_blob_data blob;
+                        {
+                            const osmium::util::TraceScope trace{osmium::util::trace_stage::framing, sequence};
+                            const auto frame_offset = m_file_offset;
+                            if (past_assigned_range(sequence, frame_offset)) {
+                                return;
+                            }
+                            const auto size = check_type_and_get_blob_size("OSMData", &hints);
+                            if (size == 0) {
+                                if (frame_offset < m_resume_offset) {
+                                    throw osmium::pbf_error{"resume offset is beyond the end of the input"};
+                                }
+                                return;
+                            }
+                            const auto offset = m_file_offset;
+                            blob = read_from_input_queue_with_check(size);
+                            if (frame_offset < m_resume_offset || !blob_is_assigned(sequence, frame_offset)) {
+                                if (frame_offset < m_resume_offset && m_file_offset > m_resume_offset) {
+                                    throw osmium::pbf_error{"resume offset is not at a blob boundary"};
+                                }
+                                blob_is_needed(offset, size, hints); // keep position in blob index
+                                continue;
+                            }
+                            if (!blob_is_needed(offset, size, hints) || !blob_is_sampled(sequence)) {
+                                continue;
+                            }
+                        }
 
-                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata()};
+                        const std::size_t blob_size = blob.data.size();
+                        const std::size_t blob_end = m_file_offset;
+                        PBFDataBlobDecoder data_blob_parser{std::move(blob), read_types(), read_metadata(), buffer_pool(), read_filter()};
+                        data_blob_parser.set_sequence(sequence);
+                        data_blob_parser.set_input_end_offset(blob_end);
+                        if (m_keep_blobs) {
+                            data_blob_parser.keep_source_data();
+                        }
 
                         if (osmium::config::use_pool_threads_for_pbf_parsing()) {
-                            send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
+                            send_to_output_queue_from_pool(std::move(data_blob_parser), blob_size);
+                        } else {
+                            send_to_output_queue(data_blob_parser());
+                        }
+                    }
+                }
+
+                /**
+                 * Parse memory mapped input. All Blob positions are found
+                 * first and then decoding of the data Blobs is dispatched
+                 * straight from the mapped memory without copying anything.
+                 */
+                void parse_mapped_input() {
+                    const auto blobs = find_pbf_blobs(mapped_data(), mapped_size());
+
+                    const auto& header_blob = blobs.front();
+                    osmium::io::Header header{decode_header(data_view{mapped_data() + header_blob.offset, header_blob.size})};
+
+                    // Only possible here, because we know all blob hints
+                    // before the header has to be sent on.
+                    if (pbf_blobs_are_sorted(blobs)) {
+                        header.set("sorting_verified", "true");
+                    }
+                    set_header_value(header);
+
+                    if (read_types() == osmium::osm_entity_bits::nothing) {
+                        return;
+                    }
+
+                    if (m_resume_offset > mapped_size()) {
+                        throw osmium::pbf_error{"resume offset is beyond the end of the input"};
+                    }
+
+                    std::size_t next_frame_offset = blobs.front().offset + blobs.front().size;
+                    for (auto it = std::next(blobs.begin()); it != blobs.end(); ++it) {
+                        const std::size_t frame_offset = next_frame_offset;
+                        const std::size_t blob_end = it->offset + it->size;
+                        next_frame_offset = blob_end;
+                        const auto sequence = static_cast<uint64_t>(std::distance(blobs.begin(), it) - 1);
+                        if (past_assigned_range(sequence, frame_offset)) {
+                            return;
+                        }
+                        if (frame_offset < m_resume_offset || !blob_is_assigned(sequence, frame_offset)) {
+                            if (frame_offset < m_resume_offset && blob_end > m_resume_offset) {
+                                throw osmium::pbf_error{"resume offset is not at a blob boundary"};
+                            }
+                            blob_is_needed(it->offset, it->size, it->hints); // keep position in blob index
+                            continue;
+                        }
+                        if (!blob_is_needed(it->offset, it->size, it->hints) || !blob_is_sampled(sequence)) {
+                            continue;
+                        }
+
+                        PBFDataBlobDecoder data_blob_parser{pbf_blob_data{nullptr, data_view{mapped_data() + it->offset, it->size}}, read_types(), read_metadata(), buffer_pool(), read_filter()};
+                        data_blob_parser.set_sequence(sequence);
+                        data_blob_parser.set_input_end_offset(blob_end);
+                        if (m_keep_blobs) {
+                            data_blob_parser.keep_source_data();
+                        }
+
+                        if (osmium::config::use_pool_threads_for_pbf_parsing()) {
+                            send_to_output_queue_from_pool(std::move(data_blob_parser), it->size);
                         } else {
                             send_to_output_queue(data_blob_parser());
                         }
@@ -206,7 +489,55 @@ namespace osmium {
                 ~PBFParser() noexcept override = default;
 
                 void run() override {
-                    osmium::thread::set_thread_name("_osmium_pbf_in");
+                    set_thread_name("_osmium_pbf_in");
+
+                    const auto index_file = get_file_option("pbf_blob_index");
+                    if (!index_file.empty()) {
+                        m_blob_index = PBFBlobIndex::read(index_file);
+                    }
+
+                    m_skip_untagged_node_blobs = file_option_is_true("pbf_skip_untagged_node_blobs");
+
+                    const auto resume_offset = get_file_option("pbf_resume_offset");
+                    if (!resume_offset.empty()) {
+                        m_resume_offset = osmium::detail::str_to_int<std::size_t>(resume_offset.c_str());
+                    }
+
+                    const auto sample_every = get_file_option("pbf_sample_every");
+                    if (!sample_every.empty()) {
+                        m_sample_every = osmium::detail::str_to_int<uint64_t>(sample_every.c_str());
+                        if (m_sample_every == 0) {
+                            throw std::invalid_argument{"Value for pbf_sample_every option must be a positive integer"};
+                        }
+                    }
+
+                    const auto blob_range = get_file_option("pbf_blob_range");
+                    if (!blob_range.empty()) {
+                        m_blob_range = parse_pbf_range_option(blob_range, "pbf_blob_range");
+                    }
+
+                    const auto byte_range = get_file_option("pbf_byte_range");
+                    if (!byte_range.empty()) {
+                        m_byte_range = parse_pbf_range_option(byte_range, "pbf_byte_range");
+                    }
+
+                    const auto sample_seed = get_file_option("pbf_sample_seed");
+                    if (!sample_seed.empty()) {
+                        m_sample_seed = osmium::detail::str_to_int<uint64_t>(sample_seed.c_str());
+                        m_sample_random = true;
+                    }
+
+                    // Blobs can only be kept if the decoded buffers contain
+                    // everything that's in them.
+                    m_keep_blobs = file_option_is_true("pbf_keep_blobs") &&
+                                   (read_types() & osmium::osm_entity_bits::nwr) == osmium::osm_entity_bits::nwr &&
+                                   read_metadata() == osmium::io::read_meta::yes &&
+                                   !read_filter();
+
+                    if (mapped_data()) {
+                        parse_mapped_input();
+                        return;
+                    }
 
                     parse_header_blob();
 
@@ -55,12 +55,14 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item_iterator.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/metadata_options.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/osm/object_comparisons.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/timestamp.hpp>
@@ -75,7 +77,12 @@ DEALINGS IN THE SOFTWARE.
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
 #include <protozero/pbf_builder.hpp>
+#include <protozero/pbf_message.hpp>
 #include <protozero/pbf_writer.hpp>
 #include <protozero/types.hpp>
 
@@ -111,6 +118,24 @@ namespace osmium {
                 /// Should node locations be added to ways?
                 bool locations_on_ways = false;
 
+                /**
+                 * Should the string table of each block be sorted by how
+                 * often the strings are used?
+                 */
+                bool sort_stringtable = false;
+
+                /**
+                 * Should hints about the contents of each blob be added to
+                 * the BlobHeader?
+                 */
+                bool add_blob_hints = false;
+
+                /**
+                 * Should the object counts and max ids from the header be
+                 * added as optional features?
+                 */
+                bool add_object_counts = false;
+
             }; // struct pbf_output_options
 
             /**
@@ -145,6 +170,159 @@ namespace osmium {
                 data = 1
             };
 
+            /**
+             * Check that the data consists of complete OSMData Blobs, each
+             * with its BlobHeader and the size of the BlobHeader in front,
+             * as returned by SerializeBlob. Only the framing is checked,
+             * the Blobs are not decoded.
+             *
+             * @throws osmium::pbf_error If the data is not framed correctly.
+             */
+            inline void check_pbf_data_frames(const std::string& data) {
+                std::size_t offset = 0;
+                while (offset < data.size()) {
+                    if (data.size() - offset < sizeof(uint32_t)) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    const auto* d = reinterpret_cast<const unsigned char*>(data.data() + offset);
+                    const uint32_t header_size = (static_cast<uint32_t>(d[0]) << 24U) |
+                                                 (static_cast<uint32_t>(d[1]) << 16U) |
+                                                 (static_cast<uint32_t>(d[2]) <<  8U) |
+                                                 (static_cast<uint32_t>(d[3]));
+                    offset += sizeof(uint32_t);
+                    if (header_size > static_cast<uint32_t>(max_blob_header_size)) {
+                        throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                    }
+                    if (data.size() - offset < header_size) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+
+                    protozero::pbf_message<FileFormat::BlobHeader> pbf_blob_header{data.data() + offset, header_size};
+                    protozero::data_view type;
+                    std::size_t datasize = 0;
+                    while (pbf_blob_header.next()) {
+                        switch (pbf_blob_header.tag_and_type()) {
+                            case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
+                                type = pbf_blob_header.get_view();
+                                break;
+                            case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
+                                datasize = static_cast<std::size_t>(pbf_blob_header.get_int32());
+                                break;
+                            default:
+                                pbf_blob_header.skip();
+                        }
+                    }
+                    offset += header_size;
+
+                    if (type != protozero::data_view{"OSMData", 7}) {
+                        throw osmium::pbf_error{"blob does not have expected type (OSMData)"};
+                    }
+                    if (datasize == 0 || datasize > max_uncompressed_blob_size) {
+                        throw osmium::pbf_error{std::string{"invalid blob size: "} + std::to_string(datasize)};
+                    }
+                    if (data.size() - offset < datasize) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    offset += datasize;
+                }
+            }
+
+            /**
+             * Put a BlobHeader in front of a serialized Blob and return
+             * both ready to be written to a file.
+             *
+             * @param blob_data The serialized Blob.
+             * @param type Type of blob.
+             * @param indexdata Data for the BlobHeader.indexdata field.
+             *                  Not written if empty.
+             */
+            inline std::string frame_blob(const std::string& blob_data, pbf_blob_type type, const std::string& indexdata) {
+                std::string blob_header_data;
+                protozero::pbf_builder<FileFormat::BlobHeader> pbf_blob_header{blob_header_data};
+
+                pbf_blob_header.add_string(FileFormat::BlobHeader::required_string_type, type == pbf_blob_type::data ? "OSMData" : "OSMHeader");
+
+                if (!indexdata.empty()) {
+                    pbf_blob_header.add_bytes(FileFormat::BlobHeader::optional_bytes_indexdata, indexdata);
+                }
+
+                // The static_cast is okay, because the size can never
+                // be much larger than max_uncompressed_blob_size. This
+                // is due to the assert in SerializeBlob and the fact that
+                // the zlib library will not grow deflated data beyond the
+                // original data plus a few header bytes
+                // (https://zlib.net/zlib_tech.html).
+                pbf_blob_header.add_int32(FileFormat::BlobHeader::required_int32_datasize, static_cast<int32_t>(blob_data.size()));
+
+                const auto size = static_cast<uint32_t>(blob_header_data.size());
+
+                // write to output: the 4-byte BlobHeader size in network
+                // byte order followed by the BlobHeader followed by the Blob
+                std::string output;
+                output.reserve(4 + blob_header_data.size() + blob_data.size());
+                output += static_cast<char>((size >> 24U) & 0xffU);
+                output += static_cast<char>((size >> 16U) & 0xffU);
+                output += static_cast<char>((size >>  8U) & 0xffU);
+                output += static_cast<char>( size         & 0xffU);
+                output.append(blob_header_data);
+                output.append(blob_data);
+
+                return output;
+            }
+
+            /**
+             * Collects the information about the objects in a blob needed
+             * for the blob hints.
+             */
+            struct blob_contents {
+
+                /// Object types in the blob.
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+                /// Does the blob contain any nodes with tags?
+                bool has_tagged_nodes = false;
+
+                /// Are the objects ordered by type and id (without duplicates)?
+                bool sorted = true;
+
+                osmium::item_type last_type = osmium::item_type::undefined;
+                osmium::object_id_type first_id = 0;
+                osmium::object_id_type last_id = 0;
+
+                void add(const osmium::OSMObject& object) noexcept {
+                    if (types == osmium::osm_entity_bits::nothing) {
+                        first_id = object.id();
+                    } else if (object.type() < last_type ||
+                               (object.type() == last_type && !osmium::id_order{}(last_id, object.id()))) {
+                        sorted = false;
+                    }
+                    types |= osmium::osm_entity_bits::from_item_type(object.type());
+                    if (object.type() == osmium::item_type::node && !object.tags().empty()) {
+                        has_tagged_nodes = true;
+                    }
+                    last_type = object.type();
+                    last_id = object.id();
+                }
+
+            }; // struct blob_contents
+
+            /**
+             * Encode the blob hints for the BlobHeader.indexdata field.
+             */
+            inline std::string encode_blob_hints(const blob_contents& contents) {
+                std::string data;
+                protozero::pbf_builder<OsmiumFormat::BlobHints> pbf_hints{data};
+                pbf_hints.add_string(OsmiumFormat::BlobHints::required_string_generator, "osmium");
+                pbf_hints.add_uint32(OsmiumFormat::BlobHints::optional_uint32_types, static_cast<uint32_t>(contents.types));
+                pbf_hints.add_bool(OsmiumFormat::BlobHints::optional_bool_has_tagged_nodes, contents.has_tagged_nodes);
+                if (contents.types != osmium::osm_entity_bits::nothing) {
+                    pbf_hints.add_sint64(OsmiumFormat::BlobHints::optional_sint64_first_id, contents.first_id);
+                    pbf_hints.add_sint64(OsmiumFormat::BlobHints::optional_sint64_last_id, contents.last_id);
+                    pbf_hints.add_bool(OsmiumFormat::BlobHints::optional_bool_sorted, contents.sorted);
+                }
+                return data;
+            }
+
             class SerializeBlob {
 
                 std::string m_msg;
@@ -155,6 +333,8 @@ namespace osmium {
 
                 pbf_compression m_use_compression;
 
+                std::string m_indexdata;
+
             public:
 
                 /**
@@ -164,12 +344,15 @@ namespace osmium {
                  * @param type Type of blob.
                  * @param use_compression The type of compression to use.
                  * @param compression_level Compression level.
+                 * @param indexdata Data for the BlobHeader.indexdata field.
+                 *                  Not written if empty.
                  */
-                SerializeBlob(std::string&& msg, pbf_blob_type type, pbf_compression use_compression, int compression_level) :
+                SerializeBlob(std::string&& msg, pbf_blob_type type, pbf_compression use_compression, int compression_level, std::string&& indexdata = std::string{}) :
                     m_msg(std::move(msg)),
                     m_compression_level(compression_level),
                     m_blob_type(type),
-                    m_use_compression(use_compression) {
+                    m_use_compression(use_compression),
+                    m_indexdata(std::move(indexdata)) {
                 }
 
                 /**
@@ -198,35 +381,18 @@ namespace osmium {
                             break;
 #else
                             throw osmium::pbf_error{"lz4 blobs not supported"};
+#endif
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zstd_data, osmium::io::detail::zstd_compress(m_msg, m_compression_level));
+                            break;
+#else
+                            throw osmium::pbf_error{"zstd blobs not supported"};
 #endif
                     }
 
-                    std::string blob_header_data;
-                    protozero::pbf_builder<FileFormat::BlobHeader> pbf_blob_header{blob_header_data};
-
-                    pbf_blob_header.add_string(FileFormat::BlobHeader::required_string_type, m_blob_type == pbf_blob_type::data ? "OSMData" : "OSMHeader");
-
-                    // The static_cast is okay, because the size can never
-                    // be much larger than max_uncompressed_blob_size. This
-                    // is due to the assert above and the fact that the zlib
-                    // library will not grow deflated data beyond the original
-                    // data plus a few header bytes (https://zlib.net/zlib_tech.html).
-                    pbf_blob_header.add_int32(FileFormat::BlobHeader::required_int32_datasize, static_cast<int32_t>(blob_data.size()));
-
-                    const auto size = static_cast<uint32_t>(blob_header_data.size());
-
-                    // write to output: the 4-byte BlobHeader size in network
-                    // byte order followed by the BlobHeader followed by the Blob
-                    std::string output;
-                    output.reserve(4 + blob_header_data.size() + blob_data.size());
-                    output += static_cast<char>((size >> 24U) & 0xffU);
-                    output += static_cast<char>((size >> 16U) & 0xffU);
-                    output += static_cast<char>((size >>  8U) & 0xffU);
-                    output += static_cast<char>( size         & 0xffU);
-                    output.append(blob_header_data);
-                    output.append(blob_data);
-
-                    return output;
+                    return frame_blob(blob_data, m_blob_type, m_indexdata);
                 }
 
             }; // class SerializeBlob
@@ -236,8 +402,8 @@ namespace osmium {
              * structure.
              *
              * Because this needs to allocate a lot of memory on the heap,
-             * only one object of this class will be created and then re-used
-             * after calling clear() on it.
+             * only one object of this class will be created for each
+             * PBFOutputBlock and then re-used after calling clear() on it.
              */
             class DenseNodes {
 
@@ -407,7 +573,25 @@ namespace osmium {
                     m_count = 0;
                 }
 
+                /**
+                 * Sort the string table by frequency and clear the group
+                 * data, so that the same objects can be added again using
+                 * the new string ids.
+                 */
+                void sort_stringtable() {
+                    m_stringtable.sort_by_frequency();
+                    m_pbf_primitive_group_data.clear();
+                    m_dense_nodes.clear();
+                    m_count = 0;
+                }
+
                 void write_stringtable(protozero::pbf_builder<OSMFormat::StringTable>& pbf_string_table) {
+                    if (m_stringtable.is_sorted()) {
+                        for (const char* s : m_stringtable.sorted_strings()) {
+                            pbf_string_table.add_bytes(OSMFormat::StringTable::repeated_bytes_s, s);
+                        }
+                        return;
+                    }
                     for (const char* s : m_stringtable) {
                         pbf_string_table.add_bytes(OSMFormat::StringTable::repeated_bytes_s, s);
                     }
@@ -471,17 +655,42 @@ namespace osmium {
 
             }; // class PrimitiveBlock
 
-            class PBFOutputFormat : public osmium::io::detail::OutputFormat, public osmium::handler::Handler {
+            /**
+             * Encodes OSM objects into PBF data blobs. Used from inside
+             * a PBFOutputBlock, so all the work of building the string
+             * tables, delta encoding and serializing the primitive blocks
+             * happens in a pool thread.
+             */
+            class PBFBlockEncoder : public osmium::handler::Handler {
 
-                pbf_output_options m_options;
+                const pbf_output_options& m_options;
 
                 PrimitiveBlock m_primitive_block;
 
+                std::string m_out;
+
+                // The objects in the current primitive block. Only used if
+                // the string table is sorted, because the block has to be
+                // encoded a second time with the new string ids then.
+                std::vector<const osmium::OSMObject*> m_objects;
+
+                // Information about the objects in the current primitive
+                // block. Used for the blob hints.
+                blob_contents m_block_contents;
+
                 void store_primitive_block() {
                     if (m_primitive_block.count() == 0) {
                         return;
                     }
 
+                    if (m_options.sort_stringtable) {
+                        m_primitive_block.sort_stringtable();
+                        for (const auto* object : m_objects) {
+                            encode_object(*object);
+                        }
+                        m_objects.clear();
+                    }
+
                     std::string primitive_block_data;
                     protozero::pbf_builder<OSMFormat::PrimitiveBlock> primitive_block{primitive_block_data};
 
@@ -492,12 +701,13 @@ namespace osmium {
 
                     primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, m_primitive_block.group_data());
 
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(primitive_block_data),
-                                      pbf_blob_type::data,
-                                      m_options.use_compression,
-                                      m_options.compression_level}
-                    ));
+                    m_out.append(SerializeBlob{std::move(primitive_block_data),
+                                               pbf_blob_type::data,
+                                               m_options.use_compression,
+                                               m_options.compression_level,
+                                               m_options.add_blob_hints ? encode_blob_hints(m_block_contents) : std::string{}}());
+
+                    m_block_contents = blob_contents{};
                 }
 
                 template <typename T>
@@ -549,133 +759,12 @@ namespace osmium {
                     }
                 }
 
-            public:
-
-                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
-                    OutputFormat(pool, output_queue),
-                    m_primitive_block(m_options) {
-
-                    if (!file.get("pbf_add_metadata").empty()) {
-                        throw std::invalid_argument{"The 'pbf_add_metadata' option is deprecated. Please use 'add_metadata' instead."};
-                    }
-
-                    m_options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
-                    m_options.use_compression = get_compression_type(file.get("pbf_compression"));
-                    m_options.add_metadata = osmium::metadata_options{file.get("add_metadata")};
-                    m_options.add_historical_information_flag = file.has_multiple_object_versions();
-                    m_options.add_visible_flag = file.has_multiple_object_versions();
-                    m_options.locations_on_ways = file.is_true("locations_on_ways");
-
-                    const auto pbl = file.get("pbf_compression_level");
-                    if (pbl.empty()) {
-                        switch (m_options.use_compression) {
-                            case pbf_compression::none:
-                                break;
-                            case pbf_compression::zlib:
-                                m_options.compression_level = osmium::io::detail::zlib_default_compression_level();
-                                break;
-                            case pbf_compression::lz4:
-#ifdef OSMIUM_WITH_LZ4
-                                m_options.compression_level = osmium::io::detail::lz4_default_compression_level();
-#endif
-                                break;
-                        }
-                    } else {
-                        char *end = nullptr;
-                        const auto val = std::strtol(pbl.c_str(), &end, 10);
-                        if (*end != '\0') {
-                            throw std::invalid_argument{"The 'pbf_compression_level' option must be an integer."};
-                        }
-                        switch (m_options.use_compression) {
-                            case pbf_compression::none:
-                                throw std::invalid_argument{"The 'pbf_compression_level' option doesn't make sense without 'pbf_compression' set."};
-                            case pbf_compression::zlib:
-                                osmium::io::detail::zlib_check_compression_level(val);
-                                break;
-                            case pbf_compression::lz4:
-#ifdef OSMIUM_WITH_LZ4
-                                osmium::io::detail::lz4_check_compression_level(val);
-#endif
-                                break;
-                        }
-                        m_options.compression_level = static_cast<int>(val);
-                    }
-                }
-
-                void write_header(const osmium::io::Header& header) final {
-                    std::string data;
-                    protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block{data};
-
-                    if (!header.boxes().empty()) {
-                        protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox{pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox};
-
-                        osmium::Box box = header.joined_boxes();
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
-                    }
-
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
-
-                    if (m_options.use_dense_nodes) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
-                    }
-
-                    if (m_options.add_historical_information_flag) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
-                    }
-
-                    if (m_options.locations_on_ways) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
-                    }
-
-                    if (header.get("sorting") == "Type_then_ID") {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "Sort.Type_then_ID");
-                    }
-
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
-
-                    const std::string osmosis_replication_timestamp{header.get("osmosis_replication_timestamp")};
-                    if (!osmosis_replication_timestamp.empty()) {
-                        osmium::Timestamp ts{osmosis_replication_timestamp.c_str()};
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
-                    }
-
-                    const std::string osmosis_replication_sequence_number{header.get("osmosis_replication_sequence_number")};
-                    if (!osmosis_replication_sequence_number.empty()) {
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, osmium::detail::str_to_int<int64_t>(osmosis_replication_sequence_number.c_str()));
-                    }
-
-                    const std::string osmosis_replication_base_url{header.get("osmosis_replication_base_url")};
-                    if (!osmosis_replication_base_url.empty()) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
-                    }
-
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(data),
-                                      pbf_blob_type::header,
-                                      m_options.use_compression,
-                                      m_options.compression_level}
-                        ));
-                }
-
-                void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    osmium::apply(buffer.cbegin(), buffer.cend(), *this);
-                }
-
-                void write_end() final {
-                    store_primitive_block();
-                }
-
-                void node(const osmium::Node& node) {
+                void encode_node(const osmium::Node& node) {
                     if (m_options.use_dense_nodes) {
-                        switch_primitive_block_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense);
                         m_primitive_block.add_dense_node(node);
                         return;
                     }
 
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
                     protozero::pbf_builder<OSMFormat::Node> pbf_node{m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
 
                     pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
@@ -685,8 +774,7 @@ namespace osmium {
                     pbf_node.add_sint64(OSMFormat::Node::required_sint64_lon, lonlat2int(node.location().lon_without_check()));
                 }
 
-                void way(const osmium::Way& way) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
+                void encode_way(const osmium::Way& way) {
                     protozero::pbf_builder<OSMFormat::Way> pbf_way{m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Way_ways};
 
                     pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
@@ -718,8 +806,7 @@ namespace osmium {
                     }
                 }
 
-                void relation(const osmium::Relation& relation) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
+                void encode_relation(const osmium::Relation& relation) {
                     protozero::pbf_builder<OSMFormat::Relation> pbf_relation{m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
 
                     pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
@@ -748,6 +835,360 @@ namespace osmium {
                     }
                 }
 
+                void encode_object(const osmium::OSMObject& object) {
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            encode_node(static_cast<const osmium::Node&>(object));
+                            break;
+                        case osmium::item_type::way:
+                            encode_way(static_cast<const osmium::Way&>(object));
+                            break;
+                        case osmium::item_type::relation:
+                            encode_relation(static_cast<const osmium::Relation&>(object));
+                            break;
+                        default:
+                            break;
+                    }
+                }
+
+                void add_object(const osmium::OSMObject& object) {
+                    if (m_options.sort_stringtable) {
+                        m_objects.push_back(&object);
+                    }
+                    m_block_contents.add(object);
+                    encode_object(object);
+                }
+
+            public:
+
+                explicit PBFBlockEncoder(const pbf_output_options& options) :
+                    m_options(options),
+                    m_primitive_block(options) {
+                }
+
+                PBFBlockEncoder(const PBFBlockEncoder&) = delete;
+                PBFBlockEncoder& operator=(const PBFBlockEncoder&) = delete;
+
+                PBFBlockEncoder(PBFBlockEncoder&&) = delete;
+                PBFBlockEncoder& operator=(PBFBlockEncoder&&) = delete;
+
+                ~PBFBlockEncoder() noexcept = default;
+
+                /**
+                 * Write out the last (partially filled) primitive block and
+                 * return all serialized blobs.
+                 */
+                std::string finish() {
+                    store_primitive_block();
+                    return std::move(m_out);
+                }
+
+                void node(const osmium::Node& node) {
+                    switch_primitive_block_type(m_options.use_dense_nodes ? OSMFormat::PrimitiveGroup::optional_DenseNodes_dense
+                                                                          : OSMFormat::PrimitiveGroup::repeated_Node_nodes);
+                    add_object(node);
+                }
+
+                void way(const osmium::Way& way) {
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
+                    add_object(way);
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
+                    add_object(relation);
+                }
+
+            }; // class PBFBlockEncoder
+
+            /**
+             * Encodes a group of buffers into PBF data blobs in a pool
+             * thread. Primitive blocks never span several PBFOutputBlocks.
+             *
+             * If there is only one buffer and it still contains exactly
+             * the objects from the PBF blob it was decoded from (see
+             * Buffer::source_data()), that blob is written out again
+             * instead of encoding the objects.
+             */
+            class PBFOutputBlock {
+
+                std::vector<std::shared_ptr<const osmium::memory::Buffer>> m_buffers;
+
+                pbf_output_options m_options;
+
+                std::string copy_source_blob() const {
+                    const auto& buffer = m_buffers.front();
+                    std::string indexdata;
+                    if (m_options.add_blob_hints) {
+                        blob_contents contents;
+                        for (const auto& object : buffer->select<osmium::OSMObject>()) {
+                            contents.add(object);
+                        }
+                        indexdata = encode_blob_hints(contents);
+                    }
+                    return frame_blob(*buffer->source_data(), pbf_blob_type::data, indexdata);
+                }
+
+            public:
+
+                PBFOutputBlock(std::vector<std::shared_ptr<const osmium::memory::Buffer>>&& buffers, const pbf_output_options& options) :
+                    m_buffers(std::move(buffers)),
+                    m_options(options) {
+                }
+
+                std::string operator()() {
+                    if (m_buffers.size() == 1 && m_buffers.front()->source_data_unchanged()) {
+                        return copy_source_blob();
+                    }
+
+                    PBFBlockEncoder encoder{m_options};
+                    for (const auto& buffer : m_buffers) {
+                        osmium::apply(buffer->cbegin(), buffer->cend(), encoder);
+                    }
+                    return encoder.finish();
+                }
+
+            }; // class PBFOutputBlock
+
+            /**
+             * Get the options for writing PBF from the file options.
+             *
+             * @throws std::invalid_argument If the options are invalid.
+             */
+            inline pbf_output_options get_pbf_output_options(const osmium::io::File& file) {
+                pbf_output_options options;
+
+                if (!file.get("pbf_add_metadata").empty()) {
+                    throw std::invalid_argument{"The 'pbf_add_metadata' option is deprecated. Please use 'add_metadata' instead."};
+                }
+
+                options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
+                options.use_compression = get_compression_type(file.get("pbf_compression"));
+                options.add_metadata = osmium::metadata_options{file.get("add_metadata")};
+                options.add_historical_information_flag = file.has_multiple_object_versions();
+                options.add_visible_flag = file.has_multiple_object_versions();
+                options.locations_on_ways = file.is_true("locations_on_ways");
+                options.sort_stringtable = file.is_true("pbf_sort_stringtable");
+                // Blob hints are most useful with locations on ways,
+                // because then blobs with untagged nodes can be skipped.
+                options.add_blob_hints = options.locations_on_ways ? file.is_not_false("pbf_blob_hints")
+                                                                   : file.is_true("pbf_blob_hints");
+                options.add_object_counts = file.is_true("pbf_object_counts");
+
+                const auto pbl = file.get("pbf_compression_level");
+                if (pbl.empty()) {
+                    switch (options.use_compression) {
+                        case pbf_compression::none:
+                            break;
+                        case pbf_compression::zlib:
+                            options.compression_level = osmium::io::detail::zlib_default_compression_level();
+                            break;
+                        case pbf_compression::lz4:
+#ifdef OSMIUM_WITH_LZ4
+                            options.compression_level = osmium::io::detail::lz4_default_compression_level();
+#endif
+                            break;
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            options.compression_level = osmium::io::detail::zstd_default_compression_level();
+#endif
+                            break;
+                    }
+                } else {
+                    char *end = nullptr;
+                    const auto val = std::strtol(pbl.c_str(), &end, 10);
+                    if (*end != '\0') {
+                        throw std::invalid_argument{"The 'pbf_compression_level' option must be an integer."};
+                    }
+                    switch (options.use_compression) {
+                        case pbf_compression::none:
+                            throw std::invalid_argument{"The 'pbf_compression_level' option doesn't make sense without 'pbf_compression' set."};
+                        case pbf_compression::zlib:
+                            osmium::io::detail::zlib_check_compression_level(val);
+                            break;
+                        case pbf_compression::lz4:
+#ifdef OSMIUM_WITH_LZ4
+                            osmium::io::detail::lz4_check_compression_level(val);
+#endif
+                            break;
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            osmium::io::detail::zstd_check_compression_level(val);
+#endif
+                            break;
+                    }
+                    options.compression_level = static_cast<int>(val);
+                }
+
+                return options;
+            }
+
+            /**
+             * Add the object counts and max ids set in the header as
+             * optional features "Count.Node=N", "MaxId.Node=N" etc. Readers
+             * can use them to presize their indexes.
+             */
+            inline void add_object_count_features(protozero::pbf_builder<OSMFormat::HeaderBlock>& pbf_header_block, const osmium::io::Header& header) {
+                static const char* const names[] = {"Node", "Way", "Relation"};
+                for (unsigned int n = 0; n < 3; ++n) {
+                    const auto type = osmium::nwr_index_to_item_type(n);
+                    const auto count = header.object_count(type);
+                    if (count > 0) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, std::string{"Count."} + names[n] + "=" + std::to_string(count));
+                    }
+                    const auto max_id = header.max_object_id(type);
+                    if (max_id > 0) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, std::string{"MaxId."} + names[n] + "=" + std::to_string(max_id));
+                    }
+                }
+            }
+
+            /**
+             * Serialize the header into a HeaderBlock message. It still
+             * has to be put into a Blob (see SerializeBlob).
+             */
+            inline std::string serialize_header_block(const osmium::io::Header& header, const pbf_output_options& options) {
+                std::string data;
+                protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block{data};
+
+                if (!header.boxes().empty()) {
+                    protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox{pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox};
+
+                    osmium::Box box = header.joined_boxes();
+                    pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
+                    pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
+                    pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
+                    pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
+                }
+
+                pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
+
+                if (options.use_dense_nodes) {
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
+                }
+
+                if (options.add_historical_information_flag) {
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
+                }
+
+                if (options.locations_on_ways) {
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
+                }
+
+                if (header.get("sorting") == "Type_then_ID") {
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "Sort.Type_then_ID");
+                }
+
+                if (options.add_object_counts) {
+                    add_object_count_features(pbf_header_block, header);
+                }
+
+                pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
+
+                const std::string osmosis_replication_timestamp{header.get("osmosis_replication_timestamp")};
+                if (!osmosis_replication_timestamp.empty()) {
+                    osmium::Timestamp ts{osmosis_replication_timestamp.c_str()};
+                    pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
+                }
+
+                const std::string osmosis_replication_sequence_number{header.get("osmosis_replication_sequence_number")};
+                if (!osmosis_replication_sequence_number.empty()) {
+                    pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, osmium::detail::str_to_int<int64_t>(osmosis_replication_sequence_number.c_str()));
+                }
+
+                const std::string osmosis_replication_base_url{header.get("osmosis_replication_base_url")};
+                if (!osmosis_replication_base_url.empty()) {
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
+                }
+
+                return data;
+            }
+
+            class PBFOutputFormat : public osmium::io::detail::OutputFormat {
+
+                /**
+                 * Buffers are collected until they hold at least this many
+                 * bytes, and are then encoded together in a pool thread.
+                 * This keeps the primitive blocks reasonably full even when
+                 * the buffers written are small.
+                 */
+                enum : std::size_t {
+                    min_bytes_per_block = 8UL * 1024UL * 1024UL
+                };
+
+                pbf_output_options m_options;
+
+                std::vector<std::shared_ptr<const osmium::memory::Buffer>> m_buffers;
+
+                std::size_t m_buffered_bytes = 0;
+
+                void submit_buffers() {
+                    if (m_buffers.empty()) {
+                        return;
+                    }
+
+                    send_to_output_queue_from_pool(PBFOutputBlock{std::move(m_buffers), m_options}, m_buffered_bytes);
+                    m_buffers.clear();
+                    m_buffered_bytes = 0;
+                }
+
+            public:
+
+                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue),
+                    m_options(get_pbf_output_options(file)) {
+                }
+
+                void write_header(const osmium::io::Header& header) final {
+                    m_output_queue.push(submit_to_pool(
+                        SerializeBlob{serialize_header_block(header, m_options),
+                                      pbf_blob_type::header,
+                                      m_options.use_compression,
+                                      m_options.compression_level}
+                        ));
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    if (buffer.committed() == 0) {
+                        return;
+                    }
+                    write_shared_buffer(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)));
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    if (buffer->committed() == 0) {
+                        return;
+                    }
+
+                    // Buffers decoded from PBF data blobs are sent off on
+                    // their own, so the original blob can be reused if the
+                    // buffer wasn't changed. This is only done if all the
+                    // metadata is written, otherwise the objects must be
+                    // encoded again to remove it.
+                    if (buffer->source_data() && m_options.add_metadata.all()) {
+                        submit_buffers();
+                        m_buffers.push_back(buffer);
+                        submit_buffers();
+                        return;
+                    }
+
+                    m_buffered_bytes += buffer->committed();
+                    m_buffers.push_back(buffer);
+                    if (m_buffered_bytes >= min_bytes_per_block) {
+                        submit_buffers();
+                    }
+                }
+
+                void write_encoded(std::string&& data) final {
+                    check_pbf_data_frames(data);
+                    submit_buffers();
+                    send_to_output_queue(std::move(data));
+                }
+
+                void write_end() final {
+                    submit_buffers();
+                }
+
             }; // class PBFOutputFormat
 
             // we want the register_output_format() function to run, setting
@@ -165,6 +165,24 @@ namespace osmium {
 
             } // namespace OSMFormat
 
+            // Not part of the OSMPBF format. This message is written by
+            // Osmium into the (otherwise unused) BlobHeader.indexdata
+            // field to describe the contents of a Blob, so that readers
+            // can skip Blobs without decompressing them.
+
+            namespace OsmiumFormat {
+
+                enum class BlobHints : protozero::pbf_tag_type {
+                    required_string_generator      = 1,
+                    optional_uint32_types          = 2,
+                    optional_bool_has_tagged_nodes = 3,
+                    optional_sint64_first_id       = 4,
+                    optional_sint64_last_id        = 5,
+                    optional_bool_sorted           = 6
+                };
+
+            } // namespace OsmiumFormat
+
         } // namespace detail
 
     } // namespace io
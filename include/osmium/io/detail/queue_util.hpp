@@ -36,7 +36,8 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/memory/buffer.hpp>
 #include <osmium/thread/queue.hpp>
 
-#include <cassert>
+#include <chrono>
+#include <cstddef>
 #include <exception>
 #include <future>
 #include <string>
@@ -49,7 +50,7 @@ namespace osmium {
         namespace detail {
 
             template <typename T>
-            using future_queue_type = osmium::thread::Queue<std::future<T>>;
+            using future_queue_type = osmium::thread::pipeline_queue<std::future<T>>;
 
             /**
              * This type of queue contains buffers with OSM data in them.
@@ -70,10 +71,22 @@ namespace osmium {
              */
             using future_string_queue_type = future_queue_type<std::string>;
 
+            /**
+             * The number of bytes the data takes up in a queue. This is
+             * used for queues limited by the number of bytes in them.
+             */
+            inline std::size_t queue_bytes(const std::string& data) noexcept {
+                return data.size();
+            }
+
+            inline std::size_t queue_bytes(const osmium::memory::Buffer& buffer) noexcept {
+                return buffer.committed();
+            }
+
             template <typename T>
             inline void add_to_queue(future_queue_type<T>& queue, T&& data) {
                 std::promise<T> promise;
-                queue.push(promise.get_future());
+                queue.push(promise.get_future(), queue_bytes(data));
                 promise.set_value(std::forward<T>(data));
             }
 
@@ -84,9 +97,13 @@ namespace osmium {
                 promise.set_exception(std::move(exception));
             }
 
+            /**
+             * The end of data is marked by an invalid future in the queue,
+             * so that empty strings or buffers can be sent as normal data.
+             */
             template <typename T>
             inline void add_end_of_data_to_queue(future_queue_type<T>& queue) {
-                add_to_queue<T>(queue, T{});
+                queue.push(std::future<T>{});
             }
 
             inline bool at_end_of_data(const std::string& data) noexcept {
@@ -101,12 +118,15 @@ namespace osmium {
             class queue_wrapper {
 
                 future_queue_type<T>& m_queue;
+                std::future<T> m_next;
+                bool m_has_next;
                 bool m_has_reached_end_of_data;
 
             public:
 
                 explicit queue_wrapper(future_queue_type<T>& queue) :
                     m_queue(queue),
+                    m_has_next(false),
                     m_has_reached_end_of_data(false) {
                 }
 
@@ -138,16 +158,45 @@ namespace osmium {
                     T data;
                     if (!m_has_reached_end_of_data) {
                         std::future<T> data_future;
-                        m_queue.wait_and_pop(data_future);
-                        assert(data_future.valid());
-                        data = std::move(data_future.get());
-                        if (at_end_of_data(data)) {
+                        if (m_has_next) {
+                            data_future = std::move(m_next);
+                            m_has_next = false;
+                        } else {
+                            m_queue.wait_and_pop(data_future);
+                        }
+                        if (data_future.valid()) {
+                            data = std::move(data_future.get());
+                        } else {
                             m_has_reached_end_of_data = true;
                         }
                     }
                     return data;
                 }
 
+                /**
+                 * Get the next data from the queue only if it is available
+                 * without waiting.
+                 *
+                 * @param data Set to the data if it was available.
+                 * @returns true if data was available.
+                 */
+                bool try_pop(T& data) {
+                    if (m_has_reached_end_of_data) {
+                        return false;
+                    }
+                    if (!m_has_next) {
+                        if (!m_queue.try_pop(m_next)) {
+                            return false;
+                        }
+                        m_has_next = true;
+                    }
+                    if (m_next.valid() && m_next.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+                        return false;
+                    }
+                    data = pop();
+                    return true;
+                }
+
             }; // class queue_wrapper
 
         } // namespace detail
@@ -0,0 +1,239 @@
+#ifndef OSMIUM_IO_DETAIL_RANGE_DECOMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_RANGE_DECOMPRESSOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/range_source.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/misc.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            enum : std::size_t {
+                default_parallel_ranges = 4,
+                default_range_size = 8UL * 1024UL * 1024UL
+            };
+
+            /**
+             * Decompressor (for uncompressed data) reading the input from
+             * a RangeSource with several range requests in flight at the
+             * same time. The requests run on their own small thread pool,
+             * because they mostly wait for the network and shouldn't block
+             * the pool threads decoding the data. The results are handed
+             * out in order by read() and from there go through the normal
+             * input queue to the parser.
+             */
+            class RangeDecompressor final : public osmium::io::Decompressor {
+
+                std::unique_ptr<osmium::io::RangeSource> m_owned_source;
+                osmium::io::RangeSource& m_source;
+                std::vector<osmium::io::byte_range> m_ranges;
+                osmium::thread::Pool m_pool;
+                std::deque<std::future<std::string>> m_results{};
+                std::size_t m_next_range = 0;
+                std::size_t m_max_in_flight;
+
+                void submit_ranges() {
+                    while (m_next_range < m_ranges.size() && m_results.size() < m_max_in_flight) {
+                        osmium::io::RangeSource* source = &m_source;
+                        const auto range = m_ranges[m_next_range];
+                        m_results.push_back(m_pool.submit([source, range]() {
+                            return source->read(range);
+                        }));
+                        ++m_next_range;
+                    }
+                }
+
+            public:
+
+                /**
+                 * Construct decompressor.
+                 *
+                 * @param source The source to read from. Must stay valid
+                 *               for the lifetime of this object.
+                 * @param range_size Size of each range request. The
+                 *                   source can split differently.
+                 * @param parallel Number of range requests in flight.
+                 */
+                RangeDecompressor(osmium::io::RangeSource& source, const std::size_t range_size, const std::size_t parallel) :
+                    m_source(source),
+                    m_ranges(source.ranges(range_size)),
+                    m_pool(static_cast<int>(parallel)),
+                    m_max_in_flight(parallel * 2) {
+                    set_file_size(source.size());
+                }
+
+                /**
+                 * Construct decompressor owning its source.
+                 */
+                RangeDecompressor(std::unique_ptr<osmium::io::RangeSource>&& source, const std::size_t range_size, const std::size_t parallel) :
+                    RangeDecompressor(*source, range_size, parallel) {
+                    m_owned_source = std::move(source);
+                }
+
+                RangeDecompressor(const RangeDecompressor&) = delete;
+                RangeDecompressor& operator=(const RangeDecompressor&) = delete;
+
+                RangeDecompressor(RangeDecompressor&&) = delete;
+                RangeDecompressor& operator=(RangeDecompressor&&) = delete;
+
+                ~RangeDecompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                std::string read() override {
+                    std::string output;
+
+                    // An empty string signals the end of the data, so skip
+                    // over empty ranges.
+                    while (output.empty()) {
+                        submit_ranges();
+                        if (m_results.empty()) {
+                            break;
+                        }
+                        output = m_results.front().get();
+                        m_results.pop_front();
+                        const auto& range = m_ranges[m_next_range - m_results.size() - 1];
+                        set_offset(range.offset + range.size);
+                    }
+
+                    return output;
+                }
+
+                void close() override {
+                    // Wait for all running requests, they reference the
+                    // source.
+                    for (auto& result : m_results) {
+                        result.wait();
+                    }
+                    m_results.clear();
+                    m_next_range = m_ranges.size();
+                }
+
+            }; // class RangeDecompressor
+
+            inline std::size_t get_size_option(const osmium::io::File& file, const char* name, const std::size_t default_value) {
+                const std::string value = file.get(name);
+                if (value.empty()) {
+                    return default_value;
+                }
+                const auto result = osmium::detail::str_to_int<std::size_t>(value.c_str());
+                if (result == 0) {
+                    throw std::invalid_argument{std::string{"Invalid value for option '"} + name + "'"};
+                }
+                return result;
+            }
+
+            /**
+             * Create a RangeDecompressor for the file if either a source
+             * is given or the "parallel_ranges" option is set on the file.
+             * Without source, "http" and "https" URLs are read with a
+             * CurlRangeSource, normal files with a FileRangeSource.
+             *
+             * The "parallel_ranges" option sets the number of requests in
+             * flight, the "range_size" option the size of each request
+             * in bytes.
+             *
+             * @returns The decompressor or nullptr if the normal way of
+             *          reading should be used.
+             * @throws osmium::io_error If a source is given but the file
+             *         is compressed.
+             */
+            inline std::unique_ptr<osmium::io::Decompressor> create_range_decompressor(const osmium::io::File& file, osmium::io::RangeSource* source) {
+                const std::size_t range_size = get_size_option(file, "range_size", default_range_size);
+
+                if (source) {
+                    if (file.compression() != file_compression::none) {
+                        throw io_error{"Reading through a RangeSource only works for uncompressed files"};
+                    }
+                    const std::size_t parallel = get_size_option(file, "parallel_ranges", default_parallel_ranges);
+                    return std::unique_ptr<osmium::io::Decompressor>{new RangeDecompressor{*source, range_size, parallel}};
+                }
+
+                if (file.get("parallel_ranges").empty() ||
+                    file.compression() != file_compression::none ||
+                    file.buffer() ||
+                    file.filename().empty() ||
+                    file.filename() == "-") {
+                    return nullptr;
+                }
+
+                const std::size_t parallel = get_size_option(file, "parallel_ranges", default_parallel_ranges);
+
+                const std::string& filename = file.filename();
+                const std::string protocol{filename.substr(0, filename.find_first_of(':'))};
+                if (protocol == "http" || protocol == "https") {
+#ifndef _WIN32
+                    std::unique_ptr<osmium::io::RangeSource> url_source{new osmium::io::CurlRangeSource{filename}};
+                    return std::unique_ptr<osmium::io::Decompressor>{new RangeDecompressor{std::move(url_source), range_size, parallel}};
+#else
+                    return nullptr;
+#endif
+                }
+
+                if (filename.find("://") != std::string::npos) {
+                    return nullptr;
+                }
+
+                std::unique_ptr<osmium::io::RangeSource> file_source{new osmium::io::FileRangeSource{filename}};
+                return std::unique_ptr<osmium::io::Decompressor>{new RangeDecompressor{std::move(file_source), range_size, parallel}};
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_RANGE_DECOMPRESSOR_HPP
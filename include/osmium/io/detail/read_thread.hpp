@@ -36,8 +36,11 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <string>
 #include <thread>
@@ -54,6 +57,10 @@ namespace osmium {
              * the input file and (optionally) decompress it. The result is
              * sent to the given queue. Any exceptions will also be send to
              * the queue.
+             *
+             * If no thread is started, call run() to do the reading in the
+             * calling thread. The queue must be large enough to hold all
+             * the data in that case.
              */
             class ReadThreadManager {
 
@@ -63,38 +70,27 @@ namespace osmium {
 
                 // used in both threads
                 std::atomic<bool> m_done;
+                std::atomic<std::size_t> m_bytes_read{0};
 
                 // only used in the main thread
                 std::thread m_thread;
 
                 void run_in_thread() {
                     osmium::thread::set_thread_name("_osmium_read");
-
-                    try {
-                        while (!m_done) {
-                            std::string data{m_decompressor.read()};
-                            if (at_end_of_data(data)) {
-                                break;
-                            }
-                            add_to_queue(m_queue, std::move(data));
-                        }
-
-                        m_decompressor.close();
-                    } catch (...) {
-                        add_to_queue(m_queue, std::current_exception());
-                    }
-
-                    add_end_of_data_to_queue(m_queue);
+                    run();
                 }
 
             public:
 
                 ReadThreadManager(osmium::io::Decompressor& decompressor,
-                                  future_string_queue_type& queue) :
+                                  future_string_queue_type& queue,
+                                  bool start_thread = true) :
                     m_decompressor(decompressor),
                     m_queue(queue),
-                    m_done(false),
-                    m_thread(std::thread(&ReadThreadManager::run_in_thread, this)) {
+                    m_done(false) {
+                    if (start_thread) {
+                        m_thread = std::thread(&ReadThreadManager::run_in_thread, this);
+                    }
                 }
 
                 ReadThreadManager(const ReadThreadManager&) = delete;
@@ -111,6 +107,42 @@ namespace osmium {
                     }
                 }
 
+                /**
+                 * Read all data and send it to the queue followed by the
+                 * end of data marker. This is what the thread does, call
+                 * it directly only if no thread was started.
+                 */
+                void run() {
+                    try {
+                        for (uint64_t sequence = 0; !m_done; ++sequence) {
+                            std::string data;
+                            {
+                                const osmium::util::TraceScope trace{osmium::util::trace_stage::read, sequence};
+                                data = m_decompressor.read();
+                            }
+                            if (at_end_of_data(data)) {
+                                break;
+                            }
+                            m_bytes_read.fetch_add(data.size(), std::memory_order_relaxed);
+                            add_to_queue(m_queue, std::move(data));
+                        }
+
+                        m_decompressor.close();
+                    } catch (...) {
+                        add_to_queue(m_queue, std::current_exception());
+                    }
+
+                    add_end_of_data_to_queue(m_queue);
+                }
+
+                /**
+                 * The number of (uncompressed) bytes sent to the queue so
+                 * far. Can be called from any thread.
+                 */
+                std::size_t bytes_read() const noexcept {
+                    return m_bytes_read.load(std::memory_order_relaxed);
+                }
+
                 void stop() noexcept {
                     m_done = true;
                 }
@@ -36,11 +36,18 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/writer_options.hpp>
 #include <osmium/util/file.hpp>
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstddef>
 #include <fcntl.h>
 #include <string>
 #include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/uio.h>
+#endif
 
 namespace osmium {
 
@@ -89,6 +96,30 @@ namespace osmium {
                 return fd;
             }
 
+            /**
+             * Open file for appending. If the file doesn't exist, it is
+             * created.
+             *
+             * @param filename Name of file to be opened.
+             * @returns File descriptor of open file.
+             * @throws system_error if the file can't be opened.
+             */
+            inline int open_for_appending(const std::string& filename) {
+#ifdef _MSC_VER
+                osmium::detail::disable_invalid_parameter_handler diph;
+#endif
+
+                int flags = O_WRONLY | O_CREAT | O_APPEND; // NOLINT(hicpp-signed-bitwise)
+#ifdef _WIN32
+                flags |= O_BINARY; // NOLINT(hicpp-signed-bitwise)
+#endif
+                const int fd = ::open(filename.c_str(), flags, 0666);
+                if (fd < 0) {
+                    throw std::system_error{errno, std::system_category(), std::string("Open failed for '") + filename + "'"};
+                }
+                return fd;
+            }
+
             /**
              * Open file for reading. If the file name is empty or "-", no file
              * is opened and the stdin file descriptor (0) is returned.
@@ -168,6 +199,105 @@ namespace osmium {
                 reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer), size);
             }
 
+            /**
+             * Writes the given number of bytes from the output_buffer to the
+             * file descriptor at the given offset using pwrite(2). The file
+             * offset of the descriptor is not changed, so several threads
+             * can write to different parts of the same file at the same
+             * time.
+             *
+             * There is no pwrite(2) on Windows, this always fails there.
+             *
+             * @param fd File descriptor.
+             * @param output_buffer Buffer with data to be written. Must be at least size bytes long.
+             * @param size Number of bytes to write.
+             * @param offset Offset in the file.
+             * @throws std::system_error On error.
+             */
+            inline void reliable_pwrite(const int fd, const unsigned char* output_buffer, const size_t size, const size_t offset) {
+                enum : std::size_t {
+                    // Max 100 MByte per write
+                    max_write = 100UL * 1024UL * 1024UL
+                };
+                size_t done = 0;
+                while (done < size) {
+                    const auto write_count = std::min(size - done, std::size_t(max_write));
+#ifndef _WIN32
+                    const auto length = ::pwrite(fd, output_buffer + done, write_count, static_cast<off_t>(offset + done));
+#else
+                    (void)fd;
+                    (void)output_buffer;
+                    (void)write_count;
+                    const int64_t length = -1;
+                    errno = ENOSYS;
+#endif
+                    if (length < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        throw std::system_error{errno, std::system_category(), "Write failed"};
+                    }
+                    done += static_cast<size_t>(length);
+                }
+            }
+
+            /**
+             * Writes all the given blocks to the file descriptor using as
+             * few writev(2) calls as possible. Handles partial writes.
+             *
+             * @param fd File descriptor.
+             * @param blocks Blocks to write in this order.
+             * @throws std::system_error On error.
+             */
+            inline void reliable_writev(const int fd, const std::vector<std::string>& blocks) {
+#ifdef _WIN32
+                for (const auto& block : blocks) {
+                    reliable_write(fd, block.data(), block.size());
+                }
+#else
+# ifdef IOV_MAX
+                enum : std::size_t {
+                    max_iov = IOV_MAX
+                };
+# else
+                enum : std::size_t {
+                    max_iov = 1024
+                };
+# endif
+                std::vector<iovec> iov;
+                iov.reserve(blocks.size());
+                for (const auto& block : blocks) {
+                    if (!block.empty()) {
+                        iov.push_back(iovec{const_cast<char*>(block.data()), block.size()}); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+                    }
+                }
+
+                std::size_t first = 0;
+                while (first < iov.size()) {
+                    const auto count = std::min(iov.size() - first, std::size_t(max_iov));
+                    const auto length = ::writev(fd, &iov[first], static_cast<int>(count));
+                    if (length < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        throw std::system_error{errno, std::system_category(), "Write failed"};
+                    }
+
+                    // Skip over everything written, the first iovec not
+                    // written completely is adjusted.
+                    auto written = static_cast<std::size_t>(length);
+                    while (first < iov.size() && written >= iov[first].iov_len) {
+                        written -= iov[first].iov_len;
+                        ++first;
+                    }
+                    if (written > 0) {
+                        iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + written;
+                        iov[first].iov_len -= written;
+                    }
+                }
+#endif
+            }
+
             /**
              * Reads a maximum of size bytes from the file descriptor into the
              * input_buffer. This is just a wrapper around read(2) catching
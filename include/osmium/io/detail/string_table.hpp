@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/detail/pbf.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -44,6 +45,7 @@ DEALINGS IN THE SOFTWARE.
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -224,6 +226,42 @@ namespace osmium {
 
             }; // struct djb2_hash
 
+            /**
+             * Hash function for null-terminated strings working on eight
+             * bytes at a time. Much faster than djb2_hash on the keys and
+             * values typically found in OSM data.
+             */
+            struct str_hash {
+
+                static uint64_t mix(uint64_t value) noexcept {
+                    value *= 0xbf58476d1ce4e5b9ULL;
+                    return value ^ (value >> 31U);
+                }
+
+                std::size_t operator()(const char* str) const noexcept {
+                    const std::size_t len = std::strlen(str);
+                    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ (static_cast<uint64_t>(len) * 0xff51afd7ed558ccdULL);
+
+                    const char* const end = str + (len & ~static_cast<std::size_t>(7U));
+                    for (; str != end; str += 8) {
+                        uint64_t word = 0;
+                        std::memcpy(&word, str, 8);
+                        hash = mix(hash ^ word);
+                    }
+
+                    uint64_t word = 0;
+                    std::memcpy(&word, str, len & 7U);
+                    hash = mix(hash ^ word);
+
+                    hash ^= hash >> 33U;
+                    hash *= 0xc4ceb9fe1a85ec53ULL;
+                    hash ^= hash >> 33U;
+
+                    return static_cast<std::size_t>(hash);
+                }
+
+            }; // struct str_hash
+
             class StringTable {
 
                 // This is the maximum number of entries in a string table.
@@ -247,14 +285,24 @@ namespace osmium {
                 };
 
                 StringStore m_strings;
-                std::unordered_map<const char*, int32_t, djb2_hash, str_equal> m_index;
+                std::unordered_map<const char*, int32_t, str_hash, str_equal> m_index;
                 int32_t m_size = 0;
 
+                // How often each string was added, indexed by id.
+                std::vector<uint32_t> m_counts;
+
+                // After sort_by_frequency() was called, this maps the
+                // original ids to the new ids and m_sorted contains the
+                // strings in the new order. Both are empty otherwise.
+                std::vector<int32_t> m_remap;
+                std::vector<const char*> m_sorted;
+
             public:
 
                 explicit StringTable(size_t size = default_stringtable_chunk_size) :
                     m_strings(size) {
                     m_strings.add("");
+                    m_counts.push_back(0);
                 }
 
                 void clear() {
@@ -262,6 +310,9 @@ namespace osmium {
                     m_index.clear();
                     m_size = 0;
                     m_strings.add("");
+                    m_counts.assign(1, 0);
+                    m_remap.clear();
+                    m_sorted.clear();
                 }
 
                 int32_t size() const noexcept {
@@ -271,6 +322,10 @@ namespace osmium {
                 int32_t add(const char* s) {
                     const auto f = m_index.find(s);
                     if (f != m_index.end()) {
+                        if (is_sorted()) {
+                            return m_remap[f->second];
+                        }
+                        ++m_counts[f->second];
                         return f->second;
                     }
 
@@ -281,9 +336,75 @@ namespace osmium {
                         throw osmium::pbf_error{"string table has too many entries"};
                     }
 
+                    m_counts.push_back(1);
+                    if (is_sorted()) {
+                        m_remap.push_back(m_size);
+                        m_sorted.push_back(cs);
+                    }
+
                     return m_size;
                 }
 
+                /**
+                 * How often was the string with the specified id added to
+                 * the table? Only counts additions before sort_by_frequency()
+                 * was called.
+                 */
+                uint32_t count(int32_t id) const noexcept {
+                    assert(id >= 0 && id <= m_size);
+                    return m_counts[id];
+                }
+
+                /**
+                 * Reorder the table so that the most often used strings get
+                 * the smallest ids. Strings used equally often stay in the
+                 * order they were added in. The empty string at id 0 always
+                 * stays in place.
+                 *
+                 * After this, add() returns the new ids, and the strings in
+                 * the new order are available from sorted_strings().
+                 */
+                void sort_by_frequency() {
+                    std::vector<const char*> strings;
+                    strings.reserve(m_size + 1);
+                    for (const char* str : m_strings) {
+                        strings.push_back(str);
+                    }
+                    assert(strings.size() == static_cast<std::size_t>(m_size) + 1);
+
+                    std::vector<int32_t> ids;
+                    ids.reserve(m_size);
+                    for (int32_t id = 1; id <= m_size; ++id) {
+                        ids.push_back(id);
+                    }
+                    std::stable_sort(ids.begin(), ids.end(), [this](int32_t a, int32_t b) {
+                        return m_counts[a] > m_counts[b];
+                    });
+
+                    m_remap.assign(m_size + 1, 0);
+                    m_sorted.clear();
+                    m_sorted.reserve(m_size + 1);
+                    m_sorted.push_back(strings[0]);
+                    int32_t new_id = 0;
+                    for (const int32_t id : ids) {
+                        m_remap[id] = ++new_id;
+                        m_sorted.push_back(strings[id]);
+                    }
+                }
+
+                /// Has sort_by_frequency() been called since the last clear()?
+                bool is_sorted() const noexcept {
+                    return !m_sorted.empty();
+                }
+
+                /**
+                 * The strings in the order set by sort_by_frequency().
+                 * Empty if the table isn't sorted.
+                 */
+                const std::vector<const char*>& sorted_strings() const noexcept {
+                    return m_sorted;
+                }
+
                 StringStore::const_iterator begin() const {
                     return m_strings.begin();
                 }
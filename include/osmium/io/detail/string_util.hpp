@@ -41,6 +41,14 @@ DEALINGS IN THE SOFTWARE.
 #include <string>
 #include <utility>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define OSMIUM_STRING_UTIL_SSE2
+#elif defined(__ARM_NEON) && (defined(__GNUC__) || defined(__clang__))
+# include <arm_neon.h>
+# define OSMIUM_STRING_UTIL_NEON
+#endif
+
 namespace osmium {
 
     namespace io {
@@ -203,11 +211,265 @@ namespace osmium {
                 out += hex_digits[ value         & 0xfU];
             }
 
+            /**
+             * Write the decimal digits of value into the buffer ending at
+             * end, two digits at a time, working backwards.
+             *
+             * @returns Pointer to the first digit written.
+             */
+            inline char* write_uint_backwards(char* end, uint64_t value) noexcept {
+                static const char digit_pairs[] =
+                    "00010203040506070809"
+                    "10111213141516171819"
+                    "20212223242526272829"
+                    "30313233343536373839"
+                    "40414243444546474849"
+                    "50515253545556575859"
+                    "60616263646566676869"
+                    "70717273747576777879"
+                    "80818283848586878889"
+                    "90919293949596979899";
+
+                while (value >= 100) {
+                    const auto index = static_cast<std::size_t>(value % 100) * 2;
+                    value /= 100;
+                    *--end = digit_pairs[index + 1];
+                    *--end = digit_pairs[index];
+                }
+
+                if (value >= 10) {
+                    const auto index = static_cast<std::size_t>(value) * 2;
+                    *--end = digit_pairs[index + 1];
+                    *--end = digit_pairs[index];
+                } else {
+                    *--end = static_cast<char>('0' + value);
+                }
+
+                return end;
+            }
+
+            /**
+             * Append the decimal representation of value to out, right
+             * aligned in a field of at least width characters filled with
+             * fill (usually ' ' or '0'). Works like the printf format "%*d"
+             * or "%0*d" (when fill is '0'), but much faster.
+             */
+            inline void append_int_to_string(std::string& out, int64_t value, int width = 0, char fill = ' ') {
+                // Enough for all digits of a 64 bit integer and the sign.
+                char buffer[21];
+                char* const end = buffer + sizeof(buffer);
+
+                const bool negative = value < 0;
+                const uint64_t abs_value = negative ? 0 - static_cast<uint64_t>(value)
+                                                    : static_cast<uint64_t>(value);
+
+                char* begin = write_uint_backwards(end, abs_value);
+                if (negative && fill != '0') {
+                    *--begin = '-';
+                }
+
+                const auto len = static_cast<int>(end - begin) + ((negative && fill == '0') ? 1 : 0);
+                if (negative && fill == '0') {
+                    out += '-';
+                }
+                if (width > len) {
+                    out.append(static_cast<std::size_t>(width - len), fill);
+                }
+
+                out.append(begin, end);
+            }
+
+            /**
+             * Append the lowercase hexadecimal representation of value to
+             * out without leading zeros. Works like the printf format "%x".
+             */
+            inline void append_hex_to_string(std::string& out, uint32_t value) {
+                static const char* lookup_hex = "0123456789abcdef";
+
+                char buffer[8];
+                char* const end = buffer + sizeof(buffer);
+                char* begin = end;
+                do {
+                    *--begin = lookup_hex[value & 0xfU];
+                    value >>= 4U;
+                } while (value != 0);
+
+                out.append(begin, end);
+            }
+
+            // Number of trailing zero bits. Value must not be 0.
+            inline unsigned int string_util_ctz(uint64_t value) noexcept {
+                assert(value != 0);
+#if defined(__GNUC__) || defined(__clang__)
+                return static_cast<unsigned int>(__builtin_ctzll(value));
+#else
+                unsigned int n = 0;
+                while ((value & 1U) == 0) {
+                    value >>= 1U;
+                    ++n;
+                }
+                return n;
+#endif
+            }
+
+            // Characters escaped in XML. See append_xml_encoded_string().
+            inline bool is_xml_special_char(const char c) noexcept {
+                return c == '&' || c == '"' || c == '\'' || c == '<' || c == '>' ||
+                       c == '\n' || c == '\r' || c == '\t';
+            }
+
+            // ASCII characters not escaped in OPL. Everything else has to
+            // go through the check in append_utf8_encoded_string().
+            inline bool is_opl_plain_char(const char c) noexcept {
+                return c > 0x20 && c < 0x7f && c != '%' && c != ',' && c != '=' && c != '@';
+            }
+
+            /**
+             * Find the first character in [data, end) for which
+             * is_xml_special_char() is true. The string is scanned 16 bytes
+             * at a time with SSE2 or NEON if available.
+             *
+             * @returns Pointer to the character or end if there is none.
+             */
+            inline const char* find_xml_special_char(const char* data, const char* const end) noexcept {
+#if defined(OSMIUM_STRING_UTIL_SSE2)
+                const __m128i amp   = _mm_set1_epi8('&');
+                const __m128i quot  = _mm_set1_epi8('"');
+                const __m128i apos  = _mm_set1_epi8('\'');
+                const __m128i lt    = _mm_set1_epi8('<');
+                const __m128i gt    = _mm_set1_epi8('>');
+                const __m128i nl    = _mm_set1_epi8('\n');
+                const __m128i cr    = _mm_set1_epi8('\r');
+                const __m128i tab   = _mm_set1_epi8('\t');
+                for (; end - data >= 16; data += 16) {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                    const __m128i a = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, quot)),
+                                                   _mm_or_si128(_mm_cmpeq_epi8(v, apos), _mm_cmpeq_epi8(v, lt)));
+                    const __m128i b = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, nl)),
+                                                   _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, tab)));
+                    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(a, b)));
+                    if (mask != 0) {
+                        return data + string_util_ctz(mask);
+                    }
+                }
+#elif defined(OSMIUM_STRING_UTIL_NEON)
+                for (; end - data >= 16; data += 16) {
+                    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data));
+                    const uint8x16_t a = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('&')), vceqq_u8(v, vdupq_n_u8('"'))),
+                                                  vorrq_u8(vceqq_u8(v, vdupq_n_u8('\'')), vceqq_u8(v, vdupq_n_u8('<'))));
+                    const uint8x16_t b = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('>')), vceqq_u8(v, vdupq_n_u8('\n'))),
+                                                  vorrq_u8(vceqq_u8(v, vdupq_n_u8('\r')), vceqq_u8(v, vdupq_n_u8('\t'))));
+                    // Narrow to 4 bits per byte to get a 64 bit mask.
+                    const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(vorrq_u8(a, b)), 4)), 0);
+                    if (mask != 0) {
+                        return data + string_util_ctz(mask) / 4;
+                    }
+                }
+#endif
+                for (; data != end; ++data) {
+                    if (is_xml_special_char(*data)) {
+                        return data;
+                    }
+                }
+                return end;
+            }
+
+            /**
+             * Find the first newline or carriage return character in
+             * [data, end). The string is scanned 16 bytes at a time with
+             * SSE2 or NEON if available.
+             *
+             * @returns Pointer to the character or end if there is none.
+             */
+            inline const char* find_line_end(const char* data, const char* const end) noexcept {
+#if defined(OSMIUM_STRING_UTIL_SSE2)
+                const __m128i nl = _mm_set1_epi8('\n');
+                const __m128i cr = _mm_set1_epi8('\r');
+                for (; end - data >= 16; data += 16) {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr))));
+                    if (mask != 0) {
+                        return data + string_util_ctz(mask);
+                    }
+                }
+#elif defined(OSMIUM_STRING_UTIL_NEON)
+                for (; end - data >= 16; data += 16) {
+                    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data));
+                    const uint8x16_t m = vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r')));
+                    const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+                    if (mask != 0) {
+                        return data + string_util_ctz(mask) / 4;
+                    }
+                }
+#endif
+                for (; data != end; ++data) {
+                    if (*data == '\n' || *data == '\r') {
+                        return data;
+                    }
+                }
+                return end;
+            }
+
+            /**
+             * Find the first character in [data, end) for which
+             * is_opl_plain_char() is false. The string is scanned 16 bytes
+             * at a time with SSE2 or NEON if available.
+             *
+             * @returns Pointer to the character or end if there is none.
+             */
+            inline const char* find_opl_non_plain_char(const char* data, const char* const end) noexcept {
+#if defined(OSMIUM_STRING_UTIL_SSE2)
+                const __m128i low     = _mm_set1_epi8(0x21);
+                const __m128i high    = _mm_set1_epi8(0x7e);
+                const __m128i percent = _mm_set1_epi8('%');
+                const __m128i comma   = _mm_set1_epi8(',');
+                const __m128i equal   = _mm_set1_epi8('=');
+                const __m128i at      = _mm_set1_epi8('@');
+                for (; end - data >= 16; data += 16) {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                    // The comparisons are signed, so bytes >= 0x80 are
+                    // smaller than 0x21.
+                    const __m128i a = _mm_or_si128(_mm_cmplt_epi8(v, low), _mm_cmpgt_epi8(v, high));
+                    const __m128i b = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, percent), _mm_cmpeq_epi8(v, comma)),
+                                                   _mm_or_si128(_mm_cmpeq_epi8(v, equal), _mm_cmpeq_epi8(v, at)));
+                    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(a, b)));
+                    if (mask != 0) {
+                        return data + string_util_ctz(mask);
+                    }
+                }
+#elif defined(OSMIUM_STRING_UTIL_NEON)
+                for (; end - data >= 16; data += 16) {
+                    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data));
+                    const uint8x16_t a = vorrq_u8(vcltq_u8(v, vdupq_n_u8(0x21)), vcgtq_u8(v, vdupq_n_u8(0x7e)));
+                    const uint8x16_t b = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('%')), vceqq_u8(v, vdupq_n_u8(','))),
+                                                  vorrq_u8(vceqq_u8(v, vdupq_n_u8('=')), vceqq_u8(v, vdupq_n_u8('@'))));
+                    const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(vorrq_u8(a, b)), 4)), 0);
+                    if (mask != 0) {
+                        return data + string_util_ctz(mask) / 4;
+                    }
+                }
+#endif
+                for (; data != end; ++data) {
+                    if (!is_opl_plain_char(*data)) {
+                        return data;
+                    }
+                }
+                return end;
+            }
+
             inline void append_utf8_encoded_string(std::string& out, const char* data) {
                 static const char* lookup_hex = "0123456789abcdef";
                 const char* end = data + std::strlen(data);
 
                 while (data != end) {
+                    // Copy runs of plain ASCII characters in one go.
+                    const char* const plain_end = find_opl_non_plain_char(data, end);
+                    out.append(data, plain_end);
+                    data = plain_end;
+                    if (data == end) {
+                        break;
+                    }
+
                     const char* last = data;
                     const uint32_t c = next_utf8_codepoint(&data, end);
 
@@ -238,8 +500,18 @@ namespace osmium {
             }
 
             inline void append_xml_encoded_string(std::string& out, const char* data) {
-                for (; *data != '\0'; ++data) {
-                    switch (*data) {
+                const char* const end = data + std::strlen(data);
+
+                while (data != end) {
+                    // Copy runs of characters not needing escaping in one
+                    // go.
+                    const char* const special = find_xml_special_char(data, end);
+                    out.append(data, special);
+                    data = special;
+                    if (data == end) {
+                        break;
+                    }
+                    switch (*data++) {
                         case '&':  out += "&amp;";  break;
                         case '\"': out += "&quot;"; break;
                         case '\'': out += "&apos;"; break;
@@ -248,7 +520,32 @@ namespace osmium {
                         case '\n': out += "&#xA;";  break;
                         case '\r': out += "&#xD;";  break;
                         case '\t': out += "&#x9;";  break;
-                        default:   out += *data;    break;
+                        default:   assert(false);   break;
+                    }
+                }
+            }
+
+            // Escape string for use in a JSON string. UTF-8 characters are
+            // passed through unchanged.
+            inline void append_json_encoded_string(std::string& out, const char* data) {
+                static const char* lookup_hex = "0123456789abcdef";
+
+                for (; *data != '\0'; ++data) {
+                    const auto c = static_cast<unsigned char>(*data);
+                    switch (c) {
+                        case '"':  out += "\\\""; break;
+                        case '\\': out += "\\\\"; break;
+                        case '\n': out += "\\n";  break;
+                        case '\r': out += "\\r";  break;
+                        case '\t': out += "\\t";  break;
+                        default:
+                            if (c < 0x20U) {
+                                out += "\\u00";
+                                append_2_hex_digits(out, c, lookup_hex);
+                            } else {
+                                out += *data;
+                            }
+                            break;
                     }
                 }
             }
@@ -310,4 +607,7 @@ namespace osmium {
 
 } // namespace osmium
 
+#undef OSMIUM_STRING_UTIL_SSE2
+#undef OSMIUM_STRING_UTIL_NEON
+
 #endif // OSMIUM_IO_DETAIL_STRING_UTIL_HPP
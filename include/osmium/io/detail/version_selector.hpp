@@ -0,0 +1,170 @@
+#ifndef OSMIUM_IO_DETAIL_VERSION_SELECTOR_HPP
+#define OSMIUM_IO_DETAIL_VERSION_SELECTOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/read_filter.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <cstddef>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Selects the latest versions of objects, or the versions
+             * current at some point in time, from the buffers read from a
+             * history file. Used by the Reader if the ReadFilter has
+             * latest_versions() set.
+             *
+             * Whether an object is superseded can only be decided when the
+             * next object is seen, which might be in the next buffer. So
+             * the selector always holds back one buffer. The superseded
+             * objects are removed from a buffer before it is handed out.
+             * The other conditions of the filter are applied to the
+             * remaining objects at that point, because they must only be
+             * checked on the selected versions.
+             */
+            class LatestVersionSelector {
+
+                osmium::io::ReadFilter m_filter;
+
+                // The buffer held back.
+                osmium::memory::Buffer m_buffer{};
+
+                // The last object not after the point in time seen so
+                // far. It is always in m_buffer or nullptr.
+                osmium::OSMObject* m_last_object = nullptr;
+
+                bool m_flushed = false;
+
+                struct no_callback {
+
+                    void moving_in_buffer(std::size_t /*old_offset*/, std::size_t /*new_offset*/) const noexcept {
+                    }
+
+                }; // struct no_callback
+
+                osmium::memory::Buffer finish_buffer() {
+                    osmium::memory::Buffer buffer{std::move(m_buffer)};
+                    m_buffer = osmium::memory::Buffer{};
+                    m_last_object = nullptr;
+
+                    if (!buffer) {
+                        return buffer;
+                    }
+
+                    bool has_removed = false;
+                    for (auto& object : buffer.select<osmium::OSMObject>()) {
+                        if (!object.removed() && m_filter.has_object_conditions() && !m_filter.match(object)) {
+                            object.set_removed(true);
+                        }
+                        has_removed = has_removed || object.removed();
+                    }
+
+                    if (has_removed) {
+                        no_callback callback;
+                        buffer.purge_removed(&callback);
+                    }
+
+                    return buffer;
+                }
+
+            public:
+
+                explicit LatestVersionSelector(const osmium::io::ReadFilter& filter) :
+                    m_filter(filter) {
+                }
+
+                /**
+                 * Add the next buffer read. Returns the buffer held back
+                 * before if it is complete now. The returned buffer might
+                 * be invalid or empty.
+                 */
+                osmium::memory::Buffer add(osmium::memory::Buffer&& buffer) {
+                    osmium::OSMObject* last_object = nullptr;
+
+                    for (auto& object : buffer.select<osmium::OSMObject>()) {
+                        if (!m_filter.match_timestamp(object.timestamp())) {
+                            object.set_removed(true);
+                            continue;
+                        }
+                        osmium::OSMObject* const previous = last_object ? last_object : m_last_object;
+                        if (previous && previous->type() == object.type() && previous->id() == object.id()) {
+                            previous->set_removed(true);
+                        }
+                        last_object = &object;
+                    }
+
+                    if (!last_object) {
+                        // There is nothing left in this buffer, the last
+                        // object in the held buffer can still be
+                        // superseded by a later one.
+                        return osmium::memory::Buffer{};
+                    }
+
+                    osmium::memory::Buffer result{finish_buffer()};
+                    m_buffer = std::move(buffer);
+                    m_last_object = last_object;
+                    return result;
+                }
+
+                /**
+                 * Return the buffer held back at the end of the input.
+                 */
+                osmium::memory::Buffer flush() {
+                    m_flushed = true;
+                    return finish_buffer();
+                }
+
+                /**
+                 * Has flush() been called?
+                 */
+                bool flushed() const noexcept {
+                    return m_flushed;
+                }
+
+            }; // class LatestVersionSelector
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_VERSION_SELECTOR_HPP
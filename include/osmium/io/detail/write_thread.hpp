@@ -36,12 +36,17 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/trace.hpp>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <future>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -52,22 +57,89 @@ namespace osmium {
             /**
              * This codes runs in its own thread, getting data from the given
              * queue, (optionally) compressing it, and writing it to the output
-             * file.
+             * file. Synchronous Writers call write_available() and run()
+             * directly instead.
              */
             class WriteThread {
 
                 queue_wrapper<std::string> m_queue;
                 std::unique_ptr<osmium::io::Compressor> m_compressor;
                 std::promise<std::size_t> m_promise;
+                std::size_t m_batch_size;
+                std::atomic<std::size_t>* m_bytes_written;
+
+                void count_bytes(const std::size_t size) noexcept {
+                    if (m_bytes_written) {
+                        m_bytes_written->fetch_add(size, std::memory_order_relaxed);
+                    }
+                }
+
+                // Write the given data and all data that is already
+                // available in the queue up to the batch size with one
+                // call to the compressor.
+                void write_batch(std::string&& data, std::vector<std::string>& blocks) {
+                    std::size_t size = data.size();
+                    blocks.push_back(std::move(data));
+
+                    std::string next;
+                    while (size < m_batch_size && m_queue.try_pop(next)) {
+                        if (m_queue.has_reached_end_of_data()) {
+                            break;
+                        }
+                        if (next.empty()) {
+                            continue;
+                        }
+                        size += next.size();
+                        blocks.push_back(std::move(next));
+                    }
+
+                    if (blocks.size() == 1) {
+                        m_compressor->write(blocks.front());
+                    } else {
+                        m_compressor->write_blocks(blocks);
+                    }
+                    count_bytes(size);
+                    blocks.clear();
+                }
+
+                void write(std::string&& data, std::vector<std::string>& blocks) {
+                    if (m_batch_size == 0) {
+                        m_compressor->write(data);
+                        count_bytes(data.size());
+                    } else {
+                        write_batch(std::move(data), blocks);
+                    }
+                }
+
+                void finish() {
+                    m_compressor->close();
+                    m_promise.set_value(m_compressor->file_size());
+                }
 
             public:
 
+                /**
+                 * @param input_queue Queue with the encoded data.
+                 * @param compressor Compressor used for writing.
+                 * @param promise Promise set to the file size at the end.
+                 * @param batch_size If this is not 0, blocks that are
+                 *                   ready in the queue are collected up to
+                 *                   this many bytes and handed to the
+                 *                   compressor together.
+                 * @param bytes_written If this is not nullptr, the number
+                 *                      of bytes handed to the compressor
+                 *                      is added to it.
+                 */
                 WriteThread(future_string_queue_type& input_queue,
                             std::unique_ptr<osmium::io::Compressor>&& compressor,
-                            std::promise<std::size_t>&& promise) :
+                            std::promise<std::size_t>&& promise,
+                            std::size_t batch_size = 0,
+                            std::atomic<std::size_t>* bytes_written = nullptr) :
                     m_queue(input_queue),
                     m_compressor(std::move(compressor)),
-                    m_promise(std::move(promise)) {
+                    m_promise(std::move(promise)),
+                    m_batch_size(batch_size),
+                    m_bytes_written(bytes_written) {
                 }
 
                 WriteThread(const WriteThread&) = delete;
@@ -80,23 +152,55 @@ namespace osmium {
 
                 void operator()() {
                     osmium::thread::set_thread_name("_osmium_write");
+                    run();
+                }
 
+                /**
+                 * Write everything until the end of data is reached and
+                 * close the compressor. This is what the thread does.
+                 */
+                void run() {
                     try {
-                        while (true) {
-                            const std::string data{m_queue.pop()};
-                            if (at_end_of_data(data)) {
+                        std::vector<std::string> blocks;
+                        for (uint64_t sequence = 0; !m_queue.has_reached_end_of_data(); ++sequence) {
+                            std::string data{m_queue.pop()};
+                            if (m_queue.has_reached_end_of_data()) {
                                 break;
                             }
-                            m_compressor->write(data);
+                            if (data.empty()) {
+                                continue;
+                            }
+                            const osmium::util::TraceScope trace{osmium::util::trace_stage::write, sequence};
+                            write(std::move(data), blocks);
                         }
-                        m_compressor->close();
-                        m_promise.set_value(m_compressor->file_size());
+                        finish();
                     } catch (...) {
                         m_promise.set_exception(std::current_exception());
                         m_queue.drain();
                     }
                 }
 
+                /**
+                 * Write all data that is already available in the queue
+                 * without waiting for more. This is used instead of a
+                 * thread if the Writer works synchronously, call run()
+                 * at the end to finish up. Errors from the compressor are
+                 * thrown from here.
+                 */
+                void write_available() {
+                    std::vector<std::string> blocks;
+                    std::string data;
+                    while (!m_queue.has_reached_end_of_data() && m_queue.try_pop(data)) {
+                        if (m_queue.has_reached_end_of_data()) {
+                            break;
+                        }
+                        if (data.empty()) {
+                            continue;
+                        }
+                        write(std::move(data), blocks);
+                    }
+                }
+
             }; // class WriteThread
 
         } // namespace detail
@@ -37,10 +37,13 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/string_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/changeset.hpp>
 #include <osmium/osm/entity_bits.hpp>
@@ -54,18 +57,25 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/types_from_string.hpp>
 #include <osmium/osm/way.hpp>
-#include <osmium/thread/util.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <expat.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <exception>
+#include <functional>
 #include <future>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -125,7 +135,79 @@ namespace osmium {
 
         namespace detail {
 
-            class XMLParser final : public Parser {
+            /**
+             * Find the end of the XML markup (tag, comment, processing
+             * instruction, etc.) starting at pos.
+             *
+             * @returns Position after the end of the markup or npos if
+             *          it is not complete in the data.
+             */
+            inline std::size_t find_xml_markup_end(const std::string& data, std::size_t pos) {
+                assert(data[pos] == '<');
+
+                const auto find_after = [&data](const char* str, std::size_t start) {
+                    const auto end = data.find(str, start);
+                    return end == std::string::npos ? end : end + std::strlen(str);
+                };
+
+                if (data.compare(pos, 4, "<!--") == 0) {
+                    return find_after("-->", pos + 4);
+                }
+                if (data.compare(pos, 9, "<![CDATA[") == 0) {
+                    return find_after("]]>", pos + 9);
+                }
+                if (data.compare(pos, 2, "<?") == 0) {
+                    return find_after("?>", pos + 2);
+                }
+                if (data.compare(pos, 9, "<!DOCTYPE") == 0) {
+                    const auto end = data.find_first_of("[>", pos + 9);
+                    if (end == std::string::npos || data[end] == '>') {
+                        return end == std::string::npos ? end : end + 1;
+                    }
+                    const auto subset_end = data.find(']', end);
+                    return subset_end == std::string::npos ? subset_end : find_after(">", subset_end);
+                }
+
+                auto i = pos + 1;
+                while (true) {
+                    i = data.find_first_of("\"'>", i);
+                    if (i == std::string::npos) {
+                        return i;
+                    }
+                    if (data[i] == '>') {
+                        return i + 1;
+                    }
+                    i = data.find(data[i], i + 1);
+                    if (i == std::string::npos) {
+                        return i;
+                    }
+                    ++i;
+                }
+            }
+
+            /**
+             * The tokenizer used for reading XML files. Set with the
+             * "xml_tokenizer" file option.
+             */
+            enum class xml_tokenizer {
+                expat = 0, ///< Use the expat library (default)
+                osm   = 1  ///< Use the built-in tokenizer for OSM XML
+            };
+
+            /**
+             * Parses the content of an OSM XML document into a buffer. This
+             * is used by the XMLParser, either for a complete document or,
+             * in parallel mode, for chunks of a document wrapped into small
+             * synthetic documents.
+             */
+            class XMLContentParser {
+
+            public:
+
+                using header_callback_type = std::function<void(const osmium::io::Header&)>;
+                using buffer_callback_type = std::function<void(osmium::memory::Buffer&&)>;
+
+            private:
 
                 enum {
                     initial_buffer_size = 1024UL * 1024UL
@@ -154,10 +236,15 @@ namespace osmium {
 
                 std::vector<context> m_context_stack;
 
+                osmium::osm_entity_bits::type m_read_types;
+
+                header_callback_type m_header_callback;
+
+                buffer_callback_type m_buffer_callback;
+
                 osmium::io::Header m_header{};
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size,
-                                                osmium::memory::Buffer::auto_grow::internal};
+                osmium::memory::Buffer m_buffer;
 
                 std::unique_ptr<osmium::builder::NodeBuilder>                m_node_builder{};
                 std::unique_ptr<osmium::builder::WayBuilder>                 m_way_builder{};
@@ -171,6 +258,8 @@ namespace osmium {
 
                 std::string m_comment_text;
 
+                const osmium::io::ReadFilter* m_read_filter;
+
                 /**
                  * A C++ wrapper for the Expat parser that makes sure no memory
                  * is leaked.
@@ -181,7 +270,7 @@ namespace osmium {
                     std::exception_ptr m_exception_ptr{};
 
                     template <typename TFunc>
-                    void member_wrap(XMLParser& xml_parser, TFunc&& func) noexcept {
+                    void member_wrap(XMLContentParser& xml_parser, TFunc&& func) noexcept {
                         if (m_exception_ptr) {
                             return;
                         }
@@ -196,24 +285,24 @@ namespace osmium {
                     template <typename TFunc>
                     static void wrap(void* data, TFunc&& func) noexcept {
                         assert(data);
-                        auto& xml_parser = *static_cast<XMLParser*>(data);
-                        xml_parser.m_expat_xml_parser->member_wrap(xml_parser, std::forward<TFunc>(func));
+                        auto& xml_parser = *static_cast<XMLContentParser*>(data);
+                        xml_parser.m_expat_xml_parser.member_wrap(xml_parser, std::forward<TFunc>(func));
                     }
 
                     static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
+                        wrap(data, [&](XMLContentParser& xml_parser) {
                             xml_parser.start_element(element, attrs);
                         });
                     }
 
                     static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
+                        wrap(data, [&](XMLContentParser& xml_parser) {
                             xml_parser.end_element(element);
                         });
                     }
 
                     static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
+                        wrap(data, [&](XMLContentParser& xml_parser) {
                             xml_parser.characters(text, len);
                         });
                     }
@@ -232,7 +321,7 @@ namespace osmium {
                             const XML_Char* /*systemId*/,
                             const XML_Char* /*publicId*/,
                             const XML_Char* /*notationName*/) noexcept {
-                        wrap(data, [&](XMLParser& /*xml_parser*/) {
+                        wrap(data, [&](XMLContentParser& /*xml_parser*/) {
                             throw osmium::xml_error{"XML entities are not supported"};
                         });
                     }
@@ -272,7 +361,444 @@ namespace osmium {
 
                 }; // class ExpatXMLParser
 
-                ExpatXMLParser* m_expat_xml_parser{nullptr};
+                ExpatXMLParser m_expat_xml_parser;
+
+                /**
+                 * A tokenizer for the subset of XML used in OSM files. It
+                 * handles elements, attributes, text, comments, CDATA
+                 * sections, processing instructions, the predefined entities
+                 * and character references. Attribute values are decoded in
+                 * place in the input data without copying them.
+                 *
+                 * It can not handle documents with a DOCTYPE declaration or
+                 * with an encoding other than UTF-8. For those documents the
+                 * call operator returns false before any callback was
+                 * called and the data seen so far can be handed to expat.
+                 *
+                 * Malformed input leads to an osmium::xml_error, but the
+                 * tokenizer is less strict than expat: It doesn't check for
+                 * invalid characters or invalid UTF-8 sequences.
+                 */
+                class OSMXMLTokenizer {
+
+                    XMLContentParser& m_content_parser;
+
+                    // Data not consumed yet.
+                    std::string m_data;
+
+                    // Position in m_data up to which the data has been
+                    // processed.
+                    std::size_t m_pos = 0;
+
+                    // Line number at the start of m_data.
+                    uint64_t m_line = 1;
+
+                    // Names of the currently open elements. Only the first
+                    // m_depth entries are used, the others are kept to
+                    // reuse their memory.
+                    std::vector<std::string> m_element_stack;
+                    std::size_t m_depth = 0;
+
+                    std::vector<const char*> m_attrs;
+                    std::string m_text;
+
+                    bool m_in_prolog = true;
+                    bool m_root_done = false;
+
+                    static bool is_space(const char c) noexcept {
+                        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+                    }
+
+                    static bool is_name_char(const char c) noexcept {
+                        return !is_space(c) && c != '/' && c != '>' && c != '=' &&
+                               c != '"' && c != '\'' && c != '<' && c != '&';
+                    }
+
+                    [[noreturn]] void error(const char* message) const {
+                        const auto line = m_line + static_cast<uint64_t>(std::count(m_data.begin(), m_data.begin() + static_cast<std::ptrdiff_t>(m_pos), '\n'));
+                        osmium::xml_error e{std::string{"XML parsing error at line "} + std::to_string(line) + ": " + message};
+                        e.line = line;
+                        throw e;
+                    }
+
+                    // Decode the entity or character reference at *data
+                    // (which points to the '&') and write the result to out.
+                    template <typename TOutputIterator>
+                    TOutputIterator decode_reference(const char** data, const char* end, TOutputIterator out) const {
+                        const char* const name = *data + 1;
+                        const char* const semicolon = static_cast<const char*>(std::memchr(name, ';', static_cast<std::size_t>(end - name)));
+                        if (!semicolon) {
+                            error("invalid entity reference");
+                        }
+                        *data = semicolon + 1;
+
+                        const auto len = semicolon - name;
+                        if (len >= 2 && name[0] == '#') {
+                            const bool hex = name[1] == 'x';
+                            const char* it = name + (hex ? 2 : 1);
+                            if (it == semicolon) {
+                                error("invalid character reference");
+                            }
+                            uint32_t cp = 0;
+                            for (; it != semicolon; ++it) {
+                                uint32_t digit = 0;
+                                if (*it >= '0' && *it <= '9') {
+                                    digit = static_cast<uint32_t>(*it - '0');
+                                } else if (hex && *it >= 'a' && *it <= 'f') {
+                                    digit = static_cast<uint32_t>(*it - 'a' + 10);
+                                } else if (hex && *it >= 'A' && *it <= 'F') {
+                                    digit = static_cast<uint32_t>(*it - 'A' + 10);
+                                } else {
+                                    error("invalid character reference");
+                                }
+                                cp = cp * (hex ? 16U : 10U) + digit;
+                                if (cp > 0x10ffffUL) {
+                                    error("reference to invalid character number");
+                                }
+                            }
+                            if ((cp < 0x20U && cp != 0x09U && cp != 0x0aU && cp != 0x0dU) ||
+                                (cp >= 0xd800UL && cp < 0xe000UL) ||
+                                cp == 0xfffeUL || cp == 0xffffUL) {
+                                error("reference to invalid character number");
+                            }
+                            return append_codepoint_as_utf8(cp, out);
+                        }
+
+                        if (len == 2 && name[0] == 'l' && name[1] == 't') {
+                            *out++ = '<';
+                        } else if (len == 2 && name[0] == 'g' && name[1] == 't') {
+                            *out++ = '>';
+                        } else if (len == 3 && !std::strncmp(name, "amp", 3)) {
+                            *out++ = '&';
+                        } else if (len == 4 && !std::strncmp(name, "quot", 4)) {
+                            *out++ = '"';
+                        } else if (len == 4 && !std::strncmp(name, "apos", 4)) {
+                            *out++ = '\'';
+                        } else {
+                            error("undefined entity");
+                        }
+                        return out;
+                    }
+
+                    // Decode attribute value in [begin, end) in place and
+                    // terminate it with a 0 byte. The decoded value is never
+                    // longer than the encoded one.
+                    void decode_attribute_value(char* begin, const char* end) const {
+                        char* out = begin;
+                        const char* it = begin;
+                        while (it != end) {
+                            const char c = *it;
+                            if (c == '&') {
+                                out = decode_reference(&it, end, out);
+                            } else if (c == '<') {
+                                error("'<' not allowed in attribute value");
+                            } else if (c == '\r') {
+                                *out++ = ' ';
+                                ++it;
+                                if (it != end && *it == '\n') {
+                                    ++it;
+                                }
+                            } else {
+                                *out++ = (c == '\t' || c == '\n') ? ' ' : c;
+                                ++it;
+                            }
+                        }
+                        *out = '\0';
+                    }
+
+                    void text(std::size_t begin, std::size_t end) {
+                        if (begin == end) {
+                            return;
+                        }
+
+                        const char* const first = m_data.data() + begin;
+                        const char* const last = m_data.data() + end;
+
+                        if (m_depth == 0) {
+                            if (!std::all_of(first, last, is_space)) {
+                                error(m_root_done ? "junk after document element" : "syntax error");
+                            }
+                            return;
+                        }
+
+                        const auto size = end - begin;
+                        if (!std::memchr(first, '&', size) && !std::memchr(first, '\r', size)) {
+                            m_content_parser.characters(first, static_cast<int>(size));
+                            return;
+                        }
+
+                        m_text.clear();
+                        auto out = std::back_inserter(m_text);
+                        const char* it = first;
+                        while (it != last) {
+                            if (*it == '&') {
+                                out = decode_reference(&it, last, out);
+                            } else if (*it == '\r') {
+                                *out++ = '\n';
+                                ++it;
+                                if (it != last && *it == '\n') {
+                                    ++it;
+                                }
+                            } else {
+                                *out++ = *it++;
+                            }
+                        }
+                        m_content_parser.characters(m_text.data(), static_cast<int>(m_text.size()));
+                    }
+
+                    // Returns false if the XML declaration names an encoding
+                    // other than UTF-8.
+                    bool check_xml_declaration(std::size_t begin, std::size_t end) const {
+                        const auto pos = m_data.find("encoding", begin);
+                        if (pos == std::string::npos || pos >= end) {
+                            return true;
+                        }
+                        const auto quote = m_data.find_first_of("\"'", pos);
+                        if (quote >= end) {
+                            return true;
+                        }
+                        const auto quote_end = m_data.find(m_data[quote], quote + 1);
+                        if (quote_end >= end) {
+                            return true;
+                        }
+                        std::string encoding{m_data, quote + 1, quote_end - quote - 1};
+                        std::transform(encoding.begin(), encoding.end(), encoding.begin(), [](char c) {
+                            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+                        });
+                        return encoding == "utf-8" || encoding == "utf8";
+                    }
+
+                    void start_tag(std::size_t begin, std::size_t end) {
+                        if (m_root_done) {
+                            error("junk after document element");
+                        }
+                        m_in_prolog = false;
+
+                        char* p = &m_data[begin + 1];
+                        const char* last = m_data.data() + end - 1; // points to '>'
+                        bool empty_element = false;
+                        if (last[-1] == '/' && last - 1 > p) {
+                            empty_element = true;
+                            --last;
+                        }
+
+                        const char* const name = p;
+                        while (p != last && is_name_char(*p)) {
+                            ++p;
+                        }
+                        if (p == name || (*name >= '0' && *name <= '9') || *name == '-' || *name == '.') {
+                            error("not well-formed (invalid token)");
+                        }
+                        if (m_depth == m_element_stack.size()) {
+                            m_element_stack.emplace_back();
+                        }
+                        std::string& element = m_element_stack[m_depth];
+                        element.assign(name, static_cast<std::size_t>(p - name));
+
+                        m_attrs.clear();
+                        while (true) {
+                            const char* const space = p;
+                            while (p != last && is_space(*p)) {
+                                ++p;
+                            }
+                            if (p == last) {
+                                break;
+                            }
+                            if (p == space) {
+                                error("not well-formed (invalid token)");
+                            }
+
+                            char* const attr_name = p;
+                            while (p != last && is_name_char(*p)) {
+                                ++p;
+                            }
+                            if (p == attr_name) {
+                                error("not well-formed (invalid token)");
+                            }
+                            char* const attr_name_end = p;
+                            while (p != last && is_space(*p)) {
+                                ++p;
+                            }
+                            if (p == last || *p != '=') {
+                                error("not well-formed (invalid token)");
+                            }
+                            ++p;
+                            while (p != last && is_space(*p)) {
+                                ++p;
+                            }
+                            if (p == last || (*p != '"' && *p != '\'')) {
+                                error("not well-formed (invalid token)");
+                            }
+                            const char quote = *p++;
+                            char* const value = p;
+                            p = static_cast<char*>(std::memchr(p, quote, static_cast<std::size_t>(last - p)));
+                            if (!p) {
+                                error("not well-formed (invalid token)");
+                            }
+                            decode_attribute_value(value, p);
+                            ++p;
+                            *attr_name_end = '\0';
+
+                            for (std::size_t i = 0; i < m_attrs.size(); i += 2) {
+                                if (!std::strcmp(m_attrs[i], attr_name)) {
+                                    error("duplicate attribute");
+                                }
+                            }
+                            m_attrs.push_back(attr_name);
+                            m_attrs.push_back(value);
+                        }
+                        m_attrs.push_back(nullptr);
+
+                        m_content_parser.start_element(element.c_str(), m_attrs.data());
+                        if (empty_element) {
+                            m_content_parser.end_element(element.c_str());
+                            if (m_depth == 0) {
+                                m_root_done = true;
+                            }
+                        } else {
+                            ++m_depth;
+                        }
+                    }
+
+                    void end_tag(std::size_t begin, std::size_t end) {
+                        const char* const name = m_data.data() + begin + 2;
+                        const char* const last = m_data.data() + end - 1; // points to '>'
+                        const char* p = name;
+                        while (p != last && is_name_char(*p)) {
+                            ++p;
+                        }
+                        const auto len = static_cast<std::size_t>(p - name);
+                        while (p != last && is_space(*p)) {
+                            ++p;
+                        }
+                        if (p != last || len == 0) {
+                            error("not well-formed (invalid token)");
+                        }
+                        if (m_depth == 0) {
+                            error(m_root_done ? "junk after document element" : "syntax error");
+                        }
+                        const std::string& element = m_element_stack[m_depth - 1];
+                        if (element.size() != len || std::memcmp(element.data(), name, len) != 0) {
+                            error("mismatched tag");
+                        }
+                        m_content_parser.end_element(element.c_str());
+                        --m_depth;
+                        if (m_depth == 0) {
+                            m_root_done = true;
+                        }
+                    }
+
+                    // Returns false if the document can not be handled by
+                    // this tokenizer.
+                    bool markup(std::size_t begin, std::size_t end) {
+                        const char c = m_data[begin + 1];
+                        if (c == '?') {
+                            if (m_in_prolog && m_data.compare(begin, 6, "<?xml ") == 0) {
+                                return check_xml_declaration(begin, end);
+                            }
+                            return true;
+                        }
+                        if (c == '!') {
+                            if (m_data.compare(begin, 4, "<!--") == 0) {
+                                return true;
+                            }
+                            if (m_data.compare(begin, 9, "<![CDATA[") == 0) {
+                                if (m_depth == 0) {
+                                    error("syntax error");
+                                }
+                                m_content_parser.characters(m_data.data() + begin + 9, static_cast<int>(end - begin - 12));
+                                return true;
+                            }
+                            if (m_in_prolog && m_data.compare(begin, 9, "<!DOCTYPE") == 0) {
+                                return false;
+                            }
+                            error("syntax error");
+                        }
+                        if (c == '/') {
+                            end_tag(begin, end);
+                        } else {
+                            start_tag(begin, end);
+                        }
+                        return true;
+                    }
+
+                public:
+
+                    explicit OSMXMLTokenizer(XMLContentParser& content_parser) :
+                        m_content_parser(content_parser) {
+                    }
+
+                    /**
+                     * Parse the next part of the document.
+                     *
+                     * @returns false if the document can not be handled by
+                     *          this tokenizer. In that case no callbacks have
+                     *          been called and all data is available from
+                     *          release_data().
+                     */
+                    bool operator()(const std::string& data, bool last) {
+                        m_data.append(data);
+
+                        if (m_in_prolog && m_pos == 0 && m_data.compare(0, 3, "\xef\xbb\xbf") == 0) {
+                            m_pos = 3;
+                        }
+
+                        while (true) {
+                            const auto lt = m_data.find('<', m_pos);
+                            if (lt == std::string::npos) {
+                                break;
+                            }
+                            const auto end = find_xml_markup_end(m_data, lt);
+                            if (end == std::string::npos) {
+                                break;
+                            }
+                            text(m_pos, lt);
+                            m_pos = lt;
+                            if (!markup(lt, end)) {
+                                return false;
+                            }
+                            m_pos = end;
+                        }
+
+                        if (last) {
+                            const auto lt = m_data.find('<', m_pos);
+                            if (lt != std::string::npos) {
+                                m_pos = lt;
+                                error("unclosed token");
+                            }
+                            text(m_pos, m_data.size());
+                            m_pos = m_data.size();
+                            if (m_in_prolog) {
+                                error("no element found");
+                            }
+                            if (!m_root_done) {
+                                error("unclosed token");
+                            }
+                            return true;
+                        }
+
+                        // The prolog is kept in case the data has to be
+                        // handed to expat later.
+                        if (!m_in_prolog) {
+                            m_line += static_cast<uint64_t>(std::count(m_data.begin(), m_data.begin() + static_cast<std::ptrdiff_t>(m_pos), '\n'));
+                            m_data.erase(0, m_pos);
+                            m_pos = 0;
+                        }
+
+                        return true;
+                    }
+
+                    std::string release_data() {
+                        return std::move(m_data);
+                    }
+
+                }; // class OSMXMLTokenizer
+
+                std::unique_ptr<OSMXMLTokenizer> m_osm_xml_tokenizer;
+
+                osmium::osm_entity_bits::type read_types() const noexcept {
+                    return m_read_types;
+                }
 
                 template <typename T>
                 static void check_attributes(const XML_Char** attrs, T&& check) {
@@ -350,10 +876,6 @@ namespace osmium {
                     m_tl_builder->add_tag(k, v);
                 }
 
-                void mark_header_as_done() {
-                    set_header_value(m_header);
-                }
-
                 void top_level_element(const XML_Char* element, const XML_Char** attrs) {
                     if (!std::strcmp(element, "osm")) {
                         m_context_stack.push_back(context::osm);
@@ -676,7 +1198,7 @@ namespace osmium {
                             if (read_types() & osmium::osm_entity_bits::node) {
                                 m_tl_builder.reset();
                                 m_node_builder.reset();
-                                m_buffer.commit();
+                                commit_object();
                                 flush_buffer();
                             }
                             break;
@@ -686,7 +1208,7 @@ namespace osmium {
                                 m_tl_builder.reset();
                                 m_wnl_builder.reset();
                                 m_way_builder.reset();
-                                m_buffer.commit();
+                                commit_object();
                                 flush_buffer();
                             }
                             break;
@@ -696,7 +1218,7 @@ namespace osmium {
                                 m_tl_builder.reset();
                                 m_rml_builder.reset();
                                 m_relation_builder.reset();
-                                m_buffer.commit();
+                                commit_object();
                                 flush_buffer();
                             }
                             break;
@@ -749,17 +1271,344 @@ namespace osmium {
                     }
                 }
 
+                // Commit the object just built if it matches the read
+                // filter, remove it from the buffer otherwise. The XML
+                // has to be parsed anyway and the tags come last, so the
+                // objects are checked after they are built.
+                void commit_object() {
+                    if (m_read_filter && !m_read_filter->match(m_buffer.get<osmium::OSMObject>(m_buffer.committed()))) {
+                        m_buffer.rollback();
+                        return;
+                    }
+                    m_buffer.commit();
+                }
+
                 void flush_buffer() {
                     if (m_buffer.has_nested_buffers()) {
                         std::unique_ptr<osmium::memory::Buffer> buffer_ptr{m_buffer.get_last_nested()};
-                        send_to_output_queue(std::move(*buffer_ptr));
+                        m_buffer_callback(std::move(*buffer_ptr));
+                    }
+                }
+
+            public:
+
+                /**
+                 * Construct content parser.
+                 *
+                 * @param read_types Which types of OSM entities to read.
+                 * @param header_callback Called with the header once it is
+                 *                        complete. Can be empty.
+                 * @param buffer_callback Called with each full buffer. If
+                 *                        this is empty, the buffer will grow
+                 *                        as needed and has to be fetched
+                 *                        with release_buffer().
+                 * @param buffer_pool If this is not nullptr and there is no
+                 *                    buffer callback, the buffer is taken
+                 *                    from this pool.
+                 * @param read_filter If this is not nullptr, only objects
+                 *                    matching it are kept.
+                 * @param tokenizer Which XML tokenizer to use.
+                 */
+                XMLContentParser(osmium::osm_entity_bits::type read_types,
+                                 header_callback_type&& header_callback,
+                                 buffer_callback_type&& buffer_callback,
+                                 osmium::memory::BufferPool* buffer_pool = nullptr,
+                                 const osmium::io::ReadFilter* read_filter = nullptr,
+                                 xml_tokenizer tokenizer = xml_tokenizer::expat) :
+                    m_read_types(read_types),
+                    m_header_callback(std::move(header_callback)),
+                    m_buffer_callback(std::move(buffer_callback)),
+                    m_buffer(m_buffer_callback ? osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal}
+                           : buffer_pool ? buffer_pool->get(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes)
+                                         : osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes}),
+                    m_read_filter(read_filter),
+                    m_expat_xml_parser(this),
+                    m_osm_xml_tokenizer(tokenizer == xml_tokenizer::osm ? new OSMXMLTokenizer{*this} : nullptr) {
+                }
+
+                XMLContentParser(const XMLContentParser&) = delete;
+                XMLContentParser& operator=(const XMLContentParser&) = delete;
+
+                XMLContentParser(XMLContentParser&&) = delete;
+                XMLContentParser& operator=(XMLContentParser&&) = delete;
+
+                ~XMLContentParser() noexcept = default;
+
+                void parse(const std::string& data, bool last) {
+                    if (m_osm_xml_tokenizer) {
+                        if ((*m_osm_xml_tokenizer)(data, last)) {
+                            return;
+                        }
+                        // The document needs features the OSM tokenizer
+                        // doesn't have, hand everything to expat.
+                        const std::string prolog{m_osm_xml_tokenizer->release_data()};
+                        m_osm_xml_tokenizer.reset();
+                        m_expat_xml_parser(prolog, last);
+                        return;
+                    }
+                    m_expat_xml_parser(data, last);
+                }
+
+                void mark_header_as_done() {
+                    if (m_header_callback) {
+                        m_header_callback(m_header);
+                    }
+                }
+
+                osmium::memory::Buffer release_buffer() {
+                    return std::move(m_buffer);
+                }
+
+            }; // class XMLContentParser
+
+            /**
+             * Parses an XML document in a separate thread. Used in parallel
+             * mode of the XMLParser.
+             */
+            class XMLChunkParser {
+
+                std::string m_document;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::memory::BufferPool* m_buffer_pool;
+                std::shared_ptr<const osmium::io::ReadFilter> m_read_filter;
+                xml_tokenizer m_tokenizer;
+
+            public:
+
+                XMLChunkParser(std::string&& document, osmium::osm_entity_bits::type read_types, osmium::memory::BufferPool* buffer_pool, std::shared_ptr<const osmium::io::ReadFilter> read_filter = nullptr, xml_tokenizer tokenizer = xml_tokenizer::expat) :
+                    m_document(std::move(document)),
+                    m_read_types(read_types),
+                    m_buffer_pool(buffer_pool),
+                    m_read_filter(std::move(read_filter)),
+                    m_tokenizer(tokenizer) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    XMLContentParser parser{m_read_types, nullptr, nullptr, m_buffer_pool, m_read_filter.get(), m_tokenizer};
+                    parser.parse(m_document, true);
+                    return parser.release_buffer();
+                }
+
+            }; // class XMLChunkParser
+
+            class XMLParser final : public Parser {
+
+                enum : std::size_t {
+                    // Approximate size of XML chunks parsed in parallel
+                    chunk_size = 1024UL * 1024UL
+                };
+
+                xml_tokenizer m_tokenizer;
+
+                XMLContentParser m_content_parser;
+
+                xml_tokenizer get_tokenizer_option() const {
+                    return get_file_option("xml_tokenizer") == "osm" ? xml_tokenizer::osm : xml_tokenizer::expat;
+                }
+
+                static std::string element_name(const std::string& data, std::size_t pos) {
+                    const auto end = data.find_first_of(" \t\r\n/>", pos);
+                    return data.substr(pos, end - pos);
+                }
+
+                static bool is_object_element(const std::string& name) noexcept {
+                    return name == "node" || name == "way" || name == "relation" || name == "changeset";
+                }
+
+                static osmium::osm_entity_bits::type element_entity_bits(const std::string& name) noexcept {
+                    if (name == "node") {
+                        return osmium::osm_entity_bits::node;
+                    }
+                    if (name == "way") {
+                        return osmium::osm_entity_bits::way;
+                    }
+                    if (name == "relation") {
+                        return osmium::osm_entity_bits::relation;
+                    }
+                    if (name == "changeset") {
+                        return osmium::osm_entity_bits::changeset;
+                    }
+                    return osmium::osm_entity_bits::nothing;
+                }
+
+                /**
+                 * Parse the input in parallel. The input is split at the
+                 * boundaries of top-level elements (nodes, ways, etc.) and
+                 * the chunks are wrapped into small documents which are
+                 * parsed on the thread pool. The header is parsed
+                 * on this thread from everything before the first object.
+                 * Chunks without any objects of the types that should be
+                 * read are not parsed at all, so reading only the
+                 * changesets from a changesets dump (or only the OSM data
+                 * from a file that also has changesets) is cheap.
+                 */
+                void run_parallel() {
+                    std::string data;
+                    std::size_t pos = 0; // scan position in data
+                    std::size_t chunk_start = std::string::npos;
+
+                    // Does the current chunk contain any objects of the
+                    // types that should be read?
+                    bool chunk_wanted = false;
+
+                    std::string xml_declaration;
+                    std::string root;
+                    std::string section;
+                    std::size_t depth = 0;
+                    bool header_done = false;
+                    bool root_done = false;
+
+                    const auto finish_header = [&](std::size_t end) {
+                        m_content_parser.parse(data.substr(0, end) + "</" + root + ">", true);
+                        m_content_parser.mark_header_as_done();
+                        header_done = true;
+                    };
+
+                    const auto submit_chunk = [&](std::size_t end) {
+                        if (chunk_start == std::string::npos) {
+                            return;
+                        }
+                        if (!chunk_wanted) {
+                            chunk_start = std::string::npos;
+                            return;
+                        }
+                        chunk_wanted = false;
+                        std::string document{xml_declaration};
+                        document += '<';
+                        document += root;
+                        document += " version=\"0.6\">";
+                        if (!section.empty()) {
+                            document += '<' + section + '>';
+                        }
+                        document.append(data, chunk_start, end - chunk_start);
+                        if (!section.empty()) {
+                            document += "</" + section + '>';
+                        }
+                        document += "</" + root + '>';
+                        chunk_start = std::string::npos;
+
+                        const std::size_t document_size = document.size();
+                        send_to_output_queue_from_pool(XMLChunkParser{std::move(document), read_types(), buffer_pool(), read_filter(), m_tokenizer}, document_size);
+                    };
+
+                    while (!root_done) {
+                        const auto lt = data.find('<', pos);
+                        const auto end = lt == std::string::npos ? lt : find_xml_markup_end(data, lt);
+
+                        if (end == std::string::npos) {
+                            if (input_done()) {
+                                break;
+                            }
+
+                            // Remove data we don't need any more.
+                            if (header_done) {
+                                const auto keep = chunk_start == std::string::npos ? std::min(lt, data.size()) : chunk_start;
+                                data.erase(0, keep);
+                                if (chunk_start != std::string::npos) {
+                                    chunk_start -= keep;
+                                }
+                                pos = lt == std::string::npos ? data.size() : lt - keep;
+                            } else {
+                                pos = lt == std::string::npos ? data.size() : lt;
+                            }
+
+                            data += get_input();
+                            continue;
+                        }
+
+                        pos = end;
+
+                        if (data[lt + 1] == '?' || data[lt + 1] == '!') {
+                            if (lt == 0 && data.compare(0, 5, "<?xml") == 0) {
+                                xml_declaration = data.substr(0, end);
+                            }
+                            continue;
+                        }
+
+                        if (data[lt + 1] == '/') { // end tag
+                            if (depth == 0) {
+                                throw osmium::xml_error{"XML parsing error: unexpected end tag"};
+                            }
+                            --depth;
+                            if (depth == 0) {
+                                if (!header_done) {
+                                    finish_header(lt);
+                                }
+                                submit_chunk(lt);
+                                root_done = true;
+                            } else if (depth == 1 && !section.empty()) {
+                                submit_chunk(lt);
+                                section.clear();
+                            } else if (depth == (section.empty() ? 1U : 2U) && chunk_start != std::string::npos && end - chunk_start >= chunk_size) {
+                                submit_chunk(end);
+                            }
+                            continue;
+                        }
+
+                        const bool empty_element = data[end - 2] == '/';
+                        const std::string name{element_name(data, lt + 1)};
+
+                        if (depth == 0) {
+                            root = name;
+                        } else if (depth == 1 && root == "osmChange" && (name == "create" || name == "modify" || name == "delete")) {
+                            if (!header_done) {
+                                finish_header(lt);
+                            }
+                            submit_chunk(lt);
+                            if (!empty_element) {
+                                section = name;
+                            }
+                        } else if (depth == (section.empty() ? 1U : 2U)) {
+                            if (!header_done && is_object_element(name)) {
+                                finish_header(lt);
+                            }
+                            if (header_done && chunk_start == std::string::npos) {
+                                chunk_start = lt;
+                            }
+                            // Other elements are always parsed, so errors
+                            // in them are found as in serial mode.
+                            const auto bits = element_entity_bits(name);
+                            if (bits == osmium::osm_entity_bits::nothing || (read_types() & bits)) {
+                                chunk_wanted = true;
+                            }
+                            if (empty_element && chunk_start != std::string::npos && end - chunk_start >= chunk_size) {
+                                submit_chunk(end);
+                            }
+                        }
+
+                        if (!empty_element) {
+                            ++depth;
+                        }
+
+                        if (header_done && read_types() == osmium::osm_entity_bits::nothing) {
+                            return;
+                        }
+                    }
+
+                    if (!header_done) {
+                        // Let expat report whatever is wrong with the data.
+                        m_content_parser.parse(data, true);
+                        m_content_parser.mark_header_as_done();
+                    } else if (!root_done) {
+                        throw osmium::xml_error{"XML parsing error: unexpected end of input"};
                     }
                 }
 
             public:
 
                 explicit XMLParser(parser_arguments& args) :
-                    Parser(args) {
+                    Parser(args),
+                    m_tokenizer(get_tokenizer_option()),
+                    m_content_parser(read_types(),
+                                     [this](const osmium::io::Header& header) {
+                                         set_header_value(header);
+                                     },
+                                     [this](osmium::memory::Buffer&& buffer) {
+                                         send_to_output_queue(std::move(buffer));
+                                     },
+                                     nullptr,
+                                     read_filter().get(),
+                                     m_tokenizer) {
                 }
 
                 XMLParser(const XMLParser&) = delete;
@@ -771,23 +1620,31 @@ namespace osmium {
                 ~XMLParser() noexcept override = default;
 
                 void run() override {
-                    osmium::thread::set_thread_name("_osmium_xml_in");
+                    set_thread_name("_osmium_xml_in");
 
-                    ExpatXMLParser parser{this};
-                    m_expat_xml_parser = &parser;
+                    const std::string tokenizer{get_file_option("xml_tokenizer")};
+                    if (!tokenizer.empty() && tokenizer != "expat" && tokenizer != "osm") {
+                        throw std::invalid_argument{"Unknown value for xml_tokenizer option: '" + tokenizer + "'"};
+                    }
+
+                    if (file_option_is_true("parallel_parsing")) {
+                        run_parallel();
+                        return;
+                    }
 
                     while (!input_done()) {
                         const std::string data{get_input()};
-                        parser(data, input_done());
+                        m_content_parser.parse(data, input_done());
                         if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
                             break;
                         }
                     }
 
-                    mark_header_as_done();
+                    m_content_parser.mark_header_as_done();
 
-                    if (m_buffer.committed() > 0) {
-                        send_to_output_queue(std::move(m_buffer));
+                    auto buffer = m_content_parser.release_buffer();
+                    if (buffer.committed() > 0) {
+                        send_to_output_queue(std::move(buffer));
                     }
                 }
 
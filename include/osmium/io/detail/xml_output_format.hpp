@@ -58,6 +58,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
 
+#include <cstddef>
 #include <iterator>
 #include <memory>
 #include <string>
@@ -152,7 +153,7 @@ namespace osmium {
 
                     if (m_options.add_metadata.timestamp() && object.timestamp()) {
                         *m_out += " timestamp=\"";
-                        *m_out += object.timestamp().to_iso_all();
+                        output_timestamp(object.timestamp());
                         *m_out += "\"";
                     }
 
@@ -198,7 +199,7 @@ namespace osmium {
                         *m_out += " user=\"";
                         append_xml_encoded_string(*m_out, comment.user());
                         *m_out += "\" date=\"";
-                        *m_out += comment.date().to_iso_all();
+                        output_timestamp(comment.date());
                         *m_out += "\">\n";
                         *m_out += "    <text>";
                         append_xml_encoded_string(*m_out, comment.text());
@@ -245,12 +246,16 @@ namespace osmium {
 
             public:
 
-                XMLOutputBlock(osmium::memory::Buffer&& buffer, const xml_output_options& options) :
+                XMLOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const xml_output_options& options) :
                     OutputBlock(std::move(buffer)),
                     m_options(options) {
                 }
 
                 std::string operator()() {
+                    // The XML output is usually about one and a half times
+                    // as large as the objects in the buffer.
+                    m_out->reserve(m_input_buffer->committed() + m_input_buffer->committed() / 2);
+
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
 
                     if (m_options.use_change_ops) {
@@ -372,13 +377,13 @@ namespace osmium {
 
                     if (changeset.created_at()) {
                         *m_out += " created_at=\"";
-                        *m_out += changeset.created_at().to_iso();
+                        output_timestamp(changeset.created_at());
                         *m_out += "\"";
                     }
 
                     if (changeset.closed_at()) {
                         *m_out += " closed_at=\"";
-                        *m_out += changeset.closed_at().to_iso();
+                        output_timestamp(changeset.closed_at());
                         *m_out += "\" open=\"false\"";
                     } else {
                         *m_out += " open=\"true\"";
@@ -464,7 +469,12 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options}));
+                    write_shared_buffer(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)));
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    const std::size_t bytes = buffer->committed();
+                    send_to_output_queue_from_pool(XMLOutputBlock{buffer, m_options}, bytes);
                 }
 
                 void write_end() final {
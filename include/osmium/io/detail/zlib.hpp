@@ -45,8 +45,15 @@ DEALINGS IN THE SOFTWARE.
 
 #include <zlib.h>
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+# include <libdeflate.h>
+#endif
+
 #include <cassert>
+#include <cstddef>
 #include <limits>
+#include <memory>
+#include <new>
 #include <string>
 
 namespace osmium {
@@ -65,9 +72,72 @@ namespace osmium {
                 }
             }
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+            struct libdeflate_compressor_deleter {
+                void operator()(::libdeflate_compressor* compressor) const noexcept {
+                    ::libdeflate_free_compressor(compressor);
+                }
+            }; // struct libdeflate_compressor_deleter
+
+            struct libdeflate_decompressor_deleter {
+                void operator()(::libdeflate_decompressor* decompressor) const noexcept {
+                    ::libdeflate_free_decompressor(decompressor);
+                }
+            }; // struct libdeflate_decompressor_deleter
+
+            // The libdeflate compressor of the current thread for the
+            // given compression level. Compressors are allocated for a
+            // fixed level, the compressor is only replaced if the level
+            // changes, which usually never happens.
+            inline ::libdeflate_compressor* thread_libdeflate_compressor(int compression_level) {
+                static thread_local std::unique_ptr<::libdeflate_compressor, libdeflate_compressor_deleter> compressor;
+                static thread_local int level = 0;
+
+                if (compression_level == Z_DEFAULT_COMPRESSION) {
+                    compression_level = 6; // same default as zlib
+                }
+
+                if (!compressor || level != compression_level) {
+                    compressor.reset(::libdeflate_alloc_compressor(compression_level));
+                    if (!compressor) {
+                        throw std::bad_alloc{};
+                    }
+                    level = compression_level;
+                }
+                return compressor.get();
+            }
+
+            // The libdeflate decompressor of the current thread. They
+            // can't be shared between threads, but can be reused.
+            inline ::libdeflate_decompressor* thread_libdeflate_decompressor() {
+                static thread_local std::unique_ptr<::libdeflate_decompressor, libdeflate_decompressor_deleter> decompressor{::libdeflate_alloc_decompressor()};
+                if (!decompressor) {
+                    throw std::bad_alloc{};
+                }
+                return decompressor.get();
+            }
+#endif
+
+            /**
+             * Name of the library used for zlib compression and
+             * decompression of PBF blobs. This is "libdeflate" if compiled
+             * with OSMIUM_WITH_LIBDEFLATE, "zlib" otherwise.
+             */
+            constexpr inline const char* zlib_backend() noexcept {
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                return "libdeflate";
+#else
+                return "zlib";
+#endif
+            }
+
             /**
              * Compress data using zlib.
              *
+             * If compiled with OSMIUM_WITH_LIBDEFLATE this uses libdeflate
+             * instead of zlib. The result is a normal zlib stream, but it
+             * is not byte-for-byte the same as what zlib would create.
+             *
              * Note that this function can not compress data larger than
              * what fits in an unsigned long, on Windows this is usually 32bit.
              *
@@ -76,6 +146,23 @@ namespace osmium {
              * @returns Compressed data.
              */
             inline std::string zlib_compress(const std::string& input, int compression_level = Z_DEFAULT_COMPRESSION) {
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                ::libdeflate_compressor* compressor = thread_libdeflate_compressor(compression_level);
+
+                std::string output(::libdeflate_zlib_compress_bound(compressor, input.size()), '\0');
+
+                const std::size_t output_size = ::libdeflate_zlib_compress(
+                    compressor,
+                    input.data(),
+                    input.size(),
+                    &*output.begin(),
+                    output.size()
+                );
+
+                if (output_size == 0) {
+                    throw io_error{"failed to compress data: buffer error"};
+                }
+#else
                 assert(input.size() < std::numeric_limits<unsigned long>::max());
                 unsigned long output_size = ::compressBound(static_cast<unsigned long>(input.size())); // NOLINT(google-runtime-int)
 
@@ -92,6 +179,7 @@ namespace osmium {
                 if (result != Z_OK) {
                     throw io_error{std::string{"failed to compress data: "} + zError(result)};
                 }
+#endif
 
                 output.resize(output_size);
 
@@ -99,21 +187,45 @@ namespace osmium {
             }
 
             /**
-             * Uncompress data using zlib.
+             * Uncompress data using zlib into output, which must have
+             * space for raw_size bytes. The memory doesn't have to be
+             * initialized.
+             *
+             * If compiled with OSMIUM_WITH_LIBDEFLATE this uses libdeflate
+             * instead of zlib, which is much faster when uncompressing
+             * whole buffers as is done here.
              *
              * Note that this function can not uncompress data larger than
              * what fits in an unsigned long, on Windows this is usually 32bit.
              *
              * @param input Compressed input data.
-             * @param raw_size Size of uncompressed data.
-             * @param output Uncompressed result data.
-             * @returns Pointer and size to incompressed data.
+             * @param input_size Size of compressed input data.
+             * @param raw_size Maximum size of uncompressed data.
+             * @param output Memory for uncompressed result data.
+             * @returns Size of uncompressed data.
+             * @throws io_error If the data could not be uncompressed.
              */
-            inline protozero::data_view zlib_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
-                output.resize(raw_size);
+            inline std::size_t zlib_uncompress(const char* input, unsigned long input_size, unsigned long raw_size, char* output) { // NOLINT(google-runtime-int)
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                std::size_t size = 0;
+                const auto result = ::libdeflate_zlib_decompress(
+                    thread_libdeflate_decompressor(),
+                    input,
+                    input_size,
+                    output,
+                    raw_size,
+                    &size
+                );
 
+                if (result != LIBDEFLATE_SUCCESS) {
+                    throw io_error{result == LIBDEFLATE_INSUFFICIENT_SPACE ? "failed to uncompress data: buffer error"
+                                                                           : "failed to uncompress data: data error"};
+                }
+
+                return size;
+#else
                 const auto result = ::uncompress(
-                    reinterpret_cast<unsigned char*>(&*output.begin()),
+                    reinterpret_cast<unsigned char*>(output),
                     &raw_size,
                     reinterpret_cast<const unsigned char*>(input),
                     input_size
@@ -123,6 +235,25 @@ namespace osmium {
                     throw io_error{std::string{"failed to uncompress data: "} + zError(result)};
                 }
 
+                return raw_size;
+#endif
+            }
+
+            /**
+             * Uncompress data using zlib.
+             *
+             * Note that this function can not uncompress data larger than
+             * what fits in an unsigned long, on Windows this is usually 32bit.
+             *
+             * @param input Compressed input data.
+             * @param raw_size Size of uncompressed data.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to incompressed data.
+             */
+            inline protozero::data_view zlib_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
+                output.resize(raw_size);
+                output.resize(zlib_uncompress(input, input_size, raw_size, &*output.begin()));
+
                 return protozero::data_view{output.data(), output.size()};
             }
 
@@ -0,0 +1,290 @@
+#ifndef OSMIUM_IO_DIFF_GENERATOR_HPP
+#define OSMIUM_IO_DIFF_GENERATOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/change_merger.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            // The current object from a source of buffers with OSM data.
+            template <typename TSource>
+            class diff_object_cursor {
+
+                TSource& m_source;
+                osmium::memory::Buffer m_buffer;
+                osmium::memory::Buffer::t_iterator<osmium::OSMObject> m_it;
+                osmium::memory::Buffer::t_iterator<osmium::OSMObject> m_end;
+
+                void next_buffer() {
+                    while (m_it == m_end) {
+                        m_buffer = m_source.read();
+                        if (!m_buffer) {
+                            return;
+                        }
+                        m_it = m_buffer.select<osmium::OSMObject>().begin();
+                        m_end = m_buffer.select<osmium::OSMObject>().end();
+                    }
+                }
+
+            public:
+
+                explicit diff_object_cursor(TSource& source) :
+                    m_source(source) {
+                    next_buffer();
+                }
+
+                bool done() const noexcept {
+                    return !m_buffer;
+                }
+
+                const osmium::OSMObject& object() const noexcept {
+                    return *m_it;
+                }
+
+                void next() {
+                    ++m_it;
+                    next_buffer();
+                }
+
+            }; // class diff_object_cursor
+
+        } // namespace detail
+
+        /**
+         * Statistics about the differences found by a DiffGenerator.
+         */
+        struct diff_stats {
+
+            /// Objects only in the new data.
+            std::size_t created = 0;
+
+            /// Objects in both with differences.
+            std::size_t modified = 0;
+
+            /// Objects only in the old data.
+            std::size_t deleted = 0;
+
+            /// Objects in both without differences.
+            std::size_t unchanged = 0;
+
+        }; // struct diff_stats
+
+        /**
+         * Creates the changes between two sorted streams of OSM data
+         * (usually two snapshots of the planet or of an extract) in a
+         * single merge-join pass over both, without reading all the data
+         * into memory.
+         *
+         * Created and modified objects are handed to the output as they
+         * are in the new data, deleted objects as they were in the old
+         * data, but with the visible flag cleared. An osmium::io::Writer
+         * for an .osc file will write them into the <create>, <modify>,
+         * and <delete> sections (objects with version 1 are created,
+         * others modified).
+         *
+         * The data must be sorted by type and id and must not contain
+         * several versions of the same object (ie. no history data).
+         *
+         * Usage:
+         * @code
+         * osmium::io::Reader old_reader{"old-planet.osm.pbf"};
+         * osmium::io::Reader new_reader{"new-planet.osm.pbf"};
+         * osmium::io::Writer writer{"changes.osc.gz"};
+         * osmium::io::DiffGenerator generator;
+         * generator.diff(old_reader, new_reader, writer);
+         * writer.close();
+         * @endcode
+         *
+         * If Readers are used, the data is decoded on their threads in
+         * parallel to the merge-join. See also osmium::io::diff_pbf_files()
+         * which skips identical blocks of two PBF files without decoding.
+         */
+        class DiffGenerator {
+
+            osmium::memory::Buffer m_deleted{1024, osmium::memory::Buffer::auto_grow::yes};
+            diff_stats m_stats;
+            bool m_compare_contents = false;
+
+            static bool same_tags(const osmium::TagList& lhs, const osmium::TagList& rhs) noexcept {
+                return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+            }
+
+            static bool same_nodes(const osmium::WayNodeList& lhs, const osmium::WayNodeList& rhs) noexcept {
+                return lhs.size() == rhs.size() &&
+                       std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const osmium::NodeRef& a, const osmium::NodeRef& b) {
+                           return a.ref() == b.ref() && a.location() == b.location();
+                       });
+            }
+
+            static bool same_members(const osmium::RelationMemberList& lhs, const osmium::RelationMemberList& rhs) noexcept {
+                return lhs.size() == rhs.size() &&
+                       std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const osmium::RelationMember& a, const osmium::RelationMember& b) {
+                           return a.type() == b.type() && a.ref() == b.ref() && !std::strcmp(a.role(), b.role());
+                       });
+            }
+
+            static bool same_contents(const osmium::OSMObject& lhs, const osmium::OSMObject& rhs) noexcept {
+                if (lhs.visible() != rhs.visible() || !same_tags(lhs.tags(), rhs.tags())) {
+                    return false;
+                }
+                switch (lhs.type()) {
+                    case osmium::item_type::node:
+                        return static_cast<const osmium::Node&>(lhs).location() == static_cast<const osmium::Node&>(rhs).location();
+                    case osmium::item_type::way:
+                        return same_nodes(static_cast<const osmium::Way&>(lhs).nodes(), static_cast<const osmium::Way&>(rhs).nodes());
+                    case osmium::item_type::relation:
+                        return same_members(static_cast<const osmium::Relation&>(lhs).members(), static_cast<const osmium::Relation&>(rhs).members());
+                    default:
+                        break;
+                }
+                return true;
+            }
+
+            template <typename TOutput>
+            void write_deleted(TOutput& output, const osmium::OSMObject& object) {
+                m_deleted.clear();
+                m_deleted.add_item(object);
+                m_deleted.commit();
+                auto& deleted = m_deleted.get<osmium::OSMObject>(0);
+                deleted.set_visible(false);
+                output(static_cast<const osmium::OSMObject&>(deleted));
+                ++m_stats.deleted;
+            }
+
+        public:
+
+            DiffGenerator() = default;
+
+            /**
+             * Also compare the contents (visibility, tags, node locations,
+             * way nodes, and relation members) of objects with the same
+             * version. Without this, only the version numbers are compared,
+             * which is enough for data from the main OSM database.
+             */
+            void compare_contents(bool value = true) noexcept {
+                m_compare_contents = value;
+            }
+
+            /**
+             * Is the object in the new data different from the one in the
+             * old data?
+             */
+            bool differ(const osmium::OSMObject& old_object, const osmium::OSMObject& new_object) const noexcept {
+                if (old_object.version() != new_object.version()) {
+                    return true;
+                }
+                return m_compare_contents && !same_contents(old_object, new_object);
+            }
+
+            /**
+             * Statistics about the differences found in all calls to
+             * diff() so far.
+             */
+            const diff_stats& stats() const noexcept {
+                return m_stats;
+            }
+
+            /**
+             * Merge-join the objects from both sources and send the
+             * differences to the output.
+             *
+             * @param old_source Source of the old data, usually an
+             *                   osmium::io::Reader. It must have a read()
+             *                   function returning buffers and an invalid
+             *                   buffer when there is no more data.
+             * @param new_source Source of the new data.
+             * @param output Called with each created, modified, or deleted
+             *               object as a const OSMObject&, for instance an
+             *               osmium::io::Writer.
+             */
+            template <typename TOldSource, typename TNewSource, typename TOutput>
+            void diff(TOldSource& old_source, TNewSource& new_source, TOutput&& output) {
+                detail::diff_object_cursor<TOldSource> old_cursor{old_source};
+                detail::diff_object_cursor<TNewSource> new_cursor{new_source};
+
+                while (!old_cursor.done() && !new_cursor.done()) {
+                    const auto& old_object = old_cursor.object();
+                    const auto& new_object = new_cursor.object();
+                    if (detail::object_less_type_id(old_object, new_object)) {
+                        write_deleted(output, old_object);
+                        old_cursor.next();
+                    } else if (detail::object_less_type_id(new_object, old_object)) {
+                        output(new_object);
+                        ++m_stats.created;
+                        new_cursor.next();
+                    } else {
+                        if (differ(old_object, new_object)) {
+                            output(new_object);
+                            ++m_stats.modified;
+                        } else {
+                            ++m_stats.unchanged;
+                        }
+                        old_cursor.next();
+                        new_cursor.next();
+                    }
+                }
+
+                for (; !old_cursor.done(); old_cursor.next()) {
+                    write_deleted(output, old_cursor.object());
+                }
+
+                for (; !new_cursor.done(); new_cursor.next()) {
+                    output(new_cursor.object());
+                    ++m_stats.created;
+                }
+            }
+
+        }; // class DiffGenerator
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DIFF_GENERATOR_HPP
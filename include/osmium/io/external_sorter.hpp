@@ -0,0 +1,304 @@
+#ifndef OSMIUM_IO_EXTERNAL_SORTER_HPP
+#define OSMIUM_IO_EXTERNAL_SORTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/file.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/object_pointer_collection.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Sorts OSM objects in the usual order (type, id, version, see
+         * osmium::object_order_type_id_version) even if they don't fit
+         * into memory.
+         *
+         * Buffers with objects are added to the sorter. As long as they
+         * take up less than the configured amount of memory they are kept
+         * in memory. When that limit is reached, the objects are sorted
+         * using all threads in the thread pool and written out as a "run"
+         * to a temporary PBF file. When sort() is called, all runs are read
+         * back in parallel and merged. If no run had to be written, the
+         * objects are sorted completely in memory.
+         *
+         * Equal objects (same type, id, version and timestamp) keep the
+         * order in which they were added.
+         *
+         * Only OSM objects (nodes, ways, and relations) are sorted, other
+         * items such as changesets are ignored.
+         */
+        class ExternalSorter {
+
+            struct run_reader {
+
+                osmium::io::Reader reader;
+                osmium::memory::Buffer buffer;
+                osmium::memory::Buffer::t_iterator<osmium::OSMObject> it{};
+                osmium::memory::Buffer::t_iterator<osmium::OSMObject> end{};
+                std::size_t run;
+
+                run_reader(const osmium::io::File& file, osmium::thread::Pool& pool, std::size_t run_number) :
+                    reader(file, pool),
+                    run(run_number) {
+                }
+
+                // Returns false at the end of the run.
+                bool next() {
+                    if (it != end) {
+                        ++it;
+                    }
+                    while (it == end) {
+                        buffer = reader.read();
+                        if (!buffer) {
+                            return false;
+                        }
+                        it = buffer.begin<osmium::OSMObject>();
+                        end = buffer.end<osmium::OSMObject>();
+                    }
+                    return true;
+                }
+
+            }; // struct run_reader
+
+            // Used for the priority queue: the smallest object comes out
+            // first, for equal objects the one from the earlier run.
+            struct run_reader_greater {
+
+                bool operator()(const run_reader* lhs, const run_reader* rhs) const noexcept {
+                    const osmium::object_order_type_id_version less{};
+                    if (less(*rhs->it, *lhs->it)) {
+                        return true;
+                    }
+                    if (less(*lhs->it, *rhs->it)) {
+                        return false;
+                    }
+                    return lhs->run > rhs->run;
+                }
+
+            }; // struct run_reader_greater
+
+            std::string m_prefix;
+            std::size_t m_max_bytes;
+            osmium::thread::Pool& m_pool;
+            std::vector<osmium::memory::Buffer> m_buffers;
+            std::size_t m_bytes = 0;
+            std::vector<std::string> m_run_files;
+
+            static osmium::io::File run_file(const std::string& filename) {
+                osmium::io::File file{filename, "pbf,pbf_compression=none"};
+                file.set_has_multiple_object_versions(true);
+                return file;
+            }
+
+            osmium::ObjectPointerCollection sort_in_memory() {
+                osmium::ObjectPointerCollection objects;
+                for (auto& buffer : m_buffers) {
+                    osmium::apply(buffer, objects);
+                }
+                objects.sort(osmium::object_order_type_id_version{}, m_pool);
+                return objects;
+            }
+
+            void clear_buffers() {
+                m_buffers.clear();
+                m_bytes = 0;
+            }
+
+            void write_run() {
+                if (m_buffers.empty()) {
+                    return;
+                }
+
+                const auto objects = sort_in_memory();
+
+                std::string filename{m_prefix + std::to_string(m_run_files.size()) + ".osm.pbf"};
+                osmium::io::Writer writer{run_file(filename), m_pool, osmium::io::overwrite::allow};
+                m_run_files.push_back(std::move(filename));
+                for (auto it = objects.cbegin(); it != objects.cend(); ++it) {
+                    writer(*it);
+                }
+                writer.close();
+
+                clear_buffers();
+            }
+
+            template <typename TOutput>
+            void merge_runs(TOutput& output) {
+                std::vector<std::unique_ptr<run_reader>> readers;
+                std::priority_queue<run_reader*, std::vector<run_reader*>, run_reader_greater> queue;
+
+                for (std::size_t run = 0; run < m_run_files.size(); ++run) {
+                    readers.emplace_back(new run_reader{run_file(m_run_files[run]), m_pool, run});
+                    if (readers.back()->next()) {
+                        queue.push(readers.back().get());
+                    }
+                }
+
+                while (!queue.empty()) {
+                    auto* reader = queue.top();
+                    queue.pop();
+                    output(*reader->it);
+                    if (reader->next()) {
+                        queue.push(reader);
+                    }
+                }
+
+                for (auto& reader : readers) {
+                    reader->reader.close();
+                }
+            }
+
+            void remove_run_files() noexcept {
+                for (const auto& filename : m_run_files) {
+                    std::remove(filename.c_str());
+                }
+                m_run_files.clear();
+            }
+
+        public:
+
+            /**
+             * Create an ExternalSorter.
+             *
+             * @param prefix Prefix for the names of the temporary files.
+             *               A number and ".osm.pbf" is added to it. Can
+             *               contain a directory name.
+             * @param max_bytes Maximum number of bytes of buffer contents
+             *                  to keep in memory before writing a run.
+             * @param pool Thread pool used for sorting and for writing
+             *             and reading the temporary files.
+             */
+            explicit ExternalSorter(std::string prefix,
+                                    std::size_t max_bytes = 1024UL * 1024UL * 1024UL,
+                                    osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) :
+                m_prefix(std::move(prefix)),
+                m_max_bytes(max_bytes),
+                m_pool(pool) {
+            }
+
+            ExternalSorter(const ExternalSorter&) = delete;
+            ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+            ExternalSorter(ExternalSorter&&) = delete;
+            ExternalSorter& operator=(ExternalSorter&&) = delete;
+
+            /**
+             * Removes any temporary files still around.
+             */
+            ~ExternalSorter() noexcept {
+                remove_run_files();
+            }
+
+            /**
+             * Add a buffer with OSM objects. The sorter takes ownership of
+             * the buffer.
+             */
+            void add(osmium::memory::Buffer&& buffer) {
+                if (!buffer || buffer.committed() == 0) {
+                    return;
+                }
+                m_bytes += buffer.committed();
+                m_buffers.push_back(std::move(buffer));
+                if (m_bytes >= m_max_bytes) {
+                    write_run();
+                }
+            }
+
+            /**
+             * Add all buffers from a source, usually an osmium::io::Reader.
+             * The source must have a read() function returning buffers and
+             * an invalid buffer when there is no more data.
+             */
+            template <typename TSource>
+            void add(TSource& source) {
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    add(std::move(buffer));
+                }
+            }
+
+            /**
+             * The number of runs written to temporary files so far.
+             */
+            std::size_t num_runs() const noexcept {
+                return m_run_files.size();
+            }
+
+            /**
+             * Send all objects in order to the output. Afterwards the
+             * sorter is empty and all temporary files are removed.
+             *
+             * @param output Called with each object as a const OSMObject&,
+             *               for instance an osmium::io::Writer.
+             */
+            template <typename TOutput>
+            void sort(TOutput&& output) {
+                if (m_run_files.empty()) {
+                    const auto objects = sort_in_memory();
+                    for (auto it = objects.cbegin(); it != objects.cend(); ++it) {
+                        output(*it);
+                    }
+                    clear_buffers();
+                    return;
+                }
+
+                write_run();
+                merge_runs(output);
+                remove_run_files();
+            }
+
+        }; // class ExternalSorter
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_EXTERNAL_SORTER_HPP
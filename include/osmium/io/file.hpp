@@ -225,6 +225,12 @@ namespace osmium {
                 } else if (suffixes.back() == "blackhole") {
                     m_file_format = file_format::blackhole;
                     suffixes.pop_back();
+                } else if (suffixes.back() == "geojsonseq" || suffixes.back() == "geojsons") {
+                    m_file_format = file_format::geojsonseq;
+                    suffixes.pop_back();
+                } else if (suffixes.back() == "parquet") {
+                    m_file_format = file_format::parquet;
+                    suffixes.pop_back();
                 }
 
                 if (suffixes.empty()) {
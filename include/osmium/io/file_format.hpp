@@ -40,15 +40,17 @@ namespace osmium {
     namespace io {
 
         enum class file_format {
-            unknown   = 0,
-            xml       = 1,
-            pbf       = 2,
-            opl       = 3,
-            json      = 4,
-            o5m       = 5,
-            debug     = 6,
-            blackhole = 7,
-            last      = 7 // must have the same value as the last real value
+            unknown    = 0,
+            xml        = 1,
+            pbf        = 2,
+            opl        = 3,
+            json       = 4,
+            o5m        = 5,
+            debug      = 6,
+            blackhole  = 7,
+            geojsonseq = 8,
+            parquet    = 9,
+            last       = 9 // must have the same value as the last real value
         };
 
         enum class read_meta {
@@ -72,6 +74,10 @@ namespace osmium {
                     return "DEBUG";
                 case file_format::blackhole:
                     return "BLACKHOLE";
+                case file_format::geojsonseq:
+                    return "GEOJSONSEQ";
+                case file_format::parquet:
+                    return "PARQUET";
                 default: // file_format::unknown
                     break;
             }
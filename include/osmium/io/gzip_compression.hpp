@@ -43,18 +43,25 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compressor.hpp>
+#include <osmium/io/detail/parallel_decompressor.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
+#include <osmium/io/source.hpp>
 #include <osmium/io/writer_options.hpp>
 
 #include <zlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <string>
+#include <utility>
+#include <vector>
 
 #ifndef _MSC_VER
 # include <unistd.h>
@@ -322,8 +329,286 @@ namespace osmium {
 
         }; // class GzipBufferDecompressor
 
+        /**
+         * Decompressor reading gzip-compressed data from a Source.
+         * Several concatenated gzip members are decompressed one after
+         * the other.
+         */
+        class GzipSourceDecompressor final : public Decompressor {
+
+            osmium::io::Source* m_source;
+            std::string m_input;
+            z_stream m_zstream;
+            std::size_t m_offset = 0;
+            bool m_in_member = false;
+            bool m_done = false;
+
+            [[noreturn]] void throw_inflate_error(const char* what, const int result) const {
+                std::string message{"gzip error: "};
+                message += what;
+                if (m_zstream.msg) {
+                    message.append(m_zstream.msg);
+                }
+                throw osmium::gzip_error{message, result};
+            }
+
+        public:
+
+            /**
+             * Read from the source. The source must outlive the
+             * decompressor.
+             */
+            explicit GzipSourceDecompressor(osmium::io::Source& source) :
+                m_source(&source),
+                m_input(osmium::io::Decompressor::input_buffer_size, '\0'),
+                m_zstream() {
+                const int result = inflateInit2(&m_zstream, MAX_WBITS | 32); // NOLINT(hicpp-signed-bitwise)
+                if (result != Z_OK) {
+                    throw_inflate_error("decompression init failed: ", result);
+                }
+            }
+
+            GzipSourceDecompressor(const GzipSourceDecompressor&) = delete;
+            GzipSourceDecompressor& operator=(const GzipSourceDecompressor&) = delete;
+
+            GzipSourceDecompressor(GzipSourceDecompressor&&) = delete;
+            GzipSourceDecompressor& operator=(GzipSourceDecompressor&&) = delete;
+
+            ~GzipSourceDecompressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            std::string read() override {
+                std::string output;
+                if (m_done || !m_source) {
+                    return output;
+                }
+
+                output.resize(osmium::io::Decompressor::input_buffer_size);
+                m_zstream.next_out = reinterpret_cast<unsigned char*>(&*output.begin());
+                m_zstream.avail_out = static_cast<unsigned int>(output.size());
+
+                while (m_zstream.avail_out > 0) {
+                    if (m_zstream.avail_in == 0) {
+                        const std::size_t nread = m_source->read(&*m_input.begin(), m_input.size());
+                        if (nread == 0) {
+                            if (m_in_member) {
+                                throw osmium::gzip_error{"gzip error: unexpected end of input"};
+                            }
+                            m_done = true;
+                            break;
+                        }
+                        m_offset += nread;
+                        set_offset(m_offset);
+                        m_zstream.next_in = reinterpret_cast<unsigned char*>(&*m_input.begin());
+                        m_zstream.avail_in = static_cast<unsigned int>(nread);
+                    }
+
+                    if (!m_in_member) {
+                        inflateReset(&m_zstream);
+                        m_in_member = true;
+                    }
+
+                    const int result = inflate(&m_zstream, Z_NO_FLUSH);
+                    if (result == Z_STREAM_END) {
+                        m_in_member = false;
+                    } else if (result != Z_OK) {
+                        throw_inflate_error("inflate failed: ", result);
+                    }
+                }
+
+                output.resize(static_cast<std::size_t>(m_zstream.next_out - reinterpret_cast<const unsigned char*>(output.data())));
+                return output;
+            }
+
+            void close() override {
+                if (m_source) {
+                    osmium::io::Source* source = m_source;
+                    m_source = nullptr;
+                    inflateEnd(&m_zstream);
+                    source->close();
+                }
+            }
+
+        }; // class GzipSourceDecompressor
+
         namespace detail {
 
+            /**
+             * Find the members of a gzip file in BGZF format (as written
+             * by bgzip). Each member of such a file has the size of the
+             * member in an extra field of its header. This allows
+             * splitting the file into members without decompressing it.
+             *
+             * @returns The members or an empty vector if this is not a
+             *          BGZF file.
+             * @throws osmium::gzip_error If a member header is truncated.
+             */
+            inline std::vector<compressed_segment> find_bgzf_members(const char* data, const std::size_t size) {
+                enum : std::size_t {
+                    header_size = 12 // fixed header including XLEN field
+                };
+
+                std::vector<compressed_segment> members;
+                const auto* const udata = reinterpret_cast<const unsigned char*>(data);
+
+                std::size_t offset = 0;
+                while (offset < size) {
+                    if (size - offset < header_size) {
+                        throw osmium::gzip_error{"gzip error: truncated BGZF member header"};
+                    }
+                    const unsigned char* header = udata + offset;
+                    if (header[0] != 0x1fU || header[1] != 0x8bU || header[2] != 8U || (header[3] & 0x04U) == 0) {
+                        return {};
+                    }
+                    const std::size_t xlen = header[10] | (static_cast<std::size_t>(header[11]) << 8U);
+                    if (size - offset - header_size < xlen) {
+                        throw osmium::gzip_error{"gzip error: truncated BGZF member header"};
+                    }
+
+                    std::size_t block_size = 0;
+                    for (std::size_t pos = header_size; pos + 4 <= header_size + xlen;) {
+                        const std::size_t slen = header[pos + 2] | (static_cast<std::size_t>(header[pos + 3]) << 8U);
+                        if (header[pos] == 'B' && header[pos + 1] == 'C' && slen == 2 && pos + 6 <= header_size + xlen) {
+                            block_size = (header[pos + 4] | (static_cast<std::size_t>(header[pos + 5]) << 8U)) + 1;
+                            break;
+                        }
+                        pos += 4 + slen;
+                    }
+
+                    if (block_size == 0) {
+                        return {};
+                    }
+                    if (block_size > size - offset) {
+                        throw osmium::gzip_error{"gzip error: truncated BGZF member"};
+                    }
+                    members.push_back(compressed_segment{offset, block_size});
+                    offset += block_size;
+                }
+
+                return members;
+            }
+
+            /**
+             * Decompress a single complete gzip member.
+             *
+             * @throws osmium::gzip_error If the data could not be
+             *         decompressed.
+             */
+            inline std::string gzip_decompress_member(const char* data, const std::size_t size) {
+                assert(size < std::numeric_limits<unsigned int>::max());
+
+                z_stream zstream{};
+                zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data));
+                zstream.avail_in = static_cast<unsigned int>(size);
+                int result = inflateInit2(&zstream, MAX_WBITS | 16); // NOLINT(hicpp-signed-bitwise)
+                if (result != Z_OK) {
+                    throw osmium::gzip_error{"gzip error: decompression init failed", result};
+                }
+
+                std::string output;
+                do {
+                    const std::size_t done = output.size();
+                    output.resize(done + std::max(size * 4, std::size_t(64 * 1024)));
+                    zstream.next_out = reinterpret_cast<unsigned char*>(&*output.begin() + done);
+                    zstream.avail_out = static_cast<unsigned int>(output.size() - done);
+                    result = inflate(&zstream, Z_NO_FLUSH);
+                    output.resize(static_cast<std::size_t>(reinterpret_cast<const char*>(zstream.next_out) - output.data()));
+                } while (result == Z_OK);
+
+                std::string message{"gzip error: inflate failed: "};
+                if (zstream.msg) {
+                    message.append(zstream.msg);
+                }
+                inflateEnd(&zstream);
+
+                if (result != Z_STREAM_END) {
+                    throw osmium::gzip_error{message, result};
+                }
+
+                return output;
+            }
+
+            enum : std::size_t {
+                // Same as bgzip, so that the compressed members nearly
+                // always fit into the 64k limit of the BGZF format.
+                gzip_parallel_block_size = 0xff00
+            };
+
+            /**
+             * Compress a block of data into a single complete gzip member.
+             * If the member is small enough it is written in BGZF format
+             * with its size in an extra field, so that files made of these
+             * members can be decompressed in parallel.
+             *
+             * @throws osmium::gzip_error If the data could not be
+             *         compressed.
+             */
+            inline std::string gzip_compress_member(const char* data, const std::size_t size) {
+                enum : std::size_t {
+                    bgzf_header_size = 18,
+                    trailer_size = 8,
+                    max_bgzf_member_size = 0x10000
+                };
+
+                assert(size < std::numeric_limits<unsigned int>::max());
+
+                z_stream zstream{};
+                int result = deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+                if (result != Z_OK) {
+                    throw osmium::gzip_error{"gzip error: compression init failed", result};
+                }
+
+                std::string output(bgzf_header_size + deflateBound(&zstream, static_cast<uLong>(size)) + trailer_size, '\0');
+                zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data));
+                zstream.avail_in = static_cast<unsigned int>(size);
+                zstream.next_out = reinterpret_cast<unsigned char*>(&*output.begin() + bgzf_header_size);
+                zstream.avail_out = static_cast<unsigned int>(output.size() - bgzf_header_size - trailer_size);
+                result = deflate(&zstream, Z_FINISH);
+                const std::size_t deflated_size = zstream.total_out;
+                deflateEnd(&zstream);
+                if (result != Z_STREAM_END) {
+                    throw osmium::gzip_error{"gzip error: deflate failed", result};
+                }
+
+                const auto put32 = [](char* out, const uint32_t value) {
+                    for (unsigned int i = 0; i < 4; ++i) {
+                        out[i] = static_cast<char>((value >> (8U * i)) & 0xffU);
+                    }
+                };
+
+                // Header with magic, deflate method, no mtime, unknown OS.
+                const char header[bgzf_header_size] = {
+                    '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff',
+                    6, 0, 'B', 'C', 2, 0, 0, 0
+                };
+                std::size_t header_size = bgzf_header_size;
+                const std::size_t member_size = bgzf_header_size + deflated_size + trailer_size;
+                if (member_size <= max_bgzf_member_size) {
+                    std::copy_n(header, bgzf_header_size, &output[0]);
+                    output[3] = 4; // FEXTRA
+                    output[16] = static_cast<char>((member_size - 1) & 0xffU);
+                    output[17] = static_cast<char>((member_size - 1) >> 8U);
+                } else {
+                    // Too large for BGZF, write a plain gzip header in
+                    // front of the deflated data.
+                    header_size = 10;
+                    std::copy_n(header, header_size, &output[bgzf_header_size - header_size]);
+                }
+
+                char* trailer = &output[bgzf_header_size + deflated_size];
+                put32(trailer, static_cast<uint32_t>(crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const unsigned char*>(data), static_cast<unsigned int>(size))));
+                put32(trailer + 4, static_cast<uint32_t>(size & 0xffffffffU));
+                output.resize(bgzf_header_size + deflated_size + trailer_size);
+                output.erase(0, bgzf_header_size - header_size);
+
+                return output;
+            }
+
             // we want the register_compression() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_gzip_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::gzip,
@@ -332,9 +617,29 @@ namespace osmium {
                 [](const char* buffer, const std::size_t size) { return new osmium::io::GzipBufferDecompressor{buffer, size}; }
             );
 
+            const bool registered_gzip_parallel_decompression = osmium::io::CompressionFactory::instance().register_parallel_decompression(osmium::io::file_compression::gzip,
+                [](const char* buffer, const std::size_t size, osmium::thread::Pool& pool) -> osmium::io::Decompressor* {
+                    auto members = find_bgzf_members(buffer, size);
+                    if (members.size() < 2) {
+                        return nullptr;
+                    }
+                    return new ParallelDecompressor{buffer, std::move(members), gzip_decompress_member, pool};
+                }
+            );
+
+            const bool registered_gzip_parallel_compression = osmium::io::CompressionFactory::instance().register_parallel_compression(osmium::io::file_compression::gzip,
+                [](const int fd, const fsync sync, osmium::thread::Pool& pool) {
+                    return new ParallelCompressor{fd, sync, gzip_compress_member, pool, gzip_parallel_block_size};
+                }
+            );
+
+            const bool registered_gzip_source_decompression = osmium::io::CompressionFactory::instance().register_source_decompression(osmium::io::file_compression::gzip,
+                [](osmium::io::Source& source) { return new osmium::io::GzipSourceDecompressor{source}; }
+            );
+
             // dummy function to silence the unused variable warning from above
             inline bool get_registered_gzip_compression() noexcept {
-                return registered_gzip_compression;
+                return registered_gzip_compression && registered_gzip_parallel_decompression && registered_gzip_parallel_compression && registered_gzip_source_decompression;
             }
 
         } // namespace detail
@@ -34,9 +34,13 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
 #include <osmium/util/options.hpp>
 
+#include <cstdint>
 #include <initializer_list>
+#include <string>
 #include <vector>
 
 namespace osmium {
@@ -77,6 +81,18 @@ namespace osmium {
              */
             bool m_has_multiple_object_versions = false;
 
+            uint64_t get_number(const std::string& key) const {
+                const std::string value{get(key)};
+                if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+                    return 0;
+                }
+                try {
+                    return std::stoull(value);
+                } catch (...) {
+                    return 0;
+                }
+            }
+
         public:
 
             Header() = default;
@@ -160,6 +176,53 @@ namespace osmium {
                 return *this;
             }
 
+            /**
+             * Get the number of objects of the given type (node, way, or
+             * relation) in the file as recorded in the header. Only some
+             * files have this information, it can be used to presize
+             * indexes before reading the file.
+             *
+             * @returns The number of objects or 0 if unknown.
+             */
+            uint64_t object_count(const osmium::item_type type) const {
+                return get_number(std::string{osmium::item_type_to_name(type)} + "_count");
+            }
+
+            /**
+             * Set the number of objects of the given type (node, way, or
+             * relation) in the file. This is only written to the file by
+             * output formats supporting it and only if asked to (for PBF
+             * with the pbf_object_counts option).
+             *
+             * @returns The header itself to allow chaining.
+             */
+            Header& set_object_count(const osmium::item_type type, const uint64_t count) {
+                set(std::string{osmium::item_type_to_name(type)} + "_count", std::to_string(count));
+                return *this;
+            }
+
+            /**
+             * Get the largest id of objects of the given type (node, way,
+             * or relation) in the file as recorded in the header.
+             *
+             * @returns The largest id or 0 if unknown.
+             */
+            osmium::object_id_type max_object_id(const osmium::item_type type) const {
+                return static_cast<osmium::object_id_type>(get_number(std::string{"max_"} + osmium::item_type_to_name(type) + "_id"));
+            }
+
+            /**
+             * Set the largest id of objects of the given type (node, way,
+             * or relation) in the file. See set_object_count() for when
+             * this is written.
+             *
+             * @returns The header itself to allow chaining.
+             */
+            Header& set_max_object_id(const osmium::item_type type, const osmium::object_id_type id) {
+                set(std::string{"max_"} + osmium::item_type_to_name(type) + "_id", std::to_string(id));
+                return *this;
+            }
+
         }; // class Header
 
     } // namespace io
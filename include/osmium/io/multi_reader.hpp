@@ -0,0 +1,398 @@
+#ifndef OSMIUM_IO_MULTI_READER_HPP
+#define OSMIUM_IO_MULTI_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/file.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * The order in which a MultiReader returns the data.
+         */
+        enum class multi_reader_order {
+            interleaved = 0,
+            type_id     = 1
+        };
+
+        /**
+         * Reads several OSM files at the same time. All files are opened
+         * at once and decoded in parallel, each by its own Reader, usually
+         * on the same shared thread pool. The data is returned in one of
+         * two ways:
+         *
+         * * multi_reader_order::interleaved: The buffers are returned as
+         *   they become available from any of the files. Use this for
+         *   handlers that don't care about the order of objects.
+         * * multi_reader_order::type_id: The objects from all files are
+         *   merged into one stream ordered by type, id, and version (k-way
+         *   merge). All input files must be sorted in this order. Objects
+         *   with the same type, id, and version in several files (for
+         *   instance in overlapping extracts) are only returned once.
+         *
+         * Usage:
+         * @code
+         * std::vector<osmium::io::File> files{...};
+         * osmium::io::MultiReader reader{files, osmium::io::multi_reader_order::type_id};
+         * while (osmium::memory::Buffer buffer = reader.read()) {
+         *     ...
+         * }
+         * reader.close();
+         * @endcode
+         *
+         * Every file needs its own read and parser thread, so don't open
+         * hundreds of files at the same time.
+         */
+        class MultiReader {
+
+            enum {
+                // Merged output buffers are returned when they reach
+                // this size.
+                output_buffer_size = 1024UL * 1024UL
+            };
+
+            using object_iterator = osmium::memory::Buffer::t_const_iterator<osmium::OSMObject>;
+
+            struct input {
+
+                std::unique_ptr<osmium::io::Reader> reader;
+
+                // Only used in type_id order: The current buffer and the
+                // next object in it.
+                osmium::memory::Buffer buffer{};
+                object_iterator it{};
+                object_iterator end{};
+
+                bool done = false;
+
+            }; // struct input
+
+            std::vector<input> m_inputs;
+
+            multi_reader_order m_order;
+
+            // Used to wait for data from any of the readers in
+            // interleaved order. This is shared with the ready callbacks
+            // of the readers which can still run in the pool threads
+            // when the MultiReader is already gone.
+            struct signal {
+                std::mutex mutex{};
+                std::condition_variable data_available{};
+                uint64_t notifications = 0;
+            };
+
+            std::shared_ptr<signal> m_signal{std::make_shared<signal>()};
+
+            // Next reader to check in interleaved order (round-robin).
+            std::size_t m_next = 0;
+
+            // Inputs with objects left in type_id order, as a heap with
+            // the smallest current object on top.
+            std::vector<input*> m_heap{};
+            bool m_heap_initialized = false;
+
+            // Type, id, and version of the last object returned in
+            // type_id order to find duplicates.
+            osmium::item_type m_last_type = osmium::item_type::undefined;
+            osmium::object_id_type m_last_id = 0;
+            osmium::object_version_type m_last_version = 0;
+
+            static bool greater(const input* lhs, const input* rhs) noexcept {
+                return *rhs->it < *lhs->it;
+            }
+
+            // Make sure the input has a current object, reading the next
+            // buffer if needed. Returns false at the end of the input.
+            static bool fill(input& in) {
+                while (in.it == in.end) {
+                    in.buffer = in.reader->read();
+                    if (!in.buffer) {
+                        in.done = true;
+                        return false;
+                    }
+                    in.it = in.buffer.cbegin<osmium::OSMObject>();
+                    in.end = in.buffer.cend<osmium::OSMObject>();
+                }
+                return true;
+            }
+
+            osmium::memory::Buffer read_interleaved() {
+                while (true) {
+                    uint64_t notifications = 0;
+                    {
+                        const std::lock_guard<std::mutex> lock{m_signal->mutex};
+                        notifications = m_signal->notifications;
+                    }
+
+                    bool all_done = true;
+                    for (std::size_t n = 0; n < m_inputs.size(); ++n) {
+                        auto& in = m_inputs[(m_next + n) % m_inputs.size()];
+                        if (in.done) {
+                            continue;
+                        }
+                        osmium::memory::Buffer buffer;
+                        if (in.reader->try_read(buffer)) {
+                            if (buffer) {
+                                m_next = (m_next + n + 1) % m_inputs.size();
+                                return buffer;
+                            }
+                            in.done = true;
+                        } else {
+                            all_done = false;
+                        }
+                    }
+
+                    if (all_done) {
+                        return osmium::memory::Buffer{};
+                    }
+
+                    // Nothing available, wait until one of the readers
+                    // notifies us. Because we remembered the count before
+                    // checking the readers, no notification can get lost.
+                    auto& sig = *m_signal;
+                    std::unique_lock<std::mutex> lock{sig.mutex};
+                    sig.data_available.wait(lock, [&sig, notifications] {
+                        return sig.notifications != notifications;
+                    });
+                }
+            }
+
+            osmium::memory::Buffer read_merged() {
+                if (!m_heap_initialized) {
+                    for (auto& in : m_inputs) {
+                        if (fill(in)) {
+                            m_heap.push_back(&in);
+                        }
+                    }
+                    std::make_heap(m_heap.begin(), m_heap.end(), greater);
+                    m_heap_initialized = true;
+                }
+
+                if (m_heap.empty()) {
+                    return osmium::memory::Buffer{};
+                }
+
+                osmium::memory::Buffer buffer{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+
+                while (!m_heap.empty() && buffer.committed() < output_buffer_size) {
+                    std::pop_heap(m_heap.begin(), m_heap.end(), greater);
+                    input* in = m_heap.back();
+
+                    const osmium::OSMObject& object = *in->it;
+                    if (object.type() != m_last_type ||
+                        object.id() != m_last_id ||
+                        object.version() != m_last_version) {
+                        buffer.add_item(object);
+                        buffer.commit();
+                        m_last_type = object.type();
+                        m_last_id = object.id();
+                        m_last_version = object.version();
+                    }
+
+                    ++in->it;
+                    if (fill(*in)) {
+                        std::push_heap(m_heap.begin(), m_heap.end(), greater);
+                    } else {
+                        m_heap.pop_back();
+                    }
+                }
+
+                if (buffer.committed() == 0) {
+                    return osmium::memory::Buffer{};
+                }
+                return buffer;
+            }
+
+        public:
+
+            /**
+             * Open all files for reading.
+             *
+             * @param files The files to read.
+             * @param order Order in which the data is returned.
+             * @param args Further arguments given to the constructor of
+             *             each Reader, see there. The same arguments are
+             *             used for all files. The ready_callback option
+             *             can not be used, the MultiReader sets it itself.
+             *
+             * @throws std::invalid_argument If files is empty.
+             * @throws osmium::io_error If there was an error.
+             * @throws std::system_error If a file could not be opened.
+             */
+            template <typename... TArgs>
+            explicit MultiReader(const std::vector<osmium::io::File>& files, multi_reader_order order, TArgs&&... args) :
+                m_inputs(files.size()),
+                m_order(order) {
+                if (files.empty()) {
+                    throw std::invalid_argument{"MultiReader needs at least one file"};
+                }
+                std::shared_ptr<signal> sig = m_signal;
+                const osmium::io::ready_callback callback{[sig]() {
+                    const std::lock_guard<std::mutex> lock{sig->mutex};
+                    ++sig->notifications;
+                    sig->data_available.notify_all();
+                }};
+                for (std::size_t i = 0; i < files.size(); ++i) {
+                    m_inputs[i].reader.reset(new osmium::io::Reader{files[i], args..., callback});
+                }
+            }
+
+            MultiReader(const MultiReader&) = delete;
+            MultiReader& operator=(const MultiReader&) = delete;
+
+            MultiReader(MultiReader&&) = delete;
+            MultiReader& operator=(MultiReader&&) = delete;
+
+            ~MultiReader() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /// The number of files.
+            std::size_t size() const noexcept {
+                return m_inputs.size();
+            }
+
+            multi_reader_order order() const noexcept {
+                return m_order;
+            }
+
+            /**
+             * Close all Readers.
+             *
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void close() {
+                for (auto& in : m_inputs) {
+                    if (in.reader) {
+                        in.reader->close();
+                    }
+                }
+            }
+
+            /**
+             * Get the header of the first file with the bounding boxes
+             * of all files added. The "multiple object versions" flag is
+             * set if it is set for any of the files.
+             *
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            osmium::io::Header header() {
+                osmium::io::Header result = m_inputs.front().reader->header();
+                for (std::size_t i = 1; i < m_inputs.size(); ++i) {
+                    const auto header = m_inputs[i].reader->header();
+                    for (const auto& box : header.boxes()) {
+                        result.add_box(box);
+                    }
+                    if (header.has_multiple_object_versions()) {
+                        result.set_has_multiple_object_versions(true);
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * Get the header of the file with the given index.
+             */
+            osmium::io::Header header(std::size_t index) {
+                return m_inputs.at(index).reader->header();
+            }
+
+            /**
+             * Reads the next buffer. An invalid buffer signals that all
+             * files have been read completely.
+             *
+             * @returns Buffer.
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            osmium::memory::Buffer read() {
+                if (m_order == multi_reader_order::interleaved) {
+                    return read_interleaved();
+                }
+                return read_merged();
+            }
+
+            /**
+             * Has all data from all files been read?
+             */
+            bool eof() const {
+                return std::all_of(m_inputs.begin(), m_inputs.end(), [](const input& in) {
+                    return in.done || in.reader->eof();
+                });
+            }
+
+        }; // class MultiReader
+
+    } // namespace io
+
+    template <typename... THandlers>
+    inline void apply_multi_reader_impl(osmium::io::MultiReader& reader, THandlers&&... handlers) {
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            detail::apply_buffer_impl(buffer, handlers...);
+        }
+        apply_flush(std::forward<THandlers>(handlers)...);
+    }
+
+    /**
+     * Apply the handlers to all objects read from the MultiReader.
+     */
+    template <typename... THandlers>
+    inline void apply(osmium::io::MultiReader& reader, THandlers&&... handlers) {
+        apply_multi_reader_impl(reader, detail::make_handler<THandlers>(std::forward<THandlers>(handlers))...);
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_MULTI_READER_HPP
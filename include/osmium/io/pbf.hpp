@@ -50,6 +50,10 @@ namespace osmium {
             types.push_back("lz4");
 #endif
 
+#if OSMIUM_WITH_ZSTD
+            types.push_back("zstd");
+#endif
+
             return types;
         }
 
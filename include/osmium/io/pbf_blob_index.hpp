@@ -0,0 +1,415 @@
+#ifndef OSMIUM_IO_PBF_BLOB_INDEX_HPP
+#define OSMIUM_IO_PBF_BLOB_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to create or use a PBF blob index.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/range_source.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * One entry in a PBFBlobIndex describing one data Blob in a PBF
+         * file. This is a POD and written to disk as is.
+         */
+        struct pbf_blob_index_entry {
+
+            /// Offset of the Blob (after the BlobHeader) in the file.
+            uint64_t offset = 0;
+
+            /// Size of the Blob in bytes.
+            uint32_t size = 0;
+
+            /// Object types in this Blob (osmium::osm_entity_bits::type).
+            uint32_t types = 0;
+
+            /// Smallest object id in this Blob.
+            int64_t min_id = 0;
+
+            /// Largest object id in this Blob.
+            int64_t max_id = 0;
+
+            osmium::osm_entity_bits::type entity_bits() const noexcept {
+                return static_cast<osmium::osm_entity_bits::type>(types);
+            }
+
+            /**
+             * Does this Blob possibly contain objects of the given type
+             * with ids in the range [first_id, last_id]?
+             */
+            bool overlaps(const osmium::item_type type, const osmium::object_id_type first_id, const osmium::object_id_type last_id) const noexcept {
+                return (entity_bits() & osmium::osm_entity_bits::from_item_type(type)) &&
+                       min_id <= last_id && max_id >= first_id;
+            }
+
+        }; // struct pbf_blob_index_entry
+
+        /**
+         * Index of all data Blobs in a PBF file. For each Blob it contains
+         * the offset and size of the Blob in the file, which object types
+         * are in it and the range of object ids.
+         *
+         * It is built once from the PBF file (see build()) and can then be
+         * stored in a sidecar file next to the PBF file (see write() and
+         * read()). The Reader uses it if the name of the index file is set
+         * in the `pbf_blob_index` option of the input file. Blobs that
+         * don't contain any of the object types requested are then not
+         * decoded (and, when the file is memory mapped, not even touched).
+         */
+        class PBFBlobIndex {
+
+            std::vector<pbf_blob_index_entry> m_entries;
+
+            enum {
+                index_version = 1
+            };
+
+            static const char* magic() noexcept {
+                return "OSMPBFBI";
+            }
+
+            enum {
+                magic_size = 8
+            };
+
+            struct file_header {
+                char magic[magic_size];
+                uint32_t version;
+                uint32_t entry_size;
+                uint64_t count;
+            };
+
+            static void read_exactly(const int fd, char* data, std::size_t size) {
+                while (size > 0) {
+                    const auto nread = osmium::io::detail::reliable_read(fd, data, static_cast<unsigned int>(size > 1024U * 1024U ? 1024U * 1024U : size));
+                    if (nread == 0) {
+                        throw osmium::pbf_error{"PBF blob index file truncated"};
+                    }
+                    data += nread;
+                    size -= static_cast<std::size_t>(nread);
+                }
+            }
+
+        public:
+
+            using const_iterator = std::vector<pbf_blob_index_entry>::const_iterator;
+
+            PBFBlobIndex() = default;
+
+            explicit PBFBlobIndex(std::vector<pbf_blob_index_entry>&& entries) :
+                m_entries(std::move(entries)) {
+            }
+
+            /**
+             * Build the index from PBF data available in memory. The data
+             * Blobs are decoded in parallel using the thread pool.
+             *
+             * @param data Pointer to the start of the PBF data.
+             * @param size Size of the PBF data in bytes.
+             * @param pool Thread pool to use.
+             * @throws osmium::pbf_error If the data is not valid PBF.
+             */
+            static PBFBlobIndex build(const char* data, const std::size_t size, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                const auto blobs = osmium::io::detail::find_pbf_blobs(data, size);
+
+                std::vector<std::future<osmium::io::detail::pbf_blob_summary>> futures;
+                futures.reserve(blobs.size() - 1);
+                for (auto it = std::next(blobs.begin()); it != blobs.end(); ++it) {
+                    const osmium::io::detail::data_view blob{data + it->offset, it->size};
+                    futures.push_back(pool.submit([blob]() {
+                        return osmium::io::detail::decode_blob_summary(blob);
+                    }));
+                }
+
+                std::vector<pbf_blob_index_entry> entries;
+                entries.reserve(futures.size());
+                auto bit = std::next(blobs.begin());
+                for (auto& future : futures) {
+                    const auto summary = future.get();
+                    pbf_blob_index_entry entry;
+                    entry.offset = bit->offset;
+                    entry.size = static_cast<uint32_t>(bit->size);
+                    entry.types = summary.types;
+                    if (summary.types != osmium::osm_entity_bits::nothing) {
+                        entry.min_id = summary.min_id;
+                        entry.max_id = summary.max_id;
+                    }
+                    entries.push_back(entry);
+                    ++bit;
+                }
+
+                return PBFBlobIndex{std::move(entries)};
+            }
+
+            /**
+             * Build the index from the uncompressed PBF file with the
+             * given name. The file is memory mapped for this.
+             *
+             * @param filename Name of the PBF file.
+             * @param pool Thread pool to use.
+             * @throws osmium::pbf_error If the data is not valid PBF.
+             * @throws std::system_error If the file can't be opened or mapped.
+             */
+            static PBFBlobIndex build(const std::string& filename, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                const int fd = osmium::io::detail::open_for_reading(filename);
+                try {
+                    const std::size_t size = osmium::file_size(fd);
+                    if (size == 0) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    const osmium::util::MemoryMapping mapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+                    auto index = build(mapping.get_addr<const char>(), size, pool);
+                    osmium::io::detail::reliable_close(fd);
+                    return index;
+                } catch (...) {
+                    osmium::io::detail::reliable_close(fd);
+                    throw;
+                }
+            }
+
+            /**
+             * Write index to the given file descriptor.
+             *
+             * @throws std::system_error If writing fails.
+             */
+            void write(const int fd) const {
+                file_header header{};
+                std::memcpy(header.magic, magic(), magic_size);
+                header.version = index_version;
+                header.entry_size = sizeof(pbf_blob_index_entry);
+                header.count = m_entries.size();
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_entries.data()), sizeof(pbf_blob_index_entry) * m_entries.size());
+            }
+
+            /**
+             * Write index to the file with the given name. An existing
+             * file will be overwritten.
+             *
+             * @throws std::system_error If writing fails.
+             */
+            void write(const std::string& filename) const {
+                const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+                try {
+                    write(fd);
+                } catch (...) {
+                    osmium::io::detail::reliable_close(fd);
+                    throw;
+                }
+                osmium::io::detail::reliable_close(fd);
+            }
+
+            /**
+             * Read index from the given file descriptor.
+             *
+             * @throws osmium::pbf_error If the data is not a valid index.
+             * @throws std::system_error If reading fails.
+             */
+            static PBFBlobIndex read(const int fd) {
+                file_header header{};
+                read_exactly(fd, reinterpret_cast<char*>(&header), sizeof(header));
+                if (std::memcmp(header.magic, magic(), magic_size) != 0 ||
+                    header.version != index_version ||
+                    header.entry_size != sizeof(pbf_blob_index_entry)) {
+                    throw osmium::pbf_error{"not a PBF blob index file or wrong version"};
+                }
+
+                std::vector<pbf_blob_index_entry> entries(static_cast<std::size_t>(header.count));
+                read_exactly(fd, reinterpret_cast<char*>(entries.data()), sizeof(pbf_blob_index_entry) * entries.size());
+
+                return PBFBlobIndex{std::move(entries)};
+            }
+
+            /**
+             * Read index from the file with the given name.
+             *
+             * @throws osmium::pbf_error If the data is not a valid index.
+             * @throws std::system_error If reading fails.
+             */
+            static PBFBlobIndex read(const std::string& filename) {
+                const int fd = osmium::io::detail::open_for_reading(filename);
+                try {
+                    auto index = read(fd);
+                    osmium::io::detail::reliable_close(fd);
+                    return index;
+                } catch (...) {
+                    osmium::io::detail::reliable_close(fd);
+                    throw;
+                }
+            }
+
+            bool empty() const noexcept {
+                return m_entries.empty();
+            }
+
+            /// The number of data Blobs in the index.
+            std::size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            const pbf_blob_index_entry& operator[](const std::size_t n) const noexcept {
+                return m_entries[n];
+            }
+
+            const_iterator begin() const noexcept {
+                return m_entries.cbegin();
+            }
+
+            const_iterator end() const noexcept {
+                return m_entries.cend();
+            }
+
+            /**
+             * Find the first Blob containing objects of any of the given
+             * types.
+             *
+             * @returns Iterator to the entry or end() if there is none.
+             */
+            const_iterator find_first(const osmium::osm_entity_bits::type types) const noexcept {
+                return std::find_if(begin(), end(), [types](const pbf_blob_index_entry& entry) {
+                    return (entry.entity_bits() & types) != 0;
+                });
+            }
+
+            /**
+             * Get all Blobs possibly containing objects of the given type
+             * with ids in the range [first_id, last_id].
+             */
+            std::vector<pbf_blob_index_entry> find(const osmium::item_type type, const osmium::object_id_type first_id, const osmium::object_id_type last_id) const {
+                std::vector<pbf_blob_index_entry> result;
+                for (const auto& entry : m_entries) {
+                    if (entry.overlaps(type, first_id, last_id)) {
+                        result.push_back(entry);
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * Split the PBF file into ranges of at least range_size bytes
+             * (except the last one) which only end at Blob boundaries. The
+             * first range contains the OSMHeader Blob.
+             *
+             * @param file_size The size of the PBF file.
+             * @param range_size Minimum size of each range.
+             */
+            std::vector<osmium::io::byte_range> aligned_ranges(const std::size_t file_size, const std::size_t range_size) const {
+                std::vector<osmium::io::byte_range> ranges;
+                std::size_t start = 0;
+                for (const auto& entry : m_entries) {
+                    const auto end = static_cast<std::size_t>(entry.offset) + entry.size;
+                    if (end - start >= range_size) {
+                        ranges.push_back(osmium::io::byte_range{start, end - start});
+                        start = end;
+                    }
+                }
+                if (start < file_size) {
+                    ranges.push_back(osmium::io::byte_range{start, file_size - start});
+                }
+                return ranges;
+            }
+
+        }; // class PBFBlobIndex
+
+        /**
+         * RangeSource wrapping another RangeSource for a PBF file so that
+         * all ranges read end at Blob boundaries according to the blob
+         * index. Every range handed to the parser then contains only
+         * complete Blobs.
+         */
+        class BlobAlignedRangeSource final : public RangeSource {
+
+            RangeSource& m_source;
+            const PBFBlobIndex& m_index;
+
+        public:
+
+            /**
+             * @param source The source to read from.
+             * @param index The blob index of the PBF file.
+             *
+             * Both must outlive this object.
+             */
+            BlobAlignedRangeSource(RangeSource& source, const PBFBlobIndex& index) noexcept :
+                m_source(source),
+                m_index(index) {
+            }
+
+            std::size_t size() override {
+                return m_source.size();
+            }
+
+            std::string read(const byte_range& range) override {
+                return m_source.read(range);
+            }
+
+            std::vector<byte_range> ranges(const std::size_t range_size) override {
+                return m_index.aligned_ranges(size(), range_size);
+            }
+
+        }; // class BlobAlignedRangeSource
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_BLOB_INDEX_HPP
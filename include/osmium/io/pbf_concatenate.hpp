@@ -0,0 +1,164 @@
+#ifndef OSMIUM_IO_PBF_CONCATENATE_HPP
+#define OSMIUM_IO_PBF_CONCATENATE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to concatenate PBF files.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_output_format.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Append all data Blobs (with their BlobHeaders) from the PBF
+             * file with the given name to the file descriptor fd. The
+             * OSMHeader Blob is skipped.
+             *
+             * @returns The number of bytes written.
+             */
+            inline std::size_t append_pbf_data_blobs(const int fd, const std::string& filename) {
+                const int input_fd = open_for_reading(filename);
+                try {
+                    const std::size_t size = osmium::file_size(input_fd);
+                    if (size == 0) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    const osmium::util::MemoryMapping mapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, input_fd};
+                    const char* data = mapping.get_addr<const char>();
+
+                    // The data Blobs follow the OSMHeader Blob without
+                    // gaps, so they can be copied in one go.
+                    const auto blobs = find_pbf_blobs(data, size);
+                    const std::size_t start = blobs.front().offset + blobs.front().size;
+                    reliable_write(fd, data + start, size - start);
+
+                    reliable_close(input_fd);
+                    return size - start;
+                } catch (...) {
+                    reliable_close(input_fd);
+                    throw;
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Concatenate several PBF files into one valid PBF file. Only the
+         * header is written anew, the data Blobs are copied from the
+         * input files as they are without decoding them. This is much
+         * faster than reading and writing the data and is used to combine
+         * the parts written by a ShardedWriter.
+         *
+         * The data in the output file is in the order of the input files,
+         * so it is usually not sorted even if all inputs were. Don't set
+         * the "sorting" option in the header in that case. All input files
+         * must have been written with the same options (for instance
+         * "locations_on_ways") as set on the output file, because these
+         * are announced in the header. The input files must not be
+         * compressed (with gzip or so), compression inside the PBF Blobs
+         * is fine.
+         *
+         * @param inputs Names of the PBF files to concatenate.
+         * @param output File to write to, format must be PBF.
+         * @param header Header for the output file.
+         * @param allow_overwrite Allow overwriting of existing file?
+         * @returns Number of bytes written to the output file.
+         * @throws std::invalid_argument If there are no inputs or the
+         *         output is not an uncompressed PBF file.
+         * @throws osmium::pbf_error If any of the inputs is not valid PBF.
+         * @throws std::system_error If reading or writing a file fails.
+         */
+        inline std::size_t concatenate_pbf_files(const std::vector<std::string>& inputs,
+                                                 const osmium::io::File& output,
+                                                 const osmium::io::Header& header,
+                                                 const osmium::io::overwrite allow_overwrite = osmium::io::overwrite::no) {
+            if (inputs.empty()) {
+                throw std::invalid_argument{"Need at least one PBF file to concatenate"};
+            }
+            if (output.format() != osmium::io::file_format::pbf ||
+                output.compression() != osmium::io::file_compression::none ||
+                output.filename().empty()) {
+                throw std::invalid_argument{"Output of PBF concatenation must be an uncompressed PBF file"};
+            }
+
+            const auto options = detail::get_pbf_output_options(output);
+            const std::string header_blob = detail::SerializeBlob{detail::serialize_header_block(header, options),
+                                                                  detail::pbf_blob_type::header,
+                                                                  options.use_compression,
+                                                                  options.compression_level}();
+
+            const int fd = detail::open_for_writing(output.filename(), allow_overwrite);
+            try {
+                detail::reliable_write(fd, header_blob.data(), header_blob.size());
+                std::size_t bytes = header_blob.size();
+                for (const auto& filename : inputs) {
+                    bytes += detail::append_pbf_data_blobs(fd, filename);
+                }
+                detail::reliable_close(fd);
+                return bytes;
+            } catch (...) {
+                detail::reliable_close(fd);
+                throw;
+            }
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_CONCATENATE_HPP
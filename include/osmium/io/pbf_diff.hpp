@@ -0,0 +1,348 @@
+#ifndef OSMIUM_IO_PBF_DIFF_HPP
+#define OSMIUM_IO_PBF_DIFF_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to create the changes between two PBF
+ * files.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/diff_generator.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Statistics about a diff between two PBF files created with
+         * diff_pbf_files().
+         */
+        struct pbf_diff_stats : public diff_stats {
+
+            /// Data Blobs found in both files which were skipped.
+            std::size_t skipped_blobs = 0;
+
+            /// Data Blobs (from both files) which had to be decoded.
+            std::size_t decoded_blobs = 0;
+
+        }; // struct pbf_diff_stats
+
+        namespace detail {
+
+            // Hash of the size and the first and last bytes of a Blob. It
+            // is only used to find candidates for identical Blobs, they
+            // are always compared completely.
+            inline uint64_t pbf_blob_fingerprint(const char* data, const std::size_t size) noexcept {
+                constexpr const std::size_t edge = 64;
+                uint64_t hash = 14695981039346656037ULL ^ size;
+                const auto add = [&hash](const char* begin, const char* end) {
+                    for (; begin != end; ++begin) {
+                        hash = (hash ^ static_cast<unsigned char>(*begin)) * 1099511628211ULL;
+                    }
+                };
+                if (size <= 2 * edge) {
+                    add(data, data + size);
+                } else {
+                    add(data, data + edge);
+                    add(data + size - edge, data + size);
+                }
+                return hash;
+            }
+
+            /**
+             * Remove all data Blobs which are in both lists and have
+             * exactly the same contents. Each Blob is matched at most once.
+             * The OSMHeader Blobs (first in the lists) are removed, too.
+             *
+             * @returns The number of Blob pairs removed.
+             */
+            inline std::size_t remove_identical_pbf_blobs(const char* old_data, std::vector<pbf_blob_position>& old_blobs,
+                                                          const char* new_data, std::vector<pbf_blob_position>& new_blobs) {
+                std::unordered_map<uint64_t, std::vector<std::size_t>> candidates;
+                for (std::size_t i = 1; i < old_blobs.size(); ++i) {
+                    candidates[pbf_blob_fingerprint(old_data + old_blobs[i].offset, old_blobs[i].size)].push_back(i);
+                }
+
+                std::vector<bool> old_matched(old_blobs.size(), false);
+                std::vector<pbf_blob_position> new_unmatched;
+                std::size_t matched = 0;
+
+                for (std::size_t i = 1; i < new_blobs.size(); ++i) {
+                    const char* blob = new_data + new_blobs[i].offset;
+                    const std::size_t size = new_blobs[i].size;
+                    bool found = false;
+                    const auto it = candidates.find(pbf_blob_fingerprint(blob, size));
+                    if (it != candidates.end()) {
+                        for (const auto n : it->second) {
+                            if (!old_matched[n] && old_blobs[n].size == size &&
+                                !std::memcmp(old_data + old_blobs[n].offset, blob, size)) {
+                                old_matched[n] = true;
+                                found = true;
+                                ++matched;
+                                break;
+                            }
+                        }
+                    }
+                    if (!found) {
+                        new_unmatched.push_back(new_blobs[i]);
+                    }
+                }
+
+                std::vector<pbf_blob_position> old_unmatched;
+                for (std::size_t i = 1; i < old_blobs.size(); ++i) {
+                    if (!old_matched[i]) {
+                        old_unmatched.push_back(old_blobs[i]);
+                    }
+                }
+
+                old_blobs = std::move(old_unmatched);
+                new_blobs = std::move(new_unmatched);
+                return matched;
+            }
+
+            /**
+             * Source of buffers for the DiffGenerator decoding the given
+             * data Blobs in order on the thread pool. Only a limited number
+             * of Blobs is decoded ahead of the one currently needed.
+             */
+            class pbf_blobs_source {
+
+                const char* m_data;
+                const std::vector<pbf_blob_position>& m_blobs;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::thread::Pool& m_pool;
+                std::size_t m_max_pending;
+                std::size_t m_next = 0;
+                std::deque<std::future<osmium::memory::Buffer>> m_futures;
+                osmium::memory::Buffer m_back_buffers{};
+
+                void submit() {
+                    while (m_next < m_blobs.size() && m_futures.size() < m_max_pending) {
+                        const auto& blob = m_blobs[m_next++];
+                        m_futures.push_back(m_pool.submit(PBFDataBlobDecoder{pbf_blob_data{nullptr, data_view{m_data + blob.offset, blob.size}},
+                                                                             m_read_types,
+                                                                             osmium::io::read_meta::yes}));
+                    }
+                }
+
+            public:
+
+                pbf_blobs_source(const char* data, const std::vector<pbf_blob_position>& blobs, const osmium::osm_entity_bits::type read_types, osmium::thread::Pool& pool) :
+                    m_data(data),
+                    m_blobs(blobs),
+                    m_read_types(read_types),
+                    m_pool(pool),
+                    m_max_pending(static_cast<std::size_t>(pool.num_threads()) * 2) {
+                }
+
+                pbf_blobs_source(const pbf_blobs_source&) = delete;
+                pbf_blobs_source& operator=(const pbf_blobs_source&) = delete;
+
+                pbf_blobs_source(pbf_blobs_source&&) = delete;
+                pbf_blobs_source& operator=(pbf_blobs_source&&) = delete;
+
+                // The decoders access the memory mapped data, so wait
+                // for them before the mapping goes away.
+                ~pbf_blobs_source() noexcept {
+                    for (auto& future : m_futures) {
+                        future.wait();
+                    }
+                }
+
+                /// Get the next buffer or an invalid buffer at the end.
+                osmium::memory::Buffer read() {
+                    while (true) {
+                        osmium::memory::Buffer buffer;
+                        if (m_back_buffers) {
+                            if (m_back_buffers.has_nested_buffers()) {
+                                buffer = std::move(*m_back_buffers.get_last_nested());
+                            } else {
+                                buffer = std::move(m_back_buffers);
+                                m_back_buffers = osmium::memory::Buffer{};
+                            }
+                        } else {
+                            submit();
+                            if (m_futures.empty()) {
+                                return osmium::memory::Buffer{};
+                            }
+                            buffer = m_futures.front().get();
+                            m_futures.pop_front();
+                            if (buffer.has_nested_buffers()) {
+                                m_back_buffers = std::move(buffer);
+                                buffer = std::move(*m_back_buffers.get_last_nested());
+                            }
+                        }
+                        if (buffer && buffer.committed() > 0) {
+                            return buffer;
+                        }
+                    }
+                }
+
+            }; // class pbf_blobs_source
+
+            /**
+             * Create the diff between two PBF files available in memory.
+             * See diff_pbf_files() for details.
+             */
+            template <typename TOutput>
+            pbf_diff_stats diff_pbf_data(const char* old_data, const std::size_t old_size,
+                                         const char* new_data, const std::size_t new_size,
+                                         TOutput&& output,
+                                         DiffGenerator& generator,
+                                         osmium::thread::Pool& pool) {
+                auto old_blobs = find_pbf_blobs(old_data, old_size);
+                auto new_blobs = find_pbf_blobs(new_data, new_size);
+
+                pbf_diff_stats stats;
+                stats.skipped_blobs = remove_identical_pbf_blobs(old_data, old_blobs, new_data, new_blobs);
+                stats.decoded_blobs = old_blobs.size() + new_blobs.size();
+
+                {
+                    pbf_blobs_source old_source{old_data, old_blobs, osmium::osm_entity_bits::object, pool};
+                    pbf_blobs_source new_source{new_data, new_blobs, osmium::osm_entity_bits::object, pool};
+                    generator.diff(old_source, new_source, std::forward<TOutput>(output));
+                }
+
+                static_cast<diff_stats&>(stats) = generator.stats();
+                return stats;
+            }
+
+            /**
+             * Memory map the PBF file with the given name and call func
+             * with a pointer to the data and its size.
+             */
+            template <typename TFunction>
+            pbf_diff_stats with_mapped_pbf_file(const std::string& filename, TFunction&& func) {
+                const int fd = open_for_reading(filename);
+                try {
+                    const std::size_t size = osmium::file_size(fd);
+                    if (size == 0) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    pbf_diff_stats stats;
+                    {
+                        const osmium::util::MemoryMapping mapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+                        stats = std::forward<TFunction>(func)(mapping.get_addr<const char>(), size);
+                    }
+                    reliable_close(fd);
+                    return stats;
+                } catch (...) {
+                    reliable_close(fd);
+                    throw;
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Create the changes between two sorted PBF files, for instance
+         * two planet files, and send them to the output (usually an
+         * osmium::io::Writer for an .osc file). See DiffGenerator for the
+         * details of the merge-join and the output.
+         *
+         * Data Blobs with exactly the same bytes in both files contain the
+         * same objects, they are skipped without decoding them. This makes
+         * the diff much faster if the files were written by the same
+         * program with the same settings and most Blobs didn't change.
+         * All other Blobs are decoded in parallel on the thread pool.
+         *
+         * The files must not be compressed (with gzip or so), compression
+         * inside the PBF Blobs is fine. They must be sorted and contain
+         * no history data.
+         *
+         * @param old_filename Name of the old PBF file.
+         * @param new_filename Name of the new PBF file.
+         * @param output Called with each created, modified, or deleted
+         *               object as a const OSMObject&.
+         * @param generator The DiffGenerator to use. Use this to set
+         *                  options like DiffGenerator::compare_contents().
+         * @param pool Thread pool to use.
+         * @returns Statistics.
+         * @throws osmium::pbf_error If any of the files is not valid PBF.
+         * @throws std::system_error If a file can't be opened or mapped.
+         */
+        template <typename TOutput>
+        pbf_diff_stats diff_pbf_files(const std::string& old_filename,
+                                      const std::string& new_filename,
+                                      TOutput&& output,
+                                      DiffGenerator& generator,
+                                      osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            return detail::with_mapped_pbf_file(old_filename, [&](const char* old_data, const std::size_t old_size) {
+                return detail::with_mapped_pbf_file(new_filename, [&](const char* new_data, const std::size_t new_size) {
+                    return detail::diff_pbf_data(old_data, old_size, new_data, new_size, output, generator, pool);
+                });
+            });
+        }
+
+        /**
+         * Create the changes between two sorted PBF files with the default
+         * settings of the DiffGenerator. See above.
+         */
+        template <typename TOutput>
+        pbf_diff_stats diff_pbf_files(const std::string& old_filename,
+                                      const std::string& new_filename,
+                                      TOutput&& output,
+                                      osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            DiffGenerator generator;
+            return diff_pbf_files(old_filename, new_filename, std::forward<TOutput>(output), generator, pool);
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_DIFF_HPP
@@ -0,0 +1,154 @@
+#ifndef OSMIUM_IO_PBF_SPLIT_HPP
+#define OSMIUM_IO_PBF_SPLIT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to split PBF files into parts which can
+ * be read independently, for instance on different machines.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/range_source.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Split PBF data into n ranges of about the same size. The
+             * ranges start at the beginning of a Blob (with its
+             * BlobHeader) and together cover all the data.
+             *
+             * @throws osmium::pbf_error If the data is not valid PBF.
+             */
+            inline std::vector<byte_range> split_pbf_data(const char* data, const std::size_t size, const std::size_t n) {
+                const auto blobs = find_pbf_blobs(data, size);
+
+                // Offsets of the starts of the data Blobs
+                std::vector<std::size_t> starts;
+                starts.reserve(blobs.size());
+                for (const auto& blob : blobs) {
+                    starts.push_back(blob.offset + blob.size);
+                }
+                starts.pop_back();
+
+                const std::size_t data_begin = starts.empty() ? size : starts.front();
+                const std::size_t data_size = size - data_begin;
+
+                std::vector<byte_range> ranges;
+                ranges.reserve(n);
+                std::size_t begin = 0;
+                for (std::size_t i = 1; i < n; ++i) {
+                    const std::size_t target = data_begin + data_size / n * i + data_size % n * i / n;
+                    const auto it = std::lower_bound(starts.begin(), starts.end(), target);
+                    const std::size_t end = std::max(begin, it == starts.end() ? size : *it);
+                    ranges.push_back(byte_range{begin, end - begin});
+                    begin = end;
+                }
+                ranges.push_back(byte_range{begin, size - begin});
+
+                return ranges;
+            }
+
+        } // namespace detail
+
+        /**
+         * Split an uncompressed PBF file into n parts of about the same
+         * size which can be read independently, for instance on different
+         * machines. Only the framing of the Blobs is checked, they are not
+         * decoded. Give each of the ranges to one Reader with
+         * set_pbf_byte_range(). Parts can be empty if there are not
+         * enough Blobs in the file.
+         *
+         * @param filename Name of the PBF file.
+         * @param n Number of parts.
+         * @returns Vector with n byte ranges covering the whole file.
+         * @throws std::invalid_argument If n is 0.
+         * @throws osmium::pbf_error If the file is not valid PBF.
+         * @throws std::system_error If the file can't be opened or read.
+         */
+        inline std::vector<byte_range> split_pbf_file(const std::string& filename, const std::size_t n) {
+            if (n == 0) {
+                throw std::invalid_argument{"Can not split PBF file into 0 parts"};
+            }
+
+            const int fd = detail::open_for_reading(filename);
+            try {
+                const std::size_t size = osmium::file_size(fd);
+                if (size == 0) {
+                    throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                }
+                const osmium::util::MemoryMapping mapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+                auto ranges = detail::split_pbf_data(mapping.get_addr<const char>(), size, n);
+                detail::reliable_close(fd);
+                return ranges;
+            } catch (...) {
+                detail::reliable_close(fd);
+                throw;
+            }
+        }
+
+        /**
+         * Restrict reading of a PBF file to the data Blobs starting in the
+         * given byte range by setting the "pbf_byte_range" option on the
+         * file. The OSMHeader is always read. Use this with the ranges
+         * returned by split_pbf_file().
+         */
+        inline void set_pbf_byte_range(osmium::io::File& file, const byte_range& range) {
+            file.set("pbf_byte_range", std::to_string(range.offset) + '-' + std::to_string(range.offset + range.size));
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_SPLIT_HPP
@@ -0,0 +1,157 @@
+#ifndef OSMIUM_IO_PBF_TRUNCATE_HPP
+#define OSMIUM_IO_PBF_TRUNCATE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to truncate partially written PBF files.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <protozero/pbf_message.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Find the end of the last complete Blob (with its BlobHeader)
+             * in the PBF data. The data can end anywhere in a Blob, for
+             * instance because it was written by a program that crashed.
+             *
+             * @returns The size of the complete Blobs at the start of the
+             *          data. 0 if not even the OSMHeader Blob is complete.
+             * @throws osmium::pbf_error If the data is not valid PBF.
+             */
+            inline std::size_t complete_pbf_blobs_size(const char* data, const std::size_t size) {
+                std::size_t offset = 0;
+
+                while (size - offset >= sizeof(uint32_t)) {
+                    const uint32_t header_size = decode_blob_header_size(data + offset);
+                    if (header_size > static_cast<uint32_t>(max_blob_header_size)) {
+                        throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                    }
+                    const std::size_t header_offset = offset + sizeof(uint32_t);
+                    if (size - header_offset < header_size) {
+                        break;
+                    }
+
+                    const auto blob_size = decode_blob_header(
+                        protozero::pbf_message<FileFormat::BlobHeader>{data_view{data + header_offset, header_size}},
+                        offset == 0 ? "OSMHeader" : "OSMData");
+                    if (blob_size > max_uncompressed_blob_size) {
+                        throw osmium::pbf_error{std::string{"invalid blob size: "} +
+                                                std::to_string(blob_size)};
+                    }
+                    if (size - header_offset - header_size < blob_size) {
+                        break;
+                    }
+
+                    offset = header_offset + header_size + blob_size;
+                }
+
+                return offset;
+            }
+
+        } // namespace detail
+
+        /**
+         * Truncate a partially written PBF file after the last complete
+         * Blob. Use this before appending to a PBF file written by a
+         * program that was killed (see osmium::io::append and
+         * Reader::checkpoint()). Only the framing of the Blobs is checked,
+         * they are not decoded.
+         *
+         * The file must not be compressed (with gzip or so), compression
+         * inside the PBF Blobs is fine.
+         *
+         * @param filename Name of the PBF file.
+         * @returns The new size of the file. 0 if not even the OSMHeader
+         *          Blob was complete.
+         * @throws osmium::pbf_error If the file is not valid PBF.
+         * @throws std::system_error If the file can't be opened, read, or
+         *         truncated.
+         */
+        inline std::size_t truncate_pbf_file(const std::string& filename) {
+            std::size_t size = 0;
+            std::size_t new_size = 0;
+
+            const int input_fd = detail::open_for_reading(filename);
+            try {
+                size = osmium::file_size(input_fd);
+                if (size > 0) {
+                    const osmium::util::MemoryMapping mapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, input_fd};
+                    new_size = detail::complete_pbf_blobs_size(mapping.get_addr<const char>(), size);
+                }
+                detail::reliable_close(input_fd);
+            } catch (...) {
+                detail::reliable_close(input_fd);
+                throw;
+            }
+
+            if (new_size < size) {
+                const int fd = detail::open_for_appending(filename);
+                try {
+                    osmium::resize_file(fd, new_size);
+                    detail::reliable_close(fd);
+                } catch (...) {
+                    detail::reliable_close(fd);
+                    throw;
+                }
+            }
+
+            return new_size;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_TRUNCATE_HPP
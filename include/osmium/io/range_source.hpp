@@ -0,0 +1,350 @@
+#ifndef OSMIUM_IO_RANGE_SOURCE_HPP
+#define OSMIUM_IO_RANGE_SOURCE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/wait.h>
+#endif
+
+#ifndef _MSC_VER
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * A range of bytes in some input.
+         */
+        struct byte_range {
+            std::size_t offset;
+            std::size_t size;
+        }; // struct byte_range
+
+        /**
+         * Interface for inputs which allow reading arbitrary byte ranges,
+         * such as files on local disk or objects in (S3-compatible)
+         * object storage accessed through HTTP range requests. Give an
+         * object of a class derived from this to the Reader to read the
+         * input through several range requests in parallel instead of one
+         * sequential stream.
+         */
+        class RangeSource {
+
+        public:
+
+            RangeSource() = default;
+
+            RangeSource(const RangeSource&) = delete;
+            RangeSource& operator=(const RangeSource&) = delete;
+
+            RangeSource(RangeSource&&) = delete;
+            RangeSource& operator=(RangeSource&&) = delete;
+
+            virtual ~RangeSource() noexcept = default;
+
+            /**
+             * The size of the input in bytes.
+             */
+            virtual std::size_t size() = 0;
+
+            /**
+             * Read the given range from the input. This is called from
+             * several threads at the same time, so it must be thread-safe.
+             *
+             * @returns The data, always exactly range.size bytes.
+             * @throws Some form of std::exception if the data can't be
+             *         read.
+             */
+            virtual std::string read(const byte_range& range) = 0;
+
+            /**
+             * Split the input into the ranges to be read. The ranges must
+             * cover the whole input in order without gaps. The default
+             * implementation returns ranges of range_size bytes (the last
+             * one can be smaller). Derived classes can split differently,
+             * for instance at PBF blob boundaries.
+             */
+            virtual std::vector<byte_range> ranges(const std::size_t range_size) {
+                const std::size_t input_size = size();
+                std::vector<byte_range> result;
+                result.reserve(input_size / range_size + 1);
+                for (std::size_t offset = 0; offset < input_size; offset += range_size) {
+                    result.push_back(byte_range{offset, std::min(range_size, input_size - offset)});
+                }
+                return result;
+            }
+
+        }; // class RangeSource
+
+        /**
+         * RangeSource reading from a local file with pread(2). This is
+         * mostly useful for files on network filesystems where several
+         * requests in flight help a lot.
+         */
+        class FileRangeSource final : public RangeSource {
+
+            int m_fd;
+
+        public:
+
+            /**
+             * Open the file.
+             *
+             * @throws std::system_error If the file can't be opened.
+             */
+            explicit FileRangeSource(const std::string& filename) :
+                m_fd(osmium::io::detail::open_for_reading(filename)) {
+            }
+
+            ~FileRangeSource() noexcept override {
+                try {
+                    osmium::io::detail::reliable_close(m_fd);
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            std::size_t size() override {
+                return osmium::file_size(m_fd);
+            }
+
+            std::string read(const byte_range& range) override {
+                std::string data(range.size, '\0');
+                std::size_t done = 0;
+                while (done < range.size) {
+#ifndef _WIN32
+                    const auto length = ::pread(m_fd, &data[done], range.size - done, static_cast<off_t>(range.offset + done));
+#else
+                    // There is no pread(2) on Windows.
+                    const int64_t length = -1;
+                    errno = ENOSYS;
+#endif
+                    if (length < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        throw std::system_error{errno, std::system_category(), "Read failed"};
+                    }
+                    if (length == 0) {
+                        throw io_error{"Unexpected end of file in range read"};
+                    }
+                    done += static_cast<std::size_t>(length);
+                }
+                return data;
+            }
+
+        }; // class FileRangeSource
+
+#ifndef _WIN32
+
+        /**
+         * RangeSource reading from a HTTP(S) URL using HTTP range requests.
+         * Every request runs the "curl" program (which must be installed)
+         * like the Reader does for URLs.
+         */
+        class CurlRangeSource final : public RangeSource {
+
+            std::string m_url;
+            std::string m_command;
+            std::size_t m_size = 0;
+            bool m_size_known = false;
+
+            // Run the command with the arguments and return everything
+            // it writes to stdout.
+            static std::string run(const std::vector<std::string>& args) {
+                // Set up everything before the fork, the child must only
+                // call async-signal-safe functions.
+                std::vector<char*> argv;
+                argv.reserve(args.size() + 1);
+                for (const auto& arg : args) {
+                    argv.push_back(const_cast<char*>(arg.c_str()));
+                }
+                argv.push_back(nullptr);
+
+                int pipefd[2];
+                if (::pipe(pipefd) < 0) {
+                    throw std::system_error{errno, std::system_category(), "opening pipe failed"};
+                }
+                const pid_t pid = ::fork();
+                if (pid < 0) {
+                    ::close(pipefd[0]);
+                    ::close(pipefd[1]);
+                    throw std::system_error{errno, std::system_category(), "fork failed"};
+                }
+                if (pid == 0) { // child
+                    ::close(pipefd[0]);
+                    if (::dup2(pipefd[1], 1) < 0) {
+                        ::_exit(1);
+                    }
+                    const int null_fd = ::open("/dev/null", O_RDWR); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+                    if (null_fd >= 0) {
+                        ::dup2(null_fd, 0);
+                        ::dup2(null_fd, 2);
+                    }
+                    ::execvp(argv[0], argv.data());
+                    ::_exit(1);
+                }
+
+                // parent
+                ::close(pipefd[1]);
+                std::string output;
+                char buffer[64 * 1024];
+                while (true) {
+                    const auto length = ::read(pipefd[0], buffer, sizeof(buffer));
+                    if (length < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        const int error = errno;
+                        ::close(pipefd[0]);
+                        ::waitpid(pid, nullptr, 0);
+                        throw std::system_error{error, std::system_category(), "Read failed"};
+                    }
+                    if (length == 0) {
+                        break;
+                    }
+                    output.append(buffer, static_cast<std::size_t>(length));
+                }
+                ::close(pipefd[0]);
+
+                int status = 0;
+                while (::waitpid(pid, &status, 0) < 0) {
+                    if (errno != EINTR) {
+                        throw std::system_error{errno, std::system_category(), "waitpid failed"};
+                    }
+                }
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) { // NOLINT(hicpp-signed-bitwise)
+                    throw io_error{"Running '" + args.front() + "' failed"};
+                }
+
+                return output;
+            }
+
+            // Find the last Content-Length header (there can be several
+            // if there were redirects).
+            static std::size_t parse_content_length(const std::string& headers) {
+                static const char name[] = "content-length:";
+                std::size_t result = 0;
+                bool found = false;
+
+                std::size_t pos = 0;
+                while (pos < headers.size()) {
+                    auto end = headers.find('\n', pos);
+                    if (end == std::string::npos) {
+                        end = headers.size();
+                    }
+                    const std::string line = headers.substr(pos, end - pos);
+                    if (line.size() > sizeof(name) - 1 &&
+                        std::equal(name, name + sizeof(name) - 1, line.begin(), [](char a, char b) {
+                            return a == std::tolower(static_cast<unsigned char>(b));
+                        })) {
+                        result = static_cast<std::size_t>(std::strtoull(line.c_str() + sizeof(name) - 1, nullptr, 10));
+                        found = true;
+                    }
+                    pos = end + 1;
+                }
+
+                if (!found) {
+                    throw io_error{"No Content-Length in HTTP response"};
+                }
+                return result;
+            }
+
+        public:
+
+            /**
+             * @param url The URL (http or https).
+             * @param command The curl program to run.
+             */
+            explicit CurlRangeSource(std::string url, std::string command = "curl") :
+                m_url(std::move(url)),
+                m_command(std::move(command)) {
+            }
+
+            const std::string& url() const noexcept {
+                return m_url;
+            }
+
+            /**
+             * Get the size of the object with a HEAD request. This is only
+             * done once.
+             */
+            std::size_t size() override {
+                if (!m_size_known) {
+                    m_size = parse_content_length(run({m_command, "-s", "-f", "-g", "-L", "-I", m_url}));
+                    m_size_known = true;
+                }
+                return m_size;
+            }
+
+            std::string read(const byte_range& range) override {
+                if (range.size == 0) {
+                    return std::string{};
+                }
+                const std::string bytes = std::to_string(range.offset) + "-" + std::to_string(range.offset + range.size - 1);
+                std::string data = run({m_command, "-s", "-f", "-g", "-L", "-r", bytes, m_url});
+                if (data.size() != range.size) {
+                    throw io_error{"Range request for " + m_url + " returned " + std::to_string(data.size()) +
+                                   " bytes instead of " + std::to_string(range.size)};
+                }
+                return data;
+            }
+
+        }; // class CurlRangeSource
+
+#endif
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_RANGE_SOURCE_HPP
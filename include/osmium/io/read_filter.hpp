@@ -0,0 +1,395 @@
+#ifndef OSMIUM_IO_READ_FILTER_HPP
+#define OSMIUM_IO_READ_FILTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Filter conditions a Reader hands to the parsers. Parsers that
+         * support them check objects while decoding and never hand out
+         * the objects that don't match in the buffers returned by
+         * Reader::read(). Parsers that don't support a condition simply
+         * ignore it, so the application must still be able to cope with
+         * objects not matching it.
+         *
+         * An object is kept only if it matches all conditions that apply
+         * to its type.
+         *
+         * Use it like this:
+         * @code
+         * osmium::TagsFilter tags_filter{false};
+         * tags_filter.add_rule(true, "highway");
+         *
+         * osmium::io::ReadFilter read_filter;
+         * read_filter.tags(tags_filter, osmium::osm_entity_bits::way)
+         *            .bbox(osmium::Box{5.0, 47.0, 15.0, 55.0});
+         *
+         * osmium::io::Reader reader{"input.osm.pbf", read_filter};
+         * @endcode
+         *
+         * The Reader keeps a copy of the filter, so it can be destroyed
+         * after the Reader has been created. But an IdSet given to ids()
+         * is not copied and must outlive the Reader.
+         */
+        class ReadFilter {
+
+            using id_set_type = osmium::index::IdSet<osmium::unsigned_object_id_type>;
+
+            osmium::TagsFilter m_tags_filter;
+            osmium::osm_entity_bits::type m_tags_types = osmium::osm_entity_bits::nothing;
+
+            osmium::object_id_type m_first_id = 0;
+            osmium::object_id_type m_last_id = 0;
+            osmium::osm_entity_bits::type m_id_range_types = osmium::osm_entity_bits::nothing;
+
+            const id_set_type* m_id_set = nullptr;
+            osmium::osm_entity_bits::type m_id_set_types = osmium::osm_entity_bits::nothing;
+
+            osmium::Box m_bbox;
+
+            osmium::Timestamp m_point_in_time;
+            bool m_versions = false;
+
+        public:
+
+            ReadFilter() = default;
+
+            /**
+             * Only keep objects of the specified types if at least one of
+             * their tags matches the filter. Objects of those types
+             * without any tags are never kept.
+             *
+             * @param filter The tags filter. It is copied.
+             * @param types The types of objects the filter applies to.
+             * @returns A reference to this filter for chaining.
+             */
+            ReadFilter& tags(const osmium::TagsFilter& filter,
+                             const osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nwr) {
+                m_tags_filter = filter;
+                m_tags_types = types;
+                return *this;
+            }
+
+            /**
+             * Only keep objects of the specified types with an id in the
+             * range from first_id to last_id (both inclusive).
+             *
+             * @param first_id The smallest id kept.
+             * @param last_id The largest id kept.
+             * @param types The types of objects the range applies to.
+             * @returns A reference to this filter for chaining.
+             * @throws std::invalid_argument if last_id < first_id.
+             */
+            ReadFilter& id_range(const osmium::object_id_type first_id,
+                                 const osmium::object_id_type last_id,
+                                 const osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nwr) {
+                if (last_id < first_id) {
+                    throw std::invalid_argument{"empty id range in read filter"};
+                }
+                m_first_id = first_id;
+                m_last_id = last_id;
+                m_id_range_types = types;
+                return *this;
+            }
+
+            /**
+             * Only keep objects of the specified types with an id in the
+             * set. Like with osmium::OSMObject::positive_id() the absolute
+             * value of the id is looked up.
+             *
+             * When reading PBF files, Blobs which can't contain any of
+             * the ids according to the blob index (see the
+             * "pbf_blob_index" file option) or the hints in their
+             * BlobHeader are not decoded at all. So looking up a few
+             * objects in a large file only decodes a handful of Blobs.
+             *
+             * @param id_set The set of ids. It is not copied and must
+             *               outlive the Reader.
+             * @param types The types of objects the set applies to.
+             * @returns A reference to this filter for chaining.
+             */
+            ReadFilter& ids(const id_set_type& id_set,
+                            const osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nwr) {
+                m_id_set = &id_set;
+                m_id_set_types = types;
+                return *this;
+            }
+
+            /**
+             * Only keep nodes with a location inside the bounding box
+             * (including its boundary). Nodes without a valid location
+             * are not kept. Ways and relations are not affected.
+             *
+             * @param box The bounding box.
+             * @returns A reference to this filter for chaining.
+             * @throws std::invalid_argument if the box is not valid.
+             */
+            ReadFilter& bbox(const osmium::Box& box) {
+                if (!box.valid()) {
+                    throw std::invalid_argument{"invalid bounding box in read filter"};
+                }
+                m_bbox = box;
+                return *this;
+            }
+
+            /**
+             * Only keep the latest version of each object, or, if a point
+             * in time is given, the version that was current at that
+             * time. This is for reading history files, which are ordered
+             * by type, id, and version. Objects with a timestamp after the
+             * point in time are never kept. Deleted objects are kept (as
+             * objects with the visible flag set to false), so the
+             * application can see that they are gone.
+             *
+             * Unlike the other conditions this one is always applied
+             * exactly: The Reader does the selection itself for formats
+             * that don't support it while decoding. The other conditions
+             * are applied to the versions selected, so an object is not
+             * kept at all if its selected version doesn't match them.
+             *
+             * Note that the point in time can only be taken into account
+             * if the metadata is read.
+             *
+             * @param point_in_time Keep the versions current at this time.
+             * @returns A reference to this filter for chaining.
+             */
+            ReadFilter& latest_versions(const osmium::Timestamp& point_in_time = osmium::end_of_time()) noexcept {
+                m_versions = true;
+                m_point_in_time = point_in_time;
+                return *this;
+            }
+
+            /**
+             * Are there no conditions in this filter, ie does it keep
+             * every object?
+             */
+            bool empty() const noexcept {
+                return (m_tags_types | m_id_range_types | m_id_set_types) == osmium::osm_entity_bits::nothing &&
+                       !filters_locations() && !m_versions;
+            }
+
+            /**
+             * Is there a condition besides the version selection?
+             */
+            bool has_object_conditions() const noexcept {
+                return (m_tags_types | m_id_range_types | m_id_set_types) != osmium::osm_entity_bits::nothing ||
+                       filters_locations();
+            }
+
+            /**
+             * Are only the latest versions (at the point in time) kept?
+             */
+            bool filters_versions() const noexcept {
+                return m_versions;
+            }
+
+            /**
+             * The point in time for the version selection.
+             */
+            osmium::Timestamp point_in_time() const noexcept {
+                return m_point_in_time;
+            }
+
+            /**
+             * Is the timestamp not after the point in time? Always true
+             * if versions are not filtered.
+             */
+            bool match_timestamp(const osmium::Timestamp& timestamp) const noexcept {
+                return !m_versions || timestamp <= m_point_in_time;
+            }
+
+            /**
+             * Get a copy of this filter that only contains the version
+             * selection.
+             */
+            ReadFilter versions_only() const {
+                ReadFilter filter;
+                filter.m_versions = m_versions;
+                filter.m_point_in_time = m_point_in_time;
+                return filter;
+            }
+
+            /**
+             * Is there any condition for objects of the specified type?
+             */
+            bool filters(const osmium::item_type type) const noexcept {
+                return filters_tags(type) || filters_ids(type) ||
+                       (type == osmium::item_type::node && filters_locations());
+            }
+
+            /**
+             * Does the tags filter apply to objects of the specified type?
+             */
+            bool filters_tags(const osmium::item_type type) const noexcept {
+                return (m_tags_types & osmium::osm_entity_bits::from_item_type(type)) != 0;
+            }
+
+            /**
+             * Does an id range or id set apply to objects of the
+             * specified type?
+             */
+            bool filters_ids(const osmium::item_type type) const noexcept {
+                return ((m_id_range_types | m_id_set_types) & osmium::osm_entity_bits::from_item_type(type)) != 0;
+            }
+
+            /**
+             * Is there a bounding box nodes have to be in?
+             */
+            bool filters_locations() const noexcept {
+                return m_bbox.valid();
+            }
+
+            /**
+             * Get the tags filter. It is empty if no tags filter was set.
+             */
+            const osmium::TagsFilter& tags_filter() const noexcept {
+                return m_tags_filter;
+            }
+
+            /**
+             * Does the tag with the specified key and value match the
+             * tags filter? An object is kept if any of its tags match.
+             */
+            bool match_tag(const char* key, const char* value) const noexcept {
+                return m_tags_filter(key, value);
+            }
+
+            /**
+             * Does any of the tags in the list match the tags filter?
+             */
+            bool match_tags(const osmium::TagList& tags) const noexcept {
+                for (const auto& tag : tags) {
+                    if (m_tags_filter(tag)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * Does the id of an object of the specified type match the
+             * id range and id set applying to that type?
+             */
+            bool match_id(const osmium::item_type type, const osmium::object_id_type id) const noexcept {
+                const auto bits = osmium::osm_entity_bits::from_item_type(type);
+                if ((m_id_range_types & bits) && (id < m_first_id || id > m_last_id)) {
+                    return false;
+                }
+                if (m_id_set_types & bits) {
+                    const auto positive_id = static_cast<osmium::unsigned_object_id_type>(id < 0 ? -id : id);
+                    return m_id_set->get(positive_id);
+                }
+                return true;
+            }
+
+            /**
+             * Can an object of the specified type with an id in the range
+             * from first_id to last_id (both inclusive) match the id range
+             * and id set applying to that type? This is used to skip whole
+             * blocks of data for which the smallest and largest id are
+             * known.
+             *
+             * @pre @code first_id <= last_id @endcode
+             */
+            bool match_id_range(const osmium::item_type type, const osmium::object_id_type first_id, const osmium::object_id_type last_id) const noexcept {
+                assert(first_id <= last_id);
+                const auto bits = osmium::osm_entity_bits::from_item_type(type);
+                if ((m_id_range_types & bits) && (last_id < m_first_id || first_id > m_last_id)) {
+                    return false;
+                }
+                if (m_id_set_types & bits) {
+                    // The id set contains absolute values of the ids.
+                    using id_type = osmium::unsigned_object_id_type;
+                    if (first_id >= 0) {
+                        return m_id_set->any_in_range(static_cast<id_type>(first_id), static_cast<id_type>(last_id));
+                    }
+                    if (last_id < 0) {
+                        return m_id_set->any_in_range(static_cast<id_type>(-last_id), static_cast<id_type>(-first_id));
+                    }
+                    return m_id_set->any_in_range(0, static_cast<id_type>(std::max(-first_id, last_id)));
+                }
+                return true;
+            }
+
+            /**
+             * Is the location inside the bounding box? Always true if
+             * there is no bounding box.
+             */
+            bool match_location(const osmium::Location& location) const noexcept {
+                return !filters_locations() ||
+                       (location.valid() && m_bbox.contains(location));
+            }
+
+            /**
+             * Does the object match all conditions applying to its type?
+             * This is used by parsers which can only check objects after
+             * building them.
+             */
+            bool match(const osmium::OSMObject& object) const noexcept {
+                const auto type = object.type();
+                if (filters_ids(type) && !match_id(type, object.id())) {
+                    return false;
+                }
+                if (type == osmium::item_type::node &&
+                    !match_location(static_cast<const osmium::Node&>(object).location())) {
+                    return false;
+                }
+                return !filters_tags(type) || match_tags(object.tags());
+            }
+
+        }; // class ReadFilter
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_READ_FILTER_HPP
@@ -0,0 +1,184 @@
+#ifndef OSMIUM_IO_READ_HEADER_HPP
+#define OSMIUM_IO_READ_HEADER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to read only the header of OSM files.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/osm/entity_bits.hpp>
+
+#include <protozero/pbf_message.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Decode the OSMHeader Blob at the start of PBF data.
+             *
+             * @param get_data Function called with a number of bytes n
+             *                 that returns a pointer to (at least) the
+             *                 first n bytes of the data. It must throw if
+             *                 there isn't enough data.
+             * @throws osmium::pbf_error If the data is not valid PBF.
+             */
+            template <typename TFunction>
+            inline osmium::io::Header decode_pbf_header_at_start(TFunction&& get_data) {
+                const uint32_t header_size = decode_blob_header_size(get_data(sizeof(uint32_t)));
+                if (header_size > static_cast<uint32_t>(max_blob_header_size)) {
+                    throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                }
+
+                const std::size_t header_end = sizeof(uint32_t) + header_size;
+                const std::size_t blob_size = decode_blob_header(
+                    protozero::pbf_message<FileFormat::BlobHeader>{get_data(header_end) + sizeof(uint32_t), header_size},
+                    "OSMHeader");
+                if (blob_size > max_uncompressed_blob_size) {
+                    throw osmium::pbf_error{std::string{"invalid blob size: "} +
+                                            std::to_string(blob_size)};
+                }
+
+                return decode_header(data_view{get_data(header_end + blob_size) + header_end, blob_size});
+            }
+
+            /**
+             * Read the header of an uncompressed PBF file reading only the
+             * OSMHeader Blob from the start of the file. This usually needs
+             * only one read(2) call.
+             */
+            inline osmium::io::Header read_pbf_file_header(const std::string& filename) {
+                enum : std::size_t {
+                    read_size = 64UL * 1024UL
+                };
+
+                std::string data;
+                const int fd = open_for_reading(filename);
+                try {
+                    const auto get_data = [&](const std::size_t size) {
+                        while (data.size() < size) {
+                            const std::size_t old_size = data.size();
+                            data.resize(old_size + std::max(std::size_t(read_size), size - old_size));
+                            const auto nread = reliable_read(fd, &data[old_size], static_cast<unsigned int>(data.size() - old_size));
+                            data.resize(old_size + static_cast<std::size_t>(nread));
+                            if (nread == 0) {
+                                throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                            }
+                        }
+                        return data.data();
+                    };
+                    auto header = decode_pbf_header_at_start(get_data);
+                    reliable_close(fd);
+                    return header;
+                } catch (...) {
+                    reliable_close(fd);
+                    throw;
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Read only the header of an OSM file. This is much faster than
+         * creating a Reader just to call header() on it, because for
+         * uncompressed PBF files (normal files or in-memory buffers) only
+         * the OSMHeader Blob is read and decoded without any threads and
+         * without reading ahead. For other files and formats a Reader
+         * reading no OSM entities is used. In this case the code for
+         * reading the format must be included as usual.
+         *
+         * @param file The file.
+         * @returns The header.
+         * @throws osmium::io_error If there was an error.
+         * @throws std::system_error If the file could not be opened.
+         */
+        inline osmium::io::Header read_header(const osmium::io::File& file) {
+            file.check();
+
+            if (file.format() == file_format::pbf && file.compression() == file_compression::none) {
+                if (file.buffer()) {
+                    return detail::decode_pbf_header_at_start([&](const std::size_t size) {
+                        if (file.buffer_size() < size) {
+                            throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                        }
+                        return file.buffer();
+                    });
+                }
+                if (!file.filename().empty() &&
+                    file.filename() != "-" &&
+                    file.filename().find("://") == std::string::npos) {
+                    return detail::read_pbf_file_header(file.filename());
+                }
+            }
+
+            osmium::io::Reader reader{file, osmium::osm_entity_bits::nothing};
+            auto header = reader.header();
+            reader.close();
+            return header;
+        }
+
+        /**
+         * Read only the header of an OSM file. See the other overload
+         * of this function for details.
+         */
+        inline osmium::io::Header read_header(const std::string& filename) {
+            return read_header(osmium::io::File{filename});
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_READ_HEADER_HPP
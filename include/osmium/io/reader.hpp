@@ -35,26 +35,47 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/detail/io_uring.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/range_decompressor.hpp>
 #include <osmium/io/detail/read_thread.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/detail/version_selector.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/range_source.hpp>
+#include <osmium/io/read_filter.hpp>
+#include <osmium/io/source.hpp>
+#include <osmium/memory/budget.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/queue_stats.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+#include <osmium/util/misc.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <fcntl.h>
+#include <functional>
 #include <future>
 #include <memory>
 #include <string>
 #include <system_error>
 #include <thread>
+#include <type_traits>
 #include <utility>
 
 #ifndef _WIN32
@@ -79,8 +100,114 @@ namespace osmium {
                 return osmium::config::get_max_queue_size("OSMDATA", 20);
             }
 
+            inline std::size_t get_input_queue_bytes() noexcept {
+                return osmium::config::get_max_queue_bytes("INPUT");
+            }
+
+            inline std::size_t get_osmdata_queue_bytes() noexcept {
+                return osmium::config::get_max_queue_bytes("OSMDATA");
+            }
+
+            // Is any of the types TArgs (or derived from) T?
+            template <typename T, typename... TArgs>
+            struct has_arg_of_type : std::false_type {
+            };
+
+            template <typename T, typename TFirst, typename... TArgs>
+            struct has_arg_of_type<T, TFirst, TArgs...> :
+                std::integral_constant<bool, std::is_base_of<T, typename std::decay<TFirst>::type>::value ||
+                                             has_arg_of_type<T, TArgs...>::value> {
+            };
+
         } // namespace detail
 
+        /**
+         * Option for the Reader: A function that is called every time new
+         * data might have become available for Reader::try_read(). Use
+         * this to integrate the Reader into an event loop.
+         *
+         * The function is called from the parser thread and from the
+         * threads of the thread pool, so it must be thread-safe and it
+         * should return quickly. Usually it will just wake up the event
+         * loop, for instance by posting to it. Notifications can be
+         * spurious, try_read() might still not have any data.
+         */
+        class ready_callback {
+
+            std::function<void()> m_function;
+
+        public:
+
+            explicit ready_callback(std::function<void()> function) :
+                m_function(std::move(function)) {
+            }
+
+            const std::function<void()>& get() const noexcept {
+                return m_function;
+            }
+
+        }; // class ready_callback
+
+        /**
+         * Snapshot of the statistics of a Reader. Returned by
+         * Reader::stats().
+         */
+        struct reader_stats {
+
+            /// Size of the input file (0 if not available).
+            std::size_t file_size = 0;
+
+            /// Offset into the input file (0 if not available).
+            std::size_t offset = 0;
+
+            /// Number of (uncompressed) bytes handed to the parser by the
+            /// read thread. Always 0 for memory mapped files.
+            std::size_t bytes_read = 0;
+
+            /// Number of buffers (blobs for PBF files) sent from the parser
+            /// to the Reader so far.
+            uint64_t buffers = 0;
+
+            /// Time since the Reader was created.
+            std::chrono::nanoseconds elapsed{0};
+
+            /// Stats of the queue between read thread and parser.
+            osmium::thread::queue_stats input_queue{};
+
+            /// Stats of the queue between parser and Reader.
+            osmium::thread::queue_stats osmdata_queue{};
+
+            /// The average number of buffers per second since the Reader
+            /// was created.
+            double buffers_per_second() const noexcept {
+                if (elapsed.count() <= 0) {
+                    return 0.0;
+                }
+                return static_cast<double>(buffers) * 1e9 / static_cast<double>(elapsed.count());
+            }
+
+        }; // struct reader_stats
+
+        /**
+         * Position in the input of a Reader from which reading can be
+         * resumed later. Returned by Reader::checkpoint(). Give it to the
+         * constructor of a new Reader on the same file to continue reading
+         * where the old Reader stopped, for instance after a long running
+         * program was killed.
+         */
+        struct reader_checkpoint {
+
+            /// Offset in the (uncompressed) input just after the data
+            /// returned by the Reader so far. This is always at a block
+            /// boundary. 0 if nothing has been returned or the input
+            /// format doesn't support checkpoints.
+            std::size_t offset = 0;
+
+            /// The header of the input file.
+            osmium::io::Header header{};
+
+        }; // struct reader_checkpoint
+
         /**
          * This is the user-facing interface for reading OSM files. Instantiate
          * an object of this class with a file name or osmium::io::File object
@@ -89,6 +216,10 @@ namespace osmium {
          */
         class Reader {
 
+            enum : std::size_t {
+                default_synchronous_threshold = 1024UL * 1024UL
+            };
+
             // The Reader::read() function reads from a queue of buffers which
             // can contain nested buffers. These nested buffers will be in
             // here, because read() can only return a single unnested buffer.
@@ -96,8 +227,22 @@ namespace osmium {
 
             osmium::io::File m_file;
 
+            // Read synchronously in the constructor without any threads,
+            // see use_synchronous_mode().
+            bool m_synchronous;
+
+            std::chrono::steady_clock::time_point m_start_time{std::chrono::steady_clock::now()};
+
             osmium::thread::Pool* m_pool = nullptr;
 
+            // Optional client of the pool used to share it fairly with
+            // other Readers.
+            osmium::thread::PoolClient* m_pool_client = nullptr;
+
+            // Optional pool the parsers get the memory for the buffers
+            // from. Buffers handed to recycle() go back into it.
+            osmium::memory::BufferPool* m_buffer_pool = nullptr;
+
             detail::ParserFactory::create_parser_type m_creator;
 
             enum class status {
@@ -109,6 +254,10 @@ namespace osmium {
 
             int m_childpid = 0;
 
+            // Only used if the input file is memory mapped, see
+            // create_mapping().
+            std::unique_ptr<osmium::util::MemoryMapping> m_mapping;
+
             detail::future_string_queue_type m_input_queue;
 
             std::unique_ptr<osmium::io::Decompressor> m_decompressor;
@@ -125,13 +274,48 @@ namespace osmium {
 
             std::size_t m_file_size = 0;
 
+            // Number of buffers taken from the osmdata queue (for tracing).
+            uint64_t m_buffer_sequence = 0;
+
+            // Offset in the input after the data returned so far, see
+            // checkpoint().
+            std::size_t m_checkpoint_offset = 0;
+
             osmium::osm_entity_bits::type m_read_which_entities = osmium::osm_entity_bits::all;
             osmium::io::read_meta m_read_metadata = osmium::io::read_meta::yes;
 
+            std::shared_ptr<const osmium::io::ReadFilter> m_read_filter;
+
+            // Only set if the ReadFilter selects versions.
+            std::unique_ptr<detail::LatestVersionSelector> m_version_selector;
+
+            std::function<void()> m_ready_callback;
+
             void set_option(osmium::thread::Pool& pool) noexcept {
                 m_pool = &pool;
             }
 
+            void set_option(osmium::thread::PoolClient& pool_client) noexcept {
+                m_pool = &pool_client.pool();
+                m_pool_client = &pool_client;
+            }
+
+            void set_option(osmium::memory::BufferPool& buffer_pool) noexcept {
+                m_buffer_pool = &buffer_pool;
+            }
+
+            void set_option(osmium::memory::MemoryBudget& budget) {
+                m_osmdata_queue.set_memory_budget(budget);
+            }
+
+            void set_option(osmium::io::RangeSource& /*range_source*/) noexcept {
+                // Only needed in the constructor, see find_range_source().
+            }
+
+            void set_option(osmium::io::Source& /*source*/) noexcept {
+                // Only needed in the constructor, see find_source().
+            }
+
             void set_option(osmium::osm_entity_bits::type value) noexcept {
                 m_read_which_entities = value;
             }
@@ -140,6 +324,38 @@ namespace osmium {
                 m_read_metadata = value;
             }
 
+            void set_option(const osmium::io::ReadFilter& filter) {
+                if (filter.filters_versions()) {
+                    // The other conditions can only be checked after the
+                    // versions have been selected, so the parsers only
+                    // get the version selection.
+                    m_version_selector.reset(new detail::LatestVersionSelector{filter});
+                    m_read_filter = std::make_shared<const osmium::io::ReadFilter>(filter.versions_only());
+                } else if (!filter.empty()) {
+                    m_read_filter = std::make_shared<const osmium::io::ReadFilter>(filter);
+                }
+            }
+
+            void set_option(const osmium::io::ready_callback& callback) {
+                m_ready_callback = callback.get();
+            }
+
+            void set_option(const osmium::io::reader_checkpoint& checkpoint) {
+                if (checkpoint.offset > 0) {
+                    m_file.set("pbf_resume_offset", std::to_string(checkpoint.offset));
+                }
+                m_checkpoint_offset = checkpoint.offset;
+            }
+
+            // Remember where the data in a buffer returned by read() ended
+            // in the input. Buffers with nested buffers are returned last,
+            // after all their nested buffers.
+            void update_checkpoint(const osmium::memory::Buffer& buffer) noexcept {
+                if (buffer.input_end_offset() > 0 && !m_version_selector) {
+                    m_checkpoint_offset = buffer.input_end_offset();
+                }
+            }
+
             // This function will run in a separate thread.
             static void parser_thread(osmium::thread::Pool& pool,
                                       const detail::ParserFactory::create_parser_type& creator,
@@ -147,7 +363,14 @@ namespace osmium {
                                       detail::future_buffer_queue_type& osmdata_queue,
                                       std::promise<osmium::io::Header>&& header_promise,
                                       osmium::osm_entity_bits::type read_which_entities,
-                                      osmium::io::read_meta read_metadata) {
+                                      osmium::io::read_meta read_metadata,
+                                      const osmium::util::MemoryMapping* mapping,
+                                      const osmium::io::File& file,
+                                      osmium::memory::BufferPool* buffer_pool,
+                                      const std::shared_ptr<const osmium::io::ReadFilter>& read_filter,
+                                      const std::function<void()>& ready_callback,
+                                      osmium::thread::PoolClient* pool_client,
+                                      bool synchronous) {
                 std::promise<osmium::io::Header> promise{std::move(header_promise)};
                 osmium::io::detail::parser_arguments args = {
                     pool,
@@ -157,6 +380,16 @@ namespace osmium {
                     read_which_entities,
                     read_metadata
                 };
+                if (mapping) {
+                    args.mapped_data = mapping->get_addr<const char>();
+                    args.mapped_size = mapping->size();
+                }
+                args.file = &file;
+                args.buffer_pool = buffer_pool;
+                args.read_filter = read_filter;
+                args.notify = ready_callback;
+                args.pool_client = pool_client;
+                args.synchronous = synchronous;
                 creator(args)->parse();
             }
 
@@ -229,6 +462,214 @@ namespace osmium {
                 return osmium::io::detail::open_for_reading(filename);
             }
 
+            /**
+             * Map the input file into memory if that is requested by the
+             * options on the file and possible:
+             *
+             * If the "mmap" option is set and the file is an
+             * uncompressed PBF file, the parser will read directly from
+             * the mapping instead of going through the input queue.
+             *
+             * If the "parallel_decompression" option is set and the file
+             * is compressed, the decompressor will work on the mapping
+             * so it can decompress independent parts of the file in
+             * parallel.
+             *
+             * Only normal non-empty files are mapped.
+             *
+             * @returns The mapping or nullptr if the file is not mapped.
+             * @throws std::system_error if a system call fails.
+             */
+            static std::unique_ptr<osmium::util::MemoryMapping> create_mapping(const osmium::io::File& file) {
+                const bool direct = file.is_true("mmap") &&
+                                    file.format() == file_format::pbf &&
+                                    file.compression() == file_compression::none;
+                const bool parallel = file.is_true("parallel_decompression") &&
+                                      file.compression() != file_compression::none;
+
+                if ((!direct && !parallel) ||
+                    file.buffer() ||
+                    file.filename().empty() ||
+                    file.filename() == "-" ||
+                    file.filename().find("://") != std::string::npos) {
+                    return nullptr;
+                }
+
+                const int fd = osmium::io::detail::open_for_reading(file.filename());
+                std::unique_ptr<osmium::util::MemoryMapping> mapping;
+                try {
+                    const std::size_t size = osmium::file_size(fd);
+                    if (size > 0) {
+                        mapping.reset(new osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd});
+                    }
+                } catch (...) {
+                    osmium::io::detail::reliable_close(fd);
+                    throw;
+                }
+
+                // The mapping stays valid after the file is closed.
+                osmium::io::detail::reliable_close(fd);
+
+                return mapping;
+            }
+
+            // The mapping is handed to the parser only if it contains
+            // uncompressed data.
+            const osmium::util::MemoryMapping* parser_mapping() const noexcept {
+                return m_file.compression() == file_compression::none ? m_mapping.get() : nullptr;
+            }
+
+            std::unique_ptr<osmium::io::Decompressor> create_decompressor(osmium::io::RangeSource* range_source, osmium::io::Source* source) {
+                if (source) {
+                    m_mapping.reset();
+                    return osmium::io::CompressionFactory::instance().create_decompressor(m_file.compression(), *source);
+                }
+
+                if (range_source) {
+                    m_mapping.reset();
+                    return osmium::io::detail::create_range_decompressor(m_file, range_source);
+                }
+
+                if (m_mapping) {
+                    if (m_file.compression() == file_compression::none) {
+                        // The parser reads directly from the mapping, so
+                        // the read thread doesn't get anything to do.
+                        return std::unique_ptr<osmium::io::Decompressor>{new osmium::io::NoDecompressor{"", 0}};
+                    }
+
+                    auto decompressor = osmium::io::CompressionFactory::instance().create_parallel_decompressor(
+                        m_file.compression(),
+                        m_mapping->get_addr<const char>(),
+                        m_mapping->size(),
+                        m_pool ? *m_pool : thread::Pool::default_instance());
+                    if (decompressor) {
+                        return decompressor;
+                    }
+
+                    // The file can not be decompressed in parallel, read
+                    // it the normal way.
+                    m_mapping.reset();
+                }
+
+                auto decompressor = osmium::io::detail::create_range_decompressor(m_file, nullptr);
+                if (decompressor) {
+                    return decompressor;
+                }
+
+                decompressor = osmium::io::detail::create_uring_decompressor(m_file);
+                if (decompressor) {
+                    return decompressor;
+                }
+
+                if (m_file.buffer()) {
+                    return osmium::io::CompressionFactory::instance().create_decompressor(m_file.compression(), m_file.buffer(), m_file.buffer_size());
+                }
+
+                return osmium::io::CompressionFactory::instance().create_decompressor(m_file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid));
+            }
+
+            /**
+             * Decide whether the file should be read synchronously: If the
+             * "synchronous" option is set on the file, use that. Otherwise
+             * small uncompressed files (with a known size of at most
+             * "synchronous_threshold" bytes, default 1 MB) are read
+             * synchronously unless the options given to the Reader need the
+             * threads.
+             */
+            static bool use_synchronous_mode(const osmium::io::File& file, bool needs_threads) {
+                // The parser fills the queues before they are read, this
+                // would block forever if they are limited in size.
+                if (osmium::thread::pipeline_queue_is_bounded) {
+                    return false;
+                }
+
+                if (!file.get("synchronous").empty()) {
+                    return file.is_true("synchronous");
+                }
+
+                if (needs_threads) {
+                    return false;
+                }
+
+                // Compressed data (PBF is compressed internally) can be
+                // many times larger after decoding. All of it would end up
+                // in the unlimited queues before the constructor returns.
+                if (file.compression() != osmium::io::file_compression::none ||
+                    file.format() == osmium::io::file_format::pbf) {
+                    return false;
+                }
+
+                const std::string threshold_option = file.get("synchronous_threshold");
+                const std::size_t threshold = threshold_option.empty() ? std::size_t(default_synchronous_threshold)
+                                                                       : osmium::detail::str_to_int<std::size_t>(threshold_option.c_str());
+
+                std::size_t size = 0;
+                if (file.buffer()) {
+                    size = file.buffer_size();
+                } else if (!file.filename().empty() &&
+                           file.filename() != "-" &&
+                           file.filename().find("://") == std::string::npos) {
+                    try {
+                        size = osmium::file_size(file.filename());
+                    } catch (const std::system_error&) {
+                        // Opening the file will report the error.
+                    }
+                }
+
+                return size > 0 && size <= threshold;
+            }
+
+            static osmium::thread::Pool* find_pool() noexcept {
+                return nullptr;
+            }
+
+            template <typename... TArgs>
+            static osmium::thread::Pool* find_pool(osmium::thread::Pool& pool, TArgs&&... /*args*/) noexcept {
+                return &pool;
+            }
+
+            template <typename... TArgs>
+            static osmium::thread::Pool* find_pool(osmium::thread::PoolClient& pool_client, TArgs&&... /*args*/) noexcept {
+                return &pool_client.pool();
+            }
+
+            template <typename T, typename... TArgs>
+            static osmium::thread::Pool* find_pool(T&& /*arg*/, TArgs&&... args) noexcept {
+                return find_pool(std::forward<TArgs>(args)...);
+            }
+
+            static osmium::io::RangeSource* find_range_source() noexcept {
+                return nullptr;
+            }
+
+            template <typename... TArgs>
+            static osmium::io::RangeSource* find_range_source(osmium::io::RangeSource& range_source, TArgs&&... /*args*/) noexcept {
+                return &range_source;
+            }
+
+            // Sources are derived from RangeSource, so they must not match
+            // here.
+            template <typename T, typename... TArgs>
+            static typename std::enable_if<!std::is_base_of<osmium::io::RangeSource, typename std::decay<T>::type>::value, osmium::io::RangeSource*>::type
+            find_range_source(T&& /*arg*/, TArgs&&... args) noexcept {
+                return find_range_source(std::forward<TArgs>(args)...);
+            }
+
+            static osmium::io::Source* find_source() noexcept {
+                return nullptr;
+            }
+
+            template <typename... TArgs>
+            static osmium::io::Source* find_source(osmium::io::Source& source, TArgs&&... /*args*/) noexcept {
+                return &source;
+            }
+
+            template <typename T, typename... TArgs>
+            static typename std::enable_if<!std::is_base_of<osmium::io::Source, typename std::decay<T>::type>::value, osmium::io::Source*>::type
+            find_source(T&& /*arg*/, TArgs&&... args) noexcept {
+                return find_source(std::forward<TArgs>(args)...);
+            }
+
         public:
 
             /**
@@ -260,21 +701,134 @@ namespace osmium {
              *      For instance when your program will fork, using the
              *      statically initialized pool will not work.
              *
+             * * osmium::thread::PoolClient&: Reference to a client of a
+             *      thread pool. The Reader will use the pool of the client
+             *      and submit all parsing work through the client. Use this
+             *      to share one pool fairly between several Readers: Each
+             *      Reader gets its own client with a weight and a limit on
+             *      the number of blocks parsed at the same time. The client
+             *      must outlive the Reader.
+             *
+             * * osmium::memory::BufferPool&: Reference to a pool of buffer
+             *      memory. The parsers will take the memory for the buffers
+             *      returned by read() from this pool if possible. Hand
+             *      buffers you don't need any more to recycle() so that their
+             *      memory can be reused. The pool must outlive the Reader.
+             *      If the pool was created with a BufferAllocator, all new
+             *      buffer memory comes from that allocator. Not all file
+             *      formats use this setting.
+             *
+             * * const osmium::io::ReadFilter&: Conditions objects have to
+             *      match. Parsers supporting them will not build objects
+             *      that don't match, which can speed up reading of
+             *      selective workloads considerably. The filter is copied.
+             *      Not all file formats use this setting. The exception
+             *      is the version selection (ReadFilter::latest_versions())
+             *      which the Reader applies itself if the parser doesn't.
+             *
+             * * const osmium::io::ready_callback&: Function called whenever
+             *      new data might be available for try_read(). See
+             *      try_read() and the ready_callback class.
+             *
+             * * osmium::io::RangeSource&: Source the input is read from
+             *      instead of opening the file. The data is read with
+             *      several range requests in flight (set with the
+             *      "parallel_ranges" option on the file, default 4) of
+             *      "range_size" bytes (default 8 MB). Use this for reading
+             *      from object storage. The file name is only used to
+             *      find the format, the file must not be compressed. The
+             *      source must outlive the Reader.
+             *
+             * * osmium::io::Source&: Source the (possibly compressed)
+             *      input is read from sequentially instead of opening the
+             *      file, for instance from shared memory (see
+             *      MemorySource) or some remote storage. The file name is
+             *      only used to find the format and compression. The
+             *      source must outlive the Reader.
+             *
+             * * osmium::memory::MemoryBudget&: Account for the decoded
+             *      data waiting to be read in this budget. While the
+             *      budget is exhausted, decoding pauses until buffers are
+             *      read or memory is freed elsewhere. The budget must
+             *      outlive the Reader.
+             *
+             * * const osmium::io::reader_checkpoint&: Resume reading at
+             *      a checkpoint returned by checkpoint() of an earlier
+             *      Reader on the same file. All data before the
+             *      checkpoint is skipped. Only PBF files support this (by
+             *      setting the "pbf_resume_offset" option on the file).
+             *      The data before the checkpoint still has to be read
+             *      unless the file is memory mapped ("mmap" option), but
+             *      it is not decoded.
+             *
+             * Small files are read synchronously: Reading, decompressing,
+             * and parsing is done completely in the constructor in the
+             * calling thread without starting any threads or using the
+             * thread pool. This avoids the overhead of setting all that up,
+             * which dominates the run time when many small files are read.
+             * This is done for uncompressed files (not PBF) known to be at
+             * most 1 MB in size (set the "synchronous_threshold" option on
+             * the file to change this) unless a ready_callback,
+             * MemoryBudget, RangeSource, or Source is given. Setting the
+             * "synchronous" option on the file to true or false overrides
+             * this. Because all data is held in memory, don't force
+             * synchronous mode for large files. If OSMIUM_USE_LOCKFREE_QUEUE
+             * is defined, files are never read synchronously, because the
+             * LockFreeQueue can not be unlimited in size.
+             *
+             * If the file has the "mmap" option set (for instance by using
+             * the format string "pbf,mmap=true") and it is an uncompressed
+             * PBF file, it will be memory mapped and decoded directly from
+             * the mapping. This avoids the read thread and all copying of
+             * the input data. In this case offset() will always return 0.
+             *
+             * If the file has the "parallel_ranges" option set to the
+             * number of requests in flight (for instance "pbf,parallel_ranges=8")
+             * and it is uncompressed, it is read with several range
+             * requests in parallel. For http and https URLs these are
+             * HTTP range requests run with the "curl" program, normal files
+             * are read with pread(2).
+             *
+             * If the "pbf_sample_every" option is set to some number n on
+             * a PBF file, only one in n data blobs is decoded, which gives
+             * approximate statistics much faster. Without the
+             * "pbf_sample_seed" option every n-th blob is used, otherwise
+             * a pseudo-random subset of blobs depending on the seed. See
+             * sampling_ratio().
+             *
+             * The "pbf_blob_range" option (for instance "pbf_blob_range=10-20")
+             * restricts reading of a PBF file to the data blobs with
+             * numbers (counting from 0) in the half-open range given, the
+             * "pbf_byte_range" option to the data blobs starting at offsets
+             * in the file in the given range. The OSMHeader is always
+             * read. Use this to distribute the work of reading one file
+             * to several processes or machines, each reading a part of
+             * it, see split_pbf_file() and set_pbf_byte_range() in
+             * pbf_split.hpp. Blobs outside the range are not decoded. If
+             * the file is memory mapped ("mmap" option), only the
+             * BlobHeaders of the blobs before the range are read and
+             * nothing after it.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
             template <typename... TArgs>
             explicit Reader(const osmium::io::File& file, TArgs&&... args) :
                 m_file(file.check()),
+                m_synchronous(use_synchronous_mode(m_file,
+                                                   detail::has_arg_of_type<osmium::io::ready_callback, TArgs...>::value ||
+                                                   detail::has_arg_of_type<osmium::memory::MemoryBudget, TArgs...>::value ||
+                                                   detail::has_arg_of_type<osmium::io::RangeSource, TArgs...>::value ||
+                                                   detail::has_arg_of_type<osmium::io::Source, TArgs...>::value)),
+                m_pool(find_pool(args...)),
                 m_creator(detail::ParserFactory::instance().get_creator_function(m_file)),
-                m_input_queue(detail::get_input_queue_size(), "raw_input"),
-                m_decompressor(m_file.buffer() ?
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), m_file.buffer(), m_file.buffer_size()) :
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid))),
-                m_read_thread_manager(*m_decompressor, m_input_queue),
-                m_osmdata_queue(detail::get_osmdata_queue_size(), "parser_results"),
+                m_mapping(create_mapping(m_file)),
+                m_input_queue(m_synchronous ? 0 : detail::get_input_queue_size(), "raw_input", m_synchronous ? 0 : detail::get_input_queue_bytes()),
+                m_decompressor(create_decompressor(find_range_source(args...), find_source(args...))),
+                m_read_thread_manager(*m_decompressor, m_input_queue, !m_synchronous),
+                m_osmdata_queue(m_synchronous ? 0 : detail::get_osmdata_queue_size(), "parser_results", m_synchronous ? 0 : detail::get_osmdata_queue_bytes()),
                 m_osmdata_queue_wrapper(m_osmdata_queue),
-                m_file_size(m_decompressor->file_size()) {
+                m_file_size(m_mapping ? m_mapping->size() : m_decompressor->file_size()) {
 
                 (void)std::initializer_list<int>{
                     (set_option(args), 0)...
@@ -286,7 +840,23 @@ namespace osmium {
 
                 std::promise<osmium::io::Header> header_promise;
                 m_header_future = header_promise.get_future();
-                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata};
+
+                if (!m_synchronous) {
+                    m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata, parser_mapping(), std::cref(m_file), m_buffer_pool, m_read_filter, m_ready_callback, m_pool_client, false};
+                    return;
+                }
+
+                // Read and parse everything right here, the queues are
+                // unlimited and will hold all the data.
+                m_read_thread_manager.run();
+                try {
+                    parser_thread(*m_pool, m_creator, m_input_queue, m_osmdata_queue, std::move(header_promise), m_read_which_entities, m_read_metadata, parser_mapping(), m_file, m_buffer_pool, m_read_filter, m_ready_callback, m_pool_client, true);
+                } catch (...) {
+                    // The parser couldn't be created, parse() itself
+                    // never throws.
+                    detail::add_to_queue(m_osmdata_queue, std::current_exception());
+                    detail::add_end_of_data_to_queue(m_osmdata_queue);
+                }
             }
 
             template <typename... TArgs>
@@ -373,17 +943,11 @@ namespace osmium {
                 return m_header;
             }
 
-            /**
-             * Reads the next buffer from the input. An invalid buffer signals
-             * end-of-file. After end-of-file all read() calls will throw an
-             * osmium::io_error.
-             *
-             * @returns Buffer.
-             * @throws Some form of osmium::io_error if there is an error.
-             */
-            osmium::memory::Buffer read() {
-                osmium::memory::Buffer buffer;
+        private:
 
+            // Get the next buffer. If wait is false, return false if
+            // no buffer is available right now instead of blocking.
+            bool next_buffer(osmium::memory::Buffer& buffer, const bool wait) {
                 // If there are buffers on the stack, return those first.
                 if (m_back_buffers) {
                     if (m_back_buffers.has_nested_buffers()) {
@@ -391,8 +955,9 @@ namespace osmium {
                     } else {
                         buffer = std::move(m_back_buffers);
                         m_back_buffers = osmium::memory::Buffer{};
+                        update_checkpoint(buffer);
                     }
-                    return buffer;
+                    return true;
                 }
 
                 if (m_status != status::okay) {
@@ -401,7 +966,8 @@ namespace osmium {
 
                 if (m_read_which_entities == osmium::osm_entity_bits::nothing) {
                     m_status = status::eof;
-                    return buffer;
+                    buffer = osmium::memory::Buffer{};
+                    return true;
                 }
 
                 try {
@@ -410,18 +976,27 @@ namespace osmium {
                     // without data is not an error, it just means we have to
                     // keep getting the next buffer until there is one with data.
                     while (true) {
-                        buffer = m_osmdata_queue_wrapper.pop();
+                        if (wait) {
+                            const osmium::util::TraceScope trace{osmium::util::trace_stage::queue_wait, m_buffer_sequence++};
+                            buffer = m_osmdata_queue_wrapper.pop();
+                        } else if (m_osmdata_queue_wrapper.try_pop(buffer)) {
+                            ++m_buffer_sequence;
+                        } else {
+                            return false;
+                        }
                         if (detail::at_end_of_data(buffer)) {
                             m_status = status::eof;
                             m_read_thread_manager.close();
-                            return buffer;
+                            return true;
                         }
                         if (buffer.has_nested_buffers()) {
                             m_back_buffers = std::move(buffer);
                             buffer = std::move(*m_back_buffers.get_last_nested());
+                        } else {
+                            update_checkpoint(buffer);
                         }
                         if (buffer.committed() > 0) {
-                            return buffer;
+                            return true;
                         }
                     }
                 } catch (...) {
@@ -431,6 +1006,100 @@ namespace osmium {
                 }
             }
 
+            bool read_impl(osmium::memory::Buffer& buffer, const bool wait) {
+                if (!m_version_selector) {
+                    return next_buffer(buffer, wait);
+                }
+
+                if (m_version_selector->flushed()) {
+                    // The last buffer was returned by the previous call,
+                    // now signal end-of-file.
+                    m_version_selector.reset();
+                    buffer = osmium::memory::Buffer{};
+                    return true;
+                }
+
+                while (true) {
+                    osmium::memory::Buffer input;
+                    if (!next_buffer(input, wait)) {
+                        return false;
+                    }
+                    if (!input) {
+                        auto last_buffer = m_version_selector->flush();
+                        if (last_buffer.committed() > 0) {
+                            buffer = std::move(last_buffer);
+                            return true;
+                        }
+                        m_version_selector.reset();
+                        buffer = std::move(input);
+                        return true;
+                    }
+                    auto result = m_version_selector->add(std::move(input));
+                    if (result.committed() > 0) {
+                        buffer = std::move(result);
+                        return true;
+                    }
+                }
+            }
+
+        public:
+
+            /**
+             * Reads the next buffer from the input. An invalid buffer signals
+             * end-of-file. After end-of-file all read() calls will throw an
+             * osmium::io_error.
+             *
+             * @returns Buffer.
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            osmium::memory::Buffer read() {
+                osmium::memory::Buffer buffer;
+                read_impl(buffer, true);
+                return buffer;
+            }
+
+            /**
+             * Non-blocking version of read(). If the next buffer is
+             * available, it is moved into the buffer parameter and true is
+             * returned. Like with read() an invalid buffer signals
+             * end-of-file. If no data is available yet, false is returned
+             * and the buffer is not changed. Call try_read() again later,
+             * usually after the function set with the ready_callback
+             * option was called.
+             *
+             * Don't mix calls to read() and try_read() from different
+             * threads, the Reader is not thread-safe.
+             *
+             * @param buffer The buffer to move the data into.
+             * @returns Was a buffer (or end-of-file) returned?
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            bool try_read(osmium::memory::Buffer& buffer) {
+                osmium::memory::Buffer next;
+                if (!read_impl(next, false)) {
+                    return false;
+                }
+                buffer = std::move(next);
+                return true;
+            }
+
+            /**
+             * Give a buffer returned by read() back to the Reader when it is
+             * not needed any more. If a BufferPool was set in the
+             * constructor, its memory goes back into that pool and will be
+             * reused for new buffers. Otherwise the buffer is simply
+             * destroyed.
+             *
+             * @param buffer The buffer. It will be invalid afterwards.
+             */
+            void recycle(osmium::memory::Buffer&& buffer) {
+                if (m_buffer_pool) {
+                    m_buffer_pool->put(std::move(buffer));
+                } else {
+                    buffer = osmium::memory::Buffer{};
+                }
+            }
+
             /**
              * Has the end of file been reached? This is set after the last
              * data has been read. It is also set by calling close().
@@ -447,6 +1116,24 @@ namespace osmium {
                 return m_file_size;
             }
 
+            /**
+             * The fraction of the data blobs decoded if the input is
+             * sampled with the "pbf_sample_every" option on a PBF file,
+             * 1.0 otherwise. Divide counts from the data returned by
+             * read() by this to estimate the counts for the whole input.
+             */
+            double sampling_ratio() const {
+                if (m_file.format() != file_format::pbf) {
+                    return 1.0;
+                }
+                const std::string sample_every = m_file.get("pbf_sample_every");
+                if (sample_every.empty()) {
+                    return 1.0;
+                }
+                const auto value = osmium::detail::str_to_int<uint64_t>(sample_every.c_str());
+                return value > 1 ? 1.0 / static_cast<double>(value) : 1.0;
+            }
+
             /**
              * Returns the current offset into the input file. Returns 0 if
              * the offset is not available (for instance when reading from
@@ -462,9 +1149,66 @@ namespace osmium {
              * do an expensive system call.
              */
             std::size_t offset() const noexcept {
+                if (parser_mapping()) {
+                    return 0;
+                }
                 return m_decompressor->offset();
             }
 
+            /**
+             * Get the position from which reading can be resumed later
+             * with a new Reader, given the data returned by read() so far
+             * has been processed completely. Only PBF files support this,
+             * for other formats the offset of the checkpoint is always 0,
+             * meaning reading has to start from the beginning. It is also
+             * always 0 if the ReadFilter selects the latest versions.
+             *
+             * A typical long running program will process the buffers
+             * returned by read() and from time to time save the checkpoint
+             * together with its own state. If the program is killed it
+             * can restart from the saved checkpoint instead of from the
+             * beginning. If it writes a PBF file, it can use
+             * truncate_pbf_file() and a Writer with osmium::io::append::yes
+             * to continue writing the output.
+             *
+             * @throws Some form of osmium::io_error if there is an error
+             *         reading the header.
+             */
+            reader_checkpoint checkpoint() {
+                reader_checkpoint result;
+                result.offset = m_checkpoint_offset;
+                result.header = header();
+                return result;
+            }
+
+            /**
+             * The number of bytes currently waiting in the queues of this
+             * Reader. The sizes are those given to the queues, for the
+             * decoded data this is the size of the input data the buffers
+             * were decoded from, so this is only an estimate. This can be
+             * called from any thread while the Reader is open.
+             */
+            std::size_t used_memory() const {
+                return m_input_queue.bytes() + m_osmdata_queue.bytes();
+            }
+
+            /**
+             * Get a snapshot of the statistics of this Reader. This can be
+             * called from any thread while the Reader is open. The stats of
+             * the thread pool used for parsing are available from the pool.
+             */
+            reader_stats stats() const {
+                reader_stats stats;
+                stats.file_size = m_file_size;
+                stats.offset = offset();
+                stats.bytes_read = m_read_thread_manager.bytes_read();
+                stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start_time);
+                stats.input_queue = m_input_queue.stats();
+                stats.osmdata_queue = m_osmdata_queue.stats();
+                stats.buffers = stats.osmdata_queue.push_count;
+                return stats;
+            }
+
         }; // class Reader
 
         /**
@@ -0,0 +1,269 @@
+#ifndef OSMIUM_IO_SHARDED_WRITER_HPP
+#define OSMIUM_IO_SHARDED_WRITER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/file.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * How the ShardedWriter distributes the data over the shards.
+         * Use one of the static functions to create an object of this
+         * class.
+         */
+        class sharding {
+
+            osmium::object_id_type m_ids_per_shard;
+
+            explicit sharding(const osmium::object_id_type ids_per_shard) noexcept :
+                m_ids_per_shard(ids_per_shard) {
+            }
+
+        public:
+
+            /**
+             * Blocks of data (whole buffers or about a buffer full of
+             * objects) are written to the shards in turn. This is the
+             * cheapest mode, because buffers are handed to the writers
+             * as they are.
+             */
+            static sharding round_robin() noexcept {
+                return sharding{0};
+            }
+
+            /**
+             * Objects with ids from n * ids_per_shard to
+             * (n + 1) * ids_per_shard - 1 are written to shard n. Objects
+             * with larger ids are written to the last shard, objects with
+             * negative ids to the first. If the input is sorted, each
+             * shard will be sorted, too.
+             *
+             * @throws std::invalid_argument If ids_per_shard is not positive.
+             */
+            static sharding id_range(const osmium::object_id_type ids_per_shard) {
+                if (ids_per_shard <= 0) {
+                    throw std::invalid_argument{"ids_per_shard must be positive"};
+                }
+                return sharding{ids_per_shard};
+            }
+
+            bool is_round_robin() const noexcept {
+                return m_ids_per_shard == 0;
+            }
+
+            osmium::object_id_type ids_per_shard() const noexcept {
+                return m_ids_per_shard;
+            }
+
+        }; // class sharding
+
+        /**
+         * Writes OSM data into several files (shards) at the same time,
+         * each with its own Writer. Because every Writer has its own
+         * encoding pipeline and write thread, this scales much better
+         * than a single Writer when writing large amounts of data.
+         *
+         * Usage:
+         * @code
+         * std::vector<osmium::io::File> parts{...};
+         * osmium::io::ShardedWriter writer{parts, osmium::io::sharding::round_robin(), header};
+         * while (osmium::memory::Buffer buffer = reader.read()) {
+         *     writer(std::move(buffer));
+         * }
+         * writer.close();
+         * @endcode
+         *
+         * PBF parts can be combined into one file afterwards with
+         * osmium::io::concatenate_pbf_files() (in pbf_concatenate.hpp).
+         */
+        class ShardedWriter {
+
+            std::vector<osmium::io::File> m_files;
+            std::vector<std::unique_ptr<osmium::io::Writer>> m_writers;
+            sharding m_sharding;
+
+            // Shard currently written to in round_robin mode and how many
+            // bytes of single items were written to it.
+            std::size_t m_current = 0;
+            std::size_t m_current_bytes = 0;
+
+            void next_shard() noexcept {
+                m_current = (m_current + 1) % m_writers.size();
+                m_current_bytes = 0;
+            }
+
+            std::size_t shard_for(const osmium::memory::Item& item) const noexcept {
+                switch (item.type()) {
+                    case osmium::item_type::node:
+                    case osmium::item_type::way:
+                    case osmium::item_type::relation:
+                    case osmium::item_type::area:
+                        break;
+                    default:
+                        // Everything else (changesets) goes into the
+                        // first shard.
+                        return 0;
+                }
+
+                const auto id = static_cast<const osmium::OSMObject&>(item).id();
+                if (id < 0) {
+                    return 0;
+                }
+
+                const auto shard = static_cast<std::size_t>(id / m_sharding.ids_per_shard());
+                return shard < m_writers.size() ? shard : m_writers.size() - 1;
+            }
+
+        public:
+
+            /**
+             * Open all the part files and write the header to each of
+             * them.
+             *
+             * @param files The files to write to, one per shard.
+             * @param mode How the data is distributed over the shards.
+             * @param args Further arguments given to the constructor of
+             *             each Writer. See there for details. The header
+             *             given here is written to each part.
+             * @throws std::invalid_argument If files is empty.
+             * @throws Any exception the Writer constructor throws.
+             */
+            template <typename... TArgs>
+            ShardedWriter(const std::vector<osmium::io::File>& files, const sharding mode, TArgs&&... args) :
+                m_files(files),
+                m_sharding(mode) {
+                if (files.empty()) {
+                    throw std::invalid_argument{"ShardedWriter needs at least one file"};
+                }
+                m_writers.reserve(files.size());
+                for (const auto& file : files) {
+                    m_writers.emplace_back(new osmium::io::Writer{file, args...});
+                }
+            }
+
+            ShardedWriter(const ShardedWriter&) = delete;
+            ShardedWriter& operator=(const ShardedWriter&) = delete;
+
+            ShardedWriter(ShardedWriter&&) = delete;
+            ShardedWriter& operator=(ShardedWriter&&) = delete;
+
+            ~ShardedWriter() noexcept = default;
+
+            /// The number of shards.
+            std::size_t size() const noexcept {
+                return m_writers.size();
+            }
+
+            /// The files written to.
+            const std::vector<osmium::io::File>& files() const noexcept {
+                return m_files;
+            }
+
+            /**
+             * Write contents of a buffer. In round_robin mode the buffer is
+             * moved to the next shard as is, in id_range mode its objects
+             * are copied to the right shards.
+             *
+             * @param buffer Buffer that is being written out.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void operator()(osmium::memory::Buffer&& buffer) {
+                if (m_sharding.is_round_robin()) {
+                    (*m_writers[m_current])(std::move(buffer));
+                    next_shard();
+                    return;
+                }
+
+                for (const auto& item : buffer) {
+                    (*m_writers[shard_for(item)])(item);
+                }
+            }
+
+            /**
+             * Write a single item (usually an OSM object). In round_robin
+             * mode the shard is switched after each buffer full of items.
+             *
+             * @param item Item to write.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void operator()(const osmium::memory::Item& item) {
+                if (!m_sharding.is_round_robin()) {
+                    (*m_writers[shard_for(item)])(item);
+                    return;
+                }
+
+                auto& writer = *m_writers[m_current];
+                writer(item);
+                m_current_bytes += item.padded_size();
+                if (m_current_bytes >= writer.buffer_size()) {
+                    next_shard();
+                }
+            }
+
+            /**
+             * Flush and close all part files. If you do not call this,
+             * the destructor will do it, but will ignore any errors.
+             *
+             * @returns Number of bytes written to all files (or 0 if it
+             *          can not be determined).
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            std::size_t close() {
+                std::size_t bytes = 0;
+                for (auto& writer : m_writers) {
+                    bytes += writer->close();
+                }
+                return bytes;
+            }
+
+        }; // class ShardedWriter
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_SHARDED_WRITER_HPP
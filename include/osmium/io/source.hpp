@@ -0,0 +1,287 @@
+#ifndef OSMIUM_IO_SOURCE_HPP
+#define OSMIUM_IO_SOURCE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <fcntl.h>
+#include <limits>
+#include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/uio.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * A block of memory to read data into.
+         */
+        struct source_buffer {
+            char* data;
+            std::size_t size;
+        }; // struct source_buffer
+
+        /**
+         * Interface for sequential inputs the (compressed) data of an OSM
+         * file is read from. Normal files and pipes are read through an
+         * FdSource, derive from this class to read from somewhere else,
+         * for instance from shared memory or some remote storage, and
+         * give an object of the class to the Reader.
+         *
+         * All functions are only called from the read thread of the
+         * Reader, they don't have to be thread-safe.
+         */
+        class Source {
+
+        public:
+
+            Source() = default;
+
+            Source(const Source&) = delete;
+            Source& operator=(const Source&) = delete;
+
+            Source(Source&&) = delete;
+            Source& operator=(Source&&) = delete;
+
+            virtual ~Source() noexcept = default;
+
+            /**
+             * Read up to size bytes into data.
+             *
+             * @returns The number of bytes read, 0 only at the end of the
+             *          input.
+             * @throws Some form of std::exception if the data can't be
+             *         read.
+             */
+            virtual std::size_t read(char* data, std::size_t size) = 0;
+
+            /**
+             * Read into several buffers (scatter read). The buffers are
+             * filled completely in order, only at the end of the input
+             * less data is returned. The default implementation calls
+             * read() as often as needed, sources that can do better
+             * (for instance with a single system call) override this.
+             *
+             * @returns The number of bytes read overall.
+             */
+            virtual std::size_t readv(const std::vector<source_buffer>& buffers) {
+                std::size_t total = 0;
+                for (const auto& buffer : buffers) {
+                    std::size_t done = 0;
+                    while (done < buffer.size) {
+                        const std::size_t nread = read(buffer.data + done, buffer.size - done);
+                        if (nread == 0) {
+                            return total + done;
+                        }
+                        done += nread;
+                    }
+                    total += done;
+                }
+                return total;
+            }
+
+            /**
+             * Hint that the given range of the input will be read soon.
+             * Sources can use this to start fetching the data in the
+             * background. The default implementation does nothing.
+             */
+            virtual void prefetch(std::size_t offset, std::size_t size) {
+                (void)offset;
+                (void)size;
+            }
+
+            /**
+             * The size of the input in bytes or 0 if it is not known.
+             */
+            virtual std::size_t size() {
+                return 0;
+            }
+
+            /**
+             * Called when reading is done. The default implementation
+             * does nothing.
+             */
+            virtual void close() {
+            }
+
+        }; // class Source
+
+        /**
+         * Source reading from a file descriptor. This is what is used
+         * for normal files, pipes, and stdin. The file descriptor is
+         * closed by close().
+         */
+        class FdSource final : public Source {
+
+            int m_fd;
+
+        public:
+
+            explicit FdSource(const int fd) noexcept :
+                m_fd(fd) {
+            }
+
+            FdSource(const FdSource&) = delete;
+            FdSource& operator=(const FdSource&) = delete;
+
+            FdSource(FdSource&&) = delete;
+            FdSource& operator=(FdSource&&) = delete;
+
+            ~FdSource() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            int fd() const noexcept {
+                return m_fd;
+            }
+
+            std::size_t read(char* data, const std::size_t size) override {
+                const auto nread = osmium::io::detail::reliable_read(m_fd, data, static_cast<unsigned int>(std::min(size, std::size_t(std::numeric_limits<int>::max()))));
+                return static_cast<std::size_t>(nread);
+            }
+
+#ifndef _WIN32
+            std::size_t readv(const std::vector<source_buffer>& buffers) override {
+                std::vector<iovec> iov;
+                iov.reserve(buffers.size());
+                for (const auto& buffer : buffers) {
+                    if (buffer.size > 0) {
+                        iov.push_back(iovec{buffer.data, buffer.size});
+                    }
+                }
+
+                // Partial reads are continued where they stopped, the first
+                // iovec not filled completely is adjusted.
+                std::size_t total = 0;
+                std::size_t first = 0;
+                while (first < iov.size()) {
+                    const auto count = std::min(iov.size() - first, std::size_t(1024));
+                    const auto length = ::readv(m_fd, &iov[first], static_cast<int>(count));
+                    if (length < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        throw std::system_error{errno, std::system_category(), "Read failed"};
+                    }
+                    if (length == 0) {
+                        break;
+                    }
+
+                    auto nread = static_cast<std::size_t>(length);
+                    total += nread;
+                    while (first < iov.size() && nread >= iov[first].iov_len) {
+                        nread -= iov[first].iov_len;
+                        ++first;
+                    }
+                    if (nread > 0) {
+                        iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + nread;
+                        iov[first].iov_len -= nread;
+                    }
+                }
+                return total;
+            }
+#endif
+
+            void prefetch(const std::size_t offset, const std::size_t size) override {
+#ifdef __linux__
+                // Only a hint, errors (for instance on pipes) are ignored.
+                ::posix_fadvise(m_fd, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#else
+                (void)offset;
+                (void)size;
+#endif
+            }
+
+            std::size_t size() override {
+                return osmium::file_size(m_fd);
+            }
+
+            void close() override {
+                if (m_fd >= 0) {
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class FdSource
+
+        /**
+         * Source reading from memory, for instance from a shared memory
+         * segment. The data is not copied, it must be available until
+         * reading is done.
+         */
+        class MemorySource final : public Source {
+
+            const char* m_data;
+            std::size_t m_size;
+            std::size_t m_offset = 0;
+
+        public:
+
+            MemorySource(const char* data, const std::size_t size) noexcept :
+                m_data(data),
+                m_size(size) {
+            }
+
+            std::size_t read(char* data, const std::size_t size) override {
+                const std::size_t length = std::min(size, m_size - m_offset);
+                std::copy_n(m_data + m_offset, length, data);
+                m_offset += length;
+                return length;
+            }
+
+            std::size_t size() override {
+                return m_size;
+            }
+
+        }; // class MemorySource
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_SOURCE_HPP
@@ -0,0 +1,220 @@
+#ifndef OSMIUM_IO_TIME_SLICES_HPP
+#define OSMIUM_IO_TIME_SLICES_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Call func with the index of every point in time at which the
+             * version was current. That is every point in time not before
+             * its own timestamp and before the timestamp of the next
+             * version (if there is one). Deleted versions are never
+             * current.
+             */
+            template <typename TFunc>
+            void for_each_time_slice(const std::vector<osmium::Timestamp>& points_in_time, const osmium::OSMObject& object, const osmium::OSMObject* next, TFunc&& func) {
+                if (!object.visible()) {
+                    return;
+                }
+                auto it = std::lower_bound(points_in_time.begin(), points_in_time.end(), object.timestamp());
+                for (; it != points_in_time.end() && (!next || *it < next->timestamp()); ++it) {
+                    func(static_cast<std::size_t>(std::distance(points_in_time.begin(), it)));
+                }
+            }
+
+            inline bool same_object(const osmium::OSMObject& a, const osmium::OSMObject& b) noexcept {
+                return a.type() == b.type() && a.id() == b.id();
+            }
+
+            /**
+             * Copy the versions in the buffer into one buffer per point in
+             * time. The last object in the buffer is left out, because its
+             * next version might be in the next buffer.
+             */
+            inline std::vector<osmium::memory::Buffer> select_time_slices(const osmium::memory::Buffer& buffer, const std::vector<osmium::Timestamp>& points_in_time) {
+                enum {
+                    initial_buffer_size = 64UL * 1024UL
+                };
+
+                std::vector<osmium::memory::Buffer> slices;
+                slices.reserve(points_in_time.size());
+                for (std::size_t i = 0; i < points_in_time.size(); ++i) {
+                    slices.emplace_back(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes);
+                }
+
+                const osmium::OSMObject* last = nullptr;
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (last) {
+                        for_each_time_slice(points_in_time, *last, same_object(*last, object) ? &object : nullptr, [&](std::size_t n) {
+                            slices[n].push_back(*last);
+                            slices[n].commit();
+                        });
+                    }
+                    last = &object;
+                }
+
+                return slices;
+            }
+
+            inline const osmium::OSMObject* first_object(const osmium::memory::Buffer& buffer) noexcept {
+                const auto objects = buffer.select<osmium::OSMObject>();
+                return objects.begin() == objects.end() ? nullptr : &*objects.begin();
+            }
+
+            inline const osmium::OSMObject* last_object(const osmium::memory::Buffer& buffer) noexcept {
+                const osmium::OSMObject* last = nullptr;
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    last = &object;
+                }
+                return last;
+            }
+
+        } // namespace detail
+
+        /**
+         * Write snapshots of the data at several points in time from a
+         * history file in a single pass. Snapshot n contains the versions
+         * of all objects current at points_in_time[n], ie. the last
+         * version with a timestamp not after that time, unless that
+         * version is deleted. It is written to writers[n].
+         *
+         * The versions are selected in parallel for each buffer in the
+         * thread pool, only the last object of each buffer has to wait
+         * for the next buffer. The objects are written in input order.
+         * The input must be ordered by type, id, and version (as history
+         * files are) and the timestamps of the versions of each object
+         * must increase. The writers are not closed.
+         *
+         * @tparam TSource Source of buffers, usually an osmium::io::Reader.
+         * @param source The source. Its read() function is called until it
+         *               returns an invalid buffer.
+         * @param points_in_time The points in time in ascending order.
+         * @param writers One Writer for each point in time.
+         * @param pool The thread pool to use.
+         * @throws std::invalid_argument if the numbers of points in time
+         *         and writers differ or the points in time are not in
+         *         ascending order.
+         */
+        template <typename TSource>
+        void write_time_slices(TSource& source, const std::vector<osmium::Timestamp>& points_in_time, const std::vector<osmium::io::Writer*>& writers, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            if (points_in_time.size() != writers.size()) {
+                throw std::invalid_argument{"need the same number of points in time and writers"};
+            }
+            if (!std::is_sorted(points_in_time.begin(), points_in_time.end())) {
+                throw std::invalid_argument{"points in time must be in ascending order"};
+            }
+
+            using buffer_ptr = std::shared_ptr<osmium::memory::Buffer>;
+
+            // Shared with the tasks which might not have finished when an
+            // exception is thrown.
+            const auto points = std::make_shared<const std::vector<osmium::Timestamp>>(points_in_time);
+
+            std::deque<std::pair<buffer_ptr, std::future<std::vector<osmium::memory::Buffer>>>> pending;
+            const std::size_t max_pending = static_cast<std::size_t>(pool.num_threads()) * 2;
+
+            // The buffer with the last object that still has to be
+            // written.
+            buffer_ptr previous;
+            const osmium::OSMObject* previous_object = nullptr;
+
+            const auto write_previous = [&](const osmium::OSMObject* next) {
+                if (previous_object) {
+                    detail::for_each_time_slice(*points, *previous_object, next, [&](std::size_t n) {
+                        (*writers[n])(*previous_object);
+                    });
+                }
+            };
+
+            const auto finish_one = [&]() {
+                auto& front = pending.front();
+                auto slices = front.second.get();
+
+                const auto* first = detail::first_object(*front.first);
+                if (first) {
+                    write_previous(previous_object && detail::same_object(*previous_object, *first) ? first : nullptr);
+                    for (std::size_t n = 0; n < writers.size(); ++n) {
+                        if (slices[n].committed() > 0) {
+                            (*writers[n])(std::move(slices[n]));
+                        }
+                    }
+                    previous = std::move(front.first);
+                    previous_object = detail::last_object(*previous);
+                }
+
+                pending.pop_front();
+            };
+
+            while (auto buffer = source.read()) {
+                const buffer_ptr ptr = std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+                auto future = pool.submit([ptr, points]() {
+                    return detail::select_time_slices(*ptr, *points);
+                });
+                pending.emplace_back(ptr, std::move(future));
+                if (pending.size() > max_pending) {
+                    finish_one();
+                }
+            }
+
+            while (!pending.empty()) {
+                finish_one();
+            }
+
+            write_previous(nullptr);
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_TIME_SLICES_HPP
@@ -34,22 +34,32 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/io_uring.hpp>
 #include <osmium/io/detail/output_format.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/detail/write_thread.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/queue_stats.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/misc.hpp>
 #include <osmium/version.hpp>
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <future>
@@ -72,8 +82,34 @@ namespace osmium {
                 return osmium::config::get_max_queue_size("OUTPUT", 20);
             }
 
+            inline std::size_t get_output_queue_bytes() noexcept {
+                return osmium::config::get_max_queue_bytes("OUTPUT");
+            }
+
         } // namespace detail
 
+        /**
+         * Snapshot of the statistics of a Writer. Returned by
+         * Writer::stats().
+         */
+        struct writer_stats {
+
+            /// Number of buffers handed to the output format for encoding.
+            uint64_t buffers = 0;
+
+            /// Number of bytes of encoded data handed to the compressor
+            /// (before compression).
+            std::size_t bytes_written = 0;
+
+            /// Time since the Writer was created.
+            std::chrono::nanoseconds elapsed{0};
+
+            /// Stats of the queue between the encoders and the write
+            /// thread.
+            osmium::thread::queue_stats output_queue{};
+
+        }; // struct writer_stats
+
         /**
          * This is the user-facing interface for writing OSM files. Instantiate
          * an object of this class with a file name or osmium::io::File object
@@ -103,9 +139,22 @@ namespace osmium {
                 default_buffer_size = 10UL * 1024UL * 1024UL
             };
 
+            enum : std::size_t {
+                default_write_batch_size = 1024UL * 1024UL
+            };
+
             osmium::io::File m_file;
 
-            detail::future_string_queue_type m_output_queue{detail::get_output_queue_size(), "raw_output"};
+            // Encode and write in the calling thread without any threads,
+            // the output queue is unlimited in this case. Not available
+            // if the queue can't be unlimited.
+            bool m_synchronous = !osmium::thread::pipeline_queue_is_bounded && m_file.is_true("synchronous");
+
+            std::chrono::steady_clock::time_point m_start_time{std::chrono::steady_clock::now()};
+            std::atomic<uint64_t> m_buffers_written{0};
+            std::atomic<std::size_t> m_bytes_written{0};
+
+            detail::future_string_queue_type m_output_queue{m_synchronous ? 0 : detail::get_output_queue_size(), "raw_output", m_synchronous ? 0 : detail::get_output_queue_bytes()};
 
             std::unique_ptr<osmium::io::detail::OutputFormat> m_output{nullptr};
 
@@ -117,6 +166,9 @@ namespace osmium {
 
             osmium::thread::thread_handler m_thread{};
 
+            // Used instead of the thread in synchronous mode.
+            std::unique_ptr<detail::WriteThread> m_sync_writer{};
+
             enum class status {
                 okay   = 0, // normal writing
                 error  = 1, // some error occurred while writing
@@ -126,16 +178,28 @@ namespace osmium {
             // This function will run in a separate thread.
             static void write_thread(detail::future_string_queue_type& output_queue,
                                      std::unique_ptr<osmium::io::Compressor>&& compressor,
-                                     std::promise<std::size_t>&& write_promise) {
+                                     std::promise<std::size_t>&& write_promise,
+                                     std::size_t batch_size,
+                                     std::atomic<std::size_t>* bytes_written) {
                 detail::WriteThread write_thread{output_queue,
                                                  std::move(compressor),
-                                                 std::move(write_promise)};
+                                                 std::move(write_promise),
+                                                 batch_size,
+                                                 bytes_written};
                 write_thread();
             }
 
             void do_write(osmium::memory::Buffer&& buffer) {
                 if (buffer && buffer.committed() > 0) {
                     m_output->write_buffer(std::move(buffer));
+                    m_buffers_written.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            void do_write(const std::shared_ptr<const osmium::memory::Buffer>& buffer) {
+                if (buffer && *buffer && buffer->committed() > 0) {
+                    m_output->write_shared_buffer(buffer);
+                    m_buffers_written.fetch_add(1, std::memory_order_relaxed);
                 }
             }
 
@@ -148,6 +212,7 @@ namespace osmium {
                     swap(m_buffer, buffer);
 
                     m_output->write_buffer(std::move(buffer));
+                    m_buffers_written.fetch_add(1, std::memory_order_relaxed);
                 }
             }
 
@@ -159,6 +224,9 @@ namespace osmium {
 
                 try {
                     func(std::forward<TArgs>(args)...);
+                    if (m_sync_writer) {
+                        m_sync_writer->write_available();
+                    }
                 } catch (...) {
                     m_status = status::error;
                     detail::add_to_queue(m_output_queue, std::current_exception());
@@ -171,6 +239,7 @@ namespace osmium {
                 osmium::io::Header header;
                 overwrite allow_overwrite = overwrite::no;
                 fsync sync = fsync::no;
+                osmium::io::append append_mode = osmium::io::append::no;
                 osmium::thread::Pool* pool = nullptr;
             };
 
@@ -190,6 +259,10 @@ namespace osmium {
                 options.sync = value;
             }
 
+            static void set_option(options_type& options, osmium::io::append value) {
+                options.append_mode = value;
+            }
+
             void do_close() {
                 if (m_status == status::okay) {
                     ensure_cleanup([&](){
@@ -201,6 +274,15 @@ namespace osmium {
                 }
             }
 
+            // In synchronous mode write everything that is left and close
+            // the compressor. This sets the write future.
+            void finish_synchronous_write() {
+                if (m_sync_writer) {
+                    m_sync_writer->run();
+                    m_sync_writer.reset();
+                }
+            }
+
         public:
 
             /**
@@ -223,6 +305,14 @@ namespace osmium {
              *       before closing it? Can be osmium::io::fsync::yes or
              *       osmium::io::fsync::no (default).
              *
+             * * osmium::io::append: Append to an existing file? Can be
+             *       osmium::io::append::yes or osmium::io::append::no
+             *       (default). If the file exists and is not empty, the
+             *       header is not written again. This only works for
+             *       uncompressed PBF and OPL files. Use it together with
+             *       truncate_pbf_file() to continue writing a PBF file
+             *       after a crash (see Reader::checkpoint()).
+             *
              * * osmium::thread::Pool&: Reference to a thread pool that should
              *      be used for writing instead of the default pool. Usually
              *      it is okay to use the statically initialized shared
@@ -230,6 +320,23 @@ namespace osmium {
              *      For instance when your program will fork, using the
              *      statically initialized pool will not work.
              *
+             * Two options on the file influence how the data is written:
+             * "write_batch_size" sets the number of bytes of encoded
+             * blocks which are already available that are written together
+             * (with writev(2) for uncompressed files, default 1 MB, 0
+             * writes every block on its own). "write_behind" (uncompressed
+             * files on Linux only) starts writeback to disk after every this
+             * many bytes and drops the data written before from the page
+             * cache. If "parallel_compression" is set, gzip and bzip2
+             * compressed output is compressed in independent blocks on the
+             * threads of the pool. The result is a valid file made of
+             * several gzip members or bzip2 streams. If "synchronous" is
+             * set, no threads are used at all: All data is encoded,
+             * compressed, and written in the calling thread. This has less
+             * overhead when writing small files. The "synchronous" option
+             * is ignored if OSMIUM_USE_LOCKFREE_QUEUE is defined, because
+             * the LockFreeQueue can not be unlimited in size.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
@@ -243,28 +350,68 @@ namespace osmium {
                     (set_option(options, args), 0)...
                 };
 
+                const bool appending = options.append_mode == osmium::io::append::yes;
+                if (appending &&
+                    ((m_file.format() != file_format::pbf && m_file.format() != file_format::opl) ||
+                     m_file.compression() != file_compression::none ||
+                     m_file.filename().empty() ||
+                     m_file.filename() == "-")) {
+                    throw io_error{"Appending is only supported for uncompressed PBF and OPL files"};
+                }
+
                 if (!options.pool) {
                     options.pool = &thread::Pool::default_instance();
                 }
 
                 m_output = osmium::io::detail::OutputFormatFactory::instance().create_output(*options.pool, m_file, m_output_queue);
+                if (m_synchronous) {
+                    m_output->set_synchronous();
+                }
 
                 if (options.header.get("generator").empty()) {
                     options.header.set("generator", "libosmium/" LIBOSMIUM_VERSION_STRING);
                 }
 
-                std::unique_ptr<osmium::io::Compressor> compressor =
-                    CompressionFactory::instance().create_compressor(file.compression(),
-                                                                     osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite),
-                                                                     options.sync);
+                const int fd = appending ? osmium::io::detail::open_for_appending(m_file.filename())
+                                         : osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite);
+                const bool needs_header = !appending || osmium::file_size(fd) == 0;
+
+                // The io_uring compressor and write behind work with
+                // offsets counted from the beginning of the file, so they
+                // are not used when appending.
+                std::unique_ptr<osmium::io::Compressor> compressor;
+                if (!appending) {
+                    compressor = osmium::io::detail::create_uring_compressor(m_file, fd, options.sync);
+                }
+                if (!compressor && !m_synchronous && m_file.is_true("parallel_compression")) {
+                    compressor = CompressionFactory::instance().create_parallel_compressor(file.compression(), fd, options.sync, *options.pool);
+                }
+                if (!compressor) {
+                    compressor = CompressionFactory::instance().create_compressor(file.compression(), fd, options.sync);
+                }
+
+                const std::string write_behind = m_file.get("write_behind");
+                if (!write_behind.empty() && !appending) {
+                    compressor->set_write_behind(osmium::detail::str_to_int<std::size_t>(write_behind.c_str()));
+                }
+
+                const std::string batch_size = m_file.get("write_batch_size");
+                const std::size_t write_batch_size = batch_size.empty() ? std::size_t(default_write_batch_size)
+                                                                        : osmium::detail::str_to_int<std::size_t>(batch_size.c_str());
 
                 std::promise<std::size_t> write_promise;
                 m_write_future = write_promise.get_future();
-                m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise)};
+                if (m_synchronous) {
+                    m_sync_writer.reset(new detail::WriteThread{m_output_queue, std::move(compressor), std::move(write_promise), write_batch_size, &m_bytes_written});
+                } else {
+                    m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise), write_batch_size, &m_bytes_written};
+                }
 
-                ensure_cleanup([&](){
-                    m_output->write_header(options.header);
-                });
+                if (needs_header) {
+                    ensure_cleanup([&](){
+                        m_output->write_header(options.header);
+                    });
+                }
             }
 
             template <typename... TArgs>
@@ -289,6 +436,11 @@ namespace osmium {
                 } catch (...) {
                     // Ignore any exceptions because destructor must not throw.
                 }
+                try {
+                    finish_synchronous_write();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
             }
 
             /**
@@ -334,6 +486,23 @@ namespace osmium {
                 });
             }
 
+            /**
+             * Write contents of a shared buffer to the output file. The
+             * buffer is not changed and can be written to several Writers
+             * at the same time (or be used otherwise) without copying it.
+             * It must not be modified until all Writers it was given to
+             * are closed.
+             *
+             * @param buffer Buffer that is being written out.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void operator()(const std::shared_ptr<const osmium::memory::Buffer>& buffer) {
+                ensure_cleanup([&](){
+                    do_flush();
+                    do_write(buffer);
+                });
+            }
+
             /**
              * Add item to the internal buffer for eventual writing to the
              * output file.
@@ -356,6 +525,32 @@ namespace osmium {
                 });
             }
 
+            /**
+             * Write data that is already encoded in the format of the
+             * output file. It is written after everything written before
+             * without looking at it further. For PBF files this must be
+             * one or more complete OSMData blobs, each with its BlobHeader
+             * and the size of the BlobHeader in front, for instance as
+             * created by the PBF output on another machine or as read from
+             * another PBF file. Only the framing is checked, it is up to
+             * the caller to make sure the blobs fit to the header and
+             * options of this file. This way PBF files encoded in parts
+             * can be assembled without decoding and encoding them again.
+             * Only the PBF format supports this.
+             *
+             * @param data The encoded data.
+             * @throws osmium::io_error If the format doesn't support this.
+             * @throws osmium::pbf_error If the PBF data is not valid.
+             */
+            void write_encoded(std::string&& data) {
+                ensure_cleanup([&](){
+                    do_flush();
+                    if (!data.empty()) {
+                        m_output->write_encoded(std::move(data));
+                    }
+                });
+            }
+
             /**
              * Flushes internal buffer and closes output file. If you do not
              * call this, the destructor of Writer will also do the same
@@ -369,6 +564,7 @@ namespace osmium {
              */
             std::size_t close() {
                 do_close();
+                finish_synchronous_write();
 
                 if (m_write_future.valid()) {
                     return m_write_future.get();
@@ -377,6 +573,21 @@ namespace osmium {
                 return 0;
             }
 
+            /**
+             * Get a snapshot of the statistics of this Writer. This can be
+             * called from any thread while the Writer exists. The stats of
+             * the thread pool used for encoding are available from the
+             * pool.
+             */
+            writer_stats stats() const {
+                writer_stats stats;
+                stats.buffers = m_buffers_written.load(std::memory_order_relaxed);
+                stats.bytes_written = m_bytes_written.load(std::memory_order_relaxed);
+                stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start_time);
+                stats.output_queue = m_output_queue.stats();
+                return stats;
+            }
+
         }; // class Writer
 
     } // namespace io
@@ -53,6 +53,15 @@ namespace osmium {
             yes = true
         };
 
+        /**
+         * Should writer append to an existing file instead of creating a
+         * new one?
+         */
+        enum class append : bool {
+            no  = false,
+            yes = true
+        };
+
     } // namespace io
 
 } // namespace osmium
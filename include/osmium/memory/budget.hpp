@@ -0,0 +1,382 @@
+#ifndef OSMIUM_MEMORY_BUDGET_HPP
+#define OSMIUM_MEMORY_BUDGET_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Exception thrown by MemoryBudget::check() if more memory is used
+     * than the budget allows. The message contains a report of the memory
+     * used by all registered accounts.
+     */
+    struct memory_budget_exceeded : public std::runtime_error {
+
+        explicit memory_budget_exceeded(const std::string& what) :
+            std::runtime_error{what} {
+        }
+
+    }; // struct memory_budget_exceeded
+
+    namespace memory {
+
+        /**
+         * A memory budget shared by several components of a program, for
+         * instance queues, item stashes, and indexes. Each component gets
+         * an account from the budget and reports how much memory it uses
+         * through it. Components react to the budget in different ways:
+         *
+         * * Queues (see osmium::thread::Queue::set_memory_budget() and the
+         *   Reader) block producers while the budget is exhausted. This
+         *   gives backpressure, for instance the Reader stops decoding
+         *   data until buffers are taken out of the queue or memory is
+         *   freed elsewhere.
+         * * The ItemStash (see ItemStash::set_memory_budget()) spills
+         *   data to disk while the budget is exhausted.
+         * * Other components (like index maps) can report their memory
+         *   use with account::set() and call check() to fail fast with a
+         *   report of where the memory went.
+         *
+         * All functions are thread safe. The budget must outlive all
+         * accounts created from it.
+         *
+         * Example:
+         * @code
+         *     osmium::memory::MemoryBudget budget{4UL * 1024 * 1024 * 1024};
+         *     osmium::io::Reader reader{"input.osm.pbf", budget};
+         *     auto index_account = budget.add_account("location index");
+         *     while (osmium::memory::Buffer buffer = reader.read()) {
+         *         ...handle buffer...
+         *         index_account.set(index.used_memory());
+         *         budget.check();
+         *     }
+         * @endcode
+         */
+        class MemoryBudget {
+
+            struct account_info {
+                std::string name;
+                std::size_t used = 0;
+                bool active = true;
+
+                explicit account_info(std::string&& n) :
+                    name(std::move(n)) {
+                }
+            };
+
+            mutable std::mutex m_mutex;
+            std::vector<account_info> m_accounts;
+            std::size_t m_limit;
+            std::size_t m_used = 0;
+            std::size_t m_peak = 0;
+
+            // Must be called with the mutex locked.
+            void change(std::size_t num, std::size_t used) noexcept {
+                m_used = m_used - m_accounts[num].used + used;
+                m_accounts[num].used = used;
+                if (m_used > m_peak) {
+                    m_peak = m_used;
+                }
+            }
+
+            void set_used(std::size_t num, std::size_t used) noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                change(num, used);
+            }
+
+            void add_used(std::size_t num, std::size_t bytes) noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                change(num, m_accounts[num].used + bytes);
+            }
+
+            bool try_add_used(std::size_t num, std::size_t bytes) noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_used + bytes > m_limit) {
+                    return false;
+                }
+                change(num, m_accounts[num].used + bytes);
+                return true;
+            }
+
+            void sub_used(std::size_t num, std::size_t bytes) noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                const std::size_t used = m_accounts[num].used;
+                change(num, bytes < used ? used - bytes : 0);
+            }
+
+            std::size_t account_used(std::size_t num) const noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_accounts[num].used;
+            }
+
+            void remove_account(std::size_t num) noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                change(num, 0);
+                m_accounts[num].active = false;
+            }
+
+        public:
+
+            /**
+             * An account in a MemoryBudget. Components report the memory
+             * they use through it. Accounts can be moved but not copied.
+             * When an account is destroyed, its memory is given back to
+             * the budget.
+             *
+             * A default constructed account doesn't belong to any budget,
+             * all functions on it do nothing and try_add() always succeeds.
+             */
+            class account {
+
+                MemoryBudget* m_budget = nullptr;
+                std::size_t m_num = 0;
+
+                friend class MemoryBudget;
+
+                account(MemoryBudget* budget, std::size_t num) noexcept :
+                    m_budget(budget),
+                    m_num(num) {
+                }
+
+            public:
+
+                account() noexcept = default;
+
+                account(const account&) = delete;
+                account& operator=(const account&) = delete;
+
+                account(account&& other) noexcept :
+                    m_budget(other.m_budget),
+                    m_num(other.m_num) {
+                    other.m_budget = nullptr;
+                }
+
+                account& operator=(account&& other) noexcept {
+                    if (this != &other) {
+                        reset();
+                        m_budget = other.m_budget;
+                        m_num = other.m_num;
+                        other.m_budget = nullptr;
+                    }
+                    return *this;
+                }
+
+                ~account() noexcept {
+                    reset();
+                }
+
+                /**
+                 * Give back all memory of this account to the budget and
+                 * detach it from the budget.
+                 */
+                void reset() noexcept {
+                    if (m_budget) {
+                        m_budget->remove_account(m_num);
+                        m_budget = nullptr;
+                    }
+                }
+
+                /**
+                 * Is this account attached to a budget?
+                 */
+                bool valid() const noexcept {
+                    return m_budget != nullptr;
+                }
+
+                /// The budget this account belongs to (or nullptr).
+                MemoryBudget* budget() const noexcept {
+                    return m_budget;
+                }
+
+                /**
+                 * Set the memory used by the component to the given
+                 * number of bytes. This never blocks or fails, even if the
+                 * budget is exceeded afterwards.
+                 */
+                void set(std::size_t bytes) noexcept {
+                    if (m_budget) {
+                        m_budget->set_used(m_num, bytes);
+                    }
+                }
+
+                /**
+                 * Add bytes to the memory used by the component. This
+                 * never blocks or fails, even if the budget is exceeded
+                 * afterwards.
+                 */
+                void add(std::size_t bytes) noexcept {
+                    if (m_budget) {
+                        m_budget->add_used(m_num, bytes);
+                    }
+                }
+
+                /**
+                 * Add bytes to the memory used by the component if this
+                 * doesn't exceed the budget.
+                 *
+                 * @returns true if the bytes were added, false otherwise.
+                 */
+                bool try_add(std::size_t bytes) noexcept {
+                    return !m_budget || m_budget->try_add_used(m_num, bytes);
+                }
+
+                /**
+                 * Subtract bytes from the memory used by the component.
+                 */
+                void sub(std::size_t bytes) noexcept {
+                    if (m_budget) {
+                        m_budget->sub_used(m_num, bytes);
+                    }
+                }
+
+                /// The number of bytes currently used by this account.
+                std::size_t used() const noexcept {
+                    return m_budget ? m_budget->account_used(m_num) : 0;
+                }
+
+            }; // class account
+
+            /**
+             * Create a memory budget.
+             *
+             * @param limit The maximum number of bytes all accounts
+             *              together should use.
+             */
+            explicit MemoryBudget(std::size_t limit) noexcept :
+                m_limit(limit) {
+            }
+
+            MemoryBudget(const MemoryBudget&) = delete;
+            MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+            MemoryBudget(MemoryBudget&&) = delete;
+            MemoryBudget& operator=(MemoryBudget&&) = delete;
+
+            ~MemoryBudget() noexcept = default;
+
+            /**
+             * Create a new account in this budget.
+             *
+             * @param name Name of the component using this account. This
+             *             is used in the report.
+             */
+            account add_account(std::string name) {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_accounts.emplace_back(std::move(name));
+                return account{this, m_accounts.size() - 1};
+            }
+
+            /// The maximum number of bytes that should be used.
+            std::size_t limit() const noexcept {
+                return m_limit;
+            }
+
+            /// The number of bytes currently used by all accounts.
+            std::size_t used() const noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_used;
+            }
+
+            /// The highest number of bytes ever used by all accounts.
+            std::size_t peak() const noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_peak;
+            }
+
+            /// The number of bytes available before the limit is reached.
+            std::size_t available() const noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_used < m_limit ? m_limit - m_used : 0;
+            }
+
+            /// Is more memory used than the budget allows?
+            bool exceeded() const noexcept {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_used > m_limit;
+            }
+
+            /**
+             * Get a report of the memory used by all accounts that are
+             * still active. Looks like this:
+             * "memory budget 1000 bytes, used 1200 bytes (peak 1300): reader 800, item_stash 400"
+             */
+            std::string report() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                std::string result{"memory budget "};
+                result += std::to_string(m_limit);
+                result += " bytes, used ";
+                result += std::to_string(m_used);
+                result += " bytes (peak ";
+                result += std::to_string(m_peak);
+                result += ')';
+                char sep = ':';
+                for (const auto& info : m_accounts) {
+                    if (info.active) {
+                        result += sep;
+                        result += ' ';
+                        result += info.name;
+                        result += ' ';
+                        result += std::to_string(info.used);
+                        sep = ',';
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * Check that the budget isn't exceeded.
+             *
+             * @throws osmium::memory_budget_exceeded if more memory is
+             *         used than the budget allows. The message contains
+             *         the report().
+             */
+            void check() const {
+                if (exceeded()) {
+                    throw osmium::memory_budget_exceeded{report()};
+                }
+            }
+
+        }; // class MemoryBudget
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUDGET_HPP
@@ -33,19 +33,23 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/memory/buffer_allocator.hpp>
 #include <osmium/memory/item.hpp>
 #include <osmium/memory/item_iterator.hpp>
 #include <osmium/osm/entity.hpp>
+#include <osmium/osm/item_type.hpp>
 #include <osmium/util/compatibility.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <iterator>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <utility>
 
 namespace osmium {
@@ -68,6 +72,31 @@ namespace osmium {
      */
     namespace memory {
 
+        namespace detail {
+
+            /**
+             * Calculate a 64 bit checksum over the given data. This is not
+             * a cryptographic hash, it is used to detect changes to buffer
+             * contents. The data is processed in 8 byte words, so this is
+             * much cheaper than any kind of encoding of the data.
+             */
+            inline uint64_t checksum(const unsigned char* data, std::size_t size) noexcept {
+                uint64_t hash = 0x9e3779b97f4a7c15ULL ^ size;
+                std::size_t i = 0;
+                for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+                    uint64_t word = 0;
+                    std::memcpy(&word, data + i, sizeof(uint64_t));
+                    hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+                    hash ^= hash >> 32U;
+                }
+                for (; i < size; ++i) {
+                    hash = (hash ^ data[i]) * 0x100000001b3ULL;
+                }
+                return hash;
+            }
+
+        } // namespace detail
+
         /**
          * A memory area for storing OSM objects and other items. Each item stored
          * has a type and a length. See the Item class for details.
@@ -110,7 +139,7 @@ namespace osmium {
         private:
 
             std::unique_ptr<Buffer> m_next_buffer;
-            std::unique_ptr<unsigned char[]> m_memory{};
+            buffer_memory m_memory{};
             unsigned char* m_data = nullptr;
             std::size_t m_capacity = 0;
             std::size_t m_written = 0;
@@ -119,7 +148,11 @@ namespace osmium {
             uint8_t m_builder_count = 0;
 #endif
             auto_grow m_auto_grow{auto_grow::no};
+            osmium::item_type m_content_type = osmium::item_type::undefined;
             std::function<void(Buffer&)> m_full;
+            std::shared_ptr<const std::string> m_source_data;
+            uint64_t m_source_checksum = 0;
+            std::size_t m_input_end_offset = 0;
 
             static std::size_t calculate_capacity(std::size_t capacity) noexcept {
                 enum {
@@ -133,17 +166,30 @@ namespace osmium {
                 return padded_length(capacity);
             }
 
-            void grow_internal() {
+            // Move the committed data into a nested buffer and continue
+            // with a new memory block that is large enough for the
+            // uncommitted data plus the given number of bytes. Only the
+            // uncommitted data is copied and it is copied only once, the
+            // committed data stays where it is.
+            void grow_internal(std::size_t size) {
                 assert(m_data && "This must be a valid buffer");
                 if (!m_memory) {
                     throw std::logic_error{"Can't grow Buffer if it doesn't use internal memory management."};
                 }
 
+                const std::size_t uncommitted = m_written - m_committed;
+                std::size_t new_capacity = m_capacity;
+                while (uncommitted + size > new_capacity) {
+                    new_capacity *= 2;
+                }
+
+                BufferAllocator& allocator = m_memory.get_deleter().allocator();
                 std::unique_ptr<Buffer> old{new Buffer{std::move(m_memory), m_capacity, m_committed}};
-                m_memory = std::unique_ptr<unsigned char[]>{new unsigned char[m_capacity]};
+                m_memory = allocate_buffer_memory(allocator, new_capacity);
                 m_data = m_memory.get();
+                m_capacity = new_capacity;
 
-                m_written -= m_committed;
+                m_written = uncommitted;
                 std::copy_n(old->data() + m_committed, m_written, m_data);
                 m_committed = 0;
 
@@ -223,18 +269,43 @@ namespace osmium {
              *             The Buffer will manage this memory.
              * @param capacity The size of the memory for this buffer.
              * @param committed The size of the initialized data. If this is 0, the buffer startes out empty.
+             * @param auto_grow Should this buffer automatically grow when it
+             *        becomes to small?
+             *
+             * @throws std::invalid_argument if the capacity or committed isn't
+             *         a multiple of the alignment or if committed is larger
+             *         than capacity.
+             */
+            explicit Buffer(std::unique_ptr<unsigned char[]> data, std::size_t capacity, std::size_t committed, auto_grow auto_grow = auto_grow::no) :
+                Buffer(buffer_memory{data.release(), detail::buffer_memory_deleter{default_buffer_allocator(), capacity}}, capacity, committed, auto_grow) {
+            }
+
+            /**
+             * Constructs a valid internally memory-managed buffer with the
+             * given capacity that already contains 'committed' bytes of data.
+             * When the buffer grows, new memory is taken from the allocator
+             * the memory came from.
+             *
+             * @param data Memory from a BufferAllocator (see
+             *             allocate_buffer_memory()). The Buffer will manage
+             *             this memory.
+             * @param capacity The size of the memory for this buffer.
+             * @param committed The size of the initialized data. If this is 0, the buffer startes out empty.
+             * @param auto_grow Should this buffer automatically grow when it
+             *        becomes to small?
              *
              * @throws std::invalid_argument if the capacity or committed isn't
              *         a multiple of the alignment or if committed is larger
              *         than capacity.
              */
-            explicit Buffer(std::unique_ptr<unsigned char[]> data, std::size_t capacity, std::size_t committed) :
+            explicit Buffer(buffer_memory data, std::size_t capacity, std::size_t committed, auto_grow auto_grow = auto_grow::no) :
                 m_next_buffer(),
                 m_memory(std::move(data)),
                 m_data(m_memory.get()),
                 m_capacity(capacity),
                 m_written(committed),
-                m_committed(committed) {
+                m_committed(committed),
+                m_auto_grow(auto_grow) {
                 if (capacity % align_bytes != 0) {
                     throw std::invalid_argument{"buffer capacity needs to be multiple of alignment"};
                 }
@@ -259,8 +330,24 @@ namespace osmium {
              *        becomes to small?
              */
             explicit Buffer(std::size_t capacity, auto_grow auto_grow = auto_grow::yes) :
+                Buffer(capacity, auto_grow, default_buffer_allocator()) {
+            }
+
+            /**
+             * Constructs a valid internally memory-managed buffer with the
+             * given capacity getting its memory from the given allocator.
+             * This memory and any memory needed when the buffer grows is
+             * returned to the allocator when the Buffer is destroyed.
+             *
+             * @param capacity The (initial) size of the memory for this buffer.
+             *        Actual capacity might be larger tue to alignment.
+             * @param auto_grow Should this buffer automatically grow when it
+             *        becomes to small?
+             * @param allocator The allocator. It must outlive the buffer.
+             */
+            Buffer(std::size_t capacity, auto_grow auto_grow, BufferAllocator& allocator) :
                 m_next_buffer(),
-                m_memory(new unsigned char[calculate_capacity(capacity)]),
+                m_memory(allocate_buffer_memory(allocator, calculate_capacity(capacity))),
                 m_data(m_memory.get()),
                 m_capacity(calculate_capacity(capacity)),
                 m_auto_grow(auto_grow) {
@@ -282,7 +369,11 @@ namespace osmium {
                 m_builder_count(other.m_builder_count),
 #endif
                 m_auto_grow(other.m_auto_grow),
-                m_full(std::move(other.m_full)) {
+                m_content_type(other.m_content_type),
+                m_full(std::move(other.m_full)),
+                m_source_data(std::move(other.m_source_data)),
+                m_source_checksum(other.m_source_checksum),
+                m_input_end_offset(other.m_input_end_offset) {
                 other.m_data = nullptr;
                 other.m_capacity = 0;
                 other.m_written = 0;
@@ -303,7 +394,11 @@ namespace osmium {
                 m_builder_count = other.m_builder_count;
 #endif
                 m_auto_grow = other.m_auto_grow;
+                m_content_type = other.m_content_type;
                 m_full = std::move(other.m_full);
+                m_source_data = std::move(other.m_source_data);
+                m_source_checksum = other.m_source_checksum;
+                m_input_end_offset = other.m_input_end_offset;
                 other.m_data = nullptr;
                 other.m_capacity = 0;
                 other.m_written = 0;
@@ -419,10 +514,10 @@ namespace osmium {
                 }
                 size = calculate_capacity(size);
                 if (m_capacity < size) {
-                    std::unique_ptr<unsigned char[]> memory{new unsigned char[size]};
-                    std::copy_n(m_memory.get(), m_capacity, memory.get());
-                    using std::swap;
-                    swap(m_memory, memory);
+                    BufferAllocator& allocator = m_memory.get_deleter().allocator();
+                    unsigned char* memory = allocator.reallocate(m_memory.get(), m_capacity, m_written, size);
+                    (void)m_memory.release();
+                    m_memory = buffer_memory{memory, detail::buffer_memory_deleter{allocator, size}};
                     m_data = m_memory.get();
                     m_capacity = size;
                 }
@@ -453,6 +548,25 @@ namespace osmium {
                 return std::move(buffer->m_next_buffer);
             }
 
+            /**
+             * Take the memory out of an internally memory-managed buffer so
+             * that it can be reused for another buffer. The deleter of the
+             * returned memory knows its size and the allocator it came from.
+             * The buffer is invalid afterwards, any nested buffers are
+             * destroyed.
+             *
+             * @pre No builder can be open on this buffer.
+             *
+             * @returns The memory or nullptr if this buffer is invalid or
+             *          doesn't use internal memory management.
+             */
+            buffer_memory release_memory() noexcept {
+                assert(m_builder_count == 0 && "Make sure there are no Builder objects still in scope");
+                buffer_memory memory{std::move(m_memory)};
+                *this = Buffer{};
+                return memory;
+            }
+
             /**
              * Mark currently written bytes in the buffer as committed.
              *
@@ -472,9 +586,85 @@ namespace osmium {
 
                 const std::size_t offset = m_committed;
                 m_committed = m_written;
+                m_content_type = osmium::item_type::undefined;
+                m_source_data.reset();
                 return offset;
             }
 
+            /**
+             * Mark the buffer as containing only OSM objects of the given
+             * type. Usually done by the input format decoders, so
+             * osmium::apply() can use a loop specialized for this type.
+             * The mark is removed on the next commit() or clear().
+             *
+             * @pre All committed items in the buffer must be of the given
+             *      type (osmium::item_type::node, way, or relation).
+             */
+            void set_content_type(osmium::item_type type) noexcept {
+                m_content_type = type;
+            }
+
+            /**
+             * The type of all objects in this buffer as set with
+             * set_content_type() or osmium::item_type::undefined if the
+             * buffer isn't marked as containing only one type of object.
+             */
+            osmium::item_type content_type() const noexcept {
+                return m_content_type;
+            }
+
+            /**
+             * Attach the encoded data this buffer was decoded from. Usually
+             * done by the input format decoders, so an output format
+             * writing the same format can copy the data instead of encoding
+             * the objects again. A checksum of the committed data is
+             * calculated, so later changes to the objects in the buffer can
+             * be detected by source_data_unchanged(). The data is removed on
+             * the next commit(), clear(), or purge_removed().
+             *
+             * @pre The buffer must be valid.
+             */
+            void set_source_data(std::shared_ptr<const std::string> data) noexcept {
+                assert(m_data && "This must be a valid buffer");
+                m_source_data = std::move(data);
+                m_source_checksum = detail::checksum(m_data, m_committed);
+            }
+
+            /**
+             * The encoded data set with set_source_data() or nullptr.
+             */
+            const std::shared_ptr<const std::string>& source_data() const noexcept {
+                return m_source_data;
+            }
+
+            /**
+             * Is there source data and do the committed contents of the
+             * buffer still match it? This calculates the checksum of the
+             * buffer contents, so it is linear in the size of the buffer.
+             */
+            bool source_data_unchanged() const noexcept {
+                return m_source_data && detail::checksum(m_data, m_committed) == m_source_checksum;
+            }
+
+            /**
+             * Set the offset in the input just after the data this buffer
+             * was decoded from. Usually done by the input format decoders
+             * which know where their blocks end, so the Reader can tell
+             * from where reading can be resumed (see Reader::checkpoint()).
+             * The offset is removed on the next clear().
+             */
+            void set_input_end_offset(const std::size_t offset) noexcept {
+                m_input_end_offset = offset;
+            }
+
+            /**
+             * The offset set with set_input_end_offset() or 0 if it is not
+             * known.
+             */
+            std::size_t input_end_offset() const noexcept {
+                return m_input_end_offset;
+            }
+
             /**
              * Roll back changes in buffer to last committed state.
              *
@@ -501,6 +691,9 @@ namespace osmium {
                 const std::size_t committed = m_committed;
                 m_written = 0;
                 m_committed = 0;
+                m_content_type = osmium::item_type::undefined;
+                m_source_data.reset();
+                m_input_end_offset = 0;
                 return committed;
             }
 
@@ -566,7 +759,7 @@ namespace osmium {
                         throw osmium::buffer_is_full{};
                     }
                     if (m_auto_grow == auto_grow::internal && m_committed != 0) {
-                        grow_internal();
+                        grow_internal(size);
                     }
                     if (m_written + size > m_capacity) {
                         // double buffer size until there is enough space
@@ -831,7 +1024,11 @@ namespace osmium {
                 swap(m_written, other.m_written);
                 swap(m_committed, other.m_committed);
                 swap(m_auto_grow, other.m_auto_grow);
+                swap(m_content_type, other.m_content_type);
                 swap(m_full, other.m_full);
+                swap(m_source_data, other.m_source_data);
+                swap(m_source_checksum, other.m_source_checksum);
+                swap(m_input_end_offset, other.m_input_end_offset);
             }
 
             /**
@@ -878,6 +1075,7 @@ namespace osmium {
                 assert(it_write.data() >= data());
                 m_written = static_cast<std::size_t>(it_write.data() - data());
                 m_committed = m_written;
+                m_source_data.reset();
             }
 
         }; // class Buffer
@@ -0,0 +1,264 @@
+#ifndef OSMIUM_MEMORY_BUFFER_ALLOCATOR_HPP
+#define OSMIUM_MEMORY_BUFFER_ALLOCATOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * Interface for allocators providing the memory for internally
+         * memory-managed Buffers. Implement this to get Buffer memory from
+         * a custom source like a per-thread malloc arena, a pool of huge
+         * pages, or a shared memory region.
+         *
+         * The allocator must outlive all buffers using memory from it.
+         * If buffers are created in one thread and destroyed in another
+         * (which is the case when reading files), the allocator must be
+         * thread safe.
+         */
+        class BufferAllocator {
+
+        public:
+
+            BufferAllocator() noexcept = default;
+
+            BufferAllocator(const BufferAllocator&) = delete;
+            BufferAllocator& operator=(const BufferAllocator&) = delete;
+
+            BufferAllocator(BufferAllocator&&) = delete;
+            BufferAllocator& operator=(BufferAllocator&&) = delete;
+
+            virtual ~BufferAllocator() noexcept = default;
+
+            /**
+             * Allocate memory for a buffer.
+             *
+             * @param size The number of bytes needed. Always a multiple of
+             *             the buffer alignment.
+             * @returns Pointer to the memory. It must be aligned to at least
+             *          osmium::memory::align_bytes.
+             * @throws std::bad_alloc (or any other exception) if the memory
+             *         could not be allocated.
+             */
+            virtual unsigned char* allocate(std::size_t size) = 0;
+
+            /**
+             * Free memory allocated with allocate() or reallocate().
+             *
+             * @param data Pointer to the memory.
+             * @param size The size that was used when allocating.
+             */
+            virtual void deallocate(unsigned char* data, std::size_t size) noexcept = 0;
+
+            /**
+             * Grow memory allocated with allocate() or reallocate(). The
+             * default implementation allocates new memory, copies the used
+             * data over, and frees the old memory.
+             *
+             * @param data Pointer to the memory.
+             * @param old_size The size that was used when allocating.
+             * @param used The number of bytes at the beginning of the memory
+             *             that must be retained.
+             * @param new_size The new size needed.
+             * @returns Pointer to the new memory. The old memory must not
+             *          be used any more.
+             * @throws std::bad_alloc (or any other exception) if the memory
+             *         could not be allocated. The old memory is still valid
+             *         in this case.
+             */
+            virtual unsigned char* reallocate(unsigned char* data, std::size_t old_size, std::size_t used, std::size_t new_size) {
+                unsigned char* new_data = allocate(new_size);
+                std::copy_n(data, used, new_data);
+                deallocate(data, old_size);
+                return new_data;
+            }
+
+        }; // class BufferAllocator
+
+        /**
+         * The default BufferAllocator getting memory from new[] and
+         * returning it with delete[].
+         */
+        class NewDeleteBufferAllocator final : public BufferAllocator {
+
+        public:
+
+            unsigned char* allocate(std::size_t size) final {
+                return new unsigned char[size];
+            }
+
+            void deallocate(unsigned char* data, std::size_t /*size*/) noexcept final {
+                delete[] data;
+            }
+
+        }; // class NewDeleteBufferAllocator
+
+        /**
+         * A BufferAllocator counting the bytes currently allocated by all
+         * buffers using it. The memory itself is taken from another
+         * allocator. Use it with a BufferPool given to the Reader to see
+         * how much memory the buffers in flight take. This allocator is
+         * thread safe if the underlying allocator is.
+         */
+        class CountingBufferAllocator final : public BufferAllocator {
+
+            BufferAllocator* m_allocator;
+            std::atomic<std::size_t> m_used{0};
+            std::atomic<std::size_t> m_peak{0};
+
+            void add(std::size_t size) noexcept {
+                const std::size_t used = m_used.fetch_add(size, std::memory_order_relaxed) + size;
+                std::size_t peak = m_peak.load(std::memory_order_relaxed);
+                while (used > peak && !m_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+                }
+            }
+
+        public:
+
+            /**
+             * Create the allocator.
+             *
+             * @param allocator The allocator the memory is taken from. It
+             *                  must outlive this allocator.
+             */
+            explicit CountingBufferAllocator(BufferAllocator& allocator) noexcept :
+                m_allocator(&allocator) {
+            }
+
+            /// Create the allocator taking memory from new[].
+            CountingBufferAllocator() noexcept;
+
+            unsigned char* allocate(std::size_t size) final {
+                unsigned char* data = m_allocator->allocate(size);
+                add(size);
+                return data;
+            }
+
+            void deallocate(unsigned char* data, std::size_t size) noexcept final {
+                m_allocator->deallocate(data, size);
+                m_used.fetch_sub(size, std::memory_order_relaxed);
+            }
+
+            unsigned char* reallocate(unsigned char* data, std::size_t old_size, std::size_t used, std::size_t new_size) final {
+                unsigned char* new_data = m_allocator->reallocate(data, old_size, used, new_size);
+                add(new_size);
+                m_used.fetch_sub(old_size, std::memory_order_relaxed);
+                return new_data;
+            }
+
+            /// The number of bytes currently allocated.
+            std::size_t used_memory() const noexcept {
+                return m_used.load(std::memory_order_relaxed);
+            }
+
+            /// The highest number of bytes ever allocated at the same time.
+            std::size_t peak_memory() const noexcept {
+                return m_peak.load(std::memory_order_relaxed);
+            }
+
+        }; // class CountingBufferAllocator
+
+        /**
+         * Get the allocator used by buffers when no other allocator is
+         * specified.
+         */
+        inline BufferAllocator& default_buffer_allocator() noexcept {
+            static NewDeleteBufferAllocator allocator;
+            return allocator;
+        }
+
+        inline CountingBufferAllocator::CountingBufferAllocator() noexcept :
+            m_allocator(&default_buffer_allocator()) {
+        }
+
+        namespace detail {
+
+            /**
+             * Deleter for memory from a BufferAllocator. It remembers the
+             * allocator and the size of the memory.
+             */
+            class buffer_memory_deleter {
+
+                BufferAllocator* m_allocator = &default_buffer_allocator();
+                std::size_t m_size = 0;
+
+            public:
+
+                buffer_memory_deleter() noexcept = default;
+
+                buffer_memory_deleter(BufferAllocator& allocator, std::size_t size) noexcept :
+                    m_allocator(&allocator),
+                    m_size(size) {
+                }
+
+                BufferAllocator& allocator() const noexcept {
+                    return *m_allocator;
+                }
+
+                std::size_t size() const noexcept {
+                    return m_size;
+                }
+
+                void operator()(unsigned char* data) const noexcept {
+                    m_allocator->deallocate(data, m_size);
+                }
+
+            }; // class buffer_memory_deleter
+
+        } // namespace detail
+
+        /**
+         * Memory for a buffer together with the information needed to
+         * free it.
+         */
+        using buffer_memory = std::unique_ptr<unsigned char[], detail::buffer_memory_deleter>;
+
+        /**
+         * Allocate memory for a buffer from the given allocator.
+         */
+        inline buffer_memory allocate_buffer_memory(BufferAllocator& allocator, std::size_t size) {
+            return buffer_memory{allocator.allocate(size), detail::buffer_memory_deleter{allocator, size}};
+        }
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_ALLOCATOR_HPP
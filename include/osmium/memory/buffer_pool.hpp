@@ -0,0 +1,209 @@
+#ifndef OSMIUM_MEMORY_BUFFER_POOL_HPP
+#define OSMIUM_MEMORY_BUFFER_POOL_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_allocator.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * A pool of memory taken from buffers that are not needed any more
+         * which can be used for new buffers. This avoids allocating and
+         * freeing large blocks of memory all the time when buffers are
+         * created and destroyed in a loop, which is what happens when
+         * reading OSM files.
+         *
+         * All functions are thread safe, so the pool can be shared between
+         * the threads creating buffers and those using them.
+         *
+         * Example:
+         * @code
+         *     osmium::memory::BufferPool buffer_pool;
+         *     osmium::io::Reader reader{"input.osm.pbf", buffer_pool};
+         *     while (osmium::memory::Buffer buffer = reader.read()) {
+         *         ...handle buffer...
+         *         buffer_pool.put(std::move(buffer));
+         *     }
+         * @endcode
+         */
+        class BufferPool {
+
+            enum {
+                default_max_buffers = 20
+            };
+
+            mutable std::mutex m_mutex;
+            std::vector<osmium::memory::buffer_memory> m_blocks;
+            std::size_t m_max_buffers;
+            osmium::memory::BufferAllocator* m_allocator;
+
+            void put_memory(osmium::memory::Buffer& buffer) {
+                osmium::memory::buffer_memory memory{buffer.release_memory()};
+                if (!memory) {
+                    return;
+                }
+
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_blocks.size() < m_max_buffers) {
+                    m_blocks.push_back(std::move(memory));
+                }
+            }
+
+        public:
+
+            /**
+             * Create a buffer pool.
+             *
+             * @param max_buffers The maximum number of buffers kept in the
+             *                    pool. Buffers handed to put() while the
+             *                    pool is full are freed.
+             */
+            explicit BufferPool(std::size_t max_buffers = default_max_buffers) :
+                m_max_buffers(max_buffers),
+                m_allocator(&osmium::memory::default_buffer_allocator()) {
+            }
+
+            /**
+             * Create a buffer pool getting new memory from the given
+             * allocator. Set this pool on a Reader to make the Reader and
+             * its parsers use the allocator for all buffers they create.
+             *
+             * @param allocator The allocator. It must outlive the pool and
+             *                  all buffers created by it.
+             * @param max_buffers The maximum number of buffers kept in the
+             *                    pool. Buffers handed to put() while the
+             *                    pool is full are freed.
+             */
+            explicit BufferPool(osmium::memory::BufferAllocator& allocator, std::size_t max_buffers = default_max_buffers) :
+                m_max_buffers(max_buffers),
+                m_allocator(&allocator) {
+            }
+
+            BufferPool(const BufferPool&) = delete;
+            BufferPool& operator=(const BufferPool&) = delete;
+
+            BufferPool(BufferPool&&) = delete;
+            BufferPool& operator=(BufferPool&&) = delete;
+
+            ~BufferPool() noexcept = default;
+
+            /**
+             * Get a new, empty buffer with at least the given capacity. If
+             * there is memory with enough capacity in the pool it is reused,
+             * otherwise a new buffer is allocated using the allocator of
+             * this pool.
+             *
+             * @param capacity The minimum capacity of the buffer.
+             * @param auto_grow Should the buffer automatically grow when it
+             *        becomes to small?
+             */
+            osmium::memory::Buffer get(std::size_t capacity, osmium::memory::Buffer::auto_grow auto_grow = osmium::memory::Buffer::auto_grow::yes) {
+                {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    // Search from the back, the most recently returned
+                    // memory is most likely to still be in the cache.
+                    for (auto it = m_blocks.rbegin(); it != m_blocks.rend(); ++it) {
+                        const std::size_t block_capacity = it->get_deleter().size();
+                        if (block_capacity >= capacity) {
+                            osmium::memory::buffer_memory memory{std::move(*it)};
+                            m_blocks.erase(std::next(it).base());
+                            return osmium::memory::Buffer{std::move(memory), block_capacity, 0, auto_grow};
+                        }
+                    }
+                }
+
+                return osmium::memory::Buffer{capacity, auto_grow, *m_allocator};
+            }
+
+            /**
+             * Put the memory of a buffer that isn't needed any more into the
+             * pool. The memory of nested buffers is added, too. Invalid
+             * buffers and buffers that don't use internal memory management
+             * are ignored.
+             *
+             * @param buffer The buffer. It will be invalid afterwards.
+             */
+            void put(osmium::memory::Buffer&& buffer) {
+                while (buffer.has_nested_buffers()) {
+                    std::unique_ptr<osmium::memory::Buffer> nested{buffer.get_last_nested()};
+                    put_memory(*nested);
+                }
+                put_memory(buffer);
+            }
+
+            /**
+             * The number of buffers currently in the pool.
+             */
+            std::size_t size() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_blocks.size();
+            }
+
+            /**
+             * The number of bytes of memory currently in the pool.
+             */
+            std::size_t used_memory() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                std::size_t bytes = 0;
+                for (const auto& block : m_blocks) {
+                    bytes += block.get_deleter().size();
+                }
+                return bytes;
+            }
+
+            /**
+             * Free all memory in the pool.
+             */
+            void clear() {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_blocks.clear();
+            }
+
+        }; // class BufferPool
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_POOL_HPP
@@ -66,6 +66,10 @@ namespace osmium {
          *     osmium::builder::add_node(cb.buffer(), _id(9), ...);
          *     osmium::builder::add_way(cb.buffer(), _id(27), ...);
          * @endcode
+         *
+         * The callback is called synchronously in the thread filling the
+         * buffer. Wrap it in an osmium::thread::AsyncCallback to have it
+         * called in another thread.
          */
         class CallbackBuffer {
 
@@ -0,0 +1,353 @@
+#ifndef OSMIUM_MEMORY_SHARED_BUFFER_RING_HPP
+#define OSMIUM_MEMORY_SHARED_BUFFER_RING_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * A ring of buffer slots in shared memory for handing Buffers from
+         * one process to other processes without copying or serializing
+         * them. This works because Buffers contain only position
+         * independent, aligned data.
+         *
+         * The ring lives in a file (for instance one created with
+         * memfd_create() on Linux or osmium::detail::create_tmp_file())
+         * which is mapped shared into all processes. Either create the
+         * ring before fork()ing the workers, they can keep using the same
+         * object, or open it with the SharedBufferRing(int fd) constructor
+         * in each process.
+         *
+         * The producer calls acquire_for_writing() to get a free slot,
+         * fills the Buffer returned by write_buffer() directly in shared
+         * memory, and hands it over with publish(). Consumers call
+         * acquire_for_reading() to claim a published slot, use the Buffer
+         * returned by read_buffer(), and call release() when they are done
+         * with it. The producer calls close() to mark the end of data.
+         *
+         * Buffers in the ring have a fixed size and can not grow. Objects
+         * larger than the slot size can not be handed over this way.
+         *
+         * Slots are claimed using lock-free atomics in the shared memory.
+         * Waiting is done by yielding the CPU.
+         */
+        class SharedBufferRing {
+
+            static_assert(ATOMIC_INT_LOCK_FREE == 2, "SharedBufferRing needs lock-free atomic ints");
+
+            enum : uint64_t {
+                // "OSMSBR" + version
+                magic = 0x4f534d5342520001ULL
+            };
+
+            enum : std::size_t {
+                // Offset of the slot data from the beginning of the
+                // mapping is rounded up to this.
+                data_alignment = 64
+            };
+
+            enum slot_state : uint32_t {
+                slot_free    = 0,
+                slot_writing = 1,
+                slot_ready   = 2,
+                slot_reading = 3
+            };
+
+            struct ring_header {
+                uint64_t magic;
+                uint64_t num_slots;
+                uint64_t slot_size;
+                std::atomic<uint32_t> closed;
+                uint32_t padding;
+            }; // struct ring_header
+
+            struct slot_header {
+                std::atomic<uint32_t> state;
+                uint32_t padding;
+                uint64_t committed;
+            }; // struct slot_header
+
+            osmium::util::MemoryMapping m_mapping;
+            std::size_t m_num_slots;
+            std::size_t m_slot_size;
+            std::size_t m_next_write = 0;
+            std::size_t m_next_read = 0;
+
+            static std::size_t data_offset(std::size_t num_slots) noexcept {
+                const std::size_t size = sizeof(ring_header) + num_slots * sizeof(slot_header);
+                return (size + data_alignment - 1) & ~(data_alignment - 1);
+            }
+
+            static std::size_t mapping_size(std::size_t num_slots, std::size_t slot_size) {
+                if (num_slots == 0) {
+                    throw std::invalid_argument{"SharedBufferRing needs at least one slot"};
+                }
+                if (slot_size == 0 || slot_size % align_bytes != 0) {
+                    throw std::invalid_argument{"SharedBufferRing slot size must be a multiple of the buffer alignment"};
+                }
+                if (slot_size > (std::numeric_limits<std::size_t>::max() - data_offset(num_slots)) / num_slots) {
+                    throw std::invalid_argument{"SharedBufferRing too large"};
+                }
+                return data_offset(num_slots) + num_slots * slot_size;
+            }
+
+            static std::size_t read_header_size(int fd) {
+                if (osmium::file_size(fd) < sizeof(ring_header)) {
+                    throw std::runtime_error{"Invalid shared buffer ring: file too short"};
+                }
+                return osmium::file_size(fd);
+            }
+
+            ring_header& header() const noexcept {
+                return *m_mapping.get_addr<ring_header>();
+            }
+
+            slot_header& slot(std::size_t n) const noexcept {
+                assert(n < m_num_slots);
+                return reinterpret_cast<slot_header*>(m_mapping.get_addr<ring_header>() + 1)[n];
+            }
+
+            unsigned char* slot_data(std::size_t n) const noexcept {
+                assert(n < m_num_slots);
+                return m_mapping.get_addr<unsigned char>() + data_offset(m_num_slots) + n * m_slot_size;
+            }
+
+            // Try to change the state of one slot from "from" to "to"
+            // checking all slots starting at cursor. Returns the slot
+            // or npos.
+            std::size_t claim(std::size_t& cursor, uint32_t from, uint32_t to) noexcept {
+                for (std::size_t i = 0; i < m_num_slots; ++i) {
+                    const std::size_t n = (cursor + i) % m_num_slots;
+                    uint32_t expected = from;
+                    if (slot(n).state.compare_exchange_strong(expected, to, std::memory_order_acquire, std::memory_order_relaxed)) {
+                        cursor = n + 1;
+                        return n;
+                    }
+                }
+                return npos;
+            }
+
+        public:
+
+            enum : std::size_t {
+                /// Returned by acquire_for_reading() at the end of data.
+                npos = std::numeric_limits<std::size_t>::max()
+            };
+
+            /**
+             * Create a new ring in the given file. The file is resized as
+             * needed and all slots are initialized as free.
+             *
+             * @param fd File descriptor of the file open for reading and
+             *           writing.
+             * @param num_slots Number of slots in the ring.
+             * @param slot_size Size of each slot in bytes. Must be a
+             *                  multiple of osmium::memory::align_bytes.
+             * @throws std::invalid_argument if the parameters are invalid.
+             * @throws std::system_error if the file could not be mapped.
+             */
+            SharedBufferRing(int fd, std::size_t num_slots, std::size_t slot_size) :
+                m_mapping(mapping_size(num_slots, slot_size), osmium::util::MemoryMapping::mapping_mode::write_shared, fd),
+                m_num_slots(num_slots),
+                m_slot_size(slot_size) {
+                auto* h = new (m_mapping.get_addr<void>()) ring_header{};
+                h->magic = magic;
+                h->num_slots = num_slots;
+                h->slot_size = slot_size;
+                h->closed.store(0, std::memory_order_relaxed);
+                for (std::size_t n = 0; n < num_slots; ++n) {
+                    auto* s = new (&slot(n)) slot_header{};
+                    s->state.store(slot_free, std::memory_order_relaxed);
+                    s->committed = 0;
+                }
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+
+            /**
+             * Open an existing ring created by another process.
+             *
+             * @param fd File descriptor of the file open for reading and
+             *           writing.
+             * @throws std::runtime_error if the file doesn't contain a
+             *         valid ring.
+             * @throws std::system_error if the file could not be mapped.
+             */
+            explicit SharedBufferRing(int fd) :
+                m_mapping(read_header_size(fd), osmium::util::MemoryMapping::mapping_mode::write_shared, fd),
+                m_num_slots(header().num_slots),
+                m_slot_size(header().slot_size) {
+                if (header().magic != magic) {
+                    throw std::runtime_error{"Invalid shared buffer ring: wrong type, version, or byte order"};
+                }
+                if (m_num_slots == 0 || m_slot_size == 0 || m_slot_size % align_bytes != 0 ||
+                    m_slot_size > (m_mapping.size() - data_offset(0)) / m_num_slots ||
+                    m_mapping.size() < data_offset(m_num_slots) + m_num_slots * m_slot_size) {
+                    throw std::runtime_error{"Invalid shared buffer ring: file too short or corrupt"};
+                }
+            }
+
+            SharedBufferRing(const SharedBufferRing&) = delete;
+            SharedBufferRing& operator=(const SharedBufferRing&) = delete;
+
+            SharedBufferRing(SharedBufferRing&&) noexcept = default;
+            SharedBufferRing& operator=(SharedBufferRing&&) noexcept = default;
+
+            ~SharedBufferRing() noexcept = default;
+
+            /// The number of slots in this ring.
+            std::size_t num_slots() const noexcept {
+                return m_num_slots;
+            }
+
+            /// The size of each slot in bytes.
+            std::size_t slot_size() const noexcept {
+                return m_slot_size;
+            }
+
+            /**
+             * Get a free slot for writing. Blocks until a slot is free.
+             *
+             * @returns The slot number.
+             */
+            std::size_t acquire_for_writing() {
+                while (true) {
+                    const std::size_t n = claim(m_next_write, slot_free, slot_writing);
+                    if (n != npos) {
+                        return n;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+
+            /**
+             * Get an empty Buffer working directly on the shared memory
+             * of the slot. It does not grow, if it is full adding data
+             * will throw osmium::buffer_is_full.
+             *
+             * @pre Slot must have been acquired with acquire_for_writing().
+             */
+            Buffer write_buffer(std::size_t n) const {
+                assert(slot(n).state.load(std::memory_order_relaxed) == slot_writing);
+                return Buffer{slot_data(n), m_slot_size, 0};
+            }
+
+            /**
+             * Hand over the data in the slot to the consumers.
+             *
+             * @param n The slot number.
+             * @param buffer The buffer returned by write_buffer(n). Only
+             *               committed data is handed over.
+             * @pre Slot must have been acquired with acquire_for_writing().
+             */
+            void publish(std::size_t n, const Buffer& buffer) noexcept {
+                assert(slot(n).state.load(std::memory_order_relaxed) == slot_writing);
+                assert(buffer.data() == slot_data(n));
+                slot(n).committed = buffer.committed();
+                slot(n).state.store(slot_ready, std::memory_order_release);
+            }
+
+            /**
+             * Mark the end of data. Consumers will get npos from
+             * acquire_for_reading() once all published slots are read.
+             */
+            void close() noexcept {
+                header().closed.store(1, std::memory_order_release);
+            }
+
+            /**
+             * Claim a published slot for reading. Blocks until a slot was
+             * published or the ring was closed.
+             *
+             * @returns The slot number or npos if the ring was closed and
+             *          there are no published slots left.
+             */
+            std::size_t acquire_for_reading() {
+                while (true) {
+                    std::size_t n = claim(m_next_read, slot_ready, slot_reading);
+                    if (n != npos) {
+                        return n;
+                    }
+                    if (header().closed.load(std::memory_order_acquire) != 0) {
+                        // check again, something could have been published
+                        // just before the close
+                        return claim(m_next_read, slot_ready, slot_reading);
+                    }
+                    std::this_thread::yield();
+                }
+            }
+
+            /**
+             * Get a Buffer with the published data of the slot. The buffer
+             * works directly on the shared memory, it is only valid until
+             * release() is called for this slot.
+             *
+             * @pre Slot must have been acquired with acquire_for_reading().
+             */
+            Buffer read_buffer(std::size_t n) const {
+                assert(slot(n).state.load(std::memory_order_relaxed) == slot_reading);
+                return Buffer{slot_data(n), m_slot_size, slot(n).committed};
+            }
+
+            /**
+             * Give the slot back to the producer.
+             *
+             * @pre Slot must have been acquired with acquire_for_reading().
+             */
+            void release(std::size_t n) noexcept {
+                assert(slot(n).state.load(std::memory_order_relaxed) == slot_reading);
+                slot(n).state.store(slot_free, std::memory_order_release);
+            }
+
+        }; // class SharedBufferRing
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_SHARED_BUFFER_RING_HPP
@@ -0,0 +1,366 @@
+#ifndef OSMIUM_MEMORY_TYPE_INDEX_HPP
+#define OSMIUM_MEMORY_TYPE_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * Iterator over the items of type T at the offsets given by an
+         * iterator over offsets into a buffer.
+         */
+        template <typename T>
+        class TypeIndexIterator {
+
+            using data_type = typename std::conditional<std::is_const<T>::value, const unsigned char*, unsigned char*>::type;
+            using offset_iterator = std::vector<std::size_t>::const_iterator;
+
+            data_type m_data = nullptr;
+            offset_iterator m_it{};
+
+        public:
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            TypeIndexIterator() noexcept = default;
+
+            TypeIndexIterator(data_type data, offset_iterator it) noexcept :
+                m_data(data),
+                m_it(it) {
+            }
+
+            TypeIndexIterator& operator++() noexcept {
+                ++m_it;
+                return *this;
+            }
+
+            TypeIndexIterator operator++(int) noexcept {
+                TypeIndexIterator tmp{*this};
+                ++m_it;
+                return tmp;
+            }
+
+            TypeIndexIterator& operator--() noexcept {
+                --m_it;
+                return *this;
+            }
+
+            TypeIndexIterator operator--(int) noexcept {
+                TypeIndexIterator tmp{*this};
+                --m_it;
+                return tmp;
+            }
+
+            TypeIndexIterator& operator+=(difference_type n) noexcept {
+                m_it += n;
+                return *this;
+            }
+
+            TypeIndexIterator& operator-=(difference_type n) noexcept {
+                m_it -= n;
+                return *this;
+            }
+
+            TypeIndexIterator operator+(difference_type n) const noexcept {
+                return TypeIndexIterator{m_data, m_it + n};
+            }
+
+            TypeIndexIterator operator-(difference_type n) const noexcept {
+                return TypeIndexIterator{m_data, m_it - n};
+            }
+
+            difference_type operator-(const TypeIndexIterator& rhs) const noexcept {
+                return m_it - rhs.m_it;
+            }
+
+            bool operator==(const TypeIndexIterator& rhs) const noexcept {
+                return m_it == rhs.m_it;
+            }
+
+            bool operator!=(const TypeIndexIterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            bool operator<(const TypeIndexIterator& rhs) const noexcept {
+                return m_it < rhs.m_it;
+            }
+
+            bool operator>(const TypeIndexIterator& rhs) const noexcept {
+                return rhs < *this;
+            }
+
+            bool operator<=(const TypeIndexIterator& rhs) const noexcept {
+                return !(rhs < *this);
+            }
+
+            bool operator>=(const TypeIndexIterator& rhs) const noexcept {
+                return !(*this < rhs);
+            }
+
+            T& operator*() const noexcept {
+                return *reinterpret_cast<T*>(m_data + *m_it);
+            }
+
+            T* operator->() const noexcept {
+                return reinterpret_cast<T*>(m_data + *m_it);
+            }
+
+            T& operator[](difference_type n) const noexcept {
+                return *reinterpret_cast<T*>(m_data + m_it[n]);
+            }
+
+        }; // class TypeIndexIterator
+
+        template <typename T>
+        inline TypeIndexIterator<T> operator+(typename TypeIndexIterator<T>::difference_type n, const TypeIndexIterator<T>& it) noexcept {
+            return it + n;
+        }
+
+        template <typename T>
+        class TypeIndexRange {
+
+            TypeIndexIterator<T> m_begin;
+            TypeIndexIterator<T> m_end;
+
+        public:
+
+            using iterator = TypeIndexIterator<T>;
+
+            TypeIndexRange(iterator first, iterator last) noexcept :
+                m_begin(first),
+                m_end(last) {
+            }
+
+            iterator begin() const noexcept {
+                return m_begin;
+            }
+
+            iterator end() const noexcept {
+                return m_end;
+            }
+
+            std::size_t size() const noexcept {
+                return static_cast<std::size_t>(m_end - m_begin);
+            }
+
+            bool empty() const noexcept {
+                return m_begin == m_end;
+            }
+
+        }; // class TypeIndexRange
+
+        /**
+         * Index of the offsets of all OSM entities (nodes, ways, relations,
+         * areas, and changesets) in a buffer by type. It is built in a
+         * single pass over the buffer. After that iterating over all
+         * items of one type doesn't have to look at the items of other
+         * types, which is much faster than Buffer::select<>() for mixed
+         * buffers if the index is used several times.
+         *
+         * The index is only valid as long as the committed part of the
+         * buffer doesn't change. Adding items to the buffer, purging
+         * removed items or moving the buffer invalidates it.
+         *
+         * The offsets can also be used to split the work on a buffer into
+         * parts, for instance with osmium::thread::Pool::parallel_for():
+         *
+         * @code
+         * osmium::memory::TypeIndex index{buffer};
+         * pool.parallel_for(index.offsets(osmium::item_type::way), [&](std::size_t offset) {
+         *     const auto& way = buffer.get<osmium::Way>(offset);
+         *     ...
+         * });
+         * @endcode
+         */
+        class TypeIndex {
+
+            enum : std::size_t {
+                num_types = static_cast<std::size_t>(osmium::item_type::changeset)
+            };
+
+            std::array<std::vector<std::size_t>, num_types> m_offsets;
+
+            const unsigned char* m_data = nullptr;
+            std::size_t m_committed = 0;
+
+            static std::size_t type_index(osmium::item_type type) noexcept {
+                const auto t = static_cast<std::size_t>(type);
+                assert(t > 0 && t <= num_types);
+                return t - 1;
+            }
+
+        public:
+
+            /// Create an empty index.
+            TypeIndex() = default;
+
+            /**
+             * Create an index of the committed items in the buffer.
+             *
+             * Complexity: Linear in the number of items in the buffer.
+             */
+            explicit TypeIndex(const osmium::memory::Buffer& buffer) {
+                build(buffer);
+            }
+
+            /**
+             * Build the index (again) for the committed items in the
+             * buffer.
+             *
+             * Complexity: Linear in the number of items in the buffer.
+             */
+            void build(const osmium::memory::Buffer& buffer) {
+                for (auto& offsets : m_offsets) {
+                    offsets.clear();
+                }
+                m_data = buffer.data();
+                m_committed = buffer.committed();
+
+                std::size_t offset = 0;
+                while (offset < m_committed) {
+                    const auto& item = *reinterpret_cast<const osmium::memory::Item*>(m_data + offset);
+                    const auto t = static_cast<std::size_t>(item.type());
+                    if (t > 0 && t <= num_types) {
+                        m_offsets[t - 1].push_back(offset);
+                    }
+                    offset += item.padded_size();
+                }
+            }
+
+            /**
+             * Is this index valid for the buffer, ie. was it built for
+             * this buffer and the committed part of the buffer wasn't
+             * changed since then? This can only detect changes of the
+             * data pointer or the size, so it is a sanity check only.
+             */
+            bool valid_for(const osmium::memory::Buffer& buffer) const noexcept {
+                return m_data == buffer.data() && m_committed == buffer.committed();
+            }
+
+            /**
+             * The offsets of all items of the specified type in the order
+             * they appear in the buffer.
+             *
+             * @param type Type of items. Must be node, way, relation, area,
+             *             or changeset.
+             */
+            const std::vector<std::size_t>& offsets(osmium::item_type type) const noexcept {
+                return m_offsets[type_index(type)];
+            }
+
+            /**
+             * The offsets of all items of the specified types in the order
+             * they appear in the buffer.
+             */
+            std::vector<std::size_t> offsets(osmium::osm_entity_bits::type entities) const {
+                std::vector<std::size_t> result;
+                for (std::size_t i = 0; i < num_types; ++i) {
+                    if (entities & osmium::osm_entity_bits::from_item_type(static_cast<osmium::item_type>(i + 1))) {
+                        const auto middle = result.size();
+                        result.insert(result.end(), m_offsets[i].cbegin(), m_offsets[i].cend());
+                        std::inplace_merge(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(middle), result.end());
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * The number of items of the specified type.
+             *
+             * @param type Type of items. Must be node, way, relation, area,
+             *             or changeset.
+             */
+            std::size_t count(osmium::item_type type) const noexcept {
+                return offsets(type).size();
+            }
+
+            /**
+             * Return a range over all items of type T in the buffer. T
+             * must be one of the types osmium::Node, Way, Relation, Area,
+             * or Changeset (or const versions of them).
+             *
+             * @pre The index must be valid for the buffer.
+             */
+            template <typename T>
+            TypeIndexRange<T> select(osmium::memory::Buffer& buffer) const noexcept {
+                assert(valid_for(buffer));
+                const auto& offsets = m_offsets[type_index(std::remove_const<T>::type::itemtype)];
+                return TypeIndexRange<T>{TypeIndexIterator<T>{buffer.data(), offsets.cbegin()},
+                                         TypeIndexIterator<T>{buffer.data(), offsets.cend()}};
+            }
+
+            template <typename T>
+            TypeIndexRange<const T> select(const osmium::memory::Buffer& buffer) const noexcept {
+                assert(valid_for(buffer));
+                const auto& offsets = m_offsets[type_index(T::itemtype)];
+                return TypeIndexRange<const T>{TypeIndexIterator<const T>{buffer.data(), offsets.cbegin()},
+                                               TypeIndexIterator<const T>{buffer.data(), offsets.cend()}};
+            }
+
+            /**
+             * Return an estimate of the number of bytes used by this index.
+             */
+            std::size_t used_memory() const noexcept {
+                std::size_t memory = sizeof(TypeIndex);
+                for (const auto& offsets : m_offsets) {
+                    memory += offsets.capacity() * sizeof(std::size_t);
+                }
+                return memory;
+            }
+
+        }; // class TypeIndex
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_TYPE_INDEX_HPP
@@ -34,11 +34,16 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/type_index.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/thread/sort.hpp>
 
 #include <boost/iterator/indirect_iterator.hpp>
 
 #include <algorithm>
+#include <cassert>
 #include <utility>
 #include <vector>
 
@@ -85,6 +90,24 @@ namespace osmium {
             m_objects.push_back(&object);
         }
 
+        /**
+         * Add pointers to all objects of the specified types in the
+         * buffer to the collection using the type index of the buffer.
+         * This only looks at the objects of the specified types.
+         *
+         * @param buffer The buffer with the objects.
+         * @param index Type index which must be valid for the buffer.
+         * @param entities Types of objects to add.
+         */
+        void add(osmium::memory::Buffer& buffer, const osmium::memory::TypeIndex& index, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::object) {
+            assert(index.valid_for(buffer));
+            const auto offsets = index.offsets(entities & osmium::osm_entity_bits::object);
+            m_objects.reserve(m_objects.size() + offsets.size());
+            for (const auto offset : offsets) {
+                m_objects.push_back(&buffer.get<osmium::OSMObject>(offset));
+            }
+        }
+
         /**
          * Sort objects according to the specified order functor. This function
          * uses a stable sort.
@@ -94,6 +117,16 @@ namespace osmium {
             std::stable_sort(m_objects.begin(), m_objects.end(), std::forward<TCompare>(compare));
         }
 
+        /**
+         * Sort the objects using the threads in the pool. See
+         * osmium::thread::parallel_stable_sort() for details. Small
+         * collections are sorted in the calling thread.
+         */
+        template <typename TCompare>
+        void sort(TCompare&& compare, osmium::thread::Pool& pool) {
+            osmium::thread::parallel_stable_sort(m_objects.begin(), m_objects.end(), std::forward<TCompare>(compare), pool);
+        }
+
         /**
          * Make objects unique according to the specified equality functor.
          *
@@ -0,0 +1,270 @@
+#ifndef OSMIUM_OSM_COMPACT_NODE_REF_LIST_HPP
+#define OSMIUM_OSM_COMPACT_NODE_REF_LIST_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        inline void append_varint(std::vector<unsigned char>& data, uint64_t value) {
+            while (value >= 0x80U) {
+                data.push_back(static_cast<unsigned char>((value & 0x7fU) | 0x80U));
+                value >>= 7U;
+            }
+            data.push_back(static_cast<unsigned char>(value));
+        }
+
+        inline void append_zigzag(std::vector<unsigned char>& data, int64_t value) {
+            append_varint(data, (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(value >> 63));
+        }
+
+        inline uint64_t decode_varint(const unsigned char** data) noexcept {
+            uint64_t value = 0;
+            unsigned int shift = 0;
+            while (**data & 0x80U) {
+                value |= static_cast<uint64_t>(**data & 0x7fU) << shift;
+                shift += 7;
+                ++*data;
+            }
+            value |= static_cast<uint64_t>(**data) << shift;
+            ++*data;
+            return value;
+        }
+
+        inline int64_t decode_zigzag(const unsigned char** data) noexcept {
+            const uint64_t value = decode_varint(data);
+            return static_cast<int64_t>(value >> 1U) ^ -static_cast<int64_t>(value & 1U);
+        }
+
+    } // namespace detail
+
+    /**
+     * Append the compact encoding of the node refs to data. The encoding
+     * starts with the number of node refs followed by the differences of
+     * the ids and coordinates to the previous node ref, all as (zigzag)
+     * varints. Because consecutive nodes of a way are usually close to
+     * each other and often have similar ids, this typically needs 3 to 6
+     * bytes per node ref instead of 16. Undefined locations are encoded
+     * losslessly.
+     *
+     * Use a CompactNodeRefList to read the encoded node refs.
+     */
+    inline void encode_node_refs(const osmium::NodeRefList& nodes, std::vector<unsigned char>& data) {
+        detail::append_varint(data, nodes.size());
+        osmium::object_id_type last_id = 0;
+        int64_t last_x = 0;
+        int64_t last_y = 0;
+        for (const auto& node_ref : nodes) {
+            detail::append_zigzag(data, node_ref.ref() - last_id);
+            detail::append_zigzag(data, node_ref.x() - last_x);
+            detail::append_zigzag(data, node_ref.y() - last_y);
+            last_id = node_ref.ref();
+            last_x = node_ref.x();
+            last_y = node_ref.y();
+        }
+    }
+
+    /**
+     * Read-only view of node refs encoded with encode_node_refs(). The
+     * node refs are decoded lazily while iterating, so this works like a
+     * NodeRefList in range-based for loops and with algorithms needing
+     * only input iterators. The encoded data must outlive this object.
+     */
+    class CompactNodeRefList {
+
+        const unsigned char* m_data = nullptr;
+        std::size_t m_size = 0;
+
+    public:
+
+        /**
+         * Iterator decoding one node ref at a time. Dereferencing gives a
+         * reference to the decoded node ref stored in the iterator.
+         */
+        class const_iterator {
+
+            const unsigned char* m_data = nullptr;
+            std::size_t m_remaining = 0;
+            osmium::NodeRef m_node_ref{};
+
+            void decode() noexcept {
+                if (m_remaining > 0) {
+                    const auto id = m_node_ref.ref() + detail::decode_zigzag(&m_data);
+                    const auto x = m_node_ref.x() + detail::decode_zigzag(&m_data);
+                    const auto y = m_node_ref.y() + detail::decode_zigzag(&m_data);
+                    m_node_ref = osmium::NodeRef{id, osmium::Location{static_cast<int32_t>(x), static_cast<int32_t>(y)}};
+                }
+            }
+
+        public:
+
+            using iterator_category = std::input_iterator_tag;
+            using value_type        = const osmium::NodeRef;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            const_iterator() noexcept = default;
+
+            const_iterator(const unsigned char* data, std::size_t remaining) noexcept :
+                m_data(data),
+                m_remaining(remaining),
+                m_node_ref(0, osmium::Location{0, 0}) {
+                decode();
+            }
+
+            const_iterator& operator++() noexcept {
+                assert(m_remaining > 0);
+                --m_remaining;
+                decode();
+                return *this;
+            }
+
+            const_iterator operator++(int) noexcept {
+                const_iterator tmp{*this};
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const const_iterator& rhs) const noexcept {
+                return m_remaining == rhs.m_remaining;
+            }
+
+            bool operator!=(const const_iterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            reference operator*() const noexcept {
+                assert(m_remaining > 0);
+                return m_node_ref;
+            }
+
+            pointer operator->() const noexcept {
+                assert(m_remaining > 0);
+                return &m_node_ref;
+            }
+
+        }; // class const_iterator
+
+        using iterator = const_iterator;
+
+        /// Create an empty list.
+        CompactNodeRefList() noexcept = default;
+
+        /**
+         * Create a view of the node refs encoded at data by
+         * encode_node_refs().
+         */
+        explicit CompactNodeRefList(const unsigned char* data) noexcept :
+            m_data(data) {
+            m_size = static_cast<std::size_t>(detail::decode_varint(&m_data));
+        }
+
+        /// The number of node refs in the list.
+        std::size_t size() const noexcept {
+            return m_size;
+        }
+
+        /// Is the list empty?
+        bool empty() const noexcept {
+            return m_size == 0;
+        }
+
+        const_iterator begin() const noexcept {
+            return {m_data, m_size};
+        }
+
+        const_iterator end() const noexcept {
+            return {};
+        }
+
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        /**
+         * The first node ref in the list.
+         *
+         * @pre @code !empty() @endcode
+         */
+        osmium::NodeRef front() const noexcept {
+            assert(!empty());
+            return *begin();
+        }
+
+        /**
+         * The last node ref in the list. This has to decode the whole list.
+         *
+         * @pre @code !empty() @endcode
+         */
+        osmium::NodeRef back() const noexcept {
+            assert(!empty());
+            osmium::NodeRef node_ref;
+            for (const auto& nr : *this) {
+                node_ref = nr;
+            }
+            return node_ref;
+        }
+
+        /**
+         * Checks whether the first and last node in the list have the
+         * same ID. The locations are not checked. This has to decode
+         * the whole list.
+         *
+         * @pre @code !empty() @endcode
+         */
+        bool is_closed() const noexcept {
+            return front().ref() == back().ref();
+        }
+
+    }; // class CompactNodeRefList
+
+} // namespace osmium
+
+#endif // OSMIUM_OSM_COMPACT_NODE_REF_LIST_HPP
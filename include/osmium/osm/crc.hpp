@@ -113,6 +113,16 @@ namespace osmium {
             return m_crc;
         }
 
+        /**
+         * Combine this checksum with the checksum of the data following
+         * it, so that the result is the same as if all data was fed into
+         * this object. Only available if the CRC type has a combine()
+         * function like osmium::CRC_zlib and osmium::CRC_crc32c.
+         */
+        void combine(const CRC& other) noexcept {
+            m_crc.combine(other.m_crc);
+        }
+
         void update_bool(const bool value) noexcept {
             m_crc.process_byte(value);
         }
@@ -0,0 +1,245 @@
+#ifndef OSMIUM_OSM_CRC_CRC32C_HPP
+#define OSMIUM_OSM_CRC_CRC32C_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+# include <nmmintrin.h>
+# define OSMIUM_CRC32C_SSE42
+#elif defined(__ARM_FEATURE_CRC32)
+# include <arm_acle.h>
+# define OSMIUM_CRC32C_ARM
+#endif
+
+namespace osmium {
+
+    namespace detail {
+
+        /// Reversed CRC32C (Castagnoli) polynomial.
+        constexpr const uint32_t crc32c_polynomial = 0x82F63B78U;
+
+        inline const std::array<uint32_t, 256>& crc32c_table() noexcept {
+            static const std::array<uint32_t, 256> table = []() {
+                std::array<uint32_t, 256> t; // NOLINT(cppcoreguidelines-pro-type-member-init)
+                for (uint32_t n = 0; n < 256; ++n) {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; ++k) {
+                        c = (c & 1U) ? (crc32c_polynomial ^ (c >> 1U)) : (c >> 1U);
+                    }
+                    t[n] = c;
+                }
+                return t;
+            }();
+            return table;
+        }
+
+        inline uint32_t gf2_matrix_times(const uint32_t* mat, uint32_t vec) noexcept {
+            uint32_t sum = 0;
+            while (vec) {
+                if (vec & 1U) {
+                    sum ^= *mat;
+                }
+                vec >>= 1U;
+                ++mat;
+            }
+            return sum;
+        }
+
+        inline void gf2_matrix_square(uint32_t* square, const uint32_t* mat) noexcept {
+            for (int n = 0; n < 32; ++n) {
+                square[n] = gf2_matrix_times(mat, mat[n]);
+            }
+        }
+
+        /**
+         * Combine two CRC32 checksums using the given reversed polynomial.
+         * This is the same algorithm zlib uses in crc32_combine().
+         *
+         * @param crc1 Checksum of the first part of the data.
+         * @param crc2 Checksum of the second part of the data.
+         * @param len2 Length of the second part of the data in bytes.
+         * @param polynomial The reversed polynomial.
+         * @returns Checksum of the concatenated data.
+         */
+        inline uint32_t crc32_combine(uint32_t crc1, const uint32_t crc2, std::size_t len2, const uint32_t polynomial) noexcept {
+            if (len2 == 0) {
+                return crc1;
+            }
+
+            uint32_t even[32]; // NOLINT(hicpp-avoid-c-arrays,modernize-avoid-c-arrays,cppcoreguidelines-avoid-c-arrays)
+            uint32_t odd[32]; // NOLINT(hicpp-avoid-c-arrays,modernize-avoid-c-arrays,cppcoreguidelines-avoid-c-arrays)
+
+            // operator for one zero bit in odd
+            odd[0] = polynomial;
+            uint32_t row = 1;
+            for (int n = 1; n < 32; ++n) {
+                odd[n] = row;
+                row <<= 1U;
+            }
+
+            gf2_matrix_square(even, odd); // two zero bits
+            gf2_matrix_square(odd, even); // four zero bits
+
+            // apply len2 zeros to crc1 (first square will put the operator
+            // for one zero byte, eight zero bits, in even)
+            do {
+                gf2_matrix_square(even, odd);
+                if (len2 & 1U) {
+                    crc1 = gf2_matrix_times(even, crc1);
+                }
+                len2 >>= 1U;
+                if (len2 == 0) {
+                    break;
+                }
+                gf2_matrix_square(odd, even);
+                if (len2 & 1U) {
+                    crc1 = gf2_matrix_times(odd, crc1);
+                }
+                len2 >>= 1U;
+            } while (len2 != 0);
+
+            return crc1 ^ crc2;
+        }
+
+    } // namespace detail
+
+    /**
+     * This class is used together with the CRC class to implement a CRC32C
+     * (Castagnoli) checksum. If the code is compiled for a CPU with the
+     * SSE 4.2 instructions (x86) or the ARMv8 CRC32 extension, those are
+     * used, otherwise a table-based implementation is used. The results
+     * are the same in either case.
+     *
+     * Note that this is a different checksum than the one computed by
+     * CRC_zlib.
+     *
+     * Usage:
+     *
+     * @code
+     * osmium::CRC<osmium::CRC_crc32c> crc;
+     * const osmium::Node& node = ...;
+     * crc.update(node);
+     * std::cout << crc().checksum() << '\n';
+     * @endcode
+     *
+     * Checksums over separate parts of the data can be combined with
+     * combine(), so they can be computed in parallel.
+     */
+    class CRC_crc32c {
+
+        uint32_t m_crc = 0xFFFFFFFFU;
+
+        std::size_t m_length = 0;
+
+        static uint32_t process_byte_impl(uint32_t crc, const unsigned char byte) noexcept {
+#if defined(OSMIUM_CRC32C_SSE42)
+            return _mm_crc32_u8(crc, byte);
+#elif defined(OSMIUM_CRC32C_ARM)
+            return __crc32cb(crc, byte);
+#else
+            return detail::crc32c_table()[(crc ^ byte) & 0xFFU] ^ (crc >> 8U);
+#endif
+        }
+
+    public:
+
+        /**
+         * Is this compiled to use the CRC32 instructions of the CPU?
+         */
+        static constexpr bool hardware_accelerated() noexcept {
+#if defined(OSMIUM_CRC32C_SSE42) || defined(OSMIUM_CRC32C_ARM)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void process_byte(const unsigned char byte) noexcept {
+            m_crc = process_byte_impl(m_crc, byte);
+            ++m_length;
+        }
+
+        void process_bytes(const void* buffer, std::size_t byte_count) noexcept {
+            const auto* data = static_cast<const unsigned char*>(buffer);
+            m_length += byte_count;
+
+#if (defined(OSMIUM_CRC32C_SSE42) && (defined(__x86_64__) || defined(_M_X64))) || (defined(OSMIUM_CRC32C_ARM) && defined(__aarch64__))
+            uint64_t crc = m_crc;
+            for (; byte_count >= sizeof(uint64_t); byte_count -= sizeof(uint64_t), data += sizeof(uint64_t)) {
+                uint64_t value; // NOLINT(cppcoreguidelines-init-variables)
+                std::memcpy(&value, data, sizeof(uint64_t));
+# if defined(OSMIUM_CRC32C_SSE42)
+                crc = _mm_crc32_u64(crc, value);
+# else
+                crc = __crc32cd(static_cast<uint32_t>(crc), value);
+# endif
+            }
+            m_crc = static_cast<uint32_t>(crc);
+#endif
+
+            for (; byte_count > 0; --byte_count, ++data) {
+                m_crc = process_byte_impl(m_crc, *data);
+            }
+        }
+
+        uint32_t checksum() const noexcept {
+            return ~m_crc;
+        }
+
+        /// The number of bytes processed so far.
+        std::size_t length() const noexcept {
+            return m_length;
+        }
+
+        /**
+         * Combine this checksum with the checksum of the data following
+         * it. Afterwards this is the checksum of the concatenated data.
+         */
+        void combine(const CRC_crc32c& other) noexcept {
+            m_crc = ~detail::crc32_combine(checksum(), other.checksum(), other.m_length, detail::crc32c_polynomial);
+            m_length += other.m_length;
+        }
+
+    }; // class CRC_crc32c
+
+} // namespace osmium
+
+#undef OSMIUM_CRC32C_SSE42
+#undef OSMIUM_CRC32C_ARM
+
+#endif // OSMIUM_OSM_CRC_CRC32C_HPP
@@ -51,25 +51,46 @@ namespace osmium {
      * crc32.update(node);
      * std::cout << crc32.checksum() << '\n';
      * @endcode
+     *
+     * Checksums over separate parts of the data can be combined with
+     * combine(), so they can be computed in parallel.
      */
     class CRC_zlib {
 
         unsigned long m_crc32 = ::crc32(0, nullptr, 0); // NOLINT(google-runtime-int)
 
+        std::size_t m_length = 0;
+
     public:
 
         void process_byte(const unsigned char byte) noexcept {
             m_crc32 = ::crc32(m_crc32, &byte, 1U);
+            ++m_length;
         }
 
         void process_bytes(const void* buffer, std::size_t byte_count) noexcept {
             m_crc32 = ::crc32(m_crc32, reinterpret_cast<const unsigned char *>(buffer), static_cast<unsigned int>(byte_count));
+            m_length += byte_count;
         }
 
         unsigned long checksum() const noexcept { // NOLINT(google-runtime-int)
             return m_crc32;
         }
 
+        /// The number of bytes processed so far.
+        std::size_t length() const noexcept {
+            return m_length;
+        }
+
+        /**
+         * Combine this checksum with the checksum of the data following
+         * it. Afterwards this is the checksum of the concatenated data.
+         */
+        void combine(const CRC_zlib& other) noexcept {
+            m_crc32 = ::crc32_combine(m_crc32, other.m_crc32, static_cast<z_off_t>(other.m_length));
+            m_length += other.m_length;
+        }
+
     }; // class CRC_zlib
 
 } // namespace osmium
@@ -0,0 +1,263 @@
+#ifndef OSMIUM_OSM_ENVELOPE_HPP
+#define OSMIUM_OSM_ENVELOPE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+
+#include <cstdint>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# if defined(__SSE4_1__)
+#  include <smmintrin.h>
+# endif
+# define OSMIUM_ENVELOPE_SSE2
+#elif defined(__ARM_NEON) && (defined(__GNUC__) || defined(__clang__))
+# include <arm_neon.h>
+# define OSMIUM_ENVELOPE_NEON
+#endif
+
+namespace osmium {
+
+    namespace detail {
+
+        static_assert(sizeof(osmium::Location) == 2 * sizeof(int32_t), "Location must consist of x and y only");
+        static_assert(sizeof(osmium::NodeRef) == sizeof(int64_t) + sizeof(osmium::Location), "NodeRef must consist of ref and location only");
+
+        enum : int32_t {
+            envelope_max_x = 180 * osmium::detail::coordinate_precision,
+            envelope_max_y =  90 * osmium::detail::coordinate_precision
+        };
+
+        /**
+         * Minimum and maximum coordinates of the valid locations seen so
+         * far. Invalid locations (see Location::valid()) are ignored like
+         * Box::extend() does.
+         */
+        struct envelope_bounds {
+
+            int32_t min_x = std::numeric_limits<int32_t>::max();
+            int32_t min_y = std::numeric_limits<int32_t>::max();
+            int32_t max_x = std::numeric_limits<int32_t>::min();
+            int32_t max_y = std::numeric_limits<int32_t>::min();
+
+            void add(const osmium::Location& location) noexcept {
+                const int32_t x = location.x();
+                const int32_t y = location.y();
+                if (x >= -envelope_max_x && x <= envelope_max_x &&
+                    y >= -envelope_max_y && y <= envelope_max_y) {
+                    min_x = x < min_x ? x : min_x;
+                    min_y = y < min_y ? y : min_y;
+                    max_x = x > max_x ? x : max_x;
+                    max_y = y > max_y ? y : max_y;
+                }
+            }
+
+            osmium::Box box() const noexcept {
+                if (min_x > max_x) {
+                    return osmium::Box{};
+                }
+                return osmium::Box{osmium::Location{min_x, min_y}, osmium::Location{max_x, max_y}};
+            }
+
+        }; // struct envelope_bounds
+
+#if defined(OSMIUM_ENVELOPE_SSE2)
+
+        // Running minimum and maximum of two locations at a time in the
+        // lanes (x0, y0, x1, y1).
+        class envelope_kernel {
+
+            const __m128i m_low  = _mm_setr_epi32(-envelope_max_x, -envelope_max_y, -envelope_max_x, -envelope_max_y);
+            const __m128i m_high = _mm_setr_epi32(envelope_max_x, envelope_max_y, envelope_max_x, envelope_max_y);
+            const __m128i m_int_max = _mm_set1_epi32(std::numeric_limits<int32_t>::max());
+            const __m128i m_int_min = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+            __m128i m_min = m_int_max;
+            __m128i m_max = m_int_min;
+
+            static __m128i select(const __m128i mask, const __m128i a, const __m128i b) noexcept {
+                return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+            }
+
+            static __m128i min(const __m128i a, const __m128i b) noexcept {
+# if defined(__SSE4_1__)
+                return _mm_min_epi32(a, b);
+# else
+                return select(_mm_cmpgt_epi32(a, b), b, a);
+# endif
+            }
+
+            static __m128i max(const __m128i a, const __m128i b) noexcept {
+# if defined(__SSE4_1__)
+                return _mm_max_epi32(a, b);
+# else
+                return select(_mm_cmpgt_epi32(a, b), a, b);
+# endif
+            }
+
+        public:
+
+            void add(const __m128i v) noexcept {
+                __m128i invalid = _mm_or_si128(_mm_cmplt_epi32(v, m_low), _mm_cmpgt_epi32(v, m_high));
+                // A location is invalid if its x or y coordinate is.
+                invalid = _mm_or_si128(invalid, _mm_shuffle_epi32(invalid, _MM_SHUFFLE(2, 3, 0, 1)));
+                m_min = min(m_min, select(invalid, m_int_max, v));
+                m_max = max(m_max, select(invalid, m_int_min, v));
+            }
+
+            static __m128i load(const osmium::Location* locations) noexcept {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(locations));
+            }
+
+            static __m128i load(const osmium::NodeRef* node_refs) noexcept {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(node_refs));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(node_refs + 1));
+                return _mm_unpackhi_epi64(a, b);
+            }
+
+            void store(envelope_bounds& bounds) const noexcept {
+                const __m128i vmin = min(m_min, _mm_shuffle_epi32(m_min, _MM_SHUFFLE(1, 0, 3, 2)));
+                const __m128i vmax = max(m_max, _mm_shuffle_epi32(m_max, _MM_SHUFFLE(1, 0, 3, 2)));
+                bounds.min_x = _mm_cvtsi128_si32(vmin);
+                bounds.min_y = _mm_cvtsi128_si32(_mm_shuffle_epi32(vmin, _MM_SHUFFLE(1, 1, 1, 1)));
+                bounds.max_x = _mm_cvtsi128_si32(vmax);
+                bounds.max_y = _mm_cvtsi128_si32(_mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 1, 1, 1)));
+            }
+
+        }; // class envelope_kernel
+
+#elif defined(OSMIUM_ENVELOPE_NEON)
+
+        // Running minimum and maximum of two locations at a time in the
+        // lanes (x0, y0, x1, y1).
+        class envelope_kernel {
+
+            int32x4_t m_low;
+            int32x4_t m_high;
+            int32x4_t m_min = vdupq_n_s32(std::numeric_limits<int32_t>::max());
+            int32x4_t m_max = vdupq_n_s32(std::numeric_limits<int32_t>::min());
+
+        public:
+
+            envelope_kernel() noexcept {
+                const int32_t low[4] = {-envelope_max_x, -envelope_max_y, -envelope_max_x, -envelope_max_y};
+                const int32_t high[4] = {envelope_max_x, envelope_max_y, envelope_max_x, envelope_max_y};
+                m_low = vld1q_s32(low);
+                m_high = vld1q_s32(high);
+            }
+
+            void add(const int32x4_t v) noexcept {
+                uint32x4_t invalid = vorrq_u32(vcltq_s32(v, m_low), vcgtq_s32(v, m_high));
+                // A location is invalid if its x or y coordinate is.
+                invalid = vorrq_u32(invalid, vrev64q_u32(invalid));
+                m_min = vminq_s32(m_min, vbslq_s32(invalid, vdupq_n_s32(std::numeric_limits<int32_t>::max()), v));
+                m_max = vmaxq_s32(m_max, vbslq_s32(invalid, vdupq_n_s32(std::numeric_limits<int32_t>::min()), v));
+            }
+
+            static int32x4_t load(const osmium::Location* locations) noexcept {
+                return vld1q_s32(reinterpret_cast<const int32_t*>(locations));
+            }
+
+            static int32x4_t load(const osmium::NodeRef* node_refs) noexcept {
+                const auto* data = reinterpret_cast<const int32_t*>(node_refs);
+                return vcombine_s32(vld1_s32(data + 2), vld1_s32(data + 6));
+            }
+
+            void store(envelope_bounds& bounds) const noexcept {
+                const int32x2_t vmin = vmin_s32(vget_low_s32(m_min), vget_high_s32(m_min));
+                const int32x2_t vmax = vmax_s32(vget_low_s32(m_max), vget_high_s32(m_max));
+                bounds.min_x = vget_lane_s32(vmin, 0);
+                bounds.min_y = vget_lane_s32(vmin, 1);
+                bounds.max_x = vget_lane_s32(vmax, 0);
+                bounds.max_y = vget_lane_s32(vmax, 1);
+            }
+
+        }; // class envelope_kernel
+
+#endif
+
+        inline const osmium::Location& location_of(const osmium::Location& location) noexcept {
+            return location;
+        }
+
+        inline osmium::Location location_of(const osmium::NodeRef& node_ref) noexcept {
+            return node_ref.location();
+        }
+
+        template <typename T>
+        inline osmium::Box envelope_of(const T* first, const T* last) noexcept {
+            envelope_bounds bounds;
+#if defined(OSMIUM_ENVELOPE_SSE2) || defined(OSMIUM_ENVELOPE_NEON)
+            if (last - first >= 2) {
+                envelope_kernel kernel;
+                for (; last - first >= 2; first += 2) {
+                    kernel.add(envelope_kernel::load(first));
+                }
+                kernel.store(bounds);
+            }
+#endif
+            for (; first != last; ++first) {
+                bounds.add(location_of(*first));
+            }
+            return bounds.box();
+        }
+
+    } // namespace detail
+
+    /**
+     * Calculate the envelope of the locations in the range [first, last).
+     * The result is the same as calling Box::extend() for each of the
+     * locations, invalid locations are ignored. With SSE2 or NEON two
+     * locations are handled at a time without branches.
+     *
+     * Complexity: Linear in the number of locations.
+     */
+    inline osmium::Box envelope(const osmium::Location* first, const osmium::Location* last) noexcept {
+        return detail::envelope_of(first, last);
+    }
+
+    /**
+     * Calculate the envelope of the locations of the node refs in the
+     * range [first, last). See above.
+     */
+    inline osmium::Box envelope(const osmium::NodeRef* first, const osmium::NodeRef* last) noexcept {
+        return detail::envelope_of(first, last);
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_OSM_ENVELOPE_HPP
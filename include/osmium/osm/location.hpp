@@ -34,7 +34,9 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <functional>
@@ -70,7 +72,63 @@ namespace osmium {
 
         // Convert string with a floating point number into integer suitable
         // for use as coordinate in a Location.
+        /**
+         * Fast path for string_to_location_coordinate() for the usual
+         * format of coordinates: An optional minus sign, one to three
+         * digits, a decimal point, and one to seven digits.
+         *
+         * @returns true if the coordinate could be parsed, false if the
+         *          general parser has to be used.
+         */
+        inline bool fast_string_to_location_coordinate(const char** data, int32_t* value) noexcept {
+            static const std::array<uint32_t, 8> powers_of_ten = {{
+                10000000, 1000000, 100000, 10000, 1000, 100, 10, 1
+            }};
+
+            const bool negative = **data == '-';
+            const char* str = *data + (negative ? 1 : 0);
+
+            const auto is_digit = [](const char c) noexcept {
+                return c >= '0' && c <= '9';
+            };
+
+            uint64_t result = 0;
+            const char* const int_begin = str;
+            while (is_digit(*str) && str - int_begin < 4) {
+                result = result * 10 + static_cast<uint64_t>(*str - '0');
+                ++str;
+            }
+            if (str == int_begin || str - int_begin > 3 || *str != '.') {
+                return false;
+            }
+            ++str;
+
+            const char* const frac_begin = str;
+            while (is_digit(*str) && str - frac_begin < 8) {
+                result = result * 10 + static_cast<uint64_t>(*str - '0');
+                ++str;
+            }
+            const auto frac_digits = str - frac_begin;
+            if (frac_digits == 0 || frac_digits > 7 || is_digit(*str) || *str == 'e' || *str == 'E') {
+                return false;
+            }
+
+            result *= powers_of_ten[static_cast<std::size_t>(frac_digits)];
+            if (result > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+                return false;
+            }
+
+            *value = negative ? -static_cast<int32_t>(result) : static_cast<int32_t>(result);
+            *data = str;
+            return true;
+        }
+
         inline int32_t string_to_location_coordinate(const char** data) {
+            int32_t value = 0;
+            if (fast_string_to_location_coordinate(data, &value)) {
+                return value;
+            }
+
             const char* str = *data;
             const char* full = str;
 
@@ -0,0 +1,156 @@
+#ifndef OSMIUM_OSM_NODE_LOCATIONS_BLOCK_HPP
+#define OSMIUM_OSM_NODE_LOCATIONS_BLOCK_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * A block of nodes in columnar form: The ids and locations of all
+     * nodes are kept in two parallel arrays, only the nodes with tags are
+     * kept as complete objects in a buffer.
+     *
+     * This is useful for passes only interested in the node locations,
+     * like filling a location index, which can use the arrays without
+     * touching the object headers, metadata, and tag lists of all the
+     * (mostly untagged) nodes. See
+     * NodeLocationsForWays::node_locations() and
+     * osmium::index::map::Map::set_many().
+     */
+    class NodeLocationsBlock {
+
+        enum {
+            initial_buffer_size = 64UL * 1024UL
+        };
+
+        std::vector<osmium::object_id_type> m_ids;
+        std::vector<osmium::Location> m_locations;
+        osmium::memory::Buffer m_tagged_nodes{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+
+    public:
+
+        /**
+         * Create an empty block. Use add_node() or add_location() to
+         * fill it.
+         */
+        NodeLocationsBlock() = default;
+
+        /**
+         * Create a block from all nodes in the buffer. Other objects in
+         * the buffer are ignored.
+         */
+        explicit NodeLocationsBlock(const osmium::memory::Buffer& buffer) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                add_node(node);
+            }
+        }
+
+        /// The number of nodes in this block.
+        std::size_t size() const noexcept {
+            return m_ids.size();
+        }
+
+        /// Is this block empty?
+        bool empty() const noexcept {
+            return m_ids.empty();
+        }
+
+        /// Reserve space for the ids and locations of this many nodes.
+        void reserve(const std::size_t size) {
+            m_ids.reserve(size);
+            m_locations.reserve(size);
+        }
+
+        /**
+         * Add the id and location of a node without tags (or with tags
+         * you are not interested in). Decoders can use this directly
+         * without building a Node object first.
+         */
+        void add_location(const osmium::object_id_type id, const osmium::Location location) {
+            m_ids.push_back(id);
+            m_locations.push_back(location);
+        }
+
+        /**
+         * Add a node. The id and location are always added to the
+         * arrays, a node with tags is also copied into the buffer of
+         * tagged nodes.
+         */
+        void add_node(const osmium::Node& node) {
+            add_location(node.id(), node.location());
+            if (!node.tags().empty()) {
+                m_tagged_nodes.add_item(node);
+                m_tagged_nodes.commit();
+            }
+        }
+
+        /// The ids of all nodes in this block.
+        const std::vector<osmium::object_id_type>& ids() const noexcept {
+            return m_ids;
+        }
+
+        /// The locations of all nodes in this block in the same order as the ids.
+        const std::vector<osmium::Location>& locations() const noexcept {
+            return m_locations;
+        }
+
+        /// Buffer with all nodes in this block which have tags.
+        const osmium::memory::Buffer& tagged_nodes() const noexcept {
+            return m_tagged_nodes;
+        }
+
+        /// Buffer with all nodes in this block which have tags.
+        osmium::memory::Buffer& tagged_nodes() noexcept {
+            return m_tagged_nodes;
+        }
+
+        /// Remove all nodes from this block.
+        void clear() {
+            m_ids.clear();
+            m_locations.clear();
+            m_tagged_nodes.clear();
+        }
+
+    }; // class NodeLocationsBlock
+
+} // namespace osmium
+
+#endif // OSMIUM_OSM_NODE_LOCATIONS_BLOCK_HPP
@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/memory/item.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/envelope.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
@@ -188,11 +189,7 @@ namespace osmium {
          * Complexity: Linear in the number of elements.
          */
         osmium::Box envelope() const noexcept {
-            osmium::Box box;
-            for (const auto& node_ref : *this) {
-                box.extend(node_ref.location());
-            }
-            return box;
+            return osmium::envelope(cbegin(), cend());
         }
 
         /// Returns an iterator to the beginning.
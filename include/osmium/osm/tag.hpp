@@ -39,6 +39,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 #include <iosfwd>
 #include <iterator>
@@ -96,6 +97,27 @@ namespace osmium {
             return reinterpret_cast<const char*>(after_null(data()));
         }
 
+        /**
+         * Get the length of the tag key in bytes (not including the
+         * terminating zero).
+         *
+         * Complexity: Linear on the number of characters in the key!
+         */
+        std::size_t key_size() const noexcept {
+            return static_cast<std::size_t>(value() - key()) - 1;
+        }
+
+        /**
+         * Get the length of the tag value in bytes (not including the
+         * terminating zero).
+         *
+         * Complexity: Linear on the number of characters in the key and
+         *             value!
+         */
+        std::size_t value_size() const noexcept {
+            return std::strlen(value());
+        }
+
     }; // class Tag
 
     inline bool operator==(const Tag& lhs, const Tag& rhs) noexcept {
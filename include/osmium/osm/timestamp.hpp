@@ -80,6 +80,78 @@ namespace osmium {
             out += static_cast<char>('0' + value);
         }
 
+        /**
+         * Append the timestamp given as seconds since the epoch to the
+         * string in ISO date/time ("yyyy-mm-ddThh:mm:ssZ") format. This
+         * doesn't go through gmtime(), the date is calculated directly
+         * from the number of days since the epoch.
+         */
+        inline void add_iso_timestamp_to_string(uint32_t timestamp, std::string& out) {
+            const uint32_t days = timestamp / 86400U;
+            uint32_t secs = timestamp - days * 86400U;
+
+            // Convert days since 1970-01-01 into year, month and day, see
+            // http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+            // Eras are 400 year periods starting on 0000-03-01, 1970-01-01
+            // is in the era starting 1600-03-01, day 135080 of that era.
+            const uint32_t z = days + 135080U;
+            const uint32_t era = z / 146097U;
+            const uint32_t doe = z - era * 146097U; // day of era [0, 146096]
+            const uint32_t yoe = (doe - doe / 1460U + doe / 36524U - doe / 146096U) / 365U; // year of era [0, 399]
+            const uint32_t doy = doe - (365U * yoe + yoe / 4U - yoe / 100U); // day of year [0, 365]
+            const uint32_t mp = (5U * doy + 2U) / 153U; // month starting from March [0, 11]
+            const uint32_t mday = doy - (153U * mp + 2U) / 5U + 1U;
+            const uint32_t month = mp < 10U ? mp + 3U : mp - 9U;
+            const uint32_t year = 1600U + era * 400U + yoe + (month <= 2U ? 1U : 0U);
+
+            const uint32_t hour = secs / 3600U;
+            secs -= hour * 3600U;
+            const uint32_t min = secs / 60U;
+            secs -= min * 60U;
+
+            char buffer[20] = {
+                static_cast<char>('0' + year / 1000U),
+                static_cast<char>('0' + (year / 100U) % 10U),
+                static_cast<char>('0' + (year / 10U) % 10U),
+                static_cast<char>('0' + year % 10U),
+                '-',
+                static_cast<char>('0' + month / 10U),
+                static_cast<char>('0' + month % 10U),
+                '-',
+                static_cast<char>('0' + mday / 10U),
+                static_cast<char>('0' + mday % 10U),
+                'T',
+                static_cast<char>('0' + hour / 10U),
+                static_cast<char>('0' + hour % 10U),
+                ':',
+                static_cast<char>('0' + min / 10U),
+                static_cast<char>('0' + min % 10U),
+                ':',
+                static_cast<char>('0' + secs / 10U),
+                static_cast<char>('0' + secs % 10U),
+                'Z'
+            };
+
+            out.append(buffer, sizeof(buffer));
+        }
+
+        /**
+         * Number of days since 1970-01-01 for the given date. Days beyond
+         * the end of the month continue into the next month like with
+         * timegm(). See
+         * http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+         */
+        inline int64_t days_from_civil(int64_t year, const unsigned int month, const unsigned int day) noexcept {
+            if (month <= 2) {
+                --year;
+            }
+            const int64_t era = (year >= 0 ? year : year - 399) / 400;
+            const auto yoe = static_cast<unsigned int>(year - era * 400); // year of era [0, 399]
+            const unsigned int doy = (153U * (month > 2 ? month - 3 : month + 9) + 2U) / 5U + day - 1U; // day of year [0, 365]
+            const unsigned int doe = yoe * 365U + yoe / 4U - yoe / 100U + doy; // day of era [0, 146096]
+            return era * 146097 + static_cast<int64_t>(doe) - 719468;
+        }
+
         inline time_t parse_timestamp(const char* str) {
             static const std::array<int, 12> mon_lengths = {{
                 31, 29, 31, 30, 31, 30,
@@ -106,30 +178,25 @@ namespace osmium {
                 str[17] >= '0' && str[17] <= '9' &&
                 str[18] >= '0' && str[18] <= '9' &&
                 str[19] == 'Z') {
-                std::tm tm; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
-                tm.tm_year = (str[ 0] - '0') * 1000 +
-                             (str[ 1] - '0') *  100 +
-                             (str[ 2] - '0') *   10 +
-                             (str[ 3] - '0')        - 1900;
-                tm.tm_mon  = (str[ 5] - '0') * 10 + (str[ 6] - '0') - 1;
-                tm.tm_mday = (str[ 8] - '0') * 10 + (str[ 9] - '0');
-                tm.tm_hour = (str[11] - '0') * 10 + (str[12] - '0');
-                tm.tm_min  = (str[14] - '0') * 10 + (str[15] - '0');
-                tm.tm_sec  = (str[17] - '0') * 10 + (str[18] - '0');
-                tm.tm_wday = 0;
-                tm.tm_yday = 0;
-                tm.tm_isdst = 0;
-                if (tm.tm_year >= 0 &&
-                    tm.tm_mon  >= 0 && tm.tm_mon  <= 11 &&
-                    tm.tm_mday >= 1 && tm.tm_mday <= mon_lengths[tm.tm_mon] &&
-                    tm.tm_hour >= 0 && tm.tm_hour <= 23 &&
-                    tm.tm_min  >= 0 && tm.tm_min  <= 59 &&
-                    tm.tm_sec  >= 0 && tm.tm_sec  <= 60) {
-#ifndef _WIN32
-                    return timegm(&tm);
-#else
-                    return _mkgmtime(&tm);
-#endif
+                const int year = (str[ 0] - '0') * 1000 +
+                                 (str[ 1] - '0') *  100 +
+                                 (str[ 2] - '0') *   10 +
+                                 (str[ 3] - '0');
+                const int mon  = (str[ 5] - '0') * 10 + (str[ 6] - '0');
+                const int mday = (str[ 8] - '0') * 10 + (str[ 9] - '0');
+                const int hour = (str[11] - '0') * 10 + (str[12] - '0');
+                const int min  = (str[14] - '0') * 10 + (str[15] - '0');
+                const int sec  = (str[17] - '0') * 10 + (str[18] - '0');
+                if (year >= 1900 &&
+                    mon  >= 1 && mon  <= 12 &&
+                    mday >= 1 && mday <= mon_lengths[mon - 1] &&
+                    hour >= 0 && hour <= 23 &&
+                    min  >= 0 && min  <= 59 &&
+                    sec  >= 0 && sec  <= 60) {
+                    // Calculated directly instead of with timegm(), which
+                    // is much slower. The result is the same.
+                    return static_cast<time_t>(days_from_civil(year, static_cast<unsigned int>(mon), static_cast<unsigned int>(mday)) * 86400 +
+                                               hour * 3600 + min * 60 + sec);
                 }
             }
             throw std::invalid_argument{std::string{"can not parse timestamp: '"} + str + "'"};
@@ -149,31 +216,7 @@ namespace osmium {
         uint32_t m_timestamp = 0;
 
         void to_iso_str(std::string& s) const {
-            std::tm tm; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
-            time_t sse = seconds_since_epoch();
-#ifndef NDEBUG
-            auto result =
-#endif
-#ifndef _WIN32
-            gmtime_r(&sse, &tm);
-            assert(result != nullptr);
-#else
-            gmtime_s(&tm, &sse);
-            assert(result == 0);
-#endif
-
-            detail::add_4digit_int_to_string(tm.tm_year + 1900, s);
-            s += '-';
-            detail::add_2digit_int_to_string(tm.tm_mon + 1, s);
-            s += '-';
-            detail::add_2digit_int_to_string(tm.tm_mday, s);
-            s += 'T';
-            detail::add_2digit_int_to_string(tm.tm_hour, s);
-            s += ':';
-            detail::add_2digit_int_to_string(tm.tm_min, s);
-            s += ':';
-            detail::add_2digit_int_to_string(tm.tm_sec, s);
-            s += 'Z';
+            detail::add_iso_timestamp_to_string(m_timestamp, s);
         }
 
     public:
@@ -0,0 +1,475 @@
+#ifndef OSMIUM_PARALLEL_VISITOR_HPP
+#define OSMIUM_PARALLEL_VISITOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Wrapper marking a handler as safe to be called from several
+         * threads at the same time. Create with osmium::concurrent().
+         */
+        template <typename THandler>
+        class concurrent_handler {
+
+            THandler& m_handler;
+
+        public:
+
+            explicit concurrent_handler(THandler& handler) noexcept :
+                m_handler(handler) {
+            }
+
+            THandler& get() const noexcept {
+                return m_handler;
+            }
+
+        }; // class concurrent_handler
+
+        template <typename T>
+        struct is_concurrent_handler : std::false_type {
+        };
+
+        template <typename THandler>
+        struct is_concurrent_handler<concurrent_handler<THandler>> : std::true_type {
+        };
+
+        template <typename T>
+        using enable_if_ordered = typename std::enable_if<!is_concurrent_handler<typename std::remove_const<T>::type>::value>::type;
+
+        template <typename TItem, typename THandler>
+        inline void apply_item_concurrent(TItem& item, const concurrent_handler<THandler>& handler) {
+            apply_item_impl(item, handler.get());
+        }
+
+        template <typename TItem, typename THandler, typename = enable_if_ordered<THandler>>
+        inline void apply_item_concurrent(TItem& /*item*/, THandler& /*handler*/) noexcept {
+        }
+
+        template <typename TItem, typename THandler>
+        inline void apply_item_ordered(TItem& /*item*/, const concurrent_handler<THandler>& /*handler*/) noexcept {
+        }
+
+        template <typename TItem, typename THandler, typename = enable_if_ordered<THandler>>
+        inline void apply_item_ordered(TItem& item, THandler& handler) {
+            apply_item_impl(item, handler);
+        }
+
+        template <typename THandler>
+        inline void apply_flush_parallel(const concurrent_handler<THandler>& handler) {
+            handler.get().flush();
+        }
+
+        template <typename THandler, typename = enable_if_ordered<THandler>>
+        inline void apply_flush_parallel(THandler& handler) {
+            handler.flush();
+        }
+
+        template <typename... THandlers>
+        struct count_concurrent_handlers;
+
+        template <>
+        struct count_concurrent_handlers<> {
+            enum : std::size_t { value = 0 };
+        };
+
+        template <typename T, typename... THandlers>
+        struct count_concurrent_handlers<T, THandlers...> {
+            enum : std::size_t {
+                value = (is_concurrent_handler<typename std::decay<T>::type>::value ? 1 : 0) +
+                        count_concurrent_handlers<THandlers...>::value
+            };
+        };
+
+        /// Maximum number of objects handed to a thread in one task.
+        constexpr const std::size_t apply_parallel_slice_size = 10000;
+
+        // A buffer and the tasks running the concurrent handlers on it.
+        struct parallel_apply_buffer {
+            std::shared_ptr<osmium::memory::Buffer> buffer;
+            std::vector<std::future<void>> futures;
+        }; // struct parallel_apply_buffer
+
+        class parallel_apply_queue {
+
+            std::deque<parallel_apply_buffer> m_pending;
+
+        public:
+
+            parallel_apply_queue() = default;
+
+            parallel_apply_queue(const parallel_apply_queue&) = delete;
+            parallel_apply_queue& operator=(const parallel_apply_queue&) = delete;
+
+            parallel_apply_queue(parallel_apply_queue&&) = delete;
+            parallel_apply_queue& operator=(parallel_apply_queue&&) = delete;
+
+            ~parallel_apply_queue() noexcept {
+                // The tasks reference the handlers, so they must be done
+                // before we return to the caller, even in case of errors.
+                for (auto& pending : m_pending) {
+                    for (auto& future : pending.futures) {
+                        if (future.valid()) {
+                            future.wait();
+                        }
+                    }
+                }
+            }
+
+            std::size_t size() const noexcept {
+                return m_pending.size();
+            }
+
+            bool empty() const noexcept {
+                return m_pending.empty();
+            }
+
+            void push(parallel_apply_buffer&& pending) {
+                m_pending.push_back(std::move(pending));
+            }
+
+            // Wait for the tasks on all buffers, the buffers stay in the
+            // queue.
+            void wait() {
+                for (auto& pending : m_pending) {
+                    for (auto& future : pending.futures) {
+                        if (future.valid()) {
+                            future.get();
+                        }
+                    }
+                }
+            }
+
+            // Wait for the tasks on the oldest buffer and return it.
+            std::shared_ptr<osmium::memory::Buffer> pop() {
+                for (auto& future : m_pending.front().futures) {
+                    if (future.valid()) {
+                        future.get();
+                    }
+                }
+                auto buffer = std::move(m_pending.front().buffer);
+                m_pending.pop_front();
+                return buffer;
+            }
+
+        }; // class parallel_apply_queue
+
+        template <typename... THandlers>
+        inline void submit_concurrent(osmium::thread::Pool& pool, parallel_apply_buffer& pending, THandlers&... handlers) {
+            using iterator = osmium::memory::Buffer::const_iterator;
+
+            const std::shared_ptr<const osmium::memory::Buffer> buffer{pending.buffer};
+            iterator it = buffer->cbegin();
+            const iterator end = buffer->cend();
+            while (it != end) {
+                const iterator first = it;
+                for (std::size_t n = 0; n < apply_parallel_slice_size && it != end; ++n) {
+                    ++it;
+                }
+                const iterator last = it;
+                pending.futures.push_back(pool.submit([buffer, first, last, &handlers...]() {
+                    for (auto i = first; i != last; ++i) {
+                        (void)std::initializer_list<int>{
+                            (apply_item_concurrent(*i, handlers), 0)...
+                        };
+                    }
+                }));
+            }
+        }
+
+        /**
+         * Copies of a handler for apply_parallel_reduce(). A task takes
+         * a copy not used by any other task right now, so there are never
+         * more copies than tasks running at the same time.
+         */
+        template <typename THandler>
+        class handler_copies {
+
+            const THandler& m_prototype;
+            std::mutex m_mutex;
+            std::vector<std::unique_ptr<THandler>> m_copies;
+            std::vector<THandler*> m_available;
+
+        public:
+
+            explicit handler_copies(const THandler& prototype) :
+                m_prototype(prototype) {
+            }
+
+            THandler* acquire() {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_available.empty()) {
+                    m_copies.emplace_back(new THandler(m_prototype));
+                    return m_copies.back().get();
+                }
+                THandler* handler = m_available.back();
+                m_available.pop_back();
+                return handler;
+            }
+
+            void release(THandler* handler) {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_available.push_back(handler);
+            }
+
+            // Only call this after all tasks are done.
+            const std::vector<std::unique_ptr<THandler>>& copies() const noexcept {
+                return m_copies;
+            }
+
+        }; // class handler_copies
+
+        template <typename THandler>
+        inline void submit_reduce(osmium::thread::Pool& pool, parallel_apply_buffer& pending, handler_copies<THandler>& copies) {
+            using iterator = osmium::memory::Buffer::const_iterator;
+
+            const std::shared_ptr<const osmium::memory::Buffer> buffer{pending.buffer};
+            iterator it = buffer->cbegin();
+            const iterator end = buffer->cend();
+            while (it != end) {
+                const iterator first = it;
+                for (std::size_t n = 0; n < apply_parallel_slice_size && it != end; ++n) {
+                    ++it;
+                }
+                const iterator last = it;
+                pending.futures.push_back(pool.submit([buffer, first, last, &copies]() {
+                    THandler* handler = copies.acquire();
+                    try {
+                        for (auto i = first; i != last; ++i) {
+                            apply_item_impl(*i, *handler);
+                        }
+                    } catch (...) {
+                        copies.release(handler);
+                        throw;
+                    }
+                    copies.release(handler);
+                }));
+            }
+        }
+
+        template <typename... THandlers>
+        inline void apply_ordered(osmium::memory::Buffer& buffer, THandlers&... handlers) {
+            for (auto& item : buffer) {
+                (void)std::initializer_list<int>{
+                    (apply_item_ordered(item, handlers), 0)...
+                };
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * Mark a handler as safe to be called from several threads at the
+     * same time for use with apply_parallel(). The handler must be
+     * derived from osmium::handler::Handler and must be available
+     * until apply_parallel() returns.
+     */
+    template <typename THandler>
+    inline detail::concurrent_handler<THandler> concurrent(THandler& handler) noexcept {
+        return detail::concurrent_handler<THandler>{handler};
+    }
+
+    /**
+     * Apply handlers to all buffers read from the source, using the
+     * threads of the pool for the handlers wrapped with concurrent().
+     *
+     * The concurrent handlers are called from the pool threads on
+     * several buffers, and on slices of large buffers, at the same time
+     * and in no specific order. They see the objects before the ordered
+     * handlers do. All other handlers are called in the calling thread
+     * on all objects in the order of the input, after the concurrent
+     * handlers are done with the buffer. They can change the objects
+     * like they can with apply().
+     *
+     * At the end flush() is called on all handlers in the order given.
+     * Exceptions thrown by any handler are propagated to the caller.
+     *
+     * Unlike apply(), this doesn't accept lambdas, all handlers must be
+     * derived from osmium::handler::Handler.
+     *
+     * @param source Object with a read() function returning buffers,
+     *               usually an osmium::io::Reader.
+     * @param pool The thread pool for the concurrent handlers.
+     * @param handlers The handlers.
+     */
+    template <typename TSource, typename... THandlers>
+    inline void apply_parallel(TSource& source, osmium::thread::Pool& pool, THandlers&&... handlers) {
+        const auto max_pending = static_cast<std::size_t>(pool.num_threads()) * 2;
+        const bool any_concurrent = detail::count_concurrent_handlers<THandlers...>::value > 0;
+
+        {
+            detail::parallel_apply_queue queue;
+            while (osmium::memory::Buffer buffer = source.read()) {
+                detail::parallel_apply_buffer pending{std::make_shared<osmium::memory::Buffer>(std::move(buffer)), {}};
+                if (any_concurrent) {
+                    detail::submit_concurrent(pool, pending, handlers...);
+                }
+                queue.push(std::move(pending));
+                while (queue.size() > max_pending) {
+                    detail::apply_ordered(*queue.pop(), handlers...);
+                }
+            }
+
+            while (!queue.empty()) {
+                detail::apply_ordered(*queue.pop(), handlers...);
+            }
+        }
+
+        (void)std::initializer_list<int>{
+            (detail::apply_flush_parallel(handlers), 0)...
+        };
+    }
+
+    /**
+     * Apply handlers to all objects in the buffer, using the threads of
+     * the pool for the handlers wrapped with concurrent(). The buffer
+     * is split into slices handled at the same time. See the other
+     * apply_parallel() function for details.
+     */
+    template <typename... THandlers>
+    inline void apply_parallel(osmium::memory::Buffer& buffer, osmium::thread::Pool& pool, THandlers&&... handlers) {
+        {
+            detail::parallel_apply_queue queue;
+
+            // The buffer is owned by the caller, so it is not deleted.
+            detail::parallel_apply_buffer pending{std::shared_ptr<osmium::memory::Buffer>{&buffer, [](osmium::memory::Buffer* /*buffer*/) {}}, {}};
+            if (detail::count_concurrent_handlers<THandlers...>::value > 0) {
+                detail::submit_concurrent(pool, pending, handlers...);
+            }
+            queue.push(std::move(pending));
+            detail::apply_ordered(*queue.pop(), handlers...);
+        }
+
+        (void)std::initializer_list<int>{
+            (detail::apply_flush_parallel(handlers), 0)...
+        };
+    }
+
+    /**
+     * Apply copies of a handler to all buffers read from the source in
+     * parallel and merge the results. This is a map-reduce for
+     * aggregations like counting objects or tags: Each task running on
+     * the threads of the pool takes a copy of the handler not used by
+     * any other task at the time and applies it to a buffer or a slice
+     * of a large buffer. So the handler doesn't need any locking, but
+     * each copy only sees some of the objects in no specific order.
+     * The objects are const.
+     *
+     * After all data is read, flush() is called on all copies and they
+     * are merged with merge(result, copy) into the result, which starts
+     * out as a copy of the handler given. There are at most as many
+     * copies as there are tasks running at the same time, usually the
+     * number of threads in the pool.
+     *
+     * The handler must be derived from osmium::handler::Handler and be
+     * copy constructible. Exceptions thrown by the handler or merge
+     * function are propagated to the caller.
+     *
+     * @param source Object with a read() function returning buffers,
+     *               usually an osmium::io::Reader.
+     * @param pool The thread pool to use.
+     * @param handler The handler in its initial state. It is only copied.
+     * @param merge Function called as merge(THandler& result, const
+     *              THandler& copy) to add the state of a copy to the
+     *              result.
+     * @returns The merged result.
+     */
+    template <typename TSource, typename THandler, typename TMerge>
+    inline THandler apply_parallel_reduce(TSource& source, osmium::thread::Pool& pool, const THandler& handler, TMerge&& merge) {
+        const auto max_pending = static_cast<std::size_t>(pool.num_threads()) * 2;
+        detail::handler_copies<THandler> copies{handler};
+
+        {
+            detail::parallel_apply_queue queue;
+            while (osmium::memory::Buffer buffer = source.read()) {
+                detail::parallel_apply_buffer pending{std::make_shared<osmium::memory::Buffer>(std::move(buffer)), {}};
+                detail::submit_reduce(pool, pending, copies);
+                queue.push(std::move(pending));
+                while (queue.size() > max_pending) {
+                    queue.pop();
+                }
+            }
+
+            while (!queue.empty()) {
+                queue.pop();
+            }
+        }
+
+        THandler result(handler);
+        for (const auto& copy : copies.copies()) {
+            copy->flush();
+            merge(result, static_cast<const THandler&>(*copy));
+        }
+        return result;
+    }
+
+    /**
+     * Apply copies of a handler to all buffers read from the source in
+     * parallel and merge the results with the merge() member function
+     * of the handler. See the other apply_parallel_reduce() function for
+     * details.
+     *
+     * @param source Object with a read() function returning buffers,
+     *               usually an osmium::io::Reader.
+     * @param pool The thread pool to use.
+     * @param handler The handler in its initial state. It must have a
+     *                member function merge(const THandler& other)
+     *                adding the state of other to itself.
+     * @returns The merged result.
+     */
+    template <typename TSource, typename THandler>
+    inline THandler apply_parallel_reduce(TSource& source, osmium::thread::Pool& pool, const THandler& handler) {
+        return apply_parallel_reduce(source, pool, handler, [](THandler& result, const THandler& other) {
+            result.merge(other);
+        });
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_PARALLEL_VISITOR_HPP
@@ -0,0 +1,141 @@
+#ifndef OSMIUM_RELATIONS_DETAIL_ID_FILTER_HPP
+#define OSMIUM_RELATIONS_DETAIL_ID_FILTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osmium {
+
+    namespace relations {
+
+        namespace detail {
+
+            /**
+             * Bloom filter for object ids. Used as a prefilter in the
+             * MembersDatabase to quickly reject objects that aren't
+             * members of any relation without doing a binary search.
+             *
+             * It uses 16 bits per id and two hash functions which gives
+             * a false positive rate of about 1.4%. There are no false
+             * negatives. An empty filter (one that wasn't reset()) lets
+             * everything through.
+             */
+            class IdFilter {
+
+                std::vector<uint64_t> m_bits;
+                uint64_t m_mask = 0;
+
+                enum {
+                    bits_per_id = 16
+                };
+
+                static uint64_t hash(osmium::object_id_type id) noexcept {
+                    // splitmix64 finalizer
+                    auto x = static_cast<uint64_t>(id);
+                    x ^= x >> 30U;
+                    x *= 0xbf58476d1ce4e5b9ULL;
+                    x ^= x >> 27U;
+                    x *= 0x94d049bb133111ebULL;
+                    x ^= x >> 31U;
+                    return x;
+                }
+
+                bool test_bit(uint64_t bit) const noexcept {
+                    return (m_bits[bit >> 6U] & (1ULL << (bit & 63U))) != 0;
+                }
+
+                void set_bit(uint64_t bit) noexcept {
+                    m_bits[bit >> 6U] |= 1ULL << (bit & 63U);
+                }
+
+            public:
+
+                /**
+                 * Clear the filter and size it for the given number of ids.
+                 */
+                void reset(std::size_t num_ids) {
+                    uint64_t bits = 64;
+                    while (bits < static_cast<uint64_t>(num_ids) * bits_per_id) {
+                        bits *= 2;
+                    }
+                    m_bits.assign(static_cast<std::size_t>(bits / 64), 0);
+                    m_mask = bits - 1;
+                }
+
+                /// Remove all ids and free the memory.
+                void clear() {
+                    m_bits.clear();
+                    m_bits.shrink_to_fit();
+                    m_mask = 0;
+                }
+
+                bool empty() const noexcept {
+                    return m_bits.empty();
+                }
+
+                void add(osmium::object_id_type id) noexcept {
+                    const auto h = hash(id);
+                    set_bit(h & m_mask);
+                    set_bit((h >> 32U) & m_mask);
+                }
+
+                /**
+                 * Is the id possibly in the filter? If this returns false,
+                 * the id has never been added.
+                 */
+                bool maybe_contains(osmium::object_id_type id) const noexcept {
+                    if (m_bits.empty()) {
+                        return true;
+                    }
+                    const auto h = hash(id);
+                    return test_bit(h & m_mask) && test_bit((h >> 32U) & m_mask);
+                }
+
+                std::size_t used_memory() const noexcept {
+                    return m_bits.capacity() * sizeof(uint64_t);
+                }
+
+            }; // class IdFilter
+
+        } // namespace detail
+
+    } // namespace relations
+
+} // namespace osmium
+
+#endif // OSMIUM_RELATIONS_DETAIL_ID_FILTER_HPP
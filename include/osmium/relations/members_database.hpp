@@ -35,7 +35,9 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/relations/detail/id_filter.hpp>
 #include <osmium/relations/relations_database.hpp>
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/util/iterator.hpp>
@@ -43,9 +45,11 @@ DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <iterator>
 #include <limits>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -137,6 +141,13 @@ namespace osmium {
 
             std::vector<element> m_elements{};
 
+            // Prefilter for lookups built in prepare_for_lookup().
+            detail::IdFilter m_filter{};
+
+            bool m_use_filter = true;
+
+            bool m_intern_tags = false;
+
         protected:
 
             osmium::ItemStash& m_stash;
@@ -152,13 +163,31 @@ namespace osmium {
             using const_iterator = std::vector<element>::const_iterator;
 
             iterator_range<iterator> find(osmium::object_id_type id) {
+                if (!m_filter.maybe_contains(id)) {
+                    return make_range(std::make_pair(m_elements.end(), m_elements.end()));
+                }
                 return make_range(std::equal_range(m_elements.begin(), m_elements.end(), element{id}, compare_member_id{}));
             }
 
             iterator_range<const_iterator> find(osmium::object_id_type id) const {
+                if (!m_filter.maybe_contains(id)) {
+                    return make_range(std::make_pair(m_elements.cend(), m_elements.cend()));
+                }
                 return make_range(std::equal_range(m_elements.cbegin(), m_elements.cend(), element{id}, compare_member_id{}));
             }
 
+            // Range of entries for the member with the specified id
+            // starting at pos as returned by find_position().
+            iterator_range<iterator> range_at(std::size_t pos, osmium::object_id_type id) {
+                assert(pos < m_elements.size() && m_elements[pos].member_id == id);
+                const auto first = std::next(m_elements.begin(), static_cast<std::ptrdiff_t>(pos));
+                auto last = first;
+                while (last != m_elements.end() && last->member_id == id) {
+                    ++last;
+                }
+                return make_range(std::make_pair(first, last));
+            }
+
             static typename iterator_range<iterator>::iterator::difference_type count_not_removed(const iterator_range<iterator>& range) noexcept {
                 return std::count_if(range.begin(), range.end(), [](const element& elem) {
                     return !elem.is_removed();
@@ -166,7 +195,8 @@ namespace osmium {
             }
 
             void add_object(const osmium::OSMObject& object, iterator_range<iterator>& range) {
-                const auto handle = m_stash.add_item(object);
+                const auto handle = m_intern_tags ? m_stash.add_object_interning_tags(object)
+                                                  : m_stash.add_item(object);
                 for (auto& elem : range) {
                     elem.object_handle = handle;
                 }
@@ -186,6 +216,7 @@ namespace osmium {
              */
             std::size_t used_memory() const noexcept {
                 return sizeof(element) * m_elements.capacity() +
+                       m_filter.used_memory() +
                        sizeof(MembersDatabaseCommon);
             }
 
@@ -200,6 +231,45 @@ namespace osmium {
                 return m_elements.size();
             }
 
+            /**
+             * Is any member with an id in the range [first_id, last_id]
+             * tracked in the database? Members already found or removed
+             * are counted, too.
+             *
+             * Complexity: Logarithmic in the number of members tracked.
+             */
+            bool contains_in_range(osmium::object_id_type first_id, osmium::object_id_type last_id) const {
+                assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling contains_in_range().");
+                const auto it = std::lower_bound(m_elements.cbegin(), m_elements.cend(), element{first_id}, compare_member_id{});
+                return it != m_elements.cend() && it->member_id <= last_id;
+            }
+
+            /**
+             * Find the position of the first entry for the member with the
+             * specified id. This only reads the member ids which never
+             * change after prepare_for_lookup() was called, so it can be
+             * called from several threads at the same time, even while
+             * objects are added from another thread.
+             *
+             * @param id The member id.
+             * @param pos Set to the position if the member was found.
+             * @returns true if a member with this id is tracked.
+             *
+             * Complexity: Logarithmic in the number of members tracked.
+             */
+            bool find_position(osmium::object_id_type id, std::size_t& pos) const {
+                assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling find_position().");
+                if (!m_filter.maybe_contains(id)) {
+                    return false;
+                }
+                const auto it = std::lower_bound(m_elements.cbegin(), m_elements.cend(), element{id}, compare_member_id{});
+                if (it == m_elements.cend() || it->member_id != id) {
+                    return false;
+                }
+                pos = static_cast<std::size_t>(std::distance(m_elements.cbegin(), it));
+                return true;
+            }
+
             /**
              * Result from the count() function.
              */
@@ -250,6 +320,29 @@ namespace osmium {
                 rel_handle.increment_members();
             }
 
+            /**
+             * Enable or disable the Bloom filter used to quickly reject
+             * lookups for objects that aren't members of any relation.
+             * It is enabled by default and uses 2 bytes per tracked
+             * member. This must be called before prepare_for_lookup().
+             */
+            void use_prefilter(bool enable = true) noexcept {
+                assert(m_init_phase && "Call MembersDatabase::use_prefilter() before prepare_for_lookup().");
+                m_use_filter = enable;
+            }
+
+            /**
+             * Enable or disable interning of tag lists. If enabled, member
+             * objects are stored with ItemStash::add_object_interning_tags()
+             * so that identical tag lists are only stored once. The objects
+             * returned by get_object() and get() then have no tags, use
+             * get_tags() instead. Disabled by default. This must be called
+             * before the first object is added.
+             */
+            void intern_tags(bool enable = true) noexcept {
+                m_intern_tags = enable;
+            }
+
             /**
              * Prepare the database for lookup. Call this function after
              * calling track() for all objects needed and before adding
@@ -259,6 +352,12 @@ namespace osmium {
             void prepare_for_lookup() {
                 assert(m_init_phase && "Can not call MembersDatabase::prepare_for_lookup() twice.");
                 std::sort(m_elements.begin(), m_elements.end());
+                if (m_use_filter) {
+                    m_filter.reset(m_elements.size());
+                    for (const auto& elem : m_elements) {
+                        m_filter.add(elem.member_id);
+                    }
+                }
 #ifndef NDEBUG
                 m_init_phase = false;
 #endif
@@ -310,6 +409,29 @@ namespace osmium {
                 return nullptr;
             }
 
+            /**
+             * Get the tags of the object with the specified id. This works
+             * whether tag interning is enabled or not.
+             *
+             * Complexity: Logarithmic in the number of members tracked (as
+             *             returned by size()).
+             *
+             * @returns A pointer to the tags or nullptr if the object is
+             *          not available.
+             */
+            const osmium::TagList* get_tags(osmium::object_id_type id) const {
+                assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling get_tags().");
+                const auto range = find(id);
+                if (range.empty()) {
+                    return nullptr;
+                }
+                const auto handle = range.begin()->object_handle;
+                if (handle.valid()) {
+                    return &m_stash.tags(handle);
+                }
+                return nullptr;
+            }
+
         }; // class MembersDatabaseCommon
 
         /**
@@ -365,6 +487,32 @@ namespace osmium {
                     return false;
                 }
 
+                add_range(object, range, std::forward<TFunc>(func));
+                return true;
+            }
+
+            /**
+             * Add the specified object to the database. Same as add(), but
+             * with the position already looked up by find_position().
+             *
+             * @param pos Position as returned by find_position() for the
+             *            id of the object.
+             * @param object Object to add.
+             * @param func If the object is the last member to complete a
+             *             relation, this function is called with the relation
+             *             as a parameter.
+             */
+            template <typename TFunc>
+            void add_at(std::size_t pos, const TObject& object, TFunc&& func) {
+                assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling add_at().");
+                auto range = range_at(pos, object.id());
+                add_range(object, range, std::forward<TFunc>(func));
+            }
+
+        private:
+
+            template <typename TFunc>
+            void add_range(const TObject& object, iterator_range<iterator>& range, TFunc&& func) {
                 // At least one relation needs this object. Store it and
                 // "tell" all relations.
                 add_object(object, range);
@@ -381,10 +529,10 @@ namespace osmium {
                         func(rel_handle);
                     }
                 }
-
-                return true;
             }
 
+        public:
+
             /**
              * Find the object with the specified id in the database and
              * return a pointer to it. Returns nullptr if there is no object
@@ -0,0 +1,215 @@
+#ifndef OSMIUM_RELATIONS_PBF_BLOB_INDEX_READER_HPP
+#define OSMIUM_RELATIONS_PBF_BLOB_INDEX_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to read relations and their members from
+ * a PBF file in one go using a PBF blob index.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace relations {
+
+        /**
+         * Statistics returned from read_with_blob_index().
+         */
+        struct blob_index_read_stats {
+            /// The number of data blobs in the file.
+            std::size_t blobs_total = 0;
+            /// The number of blobs with relations read in the first step.
+            std::size_t relation_blobs = 0;
+            /// The number of blobs read in the second step.
+            std::size_t member_blobs = 0;
+        }; // struct blob_index_read_stats
+
+        namespace detail {
+
+            // Decode the blobs in parallel and call func for each
+            // resulting buffer in the order of the blobs.
+            template <typename TFunc>
+            void decode_blobs(const char* data, const std::vector<osmium::io::pbf_blob_index_entry>& entries, osmium::osm_entity_bits::type read_types, osmium::thread::Pool& pool, TFunc&& func) {
+                const auto max_pending = static_cast<std::size_t>(pool.num_threads()) * 2;
+                std::deque<std::future<osmium::memory::Buffer>> pending;
+                for (const auto& entry : entries) {
+                    osmium::io::detail::PBFDataBlobDecoder decoder{osmium::io::detail::pbf_blob_data{nullptr, osmium::io::detail::data_view{data + entry.offset, entry.size}},
+                                                                   read_types,
+                                                                   osmium::io::read_meta::yes};
+                    pending.push_back(pool.submit(std::move(decoder)));
+                    if (pending.size() > max_pending) {
+                        func(pending.front().get());
+                        pending.pop_front();
+                    }
+                }
+                while (!pending.empty()) {
+                    func(pending.front().get());
+                    pending.pop_front();
+                }
+            }
+
+            template <typename TManager>
+            bool wants_blob(const TManager& manager, const osmium::io::pbf_blob_index_entry& entry) {
+                for (const auto type : {osmium::item_type::node, osmium::item_type::way, osmium::item_type::relation}) {
+                    if ((entry.entity_bits() & osmium::osm_entity_bits::from_item_type(type)) &&
+                        manager.member_database(type).contains_in_range(entry.min_id, entry.max_id)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        } // namespace detail
+
+        /**
+         * Read relations and their members from an (uncompressed) PBF
+         * file in one go using a PBF blob index instead of reading the
+         * file twice.
+         *
+         * First all blobs containing relations are read and the
+         * relations are given to the managers. After that the
+         * prepare_for_lookup() function is called on all managers. Then
+         * only those blobs are read that, according to the id ranges in
+         * the index, can contain members any of the managers are
+         * interested in. All objects in those blobs are sent to the
+         * handler() of each manager in file order and flush() is called
+         * at the end.
+         *
+         * The managers must be RelationsManagers or at least have the
+         * same interface as far as the member_database() function is
+         * concerned. The file is memory mapped and the blobs are decoded
+         * in the default thread pool.
+         *
+         * @tparam TManager Any number of relation manager types.
+         * @param filename Name of the PBF file.
+         * @param index Blob index of the file (see PBFBlobIndex).
+         * @param managers Relation managers.
+         * @returns Statistics about the number of blobs read.
+         * @throws osmium::pbf_error If the index doesn't match the file
+         *         or the file is not valid PBF.
+         * @throws std::system_error If the file can't be opened or mapped.
+         */
+        template <typename ...TManager>
+        blob_index_read_stats read_with_blob_index(const std::string& filename, const osmium::io::PBFBlobIndex& index, TManager&& ...managers) {
+            static_assert(sizeof...(TManager) > 0, "Need at least one manager as parameter.");
+
+            blob_index_read_stats stats;
+            stats.blobs_total = index.size();
+
+            const int fd = osmium::io::detail::open_for_reading(filename);
+            const std::size_t size = osmium::file_size(fd);
+            std::unique_ptr<osmium::util::MemoryMapping> mapping;
+            try {
+                mapping.reset(new osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd});
+            } catch (...) {
+                osmium::io::detail::reliable_close(fd);
+                throw;
+            }
+            osmium::io::detail::reliable_close(fd);
+
+            for (const auto& entry : index) {
+                if (entry.offset + entry.size > size) {
+                    throw osmium::pbf_error{"PBF blob index does not match input file"};
+                }
+            }
+
+            const char* data = mapping->get_addr<const char>();
+            auto& pool = osmium::thread::Pool::default_instance();
+
+            std::vector<osmium::io::pbf_blob_index_entry> entries;
+            for (const auto& entry : index) {
+                if (entry.entity_bits() & osmium::osm_entity_bits::relation) {
+                    entries.push_back(entry);
+                }
+            }
+            stats.relation_blobs = entries.size();
+
+            detail::decode_blobs(data, entries, osmium::osm_entity_bits::relation, pool, [&](osmium::memory::Buffer&& buffer) {
+                osmium::apply(buffer, std::forward<TManager>(managers)...);
+            });
+            (void)std::initializer_list<int>{
+                (std::forward<TManager>(managers).prepare_for_lookup(), 0)...
+            };
+
+            entries.clear();
+            for (const auto& entry : index) {
+                bool wanted = false;
+                (void)std::initializer_list<int>{
+                    (wanted = wanted || detail::wants_blob(managers, entry), 0)...
+                };
+                if (wanted) {
+                    entries.push_back(entry);
+                }
+            }
+            stats.member_blobs = entries.size();
+
+            detail::decode_blobs(data, entries, osmium::osm_entity_bits::nwr, pool, [&](osmium::memory::Buffer&& buffer) {
+                for (auto& item : buffer) {
+                    osmium::apply_item(item, std::forward<TManager>(managers).handler()...);
+                }
+            });
+            osmium::apply_flush(std::forward<TManager>(managers).handler()...);
+
+            return stats;
+        }
+
+    } // namespace relations
+
+} // namespace osmium
+
+#endif // OSMIUM_RELATIONS_PBF_BLOB_INDEX_READER_HPP
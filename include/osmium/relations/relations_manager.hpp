@@ -47,14 +47,21 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/tags/taglist.hpp>
 #include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -97,6 +104,15 @@ namespace osmium {
                 m_member_relations_db(m_stash, m_relations_db) {
             }
 
+            /**
+             * Access the internal ItemStash holding all relations and
+             * members. Call set_max_memory() on it to spill data to disk
+             * when processing large inputs.
+             */
+            osmium::ItemStash& stash() noexcept {
+                return m_stash;
+            }
+
             /// Access the internal RelationsDatabase.
             osmium::relations::RelationsDatabase& relations_database() noexcept {
                 return m_relations_db;
@@ -185,6 +201,22 @@ namespace osmium {
                 return member_database(member.type()).get_object(member.ref());
             }
 
+            /**
+             * Get tags of the member object from relation member. Use
+             * this instead of get_member_object()->tags() if tag interning
+             * is enabled in the members database, see
+             * MembersDatabaseCommon::intern_tags().
+             *
+             * @returns A pointer to the tags of the member object if it is
+             *          available. Returns nullptr otherwise.
+             */
+            const osmium::TagList* get_member_tags(const osmium::RelationMember& member) const noexcept {
+                if (member.ref() == 0) {
+                    return nullptr;
+                }
+                return member_database(member.type()).get_tags(member.ref());
+            }
+
             /**
              * Get node with specified ID from members database.
              *
@@ -306,6 +338,27 @@ namespace osmium {
 
             SecondPassHandler<RelationsManager> m_handler_pass2;
 
+            // State of a relation in the relations database when nested
+            // relations are resolved. Indexed by the position in the
+            // relations database.
+            struct nested_relation {
+                std::size_t parents = 0; // number of relations waiting for this one
+                bool top_level = false; // accepted by new_relation()
+                bool complete = false;
+                unsigned char state = 0; // for depth-first search: new (0), on stack (1), done (2)
+            }; // struct nested_relation
+
+            bool m_resolve_nested = false;
+
+            // All relations from the first pass and their offsets in
+            // m_nested_pool, sorted by id before use. Only used when
+            // nested relations are resolved.
+            osmium::memory::Buffer m_nested_pool{};
+            std::vector<std::pair<osmium::object_id_type, std::size_t>> m_nested_pool_index;
+
+            std::vector<nested_relation> m_nested;
+            std::unordered_map<osmium::object_id_type, std::size_t> m_nested_pos;
+
             static bool wanted_type(osmium::item_type type) noexcept {
                 return (TNodes     && type == osmium::item_type::node) ||
                        (TWays      && type == osmium::item_type::way) ||
@@ -438,11 +491,38 @@ namespace osmium {
             void after_relation(const osmium::Relation& /*relation*/) const noexcept {
             }
 
+            /**
+             * This method is called before the output buffer is flushed
+             * or read.
+             *
+             * Overwrite this method in a derived class if it does some
+             * work asynchronously and has to add the results to the
+             * output buffer before it is handed out.
+             */
+            void finish_pending() const noexcept {
+            }
+
+            /**
+             * This method is called when resolving nested relations
+             * finds a cycle, ie. the member of a relation is the relation
+             * itself or one of its ancestors. The member is ignored.
+             *
+             * Overwrite this method in a derived class if you are
+             * interested in these cycles.
+             */
+            void nested_relation_cycle(const osmium::Relation& /*relation*/, const osmium::RelationMember& /*member*/) const noexcept {
+            }
+
             TManager& derived() noexcept {
                 return *static_cast<TManager*>(this);
             }
 
             void handle_complete_relation(RelationHandle& rel_handle) {
+                if (m_resolve_nested) {
+                    handle_complete_nested_relation(rel_handle);
+                    return;
+                }
+
                 derived().complete_relation(*rel_handle);
                 possibly_flush();
 
@@ -455,6 +535,237 @@ namespace osmium {
                 rel_handle.remove();
             }
 
+            // When resolving nested relations, a complete relation is
+            // added as member to all relations waiting for it. It is
+            // only removed together with its members when all of them
+            // are complete and removed.
+            void handle_complete_nested_relation(RelationHandle& rel_handle) {
+                const auto pos = rel_handle.pos();
+                m_nested[pos].complete = true;
+                if (m_nested[pos].top_level) {
+                    derived().complete_relation(*rel_handle);
+                    possibly_flush();
+                }
+
+                if (m_nested[pos].parents == 0) {
+                    release_nested_relation(pos);
+                    return;
+                }
+
+                // Copy the relation first, because adding it to the
+                // stash might move the original.
+                osmium::memory::Buffer copy{rel_handle->byte_size(), osmium::memory::Buffer::auto_grow::yes};
+                copy.add_item(*rel_handle);
+                copy.commit();
+                member_relations_database().add(copy.get<osmium::Relation>(0), [this](RelationHandle& parent_handle) {
+                    handle_complete_relation(parent_handle);
+                });
+            }
+
+            void release_nested_relation(std::size_t pos) {
+                auto rel_handle = relations_database()[pos];
+                const auto id = rel_handle->id();
+
+                std::vector<std::size_t> children;
+                for (const auto& member : rel_handle->members()) {
+                    if (member.ref() == 0) {
+                        continue;
+                    }
+                    member_database(member.type()).remove(member.ref(), id);
+                    if (member.type() == osmium::item_type::relation) {
+                        const auto it = m_nested_pos.find(member.ref());
+                        if (it != m_nested_pos.end()) {
+                            children.push_back(it->second);
+                        }
+                    }
+                }
+
+                rel_handle.remove();
+
+                for (const auto child : children) {
+                    auto& info = m_nested[child];
+                    assert(info.parents > 0);
+                    --info.parents;
+                    if (info.parents == 0 && info.complete) {
+                        release_nested_relation(child);
+                    }
+                }
+            }
+
+            // Add the relation with the specified id from the pool to the
+            // relations database if it isn't there already. Returns the
+            // position in the relations database or
+            // std::numeric_limits<std::size_t>::max() if there is no
+            // relation with this id.
+            std::size_t add_nested_relation(osmium::object_id_type id) {
+                const auto it = m_nested_pos.find(id);
+                if (it != m_nested_pos.end()) {
+                    return it->second;
+                }
+
+                const auto pit = std::lower_bound(m_nested_pool_index.cbegin(), m_nested_pool_index.cend(), std::make_pair(id, std::size_t{0}));
+                if (pit == m_nested_pool_index.cend() || pit->first != id) {
+                    return std::numeric_limits<std::size_t>::max();
+                }
+
+                const auto& relation = m_nested_pool.get<osmium::Relation>(pit->second);
+                auto rel_handle = relations_database().add(relation);
+                m_nested.emplace_back();
+                m_nested_pos.emplace(id, rel_handle.pos());
+
+                std::size_t n = 0;
+                for (auto& member : rel_handle->members()) {
+                    if (!wanted_type(member.type()) ||
+                        !derived().new_member(relation, member, n)) {
+                        member.set_ref(0);
+                    } else if (member.type() != osmium::item_type::relation) {
+                        member_database(member.type()).track(rel_handle, member.ref(), n);
+                    }
+                    ++n;
+                }
+
+                return rel_handle.pos();
+            }
+
+            void visit_nested_relation(std::size_t pos) {
+                m_nested[pos].state = 1;
+
+                std::vector<std::pair<osmium::object_id_type, std::size_t>> members;
+                std::size_t n = 0;
+                for (const auto& member : relations_database()[pos]->members()) {
+                    if (member.type() == osmium::item_type::relation && member.ref() != 0) {
+                        members.emplace_back(member.ref(), n);
+                    }
+                    ++n;
+                }
+
+                for (const auto& m : members) {
+                    // This might add relations to the stash, so the
+                    // relation handle is fetched again every time.
+                    const auto child = add_nested_relation(m.first);
+                    auto rel_handle = relations_database()[pos];
+                    if (child != std::numeric_limits<std::size_t>::max() && m_nested[child].state == 1) {
+                        auto& member = *std::next(rel_handle->members().begin(), static_cast<std::ptrdiff_t>(m.second));
+                        derived().nested_relation_cycle(*rel_handle, member);
+                        member.set_ref(0);
+                        continue;
+                    }
+                    member_relations_database().track(rel_handle, m.first, m.second);
+                    if (child != std::numeric_limits<std::size_t>::max()) {
+                        ++m_nested[child].parents;
+                        if (m_nested[child].state == 0) {
+                            visit_nested_relation(child);
+                        }
+                    }
+                }
+
+                m_nested[pos].state = 2;
+            }
+
+            void resolve_nested() {
+                std::sort(m_nested_pool_index.begin(), m_nested_pool_index.end());
+
+                const auto num_top_level = m_nested.size();
+                for (std::size_t pos = 0; pos < num_top_level; ++pos) {
+                    if (m_nested[pos].state == 0) {
+                        visit_nested_relation(pos);
+                    }
+                }
+
+                m_nested_pool = osmium::memory::Buffer{};
+                m_nested_pool_index.clear();
+                m_nested_pool_index.shrink_to_fit();
+            }
+
+            struct member_match {
+                std::size_t offset; // offset of object in buffer
+                std::size_t pos; // position in members database
+            }; // struct member_match
+
+            struct matched_buffer {
+                osmium::memory::Buffer buffer;
+                std::vector<member_match> matches;
+            }; // struct matched_buffer
+
+            // Task run in the thread pool by read_members_parallel(). It
+            // only reads the member ids from the members databases which
+            // don't change in the second pass.
+            class match_task {
+
+                const RelationsManagerBase* m_manager;
+                osmium::memory::Buffer m_buffer;
+
+                template <typename TObject>
+                static void check(const MembersDatabase<TObject>& db, const osmium::OSMObject& object, std::size_t offset, std::vector<member_match>& matches) {
+                    std::size_t pos = 0;
+                    if (db.find_position(object.id(), pos)) {
+                        matches.push_back(member_match{offset, pos});
+                    }
+                }
+
+            public:
+
+                match_task(const RelationsManagerBase* manager, osmium::memory::Buffer&& buffer) :
+                    m_manager(manager),
+                    m_buffer(std::move(buffer)) {
+                }
+
+                matched_buffer operator()() {
+                    matched_buffer result{std::move(m_buffer), {}};
+                    const unsigned char* data = result.buffer.data();
+                    for (const auto& object : result.buffer.template select<osmium::OSMObject>()) {
+                        const auto offset = static_cast<std::size_t>(reinterpret_cast<const unsigned char*>(&object) - data);
+                        switch (object.type()) {
+                            case osmium::item_type::node:
+                                if (TNodes) {
+                                    check(m_manager->member_nodes_database(), object, offset, result.matches);
+                                }
+                                break;
+                            case osmium::item_type::way:
+                                if (TWays) {
+                                    check(m_manager->member_ways_database(), object, offset, result.matches);
+                                }
+                                break;
+                            case osmium::item_type::relation:
+                                if (TRelations) {
+                                    check(m_manager->member_relations_database(), object, offset, result.matches);
+                                }
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                    return result;
+                }
+
+            }; // class match_task
+
+            void handle_matched_buffer(const matched_buffer& input) {
+                const unsigned char* data = input.buffer.data();
+                auto match = input.matches.cbegin();
+                for (const auto& object : input.buffer.template select<osmium::OSMObject>()) {
+                    const auto offset = static_cast<std::size_t>(reinterpret_cast<const unsigned char*>(&object) - data);
+                    const bool found = match != input.matches.cend() && match->offset == offset;
+                    const std::size_t pos = found ? match->pos : 0;
+                    if (found) {
+                        ++match;
+                    }
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            handle_node(static_cast<const osmium::Node&>(object), found, pos);
+                            break;
+                        case osmium::item_type::way:
+                            handle_way(static_cast<const osmium::Way&>(object), found, pos);
+                            break;
+                        case osmium::item_type::relation:
+                            handle_relation(static_cast<const osmium::Relation&>(object), found, pos);
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+
         public:
 
             RelationsManager() :
@@ -471,6 +782,32 @@ namespace osmium {
                 return m_handler_pass2;
             }
 
+            /**
+             * Resolve relation members recursively. Relations which are
+             * members of relations accepted by new_relation(), and their
+             * members in turn, are tracked, too, with new_member() called
+             * for their members. A relation is only complete when all its
+             * member relations are complete. Inside complete_relation()
+             * the member relations and their members are available with
+             * get_member_relation(), get_member_way() etc. Cycles in the
+             * relation graph are detected and reported to
+             * nested_relation_cycle(), the member closing the cycle is
+             * ignored.
+             *
+             * Only relations accepted by new_relation() are handed to
+             * complete_relation() and for_each_incomplete_relation().
+             *
+             * This keeps a copy of all relations in the first pass in
+             * memory until prepare_for_lookup() is called. It must be
+             * called before the first pass.
+             */
+            void resolve_nested_relations() {
+                static_assert(TRelations, "Resolving nested relations needs the TRelations template parameter set.");
+                assert(relations_database().size() == 0 && "Call resolve_nested_relations() before the first pass.");
+                m_resolve_nested = true;
+                m_nested_pool = osmium::memory::Buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+            }
+
             /**
              * Add the specified relation to the list of relations we want to
              * build. This calls the new_relation() and new_member()
@@ -482,14 +819,28 @@ namespace osmium {
              * @param relation Relation we might want to build.
              */
             void relation(const osmium::Relation& relation) {
+                if (m_resolve_nested) {
+                    m_nested_pool_index.emplace_back(relation.id(), m_nested_pool.committed());
+                    m_nested_pool.add_item(relation);
+                    m_nested_pool.commit();
+                }
+
                 if (derived().new_relation(relation)) {
                     auto rel_handle = relations_database().add(relation);
+                    if (m_resolve_nested) {
+                        m_nested.emplace_back();
+                        m_nested.back().top_level = true;
+                        m_nested_pos.emplace(relation.id(), rel_handle.pos());
+                    }
 
                     std::size_t n = 0;
                     for (auto& member : rel_handle->members()) {
                         if (wanted_type(member.type()) &&
                             derived().new_member(relation, member, n)) {
-                            member_database(member.type()).track(rel_handle, member.ref(), n);
+                            // Member relations are tracked in resolve_nested().
+                            if (!m_resolve_nested || member.type() != osmium::item_type::relation) {
+                                member_database(member.type()).track(rel_handle, member.ref(), n);
+                            }
                         } else {
                             member.set_ref(0); // set member id to zero to indicate we are not interested
                         }
@@ -499,13 +850,22 @@ namespace osmium {
             }
 
             void handle_node(const osmium::Node& node) {
+                if (TNodes) {
+                    std::size_t pos = 0;
+                    const bool found = member_nodes_database().find_position(node.id(), pos);
+                    handle_node(node, found, pos);
+                }
+            }
+
+            void handle_node(const osmium::Node& node, bool found, std::size_t pos) {
                 if (TNodes) {
                     m_check_order_handler.node(node);
                     derived().before_node(node);
-                    const bool added = member_nodes_database().add(node, [this](RelationHandle& rel_handle) {
-                        handle_complete_relation(rel_handle);
-                    });
-                    if (!added) {
+                    if (found) {
+                        member_nodes_database().add_at(pos, node, [this](RelationHandle& rel_handle) {
+                            handle_complete_relation(rel_handle);
+                        });
+                    } else {
                         derived().node_not_in_any_relation(node);
                     }
                     derived().after_node(node);
@@ -514,13 +874,22 @@ namespace osmium {
             }
 
             void handle_way(const osmium::Way& way) {
+                if (TWays) {
+                    std::size_t pos = 0;
+                    const bool found = member_ways_database().find_position(way.id(), pos);
+                    handle_way(way, found, pos);
+                }
+            }
+
+            void handle_way(const osmium::Way& way, bool found, std::size_t pos) {
                 if (TWays) {
                     m_check_order_handler.way(way);
                     derived().before_way(way);
-                    const bool added = member_ways_database().add(way, [this](RelationHandle& rel_handle) {
-                        handle_complete_relation(rel_handle);
-                    });
-                    if (!added) {
+                    if (found) {
+                        member_ways_database().add_at(pos, way, [this](RelationHandle& rel_handle) {
+                            handle_complete_relation(rel_handle);
+                        });
+                    } else {
                         derived().way_not_in_any_relation(way);
                     }
                     derived().after_way(way);
@@ -529,13 +898,25 @@ namespace osmium {
             }
 
             void handle_relation(const osmium::Relation& relation) {
+                if (TRelations) {
+                    std::size_t pos = 0;
+                    const bool found = member_relations_database().find_position(relation.id(), pos);
+                    handle_relation(relation, found, pos);
+                }
+            }
+
+            void handle_relation(const osmium::Relation& relation, bool found, std::size_t pos) {
                 if (TRelations) {
                     m_check_order_handler.relation(relation);
                     derived().before_relation(relation);
-                    const bool added = member_relations_database().add(relation, [this](RelationHandle& rel_handle) {
-                        handle_complete_relation(rel_handle);
-                    });
-                    if (!added) {
+                    if (found) {
+                        // Nested relations are added when they are complete.
+                        if (!m_resolve_nested) {
+                            member_relations_database().add_at(pos, relation, [this](RelationHandle& rel_handle) {
+                                handle_complete_relation(rel_handle);
+                            });
+                        }
+                    } else {
                         derived().relation_not_in_any_relation(relation);
                     }
                     derived().after_relation(relation);
@@ -543,6 +924,85 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Sort the members databases to prepare them for reading. Usually
+             * this is called between the first and second pass reading through
+             * an OSM data file. When nested relations are resolved, this
+             * also builds the relation graph from the first pass. Nested
+             * relations without any members needed are complete right
+             * away.
+             */
+            void prepare_for_lookup() {
+                if (m_resolve_nested) {
+                    resolve_nested();
+                }
+
+                RelationsManagerBase::prepare_for_lookup();
+
+                if (m_resolve_nested) {
+                    for (std::size_t pos = 0; pos < m_nested.size(); ++pos) {
+                        auto rel_handle = relations_database()[pos];
+                        if (!m_nested[pos].top_level && !m_nested[pos].complete && rel_handle.has_all_members()) {
+                            handle_complete_relation(rel_handle);
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Do the second pass through the data reading buffers from
+             * the source (usually an osmium::io::Reader) until it returns
+             * an invalid buffer. This does the same as applying the
+             * handler() to the source, but the members databases are
+             * searched for each object in the thread pool. Only adding
+             * the members found to the stash and calling the callbacks
+             * (before_node(), complete_relation(), etc.) is done in the
+             * thread calling this function, in the order of the input.
+             * After all buffers are handled, flush_output() is called.
+             *
+             * @param source Object with a read() function returning
+             *               buffers.
+             * @param pool The thread pool for the lookups.
+             * @param max_pending Maximum number of buffers handed to the
+             *                    pool but not yet handled. Default
+             *                    (0) is twice the number of threads in
+             *                    the pool.
+             */
+            template <typename TSource>
+            void read_members_parallel(TSource& source, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(), std::size_t max_pending = 0) {
+                if (max_pending == 0) {
+                    max_pending = static_cast<std::size_t>(pool.num_threads()) * 2;
+                }
+
+                std::deque<std::future<matched_buffer>> pending;
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    pending.push_back(pool.submit(match_task{this, std::move(buffer)}));
+                    if (pending.size() > max_pending) {
+                        handle_matched_buffer(pending.front().get());
+                        pending.pop_front();
+                    }
+                }
+
+                while (!pending.empty()) {
+                    handle_matched_buffer(pending.front().get());
+                    pending.pop_front();
+                }
+
+                flush_output();
+            }
+
+            /// Flush the output buffer.
+            void flush_output() {
+                derived().finish_pending();
+                RelationsManagerBase::flush_output();
+            }
+
+            /// Return the contents of the output buffer.
+            osmium::memory::Buffer read() {
+                derived().finish_pending();
+                return RelationsManagerBase::read();
+            }
+
             /**
              * Call this function it will call your function back for every
              * incomplete relation, that is all relations that have missing
@@ -553,7 +1013,16 @@ namespace osmium {
              */
             template <typename TFunc>
             void for_each_incomplete_relation(TFunc&& func) {
-                relations_database().for_each_relation(std::forward<TFunc>(func));
+                if (!m_resolve_nested) {
+                    relations_database().for_each_relation(std::forward<TFunc>(func));
+                    return;
+                }
+                relations_database().for_each_relation([&](RelationHandle rel_handle) {
+                    const auto& info = m_nested[rel_handle.pos()];
+                    if (info.top_level && !info.complete) {
+                        std::forward<TFunc>(func)(rel_handle);
+                    }
+                });
             }
 
         }; // class RelationsManager
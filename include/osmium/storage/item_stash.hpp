@@ -33,15 +33,47 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/memory/budget.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/compact_node_ref_list.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#ifdef OSMIUM_WITH_LZ4
+# include <osmium/io/detail/lz4.hpp>
+#endif
+
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
 # include <iostream>
 # include <chrono>
@@ -53,6 +85,16 @@ namespace osmium {
      * Class for storing OSM data in memory. Any osmium::memory::Item can be
      * added to the stash and it will be copied into its internal Buffer. To
      * access the item again, an opaque handle is used.
+     *
+     * If the stash gets too large, it can spill the oldest parts of the
+     * data to a temporary file which is memory mapped. See
+     * set_max_memory(). If compiled with LZ4 support, the oldest parts
+     * can be compressed in memory instead, see enable_compression().
+     *
+     * OSM objects can be added with add_object_interning_tags() which
+     * stores tag lists occurring several times only once, see there.
+     * Ways can be added with add_way_compacting_nodes() which stores
+     * their node lists delta encoded, see there.
      */
     class ItemStash {
 
@@ -116,99 +158,707 @@ namespace osmium {
     private:
 
         enum {
-            initial_buffer_size = 1024UL * 1024UL
+            segment_size = 1024UL * 1024UL
         };
 
-        enum {
-            removed_item_offset = std::numeric_limits<std::size_t>::max()
+        enum : uint64_t {
+            removed_item_location = std::numeric_limits<uint64_t>::max()
         };
 
-        osmium::memory::Buffer m_buffer;
-        std::vector<std::size_t> m_index;
+        // The items are stored in segments, each with its own buffer.
+        // Segments whose items are all removed are freed right away,
+        // sparse segments are compacted one at a time by moving their
+        // remaining items into the current segment.
+        struct segment {
+            osmium::memory::Buffer buffer{};
+
+            // Set if this segment was spilled to disk. The buffer works
+            // on this mapping then.
+            std::unique_ptr<osmium::util::MemoryMapping> mapping{};
+            std::size_t file_offset = 0;
+
+            // Set if this segment was compressed. The buffer is invalid
+            // then, the items are decompressed into the cache on access.
+            std::string compressed{};
+            std::size_t raw_capacity = 0;
+            std::size_t raw_size = 0;
+
+            // Handle values of all items added to this segment in order.
+            std::vector<std::size_t> handles{};
+
+            std::size_t count_items = 0;
+            std::size_t count_removed = 0;
+        }; // struct segment
+
+        // Temporary file for segments spilled to disk.
+        class spill_file {
+
+            int m_fd;
+            std::size_t m_size = 0;
+
+            // Offsets of freed standard size regions in the file.
+            std::vector<std::size_t> m_free;
+
+        public:
+
+            spill_file() :
+                m_fd(osmium::detail::create_tmp_file()) {
+            }
+
+            spill_file(const spill_file&) = delete;
+            spill_file& operator=(const spill_file&) = delete;
+
+            spill_file(spill_file&&) = delete;
+            spill_file& operator=(spill_file&&) = delete;
+
+            ~spill_file() noexcept {
+#ifdef _WIN32
+                _close(m_fd);
+#else
+                ::close(m_fd);
+#endif
+            }
+
+            int fd() const noexcept {
+                return m_fd;
+            }
+
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            std::size_t allocate(std::size_t size) {
+                if (size == region_size(segment_size) && !m_free.empty()) {
+                    const auto offset = m_free.back();
+                    m_free.pop_back();
+                    return offset;
+                }
+                const auto offset = m_size;
+                m_size += size;
+                return offset;
+            }
+
+            void free(std::size_t offset, std::size_t size) {
+                // Only standard size regions are reused, the others are
+                // lost until the stash is destroyed.
+                if (size == region_size(segment_size)) {
+                    m_free.push_back(offset);
+                }
+            }
+
+        }; // class spill_file
+
+        // Mappings must start at page boundaries in the file.
+        static std::size_t region_size(std::size_t size) noexcept {
+            const std::size_t page_size = osmium::get_pagesize();
+            return (size + page_size - 1) / page_size * page_size;
+        }
+
+        std::vector<segment> m_segments;
+
+        // Segments which have been freed and can be reused.
+        std::vector<std::size_t> m_free_segments;
+
+        // Location of the item for each handle: segment number in upper
+        // 32 bits, offset into the segment buffer in lower 32 bits.
+        std::vector<uint64_t> m_index;
+
+        std::size_t m_current = 0;
+        std::size_t m_gc_cursor = 0;
+
+        // Maximum memory for segments in RAM, 0 means unlimited.
+        std::size_t m_max_memory = 0;
+
+        // Memory used by segments in RAM.
+        std::size_t m_memory = 0;
+
+        // Segments are spilled in the order they were created in.
+        std::size_t m_spill_cursor = 0;
+
+        std::unique_ptr<spill_file> m_spill_file;
+
+        // Decompressed copies of compressed segments. Entries are only
+        // evicted by calls modifying the stash (see trim_cache()), so
+        // that references returned by get_item() for items in different
+        // compressed segments can be used at the same time.
+        struct cache_entry {
+            std::size_t segment = std::numeric_limits<std::size_t>::max();
+            osmium::memory::Buffer buffer{};
+            uint64_t last_use = 0;
+        }; // struct cache_entry
+
+        // Mutex protecting the cache, so that the stash can be read from
+        // several threads at the same time. Copying or moving the stash
+        // creates a new mutex.
+        struct cache_mutex {
+            std::mutex mutex{};
+
+            cache_mutex() = default;
+
+            cache_mutex(const cache_mutex& /*other*/) noexcept {
+            }
+
+            cache_mutex(cache_mutex&& /*other*/) noexcept {
+            }
+
+            cache_mutex& operator=(const cache_mutex& /*other*/) noexcept {
+                return *this;
+            }
+
+            cache_mutex& operator=(cache_mutex&& /*other*/) noexcept {
+                return *this;
+            }
+
+            ~cache_mutex() noexcept = default;
+        }; // struct cache_mutex
+
+        mutable std::vector<cache_entry> m_cache;
+        mutable uint64_t m_cache_clock = 0;
+        mutable cache_mutex m_cache_mutex;
+
+        // Number of decompressed segments in the cache, 0 means that
+        // compression is disabled.
+        std::size_t m_cache_size = 0;
+
+        // Interned tag lists: handle value of the tag list item to its
+        // hash and the number of objects using it.
+        struct interned_tag_list {
+            std::size_t hash;
+            std::size_t refs;
+        }; // struct interned_tag_list
+
+        std::unordered_map<std::size_t, interned_tag_list> m_interned_tags;
+
+        // Hash of the interned tag lists to their handle values.
+        std::unordered_multimap<std::size_t, std::size_t> m_tags_by_hash;
+
+        // Handle values of objects added with add_object_interning_tags()
+        // to the handle values of their tag lists.
+        std::unordered_map<std::size_t, std::size_t> m_object_tags;
+
+        // Delta encoded node lists of ways added with
+        // add_way_compacting_nodes(), one after the other.
+        std::vector<unsigned char> m_node_data;
+
+        // Bytes in m_node_data used by node lists of removed ways.
+        std::size_t m_node_data_removed = 0;
+
+        // Position and size of a node list in m_node_data.
+        struct node_list_pos {
+            std::size_t offset;
+            std::size_t size;
+        }; // struct node_list_pos
+
+        // Handle values of ways added with add_way_compacting_nodes() to
+        // their node lists.
+        std::unordered_map<std::size_t, node_list_pos> m_way_nodes;
+
+        // Used for building copies of objects without their tag list.
+        osmium::memory::Buffer m_scratch{1024, osmium::memory::Buffer::auto_grow::yes};
+
+        // Account for the memory of segments in RAM in a memory budget.
+        osmium::memory::MemoryBudget::account m_budget_account;
         std::size_t m_count_items = 0;
         std::size_t m_count_removed = 0;
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
         int64_t m_gc_time = 0;
 #endif
 
-        class cleanup_helper {
+        static uint64_t location(std::size_t segment_num, std::size_t offset) noexcept {
+            assert(segment_num < (1ULL << 32U));
+            assert(offset < (1ULL << 32U));
+            return (static_cast<uint64_t>(segment_num) << 32U) | offset;
+        }
+
+        static std::size_t location_segment(uint64_t loc) noexcept {
+            return static_cast<std::size_t>(loc >> 32U);
+        }
 
-            std::vector<std::size_t>& m_index;
-            std::size_t m_pos = 0;
+        static std::size_t location_offset(uint64_t loc) noexcept {
+            return static_cast<std::size_t>(loc & 0xffffffffULL);
+        }
 
-        public:
+        uint64_t get_item_location(handle_type handle) const noexcept {
+            assert(handle.valid() && "handle must be valid");
+            assert(handle.value <= m_index.size());
+            const auto loc = m_index[handle.value - 1];
+            assert(loc != removed_item_location);
+            assert(location_segment(loc) < m_segments.size());
+            assert(location_offset(loc) < committed(m_segments[location_segment(loc)]));
+            return loc;
+        }
+
+        static std::size_t committed(const segment& seg) noexcept {
+            return seg.compressed.empty() ? seg.buffer.committed() : seg.raw_size;
+        }
+
+        // Get the item at the offset in the decompressed data of the
+        // segment from the cache, decompressing the segment if it isn't
+        // there. This never evicts other segments, so the cache can grow
+        // larger than m_cache_size until trim_cache() is called. When
+        // m_cache grows, the cache entries move, but the data of their
+        // buffers doesn't. So the item is looked up while holding the
+        // lock and the reference to it stays valid afterwards.
+        osmium::memory::Item& cached_item(std::size_t num, std::size_t offset) const {
+            const std::lock_guard<std::mutex> lock{m_cache_mutex.mutex};
+            for (auto& entry : m_cache) {
+                if (entry.segment == num) {
+                    entry.last_use = ++m_cache_clock;
+                    return entry.buffer.get<osmium::memory::Item>(offset);
+                }
+            }
+
+            auto it = std::find_if(m_cache.begin(), m_cache.end(), [](const cache_entry& e) {
+                return e.segment == std::numeric_limits<std::size_t>::max();
+            });
+            if (it == m_cache.end()) {
+                m_cache.emplace_back();
+                it = std::prev(m_cache.end());
+            }
+            auto& entry = *it;
+
+            const auto& seg = m_segments[num];
+            if (entry.buffer.capacity() != seg.raw_capacity) {
+                entry.buffer = osmium::memory::Buffer{seg.raw_capacity, osmium::memory::Buffer::auto_grow::no};
+            }
+            entry.buffer.clear();
+            entry.segment = num;
+            entry.last_use = ++m_cache_clock;
+#ifdef OSMIUM_WITH_LZ4
+            auto* data = entry.buffer.reserve_space(seg.raw_size);
+            osmium::io::detail::lz4_uncompress(seg.compressed.data(), seg.compressed.size(), seg.raw_size, reinterpret_cast<char*>(data));
+            entry.buffer.commit();
+#else
+            assert(false && "compressed segments need LZ4 support");
+#endif
+            return entry.buffer.get<osmium::memory::Item>(offset);
+        }
 
-            explicit cleanup_helper(std::vector<std::size_t>& index) :
-                m_index(index) {
+        // Evict the least recently used segments from the cache until at
+        // most m_cache_size are left. Must only be called from functions
+        // which are documented to invalidate references into the stash.
+        void trim_cache() {
+            if (m_cache.size() <= m_cache_size) {
+                return;
             }
+            std::sort(m_cache.begin(), m_cache.end(), [](const cache_entry& a, const cache_entry& b) {
+                return a.last_use > b.last_use;
+            });
+            m_cache.resize(m_cache_size);
+        }
 
-            void moving_in_buffer(std::size_t old_offset, std::size_t new_offset) {
-                while (m_index[m_pos] != old_offset) {
-                    ++m_pos;
-                    assert(m_pos < m_index.size());
+        void uncache_segment(std::size_t num) noexcept {
+            for (auto& entry : m_cache) {
+                if (entry.segment == num) {
+                    entry.segment = std::numeric_limits<std::size_t>::max();
+                    entry.last_use = 0;
                 }
-                m_index[m_pos] = new_offset;
-                ++m_pos;
             }
+        }
 
-        }; // cleanup_helper
+        osmium::memory::Item& item_at(uint64_t loc) const {
+            const auto num = location_segment(loc);
+            const auto& seg = m_segments[num];
+            if (seg.compressed.empty()) {
+                return seg.buffer.get<osmium::memory::Item>(location_offset(loc));
+            }
+            return cached_item(num, location_offset(loc));
+        }
 
-        std::size_t& get_item_offset_ref(handle_type handle) noexcept {
-            assert(handle.valid() && "handle must be valid");
-            assert(handle.value <= m_index.size());
-            auto& offset = m_index[handle.value - 1];
-            assert(offset != removed_item_offset);
-            assert(offset < m_buffer.committed());
-            return offset;
+        void start_segment(std::size_t min_size) {
+            std::size_t num = m_segments.size();
+            if (m_free_segments.empty()) {
+                m_segments.emplace_back();
+            } else {
+                num = m_free_segments.back();
+                m_free_segments.pop_back();
+            }
+            m_segments[num].buffer = osmium::memory::Buffer{std::max(static_cast<std::size_t>(segment_size), min_size), osmium::memory::Buffer::auto_grow::no};
+            m_memory += m_segments[num].buffer.capacity();
+            m_budget_account.set(m_memory);
+            m_current = num;
         }
 
-        std::size_t get_item_offset(handle_type handle) const noexcept {
-            assert(handle.valid() && "handle must be valid");
-            assert(handle.value <= m_index.size());
-            const auto& offset = m_index[handle.value - 1];
-            assert(offset != removed_item_offset);
-            assert(offset < m_buffer.committed());
-            return offset;
-        }
-
-        // This function decides whether it makes sense to garbage collect the
-        // database. The values here are the result of some experimentation
-        // with real data. We need to balance the memory use with the time
-        // spent on garbage collecting. We don't need to garbage collect if
-        // there is enough space in the buffer anyway (*4). On the other hand,
-        // if there aren't enough removed objects we would just call the
-        // garbage collection again and again, then it is better to let the
-        // buffer grow (*3). The checks (*1) and (*2) make sure there is
-        // minimum and maximum for the number of removed objects.
-        bool should_gc() const noexcept {
-            if (m_count_removed < 10 * 1000) { // *1
-                return false;
+        void free_segment(std::size_t num) {
+            assert(num != m_current);
+            assert(m_segments[num].count_items == 0);
+            auto& seg = m_segments[num];
+            m_count_removed -= seg.count_removed;
+            if (seg.mapping) {
+                m_spill_file->free(seg.file_offset, seg.mapping->size());
+            } else if (!seg.compressed.empty()) {
+                uncache_segment(num);
+                m_memory -= seg.compressed.size();
+                m_budget_account.set(m_memory);
+            } else {
+                m_memory -= seg.buffer.capacity();
+                m_budget_account.set(m_memory);
+            }
+            seg = segment{};
+            m_free_segments.push_back(num);
+        }
+
+        // Move the segment into the spill file. The data is copied into a
+        // mapping of the file and the memory is freed.
+        void spill_segment(std::size_t num) {
+            assert(num != m_current);
+            if (!m_spill_file) {
+                m_spill_file.reset(new spill_file{});
             }
-            if (m_count_removed >  5 * 1000 * 1000) { // *2
+            auto& seg = m_segments[num];
+            const std::size_t capacity = seg.buffer.capacity();
+            const std::size_t size = region_size(capacity);
+            const std::size_t offset = m_spill_file->allocate(size);
+
+            std::unique_ptr<osmium::util::MemoryMapping> mapping{new osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::write_shared, m_spill_file->fd(), static_cast<off_t>(offset)}};
+            auto* data = mapping->get_addr<unsigned char>();
+            std::copy_n(seg.buffer.data(), seg.buffer.committed(), data);
+
+            seg.buffer = osmium::memory::Buffer{data, capacity, seg.buffer.committed()};
+            seg.mapping = std::move(mapping);
+            seg.file_offset = offset;
+            m_memory -= capacity;
+            m_budget_account.set(m_memory);
+        }
+
+#ifdef OSMIUM_WITH_LZ4
+        // Compress the segment with LZ4 and free the uncompressed memory.
+        void compress_segment(std::size_t num) {
+            assert(num != m_current);
+            auto& seg = m_segments[num];
+            const std::size_t capacity = seg.buffer.capacity();
+            const std::size_t size = seg.buffer.committed();
+
+            std::string compressed = osmium::io::detail::lz4_compress(reinterpret_cast<const char*>(seg.buffer.data()), size);
+            compressed.shrink_to_fit();
+
+            seg.compressed = std::move(compressed);
+            seg.raw_capacity = capacity;
+            seg.raw_size = size;
+            seg.buffer = osmium::memory::Buffer{};
+            m_memory -= capacity;
+            m_memory += seg.compressed.size();
+            m_budget_account.set(m_memory);
+        }
+#endif
+
+        bool over_memory_limit() const noexcept {
+            if (m_max_memory != 0 && m_memory > m_max_memory) {
                 return true;
             }
-            if (m_count_removed * 5 < m_count_items) { // *3
+            return m_budget_account.valid() && m_budget_account.budget()->exceeded();
+        }
+
+        // Spill the oldest segments in RAM to disk (or compress them if
+        // compression is enabled) until the memory limit is reached and
+        // the memory budget (if any) is not exceeded. This must not be
+        // called while a segment is being compacted, because it frees the
+        // memory of the segment.
+        void spill_if_needed() {
+            while (over_memory_limit()) {
+                std::size_t i = 0;
+                for (; i < m_segments.size(); ++i) {
+                    const std::size_t num = (m_spill_cursor + i) % m_segments.size();
+                    const auto& seg = m_segments[num];
+                    if (num != m_current && seg.buffer && !seg.mapping) {
+                        m_spill_cursor = num + 1;
+#ifdef OSMIUM_WITH_LZ4
+                        if (m_cache_size > 0) {
+                            compress_segment(num);
+                            break;
+                        }
+#endif
+                        spill_segment(num);
+                        break;
+                    }
+                }
+                if (i == m_segments.size()) {
+                    return;
+                }
+            }
+        }
+
+        // Copy item into the current segment (starting a new one if
+        // needed) and record it under the given handle value.
+        void append_item(const osmium::memory::Item& item, std::size_t handle_value) {
+            const std::size_t size = item.padded_size();
+            if (m_segments.empty() ||
+                m_segments[m_current].buffer.capacity() - m_segments[m_current].buffer.committed() < size) {
+                start_segment(size);
+            }
+            auto& seg = m_segments[m_current];
+            const auto offset = seg.buffer.committed();
+            seg.buffer.add_item(item);
+            seg.buffer.commit();
+            seg.handles.push_back(handle_value);
+            ++seg.count_items;
+            m_index[handle_value - 1] = location(m_current, offset);
+        }
+
+        // Add the item without counting it in size().
+        handle_type insert_item(const osmium::memory::Item& item) {
+            if (m_segments.empty() ||
+                m_segments[m_current].buffer.capacity() - m_segments[m_current].buffer.committed() < item.padded_size()) {
+                start_segment(item.padded_size());
+                if (should_gc()) {
+                    garbage_collect_step();
+                }
+                spill_if_needed();
+            }
+            m_index.push_back(0);
+            append_item(item, m_index.size());
+            return handle_type{m_index.size()};
+        }
+
+        // Remove the item without counting it in size().
+        void erase_item(handle_type handle) {
+            const auto loc = get_item_location(handle);
+            const auto num = location_segment(loc);
+            auto& seg = m_segments[num];
+
+            // The items in compressed segments are not changed, the index
+            // is enough to know which items are removed.
+            if (seg.compressed.empty()) {
+                auto& item = item_at(loc);
+                assert(!item.removed() && "can not call remove_item() on already removed item");
+                item.set_removed(true);
+            }
+            m_index[handle.value - 1] = removed_item_location;
+            ++m_count_removed;
+
+            --seg.count_items;
+            ++seg.count_removed;
+            if (seg.count_items == 0 && num != m_current) {
+                free_segment(num);
+            }
+        }
+
+        // FNV-1a hash over the bytes of the tag list.
+        static std::size_t hash_tags(const osmium::TagList& tags) noexcept {
+            uint64_t hash = 14695981039346656037ULL;
+            const auto* data = tags.data();
+            for (const auto* end = data + tags.byte_size(); data != end; ++data) {
+                hash ^= *data;
+                hash *= 1099511628211ULL;
+            }
+            return static_cast<std::size_t>(hash);
+        }
+
+        // Find the tag list in the interned tag lists or add it. Returns
+        // the handle value of the interned tag list.
+        std::size_t intern_tags(const osmium::TagList& tags) {
+            const auto hash = hash_tags(tags);
+            const auto range = m_tags_by_hash.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                const auto& interned = get<osmium::TagList>(handle_type{it->second});
+                if (interned.byte_size() == tags.byte_size() &&
+                    std::memcmp(interned.data(), tags.data(), tags.byte_size()) == 0) {
+                    ++m_interned_tags[it->second].refs;
+                    return it->second;
+                }
+            }
+
+            const auto handle = insert_item(tags);
+            m_interned_tags.emplace(handle.value, interned_tag_list{hash, 1});
+            m_tags_by_hash.emplace(hash, handle.value);
+            return handle.value;
+        }
+
+        void release_tags(std::size_t handle_value) {
+            const auto it = m_interned_tags.find(handle_value);
+            assert(it != m_interned_tags.end());
+            if (--it->second.refs > 0) {
+                return;
+            }
+            const auto range = m_tags_by_hash.equal_range(it->second.hash);
+            for (auto hit = range.first; hit != range.second; ++hit) {
+                if (hit->second == handle_value) {
+                    m_tags_by_hash.erase(hit);
+                    break;
+                }
+            }
+            m_interned_tags.erase(it);
+            erase_item(handle_type{handle_value});
+        }
+
+        template <typename TBuilder, typename T>
+        void copy_without_tags(const osmium::OSMObject& object) {
+            {
+                TBuilder builder{m_scratch};
+                builder.copy_attributes(static_cast<const T&>(object));
+                builder.copy_subitems_except_tags(static_cast<const T&>(object));
+            }
+            m_scratch.commit();
+        }
+
+        void release_nodes(std::size_t handle_value) {
+            const auto it = m_way_nodes.find(handle_value);
+            if (it == m_way_nodes.end()) {
+                return;
+            }
+            m_node_data_removed += it->second.size;
+            m_way_nodes.erase(it);
+
+            // Compact the node data once most of it is unused.
+            if (m_node_data_removed > 64 * 1024 && m_node_data_removed > m_node_data.size() / 2) {
+                std::vector<unsigned char> data;
+                data.reserve(m_node_data.size() - m_node_data_removed);
+                for (auto& entry : m_way_nodes) {
+                    const auto begin = m_node_data.cbegin() + static_cast<std::ptrdiff_t>(entry.second.offset);
+                    entry.second.offset = data.size();
+                    data.insert(data.end(), begin, begin + static_cast<std::ptrdiff_t>(entry.second.size));
+                }
+                m_node_data.swap(data);
+                m_node_data_removed = 0;
+            }
+        }
+
+        // Move all remaining items out of the segment and free it.
+        void compact_segment(std::size_t num) {
+            assert(num != m_current);
+            for (std::size_t i = 0; i < m_segments[num].handles.size(); ++i) {
+                const std::size_t handle_value = m_segments[num].handles[i];
+                const auto loc = m_index[handle_value - 1];
+                if (loc != removed_item_location) {
+                    assert(location_segment(loc) == num);
+                    append_item(item_at(loc), handle_value);
+                    --m_segments[num].count_items;
+                }
+            }
+            free_segment(num);
+        }
+
+        // This function decides whether it makes sense to compact a
+        // segment. We need to balance the memory use with the time spent
+        // on moving items. If there aren't enough removed objects (*1) or
+        // only a small fraction of items are removed (*2) it isn't worth
+        // it.
+        bool should_gc() const noexcept {
+            if (m_count_removed < 10 * 1000) { // *1
                 return false;
             }
-            return m_buffer.capacity() - m_buffer.committed() < 10 * 1024; // *4
+            return m_count_removed * 5 >= m_count_items; // *2
+        }
+
+        // Compact the next segment (starting at the cursor) where at least
+        // half of the items are removed.
+        void garbage_collect_step() {
+            for (std::size_t i = 0; i < m_segments.size(); ++i) {
+                const std::size_t num = (m_gc_cursor + i) % m_segments.size();
+                const auto& seg = m_segments[num];
+                if (num != m_current && seg.buffer && seg.count_removed > 0 && seg.count_removed >= seg.count_items) {
+                    m_gc_cursor = num + 1;
+                    compact_segment(num);
+                    return;
+                }
+            }
         }
 
     public:
 
-        ItemStash() :
-            m_buffer(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes) {
+        ItemStash() = default;
+
+        /**
+         * Spill data to a temporary file if the segments in memory use
+         * more than the given number of bytes. The oldest segments are
+         * moved into the file first. The file is memory mapped, so
+         * access to spilled items works as before, but might be slower
+         * if the operating system has to read the data back from disk.
+         *
+         * The handles and index of the stash always stay in memory.
+         *
+         * @param max_memory Maximum number of bytes of item data in
+         *                   memory. 0 means no limit (the default).
+         */
+        void set_max_memory(std::size_t max_memory) {
+            m_max_memory = max_memory;
+            spill_if_needed();
+        }
+
+#ifdef OSMIUM_WITH_LZ4
+        /**
+         * Compress the oldest segments with LZ4 instead of spilling them
+         * to disk when the limit set with set_max_memory() or the memory
+         * budget is exceeded. OSM data usually compresses to a third or
+         * less of its size. Compressed segments are never spilled.
+         *
+         * Accessing an item in a compressed segment decompresses the
+         * whole segment into a cache, so this works best if the items
+         * in old segments are rarely accessed. Decompressed segments are
+         * only evicted from the cache by calls that invalidate references
+         * into the stash anyway (add_item(), remove_item(),
+         * garbage_collect(), and clear()). So references returned by
+         * get_item() and get<>() stay valid as usual, even if more than
+         * cache_size compressed segments are accessed in between. In that
+         * case the cache temporarily uses more memory. Reading from
+         * several threads at the same time is safe.
+         *
+         * Call this before adding any items. Only available if compiled
+         * with LZ4 support (OSMIUM_WITH_LZ4 defined).
+         *
+         * @param cache_size Number of decompressed segments (of 1 MByte
+         *                   each) kept in memory between modifications.
+         *                   Must be at least 1.
+         */
+        void enable_compression(std::size_t cache_size = 4) {
+            assert(cache_size > 0);
+            m_cache_size = cache_size;
+            spill_if_needed();
+        }
+#endif
+
+        /**
+         * Account for the memory of the segments in RAM in the given
+         * memory budget. Whenever the budget is exceeded (because of this
+         * stash or any other component using the budget) the oldest
+         * segments are spilled to disk like with set_max_memory(). The
+         * budget must outlive the stash.
+         *
+         * @param budget The memory budget.
+         * @param name Name of this stash in the budget report.
+         */
+        void set_memory_budget(osmium::memory::MemoryBudget& budget, const char* name = "item_stash") {
+            m_budget_account = budget.add_account(name);
+            m_budget_account.set(m_memory);
+            spill_if_needed();
         }
 
         /**
          * Return an estimate of the number of bytes currently used by this
-         * ItemStash instance.
+         * ItemStash instance. Data spilled to disk is not counted.
          *
-         * Complexity: Constant.
+         * Complexity: Linear in the number of segments.
          */
         std::size_t used_memory() const noexcept {
-            return sizeof(ItemStash) +
-                   m_buffer.capacity() +
-                   m_index.capacity() * sizeof(std::size_t);
+            std::size_t memory = sizeof(ItemStash) +
+                                 m_segments.capacity() * sizeof(segment) +
+                                 m_free_segments.capacity() * sizeof(std::size_t) +
+                                 m_index.capacity() * sizeof(uint64_t) +
+                                 m_memory;
+            for (const auto& seg : m_segments) {
+                memory += seg.handles.capacity() * sizeof(std::size_t);
+            }
+            {
+                const std::lock_guard<std::mutex> lock{m_cache_mutex.mutex};
+                for (const auto& entry : m_cache) {
+                    memory += entry.buffer.capacity();
+                }
+            }
+            // Rough estimate for the hash map nodes and buckets.
+            memory += (m_interned_tags.size() + m_tags_by_hash.size() + m_object_tags.size() + m_way_nodes.size()) * 4 * sizeof(std::size_t);
+            memory += m_node_data.capacity();
+            memory += m_scratch.capacity();
+            return memory;
+        }
+
+        /**
+         * The size of the temporary file holding data spilled to disk
+         * in bytes.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t used_disk_space() const noexcept {
+            return m_spill_file ? m_spill_file->size() : 0;
         }
 
         /**
@@ -232,12 +882,25 @@ namespace osmium {
         }
 
         /**
-         * Clear all items from the stash. This will not necessarily release
-         * any memory. All handles are invalidated.
+         * Clear all items from the stash. All handles are invalidated.
          */
         void clear() {
-            m_buffer.clear();
+            m_segments.clear();
+            m_free_segments.clear();
             m_index.clear();
+            m_spill_file.reset();
+            m_cache.clear();
+            m_interned_tags.clear();
+            m_tags_by_hash.clear();
+            m_object_tags.clear();
+            m_node_data.clear();
+            m_node_data_removed = 0;
+            m_way_nodes.clear();
+            m_current = 0;
+            m_gc_cursor = 0;
+            m_memory = 0;
+            m_budget_account.set(0);
+            m_spill_cursor = 0;
             m_count_items = 0;
             m_count_removed = 0;
         }
@@ -246,23 +909,133 @@ namespace osmium {
          * Add an item to the stash. This will invalidate any pointers and
          * references into the stash, but handles are still valid.
          *
+         * Whenever a new segment is started, this will compact at most
+         * one sparse segment, so the time spent in a single call is
+         * bounded.
+         *
          * Complexity: Amortized constant.
          */
         handle_type add_item(const osmium::memory::Item& item) {
-            if (should_gc()) {
-                garbage_collect();
-            }
+            trim_cache();
             ++m_count_items;
-            const auto offset = m_buffer.committed();
-            m_buffer.add_item(item);
-            m_buffer.commit();
-            m_index.push_back(offset);
-            return handle_type{m_index.size()};
+            return insert_item(item);
+        }
+
+        /**
+         * Add an OSM object (node, way, relation, or area) to the stash
+         * storing its tag list only once for all objects added this way
+         * with exactly the same tags (same keys and values in the same
+         * order). This saves a lot of memory if many objects share the
+         * same tags, for instance "highway=residential".
+         *
+         * The object itself is stored without tag list, so tags() on the
+         * object returned by get<>() will be empty. Use tags() on the
+         * stash to get the tags.
+         *
+         * Complexity: Amortized linear in the size of the tag list.
+         */
+        handle_type add_object_interning_tags(const osmium::OSMObject& object) {
+            if (object.tags().empty()) {
+                return add_item(object);
+            }
+
+            const auto tags_handle_value = intern_tags(object.tags());
+
+            m_scratch.clear();
+            switch (object.type()) {
+                case osmium::item_type::node:
+                    copy_without_tags<osmium::builder::NodeBuilder, osmium::Node>(object);
+                    break;
+                case osmium::item_type::way:
+                    copy_without_tags<osmium::builder::WayBuilder, osmium::Way>(object);
+                    break;
+                case osmium::item_type::relation:
+                    copy_without_tags<osmium::builder::RelationBuilder, osmium::Relation>(object);
+                    break;
+                case osmium::item_type::area:
+                    copy_without_tags<osmium::builder::AreaBuilder, osmium::Area>(object);
+                    break;
+                default:
+                    // Other items are stored as they are.
+                    release_tags(tags_handle_value);
+                    return add_item(object);
+            }
+
+            const auto handle = add_item(*m_scratch.begin());
+            m_object_tags.emplace(handle.value, tags_handle_value);
+            return handle;
+        }
+
+        /**
+         * Add a way to the stash storing its node list in a compact delta
+         * encoded form (see encode_node_refs()). This needs much less
+         * memory for ways with node locations, which usually take up 16
+         * bytes per node otherwise.
+         *
+         * The way itself is stored without node list, so nodes() on the
+         * way returned by get<>() will be empty. Use compact_nodes() on
+         * the stash to read the nodes.
+         *
+         * Complexity: Amortized linear in the number of nodes.
+         */
+        handle_type add_way_compacting_nodes(const osmium::Way& way) {
+            m_scratch.clear();
+            {
+                osmium::builder::WayBuilder builder{m_scratch};
+                builder.copy_attributes(way);
+                builder.add_item(way.tags());
+            }
+            m_scratch.commit();
+
+            const auto offset = m_node_data.size();
+            encode_node_refs(way.nodes(), m_node_data);
+
+            const auto handle = add_item(*m_scratch.begin());
+            m_way_nodes.emplace(handle.value, node_list_pos{offset, m_node_data.size() - offset});
+            return handle;
+        }
+
+        /**
+         * Get the nodes of a way added with add_way_compacting_nodes().
+         * The node refs are decoded while iterating over the list. The
+         * list is invalidated by any call adding or removing items.
+         *
+         * Complexity: Constant.
+         *
+         * @pre Handle must be a valid handle returned by
+         *      add_way_compacting_nodes() and referring to a non-removed
+         *      way.
+         */
+        osmium::CompactNodeRefList compact_nodes(handle_type handle) const noexcept {
+            const auto it = m_way_nodes.find(handle.value);
+            assert(it != m_way_nodes.end());
+            return osmium::CompactNodeRefList{m_node_data.data() + it->second.offset};
+        }
+
+        /**
+         * The number of bytes used by the node lists of ways added with
+         * add_way_compacting_nodes().
+         *
+         * Complexity: Constant.
+         */
+        std::size_t compact_nodes_size() const noexcept {
+            return m_node_data.size() - m_node_data_removed;
+        }
+
+        /**
+         * The number of distinct tag lists stored for objects added with
+         * add_object_interning_tags().
+         *
+         * Complexity: Constant.
+         */
+        std::size_t count_interned_tags() const noexcept {
+            return m_interned_tags.size();
         }
 
         /**
          * Get a reference to an item in the stash. Note that this reference
-         * will be invalidated by any add_item() or clear() calls.
+         * will be invalidated by any add_item(), garbage_collect(), or
+         * clear() calls.
          *
          * Complexity: Constant.
          *
@@ -272,12 +1045,13 @@ namespace osmium {
          *      item.
          */
         osmium::memory::Item& get_item(handle_type handle) const {
-            return m_buffer.get<osmium::memory::Item>(get_item_offset(handle));
+            return item_at(get_item_location(handle));
         }
 
         /**
          * Get a reference to an item in the stash. Note that this reference
-         * will be invalidated by any add_item() or clear() calls.
+         * will be invalidated by any add_item(), garbage_collect(), or
+         * clear() calls.
          *
          * Complexity: Constant.
          *
@@ -296,23 +1070,55 @@ namespace osmium {
         }
 
         /**
-         * Garbage collect the memory used by the ItemStash. This will free up
-         * memory for adding new items. No memory is actually returned to the
-         * OS. Usually you do not need to call this, because add_item() will
-         * call it for you as necessary.
+         * Get the tags of an OSM object in the stash. For objects added
+         * with add_object_interning_tags() this is the shared tag list,
+         * for all others the tags of the object itself. The reference is
+         * invalidated like the one returned by get_item().
+         *
+         * Complexity: Constant.
+         *
+         * @param handle A handle returned by add_item() or
+         *               add_object_interning_tags() for an OSM object.
+         *
+         * @pre Handle must be a valid handle and referring to a non-removed
+         *      OSM object.
+         */
+        const osmium::TagList& tags(handle_type handle) const {
+            const auto it = m_object_tags.find(handle.value);
+            if (it == m_object_tags.end()) {
+                return get<osmium::OSMObject>(handle).tags();
+            }
+            return get<osmium::TagList>(handle_type{it->second});
+        }
+
+        /**
+         * Garbage collect all the memory used by removed items in the
+         * ItemStash by compacting all segments with removed items. Usually
+         * you do not need to call this, because add_item() will compact
+         * sparse segments one at a time as necessary and segments with
+         * only removed items are freed immediately.
          *
          * Complexity: Linear in size() + count_removed().
          */
         void garbage_collect() {
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
-            std::cerr << "GC items=" << m_count_items << " removed=" << m_count_removed << " buffer.committed=" << m_buffer.committed() << " buffer.capacity=" << m_buffer.capacity() << "\n";
+            std::cerr << "GC items=" << m_count_items << " removed=" << m_count_removed << " segments=" << m_segments.size() << "\n";
             using clock = std::chrono::high_resolution_clock;
             std::chrono::time_point<clock> start = clock::now();
 #endif
 
-            m_count_removed = 0;
-            cleanup_helper helper{m_index};
-            m_buffer.purge_removed(&helper);
+            trim_cache();
+            if (!m_segments.empty()) {
+                if (m_segments[m_current].count_removed > 0) {
+                    start_segment(0);
+                }
+                for (std::size_t num = 0; num < m_segments.size(); ++num) {
+                    if (num != m_current && m_segments[num].count_removed > 0) {
+                        compact_segment(num);
+                    }
+                }
+                spill_if_needed();
+            }
 
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
             std::chrono::time_point<clock> stop = clock::now();
@@ -325,8 +1131,9 @@ namespace osmium {
 
         /**
          * Remove an item from the stash. The item will be marked as removed
-         * and the handle will be invalidated. No memory will actually be
-         * freed.
+         * and the handle will be invalidated. If this was the last item in
+         * a segment (other than the one currently written to), the memory
+         * of the segment is freed.
          *
          * Complexity: Constant.
          *
@@ -336,13 +1143,22 @@ namespace osmium {
          *      item.
          */
         void remove_item(handle_type handle) {
-            auto& offset = get_item_offset_ref(handle);
-            auto& item = m_buffer.get<osmium::memory::Item>(offset);
-            assert(!item.removed() && "can not call remove_item() on already removed item");
-            item.set_removed(true);
-            offset = removed_item_offset;
+            trim_cache();
+            erase_item(handle);
             --m_count_items;
-            ++m_count_removed;
+
+            if (!m_object_tags.empty()) {
+                const auto it = m_object_tags.find(handle.value);
+                if (it != m_object_tags.end()) {
+                    const auto tags_handle_value = it->second;
+                    m_object_tags.erase(it);
+                    release_tags(tags_handle_value);
+                }
+            }
+
+            if (!m_way_nodes.empty()) {
+                release_nodes(handle.value);
+            }
         }
 
     }; // class ItemStash
@@ -64,7 +64,7 @@ namespace osmium {
 
         struct match_key_prefix {
             bool operator()(const std::string& rule_key, const char* tag_key) const {
-                return rule_key.compare(0, std::string::npos, tag_key, 0, rule_key.size()) == 0;
+                return !std::strncmp(rule_key.c_str(), tag_key, rule_key.size());
             }
         }; // struct match_key_prefix
 
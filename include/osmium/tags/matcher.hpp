@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/tag.hpp>
 #include <osmium/util/string_matcher.hpp>
 
+#include <cstddef>
 #include <type_traits>
 #include <utility>
 
@@ -65,6 +66,21 @@ namespace osmium {
             return m_has_value_matcher;
         }
 
+        const osmium::StringMatcher& key_matcher() const noexcept {
+            return m_key_matcher;
+        }
+
+        const osmium::StringMatcher& value_matcher() const noexcept {
+            return m_value_matcher;
+        }
+
+        /**
+         * Is the result of the value matcher inverted?
+         */
+        bool is_inverted() const noexcept {
+            return !m_result;
+        }
+
         /**
          * Create a TagMatcher matching the key against the specified
          * StringMatcher.
@@ -102,17 +118,50 @@ namespace osmium {
          * @returns true if the tag matches.
          */
         bool operator()(const char* key, const char* value) const noexcept {
-            return m_key_matcher(key) &&
-                   (m_value_matcher(value) == m_result);
+            return match_key(key) && match_value(value);
+        }
+
+        /**
+         * Match only the key against the key matcher.
+         *
+         * @returns true if the key matches.
+         */
+        bool match_key(const char* key) const noexcept {
+            return m_key_matcher(key);
+        }
+
+        /**
+         * Match only the key of known length against the key matcher.
+         *
+         * @returns true if the key matches.
+         */
+        bool match_key(const char* key, std::size_t size) const noexcept {
+            return m_key_matcher(key, size);
+        }
+
+        /**
+         * Match only the value against the value matcher, taking the
+         * invert flag into account. A tag matches if both match_key()
+         * and match_value() return true.
+         *
+         * @returns true if the value matches.
+         */
+        bool match_value(const char* value) const noexcept {
+            return m_value_matcher(value) == m_result;
         }
 
         /**
-         * Match against the specified tag.
+         * Match against the specified tag. The length of the key is
+         * known once the value has been found, so the key is matched
+         * with the faster length-aware comparison.
          *
          * @returns true if the tag matches.
          */
         bool operator()(const osmium::Tag& tag) const noexcept {
-            return operator()(tag.key(), tag.value());
+            const char* key = tag.key();
+            const char* value = tag.value();
+            return match_key(key, static_cast<std::size_t>(value - key) - 1) &&
+                   match_value(value);
         }
 
         /**
@@ -0,0 +1,360 @@
+#ifndef OSMIUM_TAGS_STATIC_TAGS_FILTER_HPP
+#define OSMIUM_TAGS_STATIC_TAGS_FILTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/tag.hpp>
+
+#include <cstddef>
+#include <cstring>
+
+namespace osmium {
+
+    /**
+     * A string known at compile time, usually created from a string
+     * literal. Its length is computed by the compiler.
+     */
+    class static_string {
+
+        const char* m_data;
+        std::size_t m_size;
+
+    public:
+
+        template <std::size_t N>
+        constexpr static_string(const char (&str)[N]) noexcept : // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
+            m_data(str),
+            m_size(N - 1) {
+        }
+
+        constexpr const char* data() const noexcept {
+            return m_data;
+        }
+
+        constexpr std::size_t size() const noexcept {
+            return m_size;
+        }
+
+        /**
+         * Is this string equal to the string str with the given size?
+         * Checks the size and the first character before comparing the
+         * rest, so most non-matching strings are rejected quickly.
+         */
+        bool equals(const char* str, const std::size_t size) const noexcept {
+            return size == m_size &&
+                   (size == 0 || (*str == *m_data && std::memcmp(str + 1, m_data + 1, size - 1) == 0));
+        }
+
+    }; // class static_string
+
+    namespace detail {
+
+        // A key or value with its length, which is computed at most
+        // once for each tag.
+        class measured_string {
+
+            const char* m_data;
+            mutable std::size_t m_size;
+
+            enum : std::size_t {
+                unknown = static_cast<std::size_t>(-1)
+            };
+
+        public:
+
+            explicit measured_string(const char* str) noexcept :
+                m_data(str),
+                m_size(unknown) {
+            }
+
+            const char* data() const noexcept {
+                return m_data;
+            }
+
+            std::size_t size() const noexcept {
+                if (m_size == unknown) {
+                    m_size = std::strlen(m_data);
+                }
+                return m_size;
+            }
+
+        }; // class measured_string
+
+        template <typename TResult>
+        class static_key_rule {
+
+            TResult m_result;
+            static_string m_key;
+
+        public:
+
+            constexpr static_key_rule(const TResult result, const static_string key) noexcept :
+                m_result(result),
+                m_key(key) {
+            }
+
+            TResult result() const noexcept {
+                return m_result;
+            }
+
+            bool operator()(const measured_string& key, const measured_string& /*value*/) const noexcept {
+                return m_key.equals(key.data(), key.size());
+            }
+
+        }; // class static_key_rule
+
+        template <typename TResult>
+        class static_tag_rule {
+
+            TResult m_result;
+            static_string m_key;
+            static_string m_value;
+
+        public:
+
+            constexpr static_tag_rule(const TResult result, const static_string key, const static_string value) noexcept :
+                m_result(result),
+                m_key(key),
+                m_value(value) {
+            }
+
+            TResult result() const noexcept {
+                return m_result;
+            }
+
+            bool operator()(const measured_string& key, const measured_string& value) const noexcept {
+                return m_key.equals(key.data(), key.size()) &&
+                       m_value.equals(value.data(), value.size());
+            }
+
+        }; // class static_tag_rule
+
+        template <typename TResult, std::size_t N>
+        class static_key_values_rule {
+
+            TResult m_result;
+            static_string m_key;
+            const static_string* m_values;
+
+        public:
+
+            constexpr static_key_values_rule(const TResult result, const static_string key, const static_string (&values)[N]) noexcept :
+                m_result(result),
+                m_key(key),
+                m_values(values) {
+            }
+
+            TResult result() const noexcept {
+                return m_result;
+            }
+
+            bool operator()(const measured_string& key, const measured_string& value) const noexcept {
+                if (!m_key.equals(key.data(), key.size())) {
+                    return false;
+                }
+                for (std::size_t i = 0; i < N; ++i) {
+                    if (m_values[i].equals(value.data(), value.size())) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        }; // class static_key_values_rule
+
+        // The rules of a StaticTagsFilterBase as a chain of nested
+        // objects, so matching is a series of inlined calls.
+        template <typename TResult, typename... TRules>
+        class static_rule_chain;
+
+        template <typename TResult>
+        class static_rule_chain<TResult> {
+
+            TResult m_default_result;
+
+        public:
+
+            constexpr explicit static_rule_chain(const TResult default_result) noexcept :
+                m_default_result(default_result) {
+            }
+
+            TResult operator()(const measured_string& /*key*/, const measured_string& /*value*/) const noexcept {
+                return m_default_result;
+            }
+
+            TResult default_result() const noexcept {
+                return m_default_result;
+            }
+
+        }; // class static_rule_chain
+
+        template <typename TResult, typename TRule, typename... TRules>
+        class static_rule_chain<TResult, TRule, TRules...> {
+
+            TRule m_rule;
+            static_rule_chain<TResult, TRules...> m_rest;
+
+        public:
+
+            constexpr static_rule_chain(const TResult default_result, const TRule& rule, const TRules&... rules) noexcept :
+                m_rule(rule),
+                m_rest(default_result, rules...) {
+            }
+
+            TResult operator()(const measured_string& key, const measured_string& value) const noexcept {
+                return m_rule(key, value) ? m_rule.result() : m_rest(key, value);
+            }
+
+            TResult default_result() const noexcept {
+                return m_rest.default_result();
+            }
+
+        }; // class static_rule_chain
+
+    } // namespace detail
+
+    /**
+     * A tags filter with rules fixed at compile time. It works like the
+     * TagsFilterBase, the first rule that matches sets the result, but it
+     * only supports rules matching a key, a key and value, or a key and
+     * one of a list of values, all given as string literals. There is no
+     * dynamic memory, no runtime dispatch between matcher types, and the
+     * lengths of all strings are known to the compiler, so most tags are
+     * rejected by comparing the key length and first character.
+     *
+     * Create these filters with make_static_tags_filter() and the rule
+     * functions static_key_rule(), static_tag_rule(), and
+     * static_key_values_rule(). They can be used wherever a TagsFilter is
+     * used as a predicate, for instance with osmium::tags::match_any_of().
+     *
+     * @code
+     * constexpr osmium::static_string highways[] = {"motorway", "trunk", "primary"};
+     * constexpr auto filter = osmium::make_static_tags_filter(false,
+     *     osmium::static_tag_rule(false, "highway", "proposed"),
+     *     osmium::static_key_values_rule(true, "highway", highways),
+     *     osmium::static_key_rule(true, "railway"));
+     *
+     * bool result = filter(tag);
+     * @endcode
+     */
+    template <typename TResult, typename... TRules>
+    class StaticTagsFilterBase {
+
+        detail::static_rule_chain<TResult, TRules...> m_rules;
+
+    public:
+
+        constexpr explicit StaticTagsFilterBase(const TResult default_result, const TRules&... rules) noexcept :
+            m_rules(default_result, rules...) {
+        }
+
+        /**
+         * Matching function. Check the specified tag against the rules.
+         *
+         * @param tag A tag.
+         * @returns The result of the matching rule, or, if none of the rules
+         *          matched, the default result.
+         */
+        TResult operator()(const osmium::Tag& tag) const noexcept {
+            return operator()(tag.key(), tag.value());
+        }
+
+        /**
+         * Matching function. Check the tag with the specified key and
+         * value against the rules.
+         *
+         * @param key The tag key.
+         * @param value The tag value.
+         * @returns The result of the matching rule, or, if none of the rules
+         *          matched, the default result.
+         */
+        TResult operator()(const char* key, const char* value) const noexcept {
+            return m_rules(detail::measured_string{key}, detail::measured_string{value});
+        }
+
+        /**
+         * Get the result returned if none of the rules match.
+         */
+        TResult default_result() const noexcept {
+            return m_rules.default_result();
+        }
+
+        /**
+         * Return the number of rules in this filter.
+         */
+        static constexpr std::size_t count() noexcept {
+            return sizeof...(TRules);
+        }
+
+    }; // class StaticTagsFilterBase
+
+    /**
+     * Rule for a StaticTagsFilterBase matching any tag with the given key.
+     */
+    template <typename TResult>
+    constexpr detail::static_key_rule<TResult> static_key_rule(const TResult result, const static_string key) noexcept {
+        return detail::static_key_rule<TResult>{result, key};
+    }
+
+    /**
+     * Rule for a StaticTagsFilterBase matching the tag with the given key
+     * and value.
+     */
+    template <typename TResult>
+    constexpr detail::static_tag_rule<TResult> static_tag_rule(const TResult result, const static_string key, const static_string value) noexcept {
+        return detail::static_tag_rule<TResult>{result, key, value};
+    }
+
+    /**
+     * Rule for a StaticTagsFilterBase matching tags with the given key and
+     * any of the given values. The array of values must outlive the
+     * filter, usually it is a constexpr array at namespace scope.
+     */
+    template <typename TResult, std::size_t N>
+    constexpr detail::static_key_values_rule<TResult, N> static_key_values_rule(const TResult result, const static_string key, const static_string (&values)[N]) noexcept {
+        return detail::static_key_values_rule<TResult, N>{result, key, values};
+    }
+
+    /**
+     * Create a StaticTagsFilterBase from a default result and any number
+     * of rules.
+     */
+    template <typename TResult, typename... TRules>
+    constexpr StaticTagsFilterBase<TResult, TRules...> make_static_tags_filter(const TResult default_result, const TRules&... rules) noexcept {
+        return StaticTagsFilterBase<TResult, TRules...>{default_result, rules...};
+    }
+
+} // namespace osmium
+
+
+#endif // OSMIUM_TAGS_STATIC_TAGS_FILTER_HPP
@@ -0,0 +1,204 @@
+#ifndef OSMIUM_TAGS_STRING_TABLE_TAGS_FILTER_HPP
+#define OSMIUM_TAGS_STRING_TABLE_TAGS_FILTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * A TagsFilterBase compiled against a table of strings, like the
+     * string table of a PBF block. The keys and values of tags are given
+     * as ids into that table and each rule of the filter is evaluated
+     * only once for each string used as key or value. The results are
+     * cached in bitmaps with one bit per rule, so matching a tag later
+     * is a few bit operations.
+     *
+     * The strings are matched lazily on first use, so strings never used
+     * as keys (or values) are never matched against the key (or value)
+     * matchers.
+     *
+     * Call reset() whenever a new string table is used. The TagsFilterBase
+     * must not be changed while this object uses it. A default constructed
+     * object can be reused with different filters by calling the reset()
+     * function taking a filter, which keeps the memory allocated.
+     *
+     * @code
+     * osmium::TagsFilter filter{false};
+     * filter.add_rule(true, "highway");
+     *
+     * osmium::StringTableTagsFilter compiled{filter};
+     * compiled.reset(number_of_strings);
+     * bool result = compiled(key_id, key, value_id, value);
+     * @endcode
+     */
+    template <typename TResult>
+    class StringTableTagsFilterBase {
+
+        enum : std::size_t {
+            bits_per_word = 64
+        };
+
+        enum : unsigned char {
+            key_done   = 1U,
+            value_done = 2U
+        };
+
+        const osmium::TagsFilterBase<TResult>* m_filter = nullptr;
+
+        // Number of 64bit words needed for one bit per rule.
+        std::size_t m_words = 0;
+
+        std::vector<uint64_t> m_key_bits;
+        std::vector<uint64_t> m_value_bits;
+
+        // Which bitmaps were already computed for each string.
+        std::vector<unsigned char> m_state;
+
+        const uint64_t* key_bits(const std::size_t id, const char* key) {
+            uint64_t* bits = m_key_bits.data() + id * m_words;
+            if (!(m_state[id] & key_done)) {
+                for (std::size_t n = 0; n < m_filter->count(); ++n) {
+                    if (m_filter->rule_matcher(n).match_key(key)) {
+                        bits[n / bits_per_word] |= uint64_t(1U) << (n % bits_per_word);
+                    }
+                }
+                m_state[id] |= key_done;
+            }
+            return bits;
+        }
+
+        const uint64_t* value_bits(const std::size_t id, const char* value) {
+            uint64_t* bits = m_value_bits.data() + id * m_words;
+            if (!(m_state[id] & value_done)) {
+                for (std::size_t n = 0; n < m_filter->count(); ++n) {
+                    if (m_filter->rule_matcher(n).match_value(value)) {
+                        bits[n / bits_per_word] |= uint64_t(1U) << (n % bits_per_word);
+                    }
+                }
+                m_state[id] |= value_done;
+            }
+            return bits;
+        }
+
+        static std::size_t words_for(const osmium::TagsFilterBase<TResult>& filter) noexcept {
+            return (filter.count() + bits_per_word - 1) / bits_per_word;
+        }
+
+    public:
+
+        /**
+         * Construct an object not bound to any filter. Call
+         * reset(filter, num_strings) before using it.
+         */
+        StringTableTagsFilterBase() = default;
+
+        /**
+         * Constructor.
+         *
+         * @param filter The filter to compile. It is not copied and must
+         *               outlive this object.
+         */
+        explicit StringTableTagsFilterBase(const osmium::TagsFilterBase<TResult>& filter) :
+            m_filter(&filter),
+            m_words(words_for(filter)) {
+        }
+
+        /**
+         * Start using a new string table. All cached results are
+         * forgotten.
+         *
+         * @param num_strings The number of strings in the table.
+         */
+        void reset(const std::size_t num_strings) {
+            assert(m_filter);
+            m_key_bits.assign(num_strings * m_words, 0);
+            m_value_bits.assign(num_strings * m_words, 0);
+            m_state.assign(num_strings, 0);
+        }
+
+        /**
+         * Start using a new filter and string table. All cached results
+         * are forgotten.
+         *
+         * @param filter The filter to compile. It is not copied and must
+         *               outlive its use in this object.
+         * @param num_strings The number of strings in the table.
+         */
+        void reset(const osmium::TagsFilterBase<TResult>& filter, const std::size_t num_strings) {
+            m_filter = &filter;
+            m_words = words_for(filter);
+            reset(num_strings);
+        }
+
+        /**
+         * Match the tag with the specified key and value against the
+         * rules. The strings are only looked at if the results for them
+         * aren't cached yet.
+         *
+         * @param key_id The id of the key in the string table.
+         * @param key The key.
+         * @param value_id The id of the value in the string table.
+         * @param value The value.
+         * @returns The result of the first matching rule, or, if none of
+         *          the rules matched, the default result.
+         * @pre key_id and value_id must be smaller than the number of
+         *      strings given to reset().
+         */
+        TResult operator()(const std::size_t key_id, const char* key,
+                           const std::size_t value_id, const char* value) {
+            const uint64_t* kbits = key_bits(key_id, key);
+            const uint64_t* vbits = value_bits(value_id, value);
+            for (std::size_t w = 0; w < m_words; ++w) {
+                const uint64_t match = kbits[w] & vbits[w];
+                if (match) {
+                    return m_filter->rule_result(w * bits_per_word + osmium::index::detail::ctz64(match));
+                }
+            }
+            return m_filter->default_result();
+        }
+
+    }; // class StringTableTagsFilterBase
+
+    using StringTableTagsFilter = StringTableTagsFilterBase<bool>;
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_STRING_TABLE_TAGS_FILTER_HPP
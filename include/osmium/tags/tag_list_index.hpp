@@ -0,0 +1,192 @@
+#ifndef OSMIUM_TAGS_TAG_LIST_INDEX_HPP
+#define OSMIUM_TAGS_TAG_LIST_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/tag.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * An index of the tags in a TagList sorted by key. Use this when
+     * looking up many keys in the same TagList: Each lookup is then a
+     * binary search instead of a linear scan comparing the key with the
+     * keys of all tags.
+     *
+     * The index stores pointers into the TagList, so the TagList (and the
+     * Buffer containing it) must outlive the index or the next call to
+     * reset(). A TagListIndex can be reused for many objects, it keeps
+     * the memory allocated.
+     *
+     * @code
+     * osmium::TagListIndex index;
+     * for (const auto& way : buffer.select<osmium::Way>()) {
+     *     index.reset(way.tags());
+     *     const char* highway = index["highway"];
+     *     const char* name = index.get_value_by_key("name", "");
+     *     ...
+     * }
+     * @endcode
+     *
+     * If a key appears more than once in the TagList, the lookups return
+     * the first tag with that key, just like the TagList functions do.
+     */
+    class TagListIndex {
+
+        struct entry {
+            const char* key;
+            const char* value;
+        }; // struct entry
+
+        std::vector<entry> m_entries;
+
+        static bool less(const entry& lhs, const char* key) noexcept {
+            return std::strcmp(lhs.key, key) < 0;
+        }
+
+        const entry* find_key(const char* key) const noexcept {
+            const auto it = std::lower_bound(m_entries.cbegin(), m_entries.cend(), key, less);
+            if (it == m_entries.cend() || std::strcmp(it->key, key)) {
+                return nullptr;
+            }
+            return &*it;
+        }
+
+    public:
+
+        /**
+         * Create an empty index. Call reset() to fill it.
+         */
+        TagListIndex() = default;
+
+        /**
+         * Create an index of the specified TagList.
+         */
+        explicit TagListIndex(const osmium::TagList& tags) {
+            reset(tags);
+        }
+
+        /**
+         * Index the specified TagList replacing the tags indexed before.
+         *
+         * Complexity: O(n log n) on the number of tags.
+         */
+        void reset(const osmium::TagList& tags) {
+            m_entries.clear();
+            for (const auto& tag : tags) {
+                m_entries.push_back(entry{tag.key(), tag.value()});
+            }
+            std::stable_sort(m_entries.begin(), m_entries.end(), [](const entry& lhs, const entry& rhs) {
+                return std::strcmp(lhs.key, rhs.key) < 0;
+            });
+        }
+
+        /**
+         * Remove all tags from the index.
+         */
+        void clear() noexcept {
+            m_entries.clear();
+        }
+
+        /**
+         * The number of tags in the index.
+         */
+        std::size_t size() const noexcept {
+            return m_entries.size();
+        }
+
+        /**
+         * Is the index empty?
+         */
+        bool empty() const noexcept {
+            return m_entries.empty();
+        }
+
+        /**
+         * Get tag value for the given tag key. If the key is not set,
+         * returns the default_value.
+         *
+         * Complexity: O(log n) on the number of tags.
+         *
+         * @pre @code key != nullptr @endcode
+         */
+        const char* get_value_by_key(const char* key, const char* default_value = nullptr) const noexcept {
+            assert(key);
+            const auto* e = find_key(key);
+            return e ? e->value : default_value;
+        }
+
+        /**
+         * Get tag value for the given tag key. If the key is not set,
+         * returns nullptr.
+         *
+         * @pre @code key != nullptr @endcode
+         */
+        const char* operator[](const char* key) const noexcept {
+            return get_value_by_key(key);
+        }
+
+        /**
+         * Returns true if the tag with the given key is in the index.
+         *
+         * @pre @code key != nullptr @endcode
+         */
+        bool has_key(const char* key) const noexcept {
+            assert(key);
+            return find_key(key) != nullptr;
+        }
+
+        /**
+         * Returns true if the tag with the given key and value is in the
+         * index.
+         *
+         * @pre @code key != nullptr && value != nullptr @endcode
+         */
+        bool has_tag(const char* key, const char* value) const noexcept {
+            assert(key);
+            assert(value);
+            const auto* e = find_key(key);
+            return e && !std::strcmp(e->value, value);
+        }
+
+    }; // class TagListIndex
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_TAG_LIST_INDEX_HPP
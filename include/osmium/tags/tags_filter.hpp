@@ -38,6 +38,11 @@ DEALINGS IN THE SOFTWARE.
 
 #include <boost/iterator/filter_iterator.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -63,6 +68,12 @@ namespace osmium {
      * @endcode
      *
      * Use this instead of the old osmium::tags::Filter.
+     *
+     * Rules with an equal or list key matcher are indexed by key, and if
+     * they also have an equal or list value matcher, by key and value. So
+     * matching a tag only looks at the rules which can match its key and
+     * at the rules using other matchers. Large rule sets of known keys
+     * and values, like lists of POI types, are matched quickly.
      */
     template <typename TResult>
     class TagsFilterBase {
@@ -70,6 +81,87 @@ namespace osmium {
         std::vector<std::pair<TResult, TagMatcher>> m_rules;
         TResult m_default_result;
 
+        struct key_rule {
+            std::string key;
+            std::size_t rule;
+        };
+
+        struct key_value_rule {
+            std::string key;
+            std::string value;
+            std::size_t rule;
+        };
+
+        // Rules indexed by key, sorted by key and rule.
+        std::vector<key_rule> m_key_rules;
+
+        // Rules indexed by key and value, sorted by key, value, and rule.
+        // All rules in here match if key and value are equal.
+        std::vector<key_value_rule> m_key_value_rules;
+
+        // Rules that can't be indexed, they are checked for every tag.
+        std::vector<std::size_t> m_other_rules;
+
+        using key_value_type = std::pair<const char*, const char*>;
+
+        // Compares index entries with keys or keys and values.
+        struct index_compare {
+
+            static int compare(const key_value_rule& entry, const key_value_type& kv) noexcept {
+                const int c = std::strcmp(entry.key.c_str(), kv.first);
+                return c != 0 ? c : std::strcmp(entry.value.c_str(), kv.second);
+            }
+
+            bool operator()(const key_rule& lhs, const char* rhs) const noexcept {
+                return std::strcmp(lhs.key.c_str(), rhs) < 0;
+            }
+
+            bool operator()(const char* lhs, const key_rule& rhs) const noexcept {
+                return std::strcmp(lhs, rhs.key.c_str()) < 0;
+            }
+
+            bool operator()(const key_value_rule& lhs, const key_value_type& rhs) const noexcept {
+                return compare(lhs, rhs) < 0;
+            }
+
+            bool operator()(const key_value_type& lhs, const key_value_rule& rhs) const noexcept {
+                return compare(rhs, lhs) > 0;
+            }
+
+        }; // struct index_compare
+
+        // Add the last rule to the index. New entries are inserted behind
+        // all entries with the same key (and value), so the entries stay
+        // sorted by rule.
+        void index_last_rule() {
+            const std::size_t n = m_rules.size() - 1;
+            const TagMatcher& matcher = m_rules.back().second;
+
+            std::vector<std::string> keys;
+            if (!matcher.key_matcher().get_exact_strings(keys)) {
+                m_other_rules.push_back(n);
+                return;
+            }
+
+            std::vector<std::string> values;
+            if (matcher.has_value_matcher() && !matcher.is_inverted() &&
+                matcher.value_matcher().get_exact_strings(values)) {
+                for (const auto& key : keys) {
+                    for (const auto& value : values) {
+                        const auto it = std::upper_bound(m_key_value_rules.begin(), m_key_value_rules.end(),
+                                                         key_value_type{key.c_str(), value.c_str()}, index_compare{});
+                        m_key_value_rules.insert(it, key_value_rule{key, value, n});
+                    }
+                }
+                return;
+            }
+
+            for (const auto& key : keys) {
+                const auto it = std::upper_bound(m_key_rules.begin(), m_key_rules.end(), key.c_str(), index_compare{});
+                m_key_rules.insert(it, key_rule{key, n});
+            }
+        }
+
     public:
 
         using iterator = boost::filter_iterator<TagsFilterBase, osmium::TagList::const_iterator>;
@@ -101,6 +193,7 @@ namespace osmium {
          */
         TagsFilterBase& add_rule(const TResult result, const TagMatcher& matcher) {
             m_rules.emplace_back(result, matcher);
+            index_last_rule();
             return *this;
         }
 
@@ -115,6 +208,7 @@ namespace osmium {
         template <typename... TArgs>
         TagsFilterBase& add_rule(const TResult result, TArgs&&... args) {
             m_rules.emplace_back(result, osmium::TagMatcher{std::forward<TArgs>(args)...});
+            index_last_rule();
             return *this;
         }
 
@@ -126,11 +220,78 @@ namespace osmium {
          *          matched, the default result.
          */
         TResult operator()(const osmium::Tag& tag) const noexcept {
-            for (const auto& rule : m_rules) {
-                if (rule.second(tag)) {
-                    return rule.first;
+            return operator()(tag.key(), tag.value());
+        }
+
+        /**
+         * Matching function. Check the tag with the specified key and
+         * value against the rules.
+         *
+         * @param key The tag key.
+         * @param value The tag value.
+         * @returns The result of the matching rule, or, if none of the rules
+         *          matched, the default result.
+         */
+        TResult operator()(const char* key, const char* value) const noexcept {
+            const auto keys = std::equal_range(m_key_rules.cbegin(), m_key_rules.cend(), key, index_compare{});
+            const auto key_values = std::equal_range(m_key_value_rules.cbegin(), m_key_value_rules.cend(),
+                                                     key_value_type{key, value}, index_compare{});
+
+            auto kit = keys.first;
+            auto kvit = key_values.first;
+            auto oit = m_other_rules.cbegin();
+
+            // Go through the candidate rules in the order they were added,
+            // the first rule matching decides.
+            constexpr const std::size_t none = std::numeric_limits<std::size_t>::max();
+            while (true) {
+                const std::size_t k = kit != keys.second ? kit->rule : none;
+                const std::size_t kv = kvit != key_values.second ? kvit->rule : none;
+                const std::size_t o = oit != m_other_rules.cend() ? *oit : none;
+
+                if (kv < k && kv < o) {
+                    return m_rules[kv].first;
+                }
+                if (k == none && o == none) {
+                    return m_default_result;
+                }
+
+                std::size_t n = 0;
+                if (k < o) {
+                    n = k;
+                    ++kit;
+                } else {
+                    n = o;
+                    ++oit;
+                }
+                if (m_rules[n].second(key, value)) {
+                    return m_rules[n].first;
                 }
             }
+        }
+
+        /**
+         * Get the result of the rule with the specified index.
+         *
+         * @pre n < count()
+         */
+        TResult rule_result(const std::size_t n) const noexcept {
+            return m_rules[n].first;
+        }
+
+        /**
+         * Get the TagMatcher of the rule with the specified index.
+         *
+         * @pre n < count()
+         */
+        const TagMatcher& rule_matcher(const std::size_t n) const noexcept {
+            return m_rules[n].second;
+        }
+
+        /**
+         * Get the result returned if none of the rules match.
+         */
+        TResult default_result() const noexcept {
             return m_default_result;
         }
 
@@ -0,0 +1,290 @@
+#ifndef OSMIUM_THREAD_ASYNC_CALLBACK_HPP
+#define OSMIUM_THREAD_ASYNC_CALLBACK_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/queue_stats.hpp>
+#include <osmium/thread/util.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Wrapper around a callback function taking buffers, which calls
+         * the function asynchronously in another thread. The buffers are
+         * put into a queue of limited size from which they are taken by a
+         * dedicated thread or by a task on the thread pool. The callback
+         * is always called for one buffer after the other in the order the
+         * buffers were added, never in parallel, so it can do things like
+         * writing to an osmium::io::Writer.
+         *
+         * Use this with an osmium::memory::CallbackBuffer, for instance
+         * the one in the MultipolygonManager or other relations managers,
+         * so that creating the data and handling it overlap:
+         *
+         * @code
+         * osmium::io::Writer writer{...};
+         * osmium::thread::AsyncCallback async{[&writer](osmium::memory::Buffer&& buffer) {
+         *     writer(std::move(buffer));
+         * }};
+         * mp_manager.set_callback(async.function());
+         * ...
+         * mp_manager.flush_output();
+         * async.close();
+         * writer.close();
+         * @endcode
+         *
+         * If the callback throws an exception, all further buffers are
+         * dropped and the exception is rethrown from the next call to
+         * operator() or from close().
+         */
+        class AsyncCallback {
+
+        public:
+
+            /// The type of the callback function.
+            using callback_func_type = std::function<void(osmium::memory::Buffer&&)>;
+
+            enum : std::size_t {
+                default_max_queue_size = 4U
+            };
+
+        private:
+
+            callback_func_type m_callback;
+            osmium::thread::Pool* m_pool = nullptr;
+            Queue<osmium::memory::Buffer> m_queue;
+
+            // Only used with pool: Is a task working on the queue?
+            std::mutex m_mutex{};
+            std::condition_variable m_idle{};
+            bool m_draining = false;
+
+            std::exception_ptr m_error{};
+            std::atomic<bool> m_failed{false};
+            bool m_closed = false;
+
+            std::thread m_thread{};
+
+            void handle(osmium::memory::Buffer&& buffer) noexcept {
+                if (m_failed) {
+                    return;
+                }
+                try {
+                    m_callback(std::move(buffer));
+                } catch (...) {
+                    m_error = std::current_exception();
+                    m_failed = true;
+                }
+            }
+
+            void run_thread() {
+                osmium::thread::set_thread_name("_osmium_async");
+                while (true) {
+                    osmium::memory::Buffer buffer;
+                    m_queue.wait_and_pop(buffer);
+                    if (!buffer) {
+                        return;
+                    }
+                    handle(std::move(buffer));
+                }
+            }
+
+            void drain() {
+                while (true) {
+                    osmium::memory::Buffer buffer;
+                    if (m_queue.try_pop(buffer)) {
+                        handle(std::move(buffer));
+                        continue;
+                    }
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_queue.empty()) {
+                        m_draining = false;
+                        m_idle.notify_all();
+                        return;
+                    }
+                }
+            }
+
+            void check_for_error() const {
+                // m_error is written before m_failed is set, so it can be
+                // read safely once m_failed is true.
+                if (m_failed) {
+                    std::rethrow_exception(m_error);
+                }
+            }
+
+        public:
+
+            /**
+             * Create an AsyncCallback calling the callback in a dedicated
+             * thread.
+             *
+             * @param callback The callback function.
+             * @param max_queue_size Maximum number of buffers waiting for
+             *                       the callback. If the queue is full,
+             *                       adding a buffer blocks.
+             */
+            explicit AsyncCallback(callback_func_type callback, const std::size_t max_queue_size = default_max_queue_size) :
+                m_callback(std::move(callback)),
+                m_queue(max_queue_size, "async_callback") {
+                m_thread = std::thread{&AsyncCallback::run_thread, this};
+            }
+
+            /**
+             * Create an AsyncCallback calling the callback in tasks on the
+             * thread pool. There is at most one task for this callback
+             * active at any time.
+             *
+             * @param callback The callback function.
+             * @param pool The thread pool.
+             * @param max_queue_size Maximum number of buffers waiting for
+             *                       the callback. If the queue is full,
+             *                       adding a buffer blocks.
+             */
+            AsyncCallback(callback_func_type callback, osmium::thread::Pool& pool, const std::size_t max_queue_size = default_max_queue_size) :
+                m_callback(std::move(callback)),
+                m_pool(&pool),
+                m_queue(max_queue_size, "async_callback") {
+            }
+
+            AsyncCallback(const AsyncCallback&) = delete;
+            AsyncCallback& operator=(const AsyncCallback&) = delete;
+
+            AsyncCallback(AsyncCallback&&) = delete;
+            AsyncCallback& operator=(AsyncCallback&&) = delete;
+
+            ~AsyncCallback() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Add a buffer to the queue. Blocks if the queue is full.
+             * Invalid buffers are ignored.
+             *
+             * @throws Any exception thrown by the callback for an earlier
+             *         buffer.
+             * @throws std::logic_error If close() was called before.
+             */
+            void operator()(osmium::memory::Buffer&& buffer) {
+                check_for_error();
+                if (m_closed) {
+                    throw std::logic_error{"AsyncCallback was closed"};
+                }
+                if (!buffer) {
+                    return;
+                }
+
+                m_queue.push(std::move(buffer));
+
+                if (m_pool) {
+                    {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                        if (m_draining) {
+                            return;
+                        }
+                        m_draining = true;
+                    }
+                    m_pool->submit([this]() {
+                        drain();
+                    });
+                }
+            }
+
+            /**
+             * Get a function calling this AsyncCallback which can be given
+             * to osmium::memory::CallbackBuffer::set_callback(). The
+             * AsyncCallback must outlive the function.
+             */
+            callback_func_type function() {
+                return [this](osmium::memory::Buffer&& buffer) {
+                    (*this)(std::move(buffer));
+                };
+            }
+
+            /**
+             * Wait until the callback was called for all buffers in the
+             * queue. No buffers can be added after this. This is called
+             * from the destructor, but call it yourself to get exceptions.
+             *
+             * @throws Any exception thrown by the callback.
+             */
+            void close() {
+                if (!m_closed) {
+                    m_closed = true;
+                    if (m_pool) {
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        m_idle.wait(lock, [this]() {
+                            return !m_draining;
+                        });
+                    } else {
+                        m_queue.push(osmium::memory::Buffer{});
+                        m_thread.join();
+                    }
+                }
+                check_for_error();
+            }
+
+            /**
+             * Get the statistics of the queue. Large numbers of blocked
+             * pushes mean that the callback is slower than the producer.
+             */
+            queue_stats stats() const {
+                return m_queue.stats();
+            }
+
+        }; // class AsyncCallback
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_ASYNC_CALLBACK_HPP
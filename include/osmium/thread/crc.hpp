@@ -0,0 +1,149 @@
+#ifndef OSMIUM_THREAD_CRC_HPP
+#define OSMIUM_THREAD_CRC_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/crc.hpp>
+#include <osmium/osm/entity.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace osmium {
+
+    namespace thread {
+
+        namespace detail {
+
+            template <typename TCRC>
+            void update_crc(osmium::CRC<TCRC>& crc, const osmium::OSMEntity& entity) noexcept {
+                switch (entity.type()) {
+                    case osmium::item_type::node:
+                        crc.update(static_cast<const osmium::Node&>(entity));
+                        break;
+                    case osmium::item_type::way:
+                        crc.update(static_cast<const osmium::Way&>(entity));
+                        break;
+                    case osmium::item_type::relation:
+                        crc.update(static_cast<const osmium::Relation&>(entity));
+                        break;
+                    case osmium::item_type::area:
+                        crc.update(static_cast<const osmium::Area&>(entity));
+                        break;
+                    case osmium::item_type::changeset:
+                        crc.update(static_cast<const osmium::Changeset&>(entity));
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Compute the checksum of all OSM entities in a buffer. This is
+         * the same as calling CRC::update() for each node, way, relation,
+         * area, and changeset in the buffer in order.
+         */
+        template <typename TCRC>
+        osmium::CRC<TCRC> buffer_crc(const osmium::memory::Buffer& buffer) {
+            osmium::CRC<TCRC> crc;
+            for (const auto& entity : buffer.select<osmium::OSMEntity>()) {
+                detail::update_crc(crc, entity);
+            }
+            return crc;
+        }
+
+        /**
+         * Compute the checksum of all OSM entities from the source using
+         * the thread pool. Each buffer is checksummed in its own task and
+         * the results are combined in input order using the combine()
+         * function of the CRC type (see osmium::CRC_zlib and
+         * osmium::CRC_crc32c).
+         *
+         * Because the checksum is defined over the sequence of entities,
+         * the result doesn't depend on how the data is split into buffers
+         * (or PBF blobs). It is the same as calling CRC::update() on all
+         * entities one after the other.
+         *
+         * @tparam TCRC The CRC type. Must have a combine() function.
+         * @tparam TSource Source of buffers, usually an osmium::io::Reader.
+         * @param source The source. Its read() function is called until it
+         *               returns an invalid buffer.
+         * @param pool The thread pool to use.
+         * @returns The checksum.
+         */
+        template <typename TCRC, typename TSource>
+        osmium::CRC<TCRC> parallel_crc(TSource& source, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            using buffer_ptr = std::shared_ptr<osmium::memory::Buffer>;
+
+            osmium::CRC<TCRC> crc;
+            std::deque<std::future<osmium::CRC<TCRC>>> pending;
+            const std::size_t max_pending = static_cast<std::size_t>(pool.num_threads()) * 2;
+
+            while (auto buffer = source.read()) {
+                const buffer_ptr ptr = std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+                auto future = pool.submit([ptr]() {
+                    return buffer_crc<TCRC>(*ptr);
+                });
+                pending.push_back(std::move(future));
+                if (pending.size() > max_pending) {
+                    crc.combine(pending.front().get());
+                    pending.pop_front();
+                }
+            }
+
+            while (!pending.empty()) {
+                crc.combine(pending.front().get());
+                pending.pop_front();
+            }
+
+            return crc;
+        }
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_CRC_HPP
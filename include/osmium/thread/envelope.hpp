@@ -0,0 +1,175 @@
+#ifndef OSMIUM_THREAD_ENVELOPE_HPP
+#define OSMIUM_THREAD_ENVELOPE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        namespace detail {
+
+            inline void extend_envelope(osmium::Box& box, const osmium::OSMEntity& entity) noexcept {
+                switch (entity.type()) {
+                    case osmium::item_type::node:
+                        box.extend(static_cast<const osmium::Node&>(entity).location());
+                        break;
+                    case osmium::item_type::way:
+                        box.extend(static_cast<const osmium::Way&>(entity).envelope());
+                        break;
+                    case osmium::item_type::area:
+                        box.extend(static_cast<const osmium::Area&>(entity).envelope());
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            enum : std::size_t {
+                envelope_chunk_size = 4096U
+            };
+
+        } // namespace detail
+
+        /**
+         * Compute the envelope of all node locations, way node locations,
+         * and locations in the outer rings of areas in a buffer. Relations
+         * and changesets are ignored. The envelopes of the node lists are
+         * calculated with osmium::envelope() which uses SIMD instructions
+         * if available.
+         */
+        inline osmium::Box buffer_envelope(const osmium::memory::Buffer& buffer) noexcept {
+            osmium::Box box;
+            for (const auto& entity : buffer.select<osmium::OSMEntity>()) {
+                detail::extend_envelope(box, entity);
+            }
+            return box;
+        }
+
+        /**
+         * Compute the envelope of a buffer (see above) using the thread
+         * pool. The buffer is split into chunks of objects which are
+         * handled in their own tasks. Use this for large buffers, for
+         * small ones the overhead is larger than the gain.
+         *
+         * The buffer must not be changed until the function returns.
+         */
+        inline osmium::Box buffer_envelope(const osmium::memory::Buffer& buffer, osmium::thread::Pool& pool) {
+            std::vector<std::future<osmium::Box>> futures;
+            auto first = buffer.cbegin<osmium::OSMEntity>();
+            const auto end = buffer.cend<osmium::OSMEntity>();
+            while (first != end) {
+                auto last = first;
+                for (std::size_t n = 0; n < detail::envelope_chunk_size && last != end; ++n) {
+                    ++last;
+                }
+                futures.push_back(pool.submit([first, last]() {
+                    osmium::Box box;
+                    for (auto it = first; it != last; ++it) {
+                        detail::extend_envelope(box, *it);
+                    }
+                    return box;
+                }));
+                first = last;
+            }
+
+            osmium::Box box;
+            for (auto& future : futures) {
+                box.extend(future.get());
+            }
+            return box;
+        }
+
+        /**
+         * Compute the envelope of all OSM objects from the source using
+         * the thread pool. Each buffer is handled in its own task. See
+         * buffer_envelope() for which locations are taken into account.
+         *
+         * This can be used to compute the bounding box for the header of
+         * a file or for spatial prefilters.
+         *
+         * @tparam TSource Source of buffers, usually an osmium::io::Reader.
+         * @param source The source. Its read() function is called until it
+         *               returns an invalid buffer.
+         * @param pool The thread pool to use.
+         * @returns The envelope. It is undefined if there are no (valid)
+         *          locations in the data.
+         */
+        template <typename TSource>
+        osmium::Box parallel_envelope(TSource& source, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            using buffer_ptr = std::shared_ptr<osmium::memory::Buffer>;
+
+            osmium::Box box;
+            std::deque<std::future<osmium::Box>> pending;
+            const std::size_t max_pending = static_cast<std::size_t>(pool.num_threads()) * 2;
+
+            while (auto buffer = source.read()) {
+                const buffer_ptr ptr = std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+                pending.push_back(pool.submit([ptr]() {
+                    return buffer_envelope(*ptr);
+                }));
+                if (pending.size() > max_pending) {
+                    box.extend(pending.front().get());
+                    pending.pop_front();
+                }
+            }
+
+            while (!pending.empty()) {
+                box.extend(pending.front().get());
+                pending.pop_front();
+            }
+
+            return box;
+        }
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_ENVELOPE_HPP
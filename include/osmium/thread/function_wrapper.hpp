@@ -33,7 +33,9 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
-#include <memory>
+#include <cstddef>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace osmium {
@@ -44,6 +46,12 @@ namespace osmium {
          * This function wrapper can collect move-only functions unlike
          * std::function which needs copyable functions.
          * Taken from the book "C++ Concurrency in Action".
+         *
+         * Small functors (up to small_size bytes, for instance a
+         * std::packaged_task or a lambda capturing a few pointers) are
+         * stored inside the wrapper, larger ones on the heap. So wrapping
+         * the tasks submitted to the thread pool usually doesn't allocate
+         * any memory.
          */
         class function_wrapper {
 
@@ -63,9 +71,13 @@ namespace osmium {
                     return true;
                 }
 
-            }; // struct impl_base
+                // Move construct a copy of this object in the storage.
+                // Only used for objects stored inside the wrapper.
+                virtual impl_base* move_to(void* storage) noexcept {
+                    return new (storage) impl_base{};
+                }
 
-            std::unique_ptr<impl_base> impl;
+            }; // struct impl_base
 
             template <typename F>
             struct impl_type : impl_base {
@@ -81,8 +93,71 @@ namespace osmium {
                     return false;
                 }
 
+                impl_base* move_to(void* storage) noexcept override {
+                    return new (storage) impl_type{std::forward<F>(m_functor)};
+                }
+
             }; // struct impl_type
 
+        public:
+
+            enum : std::size_t {
+                small_size = 6 * sizeof(void*)
+            };
+
+        private:
+
+            using storage_type = typename std::aligned_storage<small_size>::type;
+
+            template <typename T>
+            using is_small = std::integral_constant<bool,
+                sizeof(T) <= sizeof(storage_type) &&
+                alignof(storage_type) % alignof(T) == 0 &&
+                std::is_nothrow_move_constructible<T>::value>;
+
+            storage_type m_storage;
+
+            impl_base* m_impl = nullptr;
+
+            bool m_small = false;
+
+            template <typename T, typename... TArgs>
+            void create(std::true_type /*small*/, TArgs&&... args) {
+                m_impl = new (&m_storage) T(std::forward<TArgs>(args)...);
+                m_small = true;
+            }
+
+            template <typename T, typename... TArgs>
+            void create(std::false_type /*small*/, TArgs&&... args) {
+                m_impl = new T(std::forward<TArgs>(args)...);
+                m_small = false;
+            }
+
+            void move_from(function_wrapper& other) noexcept {
+                m_small = other.m_small;
+                if (other.m_small) {
+                    m_impl = other.m_impl->move_to(&m_storage);
+                    other.m_impl->~impl_base();
+                } else {
+                    m_impl = other.m_impl;
+                }
+                other.m_impl = nullptr;
+                other.m_small = false;
+            }
+
+            void reset() noexcept {
+                if (!m_impl) {
+                    return;
+                }
+                if (m_small) {
+                    m_impl->~impl_base();
+                } else {
+                    delete m_impl;
+                }
+                m_impl = nullptr;
+                m_small = false;
+            }
+
         public:
 
             // Constructor must not be "explicit" for wrapper
@@ -90,19 +165,19 @@ namespace osmium {
             template <typename TFunction, typename X = typename std::enable_if<
                 !std::is_same<TFunction, function_wrapper>::value, void>::type>
             // cppcheck-suppress noExplicitConstructor
-            function_wrapper(TFunction&& f) : // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
-                impl(new impl_type<TFunction>(std::forward<TFunction>(f))) {
+            function_wrapper(TFunction&& f) { // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
+                create<impl_type<TFunction>>(is_small<impl_type<TFunction>>{}, std::forward<TFunction>(f));
             }
 
             // The integer parameter is only used to signal that we want
             // the special function wrapper that makes the worker thread
             // shut down.
-            explicit function_wrapper(int /*dummy*/) :
-                impl(new impl_base()) {
+            explicit function_wrapper(int /*dummy*/) {
+                create<impl_base>(std::true_type{});
             }
 
             bool operator()() {
-                return impl->call();
+                return m_impl->call();
             }
 
             function_wrapper() = default;
@@ -110,19 +185,29 @@ namespace osmium {
             function_wrapper(const function_wrapper&) = delete;
             function_wrapper& operator=(const function_wrapper&) = delete;
 
-            function_wrapper(function_wrapper&& other) noexcept :
-                impl(std::move(other.impl)) {
+            function_wrapper(function_wrapper&& other) noexcept {
+                move_from(other);
             }
 
             function_wrapper& operator=(function_wrapper&& other) noexcept {
-                impl = std::move(other.impl);
+                if (this != &other) {
+                    reset();
+                    move_from(other);
+                }
                 return *this;
             }
 
-            ~function_wrapper() = default;
+            ~function_wrapper() noexcept {
+                reset();
+            }
 
             explicit operator bool() const {
-                return static_cast<bool>(impl);
+                return m_impl != nullptr;
+            }
+
+            /// Is the function stored inside this wrapper (and not on the heap)?
+            bool is_stored_inline() const noexcept {
+                return m_impl && m_small;
             }
 
         }; // class function_wrapper
@@ -0,0 +1,384 @@
+#ifndef OSMIUM_THREAD_LOCKFREE_QUEUE_HPP
+#define OSMIUM_THREAD_LOCKFREE_QUEUE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/budget.hpp>
+#include <osmium/thread/queue_stats.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility> // IWYU pragma: keep
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+# include <iostream>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A thread-safe bounded queue for any number of producers and
+         * consumers implemented as a lock-free ring buffer. It has the same
+         * interface as osmium::thread::Queue and can be used instead of it.
+         *
+         * Pushing and popping doesn't take a lock as long as the queue is
+         * neither full nor empty. A thread that has to wait spins for a
+         * short while and then goes to sleep on a condition variable until
+         * it is woken up by the other side.
+         *
+         * Define OSMIUM_USE_LOCKFREE_QUEUE before including any Osmium
+         * headers to use this queue in the thread pool and the I/O
+         * pipelines.
+         */
+        template <typename T>
+        class LockFreeQueue {
+
+            enum : std::size_t {
+                // Number of elements if no maximum size is set.
+                default_max_size = 1024,
+
+                // Used to keep the producer and consumer positions in
+                // different cache lines.
+                cache_line_size = 64
+            };
+
+            enum {
+                // Number of times a waiting thread checks the queue
+                // before it goes to sleep.
+                spin_count = 100
+            };
+
+            struct cell {
+                std::atomic<std::size_t> sequence{0};
+                T value{};
+                std::size_t bytes = 0;
+            };
+
+            /// Maximum size of this queue. If the queue is full pushing to
+            /// the queue will block.
+            const std::size_t m_max_size;
+
+            /// Name of this queue (for debugging and stats).
+            const std::string m_name;
+
+            /// Maximum number of bytes in this queue. This limit is not
+            /// exact, several threads pushing at the same time can go a
+            /// bit over it.
+            const std::size_t m_max_bytes;
+
+            std::unique_ptr<cell[]> m_cells;
+
+            /// Number of bytes in the queue as given to push().
+            std::atomic<std::size_t> m_bytes{0};
+
+            char m_pad0[cache_line_size];
+            std::atomic<std::size_t> m_push_pos{0};
+            char m_pad1[cache_line_size];
+            std::atomic<std::size_t> m_pop_pos{0};
+            char m_pad2[cache_line_size];
+
+            /// Number of threads sleeping in push() or wait_and_pop().
+            std::atomic<int> m_sleeping{0};
+
+            /// Only used for sleeping threads.
+            std::mutex m_mutex;
+
+            /// Used to signal consumers when data is available in the queue.
+            std::condition_variable m_data_available;
+
+            /// Used to signal producers when queue is not full.
+            std::condition_variable m_space_available;
+
+            /// Statistics about the use of this queue.
+            detail::queue_counters m_counters;
+
+            /// Account for the bytes in this queue in a memory budget.
+            osmium::memory::MemoryBudget::account m_budget_account;
+
+            cell& cell_at(const std::size_t pos) noexcept {
+                return m_cells[pos % m_max_size];
+            }
+
+            bool try_push(T& value, const std::size_t bytes) {
+                // An element is always allowed into an empty queue even
+                // if it is larger than the byte limit or the memory budget
+                // is exhausted.
+                const std::size_t current = m_bytes.load(std::memory_order_acquire);
+                if (m_max_bytes && current > 0 && current + bytes > m_max_bytes) {
+                    return false;
+                }
+                if (current == 0) {
+                    m_budget_account.add(bytes);
+                } else if (!m_budget_account.try_add(bytes)) {
+                    return false;
+                }
+                std::size_t pos = m_push_pos.load(std::memory_order_relaxed);
+                while (true) {
+                    cell& c = cell_at(pos);
+                    const std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+                    if (sequence == pos) {
+                        if (m_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            c.value = std::move(value);
+                            c.bytes = bytes;
+                            m_bytes.fetch_add(bytes, std::memory_order_acq_rel);
+                            c.sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (sequence < pos) {
+                        m_budget_account.sub(bytes);
+                        return false; // full
+                    } else {
+                        pos = m_push_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            bool try_pop_impl(T& value) {
+                std::size_t pos = m_pop_pos.load(std::memory_order_relaxed);
+                while (true) {
+                    cell& c = cell_at(pos);
+                    const std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+                    if (sequence == pos + 1) {
+                        if (m_pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            value = std::move(c.value);
+                            m_bytes.fetch_sub(c.bytes, std::memory_order_acq_rel);
+                            m_budget_account.sub(c.bytes);
+                            c.sequence.store(pos + m_max_size, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (sequence < pos + 1) {
+                        return false; // empty
+                    } else {
+                        pos = m_pop_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // Wake up threads sleeping on the condition variable. This is
+            // cheap if nobody is sleeping.
+            void wake_up(std::condition_variable& condition) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_sleeping.load(std::memory_order_relaxed) > 0) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    condition.notify_all();
+                }
+            }
+
+            // Call func until it returns true. Spin for a while first, then
+            // sleep on the condition variable. The timeout makes sure we
+            // never sleep forever even if a wake up is missed.
+            template <typename TFunc>
+            void spin_then_park(std::condition_variable& condition, TFunc&& func) {
+                constexpr const std::chrono::milliseconds max_wait{10};
+
+                for (int i = 0; i < spin_count; ++i) {
+                    if (func()) {
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+
+                std::unique_lock<std::mutex> lock{m_mutex};
+                ++m_sleeping;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                while (!func()) {
+                    condition.wait_for(lock, max_wait);
+                }
+                --m_sleeping;
+            }
+
+        public:
+
+            /**
+             * Construct a multithreaded queue.
+             *
+             * @param max_size Maximum number of elements in the queue. Set to
+             *                 0 for the default size. (The queue can not
+             *                 have an unlimited size.)
+             * @param name Optional name for this queue. (Used for debugging
+             *             and in the stats.)
+             * @param max_bytes Maximum number of bytes in the queue as
+             *                  given to push(). Set to 0 for no limit.
+             */
+            explicit LockFreeQueue(std::size_t max_size = 0, std::string name = "", std::size_t max_bytes = 0) :
+                m_max_size(max_size > 0 ? max_size : default_max_size),
+                m_name(std::move(name)),
+                m_max_bytes(max_bytes),
+                m_cells(new cell[m_max_size]) {
+                for (std::size_t i = 0; i < m_max_size; ++i) {
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            LockFreeQueue(const LockFreeQueue&) = delete;
+            LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+            LockFreeQueue(LockFreeQueue&&) = delete;
+            LockFreeQueue& operator=(LockFreeQueue&&) = delete;
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+            ~LockFreeQueue() {
+                std::cerr << stats() << '\n';
+            }
+#else
+            ~LockFreeQueue() = default;
+#endif
+
+            /**
+             * Account for the bytes in this queue (as given to push()) in
+             * the specified memory budget. While the budget is exhausted,
+             * push() will block, unless the queue is empty. Call this
+             * before the queue is used by any other thread. The budget
+             * must outlive the queue.
+             */
+            void set_memory_budget(osmium::memory::MemoryBudget& budget) {
+                m_budget_account = budget.add_account(m_name.empty() ? "queue" : m_name);
+            }
+
+            /**
+             * Push an element onto the queue. If the queue is full,
+             * adding the element would go over the byte limit, or the
+             * memory budget is exhausted, this call will block.
+             *
+             * @param value The element.
+             * @param bytes The (estimated) size of the element in bytes.
+             */
+            void push(T value, std::size_t bytes = 0) {
+                m_counters.count_push();
+                if (!try_push(value, bytes)) {
+                    const auto start = detail::queue_counters::now();
+                    spin_then_park(m_space_available, [this, &value, bytes] {
+                        return try_push(value, bytes);
+                    });
+                    m_counters.blocked_push(start);
+                }
+                m_counters.update_largest_size(size());
+                m_counters.update_largest_bytes(this->bytes());
+                wake_up(m_data_available);
+            }
+
+            /**
+             * Push all elements in the range [first, last) onto the queue
+             * in order. The elements are moved out of the range. Waiting
+             * consumers are only woken up once (unless the queue gets
+             * full). The elements don't count towards the byte limit.
+             */
+            template <typename TIterator>
+            void push_many(TIterator first, TIterator last) {
+                for (; first != last; ++first) {
+                    m_counters.count_push();
+                    if (!try_push(*first, 0)) {
+                        wake_up(m_data_available);
+                        const auto start = detail::queue_counters::now();
+                        spin_then_park(m_space_available, [this, &first] {
+                            return try_push(*first, 0);
+                        });
+                        m_counters.blocked_push(start);
+                    }
+                }
+                m_counters.update_largest_size(size());
+                wake_up(m_data_available);
+            }
+
+            void wait_and_pop(T& value) {
+                m_counters.count_pop();
+                if (!try_pop_impl(value)) {
+                    const auto start = detail::queue_counters::now();
+                    spin_then_park(m_data_available, [this, &value] {
+                        return try_pop_impl(value);
+                    });
+                    m_counters.blocked_pop(start);
+                }
+                wake_up(m_space_available);
+            }
+
+            bool try_pop(T& value) {
+                m_counters.count_pop();
+                if (!try_pop_impl(value)) {
+                    m_counters.count_empty();
+                    return false;
+                }
+                wake_up(m_space_available);
+                return true;
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+            /**
+             * The number of elements in the queue. This is only a snapshot
+             * if other threads are using the queue at the same time.
+             */
+            std::size_t size() const {
+                const std::size_t pop_pos = m_pop_pos.load(std::memory_order_acquire);
+                const std::size_t push_pos = m_push_pos.load(std::memory_order_acquire);
+                return push_pos > pop_pos ? push_pos - pop_pos : 0;
+            }
+
+            /**
+             * The number of bytes in the queue as given to push(). This is
+             * only a snapshot if other threads are using the queue at the
+             * same time.
+             */
+            std::size_t bytes() const noexcept {
+                return m_bytes.load(std::memory_order_acquire);
+            }
+
+            const std::string& name() const noexcept {
+                return m_name;
+            }
+
+            /**
+             * Get a snapshot of the statistics of this queue. This can be
+             * called from any thread at any time.
+             */
+            queue_stats stats() const {
+                return m_counters.get(m_name, m_max_size, size(), m_max_bytes, bytes());
+            }
+
+        }; // class LockFreeQueue
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_LOCKFREE_QUEUE_HPP
@@ -0,0 +1,175 @@
+#ifndef OSMIUM_THREAD_NUMA_HPP
+#define OSMIUM_THREAD_NUMA_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+# include <sched.h>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        namespace detail {
+
+            /**
+             * Parse a list of CPUs or NUMA nodes in the format used by
+             * Linux in sysfs, for instance "0-3,8,10-11".
+             *
+             * @returns Vector of all numbers in the list, empty vector if
+             *          the list is empty or invalid.
+             */
+            inline std::vector<int> parse_cpu_list(const std::string& list) {
+                std::vector<int> result;
+
+                const char* str = list.c_str();
+                while (*str != '\0' && *str != '\n') {
+                    char* end = nullptr;
+                    const long first = std::strtol(str, &end, 10); // NOLINT(google-runtime-int)
+                    if (end == str || first < 0) {
+                        return {};
+                    }
+                    long last = first; // NOLINT(google-runtime-int)
+                    str = end;
+                    if (*str == '-') {
+                        ++str;
+                        last = std::strtol(str, &end, 10);
+                        if (end == str || last < first) {
+                            return {};
+                        }
+                        str = end;
+                    }
+                    for (long n = first; n <= last; ++n) { // NOLINT(google-runtime-int)
+                        result.push_back(static_cast<int>(n));
+                    }
+                    if (*str == ',') {
+                        ++str;
+                    } else if (*str != '\0' && *str != '\n') {
+                        return {};
+                    }
+                }
+
+                return result;
+            }
+
+            inline std::string read_first_line(const std::string& filename) {
+                std::ifstream file{filename};
+                std::string line;
+                std::getline(file, line);
+                return line;
+            }
+
+        } // namespace detail
+
+        /**
+         * Get the CPUs of all NUMA nodes on this system by reading the
+         * information Linux provides in sysfs. Nodes are indexed by their
+         * position in the result, not by their id.
+         *
+         * @param sysfs_dir The sysfs directory with the node information.
+         * @returns A vector with the CPU numbers for each node. The vector
+         *          is empty if the information is not available.
+         */
+        inline std::vector<std::vector<int>> numa_node_cpus(const std::string& sysfs_dir = "/sys/devices/system/node") {
+            std::vector<std::vector<int>> nodes;
+
+            for (const int node : detail::parse_cpu_list(detail::read_first_line(sysfs_dir + "/online"))) {
+                auto cpus = detail::parse_cpu_list(detail::read_first_line(sysfs_dir + "/node" + std::to_string(node) + "/cpulist"));
+                if (!cpus.empty()) {
+                    nodes.push_back(std::move(cpus));
+                }
+            }
+
+            return nodes;
+        }
+
+        /**
+         * Get the index of the NUMA node the current thread is running on.
+         *
+         * @param nodes The CPUs of all nodes as returned by numa_node_cpus().
+         * @returns The index into nodes or -1 if it is not known.
+         */
+        inline int current_numa_node(const std::vector<std::vector<int>>& nodes) noexcept {
+#ifdef __linux__
+            const int cpu = ::sched_getcpu();
+            for (std::size_t i = 0; i < nodes.size(); ++i) {
+                for (const int node_cpu : nodes[i]) {
+                    if (node_cpu == cpu) {
+                        return static_cast<int>(i);
+                    }
+                }
+            }
+#else
+            (void)nodes;
+#endif
+            return -1;
+        }
+
+        /**
+         * Restrict the current thread to run only on the given CPUs. This
+         * only works on Linux.
+         *
+         * @returns True if the affinity was set, false otherwise.
+         */
+        inline bool set_thread_affinity(const std::vector<int>& cpus) noexcept {
+#ifdef __linux__
+            if (cpus.empty()) {
+                return false;
+            }
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+            (void)cpus;
+            return false;
+#endif
+        }
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_NUMA_HPP
@@ -0,0 +1,590 @@
+#ifndef OSMIUM_THREAD_PIPELINE_HPP
+#define OSMIUM_THREAD_PIPELINE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/queue_stats.hpp>
+#include <osmium/thread/util.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * How the function of a pipeline stage is called.
+         */
+        enum class stage_mode {
+
+            /// Called for several buffers in parallel on the thread pool,
+            /// results are passed on in input order.
+            ordered = 0,
+
+            /// Called for several buffers in parallel on the thread pool,
+            /// results are passed on as soon as they are available.
+            unordered = 1,
+
+            /// Called for one buffer after the other in input order in a
+            /// thread of its own. Use this for stages with state like
+            /// handlers or writers.
+            stateful = 2
+
+        }; // enum class stage_mode
+
+        inline const char* stage_mode_name(const stage_mode mode) noexcept {
+            static const char* names[] = {"ordered", "unordered", "stateful"};
+            return names[static_cast<int>(mode)];
+        }
+
+        /**
+         * Statistics about one stage (or sink) of a Pipeline.
+         */
+        struct pipeline_stage_stats {
+
+            /// Name of the stage.
+            std::string name{};
+
+            /// Mode of the stage. Sinks are always stateful.
+            stage_mode mode = stage_mode::ordered;
+
+            /// Number of buffers handed to the stage function.
+            uint64_t buffers = 0;
+
+            /// Number of committed bytes in those buffers.
+            uint64_t bytes = 0;
+
+            /// Total time spent in the stage function summed up over all
+            /// threads.
+            std::chrono::nanoseconds busy{0};
+
+            /// Statistics of the queue in front of the stage.
+            queue_stats input_queue{};
+
+            /// Bytes handled per second of busy time (per thread).
+            double bytes_per_second() const noexcept {
+                return busy.count() == 0 ? 0.0 : static_cast<double>(bytes) * 1e9 / static_cast<double>(busy.count());
+            }
+
+        }; // struct pipeline_stage_stats
+
+        template <typename TChar, typename TTraits>
+        inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const pipeline_stage_stats& stats) {
+            return out << "stage '" << stats.name
+                       << "' (" << stage_mode_name(stats.mode)
+                       << ") handled " << stats.buffers
+                       << " buffers with " << stats.bytes
+                       << " bytes in " << std::chrono::duration_cast<std::chrono::milliseconds>(stats.busy).count()
+                       << " ms busy time";
+        }
+
+        namespace detail {
+
+            // Element of the queues between pipeline stages. The end of
+            // the data is marked by an element with end set.
+            struct pipeline_item {
+
+                std::future<osmium::memory::Buffer> future{};
+                bool end = false;
+
+                pipeline_item() = default;
+
+                pipeline_item(std::future<osmium::memory::Buffer>&& buffer_future, const bool is_end) :
+                    future(std::move(buffer_future)),
+                    end(is_end) {
+                }
+
+            }; // struct pipeline_item
+
+            inline pipeline_item make_pipeline_item(osmium::memory::Buffer&& buffer) {
+                std::promise<osmium::memory::Buffer> promise;
+                promise.set_value(std::move(buffer));
+                return pipeline_item{promise.get_future(), false};
+            }
+
+            inline pipeline_item make_pipeline_end() {
+                return pipeline_item{std::future<osmium::memory::Buffer>{}, true};
+            }
+
+            class pipeline_counters {
+
+                std::atomic<uint64_t> m_buffers{0};
+                std::atomic<uint64_t> m_bytes{0};
+                std::atomic<int64_t> m_busy{0};
+
+            public:
+
+                template <typename TFunction, typename... TArgs>
+                auto call(TFunction& func, const osmium::memory::Buffer& buffer, TArgs&&... args) -> decltype(func(std::forward<TArgs>(args)...)) {
+                    m_buffers.fetch_add(1, std::memory_order_relaxed);
+                    m_bytes.fetch_add(buffer.committed(), std::memory_order_relaxed);
+                    struct timer {
+                        std::atomic<int64_t>& busy;
+                        std::chrono::steady_clock::time_point start;
+                        ~timer() {
+                            busy.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+                                           std::memory_order_relaxed);
+                        }
+                    } const t{m_busy, std::chrono::steady_clock::now()};
+                    return func(std::forward<TArgs>(args)...);
+                }
+
+                void fill(pipeline_stage_stats& stats) const noexcept {
+                    stats.buffers = m_buffers.load(std::memory_order_relaxed);
+                    stats.bytes = m_bytes.load(std::memory_order_relaxed);
+                    stats.busy = std::chrono::nanoseconds{m_busy.load(std::memory_order_relaxed)};
+                }
+
+            }; // class pipeline_counters
+
+        } // namespace detail
+
+        /**
+         * A pipeline of stages working on buffers of OSM data. Buffers
+         * are read from a source (usually an osmium::io::Reader) and
+         * handed through all stages one after the other. The output of
+         * the last stage is handed to all sinks (for instance several
+         * Writers).
+         *
+         * Each stage gets a buffer and returns a buffer, it can change the
+         * buffer in place (like adding node locations to ways) or return
+         * a different one (like a filter). If it returns an invalid buffer
+         * (osmium::memory::Buffer{}) nothing is handed on. Stages are
+         * either ordered, unordered, or stateful (see stage_mode). The
+         * functions of ordered and unordered stages are called on the
+         * thread pool from several threads at the same time, they must be
+         * thread safe.
+         *
+         * The stages are connected by queues of limited size, so only a
+         * bounded number of buffers is in the pipeline at any time. Each
+         * stateful stage, each sink, and the distribution to the sinks run
+         * in a thread of their own, the work of the other stages is done
+         * on the (shared) thread pool.
+         *
+         * Usage:
+         * @code
+         * osmium::io::Reader reader{"input.osm.pbf"};
+         * osmium::io::Writer writer{"output.osm.pbf"};
+         * osmium::thread::Pipeline pipeline;
+         * pipeline.add_stage("filter", osmium::thread::stage_mode::ordered, [](osmium::memory::Buffer&& buffer) {
+         *     ... return filtered buffer ...
+         * });
+         * pipeline.add_stage("write", osmium::thread::stage_mode::stateful, [&](osmium::memory::Buffer&& buffer) {
+         *     writer(std::move(buffer));
+         *     return osmium::memory::Buffer{};
+         * });
+         * pipeline.run(reader);
+         * writer.close();
+         * reader.close();
+         * for (const auto& stats : pipeline.stats()) {
+         *     std::cerr << stats << '\n';
+         * }
+         * @endcode
+         *
+         * If there is only one writer, it is cheaper to use a stateful
+         * stage as in the example above, because sinks only get a const
+         * reference to the buffer which they share with the other sinks.
+         */
+        class Pipeline {
+
+        public:
+
+            using stage_function = std::function<osmium::memory::Buffer(osmium::memory::Buffer&&)>;
+
+            using sink_function = std::function<void(const osmium::memory::Buffer&)>;
+
+        private:
+
+            using buffer_ptr = std::shared_ptr<const osmium::memory::Buffer>;
+
+            struct stage {
+
+                std::string name;
+                stage_mode mode;
+                stage_function func;
+                Queue<detail::pipeline_item> input;
+                detail::pipeline_counters counters{};
+
+                // Promises for the results of an unordered stage. They
+                // are fulfilled in the order the results become ready.
+                std::mutex slots_mutex{};
+                std::deque<std::promise<osmium::memory::Buffer>> slots{};
+
+                stage(std::string&& stage_name, const stage_mode run_mode, stage_function&& function, const std::size_t queue_size) :
+                    name(std::move(stage_name)),
+                    mode(run_mode),
+                    func(std::move(function)),
+                    input(queue_size, name) {
+                }
+
+            }; // struct stage
+
+            struct sink {
+
+                std::string name;
+                sink_function func;
+                Queue<buffer_ptr> input;
+                detail::pipeline_counters counters{};
+
+                sink(std::string&& sink_name, sink_function&& function, const std::size_t queue_size) :
+                    name(std::move(sink_name)),
+                    func(std::move(function)),
+                    input(queue_size, name) {
+                }
+
+            }; // struct sink
+
+            // Task for an ordered stage on the pool.
+            struct ordered_task {
+
+                stage* s;
+                osmium::memory::Buffer buffer;
+
+                osmium::memory::Buffer operator()() {
+                    return s->counters.call(s->func, buffer, std::move(buffer));
+                }
+
+            }; // struct ordered_task
+
+            // Task for an unordered stage on the pool. It fulfills the
+            // first open slot of the stage when it is done.
+            struct unordered_task {
+
+                stage* s;
+                osmium::memory::Buffer buffer;
+
+                void operator()() {
+                    osmium::memory::Buffer result;
+                    std::exception_ptr exception;
+                    try {
+                        result = s->counters.call(s->func, buffer, std::move(buffer));
+                    } catch (...) {
+                        exception = std::current_exception();
+                    }
+                    std::promise<osmium::memory::Buffer> promise;
+                    {
+                        const std::lock_guard<std::mutex> lock{s->slots_mutex};
+                        promise = std::move(s->slots.front());
+                        s->slots.pop_front();
+                    }
+                    if (exception) {
+                        promise.set_exception(exception);
+                    } else {
+                        promise.set_value(std::move(result));
+                    }
+                }
+
+            }; // struct unordered_task
+
+            osmium::thread::Pool& m_pool;
+            std::size_t m_queue_size;
+            std::vector<std::unique_ptr<stage>> m_stages;
+            std::vector<std::unique_ptr<sink>> m_sinks;
+            Queue<detail::pipeline_item> m_output;
+
+            std::mutex m_error_mutex;
+            std::exception_ptr m_error;
+            std::atomic<bool> m_failed{false};
+            bool m_run = false;
+
+            void set_error(std::exception_ptr&& exception) {
+                const std::lock_guard<std::mutex> lock{m_error_mutex};
+                if (!m_error) {
+                    m_error = std::move(exception);
+                }
+                m_failed = true;
+            }
+
+            void process(stage& s, osmium::memory::Buffer&& buffer, Queue<detail::pipeline_item>& output) {
+                switch (s.mode) {
+                    case stage_mode::ordered:
+                        output.push(detail::pipeline_item{m_pool.submit(ordered_task{&s, std::move(buffer)}), false});
+                        break;
+                    case stage_mode::unordered: {
+                            std::future<osmium::memory::Buffer> future;
+                            {
+                                const std::lock_guard<std::mutex> lock{s.slots_mutex};
+                                s.slots.emplace_back();
+                                future = s.slots.back().get_future();
+                            }
+                            output.push(detail::pipeline_item{std::move(future), false});
+                            m_pool.submit(unordered_task{&s, std::move(buffer)});
+                        }
+                        break;
+                    case stage_mode::stateful:
+                        output.push(detail::make_pipeline_item(s.counters.call(s.func, buffer, std::move(buffer))));
+                        break;
+                }
+            }
+
+            // Get the next buffer from the queue. Returns false at the
+            // end of the data. Errors are recorded and the buffer is
+            // dropped. After an error all buffers are dropped.
+            bool next_buffer(Queue<detail::pipeline_item>& input, osmium::memory::Buffer& buffer) {
+                detail::pipeline_item item;
+                input.wait_and_pop(item);
+                if (item.end) {
+                    return false;
+                }
+                try {
+                    buffer = item.future.get();
+                } catch (...) {
+                    set_error(std::current_exception());
+                }
+                if (m_failed) {
+                    buffer = osmium::memory::Buffer{};
+                }
+                return true;
+            }
+
+            void run_stage(stage& s, Queue<detail::pipeline_item>& output) {
+                osmium::thread::set_thread_name("_osmium_pipe");
+                osmium::memory::Buffer buffer;
+                while (next_buffer(s.input, buffer)) {
+                    if (buffer) {
+                        try {
+                            process(s, std::move(buffer), output);
+                        } catch (...) {
+                            set_error(std::current_exception());
+                        }
+                    }
+                }
+                output.push(detail::make_pipeline_end());
+            }
+
+            void run_dispatcher() {
+                osmium::thread::set_thread_name("_osmium_pipe");
+                osmium::memory::Buffer buffer;
+                while (next_buffer(m_output, buffer)) {
+                    if (buffer && !m_sinks.empty()) {
+                        const buffer_ptr ptr = std::make_shared<const osmium::memory::Buffer>(std::move(buffer));
+                        for (auto& s : m_sinks) {
+                            s->input.push(ptr);
+                        }
+                    }
+                }
+                for (auto& s : m_sinks) {
+                    s->input.push(buffer_ptr{});
+                }
+            }
+
+            void run_sink(sink& s) {
+                osmium::thread::set_thread_name("_osmium_pipe");
+                while (true) {
+                    buffer_ptr ptr;
+                    s.input.wait_and_pop(ptr);
+                    if (!ptr) {
+                        return;
+                    }
+                    if (!m_failed) {
+                        try {
+                            s.counters.call(s.func, *ptr, *ptr);
+                        } catch (...) {
+                            set_error(std::current_exception());
+                        }
+                    }
+                }
+            }
+
+        public:
+
+            /**
+             * Create a pipeline.
+             *
+             * @param pool The thread pool used for ordered and unordered
+             *             stages.
+             * @param queue_size The maximum number of buffers in each of
+             *                   the queues between the stages. This also
+             *                   limits the number of buffers handled at
+             *                   the same time in a parallel stage. The
+             *                   default (0) is twice the number of threads
+             *                   in the pool.
+             */
+            explicit Pipeline(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(), const std::size_t queue_size = 0) :
+                m_pool(pool),
+                m_queue_size(queue_size > 0 ? queue_size : static_cast<std::size_t>(pool.num_threads()) * 2),
+                m_output(m_queue_size, "pipeline_output") {
+            }
+
+            Pipeline(const Pipeline&) = delete;
+            Pipeline& operator=(const Pipeline&) = delete;
+
+            Pipeline(Pipeline&&) = delete;
+            Pipeline& operator=(Pipeline&&) = delete;
+
+            ~Pipeline() noexcept = default;
+
+            /**
+             * Add a stage at the end of the pipeline.
+             *
+             * @param name Name of the stage (used in the stats).
+             * @param mode How the stage is run.
+             * @param func The function called for each buffer.
+             * @returns A reference to this pipeline.
+             */
+            Pipeline& add_stage(std::string name, const stage_mode mode, stage_function func) {
+                m_stages.emplace_back(new stage{std::move(name), mode, std::move(func), m_queue_size});
+                return *this;
+            }
+
+            /**
+             * Add a sink getting all buffers from the last stage (or from
+             * the source if there are no stages). All sinks get the same
+             * buffers in input order (or in the order an unordered last
+             * stage returns them). Each sink runs in its own thread.
+             *
+             * @param name Name of the sink (used in the stats).
+             * @param func The function called for each buffer.
+             * @returns A reference to this pipeline.
+             */
+            Pipeline& add_sink(std::string name, sink_function func) {
+                m_sinks.emplace_back(new sink{std::move(name), std::move(func), m_queue_size});
+                return *this;
+            }
+
+            /// The number of stages in this pipeline.
+            std::size_t num_stages() const noexcept {
+                return m_stages.size();
+            }
+
+            /// The number of sinks in this pipeline.
+            std::size_t num_sinks() const noexcept {
+                return m_sinks.size();
+            }
+
+            /**
+             * Run the pipeline with all the buffers from the source. This
+             * returns when all buffers went through all stages and sinks.
+             * A pipeline can only be run once.
+             *
+             * @param source Source of buffers, usually an
+             *               osmium::io::Reader. Its read() function is
+             *               called in the current thread until it returns
+             *               an invalid buffer.
+             * @throws std::logic_error If the pipeline was run before.
+             * @throws Any exception thrown by the source or a stage or
+             *         sink function. If there is an exception, no further
+             *         buffers are read and all buffers still in the
+             *         pipeline are dropped. The first exception is
+             *         rethrown after all threads are done.
+             */
+            template <typename TSource>
+            void run(TSource& source) {
+                if (m_run) {
+                    throw std::logic_error{"Pipeline can only be run once"};
+                }
+                m_run = true;
+
+                std::vector<osmium::thread::thread_handler> threads;
+                for (std::size_t n = 0; n < m_stages.size(); ++n) {
+                    auto& output = n + 1 < m_stages.size() ? m_stages[n + 1]->input : m_output;
+                    threads.emplace_back(&Pipeline::run_stage, this, std::ref(*m_stages[n]), std::ref(output));
+                }
+                threads.emplace_back(&Pipeline::run_dispatcher, this);
+                for (auto& s : m_sinks) {
+                    threads.emplace_back(&Pipeline::run_sink, this, std::ref(*s));
+                }
+
+                auto& input = m_stages.empty() ? m_output : m_stages.front()->input;
+                try {
+                    while (!m_failed) {
+                        auto buffer = source.read();
+                        if (!buffer) {
+                            break;
+                        }
+                        input.push(detail::make_pipeline_item(std::move(buffer)));
+                    }
+                } catch (...) {
+                    set_error(std::current_exception());
+                }
+                input.push(detail::make_pipeline_end());
+
+                threads.clear();
+
+                if (m_error) {
+                    std::rethrow_exception(m_error);
+                }
+            }
+
+            /**
+             * Get the statistics of all stages followed by all sinks. This
+             * can be called at any time from any thread, while the
+             * pipeline is running the numbers are a snapshot.
+             */
+            std::vector<pipeline_stage_stats> stats() const {
+                std::vector<pipeline_stage_stats> result;
+                result.reserve(m_stages.size() + m_sinks.size());
+                for (const auto& s : m_stages) {
+                    pipeline_stage_stats stats;
+                    stats.name = s->name;
+                    stats.mode = s->mode;
+                    s->counters.fill(stats);
+                    stats.input_queue = s->input.stats();
+                    result.push_back(std::move(stats));
+                }
+                for (const auto& s : m_sinks) {
+                    pipeline_stage_stats stats;
+                    stats.name = s->name;
+                    stats.mode = stage_mode::stateful;
+                    s->counters.fill(stats);
+                    stats.input_queue = s->input.stats();
+                    result.push_back(std::move(stats));
+                }
+                return result;
+            }
+
+        }; // class Pipeline
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_PIPELINE_HPP
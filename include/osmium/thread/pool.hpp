@@ -34,12 +34,24 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/thread/function_wrapper.hpp>
+#include <osmium/thread/numa.hpp>
 #include <osmium/thread/queue.hpp>
+#include <osmium/thread/queue_stats.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -82,13 +94,246 @@ namespace osmium {
                 return osmium::config::get_max_queue_size("WORK", 10);
             }
 
+            /**
+             * Shares the workers of a pool between the PoolClients of that
+             * pool using stride scheduling: Every client has a virtual
+             * time ("pass") that advances by a step inversely proportional
+             * to its weight for every task run. When a worker is free, it
+             * runs the oldest task of the client with the smallest pass.
+             */
+            class fair_scheduler {
+
+            public:
+
+                struct client_state {
+
+                    std::deque<function_wrapper> tasks{};
+                    std::condition_variable slot_available{};
+                    uint64_t stride;
+                    uint64_t pass = 0;
+
+                    // Number of tasks queued or running.
+                    std::size_t in_flight = 0;
+                    std::size_t max_in_flight;
+
+                    client_state(uint64_t s, std::size_t max) :
+                        stride(s),
+                        max_in_flight(max) {
+                    }
+
+                }; // struct client_state
+
+            private:
+
+                std::mutex m_mutex{};
+                std::vector<client_state*> m_clients{};
+
+                // Pass of the client that was scheduled last. Clients
+                // which were idle start from here, so they can't save
+                // up credit while they have nothing to do.
+                uint64_t m_pass = 0;
+
+            public:
+
+                enum : uint64_t {
+                    stride_base = 1U << 20U
+                };
+
+                void add(client_state& client) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    client.pass = m_pass;
+                    m_clients.push_back(&client);
+                }
+
+                // Waits until all tasks of the client are done.
+                void remove(client_state& client) {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    client.slot_available.wait(lock, [&client] {
+                        return client.in_flight == 0;
+                    });
+                    m_clients.erase(std::find(m_clients.begin(), m_clients.end(), &client));
+                }
+
+                // Blocks while the client has max_in_flight tasks.
+                void enqueue(client_state& client, function_wrapper&& task) {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    client.slot_available.wait(lock, [&client] {
+                        return client.in_flight < client.max_in_flight;
+                    });
+                    if (client.tasks.empty() && client.pass < m_pass) {
+                        client.pass = m_pass;
+                    }
+                    ++client.in_flight;
+                    client.tasks.push_back(std::move(task));
+                }
+
+                // Run the next task of the client which is most behind
+                // its share. Called once for every enqueued task.
+                void run_next() {
+                    function_wrapper task;
+                    client_state* next = nullptr;
+                    {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                        for (auto* client : m_clients) {
+                            if (!client->tasks.empty() && (!next || client->pass < next->pass)) {
+                                next = client;
+                            }
+                        }
+                        if (!next) {
+                            return;
+                        }
+                        m_pass = next->pass;
+                        next->pass += next->stride;
+                        task = std::move(next->tasks.front());
+                        next->tasks.pop_front();
+                    }
+
+                    task();
+
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    --next->in_flight;
+                    next->slot_available.notify_all();
+                }
+
+            }; // class fair_scheduler
+
         } // namespace detail
 
+        /**
+         * Snapshot of the statistics of a thread pool. Returned by
+         * Pool::stats().
+         */
+        struct pool_stats {
+
+            /// Number of worker threads.
+            int num_threads = 0;
+
+            /// Number of tasks waiting to be run.
+            std::size_t queued_tasks = 0;
+
+            /// Number of tasks run to completion so far.
+            uint64_t tasks_executed = 0;
+
+            /// Total time all workers spent running tasks.
+            std::chrono::nanoseconds busy_time{0};
+
+            /// Time since the pool was created.
+            std::chrono::nanoseconds uptime{0};
+
+            /// Stats of the shared work queue.
+            queue_stats work_queue{};
+
+            /**
+             * The fraction of the available worker time spent running
+             * tasks (between 0 and 1).
+             */
+            double utilization() const noexcept {
+                if (num_threads <= 0 || uptime.count() <= 0) {
+                    return 0.0;
+                }
+                return static_cast<double>(busy_time.count()) /
+                       (static_cast<double>(uptime.count()) * num_threads);
+            }
+
+        }; // struct pool_stats
+
         /**
          *  Thread pool.
+         *
+         *  By default all tasks go through one shared work queue. In the
+         *  work-stealing mode every worker thread has an additional queue
+         *  of its own. Tasks submitted from within a worker thread of the
+         *  pool go onto the queue of that thread, they don't block and
+         *  don't contend with other threads for the shared queue. A worker
+         *  takes tasks from its own queue first (newest first), then from
+         *  the shared queue, and if there is nothing there, it steals the
+         *  oldest task from the queue of another worker.
          */
         class Pool {
 
+            friend class PoolClient;
+
+        public:
+
+            enum class scheduling {
+                default_scheduling = 0, // use OSMIUM_POOL_WORK_STEALING
+                shared_queue       = 1,
+                work_stealing      = 2
+            };
+
+            /**
+             * Placement of the worker threads on NUMA nodes. Memory is
+             * usually allocated on the node of the thread first writing
+             * to it, so this also decides where the buffers created by
+             * the workers end up.
+             */
+            enum class affinity {
+                default_affinity = 0, // use OSMIUM_POOL_AFFINITY
+                none             = 1, // no pinning
+                spread_nodes     = 2, // pin workers round-robin to all nodes
+                local_node       = 3  // pin workers to node of creating thread
+            };
+
+        private:
+
+            /**
+             * The per-worker queue used in work-stealing mode.
+             */
+            class work_deque {
+
+                std::mutex m_mutex;
+                std::deque<function_wrapper> m_tasks;
+
+            public:
+
+                void push(function_wrapper&& task) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_tasks.push_back(std::move(task));
+                }
+
+                void push_many(std::vector<function_wrapper>& tasks) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    for (auto& task : tasks) {
+                        m_tasks.push_back(std::move(task));
+                    }
+                }
+
+                // Take newest task. Used by the owning worker.
+                bool pop(function_wrapper& task) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_tasks.empty()) {
+                        return false;
+                    }
+                    task = std::move(m_tasks.back());
+                    m_tasks.pop_back();
+                    return true;
+                }
+
+                // Take oldest task. Used by other workers.
+                bool steal(function_wrapper& task) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_tasks.empty()) {
+                        return false;
+                    }
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                    return true;
+                }
+
+            }; // class work_deque
+
+            // Identifies the pool and worker the current thread belongs to
+            // if it is a worker thread in work-stealing mode.
+            struct worker_id {
+                const Pool* pool = nullptr;
+                std::size_t index = 0;
+            };
+
+            static worker_id& current_worker() noexcept {
+                static thread_local worker_id id;
+                return id;
+            }
+
             /**
              * This class makes sure all pool threads will be joined when
              * the pool is destructed.
@@ -119,22 +364,192 @@ namespace osmium {
 
             }; // class thread_joiner
 
-            osmium::thread::Queue<function_wrapper> m_work_queue;
+            osmium::thread::pipeline_queue<function_wrapper> m_work_queue;
+
+            // Only used in work-stealing mode.
+            std::vector<std::unique_ptr<work_deque>> m_local_queues{};
+            std::atomic<std::size_t> m_local_tasks{0};
+            std::atomic<int> m_idle_workers{0};
+            std::mutex m_idle_mutex{};
+            std::condition_variable m_work_available{};
+
+            // Used for the stats.
+            const std::chrono::steady_clock::time_point m_start_time{std::chrono::steady_clock::now()};
+            std::atomic<uint64_t> m_tasks_executed{0};
+            std::atomic<int64_t> m_busy_time{0};
+
             std::vector<std::thread> m_threads{};
             thread_joiner m_joiner;
             int m_num_threads;
+            bool m_work_stealing;
+
+            // CPUs each worker is pinned to. Empty if not pinned.
+            std::vector<std::vector<int>> m_worker_cpus{};
+
+            // Only used by PoolClients.
+            detail::fair_scheduler m_fair_scheduler{};
+
+            bool find_task(const std::size_t index, function_wrapper& task) {
+                if (m_local_queues[index]->pop(task)) {
+                    --m_local_tasks;
+                    return true;
+                }
+
+                if (m_work_queue.try_pop(task)) {
+                    return true;
+                }
 
-            void worker_thread() {
+                for (std::size_t n = 1; n < m_local_queues.size(); ++n) {
+                    if (m_local_queues[(index + n) % m_local_queues.size()]->steal(task)) {
+                        --m_local_tasks;
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void wait_for_task(const std::size_t index, function_wrapper& task) {
+                constexpr const std::chrono::milliseconds max_wait{10};
+
+                while (!find_task(index, task)) {
+                    std::unique_lock<std::mutex> lock{m_idle_mutex};
+                    ++m_idle_workers;
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    m_work_available.wait_for(lock, max_wait, [this] {
+                        return m_local_tasks > 0 || !m_work_queue.empty();
+                    });
+                    --m_idle_workers;
+                }
+            }
+
+            // Wake up an idle worker in work-stealing mode. This is cheap
+            // if no worker is idle.
+            void notify_idle_worker() {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_idle_workers > 0) {
+                    const std::lock_guard<std::mutex> lock{m_idle_mutex};
+                    m_work_available.notify_one();
+                }
+            }
+
+            // Same as notify_idle_worker() but wakes up all idle workers.
+            void notify_idle_workers() {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_idle_workers > 0) {
+                    const std::lock_guard<std::mutex> lock{m_idle_mutex};
+                    m_work_available.notify_all();
+                }
+            }
+
+            void worker_thread(const std::size_t index) {
                 osmium::thread::set_thread_name("_osmium_worker");
+                if (!m_worker_cpus.empty()) {
+                    set_thread_affinity(m_worker_cpus[index]);
+                }
+                if (m_work_stealing) {
+                    current_worker().pool = this;
+                    current_worker().index = index;
+                }
                 while (true) {
                     function_wrapper task;
-                    m_work_queue.wait_and_pop(task);
-                    if (task && task()) {
+                    if (m_work_stealing) {
+                        wait_for_task(index, task);
+                    } else {
+                        m_work_queue.wait_and_pop(task);
+                    }
+                    if (!task) {
+                        continue;
+                    }
+                    const auto start = std::chrono::steady_clock::now();
+                    if (task()) {
                         // The called tasks returns true only when the
                         // worker thread should shut down.
                         return;
                     }
+                    const auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                    m_busy_time.fetch_add(busy.count(), std::memory_order_relaxed);
+                    m_tasks_executed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            static affinity get_affinity(const affinity placement) noexcept {
+                if (placement != affinity::default_affinity) {
+                    return placement;
+                }
+                switch (osmium::config::get_pool_affinity()) {
+                    case 1:
+                        return affinity::spread_nodes;
+                    case 2:
+                        return affinity::local_node;
+                    default:
+                        break;
                 }
+                return affinity::none;
+            }
+
+            void assign_worker_cpus(const affinity placement) {
+                if (placement == affinity::none) {
+                    return;
+                }
+
+                const auto nodes = numa_node_cpus();
+                if (nodes.size() < 2) {
+                    // nothing to gain on a machine with only one node
+                    return;
+                }
+
+                if (placement == affinity::local_node) {
+                    const int node = current_numa_node(nodes);
+                    if (node < 0) {
+                        return;
+                    }
+                    m_worker_cpus.assign(static_cast<std::size_t>(m_num_threads), nodes[static_cast<std::size_t>(node)]);
+                    return;
+                }
+
+                for (int i = 0; i < m_num_threads; ++i) {
+                    m_worker_cpus.push_back(nodes[static_cast<std::size_t>(i) % nodes.size()]);
+                }
+            }
+
+            void push_task(function_wrapper&& task) {
+                if (!m_work_stealing) {
+                    m_work_queue.push(std::move(task));
+                    return;
+                }
+
+                const worker_id& worker = current_worker();
+                if (worker.pool == this) {
+                    ++m_local_tasks;
+                    m_local_queues[worker.index]->push(std::move(task));
+                } else {
+                    m_work_queue.push(std::move(task));
+                }
+                notify_idle_worker();
+            }
+
+            void push_tasks(std::vector<function_wrapper>& tasks) {
+                if (!m_work_stealing) {
+                    m_work_queue.push_many(tasks.begin(), tasks.end());
+                    return;
+                }
+
+                const worker_id& worker = current_worker();
+                if (worker.pool == this) {
+                    m_local_tasks += tasks.size();
+                    m_local_queues[worker.index]->push_many(tasks);
+                } else {
+                    m_work_queue.push_many(tasks.begin(), tasks.end());
+                }
+                notify_idle_workers();
+            }
+
+            static bool use_work_stealing(const scheduling mode) noexcept {
+                if (mode == scheduling::default_scheduling) {
+                    return osmium::config::use_work_stealing_pool();
+                }
+                return mode == scheduling::work_stealing;
             }
 
         public:
@@ -147,6 +562,11 @@ namespace osmium {
                 default_queue_size = 0U
             };
 
+            /// Number of chunks per worker thread used by parallel_for().
+            enum : std::size_t {
+                chunks_per_thread = 4U
+            };
+
             /**
              * Create thread pool with the given number of threads. If
              * num_threads is 0, the number of threads is read from
@@ -161,15 +581,33 @@ namespace osmium {
              *
              * If max_queue_size is 0, the queue size is read from
              * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE.
+             *
+             * If mode is scheduling::default_scheduling, work stealing is
+             * used if the environment variable OSMIUM_POOL_WORK_STEALING
+             * is set to "true", "yes", "on", or "1".
+             *
+             * If placement is affinity::default_affinity, it is read from
+             * the environment variable OSMIUM_POOL_AFFINITY which can be
+             * set to "none", "spread", or "local". Pinning only happens on
+             * Linux systems with more than one NUMA node.
              */
-            explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size) :
+            explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size, scheduling mode = scheduling::default_scheduling, affinity placement = affinity::default_affinity) :
                 m_work_queue(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size(), "work"),
                 m_joiner(m_threads),
-                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())) {
+                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())),
+                m_work_stealing(use_work_stealing(mode)) {
+
+                if (m_work_stealing) {
+                    for (int i = 0; i < m_num_threads; ++i) {
+                        m_local_queues.emplace_back(new work_deque{});
+                    }
+                }
+
+                assign_worker_cpus(get_affinity(placement));
 
                 try {
                     for (int i = 0; i < m_num_threads; ++i) {
-                        m_threads.emplace_back(&Pool::worker_thread, this);
+                        m_threads.emplace_back(&Pool::worker_thread, this, static_cast<std::size_t>(i));
                     }
                 } catch (...) {
                     shutdown_all_workers();
@@ -192,6 +630,9 @@ namespace osmium {
                 for (int i = 0; i < m_num_threads; ++i) {
                     // The special function wrapper makes a worker shut down.
                     m_work_queue.push(function_wrapper{0});
+                    if (m_work_stealing) {
+                        notify_idle_worker();
+                    }
                 }
             }
 
@@ -209,12 +650,42 @@ namespace osmium {
                 return m_num_threads;
             }
 
+            bool work_stealing() const noexcept {
+                return m_work_stealing;
+            }
+
+            /**
+             * Are the worker threads pinned to NUMA nodes?
+             */
+            bool pinned() const noexcept {
+                return !m_worker_cpus.empty();
+            }
+
+            /**
+             * The number of tasks waiting to be run. In work-stealing mode
+             * this includes the tasks in the per-worker queues.
+             */
             std::size_t queue_size() const {
-                return m_work_queue.size();
+                return m_work_queue.size() + m_local_tasks;
             }
 
             bool queue_empty() const {
-                return m_work_queue.empty();
+                return m_work_queue.empty() && m_local_tasks == 0;
+            }
+
+            /**
+             * Get a snapshot of the statistics of this pool. This can be
+             * called from any thread at any time.
+             */
+            pool_stats stats() const {
+                pool_stats stats;
+                stats.num_threads = m_num_threads;
+                stats.queued_tasks = queue_size();
+                stats.tasks_executed = m_tasks_executed.load(std::memory_order_relaxed);
+                stats.busy_time = std::chrono::nanoseconds{m_busy_time.load(std::memory_order_relaxed)};
+                stats.uptime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start_time);
+                stats.work_queue = m_work_queue.stats();
+                return stats;
             }
 
             template <typename TFunction>
@@ -223,13 +694,219 @@ namespace osmium {
 
                 std::packaged_task<result_type()> task{std::forward<TFunction>(func)};
                 std::future<result_type> future_result{task.get_future()};
-                m_work_queue.push(std::move(task));
+
+                push_task(std::move(task));
 
                 return future_result;
             }
 
+            /**
+             * Submit several tasks at once. This is the same as calling
+             * submit() for each of the functions in the range [first,
+             * last), but the work queue is only locked once for all of
+             * them, so this is cheaper when submitting many small tasks.
+             * The functions are moved out of the range.
+             *
+             * @returns The futures for the results of the tasks in the
+             *          same order as the functions.
+             */
+            template <typename TIterator>
+            std::vector<std::future<typename std::result_of<typename std::iterator_traits<TIterator>::value_type()>::type>>
+            submit_batch(TIterator first, TIterator last) {
+                using result_type = typename std::result_of<typename std::iterator_traits<TIterator>::value_type()>::type;
+
+                std::vector<std::future<result_type>> futures;
+                std::vector<function_wrapper> tasks;
+                for (; first != last; ++first) {
+                    std::packaged_task<result_type()> task{std::move(*first)};
+                    futures.push_back(task.get_future());
+                    tasks.emplace_back(std::move(task));
+                }
+
+                push_tasks(tasks);
+
+                return futures;
+            }
+
+            /**
+             * Call func(item) for each item in the range [first, last)
+             * on the worker threads. The range is split into chunks of
+             * consecutive items, a few per worker thread, which are
+             * submitted together with submit_batch(). The calling thread
+             * works on the first chunk itself and then waits for the
+             * others.
+             *
+             * This blocks, so don't call it from a task running on this
+             * pool, that can deadlock if all workers do it.
+             *
+             * @throws Any exception thrown by func. The first one is
+             *         rethrown after all chunks are done.
+             */
+            template <typename TIterator, typename TFunction>
+            void parallel_for(TIterator first, TIterator last, TFunction&& func) {
+                using function_type = typename std::remove_reference<TFunction>::type;
+
+                struct chunk {
+                    TIterator first;
+                    TIterator last;
+                    function_type* func;
+
+                    void operator()() const {
+                        for (auto it = first; it != last; ++it) {
+                            (*func)(*it);
+                        }
+                    }
+                };
+
+                const auto size = static_cast<std::size_t>(std::distance(first, last));
+                if (size == 0) {
+                    return;
+                }
+
+                const std::size_t num_chunks = std::min(size, static_cast<std::size_t>(m_num_threads) * chunks_per_thread);
+                std::vector<chunk> chunks;
+                chunks.reserve(num_chunks);
+                for (std::size_t n = 0; n < num_chunks; ++n) {
+                    const auto chunk_first = first;
+                    std::advance(first, static_cast<typename std::iterator_traits<TIterator>::difference_type>(size / num_chunks + (n < size % num_chunks ? 1 : 0)));
+                    chunks.push_back(chunk{chunk_first, first, &func});
+                }
+
+                auto futures = submit_batch(std::next(chunks.begin()), chunks.end());
+
+                std::exception_ptr exception;
+                try {
+                    chunks.front()();
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+
+                for (auto& future : futures) {
+                    try {
+                        future.get();
+                    } catch (...) {
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                    }
+                }
+
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+            /**
+             * Call func(item) for each item in the range on the worker
+             * threads. The range can be anything with begin() and end(),
+             * for instance an osmium::memory::Buffer or the result of
+             * Buffer::select<T>(). See the other parallel_for() function
+             * for details.
+             */
+            template <typename TRange, typename TFunction>
+            void parallel_for(TRange&& range, TFunction&& func) {
+                parallel_for(range.begin(), range.end(), std::forward<TFunction>(func));
+            }
+
         }; // class Pool
 
+        /**
+         * Lets several independent users, for instance several Readers,
+         * share one thread pool fairly. Tasks submitted through a client
+         * don't go into the work queue of the pool directly but into a
+         * queue of the client. Every time a worker becomes free, it takes
+         * the next task from the client that got the smallest share of
+         * the workers relative to its weight so far. So a client
+         * submitting lots of tasks can't starve the other clients.
+         *
+         * Tasks submitted to the pool directly are run in order as
+         * usual, they are not part of the fair sharing.
+         *
+         * The client must be destroyed before the pool. The destructor
+         * waits until all tasks submitted through the client are done.
+         */
+        class PoolClient {
+
+            Pool& m_pool;
+            detail::fair_scheduler::client_state m_state;
+
+            // Run by the pool for every task submitted through any
+            // client. It runs the next task chosen by the scheduler,
+            // which is not necessarily the task of this client.
+            struct dispatch_task {
+
+                detail::fair_scheduler* scheduler;
+
+                void operator()() const {
+                    scheduler->run_next();
+                }
+
+            }; // struct dispatch_task
+
+        public:
+
+            enum {
+                default_max_in_flight = 0
+            };
+
+            /**
+             * Create a new client of the pool.
+             *
+             * @param pool The thread pool.
+             * @param weight Relative share of the workers this client gets
+             *               when several clients have tasks waiting. Must
+             *               be at least 1.
+             * @param max_in_flight Maximum number of tasks of this client
+             *                      queued or running at the same time.
+             *                      submit() blocks when this is reached.
+             *                      If 0, twice the number of threads in the
+             *                      pool is used.
+             */
+            explicit PoolClient(Pool& pool, unsigned int weight = 1, std::size_t max_in_flight = default_max_in_flight) :
+                m_pool(pool),
+                m_state(detail::fair_scheduler::stride_base / (weight > 0 ? weight : 1),
+                        max_in_flight > 0 ? max_in_flight : 2 * static_cast<std::size_t>(pool.num_threads())) {
+                m_pool.m_fair_scheduler.add(m_state);
+            }
+
+            PoolClient(const PoolClient&) = delete;
+            PoolClient& operator=(const PoolClient&) = delete;
+
+            PoolClient(PoolClient&&) = delete;
+            PoolClient& operator=(PoolClient&&) = delete;
+
+            ~PoolClient() {
+                m_pool.m_fair_scheduler.remove(m_state);
+            }
+
+            Pool& pool() const noexcept {
+                return m_pool;
+            }
+
+            std::size_t max_in_flight() const noexcept {
+                return m_state.max_in_flight;
+            }
+
+            /**
+             * Submit a task to the pool. Works like Pool::submit(), but
+             * blocks if this client already has max_in_flight() tasks
+             * queued or running.
+             */
+            template <typename TFunction>
+            std::future<typename std::result_of<TFunction()>::type> submit(TFunction&& func) {
+                using result_type = typename std::result_of<TFunction()>::type;
+
+                std::packaged_task<result_type()> task{std::forward<TFunction>(func)};
+                std::future<result_type> future_result{task.get_future()};
+
+                m_pool.m_fair_scheduler.enqueue(m_state, std::move(task));
+                m_pool.push_task(dispatch_task{&m_pool.m_fair_scheduler});
+
+                return future_result;
+            }
+
+        }; // class PoolClient
+
     } // namespace thread
 
 } // namespace osmium
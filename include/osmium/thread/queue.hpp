@@ -33,6 +33,9 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/memory/budget.hpp>
+#include <osmium/thread/queue_stats.hpp>
+
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
@@ -42,10 +45,13 @@ DEALINGS IN THE SOFTWARE.
 #include <utility> // IWYU pragma: keep
 
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
-# include <atomic>
 # include <iostream>
 #endif
 
+#ifdef OSMIUM_USE_LOCKFREE_QUEUE
+# include <osmium/thread/lockfree_queue.hpp>
+#endif
+
 namespace osmium {
 
     namespace thread {
@@ -60,40 +66,59 @@ namespace osmium {
             /// the queue will block.
             const std::size_t m_max_size;
 
-            /// Name of this queue (for debugging only).
+            /// Name of this queue (for debugging and stats).
             const std::string m_name;
 
+            /// Maximum number of bytes in this queue. If adding an element
+            /// would go over this, pushing will block.
+            const std::size_t m_max_bytes;
+
             mutable std::mutex m_mutex;
 
             std::queue<T> m_queue;
 
+            /// The number of bytes given to push() for each element.
+            std::queue<std::size_t> m_sizes;
+
+            /// Sum of all elements in m_sizes.
+            std::size_t m_bytes = 0;
+
             /// Used to signal consumers when data is available in the queue.
             std::condition_variable m_data_available;
 
             /// Used to signal producers when queue is not full.
             std::condition_variable m_space_available;
 
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-            /// The largest size the queue has been so far.
-            std::size_t m_largest_size;
-
-            /// The number of times push() was called on the queue.
-            std::atomic<int> m_push_counter;
+            /// Statistics about the use of this queue.
+            detail::queue_counters m_counters;
 
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_full_counter;
+            /// Account for the bytes in this queue in a memory budget.
+            osmium::memory::MemoryBudget::account m_budget_account;
 
-            /**
-             * The number of times wait_and_pop(with_timeout)() was called
-             * on the queue.
-             */
-            std::atomic<int> m_pop_counter;
+            // Must be called with the mutex locked. An element is always
+            // allowed into an empty queue even if it is larger than the
+            // byte limit or the memory budget is exhausted. If this
+            // returns true, the bytes have been added to the budget.
+            bool has_space_for(const std::size_t bytes) noexcept {
+                if (m_max_size && m_queue.size() >= m_max_size) {
+                    return false;
+                }
+                if (m_queue.empty()) {
+                    m_budget_account.add(bytes);
+                    return true;
+                }
+                return (!m_max_bytes || m_bytes + bytes <= m_max_bytes) &&
+                       m_budget_account.try_add(bytes);
+            }
 
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_empty_counter;
-#endif
+            // Must be called with the mutex locked.
+            void pop_front(T& value) {
+                value = std::move(m_queue.front());
+                m_queue.pop();
+                m_bytes -= m_sizes.front();
+                m_budget_account.sub(m_sizes.front());
+                m_sizes.pop();
+            }
 
         public:
 
@@ -102,21 +127,16 @@ namespace osmium {
              *
              * @param max_size Maximum number of elements in the queue. Set to
              *                 0 for an unlimited size.
-             * @param name Optional name for this queue. (Used for debugging.)
+             * @param name Optional name for this queue. (Used for debugging
+             *             and in the stats.)
+             * @param max_bytes Maximum number of bytes in the queue as
+             *                  given to push(). Set to 0 for no limit.
              */
-            explicit Queue(std::size_t max_size = 0, std::string name = "") :
+            explicit Queue(std::size_t max_size = 0, std::string name = "", std::size_t max_bytes = 0) :
                 m_max_size(max_size),
                 m_name(std::move(name)),
-                m_queue()
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ,
-                m_largest_size(0),
-                m_push_counter(0),
-                m_full_counter(0),
-                m_pop_counter(0),
-                m_empty_counter(0)
-#endif
-            {
+                m_max_bytes(max_bytes),
+                m_queue() {
             }
 
             Queue(const Queue&) = delete;
@@ -127,88 +147,110 @@ namespace osmium {
 
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
             ~Queue() {
-                std::cerr << "queue '" << m_name
-                          << "' with max_size=" << m_max_size
-                          << " had largest size " << m_largest_size
-                          << " and was full " << m_full_counter
-                          << " times in " << m_push_counter
-                          << " push() calls and was empty " << m_empty_counter
-                          << " times in " << m_pop_counter
-                          << " pop() calls\n";
+                std::cerr << stats() << '\n';
             }
 #else
             ~Queue() = default;
 #endif
 
+            /**
+             * Account for the bytes in this queue (as given to push()) in
+             * the specified memory budget. While the budget is exhausted,
+             * push() will block, unless the queue is empty. Call this
+             * before any elements are pushed. The budget must outlive the
+             * queue.
+             */
+            void set_memory_budget(osmium::memory::MemoryBudget& budget) {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_budget_account = budget.add_account(m_name.empty() ? "queue" : m_name);
+            }
+
             /**
              * Push an element onto the queue. If the queue has a max size,
-             * this call will block if the queue is full.
+             * this call will block if the queue is full. If the queue has
+             * a byte limit or a memory budget, it will also block if
+             * adding the element would go over that limit.
+             *
+             * @param value The element.
+             * @param bytes The (estimated) size of the element in bytes.
              */
-            void push(T value) {
+            void push(T value, std::size_t bytes = 0) {
                 constexpr const std::chrono::milliseconds max_wait{10};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_push_counter;
-#endif
-                if (m_max_size) {
-                    while (size() >= m_max_size) {
-                        std::unique_lock<std::mutex> lock{m_mutex};
-                        m_space_available.wait_for(lock, max_wait, [this] {
-                            return m_queue.size() < m_max_size;
-                        });
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_full_counter;
-#endif
+                m_counters.count_push();
+                std::unique_lock<std::mutex> lock{m_mutex};
+                if (!has_space_for(bytes)) {
+                    const auto start = detail::queue_counters::now();
+                    while (!has_space_for(bytes)) {
+                        m_space_available.wait_for(lock, max_wait);
                     }
+                    m_counters.blocked_push(start);
                 }
-                std::lock_guard<std::mutex> lock{m_mutex};
                 m_queue.push(std::move(value));
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                if (m_largest_size < m_queue.size()) {
-                    m_largest_size = m_queue.size();
-                }
-#endif
+                m_sizes.push(bytes);
+                m_bytes += bytes;
+                m_counters.update_largest_size(m_queue.size());
+                m_counters.update_largest_bytes(m_bytes);
                 m_data_available.notify_one();
             }
 
+            /**
+             * Push all elements in the range [first, last) onto the queue
+             * in order. The elements are moved out of the range. This
+             * takes the lock only once (unless the queue gets full) and is
+             * cheaper than calling push() for each element. The elements
+             * don't count towards the byte limit.
+             */
+            template <typename TIterator>
+            void push_many(TIterator first, TIterator last) {
+                constexpr const std::chrono::milliseconds max_wait{10};
+                std::unique_lock<std::mutex> lock{m_mutex};
+                for (; first != last; ++first) {
+                    m_counters.count_push();
+                    if (!has_space_for(0)) {
+                        m_data_available.notify_all();
+                        const auto start = detail::queue_counters::now();
+                        while (!has_space_for(0)) {
+                            m_space_available.wait_for(lock, max_wait);
+                        }
+                        m_counters.blocked_push(start);
+                    }
+                    m_queue.push(std::move(*first));
+                    m_sizes.push(0);
+                }
+                m_counters.update_largest_size(m_queue.size());
+                m_data_available.notify_all();
+            }
+
             void wait_and_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
+                m_counters.count_pop();
                 std::unique_lock<std::mutex> lock{m_mutex};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 if (m_queue.empty()) {
-                    ++m_empty_counter;
+                    const auto start = detail::queue_counters::now();
+                    m_data_available.wait(lock, [this] {
+                        return !m_queue.empty();
+                    });
+                    m_counters.blocked_pop(start);
                 }
-#endif
-                m_data_available.wait(lock, [this] {
-                    return !m_queue.empty();
-                });
                 if (!m_queue.empty()) {
-                    value = std::move(m_queue.front());
-                    m_queue.pop();
+                    pop_front(value);
                     lock.unlock();
-                    if (m_max_size) {
+                    if (m_max_size || m_max_bytes) {
                         m_space_available.notify_one();
                     }
                 }
             }
 
             bool try_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
+                m_counters.count_pop();
                 {
                     std::lock_guard<std::mutex> lock{m_mutex};
                     if (m_queue.empty()) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_empty_counter;
-#endif
+                        m_counters.count_empty();
                         return false;
                     }
-                    value = std::move(m_queue.front());
-                    m_queue.pop();
+                    pop_front(value);
                 }
-                if (m_max_size) {
+                if (m_max_size || m_max_bytes) {
                     m_space_available.notify_one();
                 }
                 return true;
@@ -224,8 +266,54 @@ namespace osmium {
                 return m_queue.size();
             }
 
+            /**
+             * The number of bytes in the queue as given to push().
+             */
+            std::size_t bytes() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_bytes;
+            }
+
+            const std::string& name() const noexcept {
+                return m_name;
+            }
+
+            /**
+             * Get a snapshot of the statistics of this queue. This can be
+             * called from any thread at any time.
+             */
+            queue_stats stats() const {
+                return m_counters.get(m_name, m_max_size, size(), m_max_bytes, bytes());
+            }
+
         }; // class Queue
 
+        /**
+         * The queue type used for the work queue of the thread pool and
+         * for the queues of the I/O pipelines. This is Queue, or
+         * LockFreeQueue if OSMIUM_USE_LOCKFREE_QUEUE is defined.
+         */
+#ifdef OSMIUM_USE_LOCKFREE_QUEUE
+        template <typename T>
+        using pipeline_queue = LockFreeQueue<T>;
+#else
+        template <typename T>
+        using pipeline_queue = Queue<T>;
+#endif
+
+        /**
+         * Is the size of a pipeline_queue always limited? A Queue with
+         * max_size 0 is unlimited, a LockFreeQueue always has a maximum
+         * size. Code that fills a queue completely before anything is
+         * taken out of it (like the synchronous modes of the Reader and
+         * Writer) can only do this if this is false.
+         */
+#ifdef OSMIUM_USE_LOCKFREE_QUEUE
+        constexpr const bool pipeline_queue_is_bounded = true;
+#else
+        constexpr const bool pipeline_queue_is_bounded = false;
+#endif
+
     } // namespace thread
 
 } // namespace osmium
@@ -0,0 +1,203 @@
+#ifndef OSMIUM_THREAD_QUEUE_STATS_HPP
+#define OSMIUM_THREAD_QUEUE_STATS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Snapshot of the statistics of a queue. Returned by the stats()
+         * function of Queue and LockFreeQueue.
+         */
+        struct queue_stats {
+
+            /// Name of the queue.
+            std::string name{};
+
+            /// Maximum size of the queue (0 for unlimited).
+            std::size_t max_size = 0;
+
+            /// Number of elements in the queue when the snapshot was taken.
+            std::size_t size = 0;
+
+            /// The largest size the queue has been so far.
+            std::size_t largest_size = 0;
+
+            /// Maximum number of bytes in the queue (0 for unlimited).
+            std::size_t max_bytes = 0;
+
+            /// Number of bytes in the queue when the snapshot was taken.
+            /// Only counts bytes given to push().
+            std::size_t bytes = 0;
+
+            /// The largest number of bytes in the queue so far.
+            std::size_t largest_bytes = 0;
+
+            /// The number of times push() was called on the queue.
+            uint64_t push_count = 0;
+
+            /// The number of times the queue was full and a thread pushing
+            /// to the queue was blocked.
+            uint64_t full_count = 0;
+
+            /// The number of times wait_and_pop() or try_pop() was called
+            /// on the queue.
+            uint64_t pop_count = 0;
+
+            /// The number of times the queue was empty when a thread tried
+            /// to pop from it.
+            uint64_t empty_count = 0;
+
+            /// Total time threads were blocked in push().
+            std::chrono::nanoseconds push_wait{0};
+
+            /// Total time threads were blocked in wait_and_pop().
+            std::chrono::nanoseconds pop_wait{0};
+
+        }; // struct queue_stats
+
+        template <typename TChar, typename TTraits>
+        inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const queue_stats& stats) {
+            return out << "queue '" << stats.name
+                       << "' with max_size=" << stats.max_size
+                       << " had largest size " << stats.largest_size
+                       << " and was full " << stats.full_count
+                       << " times in " << stats.push_count
+                       << " push() calls and was empty " << stats.empty_count
+                       << " times in " << stats.pop_count
+                       << " pop() calls";
+        }
+
+        namespace detail {
+
+            /**
+             * The counters behind queue_stats. All updates are relaxed
+             * atomic operations, the clock is only read when a thread
+             * actually has to wait.
+             */
+            class queue_counters {
+
+                std::atomic<std::size_t> m_largest_size{0};
+                std::atomic<std::size_t> m_largest_bytes{0};
+                std::atomic<uint64_t> m_push_count{0};
+                std::atomic<uint64_t> m_full_count{0};
+                std::atomic<uint64_t> m_pop_count{0};
+                std::atomic<uint64_t> m_empty_count{0};
+                std::atomic<int64_t> m_push_wait{0};
+                std::atomic<int64_t> m_pop_wait{0};
+
+                static int64_t since(const std::chrono::steady_clock::time_point start) noexcept {
+                    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                }
+
+            public:
+
+                using time_point = std::chrono::steady_clock::time_point;
+
+                static time_point now() noexcept {
+                    return std::chrono::steady_clock::now();
+                }
+
+                void count_push() noexcept {
+                    m_push_count.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                void count_pop() noexcept {
+                    m_pop_count.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                void count_empty() noexcept {
+                    m_empty_count.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                // Called after a push() that had to wait since start.
+                void blocked_push(const time_point start) noexcept {
+                    m_full_count.fetch_add(1, std::memory_order_relaxed);
+                    m_push_wait.fetch_add(since(start), std::memory_order_relaxed);
+                }
+
+                // Called after a wait_and_pop() that had to wait since start.
+                void blocked_pop(const time_point start) noexcept {
+                    m_empty_count.fetch_add(1, std::memory_order_relaxed);
+                    m_pop_wait.fetch_add(since(start), std::memory_order_relaxed);
+                }
+
+                void update_largest_size(const std::size_t size) noexcept {
+                    std::size_t largest_size = m_largest_size.load(std::memory_order_relaxed);
+                    while (largest_size < size &&
+                           !m_largest_size.compare_exchange_weak(largest_size, size, std::memory_order_relaxed)) {
+                    }
+                }
+
+                void update_largest_bytes(const std::size_t bytes) noexcept {
+                    std::size_t largest_bytes = m_largest_bytes.load(std::memory_order_relaxed);
+                    while (largest_bytes < bytes &&
+                           !m_largest_bytes.compare_exchange_weak(largest_bytes, bytes, std::memory_order_relaxed)) {
+                    }
+                }
+
+                queue_stats get(const std::string& name, const std::size_t max_size, const std::size_t size, const std::size_t max_bytes = 0, const std::size_t bytes = 0) const {
+                    queue_stats stats;
+                    stats.name = name;
+                    stats.max_size = max_size;
+                    stats.size = size;
+                    stats.largest_size = m_largest_size.load(std::memory_order_relaxed);
+                    stats.max_bytes = max_bytes;
+                    stats.bytes = bytes;
+                    stats.largest_bytes = m_largest_bytes.load(std::memory_order_relaxed);
+                    stats.push_count = m_push_count.load(std::memory_order_relaxed);
+                    stats.full_count = m_full_count.load(std::memory_order_relaxed);
+                    stats.pop_count = m_pop_count.load(std::memory_order_relaxed);
+                    stats.empty_count = m_empty_count.load(std::memory_order_relaxed);
+                    stats.push_wait = std::chrono::nanoseconds{m_push_wait.load(std::memory_order_relaxed)};
+                    stats.pop_wait = std::chrono::nanoseconds{m_pop_wait.load(std::memory_order_relaxed)};
+                    return stats;
+                }
+
+            }; // class queue_counters
+
+        } // namespace detail
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_QUEUE_STATS_HPP
@@ -0,0 +1,122 @@
+#ifndef OSMIUM_THREAD_SORT_HPP
+#define OSMIUM_THREAD_SORT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        namespace detail {
+
+            enum : std::size_t {
+                // Ranges smaller than this are sorted in the calling thread.
+                min_parallel_sort_size = 16UL * 1024UL
+            };
+
+            inline void wait_for_all(std::vector<std::future<void>>& futures) {
+                for (auto& future : futures) {
+                    future.get();
+                }
+                futures.clear();
+            }
+
+        } // namespace detail
+
+        /**
+         * Sort a range like std::stable_sort() does, but use the threads
+         * of the pool. The range is split into one chunk per thread, the
+         * chunks are sorted in parallel and then merged in parallel,
+         * pairwise, until only one chunk is left. Merging keeps the order
+         * of equal elements, so the sort is stable.
+         *
+         * This function must not be called from a thread in the pool,
+         * because it waits for the tasks it submits.
+         *
+         * @param begin Start of the range.
+         * @param end End of the range.
+         * @param compare Comparison function object.
+         * @param pool The thread pool to use.
+         */
+        template <typename TIterator, typename TCompare>
+        void parallel_stable_sort(TIterator begin, TIterator end, TCompare compare, osmium::thread::Pool& pool) {
+            const auto size = static_cast<std::size_t>(std::distance(begin, end));
+            auto chunks = std::min(static_cast<std::size_t>(pool.num_threads()), size / detail::min_parallel_sort_size);
+            if (chunks < 2) {
+                std::stable_sort(begin, end, compare);
+                return;
+            }
+
+            std::vector<TIterator> bounds;
+            bounds.reserve(chunks + 1);
+            for (std::size_t i = 0; i < chunks; ++i) {
+                bounds.push_back(std::next(begin, static_cast<typename std::iterator_traits<TIterator>::difference_type>(size * i / chunks)));
+            }
+            bounds.push_back(end);
+
+            std::vector<std::future<void>> futures;
+            for (std::size_t i = 0; i < chunks; ++i) {
+                const auto first = bounds[i];
+                const auto last = bounds[i + 1];
+                futures.push_back(pool.submit([first, last, compare]() {
+                    std::stable_sort(first, last, compare);
+                }));
+            }
+            detail::wait_for_all(futures);
+
+            for (std::size_t width = 1; width < chunks; width *= 2) {
+                for (std::size_t i = 0; i + width < chunks; i += 2 * width) {
+                    const auto first = bounds[i];
+                    const auto middle = bounds[i + width];
+                    const auto last = bounds[std::min(i + 2 * width, chunks)];
+                    futures.push_back(pool.submit([first, middle, last, compare]() {
+                        std::inplace_merge(first, middle, last, compare);
+                    }));
+                }
+                detail::wait_for_all(futures);
+            }
+        }
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_SORT_HPP
@@ -80,6 +80,39 @@ namespace osmium {
             return true;
         }
 
+        /**
+         * Get the setting for the placement of pool threads on NUMA nodes
+         * from the environment variable OSMIUM_POOL_AFFINITY.
+         *
+         * @returns 0 for "none" or if not set, 1 for "spread", 2 for
+         *          "local".
+         */
+        inline int get_pool_affinity() noexcept {
+            const char* env = osmium::detail::getenv_wrapper("OSMIUM_POOL_AFFINITY");
+            if (env) {
+                if (!strcasecmp(env, "spread")) {
+                    return 1;
+                }
+                if (!strcasecmp(env, "local")) {
+                    return 2;
+                }
+            }
+            return 0;
+        }
+
+        inline bool use_work_stealing_pool() noexcept {
+            const char* env = osmium::detail::getenv_wrapper("OSMIUM_POOL_WORK_STEALING");
+            if (env) {
+                if (!strcasecmp(env, "on") ||
+                    !strcasecmp(env, "true") ||
+                    !strcasecmp(env, "yes") ||
+                    !strcasecmp(env, "1")) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
         inline std::size_t get_max_queue_size(const char* queue_name, const std::size_t default_value) noexcept {
             assert(queue_name);
             std::string name{"OSMIUM_MAX_"};
@@ -103,6 +136,50 @@ namespace osmium {
             return value;
         }
 
+        /**
+         * Get the maximum number of bytes in the queue with the given name
+         * from the environment variable OSMIUM_MAX_<queue_name>_QUEUE_BYTES.
+         * The number can have a suffix "k", "M", or "G" (case-insensitive)
+         * for KiB, MiB, or GiB, respectively.
+         *
+         * @returns The number of bytes or 0 (for no limit) if the
+         *          variable is not set or invalid.
+         */
+        inline std::size_t get_max_queue_bytes(const char* queue_name) noexcept {
+            assert(queue_name);
+            std::string name{"OSMIUM_MAX_"};
+            name += queue_name;
+            name += "_QUEUE_BYTES";
+            const char* env = osmium::detail::getenv_wrapper(name.c_str());
+            if (!env || *env == '\0') {
+                return 0;
+            }
+
+            std::string number{env};
+            std::size_t factor = 1;
+            switch (number.back()) {
+                case 'k':
+                case 'K':
+                    factor = 1024UL;
+                    break;
+                case 'm':
+                case 'M':
+                    factor = 1024UL * 1024UL;
+                    break;
+                case 'g':
+                case 'G':
+                    factor = 1024UL * 1024UL * 1024UL;
+                    break;
+                default:
+                    break;
+            }
+            if (factor != 1) {
+                number.pop_back();
+            }
+
+            return osmium::detail::str_to_int<std::size_t>(number.c_str()) * factor;
+        }
+
     } // namespace config
 
 } // namespace osmium
@@ -93,6 +93,16 @@ namespace osmium {
             return static_cast<int>(m_peak / 1024);
         }
 
+        /// Return current memory usage in bytes
+        int64_t current_bytes() const noexcept {
+            return m_current * 1024;
+        }
+
+        /// Return peak memory usage in bytes
+        int64_t peak_bytes() const noexcept {
+            return m_peak * 1024;
+        }
+
     }; // class MemoryUsage
 
 } // namespace osmium
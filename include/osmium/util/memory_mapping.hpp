@@ -36,9 +36,12 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/util/compatibility.hpp>
 #include <osmium/util/file.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
 #include <system_error>
 
@@ -92,6 +95,11 @@ namespace osmium {
          *
          * On Windows the file will be set to binary mode before the memory
          * mapping.
+         *
+         * On Linux the mapping can optionally be backed by huge pages, which
+         * reduces TLB misses for random accesses into large mappings. See
+         * huge_pages_mode for details. On other systems this setting is
+         * ignored.
          */
         class MemoryMapping {
 
@@ -103,6 +111,39 @@ namespace osmium {
                 write_shared  = 2
             };
 
+            /**
+             * Use of huge pages for the mapping.
+             */
+            enum class huge_pages_mode {
+                /// Use normal pages.
+                none        = 0,
+                /// Ask the kernel to use transparent huge pages with madvise().
+                transparent = 1,
+                /**
+                 * Use MAP_HUGETLB for anonymous mappings. This needs huge
+                 * pages reserved by the administrator. If that fails,
+                 * transparent huge pages are used instead. For file-backed
+                 * mappings this is the same as transparent.
+                 */
+                hugetlb     = 2
+            };
+
+            /**
+             * Expected access pattern for the mapped memory, given to the
+             * kernel with madvise(). This controls how much readahead the
+             * kernel does when paging in file-backed mappings.
+             */
+            enum class access_hint {
+                /// Default kernel behaviour.
+                normal     = 0,
+                /// Memory is accessed front to back, read ahead aggressively.
+                sequential = 1,
+                /// Memory is accessed in random order, don't read ahead.
+                random     = 2,
+                /// Memory will be needed soon, start reading it in now.
+                willneed   = 3
+            };
+
         private:
 
             /// The size of the mapping
@@ -117,6 +158,12 @@ namespace osmium {
             /// Mapping mode
             mapping_mode m_mapping_mode;
 
+            /// Huge pages mode actually used
+            huge_pages_mode m_huge_pages;
+
+            /// Access hint set with advise()
+            access_hint m_access_hint;
+
 #ifdef _WIN32
             HANDLE m_handle;
 #endif
@@ -138,6 +185,29 @@ namespace osmium {
 
             flag_type get_flags() const noexcept;
 
+#ifndef _WIN32
+            // The size of the huge pages on this system.
+            static std::size_t huge_page_size() noexcept;
+
+            // The number of bytes actually mapped. Mappings with MAP_HUGETLB
+            // must be a multiple of the huge page size.
+            std::size_t mapped_size() const noexcept;
+
+            // Mmap the memory with the current settings. Returns MAP_FAILED
+            // on error. If MAP_HUGETLB doesn't work, this will fall back to
+            // transparent huge pages.
+            void* map_memory() noexcept;
+
+            // Advise the kernel to use transparent huge pages if requested.
+            // Errors are ignored, because the kernel might not allow this
+            // for all mappings.
+            void advise_huge_pages() const noexcept;
+
+            // Give the access hint to the kernel. Errors are ignored,
+            // because this is only an optimization.
+            void apply_access_hint() const noexcept;
+#endif
+
             static std::size_t check_size(std::size_t size) {
                 if (size == 0) {
                     return osmium::get_pagesize();
@@ -201,9 +271,10 @@ namespace osmium {
              * @param mode Mapping mode: readonly, or writable (shared or private)
              * @param fd Open file descriptor of a file we want to map
              * @param offset Offset into the file where the mapping should start
+             * @param huge_pages Use of huge pages for this mapping
              * @throws std::system_error if the mapping fails
              */
-            MemoryMapping(std::size_t size, mapping_mode mode, int fd = -1, off_t offset = 0);
+            MemoryMapping(std::size_t size, mapping_mode mode, int fd = -1, off_t offset = 0, huge_pages_mode huge_pages = huge_pages_mode::none);
 
             /**
              * @deprecated
@@ -258,6 +329,9 @@ namespace osmium {
              * systems it will unmap and remap the memory. This can only be
              * done for file-based mappings, not anonymous mappings!
              *
+             * Anonymous mappings using MAP_HUGETLB are resized by creating
+             * a new mapping and copying the data.
+             *
              * @param new_size Number of bytes to resize to (must be > 0).
              *
              * @throws std::system_error if the remapping fails.
@@ -297,6 +371,33 @@ namespace osmium {
                 return m_mapping_mode != mapping_mode::readonly;
             }
 
+            /**
+             * The huge pages mode used for this mapping. This can be
+             * different from the mode requested when the system doesn't
+             * support it.
+             */
+            huge_pages_mode huge_pages() const noexcept {
+                return m_huge_pages;
+            }
+
+            /**
+             * Tell the kernel how the mapped memory is going to be accessed.
+             * The hint is kept and applied again when the mapping is
+             * resized. Use access_hint::sequential while filling a large
+             * file-backed mapping front to back and access_hint::random
+             * for lookups in it. On Windows this does nothing.
+             *
+             * @param hint The expected access pattern.
+             */
+            void advise(access_hint hint) noexcept;
+
+            /**
+             * The access hint set with advise().
+             */
+            access_hint access() const noexcept {
+                return m_access_hint;
+            }
+
             /**
              * Get the address of the mapping as any pointer type you like.
              *
@@ -323,8 +424,8 @@ namespace osmium {
 
         public:
 
-            explicit AnonymousMemoryMapping(std::size_t size) :
-                MemoryMapping(size, mapping_mode::write_private) {
+            explicit AnonymousMemoryMapping(std::size_t size, huge_pages_mode huge_pages = huge_pages_mode::none) :
+                MemoryMapping(size, mapping_mode::write_private, -1, 0, huge_pages) {
             }
 
 #ifndef __linux__
@@ -357,10 +458,11 @@ namespace osmium {
              * Create anonymous typed memory mapping of given size.
              *
              * @param size Number of objects of type T to be mapped
+             * @param huge_pages Use of huge pages for this mapping
              * @throws std::system_error if the mapping fails
              */
-            explicit TypedMemoryMapping(std::size_t size) :
-                m_mapping(sizeof(T) * size, MemoryMapping::mapping_mode::write_private) {
+            explicit TypedMemoryMapping(std::size_t size, MemoryMapping::huge_pages_mode huge_pages = MemoryMapping::huge_pages_mode::none) :
+                m_mapping(sizeof(T) * size, MemoryMapping::mapping_mode::write_private, -1, 0, huge_pages) {
             }
 
             /**
@@ -371,10 +473,11 @@ namespace osmium {
              * @param mode Mapping mode: readonly, or writable (shared or private)
              * @param fd Open file descriptor of a file we want to map
              * @param offset Offset into the file where the mapping should start
+             * @param huge_pages Use of huge pages for this mapping
              * @throws std::system_error if the mapping fails
              */
-            TypedMemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset = 0) :
-                m_mapping(sizeof(T) * size, mode, fd, sizeof(T) * offset) {
+            TypedMemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset = 0, MemoryMapping::huge_pages_mode huge_pages = MemoryMapping::huge_pages_mode::none) :
+                m_mapping(sizeof(T) * size, mode, fd, sizeof(T) * offset, huge_pages) {
             }
 
             /**
@@ -470,6 +573,28 @@ namespace osmium {
                 return m_mapping.writable();
             }
 
+            /**
+             * The huge pages mode used for this mapping.
+             */
+            MemoryMapping::huge_pages_mode huge_pages() const noexcept {
+                return m_mapping.huge_pages();
+            }
+
+            /**
+             * Tell the kernel how the mapped memory is going to be accessed.
+             * See MemoryMapping::advise().
+             */
+            void advise(MemoryMapping::access_hint hint) noexcept {
+                m_mapping.advise(hint);
+            }
+
+            /**
+             * The access hint set with advise().
+             */
+            MemoryMapping::access_hint access() const noexcept {
+                return m_mapping.access();
+            }
+
             /**
              * Get the address of the beginning of the mapping.
              *
@@ -581,24 +706,117 @@ inline int osmium::util::MemoryMapping::get_protection() const noexcept {
 
 inline int osmium::util::MemoryMapping::get_flags() const noexcept {
     if (m_fd == -1) {
+#ifdef MAP_HUGETLB
+        if (m_huge_pages == huge_pages_mode::hugetlb) {
+            return MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB; // NOLINT(hicpp-signed-bitwise)
+        }
+#endif
         return MAP_PRIVATE | MAP_ANONYMOUS; // NOLINT(hicpp-signed-bitwise)
     }
-    if (m_mapping_mode == mapping_mode::write_shared) {
-        return MAP_SHARED;
+    // Read-only mappings are shared, so all processes mapping the same
+    // file use the same pages in the page cache.
+    if (m_mapping_mode == mapping_mode::write_private) {
+        return MAP_PRIVATE;
     }
-    return MAP_PRIVATE;
+    return MAP_SHARED;
 }
 
-inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, mapping_mode mode, int fd, off_t offset) :
+inline std::size_t osmium::util::MemoryMapping::huge_page_size() noexcept {
+    static const std::size_t size = []() {
+        std::size_t result = 2UL * 1024UL * 1024UL;
+#ifdef __linux__
+        std::FILE* file = std::fopen("/proc/meminfo", "r");
+        if (file) {
+            char line[256];
+            while (std::fgets(line, sizeof(line), file)) {
+                unsigned long kbytes = 0; // NOLINT(google-runtime-int)
+                if (std::sscanf(line, "Hugepagesize: %lu kB", &kbytes) == 1 && kbytes > 0) { // NOLINT(cert-err34-c)
+                    result = kbytes * 1024UL;
+                    break;
+                }
+            }
+            std::fclose(file);
+        }
+#endif
+        return result;
+    }();
+    return size;
+}
+
+inline std::size_t osmium::util::MemoryMapping::mapped_size() const noexcept {
+    if (m_fd == -1 && m_huge_pages == huge_pages_mode::hugetlb) {
+        const std::size_t page_size = huge_page_size();
+        return (m_size + page_size - 1) / page_size * page_size;
+    }
+    return m_size;
+}
+
+inline void osmium::util::MemoryMapping::advise_huge_pages() const noexcept {
+#ifdef MADV_HUGEPAGE
+    if (m_huge_pages == huge_pages_mode::transparent) {
+        ::madvise(m_addr, m_size, MADV_HUGEPAGE);
+    }
+#endif
+}
+
+inline void osmium::util::MemoryMapping::apply_access_hint() const noexcept {
+    switch (m_access_hint) {
+        case access_hint::normal:
+            ::madvise(m_addr, m_size, MADV_NORMAL);
+            break;
+        case access_hint::sequential:
+            ::madvise(m_addr, m_size, MADV_SEQUENTIAL);
+            break;
+        case access_hint::random:
+            ::madvise(m_addr, m_size, MADV_RANDOM);
+            break;
+        case access_hint::willneed:
+            ::madvise(m_addr, m_size, MADV_WILLNEED);
+            break;
+    }
+}
+
+inline void osmium::util::MemoryMapping::advise(access_hint hint) noexcept {
+    m_access_hint = hint;
+    if (is_valid()) {
+        apply_access_hint();
+    }
+}
+
+// MAP_FAILED is often a macro containing an old style cast
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+
+inline void* osmium::util::MemoryMapping::map_memory() noexcept {
+#ifdef MAP_HUGETLB
+    if (m_fd == -1 && m_huge_pages == huge_pages_mode::hugetlb) {
+        void* addr = ::mmap(nullptr, mapped_size(), get_protection(), get_flags(), m_fd, m_offset);
+        if (addr != MAP_FAILED) {
+            return addr;
+        }
+    }
+#endif
+    if (m_huge_pages == huge_pages_mode::hugetlb) {
+        m_huge_pages = huge_pages_mode::transparent;
+    }
+    return ::mmap(nullptr, m_size, get_protection(), get_flags(), m_fd, m_offset);
+}
+
+#pragma GCC diagnostic pop
+
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, mapping_mode mode, int fd, off_t offset, huge_pages_mode huge_pages) :
     m_size(check_size(size)),
     m_offset(offset),
     m_fd(resize_fd(fd)),
     m_mapping_mode(mode),
-    m_addr(::mmap(nullptr, m_size, get_protection(), get_flags(), m_fd, m_offset)) {
+    m_huge_pages(huge_pages),
+    m_access_hint(access_hint::normal),
+    m_addr(map_memory()) {
     assert(!(fd == -1 && mode == mapping_mode::readonly));
     if (!is_valid()) {
         throw std::system_error{errno, std::system_category(), "mmap failed"};
     }
+    advise_huge_pages();
 }
 
 inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcept :
@@ -606,6 +824,8 @@ inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcep
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
+    m_huge_pages(other.m_huge_pages),
+    m_access_hint(other.m_access_hint),
     m_addr(other.m_addr) {
     other.make_invalid();
 }
@@ -621,6 +841,8 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
     m_offset       = other.m_offset;
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
+    m_huge_pages   = other.m_huge_pages;
+    m_access_hint  = other.m_access_hint;
     m_addr         = other.m_addr;
     other.make_invalid();
     return *this;
@@ -628,7 +850,7 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
 
 inline void osmium::util::MemoryMapping::unmap() {
     if (is_valid()) {
-        if (::munmap(m_addr, m_size) != 0) {
+        if (::munmap(m_addr, mapped_size()) != 0) {
             throw std::system_error{errno, std::system_category(), "munmap failed"};
         }
         make_invalid();
@@ -639,11 +861,33 @@ inline void osmium::util::MemoryMapping::resize(std::size_t new_size) {
     assert(new_size > 0 && "can not resize to zero size");
     if (m_fd == -1) { // anonymous mapping
 #ifdef __linux__
+        if (m_huge_pages == huge_pages_mode::hugetlb) {
+            // Older kernels can't mremap() MAP_HUGETLB mappings, so we
+            // create a new mapping and copy the data over.
+            const std::size_t old_size = m_size;
+            void* const old_addr = m_addr;
+            const std::size_t old_mapped_size = mapped_size();
+            m_size = new_size;
+            m_addr = map_memory();
+            if (!is_valid()) {
+                m_size = old_size;
+                m_huge_pages = huge_pages_mode::hugetlb;
+                m_addr = old_addr;
+                throw std::system_error{errno, std::system_category(), "mmap (remap) failed"};
+            }
+            std::memcpy(m_addr, old_addr, std::min(old_size, new_size));
+            ::munmap(old_addr, old_mapped_size);
+            advise_huge_pages();
+            apply_access_hint();
+            return;
+        }
         m_addr = ::mremap(m_addr, m_size, new_size, MREMAP_MAYMOVE);
         if (!is_valid()) {
             throw std::system_error{errno, std::system_category(), "mremap failed"};
         }
         m_size = new_size;
+        advise_huge_pages();
+        apply_access_hint();
 #else
         assert(false && "can't resize anonymous mappings on non-linux systems");
 #endif
@@ -655,6 +899,8 @@ inline void osmium::util::MemoryMapping::resize(std::size_t new_size) {
         if (!is_valid()) {
             throw std::system_error{errno, std::system_category(), "mmap (remap) failed"};
         }
+        advise_huge_pages();
+        apply_access_hint();
     }
 }
 
@@ -751,11 +997,13 @@ inline int last_error() noexcept {
     return static_cast<int>(GetLastError());
 }
 
-inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset) :
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset, huge_pages_mode /*huge_pages*/) :
     m_size(check_size(size)),
     m_offset(offset),
     m_fd(resize_fd(fd)),
     m_mapping_mode(mode),
+    m_huge_pages(huge_pages_mode::none),
+    m_access_hint(access_hint::normal),
     m_handle(create_file_mapping()),
     m_addr(nullptr) {
 
@@ -774,6 +1022,8 @@ inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcep
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
+    m_huge_pages(other.m_huge_pages),
+    m_access_hint(other.m_access_hint),
     m_handle(std::move(other.m_handle)),
     m_addr(other.m_addr) {
     other.make_invalid();
@@ -786,6 +1036,8 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
     m_offset       = other.m_offset;
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
+    m_huge_pages   = other.m_huge_pages;
+    m_access_hint  = other.m_access_hint;
     m_handle       = std::move(other.m_handle);
     m_addr         = other.m_addr;
     other.make_invalid();
@@ -809,6 +1061,10 @@ inline void osmium::util::MemoryMapping::unmap() {
     }
 }
 
+inline void osmium::util::MemoryMapping::advise(access_hint hint) noexcept {
+    m_access_hint = hint;
+}
+
 inline void osmium::util::MemoryMapping::resize(std::size_t new_size) {
     unmap();
 
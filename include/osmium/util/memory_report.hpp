@@ -0,0 +1,282 @@
+#ifndef OSMIUM_UTIL_MEMORY_REPORT_HPP
+#define OSMIUM_UTIL_MEMORY_REPORT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/memory.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    inline namespace util {
+
+        /**
+         * One entry in a memory_snapshot.
+         */
+        struct memory_report_entry {
+
+            /// The name the memory was registered under.
+            std::string name;
+
+            /// The number of bytes used.
+            std::size_t bytes;
+
+        }; // struct memory_report_entry
+
+        /**
+         * The memory use of all parts registered with a MemoryReport at
+         * one point in time.
+         */
+        struct memory_snapshot {
+
+            using clock = std::chrono::steady_clock;
+
+            /// When the snapshot was taken.
+            clock::time_point time;
+
+            /// Time since the MemoryReport was created.
+            std::chrono::nanoseconds elapsed{0};
+
+            /// Virtual memory size of the process (Linux only, 0 otherwise).
+            int64_t process_current = 0;
+
+            /// Peak virtual memory size of the process (Linux only, 0 otherwise).
+            int64_t process_peak = 0;
+
+            /// The memory used by each registered part in the order they
+            /// were added.
+            std::vector<memory_report_entry> entries;
+
+            /// The sum of the memory used by all registered parts.
+            std::size_t total() const noexcept {
+                std::size_t sum = 0;
+                for (const auto& entry : entries) {
+                    sum += entry.bytes;
+                }
+                return sum;
+            }
+
+        }; // struct memory_snapshot
+
+        template <typename TChar, typename TTraits>
+        inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const memory_snapshot& snapshot) {
+            constexpr const double mbyte = 1024.0 * 1024.0;
+            const auto old_flags = out.flags();
+            const auto old_precision = out.precision();
+            out << std::fixed << std::setprecision(1);
+            for (const auto& entry : snapshot.entries) {
+                out << std::left << std::setw(32) << entry.name << std::right
+                    << std::setw(12) << (static_cast<double>(entry.bytes) / mbyte) << " MB\n";
+            }
+            out << std::left << std::setw(32) << "total" << std::right
+                << std::setw(12) << (static_cast<double>(snapshot.total()) / mbyte) << " MB\n";
+            if (snapshot.process_current > 0) {
+                out << std::left << std::setw(32) << "process (current/peak)" << std::right
+                    << std::setw(12) << (static_cast<double>(snapshot.process_current) / mbyte) << " MB / "
+                    << (static_cast<double>(snapshot.process_peak) / mbyte) << " MB\n";
+            }
+            out.flags(old_flags);
+            out.precision(old_precision);
+            return out;
+        }
+
+        namespace detail {
+
+            template <typename T, typename = void>
+            struct has_used_memory : std::false_type {
+            };
+
+            template <typename T>
+            struct has_used_memory<T, typename std::enable_if<std::is_convertible<decltype(std::declval<const T&>().used_memory()), std::size_t>::value>::type> : std::true_type {
+            };
+
+        } // namespace detail
+
+        /**
+         * A live report of the memory used by different parts of a program,
+         * for instance Reader queues, buffers in flight (see
+         * osmium::memory::CountingBufferAllocator), an ItemStash, relation
+         * databases, and indexes. Each part is registered with a function
+         * returning the number of bytes it uses (or, for objects with a
+         * used_memory() function, with the object itself). A snapshot()
+         * asks all parts for their current use.
+         *
+         * For periodic sampling, set a callback with set_sampling() and
+         * call sample_if_due() regularly, for instance after every buffer.
+         * The callback gets a snapshot whenever the interval has passed.
+         * Sampling is done in the thread calling sample_if_due(), because
+         * the used_memory() functions of most data structures must not be
+         * called while they are changed in another thread.
+         *
+         * Example:
+         * @code
+         *     osmium::MemoryReport report;
+         *     report.add("reader", reader);
+         *     report.add("location index", index);
+         *     report.add("stash", stash);
+         *     report.set_sampling(std::chrono::seconds{10}, [](const osmium::memory_snapshot& snapshot) {
+         *         std::cerr << snapshot;
+         *     });
+         *     while (osmium::memory::Buffer buffer = reader.read()) {
+         *         ...
+         *         report.sample_if_due();
+         *     }
+         * @endcode
+         */
+        class MemoryReport {
+
+        public:
+
+            using probe_type = std::function<std::size_t()>;
+            using sample_callback_type = std::function<void(const memory_snapshot&)>;
+
+        private:
+
+            using clock = memory_snapshot::clock;
+
+            std::vector<std::pair<std::string, probe_type>> m_probes;
+
+            clock::time_point m_start_time = clock::now();
+            clock::duration m_interval{0};
+            clock::time_point m_next_sample{};
+            sample_callback_type m_callback;
+
+        public:
+
+            MemoryReport() = default;
+
+            /**
+             * Register a part of the program with a function returning
+             * the number of bytes it uses.
+             */
+            void add(std::string name, probe_type probe) {
+                m_probes.emplace_back(std::move(name), std::move(probe));
+            }
+
+            /**
+             * Register an object with a used_memory() function. The object
+             * must outlive this report (or be removed before it is
+             * destroyed).
+             */
+            template <typename T, typename std::enable_if<detail::has_used_memory<T>::value, int>::type = 0>
+            void add(std::string name, const T& object) {
+                add(std::move(name), [&object]() {
+                    return static_cast<std::size_t>(object.used_memory());
+                });
+            }
+
+            /**
+             * Remove all parts registered under the given name.
+             */
+            void remove(const std::string& name) {
+                std::vector<std::pair<std::string, probe_type>> probes;
+                for (auto& probe : m_probes) {
+                    if (probe.first != name) {
+                        probes.push_back(std::move(probe));
+                    }
+                }
+                swap(probes, m_probes);
+            }
+
+            /// The number of registered parts.
+            std::size_t size() const noexcept {
+                return m_probes.size();
+            }
+
+            /**
+             * Ask all registered parts how much memory they use now.
+             */
+            memory_snapshot snapshot() const {
+                memory_snapshot result;
+                result.time = clock::now();
+                result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(result.time - m_start_time);
+                const osmium::MemoryUsage usage;
+                result.process_current = usage.current_bytes();
+                result.process_peak = usage.peak_bytes();
+                result.entries.reserve(m_probes.size());
+                for (const auto& probe : m_probes) {
+                    result.entries.push_back(memory_report_entry{probe.first, probe.second()});
+                }
+                return result;
+            }
+
+            /**
+             * Call the callback with a snapshot whenever sample_if_due()
+             * is called and at least the interval has passed since the
+             * last sample. The first call of sample_if_due() always takes
+             * a sample.
+             */
+            template <typename TRep, typename TPeriod>
+            void set_sampling(std::chrono::duration<TRep, TPeriod> interval, sample_callback_type callback) {
+                m_interval = std::chrono::duration_cast<clock::duration>(interval);
+                m_next_sample = clock::time_point{};
+                m_callback = std::move(callback);
+            }
+
+            /**
+             * Take a sample if the interval set with set_sampling() has
+             * passed. This is cheap if it hasn't, so it can be called
+             * often.
+             *
+             * @returns true if a sample was taken.
+             */
+            bool sample_if_due() {
+                if (!m_callback) {
+                    return false;
+                }
+                const auto now = clock::now();
+                if (now < m_next_sample) {
+                    return false;
+                }
+                m_next_sample = now + m_interval;
+                m_callback(snapshot());
+                return true;
+            }
+
+        }; // class MemoryReport
+
+    } // namespace util
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_MEMORY_REPORT_HPP
@@ -35,6 +35,8 @@ DEALINGS IN THE SOFTWARE.
 
 #include <boost/variant.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
 #include <iosfwd>
 #include <regex>
@@ -89,6 +91,10 @@ namespace osmium {
                 return false;
             }
 
+            static bool match(const char* /*test_string*/, std::size_t /*size*/) noexcept {
+                return false;
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "always_false";
@@ -107,6 +113,10 @@ namespace osmium {
                 return true;
             }
 
+            static bool match(const char* /*test_string*/, std::size_t /*size*/) noexcept {
+                return true;
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "always_true";
@@ -131,10 +141,19 @@ namespace osmium {
                 m_str(str) {
             }
 
+            const std::string& str() const noexcept {
+                return m_str;
+            }
+
             bool match(const char* test_string) const noexcept {
                 return !std::strcmp(m_str.c_str(), test_string);
             }
 
+            bool match(const char* test_string, std::size_t size) const noexcept {
+                return size == m_str.size() &&
+                       !std::memcmp(m_str.data(), test_string, size);
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "equal[" << m_str << ']';
@@ -160,7 +179,12 @@ namespace osmium {
             }
 
             bool match(const char* test_string) const noexcept {
-                return m_str.compare(0, std::string::npos, test_string, 0, m_str.size()) == 0;
+                return !std::strncmp(m_str.c_str(), test_string, m_str.size());
+            }
+
+            bool match(const char* test_string, std::size_t size) const noexcept {
+                return size >= m_str.size() &&
+                       !std::memcmp(m_str.data(), test_string, m_str.size());
             }
 
             template <typename TChar, typename TTraits>
@@ -191,6 +215,10 @@ namespace osmium {
                 return std::strstr(test_string, m_str.c_str()) != nullptr;
             }
 
+            bool match(const char* test_string, std::size_t size) const noexcept {
+                return size >= m_str.size() && match(test_string);
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "substring[" << m_str << ']';
@@ -216,6 +244,10 @@ namespace osmium {
                 return std::regex_search(test_string, m_regex);
             }
 
+            bool match(const char* test_string, std::size_t size) const noexcept {
+                return std::regex_search(test_string, test_string + size, m_regex);
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "regex";
@@ -226,10 +258,24 @@ namespace osmium {
 
         /**
          * Matches if the test string is equal to any of the stored strings.
+         * A sorted copy of the strings is kept, so matching uses a binary
+         * search and stays fast for long lists.
          */
         class list : public matcher {
 
             std::vector<std::string> m_strings;
+            std::vector<std::string> m_sorted;
+
+            static bool less(const std::string& lhs, const char* rhs) noexcept {
+                return std::strcmp(lhs.c_str(), rhs) < 0;
+            }
+
+            void add_sorted(const std::string& str) {
+                const auto it = std::lower_bound(m_sorted.begin(), m_sorted.end(), str.c_str(), less);
+                if (it == m_sorted.end() || *it != str) {
+                    m_sorted.insert(it, str);
+                }
+            }
 
         public:
 
@@ -237,26 +283,38 @@ namespace osmium {
 
             explicit list(std::vector<std::string> strings) :
                 m_strings(std::move(strings)) {
+                for (const auto& s : m_strings) {
+                    add_sorted(s);
+                }
             }
 
             list& add_string(const char* str) {
                 m_strings.emplace_back(str);
+                add_sorted(m_strings.back());
                 return *this;
             }
 
             list& add_string(const std::string& str) {
                 m_strings.push_back(str);
+                add_sorted(str);
                 return *this;
             }
 
+            const std::vector<std::string>& strings() const noexcept {
+                return m_strings;
+            }
+
             bool match(const char* test_string) const noexcept {
-                for (const auto& s : m_strings) {
-                    if (!std::strcmp(s.c_str(), test_string)) {
-                        return true;
-                    }
-                }
-                return false;
+                const auto it = std::lower_bound(m_sorted.cbegin(), m_sorted.cend(), test_string, less);
+                return it != m_sorted.cend() && !std::strcmp(it->c_str(), test_string);
+            }
 
+            bool match(const char* test_string, std::size_t size) const noexcept {
+                const auto it = std::lower_bound(m_sorted.cbegin(), m_sorted.cend(), test_string, [size](const std::string& lhs, const char* rhs) {
+                    return lhs.compare(0, std::string::npos, rhs, size) < 0;
+                });
+                return it != m_sorted.cend() && it->size() == size &&
+                       !std::memcmp(it->data(), test_string, size);
             }
 
             template <typename TChar, typename TTraits>
@@ -301,6 +359,52 @@ namespace osmium {
 
         }; // class match_visitor
 
+        class match_size_visitor : public boost::static_visitor<bool> {
+
+            const char* m_str;
+            std::size_t m_size;
+
+        public:
+
+            match_size_visitor(const char* str, std::size_t size) noexcept :
+                m_str(str),
+                m_size(size) {
+            }
+
+            template <typename TMatcher>
+            bool operator()(const TMatcher& t) const noexcept {
+                return t.match(m_str, m_size);
+            }
+
+        }; // class match_size_visitor
+
+        class exact_strings_visitor : public boost::static_visitor<bool> {
+
+            std::vector<std::string>* m_strings;
+
+        public:
+
+            explicit exact_strings_visitor(std::vector<std::string>& strings) noexcept :
+                m_strings(&strings) {
+            }
+
+            bool operator()(const equal& t) const {
+                m_strings->push_back(t.str());
+                return true;
+            }
+
+            bool operator()(const list& t) const {
+                m_strings->insert(m_strings->end(), t.strings().cbegin(), t.strings().cend());
+                return true;
+            }
+
+            template <typename TMatcher>
+            bool operator()(const TMatcher& /*t*/) const noexcept {
+                return false;
+            }
+
+        }; // class exact_strings_visitor
+
         template <typename TChar, typename TTraits>
         class print_visitor : public boost::static_visitor<void> {
 
@@ -402,6 +506,21 @@ namespace osmium {
             return boost::apply_visitor(match_visitor{str}, m_matcher);
         }
 
+        /**
+         * Match the specified string of known length. This is faster than
+         * matching a nul-terminated string, because strings of the wrong
+         * length can be rejected without looking at their contents and
+         * the comparison can use memcmp().
+         *
+         * @param str The string. It must be nul-terminated even though
+         *            the length is given.
+         * @param size The length of the string (not including the
+         *             terminating zero).
+         */
+        bool operator()(const char* str, std::size_t size) const noexcept {
+            return boost::apply_visitor(match_size_visitor{str, size}, m_matcher);
+        }
+
         /**
          * Match the specified string.
          */
@@ -409,6 +528,19 @@ namespace osmium {
             return operator()(str.c_str());
         }
 
+        /**
+         * If this matcher only matches strings known in advance (it is an
+         * equal or list matcher), add those strings to the vector. This
+         * can be used to build indexes for fast lookups of many matchers.
+         *
+         * @param strings The strings are appended to this vector.
+         * @returns true if this is an equal or list matcher, false
+         *          otherwise (nothing is added in that case).
+         */
+        bool get_exact_strings(std::vector<std::string>& strings) const {
+            return boost::apply_visitor(exact_strings_visitor{strings}, m_matcher);
+        }
+
         template <typename TChar, typename TTraits>
         void print(std::basic_ostream<TChar, TTraits>& out) const {
             boost::apply_visitor(print_visitor<TChar, TTraits>{out}, m_matcher);
@@ -0,0 +1,282 @@
+#ifndef OSMIUM_UTIL_TRACE_HPP
+#define OSMIUM_UTIL_TRACE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace osmium {
+
+    inline namespace util {
+
+        /**
+         * The stages of the I/O pipelines that can be traced.
+         */
+        enum class trace_stage : uint8_t {
+            read       = 0, ///< Read thread reading a chunk of input data
+            framing    = 1, ///< Parser splitting the input into blobs
+            decompress = 2, ///< Decompression of a PBF blob
+            decode     = 3, ///< Decoding of a PBF primitive block
+            queue_wait = 4, ///< Reader waiting for the next buffer
+            handler    = 5, ///< Handlers called from osmium::apply()
+            write      = 6  ///< Write thread compressing and writing data
+        };
+
+        inline const char* trace_stage_name(const trace_stage stage) noexcept {
+            static const char* names[] = {
+                "read",
+                "framing",
+                "decompress",
+                "decode",
+                "queue_wait",
+                "handler",
+                "write"
+            };
+            return names[static_cast<std::size_t>(stage)];
+        }
+
+        /**
+         * One begin or end event emitted by a pipeline stage.
+         */
+        struct trace_event {
+
+            using clock = std::chrono::steady_clock;
+
+            /// The stage emitting this event.
+            trace_stage stage;
+
+            /// True for the begin event, false for the end event.
+            bool begin;
+
+            /**
+             * The sequence number of the data this event is about. For
+             * the PBF stages and the Reader this is the number of the
+             * data blob/buffer, for the read and write threads the number
+             * of the chunk of data.
+             */
+            uint64_t sequence;
+
+            /// The thread the event was emitted from.
+            std::thread::id thread;
+
+            /// When the event was emitted.
+            clock::time_point time;
+
+        }; // struct trace_event
+
+        /**
+         * Base class for receivers of trace events. Install an object of
+         * a derived class with set_tracer(). The emit() function is
+         * called from many threads at the same time.
+         */
+        class Tracer {
+
+        public:
+
+            Tracer() = default;
+
+            Tracer(const Tracer&) = delete;
+            Tracer& operator=(const Tracer&) = delete;
+
+            Tracer(Tracer&&) = delete;
+            Tracer& operator=(Tracer&&) = delete;
+
+            virtual ~Tracer() noexcept = default;
+
+            virtual void emit(const trace_event& event) = 0;
+
+        }; // class Tracer
+
+    } // namespace util
+
+    namespace detail {
+
+        inline std::atomic<osmium::util::Tracer*>& current_tracer() noexcept {
+            static std::atomic<osmium::util::Tracer*> tracer{nullptr};
+            return tracer;
+        }
+
+    } // namespace detail
+
+    inline namespace util {
+
+        /**
+         * Set the tracer receiving the events from all pipeline stages
+         * in this process. Set to nullptr (the default) to disable
+         * tracing. The tracer must stay alive until tracing is disabled
+         * and all Readers and Writers active while it was set are closed.
+         */
+        inline void set_tracer(Tracer* tracer) noexcept {
+            detail::current_tracer().store(tracer, std::memory_order_release);
+        }
+
+        /**
+         * Get the tracer set with set_tracer() or nullptr if tracing is
+         * disabled.
+         */
+        inline Tracer* get_tracer() noexcept {
+            return detail::current_tracer().load(std::memory_order_acquire);
+        }
+
+        /**
+         * Emits a begin event on construction and an end event on
+         * destruction if a tracer is set. If no tracer is set, this costs
+         * one atomic load.
+         */
+        class TraceScope {
+
+            Tracer* m_tracer;
+            trace_stage m_stage;
+            uint64_t m_sequence;
+
+            void emit(const bool begin) const {
+                m_tracer->emit(trace_event{m_stage, begin, m_sequence, std::this_thread::get_id(), trace_event::clock::now()});
+            }
+
+        public:
+
+            TraceScope(const trace_stage stage, const uint64_t sequence) :
+                m_tracer(get_tracer()),
+                m_stage(stage),
+                m_sequence(sequence) {
+                if (m_tracer) {
+                    emit(true);
+                }
+            }
+
+            TraceScope(const TraceScope&) = delete;
+            TraceScope& operator=(const TraceScope&) = delete;
+
+            TraceScope(TraceScope&&) = delete;
+            TraceScope& operator=(TraceScope&&) = delete;
+
+            ~TraceScope() noexcept {
+                if (m_tracer) {
+                    try {
+                        emit(false);
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+            }
+
+        }; // class TraceScope
+
+        /**
+         * Tracer collecting all events in memory. They can be written out
+         * in the Chrome trace event format (JSON) which can be loaded into
+         * chrome://tracing or the Perfetto UI.
+         */
+        class ChromeTraceWriter : public Tracer {
+
+            mutable std::mutex m_mutex;
+            std::vector<trace_event> m_events;
+            trace_event::clock::time_point m_start{trace_event::clock::now()};
+
+        public:
+
+            ChromeTraceWriter() = default;
+
+            void emit(const trace_event& event) override {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_events.push_back(event);
+            }
+
+            /// The number of events collected so far.
+            std::size_t size() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_events.size();
+            }
+
+            /// A copy of the events collected so far.
+            std::vector<trace_event> events() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_events;
+            }
+
+            /// Remove all events collected so far.
+            void clear() {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_events.clear();
+            }
+
+            /**
+             * Write all events collected so far as JSON to the stream.
+             * Threads are numbered in the order they first emitted an
+             * event, timestamps are in microseconds since this object was
+             * created.
+             */
+            void write(std::ostream& out) const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+
+                std::map<std::thread::id, std::size_t> thread_ids;
+                out << "{\"traceEvents\":[";
+                bool first = true;
+                for (const auto& event : m_events) {
+                    const auto id = thread_ids.emplace(event.thread, thread_ids.size() + 1).first->second;
+                    const auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(event.time - m_start).count();
+                    if (!first) {
+                        out << ',';
+                    }
+                    first = false;
+                    out << "\n{\"name\":\"" << trace_stage_name(event.stage)
+                        << "\",\"cat\":\"osmium\",\"ph\":\"" << (event.begin ? 'B' : 'E')
+                        << "\",\"ts\":" << (ts / 1000) << '.';
+                    const auto fraction = ts % 1000;
+                    if (fraction < 100) {
+                        out << '0';
+                    }
+                    if (fraction < 10) {
+                        out << '0';
+                    }
+                    out << fraction
+                        << ",\"pid\":1,\"tid\":" << id
+                        << ",\"args\":{\"sequence\":" << event.sequence << "}}";
+                }
+                out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+            }
+
+        }; // class ChromeTraceWriter
+
+    } // namespace util
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_TRACE_HPP
@@ -40,7 +40,10 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm.hpp>
 #include <osmium/osm/entity.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/util/trace.hpp>
 
+#include <cstdint>
+#include <initializer_list>
 #include <type_traits>
 #include <utility>
 
@@ -295,13 +298,296 @@ namespace osmium {
             return wrapper_handler<typename std::decay<T>::type>(std::forward<T>(func));
         }
 
+        // Does the handler have its own version of the callback? This is
+        // false if the function is the one inherited from the Handler
+        // base class which doesn't do anything. If it can't be determined
+        // (for instance because the function is overloaded) this is true.
+#define OSMIUM_HANDLER_OVERRIDES(_name_) \
+template <typename THandler, typename = void> \
+struct overrides_##_name_ : std::true_type { \
+}; \
+template <typename THandler> \
+struct overrides_##_name_<THandler, typename std::enable_if<std::is_same<decltype(&THandler::_name_), decltype(&osmium::handler::Handler::_name_)>::value>::type> : std::false_type { \
+}; \
+template <typename THandler, typename TObject> \
+inline void call_##_name_(THandler& handler, TObject& object, std::true_type /*overridden*/) { \
+    handler._name_(object); \
+} \
+template <typename THandler, typename TObject> \
+inline void call_##_name_(THandler& /*handler*/, TObject& /*object*/, std::false_type /*overridden*/) noexcept { \
+} \
+template <typename THandler, typename TObject> \
+inline void call_##_name_(THandler& handler, TObject& object) { \
+    call_##_name_(handler, object, overrides_##_name_<typename std::decay<THandler>::type>{}); \
+}
+
+        OSMIUM_HANDLER_OVERRIDES(osm_object)
+        OSMIUM_HANDLER_OVERRIDES(node)
+        OSMIUM_HANDLER_OVERRIDES(way)
+        OSMIUM_HANDLER_OVERRIDES(relation)
+        OSMIUM_HANDLER_OVERRIDES(area)
+        OSMIUM_HANDLER_OVERRIDES(changeset)
+
+#undef OSMIUM_HANDLER_OVERRIDES
+
+        // Call the callbacks for one object, leaving out those the
+        // handler doesn't override.
+        template <typename THandler>
+        inline void apply_object(const osmium::Node& node, THandler& handler) {
+            call_osm_object(handler, node);
+            call_node(handler, node);
+        }
+
+        template <typename THandler>
+        inline void apply_object(osmium::Node& node, THandler& handler) {
+            call_osm_object(handler, node);
+            call_node(handler, node);
+        }
+
+        template <typename THandler>
+        inline void apply_object(const osmium::Way& way, THandler& handler) {
+            call_osm_object(handler, way);
+            call_way(handler, way);
+        }
+
+        template <typename THandler>
+        inline void apply_object(osmium::Way& way, THandler& handler) {
+            call_osm_object(handler, way);
+            call_way(handler, way);
+        }
+
+        template <typename THandler>
+        inline void apply_object(const osmium::Relation& relation, THandler& handler) {
+            call_osm_object(handler, relation);
+            call_relation(handler, relation);
+        }
+
+        template <typename THandler>
+        inline void apply_object(osmium::Relation& relation, THandler& handler) {
+            call_osm_object(handler, relation);
+            call_relation(handler, relation);
+        }
+
+        template <typename THandler>
+        inline void apply_object(const osmium::Area& area, THandler& handler) {
+            call_osm_object(handler, area);
+            call_area(handler, area);
+        }
+
+        template <typename THandler>
+        inline void apply_object(osmium::Area& area, THandler& handler) {
+            call_osm_object(handler, area);
+            call_area(handler, area);
+        }
+
+        template <typename THandler>
+        inline void apply_object(const osmium::Changeset& changeset, THandler& handler) {
+            call_changeset(handler, changeset);
+        }
+
+        template <typename THandler>
+        inline void apply_object(osmium::Changeset& changeset, THandler& handler) {
+            call_changeset(handler, changeset);
+        }
+
+        template <typename TObject, typename TItem, typename... THandlers>
+        inline void apply_object_to_all(TItem& item, THandlers&... handlers) {
+            auto& object = static_cast<ConstIfConst<TItem, TObject>&>(item);
+            (void)std::initializer_list<int>{
+                (apply_object(object, handlers), 0)...
+            };
+        }
+
+        // Look at the type of the item only once for all handlers.
+        // Only used for items (and entities) because other item classes
+        // can't be cast to all the types.
+        template <typename TItem, typename... THandlers>
+        inline void apply_item_fused_impl(TItem& item, THandlers&... handlers) {
+            switch (item.type()) {
+                case osmium::item_type::node:
+                    apply_object_to_all<osmium::Node>(item, handlers...);
+                    break;
+                case osmium::item_type::way:
+                    apply_object_to_all<osmium::Way>(item, handlers...);
+                    break;
+                case osmium::item_type::relation:
+                    apply_object_to_all<osmium::Relation>(item, handlers...);
+                    break;
+                case osmium::item_type::area:
+                    apply_object_to_all<osmium::Area>(item, handlers...);
+                    break;
+                case osmium::item_type::changeset:
+                    apply_object_to_all<osmium::Changeset>(item, handlers...);
+                    break;
+                default:
+                    (void)std::initializer_list<int>{
+                        (apply_item_impl(item, handlers), 0)...
+                    };
+            }
+        }
+
+        template <typename... THandlers>
+        inline void apply_item_fused(const osmium::memory::Item& item, THandlers&... handlers) {
+            apply_item_fused_impl(item, handlers...);
+        }
+
+        template <typename... THandlers>
+        inline void apply_item_fused(osmium::memory::Item& item, THandlers&... handlers) {
+            apply_item_fused_impl(item, handlers...);
+        }
+
+        template <typename... THandlers>
+        inline void apply_item_fused(const osmium::OSMEntity& item, THandlers&... handlers) {
+            apply_item_fused_impl(item, handlers...);
+        }
+
+        template <typename... THandlers>
+        inline void apply_item_fused(osmium::OSMEntity& item, THandlers&... handlers) {
+            apply_item_fused_impl(item, handlers...);
+        }
+
+        template <typename TItem, typename... THandlers>
+        inline void apply_item_fused(TItem& item, THandlers&... handlers) {
+            (void)std::initializer_list<int>{
+                (apply_item_impl(item, handlers), 0)...
+            };
+        }
+
+        // Loop over a buffer containing only objects of type TObject
+        // without looking at the type of every object.
+        template <typename TObject, typename TBuffer, typename... THandlers>
+        inline void apply_objects(TBuffer& buffer, THandlers&... handlers) {
+            for (auto& object : buffer.template select<TObject>()) {
+                (void)std::initializer_list<int>{
+                    (apply_object(object, handlers), 0)...
+                };
+            }
+        }
+
+        // Handlers can have node_batch(), way_batch(), and
+        // relation_batch() functions taking a range of consecutive
+        // objects of one type. They are called instead of osm_object()
+        // and node() etc.
+#define OSMIUM_HANDLER_BATCH(_name_, _type_) \
+template <typename THandler, typename = void> \
+struct has_##_name_##_batch : std::false_type { \
+}; \
+template <typename THandler> \
+struct has_##_name_##_batch<THandler, decltype(std::declval<THandler&>()._name_##_batch(std::declval<const osmium::memory::ItemIteratorRange<const osmium::_type_>&>()), void())> : std::true_type { \
+}; \
+template <typename TIterator, typename THandler> \
+inline void apply_##_name_##_run(TIterator first, TIterator last, THandler& handler, std::true_type /*batch*/) { \
+    handler._name_##_batch(osmium::memory::ItemIteratorRange<const osmium::_type_>{first.data(), last.data()}); \
+} \
+template <typename TIterator, typename THandler> \
+inline void apply_##_name_##_run(TIterator first, TIterator last, THandler& handler, std::false_type /*batch*/) { \
+    for (; first != last; ++first) { \
+        apply_object(static_cast<ConstIfConst<typename std::remove_reference<decltype(*first)>::type, osmium::_type_>&>(*first), handler); \
+    } \
+}
+
+        OSMIUM_HANDLER_BATCH(node, Node)
+        OSMIUM_HANDLER_BATCH(way, Way)
+        OSMIUM_HANDLER_BATCH(relation, Relation)
+
+#undef OSMIUM_HANDLER_BATCH
+
+        template <typename... THandlers>
+        struct any_batch;
+
+        template <>
+        struct any_batch<> : std::false_type {
+        };
+
+        template <typename THandler, typename... THandlers>
+        struct any_batch<THandler, THandlers...> : std::integral_constant<bool,
+            has_node_batch<THandler>::value ||
+            has_way_batch<THandler>::value ||
+            has_relation_batch<THandler>::value ||
+            any_batch<THandlers...>::value> {
+        };
+
+        template <typename TIterator, typename THandler>
+        inline void apply_run(osmium::item_type type, TIterator first, TIterator last, THandler& handler) {
+            using handler_type = typename std::decay<THandler>::type;
+            switch (type) {
+                case osmium::item_type::node:
+                    apply_node_run(first, last, handler, has_node_batch<handler_type>{});
+                    break;
+                case osmium::item_type::way:
+                    apply_way_run(first, last, handler, has_way_batch<handler_type>{});
+                    break;
+                case osmium::item_type::relation:
+                    apply_relation_run(first, last, handler, has_relation_batch<handler_type>{});
+                    break;
+                default:
+                    for (; first != last; ++first) {
+                        apply_item_fused(*first, handler);
+                    }
+            }
+        }
+
+        // If any handler has batch functions, the buffer is split into
+        // runs of objects of the same type. Each handler gets each run
+        // in turn.
+        template <typename TBuffer, typename... THandlers>
+        inline void apply_buffer_dispatch(TBuffer& buffer, std::true_type /*batch*/, THandlers&... handlers) {
+            auto it = buffer.begin();
+            const auto end = buffer.end();
+
+            if (buffer.content_type() != osmium::item_type::undefined) {
+                (void)std::initializer_list<int>{
+                    (apply_run(buffer.content_type(), it, end, handlers), 0)...
+                };
+                return;
+            }
+
+            while (it != end) {
+                const auto type = it->type();
+                const auto first = it;
+                ++it;
+                if (type == osmium::item_type::node ||
+                    type == osmium::item_type::way ||
+                    type == osmium::item_type::relation) {
+                    while (it != end && it->type() == type) {
+                        ++it;
+                    }
+                }
+                (void)std::initializer_list<int>{
+                    (apply_run(type, first, it, handlers), 0)...
+                };
+            }
+        }
+
+        template <typename TBuffer, typename... THandlers>
+        inline void apply_buffer_dispatch(TBuffer& buffer, std::false_type /*batch*/, THandlers&... handlers) {
+            switch (buffer.content_type()) {
+                case osmium::item_type::node:
+                    apply_objects<osmium::Node>(buffer, handlers...);
+                    break;
+                case osmium::item_type::way:
+                    apply_objects<osmium::Way>(buffer, handlers...);
+                    break;
+                case osmium::item_type::relation:
+                    apply_objects<osmium::Relation>(buffer, handlers...);
+                    break;
+                default:
+                    for (auto& item : buffer) {
+                        apply_item_fused(item, handlers...);
+                    }
+            }
+        }
+
+        template <typename TBuffer, typename... THandlers>
+        inline void apply_buffer_impl(TBuffer& buffer, THandlers&... handlers) {
+            apply_buffer_dispatch(buffer, any_batch<typename std::decay<THandlers>::type...>{}, handlers...);
+        }
+
     } // namespace detail
 
     template <typename TItem, typename... THandlers>
     inline void apply_item(TItem& item, THandlers&&... handlers) {
-        (void)std::initializer_list<int>{
-            (detail::apply_item_impl(item, std::forward<THandlers>(handlers)), 0)...
-        };
+        detail::apply_item_fused(item, handlers...);
     }
 
     template <typename... THandlers>
@@ -331,9 +617,47 @@ namespace osmium {
         apply(begin(c), end(c), std::forward<THandlers>(handlers)...);
     }
 
+    template <typename TBuffer, typename... THandlers>
+    inline void apply_buffer_and_flush(TBuffer& buffer, THandlers&&... handlers) {
+        detail::apply_buffer_impl(buffer, handlers...);
+        apply_flush(std::forward<THandlers>(handlers)...);
+    }
+
+    template <typename... THandlers>
+    inline void apply_reader_impl(osmium::io::Reader& reader, THandlers&&... handlers) {
+        uint64_t sequence = 0;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            const osmium::util::TraceScope trace{osmium::util::trace_stage::handler, sequence++};
+            detail::apply_buffer_impl(buffer, handlers...);
+        }
+        apply_flush(std::forward<THandlers>(handlers)...);
+    }
+
+    /**
+     * Apply the handlers to all objects in the buffer. If the buffer is
+     * marked as containing only one type of object (see
+     * osmium::memory::Buffer::content_type()), a loop specialized for
+     * this type is used.
+     */
     template <typename... THandlers>
     inline void apply(const osmium::memory::Buffer& buffer, THandlers&&... handlers) {
-        apply(buffer.cbegin(), buffer.cend(), std::forward<THandlers>(handlers)...);
+        apply_buffer_and_flush(buffer, detail::make_handler<THandlers>(std::forward<THandlers>(handlers))...);
+    }
+
+    template <typename... THandlers>
+    inline void apply(osmium::memory::Buffer& buffer, THandlers&&... handlers) {
+        apply_buffer_and_flush(buffer, detail::make_handler<THandlers>(std::forward<THandlers>(handlers))...);
+    }
+
+    /**
+     * Apply the handlers to all objects read from the reader buffer by
+     * buffer. Buffers marked as containing only one type of object (see
+     * osmium::memory::Buffer::content_type()) use a loop specialized
+     * for this type.
+     */
+    template <typename... THandlers>
+    inline void apply(osmium::io::Reader& reader, THandlers&&... handlers) {
+        apply_reader_impl(reader, detail::make_handler<THandlers>(std::forward<THandlers>(handlers))...);
     }
 
 } // namespace osmium
@@ -0,0 +1,211 @@
+#include "catch.hpp"
+
+#include <osmium/area/area_updater.hpp>
+#include <osmium/handler/update_object_relations.hpp>
+#include <osmium/index/map/sparse_mem_map.hpp>
+#include <osmium/index/object_store.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cerrno>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _MSC_VER
+# include <direct.h>
+#endif
+
+using location_index_type = osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::Location>;
+using relations_index_type = osmium::handler::UpdateObjectRelations::index_type;
+using change_list = std::vector<std::pair<osmium::area::area_change_type, osmium::object_id_type>>;
+
+static osmium::memory::Buffer opl_buffer(std::initializer_list<const char*> lines) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (const char* line : lines) {
+        REQUIRE(osmium::opl_parse(line, buffer));
+    }
+    return buffer;
+}
+
+static osmium::memory::Buffer initial_data() {
+    return opl_buffer({
+        "n1 v1 x1.0 y1.0",
+        "n2 v1 x2.0 y1.0",
+        "n3 v1 x2.0 y2.0",
+        "n4 v1 x1.0 y2.0",
+        "n5 v1 x5.0 y5.0",
+        "n6 v1 x6.0 y5.0",
+        "n7 v1 x6.0 y6.0",
+        "n8 v1 x5.0 y6.0",
+        "n9 v1 x8.0 y8.0",
+        "w10 v1 Tbuilding=yes Nn1,n2,n3,n4,n1",
+        "w11 v1 Nn5,n6,n7",
+        "w12 v1 Nn7,n8,n5",
+        "w13 v1 Nn1,n2,n9,n1",
+        "w14 v1 Thighway=residential Nn4,n9",
+        "r20 v1 Ttype=multipolygon,landuse=forest Mw11@outer,w12@outer"
+    });
+}
+
+class Fixture {
+
+public:
+
+    location_index_type locations;
+    relations_index_type w2n;
+    relations_index_type n2w;
+    relations_index_type r2w;
+    relations_index_type w2r;
+
+    explicit Fixture(const osmium::memory::Buffer& buffer) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            locations.set(node.positive_id(), node.location());
+        }
+        locations.sort();
+
+        osmium::handler::UpdateObjectRelations handler{w2n, n2w, r2w, w2r, true};
+        osmium::apply(buffer, handler);
+        handler.finish();
+    }
+
+}; // class Fixture
+
+static change_list apply_changes(osmium::area::AreaUpdater& updater, const osmium::memory::Buffer& changes, osmium::area::area_update_stats& stats) {
+    change_list result;
+    stats = updater.apply(changes, [&](osmium::area::area_change_type change, const osmium::Area& area) {
+        if (change == osmium::area::area_change_type::deleted) {
+            REQUIRE_FALSE(area.visible());
+            REQUIRE(area.num_rings().first == 0);
+        } else {
+            REQUIRE(area.visible());
+            REQUIRE(area.num_rings().first > 0);
+        }
+        result.emplace_back(change, area.id());
+    });
+    return result;
+}
+
+TEST_CASE("Area updater reassembles areas affected by changes") {
+    const auto data = initial_data();
+    Fixture fixture{data};
+
+    osmium::area::AreaUpdater updater{nullptr, fixture.locations, fixture.w2n, fixture.n2w, fixture.r2w, fixture.w2r};
+    updater.load(data);
+    REQUIRE(updater.num_remembered() == 6);
+
+    osmium::area::area_update_stats stats;
+
+    SECTION("moved node changes closed way") {
+        const auto changes = opl_buffer({"n3 v2 x2.5 y2.5"});
+        const auto result = apply_changes(updater, changes, stats);
+        REQUIRE(result == (change_list{{osmium::area::area_change_type::modified, 20}}));
+        REQUIRE(stats.nodes == 1);
+        REQUIRE(stats.affected_ways == 1);
+        REQUIRE(stats.affected_relations == 0);
+        REQUIRE(stats.modified == 1);
+        REQUIRE(stats.assembler.area_simple_case == 1);
+    }
+
+    SECTION("moved node changes relation through member way") {
+        const auto changes = opl_buffer({"n6 v2 x6.5 y4.5"});
+        const auto result = apply_changes(updater, changes, stats);
+        REQUIRE(result == (change_list{{osmium::area::area_change_type::modified, 41}}));
+        REQUIRE(stats.affected_ways == 1);
+        REQUIRE(stats.affected_relations == 1);
+    }
+
+    SECTION("node used by several objects only leads to one update each") {
+        const auto changes = opl_buffer({
+            "n1 v2 x0.5 y0.5",
+            "n4 v2 x0.5 y2.0",
+            "w10 v2 Tbuilding=house Nn1,n2,n3,n4,n1"
+        });
+        const auto result = apply_changes(updater, changes, stats);
+        REQUIRE(result == (change_list{{osmium::area::area_change_type::modified, 20}}));
+        REQUIRE(stats.affected_ways == 3); // w10, w13 (no tags), w14 (not closed)
+    }
+
+    SECTION("tagged way becomes area") {
+        const auto changes = opl_buffer({"w13 v2 Tlanduse=meadow Nn1,n2,n9,n1"});
+        const auto result = apply_changes(updater, changes, stats);
+        REQUIRE(result == (change_list{{osmium::area::area_change_type::created, 26}}));
+        REQUIRE(stats.created == 1);
+    }
+
+    SECTION("deleted way deletes area") {
+        const auto changes = opl_buffer({"w10 v2 dD"});
+        const auto result = apply_changes(updater, changes, stats);
+        REQUIRE(result == (change_list{{osmium::area::area_change_type::deleted, 20}}));
+        REQUIRE(stats.deleted == 1);
+    }
+
+    SECTION("way that can't be assembled any more deletes area") {
+        // self-intersecting
+        const auto changes = opl_buffer({"n3 v2 x1.0 y0.0"});
+        const auto result = apply_changes(updater, changes, stats);
+        REQUIRE(result == (change_list{{osmium::area::area_change_type::deleted, 20}}));
+    }
+
+    SECTION("deleted member way deletes multipolygon, new member creates it again") {
+        auto result = apply_changes(updater, opl_buffer({"w12 v2 dD"}), stats);
+        REQUIRE(result == (change_list{{osmium::area::area_change_type::deleted, 41}}));
+
+        result = apply_changes(updater, opl_buffer({
+            "w15 v1 Nn7,n8,n5",
+            "r20 v2 Ttype=multipolygon,landuse=forest Mw11@outer,w15@outer"
+        }), stats);
+        REQUIRE(result == (change_list{{osmium::area::area_change_type::created, 41}}));
+
+        // the new member way is in the indexes now
+        result = apply_changes(updater, opl_buffer({"n8 v2 x5.0 y6.5"}), stats);
+        REQUIRE(result == (change_list{{osmium::area::area_change_type::modified, 41}}));
+    }
+
+    SECTION("changes to unrelated objects do nothing") {
+        const auto changes = opl_buffer({"n9 v2 x8.5 y8.5", "w14 v2 Thighway=primary Nn4,n9"});
+        const auto result = apply_changes(updater, changes, stats);
+        REQUIRE(result.empty());
+        REQUIRE(stats.affected_ways == 2);
+    }
+}
+
+TEST_CASE("Area updater uses object store") {
+    const std::string directory{"test-area-updater-store"};
+#ifndef _WIN32
+    const int mkdir_result = ::mkdir(directory.c_str(), 0777);
+#else
+    const int mkdir_result = _mkdir(directory.c_str());
+#endif
+    REQUIRE((mkdir_result == 0 || errno == EEXIST));
+
+    const auto data = initial_data();
+    {
+        osmium::index::ObjectStoreWriter writer{directory};
+        writer(data);
+        writer.close();
+    }
+    const osmium::index::ObjectStore store{directory};
+
+    Fixture fixture{data};
+    osmium::area::AreaUpdater updater{&store, fixture.locations, fixture.w2n, fixture.n2w, fixture.r2w, fixture.w2r};
+    REQUIRE(updater.num_remembered() == 0);
+
+    osmium::area::area_update_stats stats;
+    auto result = apply_changes(updater, opl_buffer({"n3 v2 x2.5 y2.5", "n6 v2 x6.5 y4.5"}), stats);
+    REQUIRE(result == (change_list{{osmium::area::area_change_type::modified, 20},
+                                   {osmium::area::area_change_type::modified, 41}}));
+
+    result = apply_changes(updater, opl_buffer({"w10 v2 dD"}), stats);
+    REQUIRE(result == (change_list{{osmium::area::area_change_type::deleted, 20}}));
+    REQUIRE(updater.num_remembered() == 1);
+
+    // the deleted way in the overlay hides the way in the store
+    result = apply_changes(updater, opl_buffer({"n2 v2 x2.5 y1.0"}), stats);
+    REQUIRE(result.empty());
+}
@@ -1,10 +1,20 @@
 #include "catch.hpp"
 
 #include <osmium/area/assembler.hpp>
+#include <osmium/area/segment_cache.hpp>
 #include <osmium/builder/attr.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/area.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
 using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 TEST_CASE("Build area from way") {
@@ -141,3 +151,270 @@ TEST_CASE("Build area from way with ignored invalid location") {
     REQUIRE(s.invalid_locations == 1);
 }
 
+
+namespace {
+
+    // Add a square ring as closed way with the given id to the buffer.
+    void add_square(osmium::memory::Buffer& buffer, osmium::object_id_type id, double x, double y, double size) {
+        const std::vector<osmium::NodeRef> nodes = {
+            {id * 10 + 0, {x,        y       }},
+            {id * 10 + 1, {x,        y + size}},
+            {id * 10 + 2, {x + size, y + size}},
+            {id * 10 + 3, {x + size, y       }},
+            {id * 10 + 0, {x,        y       }}
+        };
+        osmium::builder::add_way(buffer, _id(id), _nodes(nodes));
+    }
+
+    // Assemble multipolygon with the given config and return a string
+    // describing the area.
+    std::string assemble_grid(const osmium::area::AssemblerConfig& config, bool touching) {
+        osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+        constexpr const int size = 20;
+        std::vector<member_type> members;
+
+        // One big outer ring with holes in a grid, every other hole with
+        // an island in it.
+        add_square(buffer, 1, 0.0, 0.0, size + 1.0);
+        members.emplace_back(osmium::item_type::way, 1, "outer");
+        osmium::object_id_type id = 2;
+        for (int i = 0; i < size; ++i) {
+            for (int j = 0; j < size; ++j) {
+                add_square(buffer, id, i + 0.5, j + 0.5, 0.5);
+                members.emplace_back(osmium::item_type::way, id++, "inner");
+                if ((i + j) % 2 == 0) {
+                    add_square(buffer, id, i + 0.6, j + 0.6, 0.3);
+                    members.emplace_back(osmium::item_type::way, id++, "outer");
+                }
+            }
+        }
+
+        // Hole touching another hole at a corner (forces the complex case).
+        if (touching) {
+            add_square(buffer, id, 1.0, 1.0, 0.2);
+            members.emplace_back(osmium::item_type::way, id++, "inner");
+        }
+
+        const auto rpos = osmium::builder::add_relation(buffer, _id(1), _tag("type", "multipolygon"), _members(members));
+
+        std::vector<const osmium::Way*> ways;
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            ways.push_back(&way);
+        }
+
+        osmium::area::Assembler assembler{config};
+        osmium::memory::Buffer area_buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+        REQUIRE(assembler(buffer.get<osmium::Relation>(rpos), ways, area_buffer));
+
+        const auto& area = area_buffer.get<osmium::Area>(0);
+        std::string out;
+        for (const auto& outer : area.outer_rings()) {
+            out += "O";
+            for (const auto& nr : outer) {
+                out += ' ' + std::to_string(nr.ref());
+            }
+            for (const auto& inner : area.inner_rings(outer)) {
+                out += "\n I";
+                for (const auto& nr : inner) {
+                    out += ' ' + std::to_string(nr.ref());
+                }
+            }
+            out += '\n';
+        }
+        return out;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Build area with many rings with and without segment index") {
+    osmium::area::AssemblerConfig config_plain;
+    config_plain.segment_index_threshold = std::numeric_limits<std::size_t>::max();
+
+    osmium::area::AssemblerConfig config_index;
+    config_index.segment_index_threshold = 0;
+
+    SECTION("simple case") {
+        const auto result = assemble_grid(config_plain, false);
+        REQUIRE(std::count(result.begin(), result.end(), 'O') == 201);
+        REQUIRE(std::count(result.begin(), result.end(), 'I') == 400);
+        REQUIRE(result == assemble_grid(config_index, false));
+    }
+
+    SECTION("complex case") {
+        const auto result = assemble_grid(config_plain, true);
+        REQUIRE(std::count(result.begin(), result.end(), 'I') == 401);
+        REQUIRE(result == assemble_grid(config_index, true));
+    }
+}
+
+TEST_CASE("Build area with many rings with segment cache") {
+    const osmium::area::AssemblerConfig config_plain;
+    const auto expected = assemble_grid(config_plain, true);
+
+    osmium::area::SegmentCache cache;
+    osmium::area::AssemblerConfig config_cache;
+    config_cache.segment_cache = &cache;
+
+    REQUIRE(assemble_grid(config_cache, true) == expected);
+    REQUIRE(cache.hits() == 0);
+    REQUIRE(cache.size() == 602);
+
+    REQUIRE(assemble_grid(config_cache, true) == expected);
+    REQUIRE(cache.hits() == 602);
+}
+
+TEST_CASE("Reuse assembler after reset") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    add_square(buffer, 1, 0.0, 0.0, 4.0);
+    add_square(buffer, 2, 1.0, 1.0, 1.0);
+    add_square(buffer, 3, 5.0, 5.0, 1.0);
+    const auto rpos = osmium::builder::add_relation(buffer, _id(1), _tag("type", "multipolygon"),
+        _member(osmium::item_type::way, 1, "outer"),
+        _member(osmium::item_type::way, 2, "inner"));
+
+    std::vector<const osmium::Way*> ways;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        if (way.id() < 3) {
+            ways.push_back(&way);
+        }
+    }
+    const auto& way = *std::next(buffer.select<osmium::Way>().begin(), 2);
+
+    osmium::area::AssemblerConfig config;
+    config.segment_index_threshold = 0;
+    osmium::area::Assembler assembler{config};
+
+    osmium::memory::Buffer area_buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(assembler(buffer.get<osmium::Relation>(rpos), ways, area_buffer));
+    REQUIRE(assembler.stats().nodes == 8);
+    REQUIRE(assembler.stats().inner_rings == 1);
+
+    assembler.reset();
+    REQUIRE(assembler.stats().nodes == 0);
+    REQUIRE(assembler(way, area_buffer));
+    REQUIRE(assembler.stats().nodes == 4);
+    REQUIRE(assembler.stats().from_ways == 1);
+    REQUIRE(assembler.stats().from_relations == 0);
+    REQUIRE(assembler.stats().inner_rings == 0);
+
+    osmium::area::Assembler fresh_assembler{config};
+    osmium::memory::Buffer fresh_buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(fresh_assembler(way, fresh_buffer));
+
+    const auto& area = *std::next(area_buffer.select<osmium::Area>().begin());
+    const auto& fresh_area = fresh_buffer.get<osmium::Area>(0);
+    REQUIRE(area.id() == 6);
+    REQUIRE(area.num_rings() == fresh_area.num_rings());
+    REQUIRE(std::equal(area.outer_rings().begin()->cbegin(), area.outer_rings().begin()->cend(),
+                       fresh_area.outer_rings().begin()->cbegin()));
+}
+
+TEST_CASE("Reuse assembler for complex multipolygons") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    // Inner ring touching the outer ring at two nodes, so the rings have
+    // to be put together from several partial rings.
+    osmium::builder::add_way(buffer, _id(1), _nodes({
+        {1, {0.0, 0.0}}, {2, {0.0, 4.0}}, {3, {4.0, 4.0}}, {4, {4.0, 0.0}}, {1, {0.0, 0.0}}
+    }));
+    osmium::builder::add_way(buffer, _id(2), _nodes({
+        {2, {0.0, 4.0}}, {6, {2.0, 2.5}}, {4, {4.0, 0.0}}, {7, {1.5, 1.0}}, {2, {0.0, 4.0}}
+    }));
+    const auto rpos = osmium::builder::add_relation(buffer, _id(1), _tag("type", "multipolygon"),
+        _member(osmium::item_type::way, 1, "outer"),
+        _member(osmium::item_type::way, 2, "inner"));
+
+    std::vector<const osmium::Way*> ways;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        ways.push_back(&way);
+    }
+    const auto& relation = buffer.get<osmium::Relation>(rpos);
+
+    const auto area_string = [](const osmium::memory::Buffer& area_buffer) {
+        std::string out;
+        for (const auto& area : area_buffer.select<osmium::Area>()) {
+            for (const auto& ring : area.outer_rings()) {
+                out += 'O';
+                for (const auto& nr : ring) {
+                    out += ' ' + std::to_string(nr.ref());
+                }
+                for (const auto& inner : area.inner_rings(ring)) {
+                    out += " I";
+                    for (const auto& nr : inner) {
+                        out += ' ' + std::to_string(nr.ref());
+                    }
+                }
+            }
+        }
+        return out;
+    };
+
+    const osmium::area::AssemblerConfig config;
+
+    osmium::area::Assembler fresh_assembler{config};
+    osmium::memory::Buffer expected_buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    fresh_assembler(relation, ways, expected_buffer);
+    const auto expected = area_string(expected_buffer);
+    REQUIRE_FALSE(expected.empty());
+    const auto expected_stats = fresh_assembler.stats();
+    REQUIRE(expected_stats.area_really_complex_case == 1);
+
+    osmium::area::Assembler assembler{config};
+    for (int i = 0; i < 3; ++i) {
+        assembler.reset();
+        osmium::memory::Buffer area_buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+        assembler(relation, ways, area_buffer);
+        REQUIRE(area_string(area_buffer) == expected);
+        REQUIRE(assembler.stats().outer_rings == expected_stats.outer_rings);
+        REQUIRE(assembler.stats().inner_rings == expected_stats.inner_rings);
+        REQUIRE(assembler.stats().area_really_complex_case == 1);
+    }
+}
+
+TEST_CASE("Assembler collects stage timings") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto wpos = osmium::builder::add_way(buffer,
+        _id(1),
+        _nodes({
+            {1, {1.0, 1.0}},
+            {2, {1.0, 2.0}},
+            {3, {2.0, 2.0}},
+            {4, {2.0, 1.0}},
+            {1, {1.0, 1.0}}
+        })
+    );
+
+    osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler{config};
+
+    osmium::memory::Buffer area_buffer{10240};
+    REQUIRE(assembler(buffer.get<osmium::Way>(wpos), area_buffer));
+
+    const auto& s = assembler.stats();
+    REQUIRE(s.segments == 4);
+    REQUIRE(s.time_rings_complex == 0);
+    REQUIRE(s.time_total >= s.time_sort + s.time_duplicate_segments + s.time_intersections +
+                            s.time_locations + s.time_rings_simple + s.time_roles);
+    REQUIRE(std::accumulate(s.time_histogram.cbegin(), s.time_histogram.cend(), uint64_t{0}) == 1);
+
+    osmium::area::area_stats sum;
+    sum += s;
+    sum += s;
+    REQUIRE(sum.segments == 8);
+    REQUIRE(sum.time_total == 2 * s.time_total);
+    REQUIRE(std::accumulate(sum.time_histogram.cbegin(), sum.time_histogram.cend(), uint64_t{0}) == 2);
+}
+
+TEST_CASE("Assembly time histogram buckets") {
+    osmium::area::area_stats s;
+    s.add_assembly_time(500);
+    s.add_assembly_time(1500);
+    s.add_assembly_time(3000);
+    s.add_assembly_time(std::numeric_limits<uint64_t>::max());
+    REQUIRE(s.time_histogram[0] == 1);
+    REQUIRE(s.time_histogram[1] == 1);
+    REQUIRE(s.time_histogram[2] == 1);
+    REQUIRE(s.time_histogram.back() == 1);
+}
@@ -0,0 +1,134 @@
+#include "catch.hpp"
+
+#include <osmium/area/line_merger.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::vector<std::string> merged_ways(osmium::area::LineMerger& merger) {
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    merger.create_ways(out);
+    std::vector<std::string> result;
+    for (const auto& way : out.select<osmium::Way>()) {
+        std::string str{way.is_closed() ? "ring" : "line"};
+        for (const auto& nr : way.nodes()) {
+            str += ' ' + std::to_string(nr.ref());
+        }
+        result.push_back(str);
+    }
+    return result;
+}
+
+TEST_CASE("Line merger with two ways forming a ring") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {0.0, 0.0}}, {2, {0.0, 1.0}}, {3, {1.0, 1.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{3, {1.0, 1.0}}, {4, {1.0, 0.0}}, {1, {0.0, 0.0}}}));
+
+    osmium::thread::Pool pool{2};
+    osmium::area::LineMerger merger{pool};
+    merger.add_ways(buffer);
+    REQUIRE(merger.num_segments() == 4);
+    merger.merge();
+
+    REQUIRE(merger.num_lines() == 1);
+    REQUIRE(merger.num_rings() == 1);
+    REQUIRE(merged_ways(merger) == std::vector<std::string>{"ring 1 2 3 4 1"});
+}
+
+TEST_CASE("Line merger joining open lines") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {0.0, 0.0}}, {2, {1.0, 0.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{4, {3.0, 0.0}}, {3, {2.0, 0.0}}, {2, {1.0, 0.0}}}));
+    osmium::builder::add_way(buffer, _id(3), _nodes({{4, {3.0, 0.0}}, {5, {4.0, 0.0}}}));
+
+    // overlapping way, gives duplicate segment
+    osmium::builder::add_way(buffer, _id(4), _nodes({{4, {3.0, 0.0}}, {5, {4.0, 0.0}}}));
+
+    // invalid location and zero length segment are ignored
+    osmium::builder::add_way(buffer, _id(5), _nodes({{6, {5.0, 0.0}}, {7, osmium::Location{}}}));
+    osmium::builder::add_way(buffer, _id(6), _nodes({{8, {6.0, 0.0}}, {9, {6.0, 0.0}}}));
+
+    osmium::area::LineMerger merger;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        merger.add_way(way);
+    }
+    merger.merge();
+
+    REQUIRE(merger.invalid_segments() == 1);
+    REQUIRE(merger.duplicate_segments() == 1);
+    REQUIRE(merger.num_segments() == 4);
+    REQUIRE(merger.num_rings() == 0);
+    REQUIRE(merged_ways(merger) == std::vector<std::string>{"line 1 2 3 4 5"});
+}
+
+TEST_CASE("Line merger stops lines at junctions") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {0.0, 0.0}}, {2, {1.0, 0.0}}, {3, {2.0, 0.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{2, {1.0, 0.0}}, {4, {1.0, 1.0}}}));
+
+    osmium::area::LineMerger merger;
+    merger.add_ways(buffer);
+    merger.merge();
+
+    REQUIRE(merger.num_lines() == 3);
+    REQUIRE(merger.num_rings() == 0);
+    auto ways = merged_ways(merger);
+    std::sort(ways.begin(), ways.end());
+    REQUIRE(ways == (std::vector<std::string>{"line 1 2", "line 2 3", "line 2 4"}));
+}
+
+TEST_CASE("Line merger with many rings in parallel") {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    const int size = 80;
+    osmium::object_id_type id = 1;
+    for (int x = 0; x < size; ++x) {
+        for (int y = 0; y < size; ++y) {
+            // Each square ring is split into two ways, the second one
+            // reversed.
+            const osmium::object_id_type n = id * 10;
+            const osmium::NodeRef n0{n + 0, {x * 1.0,       y * 1.0}};
+            const osmium::NodeRef n1{n + 1, {x * 1.0,       y * 1.0 + 0.5}};
+            const osmium::NodeRef n2{n + 2, {x * 1.0 + 0.5, y * 1.0 + 0.5}};
+            const osmium::NodeRef n3{n + 3, {x * 1.0 + 0.5, y * 1.0}};
+            osmium::builder::add_way(buffer, _id(id++), _nodes({n0, n1, n2}));
+            osmium::builder::add_way(buffer, _id(id++), _nodes({n0, n3, n2}));
+        }
+    }
+
+    osmium::thread::Pool pool{3};
+    osmium::area::LineMerger merger{pool};
+    merger.add_ways(buffer);
+    merger.add_ways(buffer);
+    REQUIRE(merger.num_segments() == 2 * 4 * size * size);
+    merger.merge();
+
+    REQUIRE(merger.duplicate_segments() == 4 * size * size);
+    REQUIRE(merger.num_lines() == size * size);
+    REQUIRE(merger.num_rings() == size * size);
+
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    merger.create_ways(out, 100, true);
+    int count = 0;
+    for (const auto& way : out.select<osmium::Way>()) {
+        REQUIRE(way.id() == 100 + count);
+        REQUIRE(way.nodes().size() == 5);
+        REQUIRE(way.is_closed());
+        ++count;
+    }
+    REQUIRE(count == size * size);
+
+    // merging again gives the same result
+    merger.merge();
+    REQUIRE(merger.num_rings() == size * size);
+
+    merger.clear();
+    REQUIRE(merger.num_segments() == 0);
+    REQUIRE(merger.num_lines() == 0);
+}
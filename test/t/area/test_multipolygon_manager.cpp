@@ -0,0 +1,184 @@
+#include "catch.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using mp_manager_type = osmium::area::MultipolygonManager<osmium::area::Assembler>;
+
+static osmium::memory::Buffer create_test_data() {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int i = 0; i < 20; ++i) {
+        const double x = i * 5.0;
+
+        // closed way tagged as area
+        osmium::builder::add_way(buffer,
+            _id(100 + i),
+            _tag("building", "yes"),
+            _nodes({
+                {1000 + i * 10, {x + 1.0, 1.0}},
+                {1001 + i * 10, {x + 1.0, 2.0}},
+                {1002 + i * 10, {x + 2.0, 2.0}},
+                {1003 + i * 10, {x + 2.0, 1.0}},
+                {1000 + i * 10, {x + 1.0, 1.0}}
+            })
+        );
+    }
+
+    for (int i = 0; i < 20; ++i) {
+        const double x = i * 5.0;
+
+        // two open ways forming a ring for a multipolygon relation
+        osmium::builder::add_way(buffer,
+            _id(200 + i * 2),
+            _nodes({
+                {1004 + i * 10, {x + 3.0, 1.0}},
+                {1005 + i * 10, {x + 3.0, 2.0}},
+                {1006 + i * 10, {x + 4.0, 2.0}}
+            })
+        );
+        osmium::builder::add_way(buffer,
+            _id(201 + i * 2),
+            _nodes({
+                {1006 + i * 10, {x + 4.0, 2.0}},
+                {1007 + i * 10, {x + 4.0, 1.0}},
+                {1004 + i * 10, {x + 3.0, 1.0}}
+            })
+        );
+    }
+
+    for (int i = 0; i < 20; ++i) {
+        osmium::builder::add_relation(buffer,
+            _id(300 + i),
+            _tag("type", "multipolygon"),
+            _tag("landuse", "forest"),
+            _member(osmium::item_type::way, 200 + i * 2, "outer"),
+            _member(osmium::item_type::way, 201 + i * 2, "outer")
+        );
+    }
+
+    return buffer;
+}
+
+static std::vector<osmium::object_id_type> assemble(mp_manager_type& manager, const osmium::memory::Buffer& input) {
+    for (const auto& relation : input.select<osmium::Relation>()) {
+        manager.relation(relation);
+    }
+    manager.prepare_for_lookup();
+
+    osmium::apply(input, manager.handler());
+
+    std::vector<osmium::object_id_type> ids;
+    const auto output = manager.read();
+    for (const auto& area : output.select<osmium::Area>()) {
+        REQUIRE(area.num_rings().first == 1);
+        ids.push_back(area.id());
+    }
+    return ids;
+}
+
+TEST_CASE("Parallel multipolygon assembly gives same result as sequential") {
+    const auto input = create_test_data();
+    const osmium::area::AssemblerConfig config;
+
+    mp_manager_type sequential_manager{config};
+    const auto expected = assemble(sequential_manager, input);
+    REQUIRE(expected.size() == 40);
+
+    osmium::thread::Pool pool{2};
+    mp_manager_type parallel_manager{config};
+    parallel_manager.set_thread_pool(pool, 3);
+    const auto result = assemble(parallel_manager, input);
+
+    REQUIRE(result == expected);
+    REQUIRE(parallel_manager.stats().from_ways == sequential_manager.stats().from_ways);
+    REQUIRE(parallel_manager.stats().from_relations == sequential_manager.stats().from_relations);
+}
+
+TEST_CASE("Parallel multipolygon assembly with callback") {
+    const auto input = create_test_data();
+    const osmium::area::AssemblerConfig config;
+
+    osmium::thread::Pool pool{2};
+    mp_manager_type manager{config};
+    manager.set_thread_pool(pool);
+
+    for (const auto& relation : input.select<osmium::Relation>()) {
+        manager.relation(relation);
+    }
+    manager.prepare_for_lookup();
+
+    std::size_t count = 0;
+    osmium::apply(input, manager.handler([&](osmium::memory::Buffer&& buffer) {
+        for (const auto& area : buffer.select<osmium::Area>()) {
+            (void)area;
+            ++count;
+        }
+    }));
+
+    REQUIRE(count == 40);
+}
+
+TEST_CASE("Multipolygon assembly with area cache") {
+    auto input = create_test_data();
+    const osmium::area::AssemblerConfig config;
+
+    mp_manager_type plain_manager{config};
+    const auto expected = assemble(plain_manager, input);
+
+    osmium::area::AreaCache cache;
+
+    mp_manager_type manager1{config};
+    manager1.set_cache(cache);
+    REQUIRE(assemble(manager1, input) == expected);
+    REQUIRE(cache.size() == 20);
+    REQUIRE(cache.hits() == 0);
+    REQUIRE(cache.misses() == 20);
+    REQUIRE(manager1.stats().from_relations == 20);
+
+    SECTION("unchanged input") {
+        mp_manager_type manager2{config};
+        manager2.set_cache(cache);
+        REQUIRE(assemble(manager2, input) == expected);
+        REQUIRE(cache.hits() == 20);
+        REQUIRE(cache.misses() == 20);
+        REQUIRE(manager2.stats().from_relations == 0);
+    }
+
+    SECTION("unchanged input with thread pool") {
+        osmium::thread::Pool pool{2};
+        mp_manager_type manager2{config};
+        manager2.set_thread_pool(pool, 3);
+        manager2.set_cache(cache);
+        REQUIRE(assemble(manager2, input) == expected);
+        REQUIRE(cache.hits() == 20);
+        REQUIRE(cache.misses() == 20);
+    }
+
+    SECTION("changed node location") {
+        // move node shared by ways 204 and 205 (relation 302)
+        for (auto& way : input.select<osmium::Way>()) {
+            for (auto& nr : way.nodes()) {
+                if (nr.ref() == 1024) {
+                    nr.set_location(osmium::Location{13.5, 1.5});
+                }
+            }
+        }
+
+        mp_manager_type manager2{config};
+        manager2.set_cache(cache);
+        REQUIRE(assemble(manager2, input) == expected);
+        REQUIRE(cache.hits() == 19);
+        REQUIRE(cache.misses() == 21);
+        REQUIRE(manager2.stats().from_relations == 1);
+    }
+}
@@ -0,0 +1,148 @@
+#include "catch.hpp"
+
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/area/segment_cache.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    class IntersectionRecorder : public osmium::area::ProblemReporter {
+
+    public:
+
+        std::vector<osmium::Location> intersections;
+
+        void report_intersection(osmium::object_id_type /*way1_id*/, osmium::Location /*way1_seg_start*/, osmium::Location /*way1_seg_end*/,
+                                 osmium::object_id_type /*way2_id*/, osmium::Location /*way2_seg_start*/, osmium::Location /*way2_seg_end*/, osmium::Location intersection) override {
+            intersections.push_back(intersection);
+        }
+
+    }; // class IntersectionRecorder
+
+    osmium::memory::Buffer create_ways() {
+        osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+        uint32_t seed = 42;
+        const auto random = [&seed](int32_t max) {
+            seed = seed * 1103515245U + 12345U;
+            return static_cast<int32_t>((seed >> 8U) % static_cast<uint32_t>(max));
+        };
+
+        osmium::object_id_type node_id = 1;
+        for (osmium::object_id_type id = 1; id <= 20; ++id) {
+            std::vector<osmium::NodeRef> nodes;
+            for (int n = 0; n < 20; ++n) {
+                const bool vertical = n % 2 == 0;
+                const int32_t x = vertical ? 100000 + random(1000) : random(1000000);
+                nodes.emplace_back(node_id++, osmium::Location{x, random(1000000)});
+            }
+            osmium::builder::add_way(buffer, _id(id), _nodes(nodes));
+        }
+
+        return buffer;
+    }
+
+    uint32_t find_intersections(const osmium::memory::Buffer& buffer, IntersectionRecorder& recorder, bool sweep_line) {
+        osmium::area::detail::SegmentList segment_list{false};
+        uint64_t duplicate_nodes = 0;
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            segment_list.extract_segments_from_way(nullptr, duplicate_nodes, way);
+        }
+        segment_list.sort();
+        uint64_t duplicate_segments = 0;
+        uint64_t overlapping_segments = 0;
+        segment_list.erase_duplicate_segments(nullptr, duplicate_segments, overlapping_segments);
+        return segment_list.find_intersections(&recorder, sweep_line);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Sweep line finds same intersections as simple algorithm") {
+    const auto buffer = create_ways();
+
+    IntersectionRecorder recorder_simple;
+    const auto count_simple = find_intersections(buffer, recorder_simple, false);
+
+    IntersectionRecorder recorder_sweep;
+    const auto count_sweep = find_intersections(buffer, recorder_sweep, true);
+
+    REQUIRE(count_simple > 100);
+    REQUIRE(count_simple == count_sweep);
+    REQUIRE(recorder_simple.intersections == recorder_sweep.intersections);
+}
+
+TEST_CASE("Sweep line on empty segment list") {
+    osmium::memory::Buffer buffer{1024};
+    IntersectionRecorder recorder;
+    REQUIRE(find_intersections(buffer, recorder, true) == 0);
+    REQUIRE(recorder.intersections.empty());
+}
+
+TEST_CASE("Segment list with segment cache") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {1.0, 1.0}}, {2, {1.0, 2.0}}, {3, {2.0, 2.0}}, {1, {1.0, 1.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{4, {3.0, 1.0}}, {5, {3.0, 1.0}}, {6, {3.0, 2.0}}}));
+    osmium::builder::add_way(buffer, _id(3), _nodes({{7, {4.0, 1.0}}, {8, osmium::Location{}}, {9, {4.0, 2.0}}}));
+
+    osmium::area::SegmentCache cache;
+
+    const auto extract = [&](osmium::area::SegmentCache* segment_cache) {
+        osmium::area::detail::SegmentList segment_list{false};
+        segment_list.set_cache(segment_cache);
+        uint64_t duplicate_nodes = 0;
+        uint32_t invalid_locations = 0;
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            invalid_locations += segment_list.extract_segments_from_way(nullptr, duplicate_nodes, way);
+        }
+        REQUIRE(duplicate_nodes == 1);
+        REQUIRE(invalid_locations == 1);
+        std::vector<osmium::area::detail::NodeRefSegment> segments{segment_list.begin(), segment_list.end()};
+        return segments;
+    };
+
+    const auto expected = extract(nullptr);
+    REQUIRE(expected.size() == 5);
+
+    REQUIRE(extract(&cache) == expected);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.num_segments() == 3);
+    REQUIRE(cache.hits() == 0);
+    REQUIRE(cache.misses() == 3);
+
+    const auto cached = extract(&cache);
+    REQUIRE(cached == expected);
+    REQUIRE(cached[0].way() == expected[0].way());
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.misses() == 5);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.num_segments() == 0);
+}
+
+TEST_CASE("Segment cache with maximum size") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {1.0, 1.0}}, {2, {1.0, 2.0}}, {3, {2.0, 2.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{4, {3.0, 1.0}}, {5, {3.0, 2.0}}}));
+
+    osmium::area::SegmentCache cache{2};
+    osmium::area::detail::SegmentList segment_list{false};
+    segment_list.set_cache(&cache);
+    uint64_t duplicate_nodes = 0;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        segment_list.extract_segments_from_way(nullptr, duplicate_nodes, way);
+    }
+
+    REQUIRE(segment_list.size() == 3);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.num_segments() == 2);
+}
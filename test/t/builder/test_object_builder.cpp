@@ -4,7 +4,13 @@
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 TEST_CASE("create objects using builder") {
     osmium::memory::Buffer buffer{1024 * 10};
@@ -480,3 +486,226 @@ TEST_CASE("clear_user should clear the user field but nothing else") {
     REQUIRE(it == node.tags().end());
 }
 
+
+namespace {
+
+    const std::vector<std::pair<std::string, std::string>> test_tags = {
+        {"highway", "primary"}, {"name", ""}, {"x", "a somewhat longer value"}
+    };
+
+    const std::vector<std::pair<osmium::item_type, std::string>> test_members = {
+        {osmium::item_type::way, "outer"}, {osmium::item_type::node, ""}, {osmium::item_type::relation, "subarea1"}
+    };
+
+    void build_way(osmium::memory::Buffer& buffer, bool fast) {
+        {
+            osmium::builder::WayBuilder builder{buffer};
+            builder.set_id(17).set_user("foo");
+            {
+                osmium::builder::WayNodeListBuilder wnl_builder{builder};
+                if (fast) {
+                    auto* node_ref = wnl_builder.add_node_refs(3);
+                    node_ref[0].set_ref(1);
+                    node_ref[1] = osmium::NodeRef{2, osmium::Location{1.0, 2.0}};
+                    node_ref[2].set_ref(3);
+                } else {
+                    wnl_builder.add_node_ref(1);
+                    wnl_builder.add_node_ref(2, osmium::Location{1.0, 2.0});
+                    wnl_builder.add_node_ref(3);
+                }
+            }
+            osmium::builder::TagListBuilder tl_builder{builder};
+            if (fast) {
+                std::size_t size = 0;
+                for (const auto& tag : test_tags) {
+                    size += osmium::builder::TagListBuilder::tag_size(tag.first.size(), tag.second.size());
+                }
+                char* target = tl_builder.reserve_tags(size);
+                for (const auto& tag : test_tags) {
+                    target = osmium::builder::TagListBuilder::write_tag(target, tag.first.data(), tag.first.size(), tag.second.data(), tag.second.size());
+                }
+            } else {
+                for (const auto& tag : test_tags) {
+                    tl_builder.add_tag(tag.first, tag.second);
+                }
+            }
+        }
+        buffer.commit();
+    }
+
+    void build_relation(osmium::memory::Buffer& buffer, bool fast) {
+        {
+            osmium::builder::RelationBuilder builder{buffer};
+            builder.set_id(17).set_user("foo");
+            osmium::builder::RelationMemberListBuilder rml_builder{builder};
+            if (fast) {
+                std::size_t size = 0;
+                for (const auto& member : test_members) {
+                    size += osmium::builder::RelationMemberListBuilder::member_size(member.second.size());
+                }
+                unsigned char* target = rml_builder.reserve_members(size);
+                osmium::object_id_type ref = 1;
+                for (const auto& member : test_members) {
+                    target = osmium::builder::RelationMemberListBuilder::write_member(target, member.first, ref++, member.second.data(), member.second.size());
+                }
+            } else {
+                osmium::object_id_type ref = 1;
+                for (const auto& member : test_members) {
+                    rml_builder.add_member(member.first, ref++, member.second);
+                }
+            }
+        }
+        buffer.commit();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Reserving space for node refs and tags at once gives the same way") {
+    osmium::memory::Buffer buffer1{1024 * 10};
+    osmium::memory::Buffer buffer2{1024 * 10};
+    build_way(buffer1, false);
+    build_way(buffer2, true);
+
+    REQUIRE(buffer1.committed() == buffer2.committed());
+    REQUIRE(std::equal(buffer1.data(), buffer1.data() + buffer1.committed(), buffer2.data()));
+
+    const auto& way = buffer2.get<osmium::Way>(0);
+    REQUIRE(way.nodes().size() == 3);
+    REQUIRE(way.nodes()[1].location() == osmium::Location(1.0, 2.0));
+    REQUIRE(way.tags().size() == 3);
+    REQUIRE(std::string{way.tags().get_value_by_key("x")} == "a somewhat longer value");
+}
+
+TEST_CASE("Reserving space for members at once gives the same relation") {
+    osmium::memory::Buffer buffer1{1024 * 10};
+    osmium::memory::Buffer buffer2{1024 * 10};
+    build_relation(buffer1, false);
+    build_relation(buffer2, true);
+
+    REQUIRE(buffer1.committed() == buffer2.committed());
+    REQUIRE(std::equal(buffer1.data(), buffer1.data() + buffer1.committed(), buffer2.data()));
+
+    const auto& relation = buffer2.get<osmium::Relation>(0);
+    REQUIRE(relation.members().size() == 3);
+    auto it = relation.members().begin();
+    REQUIRE(std::string{it->role()} == "outer");
+    ++it;
+    REQUIRE(std::string{it->role()} == "");
+    ++it;
+    REQUIRE(it->type() == osmium::item_type::relation);
+    REQUIRE(it->ref() == 3);
+    REQUIRE(std::string{it->role()} == "subarea1");
+}
+
+TEST_CASE("Tag size checks length of key and value") {
+    REQUIRE(osmium::builder::TagListBuilder::tag_size(1, 2) == 5);
+    REQUIRE_THROWS_AS(osmium::builder::TagListBuilder::tag_size(osmium::max_osm_string_length + 1, 2), const std::length_error&);
+    REQUIRE_THROWS_AS(osmium::builder::RelationMemberListBuilder::member_size(osmium::max_osm_string_length + 1), const std::length_error&);
+}
+
+TEST_CASE("copy_attributes copies all attributes and the user") {
+    osmium::memory::Buffer buffer{1024 * 10};
+    const std::string user = "a user name which is longer than the minimum size";
+
+    {
+        osmium::builder::NodeBuilder builder{buffer};
+        builder.set_id(17)
+            .set_visible(true)
+            .set_version(3)
+            .set_changeset(123)
+            .set_uid(555)
+            .set_timestamp("2015-07-01T00:00:01Z")
+            .set_location(osmium::Location{1.2, 3.4})
+            .set_user(user);
+        builder.add_tags({{"highway", "primary"}, {"oneway", "yes"}});
+    }
+    const auto& node = buffer.get<osmium::Node>(buffer.commit());
+
+    osmium::memory::Buffer out{1024 * 10};
+    {
+        osmium::builder::NodeBuilder builder{out};
+        builder.copy_attributes(node);
+        builder.add_tags({{"highway", "primary"}, {"oneway", "yes"}});
+    }
+    const auto& copy = out.get<osmium::Node>(out.commit());
+
+    REQUIRE(out.committed() == buffer.committed());
+    REQUIRE(std::equal(buffer.data(), buffer.data() + buffer.committed(), out.data()));
+    REQUIRE(copy.id() == 17);
+    REQUIRE(copy.version() == 3);
+    REQUIRE(copy.location() == osmium::Location(1.2, 3.4));
+    REQUIRE(user == copy.user());
+}
+
+TEST_CASE("copy_with_new_tags") {
+    osmium::memory::Buffer buffer{1024 * 10};
+    osmium::memory::Buffer out{1024 * 10};
+
+    const auto rewrite = [](const osmium::TagList& tags, osmium::builder::TagListBuilder& builder) {
+        for (const auto& tag : tags) {
+            if (std::strcmp(tag.key(), "created_by")) {
+                builder.add_tag(tag);
+            }
+        }
+        builder.add_tag("new", "tag");
+    };
+
+    SECTION("node") {
+        {
+            osmium::builder::NodeBuilder builder{buffer};
+            builder.set_id(1).set_version(2).set_user("foo").set_location(osmium::Location{1.0, 2.0});
+            builder.add_tags({{"created_by", "x"}, {"amenity", "bench"}});
+        }
+        const auto& node = buffer.get<osmium::Node>(buffer.commit());
+
+        const auto& copy = out.get<osmium::Node>(osmium::builder::copy_with_new_tags(out, node, rewrite));
+        REQUIRE(copy.id() == 1);
+        REQUIRE(copy.version() == 2);
+        REQUIRE(std::string{"foo"} == copy.user());
+        REQUIRE(copy.location() == osmium::Location(1.0, 2.0));
+        REQUIRE(copy.tags().size() == 2);
+        REQUIRE(std::string{"bench"} == copy.tags()["amenity"]);
+        REQUIRE(std::string{"tag"} == copy.tags()["new"]);
+        REQUIRE_FALSE(copy.tags().has_key("created_by"));
+    }
+
+    SECTION("way") {
+        {
+            osmium::builder::WayBuilder builder{buffer};
+            builder.set_id(2).set_user("a somewhat longer user name");
+            builder.add_tags({{"created_by", "x"}, {"highway", "primary"}});
+            builder.add_node_refs({{1, osmium::Location{1.0, 1.0}}, {2, osmium::Location{2.0, 2.0}}, 3});
+        }
+        const auto& way = buffer.get<osmium::Way>(buffer.commit());
+
+        const auto& copy = out.get<osmium::Way>(osmium::builder::copy_with_new_tags(out, way, rewrite));
+        REQUIRE(copy.id() == 2);
+        REQUIRE(std::string{"a somewhat longer user name"} == copy.user());
+        REQUIRE(copy.nodes().size() == 3);
+        REQUIRE(copy.nodes()[1].ref() == 2);
+        REQUIRE(copy.nodes()[1].location() == osmium::Location(2.0, 2.0));
+        REQUIRE(copy.tags().size() == 2);
+        REQUIRE(std::string{"primary"} == copy.tags()["highway"]);
+    }
+
+    SECTION("relation") {
+        {
+            osmium::builder::RelationBuilder builder{buffer};
+            builder.set_id(3);
+            {
+                osmium::builder::RelationMemberListBuilder rml_builder{builder};
+                rml_builder.add_member(osmium::item_type::way, 10, "outer");
+                rml_builder.add_member(osmium::item_type::way, 11, "inner");
+            }
+            builder.add_tags({{"type", "multipolygon"}});
+        }
+        const auto& relation = buffer.get<osmium::Relation>(buffer.commit());
+
+        const auto& copy = out.get<osmium::Relation>(osmium::builder::copy_with_new_tags(out, relation, rewrite));
+        REQUIRE(copy.id() == 3);
+        REQUIRE(copy.members().size() == 2);
+        REQUIRE(std::string{"inner"} == std::next(copy.members().begin())->role());
+        REQUIRE(copy.tags().size() == 2);
+        REQUIRE(std::string{"multipolygon"} == copy.tags()["type"]);
+    }
+}
@@ -0,0 +1,119 @@
+#include "catch.hpp"
+
+#include <osmium/experimental/flex_reader.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <string>
+
+using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+namespace {
+
+    // Many nodes and ways in a grid with one closed way tagged as
+    // building and a multipolygon relation made from four ways.
+    std::string generate_data(int size) {
+        std::string data;
+        for (int x = 0; x < size; ++x) {
+            for (int y = 0; y < size; ++y) {
+                data += "n" + std::to_string(x * size + y + 1) + " x" + std::to_string(x * 0.001) + " y" + std::to_string(y * 0.001) + "\n";
+            }
+        }
+        for (int x = 0; x < size; ++x) {
+            data += "w" + std::to_string(x + 1) + " Thighway=residential N";
+            for (int y = 0; y < size; ++y) {
+                data += (y == 0 ? "n" : ",n") + std::to_string(x * size + y + 1);
+            }
+            data += "\n";
+        }
+        data += "w100001 Tbuilding=yes Nn1,n2,n" + std::to_string(size + 2) + ",n" + std::to_string(size + 1) + ",n1\n";
+        data += "w100002 Nn1,n3\n";
+        data += "w100003 Nn3,n" + std::to_string(2 * size + 3) + "\n";
+        data += "w100004 Nn" + std::to_string(2 * size + 3) + ",n" + std::to_string(2 * size + 1) + "\n";
+        data += "w100005 Nn" + std::to_string(2 * size + 1) + ",n1\n";
+        data += "r1 Ttype=multipolygon,landuse=forest Mw100002@outer,w100003@outer,w100004@outer,w100005@outer\n";
+        return data;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Flex reader adds locations and assembles areas") {
+    const int size = 200;
+    const std::string data = generate_data(size);
+    const osmium::io::File file{data.data(), data.size(), "opl"};
+
+    osmium::thread::Pool pool{2};
+    index_type index;
+    location_handler_type location_handler{index};
+    osmium::experimental::FlexReader<location_handler_type> reader{file, location_handler, osmium::osm_entity_bits::nwra, pool};
+
+    int buffers = 0;
+    int ways = 0;
+    int areas = 0;
+    osmium::object_id_type last_way_id = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        ++buffers;
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            // ways are returned in order
+            REQUIRE(way.id() > last_way_id);
+            last_way_id = way.id();
+            for (const auto& nr : way.nodes()) {
+                REQUIRE(nr.location().valid());
+                REQUIRE(nr.location() == index.get(static_cast<osmium::unsigned_object_id_type>(nr.ref())));
+            }
+            ++ways;
+        }
+        for (const auto& area : buffer.select<osmium::Area>()) {
+            REQUIRE(area.num_rings().first == 1);
+            ++areas;
+        }
+    }
+    REQUIRE(reader.eof());
+    reader.close();
+
+    REQUIRE(buffers > 1);
+    REQUIRE(ways == size + 5);
+    REQUIRE(areas == 2);
+}
+
+TEST_CASE("Flex reader without areas") {
+    const std::string data = generate_data(10);
+    const osmium::io::File file{data.data(), data.size(), "opl"};
+
+    index_type index;
+    location_handler_type location_handler{index};
+    osmium::experimental::FlexReader<location_handler_type> reader{file, location_handler};
+    REQUIRE_FALSE(reader.eof());
+
+    int ways = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            REQUIRE(way.nodes().front().location().valid());
+            ++ways;
+        }
+        REQUIRE(buffer.select<osmium::Area>().empty());
+    }
+    REQUIRE(ways == 15);
+    REQUIRE(reader.eof());
+    reader.close();
+}
+
+TEST_CASE("Flex reader closed early") {
+    const std::string data = generate_data(100);
+    const osmium::io::File file{data.data(), data.size(), "opl"};
+
+    index_type index;
+    location_handler_type location_handler{index};
+    osmium::experimental::FlexReader<location_handler_type> reader{file, location_handler};
+    REQUIRE(reader.read());
+    reader.close();
+    REQUIRE(reader.eof());
+}
@@ -0,0 +1,119 @@
+#include "catch.hpp"
+
+#include "area_helper.hpp"
+
+#include <osmium/geom/area_index.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+static void add_test_areas(osmium::memory::Buffer& buffer) {
+    osmium::builder::add_area(buffer,
+        _id(2),
+        _tag("boundary", "administrative"),
+        _outer_ring({
+            {1, {0.0, 0.0}},
+            {2, {10.0, 0.0}},
+            {3, {10.0, 10.0}},
+            {4, {0.0, 10.0}},
+            {1, {0.0, 0.0}}
+        }),
+        _inner_ring({
+            {5, {1.0, 1.0}},
+            {6, {2.0, 1.0}},
+            {7, {2.0, 2.0}},
+            {8, {1.0, 2.0}},
+            {5, {1.0, 1.0}}
+        })
+    );
+    osmium::builder::add_area(buffer,
+        _id(5),
+        _tag("landuse", "forest"),
+        _outer_ring({
+            {10, {5.0, 5.0}},
+            {11, {15.0, 5.0}},
+            {12, {10.0, 15.0}},
+            {10, {5.0, 5.0}}
+        })
+    );
+    osmium::builder::add_area(buffer,
+        _id(7),
+        _outer_ring({
+            {20, {5.0, 5.0}},
+            {21, osmium::Location{}},
+            {22, {6.0, 6.0}},
+            {20, {5.0, 5.0}}
+        })
+    );
+}
+
+TEST_CASE("AreaIndex built from buffer") {
+    osmium::memory::Buffer buffer{10000};
+    add_test_areas(buffer);
+
+    osmium::geom::AreaIndex index{16};
+    REQUIRE(index.add(buffer) == 2);
+    REQUIRE_FALSE(index.built());
+    index.build();
+    REQUIRE(index.built());
+    buffer.clear();
+
+    REQUIRE(index.size() == 2);
+    REQUIRE(index.area_id(0) == 2);
+    REQUIRE(index.area_id(1) == 5);
+
+    std::vector<std::size_t> areas;
+    index.get_containing(osmium::Location{0.5, 0.5}, areas);
+    REQUIRE(areas == std::vector<std::size_t>{0});
+
+    index.get_containing(osmium::Location{1.5, 1.5}, areas);
+    REQUIRE(areas.empty());
+
+    index.get_containing(osmium::Location{8.0, 7.0}, areas);
+    REQUIRE(areas == (std::vector<std::size_t>{0, 1}));
+
+    index.get_containing(osmium::Location{12.0, 6.0}, areas);
+    REQUIRE(areas == std::vector<std::size_t>{1});
+
+    osmium::memory::Buffer buffer2{10000};
+    REQUIRE_THROWS_AS(index.add(create_test_area_1outer_0inner(buffer2)), const std::logic_error&);
+}
+
+TEST_CASE("AreaIndex parallel queries give the same results") {
+    osmium::memory::Buffer buffer{10000};
+    add_test_areas(buffer);
+
+    osmium::geom::AreaIndex index{8};
+    index.add(buffer);
+    index.build();
+
+    std::vector<osmium::Location> locations;
+    for (int ix = -20; ix <= 160; ++ix) {
+        for (int iy = -20; iy <= 160; iy += 7) {
+            locations.emplace_back(ix * 0.1 + 0.003, iy * 0.1 + 0.001);
+        }
+    }
+    locations.emplace_back();
+
+    osmium::thread::Pool pool{3};
+    const auto results = index.get_containing(pool, locations);
+    REQUIRE(results.size() == locations.size());
+
+    std::vector<std::size_t> expected;
+    std::size_t count = 0;
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        index.get_containing(locations[n], expected);
+        REQUIRE(results[n] == expected);
+        count += expected.size();
+    }
+    REQUIRE(count > 0);
+
+    std::atomic<std::size_t> calls{0};
+    index.for_each_containing(pool, locations, [&calls](std::size_t /*n*/, std::size_t /*area*/) {
+        ++calls;
+    });
+    REQUIRE(calls == count);
+}
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/caching_projection.hpp>
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/wkt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    class CountingProjection {
+
+        int* m_count;
+
+    public:
+
+        explicit CountingProjection(int* count) :
+            m_count(count) {
+        }
+
+        osmium::geom::Coordinates operator()(osmium::Location location) const {
+            ++*m_count;
+            return osmium::geom::Coordinates{location.lon() * 2, location.lat() * 2};
+        }
+
+        static int epsg() noexcept {
+            return 1234;
+        }
+
+        static std::string proj_string() noexcept {
+            return "+proj=counting";
+        }
+
+    }; // class CountingProjection
+
+} // anonymous namespace
+
+TEST_CASE("Caching projection only projects a location once") {
+    int count = 0;
+    const osmium::geom::CachingProjection<CountingProjection> projection{CountingProjection{&count}, 1000};
+    REQUIRE(projection.cache_size() == 1024);
+    REQUIRE(projection.epsg() == 1234);
+    REQUIRE(projection.proj_string() == "+proj=counting");
+
+    const osmium::Location loc{1.5, 2.5};
+    auto c = projection(loc);
+    REQUIRE(c.x == Approx(3.0));
+    REQUIRE(c.y == Approx(5.0));
+    c = projection(loc);
+    REQUIRE(c.x == Approx(3.0));
+    REQUIRE(c.y == Approx(5.0));
+
+    REQUIRE(count == 1);
+    REQUIRE(projection.hits() == 1);
+    REQUIRE(projection.misses() == 1);
+
+    REQUIRE_THROWS_AS(projection(osmium::Location{}), const osmium::invalid_location&);
+    REQUIRE_THROWS_AS(projection(osmium::Location{}), const osmium::invalid_location&);
+    REQUIRE(count == 3);
+    REQUIRE(projection.misses() == 1);
+}
+
+TEST_CASE("Caching projection with colliding locations") {
+    int count = 0;
+    osmium::geom::CachingProjection<CountingProjection> projection{CountingProjection{&count}, 1};
+    REQUIRE(projection.cache_size() == 1);
+
+    const osmium::Location loc1{1.0, 2.0};
+    const osmium::Location loc2{3.0, 4.0};
+    REQUIRE(projection(loc1).x == Approx(2.0));
+    REQUIRE(projection(loc2).x == Approx(6.0));
+    REQUIRE(projection(loc1).x == Approx(2.0));
+    REQUIRE(count == 3);
+
+    projection.clear();
+    REQUIRE(projection.hits() == 0);
+    REQUIRE(projection(loc1).x == Approx(2.0));
+    REQUIRE(count == 4);
+}
+
+TEST_CASE("Geometry factory with caching projection") {
+    int count = 0;
+    using projection_type = osmium::geom::CachingProjection<CountingProjection>;
+    osmium::geom::WKTFactory<projection_type> factory{projection_type{CountingProjection{&count}}};
+    REQUIRE(factory.epsg() == 1234);
+
+    osmium::memory::Buffer buffer{1000};
+    const auto pos1 = osmium::builder::add_way(buffer, _nodes({{1, {1.0, 1.0}}, {2, {2.0, 1.0}}, {3, {2.0, 2.0}}}));
+    const auto pos2 = osmium::builder::add_way(buffer, _nodes({{3, {2.0, 2.0}}, {4, {3.0, 2.0}}, {1, {1.0, 1.0}}}));
+
+    REQUIRE(factory.create_linestring(buffer.get<osmium::Way>(pos1)) == "LINESTRING(2 2,4 2,4 4)");
+    REQUIRE(factory.create_linestring(buffer.get<osmium::Way>(pos2)) == "LINESTRING(4 4,6 4,2 2)");
+    REQUIRE(count == 4);
+    REQUIRE(factory.projection().hits() == 2);
+    REQUIRE(factory.projection().misses() == 4);
+}
+
+TEST_CASE("Caching projection gives same result as underlying projection") {
+    osmium::geom::WKTFactory<osmium::geom::MercatorProjection> factory{2};
+    osmium::geom::WKTFactory<osmium::geom::CachingProjection<osmium::geom::MercatorProjection>> caching_factory{2};
+    REQUIRE(caching_factory.epsg() == 3857);
+
+    for (int i = 0; i < 2; ++i) {
+        const osmium::Location loc{3.2, 4.2};
+        REQUIRE(caching_factory.create_point(loc) == factory.create_point(loc));
+    }
+    REQUIRE(caching_factory.projection().hits() == 1);
+}
@@ -0,0 +1,94 @@
+#include "catch.hpp"
+
+#include "wnl_helper.hpp"
+
+#include <osmium/geom/fixed_point.hpp>
+#include <osmium/geom/haversine.hpp>
+
+#include <cmath>
+
+namespace fp = osmium::geom::fixed_point;
+
+TEST_CASE("Fixed point orientation") {
+    const osmium::Location a{0.0, 0.0};
+    const osmium::Location b{1.0, 0.0};
+    const osmium::Location c{1.0, 1.0};
+
+    REQUIRE(fp::orientation(a, b, c) == 1);
+    REQUIRE(fp::orientation(a, c, b) == -1);
+    REQUIRE(fp::orientation(a, b, osmium::Location{2.0, 0.0}) == 0);
+    REQUIRE(fp::cross(a, b, c) == 10000000LL * 10000000LL);
+}
+
+TEST_CASE("Fixed point orientation is exact for large coordinates") {
+    const osmium::Location a{-180.0, -90.0};
+    const osmium::Location b{180.0, 90.0};
+    REQUIRE(fp::orientation(a, b, osmium::Location{0.0, 0.0}) == 0);
+    REQUIRE(fp::orientation(a, b, osmium::Location{int32_t(1), int32_t(0)}) == -1);
+    REQUIRE(fp::orientation(a, b, osmium::Location{int32_t(-1), int32_t(0)}) == 1);
+}
+
+TEST_CASE("Fixed point bounding box overlap") {
+    const osmium::Location p0{0.0, 0.0};
+    const osmium::Location p1{1.0, 1.0};
+
+    REQUIRE(fp::boxes_overlap(p0, p1, osmium::Location{0.5, 2.0}, osmium::Location{0.6, 0.5}));
+    REQUIRE(fp::boxes_overlap(p0, p1, osmium::Location{1.0, 1.0}, osmium::Location{2.0, 2.0}));
+    REQUIRE_FALSE(fp::boxes_overlap(p0, p1, osmium::Location{1.5, 0.0}, osmium::Location{2.0, 1.0}));
+    REQUIRE_FALSE(fp::boxes_overlap(p0, p1, osmium::Location{0.0, 1.5}, osmium::Location{1.0, 2.0}));
+}
+
+TEST_CASE("Fixed point segment intersection") {
+    const osmium::Location p0{0.0, 0.0};
+    const osmium::Location p1{2.0, 2.0};
+
+    // crossing
+    REQUIRE(fp::segments_intersect(p0, p1, osmium::Location{0.0, 2.0}, osmium::Location{2.0, 0.0}));
+
+    // touching in an end point
+    REQUIRE(fp::segments_intersect(p0, p1, osmium::Location{1.0, 1.0}, osmium::Location{2.0, 0.0}));
+    REQUIRE(fp::segments_intersect(p0, p1, p1, osmium::Location{3.0, 0.0}));
+
+    // collinear and overlapping / disjoint
+    REQUIRE(fp::segments_intersect(p0, p1, osmium::Location{1.0, 1.0}, osmium::Location{3.0, 3.0}));
+    REQUIRE_FALSE(fp::segments_intersect(p0, p1, osmium::Location{3.0, 3.0}, osmium::Location{4.0, 4.0}));
+
+    // end point on the extension of the other segment
+    REQUIRE_FALSE(fp::segments_intersect(p0, p1, osmium::Location{3.0, 3.0}, osmium::Location{1.5, 4.0}));
+
+    // boxes overlap but segments don't
+    REQUIRE_FALSE(fp::segments_intersect(p0, p1, osmium::Location{1.5, 0.0}, osmium::Location{2.0, 1.0}));
+
+    // parallel
+    REQUIRE_FALSE(fp::segments_intersect(p0, p1, osmium::Location{0.0, 1.0}, osmium::Location{1.0, 2.0}));
+}
+
+TEST_CASE("Fixed point approximate distance is close to haversine") {
+    for (const double lat : {-70.0, -30.0, 0.0, 10.0, 47.0, 60.0, 75.0}) {
+        for (const double d : {0.0001, 0.001, 0.01, 0.05}) {
+            const osmium::Location a{8.0, lat};
+            const osmium::Location b{8.0 + d, lat + d / 2};
+            const double expected = osmium::geom::haversine::distance(osmium::geom::Coordinates{a}, osmium::geom::Coordinates{b});
+            const double result = fp::approximate_distance(a, b);
+            INFO("lat " << lat << " d " << d);
+            REQUIRE(std::abs(result - expected) < expected * 1e-4);
+        }
+    }
+
+    const osmium::Location a{1.0, 2.0};
+    REQUIRE(fp::approximate_distance(a, a) == Approx(0.0));
+}
+
+TEST_CASE("Fixed point approximate length of a way") {
+    osmium::memory::Buffer buffer{10000};
+    const auto& wnl = create_test_wnl_okay(buffer);
+
+    const double expected = osmium::geom::haversine::distance(wnl);
+    REQUIRE(fp::approximate_length(wnl) == Approx(expected).epsilon(1e-4));
+}
+
+TEST_CASE("Fixed point approximate length with invalid location") {
+    osmium::memory::Buffer buffer{10000};
+    const auto& wnl = create_test_wnl_undefined_location(buffer);
+    REQUIRE_THROWS_AS(fp::approximate_length(wnl), const osmium::invalid_location&);
+}
@@ -0,0 +1,80 @@
+#include "catch.hpp"
+
+#include "wnl_helper.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/geom/way_lengths.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <iterator>
+#include <vector>
+
+TEST_CASE("Haversine distance between coordinates") {
+    const osmium::geom::Coordinates a{0.0, 0.0};
+    const osmium::geom::Coordinates b{1.0, 0.0};
+    REQUIRE(osmium::geom::haversine::distance(a, a) == Approx(0.0));
+    REQUIRE(osmium::geom::haversine::distance(a, b) == Approx(111226.3).epsilon(1e-6));
+    REQUIRE(osmium::geom::haversine::distance(a, b) == osmium::geom::haversine::distance(b, a));
+}
+
+TEST_CASE("Haversine segment distances of a way node list") {
+    osmium::memory::Buffer buffer{10000};
+    const auto& wnl = create_test_wnl_okay(buffer);
+
+    const auto lengths = osmium::geom::haversine::segment_distances(wnl);
+    REQUIRE(lengths.size() == 3);
+    double sum = 0.0;
+    for (std::size_t i = 0; i < lengths.size(); ++i) {
+        const osmium::geom::Coordinates c1{wnl[i].location()};
+        const osmium::geom::Coordinates c2{wnl[i + 1].location()};
+        REQUIRE(lengths[i] == Approx(osmium::geom::haversine::distance(c1, c2)));
+        sum += lengths[i];
+    }
+    REQUIRE(lengths[1] == Approx(0.0));
+    REQUIRE(osmium::geom::haversine::distance(wnl) == Approx(sum));
+
+    std::vector<double> out;
+    osmium::geom::haversine::segment_distances(wnl, std::back_inserter(out));
+    REQUIRE(out == lengths);
+}
+
+TEST_CASE("Haversine segment distances of short way node lists") {
+    osmium::memory::Buffer buffer{10000};
+
+    SECTION("empty") {
+        const auto& wnl = create_test_wnl_empty(buffer);
+        REQUIRE(osmium::geom::haversine::segment_distances(wnl).empty());
+        REQUIRE(osmium::geom::haversine::distance(wnl) == Approx(0.0));
+    }
+
+    SECTION("undefined location") {
+        const auto& wnl = create_test_wnl_undefined_location(buffer);
+        REQUIRE_THROWS_AS(osmium::geom::haversine::segment_distances(wnl), const osmium::invalid_location&);
+        REQUIRE_THROWS_AS(osmium::geom::haversine::distance(wnl), const osmium::invalid_location&);
+    }
+}
+
+TEST_CASE("Haversine lengths of all ways in a buffer") {
+    osmium::memory::Buffer buffer{10000, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<double> expected;
+    for (int i = 0; i < 100; ++i) {
+        const double d = 0.001 * i;
+        osmium::builder::add_node(buffer, _id(i + 1), _location(d, d));
+        const auto pos = osmium::builder::add_way(buffer, _id(i + 1), _nodes({
+            {1, {1.0, 2.0}},
+            {2, {1.0 + d, 2.0}},
+            {3, {1.0 + d, 2.0 + d}}
+        }));
+        expected.push_back(osmium::geom::haversine::distance(buffer.get<osmium::Way>(pos).nodes()));
+    }
+
+    osmium::thread::Pool pool{2};
+    const auto lengths = osmium::geom::haversine::way_lengths(buffer, pool);
+    REQUIRE(lengths == expected);
+    REQUIRE(lengths[0] == Approx(0.0));
+    REQUIRE(lengths[99] > lengths[98]);
+
+    REQUIRE(osmium::geom::haversine::way_lengths(osmium::memory::Buffer{1024}, pool).empty());
+}
@@ -0,0 +1,52 @@
+#include "catch.hpp"
+
+#include <osmium/geom/hilbert.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include <vector>
+
+TEST_CASE("Hilbert index of corners") {
+    REQUIRE(osmium::geom::hilbert_index(0, 0) == 0);
+    REQUIRE(osmium::geom::hilbert_index(0, 0xffffffffU) > 0);
+    REQUIRE(osmium::geom::hilbert_index(0xffffffffU, 0) == std::numeric_limits<uint64_t>::max());
+}
+
+TEST_CASE("Hilbert curve visits neighbouring cells in order") {
+    // 16x16 grid of cells using the highest bits of the coordinates
+    const int n = 16;
+    const uint32_t shift = 28;
+
+    std::vector<std::pair<uint64_t, std::pair<int, int>>> cells;
+    for (int x = 0; x < n; ++x) {
+        for (int y = 0; y < n; ++y) {
+            const auto index = osmium::geom::hilbert_index(static_cast<uint32_t>(x) << shift, static_cast<uint32_t>(y) << shift);
+            cells.emplace_back(index, std::make_pair(x, y));
+        }
+    }
+    std::sort(cells.begin(), cells.end());
+
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        REQUIRE(cells[i].first >> (2 * shift) == static_cast<uint64_t>(i));
+        if (i > 0) {
+            const auto& a = cells[i - 1].second;
+            const auto& b = cells[i].second;
+            REQUIRE(std::abs(a.first - b.first) + std::abs(a.second - b.second) == 1);
+        }
+    }
+}
+
+TEST_CASE("Hilbert index of locations") {
+    const osmium::Location a{9.0, 49.0};
+    const osmium::Location b{9.0001, 49.0001};
+    const osmium::Location c{-120.0, -30.0};
+
+    REQUIRE(osmium::geom::hilbert_index(a) != osmium::geom::hilbert_index(b));
+    REQUIRE(osmium::geom::hilbert_index(a) >> 40U == osmium::geom::hilbert_index(b) >> 40U);
+    REQUIRE(osmium::geom::hilbert_index(a) >> 40U != osmium::geom::hilbert_index(c) >> 40U);
+    REQUIRE(osmium::geom::hilbert_index(osmium::Location{}) == std::numeric_limits<uint64_t>::max());
+}
@@ -1,6 +1,13 @@
 #include "catch.hpp"
 
+#include "wnl_helper.hpp"
+
 #include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/wkt.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
 
 TEST_CASE("Mercator projection") {
     const osmium::geom::MercatorProjection projection;
@@ -32,3 +39,76 @@ TEST_CASE("Mercator bounds") {
     REQUIRE(osmium::geom::detail::y_to_lat(osmium::geom::detail::lon_to_x(180.0)) == Approx(osmium::geom::MERCATOR_MAX_LAT).epsilon(0.0000001));
 }
 
+
+TEST_CASE("Mercator projection of many locations at once") {
+    std::vector<osmium::Location> locations;
+    for (int lat = -85; lat <= 85; lat += 5) {
+        locations.emplace_back(lat * 2.1, lat + 0.3);
+    }
+    locations.emplace_back(180.0, osmium::geom::MERCATOR_MAX_LAT);
+    locations.emplace_back(-180.0, -osmium::geom::MERCATOR_MAX_LAT);
+    locations.emplace_back(0.0, 78.0);
+    locations.emplace_back(0.0, -78.0);
+
+    const osmium::geom::MercatorProjection projection;
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    projection(locations.data(), coordinates.data(), locations.size());
+
+    for (std::size_t i = 0; i < locations.size(); ++i) {
+        const auto c = projection(locations[i]);
+        REQUIRE(coordinates[i].x == c.x);
+        REQUIRE(coordinates[i].y == c.y);
+    }
+
+    projection(locations.data(), coordinates.data(), 0);
+
+    locations.emplace_back();
+    coordinates.resize(locations.size());
+    REQUIRE_THROWS_AS(projection(locations.data(), coordinates.data(), locations.size()), const osmium::invalid_location&);
+}
+
+// Coordinates of the location in web mercator as they appear in WKT.
+static std::string wkt_coordinates(const osmium::Location& location) {
+    const osmium::geom::WKTFactory<osmium::geom::MercatorProjection> factory{2};
+    const std::string point{factory.create_point(location)};
+    return point.substr(6, point.size() - 7);
+}
+
+TEST_CASE("Geometry factory with mercator projection") {
+    osmium::geom::WKTFactory<osmium::geom::MercatorProjection> factory{2};
+    osmium::memory::Buffer buffer{10000};
+
+    SECTION("linestring") {
+        const auto& wnl = create_test_wnl_okay(buffer);
+        const auto a = wkt_coordinates(wnl[0].location());
+        const auto b = wkt_coordinates(wnl[1].location());
+        const auto c = wkt_coordinates(wnl[3].location());
+        REQUIRE(factory.create_linestring(wnl) == "LINESTRING(" + a + "," + b + "," + c + ")");
+        REQUIRE(factory.create_linestring(wnl, osmium::geom::use_nodes::all, osmium::geom::direction::backward) ==
+                "LINESTRING(" + c + "," + b + "," + b + "," + a + ")");
+    }
+
+    SECTION("polygon") {
+        const auto& wnl = create_test_wnl_closed(buffer);
+        std::string expected{"POLYGON(("};
+        for (const auto& node_ref : wnl) {
+            expected += wkt_coordinates(node_ref.location());
+            expected += ',';
+        }
+        expected.back() = ')';
+        expected += ')';
+        REQUIRE(factory.create_polygon(wnl, osmium::geom::use_nodes::all) == expected);
+    }
+
+    SECTION("linestring with two same locations") {
+        const auto& wnl = create_test_wnl_same_location(buffer);
+        const auto a = wkt_coordinates(wnl[0].location());
+        REQUIRE_THROWS_AS(factory.create_linestring(wnl), const osmium::geometry_error&);
+        REQUIRE(factory.create_linestring(wnl, osmium::geom::use_nodes::all) == "LINESTRING(" + a + "," + a + ")");
+    }
+
+    SECTION("linestring with undefined location") {
+        const auto& wnl = create_test_wnl_undefined_location(buffer);
+        REQUIRE_THROWS_AS(factory.create_linestring(wnl), const osmium::invalid_location&);
+    }
+}
@@ -0,0 +1,75 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/pipeline.hpp>
+#include <osmium/geom/wkt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <deque>
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_ways(int first) {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int id = first; id < first + 100; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _location(id / 100.0, 1.0));
+        osmium::builder::add_way(buffer, _id(id), _nodes({
+            {1, {id / 100.0, 1.0}},
+            {2, {id / 100.0, 2.0}}
+        }));
+    }
+
+    // way with too few points and way with invalid location
+    osmium::builder::add_way(buffer, _id(first + 1000), _nodes({{1, {1.0, 1.0}}}));
+    osmium::builder::add_way(buffer, _id(first + 1001), _nodes({{1, {1.0, 1.0}}, {2, osmium::Location{}}}));
+
+    return buffer;
+}
+
+TEST_CASE("Create geometries with GeometryPipeline") {
+    osmium::thread::Pool pool{2};
+    const osmium::geom::WKTFactory<> factory;
+
+    SECTION("ways") {
+        osmium::geom::GeometryPipeline<osmium::geom::WKTFactory<>> pipeline{factory, osmium::osm_entity_bits::way, pool};
+
+        std::deque<decltype(pipeline)::future_type> futures;
+        for (int first = 0; first < 1000; first += 100) {
+            futures.push_back(pipeline.submit(create_ways(first)));
+        }
+
+        // Compare with geometries created inline
+        osmium::geom::WKTFactory<> inline_factory;
+        int id = 0;
+        for (auto& future : futures) {
+            const auto result = future.get();
+            REQUIRE(result.size() == 100);
+            const auto buffer = create_ways(id);
+            auto it = buffer.select<osmium::Way>().cbegin();
+            for (const auto& geom : result) {
+                REQUIRE(geom.type == osmium::item_type::way);
+                REQUIRE(geom.id == id);
+                REQUIRE(geom.geometry == inline_factory.create_linestring(*it));
+                ++it;
+                ++id;
+            }
+        }
+        REQUIRE(id == 1000);
+    }
+
+    SECTION("nodes and ways") {
+        osmium::geom::GeometryPipeline<osmium::geom::WKTFactory<>> pipeline{factory, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way, pool};
+
+        const auto result = pipeline.submit(create_ways(0)).get();
+        REQUIRE(result.size() == 200);
+        REQUIRE(result[0].type == osmium::item_type::node);
+        REQUIRE(result[0].geometry == "POINT(0 1)");
+        REQUIRE(result[1].type == osmium::item_type::way);
+        REQUIRE(result[1].geometry == "LINESTRING(0 1,0 2)");
+    }
+}
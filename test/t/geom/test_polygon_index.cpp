@@ -0,0 +1,191 @@
+#include "catch.hpp"
+
+#include "area_helper.hpp"
+
+#include <osmium/geom/polygon_index.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("ExtractPolygon from box") {
+    const osmium::geom::ExtractPolygon polygon{osmium::Box{1.0, 2.0, 3.0, 4.0}};
+    REQUIRE_FALSE(polygon.empty());
+    REQUIRE(polygon.envelope() == (osmium::Box{1.0, 2.0, 3.0, 4.0}));
+    REQUIRE(polygon.contains(osmium::Location{2.0, 3.0}));
+    REQUIRE(polygon.contains(osmium::Location{1.0, 2.0}));
+    REQUIRE(polygon.contains(osmium::Location{3.0, 4.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{0.5, 3.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{2.0, 4.5}));
+}
+
+TEST_CASE("ExtractPolygon from invalid box") {
+    REQUIRE_THROWS_AS(osmium::geom::ExtractPolygon{osmium::Box{}}, const std::invalid_argument&);
+}
+
+TEST_CASE("ExtractPolygon from rings") {
+    osmium::geom::ExtractPolygon polygon;
+    REQUIRE(polygon.empty());
+    REQUIRE_FALSE(polygon.contains(osmium::Location{0.0, 0.0}));
+
+    // triangle, ring is closed automatically
+    polygon.add_ring({osmium::Location{0.0, 0.0}, osmium::Location{4.0, 0.0}, osmium::Location{0.0, 4.0}});
+    REQUIRE(polygon.rings().size() == 1);
+    REQUIRE(polygon.rings()[0].size() == 4);
+    REQUIRE(polygon.contains(osmium::Location{1.0, 1.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{3.0, 3.0}));
+
+    SECTION("hole") {
+        polygon.add_ring({osmium::Location{0.5, 0.5}, osmium::Location{1.5, 0.5}, osmium::Location{1.5, 1.5}, osmium::Location{0.5, 1.5}});
+        REQUIRE_FALSE(polygon.contains(osmium::Location{1.0, 1.0}));
+        REQUIRE(polygon.contains(osmium::Location{0.2, 0.2}));
+        REQUIRE(polygon.contains(osmium::Location{2.0, 1.0}));
+    }
+
+    SECTION("invalid rings") {
+        REQUIRE_THROWS_AS(polygon.add_ring({osmium::Location{0.0, 0.0}, osmium::Location{1.0, 1.0}}), const std::invalid_argument&);
+        REQUIRE_THROWS_AS(polygon.add_ring({osmium::Location{0.0, 0.0}, osmium::Location{}, osmium::Location{1.0, 1.0}}), const std::invalid_argument&);
+    }
+}
+
+TEST_CASE("ExtractPolygon from area") {
+    osmium::memory::Buffer buffer{10000};
+    const osmium::Area& area = create_test_area_1outer_1inner(buffer);
+    const osmium::geom::ExtractPolygon polygon{area};
+    REQUIRE(polygon.rings().size() == 2);
+    REQUIRE(polygon.contains(osmium::Location{0.5, 0.5}));
+    REQUIRE(polygon.contains(osmium::Location{8.5, 5.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{5.0, 5.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{9.5, 5.0}));
+}
+
+TEST_CASE("PolygonIndex without polygons") {
+    const osmium::geom::PolygonIndex index{{}};
+    REQUIRE(index.size() == 0);
+    std::vector<std::size_t> ids;
+    index.get_containing(osmium::Location{1.0, 1.0}, ids);
+    REQUIRE(ids.empty());
+}
+
+TEST_CASE("PolygonIndex with a few polygons") {
+    std::vector<osmium::geom::ExtractPolygon> polygons;
+    polygons.emplace_back(osmium::Box{0.0, 0.0, 10.0, 10.0});
+    polygons.emplace_back(osmium::Box{5.0, 5.0, 15.0, 15.0});
+    polygons.emplace_back();
+    polygons.emplace_back();
+    polygons.back().add_ring({osmium::Location{-5.0, -5.0}, osmium::Location{10.0, -5.0}, osmium::Location{-5.0, 10.0}});
+
+    const osmium::geom::PolygonIndex index{std::move(polygons), 16};
+    REQUIRE(index.size() == 4);
+    REQUIRE(index.polygon(2).empty());
+
+    std::vector<std::size_t> ids;
+
+    index.get_containing(osmium::Location{7.0, 7.0}, ids);
+    REQUIRE(ids == (std::vector<std::size_t>{0, 1}));
+
+    index.get_containing(osmium::Location{1.0, 1.0}, ids);
+    REQUIRE(ids == (std::vector<std::size_t>{0, 3}));
+
+    index.get_containing(osmium::Location{12.0, 12.0}, ids);
+    REQUIRE(ids == std::vector<std::size_t>{1});
+
+    index.get_containing(osmium::Location{4.0, 4.0}, ids);
+    REQUIRE(ids == std::vector<std::size_t>{0});
+
+    index.get_containing(osmium::Location{20.0, 20.0}, ids);
+    REQUIRE(ids.empty());
+
+    index.get_containing(osmium::Location{}, ids);
+    REQUIRE(ids.empty());
+}
+
+TEST_CASE("PolygonIndex gives same results as checking all polygons") {
+    std::vector<osmium::geom::ExtractPolygon> polygons;
+    for (int i = 0; i < 20; ++i) {
+        const double x = i * 1.7 - 15.0;
+        const double y = ((i * 7) % 11) * 1.3 - 7.0;
+        polygons.emplace_back();
+        polygons.back().add_ring({osmium::Location{x, y},
+                                  osmium::Location{x + 6.0, y + 1.0},
+                                  osmium::Location{x + 3.0, y + 2.5},
+                                  osmium::Location{x + 5.0, y + 7.0},
+                                  osmium::Location{x - 1.0, y + 4.0}});
+        if (i % 3 == 0) {
+            polygons.back().add_ring({osmium::Location{x + 1.0, y + 2.0},
+                                      osmium::Location{x + 2.0, y + 2.0},
+                                      osmium::Location{x + 2.0, y + 3.0}});
+        }
+    }
+    const auto copy = polygons;
+
+    for (const uint32_t resolution : {1U, 7U, 64U}) {
+        const osmium::geom::PolygonIndex index{copy, resolution};
+        std::vector<std::size_t> ids;
+        std::vector<std::size_t> expected;
+        for (int ix = -200; ix <= 200; ++ix) {
+            for (int iy = -100; iy <= 100; ++iy) {
+                const osmium::Location location{ix * 0.1 + 0.013, iy * 0.1 + 0.007};
+                expected.clear();
+                for (std::size_t n = 0; n < polygons.size(); ++n) {
+                    if (polygons[n].contains(location)) {
+                        expected.push_back(n);
+                    }
+                }
+                index.get_containing(location, ids);
+                if (ids != expected) {
+                    INFO("resolution " << resolution << " location " << location);
+                    REQUIRE(ids == expected);
+                }
+            }
+        }
+    }
+}
+
+static bool brute_force_contains(const std::vector<std::vector<osmium::Location>>& rings, const osmium::Location location) {
+    const double x = location.lon();
+    const double y = location.lat();
+    bool inside = false;
+    for (const auto& ring : rings) {
+        for (std::size_t i = 0; i < ring.size(); ++i) {
+            const auto& a = ring[i];
+            const auto& b = ring[(i + 1) % ring.size()];
+            if ((a.lat() > y) != (b.lat() > y) &&
+                x < a.lon() + (y - a.lat()) / (b.lat() - a.lat()) * (b.lon() - a.lon())) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+TEST_CASE("ExtractPolygon with rings with many edges") {
+    // A star shaped ring with a hole and a small island
+    std::vector<std::vector<osmium::Location>> rings(3);
+    for (int i = 0; i < 1000; ++i) {
+        const double angle = i * 2.0 * 3.14159265358979 / 1000;
+        const double radius = (i % 2 == 0) ? 10.0 : 7.0;
+        rings[0].emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+        rings[1].emplace_back(2.0 * std::cos(-angle), 2.0 * std::sin(-angle));
+    }
+    rings[2] = {osmium::Location{20.0, 20.0}, osmium::Location{21.0, 20.0}, osmium::Location{20.5, 21.0}};
+
+    osmium::geom::ExtractPolygon polygon;
+    for (const auto& ring : rings) {
+        polygon.add_ring(ring);
+    }
+
+    for (int ix = -250; ix <= 250; ++ix) {
+        for (int iy = -120; iy <= 250; iy += 3) {
+            const osmium::Location location{ix * 0.1 + 0.0013, iy * 0.1 + 0.0007};
+            if (polygon.contains(location) != brute_force_contains(rings, location)) {
+                INFO("location " << location);
+                REQUIRE(polygon.contains(location) == brute_force_contains(rings, location));
+            }
+        }
+    }
+    REQUIRE(polygon.contains(osmium::Location{5.0, 0.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{0.0, 0.0}));
+    REQUIRE(polygon.contains(osmium::Location{20.5, 20.5}));
+}
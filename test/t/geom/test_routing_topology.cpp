@@ -0,0 +1,133 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/geom/routing_topology.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <iterator>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+// Two ways crossing at node 3, a third way continuing the second one.
+static osmium::memory::Buffer create_ways() {
+    osmium::memory::Buffer buffer{10000, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(10), _nodes({
+        {1, {0.0, 0.0}},
+        {2, {0.0, 0.1}},
+        {3, {0.0, 0.2}},
+        {4, {0.0, 0.3}}
+    }));
+    osmium::builder::add_way(buffer, _id(11), _nodes({
+        {5, {-0.1, 0.2}},
+        {3, {0.0, 0.2}},
+        {6, {0.1, 0.2}}
+    }));
+    osmium::builder::add_way(buffer, _id(12), _nodes({
+        {6, {0.1, 0.2}},
+        {7, {0.2, 0.2}},
+        {8, {0.3, 0.2}}
+    }));
+    return buffer;
+}
+
+static double dist(double x1, double y1, double x2, double y2) {
+    return osmium::geom::haversine::distance(osmium::geom::Coordinates{x1, y1}, osmium::geom::Coordinates{x2, y2});
+}
+
+TEST_CASE("Routing topology finds vertices") {
+    const auto buffer = create_ways();
+    osmium::geom::RoutingTopology topology;
+    topology.count(buffer);
+
+    REQUIRE(topology.num_vertices() == 6);
+    for (const osmium::object_id_type id : {1, 3, 4, 5, 6, 8}) {
+        REQUIRE(topology.is_vertex(id));
+    }
+    REQUIRE_FALSE(topology.is_vertex(2));
+    REQUIRE_FALSE(topology.is_vertex(7));
+    REQUIRE_FALSE(topology.is_vertex(9));
+}
+
+TEST_CASE("Routing topology splits ways into edges") {
+    const auto buffer = create_ways();
+    osmium::geom::RoutingTopology topology;
+    topology.count(buffer);
+
+    const auto edges = topology.edges(buffer);
+    REQUIRE(edges.size() == 5);
+
+    REQUIRE(edges[0].way_id == 10);
+    REQUIRE(edges[0].from_node == 1);
+    REQUIRE(edges[0].to_node == 3);
+    REQUIRE(edges[0].length == Approx(dist(0.0, 0.0, 0.0, 0.1) + dist(0.0, 0.1, 0.0, 0.2)));
+
+    REQUIRE(edges[1].way_id == 10);
+    REQUIRE(edges[1].from_node == 3);
+    REQUIRE(edges[1].to_node == 4);
+    REQUIRE(edges[1].length == Approx(dist(0.0, 0.2, 0.0, 0.3)));
+
+    REQUIRE(edges[2].way_id == 11);
+    REQUIRE(edges[2].from_node == 5);
+    REQUIRE(edges[2].to_node == 3);
+
+    REQUIRE(edges[3].way_id == 11);
+    REQUIRE(edges[3].from_node == 3);
+    REQUIRE(edges[3].to_node == 6);
+
+    REQUIRE(edges[4].way_id == 12);
+    REQUIRE(edges[4].from_node == 6);
+    REQUIRE(edges[4].to_node == 8);
+
+    double sum = 0.0;
+    for (const auto& edge : edges) {
+        sum += edge.length;
+    }
+    double expected = 0.0;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        expected += osmium::geom::haversine::distance(way.nodes());
+    }
+    REQUIRE(sum == Approx(expected));
+}
+
+TEST_CASE("Routing topology ignores ways without valid locations") {
+    osmium::memory::Buffer buffer{10000, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{4, {1.0, 1.0}}}));
+
+    osmium::geom::RoutingTopology topology;
+    topology.count(buffer);
+    REQUIRE(topology.num_vertices() == 3);
+
+    std::vector<osmium::geom::routing_edge> edges;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        topology.edges(way, std::back_inserter(edges));
+    }
+    REQUIRE(edges.empty());
+}
+
+TEST_CASE("Routing topology with thread pool") {
+    std::vector<osmium::memory::Buffer> buffers;
+    for (int i = 0; i < 20; ++i) {
+        buffers.push_back(create_ways());
+    }
+
+    osmium::thread::Pool pool{4};
+    osmium::geom::RoutingTopology topology;
+    topology.count(buffers, pool);
+
+    // All nodes are used several times now, so all are vertices.
+    REQUIRE(topology.num_vertices() == 8);
+
+    const auto edges = topology.edges(buffers, pool);
+    REQUIRE(edges.size() == 20 * 7);
+    for (std::size_t i = 0; i < edges.size(); i += 7) {
+        REQUIRE(edges[i].way_id == 10);
+        REQUIRE(edges[i].from_node == 1);
+        REQUIRE(edges[i].to_node == 2);
+        REQUIRE(edges[i + 6].way_id == 12);
+        REQUIRE(edges[i + 6].to_node == 8);
+    }
+}
@@ -0,0 +1,266 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/simplify.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+// Straightforward recursive Douglas-Peucker for comparison.
+static void reference_simplify(const std::vector<osmium::geom::Coordinates>& points, std::size_t first, std::size_t last, double tolerance, std::vector<bool>& keep) {
+    if (last - first < 2) {
+        return;
+    }
+    std::size_t farthest = first + 1;
+    double max_distance = -1.0;
+    for (std::size_t i = first + 1; i < last; ++i) {
+        const double distance = osmium::geom::detail::squared_segment_distance(points[first], points[last], points[i]);
+        if (distance > max_distance) {
+            max_distance = distance;
+            farthest = i;
+        }
+    }
+    if (max_distance > tolerance * tolerance) {
+        keep[farthest] = true;
+        reference_simplify(points, first, farthest, tolerance, keep);
+        reference_simplify(points, farthest, last, tolerance, keep);
+    }
+}
+
+static std::vector<bool> reference_simplify(const std::vector<osmium::geom::Coordinates>& points, double tolerance) {
+    std::vector<bool> keep(points.size(), false);
+    keep.front() = true;
+    keep.back() = true;
+    reference_simplify(points, 0, points.size() - 1, tolerance, keep);
+    return keep;
+}
+
+static osmium::memory::Buffer create_zigzag_way(osmium::object_id_type id, int num_nodes) {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<osmium::NodeRef> nodes;
+    for (int i = 0; i < num_nodes; ++i) {
+        // y alternates between 0 and 0.001 * i
+        nodes.emplace_back(i + 1, osmium::Location{i * 0.01, (i % 2) * 0.001 * i});
+    }
+    osmium::builder::add_way(buffer, _id(id), _nodes(nodes));
+    return buffer;
+}
+
+TEST_CASE("Simplifier needs valid tolerances") {
+    const std::vector<double> negative = {1.0, -1.0};
+    REQUIRE_THROWS_AS(osmium::geom::Simplifier{std::vector<double>{}}, const std::invalid_argument&);
+    REQUIRE_THROWS_AS(osmium::geom::Simplifier(std::vector<double>(33, 1.0)), const std::invalid_argument&);
+    REQUIRE_THROWS_AS(osmium::geom::Simplifier{negative}, const std::invalid_argument&);
+
+    const osmium::geom::Simplifier simplifier{{0.1, 1.0}};
+    REQUIRE(simplifier.num_levels() == 2);
+    REQUIRE(simplifier.tolerance(1) == Approx(1.0));
+}
+
+TEST_CASE("Simplify short and straight linestrings") {
+    const osmium::geom::Simplifier simplifier{{0.0, 1.0}};
+
+    const auto empty = simplifier(std::vector<osmium::geom::Coordinates>{});
+    REQUIRE(empty.empty());
+
+    const auto two = simplifier(std::vector<osmium::geom::Coordinates>{osmium::geom::Coordinates{0, 0}, osmium::geom::Coordinates{1, 1}});
+    REQUIRE(two.count(0) == 2);
+    REQUIRE(two.count(1) == 2);
+
+    // collinear points are removed even with tolerance 0
+    std::vector<osmium::geom::Coordinates> line;
+    for (int i = 0; i < 10; ++i) {
+        line.emplace_back(i, 2 * i);
+    }
+    const auto straight = simplifier(line);
+    REQUIRE(straight.size() == 10);
+    REQUIRE(straight.count(0) == 2);
+    REQUIRE(straight.keep(0, 0));
+    REQUIRE(straight.keep(0, 9));
+}
+
+TEST_CASE("Simplify coordinates with several tolerances") {
+    const std::vector<osmium::geom::Coordinates> points = {
+        osmium::geom::Coordinates{0, 0},
+        osmium::geom::Coordinates{1, 0.5},
+        osmium::geom::Coordinates{2, -0.2},
+        osmium::geom::Coordinates{3, 5},
+        osmium::geom::Coordinates{4, 6},
+        osmium::geom::Coordinates{5, 7},
+        osmium::geom::Coordinates{6, 8.1},
+        osmium::geom::Coordinates{7, 9},
+        osmium::geom::Coordinates{8, 9},
+        osmium::geom::Coordinates{9, 9}
+    };
+
+    const osmium::geom::Simplifier simplifier{{0.0, 0.3, 100.0}};
+    const auto s = simplifier(points);
+    REQUIRE(s.size() == points.size());
+
+    REQUIRE(s.count(0) == 8); // points 4 and 8 are on a straight line
+    REQUIRE(s.count(2) == 2);
+
+    std::vector<osmium::geom::Coordinates> out;
+    s.copy(1, points.cbegin(), std::back_inserter(out));
+    REQUIRE(out.size() == s.count(1));
+    REQUIRE(out.front() == points.front());
+    REQUIRE(out.back() == points.back());
+    for (std::size_t level = 0; level < 3; ++level) {
+        REQUIRE(reference_simplify(points, simplifier.tolerance(level)) == [&]() {
+            std::vector<bool> keep;
+            for (std::size_t i = 0; i < s.size(); ++i) {
+                keep.push_back(s.keep(level, i));
+            }
+            return keep;
+        }());
+    }
+}
+
+TEST_CASE("Simplify gives the same result as separate Douglas-Peucker runs") {
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<int> dist{-1000, 1000};
+
+    const std::vector<double> tolerances = {0.0, 10.0, 50.0, 200.0, 1000.0};
+    const osmium::geom::Simplifier simplifier{tolerances};
+
+    for (int run = 0; run < 50; ++run) {
+        std::vector<osmium::geom::Coordinates> points;
+        for (int i = 0; i < 200; ++i) {
+            points.emplace_back(i * 10 + dist(gen) / 10, dist(gen));
+        }
+
+        const auto s = simplifier(points);
+        for (std::size_t level = 0; level < tolerances.size(); ++level) {
+            const auto expected = reference_simplify(points, tolerances[level]);
+            for (std::size_t i = 0; i < points.size(); ++i) {
+                REQUIRE(s.keep(level, i) == expected[i]);
+                if (level > 0 && s.keep(level, i)) {
+                    REQUIRE(s.keep(level - 1, i));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Simplify way nodes using integer locations") {
+    const auto buffer = create_zigzag_way(1, 100);
+    const auto& way = buffer.get<osmium::Way>(0);
+
+    // tolerances in degrees
+    const osmium::geom::Simplifier simplifier{{0.0, 0.01, 1.0}};
+    const auto s = simplifier(way.nodes());
+    REQUIRE(s.size() == 100);
+    REQUIRE(s.count(0) == 100);
+    REQUIRE(s.count(2) == 2);
+
+    // Must be the same as the simplification on the coordinates
+    std::vector<osmium::geom::Coordinates> coordinates;
+    for (const auto& node_ref : way.nodes()) {
+        coordinates.emplace_back(node_ref.location());
+    }
+    const auto sc = simplifier(coordinates);
+    for (std::size_t level = 0; level < 3; ++level) {
+        REQUIRE(s.count(level) == sc.count(level));
+    }
+
+    std::vector<osmium::NodeRef> nodes;
+    s.copy(1, way.nodes().cbegin(), std::back_inserter(nodes));
+    REQUIRE(nodes.size() == s.count(1));
+    REQUIRE(nodes.front().ref() == 1);
+    REQUIRE(nodes.back().ref() == 100);
+}
+
+TEST_CASE("Simplify closed ring") {
+    osmium::memory::Buffer buffer{1024UL, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({
+        {1, {0.0, 0.0}},
+        {2, {1.0, 0.0}},
+        {3, {1.0, 0.5}},
+        {4, {1.0, 1.0}},
+        {5, {0.0, 1.0}},
+        {1, {0.0, 0.0}}
+    }));
+    const auto& way = buffer.get<osmium::Way>(0);
+
+    const osmium::geom::Simplifier simplifier{{0.0, 1.2, 2.0}};
+    const auto s = simplifier(way.nodes());
+    REQUIRE(s.count(0) == 5); // node 3 is removed
+    REQUIRE_FALSE(s.keep(0, 2));
+    REQUIRE(s.count(1) == 3); // collapsed to first, farthest, last
+    REQUIRE(s.keep(1, 3));
+    REQUIRE(s.count(2) == 2);
+}
+
+TEST_CASE("Simplify with invalid location") {
+    osmium::memory::Buffer buffer{1024UL, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({
+        {1, {0.0, 0.0}},
+        {2, osmium::Location{}},
+        {3, {1.0, 1.0}}
+    }));
+    const osmium::geom::Simplifier simplifier{{1.0}};
+    REQUIRE_THROWS_AS(simplifier(buffer.get<osmium::Way>(0).nodes()), const osmium::invalid_location&);
+}
+
+TEST_CASE("Simplify all ways and areas in buffer") {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= 50; ++id) {
+        const auto way_buffer = create_zigzag_way(id, id + 1);
+        buffer.add_item(way_buffer.get<osmium::Way>(0));
+        buffer.commit();
+    }
+    osmium::builder::add_way(buffer, _id(51), _nodes({{1, {1.0, 1.0}}, {2, osmium::Location{}}}));
+    osmium::builder::add_area(buffer, _id(2),
+        _outer_ring({
+            {1, {0.0, 0.0}},
+            {2, {1.0, 0.0}},
+            {3, {1.0, 0.5}},
+            {4, {1.0, 1.0}},
+            {5, {0.0, 1.0}},
+            {1, {0.0, 0.0}}
+        }),
+        _inner_ring({
+            {6, {0.2, 0.2}},
+            {7, {0.2, 0.8}},
+            {8, {0.8, 0.8}},
+            {9, {0.8, 0.2}},
+            {6, {0.2, 0.2}}
+        })
+    );
+
+    const osmium::geom::Simplifier simplifier{{0.0, 0.01}};
+    osmium::thread::Pool pool{2};
+    const auto result = osmium::geom::simplify(buffer, simplifier, pool);
+
+    REQUIRE(result.size() == 53);
+
+    int id = 1;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        const auto& entry = result[static_cast<std::size_t>(id - 1)];
+        REQUIRE(entry.nodes == &way.nodes());
+        REQUIRE(entry.nodes->type() == osmium::item_type::way_node_list);
+        if (id <= 50) {
+            const auto expected = simplifier(way.nodes());
+            REQUIRE(entry.simplification.size() == way.nodes().size());
+            REQUIRE(entry.simplification.count(0) == expected.count(0));
+            REQUIRE(entry.simplification.count(1) == expected.count(1));
+        } else {
+            REQUIRE(entry.simplification.empty());
+        }
+        ++id;
+    }
+
+    REQUIRE(result[51].nodes->type() == osmium::item_type::outer_ring);
+    REQUIRE(result[51].simplification.count(0) == 5);
+    REQUIRE(result[52].nodes->type() == osmium::item_type::inner_ring);
+    REQUIRE(result[52].simplification.count(0) == 5);
+}
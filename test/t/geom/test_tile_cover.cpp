@@ -0,0 +1,196 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/tile.hpp>
+#include <osmium/geom/tile_buckets.hpp>
+#include <osmium/geom/tile_cover.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static bool contains(const std::vector<osmium::geom::Tile>& tiles, const osmium::geom::Tile& tile) {
+    return std::binary_search(tiles.cbegin(), tiles.cend(), tile);
+}
+
+TEST_CASE("Tile cover of location") {
+    osmium::geom::TileCover cover{4};
+    const osmium::Location location{9.3, 49.1};
+    const auto& tiles = cover.location(location);
+    REQUIRE(tiles.size() == 1);
+    REQUIRE(tiles[0] == osmium::geom::Tile(4, location));
+
+    REQUIRE_THROWS_AS(cover.location(osmium::Location{}), const osmium::invalid_location&);
+}
+
+TEST_CASE("Tile cover of box") {
+    osmium::geom::TileCover cover{1};
+    REQUIRE(cover.box(osmium::Box{-180.0, -90.0, 180.0, 90.0}).size() == 4);
+    REQUIRE(cover.box(osmium::Box{1.0, 1.0, 2.0, 2.0}).size() == 1);
+    REQUIRE(cover.box(osmium::Box{-1.0, 1.0, 2.0, 2.0}).size() == 2);
+    REQUIRE(cover.box(osmium::Box{}).empty());
+
+    osmium::geom::TileCover cover10{10};
+    const auto& tiles = cover10.box(osmium::Box{9.0, 49.0, 9.5, 49.5});
+    const osmium::geom::Tile bl{10, osmium::Location{9.0, 49.0}};
+    const osmium::geom::Tile tr{10, osmium::Location{9.5, 49.5}};
+    REQUIRE(tiles.size() == (tr.x - bl.x + 1) * (bl.y - tr.y + 1));
+    REQUIRE(contains(tiles, bl));
+    REQUIRE(contains(tiles, tr));
+}
+
+TEST_CASE("Tile cover of ways") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_real_distribution<double> lon{8.0, 10.0};
+    std::uniform_real_distribution<double> lat{48.0, 50.0};
+
+    std::vector<std::size_t> offsets;
+    for (int i = 0; i < 20; ++i) {
+        std::vector<osmium::NodeRef> nodes;
+        for (int n = 1; n <= 5; ++n) {
+            nodes.emplace_back(n, osmium::Location{lon(gen), lat(gen)});
+        }
+        offsets.push_back(osmium::builder::add_way(buffer, _id(i), _nodes(nodes)));
+    }
+
+    osmium::geom::TileCover cover{9};
+    osmium::geom::TileCover bbox_cover{9};
+    for (const auto offset : offsets) {
+        const auto& way = buffer.get<osmium::Way>(offset);
+        const auto& tiles = cover.way(way);
+        const auto& bbox_tiles = bbox_cover.way(way, osmium::geom::tile_cover_mode::bbox);
+        REQUIRE(tiles.size() <= bbox_tiles.size());
+        REQUIRE(std::is_sorted(tiles.cbegin(), tiles.cend()));
+        for (const auto& tile : tiles) {
+            REQUIRE(contains(bbox_tiles, tile));
+        }
+
+        // The tiles of all nodes must be in the cover
+        for (const auto& node_ref : way.nodes()) {
+            REQUIRE(contains(tiles, osmium::geom::Tile(9, node_ref.location())));
+        }
+
+        // Tiles of points along the segments (in mercator) must be in
+        // the cover
+        const auto& wnl = way.nodes();
+        for (std::size_t i = 1; i < wnl.size(); ++i) {
+            const auto a = osmium::geom::lonlat_to_mercator(wnl[i - 1].location());
+            const auto b = osmium::geom::lonlat_to_mercator(wnl[i].location());
+            for (int s = 1; s < 100; ++s) {
+                const double f = s / 100.0;
+                const osmium::geom::Coordinates c{a.x + f * (b.x - a.x), a.y + f * (b.y - a.y)};
+                REQUIRE(contains(tiles, osmium::geom::Tile(9, c)));
+            }
+        }
+    }
+}
+
+TEST_CASE("Tile cover of a horizontal and vertical way") {
+    osmium::memory::Buffer buffer{10240};
+    const auto h = osmium::builder::add_way(buffer, _id(1), _nodes({{1, {0.5, 0.5}}, {2, {179.5, 0.5}}}));
+    const auto v = osmium::builder::add_way(buffer, _id(2), _nodes({{1, {0.5, 0.5}}, {2, {0.5, 80.0}}}));
+    const auto p = osmium::builder::add_way(buffer, _id(3), _nodes({{1, {0.5, 0.5}}}));
+
+    osmium::geom::TileCover cover{3};
+    REQUIRE(cover.way(buffer.get<osmium::Way>(h)).size() == 4);
+    REQUIRE(cover.way(buffer.get<osmium::Way>(v)).size() == 4);
+    REQUIRE(cover.way(buffer.get<osmium::Way>(p)).size() == 1);
+}
+
+TEST_CASE("Tile cover of area") {
+    osmium::memory::Buffer buffer{10240};
+    const auto rectangle = osmium::builder::add_area(buffer, _id(2), _outer_ring({
+        {1, {1.0, 1.0}},
+        {2, {60.0, 1.0}},
+        {3, {60.0, 60.0}},
+        {4, {1.0, 60.0}},
+        {1, {1.0, 1.0}}
+    }));
+    const auto triangle = osmium::builder::add_area(buffer, _id(4), _outer_ring({
+        {1, {1.0, 1.0}},
+        {2, {60.0, 1.0}},
+        {3, {1.0, 60.0}},
+        {1, {1.0, 1.0}}
+    }));
+    const auto with_hole = osmium::builder::add_area(buffer, _id(6), _outer_ring({
+        {1, {1.0, 1.0}},
+        {2, {60.0, 1.0}},
+        {3, {60.0, 60.0}},
+        {4, {1.0, 60.0}},
+        {1, {1.0, 1.0}}
+    }), _inner_ring({
+        {5, {10.0, 10.0}},
+        {6, {50.0, 10.0}},
+        {7, {50.0, 50.0}},
+        {8, {10.0, 50.0}},
+        {5, {10.0, 10.0}}
+    }));
+
+    osmium::geom::TileCover cover{5};
+    osmium::geom::TileCover bbox_cover{5};
+
+    // a rectangle in lon/lat is a rectangle in mercator
+    const auto& rectangle_area = buffer.get<osmium::Area>(rectangle);
+    REQUIRE(cover.area(rectangle_area) == bbox_cover.area(rectangle_area, osmium::geom::tile_cover_mode::bbox));
+
+    const auto& triangle_tiles = cover.area(buffer.get<osmium::Area>(triangle));
+    REQUIRE(triangle_tiles.size() < bbox_cover.area(rectangle_area).size());
+    REQUIRE(contains(triangle_tiles, osmium::geom::Tile(5, osmium::Location{10.0, 10.0})));
+    REQUIRE_FALSE(contains(triangle_tiles, osmium::geom::Tile(5, osmium::Location{55.0, 55.0})));
+
+    const auto& hole_tiles = cover.area(buffer.get<osmium::Area>(with_hole));
+    REQUIRE(contains(hole_tiles, osmium::geom::Tile(5, osmium::Location{5.0, 5.0})));
+    REQUIRE_FALSE(contains(hole_tiles, osmium::geom::Tile(5, osmium::Location{30.0, 30.0})));
+}
+
+TEST_CASE("Tile buckets") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 0; i < 2000; ++i) {
+        osmium::builder::add_node(buffer, _id(i), _location(i % 100 < 50 ? -1.0 : 1.0, 1.0));
+    }
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {-1.0, 1.0}}, {2, {1.0, 1.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{1, {-1.0, 1.0}}, {2, osmium::Location{}}}));
+    osmium::builder::add_relation(buffer, _id(1));
+
+    osmium::thread::Pool pool{2};
+    osmium::geom::TileBuckets buckets{1};
+    buckets.add_buffer(buffer, pool);
+
+    REQUIRE(buckets.buckets().size() == 2);
+    for (const auto& bucket : buckets.buckets()) {
+        REQUIRE(bucket.first.z == 1);
+        REQUIRE(bucket.first.y == 0);
+        REQUIRE(std::distance(bucket.second.select<osmium::Node>().begin(), bucket.second.select<osmium::Node>().end()) == 1000);
+        REQUIRE(std::distance(bucket.second.select<osmium::Way>().begin(), bucket.second.select<osmium::Way>().end()) == 1);
+        osmium::object_id_type last_id = -1;
+        for (const auto& node : bucket.second.select<osmium::Node>()) {
+            REQUIRE(node.id() > last_id);
+            last_id = node.id();
+        }
+    }
+
+    osmium::geom::TileBuckets serial{1};
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        serial.add(object);
+    }
+    REQUIRE(serial.buckets().size() == 2);
+    auto it = serial.buckets().cbegin();
+    for (const auto& bucket : buckets.buckets()) {
+        REQUIRE(bucket.first == it->first);
+        REQUIRE(bucket.second.committed() == it->second.committed());
+        ++it;
+    }
+
+    buckets.clear();
+    REQUIRE(buckets.buckets().empty());
+}
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 
+#include "area_helper.hpp"
 #include "wnl_helper.hpp"
 
 #include <osmium/geom/mercator_projection.hpp>
@@ -137,3 +138,34 @@ TEST_CASE("WKB geometry (byte-order-independent) of empty linestring") {
     REQUIRE_THROWS_AS(factory.create_linestring(wnl, osmium::geom::use_nodes::all, osmium::geom::direction::backward), const osmium::geometry_error&);
 }
 
+
+TEST_CASE("WKB geometry factory appending to output string") {
+    osmium::memory::Buffer buffer{10000};
+    const auto& wnl = create_test_wnl_okay(buffer);
+    const auto& wnl_same = create_test_wnl_same_location(buffer);
+    osmium::memory::Buffer area_buffer{10000};
+    const auto& area = create_test_area_1outer_1inner(area_buffer);
+    const osmium::Location loc{3.2, 4.2};
+
+    for (const auto wtype : {osmium::geom::wkb_type::wkb, osmium::geom::wkb_type::ewkb}) {
+        for (const auto otype : {osmium::geom::out_type::binary, osmium::geom::out_type::hex}) {
+            osmium::geom::WKBFactory<> factory{wtype, otype};
+            const std::string expected = factory.create_point(loc) +
+                                         factory.create_linestring(wnl) +
+                                         factory.create_multipolygon(area);
+
+            std::string output{"X"};
+            osmium::geom::WKBFactory<> output_factory{wtype, otype, &output};
+            REQUIRE(output_factory.create_point(loc).empty());
+            REQUIRE(output_factory.create_linestring(wnl).empty());
+            REQUIRE(output_factory.create_multipolygon(area).empty());
+            REQUIRE(output == "X" + expected);
+
+            // Failed geometries don't leave anything in the output
+            output.clear();
+            REQUIRE_THROWS_AS(output_factory.create_linestring(wnl_same), const osmium::geometry_error&);
+            REQUIRE_THROWS_AS(output_factory.create_point(osmium::Location{}), const osmium::invalid_location&);
+            REQUIRE(output.empty());
+        }
+    }
+}
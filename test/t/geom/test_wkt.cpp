@@ -7,6 +7,7 @@
 #include <osmium/geom/wkt.hpp>
 
 #include <string>
+#include <vector>
 
 TEST_CASE("WKT geometry for point") {
     const osmium::geom::WKTFactory<> factory;
@@ -153,3 +154,30 @@ TEST_CASE("WKT geometry factory") {
 
 }
 
+
+TEST_CASE("WKT geometries for all ways and areas in a buffer") {
+    osmium::geom::WKTFactory<> factory;
+    osmium::memory::Buffer buffer{10000, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {1.0, 1.0}}, {2, {2.0, 2.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{1, {1.0, 1.0}}, {1, {1.0, 1.0}}}));
+    osmium::builder::add_way(buffer, _id(3), _nodes({1, 2}));
+    osmium::builder::add_way(buffer, _id(4), _nodes({{3, {3.0, 1.0}}, {4, {4.0, 2.0}}}));
+    create_test_area_1outer_0inner(buffer);
+
+    std::vector<std::string> result;
+    const auto count = factory.create_linestrings(buffer, [&result](const osmium::Way& way, std::string&& wkt) {
+        result.push_back(std::to_string(way.id()) + ' ' + wkt);
+    });
+    REQUIRE(count == 2);
+    REQUIRE(result.size() == 2);
+    REQUIRE(result[0] == "1 LINESTRING(1 1,2 2)");
+    REQUIRE(result[1] == "4 LINESTRING(3 1,4 2)");
+
+    result.clear();
+    REQUIRE(factory.create_multipolygons(buffer, [&result](const osmium::Area& /*area*/, std::string&& wkt) {
+        result.push_back(wkt);
+    }) == 1);
+    REQUIRE(result.size() == 1);
+    REQUIRE(result[0] == "MULTIPOLYGON(((3.2 4.2,3.5 4.7,3.6 4.9,3.2 4.2)))");
+}
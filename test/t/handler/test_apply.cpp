@@ -2,6 +2,7 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
 #include <osmium/handler.hpp>
 #include <osmium/handler/node_locations_for_ways.hpp>
 #include <osmium/index/map/flex_mem.hpp>
@@ -11,6 +12,9 @@
 #include <osmium/memory/buffer.hpp>
 #include <osmium/visitor.hpp>
 
+#include <iterator>
+#include <vector>
+
 TEST_CASE("apply with lambdas on reader") {
     osmium::io::File file{with_data_dir("t/relations/data.osm")};
     osmium::io::Reader reader{file};
@@ -129,3 +133,189 @@ TEST_CASE("apply with handler and lambda") {
     REQUIRE(y == 40000000);
 }
 
+
+TEST_CASE("apply on buffers with only one type of object") {
+    osmium::io::File file{with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf")};
+
+    std::size_t buffers = 0;
+    std::size_t marked = 0;
+    osmium::io::Reader reader{file};
+    while (const auto buffer = reader.read()) {
+        ++buffers;
+        const auto type = buffer.content_type();
+        if (type != osmium::item_type::undefined) {
+            ++marked;
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                REQUIRE(object.type() == type);
+            }
+        }
+    }
+    reader.close();
+    REQUIRE(buffers > 0);
+    REQUIRE(marked == buffers);
+
+    struct counting_handler : public osmium::handler::Handler {
+        int objects = 0;
+        int nodes = 0;
+
+        void osm_object(const osmium::OSMObject& /*object*/) noexcept {
+            ++objects;
+        }
+
+        void node(const osmium::Node& /*node*/) noexcept {
+            ++nodes;
+        }
+    };
+
+    counting_handler handler1;
+    counting_handler handler2;
+    osmium::io::Reader reader2{file};
+    osmium::apply(reader2, handler1, handler2);
+    reader2.close();
+
+    const auto all = osmium::io::read_file(file);
+    counting_handler handler3;
+    osmium::apply(all, handler3);
+    REQUIRE(all.content_type() == osmium::item_type::undefined);
+
+    REQUIRE(handler1.objects == handler3.objects);
+    REQUIRE(handler1.nodes == handler3.nodes);
+    REQUIRE(handler2.nodes == handler3.nodes);
+    REQUIRE(handler3.nodes > 0);
+}
+
+namespace {
+
+    struct NodeOnlyHandler : public osmium::handler::Handler {
+        int nodes = 0;
+
+        void node(const osmium::Node& /*node*/) noexcept {
+            ++nodes;
+        }
+    };
+
+    struct OverloadedHandler : public osmium::handler::Handler {
+        int ways = 0;
+
+        void way(const osmium::Way& /*way*/) noexcept {
+            ++ways;
+        }
+
+        void way(osmium::Way& /*way*/) noexcept {
+            ++ways;
+        }
+    };
+
+    struct ObjectHandler : public osmium::handler::Handler {
+        int objects = 0;
+
+        void osm_object(const osmium::OSMObject& /*object*/) noexcept {
+            ++objects;
+        }
+    };
+
+} // anonymous namespace
+
+TEST_CASE("detect callbacks overridden in handlers") {
+    REQUIRE_FALSE(osmium::detail::overrides_node<osmium::handler::Handler>::value);
+    REQUIRE(osmium::detail::overrides_node<NodeOnlyHandler>::value);
+    REQUIRE_FALSE(osmium::detail::overrides_way<NodeOnlyHandler>::value);
+    REQUIRE_FALSE(osmium::detail::overrides_osm_object<NodeOnlyHandler>::value);
+    REQUIRE(osmium::detail::overrides_way<OverloadedHandler>::value);
+    REQUIRE_FALSE(osmium::detail::overrides_relation<OverloadedHandler>::value);
+    REQUIRE(osmium::detail::overrides_osm_object<ObjectHandler>::value);
+}
+
+TEST_CASE("apply with many handlers calls only overridden callbacks") {
+    osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    NodeOnlyHandler n1;
+    NodeOnlyHandler n2;
+    OverloadedHandler w1;
+    OverloadedHandler w2;
+    ObjectHandler o1;
+    ObjectHandler o2;
+    osmium::handler::Handler empty;
+    int relations = 0;
+
+    osmium::io::Reader reader{file};
+    osmium::apply(reader, n1, w1, o1, empty, n2, w2, o2, [&](const osmium::Relation& /*relation*/) {
+        ++relations;
+    });
+    reader.close();
+
+    REQUIRE(n1.nodes == 5);
+    REQUIRE(n2.nodes == 5);
+    REQUIRE(w1.ways == 2);
+    REQUIRE(w2.ways == 2);
+    REQUIRE(o1.objects == 10);
+    REQUIRE(o2.objects == 10);
+    REQUIRE(relations == 3);
+}
+
+namespace {
+
+    struct BatchHandler : public osmium::handler::Handler {
+        std::vector<std::size_t> node_batches;
+        std::vector<std::size_t> way_batches;
+        int single_nodes = 0;
+        int objects = 0;
+
+        void node_batch(const osmium::memory::ItemIteratorRange<const osmium::Node>& nodes) {
+            node_batches.push_back(static_cast<std::size_t>(std::distance(nodes.begin(), nodes.end())));
+        }
+
+        void way_batch(const osmium::memory::ItemIteratorRange<const osmium::Way>& ways) {
+            way_batches.push_back(static_cast<std::size_t>(std::distance(ways.begin(), ways.end())));
+        }
+
+        void node(const osmium::Node& /*node*/) noexcept {
+            ++single_nodes;
+        }
+
+        void osm_object(const osmium::OSMObject& /*object*/) noexcept {
+            ++objects;
+        }
+    };
+
+} // anonymous namespace
+
+TEST_CASE("apply with batch callbacks") {
+    REQUIRE(osmium::detail::has_node_batch<BatchHandler>::value);
+    REQUIRE(osmium::detail::has_way_batch<BatchHandler>::value);
+    REQUIRE_FALSE(osmium::detail::has_relation_batch<BatchHandler>::value);
+    REQUIRE_FALSE(osmium::detail::has_node_batch<NodeOnlyHandler>::value);
+
+    osmium::io::File file{with_data_dir("t/relations/data.osm")};
+    osmium::io::Reader reader{file};
+    auto buffer = reader.read();
+    reader.close();
+
+    BatchHandler batch;
+    ObjectHandler object_handler;
+    std::vector<osmium::item_type> types;
+    osmium::apply(buffer, batch, object_handler, [&](const osmium::OSMObject& object) {
+        types.push_back(object.type());
+    });
+
+    REQUIRE(batch.node_batches == std::vector<std::size_t>{5});
+    REQUIRE(batch.way_batches == std::vector<std::size_t>{2});
+    REQUIRE(batch.single_nodes == 0);
+    REQUIRE(batch.objects == 3); // only the relations
+    REQUIRE(object_handler.objects == 10);
+    REQUIRE(types.size() == 10);
+    REQUIRE(types.front() == osmium::item_type::node);
+    REQUIRE(types.back() == osmium::item_type::relation);
+
+    SECTION("buffer with only one type") {
+        using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+        osmium::memory::Buffer nodes{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_node(nodes, _id(1));
+        osmium::builder::add_node(nodes, _id(2));
+        nodes.set_content_type(osmium::item_type::node);
+
+        BatchHandler batch2;
+        osmium::apply(nodes, batch2);
+        REQUIRE(batch2.node_batches == std::vector<std::size_t>{2});
+    }
+}
@@ -0,0 +1,270 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/parallel_visitor.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    struct CountHandler : public osmium::handler::Handler {
+
+        std::atomic<std::size_t> nodes{0};
+        std::atomic<std::size_t> ways{0};
+        std::atomic<osmium::object_id_type> sum{0};
+        int flushed = 0;
+
+        void node(const osmium::Node& node) {
+            ++nodes;
+            sum += node.id();
+        }
+
+        void way(const osmium::Way& /*way*/) {
+            ++ways;
+        }
+
+        void flush() {
+            ++flushed;
+        }
+
+    }; // struct CountHandler
+
+    struct OrderHandler : public osmium::handler::Handler {
+
+        std::vector<osmium::object_id_type> ids;
+        int flushed = 0;
+
+        void osm_object(const osmium::OSMObject& object) {
+            ids.push_back(object.id());
+        }
+
+        void flush() {
+            ++flushed;
+        }
+
+    }; // struct OrderHandler
+
+    struct ThrowHandler : public osmium::handler::Handler {
+
+        void way(const osmium::Way& way) {
+            if (way.id() == 7) {
+                throw std::runtime_error{"way 7"};
+            }
+        }
+
+    }; // struct ThrowHandler
+
+    struct SumHandler : public osmium::handler::Handler {
+
+        std::size_t nodes = 0;
+        std::size_t ways = 0;
+        osmium::object_id_type sum = 0;
+        int flushed = 0;
+
+        void node(const osmium::Node& node) {
+            ++nodes;
+            sum += node.id();
+        }
+
+        void way(const osmium::Way& /*way*/) {
+            ++ways;
+        }
+
+        void flush() {
+            ++flushed;
+        }
+
+        void merge(const SumHandler& other) {
+            nodes += other.nodes;
+            ways += other.ways;
+            sum += other.sum;
+            flushed += other.flushed;
+        }
+
+    }; // struct SumHandler
+
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        explicit BufferSource(std::vector<osmium::memory::Buffer>&& buffers) :
+            m_buffers(std::move(buffers)) {
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+    osmium::memory::Buffer make_buffer(osmium::object_id_type first, osmium::object_id_type last) {
+        using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = first; id < last; ++id) {
+            osmium::builder::add_node(buffer, _id(id));
+        }
+        for (osmium::object_id_type id = first; id < first + 10; ++id) {
+            osmium::builder::add_way(buffer, _id(id));
+        }
+        return buffer;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Parallel apply on a buffer split into slices") {
+    osmium::thread::Pool pool{3};
+    auto buffer = make_buffer(1, 25001);
+
+    CountHandler counter;
+    OrderHandler order;
+    osmium::apply_parallel(buffer, pool, osmium::concurrent(counter), order);
+
+    REQUIRE(counter.nodes == 25000);
+    REQUIRE(counter.ways == 10);
+    REQUIRE(counter.sum == 25000LL * 25001LL / 2);
+    REQUIRE(counter.flushed == 1);
+
+    REQUIRE(order.ids.size() == 25010);
+    REQUIRE(order.ids.front() == 1);
+    REQUIRE(order.ids[24999] == 25000);
+    REQUIRE(order.ids.back() == 10);
+    REQUIRE(order.flushed == 1);
+}
+
+TEST_CASE("Parallel apply on buffers from a source keeps order for ordered handlers") {
+    osmium::thread::Pool pool{2};
+
+    std::vector<osmium::memory::Buffer> buffers;
+    for (osmium::object_id_type n = 0; n < 10; ++n) {
+        buffers.push_back(make_buffer(n * 100 + 1, n * 100 + 101));
+    }
+    BufferSource source{std::move(buffers)};
+
+    CountHandler counter;
+    OrderHandler order;
+    osmium::apply_parallel(source, pool, order, osmium::concurrent(counter));
+
+    REQUIRE(counter.nodes == 1000);
+    REQUIRE(counter.ways == 100);
+    REQUIRE(counter.flushed == 1);
+
+    std::vector<osmium::object_id_type> expected;
+    for (osmium::object_id_type n = 0; n < 10; ++n) {
+        for (osmium::object_id_type id = n * 100 + 1; id < n * 100 + 101; ++id) {
+            expected.push_back(id);
+        }
+        for (osmium::object_id_type id = n * 100 + 1; id < n * 100 + 11; ++id) {
+            expected.push_back(id);
+        }
+    }
+    REQUIRE(order.ids == expected);
+}
+
+TEST_CASE("Parallel apply with only ordered handlers") {
+    osmium::thread::Pool pool{2};
+    auto buffer = make_buffer(1, 11);
+
+    OrderHandler order;
+    osmium::apply_parallel(buffer, pool, order);
+
+    REQUIRE(order.ids.size() == 20);
+    REQUIRE(order.flushed == 1);
+}
+
+TEST_CASE("Parallel apply propagates exceptions from concurrent handlers") {
+    osmium::thread::Pool pool{2};
+
+    std::vector<osmium::memory::Buffer> buffers;
+    for (osmium::object_id_type n = 0; n < 5; ++n) {
+        buffers.push_back(make_buffer(n * 100 + 1, n * 100 + 101));
+    }
+    BufferSource source{std::move(buffers)};
+
+    ThrowHandler thrower;
+    OrderHandler order;
+    REQUIRE_THROWS_AS(osmium::apply_parallel(source, pool, osmium::concurrent(thrower), order), const std::runtime_error&);
+    REQUIRE(order.flushed == 0);
+}
+
+TEST_CASE("Parallel reduce with merge member function") {
+    osmium::thread::Pool pool{3};
+
+    std::vector<osmium::memory::Buffer> buffers;
+    for (osmium::object_id_type n = 0; n < 10; ++n) {
+        buffers.push_back(make_buffer(n * 100 + 1, n * 100 + 101));
+    }
+    buffers.push_back(make_buffer(1001, 26001));
+    BufferSource source{std::move(buffers)};
+
+    const auto result = osmium::apply_parallel_reduce(source, pool, SumHandler{});
+
+    REQUIRE(result.nodes == 26000);
+    REQUIRE(result.ways == 110);
+    REQUIRE(result.sum == 26000LL * 26001LL / 2);
+    REQUIRE(result.flushed >= 1);
+    REQUIRE(result.flushed <= 6);
+}
+
+TEST_CASE("Parallel reduce with merge function") {
+    osmium::thread::Pool pool{2};
+
+    std::vector<osmium::memory::Buffer> buffers;
+    for (osmium::object_id_type n = 0; n < 5; ++n) {
+        buffers.push_back(make_buffer(n * 100 + 1, n * 100 + 101));
+    }
+    BufferSource source{std::move(buffers)};
+
+    SumHandler initial;
+    initial.nodes = 7;
+
+    int merged = 0;
+    const auto result = osmium::apply_parallel_reduce(source, pool, initial, [&merged](SumHandler& total, const SumHandler& other) {
+        total.nodes += other.nodes - 7;
+        total.ways += other.ways;
+        ++merged;
+    });
+
+    REQUIRE(merged >= 1);
+    REQUIRE(result.nodes == 507);
+    REQUIRE(result.ways == 50);
+    REQUIRE(result.sum == 0);
+    REQUIRE(initial.nodes == 7);
+}
+
+TEST_CASE("Parallel reduce on empty source returns initial handler") {
+    osmium::thread::Pool pool{2};
+    BufferSource source{std::vector<osmium::memory::Buffer>{}};
+
+    SumHandler initial;
+    initial.ways = 3;
+    const auto result = osmium::apply_parallel_reduce(source, pool, initial);
+
+    REQUIRE(result.nodes == 0);
+    REQUIRE(result.ways == 3);
+    REQUIRE(result.flushed == 0);
+}
+
+TEST_CASE("Parallel reduce propagates exceptions from handler") {
+    osmium::thread::Pool pool{2};
+
+    std::vector<osmium::memory::Buffer> buffers;
+    for (osmium::object_id_type n = 0; n < 5; ++n) {
+        buffers.push_back(make_buffer(n * 100 + 1, n * 100 + 101));
+    }
+    BufferSource source{std::move(buffers)};
+
+    REQUIRE_THROWS_AS(osmium::apply_parallel_reduce(source, pool, ThrowHandler{}, [](ThrowHandler& /*total*/, const ThrowHandler& /*other*/) {}), const std::runtime_error&);
+}
@@ -114,3 +114,22 @@ TEST_CASE("Dynamic handler") {
     REQUIRE(count == 10);
 }
 
+
+TEST_CASE("Dynamic handler on buffer with only one type of object") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 5; ++id) {
+        osmium::builder::add_way(buffer, _id(id));
+    }
+    buffer.set_content_type(osmium::item_type::way);
+
+    osmium::handler::DynamicHandler handler;
+    int count = 0;
+
+    osmium::apply(buffer, handler);
+    REQUIRE(count == 0);
+
+    handler.set<Handler1>(count);
+    osmium::apply(buffer, handler);
+    REQUIRE(count == 6); // 5 ways and flush
+}
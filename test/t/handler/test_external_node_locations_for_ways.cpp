@@ -0,0 +1,144 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/external_node_locations_for_ways.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::Location test_location(osmium::object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id * 10), static_cast<int32_t>(-id * 20)};
+}
+
+static osmium::memory::Buffer create_nodes() {
+    osmium::memory::Buffer buffer{1024 * 1024};
+    // Sorted as in OSM files: negative ids ordered by absolute value first
+    for (osmium::object_id_type id : {-2, -5, 1, 2, 3, 5, 8, 13, 21, 34}) {
+        osmium::builder::add_node(buffer, _id(id), _location(test_location(id)));
+    }
+    for (osmium::object_id_type id = 100; id < 2000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _location(test_location(id)));
+    }
+    return buffer;
+}
+
+static osmium::memory::Buffer create_ways() {
+    osmium::memory::Buffer buffer{1024 * 1024};
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3, 5}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({34, 8, -5, 1}));
+    osmium::builder::add_way(buffer, _id(3), _nodes({21, -2, 13}));
+    for (osmium::object_id_type id = 10; id < 200; ++id) {
+        std::vector<osmium::object_id_type> nodes;
+        for (osmium::object_id_type n = 0; n < 10; ++n) {
+            nodes.push_back(100 + (id * 37 + n * 101) % 1900);
+        }
+        osmium::builder::add_way(buffer, _id(id), _nodes(nodes));
+    }
+    return buffer;
+}
+
+using handler_type = osmium::handler::ExternalNodeLocationsForWays;
+
+static void check_locations(std::size_t memory) {
+    auto nodes = create_nodes();
+    auto ways1 = create_ways();
+    auto ways2 = create_ways();
+
+    handler_type handler{memory};
+    REQUIRE(handler.current_pass() == handler_type::pass::collect_node_refs);
+
+    osmium::apply(ways1, handler);
+    REQUIRE(handler.num_node_refs() == 4 + 4 + 3 + 190 * 10);
+
+    handler.start_node_pass();
+    REQUIRE(handler.current_pass() == handler_type::pass::join_nodes);
+    osmium::apply(nodes, handler);
+
+    handler.start_way_pass();
+    REQUIRE(handler.current_pass() == handler_type::pass::add_locations);
+    osmium::apply(ways2, handler);
+
+    for (const auto& way : ways2.select<osmium::Way>()) {
+        for (const auto& node_ref : way.nodes()) {
+            REQUIRE(node_ref.location() == test_location(node_ref.ref()));
+        }
+    }
+}
+
+TEST_CASE("External node locations for ways sorted in memory") {
+    check_locations(1024 * 1024);
+}
+
+TEST_CASE("External node locations for ways sorted with temporary files") {
+    check_locations(1000);
+}
+
+TEST_CASE("External node locations for ways with missing nodes") {
+    osmium::memory::Buffer nodes{1024};
+    osmium::builder::add_node(nodes, _id(2), _location(test_location(2)));
+
+    osmium::memory::Buffer ways{1024};
+    osmium::builder::add_way(ways, _id(1), _nodes({1, 2, 3}));
+
+    handler_type handler{100};
+    osmium::apply(ways, handler);
+    handler.start_node_pass();
+    osmium::apply(nodes, handler);
+    handler.start_way_pass();
+
+    SECTION("throws") {
+        REQUIRE_THROWS_AS(osmium::apply(ways, handler), const osmium::not_found&);
+    }
+
+    SECTION("ignore errors") {
+        handler.ignore_errors();
+        osmium::apply(ways, handler);
+        const auto& way = ways.get<osmium::Way>(0);
+        REQUIRE_FALSE(way.nodes()[0].location());
+        REQUIRE(way.nodes()[1].location() == test_location(2));
+        REQUIRE_FALSE(way.nodes()[2].location());
+    }
+}
+
+TEST_CASE("External node locations for ways needs ways in the same order") {
+    osmium::memory::Buffer ways1{1024};
+    osmium::builder::add_way(ways1, _id(1), _nodes({-5, 1}));
+    osmium::builder::add_way(ways1, _id(2), _nodes({2, 3}));
+
+    osmium::memory::Buffer ways2{1024};
+    osmium::builder::add_way(ways2, _id(2), _nodes({2, 3}));
+    osmium::builder::add_way(ways2, _id(1), _nodes({-5, 1}));
+
+    auto nodes = create_nodes();
+
+    handler_type handler;
+    osmium::apply(ways1, handler);
+    handler.start_node_pass();
+    osmium::apply(nodes, handler);
+    handler.start_way_pass();
+    REQUIRE_THROWS_AS(osmium::apply(ways2, handler), const std::runtime_error&);
+}
+
+TEST_CASE("External node locations for ways needs sorted nodes") {
+    osmium::memory::Buffer nodes{1024};
+    osmium::builder::add_node(nodes, _id(3), _location(test_location(3)));
+    osmium::builder::add_node(nodes, _id(2), _location(test_location(2)));
+
+    handler_type handler;
+    handler.start_node_pass();
+    REQUIRE_THROWS_AS(osmium::apply(nodes, handler), const std::runtime_error&);
+}
+
+TEST_CASE("External node locations for ways checks the passes") {
+    handler_type handler;
+    REQUIRE_THROWS_AS(handler.start_way_pass(), const std::logic_error&);
+    handler.start_node_pass();
+    REQUIRE_THROWS_AS(handler.start_node_pass(), const std::logic_error&);
+}
@@ -0,0 +1,133 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/id_renumber.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/mapped_file_map.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstdio>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_buffer() {
+    osmium::memory::Buffer buffer{1024 * 10, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(10), _location(50.0, 10.0));
+    osmium::builder::add_node(buffer, _id(20), _location(-50.0, -10.0));
+    osmium::builder::add_node(buffer, _id(30), _location(50.001, 10.001));
+    osmium::builder::add_node(buffer, _id(40), _location(-50.001, -10.001));
+    osmium::builder::add_way(buffer, _id(5), _nodes({20, 40}));
+    osmium::builder::add_way(buffer, _id(7), _nodes({30, 10, 99}));
+    osmium::builder::add_relation(buffer, _id(3), _member(osmium::item_type::way, 7), _member(osmium::item_type::node, 77), _member(osmium::item_type::relation, 8));
+    osmium::builder::add_relation(buffer, _id(8), _member(osmium::item_type::way, 5));
+    return buffer;
+}
+
+static std::string ids(const osmium::memory::Buffer& buffer) {
+    std::string result;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        result += osmium::item_type_to_char(object.type());
+        result += std::to_string(object.id());
+        if (object.type() == osmium::item_type::way) {
+            for (const auto& node_ref : static_cast<const osmium::Way&>(object).nodes()) {
+                result += ',' + std::to_string(node_ref.ref());
+            }
+        } else if (object.type() == osmium::item_type::relation) {
+            for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                result += ',';
+                result += osmium::item_type_to_char(member.type());
+                result += std::to_string(member.ref());
+            }
+        }
+        result += ' ';
+    }
+    return result;
+}
+
+static std::string renumbered(const osmium::handler::renumber_order order) {
+    auto buffer = create_buffer();
+    osmium::handler::IdRenumber renumber{order};
+    osmium::apply(buffer, renumber);
+    renumber.prepare();
+    renumber.renumber(buffer);
+    return ids(buffer);
+}
+
+TEST_CASE("Renumber ids in input order") {
+    REQUIRE(renumbered(osmium::handler::renumber_order::input) ==
+            "n1 n2 n3 n4 w1,2,4 w2,3,1,6 r1,w2,n5,r2 r2,w1 ");
+}
+
+TEST_CASE("Renumber ids in order of first reference") {
+    REQUIRE(renumbered(osmium::handler::renumber_order::first_reference) ==
+            "n4 n1 n3 n2 w1,1,2 w2,3,4,5 r1,w2,n6,r2 r2,w1 ");
+}
+
+TEST_CASE("Renumber ids in Hilbert order") {
+    // Nodes 20 and 40 and nodes 10 and 30 are close to each other, so
+    // they get consecutive ids. Way 5 starts at node 20 which comes
+    // first, so it gets the first id. Missing nodes 77 and 99 come last.
+    REQUIRE(renumbered(osmium::handler::renumber_order::hilbert) ==
+            "n3 n1 n4 n2 w1,1,2 w2,4,3,6 r1,w2,n5,r2 r2,w1 ");
+}
+
+TEST_CASE("Renumber objects not seen in first pass throws") {
+    auto buffer = create_buffer();
+    osmium::handler::IdRenumber renumber;
+    renumber.prepare();
+    REQUIRE_THROWS_AS(renumber.renumber(buffer), const osmium::not_found&);
+}
+
+TEST_CASE("Write maps from old to new ids") {
+    auto buffer = create_buffer();
+    osmium::handler::IdRenumber renumber{osmium::handler::renumber_order::first_reference};
+    osmium::apply(buffer, renumber);
+    renumber.prepare();
+
+    REQUIRE(renumber.node_map().size() == 6);
+    REQUIRE(renumber.new_id(osmium::item_type::node, 99) == 5);
+    REQUIRE(renumber.new_id(osmium::item_type::way, -7) == 2);
+
+    const int node_fd = osmium::detail::create_tmp_file();
+    const int way_fd = osmium::detail::create_tmp_file();
+    const int relation_fd = osmium::detail::create_tmp_file();
+    renumber.write_maps(node_fd, way_fd, relation_fd);
+
+    using map_type = osmium::index::map::MappedFileMap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+    const map_type node_map{node_fd};
+    REQUIRE(node_map.get(20) == 1);
+    REQUIRE(node_map.get(77) == 6);
+    const map_type relation_map{relation_fd};
+    REQUIRE(relation_map.get(8) == 2);
+}
+
+TEST_CASE("Renumber file") {
+    const std::string input_data{"n10 x1 y1\nn20 x2 y2\nw5 Nn20,n10\nr3 Mw5@\n"};
+    const osmium::io::File input{input_data.data(), input_data.size(), "opl"};
+    const std::string output_name{"test-id-renumber.opl"};
+
+    {
+        osmium::io::Writer writer{output_name, osmium::io::overwrite::allow};
+        osmium::handler::IdRenumber renumber;
+        renumber.renumber_file(input, writer);
+        writer.close();
+    }
+
+    osmium::io::Reader reader{output_name};
+    std::string result;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        result += ids(buffer);
+    }
+    reader.close();
+    REQUIRE(result == "n1 n2 w1,2,1 r1,w1 ");
+
+    REQUIRE(std::remove(output_name.c_str()) == 0);
+}
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/multi_extract.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/visitor.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+// Nodes 1 to 9 at (id, id), way n has nodes n and n+1, relation 1 has way 1
+// as member, relation 2 has node 8, relation 3 has relation 2.
+static osmium::memory::Buffer create_test_data() {
+    osmium::memory::Buffer buffer{1024UL * 64UL, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int id = 1; id <= 9; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(id, id));
+    }
+    for (int id = 1; id <= 8; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({id, id + 1}));
+    }
+    osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 1));
+    osmium::builder::add_relation(buffer, _id(2), _version(1), _member(osmium::item_type::node, 8));
+    osmium::builder::add_relation(buffer, _id(3), _version(1), _member(osmium::item_type::relation, 2));
+
+    return buffer;
+}
+
+static std::vector<osmium::geom::ExtractPolygon> create_polygons() {
+    std::vector<osmium::geom::ExtractPolygon> polygons;
+    polygons.emplace_back(osmium::Box{0.5, 0.5, 2.5, 2.5});
+    polygons.emplace_back(osmium::Box{7.5, 7.5, 20.0, 20.0});
+    polygons.emplace_back(osmium::Box{30.0, 30.0, 40.0, 40.0});
+    return polygons;
+}
+
+template <typename TSet>
+static std::string ids(const TSet& set) {
+    std::string result;
+    for (const auto id : set) {
+        result += std::to_string(id);
+        result += ' ';
+    }
+    return result;
+}
+
+TEST_CASE("MultiExtract needs one writer per polygon") {
+    REQUIRE_THROWS_AS(osmium::handler::MultiExtract(create_polygons(), {nullptr}), const std::invalid_argument&);
+}
+
+TEST_CASE("MultiExtract collects ids") {
+    osmium::handler::MultiExtract handler{create_polygons(), {nullptr, nullptr, nullptr}, 8};
+    REQUIRE(handler.size() == 3);
+
+    auto buffer = create_test_data();
+    osmium::apply(buffer, handler);
+
+    REQUIRE(ids(handler.node_ids(0)) == "1 2 ");
+    REQUIRE(ids(handler.way_ids(0)) == "1 2 ");
+    REQUIRE(ids(handler.relation_ids(0)) == "1 ");
+
+    REQUIRE(ids(handler.node_ids(1)) == "8 9 ");
+    REQUIRE(ids(handler.way_ids(1)) == "7 8 ");
+    REQUIRE(ids(handler.relation_ids(1)) == "2 3 ");
+
+    REQUIRE(handler.node_ids(2).empty());
+    REQUIRE(handler.way_ids(2).empty());
+    REQUIRE(handler.relation_ids(2).empty());
+}
+
+static std::string read_ids(const std::string& filename) {
+    std::string result;
+
+    osmium::io::Reader reader{filename};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            result += osmium::item_type_to_char(object.type());
+            result += std::to_string(object.id());
+            result += ' ';
+        }
+    }
+    reader.close();
+
+    return result;
+}
+
+TEST_CASE("MultiExtract writes extracts") {
+    {
+        osmium::io::Writer writer0{"test-multi-extract-0.osm", osmium::io::overwrite::allow};
+        osmium::io::Writer writer1{"test-multi-extract-1.osm", osmium::io::overwrite::allow};
+        osmium::io::Writer writer2{"test-multi-extract-2.osm", osmium::io::overwrite::allow};
+
+        osmium::handler::MultiExtract handler{create_polygons(), {&writer0, &writer1, &writer2}};
+        auto buffer = create_test_data();
+        osmium::apply(buffer, handler);
+
+        writer0.close();
+        writer1.close();
+        writer2.close();
+    }
+
+    REQUIRE(read_ids("test-multi-extract-0.osm") == "n1 n2 w1 w2 r1 ");
+    REQUIRE(read_ids("test-multi-extract-1.osm") == "n8 n9 w7 w8 r2 r3 ");
+    REQUIRE(read_ids("test-multi-extract-2.osm").empty());
+}
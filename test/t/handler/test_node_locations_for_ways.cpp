@@ -0,0 +1,303 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mmap_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_locations_block.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using dense_index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+using sparse_index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+template <typename TIndex>
+static void test_get_many(TIndex& index) {
+    for (osmium::unsigned_object_id_type id = 1; id < 100; id += 2) {
+        index.set(id, osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id * 2)});
+    }
+    index.sort();
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 0; id < 200; ++id) {
+        ids.push_back(id * 7 % 200);
+    }
+
+    std::vector<osmium::Location> locations(ids.size());
+    index.get_many(ids.data(), locations.data(), ids.size());
+
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(locations[i] == index.get_noexcept(ids[i]));
+    }
+
+    index.get_many(ids.data(), locations.data(), 0);
+}
+
+TEST_CASE("Index get_many on dense array") {
+    dense_index_type index;
+    test_get_many(index);
+}
+
+TEST_CASE("Index get_many with default implementation") {
+    sparse_index_type index;
+    test_get_many(index);
+}
+
+template <typename TIndex>
+static void test_set_many(TIndex& index) {
+    std::vector<osmium::unsigned_object_id_type> ids;
+    std::vector<osmium::Location> locations;
+    for (osmium::unsigned_object_id_type id = 1; id < 100; id += 3) {
+        ids.push_back(id);
+        locations.emplace_back(static_cast<int32_t>(id), static_cast<int32_t>(id * 2));
+    }
+    index.set_many(ids.data(), locations.data(), ids.size());
+    index.set_many(ids.data(), locations.data(), 0);
+    index.sort();
+
+    for (osmium::unsigned_object_id_type id = 0; id < 120; ++id) {
+        if (id % 3 == 1 && id < 100) {
+            REQUIRE(index.get(id) == osmium::Location(static_cast<int32_t>(id), static_cast<int32_t>(id * 2)));
+        } else {
+            REQUIRE_FALSE(index.get_noexcept(id).valid());
+        }
+    }
+}
+
+TEST_CASE("Index set_many on dense array") {
+    dense_index_type index;
+    test_set_many(index);
+}
+
+TEST_CASE("Index set_many with default implementation") {
+    sparse_index_type index;
+    test_set_many(index);
+}
+
+// Index recording the access hints it gets.
+class hint_recording_index : public osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> {
+
+    dense_index_type m_index;
+
+public:
+
+    std::vector<osmium::MemoryMapping::access_hint> hints;
+
+    void set(const osmium::unsigned_object_id_type id, const osmium::Location value) override {
+        m_index.set(id, value);
+    }
+
+    osmium::Location get(const osmium::unsigned_object_id_type id) const override {
+        return m_index.get(id);
+    }
+
+    osmium::Location get_noexcept(const osmium::unsigned_object_id_type id) const noexcept override {
+        return m_index.get_noexcept(id);
+    }
+
+    std::size_t size() const override {
+        return m_index.size();
+    }
+
+    std::size_t used_memory() const override {
+        return m_index.used_memory();
+    }
+
+    void clear() override {
+        m_index.clear();
+    }
+
+    void set_access_hint(const osmium::MemoryMapping::access_hint hint) override {
+        hints.push_back(hint);
+    }
+
+}; // class hint_recording_index
+
+TEST_CASE("NodeLocationsForWays sets access hints on indexes") {
+    hint_recording_index index_pos;
+    hint_recording_index index_neg;
+    osmium::handler::NodeLocationsForWays<hint_recording_index, hint_recording_index> handler{index_pos, index_neg};
+
+    osmium::memory::Buffer buffer{1024 * 10};
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 1.0));
+    osmium::builder::add_node(buffer, _id(2), _location(2.0, 2.0));
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2}));
+    osmium::builder::add_node(buffer, _id(3), _location(3.0, 3.0));
+    osmium::builder::add_way(buffer, _id(2), _nodes({2, 3}));
+
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        handler.node(node);
+        if (node.id() == 2) {
+            for (auto& way : buffer.select<osmium::Way>()) {
+                handler.way(way);
+                break;
+            }
+        }
+    }
+    for (auto& way : buffer.select<osmium::Way>()) {
+        handler.way(way);
+    }
+
+    const std::vector<osmium::MemoryMapping::access_hint> expected{
+        osmium::MemoryMapping::access_hint::sequential,
+        osmium::MemoryMapping::access_hint::random
+    };
+    REQUIRE(index_pos.hints == expected);
+    REQUIRE(index_neg.hints == expected);
+}
+
+#ifdef __linux__
+TEST_CASE("Access hints on index based on memory mapping") {
+    osmium::index::map::SparseMmapArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    index.set_access_hint(osmium::MemoryMapping::access_hint::sequential);
+    for (osmium::unsigned_object_id_type id = 1; id < 100000; ++id) {
+        index.set(id, osmium::Location{static_cast<int32_t>(id), 1});
+    }
+    index.set_access_hint(osmium::MemoryMapping::access_hint::random);
+    REQUIRE(index.get(77777) == osmium::Location(77777, 1));
+
+    // Maps not based on memory mappings ignore the hint
+    dense_index_type dense_index;
+    dense_index.set_access_hint(osmium::MemoryMapping::access_hint::random);
+}
+#endif
+
+TEST_CASE("NodeLocationsForWays stores locations from NodeLocationsBlock") {
+    dense_index_type index_pos;
+    dense_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<dense_index_type, dense_index_type> handler{index_pos, index_neg};
+
+    osmium::memory::Buffer buffer{1024 * 10};
+    for (osmium::object_id_type id : {1, 2, -3, -4, 5, 6, -7, 3}) {
+        osmium::builder::add_node(buffer, _id(id), _location(static_cast<double>(id), id + 0.5));
+    }
+
+    const osmium::NodeLocationsBlock block{buffer};
+    handler.node_locations(block);
+
+    for (osmium::object_id_type id : {1, 2, -3, -4, 5, 6, -7, 3}) {
+        REQUIRE(handler.get_node_location(id) == osmium::Location(static_cast<double>(id), id + 0.5));
+    }
+    REQUIRE_FALSE(handler.get_node_location(4).valid());
+    REQUIRE_FALSE(handler.get_node_location(-5).valid());
+
+    osmium::memory::Buffer way_buffer{1024};
+    osmium::builder::add_way(way_buffer, _id(1), _nodes({1, -3, 6}));
+    auto& way = way_buffer.get<osmium::Way>(0);
+    handler.way(way);
+    REQUIRE(way.nodes()[1].location() == osmium::Location(-3.0, -2.5));
+}
+
+TEST_CASE("NodeLocationsForWays adds locations to ways") {
+    dense_index_type index_pos;
+    dense_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<dense_index_type, dense_index_type> handler{index_pos, index_neg};
+
+    osmium::memory::Buffer buffer{1024 * 10};
+    for (osmium::object_id_type id : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}) {
+        osmium::builder::add_node(buffer, _id(id), _location(id, id + 0.5));
+    }
+    osmium::builder::add_node(buffer, _id(-3), _location(-3.0, -3.5));
+
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        handler.node(node);
+    }
+
+    SECTION("positive and negative ids") {
+        osmium::builder::add_way(buffer, _id(1), _nodes({12, 1, -3, 10, 2, 3, 4, 5, 6, 7, 8, 9, 11}));
+        auto& way = *buffer.select<osmium::Way>().begin();
+        handler.way(way);
+
+        for (const auto& node_ref : way.nodes()) {
+            if (node_ref.ref() == -3) {
+                REQUIRE(node_ref.location() == osmium::Location(-3.0, -3.5));
+            } else {
+                const auto id = node_ref.ref();
+                REQUIRE(node_ref.location() == osmium::Location(static_cast<double>(id), id + 0.5));
+            }
+        }
+    }
+
+    SECTION("missing node throws") {
+        osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 99}));
+        auto& way = *buffer.select<osmium::Way>().begin();
+        REQUIRE_THROWS_AS(handler.way(way), const osmium::not_found&);
+    }
+
+    SECTION("missing node with ignore_errors") {
+        handler.ignore_errors();
+        osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 99, -7}));
+        auto& way = *buffer.select<osmium::Way>().begin();
+        handler.way(way);
+        REQUIRE(way.nodes()[0].location() == osmium::Location(1.0, 1.5));
+        REQUIRE(way.nodes()[1].location() == osmium::Location(2.0, 2.5));
+        REQUIRE_FALSE(way.nodes()[2].location());
+        REQUIRE_FALSE(way.nodes()[3].location());
+    }
+
+    SECTION("keep existing locations") {
+        handler.keep_existing_locations();
+        osmium::builder::add_way(buffer, _id(1), _nodes({
+            {1, {50.0, 50.0}},
+            {2, osmium::Location{}},
+            {99, {60.0, 60.0}}
+        }));
+        auto& way = *buffer.select<osmium::Way>().begin();
+        handler.way(way);
+        REQUIRE(way.nodes()[0].location() == osmium::Location(50.0, 50.0));
+        REQUIRE(way.nodes()[1].location() == osmium::Location(2.0, 2.5));
+        REQUIRE(way.nodes()[2].location() == osmium::Location(60.0, 60.0));
+    }
+}
+
+TEST_CASE("NodeLocationsForWays stores negative ids without index") {
+    dense_index_type index_pos;
+    osmium::handler::NodeLocationsForWays<dense_index_type> handler{index_pos};
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 1.5));
+    for (int id = 1; id <= 1000; ++id) {
+        osmium::builder::add_node(buffer, _id(-id), _location(id / 10.0, -id / 10.0));
+    }
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        handler.node(node);
+    }
+
+    REQUIRE(handler.get_node_location(1) == osmium::Location(1.0, 1.5));
+    REQUIRE(handler.get_node_location(-1) == osmium::Location(0.1, -0.1));
+    REQUIRE(handler.get_node_location(-777) == osmium::Location(77.7, -77.7));
+    REQUIRE(handler.get_node_location(-1000) == osmium::Location(100.0, -100.0));
+    REQUIRE_FALSE(handler.get_node_location(-1001));
+
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, -5, -500}));
+    auto& way = *buffer.select<osmium::Way>().begin();
+    handler.way(way);
+    REQUIRE(way.nodes()[1].location() == osmium::Location(0.5, -0.5));
+    REQUIRE(way.nodes()[2].location() == osmium::Location(50.0, -50.0));
+
+    handler.clear();
+    REQUIRE_FALSE(handler.get_node_location(-1));
+}
+
+TEST_CASE("NodeLocationsForWays presizes index") {
+    dense_index_type index_pos;
+    osmium::handler::NodeLocationsForWays<dense_index_type> handler{index_pos};
+
+    handler.presize(0, 0);
+    handler.presize(500, 1000);
+    REQUIRE(index_pos.size() == 0);
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1000), _location(1.0, 1.5));
+    handler.node(buffer.get<osmium::Node>(0));
+    REQUIRE(handler.get_node_location(1000) == osmium::Location(1.0, 1.5));
+}
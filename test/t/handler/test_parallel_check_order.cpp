@@ -0,0 +1,83 @@
+#include "catch.hpp"
+
+#include <osmium/handler/parallel_check_order.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // Source returning one buffer for each list of OPL lines.
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        explicit BufferSource(std::initializer_list<std::initializer_list<const char*>> buffers) {
+            for (const auto& lines : buffers) {
+                osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+                for (const char* line : lines) {
+                    REQUIRE(osmium::opl_parse(line, buffer));
+                }
+                m_buffers.push_back(std::move(buffer));
+            }
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+} // anonymous namespace
+
+TEST_CASE("Parallel CheckOrder with ordered input") {
+    osmium::thread::Pool pool{2};
+    BufferSource source{{"n-3", "n1", "n2"}, {}, {"n5", "w1"}, {"w2", "r4"}, {"r7"}};
+
+    const auto check_order = osmium::handler::check_order_parallel(source, pool);
+    REQUIRE(check_order.max_node_id() == 5);
+    REQUIRE(check_order.max_way_id() == 2);
+    REQUIRE(check_order.max_relation_id() == 7);
+}
+
+TEST_CASE("Parallel CheckOrder with error inside a buffer") {
+    osmium::thread::Pool pool{2};
+    BufferSource source{{"n1", "n2"}, {"n3", "w2", "w1"}, {"r1"}};
+
+    try {
+        osmium::handler::check_order_parallel(source, pool);
+        REQUIRE(false);
+    } catch (const osmium::out_of_order_error& e) {
+        REQUIRE(e.object_id == 1);
+    }
+}
+
+TEST_CASE("Parallel CheckOrder with error between buffers") {
+    osmium::thread::Pool pool{2};
+    BufferSource source{{"n1", "n2", "w1"}, {"n3", "w2"}, {"w1", "w0"}};
+
+    try {
+        osmium::handler::check_order_parallel(source, pool);
+        REQUIRE(false);
+    } catch (const osmium::out_of_order_error& e) {
+        REQUIRE(e.object_id == 3);
+    }
+}
+
+TEST_CASE("Parallel CheckOrder with duplicate id at buffer boundary") {
+    osmium::thread::Pool pool{2};
+    BufferSource source{{"n1", "n2"}, {"n2", "n3"}};
+
+    REQUIRE_THROWS_AS(osmium::handler::check_order_parallel(source, pool), const osmium::out_of_order_error&);
+}
@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/disk_store.hpp>
+#include <osmium/handler/parallel_disk_store.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// There is no pwrite(2) on Windows
+#ifndef _WIN32
+
+#include <unistd.h>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using offset_index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, std::size_t>;
+using entries_type = std::vector<std::pair<osmium::unsigned_object_id_type, std::size_t>>;
+
+static osmium::memory::Buffer create_buffer(const int n) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 0; i < 20; ++i) {
+        osmium::builder::add_node(buffer, _id(n * 100 + i), _version(1), _location(1.0, 2.0), _tag("n", std::to_string(i)));
+    }
+    osmium::builder::add_way(buffer, _id(n), _nodes({n * 100, n * 100 + 1}));
+    osmium::builder::add_relation(buffer, _id(n), _member(osmium::item_type::way, n, ""));
+    return buffer;
+}
+
+static std::string file_content(const int fd) {
+    std::string data(osmium::file_size(fd), '\0');
+    REQUIRE(::pread(fd, &data[0], data.size(), 0) == static_cast<ssize_t>(data.size()));
+    return data;
+}
+
+static entries_type entries(offset_index_type& index) {
+    index.sort();
+    return entries_type(index.cbegin(), index.cend());
+}
+
+TEST_CASE("ParallelDiskStore writes the same as DiskStore") {
+    const int serial_fd = osmium::detail::create_tmp_file();
+    offset_index_type serial_nodes;
+    offset_index_type serial_ways;
+    offset_index_type serial_relations;
+    {
+        osmium::handler::DiskStore store{serial_fd, serial_nodes, serial_ways, serial_relations};
+        for (int n = 1; n <= 50; ++n) {
+            store(create_buffer(n));
+        }
+    }
+
+    const int parallel_fd = osmium::detail::create_tmp_file();
+    offset_index_type parallel_nodes;
+    offset_index_type parallel_ways;
+    offset_index_type parallel_relations;
+
+    osmium::thread::Pool pool{4};
+    osmium::handler::ParallelDiskStore store{parallel_fd, parallel_nodes, parallel_ways, parallel_relations, pool};
+    for (int n = 1; n <= 50; ++n) {
+        store(create_buffer(n));
+    }
+    store.close();
+
+    REQUIRE(store.size() == osmium::file_size(serial_fd));
+    REQUIRE(file_content(parallel_fd) == file_content(serial_fd));
+
+    REQUIRE(parallel_nodes.size() == 50 * 20);
+    REQUIRE(entries(parallel_nodes) == entries(serial_nodes));
+    REQUIRE(entries(parallel_ways) == entries(serial_ways));
+    REQUIRE(entries(parallel_relations) == entries(serial_relations));
+
+    ::close(serial_fd);
+    ::close(parallel_fd);
+}
+
+TEST_CASE("ParallelDiskStore with nothing written") {
+    const int fd = osmium::detail::create_tmp_file();
+    offset_index_type nodes;
+    offset_index_type ways;
+    offset_index_type relations;
+
+    osmium::thread::Pool pool{2};
+    osmium::handler::ParallelDiskStore store{fd, nodes, ways, relations, pool};
+    store(osmium::memory::Buffer{1024});
+    store.close();
+
+    REQUIRE(store.size() == 0);
+    REQUIRE(nodes.size() == 0);
+    ::close(fd);
+}
+
+#endif
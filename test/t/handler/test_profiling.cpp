@@ -0,0 +1,184 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/dynamic_handler.hpp>
+#include <osmium/handler/chain.hpp>
+#include <osmium/handler/profiling.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    osmium::memory::Buffer make_buffer() {
+        using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int i = 1; i <= 100; ++i) {
+            osmium::builder::add_node(buffer, _id(i));
+        }
+        for (int i = 1; i <= 20; ++i) {
+            osmium::builder::add_way(buffer, _id(i), _nodes({1, 2, 3}));
+        }
+        osmium::builder::add_relation(buffer, _id(1));
+        return buffer;
+    }
+
+    struct NodeWayHandler : public osmium::handler::Handler {
+
+        int nodes = 0;
+        int ways = 0;
+        int flushes = 0;
+
+        void node(const osmium::Node& /*node*/) noexcept {
+            ++nodes;
+        }
+
+        void way(const osmium::Way& /*way*/) noexcept {
+            ++ways;
+        }
+
+        void flush() noexcept {
+            ++flushes;
+        }
+
+    }; // struct NodeWayHandler
+
+    struct BatchHandler : public osmium::handler::Handler {
+
+        int nodes = 0;
+        int batches = 0;
+
+        void node_batch(const osmium::memory::ItemIteratorRange<const osmium::Node>& nodes_range) noexcept {
+            ++batches;
+            nodes += static_cast<int>(nodes_range.size());
+        }
+
+    }; // struct BatchHandler
+
+    const osmium::handler::profile_row* find_row(const std::vector<osmium::handler::profile_row>& rows, const std::string& handler, osmium::handler::profiled_callback callback) {
+        for (const auto& row : rows) {
+            if (row.handler == handler && row.callback == callback) {
+                return &row;
+            }
+        }
+        return nullptr;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Profiling handler with apply") {
+    auto buffer = make_buffer();
+
+    NodeWayHandler h1;
+    NodeWayHandler h2;
+    osmium::handler::HandlerProfiler profiler;
+    auto p1 = osmium::handler::make_profiling_handler(profiler, h1, "first");
+    auto p2 = osmium::handler::make_profiling_handler(profiler, h2, "second");
+
+    osmium::apply(buffer, p1, p2);
+
+    REQUIRE(h1.nodes == 100);
+    REQUIRE(h1.ways == 20);
+    REQUIRE(h1.flushes == 1);
+    REQUIRE(h2.nodes == 100);
+
+    const auto rows = profiler.rows();
+    REQUIRE(rows.size() == 6);
+    REQUIRE(rows[0].handler == "first");
+    REQUIRE(rows[0].callback == osmium::handler::profiled_callback::node);
+    REQUIRE(rows[0].calls == 100);
+    REQUIRE(rows[1].callback == osmium::handler::profiled_callback::way);
+    REQUIRE(rows[1].calls == 20);
+    REQUIRE(rows[2].callback == osmium::handler::profiled_callback::flush);
+    REQUIRE(rows[2].calls == 1);
+    REQUIRE(rows[3].handler == "second");
+
+    // the handler doesn't have relation() or osm_object() callbacks
+    REQUIRE(find_row(rows, "first", osmium::handler::profiled_callback::relation) == nullptr);
+    REQUIRE(find_row(rows, "first", osmium::handler::profiled_callback::osm_object) == nullptr);
+
+    for (const auto& row : rows) {
+        REQUIRE(row.time.count() >= 0);
+    }
+
+    std::ostringstream out;
+    out << profiler;
+    const std::string table = out.str();
+    REQUIRE(table.find("handler") == 0);
+    REQUIRE(table.find("second") != std::string::npos);
+    REQUIRE(table.find("flush") != std::string::npos);
+    REQUIRE(std::count(table.begin(), table.end(), '\n') == 7);
+
+    profiler.clear();
+    REQUIRE(profiler.rows().empty());
+}
+
+TEST_CASE("Profiling handler timing every call") {
+    auto buffer = make_buffer();
+
+    NodeWayHandler handler;
+    osmium::handler::HandlerProfiler profiler{1};
+    REQUIRE(profiler.sample_mask() == 0);
+    auto profiled = osmium::handler::make_profiling_handler(profiler, handler, "h");
+    osmium::apply(buffer, profiled);
+
+    const auto rows = profiler.rows();
+    const auto* row = find_row(rows, "h", osmium::handler::profiled_callback::node);
+    REQUIRE(row);
+    REQUIRE(row->calls == 100);
+}
+
+TEST_CASE("Profiling handler sample interval is rounded to power of two") {
+    osmium::handler::HandlerProfiler profiler{100};
+    REQUIRE(profiler.sample_mask() == 63);
+}
+
+TEST_CASE("Profiling handler keeps batch functions of wrapped handler") {
+    auto buffer = make_buffer();
+
+    BatchHandler handler;
+    osmium::handler::HandlerProfiler profiler;
+    auto profiled = osmium::handler::make_profiling_handler(profiler, handler, "batch");
+    osmium::apply(buffer, profiled);
+
+    REQUIRE(handler.nodes == 100);
+    REQUIRE(handler.batches == 1);
+
+    const auto rows = profiler.rows();
+    const auto* row = find_row(rows, "batch", osmium::handler::profiled_callback::node);
+    REQUIRE(row);
+    REQUIRE(row->calls == 100);
+}
+
+TEST_CASE("Profiling handler in chain handler and dynamic handler") {
+    auto buffer = make_buffer();
+    osmium::handler::HandlerProfiler profiler;
+
+    SECTION("chain handler") {
+        NodeWayHandler h1;
+        NodeWayHandler h2;
+        auto p1 = osmium::handler::make_profiling_handler(profiler, h1, "first");
+        auto p2 = osmium::handler::make_profiling_handler(profiler, h2, "second");
+        osmium::handler::ChainHandler<decltype(p1), decltype(p2)> chain{p1, p2};
+        osmium::apply(buffer, chain);
+        REQUIRE(h1.ways == 20);
+        REQUIRE(h2.ways == 20);
+        const auto rows = profiler.rows();
+        REQUIRE(find_row(rows, "second", osmium::handler::profiled_callback::way)->calls == 20);
+    }
+
+    SECTION("dynamic handler") {
+        NodeWayHandler h;
+        osmium::handler::DynamicHandler dynamic;
+        dynamic.set<osmium::handler::ProfilingHandler<NodeWayHandler>>(profiler, h, "dynamic");
+        osmium::apply(buffer, dynamic);
+        REQUIRE(h.nodes == 100);
+        const auto rows = profiler.rows();
+        REQUIRE(find_row(rows, "dynamic", osmium::handler::profiled_callback::node)->calls == 100);
+        REQUIRE(find_row(rows, "dynamic", osmium::handler::profiled_callback::flush)->calls == 1);
+    }
+}
@@ -0,0 +1,74 @@
+#include "catch.hpp"
+
+#include <osmium/handler/update_object_relations.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/visitor.hpp>
+
+#include <initializer_list>
+#include <vector>
+
+using index_type = osmium::handler::UpdateObjectRelations::index_type;
+using ids = std::vector<osmium::unsigned_object_id_type>;
+
+static osmium::memory::Buffer opl_buffer(std::initializer_list<const char*> lines) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (const char* line : lines) {
+        REQUIRE(osmium::opl_parse(line, buffer));
+    }
+    return buffer;
+}
+
+TEST_CASE("Update object relations from changes") {
+    index_type w2n;
+    index_type n2w;
+    index_type r2w;
+    index_type w2r;
+
+    {
+        auto buffer = opl_buffer({
+            "w10 v1 Nn1,n2,n3",
+            "w11 v1 Nn3,n4",
+            "r20 v1 Mw10@,n1@,w11@",
+            "r21 v1 Mw11@"
+        });
+        osmium::handler::UpdateObjectRelations handler{w2n, n2w, r2w, w2r, true};
+        osmium::apply(buffer, handler);
+        handler.finish();
+    }
+
+    REQUIRE(n2w.get_all(3) == (ids{10, 11}));
+    REQUIRE(w2r.get_all(11) == (ids{20, 21}));
+    REQUIRE(w2r.get_all(1).empty());
+
+    {
+        auto buffer = opl_buffer({
+            "w10 v2 Nn1,n5",  // modified
+            "w11 v2 dD",      // deleted
+            "w12 v1 Nn3,n5",  // created
+            "r20 v2 Mw12@",   // modified
+            "r21 v2 dD"       // deleted
+        });
+        osmium::handler::UpdateObjectRelations handler{w2n, n2w, r2w, w2r};
+        osmium::apply(buffer, handler);
+        handler.finish();
+    }
+
+    REQUIRE(n2w.get_all(1) == ids{10});
+    REQUIRE(n2w.get_all(2).empty());
+    REQUIRE(n2w.get_all(3) == ids{12});
+    REQUIRE(n2w.get_all(4).empty());
+    REQUIRE(n2w.get_all(5) == (ids{10, 12}));
+    REQUIRE(w2n.get_all(10) == (ids{1, 5}));
+    REQUIRE(w2n.get_all(11).empty());
+
+    REQUIRE(w2r.get_all(10).empty());
+    REQUIRE(w2r.get_all(11).empty());
+    REQUIRE(w2r.get_all(12) == ids{20});
+    REQUIRE(r2w.get_all(21).empty());
+
+    n2w.compact();
+    w2r.compact();
+    REQUIRE(n2w.get_all(5) == (ids{10, 12}));
+    REQUIRE(w2r.get_all(12) == ids{20});
+}
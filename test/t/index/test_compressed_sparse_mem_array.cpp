@@ -0,0 +1,162 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/compressed_sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using index_type = osmium::index::map::CompressedSparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location test_location(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id * 37 % 3600000000) - 1800000000,
+                            static_cast<int32_t>(id * 13 % 1800000000) - 900000000};
+}
+
+static std::string read_file(const int fd) {
+    const auto size = osmium::file_size(fd);
+    std::string data(size, '\0');
+    REQUIRE(::lseek(fd, 0, SEEK_SET) == 0);
+    REQUIRE(::read(fd, &data[0], size) == static_cast<ssize_t>(size));
+    return data;
+}
+
+TEST_CASE("CompressedSparseMemArray is empty to begin with") {
+    index_type index;
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.used_memory() == 0);
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    REQUIRE_THROWS_AS(index.get(17), const osmium::not_found&);
+}
+
+TEST_CASE("CompressedSparseMemArray with ids in order spanning several blocks") {
+    index_type index;
+
+    const osmium::unsigned_object_id_type count = index_type::block_size * 10 + 17;
+    for (osmium::unsigned_object_id_type id = 1; id <= count; ++id) {
+        index.set(id * 3, test_location(id * 3));
+    }
+
+    REQUIRE(index.size() == count);
+    REQUIRE(index.used_memory() < count * 16);
+
+    for (osmium::unsigned_object_id_type id = 1; id <= count; ++id) {
+        REQUIRE(index.get(id * 3) == test_location(id * 3));
+        REQUIRE(index.get_noexcept(id * 3 + 1) == osmium::Location{});
+    }
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    REQUIRE(index.get_noexcept(count * 3 + 3) == osmium::Location{});
+}
+
+TEST_CASE("CompressedSparseMemArray with large gaps in ids and extreme coordinates") {
+    index_type index;
+
+    index.set(1, osmium::Location{-1800000000, -900000000});
+    index.set(2, osmium::Location{1800000000, 900000000});
+    index.set(3, osmium::Location{0, 0});
+    index.set(1ULL << 40U, osmium::Location{1800000000, -900000000});
+    index.set((1ULL << 40U) + 1, osmium::Location{-1800000000, 900000000});
+
+    REQUIRE(index.get(1) == osmium::Location(-1800000000, -900000000));
+    REQUIRE(index.get(2) == osmium::Location(1800000000, 900000000));
+    REQUIRE(index.get(3) == osmium::Location(0, 0));
+    REQUIRE(index.get(1ULL << 40U) == osmium::Location(1800000000, -900000000));
+    REQUIRE(index.get((1ULL << 40U) + 1) == osmium::Location(-1800000000, 900000000));
+    REQUIRE(index.get_noexcept(4) == osmium::Location{});
+}
+
+TEST_CASE("CompressedSparseMemArray with ids out of order") {
+    index_type index;
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 1; id < 2000; ++id) {
+        ids.push_back(id * 2);
+    }
+    std::reverse(ids.begin() + 500, ids.begin() + 1000);
+
+    for (const auto id : ids) {
+        index.set(id, test_location(id));
+    }
+    index.set(100, osmium::Location{1, 2}); // set again, must win
+
+    index.sort();
+    REQUIRE(index.size() == ids.size());
+
+    for (const auto id : ids) {
+        if (id == 100) {
+            REQUIRE(index.get(id) == osmium::Location(1, 2));
+        } else {
+            REQUIRE(index.get(id) == test_location(id));
+        }
+        REQUIRE(index.get_noexcept(id + 1) == osmium::Location{});
+    }
+
+    // Setting further ids after sort() works.
+    index.set(5000, test_location(5000));
+    REQUIRE(index.get(5000) == test_location(5000));
+}
+
+TEST_CASE("CompressedSparseMemArray clear") {
+    index_type index;
+    for (osmium::unsigned_object_id_type id = 1; id < 1000; ++id) {
+        index.set(id, test_location(id));
+    }
+    index.clear();
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.used_memory() == 0);
+    REQUIRE(index.get_noexcept(5) == osmium::Location{});
+
+    index.set(2, osmium::Location{3, 4});
+    REQUIRE(index.get(2) == osmium::Location(3, 4));
+}
+
+TEST_CASE("CompressedSparseMemArray dumps the same data as SparseMemArray") {
+    index_type index;
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> sparse;
+
+    for (osmium::unsigned_object_id_type id = 1; id < 1000; id += 3) {
+        index.set(id, test_location(id));
+        sparse.set(id, test_location(id));
+    }
+    index.set(5, test_location(5));
+    sparse.set(5, test_location(5));
+    sparse.sort();
+
+    SECTION("as list") {
+        const int fd1 = osmium::detail::create_tmp_file();
+        const int fd2 = osmium::detail::create_tmp_file();
+        index.dump_as_list(fd1);
+        sparse.dump_as_list(fd2);
+        REQUIRE(read_file(fd1) == read_file(fd2));
+        ::close(fd1);
+        ::close(fd2);
+    }
+
+    SECTION("as array") {
+        const int fd1 = osmium::detail::create_tmp_file();
+        const int fd2 = osmium::detail::create_tmp_file();
+        index.dump_as_array(fd1);
+        sparse.dump_as_array(fd2);
+        REQUIRE(read_file(fd1) == read_file(fd2));
+        ::close(fd1);
+        ::close(fd2);
+    }
+}
+
+TEST_CASE("CompressedSparseMemArray is registered in the map factory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    REQUIRE(map_factory.has_map_type("compressed_sparse_mem_array"));
+
+    auto map = map_factory.create_map("compressed_sparse_mem_array");
+    map->set(17, osmium::Location{1, 2});
+    REQUIRE(map->get(17) == osmium::Location(1, 2));
+}
@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/handler/parallel_node_locations.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/concurrent_dense_mmap_array.hpp>
+#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using index_type = osmium::index::map::ConcurrentDenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location test_location(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id % 1000000), -static_cast<int32_t>(id / 7)};
+}
+
+TEST_CASE("ConcurrentDenseMmapArray set and get") {
+    index_type index;
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.used_memory() == 0);
+
+    index.set(5, osmium::Location{1.0, 2.0});
+    index.set(3000000, osmium::Location{3.0, 4.0});
+    index.set(0, osmium::Location{0, 0});
+
+    REQUIRE(index.get(5) == osmium::Location(1.0, 2.0));
+    REQUIRE(index.get(3000000) == osmium::Location(3.0, 4.0));
+    REQUIRE(index.get(0) == osmium::Location(0, 0));
+    REQUIRE(index.get_noexcept(6) == osmium::Location{});
+    REQUIRE(index.get_noexcept(2000000) == osmium::Location{});
+    REQUIRE(index.get_noexcept(index_type::max_size()) == osmium::Location{});
+    REQUIRE_THROWS_AS(index.get(6), const osmium::not_found&);
+    REQUIRE_THROWS_AS(index.set(index_type::max_size(), osmium::Location{}), const std::range_error&);
+
+    // only the chunks with ids set use memory
+    REQUIRE(index.size() >= 3000001);
+    REQUIRE(index.used_memory() == 2 * (1U << 20U) * sizeof(osmium::Location));
+
+    index.clear();
+    REQUIRE(index.get_noexcept(5) == osmium::Location{});
+}
+
+TEST_CASE("ConcurrentDenseMmapArray filled from several threads") {
+    index_type index;
+
+    const int num_threads = 4;
+    const osmium::unsigned_object_id_type ids_per_thread = 1500000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&index, t]() {
+            // interleaved ids, so threads share chunks
+            for (osmium::unsigned_object_id_type id = t; id < num_threads * ids_per_thread; id += num_threads) {
+                index.set(id, test_location(id));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (osmium::unsigned_object_id_type id = 0; id < num_threads * ids_per_thread; ++id) {
+        if (index.get_noexcept(id) != test_location(id)) {
+            FAIL("wrong location for id " << id);
+        }
+    }
+}
+
+TEST_CASE("ConcurrentDenseMmapArray dump as array") {
+    index_type index;
+    index.set(1, osmium::Location{1.0, 2.0});
+    index.set(3, osmium::Location{3.0, 4.0});
+
+    const int fd = osmium::detail::create_tmp_file();
+    index.dump_as_array(fd);
+
+    using dense_file_array = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+    dense_file_array file_index{fd};
+    REQUIRE(osmium::file_size(fd) == index.size() * sizeof(osmium::Location));
+    REQUIRE(file_index.get_noexcept(0) == osmium::Location{});
+    REQUIRE(file_index.get(1) == osmium::Location(1.0, 2.0));
+    REQUIRE(file_index.get(3) == osmium::Location(3.0, 4.0));
+}
+
+TEST_CASE("ConcurrentDenseMmapArray from map factory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    auto index = map_factory.create_map("concurrent_dense_mmap_array");
+    index->set(17, osmium::Location{1.0, 2.0});
+    REQUIRE(index->get(17) == osmium::Location(1.0, 2.0));
+}
+
+TEST_CASE("ParallelNodeLocations stores locations from buffers") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::thread::Pool pool{3};
+    index_type index_pos;
+    index_type index_neg;
+
+    {
+        osmium::handler::ParallelNodeLocations<index_type, index_type> handler{pool, index_pos, index_neg};
+
+        for (int b = 0; b < 20; ++b) {
+            osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+            for (int n = 1; n <= 1000; ++n) {
+                const osmium::object_id_type id = b * 1000 + n;
+                osmium::builder::add_node(buffer, _id(id), _location(test_location(id)));
+            }
+            osmium::builder::add_node(buffer, _id(-b - 1), _location(test_location(b)));
+            osmium::builder::add_way(buffer, _id(b), _nodes({1, 2}));
+            handler.store(std::move(buffer));
+        }
+
+        handler.flush();
+    }
+
+    for (osmium::unsigned_object_id_type id = 1; id <= 20000; ++id) {
+        REQUIRE(index_pos.get(id) == test_location(id));
+    }
+    for (osmium::unsigned_object_id_type id = 1; id <= 20; ++id) {
+        REQUIRE(index_neg.get(id) == test_location(id - 1));
+    }
+
+    // The index can then be used with the NodeLocationsForWays handler.
+    osmium::handler::NodeLocationsForWays<index_type, index_type> location_handler{index_pos, index_neg};
+    REQUIRE(location_handler.get_node_location(123) == test_location(123));
+}
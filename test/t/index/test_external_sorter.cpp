@@ -0,0 +1,80 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/external_sorter.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+static std::vector<uint64_t> test_data(std::size_t count) {
+    std::vector<uint64_t> data;
+    for (uint64_t i = 0; i < count; ++i) {
+        data.push_back((i * 7919) % 1000);
+    }
+    return data;
+}
+
+static std::vector<uint64_t> read_all(osmium::detail::external_sorter<uint64_t>& sorter) {
+    std::vector<uint64_t> result;
+    uint64_t value = 0;
+    while (sorter.next(value)) {
+        result.push_back(value);
+    }
+    return result;
+}
+
+TEST_CASE("External sorter without any data") {
+    osmium::detail::external_sorter<uint64_t> sorter{10};
+    sorter.finish();
+    uint64_t value = 0;
+    REQUIRE_FALSE(sorter.next(value));
+    REQUIRE(sorter.num_runs() == 0);
+}
+
+TEST_CASE("External sorter with everything in memory") {
+    auto data = test_data(500);
+    osmium::detail::external_sorter<uint64_t> sorter{1000};
+    for (const auto value : data) {
+        sorter.add(value);
+    }
+    sorter.finish();
+    REQUIRE(sorter.num_runs() == 0);
+    REQUIRE(sorter.size() == 500);
+
+    std::sort(data.begin(), data.end());
+    REQUIRE(read_all(sorter) == data);
+}
+
+TEST_CASE("External sorter with several runs") {
+    auto data = test_data(100000);
+    osmium::detail::external_sorter<uint64_t> sorter{777};
+    for (const auto value : data) {
+        sorter.add(value);
+    }
+    sorter.finish();
+    REQUIRE(sorter.num_runs() == 129);
+    REQUIRE(sorter.size() == 100000);
+
+    std::sort(data.begin(), data.end());
+    REQUIRE(read_all(sorter) == data);
+
+    REQUIRE_THROWS_AS(sorter.add(1), const std::logic_error&);
+}
+
+TEST_CASE("External sorter with custom order") {
+    auto data = test_data(1000);
+    osmium::detail::external_sorter<uint64_t, std::greater<uint64_t>> sorter{100};
+    for (const auto value : data) {
+        sorter.add(value);
+    }
+    sorter.finish();
+
+    std::sort(data.begin(), data.end(), std::greater<uint64_t>{});
+    std::vector<uint64_t> result;
+    uint64_t value = 0;
+    while (sorter.next(value)) {
+        result.push_back(value);
+    }
+    REQUIRE(result == data);
+}
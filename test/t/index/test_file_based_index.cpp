@@ -2,6 +2,7 @@
 
 #include <osmium/index/detail/tmpfile.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/map/dense_mmap_array.hpp>
 #include <osmium/index/map/sparse_file_array.hpp>
 #include <osmium/index/node_locations_map.hpp>
 #include <osmium/osm/location.hpp>
@@ -89,6 +90,45 @@ TEST_CASE("File based dense index") {
     }
 }
 
+TEST_CASE("File based dense index with huge pages") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    const osmium::Location loc{1.2, 4.5};
+
+    SECTION("temporary file") {
+        auto index = map_factory.create_map("dense_file_array,transparent_huge_pages");
+        index->set(1000, loc);
+        REQUIRE(index->get(1000) == loc);
+        REQUIRE(index->size() == 1001);
+    }
+
+    SECTION("given file") {
+        const int fd = osmium::detail::create_tmp_file();
+        using index_type = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+        {
+            index_type index{fd, osmium::MemoryMapping::huge_pages_mode::transparent};
+            index.set(1000, loc);
+            REQUIRE(index.get(1000) == loc);
+        }
+        REQUIRE(osmium::file_size(fd) >= 1001 * sizeof(osmium::Location));
+    }
+}
+
+#ifdef __linux__
+TEST_CASE("Dense mmap index with huge pages") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    const osmium::Location loc{1.2, 4.5};
+
+    for (const char* config : {"dense_mmap_array", "dense_mmap_array,huge_pages", "dense_mmap_array,transparent_huge_pages"}) {
+        auto index = map_factory.create_map(config);
+        index->set(17, loc);
+        index->set(5000000, loc);
+        REQUIRE(index->get(17) == loc);
+        REQUIRE(index->get(5000000) == loc);
+        REQUIRE(index->get_noexcept(18) == osmium::Location{});
+    }
+}
+#endif
+
 TEST_CASE("File based sparse index") {
     const int fd = osmium::detail::create_tmp_file();
 
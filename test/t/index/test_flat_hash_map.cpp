@@ -0,0 +1,161 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/flat_hash_map.hpp>
+#include <osmium/index/map/sparse_mem_map.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using index_type = osmium::index::map::FlatHashMap<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location test_location(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id * 37 % 3600000000 / 2) - 900000000,
+                            static_cast<int32_t>(id * 13 % 1800000000) - 900000000};
+}
+
+static std::string read_file(const int fd) {
+    const auto size = osmium::file_size(fd);
+    std::string data(size, '\0');
+    REQUIRE(::lseek(fd, 0, SEEK_SET) == 0);
+    REQUIRE(::read(fd, &data[0], size) == static_cast<ssize_t>(size));
+    return data;
+}
+
+TEST_CASE("FlatHashMap is empty to begin with") {
+    const index_type index;
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.used_memory() == 0);
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    REQUIRE_THROWS_AS(index.get(17), const osmium::not_found&);
+}
+
+TEST_CASE("FlatHashMap with ids set and removed in random order") {
+    index_type index;
+    std::map<osmium::unsigned_object_id_type, osmium::Location> expected;
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<osmium::unsigned_object_id_type> id_dist{0, 5000};
+    for (int i = 0; i < 20000; ++i) {
+        const auto id = id_dist(gen);
+        if (i % 3 == 0) {
+            index.set(id, osmium::Location{});
+            expected.erase(id);
+        } else {
+            const auto location = test_location(id + static_cast<osmium::unsigned_object_id_type>(i));
+            index.set(id, location);
+            expected[id] = location;
+        }
+    }
+
+    REQUIRE(index.size() == expected.size());
+    REQUIRE(index.used_memory() <= index.size() * 16 * 2 * 4 / 3 + 16 * 16);
+
+    for (osmium::unsigned_object_id_type id = 0; id <= 5001; ++id) {
+        const auto it = expected.find(id);
+        if (it == expected.end()) {
+            REQUIRE(index.get_noexcept(id) == osmium::Location{});
+        } else {
+            REQUIRE(index.get(id) == it->second);
+        }
+    }
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 0; id <= 5001; id += 7) {
+        ids.push_back(id);
+    }
+    std::vector<osmium::Location> values(ids.size());
+    index.get_many(ids.data(), values.data(), ids.size());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(values[i] == index.get_noexcept(ids[i]));
+    }
+}
+
+TEST_CASE("FlatHashMap with large ids") {
+    index_type index;
+    index.reserve(1000);
+    const auto memory = index.used_memory();
+    REQUIRE(memory >= 1000 * 16);
+
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+        index.set(id << 40U, test_location(id));
+    }
+    REQUIRE(index.used_memory() == memory);
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+        REQUIRE(index.get(id << 40U) == test_location(id));
+        REQUIRE(index.get_noexcept(id) == osmium::Location{});
+    }
+
+    index.clear();
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.used_memory() == 0);
+    REQUIRE(index.get_noexcept(1ULL << 40U) == osmium::Location{});
+}
+
+TEST_CASE("FlatHashMap concurrent reads") {
+    index_type index;
+    for (osmium::unsigned_object_id_type id = 1; id <= 10000; ++id) {
+        index.set(id * 3, test_location(id * 3));
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<int> errors(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&index, &errors, t]() {
+            for (osmium::unsigned_object_id_type id = 1; id <= 10000; ++id) {
+                if (index.get_noexcept(id * 3) != test_location(id * 3)) {
+                    ++errors[t];
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(errors == std::vector<int>(4, 0));
+}
+
+TEST_CASE("FlatHashMap dumps the same data as SparseMemMap") {
+    index_type index;
+    osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::Location> sparse;
+
+    for (int i = 1000; i > 0; i -= 3) {
+        const auto id = static_cast<osmium::unsigned_object_id_type>(i);
+        index.set(id, test_location(id));
+        sparse.set(id, test_location(id));
+    }
+
+    const int fd1 = osmium::detail::create_tmp_file();
+    const int fd2 = osmium::detail::create_tmp_file();
+    index.dump_as_list(fd1);
+    sparse.dump_as_list(fd2);
+    REQUIRE(read_file(fd1) == read_file(fd2));
+    ::close(fd1);
+    ::close(fd2);
+
+    const int fd3 = osmium::detail::create_tmp_file();
+    index.dump_as_array(fd3);
+    const auto array = read_file(fd3);
+    REQUIRE(array.size() == 1001 * sizeof(osmium::Location));
+    ::close(fd3);
+}
+
+TEST_CASE("FlatHashMap is registered in the map factory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    REQUIRE(map_factory.has_map_type("flat_hash"));
+
+    auto map = map_factory.create_map("flat_hash");
+    map->set(17, osmium::Location{1, 2});
+    REQUIRE(map->get(17) == osmium::Location(1, 2));
+}
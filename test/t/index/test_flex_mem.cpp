@@ -0,0 +1,120 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using id_type = osmium::unsigned_object_id_type;
+using index_type = osmium::index::map::FlexMem<id_type, osmium::Location>;
+
+static std::vector<id_type> shuffled_ids() {
+    std::vector<id_type> ids;
+    for (id_type id = 1; id < 1000000; id += 3) {
+        ids.push_back(id);
+    }
+    std::mt19937 gen{42};
+    std::shuffle(ids.begin(), ids.end(), gen);
+    return ids;
+}
+
+static osmium::Location location_for(const id_type id) {
+    return osmium::Location{static_cast<int32_t>(id), 7};
+}
+
+static void check_lookups(const index_type& index) {
+    for (id_type id = 0; id < 1000010; ++id) {
+        if (id % 3 == 1 && id < 1000000) {
+            REQUIRE(index.get_noexcept(id) == location_for(id));
+        } else {
+            REQUIRE_FALSE(index.get_noexcept(id).valid());
+        }
+    }
+}
+
+TEST_CASE("FlexMem sort on thread pool") {
+    osmium::thread::Pool pool{4};
+    index_type index;
+    index.set_thread_pool(pool);
+    index.reserve(1000);
+
+    for (const auto id : shuffled_ids()) {
+        index.set(id, location_for(id));
+    }
+    index.sort();
+
+    REQUIRE_FALSE(index.is_dense());
+    check_lookups(index);
+}
+
+TEST_CASE("FlexMem switch to dense on thread pool") {
+    osmium::thread::Pool pool{4};
+    index_type index;
+    index.set_thread_pool(pool);
+
+    for (const auto id : shuffled_ids()) {
+        index.set(id, location_for(id));
+    }
+    // Duplicate id, the last value must win
+    index.set(4, osmium::Location{1, 1});
+    index.set(4, location_for(4));
+
+    index.switch_to_dense();
+    REQUIRE(index.is_dense());
+    REQUIRE(index.stats().first == 1000000 / 65536 + 1);
+    check_lookups(index);
+}
+
+TEST_CASE("FlexMem reserve dense blocks up front") {
+    index_type index;
+
+    SECTION("with thread pool") {
+        osmium::thread::Pool pool{3};
+        index.set_thread_pool(pool);
+        index.set(17, location_for(17));
+        index.reserve_dense(1000000);
+    }
+
+    SECTION("without thread pool") {
+        index.set(17, location_for(17));
+        index.reserve_dense(1000000);
+    }
+
+    REQUIRE(index.is_dense());
+    REQUIRE(index.stats().first == 1000000 / 65536 + 1);
+    REQUIRE(index.stats().second == 0);
+    REQUIRE(index.get(17) == location_for(17));
+    REQUIRE_FALSE(index.get_noexcept(18).valid());
+
+    index.set(999999, location_for(999999));
+    REQUIRE(index.get(999999) == location_for(999999));
+    REQUIRE(index.stats().first == 1000000 / 65536 + 1);
+}
+
+TEST_CASE("FlexMem presize picks mode up front") {
+    index_type index;
+
+    SECTION("dense") {
+        index.presize(0x1000000, 0x2000000);
+        REQUIRE(index.is_dense());
+        REQUIRE(index.stats().first == 0x2000000 / 65536 + 1);
+    }
+
+    SECTION("sparse because of few entries") {
+        index.presize(1000, 2000);
+        REQUIRE_FALSE(index.is_dense());
+    }
+
+    SECTION("sparse because ids are spread out") {
+        index.presize(0x1000000, 0x10000000);
+        REQUIRE_FALSE(index.is_dense());
+    }
+
+    index.set(17, location_for(17));
+    REQUIRE(index.get(17) == location_for(17));
+}
@@ -0,0 +1,69 @@
+#include "catch.hpp"
+
+#include <osmium/index/multimap/hybrid.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using hybrid_type = osmium::index::multimap::Hybrid<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+
+static std::vector<osmium::unsigned_object_id_type> get_all(hybrid_type& map, const osmium::unsigned_object_id_type id) {
+    std::vector<osmium::unsigned_object_id_type> values;
+    const auto range = map.get_all(id);
+    for (auto it = range.first; it != range.second; ++it) {
+        values.push_back(it->second);
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+TEST_CASE("Hybrid multimap finds elements in main and extra part") {
+    hybrid_type map;
+    map.unsorted_set(3, 30);
+    map.unsorted_set(1, 10);
+    map.unsorted_set(3, 31);
+    map.sort();
+
+    map.set(2, 20);
+    map.set(3, 32);
+    REQUIRE(map.size() == 5);
+
+    REQUIRE(get_all(map, 1) == (std::vector<osmium::unsigned_object_id_type>{10}));
+    REQUIRE(get_all(map, 2) == (std::vector<osmium::unsigned_object_id_type>{20}));
+    REQUIRE(get_all(map, 3) == (std::vector<osmium::unsigned_object_id_type>{30, 31, 32}));
+    REQUIRE(get_all(map, 4).empty());
+}
+
+TEST_CASE("Hybrid multimap consolidate merges extra part") {
+    hybrid_type map;
+    for (osmium::unsigned_object_id_type id = 1000; id > 0; id -= 2) {
+        map.unsorted_set(id, id * 10);
+    }
+    map.sort();
+
+    // consolidate several times as with a stream of change files
+    for (osmium::unsigned_object_id_type round = 0; round < 3; ++round) {
+        for (osmium::unsigned_object_id_type id = 9; id < 1000; id += 10) {
+            map.set(id + round, round + 1);
+        }
+        map.remove(502, 5020);
+        map.consolidate();
+    }
+
+    REQUIRE(map.size() == 500 - 1 + 3 * 100);
+    REQUIRE(get_all(map, 502).empty());
+    REQUIRE(get_all(map, 998) == (std::vector<osmium::unsigned_object_id_type>{9980}));
+    REQUIRE(get_all(map, 999) == (std::vector<osmium::unsigned_object_id_type>{1}));
+    REQUIRE(get_all(map, 1000) == (std::vector<osmium::unsigned_object_id_type>{2, 10000}));
+    REQUIRE(get_all(map, 1001) == (std::vector<osmium::unsigned_object_id_type>{3}));
+    REQUIRE(get_all(map, 9) == (std::vector<osmium::unsigned_object_id_type>{1}));
+    REQUIRE(get_all(map, 10) == (std::vector<osmium::unsigned_object_id_type>{2, 100}));
+
+    // main part is sorted again if needed
+    map.unsorted_set(1, 1);
+    map.consolidate();
+    REQUIRE(get_all(map, 1) == (std::vector<osmium::unsigned_object_id_type>{1}));
+    REQUIRE(get_all(map, 2) == (std::vector<osmium::unsigned_object_id_type>{20}));
+}
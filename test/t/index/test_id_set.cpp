@@ -3,6 +3,11 @@
 #include <osmium/index/id_set.hpp>
 #include <osmium/osm/types.hpp>
 
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <vector>
+
 TEST_CASE("Basic functionality of IdSetDense") {
     osmium::index::IdSetDense<osmium::unsigned_object_id_type> s;
 
@@ -131,6 +136,113 @@ TEST_CASE("Large gap") {
     REQUIRE_FALSE(s.get(1U << 29U));
 }
 
+TEST_CASE("Reserve chunk directory of IdSetDense") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type, 3> s;
+
+    s.reserve(1000);
+    REQUIRE(s.empty());
+    REQUIRE(s.num_chunks() == 1000 / 64 + 1);
+    REQUIRE(s.begin() == s.end());
+
+    s.set(999);
+    REQUIRE(s.num_chunks() == 1000 / 64 + 1);
+    REQUIRE(s.get(999));
+    REQUIRE(*s.begin() == 999);
+}
+
+template <typename TSet>
+static std::vector<osmium::unsigned_object_id_type> to_vector(const TSet& s) {
+    return std::vector<osmium::unsigned_object_id_type>(s.begin(), s.end());
+}
+
+TEST_CASE("Iterating over IdSetDense with small chunks") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type, 3> s;
+    const std::vector<osmium::unsigned_object_id_type> ids = {0, 1, 7, 8, 63, 64, 65, 127, 128, 200, 1000, 1001, 5000};
+    for (const auto id : ids) {
+        s.set(id);
+    }
+    REQUIRE(to_vector(s) == ids);
+}
+
+TEST_CASE("Check ranges in IdSetDense") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type, 3> s;
+    REQUIRE_FALSE(s.any_in_range(0, 1000));
+
+    s.set(70);
+    s.set(1000);
+
+    REQUIRE(s.any_in_range(70, 70));
+    REQUIRE(s.any_in_range(0, 70));
+    REQUIRE(s.any_in_range(65, 71));
+    REQUIRE_FALSE(s.any_in_range(0, 69));
+    REQUIRE_FALSE(s.any_in_range(71, 999));
+    REQUIRE(s.any_in_range(71, 1000));
+    REQUIRE(s.any_in_range(0, 100000));
+    REQUIRE_FALSE(s.any_in_range(1001, 100000));
+
+    // compare with the generic implementation in the base class
+    const osmium::index::IdSet<osmium::unsigned_object_id_type>& base = s;
+    for (osmium::unsigned_object_id_type first = 60; first < 80; ++first) {
+        for (osmium::unsigned_object_id_type last = first; last < 140; ++last) {
+            REQUIRE(s.any_in_range(first, last) == base.IdSet::any_in_range(first, last));
+        }
+    }
+}
+
+TEST_CASE("Bulk operations on IdSetDense") {
+    using set_type = osmium::index::IdSetDense<osmium::unsigned_object_id_type, 6>;
+    set_type a;
+    set_type b;
+    std::set<osmium::unsigned_object_id_type> ra;
+    std::set<osmium::unsigned_object_id_type> rb;
+
+    for (osmium::unsigned_object_id_type i = 0; i < 20000; i += 3) {
+        a.set(i);
+        ra.insert(i);
+    }
+    for (osmium::unsigned_object_id_type i = 5000; i < 40000; i += 5) {
+        b.set(i);
+        rb.insert(i);
+    }
+    b.set(100000);
+    rb.insert(100000);
+
+    std::vector<osmium::unsigned_object_id_type> expected;
+
+    SECTION("merge") {
+        a.merge(b);
+        std::set_union(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(expected));
+    }
+
+    SECTION("intersect") {
+        a.intersect(b);
+        std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(expected));
+        REQUIRE(a.used_memory() < b.used_memory());
+    }
+
+    SECTION("subtract") {
+        a.subtract(b);
+        std::set_difference(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(expected));
+    }
+
+    SECTION("intersect with empty set") {
+        a.intersect(set_type{});
+        REQUIRE(a.empty());
+    }
+
+    SECTION("subtract itself") {
+        const set_type c{a};
+        a.subtract(c);
+        REQUIRE(a.empty());
+    }
+
+    REQUIRE(to_vector(a) == expected);
+    REQUIRE(a.size() == expected.size());
+    for (const auto id : expected) {
+        REQUIRE(a.get(id));
+    }
+}
+
 TEST_CASE("Basic functionality of IdSetSmall") {
     osmium::index::IdSetSmall<osmium::unsigned_object_id_type> s;
 
@@ -160,6 +272,19 @@ TEST_CASE("Basic functionality of IdSetSmall") {
     REQUIRE(s.empty());
 }
 
+TEST_CASE("Check ranges in IdSetSmall") {
+    osmium::index::IdSetSmall<osmium::unsigned_object_id_type> s;
+    REQUIRE_FALSE(s.any_in_range(0, 1000));
+
+    s.set(28);
+    s.set(17);
+
+    REQUIRE(s.any_in_range(17, 17));
+    REQUIRE(s.any_in_range(20, 30));
+    REQUIRE_FALSE(s.any_in_range(18, 27));
+    REQUIRE_FALSE(s.any_in_range(29, 1000));
+}
+
 TEST_CASE("Copying IdSetSmall") {
     osmium::index::IdSetSmall<osmium::unsigned_object_id_type> s1;
     osmium::index::IdSetSmall<osmium::unsigned_object_id_type> s2;
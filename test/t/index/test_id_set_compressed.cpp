@@ -0,0 +1,125 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_set_compressed.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+using id_set = osmium::index::IdSetCompressed<osmium::unsigned_object_id_type>;
+
+static void check_same(const id_set& s, const std::set<osmium::unsigned_object_id_type>& expected) {
+    REQUIRE(s.size() == expected.size());
+    REQUIRE(std::vector<osmium::unsigned_object_id_type>(s.begin(), s.end()) ==
+            std::vector<osmium::unsigned_object_id_type>(expected.begin(), expected.end()));
+    for (const auto id : expected) {
+        REQUIRE(s.get(id));
+        REQUIRE_FALSE(s.get(id + (1ULL << 40U)));
+    }
+}
+
+TEST_CASE("Basic functionality of IdSetCompressed") {
+    id_set s;
+
+    REQUIRE(s.empty());
+    REQUIRE(s.begin() == s.end());
+    REQUIRE_FALSE(s.get(17));
+
+    s.set(17);
+    REQUIRE(s.get(17));
+    REQUIRE_FALSE(s.get(16));
+    REQUIRE(s.size() == 1);
+
+    REQUIRE(s.check_and_set(1 << 20));
+    REQUIRE_FALSE(s.check_and_set(1 << 20));
+    s.set(3);
+    REQUIRE(s.size() == 3);
+
+    check_same(s, {3, 17, 1 << 20});
+
+    s.unset(17);
+    s.unset(18);
+    check_same(s, {3, 1 << 20});
+
+    s.clear();
+    REQUIRE(s.empty());
+    REQUIRE(s.begin() == s.end());
+}
+
+TEST_CASE("IdSetCompressed with large blocks converts to bitmap and back") {
+    id_set s;
+    std::set<osmium::unsigned_object_id_type> expected;
+
+    for (osmium::unsigned_object_id_type id = 100000; id < 160000; id += 3) {
+        s.set(id);
+        expected.insert(id);
+    }
+    check_same(s, expected);
+
+    for (osmium::unsigned_object_id_type id = 100000; id < 160000; id += 6) {
+        s.unset(id);
+        expected.erase(id);
+    }
+    check_same(s, expected);
+}
+
+TEST_CASE("IdSetCompressed optimize uses runs for consecutive ids") {
+    id_set s;
+    std::set<osmium::unsigned_object_id_type> expected;
+
+    for (osmium::unsigned_object_id_type id = 1000; id < 200000; ++id) {
+        s.set(id);
+        expected.insert(id);
+    }
+    s.set(500000);
+    expected.insert(500000);
+
+    const auto before = s.used_memory();
+    s.optimize();
+    REQUIRE(s.used_memory() < before / 50);
+    check_same(s, expected);
+
+    // sets and unsets still work after conversion to runs
+    s.unset(5000);
+    expected.erase(5000);
+    s.set(300000);
+    expected.insert(300000);
+    check_same(s, expected);
+}
+
+TEST_CASE("IdSetCompressed with random ids") {
+    std::mt19937_64 gen{42};
+    std::uniform_int_distribution<osmium::unsigned_object_id_type> dist{0, 20000000};
+
+    id_set s;
+    std::set<osmium::unsigned_object_id_type> expected;
+
+    for (int i = 0; i < 100000; ++i) {
+        const auto id = dist(gen);
+        REQUIRE(s.check_and_set(id) == expected.insert(id).second);
+    }
+    check_same(s, expected);
+
+    for (int i = 0; i < 50000; ++i) {
+        const auto id = dist(gen);
+        s.unset(id);
+        expected.erase(id);
+    }
+    s.optimize();
+    check_same(s, expected);
+}
+
+TEST_CASE("IdSetCompressed in nwr_array") {
+    osmium::nwr_array<id_set> sets;
+
+    sets(osmium::item_type::node).set(17);
+    sets(osmium::item_type::way).set(42);
+
+    REQUIRE(sets(osmium::item_type::node).get(17));
+    REQUIRE_FALSE(sets(osmium::item_type::node).get(42));
+    REQUIRE(sets(osmium::item_type::way).get(42));
+    REQUIRE(sets(osmium::item_type::relation).empty());
+}
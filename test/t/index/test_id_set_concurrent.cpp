@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_set_concurrent.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using id_set = osmium::index::ConcurrentIdSetDense<osmium::unsigned_object_id_type, 3>;
+
+TEST_CASE("Basic functionality of ConcurrentIdSetDense") {
+    id_set s{1000};
+
+    REQUIRE(s.empty());
+    REQUIRE(s.size() == 0);
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE_FALSE(s.get(1ULL << 40U));
+
+    s.set(17);
+    REQUIRE(s.get(17));
+    REQUIRE_FALSE(s.get(16));
+    REQUIRE_FALSE(s.empty());
+    REQUIRE(s.size() == 1);
+
+    REQUIRE(s.check_and_set(999));
+    REQUIRE_FALSE(s.check_and_set(999));
+    s.set(3);
+    REQUIRE(s.size() == 3);
+
+    REQUIRE(s.any_in_range(0, 3));
+    REQUIRE_FALSE(s.any_in_range(4, 16));
+    REQUIRE(s.any_in_range(4, 17));
+    REQUIRE_FALSE(s.any_in_range(18, 998));
+    REQUIRE(s.any_in_range(18, 999));
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    s.for_each([&](osmium::unsigned_object_id_type id) {
+        ids.push_back(id);
+    });
+    REQUIRE(ids == (std::vector<osmium::unsigned_object_id_type>{3, 17, 999}));
+
+    REQUIRE_THROWS_AS(s.set(1024), const std::out_of_range&);
+
+    REQUIRE(s.used_memory() > 0);
+    s.clear();
+    REQUIRE(s.empty());
+    REQUIRE_FALSE(s.get(17));
+}
+
+TEST_CASE("Merge ConcurrentIdSetDense into IdSetDense") {
+    id_set s{1000};
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type, 3> dense;
+
+    dense.set(5);
+    dense.set(70);
+    s.set(5);
+    s.set(6);
+    s.set(64);
+    s.set(800);
+
+    s.merge_into(dense);
+    REQUIRE(dense.size() == 5);
+    REQUIRE(std::vector<osmium::unsigned_object_id_type>(dense.begin(), dense.end()) ==
+            (std::vector<osmium::unsigned_object_id_type>{5, 6, 64, 70, 800}));
+}
+
+TEST_CASE("Fill ConcurrentIdSetDense from several threads") {
+    osmium::index::ConcurrentIdSetDense<osmium::unsigned_object_id_type, 10> s;
+    std::atomic<std::size_t> added{0};
+
+    const unsigned int num_threads = 4;
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&s, &added, t]() {
+            // All threads set overlapping Ids in all chunks.
+            for (osmium::unsigned_object_id_type id = t; id < 200000; id += 2) {
+                if (s.check_and_set(id * 3)) {
+                    ++added;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Every Id was set by two threads, but added by only one of them.
+    REQUIRE(added == 200000);
+    REQUIRE(s.size() == 200000);
+    for (osmium::unsigned_object_id_type id = 0; id < 200000; ++id) {
+        REQUIRE(s.get(id * 3));
+        REQUIRE_FALSE(s.get(id * 3 + 1));
+    }
+}
+
+TEST_CASE("ConcurrentNWRIdSetDense") {
+    osmium::index::ConcurrentNWRIdSetDense sets;
+
+    std::thread thread{[&sets]() {
+        for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+            sets(osmium::item_type::node).set(id);
+        }
+    }};
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000; id += 2) {
+        sets(osmium::item_type::way).set(id);
+    }
+    thread.join();
+
+    REQUIRE(sets(osmium::item_type::node).size() == 1000);
+    REQUIRE(sets(osmium::item_type::way).size() == 500);
+    REQUIRE(sets(osmium::item_type::relation).empty());
+    REQUIRE(sets(osmium::item_type::way).get(999));
+    REQUIRE_FALSE(sets(osmium::item_type::way).get(1000));
+}
@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/id_set_compressed.hpp>
+#include <osmium/index/id_set_mapped.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using id_type = osmium::unsigned_object_id_type;
+
+static std::set<id_type> test_ids() {
+    std::mt19937_64 gen{17};
+    std::uniform_int_distribution<id_type> dist{0, 10000000};
+
+    std::set<id_type> ids;
+    for (int i = 0; i < 20000; ++i) {
+        ids.insert(dist(gen));
+    }
+    for (id_type id = 20000000; id < 20100000; ++id) {
+        ids.insert(id);
+    }
+    return ids;
+}
+
+template <typename TSet>
+static std::vector<id_type> all_ids(const TSet& set) {
+    std::vector<id_type> result;
+    set.for_each([&result](id_type id) {
+        result.push_back(id);
+    });
+    return result;
+}
+
+TEST_CASE("Write IdSetDense to file and map it") {
+    const auto ids = test_ids();
+    osmium::index::IdSetDense<id_type, 16> set;
+    for (const auto id : ids) {
+        set.set(id);
+    }
+
+    const int fd = osmium::detail::create_tmp_file();
+    osmium::index::write_id_set(fd, set);
+
+    const osmium::index::IdSetDenseMapped<id_type, 16> mapped{fd};
+    REQUIRE_FALSE(mapped.empty());
+    REQUIRE(mapped.size() == ids.size());
+    REQUIRE(all_ids(mapped) == std::vector<id_type>(ids.begin(), ids.end()));
+    for (id_type id = 0; id < 30000000; id += 997) {
+        REQUIRE(mapped.get(id) == set.get(id));
+    }
+    REQUIRE_FALSE(mapped.get(1ULL << 40U));
+
+    REQUIRE_THROWS_AS((osmium::index::IdSetDenseMapped<id_type, 17>{fd}), const std::runtime_error&);
+    REQUIRE_THROWS_AS(osmium::index::IdSetCompressedMapped<id_type>{fd}, const std::runtime_error&);
+
+    osmium::io::detail::reliable_close(fd);
+}
+
+TEST_CASE("Write empty IdSetDense to file and map it") {
+    const osmium::index::IdSetDense<id_type> set;
+
+    const int fd = osmium::detail::create_tmp_file();
+    osmium::index::write_id_set(fd, set);
+
+    const osmium::index::IdSetDenseMapped<id_type> mapped{fd};
+    REQUIRE(mapped.empty());
+    REQUIRE_FALSE(mapped.get(17));
+    REQUIRE(all_ids(mapped).empty());
+
+    osmium::io::detail::reliable_close(fd);
+}
+
+TEST_CASE("Write IdSetCompressed to file and map it") {
+    const auto ids = test_ids();
+    osmium::index::IdSetCompressed<id_type> set;
+    for (const auto id : ids) {
+        set.set(id);
+    }
+    // make sure we have all container types
+    for (id_type id = 40000000; id < 40060000; id += 2) {
+        set.set(id);
+    }
+    set.optimize();
+
+    const int fd = osmium::detail::create_tmp_file();
+    osmium::index::write_id_set(fd, set);
+
+    const osmium::index::IdSetCompressedMapped<id_type> mapped{fd};
+    REQUIRE(mapped.size() == set.size());
+    REQUIRE(all_ids(mapped) == std::vector<id_type>(set.begin(), set.end()));
+    for (id_type id = 0; id < 50000000; id += 991) {
+        REQUIRE(mapped.get(id) == set.get(id));
+    }
+
+    REQUIRE_THROWS_AS(osmium::index::IdSetDenseMapped<id_type>{fd}, const std::runtime_error&);
+
+    osmium::io::detail::reliable_close(fd);
+}
+
+TEST_CASE("Mapping empty file as IdSet fails") {
+    const int fd = osmium::detail::create_tmp_file();
+    REQUIRE_THROWS_AS(osmium::index::IdSetCompressedMapped<id_type>{fd}, const std::runtime_error&);
+    osmium::io::detail::reliable_close(fd);
+}
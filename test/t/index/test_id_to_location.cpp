@@ -1,10 +1,15 @@
 #include "catch.hpp"
 
+#include <osmium/index/map/compact_sparse_mem_array.hpp>
+#include <osmium/index/map/compressed_sparse_mem_array.hpp>
+#include <osmium/index/map/concurrent_dense_mmap_array.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/dense_mmap_array.hpp>
 #include <osmium/index/map/dummy.hpp>
+#include <osmium/index/map/flat_hash_map.hpp>
 #include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/quantized_dense_mem_array.hpp>
 #include <osmium/index/map/sparse_file_array.hpp>
 #include <osmium/index/map/sparse_mem_array.hpp>
 #include <osmium/index/map/sparse_mem_map.hpp>
@@ -119,6 +124,15 @@ TEST_CASE("Map Id to location: DenseMemArray") {
     test_func_real<index_type>(index2);
 }
 
+TEST_CASE("Map Id to location: presize DenseMemArray") {
+    using index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index;
+    index.presize(10, 1000);
+    REQUIRE(index.size() == 0);
+    test_func_real<index_type>(index);
+}
+
 #ifdef __linux__
 TEST_CASE("Map Id to location: DenseMmapArray") {
     using index_type = osmium::index::map::DenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
@@ -133,6 +147,46 @@ TEST_CASE("Map Id to location: DenseMmapArray") {
 # pragma message("not running 'DenseMmapArray' test case on this machine")
 #endif
 
+TEST_CASE("Map Id to location: QuantizedDenseMemArray") {
+    using index_type = osmium::index::map::QuantizedDenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: CompactSparseMemArray") {
+    using index_type = osmium::index::map::CompactSparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: CompressedSparseMemArray") {
+    using index_type = osmium::index::map::CompressedSparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: ConcurrentDenseMmapArray") {
+    using index_type = osmium::index::map::ConcurrentDenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
 TEST_CASE("Map Id to location: DenseFileArray") {
     using index_type = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
 
@@ -157,6 +211,16 @@ TEST_CASE("Map Id to location: SparseMemTable") {
 
 #endif
 
+TEST_CASE("Map Id to location: FlatHashMap") {
+    using index_type = osmium::index::map::FlatHashMap<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
 TEST_CASE("Map Id to location: SparseMemMap") {
     using index_type = osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::Location>;
 
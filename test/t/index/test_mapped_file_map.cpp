@@ -0,0 +1,269 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/mapped_file_map.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_map.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+using id_type = osmium::unsigned_object_id_type;
+using mapped_file_map = osmium::index::map::MappedFileMap<id_type, osmium::Location>;
+
+static osmium::Location location_for(const id_type id) {
+    return osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id * 3)};
+}
+
+template <typename TIndex>
+static void fill(TIndex& index) {
+    for (id_type id = 3; id < 10000; id += 7) {
+        index.set(id, location_for(id));
+    }
+    index.sort();
+}
+
+static void check_lookups(const mapped_file_map& map) {
+    for (id_type id = 0; id < 10010; ++id) {
+        if (id % 7 == 3 && id < 10000) {
+            REQUIRE(map.get(id) == location_for(id));
+        } else {
+            REQUIRE_FALSE(map.get_noexcept(id).valid());
+        }
+    }
+    REQUIRE_THROWS_AS(map.get(4), const osmium::not_found&);
+    REQUIRE_THROWS_AS(map.get(20000), const osmium::not_found&);
+}
+
+TEST_CASE("Write dense map and open as MappedFileMap") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::DenseMemArray<id_type, osmium::Location> index;
+    fill(index);
+    osmium::index::write_map_file(fd, index);
+
+    const mapped_file_map map{fd};
+    REQUIRE(map.is_dense());
+    REQUIRE(map.size() == index.size());
+    check_lookups(map);
+}
+
+TEST_CASE("Write sparse map and open as MappedFileMap") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::SparseMemArray<id_type, osmium::Location> index;
+    fill(index);
+    osmium::index::write_map_file(fd, index);
+
+    mapped_file_map map{fd};
+    REQUIRE_FALSE(map.is_dense());
+    REQUIRE(map.size() == index.size());
+    map.set_access_hint(osmium::MemoryMapping::access_hint::random);
+    check_lookups(map);
+
+    REQUIRE_THROWS_AS(map.set(1, location_for(1)), const std::runtime_error&);
+
+    map.clear();
+    REQUIRE(map.size() == 0);
+}
+
+TEST_CASE("Write empty sparse map and open as MappedFileMap") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::SparseMemArray<id_type, osmium::Location> index;
+    osmium::index::write_map_file(fd, index);
+    REQUIRE(osmium::file_size(fd) == 64);
+
+    const mapped_file_map map{fd};
+    REQUIRE(map.size() == 0);
+    REQUIRE_FALSE(map.get_noexcept(0).valid());
+}
+
+TEST_CASE("Write map with dump_as_list() and open as MappedFileMap") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::SparseMemMap<id_type, osmium::Location> index;
+    fill(index);
+    osmium::index::map::Map<id_type, osmium::Location>& base = index;
+    osmium::index::write_map_file(fd, base);
+
+    const mapped_file_map map{fd};
+    REQUIRE_FALSE(map.is_dense());
+    REQUIRE(map.size() == index.size());
+    check_lookups(map);
+}
+
+TEST_CASE("Write map without dump_as_list() support") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::DenseMemArray<id_type, osmium::Location> index;
+    fill(index);
+    osmium::index::map::Map<id_type, osmium::Location>& base = index;
+    REQUIRE_THROWS_AS(osmium::index::write_map_file(fd, base), const std::runtime_error&);
+    REQUIRE_THROWS_AS(mapped_file_map{fd}, const std::runtime_error&);
+}
+
+TEST_CASE("Write map file data in parallel chunks") {
+    std::vector<char> data(100000);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 13);
+    }
+
+    const int fd = osmium::detail::create_tmp_file();
+    osmium::thread::Pool pool{4};
+    osmium::index::detail::write_map_file_data(fd, data.data(), data.size(), 64, pool, 1000);
+    REQUIRE(osmium::file_size(fd) == data.size() + 64);
+
+    std::vector<char> result(data.size() + 64);
+    REQUIRE(osmium::io::detail::reliable_read(fd, result.data(), static_cast<unsigned int>(result.size())) == result.size());
+    REQUIRE(std::equal(data.begin(), data.end(), result.begin() + 64));
+}
+
+TEST_CASE("MappedFileMap checks the file") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    SECTION("empty file") {
+        REQUIRE_THROWS_AS(mapped_file_map{fd}, const std::runtime_error&);
+    }
+
+    SECTION("wrong magic") {
+        const std::vector<uint64_t> header(8, 1);
+        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(header.data()), header.size() * sizeof(uint64_t));
+        REQUIRE_THROWS_AS(mapped_file_map{fd}, const std::runtime_error&);
+    }
+
+    SECTION("wrong value size") {
+        osmium::index::map::SparseMemArray<id_type, uint32_t> index;
+        index.set(1, 17);
+        osmium::index::write_map_file(fd, index);
+        REQUIRE_THROWS_AS(mapped_file_map{fd}, const std::runtime_error&);
+        const osmium::index::map::MappedFileMap<id_type, uint32_t> map{fd};
+        REQUIRE(map.get(1) == 17);
+    }
+
+    SECTION("file too short") {
+        osmium::index::map::SparseMemArray<id_type, osmium::Location> index;
+        fill(index);
+        osmium::index::write_map_file(fd, index);
+        osmium::resize_file(fd, 1000);
+        REQUIRE_THROWS_AS(mapped_file_map{fd}, const std::runtime_error&);
+    }
+}
+
+TEST_CASE("Create MappedFileMap with MapFactory") {
+    const auto& map_factory = osmium::index::MapFactory<id_type, osmium::Location>::instance();
+    REQUIRE(map_factory.has_map_type("mapped_file_map"));
+    REQUIRE_THROWS_AS(map_factory.create_map("mapped_file_map"), const osmium::map_factory_error&);
+
+    const std::string filename{"test-mapped-file-map.idx"};
+    {
+        const int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644); // NOLINT(hicpp-signed-bitwise)
+        REQUIRE(fd >= 0);
+        osmium::index::map::SparseMemArray<id_type, osmium::Location> index;
+        fill(index);
+        osmium::index::write_map_file(fd, index);
+        REQUIRE(::close(fd) == 0);
+    }
+
+    const auto map = map_factory.create_map("mapped_file_map," + filename);
+    REQUIRE(map->get(10) == location_for(10));
+
+    REQUIRE(std::remove(filename.c_str()) == 0);
+}
+
+TEST_CASE("Seal map file and open it by name") {
+    const std::string filename{"test-mapped-file-map-sealed.idx"};
+
+    osmium::index::map::SparseMemArray<id_type, osmium::Location> index;
+    fill(index);
+    osmium::index::seal_map_file(filename, index);
+    REQUIRE_THROWS_AS(mapped_file_map{filename + ".tmp"}, const std::system_error&);
+
+    const mapped_file_map map1{filename};
+    const mapped_file_map map2{filename};
+    check_lookups(map1);
+    check_lookups(map2);
+
+    // Sealing again replaces the file, maps already open keep the old
+    // contents.
+    osmium::index::map::DenseMemArray<id_type, osmium::Location> dense_index;
+    dense_index.set(1, location_for(1));
+    osmium::index::seal_map_file(filename, dense_index);
+
+    const mapped_file_map map3{filename};
+    REQUIRE(map3.is_dense());
+    REQUIRE(map3.get(1) == location_for(1));
+    REQUIRE_FALSE(map1.get_noexcept(1).valid());
+    check_lookups(map1);
+
+    REQUIRE(std::remove(filename.c_str()) == 0);
+}
+
+TEST_CASE("Seal map file with dump_as_list()") {
+    const std::string filename{"test-mapped-file-map-sealed-list.idx"};
+
+    osmium::index::map::SparseMemMap<id_type, osmium::Location> index;
+    fill(index);
+    osmium::index::seal_map_file(filename, index);
+
+    const mapped_file_map map{filename};
+    REQUIRE_FALSE(map.is_dense());
+    check_lookups(map);
+
+    REQUIRE(std::remove(filename.c_str()) == 0);
+}
+
+TEST_CASE("Open missing map file by name") {
+    REQUIRE_THROWS_AS(mapped_file_map{"test-mapped-file-map-does-not-exist.idx"}, const std::system_error&);
+}
+
+#ifndef _WIN32
+TEST_CASE("Open sealed map file from other process") {
+    const std::string filename{"test-mapped-file-map-shared.idx"};
+
+    osmium::index::map::DenseMemArray<id_type, osmium::Location> index;
+    fill(index);
+    osmium::index::seal_map_file(filename, index);
+
+    const pid_t pid = ::fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        const mapped_file_map map{filename};
+        bool okay = map.size() == index.size();
+        for (id_type id = 3; id < 10000; id += 7) {
+            okay = okay && map.get_noexcept(id) == location_for(id);
+        }
+        ::_exit(okay ? 0 : 1);
+    }
+
+    const mapped_file_map map{filename};
+    check_lookups(map);
+
+    int status = 0;
+    REQUIRE(::waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+
+    REQUIRE(std::remove(filename.c_str()) == 0);
+}
+#endif
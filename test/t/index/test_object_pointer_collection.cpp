@@ -2,10 +2,15 @@
 
 #include <osmium/builder/attr.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/type_index.hpp>
 #include <osmium/object_pointer_collection.hpp>
 #include <osmium/osm/object_comparisons.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
 
+#include <algorithm>
+#include <iterator>
+
 using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 TEST_CASE("Create ObjectPointerCollection") {
@@ -82,3 +87,49 @@ TEST_CASE("Create ObjectPointerCollection") {
     REQUIRE(collection.empty());
 }
 
+
+TEST_CASE("Sort ObjectPointerCollection using a thread pool") {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int i = 0; i < 50000; ++i) {
+        osmium::builder::add_node(buffer, _id((i * 7919) % 10007), _version(i % 5 + 1));
+    }
+
+    osmium::ObjectPointerCollection expected;
+    osmium::apply(buffer, expected);
+    expected.sort(osmium::object_order_type_id_version{});
+
+    osmium::thread::Pool pool{4};
+    osmium::ObjectPointerCollection collection;
+    osmium::apply(buffer, collection);
+    collection.sort(osmium::object_order_type_id_version{}, pool);
+
+    REQUIRE(collection.size() == expected.size());
+    REQUIRE(std::equal(collection.ptr_begin(), collection.ptr_end(), expected.ptr_begin()));
+}
+
+TEST_CASE("Fill ObjectPointerCollection from type index") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1));
+    osmium::builder::add_way(buffer, _id(2));
+    osmium::builder::add_node(buffer, _id(3));
+    osmium::builder::add_relation(buffer, _id(4));
+    osmium::builder::add_way(buffer, _id(5));
+
+    const osmium::memory::TypeIndex index{buffer};
+
+    osmium::ObjectPointerCollection all;
+    all.add(buffer, index);
+    REQUIRE(all.size() == 5);
+    osmium::object_id_type id = 1;
+    for (const auto& object : all) {
+        REQUIRE(object.id() == id++);
+    }
+
+    osmium::ObjectPointerCollection ways;
+    ways.add(buffer, index, osmium::osm_entity_bits::way);
+    REQUIRE(ways.size() == 2);
+    REQUIRE(ways.cbegin()->id() == 2);
+    REQUIRE(std::next(ways.cbegin())->id() == 5);
+}
@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/object_store.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _MSC_VER
+# include <direct.h>
+#endif
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string store_directory() {
+    const std::string directory{"test-object-store"};
+#ifndef _WIN32
+    const int result = ::mkdir(directory.c_str(), 0777);
+#else
+    const int result = _mkdir(directory.c_str());
+#endif
+    REQUIRE((result == 0 || errno == EEXIST));
+    return directory;
+}
+
+static void write_store(const std::string& directory) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(20), _version(1), _location(1.0, 2.0), _tag("amenity", "pub"));
+    osmium::builder::add_node(buffer, _id(10), _version(2), _location(3.0, 4.0));
+    osmium::builder::add_way(buffer, _id(5), _nodes({10, 20}), _tag("highway", "primary"));
+    osmium::builder::add_relation(buffer, _id(7), _member(osmium::item_type::way, 5, "outer"));
+
+    osmium::index::ObjectStoreWriter writer{directory};
+    writer(buffer);
+    writer.close();
+}
+
+TEST_CASE("Write and read object store") {
+    const auto directory = store_directory();
+    write_store(directory);
+
+    const osmium::index::ObjectStore store{directory};
+    REQUIRE(store.size(osmium::item_type::node) == 2);
+    REQUIRE(store.size(osmium::item_type::way) == 1);
+    REQUIRE(store.size(osmium::item_type::relation) == 1);
+    REQUIRE(store.size(osmium::item_type::changeset) == 0);
+
+    const osmium::Node& node = store.get_node(20);
+    REQUIRE(node.id() == 20);
+    REQUIRE(node.location() == osmium::Location(1.0, 2.0));
+    REQUIRE(std::string{node.tags().get_value_by_key("amenity")} == "pub");
+
+    REQUIRE(store.get_node(10).version() == 2);
+
+    const osmium::Way& way = store.get_way(5);
+    REQUIRE(way.nodes().size() == 2);
+    REQUIRE(way.nodes()[1].ref() == 20);
+
+    const osmium::Relation& relation = store.get_relation(7);
+    REQUIRE(relation.members().begin()->ref() == 5);
+    REQUIRE(std::string{relation.members().begin()->role()} == "outer");
+
+    REQUIRE(store.get(osmium::item_type::way, 5).type() == osmium::item_type::way);
+}
+
+TEST_CASE("Objects not in object store") {
+    const auto directory = store_directory();
+    write_store(directory);
+
+    const osmium::index::ObjectStore store{directory};
+    REQUIRE(store.get_noexcept(osmium::item_type::node, 11) == nullptr);
+    REQUIRE(store.get_noexcept(osmium::item_type::node, 99) == nullptr);
+    REQUIRE(store.get_noexcept(osmium::item_type::way, 20) == nullptr);
+    REQUIRE(store.get_noexcept(osmium::item_type::area, 5) == nullptr);
+    REQUIRE_THROWS_AS(store.get_way(6), const osmium::not_found&);
+}
+
+TEST_CASE("Empty object store") {
+    const auto directory = store_directory();
+    {
+        osmium::index::ObjectStoreWriter writer{directory};
+    }
+
+    const osmium::index::ObjectStore store{directory};
+    REQUIRE(store.size(osmium::item_type::node) == 0);
+    REQUIRE(store.get_noexcept(osmium::item_type::node, 1) == nullptr);
+}
+
+TEST_CASE("Object store needs existing files") {
+    REQUIRE_THROWS_AS(osmium::index::ObjectStore{"test-object-store-does-not-exist"}, const std::system_error&);
+}
@@ -0,0 +1,114 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/multimap/persistent.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+#include <vector>
+
+using map_type = osmium::index::multimap::PersistentMultimap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+using values = std::vector<osmium::unsigned_object_id_type>;
+
+static void load(map_type& map) {
+    map.set(3, 30);
+    map.set(1, 11);
+    map.set(1, 10);
+    map.set(2, 20);
+    map.set(1, 10); // duplicate
+    map.sort();
+}
+
+TEST_CASE("Persistent multimap initial load") {
+    map_type map;
+    load(map);
+
+    REQUIRE(map.size() == 4);
+    REQUIRE(map.log_size() == 0);
+    REQUIRE(map.get_all(1) == (values{10, 11}));
+    REQUIRE(map.get_all(2) == values{20});
+    REQUIRE(map.get_all(4).empty());
+}
+
+TEST_CASE("Persistent multimap updates") {
+    map_type map;
+    load(map);
+
+    map.add(1, 12);
+    map.remove(1, 10);
+    map.add(2, 20); // already there
+    map.remove(3, 31); // not there
+    map.add(4, 40);
+    map.add(4, 41);
+    map.remove(4, 40);
+    map.remove(3, 30);
+    map.add(3, 30); // re-added
+    map.add(0, 5);
+
+    REQUIRE(map.log_size() == 10);
+
+    const auto check = [&]() {
+        REQUIRE(map.get_all(0) == values{5});
+        REQUIRE(map.get_all(1) == (values{11, 12}));
+        REQUIRE(map.get_all(2) == values{20});
+        REQUIRE(map.get_all(3) == values{30});
+        REQUIRE(map.get_all(4) == values{41});
+        REQUIRE(map.get_all(5).empty());
+    };
+
+    check();
+
+    map.compact();
+    REQUIRE(map.log_size() == 0);
+    REQUIRE(map.size() == 6);
+    check();
+
+    map.remove(0, 5);
+    map.remove(4, 41);
+    map.compact();
+    REQUIRE(map.size() == 4);
+    REQUIRE(map.get_all(0).empty());
+    REQUIRE(map.get_all(4).empty());
+    REQUIRE(map.get_all(1) == (values{11, 12}));
+}
+
+TEST_CASE("Persistent multimap needs compaction") {
+    map_type map;
+    REQUIRE_FALSE(map.needs_compaction());
+    for (osmium::unsigned_object_id_type id = 1; id <= map_type::min_compaction_size; ++id) {
+        map.add(id, id);
+    }
+    REQUIRE(map.needs_compaction());
+    map.compact();
+    REQUIRE_FALSE(map.needs_compaction());
+    REQUIRE(map.size() == map_type::min_compaction_size);
+}
+
+TEST_CASE("Persistent multimap in files") {
+    const int main_fd = osmium::detail::create_tmp_file();
+    const int log_fd = osmium::detail::create_tmp_file();
+
+    {
+        map_type map{main_fd, log_fd};
+        load(map);
+        map.add(1, 12);
+        map.remove(2, 20);
+    }
+
+    {
+        map_type map{main_fd, log_fd};
+        REQUIRE(map.log_size() == 2);
+        REQUIRE(map.get_all(1) == (values{10, 11, 12}));
+        REQUIRE(map.get_all(2).empty());
+        map.compact();
+    }
+
+    {
+        map_type map{main_fd, log_fd};
+        REQUIRE(map.log_size() == 0);
+        REQUIRE(map.size() == 4);
+        REQUIRE(map.get_all(1) == (values{10, 11, 12}));
+        REQUIRE(map.get_all(2).empty());
+        REQUIRE(map.get_all(3) == values{30});
+    }
+}
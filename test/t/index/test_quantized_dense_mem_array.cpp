@@ -0,0 +1,122 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/quantized_dense_mem_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+using index_type = osmium::index::map::QuantizedDenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static bool near(const osmium::Location a, const osmium::Location b, const int32_t max_error) {
+    return std::abs(a.x() - b.x()) <= max_error && std::abs(a.y() - b.y()) <= max_error;
+}
+
+// Locations along a road in Berlin with a few meters between them.
+static osmium::Location test_location(osmium::unsigned_object_id_type id) {
+    return osmium::Location{134000000 + static_cast<int32_t>(id * 97 % 5000),
+                            525000000 + static_cast<int32_t>(id * 89 % 5000)};
+}
+
+TEST_CASE("QuantizedDenseMemArray is empty to begin with") {
+    const index_type index;
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.used_memory() == 0);
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    REQUIRE_THROWS_AS(index.get(17), const osmium::not_found&);
+}
+
+TEST_CASE("QuantizedDenseMemArray returns locations within the documented error") {
+    index_type index;
+    REQUIRE(index.max_error() == 8);
+
+    const osmium::unsigned_object_id_type count = 10000;
+    for (osmium::unsigned_object_id_type id = 1; id <= count; ++id) {
+        index.set(id, test_location(id));
+    }
+
+    REQUIRE(index.size() == count + 1);
+    REQUIRE(index.outliers() == 0);
+    REQUIRE(index.used_memory() < (count + 1) * 5);
+
+    for (osmium::unsigned_object_id_type id = 1; id <= count; ++id) {
+        REQUIRE(near(index.get(id), test_location(id), index.max_error()));
+    }
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    REQUIRE(index.get_noexcept(count + 1) == osmium::Location{});
+}
+
+TEST_CASE("QuantizedDenseMemArray with different precision") {
+    SECTION("exact") {
+        index_type index{0};
+        REQUIRE(index.max_error() == 0);
+        index.set(1, osmium::Location{123456789, 12345678});
+        index.set(2, osmium::Location{123456780, 12345670});
+        REQUIRE(index.get(1) == osmium::Location(123456789, 12345678));
+        REQUIRE(index.get(2) == osmium::Location(123456780, 12345670));
+        REQUIRE(index.outliers() == 0);
+    }
+
+    SECTION("coarse") {
+        index_type index{15};
+        REQUIRE(index.max_error() == 1 << 14);
+        index.set(1, osmium::Location{123456789, 12345678});
+        index.set(2, osmium::Location{-123456789, -12345678});
+        REQUIRE(near(index.get(1), osmium::Location(123456789, 12345678), index.max_error()));
+        REQUIRE(near(index.get(2), osmium::Location(-123456789, -12345678), index.max_error()));
+        REQUIRE(index.outliers() == 0);
+    }
+
+    SECTION("too coarse") {
+        REQUIRE_THROWS_AS(index_type{16}, const std::invalid_argument&);
+    }
+}
+
+TEST_CASE("QuantizedDenseMemArray stores outliers exactly") {
+    index_type index;
+
+    index.set(1, osmium::Location{1.0, 1.0});
+    index.set(2, osmium::Location{-170.0, 80.0}); // far away, same block
+    index.set(3, osmium::Location{1.0000011, 1.0});
+    index.set(4, osmium::Location{180.0, 90.0});
+    index.set(5, osmium::Location{-180.0, -90.0});
+    index.set(64, osmium::Location{180.0, 90.0}); // new block at the edge
+
+    REQUIRE(index.outliers() == 3);
+    REQUIRE(index.get(2) == osmium::Location(-170.0, 80.0));
+    REQUIRE(index.get(4) == osmium::Location(180.0, 90.0));
+    REQUIRE(index.get(5) == osmium::Location(-180.0, -90.0));
+    REQUIRE(near(index.get(1), osmium::Location(1.0, 1.0), index.max_error()));
+    REQUIRE(near(index.get(3), osmium::Location(1.0000011, 1.0), index.max_error()));
+    REQUIRE(index.get(64) == osmium::Location(180.0, 90.0));
+
+    // Setting again replaces outliers
+    index.set(2, osmium::Location{1.0, 1.0});
+    REQUIRE(index.outliers() == 2);
+    REQUIRE(near(index.get(2), osmium::Location(1.0, 1.0), index.max_error()));
+
+    // and removes them
+    index.update(4, osmium::Location{});
+    REQUIRE(index.outliers() == 1);
+    REQUIRE(index.get_noexcept(4) == osmium::Location{});
+
+    index.update(1000, osmium::Location{});
+    REQUIRE(index.size() == 65);
+
+    index.clear();
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.outliers() == 0);
+    REQUIRE(index.get_noexcept(2) == osmium::Location{});
+}
+
+TEST_CASE("QuantizedDenseMemArray is registered in the map factory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    REQUIRE(map_factory.has_map_type("quantized_dense_mem_array"));
+
+    auto map = map_factory.create_map("quantized_dense_mem_array");
+    map->set(17, osmium::Location{1, 2});
+    REQUIRE(map->get(17) == osmium::Location(1, 2));
+}
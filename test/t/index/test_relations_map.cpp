@@ -3,12 +3,15 @@
 #include <osmium/index/relations_map.hpp>
 
 #include <type_traits>
+#include <vector>
 
 static_assert(!std::is_default_constructible<osmium::index::RelationsMapIndex>::value, "RelationsMapIndex should not be default constructible");
 static_assert(!std::is_copy_constructible<osmium::index::RelationsMapIndex>::value, "RelationsMapIndex should not be copy constructible");
 static_assert(!std::is_copy_constructible<osmium::index::RelationsMapStash>::value, "RelationsMapStash should not be copy constructible");
 static_assert(!std::is_copy_assignable<osmium::index::RelationsMapIndex>::value, "RelationsMapIndex should not be copy assignable");
 static_assert(!std::is_copy_assignable<osmium::index::RelationsMapStash>::value, "RelationsMapStash should not be copy assignable");
+static_assert(!std::is_default_constructible<osmium::index::RelationsMapCSRIndex>::value, "RelationsMapCSRIndex should not be default constructible");
+static_assert(!std::is_copy_constructible<osmium::index::RelationsMapCSRIndex>::value, "RelationsMapCSRIndex should not be copy constructible");
 
 TEST_CASE("RelationsMapStash lvalue") {
     osmium::index::RelationsMapStash stash;
@@ -105,3 +108,63 @@ TEST_CASE("RelationsMapStash both indexes") {
     REQUIRE(count == 2);
 }
 
+
+TEST_CASE("RelationsMapStash CSR index") {
+    osmium::index::RelationsMapStash stash;
+    stash.add(1, 2);
+    stash.add(1, 3);
+    stash.add(4, 3);
+    stash.add(1, 2);
+    stash.add(7, 1);
+
+    const auto index = stash.build_member_to_parent_csr_index();
+    REQUIRE_FALSE(index.empty());
+    REQUIRE(index.size() == 4);
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    index.for_each(1, [&](osmium::unsigned_object_id_type id) {
+        ids.push_back(id);
+    });
+    REQUIRE(ids == std::vector<osmium::unsigned_object_id_type>({2, 3}));
+
+    REQUIRE(index.count(0) == 0);
+    REQUIRE(index.count(1) == 2);
+    REQUIRE(index.count(2) == 0);
+    REQUIRE(index.count(4) == 1);
+    REQUIRE(index.count(7) == 1);
+    REQUIRE(index.count(8) == 0);
+    REQUIRE(index.count(1000) == 0);
+
+    int count = 0;
+    index.for_each(1000, [&](osmium::unsigned_object_id_type /*id*/) {
+        ++count;
+    });
+    REQUIRE(count == 0);
+}
+
+TEST_CASE("RelationsMapStash reverse CSR index") {
+    osmium::index::RelationsMapStash stash;
+    stash.add(1, 2);
+    stash.add(1, 3);
+    stash.add(4, 3);
+
+    const auto index = stash.build_parent_to_member_csr_index();
+    REQUIRE(index.size() == 3);
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    index.for_each(3, [&](osmium::unsigned_object_id_type id) {
+        ids.push_back(id);
+    });
+    REQUIRE(ids == std::vector<osmium::unsigned_object_id_type>({1, 4}));
+    REQUIRE(index.count(1) == 0);
+    REQUIRE(index.count(2) == 1);
+}
+
+TEST_CASE("RelationsMapStash empty CSR index") {
+    osmium::index::RelationsMapStash stash;
+
+    const auto index = stash.build_member_to_parent_csr_index();
+    REQUIRE(index.empty());
+    REQUIRE(index.size() == 0); // NOLINT(readability-container-size-empty)
+    REQUIRE(index.count(0) == 0);
+}
@@ -0,0 +1,64 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/sort_by_id.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+using element_type = std::pair<uint64_t, uint32_t>;
+
+static std::vector<element_type> random_data(std::size_t count, uint64_t max_id) {
+    std::mt19937_64 gen{42};
+    std::uniform_int_distribution<uint64_t> id_dist{0, max_id};
+    std::uniform_int_distribution<uint32_t> value_dist{0, 10};
+
+    std::vector<element_type> data;
+    data.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        data.emplace_back(id_dist(gen), value_dist(gen));
+    }
+    return data;
+}
+
+static void check_sort(std::vector<element_type> data) {
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+    osmium::index::detail::sort_by_id(data.begin(), data.end());
+    REQUIRE(data == expected);
+}
+
+TEST_CASE("Sort by id: empty and small ranges") {
+    check_sort({});
+    check_sort({{3, 1}});
+    check_sort(random_data(100, 1000));
+}
+
+TEST_CASE("Sort by id: large ranges with small ids") {
+    check_sort(random_data(200000, 1000));
+}
+
+TEST_CASE("Sort by id: large ranges with large ids") {
+    check_sort(random_data(200000, 10000000000ULL));
+    check_sort(random_data(100000, std::numeric_limits<uint64_t>::max()));
+}
+
+TEST_CASE("Sort by id: mostly sorted range") {
+    std::vector<element_type> data;
+    for (uint64_t i = 0; i < 100000; ++i) {
+        data.emplace_back(i * 3, static_cast<uint32_t>(i % 7));
+    }
+    std::swap(data[10], data[90000]);
+    check_sort(data);
+}
+
+TEST_CASE("Sort by id: with pointer iterators") {
+    auto data = random_data(100000, 1u << 20u);
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+    osmium::index::detail::sort_by_id(data.data(), data.data() + data.size());
+    REQUIRE(data == expected);
+}
@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mmap_array.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+
+using id_type = osmium::unsigned_object_id_type;
+static const std::size_t empty = osmium::index::empty_value<std::size_t>();
+
+template <typename TIndex>
+static void fill(TIndex& index, const std::size_t count) {
+    // Ids 10, 12, 14, ... set in reverse order, so sort() has to work.
+    for (std::size_t n = count; n > 0; --n) {
+        const id_type id = 8 + 2 * n;
+        index.set(id, id + 1);
+    }
+    index.sort();
+}
+
+template <typename TIndex>
+static void check_lookups(const TIndex& index, const std::size_t count) {
+    REQUIRE(index.get_noexcept(0) == empty);
+    REQUIRE(index.get_noexcept(9) == empty);
+    for (std::size_t n = 1; n <= count; ++n) {
+        const id_type id = 8 + 2 * n;
+        REQUIRE(index.get(id) == id + 1);
+        REQUIRE(index.get_noexcept(id + 1) == empty);
+    }
+    REQUIRE(index.get_noexcept(10 + 2 * count) == empty);
+    REQUIRE_THROWS_AS(index.get(10 + 2 * count), const osmium::not_found&);
+}
+
+TEST_CASE("Search layout on SparseMemArray") {
+    using index_type = osmium::index::map::SparseMemArray<id_type, std::size_t>;
+
+    for (const std::size_t count : {0, 1, 15, 16, 17, 32, 33, 100, 1000, 4097}) {
+        index_type index;
+        fill(index, count);
+        check_lookups(index, count);
+
+        index.build_search_layout();
+        REQUIRE(index.has_search_layout() == (count > 16));
+        check_lookups(index, count);
+    }
+}
+
+TEST_CASE("Search layout is removed when map changes") {
+    using index_type = osmium::index::map::SparseMemArray<id_type, std::size_t>;
+
+    index_type index;
+    fill(index, 100);
+    index.build_search_layout();
+    REQUIRE(index.has_search_layout());
+    REQUIRE(index.used_memory() > 100 * sizeof(index_type::element_type));
+
+    SECTION("set") {
+        index.set(5, 6);
+        REQUIRE_FALSE(index.has_search_layout());
+        index.sort();
+        REQUIRE(index.get(5) == 6);
+    }
+
+    SECTION("commit_updates") {
+        index.update(5, 6);
+        index.update(12, 0);
+        index.commit_updates();
+        REQUIRE_FALSE(index.has_search_layout());
+        index.build_search_layout();
+        REQUIRE(index.get(5) == 6);
+        REQUIRE(index.get(12) == 0);
+        REQUIRE(index.get(14) == 15);
+    }
+
+    SECTION("clear") {
+        index.clear();
+        REQUIRE_FALSE(index.has_search_layout());
+        REQUIRE(index.get_noexcept(10) == empty);
+    }
+}
+
+TEST_CASE("Search layout through Map interface") {
+    using index_type = osmium::index::map::SparseMemArray<id_type, std::size_t>;
+
+    index_type index;
+    fill(index, 1000);
+    osmium::index::map::Map<id_type, std::size_t>& map = index;
+    map.build_search_layout();
+    REQUIRE(index.has_search_layout());
+    check_lookups(map, 1000);
+}
+
+#ifdef __linux__
+TEST_CASE("Search layout on SparseMmapArray") {
+    using index_type = osmium::index::map::SparseMmapArray<id_type, std::size_t>;
+
+    index_type index;
+    fill(index, 1000);
+    index.build_search_layout();
+    REQUIRE(index.has_search_layout());
+    check_lookups(index, 1000);
+}
+#endif
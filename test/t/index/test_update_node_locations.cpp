@@ -0,0 +1,165 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/compact_sparse_mem_array.hpp>
+#include <osmium/index/map/compressed_sparse_mem_array.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/flat_hash_map.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_map.hpp>
+#include <osmium/index/update_node_locations.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // Source returning the buffers one after the other.
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        explicit BufferSource(std::vector<osmium::memory::Buffer>&& buffers) :
+            m_buffers(std::move(buffers)) {
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+    osmium::memory::Buffer opl_buffer(std::initializer_list<const char*> lines) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (const char* line : lines) {
+            REQUIRE(osmium::opl_parse(line, buffer));
+        }
+        return buffer;
+    }
+
+    template <typename TIndex>
+    void fill_index(TIndex& index) {
+        for (osmium::unsigned_object_id_type id = 10; id <= 100; id += 10) {
+            index.set(id, osmium::Location{static_cast<double>(id) / 100.0, 1.0});
+        }
+        index.sort();
+    }
+
+    template <typename TIndex>
+    void apply_changes(TIndex& index) {
+        std::vector<osmium::memory::Buffer> buffers;
+        buffers.push_back(opl_buffer({
+            "n20 v2 dV x5 y5", // modify
+            "n30 v2 dD",       // delete
+            "n35 v1 dV x1 y2", // create
+            "n-5 v1 dV x1 y1"  // negative ids are ignored
+        }));
+        buffers.push_back(opl_buffer({
+            "n35 v2 dV x3 y4", // modify again
+            "n40 v2 dD",       // delete
+            "n40 v3 dV x6 y6", // undelete
+            "n45 v1 dD",       // delete of unknown node
+            "n200 v1 dV x7 y7" // create after the end
+        }));
+        BufferSource source{std::move(buffers)};
+        osmium::index::update_node_locations(index, source);
+    }
+
+    template <typename TIndex>
+    void check_index(const TIndex& index) {
+        REQUIRE(index.get_noexcept(10) == osmium::Location(0.1, 1.0));
+        REQUIRE(index.get_noexcept(20) == osmium::Location(5.0, 5.0));
+        REQUIRE(index.get_noexcept(30) == osmium::Location{});
+        REQUIRE(index.get_noexcept(35) == osmium::Location(3.0, 4.0));
+        REQUIRE(index.get_noexcept(40) == osmium::Location(6.0, 6.0));
+        REQUIRE(index.get_noexcept(45) == osmium::Location{});
+        REQUIRE(index.get_noexcept(50) == osmium::Location(0.5, 1.0));
+        REQUIRE(index.get_noexcept(100) == osmium::Location(1.0, 1.0));
+        REQUIRE(index.get_noexcept(200) == osmium::Location(7.0, 7.0));
+        REQUIRE(index.get_noexcept(5) == osmium::Location{});
+    }
+
+    template <typename TIndex>
+    void test_update(TIndex& index) {
+        fill_index(index);
+        apply_changes(index);
+        check_index(index);
+    }
+
+} // anonymous namespace
+
+using id_type = osmium::unsigned_object_id_type;
+
+TEST_CASE("Update SparseMemArray from changes") {
+    osmium::index::map::SparseMemArray<id_type, osmium::Location> index;
+    test_update(index);
+    REQUIRE(index.size() == 11);
+}
+
+TEST_CASE("Update DenseMemArray from changes") {
+    osmium::index::map::DenseMemArray<id_type, osmium::Location> index;
+    test_update(index);
+}
+
+TEST_CASE("Update FlatHashMap from changes") {
+    osmium::index::map::FlatHashMap<id_type, osmium::Location> index;
+    test_update(index);
+    REQUIRE(index.size() == 11);
+}
+
+TEST_CASE("Update SparseMemMap from changes") {
+    osmium::index::map::SparseMemMap<id_type, osmium::Location> index;
+    test_update(index);
+    REQUIRE(index.size() == 11);
+}
+
+TEST_CASE("Update FlexMem from changes") {
+    SECTION("sparse") {
+        osmium::index::map::FlexMem<id_type, osmium::Location> index;
+        test_update(index);
+        REQUIRE(index.size() == 11);
+    }
+    SECTION("dense") {
+        osmium::index::map::FlexMem<id_type, osmium::Location> index{true};
+        test_update(index);
+    }
+}
+
+TEST_CASE("Update CompactSparseMemArray from changes") {
+    osmium::index::map::CompactSparseMemArray<id_type, osmium::Location> index;
+    test_update(index);
+}
+
+TEST_CASE("Update CompressedSparseMemArray from changes") {
+    osmium::index::map::CompressedSparseMemArray<id_type, osmium::Location> index;
+    test_update(index);
+}
+
+TEST_CASE("Update SparseFileArray from changes") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    {
+        osmium::index::map::SparseFileArray<id_type, osmium::Location> index{fd};
+        test_update(index);
+        REQUIRE(index.size() == 11);
+    }
+
+    // The file must contain the merged data only.
+    {
+        osmium::index::map::SparseFileArray<id_type, osmium::Location> index{fd};
+        REQUIRE(index.size() == 11);
+        check_index(index);
+    }
+}
@@ -0,0 +1,164 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/add_locations_to_ways.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/misc.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+namespace {
+
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        explicit BufferSource(std::vector<osmium::memory::Buffer>&& buffers) :
+            m_buffers(std::move(buffers)) {
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+    struct BufferSink {
+
+        std::vector<osmium::memory::Buffer> buffers;
+
+        void operator()(osmium::memory::Buffer&& buffer) {
+            buffers.push_back(std::move(buffer));
+        }
+
+    }; // struct BufferSink
+
+    osmium::Location location_for(const osmium::object_id_type id) {
+        return osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(-id)};
+    }
+
+    osmium::memory::Buffer make_nodes(const osmium::object_id_type first, const osmium::object_id_type last) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = first; id < last; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _location(location_for(id)));
+        }
+        return buffer;
+    }
+
+    // Ways with ids first to last - 1, way n references nodes n and n + 1.
+    osmium::memory::Buffer make_ways(const osmium::object_id_type first, const osmium::object_id_type last) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = first; id < last; ++id) {
+            osmium::builder::add_way(buffer, _id(id), _nodes({id, id + 1}));
+        }
+        return buffer;
+    }
+
+    std::size_t check_ways(const std::vector<osmium::memory::Buffer>& buffers) {
+        std::size_t count = 0;
+        for (const auto& buffer : buffers) {
+            for (const auto& way : buffer.select<osmium::Way>()) {
+                for (const auto& node_ref : way.nodes()) {
+                    REQUIRE(node_ref.location() == location_for(node_ref.ref()));
+                }
+                ++count;
+            }
+        }
+        return count;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Add locations to ways in parallel") {
+    osmium::thread::Pool pool{3};
+
+    std::vector<osmium::memory::Buffer> buffers;
+    buffers.push_back(make_nodes(1, 1000));
+    buffers.push_back(make_nodes(1000, 30001));
+    for (osmium::object_id_type n = 0; n < 10; ++n) {
+        buffers.push_back(make_ways(n * 100 + 1, n * 100 + 101));
+    }
+    buffers.push_back(make_ways(1001, 30000));
+    BufferSource source{std::move(buffers)};
+
+    index_type index;
+    location_handler_type handler{index};
+    BufferSink sink;
+    osmium::io::add_locations_to_ways(source, sink, handler, pool);
+
+    REQUIRE(sink.buffers.size() == 13);
+    REQUIRE(sink.buffers[0].select<osmium::Node>().size() == 999);
+    REQUIRE(check_ways(sink.buffers) == 29999);
+
+    osmium::object_id_type last_id = 0;
+    for (const auto& buffer : sink.buffers) {
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            REQUIRE(way.id() == last_id + 1);
+            last_id = way.id();
+        }
+    }
+}
+
+TEST_CASE("Add locations to ways with nodes after ways") {
+    osmium::thread::Pool pool{2};
+
+    std::vector<osmium::memory::Buffer> buffers;
+    buffers.push_back(make_nodes(1, 51));
+    buffers.push_back(make_ways(1, 50));
+    buffers.push_back(make_nodes(51, 101));
+    buffers.push_back(make_ways(51, 100));
+    BufferSource source{std::move(buffers)};
+
+    index_type index;
+    location_handler_type handler{index};
+    BufferSink sink;
+    osmium::io::add_locations_to_ways(source, sink, handler, pool);
+
+    REQUIRE(sink.buffers.size() == 4);
+    REQUIRE(check_ways(sink.buffers) == 98);
+}
+
+TEST_CASE("Add locations to ways with missing node") {
+    osmium::thread::Pool pool{2};
+
+    std::vector<osmium::memory::Buffer> buffers;
+    buffers.push_back(make_nodes(1, 10));
+    buffers.push_back(make_ways(1, 11));
+    BufferSource source{std::move(buffers)};
+
+    index_type index;
+    location_handler_type handler{index};
+    BufferSink sink;
+
+    SECTION("error") {
+        REQUIRE_THROWS_AS(osmium::io::add_locations_to_ways(source, sink, handler, pool), const osmium::not_found&);
+    }
+
+    SECTION("ignore errors") {
+        handler.ignore_errors();
+        osmium::io::add_locations_to_ways(source, sink, handler, pool);
+        REQUIRE(sink.buffers.size() == 2);
+        const auto& way = *sink.buffers[1].select<osmium::Way>().begin();
+        REQUIRE(way.nodes()[0].location() == location_for(1));
+    }
+}
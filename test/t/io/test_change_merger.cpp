@@ -0,0 +1,173 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/change_merger.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Source returning the buffers one by one.
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        void add(osmium::memory::Buffer&& buffer) {
+            m_buffers.push_back(std::move(buffer));
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+    struct CollectIds {
+
+        std::string result;
+
+        void operator()(const osmium::OSMObject& object) {
+            result += osmium::item_type_to_char(object.type());
+            result += std::to_string(object.id());
+            result += 'v';
+            result += std::to_string(object.version());
+            result += ' ';
+        }
+
+    }; // struct CollectIds
+
+    osmium::memory::Buffer create_data() {
+        osmium::memory::Buffer buffer{1024UL * 64UL, osmium::memory::Buffer::auto_grow::yes};
+        for (int id = 1; id <= 5; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(2), _location(id, id));
+        }
+        osmium::builder::add_way(buffer, _id(1), _version(2), _nodes({1, 2}));
+        osmium::builder::add_way(buffer, _id(3), _version(2), _nodes({3, 4}));
+        osmium::builder::add_relation(buffer, _id(1), _version(2), _member(osmium::item_type::way, 1));
+        return buffer;
+    }
+
+    osmium::memory::Buffer create_changes() {
+        osmium::memory::Buffer buffer{1024UL * 64UL, osmium::memory::Buffer::auto_grow::yes};
+        // changes are not sorted and contain several versions
+        osmium::builder::add_way(buffer, _id(2), _version(1), _nodes({2, 3}));
+        osmium::builder::add_node(buffer, _id(3), _version(3), _location(3.5, 3.5));
+        osmium::builder::add_node(buffer, _id(2), _version(3), _deleted());
+        osmium::builder::add_node(buffer, _id(3), _version(4), _location(3.6, 3.6));
+        osmium::builder::add_node(buffer, _id(0), _version(1), _location(0.5, 0.5));
+        osmium::builder::add_node(buffer, _id(5), _version(1), _location(5.5, 5.5)); // older than data
+        osmium::builder::add_node(buffer, _id(7), _version(1), _location(7.0, 7.0));
+        osmium::builder::add_way(buffer, _id(3), _version(3), _deleted());
+        osmium::builder::add_relation(buffer, _id(2), _version(1), _member(osmium::item_type::node, 7));
+        return buffer;
+    }
+
+    const char* const expected = "n0v1 n1v2 n3v4 n4v2 n5v2 n7v1 w1v2 w2v1 r1v2 r2v1 ";
+
+} // anonymous namespace
+
+TEST_CASE("Merge without changes") {
+    osmium::io::ChangeMerger merger;
+    REQUIRE(merger.size() == 0);
+
+    BufferSource source;
+    source.add(create_data());
+
+    CollectIds ids;
+    merger.merge(source, ids);
+    REQUIRE(ids.result == "n1v2 n2v2 n3v2 n4v2 n5v2 w1v2 w3v2 r1v2 ");
+}
+
+TEST_CASE("Merge changes into empty data") {
+    osmium::io::ChangeMerger merger;
+    merger.add_changes(create_changes());
+    REQUIRE(merger.size() == 9);
+    merger.sort();
+    REQUIRE(merger.size() == 8);
+
+    BufferSource source;
+    CollectIds ids;
+    merger.merge(source, ids);
+    REQUIRE(ids.result == "n0v1 n3v4 n5v1 n7v1 w2v1 r2v1 ");
+}
+
+TEST_CASE("Merge changes into data") {
+    osmium::io::ChangeMerger merger;
+    merger.add_changes(create_changes());
+
+    BufferSource source;
+    auto data = create_data();
+
+    SECTION("in one buffer") {
+        source.add(std::move(data));
+    }
+
+    SECTION("in one buffer per object") {
+        for (const auto& object : data.select<osmium::OSMObject>()) {
+            osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+            buffer.add_item(object);
+            buffer.commit();
+            source.add(std::move(buffer));
+        }
+    }
+
+    CollectIds ids;
+    merger.merge(source, ids);
+    REQUIRE(ids.result == expected);
+
+    merger.clear();
+    REQUIRE(merger.size() == 0);
+}
+
+TEST_CASE("Merge changes from files") {
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-change-merger-data.osm"}, osmium::io::overwrite::allow};
+        writer(create_data());
+        writer.close();
+    }
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-change-merger-changes.osc"}, osmium::io::overwrite::allow};
+        writer(create_changes());
+        writer.close();
+    }
+
+    osmium::io::ChangeMerger merger;
+    {
+        osmium::io::Reader reader{"test-change-merger-changes.osc"};
+        merger.add_changes(reader);
+        reader.close();
+    }
+
+    {
+        osmium::io::Reader reader{"test-change-merger-data.osm"};
+        osmium::io::Writer writer{osmium::io::File{"test-change-merger-result.osm"}, osmium::io::overwrite::allow};
+        merger.merge(reader, writer);
+        writer.close();
+        reader.close();
+    }
+
+    osmium::io::Reader reader{"test-change-merger-result.osm"};
+    CollectIds ids;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids(object);
+        }
+    }
+    reader.close();
+    REQUIRE(ids.result == expected);
+}
@@ -0,0 +1,224 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/diff_generator.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Source returning the buffers one by one.
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        void add(osmium::memory::Buffer&& buffer) {
+            m_buffers.push_back(std::move(buffer));
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+    struct CollectChanges {
+
+        std::string result;
+
+        void operator()(const osmium::OSMObject& object) {
+            result += object.visible() ? (object.version() == 1 ? 'c' : 'm') : 'd';
+            result += osmium::item_type_to_char(object.type());
+            result += std::to_string(object.id());
+            result += 'v';
+            result += std::to_string(object.version());
+            result += ' ';
+        }
+
+    }; // struct CollectChanges
+
+    osmium::memory::Buffer create_old_data() {
+        osmium::memory::Buffer buffer{1024UL * 64UL, osmium::memory::Buffer::auto_grow::yes};
+        for (int id = 1; id <= 5; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _location(id, id));
+        }
+        osmium::builder::add_way(buffer, _id(1), _version(1), _nodes({1, 2}));
+        osmium::builder::add_way(buffer, _id(2), _version(3), _nodes({2, 3}), _tag("highway", "primary"));
+        osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 1, "outer"));
+        return buffer;
+    }
+
+    osmium::memory::Buffer create_new_data() {
+        osmium::memory::Buffer buffer{1024UL * 64UL, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_node(buffer, _id(1), _version(1), _location(1, 1));
+        osmium::builder::add_node(buffer, _id(3), _version(2), _location(3.5, 3.5));
+        osmium::builder::add_node(buffer, _id(4), _version(1), _location(4, 4));
+        osmium::builder::add_node(buffer, _id(5), _version(1), _location(5, 5));
+        osmium::builder::add_node(buffer, _id(6), _version(1), _location(6, 6));
+        osmium::builder::add_way(buffer, _id(1), _version(1), _nodes({1, 2}));
+        // same version, but different tags
+        osmium::builder::add_way(buffer, _id(2), _version(3), _nodes({2, 3}), _tag("highway", "secondary"));
+        osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 1, "outer"));
+        osmium::builder::add_relation(buffer, _id(2), _version(1), _member(osmium::item_type::node, 6));
+        return buffer;
+    }
+
+    osmium::memory::Buffer copy_data(const osmium::memory::Buffer& data) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        buffer.add_buffer(data);
+        buffer.commit();
+        return buffer;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Diff of identical data") {
+    const auto data = create_old_data();
+    BufferSource old_source;
+    old_source.add(copy_data(data));
+    BufferSource new_source;
+    new_source.add(copy_data(data));
+
+    osmium::io::DiffGenerator generator;
+    generator.compare_contents();
+    CollectChanges changes;
+    generator.diff(old_source, new_source, changes);
+    REQUIRE(changes.result.empty());
+    REQUIRE(generator.stats().unchanged == 8);
+    REQUIRE(generator.stats().created == 0);
+    REQUIRE(generator.stats().modified == 0);
+    REQUIRE(generator.stats().deleted == 0);
+}
+
+TEST_CASE("Diff with empty data") {
+    BufferSource empty_source;
+    BufferSource source;
+    source.add(create_old_data());
+    osmium::io::DiffGenerator generator;
+    CollectChanges changes;
+
+    SECTION("old data empty") {
+        generator.diff(empty_source, source, changes);
+        REQUIRE(changes.result == "cn1v1 cn2v1 cn3v1 cn4v1 cn5v1 cw1v1 mw2v3 cr1v1 ");
+        REQUIRE(generator.stats().created == 8);
+    }
+
+    SECTION("new data empty") {
+        generator.diff(source, empty_source, changes);
+        REQUIRE(changes.result == "dn1v1 dn2v1 dn3v1 dn4v1 dn5v1 dw1v1 dw2v3 dr1v1 ");
+        REQUIRE(generator.stats().deleted == 8);
+    }
+}
+
+TEST_CASE("Diff of changed data") {
+    for (const bool one_buffer_per_object : {false, true}) {
+        const auto old_data = create_old_data();
+        BufferSource old_source;
+        if (one_buffer_per_object) {
+            for (const auto& object : old_data.select<osmium::OSMObject>()) {
+                osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+                buffer.add_item(object);
+                buffer.commit();
+                old_source.add(std::move(buffer));
+            }
+        } else {
+            old_source.add(copy_data(old_data));
+        }
+        BufferSource new_source;
+        new_source.add(create_new_data());
+
+        osmium::io::DiffGenerator generator;
+        generator.compare_contents();
+        CollectChanges changes;
+        generator.diff(old_source, new_source, changes);
+        REQUIRE(changes.result == "dn2v1 mn3v2 cn6v1 mw2v3 cr2v1 ");
+        REQUIRE(generator.stats().unchanged == 5);
+    }
+}
+
+TEST_CASE("Diff of changed data comparing only versions") {
+    BufferSource old_source;
+    old_source.add(create_old_data());
+    BufferSource new_source;
+    new_source.add(create_new_data());
+
+    osmium::io::DiffGenerator generator;
+    CollectChanges changes;
+    generator.diff(old_source, new_source, changes);
+    REQUIRE(changes.result == "dn2v1 mn3v2 cn6v1 cr2v1 ");
+    REQUIRE(generator.stats().unchanged == 6);
+}
+
+TEST_CASE("Diff compares contents of objects") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto n1 = osmium::builder::add_node(buffer, _id(1), _version(1), _location(1, 1));
+    const auto n2 = osmium::builder::add_node(buffer, _id(1), _version(1), _location(1, 2));
+    const auto w1 = osmium::builder::add_way(buffer, _id(1), _version(1), _nodes({1, 2}));
+    const auto w2 = osmium::builder::add_way(buffer, _id(1), _version(1), _nodes({1, 3}));
+    const auto r1 = osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 1, "outer"));
+    const auto r2 = osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 1, "inner"));
+    const auto r3 = osmium::builder::add_relation(buffer, _id(1), _version(2), _member(osmium::item_type::way, 1, "outer"));
+
+    osmium::io::DiffGenerator generator;
+    REQUIRE_FALSE(generator.differ(buffer.get<osmium::Node>(n1), buffer.get<osmium::Node>(n2)));
+    REQUIRE(generator.differ(buffer.get<osmium::Relation>(r1), buffer.get<osmium::Relation>(r3)));
+
+    generator.compare_contents();
+    REQUIRE_FALSE(generator.differ(buffer.get<osmium::Node>(n1), buffer.get<osmium::Node>(n1)));
+    REQUIRE(generator.differ(buffer.get<osmium::Node>(n1), buffer.get<osmium::Node>(n2)));
+    REQUIRE(generator.differ(buffer.get<osmium::Way>(w1), buffer.get<osmium::Way>(w2)));
+    REQUIRE(generator.differ(buffer.get<osmium::Relation>(r1), buffer.get<osmium::Relation>(r2)));
+}
+
+TEST_CASE("Diff of files written to change file") {
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-diff-generator-old.osm"}, osmium::io::overwrite::allow};
+        writer(create_old_data());
+        writer.close();
+    }
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-diff-generator-new.osm"}, osmium::io::overwrite::allow};
+        writer(create_new_data());
+        writer.close();
+    }
+
+    osmium::io::DiffGenerator generator;
+    generator.compare_contents();
+    {
+        osmium::io::Reader old_reader{"test-diff-generator-old.osm"};
+        osmium::io::Reader new_reader{"test-diff-generator-new.osm"};
+        osmium::io::Writer writer{osmium::io::File{"test-diff-generator-result.osc"}, osmium::io::overwrite::allow};
+        generator.diff(old_reader, new_reader, writer);
+        writer.close();
+        new_reader.close();
+        old_reader.close();
+    }
+    REQUIRE(generator.stats().created == 2);
+    REQUIRE(generator.stats().modified == 2);
+    REQUIRE(generator.stats().deleted == 1);
+
+    osmium::io::Reader reader{"test-diff-generator-result.osc"};
+    CollectChanges changes;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            changes(object);
+        }
+    }
+    reader.close();
+    REQUIRE(changes.result == "dn2v1 mn3v2 cn6v1 mw2v3 cr2v1 ");
+}
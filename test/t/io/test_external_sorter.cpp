@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/external_sorter.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    struct CollectObjects {
+
+        std::vector<std::string> result;
+
+        void operator()(const osmium::OSMObject& object) {
+            result.push_back(std::string{osmium::item_type_to_char(object.type())} +
+                             std::to_string(object.id()) + 'v' +
+                             std::to_string(object.version()) +
+                             (object.visible() ? "" : "d") +
+                             object.tags().get_value_by_key("n", ""));
+        }
+
+    }; // struct CollectObjects
+
+    // Create buffers with objects in random order, each buffer holding
+    // a part of the objects.
+    std::vector<osmium::memory::Buffer> create_buffers() {
+        std::vector<osmium::memory::Buffer> buffers;
+        for (int b = 0; b < 10; ++b) {
+            buffers.emplace_back(1024UL * 64UL, osmium::memory::Buffer::auto_grow::yes);
+            auto& buffer = buffers.back();
+            for (int i = 0; i < 300; ++i) {
+                const int n = b * 300 + i;
+                const int id = (n * 7919) % 997 - 100;
+                const std::string tag = std::to_string(n);
+                switch (n % 3) {
+                    case 0:
+                        osmium::builder::add_node(buffer, _id(id), _version(n % 4 + 1), _location(1.0, 2.0), _tag("n", tag));
+                        break;
+                    case 1:
+                        osmium::builder::add_way(buffer, _id(id), _version(n % 4 + 1), _nodes({1, 2}), _tag("n", tag), _deleted(n % 5 == 0));
+                        break;
+                    default:
+                        osmium::builder::add_relation(buffer, _id(id), _version(n % 4 + 1), _member(osmium::item_type::node, 1), _tag("n", tag));
+                        break;
+                }
+            }
+        }
+        return buffers;
+    }
+
+    std::vector<std::string> expected_result() {
+        auto buffers = create_buffers();
+        osmium::ObjectPointerCollection objects;
+        for (auto& buffer : buffers) {
+            osmium::apply(buffer, objects);
+        }
+        objects.sort(osmium::object_order_type_id_version{});
+        CollectObjects collect;
+        for (auto it = objects.cbegin(); it != objects.cend(); ++it) {
+            collect(*it);
+        }
+        return collect.result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("External sort in memory") {
+    osmium::io::ExternalSorter sorter{"test-external-sorter-mem-"};
+    for (auto& buffer : create_buffers()) {
+        sorter.add(std::move(buffer));
+    }
+    REQUIRE(sorter.num_runs() == 0);
+
+    CollectObjects collect;
+    sorter.sort(collect);
+    REQUIRE(collect.result.size() == 3000);
+    REQUIRE(collect.result == expected_result());
+}
+
+TEST_CASE("External sort with runs in temporary files") {
+    CollectObjects collect;
+    {
+        osmium::io::ExternalSorter sorter{"test-external-sorter-run-", 20000};
+        for (auto& buffer : create_buffers()) {
+            sorter.add(std::move(buffer));
+        }
+        REQUIRE(sorter.num_runs() > 2);
+        REQUIRE(std::ifstream{"test-external-sorter-run-0.osm.pbf"}.good());
+
+        sorter.sort(collect);
+        REQUIRE(sorter.num_runs() == 0);
+    }
+
+    REQUIRE_FALSE(std::ifstream{"test-external-sorter-run-0.osm.pbf"}.good());
+    REQUIRE(collect.result.size() == 3000);
+    REQUIRE(collect.result == expected_result());
+}
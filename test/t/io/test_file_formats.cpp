@@ -230,6 +230,28 @@ TEST_CASE("Override file format by suffix 'osh.blackhole.gz'") {
     f.check();
 }
 
+TEST_CASE("File format by suffix 'geojsonseq'") {
+    const osmium::io::File f{"test.geojsonseq"};
+    REQUIRE(osmium::io::file_format::geojsonseq == f.format());
+    REQUIRE(osmium::io::file_compression::none == f.compression());
+    REQUIRE_FALSE(f.has_multiple_object_versions());
+    f.check();
+}
+
+TEST_CASE("Override file format by suffix 'geojsons.gz'") {
+    const osmium::io::File f{"test", "geojsons.gz"};
+    REQUIRE(osmium::io::file_format::geojsonseq == f.format());
+    REQUIRE(osmium::io::file_compression::gzip == f.compression());
+    f.check();
+}
+
+TEST_CASE("File format by suffix 'parquet'") {
+    const osmium::io::File f{"test.parquet"};
+    REQUIRE(osmium::io::file_format::parquet == f.format());
+    REQUIRE(osmium::io::file_compression::none == f.compression());
+    f.check();
+}
+
 TEST_CASE("Override file format by suffix 'osh.pbf'") {
     const osmium::io::File f{"test", "osh.pbf"};
     REQUIRE(osmium::io::file_format::pbf == f.format());
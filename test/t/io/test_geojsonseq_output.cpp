@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/geojsonseq_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream file{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+static osmium::memory::Buffer create_test_buffer() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer,
+        _id(1),
+        _version(2),
+        _timestamp(osmium::Timestamp{"2020-01-01T00:00:00Z"}),
+        _cid(3),
+        _uid(4),
+        _user("foo"),
+        _location(1.5, 2.5),
+        _tag("name", "\"Quote\" \\ and\ttab"));
+
+    // untagged node
+    osmium::builder::add_node(buffer, _id(2), _location(1.0, 2.0));
+
+    // node without location
+    osmium::builder::add_node(buffer, _id(3), _tag("amenity", "bench"));
+
+    osmium::builder::add_way(buffer,
+        _id(10),
+        _nodes({{1, {1.5, 2.5}}, {2, {1.0, 2.0}}}),
+        _tag("highway", "primary"));
+
+    // way without locations
+    osmium::builder::add_way(buffer, _id(11), _nodes({1, 2}));
+
+    // relations are ignored
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 10), _tag("type", "route"));
+
+    {
+        osmium::builder::AreaBuilder builder{buffer};
+        builder.set_id(osmium::object_id_to_area_id(12, osmium::item_type::way));
+        {
+            osmium::builder::TagListBuilder tl_builder{builder};
+            tl_builder.add_tag("building", "yes");
+        }
+        {
+            osmium::builder::OuterRingBuilder ring_builder{builder};
+            ring_builder.add_node_ref(1, osmium::Location{0.0, 0.0});
+            ring_builder.add_node_ref(2, osmium::Location{1.0, 0.0});
+            ring_builder.add_node_ref(3, osmium::Location{1.0, 1.0});
+            ring_builder.add_node_ref(1, osmium::Location{0.0, 0.0});
+        }
+    }
+    buffer.commit();
+
+    return buffer;
+}
+
+static void write_test_file(const osmium::io::File& file) {
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(create_test_buffer());
+    writer.close();
+}
+
+TEST_CASE("Write GeoJSONSeq file") {
+    write_test_file(osmium::io::File{"test-geojsonseq-output.geojsonseq"});
+
+    const std::string expected =
+        "\x1e" R"({"type":"Feature","geometry":{"type":"Point","coordinates":[1.5,2.5]},"properties":{"@type":"node","@id":1,"name":"\"Quote\" \\ and\ttab"}})" "\n"
+        "\x1e" R"({"type":"Feature","geometry":{"type":"LineString","coordinates":[[1.5,2.5],[1,2]]},"properties":{"@type":"way","@id":10,"highway":"primary"}})" "\n"
+        "\x1e" R"({"type":"Feature","geometry":{"type":"MultiPolygon","coordinates":[[[[0,0],[1,0],[1,1],[0,0]]]]},"properties":{"@type":"way","@id":12,"building":"yes"}})" "\n";
+
+    REQUIRE(read_file("test-geojsonseq-output.geojsonseq") == expected);
+}
+
+TEST_CASE("Write GeoJSONSeq file with metadata, untagged nodes, and without record separator") {
+    write_test_file(osmium::io::File{"test-geojsonseq-output-options.geojsonseq", "geojsonseq,add_metadata=version+timestamp+user,include_untagged_nodes=true,print_record_separator=false"});
+
+    const std::string result = read_file("test-geojsonseq-output-options.geojsonseq");
+    REQUIRE(result.find('\x1e') == std::string::npos);
+    REQUIRE(result.substr(0, result.find('\n')) ==
+        R"({"type":"Feature","geometry":{"type":"Point","coordinates":[1.5,2.5]},"properties":{"@type":"node","@id":1,"@version":2,"@timestamp":"2020-01-01T00:00:00Z","@user":"foo","name":"\"Quote\" \\ and\ttab"}})");
+    REQUIRE(result.find(R"("@type":"node","@id":2,)") != std::string::npos);
+    REQUIRE(result.find(R"("@type":"node","@id":3,)") == std::string::npos);
+    REQUIRE(result.find(R"("@type":"way","@id":11,)") == std::string::npos);
+}
+
+static std::string write_with_empty_buffers(const std::string& filename, const char* format) {
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+
+    osmium::memory::Buffer buffer1{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_relation(buffer1, _id(20), _member(osmium::item_type::way, 10));
+    writer(std::move(buffer1));
+
+    writer(create_test_buffer());
+
+    osmium::memory::Buffer buffer2{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_relation(buffer2, _id(21), _member(osmium::item_type::way, 10));
+    writer(std::move(buffer2));
+
+    writer.close();
+
+    return read_file(filename);
+}
+
+TEST_CASE("Write GeoJSONSeq file with buffers without any features") {
+    SECTION("with record separator") {
+        const std::string result = write_with_empty_buffers("test-geojsonseq-output-empty.geojsonseq", "geojsonseq");
+        REQUIRE(result.find(R"("@type":"way","@id":12,)") != std::string::npos);
+        REQUIRE(result.substr(0, 2) == "\x1e{");
+        REQUIRE(result.find("\x1e\x1e") == std::string::npos);
+        REQUIRE(result.find("\n\x1e\n") == std::string::npos);
+        REQUIRE(result.back() == '\n');
+    }
+
+    SECTION("newline delimited") {
+        const std::string result = write_with_empty_buffers("test-geojsonseq-output-empty-nd.geojsonseq", "geojsonseq,print_record_separator=false");
+        REQUIRE(result.find(R"("@type":"way","@id":12,)") != std::string::npos);
+        REQUIRE(result.front() == '{');
+        REQUIRE(result.find("\n\n") == std::string::npos);
+        REQUIRE(result.back() == '\n');
+    }
+}
@@ -0,0 +1,36 @@
+#include "catch.hpp"
+
+#include <osmium/io/header.hpp>
+#include <osmium/osm/item_type.hpp>
+
+TEST_CASE("Header without object counts") {
+    const osmium::io::Header header;
+    REQUIRE(header.object_count(osmium::item_type::node) == 0);
+    REQUIRE(header.max_object_id(osmium::item_type::relation) == 0);
+}
+
+TEST_CASE("Header with object counts and max ids") {
+    osmium::io::Header header;
+    header.set_object_count(osmium::item_type::node, 1000)
+          .set_object_count(osmium::item_type::way, 100)
+          .set_max_object_id(osmium::item_type::node, 123456789012LL);
+
+    REQUIRE(header.object_count(osmium::item_type::node) == 1000);
+    REQUIRE(header.object_count(osmium::item_type::way) == 100);
+    REQUIRE(header.object_count(osmium::item_type::relation) == 0);
+    REQUIRE(header.max_object_id(osmium::item_type::node) == 123456789012LL);
+    REQUIRE(header.max_object_id(osmium::item_type::way) == 0);
+
+    REQUIRE(header.get("node_count") == "1000");
+    REQUIRE(header.get("max_node_id") == "123456789012");
+}
+
+TEST_CASE("Header with invalid object counts") {
+    osmium::io::Header header;
+    header.set("node_count", "foo");
+    header.set("way_count", "-5");
+    header.set("relation_count", "99999999999999999999999");
+    REQUIRE(header.object_count(osmium::item_type::node) == 0);
+    REQUIRE(header.object_count(osmium::item_type::way) == 0);
+    REQUIRE(header.object_count(osmium::item_type::relation) == 0);
+}
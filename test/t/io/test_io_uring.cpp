@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/io_uring.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream file{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+static std::string test_data() {
+    std::string data;
+    for (int i = 0; data.size() < 5 * 1024 * 1024 + 123; ++i) {
+        data += "n" + std::to_string(i) + " v1 x1.5 y2.5 Tref=" + std::to_string(i * 7) + "\n";
+    }
+    return data;
+}
+
+static void write_test_file(const std::string& filename, const std::string& data) {
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+}
+
+TEST_CASE("io_uring decompressor is only used if requested") {
+    write_test_file("test_io_uring_small.opl", "n1\n");
+
+    REQUIRE_FALSE(osmium::io::detail::create_uring_decompressor(osmium::io::File{"test_io_uring_small.opl"}));
+    REQUIRE_FALSE(osmium::io::detail::create_uring_decompressor(osmium::io::File{"test_io_uring_small.opl.gz", "opl.gz,io_uring=true"}));
+    REQUIRE_THROWS_AS(osmium::io::detail::create_uring_decompressor(osmium::io::File{"test_io_uring_small.opl", "opl,io_uring=true,io_uring_queue_depth=0"}), const std::invalid_argument&);
+}
+
+TEST_CASE("Read file through io_uring") {
+    const std::string data = test_data();
+    write_test_file("test_io_uring.opl", data);
+
+    for (const char* format : {"opl,io_uring=true", "opl,io_uring=true,direct_io=true,io_uring_queue_depth=2"}) {
+        auto decompressor = osmium::io::detail::create_uring_decompressor(osmium::io::File{"test_io_uring.opl", format});
+        if (!decompressor) {
+            WARN("io_uring not available");
+            return;
+        }
+
+        REQUIRE(decompressor->file_size() == data.size());
+
+        std::string result;
+        for (std::string block = decompressor->read(); !block.empty(); block = decompressor->read()) {
+            REQUIRE(block.size() <= osmium::io::Decompressor::input_buffer_size);
+            result += block;
+        }
+        decompressor->close();
+
+        REQUIRE(decompressor->offset() == data.size());
+        REQUIRE(result == data);
+    }
+}
+
+TEST_CASE("Read and write OSM data through io_uring") {
+    write_test_file("test_io_uring_in.opl", test_data());
+
+    {
+        osmium::io::Reader reader{osmium::io::File{"test_io_uring_in.opl", "opl,io_uring=true,direct_io=true"}};
+        osmium::io::Writer writer{osmium::io::File{"test_io_uring_out.opl", "opl,io_uring=true"}, osmium::io::overwrite::allow};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            writer(std::move(buffer));
+        }
+        writer.close();
+        reader.close();
+    }
+
+    {
+        osmium::io::Reader reader{"test_io_uring_in.opl"};
+        osmium::io::Writer writer{"test_io_uring_expected.opl", osmium::io::overwrite::allow};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            writer(std::move(buffer));
+        }
+        writer.close();
+        reader.close();
+    }
+
+    const std::string expected = read_file("test_io_uring_expected.opl");
+    REQUIRE(expected.size() > 5 * 1024 * 1024);
+    REQUIRE(read_file("test_io_uring_out.opl") == expected);
+}
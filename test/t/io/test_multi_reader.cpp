@@ -0,0 +1,140 @@
+#include "catch.hpp"
+
+#include <osmium/handler.hpp>
+#include <osmium/io/multi_reader.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+    const std::string shard1 =
+        "n1 v1\n"
+        "n3 v1\n"
+        "n3 v2\n"
+        "w1 v1 Nn1,n3\n";
+
+    const std::string shard2 =
+        "n2 v1\n"
+        "n3 v2\n"
+        "w2 v1 Nn2,n3\n"
+        "r1 v1 Mw1@,w2@\n";
+
+    const std::string shard3 =
+        "n4 v1\n";
+
+    std::vector<osmium::io::File> files() {
+        return {
+            osmium::io::File{shard1.data(), shard1.size(), "opl"},
+            osmium::io::File{shard2.data(), shard2.size(), "opl"},
+            osmium::io::File{shard3.data(), shard3.size(), "opl"}
+        };
+    }
+
+    std::string object_ids(const osmium::memory::Buffer& buffer) {
+        std::string result;
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            result += osmium::item_type_to_char(object.type());
+            result += std::to_string(object.id());
+            result += 'v';
+            result += std::to_string(object.version());
+            result += ' ';
+        }
+        return result;
+    }
+
+    struct CountHandler : public osmium::handler::Handler {
+
+        int nodes = 0;
+        int ways = 0;
+        int relations = 0;
+
+        void node(const osmium::Node& /*node*/) noexcept {
+            ++nodes;
+        }
+
+        void way(const osmium::Way& /*way*/) noexcept {
+            ++ways;
+        }
+
+        void relation(const osmium::Relation& /*relation*/) noexcept {
+            ++relations;
+        }
+
+    }; // struct CountHandler
+
+} // anonymous namespace
+
+TEST_CASE("MultiReader needs files") {
+    const std::vector<osmium::io::File> no_files;
+    REQUIRE_THROWS_AS(osmium::io::MultiReader(no_files, osmium::io::multi_reader_order::interleaved), const std::invalid_argument&);
+}
+
+TEST_CASE("MultiReader merging files in type/id order") {
+    osmium::io::MultiReader reader{files(), osmium::io::multi_reader_order::type_id};
+    REQUIRE(reader.size() == 3);
+    REQUIRE(reader.order() == osmium::io::multi_reader_order::type_id);
+
+    std::string result;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        result += object_ids(buffer);
+    }
+    REQUIRE(result == "n1v1 n2v1 n3v1 n3v2 n4v1 w1v1 w2v1 r1v1 ");
+    REQUIRE(reader.eof());
+
+    reader.close();
+}
+
+TEST_CASE("MultiReader reading files interleaved") {
+    osmium::thread::Pool pool{2};
+    osmium::io::MultiReader reader{files(), osmium::io::multi_reader_order::interleaved, pool};
+
+    std::string result;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        result += object_ids(buffer);
+    }
+    REQUIRE(reader.eof());
+
+    // The order of the files is not defined, but each file is in order
+    // and nothing is deduplicated.
+    REQUIRE(result.size() == std::string{"n1v1 n3v1 n3v2 w1v1 n2v1 n3v2 w2v1 r1v1 n4v1 "}.size());
+    REQUIRE(result.find("n1v1 n3v1 n3v2 w1v1 ") != std::string::npos);
+    REQUIRE(result.find("n2v1 n3v2 w2v1 r1v1 ") != std::string::npos);
+    REQUIRE(result.find("n4v1 ") != std::string::npos);
+
+    reader.close();
+}
+
+TEST_CASE("MultiReader with apply") {
+    CountHandler handler;
+
+    SECTION("interleaved") {
+        osmium::io::MultiReader reader{files(), osmium::io::multi_reader_order::interleaved, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
+        osmium::apply(reader, handler);
+        REQUIRE(handler.nodes == 6);
+        reader.close();
+    }
+
+    SECTION("type_id") {
+        osmium::io::MultiReader reader{files(), osmium::io::multi_reader_order::type_id, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
+        osmium::apply(reader, handler);
+        REQUIRE(handler.nodes == 5);
+        reader.close();
+    }
+
+    REQUIRE(handler.ways == 2);
+    REQUIRE(handler.relations == 0);
+}
+
+TEST_CASE("MultiReader header") {
+    osmium::io::MultiReader reader{files(), osmium::io::multi_reader_order::type_id};
+    const auto header = reader.header();
+    REQUIRE_FALSE(header.has_multiple_object_versions());
+    REQUIRE(reader.header(1).boxes().empty());
+    REQUIRE_THROWS_AS(reader.header(3), const std::out_of_range&);
+    reader.close();
+}
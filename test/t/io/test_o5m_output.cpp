@@ -0,0 +1,184 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/o5m_output_format.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/o5m_output.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream file{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+static void add_test_objects(osmium::memory::Buffer& buffer, int first_id, int count) {
+    const std::string long_value(300, 'x');
+
+    for (int id = first_id; id < first_id + count; ++id) {
+        osmium::builder::add_node(buffer,
+            _id(id),
+            _version(id % 5 + 1),
+            _timestamp(osmium::Timestamp{1500000000 + id}),
+            _cid(1000 + id / 7),
+            _uid(id % 3),
+            _user(id % 3 == 0 ? "" : "user" + std::to_string(id % 3)),
+            _location(osmium::Location{id / 1000.0, -id / 2000.0}),
+            _tag("highway", id % 2 ? "crossing" : "traffic_signals"),
+            _tag("name", id % 11 ? "Main Street" : long_value),
+            _tag("ref", std::to_string(id)));
+    }
+
+    osmium::builder::add_node(buffer, _id(-first_id), _version(2), _deleted());
+
+    for (int id = first_id; id < first_id + count / 10; ++id) {
+        osmium::builder::add_way(buffer,
+            _id(id),
+            _version(1),
+            _timestamp(osmium::Timestamp{1600000000 + id}),
+            _cid(2000),
+            _uid(17),
+            _user("mapper"),
+            _nodes({id, id + 1, id + 2, id}),
+            _tag("building", "yes"));
+    }
+
+    osmium::builder::add_way(buffer, _id(first_id + count), _version(3), _deleted());
+
+    for (int id = first_id; id < first_id + count / 100; ++id) {
+        osmium::builder::add_relation(buffer,
+            _id(id),
+            _version(1),
+            _timestamp(osmium::Timestamp{1600000000}),
+            _cid(3000),
+            _uid(17),
+            _user("mapper"),
+            _member(osmium::item_type::node, id, "stop"),
+            _member(osmium::item_type::way, id + 1, ""),
+            _member(osmium::item_type::relation, id - 1, "subarea"),
+            _member(osmium::item_type::way, id + 5, "platform"),
+            _tag("type", "route"));
+    }
+}
+
+static void write_buffers(const osmium::io::File& file, const std::vector<osmium::memory::Buffer>& buffers) {
+    osmium::io::Header header;
+    header.add_box(osmium::Box{1.5, 2.5, 3.0, 4.0});
+    header.set("o5m_timestamp", "2020-01-02T03:04:05Z");
+
+    osmium::io::Writer writer{file, header, osmium::io::overwrite::allow};
+    for (const auto& buffer : buffers) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            writer(object);
+        }
+        writer.flush();
+    }
+    writer.close();
+}
+
+static void convert_to_opl(const std::string& input, const std::string& output) {
+    osmium::io::Reader reader{input};
+    osmium::io::Writer writer{osmium::io::File{output, "opl"}, osmium::io::overwrite::allow};
+    while (auto buffer = reader.read()) {
+        writer(std::move(buffer));
+    }
+    writer.close();
+    reader.close();
+}
+
+TEST_CASE("Write o5m file and read it back") {
+    std::vector<osmium::memory::Buffer> buffers;
+    for (int n = 0; n < 3; ++n) {
+        buffers.emplace_back(1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes);
+        add_test_objects(buffers.back(), 1 + n * 10000, 2000);
+    }
+
+    write_buffers(osmium::io::File{"test-o5m-output-expected.opl"}, buffers);
+    write_buffers(osmium::io::File{"test-o5m-output.o5m"}, buffers);
+    convert_to_opl("test-o5m-output.o5m", "test-o5m-output-result.opl");
+
+    const auto expected = read_file("test-o5m-output-expected.opl");
+    REQUIRE_FALSE(expected.empty());
+    REQUIRE(read_file("test-o5m-output-result.opl") == expected);
+
+    osmium::io::Reader reader{"test-o5m-output.o5m"};
+    const auto header = reader.header();
+    reader.close();
+    REQUIRE_FALSE(header.has_multiple_object_versions());
+    REQUIRE(header.get("o5m_timestamp") == "2020-01-02T03:04:05Z");
+    REQUIRE(header.box() == osmium::Box(1.5, 2.5, 3.0, 4.0));
+}
+
+TEST_CASE("Write o5c file") {
+    std::vector<osmium::memory::Buffer> buffers;
+    buffers.emplace_back(1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes);
+    add_test_objects(buffers.back(), 1, 200);
+
+    write_buffers(osmium::io::File{"test-o5m-output.o5c"}, buffers);
+
+    const auto data = read_file("test-o5m-output.o5c");
+    REQUIRE(data.substr(0, 7) == std::string{"\xff\xe0\x04o5c2"});
+    REQUIRE(data.back() == '\xfe');
+
+    osmium::io::Reader reader{"test-o5m-output.o5c"};
+    REQUIRE(reader.header().has_multiple_object_versions());
+    int count = 0;
+    while (const auto buffer = reader.read()) {
+        count += static_cast<int>(std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend()));
+    }
+    reader.close();
+    REQUIRE(count == 200 + 1 + 20 + 1 + 2);
+}
+
+TEST_CASE("Write o5m file without metadata") {
+    std::vector<osmium::memory::Buffer> buffers;
+    buffers.emplace_back(1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes);
+    add_test_objects(buffers.back(), 1, 100);
+
+    write_buffers(osmium::io::File{"test-o5m-output-nometa.o5m", "o5m,add_metadata=false"}, buffers);
+
+    osmium::io::Reader reader{"test-o5m-output-nometa.o5m"};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE(object.version() == 0);
+            REQUIRE(object.timestamp() == osmium::Timestamp{});
+            REQUIRE(std::string{object.user()}.empty());
+        }
+    }
+    reader.close();
+}
+
+TEST_CASE("o5m output reference table") {
+    osmium::io::detail::OutputReferenceTable table;
+
+    REQUIRE(table.find("a") == 0);
+    table.add("a");
+    REQUIRE(table.find("a") == 1);
+    table.add("b");
+    table.skip();
+    REQUIRE(table.find("a") == 3);
+    REQUIRE(table.find("b") == 2);
+
+    table.add(std::string(253, 'x'));
+    REQUIRE(table.find(std::string(253, 'x')) == 0);
+
+    for (int i = 0; i < 15000; ++i) {
+        table.add(std::to_string(i));
+    }
+    REQUIRE(table.find("a") == 0);
+    REQUIRE(table.find("0") == 15000);
+    REQUIRE(table.find("14999") == 1);
+
+    table.clear();
+    REQUIRE(table.find("14999") == 0);
+}
@@ -1277,3 +1277,18 @@ TEST_CASE("line_by_line for OPL parser 28") {
     check_lbl({"foo\nb", "ar"}, {"foo", "bar"});
 }
 
+
+TEST_CASE("line_by_line for OPL parser with long lines") {
+    const std::string a(40, 'a');
+    const std::string b(17, 'b');
+    const std::string c(33, 'c');
+    check_lbl({a + "\n" + b + "\r\n" + c.substr(0, 20), c.substr(20) + "\n\n"}, {a, b, c});
+}
+
+TEST_CASE("Count OPL lines") {
+    REQUIRE(oid::count_opl_lines("") == 0);
+    REQUIRE(oid::count_opl_lines("\n\r\n") == 0);
+    REQUIRE(oid::count_opl_lines("foo") == 1);
+    REQUIRE(oid::count_opl_lines("foo\r\nbar\n\nbaz") == 3);
+    REQUIRE(oid::count_opl_lines(std::string(100, 'x') + "\n" + std::string(20, 'y') + "\n") == 2);
+}
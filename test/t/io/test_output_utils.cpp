@@ -2,10 +2,13 @@
 
 #include <osmium/io/detail/string_util.hpp>
 
+#include <cstdint>
 #include <iterator>
+#include <limits>
 #include <locale>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 TEST_CASE("output formatted with small results") {
     std::string out;
@@ -210,3 +213,105 @@ TEST_CASE("incomplete Unicode codepoint") {
     }
 }
 
+// Encode the string one character at a time, so the scan for the next
+// character that has to be escaped never sees more than one character.
+template <typename TFunc>
+static std::string encode_char_by_char(const std::string& str, TFunc&& func) {
+    std::string out;
+    for (const char c : str) {
+        const char buffer[2] = {c, '\0'};
+        func(out, buffer);
+    }
+    return out;
+}
+
+TEST_CASE("XML and UTF8 encoding of long strings with special character at any position") {
+    const auto xml = [](std::string& out, const char* data) {
+        osmium::io::detail::append_xml_encoded_string(out, data);
+    };
+    const auto utf8 = [](std::string& out, const char* data) {
+        osmium::io::detail::append_utf8_encoded_string(out, data);
+    };
+
+    for (int c = 1; c < 0x80; ++c) {
+        for (std::size_t pos = 0; pos < 40; ++pos) {
+            std::string str(40, 'x');
+            str[pos] = static_cast<char>(c);
+            str[39 - pos] = static_cast<char>(c);
+
+            std::string out_xml;
+            osmium::io::detail::append_xml_encoded_string(out_xml, str.c_str());
+            REQUIRE(out_xml == encode_char_by_char(str, xml));
+
+            std::string out_utf8;
+            osmium::io::detail::append_utf8_encoded_string(out_utf8, str.c_str());
+            REQUIRE(out_utf8 == encode_char_by_char(str, utf8));
+        }
+    }
+}
+
+TEST_CASE("Find line end at any position") {
+    for (std::size_t len = 0; len < 40; ++len) {
+        std::string str(len, 'x');
+        const char* const end = str.data() + str.size();
+        REQUIRE(osmium::io::detail::find_line_end(str.data(), end) == end);
+        for (std::size_t pos = 0; pos < len; ++pos) {
+            str[pos] = (pos % 2) ? '\n' : '\r';
+            REQUIRE(osmium::io::detail::find_line_end(str.data(), end) == str.data() + pos);
+            str[pos] = 'x';
+        }
+    }
+}
+
+TEST_CASE("UTF8 encoding of long strings with multibyte characters") {
+    std::string str{"abcdefghijklmnopqrstuvwxyz"};
+    str += u8"ボ";
+    str += "abcdefghijklmnopqrstuvwxyz";
+    str += u8"ä";
+    str += "0123456789012345678=";
+
+    std::string out;
+    osmium::io::detail::append_utf8_encoded_string(out, str.c_str());
+    REQUIRE(out == "abcdefghijklmnopqrstuvwxyz%30dc%abcdefghijklmnopqrstuvwxyz" u8"ä" "0123456789012345678%3d%");
+}
+
+TEST_CASE("append_int_to_string works like printf") {
+    const std::vector<int64_t> values = {
+        0, 1, 9, 10, 99, 100, 101, 999, 1000, 12345, -1, -9, -10, -100, -12345,
+        1234567890123LL, -1234567890123LL,
+        std::numeric_limits<int64_t>::max(),
+        std::numeric_limits<int64_t>::min()
+    };
+
+    for (const auto value : values) {
+        for (int width = 0; width < 25; ++width) {
+            std::string out{"x"};
+            osmium::io::detail::append_int_to_string(out, value, width);
+            std::string ref{"x"};
+            osmium::io::detail::append_printf_formatted_string(ref, "%*lld", width, static_cast<long long>(value)); // NOLINT(google-runtime-int)
+            REQUIRE(out == ref);
+
+            out = "x";
+            osmium::io::detail::append_int_to_string(out, value, width, '0');
+            ref = "x";
+            osmium::io::detail::append_printf_formatted_string(ref, "%0*lld", width, static_cast<long long>(value)); // NOLINT(google-runtime-int)
+            REQUIRE(out == ref);
+        }
+    }
+}
+
+TEST_CASE("append_hex_to_string works like printf") {
+    for (const uint32_t value : {0U, 1U, 0xfU, 0x10U, 0xabcdU, 0x10000U, 0x12345678U, 0xffffffffU}) {
+        std::string out;
+        osmium::io::detail::append_hex_to_string(out, value);
+        std::string ref;
+        osmium::io::detail::append_printf_formatted_string(ref, "%x", value);
+        REQUIRE(out == ref);
+    }
+}
+
+TEST_CASE("JSON encoding") {
+    std::string out;
+    osmium::io::detail::append_json_encoded_string(out, "a\"b\\c\nd\te\x01" u8"ä");
+    REQUIRE(out == "a\\\"b\\\\c\\nd\\te\\u0001" u8"ä");
+}
@@ -0,0 +1,139 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/bzip2_compression.hpp>
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string test_data() {
+    std::string data;
+    for (int i = 0; i < 20000; ++i) {
+        data += "n" + std::to_string(i) + " v1 dV c1 t2014-01-01T00:00:00Z i1 utest T x1 y1\n";
+    }
+    return data;
+}
+
+static osmium::memory::Buffer create_nodes(const int count) {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= count; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0), _tag("highway", "bus_stop"));
+    }
+    return buffer;
+}
+
+static int count_nodes(const osmium::io::File& file) {
+    int count = 0;
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{file, pool};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == ++count);
+        }
+    }
+    reader.close();
+    return count;
+}
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream file{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Compress gzip member in BGZF format") {
+    const std::string data = test_data().substr(0, 1000);
+    const std::string member = osmium::io::detail::gzip_compress_member(data.data(), data.size());
+
+    const auto members = osmium::io::detail::find_bgzf_members(member.data(), member.size());
+    REQUIRE(members.size() == 1);
+    REQUIRE(members[0].size == member.size());
+    REQUIRE(osmium::io::detail::gzip_decompress_member(member.data(), member.size()) == data);
+}
+
+TEST_CASE("Compress empty gzip member") {
+    const std::string member = osmium::io::detail::gzip_compress_member("", 0);
+    REQUIRE(osmium::io::detail::gzip_decompress_member(member.data(), member.size()).empty());
+}
+
+TEST_CASE("Compress bzip2 stream") {
+    const std::string data = test_data();
+    const std::string stream = osmium::io::detail::bzip2_compress_stream(data.data(), data.size());
+    REQUIRE(osmium::io::detail::bzip2_decompress_stream(stream.data(), stream.size()) == data);
+}
+
+TEST_CASE("Parallel compressor writes blocks in order") {
+    const std::string filename{"test_parallel_compression.gz"};
+    const std::string data = test_data();
+
+    osmium::thread::Pool pool{3};
+    auto compressor = osmium::io::CompressionFactory::instance().create_parallel_compressor(osmium::io::file_compression::gzip,
+        osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow), osmium::io::fsync::no, pool);
+    REQUIRE(compressor);
+
+    for (std::size_t pos = 0; pos < data.size(); pos += 10000) {
+        compressor->write(data.substr(pos, 10000));
+    }
+    compressor->close();
+
+    const std::string compressed = read_file(filename);
+    REQUIRE(compressor->file_size() == compressed.size());
+
+    const auto members = osmium::io::detail::find_bgzf_members(compressed.data(), compressed.size());
+    REQUIRE(members.size() > 1);
+
+    std::string result;
+    for (const auto& member : members) {
+        result += osmium::io::detail::gzip_decompress_member(compressed.data() + member.offset, member.size);
+    }
+    REQUIRE(result == data);
+}
+
+TEST_CASE("No parallel compressor for uncompressed files") {
+    osmium::thread::Pool pool{2};
+    REQUIRE_FALSE(osmium::io::CompressionFactory::instance().create_parallel_compressor(osmium::io::file_compression::none, 1, osmium::io::fsync::no, pool));
+}
+
+TEST_CASE("Writer with parallel compression") {
+    osmium::thread::Pool pool{2};
+
+    SECTION("gzip") {
+        const osmium::io::File file{"test_parallel_compression.opl.gz", "opl.gz,parallel_compression=true"};
+        osmium::io::Writer writer{file, pool, osmium::io::overwrite::allow};
+        writer(create_nodes(5000));
+        writer.close();
+
+        REQUIRE(count_nodes(osmium::io::File{file.filename()}) == 5000);
+        REQUIRE(count_nodes(osmium::io::File{file.filename(), "opl.gz,parallel_decompression=true"}) == 5000);
+    }
+
+    SECTION("bzip2") {
+        const osmium::io::File file{"test_parallel_compression.opl.bz2", "opl.bz2,parallel_compression=true"};
+        osmium::io::Writer writer{file, pool, osmium::io::overwrite::allow};
+        writer(create_nodes(20000));
+        writer.close();
+
+        REQUIRE(count_nodes(osmium::io::File{file.filename()}) == 20000);
+        REQUIRE(count_nodes(osmium::io::File{file.filename(), "opl.bz2,parallel_decompression=true"}) == 20000);
+    }
+
+    SECTION("empty gzip file") {
+        const osmium::io::File file{"test_parallel_compression_empty.opl.gz", "opl.gz,parallel_compression=true"};
+        osmium::io::Writer writer{file, pool, osmium::io::overwrite::allow};
+        writer.close();
+
+        REQUIRE(osmium::file_size(file.filename()) > 0);
+        REQUIRE(count_nodes(osmium::io::File{file.filename()}) == 0);
+    }
+}
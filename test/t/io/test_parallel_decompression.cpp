@@ -0,0 +1,173 @@
+#include "catch.hpp"
+
+#include <osmium/io/bzip2_compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <bzlib.h>
+#include <zlib.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::string bzip2_compress(const std::string& data) {
+    std::string output(data.size() + data.size() / 100 + 600, '\0');
+    auto size = static_cast<unsigned int>(output.size());
+    REQUIRE(BZ2_bzBuffToBuffCompress(&*output.begin(), &size, const_cast<char*>(data.data()), static_cast<unsigned int>(data.size()), 9, 0, 0) == BZ_OK);
+    output.resize(size);
+    return output;
+}
+
+static std::string gzip_compress(const std::string& data) {
+    std::string output(compressBound(static_cast<uLong>(data.size())) + 32, '\0');
+    z_stream zstream{};
+    REQUIRE(deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS | 16, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data.data()));
+    zstream.avail_in = static_cast<unsigned int>(data.size());
+    zstream.next_out = reinterpret_cast<unsigned char*>(&*output.begin());
+    zstream.avail_out = static_cast<unsigned int>(output.size());
+    REQUIRE(deflate(&zstream, Z_FINISH) == Z_STREAM_END);
+    output.resize(zstream.total_out);
+    deflateEnd(&zstream);
+    return output;
+}
+
+// Build a gzip member with a BGZF extra field like bgzip does.
+static std::string bgzf_compress(const std::string& data) {
+    const std::string plain = gzip_compress(data);
+    const std::string body = plain.substr(10);
+
+    std::string output{"\x1f\x8b\x08\x04\0\0\0\0\0\xff\x06\0BC\x02\0", 16};
+    const std::size_t bsize = output.size() + 2 + body.size() - 1;
+    output += static_cast<char>(bsize & 0xffU);
+    output += static_cast<char>((bsize >> 8U) & 0xffU);
+    output += body;
+    return output;
+}
+
+static std::string read_all(osmium::io::Decompressor& decompressor) {
+    std::string all;
+    for (std::string data = decompressor.read(); !data.empty(); data = decompressor.read()) {
+        all += data;
+    }
+    return all;
+}
+
+static const std::vector<std::string> parts = {
+    "n1 v1 dV c1 t2014-01-01T00:00:00Z i1 utest T x1 y1\n",
+    "n2 v1 dV c1 t2014-01-01T00:00:00Z i1 utest T x2 y2\n",
+    "",
+    "n3 v1 dV c1 t2014-01-01T00:00:00Z i1 utest T x3 y3\n"
+};
+
+TEST_CASE("Find streams in multi-stream bzip2 data") {
+    std::string data;
+    for (const auto& part : parts) {
+        data += bzip2_compress(part);
+    }
+
+    const auto streams = osmium::io::detail::find_bzip2_streams(data.data(), data.size());
+    REQUIRE(streams.size() == parts.size());
+    REQUIRE(streams[0].offset == 0);
+    REQUIRE(streams.back().offset + streams.back().size == data.size());
+
+    REQUIRE(osmium::io::detail::find_bzip2_streams("foo", 3).empty());
+}
+
+TEST_CASE("Decompress multi-stream bzip2 data in parallel") {
+    std::string data;
+    std::string expected;
+    for (const auto& part : parts) {
+        data += bzip2_compress(part);
+        expected += part;
+    }
+
+    osmium::thread::Pool pool{2};
+    auto decompressor = osmium::io::CompressionFactory::instance().create_parallel_decompressor(osmium::io::file_compression::bzip2, data.data(), data.size(), pool);
+    REQUIRE(decompressor);
+    REQUIRE(read_all(*decompressor) == expected);
+    REQUIRE(decompressor->offset() == data.size());
+}
+
+TEST_CASE("Single-stream bzip2 data can not be decompressed in parallel") {
+    const std::string data = bzip2_compress(parts[0]);
+
+    osmium::thread::Pool pool{2};
+    REQUIRE_FALSE(osmium::io::CompressionFactory::instance().create_parallel_decompressor(osmium::io::file_compression::bzip2, data.data(), data.size(), pool));
+}
+
+TEST_CASE("Truncated bzip2 stream in parallel decompression") {
+    std::string data = bzip2_compress(parts[0]);
+    data.resize(data.size() - 4);
+    data += bzip2_compress(parts[1]);
+
+    osmium::thread::Pool pool{2};
+    auto decompressor = osmium::io::CompressionFactory::instance().create_parallel_decompressor(osmium::io::file_compression::bzip2, data.data(), data.size(), pool);
+    REQUIRE(decompressor);
+    REQUIRE_THROWS_AS(read_all(*decompressor), const osmium::bzip2_error&);
+}
+
+TEST_CASE("Decompress BGZF data in parallel") {
+    std::string data;
+    std::string expected;
+    for (const auto& part : parts) {
+        data += bgzf_compress(part);
+        expected += part;
+    }
+
+    const auto members = osmium::io::detail::find_bgzf_members(data.data(), data.size());
+    REQUIRE(members.size() == parts.size());
+
+    osmium::thread::Pool pool{2};
+    auto decompressor = osmium::io::CompressionFactory::instance().create_parallel_decompressor(osmium::io::file_compression::gzip, data.data(), data.size(), pool);
+    REQUIRE(decompressor);
+    REQUIRE(read_all(*decompressor) == expected);
+}
+
+TEST_CASE("Normal gzip data can not be decompressed in parallel") {
+    const std::string data = gzip_compress(parts[0]) + gzip_compress(parts[1]);
+
+    REQUIRE(osmium::io::detail::find_bgzf_members(data.data(), data.size()).empty());
+
+    osmium::thread::Pool pool{2};
+    REQUIRE_FALSE(osmium::io::CompressionFactory::instance().create_parallel_decompressor(osmium::io::file_compression::gzip, data.data(), data.size(), pool));
+}
+
+TEST_CASE("Truncated BGZF data") {
+    std::string data = bgzf_compress(parts[0]) + bgzf_compress(parts[1]);
+    data.resize(data.size() - 4);
+
+    REQUIRE_THROWS_AS(osmium::io::detail::find_bgzf_members(data.data(), data.size()), const osmium::gzip_error&);
+}
+
+TEST_CASE("Reader with parallel decompression") {
+    const std::string filename{"test_parallel_decompression.opl.bz2"};
+    {
+        std::string data;
+        for (const auto& part : parts) {
+            data += bzip2_compress(part);
+        }
+        const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+        osmium::io::detail::reliable_write(fd, data.data(), data.size());
+        osmium::io::detail::reliable_close(fd);
+    }
+
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{osmium::io::File{filename, "opl.bz2,parallel_decompression=true"}, pool};
+
+    std::vector<osmium::object_id_type> ids;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            ids.push_back(node.id());
+        }
+    }
+    reader.close();
+
+    REQUIRE(ids == std::vector<osmium::object_id_type>({1, 2, 3}));
+}
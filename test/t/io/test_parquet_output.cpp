@@ -0,0 +1,262 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/parquet_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream file{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+static osmium::memory::Buffer create_test_buffer() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer,
+        _id(1),
+        _version(2),
+        _timestamp(osmium::Timestamp{"2020-01-01T00:00:00Z"}),
+        _cid(3),
+        _uid(4),
+        _user("foo"),
+        _location(1.5, 2.5),
+        _tag("amenity", "bench"),
+        _tag("name", "Bench"));
+
+    osmium::builder::add_node(buffer, _id(2), _location(1.0, 2.0));
+
+    osmium::builder::add_way(buffer,
+        _id(10),
+        _nodes({{1, {1.5, 2.5}}, {2, {1.0, 2.0}}}),
+        _tag("highway", "primary"));
+
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 10), _tag("type", "route"));
+
+    return buffer;
+}
+
+static uint32_t footer_length(const std::string& data) {
+    const auto* end = reinterpret_cast<const unsigned char*>(data.data() + data.size() - 4);
+    return uint32_t(end[-4]) | (uint32_t(end[-3]) << 8U) | (uint32_t(end[-2]) << 16U) | (uint32_t(end[-1]) << 24U);
+}
+
+// Minimal reader for the Thrift compact protocol, just enough to decode
+// the page headers and file metadata written by the Parquet output.
+struct thrift_value {
+    int64_t integer = 0;
+    std::string binary{};
+    std::vector<thrift_value> list{};
+    std::map<int16_t, thrift_value> fields{};
+};
+
+class thrift_reader {
+
+    const std::string& m_data;
+    std::size_t m_pos;
+
+    uint8_t next_byte() {
+        REQUIRE(m_pos < m_data.size());
+        return static_cast<uint8_t>(m_data[m_pos++]);
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        unsigned int shift = 0;
+        while (true) {
+            const auto byte = next_byte();
+            value |= static_cast<uint64_t>(byte & 0x7fU) << shift;
+            if ((byte & 0x80U) == 0) {
+                return value;
+            }
+            shift += 7;
+        }
+    }
+
+    static int64_t unzigzag(uint64_t value) noexcept {
+        return static_cast<int64_t>(value >> 1U) ^ -static_cast<int64_t>(value & 1U);
+    }
+
+    thrift_value value(uint8_t type) {
+        thrift_value result;
+        switch (type) {
+            case 1: // bool true
+                result.integer = 1;
+                break;
+            case 2: // bool false
+                break;
+            case 5: // i32
+            case 6: // i64
+                result.integer = unzigzag(varint());
+                break;
+            case 8: { // binary
+                    const auto size = static_cast<std::size_t>(varint());
+                    REQUIRE(m_pos + size <= m_data.size());
+                    result.binary = m_data.substr(m_pos, size);
+                    m_pos += size;
+                }
+                break;
+            case 9: { // list
+                    const auto header = next_byte();
+                    uint64_t size = header >> 4U;
+                    if (size == 15) {
+                        size = varint();
+                    }
+                    for (uint64_t i = 0; i < size; ++i) {
+                        result.list.push_back(value(header & 0x0fU));
+                    }
+                }
+                break;
+            case 12: // struct
+                result = read_struct();
+                break;
+            default:
+                FAIL("unexpected thrift type " << int(type));
+        }
+        return result;
+    }
+
+public:
+
+    thrift_reader(const std::string& data, std::size_t pos) :
+        m_data(data),
+        m_pos(pos) {
+    }
+
+    std::size_t pos() const noexcept {
+        return m_pos;
+    }
+
+    thrift_value read_struct() {
+        thrift_value result;
+        int16_t last_id = 0;
+        while (true) {
+            const auto header = next_byte();
+            if (header == 0) {
+                return result;
+            }
+            const auto delta = static_cast<int16_t>(header >> 4U);
+            const auto id = delta != 0 ? static_cast<int16_t>(last_id + delta)
+                                       : static_cast<int16_t>(unzigzag(varint()));
+            result.fields[id] = value(header & 0x0fU);
+            last_id = id;
+        }
+    }
+
+}; // class thrift_reader
+
+TEST_CASE("Write Parquet file") {
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-parquet-output.parquet"}, osmium::io::overwrite::allow};
+        writer(create_test_buffer());
+        writer(create_test_buffer());
+        writer.close();
+    }
+
+    const std::string data = read_file("test-parquet-output.parquet");
+    REQUIRE(data.size() > 12);
+    REQUIRE(data.substr(0, 4) == "PAR1");
+    REQUIRE(data.substr(data.size() - 4) == "PAR1");
+
+    const auto length = footer_length(data);
+    REQUIRE(length + 12 < data.size());
+
+    const std::string footer = data.substr(data.size() - 8 - length, length);
+    REQUIRE(footer.find("timestamp") != std::string::npos);
+    REQUIRE(footer.find("key_value") != std::string::npos);
+    REQUIRE(footer.find(R"("primary_column":"geometry")") != std::string::npos);
+}
+
+TEST_CASE("Parquet file metadata matches the data written") {
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-parquet-output-footer.parquet"}, osmium::io::overwrite::allow};
+        writer(create_test_buffer());
+        writer(create_test_buffer());
+        writer.close();
+    }
+
+    const std::string data = read_file("test-parquet-output-footer.parquet");
+    const auto length = footer_length(data);
+    const std::size_t footer_start = data.size() - 8 - length;
+
+    thrift_reader reader{data, footer_start};
+    auto metadata = reader.read_struct();
+    REQUIRE(reader.pos() == data.size() - 8);
+
+    REQUIRE(metadata.fields[1].integer == 1); // version
+    REQUIRE(metadata.fields[2].list.front().fields[4].binary == "schema");
+    REQUIRE(metadata.fields[3].integer == 8); // num_rows
+
+    auto& row_groups = metadata.fields[4].list;
+    REQUIRE(row_groups.size() == 2);
+
+    std::size_t expected_offset = 4; // after magic
+    for (auto& row_group : row_groups) {
+        auto& columns = row_group.fields[1].list;
+        REQUIRE(columns.size() == 11); // 3 + 5 metadata + key + value + geometry
+        REQUIRE(columns.front().fields[3].fields[3].list.front().binary == "type");
+
+        int64_t row_group_size = 0;
+        for (auto& chunk : columns) {
+            const auto offset = chunk.fields[2].integer;
+            auto& column_metadata = chunk.fields[3].fields;
+            REQUIRE(offset == static_cast<int64_t>(expected_offset));
+            REQUIRE(column_metadata[9].integer == offset); // data_page_offset
+            REQUIRE(column_metadata[4].integer == 0); // uncompressed
+            const auto size = column_metadata[7].integer; // total_compressed_size
+            REQUIRE(column_metadata[6].integer == size); // total_uncompressed_size
+
+            // each chunk is one data page
+            thrift_reader page_reader{data, static_cast<std::size_t>(offset)};
+            auto page_header = page_reader.read_struct();
+            REQUIRE(page_header.fields[1].integer == 0); // DATA_PAGE
+            REQUIRE(page_header.fields[2].integer == page_header.fields[3].integer);
+            REQUIRE(static_cast<int64_t>(page_reader.pos()) - offset + page_header.fields[3].integer == size);
+            REQUIRE(page_header.fields[5].fields[1].integer == column_metadata[5].integer); // num_values
+
+            expected_offset += static_cast<std::size_t>(size);
+            row_group_size += size;
+        }
+        REQUIRE(columns[1].fields[3].fields[5].integer == 4); // num_values of "id"
+        REQUIRE(row_group.fields[2].integer == row_group_size); // total_byte_size
+        REQUIRE(row_group.fields[3].integer == 4); // num_rows
+    }
+
+    REQUIRE(expected_offset == footer_start);
+}
+
+TEST_CASE("Write Parquet file without metadata") {
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-parquet-output-nometa.parquet", "parquet,add_metadata=false"}, osmium::io::overwrite::allow};
+        writer(create_test_buffer());
+        writer.close();
+    }
+
+    const std::string data = read_file("test-parquet-output-nometa.parquet");
+    const std::string footer = data.substr(data.size() - 8 - footer_length(data), footer_length(data));
+    REQUIRE(footer.find("timestamp") == std::string::npos);
+    REQUIRE(footer.find("geometry") != std::string::npos);
+}
+
+TEST_CASE("Write Parquet file without any data") {
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-parquet-output-empty.parquet"}, osmium::io::overwrite::allow};
+        writer.close();
+    }
+
+    const std::string data = read_file("test-parquet-output-empty.parquet");
+    REQUIRE(data.substr(0, 4) == "PAR1");
+    REQUIRE(data.substr(data.size() - 4) == "PAR1");
+    REQUIRE(footer_length(data) + 12 == data.size());
+}
@@ -2,9 +2,27 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 TEST_CASE("Get supported PBF compression types") {
     const auto types = osmium::io::supported_pbf_compression_types();
@@ -50,3 +68,491 @@ TEST_CASE("Read PBF file with version=-1 and changeset=-1 and DenseNodes (writte
     REQUIRE(object.version() == 0);
     REQUIRE(object.changeset() == 0);
 }
+
+// This decompressor doesn't decompress anything, it hands out the data
+// from the file in tiny chunks, so that BlobHeaders and Blobs straddle
+// the boundaries between input chunks.
+class SmallChunksDecompressor final : public osmium::io::Decompressor {
+
+    int m_fd;
+
+public:
+
+    explicit SmallChunksDecompressor(int fd) :
+        m_fd(fd) {
+    }
+
+    SmallChunksDecompressor(const SmallChunksDecompressor&) = delete;
+    SmallChunksDecompressor& operator=(const SmallChunksDecompressor&) = delete;
+
+    SmallChunksDecompressor(SmallChunksDecompressor&&) = delete;
+    SmallChunksDecompressor& operator=(SmallChunksDecompressor&&) = delete;
+
+    ~SmallChunksDecompressor() noexcept override = default;
+
+    std::string read() override {
+        std::string buffer(7, '\0');
+        const auto nread = osmium::io::detail::reliable_read(m_fd, &*buffer.begin(), 7);
+        buffer.resize(std::string::size_type(nread));
+        return buffer;
+    }
+
+    void close() override {
+        if (m_fd >= 0) {
+            osmium::io::detail::reliable_close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+}; // class SmallChunksDecompressor
+
+TEST_CASE("Read PBF file from input chunks smaller than blobs") {
+    osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::gzip,
+        [](int /*unused*/, osmium::io::fsync /*unused*/) { return nullptr; },
+        [](int fd) { return new SmallChunksDecompressor{fd}; },
+        [](const char* /*unused*/, size_t /*unused*/) { return nullptr; }
+    );
+
+    const osmium::io::File file{with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf"), "pbf.gz"};
+    osmium::memory::Buffer buffer = osmium::io::read_file(file);
+
+    const osmium::OSMObject& object = *(buffer.cbegin<osmium::OSMObject>());
+    REQUIRE(object.version() == 0);
+    REQUIRE(object.changeset() == 0);
+}
+
+TEST_CASE("Read PBF file using memory mapping") {
+    const osmium::io::File file{with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf"), "pbf,mmap=true"};
+
+    osmium::io::Reader reader{file};
+    REQUIRE(reader.file_size() > 0);
+
+    const auto header = reader.header();
+    REQUIRE(header.get("pbf_dense_nodes") == "true");
+
+    const auto buffer = reader.read();
+    REQUIRE(buffer);
+    const osmium::OSMObject& object = *(buffer.cbegin<osmium::OSMObject>());
+    REQUIRE(object.version() == 0);
+    REQUIRE(object.changeset() == 0);
+
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
+
+TEST_CASE("Read PBF file using memory mapping reading only header") {
+    const osmium::io::File file{with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf"), "pbf,mmap=true"};
+
+    osmium::io::Reader reader{file, osmium::osm_entity_bits::nothing};
+    REQUIRE(reader.header().get("pbf_dense_nodes") == "true");
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
+
+TEST_CASE("Write and read back PBF file spanning several encoding tasks") {
+    const std::string filename{"test-pbf-write-many-buffers.osm.pbf"};
+    const int num_buffers = 200;
+    const int nodes_per_buffer = 1000;
+
+    {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        for (int b = 0; b < num_buffers; ++b) {
+            osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+            for (int n = 0; n < nodes_per_buffer; ++n) {
+                const int id = b * nodes_per_buffer + n + 1;
+                osmium::builder::add_node(buffer,
+                    _id(id),
+                    _version(1),
+                    _location(osmium::Location{id % 360 - 180.0, id % 180 - 90.0}),
+                    _user("user"),
+                    _tag("key", std::to_string(id % 17)));
+            }
+            if (b == num_buffers - 1) {
+                osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3}), _tag("highway", "road"));
+            }
+            writer(std::move(buffer));
+        }
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename};
+    osmium::object_id_type expected_id = 1;
+    int ways = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            if (object.type() == osmium::item_type::way) {
+                ++ways;
+                REQUIRE(static_cast<const osmium::Way&>(object).nodes().size() == 3);
+                continue;
+            }
+            const auto& node = static_cast<const osmium::Node&>(object);
+            REQUIRE(node.id() == expected_id);
+            REQUIRE(node.location() == osmium::Location(expected_id % 360 - 180.0, expected_id % 180 - 90.0));
+            REQUIRE(std::string{node.user()} == "user");
+            REQUIRE(std::string{node.tags().get_value_by_key("key")} == std::to_string(expected_id % 17));
+            ++expected_id;
+        }
+    }
+    reader.close();
+
+    REQUIRE(expected_id == num_buffers * nodes_per_buffer + 1);
+    REQUIRE(ways == 1);
+}
+
+TEST_CASE("Write and read back PBF file with sorted string table") {
+    const std::string filename_unsorted{"test-pbf-write-unsorted.osm.pbf"};
+    const std::string filename_sorted{"test-pbf-write-sorted.osm.pbf"};
+
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    // The first few hundred objects use strings which are rare, so
+    // the common strings get ids needing more than one byte if the
+    // string table isn't sorted.
+    for (int id = 1; id <= 3000; ++id) {
+        const bool rare = id <= 300;
+        osmium::builder::add_node(buffer,
+            _id(id),
+            _location(osmium::Location{1.0, 2.0}),
+            _user(rare ? "user" + std::to_string(id) : "mapper"),
+            _tag(rare ? "key" + std::to_string(id) : "highway", "residential"));
+    }
+    for (int id = 1; id <= 1000; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({1, 2}), _tag(id <= 200 ? "key" + std::to_string(id) : "building", "yes"));
+    }
+    for (int id = 1; id <= 100; ++id) {
+        osmium::builder::add_relation(buffer, _id(id), _member(osmium::item_type::node, 1, "role" + std::to_string(id % 13)));
+    }
+
+    for (const char* dense : {"true", "false"}) {
+        osmium::io::File file_unsorted{filename_unsorted, std::string{"pbf,pbf_compression=none,pbf_dense_nodes="} + dense};
+        osmium::io::File file_sorted{filename_sorted, std::string{"pbf,pbf_compression=none,pbf_sort_stringtable=true,pbf_dense_nodes="} + dense};
+
+        for (const auto& file : {file_unsorted, file_sorted}) {
+            osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                writer(object);
+            }
+            writer.close();
+        }
+
+        REQUIRE(osmium::file_size(filename_sorted) < osmium::file_size(filename_unsorted));
+
+        osmium::io::Reader reader_unsorted{filename_unsorted};
+        osmium::io::Reader reader_sorted{filename_sorted};
+        int count = 0;
+        while (const auto buffer_unsorted = reader_unsorted.read()) {
+            const auto buffer_sorted = reader_sorted.read();
+            const auto objects_sorted = buffer_sorted.select<osmium::OSMObject>();
+            auto it = objects_sorted.cbegin();
+            for (const auto& object : buffer_unsorted.select<osmium::OSMObject>()) {
+                REQUIRE(it != objects_sorted.cend());
+                REQUIRE(object.type() == it->type());
+                REQUIRE(object.id() == it->id());
+                REQUIRE(std::string{object.user()} == it->user());
+                REQUIRE(object.tags().size() == it->tags().size());
+                REQUIRE(std::equal(object.tags().cbegin(), object.tags().cend(), it->tags().cbegin()));
+                if (object.type() == osmium::item_type::relation) {
+                    REQUIRE(std::string{static_cast<const osmium::Relation&>(object).members().cbegin()->role()} ==
+                            static_cast<const osmium::Relation&>(*it).members().cbegin()->role());
+                }
+                ++it;
+                ++count;
+            }
+            REQUIRE(it == objects_sorted.cend());
+        }
+        REQUIRE(count == 4100);
+        REQUIRE_FALSE(reader_sorted.read());
+        reader_unsorted.close();
+        reader_sorted.close();
+    }
+}
+
+TEST_CASE("Read PBF file with tags filter") {
+    const std::string filename{"test-pbf-read-filter.osm.pbf"};
+
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= 30; ++id) {
+        if (id % 2 == 0) {
+            osmium::builder::add_node(buffer, _id(id), _version(id), _location(1.0, 2.0),
+                _user("user" + std::to_string(id % 3)), _tag("highway", std::to_string(id)));
+        } else {
+            osmium::builder::add_node(buffer, _id(id), _version(id), _location(1.0, 2.0),
+                _user("user" + std::to_string(id % 3)));
+        }
+    }
+    for (int id = 1; id <= 10; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({1, 2}), _tag(id % 3 == 0 ? "highway" : "building", "yes"));
+    }
+    for (int id = 1; id <= 4; ++id) {
+        osmium::builder::add_relation(buffer, _id(id), _member(osmium::item_type::way, 1, "outer"));
+    }
+
+    osmium::TagsFilter tags_filter{false};
+    tags_filter.add_rule(true, "highway");
+
+    for (const char* dense : {"true", "false"}) {
+        {
+            osmium::io::Writer writer{osmium::io::File{filename, std::string{"pbf,pbf_dense_nodes="} + dense}, osmium::io::overwrite::allow};
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                writer(object);
+            }
+            writer.close();
+        }
+
+        SECTION(std::string{"filter all types, dense="} + dense) {
+            osmium::io::ReadFilter read_filter;
+            read_filter.tags(tags_filter);
+
+            int nodes = 0;
+            int ways = 0;
+            int relations = 0;
+            osmium::io::Reader reader{filename, read_filter};
+            while (const auto read_buffer = reader.read()) {
+                for (const auto& object : read_buffer.select<osmium::OSMObject>()) {
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            ++nodes;
+                            REQUIRE(object.id() % 2 == 0);
+                            REQUIRE(object.version() == static_cast<osmium::object_version_type>(object.id()));
+                            REQUIRE(std::string{object.user()} == "user" + std::to_string(object.id() % 3));
+                            REQUIRE(std::string{object.tags()["highway"]} == std::to_string(object.id()));
+                            REQUIRE(static_cast<const osmium::Node&>(object).location() == osmium::Location(1.0, 2.0));
+                            break;
+                        case osmium::item_type::way:
+                            ++ways;
+                            REQUIRE(object.id() % 3 == 0);
+                            REQUIRE(static_cast<const osmium::Way&>(object).nodes().size() == 2);
+                            break;
+                        default:
+                            ++relations;
+                    }
+                }
+            }
+            reader.close();
+
+            REQUIRE(nodes == 15);
+            REQUIRE(ways == 3);
+            REQUIRE(relations == 0);
+        }
+
+        SECTION(std::string{"filter only ways, dense="} + dense) {
+            osmium::io::ReadFilter read_filter;
+            read_filter.tags(tags_filter, osmium::osm_entity_bits::way);
+
+            int nodes = 0;
+            int ways = 0;
+            int relations = 0;
+            osmium::io::Reader reader{filename, read_filter};
+            while (const auto read_buffer = reader.read()) {
+                for (const auto& object : read_buffer.select<osmium::OSMObject>()) {
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            ++nodes;
+                            break;
+                        case osmium::item_type::way:
+                            ++ways;
+                            REQUIRE(object.id() % 3 == 0);
+                            break;
+                        default:
+                            ++relations;
+                    }
+                }
+            }
+            reader.close();
+
+            REQUIRE(nodes == 30);
+            REQUIRE(ways == 3);
+            REQUIRE(relations == 4);
+        }
+    }
+}
+
+TEST_CASE("Read PBF file with empty read filter") {
+    osmium::io::ReadFilter read_filter;
+    REQUIRE(read_filter.empty());
+
+    osmium::io::Reader reader{with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf"), read_filter};
+    const auto buffer = reader.read();
+    REQUIRE(buffer);
+    REQUIRE(buffer.select<osmium::Node>().size() == 1);
+    reader.close();
+}
+
+TEST_CASE("Read PBF file with and without metadata") {
+    const std::string filename{"test-pbf-read-meta.osm.pbf"};
+
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _version(3), _changeset(7), _uid(9), _user("mapper"), _location(osmium::Location{1.0, 2.0}), _tag("a", "b"));
+    osmium::builder::add_way(buffer, _id(2), _version(4), _changeset(7), _uid(9), _user("mapper"), _nodes({1, 2}), _tag("c", "d"));
+    osmium::builder::add_relation(buffer, _id(3), _version(5), _changeset(7), _uid(9), _user("mapper"), _member(osmium::item_type::node, 1, "role"));
+
+    for (const char* dense : {"true", "false"}) {
+        {
+            osmium::io::Writer writer{osmium::io::File{filename, std::string{"pbf,pbf_dense_nodes="} + dense}, osmium::io::overwrite::allow};
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                writer(object);
+            }
+            writer.close();
+        }
+
+        for (const auto read_metadata : {osmium::io::read_meta::yes, osmium::io::read_meta::no}) {
+            osmium::io::Reader reader{filename, osmium::osm_entity_bits::all, read_metadata};
+            int count = 0;
+            while (const auto read_buffer = reader.read()) {
+                for (const auto& object : read_buffer.select<osmium::OSMObject>()) {
+                    REQUIRE(object.id() == ++count);
+                    REQUIRE(object.tags().size() == (object.type() == osmium::item_type::relation ? 0 : 1));
+                    if (read_metadata == osmium::io::read_meta::yes) {
+                        REQUIRE(object.version() == static_cast<osmium::object_version_type>(count + 2));
+                        REQUIRE(object.changeset() == 7);
+                        REQUIRE(std::string{object.user()} == "mapper");
+                    } else {
+                        REQUIRE(object.version() == 0);
+                        REQUIRE(object.changeset() == 0);
+                        REQUIRE(std::string{object.user()}.empty());
+                    }
+                }
+            }
+            reader.close();
+            REQUIRE(count == 3);
+        }
+    }
+}
+
+#ifdef OSMIUM_WITH_ZSTD
+TEST_CASE("Write and read back PBF file with zstd compression") {
+    const std::string filename{"test-pbf-write-zstd.osm.pbf"};
+
+    REQUIRE(osmium::io::detail::get_compression_type("zstd") == osmium::io::detail::pbf_compression::zstd);
+
+    const auto types = osmium::io::supported_pbf_compression_types();
+    REQUIRE(std::find(types.cbegin(), types.cend(), "zstd") != types.cend());
+
+    {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (int id = 1; id <= 10000; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _location(osmium::Location{1.0, 2.0}), _tag("highway", "crossing"));
+        }
+
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf,pbf_compression=zstd,pbf_compression_level=9"}, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename};
+    osmium::object_id_type expected_id = 1;
+    while (const auto buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == expected_id);
+            REQUIRE(std::string{node.tags()["highway"]} == "crossing");
+            ++expected_id;
+        }
+    }
+    reader.close();
+    REQUIRE(expected_id == 10001);
+
+    REQUIRE_THROWS_AS(osmium::io::Writer(osmium::io::File{filename, "pbf,pbf_compression=zstd,pbf_compression_level=100"}, osmium::io::overwrite::allow),
+                      const std::invalid_argument&);
+}
+#endif
+
+TEST_CASE("Write and read back PBF file with object counts in header") {
+    const std::string filename{"test-pbf-write-object-counts.osm.pbf"};
+
+    osmium::io::Header header;
+    header.set_object_count(osmium::item_type::node, 3000)
+          .set_max_object_id(osmium::item_type::node, 3000)
+          .set_object_count(osmium::item_type::way, 10)
+          .set_max_object_id(osmium::item_type::way, 25);
+
+    SECTION("with pbf_object_counts option") {
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf,pbf_object_counts=true"}, header, osmium::io::overwrite::allow};
+        writer.close();
+
+        osmium::io::Reader reader{filename};
+        const auto read_header = reader.header();
+        REQUIRE(read_header.object_count(osmium::item_type::node) == 3000);
+        REQUIRE(read_header.max_object_id(osmium::item_type::node) == 3000);
+        REQUIRE(read_header.object_count(osmium::item_type::way) == 10);
+        REQUIRE(read_header.max_object_id(osmium::item_type::way) == 25);
+        REQUIRE(read_header.object_count(osmium::item_type::relation) == 0);
+        REQUIRE(read_header.get("pbf_optional_feature_0") == "Count.Node=3000");
+        reader.close();
+    }
+
+    SECTION("without pbf_object_counts option") {
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf"}, header, osmium::io::overwrite::allow};
+        writer.close();
+
+        osmium::io::Reader reader{filename};
+        REQUIRE(reader.header().object_count(osmium::item_type::node) == 0);
+        reader.close();
+    }
+}
+
+static std::string pbf_data_blobs_of_file(const std::string& filename) {
+    std::ifstream file{filename, std::ios::binary};
+    const std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    const auto blobs = osmium::io::detail::find_pbf_blobs(data.data(), data.size());
+    const auto header_end = blobs.front().offset + blobs.front().size;
+    return data.substr(header_end);
+}
+
+TEST_CASE("Assemble PBF file from pre-encoded data blobs") {
+    for (int part = 0; part < 2; ++part) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int id = 1; id <= 100; ++id) {
+            osmium::builder::add_node(buffer, _id(part * 100 + id), _version(1), _location(1.0, 2.0));
+        }
+        osmium::io::Writer writer{"test-pbf-encoded-part" + std::to_string(part) + ".osm.pbf", osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    const std::string filename{"test-pbf-encoded-assembled.osm.pbf"};
+    osmium::io::Header header;
+    header.set("generator", "assembler");
+
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+
+    SECTION("valid blobs") {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_node(buffer, _id(1000), _version(1), _location(1.0, 2.0));
+        writer(buffer.get<osmium::memory::Item>(0));
+
+        writer.write_encoded(pbf_data_blobs_of_file("test-pbf-encoded-part0.osm.pbf"));
+        writer.write_encoded(pbf_data_blobs_of_file("test-pbf-encoded-part1.osm.pbf"));
+        writer.write_encoded(std::string{});
+        writer.close();
+
+        osmium::io::Reader reader{filename};
+        REQUIRE(reader.header().get("generator") == "assembler");
+        std::vector<osmium::object_id_type> ids;
+        while (const auto read_buffer = reader.read()) {
+            for (const auto& object : read_buffer.select<osmium::OSMObject>()) {
+                ids.push_back(object.id());
+            }
+        }
+        reader.close();
+
+        REQUIRE(ids.size() == 201);
+        REQUIRE(ids.front() == 1000);
+        for (std::size_t i = 1; i < ids.size(); ++i) {
+            REQUIRE(ids[i] == static_cast<osmium::object_id_type>(i));
+        }
+    }
+
+    SECTION("garbage") {
+        REQUIRE_THROWS_AS(writer.write_encoded(std::string{"garbage"}), const osmium::pbf_error&);
+    }
+
+    SECTION("truncated blob") {
+        const auto data = pbf_data_blobs_of_file("test-pbf-encoded-part0.osm.pbf");
+        REQUIRE_THROWS_AS(writer.write_encoded(data.substr(0, data.size() - 1)), const osmium::pbf_error&);
+    }
+
+    SECTION("header blob") {
+        std::ifstream file{"test-pbf-encoded-part0.osm.pbf", std::ios::binary};
+        const std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+        REQUIRE_THROWS_AS(writer.write_encoded(std::string{data}), const osmium::pbf_error&);
+    }
+}
@@ -0,0 +1,259 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/visitor.hpp>
+
+#include <protozero/pbf_writer.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+// Writes a file with two blocks of untagged nodes, one block with tagged
+// nodes and one block with ways.
+static void write_file(const std::string& filename, const char* format) {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= 16100; ++id) {
+        const osmium::Location location{1.0 + id / 100000.0, 2.0};
+        if (id <= 16000) {
+            osmium::builder::add_node(buffer, _id(id), _location(location));
+        } else {
+            osmium::builder::add_node(buffer, _id(id), _location(location), _tag("amenity", "bench"));
+        }
+    }
+    for (int id = 1; id <= 10; ++id) {
+        osmium::builder::add_way(buffer, _id(id),
+            _nodes({osmium::NodeRef{id, osmium::Location{1.0, 2.0}},
+                    osmium::NodeRef{id + 1, osmium::Location{1.5, 2.5}}}));
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static std::vector<osmium::io::detail::pbf_blob_position> find_blobs(const std::string& filename, std::string& data) {
+    std::ifstream file{filename, std::ios::binary};
+    data.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    return osmium::io::detail::find_pbf_blobs(data.data(), data.size());
+}
+
+TEST_CASE("PBF blob hints are written with locations on ways") {
+    const std::string filename{"test-pbf-blob-hints.osm.pbf"};
+    write_file(filename, "pbf,locations_on_ways=true");
+
+    std::string data;
+    const auto blobs = find_blobs(filename, data);
+    REQUIRE(blobs.size() == 5);
+
+    REQUIRE_FALSE(blobs[0].hints.valid);
+
+    REQUIRE(blobs[1].hints.valid);
+    REQUIRE(blobs[1].hints.types == osmium::osm_entity_bits::node);
+    REQUIRE_FALSE(blobs[1].hints.has_tagged_nodes);
+
+    REQUIRE(blobs[2].hints.valid);
+    REQUIRE(blobs[2].hints.types == osmium::osm_entity_bits::node);
+    REQUIRE_FALSE(blobs[2].hints.has_tagged_nodes);
+
+    REQUIRE(blobs[3].hints.valid);
+    REQUIRE(blobs[3].hints.types == osmium::osm_entity_bits::node);
+    REQUIRE(blobs[3].hints.has_tagged_nodes);
+
+    REQUIRE(blobs[4].hints.valid);
+    REQUIRE(blobs[4].hints.types == osmium::osm_entity_bits::way);
+    REQUIRE_FALSE(blobs[4].hints.has_tagged_nodes);
+}
+
+TEST_CASE("PBF blob hints contain id range and sort order") {
+    const std::string filename{"test-pbf-blob-hints-ids.osm.pbf"};
+    write_file(filename, "pbf,locations_on_ways=true");
+
+    std::string data;
+    auto blobs = find_blobs(filename, data);
+    REQUIRE(blobs.size() == 5);
+
+    for (std::size_t i = 1; i < blobs.size(); ++i) {
+        REQUIRE(blobs[i].hints.has_ids);
+        REQUIRE(blobs[i].hints.sorted);
+    }
+    REQUIRE(blobs[1].hints.first_id == 1);
+    REQUIRE(blobs[1].hints.last_id == 8000);
+    REQUIRE(blobs[3].hints.first_id == 16001);
+    REQUIRE(blobs[3].hints.last_id == 16100);
+    REQUIRE(blobs[4].hints.first_id == 1);
+    REQUIRE(blobs[4].hints.last_id == 10);
+
+    REQUIRE(osmium::io::detail::pbf_blobs_are_sorted(blobs));
+
+    SECTION("overlapping blobs") {
+        blobs[2].hints.first_id = 8000;
+        REQUIRE_FALSE(osmium::io::detail::pbf_blobs_are_sorted(blobs));
+    }
+
+    SECTION("unsorted blob") {
+        blobs[3].hints.sorted = false;
+        REQUIRE_FALSE(osmium::io::detail::pbf_blobs_are_sorted(blobs));
+    }
+
+    SECTION("blob without hints") {
+        blobs[4].hints.valid = false;
+        REQUIRE_FALSE(osmium::io::detail::pbf_blobs_are_sorted(blobs));
+    }
+}
+
+TEST_CASE("PBF blob hints of unsorted block") {
+    const std::string filename{"test-pbf-blob-hints-unsorted.osm.pbf"};
+    {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_node(buffer, _id(2), _location(1.0, 2.0));
+        osmium::builder::add_node(buffer, _id(1), _location(1.0, 2.0));
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf,locations_on_ways=true"}, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    std::string data;
+    const auto blobs = find_blobs(filename, data);
+    REQUIRE(blobs.size() == 2);
+    REQUIRE(blobs[1].hints.has_ids);
+    REQUIRE_FALSE(blobs[1].hints.sorted);
+    REQUIRE(blobs[1].hints.first_id == 2);
+    REQUIRE(blobs[1].hints.last_id == 1);
+    REQUIRE_FALSE(osmium::io::detail::pbf_blobs_are_sorted(blobs));
+}
+
+TEST_CASE("Reading sorted PBF file with blob hints sets sorting_verified") {
+    const std::string filename{"test-pbf-blob-hints-verified.osm.pbf"};
+    write_file(filename, "pbf,locations_on_ways=true");
+
+    SECTION("with mmap") {
+        osmium::io::File file{filename};
+        file.set("mmap");
+        osmium::io::Reader reader{file, osmium::osm_entity_bits::nothing};
+        REQUIRE(reader.header().get("sorting_verified") == "true");
+        reader.close();
+    }
+
+    SECTION("without mmap the order can not be verified up front") {
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::nothing};
+        REQUIRE(reader.header().get("sorting_verified").empty());
+        reader.close();
+    }
+}
+
+TEST_CASE("PBF blob hints are not written by default") {
+    const std::string filename{"test-pbf-no-blob-hints.osm.pbf"};
+    write_file(filename, "pbf");
+
+    std::string data;
+    for (const auto& blob : find_blobs(filename, data)) {
+        REQUIRE_FALSE(blob.hints.valid);
+    }
+}
+
+TEST_CASE("Foreign data in BlobHeader.indexdata is ignored") {
+    std::string data;
+    {
+        protozero::pbf_writer writer{data};
+        writer.add_string(1, "something else");
+        writer.add_uint32(2, 4);
+    }
+    REQUIRE_FALSE(osmium::io::detail::decode_blob_hints(protozero::data_view{data.data(), data.size()}).valid);
+
+    const std::string garbage(5, '\xff');
+    REQUIRE_FALSE(osmium::io::detail::decode_blob_hints(protozero::data_view{garbage.data(), garbage.size()}).valid);
+}
+
+TEST_CASE("Reading PBF file with blob hints") {
+    const std::string filename{"test-pbf-blob-hints-read.osm.pbf"};
+    write_file(filename, "pbf,locations_on_ways=true");
+
+    int nodes = 0;
+    int tagged_nodes = 0;
+    int ways = 0;
+
+    const auto count = [&](const osmium::memory::Buffer& buffer) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            if (object.type() == osmium::item_type::node) {
+                ++nodes;
+                if (!object.tags().empty()) {
+                    ++tagged_nodes;
+                }
+            } else {
+                ++ways;
+            }
+        }
+    };
+
+    SECTION("all blobs") {
+        osmium::io::Reader reader{filename};
+        while (const auto buffer = reader.read()) {
+            count(buffer);
+        }
+        reader.close();
+        REQUIRE(nodes == 16100);
+        REQUIRE(tagged_nodes == 100);
+        REQUIRE(ways == 10);
+    }
+
+    SECTION("skip blobs with untagged nodes only") {
+        osmium::io::File file{filename};
+        file.set("pbf_skip_untagged_node_blobs");
+        osmium::io::Reader reader{file};
+        while (const auto buffer = reader.read()) {
+            count(buffer);
+        }
+        reader.close();
+        REQUIRE(nodes == 100);
+        REQUIRE(tagged_nodes == 100);
+        REQUIRE(ways == 10);
+    }
+
+    SECTION("skip blobs with untagged nodes only using mmap") {
+        osmium::io::File file{filename};
+        file.set("pbf_skip_untagged_node_blobs");
+        file.set("mmap");
+        osmium::io::Reader reader{file};
+        while (const auto buffer = reader.read()) {
+            count(buffer);
+        }
+        reader.close();
+        REQUIRE(nodes == 100);
+        REQUIRE(tagged_nodes == 100);
+        REQUIRE(ways == 10);
+    }
+
+    SECTION("ways only, keeping the existing locations") {
+        using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+        index_type index;
+        osmium::handler::NodeLocationsForWays<index_type> location_handler{index};
+        location_handler.keep_existing_locations();
+
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::way};
+        while (auto buffer = reader.read()) {
+            osmium::apply(buffer, location_handler);
+            count(buffer);
+            for (const auto& way : buffer.select<osmium::Way>()) {
+                REQUIRE(way.nodes()[0].location() == osmium::Location(1.0, 2.0));
+                REQUIRE(way.nodes()[1].location() == osmium::Location(1.5, 2.5));
+            }
+        }
+        reader.close();
+        REQUIRE(nodes == 0);
+        REQUIRE(ways == 10);
+    }
+}
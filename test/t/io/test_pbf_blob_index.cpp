@@ -0,0 +1,163 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/read_filter.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+TEST_CASE("Build PBF blob index") {
+    const auto index = osmium::io::PBFBlobIndex::build(with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf"));
+
+    REQUIRE(index.size() == 1);
+    REQUIRE(index[0].entity_bits() == osmium::osm_entity_bits::node);
+    REQUIRE(index[0].min_id == 2);
+    REQUIRE(index[0].max_id == 2);
+    REQUIRE(index[0].offset > 0);
+    REQUIRE(index[0].size > 0);
+
+    REQUIRE(index.find_first(osmium::osm_entity_bits::node) == index.begin());
+    REQUIRE(index.find_first(osmium::osm_entity_bits::way) == index.end());
+
+    REQUIRE(index.find(osmium::item_type::node, 1, 5).size() == 1);
+    REQUIRE(index.find(osmium::item_type::node, 3, 5).empty());
+    REQUIRE(index.find(osmium::item_type::way, 1, 5).empty());
+}
+
+TEST_CASE("Write and read PBF blob index") {
+    const auto index = osmium::io::PBFBlobIndex::build(with_data_dir("t/io/data_pbf_version-1.osm.pbf"));
+    REQUIRE(index.size() == 1);
+
+    const int fd = osmium::detail::create_tmp_file();
+    index.write(fd);
+    REQUIRE(::lseek(fd, 0, SEEK_SET) == 0);
+
+    const auto index2 = osmium::io::PBFBlobIndex::read(fd);
+    REQUIRE(index2.size() == 1);
+    REQUIRE(index2[0].offset == index[0].offset);
+    REQUIRE(index2[0].size == index[0].size);
+    REQUIRE(index2[0].types == index[0].types);
+    REQUIRE(index2[0].min_id == index[0].min_id);
+    REQUIRE(index2[0].max_id == index[0].max_id);
+}
+
+TEST_CASE("Read PBF blob index from invalid file") {
+    const int fd = osmium::detail::create_tmp_file();
+    REQUIRE(::write(fd, "not an index file", 17) == 17);
+    REQUIRE(::lseek(fd, 0, SEEK_SET) == 0);
+
+    REQUIRE_THROWS_AS(osmium::io::PBFBlobIndex::read(fd), osmium::pbf_error);
+}
+
+TEST_CASE("Reader uses PBF blob index to skip blobs") {
+    const std::string filename = with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf");
+    const std::string index_filename{"test_pbf_blob_index.idx"};
+    osmium::io::PBFBlobIndex::build(filename).write(index_filename);
+
+    for (const char* format : {"pbf", "pbf,mmap=true"}) {
+        osmium::io::File file{filename, format};
+        file.set("pbf_blob_index", index_filename);
+
+        {
+            osmium::io::Reader reader{file, osmium::osm_entity_bits::node};
+            const auto buffer = reader.read();
+            REQUIRE(buffer);
+            REQUIRE(buffer.cbegin<osmium::OSMObject>()->id() == 2);
+            REQUIRE_FALSE(reader.read());
+        }
+
+        {
+            osmium::io::Reader reader{file, osmium::osm_entity_bits::way};
+            REQUIRE_FALSE(reader.read());
+        }
+    }
+}
+
+TEST_CASE("Reader uses PBF blob index to skip blobs not matching id set") {
+    const std::string filename = with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf");
+    const std::string index_filename{"test_pbf_blob_index_ids.idx"};
+    osmium::io::PBFBlobIndex::build(filename).write(index_filename);
+
+    osmium::io::File file{filename};
+    file.set("pbf_blob_index", index_filename);
+
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> ids;
+    osmium::io::ReadFilter read_filter;
+    read_filter.ids(ids);
+
+    SECTION("id not in set") {
+        ids.set(1);
+        ids.set(3);
+        osmium::io::Reader reader{file, read_filter};
+        REQUIRE_FALSE(reader.read());
+        reader.close();
+    }
+
+    SECTION("id in set") {
+        ids.set(2);
+        osmium::io::Reader reader{file, read_filter};
+        const auto buffer = reader.read();
+        REQUIRE(buffer);
+        REQUIRE(buffer.cbegin<osmium::OSMObject>()->id() == 2);
+        REQUIRE_FALSE(reader.read());
+        reader.close();
+    }
+}
+
+TEST_CASE("Reader with PBF blob index not matching file") {
+    const std::string index_filename{"test_pbf_blob_index_mismatch.idx"};
+    osmium::io::PBFBlobIndex::build(with_data_dir("t/io/data_pbf_version-1.osm.pbf")).write(index_filename);
+
+    osmium::io::File file{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+    file.set("pbf_blob_index", index_filename);
+    osmium::io::Reader reader{file};
+    REQUIRE_THROWS_AS(reader.read(), osmium::pbf_error);
+}
+
+TEST_CASE("PBF blob index aligned ranges") {
+    std::vector<osmium::io::pbf_blob_index_entry> entries(3);
+    entries[0].offset = 20;
+    entries[0].size = 80;
+    entries[1].offset = 110;
+    entries[1].size = 90;
+    entries[2].offset = 210;
+    entries[2].size = 90;
+    const osmium::io::PBFBlobIndex index{std::move(entries)};
+
+    const auto ranges = index.aligned_ranges(300, 150);
+    REQUIRE(ranges.size() == 2);
+    REQUIRE(ranges[0].offset == 0);
+    REQUIRE(ranges[0].size == 200);
+    REQUIRE(ranges[1].offset == 200);
+    REQUIRE(ranges[1].size == 100);
+
+    const auto small_ranges = index.aligned_ranges(300, 1);
+    REQUIRE(small_ranges.size() == 3);
+    REQUIRE(small_ranges[1].offset == 100);
+    REQUIRE(small_ranges[1].size == 100);
+}
+
+TEST_CASE("Reader with blob aligned range source") {
+    const std::string filename = with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf");
+    const auto index = osmium::io::PBFBlobIndex::build(filename);
+
+    osmium::io::FileRangeSource file_source{filename};
+    osmium::io::BlobAlignedRangeSource source{file_source, index};
+    REQUIRE(source.ranges(1).size() == 1);
+
+    osmium::io::Reader reader{osmium::io::File{filename}, source};
+    const auto buffer = reader.read();
+    REQUIRE(buffer);
+    REQUIRE(buffer.cbegin<osmium::OSMObject>()->id() == 2);
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
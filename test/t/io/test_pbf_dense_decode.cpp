@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/util/delta.hpp>
+
+#include <protozero/exception.hpp>
+#include <protozero/pbf_reader.hpp>
+#include <protozero/pbf_writer.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+static std::string encode_deltas(const std::vector<int64_t>& values) {
+    std::vector<int64_t> deltas;
+    osmium::DeltaEncode<int64_t> encoder;
+    for (const auto value : values) {
+        deltas.push_back(encoder.update(value));
+    }
+
+    std::string data;
+    protozero::pbf_writer writer{data};
+    writer.add_packed_sint64(1, deltas.cbegin(), deltas.cend());
+    return data;
+}
+
+static protozero::data_view packed_field(const std::string& data) {
+    protozero::pbf_reader reader{data};
+    REQUIRE(reader.next(1));
+    return reader.get_view();
+}
+
+TEST_CASE("Decode empty dense delta field") {
+    std::vector<int64_t> output{1, 2, 3};
+    osmium::io::detail::decode_dense_delta_sint64(protozero::data_view{}, output);
+    REQUIRE(output.empty());
+}
+
+TEST_CASE("Decode dense delta field with small and large deltas") {
+    std::vector<int64_t> values;
+    int64_t id = 1;
+    for (int i = 0; i < 100; ++i) {
+        id += (i % 17 == 0) ? 1000000007 : (i % 5);
+        values.push_back(i % 3 == 0 ? -id : id);
+    }
+    values.push_back(0);
+    values.push_back(-4611686018427387904LL);
+    values.push_back(4611686018427387903LL);
+
+    const std::string data = encode_deltas(values);
+
+    std::vector<int64_t> output;
+    osmium::io::detail::decode_dense_delta_sint64(packed_field(data), output);
+    REQUIRE(output == values);
+}
+
+TEST_CASE("Decode dense delta field with runs of one-byte varints") {
+    std::vector<int64_t> values;
+    for (int64_t i = 0; i < 37; ++i) {
+        values.push_back(i * 3);
+    }
+
+    const std::string data = encode_deltas(values);
+
+    std::vector<int64_t> output;
+    osmium::io::detail::decode_dense_delta_sint64(packed_field(data), output);
+    REQUIRE(output == values);
+}
+
+TEST_CASE("Decode truncated dense delta field") {
+    const std::string data{"\x02\x04\x80"};
+
+    std::vector<int64_t> output;
+    REQUIRE_THROWS_AS(osmium::io::detail::decode_dense_delta_sint64(protozero::data_view{data.data(), data.size()}, output),
+                      const protozero::end_of_buffer_exception&);
+}
+
+TEST_CASE("Decode dense delta field with overlong varint") {
+    const std::string data(12, '\xff');
+
+    std::vector<int64_t> output;
+    REQUIRE_THROWS_AS(osmium::io::detail::decode_dense_delta_sint64(protozero::data_view{data.data(), data.size()}, output),
+                      const protozero::varint_too_long_exception&);
+}
+
+TEST_CASE("Decode PBF blobs reusing scratch space") {
+    std::ifstream file{with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf"), std::ios::binary};
+    const std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+    const auto blobs = osmium::io::detail::find_pbf_blobs(data.data(), data.size());
+    REQUIRE(blobs.size() == 2);
+    const protozero::data_view blob{data.data() + blobs[1].offset, blobs[1].size};
+
+    osmium::io::detail::pbf_decoder_scratch scratch;
+
+    // leftovers from an earlier block must not be visible
+    scratch.stringtable.emplace_back("foo", 3);
+    scratch.dense_ids.push_back(17);
+
+    for (int i = 0; i < 2; ++i) {
+        osmium::io::detail::PBFPrimitiveBlockDecoder decoder{
+            osmium::io::detail::decode_blob(blob, scratch.uncompressed),
+            osmium::osm_entity_bits::all,
+            osmium::io::read_meta::yes,
+            scratch};
+        const auto buffer = decoder();
+
+        REQUIRE(std::distance(buffer.cbegin<osmium::Node>(), buffer.cend<osmium::Node>()) == 1);
+        const osmium::Node& node = *buffer.cbegin<osmium::Node>();
+        REQUIRE(node.id() == 2);
+        REQUIRE(node.version() == 0);
+        REQUIRE(scratch.dense_ids.size() == 1);
+    }
+}
@@ -0,0 +1,84 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_diff.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+enum {
+    num_nodes = 80000 // the PBF writer puts 8000 objects into one blob
+};
+
+namespace {
+
+    struct CollectChanges {
+
+        std::string result;
+
+        void operator()(const osmium::OSMObject& object) {
+            result += object.visible() ? (object.version() == 1 ? 'c' : 'm') : 'd';
+            result += osmium::item_type_to_char(object.type());
+            result += std::to_string(object.id());
+            result += 'v';
+            result += std::to_string(object.version());
+            result += ' ';
+        }
+
+    }; // struct CollectChanges
+
+    void write_file(const std::string& filename, const bool changed) {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (int id = 1; id <= num_nodes; ++id) {
+            if (changed && id == 50000) {
+                osmium::builder::add_node(buffer, _id(id), _version(2), _location(1.5, 2.5));
+            } else {
+                osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+            }
+        }
+        if (changed) {
+            osmium::builder::add_node(buffer, _id(num_nodes + 1), _version(1), _location(3.0, 4.0));
+        }
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Diff of identical PBF files") {
+    write_file("test-pbf-diff-old.osm.pbf", false);
+
+    CollectChanges changes;
+    const auto stats = osmium::io::diff_pbf_files("test-pbf-diff-old.osm.pbf", "test-pbf-diff-old.osm.pbf", changes);
+    REQUIRE(changes.result.empty());
+    REQUIRE(stats.skipped_blobs == 10);
+    REQUIRE(stats.decoded_blobs == 0);
+    REQUIRE(stats.unchanged == 0);
+}
+
+TEST_CASE("Diff of PBF files skips identical blobs") {
+    write_file("test-pbf-diff-old.osm.pbf", false);
+    write_file("test-pbf-diff-new.osm.pbf", true);
+
+    CollectChanges changes;
+    const auto stats = osmium::io::diff_pbf_files("test-pbf-diff-old.osm.pbf", "test-pbf-diff-new.osm.pbf", changes);
+    REQUIRE(changes.result == "mn50000v2 cn80001v1 ");
+    REQUIRE(stats.skipped_blobs == 9);
+    REQUIRE(stats.decoded_blobs == 3);
+    REQUIRE(stats.created == 1);
+    REQUIRE(stats.modified == 1);
+    REQUIRE(stats.deleted == 0);
+    REQUIRE(stats.unchanged == 7999);
+
+    changes.result.clear();
+    const auto reverse_stats = osmium::io::diff_pbf_files("test-pbf-diff-new.osm.pbf", "test-pbf-diff-old.osm.pbf", changes);
+    REQUIRE(changes.result == "mn50000v1 dn80001v1 ");
+    REQUIRE(reverse_stats.skipped_blobs == 9);
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+// Writes a file with two blobs of nodes and one blob of ways.
+static void write_file(const std::string& filename) {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= 9000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _user("foo"), _location(1.0 + id / 100000.0, 2.0), _tag("n", std::to_string(id)));
+    }
+    for (int id = 1; id <= 10; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({id, id + 1}), _tag("highway", "road"));
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, "pbf"}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+// Returns the Blob data of all data blobs in the file.
+static std::vector<std::string> data_blobs(const std::string& filename) {
+    std::ifstream file{filename, std::ios::binary};
+    const std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    const auto blobs = osmium::io::detail::find_pbf_blobs(data.data(), data.size());
+
+    std::vector<std::string> result;
+    for (auto it = std::next(blobs.begin()); it != blobs.end(); ++it) {
+        result.emplace_back(data.data() + it->offset, it->size);
+    }
+    return result;
+}
+
+static std::size_t count_buffers_with_source_data(const osmium::io::File& file, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::all) {
+    std::size_t count = 0;
+    osmium::io::Reader reader{file, entities};
+    while (const auto buffer = reader.read()) {
+        if (buffer.source_data()) {
+            REQUIRE(buffer.source_data_unchanged());
+            ++count;
+        }
+    }
+    reader.close();
+    return count;
+}
+
+TEST_CASE("PBF blobs are only kept if requested") {
+    const std::string filename{"test-pbf-keep-blobs.osm.pbf"};
+    write_file(filename);
+    REQUIRE(data_blobs(filename).size() == 3);
+
+    REQUIRE(count_buffers_with_source_data(osmium::io::File{filename}) == 0);
+    REQUIRE(count_buffers_with_source_data(osmium::io::File{filename, "pbf,pbf_keep_blobs=true"}) == 3);
+    REQUIRE(count_buffers_with_source_data(osmium::io::File{filename, "pbf,pbf_keep_blobs=true"}, osmium::osm_entity_bits::node) == 0);
+}
+
+static void copy_file(const std::string& input, const std::string& output, const char* format, bool modify) {
+    osmium::io::Reader reader{osmium::io::File{input, "pbf,pbf_keep_blobs=true"}};
+    osmium::io::Writer writer{osmium::io::File{output, format}, osmium::io::overwrite::allow};
+    while (auto buffer = reader.read()) {
+        if (modify && buffer.begin()->type() == osmium::item_type::way) {
+            for (auto& way : buffer.select<osmium::Way>()) {
+                way.set_id(way.id() + 100);
+            }
+        }
+        writer(std::move(buffer));
+    }
+    writer.close();
+    reader.close();
+}
+
+static std::string read_way_ids(const std::string& filename) {
+    std::string result;
+    osmium::io::Reader reader{filename, osmium::osm_entity_bits::way};
+    while (const auto buffer = reader.read()) {
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            result += std::to_string(way.id());
+            result += ' ';
+        }
+    }
+    reader.close();
+    return result;
+}
+
+TEST_CASE("Unchanged PBF blobs are copied to output") {
+    const std::string input{"test-pbf-keep-blobs-in.osm.pbf"};
+    const std::string output{"test-pbf-keep-blobs-out.osm.pbf"};
+    write_file(input);
+    const auto input_blobs = data_blobs(input);
+    REQUIRE(input_blobs.size() == 3);
+
+    // The output uses no compression, so re-encoded blobs are different
+    copy_file(input, output, "pbf,pbf_compression=none", false);
+    REQUIRE(data_blobs(output) == input_blobs);
+
+    copy_file(input, output, "pbf,pbf_compression=none", true);
+    const auto output_blobs = data_blobs(output);
+    REQUIRE(output_blobs.size() == 3);
+    REQUIRE(output_blobs[0] == input_blobs[0]);
+    REQUIRE(output_blobs[1] == input_blobs[1]);
+    REQUIRE(output_blobs[2] != input_blobs[2]);
+    REQUIRE(read_way_ids(output) == "101 102 103 104 105 106 107 108 109 110 ");
+
+    // Blobs are not reused if metadata has to be removed
+    copy_file(input, output, "pbf,pbf_compression=none,add_metadata=false", false);
+    const auto no_metadata_blobs = data_blobs(output);
+    REQUIRE(no_metadata_blobs.size() == 3);
+    REQUIRE(no_metadata_blobs[0] != input_blobs[0]);
+}
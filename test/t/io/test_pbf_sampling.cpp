@@ -0,0 +1,102 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+enum {
+    num_nodes = 80000 // the PBF writer puts 8000 objects into one blob
+};
+
+static const std::string& sampling_test_file() {
+    static const std::string filename{"test-pbf-sampling.osm.pbf"};
+    static bool written = false;
+    if (!written) {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (int id = 1; id <= num_nodes; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+        }
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+        written = true;
+    }
+    return filename;
+}
+
+// Returns the first id of each block of 8000 ids read.
+static std::vector<osmium::object_id_type> read_blob_starts(const std::string& format, double* ratio = nullptr) {
+    osmium::io::Reader reader{osmium::io::File{sampling_test_file(), format}};
+    if (ratio) {
+        *ratio = reader.sampling_ratio();
+    }
+    std::vector<osmium::object_id_type> starts;
+    int count = 0;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            if (object.id() % 8000 == 1) {
+                starts.push_back(object.id());
+            }
+            ++count;
+        }
+    }
+    reader.close();
+    REQUIRE(count == static_cast<int>(starts.size()) * 8000);
+    return starts;
+}
+
+TEST_CASE("Read PBF file without sampling") {
+    double ratio = 0.0;
+    REQUIRE(read_blob_starts("pbf", &ratio).size() == 10);
+    REQUIRE(ratio == Approx(1.0));
+
+    REQUIRE(read_blob_starts("pbf,pbf_sample_every=1", &ratio).size() == 10);
+    REQUIRE(ratio == Approx(1.0));
+}
+
+TEST_CASE("Read every n-th blob of PBF file") {
+    const std::vector<osmium::object_id_type> expected{1, 24001, 48001, 72001};
+    for (const char* format : {"pbf,pbf_sample_every=3", "pbf,pbf_sample_every=3,mmap=true"}) {
+        double ratio = 0.0;
+        REQUIRE(read_blob_starts(format, &ratio) == expected);
+        REQUIRE(ratio == Approx(1.0 / 3));
+    }
+}
+
+TEST_CASE("Read random blobs of PBF file") {
+    double ratio = 0.0;
+    const auto starts = read_blob_starts("pbf,pbf_sample_every=2,pbf_sample_seed=42", &ratio);
+    REQUIRE(ratio == Approx(0.5));
+
+    // The sample only depends on the seed, so this will never change.
+    const std::vector<osmium::object_id_type> expected{16001, 24001, 32001, 40001, 56001, 72001};
+    REQUIRE(starts == expected);
+
+    REQUIRE(read_blob_starts("pbf,pbf_sample_every=2,pbf_sample_seed=42,mmap=true") == starts);
+
+    // different seeds give different samples
+    bool different = false;
+    for (int seed = 0; seed < 10; ++seed) {
+        if (read_blob_starts("pbf,pbf_sample_every=2,pbf_sample_seed=" + std::to_string(seed)) != starts) {
+            different = true;
+        }
+    }
+    REQUIRE(different);
+}
+
+TEST_CASE("Read PBF file with invalid sampling option") {
+    osmium::io::Reader reader{osmium::io::File{sampling_test_file(), "pbf,pbf_sample_every=0"}};
+    REQUIRE_THROWS_AS(reader.read(), const std::invalid_argument&);
+    reader.close();
+}
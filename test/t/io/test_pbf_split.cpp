@@ -0,0 +1,128 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/pbf_split.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/util/file.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+enum {
+    num_nodes = 80000 // the PBF writer puts 8000 objects into one blob
+};
+
+static const std::string& split_test_file() {
+    static const std::string filename{"test-pbf-split.osm.pbf"};
+    static bool written = false;
+    if (!written) {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (int id = 1; id <= num_nodes; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+        }
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+        written = true;
+    }
+    return filename;
+}
+
+static std::vector<osmium::object_id_type> read_ids(const osmium::io::File& file) {
+    osmium::io::Reader reader{file};
+    REQUIRE(reader.header().get("generator").substr(0, 9) == "libosmium");
+    std::vector<osmium::object_id_type> ids;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids.push_back(object.id());
+        }
+    }
+    reader.close();
+    return ids;
+}
+
+static std::vector<osmium::object_id_type> read_ids(const std::string& format) {
+    return read_ids(osmium::io::File{split_test_file(), format});
+}
+
+TEST_CASE("Read range of blobs from PBF file") {
+    for (const char* format : {"pbf,pbf_blob_range=2-4", "pbf,pbf_blob_range=2-4,mmap=true"}) {
+        const auto ids = read_ids(format);
+        REQUIRE(ids.size() == 16000);
+        REQUIRE(ids.front() == 16001);
+        REQUIRE(ids.back() == 32000);
+    }
+
+    REQUIRE(read_ids("pbf,pbf_blob_range=8-").size() == 16000);
+    REQUIRE(read_ids("pbf,pbf_blob_range=0-1").size() == 8000);
+    REQUIRE(read_ids("pbf,pbf_blob_range=3-3").empty());
+    REQUIRE(read_ids("pbf,pbf_blob_range=10-20").empty());
+}
+
+TEST_CASE("Read byte range from PBF file") {
+    // No blob starts in this range.
+    REQUIRE(read_ids("pbf,pbf_byte_range=1-2").empty());
+
+    const auto ranges = osmium::io::split_pbf_file(split_test_file(), 1);
+    REQUIRE(ranges.size() == 1);
+    REQUIRE(ranges[0].offset == 0);
+    REQUIRE(ranges[0].size == osmium::file_size(split_test_file()));
+    REQUIRE(read_ids("pbf,pbf_byte_range=0-" + std::to_string(ranges[0].size)).size() == num_nodes);
+}
+
+TEST_CASE("Split PBF file into parts") {
+    const auto size = osmium::file_size(split_test_file());
+
+    for (std::size_t n : {2U, 3U, 4U, 10U, 20U}) {
+        const auto ranges = osmium::io::split_pbf_file(split_test_file(), n);
+        REQUIRE(ranges.size() == n);
+        REQUIRE(ranges.front().offset == 0);
+        REQUIRE(ranges.back().offset + ranges.back().size == size);
+
+        std::vector<osmium::object_id_type> all_ids;
+        std::size_t offset = 0;
+        for (const auto& range : ranges) {
+            REQUIRE(range.offset == offset);
+            offset += range.size;
+
+            for (const char* format : {"pbf", "pbf,mmap=true"}) {
+                osmium::io::File file{split_test_file(), format};
+                osmium::io::set_pbf_byte_range(file, range);
+                const auto ids = read_ids(file);
+                REQUIRE(ids.size() % 8000 == 0);
+                if (n <= 4) {
+                    // All blobs have about the same size, so all parts
+                    // get some of them.
+                    REQUIRE_FALSE(ids.empty());
+                }
+                if (format[3] == '\0') {
+                    all_ids.insert(all_ids.end(), ids.begin(), ids.end());
+                }
+            }
+        }
+
+        REQUIRE(all_ids.size() == num_nodes);
+        for (std::size_t i = 0; i < all_ids.size(); ++i) {
+            REQUIRE(all_ids[i] == static_cast<osmium::object_id_type>(i + 1));
+        }
+    }
+
+    REQUIRE_THROWS_AS(osmium::io::split_pbf_file(split_test_file(), 0), const std::invalid_argument&);
+}
+
+TEST_CASE("Read PBF file with invalid range option") {
+    for (const char* format : {"pbf,pbf_blob_range=4-2", "pbf,pbf_blob_range=4", "pbf,pbf_byte_range=-10", "pbf,pbf_byte_range=1x-2"}) {
+        osmium::io::Reader reader{osmium::io::File{split_test_file(), format}};
+        REQUIRE_THROWS_AS(reader.read(), const std::invalid_argument&);
+        reader.close();
+    }
+}
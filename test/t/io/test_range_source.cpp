@@ -0,0 +1,114 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/range_source.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+    class StringRangeSource : public osmium::io::RangeSource {
+
+        std::string m_data;
+
+    public:
+
+        std::atomic<int> requests{0};
+
+        explicit StringRangeSource(std::string data) :
+            m_data(std::move(data)) {
+        }
+
+        std::size_t size() override {
+            return m_data.size();
+        }
+
+        std::string read(const osmium::io::byte_range& range) override {
+            ++requests;
+            return m_data.substr(range.offset, range.size);
+        }
+
+    }; // class StringRangeSource
+
+    std::string read_file(const std::string& filename) {
+        std::ifstream file{filename, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+
+    std::string object_ids(osmium::io::Reader& reader) {
+        std::string result;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                result += osmium::item_type_to_char(object.type());
+                result += std::to_string(object.id());
+                result += ' ';
+            }
+        }
+        reader.close();
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Default ranges of RangeSource") {
+    StringRangeSource source{"0123456789"};
+
+    const auto ranges = source.ranges(4);
+    REQUIRE(ranges.size() == 3);
+    REQUIRE(ranges[0].offset == 0);
+    REQUIRE(ranges[0].size == 4);
+    REQUIRE(ranges[2].offset == 8);
+    REQUIRE(ranges[2].size == 2);
+
+    REQUIRE(source.ranges(10).size() == 1);
+    REQUIRE(StringRangeSource{""}.ranges(4).empty());
+}
+
+TEST_CASE("FileRangeSource") {
+    const std::string filename = with_data_dir("t/io/data.osm");
+    const std::string data = read_file(filename);
+
+    osmium::io::FileRangeSource source{filename};
+    REQUIRE(source.size() == data.size());
+    REQUIRE(source.read(osmium::io::byte_range{10, 20}) == data.substr(10, 20));
+    REQUIRE_THROWS_AS(source.read(osmium::io::byte_range{data.size() - 1, 2}), const osmium::io_error&);
+}
+
+TEST_CASE("Reader with parallel_ranges option") {
+    const std::string filename = with_data_dir("t/io/data.osm");
+
+    osmium::io::Reader reader_normal{filename};
+    const auto expected = object_ids(reader_normal);
+    REQUIRE_FALSE(expected.empty());
+
+    osmium::io::Reader reader{osmium::io::File{filename, "osm,parallel_ranges=3,range_size=50"}};
+    REQUIRE(object_ids(reader) == expected);
+}
+
+TEST_CASE("Reader with custom RangeSource") {
+    StringRangeSource source{"n1\nn2\nw3\nr4\n"};
+
+    osmium::io::Reader reader{osmium::io::File{"remote.opl", "opl,parallel_ranges=2,range_size=3"}, source};
+    REQUIRE(object_ids(reader) == "n1 n2 w3 r4 ");
+    REQUIRE(source.requests == 4);
+}
+
+TEST_CASE("Reader with custom RangeSource needs uncompressed file") {
+    StringRangeSource source{"n1\n"};
+    REQUIRE_THROWS_AS(osmium::io::Reader(osmium::io::File{"remote.opl.gz"}, source), const osmium::io_error&);
+}
+
+TEST_CASE("Reader with invalid range_size option") {
+    StringRangeSource source{"n1\n"};
+    REQUIRE_THROWS_AS(osmium::io::Reader(osmium::io::File{"remote.opl", "opl,range_size=0"}, source), const std::invalid_argument&);
+}
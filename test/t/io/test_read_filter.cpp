@@ -0,0 +1,171 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/o5m_output.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/read_filter.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <stdexcept>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_test_data() {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int id = 1; id <= 20; ++id) {
+        if (id % 4 == 0) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _user("user"),
+                _location(id / 10.0, id / 10.0), _tag("amenity", "bench"));
+        } else {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _user("user"),
+                _location(id / 10.0, id / 10.0));
+        }
+    }
+    for (int id = 1; id <= 6; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(1), _user("user"),
+            _nodes({1, 2}), _tag(id % 2 ? "highway" : "building", "yes"));
+    }
+    for (int id = 1; id <= 3; ++id) {
+        osmium::builder::add_relation(buffer, _id(id), _version(1), _user("user"),
+            _member(osmium::item_type::way, 1, "outer"), _tag("type", "multipolygon"));
+    }
+
+    return buffer;
+}
+
+// Read the file and return the types and ids of all objects.
+static std::string read_ids(const osmium::io::File& file, const osmium::io::ReadFilter& filter) {
+    std::string result;
+
+    osmium::io::Reader reader{file, filter};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            result += osmium::item_type_to_char(object.type());
+            result += std::to_string(object.id());
+            result += ' ';
+        }
+    }
+    reader.close();
+
+    return result;
+}
+
+TEST_CASE("ReadFilter conditions") {
+    osmium::io::ReadFilter filter;
+    REQUIRE(filter.empty());
+    REQUIRE_FALSE(filter.filters(osmium::item_type::node));
+
+    SECTION("id range") {
+        filter.id_range(10, 20, osmium::osm_entity_bits::way);
+        REQUIRE_FALSE(filter.empty());
+        REQUIRE(filter.filters(osmium::item_type::way));
+        REQUIRE_FALSE(filter.filters(osmium::item_type::node));
+        REQUIRE(filter.match_id(osmium::item_type::way, 10));
+        REQUIRE(filter.match_id(osmium::item_type::way, 20));
+        REQUIRE_FALSE(filter.match_id(osmium::item_type::way, 9));
+        REQUIRE_FALSE(filter.match_id(osmium::item_type::way, 21));
+        REQUIRE(filter.match_id(osmium::item_type::node, 9));
+        REQUIRE(filter.match_id_range(osmium::item_type::way, 1, 10));
+        REQUIRE(filter.match_id_range(osmium::item_type::way, 15, 30));
+        REQUIRE_FALSE(filter.match_id_range(osmium::item_type::way, 1, 9));
+        REQUIRE_FALSE(filter.match_id_range(osmium::item_type::way, 21, 30));
+        REQUIRE(filter.match_id_range(osmium::item_type::node, 1, 9));
+    }
+
+    SECTION("empty id range") {
+        REQUIRE_THROWS_AS(filter.id_range(20, 10), const std::invalid_argument&);
+    }
+
+    SECTION("id set") {
+        osmium::index::IdSetSmall<osmium::unsigned_object_id_type> ids;
+        ids.set(3);
+        filter.ids(ids);
+        REQUIRE(filter.filters(osmium::item_type::relation));
+        REQUIRE(filter.match_id(osmium::item_type::node, 3));
+        REQUIRE(filter.match_id(osmium::item_type::node, -3));
+        REQUIRE_FALSE(filter.match_id(osmium::item_type::node, 4));
+        REQUIRE(filter.match_id_range(osmium::item_type::node, 1, 3));
+        REQUIRE(filter.match_id_range(osmium::item_type::node, -5, -2));
+        REQUIRE(filter.match_id_range(osmium::item_type::node, -1, 3));
+        REQUIRE(filter.match_id_range(osmium::item_type::node, -3, 1));
+        REQUIRE_FALSE(filter.match_id_range(osmium::item_type::node, 4, 10));
+        REQUIRE_FALSE(filter.match_id_range(osmium::item_type::node, -2, 2));
+    }
+
+    SECTION("bounding box") {
+        filter.bbox(osmium::Box{0.0, 0.0, 1.0, 1.0});
+        REQUIRE(filter.filters(osmium::item_type::node));
+        REQUIRE_FALSE(filter.filters(osmium::item_type::way));
+        REQUIRE(filter.match_location(osmium::Location{0.5, 1.0}));
+        REQUIRE_FALSE(filter.match_location(osmium::Location{0.5, 1.5}));
+        REQUIRE_FALSE(filter.match_location(osmium::Location{}));
+    }
+
+    SECTION("invalid bounding box") {
+        REQUIRE_THROWS_AS(filter.bbox(osmium::Box{}), const std::invalid_argument&);
+    }
+}
+
+TEST_CASE("Read files with read filter") {
+    int n = 0;
+    for (const char* format : {"pbf", "pbf,pbf_dense_nodes=false", "o5m", "osm"}) {
+        const std::string filename = "test-read-filter-" + std::to_string(++n);
+        {
+            osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+            writer(create_test_data());
+            writer.close();
+        }
+
+        const std::string all{"n1 n2 n3 n4 n5 n6 n7 n8 n9 n10 n11 n12 n13 n14 n15 n16 n17 n18 n19 n20 w1 w2 w3 w4 w5 w6 r1 r2 r3 "};
+        const std::string ways_and_relations{"w1 w2 w3 w4 w5 w6 r1 r2 r3 "};
+
+        for (const char* options : {"", ",parallel_parsing=true"}) {
+            const osmium::io::File file{filename, std::string{format} + options};
+            INFO("format: " << format << options);
+
+            REQUIRE(read_ids(file, osmium::io::ReadFilter{}) == all);
+
+            {
+                osmium::io::ReadFilter filter;
+                filter.id_range(5, 12, osmium::osm_entity_bits::node);
+                REQUIRE(read_ids(file, filter) == "n5 n6 n7 n8 n9 n10 n11 n12 " + ways_and_relations);
+            }
+
+            {
+                osmium::index::IdSetSmall<osmium::unsigned_object_id_type> ids;
+                ids.set(2);
+                ids.set(3);
+                ids.set(5);
+                osmium::io::ReadFilter filter;
+                filter.ids(ids, osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation);
+                REQUIRE(read_ids(file, filter) == all.substr(0, all.find('w')) + "w2 w3 w5 r2 r3 ");
+            }
+
+            {
+                osmium::io::ReadFilter filter;
+                filter.bbox(osmium::Box{0.25, 0.25, 1.05, 1.05});
+                REQUIRE(read_ids(file, filter) == "n3 n4 n5 n6 n7 n8 n9 n10 " + ways_and_relations);
+            }
+
+            {
+                osmium::TagsFilter tags_filter{false};
+                tags_filter.add_rule(true, "amenity");
+                tags_filter.add_rule(true, "highway");
+                osmium::io::ReadFilter filter;
+                filter.tags(tags_filter).bbox(osmium::Box{0.25, 0.25, 1.05, 1.05});
+                REQUIRE(read_ids(file, filter) == "n4 n8 w1 w3 w5 ");
+            }
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/read_header.hpp>
+#include <osmium/io/xml_input.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+static osmium::io::Header header_from_reader(const std::string& filename) {
+    osmium::io::Reader reader{filename};
+    auto header = reader.header();
+    reader.close();
+    return header;
+}
+
+TEST_CASE("Read header of PBF file") {
+    const std::string filename = with_data_dir("t/io/data_pbf_version-1.osm.pbf");
+    const auto expected = header_from_reader(filename);
+    REQUIRE_FALSE(expected.get("generator").empty());
+
+    const auto header = osmium::io::read_header(filename);
+    REQUIRE(header.get("generator") == expected.get("generator"));
+    REQUIRE(header.boxes().size() == expected.boxes().size());
+    REQUIRE(header.has_multiple_object_versions() == expected.has_multiple_object_versions());
+}
+
+TEST_CASE("Read header of PBF data in memory") {
+    std::ifstream file{with_data_dir("t/io/data_pbf_version-1.osm.pbf"), std::ios::binary};
+    const std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    REQUIRE_FALSE(data.empty());
+
+    const auto expected = header_from_reader(with_data_dir("t/io/data_pbf_version-1.osm.pbf"));
+
+    const auto header = osmium::io::read_header(osmium::io::File{data.data(), data.size(), "pbf"});
+    REQUIRE(header.get("generator") == expected.get("generator"));
+
+    SECTION("only header blob needed") {
+        const auto short_header = osmium::io::read_header(osmium::io::File{data.data(), 44, "pbf"});
+        REQUIRE(short_header.get("generator") == expected.get("generator"));
+    }
+
+    SECTION("truncated") {
+        REQUIRE_THROWS_AS(osmium::io::read_header(osmium::io::File{data.data(), 10, "pbf"}), const osmium::pbf_error&);
+        REQUIRE_THROWS_AS(osmium::io::read_header(osmium::io::File{data.data(), 2, "pbf"}), const osmium::pbf_error&);
+    }
+}
+
+TEST_CASE("Read header of truncated PBF file") {
+    std::ifstream file{with_data_dir("t/io/data_pbf_version-1.osm.pbf"), std::ios::binary};
+    const std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+    {
+        std::ofstream out{"test-read-header-truncated.osm.pbf", std::ios::binary};
+        out.write(data.data(), 20);
+    }
+
+    REQUIRE_THROWS_AS(osmium::io::read_header("test-read-header-truncated.osm.pbf"), const osmium::pbf_error&);
+}
+
+TEST_CASE("Read header of XML file") {
+    const auto header = osmium::io::read_header(with_data_dir("t/io/data.osm"));
+    REQUIRE(header.get("generator") == "testdata");
+}
+
+TEST_CASE("Read header of nonexistent file") {
+    REQUIRE_THROWS_AS(osmium::io::read_header(with_data_dir("t/io/nonexistent-file.osm.pbf")), const std::system_error&);
+}
@@ -0,0 +1,199 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/o5m_output.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/read_filter.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Enough nodes so the versions of some of them end up in different
+    // buffers.
+    constexpr const int num_nodes = 20000;
+
+    osmium::Timestamp version_timestamp(int id, int version) noexcept {
+        return osmium::Timestamp{static_cast<uint32_t>(version * 100000 + id)};
+    }
+
+    // Each node has three versions. The third one deletes every fifth
+    // node and adds a tag to every third node. Every seventh node has a
+    // tag in the first version only.
+    osmium::memory::Buffer create_history_data() {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+        for (int id = 1; id <= num_nodes; ++id) {
+            for (int version = 1; version <= 3; ++version) {
+                const bool visible = version < 3 || id % 5 != 0;
+                const auto location = visible ? osmium::Location{id / 10000.0, version / 10.0} : osmium::Location{};
+                const char* key = "";
+                if (version == 1 && id % 7 == 0) {
+                    key = "shop";
+                } else if (version == 3 && id % 3 == 0 && visible) {
+                    key = "amenity";
+                }
+                if (*key) {
+                    osmium::builder::add_node(buffer, _id(id), _version(version), _user("user"),
+                        _timestamp(version_timestamp(id, version)), _visible(visible),
+                        _location(location), _tag(key, "yes"));
+                } else {
+                    osmium::builder::add_node(buffer, _id(id), _version(version), _user("user"),
+                        _timestamp(version_timestamp(id, version)), _visible(visible),
+                        _location(location));
+                }
+            }
+        }
+        for (int id = 1; id <= 10; ++id) {
+            for (int version = 1; version <= 2; ++version) {
+                osmium::builder::add_way(buffer, _id(id), _version(version), _user("user"),
+                    _timestamp(version_timestamp(id, version)), _nodes({1, 2}));
+            }
+        }
+
+        return buffer;
+    }
+
+    struct read_result {
+        int count = 0;
+        int wrong_version = 0;
+        int duplicates = 0;
+        int deleted = 0;
+        int tagged = 0;
+    };
+
+    read_result read_versions(const osmium::io::File& file, const osmium::io::ReadFilter& filter, int expected_version) {
+        read_result result;
+        osmium::item_type last_type = osmium::item_type::undefined;
+        osmium::object_id_type last_id = 0;
+
+        osmium::io::Reader reader{file, filter};
+        while (const auto buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                ++result.count;
+                if (object.type() == last_type && object.id() == last_id) {
+                    ++result.duplicates;
+                }
+                last_type = object.type();
+                last_id = object.id();
+                const int version = object.type() == osmium::item_type::way ? 2 : expected_version;
+                if (object.version() != static_cast<osmium::object_version_type>(version)) {
+                    ++result.wrong_version;
+                }
+                if (object.deleted()) {
+                    ++result.deleted;
+                }
+                if (!object.tags().empty()) {
+                    ++result.tagged;
+                }
+            }
+        }
+        reader.close();
+        REQUIRE(reader.eof());
+
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("ReadFilter version selection conditions") {
+    osmium::io::ReadFilter filter;
+    REQUIRE_FALSE(filter.filters_versions());
+    REQUIRE(filter.match_timestamp(osmium::Timestamp{100}));
+
+    filter.latest_versions(osmium::Timestamp{50});
+    REQUIRE_FALSE(filter.empty());
+    REQUIRE(filter.filters_versions());
+    REQUIRE_FALSE(filter.has_object_conditions());
+    REQUIRE_FALSE(filter.filters(osmium::item_type::node));
+    REQUIRE(filter.point_in_time() == osmium::Timestamp{50});
+    REQUIRE(filter.match_timestamp(osmium::Timestamp{50}));
+    REQUIRE_FALSE(filter.match_timestamp(osmium::Timestamp{51}));
+
+    filter.id_range(1, 10);
+    REQUIRE(filter.has_object_conditions());
+    const auto versions = filter.versions_only();
+    REQUIRE(versions.filters_versions());
+    REQUIRE_FALSE(versions.has_object_conditions());
+    REQUIRE(versions.point_in_time() == osmium::Timestamp{50});
+}
+
+TEST_CASE("Read latest versions from history files") {
+    int n = 0;
+    for (const char* format : {"pbf", "pbf,pbf_dense_nodes=false", "o5m", "osm"}) {
+        const std::string filename = "test-read-latest-versions-" + std::to_string(++n);
+        {
+            osmium::io::File file{filename, format};
+            file.set_has_multiple_object_versions(true);
+            osmium::io::Header header;
+            header.set_has_multiple_object_versions(true);
+            osmium::io::Writer writer{file, header, osmium::io::overwrite::allow};
+            writer(create_history_data());
+            writer.close();
+        }
+
+        for (const char* options : {"", ",parallel_parsing=true"}) {
+            const osmium::io::File file{filename, std::string{format} + options};
+            INFO("format: " << format << options);
+
+            {
+                osmium::io::ReadFilter filter;
+                filter.latest_versions();
+                const auto result = read_versions(file, filter, 3);
+                REQUIRE(result.count == num_nodes + 10);
+                REQUIRE(result.wrong_version == 0);
+                REQUIRE(result.duplicates == 0);
+                REQUIRE(result.deleted == num_nodes / 5);
+                REQUIRE(result.tagged == num_nodes / 3 - num_nodes / 15);
+            }
+
+            {
+                osmium::io::ReadFilter filter;
+                filter.latest_versions(osmium::Timestamp{250000});
+                const auto result = read_versions(file, filter, 2);
+                REQUIRE(result.count == num_nodes + 10);
+                REQUIRE(result.wrong_version == 0);
+                REQUIRE(result.duplicates == 0);
+                REQUIRE(result.deleted == 0);
+                REQUIRE(result.tagged == 0);
+            }
+
+            {
+                osmium::io::ReadFilter filter;
+                filter.latest_versions(osmium::Timestamp{150000});
+                const auto result = read_versions(file, filter, 1); // ways have the wrong version here
+                REQUIRE(result.count == num_nodes + 10);
+                REQUIRE(result.duplicates == 0);
+            }
+
+            {
+                osmium::TagsFilter tags_filter{false};
+                tags_filter.add_rule(true, "shop");
+                osmium::io::ReadFilter filter;
+                filter.tags(tags_filter, osmium::osm_entity_bits::node).latest_versions();
+                REQUIRE(read_versions(file, filter, 3).count == 10);
+            }
+
+            {
+                osmium::TagsFilter tags_filter{false};
+                tags_filter.add_rule(true, "amenity");
+                osmium::io::ReadFilter filter;
+                filter.tags(tags_filter, osmium::osm_entity_bits::node).latest_versions();
+                const auto result = read_versions(file, filter, 3);
+                REQUIRE(result.count == num_nodes / 3 - num_nodes / 15 + 10);
+                REQUIRE(result.wrong_version == 0);
+            }
+        }
+    }
+}
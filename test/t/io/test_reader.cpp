@@ -6,10 +6,18 @@
 #include <osmium/io/any_compression.hpp>
 #include <osmium/io/pbf_input.hpp>
 #include <osmium/io/xml_input.hpp>
+#include <osmium/memory/budget.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/visitor.hpp>
 
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 
 struct CountHandler : public osmium::handler::Handler {
 
@@ -55,6 +63,28 @@ TEST_CASE("Reader can be initialized with file") {
     REQUIRE(count == count_fds());
 }
 
+TEST_CASE("Reader keeps stats") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+
+    osmium::io::Reader reader{file};
+    osmium::handler::Handler handler;
+
+    osmium::apply(reader, handler);
+
+    const auto stats = reader.stats();
+    REQUIRE(stats.file_size == osmium::file_size(with_data_dir("t/io/data.osm")));
+    REQUIRE(stats.bytes_read == stats.file_size);
+    REQUIRE(stats.buffers > 0);
+    REQUIRE(stats.elapsed.count() > 0);
+    REQUIRE(stats.input_queue.name == "raw_input");
+    REQUIRE(stats.input_queue.push_count > 0);
+    REQUIRE(stats.osmdata_queue.name == "parser_results");
+    REQUIRE(stats.osmdata_queue.push_count == stats.buffers);
+    REQUIRE(stats.osmdata_queue.pop_count > 0);
+
+    reader.close();
+}
+
 TEST_CASE("Reader can be initialized with string") {
     const int count = count_fds();
 
@@ -81,6 +111,156 @@ TEST_CASE("Reader can be initialized with user-provided pool") {
     REQUIRE(count == count_fds());
 }
 
+TEST_CASE("Reader with memory budget") {
+    osmium::memory::MemoryBudget budget{1};
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file, budget};
+    CountHandler handler;
+
+    osmium::apply(reader, handler);
+    REQUIRE(handler.count == 1);
+
+    reader.close();
+    REQUIRE(budget.used() == 0);
+    REQUIRE(budget.report().find("parser_results") != std::string::npos);
+}
+
+TEST_CASE("Readers can share pool through pool clients") {
+    osmium::thread::Pool pool{2};
+    osmium::thread::PoolClient client1{pool, 1, 1};
+    osmium::thread::PoolClient client2{pool, 4};
+
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader1{file, client1};
+    osmium::io::Reader reader2{file, client2};
+
+    CountHandler handler1;
+    CountHandler handler2;
+    osmium::apply(reader1, handler1);
+    osmium::apply(reader2, handler2);
+
+    REQUIRE(handler1.count == 1);
+    REQUIRE(handler2.count == 1);
+
+    reader1.close();
+    reader2.close();
+}
+
+TEST_CASE("Reader with buffer pool recycles buffers") {
+    osmium::memory::BufferPool buffer_pool;
+
+    for (int i = 0; i < 2; ++i) {
+        osmium::io::File file{with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf")};
+        osmium::io::Reader reader{file, buffer_pool};
+
+        int count = 0;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            count += static_cast<int>(std::distance(buffer.cbegin<osmium::Node>(), buffer.cend<osmium::Node>()));
+            reader.recycle(std::move(buffer));
+            REQUIRE_FALSE(buffer);
+        }
+        REQUIRE(count == 1);
+        REQUIRE(buffer_pool.size() == 1);
+
+        reader.close();
+    }
+}
+
+TEST_CASE("Reader without buffer pool drops recycled buffers") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file};
+
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        reader.recycle(std::move(buffer));
+        REQUIRE_FALSE(buffer);
+    }
+
+    reader.close();
+}
+
+namespace {
+
+    int count_objects(const osmium::memory::Buffer& buffer) {
+        return static_cast<int>(std::distance(buffer.cbegin(), buffer.cend()));
+    }
+
+    int count_objects_with_read(const osmium::io::File& file) {
+        osmium::io::Reader reader{file};
+        int count = 0;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            count += count_objects(buffer);
+        }
+        reader.close();
+        return count;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Reader with try_read() and ready callback") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    const int expected = count_objects_with_read(file);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int notifications = 0;
+
+    const osmium::io::ready_callback callback{[&]() {
+        const std::lock_guard<std::mutex> lock{mutex};
+        ++notifications;
+        cv.notify_one();
+    }};
+
+    osmium::io::Reader reader{file, callback};
+
+    int count = 0;
+    int seen = 0;
+    while (true) {
+        osmium::memory::Buffer buffer;
+        if (reader.try_read(buffer)) {
+            if (!buffer) {
+                break;
+            }
+            count += count_objects(buffer);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [&]() { return notifications != seen; });
+        seen = notifications;
+    }
+
+    REQUIRE(count == expected);
+    REQUIRE(reader.eof());
+    REQUIRE(notifications > 0);
+    REQUIRE_THROWS_AS(reader.read(), const osmium::io_error&);
+
+    reader.close();
+}
+
+TEST_CASE("Reader with try_read() without ready callback") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    const int expected = count_objects_with_read(file);
+
+    osmium::io::Reader reader{file};
+
+    int count = 0;
+    osmium::memory::Buffer buffer;
+    while (true) {
+        if (!reader.try_read(buffer)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!buffer) {
+            break;
+        }
+        count += count_objects(buffer);
+    }
+
+    REQUIRE(count == expected);
+    REQUIRE(reader.eof());
+
+    reader.close();
+}
+
 TEST_CASE("Reader should throw after eof") {
     const int count = count_fds();
 
@@ -342,3 +522,93 @@ TEST_CASE("Can not read after close") {
     REQUIRE(count == count_fds());
 }
 
+
+TEST_CASE("Reader reads small files synchronously") {
+    const int count = count_fds();
+
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file};
+
+    // All data has already been parsed and the queues are unlimited.
+    // Not available if the queues can't be unlimited.
+    if (!osmium::thread::pipeline_queue_is_bounded) {
+        const auto stats = reader.stats();
+        REQUIRE(stats.osmdata_queue.max_size == 0);
+        REQUIRE(stats.osmdata_queue.push_count > 0);
+        REQUIRE(stats.bytes_read == stats.file_size);
+    }
+
+    REQUIRE(reader.header().get("generator") == "testdata");
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    REQUIRE(handler.count == 1);
+
+    reader.close();
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Reader synchronous mode can be set on the file") {
+    CountHandler handler;
+
+    SECTION("switched off") {
+        osmium::io::File file{with_data_dir("t/io/data.osm"), "osm,synchronous=false"};
+        osmium::io::Reader reader{file};
+        REQUIRE(reader.stats().osmdata_queue.max_size > 0);
+        osmium::apply(reader, handler);
+    }
+
+    SECTION("threshold") {
+        osmium::io::File file{with_data_dir("t/io/data.osm"), "osm,synchronous_threshold=10"};
+        osmium::io::Reader reader{file};
+        REQUIRE(reader.stats().osmdata_queue.max_size > 0);
+        osmium::apply(reader, handler);
+    }
+
+    SECTION("not for compressed file by default") {
+        osmium::io::File file{with_data_dir("t/io/data.osm.gz")};
+        osmium::io::Reader reader{file};
+        REQUIRE(reader.stats().osmdata_queue.max_size > 0);
+        osmium::apply(reader, handler);
+    }
+
+    SECTION("forced with compressed file") {
+        osmium::io::File file{with_data_dir("t/io/data.osm.gz"), "osm.gz,synchronous=true,synchronous_threshold=10"};
+        osmium::io::Reader reader{file};
+        if (!osmium::thread::pipeline_queue_is_bounded) {
+            REQUIRE(reader.stats().osmdata_queue.max_size == 0);
+        }
+        osmium::apply(reader, handler);
+    }
+
+    REQUIRE(handler.count == 1);
+}
+
+TEST_CASE("Reader not synchronous with memory budget") {
+    osmium::memory::MemoryBudget budget{1024 * 1024};
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm"), budget};
+    REQUIRE(reader.stats().osmdata_queue.max_size > 0);
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    REQUIRE(handler.count == 1);
+}
+
+TEST_CASE("Reader not synchronous with source") {
+    const std::string data{"<osm version='0.6'><node id='1' version='1' lat='1' lon='1'/></osm>"};
+    osmium::io::MemorySource source{data.data(), data.size()};
+    osmium::io::Reader reader{osmium::io::File{with_data_dir("t/io/data.osm")}, source};
+    REQUIRE(reader.stats().osmdata_queue.max_size > 0);
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    REQUIRE(handler.count == 1);
+}
+
+TEST_CASE("Reader in synchronous mode reports parse errors when reading") {
+    const std::string data{"<osm version='0.6'><node id='1'></osm>"};
+    osmium::io::File file{data.data(), data.size(), "osm"};
+    osmium::io::Reader reader{file};
+    if (!osmium::thread::pipeline_queue_is_bounded) {
+        REQUIRE(reader.stats().osmdata_queue.max_size == 0);
+    }
+    REQUIRE_THROWS_AS(reader.read(), const osmium::xml_error&);
+    reader.close();
+}
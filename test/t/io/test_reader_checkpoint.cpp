@@ -0,0 +1,233 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/pbf_truncate.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/util/file.hpp>
+
+#include <string>
+
+#include <unistd.h>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_buffer(const int first_id, const int last_id) {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = first_id; id <= last_id; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+    }
+    return buffer;
+}
+
+// Write a PBF file with several blobs (the PBF writer puts at most 8000
+// objects into one blob).
+static void write_pbf_file(const std::string& filename) {
+    osmium::io::Header header;
+    header.set("generator", "test");
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+    writer(create_buffer(1, 20000));
+    writer.close();
+}
+
+struct ids_read {
+    int count = 0;
+    osmium::object_id_type first = 0;
+    osmium::object_id_type last = 0;
+};
+
+static void add_ids(ids_read& ids, const osmium::memory::Buffer& buffer) {
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        if (ids.count == 0) {
+            ids.first = object.id();
+        }
+        ids.last = object.id();
+        ++ids.count;
+    }
+}
+
+// Read until the checkpoint of the reader moves.
+static ids_read read_until_checkpoint(osmium::io::Reader& reader) {
+    const auto start = reader.checkpoint().offset;
+    ids_read ids;
+    while (reader.checkpoint().offset == start) {
+        const auto buffer = reader.read();
+        REQUIRE(buffer);
+        add_ids(ids, buffer);
+    }
+    return ids;
+}
+
+static ids_read read_all(osmium::io::Reader& reader) {
+    ids_read ids;
+    while (const auto buffer = reader.read()) {
+        add_ids(ids, buffer);
+    }
+    return ids;
+}
+
+TEST_CASE("Reader checkpoint before reading") {
+    const std::string filename{"test-reader-checkpoint-0.osm.pbf"};
+    write_pbf_file(filename);
+
+    osmium::io::Reader reader{filename};
+    const auto checkpoint = reader.checkpoint();
+    REQUIRE(checkpoint.offset == 0);
+    REQUIRE(checkpoint.header.get("generator") == "test");
+    reader.close();
+}
+
+TEST_CASE("Resume reading PBF file at checkpoint") {
+    const std::string filename{"test-reader-checkpoint-1.osm.pbf"};
+    write_pbf_file(filename);
+
+    const char* const formats[] = {"pbf", "pbf,mmap=true"};
+    for (const char* format : formats) {
+        INFO(format);
+        const osmium::io::File file{filename, format};
+
+        osmium::io::reader_checkpoint checkpoint;
+        ids_read first;
+        {
+            osmium::io::Reader reader{file};
+            first = read_until_checkpoint(reader);
+            checkpoint = reader.checkpoint();
+            reader.close();
+        }
+        REQUIRE(first.first == 1);
+        REQUIRE(first.count == first.last);
+        REQUIRE(first.count < 20000);
+        REQUIRE(checkpoint.offset < osmium::file_size(filename));
+
+        ids_read second;
+        {
+            osmium::io::Reader reader{file, checkpoint};
+            REQUIRE(reader.checkpoint().offset == checkpoint.offset);
+            second = read_until_checkpoint(reader);
+            checkpoint = reader.checkpoint();
+            reader.close();
+        }
+        REQUIRE(second.first == first.last + 1);
+
+        osmium::io::Reader reader{file, checkpoint};
+        const auto rest = read_all(reader);
+        REQUIRE(reader.checkpoint().offset == osmium::file_size(filename));
+        reader.close();
+
+        REQUIRE(rest.first == second.last + 1);
+        REQUIRE(rest.last == 20000);
+        REQUIRE(first.count + second.count + rest.count == 20000);
+    }
+}
+
+TEST_CASE("Resume reading PBF file at invalid checkpoint") {
+    const std::string filename{"test-reader-checkpoint-2.osm.pbf"};
+    write_pbf_file(filename);
+
+    osmium::io::reader_checkpoint checkpoint;
+
+    SECTION("not at blob boundary") {
+        osmium::io::Reader reader{filename};
+        read_until_checkpoint(reader);
+        checkpoint.offset = reader.checkpoint().offset + 1;
+        reader.close();
+    }
+
+    SECTION("beyond end of file") {
+        checkpoint.offset = osmium::file_size(filename) + 1;
+    }
+
+    osmium::io::Reader reader{filename, checkpoint};
+    REQUIRE_THROWS_AS(read_all(reader), const osmium::pbf_error&);
+    reader.close();
+}
+
+TEST_CASE("Truncate PBF file and append to it") {
+    const std::string filename{"test-reader-checkpoint-3.osm.pbf"};
+    write_pbf_file(filename);
+
+    REQUIRE(osmium::io::truncate_pbf_file(filename) == osmium::file_size(filename));
+
+    osmium::io::reader_checkpoint checkpoint;
+    ids_read first;
+    {
+        osmium::io::Reader reader{filename};
+        first = read_until_checkpoint(reader);
+        checkpoint = reader.checkpoint();
+        reader.close();
+    }
+
+    // Simulate a crash in the middle of writing the next blob.
+    REQUIRE(::truncate(filename.c_str(), static_cast<off_t>(checkpoint.offset + 10)) == 0);
+    REQUIRE(osmium::io::truncate_pbf_file(filename) == checkpoint.offset);
+    REQUIRE(osmium::file_size(filename) == checkpoint.offset);
+
+    {
+        osmium::io::Writer writer{filename, osmium::io::append::yes};
+        writer(create_buffer(static_cast<int>(first.last) + 1, 20000));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename};
+    REQUIRE(reader.header().get("generator") == "test");
+    const auto all = read_all(reader);
+    reader.close();
+
+    REQUIRE(all.first == 1);
+    REQUIRE(all.last == 20000);
+    REQUIRE(all.count == 20000);
+}
+
+TEST_CASE("Truncate PBF file with incomplete header") {
+    const std::string filename{"test-reader-checkpoint-4.osm.pbf"};
+    write_pbf_file(filename);
+
+    REQUIRE(::truncate(filename.c_str(), 10) == 0);
+    REQUIRE(osmium::io::truncate_pbf_file(filename) == 0);
+    REQUIRE(osmium::file_size(filename) == 0);
+
+    {
+        osmium::io::Header header;
+        header.set("generator", "again");
+        osmium::io::Writer writer{filename, header, osmium::io::append::yes};
+        writer(create_buffer(1, 3));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename};
+    REQUIRE(reader.header().get("generator") == "again");
+    REQUIRE(read_all(reader).count == 3);
+    reader.close();
+}
+
+TEST_CASE("Append to OPL file") {
+    const std::string filename{"test-reader-checkpoint-5.opl"};
+    {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(create_buffer(1, 2));
+        writer.close();
+    }
+    {
+        osmium::io::Writer writer{filename, osmium::io::append::yes};
+        writer(create_buffer(3, 4));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename};
+    const auto all = read_all(reader);
+    REQUIRE(reader.checkpoint().offset == 0);
+    reader.close();
+
+    REQUIRE(all.count == 4);
+    REQUIRE(all.last == 4);
+}
+
+TEST_CASE("Can not append to XML file") {
+    REQUIRE_THROWS_AS(osmium::io::Writer("test-reader-checkpoint-6.osm", osmium::io::append::yes), const osmium::io_error&);
+}
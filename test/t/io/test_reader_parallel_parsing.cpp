@@ -0,0 +1,332 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/o5m_output.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <string>
+#include <vector>
+
+static std::string object_summary(const osmium::OSMObject& object) {
+    std::string summary{osmium::item_type_to_char(object.type())};
+    summary += std::to_string(object.id());
+    summary += 'v';
+    summary += std::to_string(object.version());
+    summary += object.visible() ? 'V' : 'D';
+    for (const auto& tag : object.tags()) {
+        summary += ' ';
+        summary += tag.key();
+        summary += '=';
+        summary += tag.value();
+    }
+    return summary;
+}
+
+static std::vector<std::string> read_summaries(const osmium::io::File& file, osmium::io::Header* header = nullptr, osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::all) {
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{file, read_types, pool};
+    if (header) {
+        *header = reader.header();
+    }
+
+    std::vector<std::string> summaries;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            summaries.push_back(object_summary(object));
+        }
+    }
+    reader.close();
+
+    return summaries;
+}
+
+static std::string large_osm_file() {
+    std::string data{"<?xml version='1.0' encoding='UTF-8'?>\n"
+                     "<!-- comment with <node> in it -->\n"
+                     "<osm version=\"0.6\" generator=\"test\">\n"
+                     "  <bounds minlat=\"1\" minlon=\"2\" maxlat=\"3\" maxlon=\"4\"/>\n"};
+    for (int i = 1; i <= 30000; ++i) {
+        data += "  <node id=\"" + std::to_string(i) + "\" version=\"1\" lat=\"1.0\" lon=\"2.0\"";
+        if (i % 3 == 0) {
+            data += "/>\n";
+        } else {
+            data += ">\n    <tag k=\"note\" v=\"a > b\"/>\n    <!-- <way> -->\n  </node>\n";
+        }
+    }
+    data += "  <way id=\"1\" version=\"2\">\n    <nd ref=\"1\"/>\n    <nd ref=\"2\"/>\n  </way>\n"
+            "  <relation id=\"1\" version=\"1\">\n    <member type=\"way\" ref=\"1\" role=\"\"/>\n  </relation>\n"
+            "</osm>\n";
+    return data;
+}
+
+TEST_CASE("Parallel XML parsing gives the same result as serial parsing") {
+    const std::string data = large_osm_file();
+    REQUIRE(data.size() > 2 * 1024 * 1024);
+
+    osmium::io::Header header;
+    const auto serial = read_summaries(osmium::io::File{data.data(), data.size(), "osm"});
+    const auto parallel = read_summaries(osmium::io::File{data.data(), data.size(), "osm,parallel_parsing=true"}, &header);
+
+    REQUIRE(serial.size() == 30002);
+    REQUIRE(serial == parallel);
+
+    REQUIRE(header.get("generator") == "test");
+    REQUIRE(header.box().valid());
+    REQUIRE_FALSE(header.has_multiple_object_versions());
+
+    // Reading from a file the data arrives in several pieces which are
+    // not aligned to element boundaries.
+    const std::string filename{"test_reader_parallel_parsing.osm"};
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+
+    REQUIRE(serial == read_summaries(osmium::io::File{filename, "osm,parallel_parsing=true"}));
+}
+
+TEST_CASE("Parallel XML parsing of test file") {
+    const osmium::io::File serial_file{with_data_dir("t/io/deleted_nodes.osh")};
+    const osmium::io::File parallel_file{with_data_dir("t/io/deleted_nodes.osh"), "osh,parallel_parsing=true"};
+
+    REQUIRE(read_summaries(serial_file) == read_summaries(parallel_file));
+}
+
+TEST_CASE("Parallel XML parsing of change file") {
+    const std::string data{
+        "<?xml version='1.0' encoding='UTF-8'?>\n"
+        "<osmChange version=\"0.6\" generator=\"test\">\n"
+        "  <create>\n    <node id=\"1\" version=\"1\" lat=\"1\" lon=\"1\"/>\n  </create>\n"
+        "  <modify>\n    <node id=\"2\" version=\"2\" lat=\"1\" lon=\"1\"><tag k=\"a\" v=\"b\"/></node>\n"
+        "    <way id=\"3\" version=\"2\"><nd ref=\"2\"/></way>\n  </modify>\n"
+        "  <delete/>\n"
+        "  <delete>\n    <node id=\"4\" version=\"3\"/>\n  </delete>\n"
+        "</osmChange>\n"
+    };
+
+    osmium::io::Header header;
+    const auto summaries = read_summaries(osmium::io::File{data.data(), data.size(), "osc,parallel_parsing=true"}, &header);
+
+    REQUIRE(summaries == std::vector<std::string>({"n1v1V", "n2v2V a=b", "w3v2V", "n4v3D"}));
+    REQUIRE(header.get("generator") == "test");
+    REQUIRE(header.has_multiple_object_versions());
+}
+
+TEST_CASE("Parallel XML parsing of file without objects") {
+    const std::string data{"<osm version=\"0.6\" generator=\"test\"><bounds minlat=\"1\" minlon=\"2\" maxlat=\"3\" maxlon=\"4\"/></osm>"};
+
+    osmium::io::Header header;
+    REQUIRE(read_summaries(osmium::io::File{data.data(), data.size(), "osm,parallel_parsing=true"}, &header).empty());
+    REQUIRE(header.get("generator") == "test");
+}
+
+TEST_CASE("Parallel XML parsing reading only the header") {
+    const std::string data = large_osm_file();
+
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{osmium::io::File{data.data(), data.size(), "osm,parallel_parsing=true"}, osmium::osm_entity_bits::nothing, pool};
+    REQUIRE(reader.header().get("generator") == "test");
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
+
+TEST_CASE("Parallel XML parsing of broken files") {
+    const std::string broken_object{"<osm version=\"0.6\"><node id=\"1\"><tag k=\"a\"></node></osm>"};
+    REQUIRE_THROWS_AS(read_summaries(osmium::io::File{broken_object.data(), broken_object.size(), "osm,parallel_parsing=true"}), const osmium::xml_error&);
+
+    const std::string truncated{"<osm version=\"0.6\"><node id=\"1\"/><node id=\"2\"/>"};
+    REQUIRE_THROWS_AS(read_summaries(osmium::io::File{truncated.data(), truncated.size(), "osm,parallel_parsing=true"}), const osmium::xml_error&);
+
+    const std::string wrong_version{"<osm version=\"0.5\"><node id=\"1\"/></osm>"};
+    REQUIRE_THROWS_AS(read_summaries(osmium::io::File{wrong_version.data(), wrong_version.size(), "osm,parallel_parsing=true"}), const osmium::format_version_error&);
+}
+
+static std::string large_changesets_file() {
+    std::string data{"<?xml version='1.0' encoding='UTF-8'?>\n"
+                     "<osm license=\"test\" version=\"0.6\" generator=\"test\">\n"
+                     "  <bound box=\"-90,-180,90,180\" origin=\"test\"/>\n"};
+    for (int i = 1; i <= 6000; ++i) {
+        const std::string comments = std::to_string(i % 3);
+        data += "  <changeset id=\"" + std::to_string(i) + "\" created_at=\"2020-01-01T00:00:00Z\" closed_at=\"2020-01-01T01:00:00Z\" open=\"false\""
+                " user=\"test\" uid=\"1\" num_changes=\"3\" comments_count=\"" + comments + "\">\n"
+                "    <tag k=\"comment\" v=\"fix &lt;changeset&gt; " + std::to_string(i) + "\"/>\n"
+                "    <discussion>\n";
+        for (int c = 0; c < i % 3; ++c) {
+            data += "      <comment date=\"2020-01-02T00:00:00Z\" uid=\"2\" user=\"other\">\n"
+                    "        <text>comment " + std::to_string(c) + " with &lt;/changeset&gt; in it</text>\n"
+                    "      </comment>\n";
+        }
+        data += "    </discussion>\n  </changeset>\n";
+        if (i % 1000 == 0) {
+            data += "  <node id=\"" + std::to_string(i) + "\" version=\"1\" lat=\"1.0\" lon=\"2.0\"/>\n";
+        }
+    }
+    data += "</osm>\n";
+    return data;
+}
+
+static std::vector<std::string> read_changesets(const osmium::io::File& file, osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::all) {
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{file, read_types, pool};
+
+    std::vector<std::string> summaries;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& item : buffer) {
+            if (item.type() == osmium::item_type::changeset) {
+                const auto& changeset = static_cast<const osmium::Changeset&>(item);
+                std::string summary{"c" + std::to_string(changeset.id()) + " " + changeset.tags().get_value_by_key("comment", "")};
+                for (const auto& comment : changeset.discussion()) {
+                    summary += " [";
+                    summary += comment.user();
+                    summary += ": ";
+                    summary += comment.text();
+                    summary += ']';
+                }
+                summaries.push_back(summary);
+            } else if (item.type() == osmium::item_type::node) {
+                summaries.push_back(object_summary(static_cast<const osmium::OSMObject&>(item)));
+            }
+        }
+    }
+    reader.close();
+
+    return summaries;
+}
+
+TEST_CASE("Parallel XML parsing of changesets dump with discussions") {
+    const std::string data = large_changesets_file();
+    REQUIRE(data.size() > 2 * 1024 * 1024);
+
+    const auto serial = read_changesets(osmium::io::File{data.data(), data.size(), "osm"});
+    const auto parallel = read_changesets(osmium::io::File{data.data(), data.size(), "osm,parallel_parsing=true"});
+
+    REQUIRE(serial.size() == 6006);
+    REQUIRE(serial[0] == "c1 fix <changeset> 1 [other: comment 0 with </changeset> in it]");
+    REQUIRE(serial == parallel);
+
+    SECTION("only changesets") {
+        const auto changesets = read_changesets(osmium::io::File{data.data(), data.size(), "osm,parallel_parsing=true"}, osmium::osm_entity_bits::changeset);
+        REQUIRE(changesets.size() == 6000);
+        REQUIRE(changesets == read_changesets(osmium::io::File{data.data(), data.size(), "osm"}, osmium::osm_entity_bits::changeset));
+    }
+
+    SECTION("only nodes") {
+        const auto nodes = read_changesets(osmium::io::File{data.data(), data.size(), "osm,parallel_parsing=true"}, osmium::osm_entity_bits::node);
+        REQUIRE(nodes == std::vector<std::string>({"n1000v1V", "n2000v1V", "n3000v1V", "n4000v1V", "n5000v1V", "n6000v1V"}));
+    }
+}
+
+static std::string large_opl_file() {
+    std::string data;
+    for (int i = 1; i <= 40000; ++i) {
+        data += "n" + std::to_string(i) + " v1 dV c1 t2014-01-01T00:00:00Z i1 utest Tnote=a%20%b x1.0 y2.0\n";
+        if (i % 1000 == 0) {
+            data += "\r\n# comment\n";
+        }
+    }
+    data += "w1 v2 dV c1 t2014-01-01T00:00:00Z i1 utest T Nn1,n2\n";
+    data += "r1 v1 dV c1 t2014-01-01T00:00:00Z i1 utest T Mw1@"; // no newline at end
+    return data;
+}
+
+TEST_CASE("Parallel OPL parsing gives the same result as serial parsing") {
+    const std::string data = large_opl_file();
+    REQUIRE(data.size() > 2 * 1024 * 1024);
+
+    const auto serial = read_summaries(osmium::io::File{data.data(), data.size(), "opl"});
+    REQUIRE(serial.size() == 40002);
+    REQUIRE(serial == read_summaries(osmium::io::File{data.data(), data.size(), "opl,parallel_parsing=true"}));
+
+    const std::string filename{"test_reader_parallel_parsing.opl"};
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+
+    REQUIRE(serial == read_summaries(osmium::io::File{filename, "opl,parallel_parsing=true"}));
+}
+
+TEST_CASE("Parallel OPL parsing reports the same line numbers in errors") {
+    std::string data = large_opl_file();
+    data.insert(data.size() / 4 * 3, "\nn99 foo\n");
+
+    std::string serial_error;
+    try {
+        read_summaries(osmium::io::File{data.data(), data.size(), "opl"});
+    } catch (const osmium::opl_error& e) {
+        serial_error = e.what();
+    }
+    REQUIRE_FALSE(serial_error.empty());
+
+    std::string parallel_error;
+    try {
+        read_summaries(osmium::io::File{data.data(), data.size(), "opl,parallel_parsing=true"});
+    } catch (const osmium::opl_error& e) {
+        parallel_error = e.what();
+    }
+    REQUIRE(serial_error == parallel_error);
+}
+
+// Writes an o5m file with a reset dataset at the start of every block of
+// 1000 objects.
+static void write_large_o5m_file(const std::string& filename) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::io::Header header;
+    header.add_box(osmium::Box{2.0, 1.0, 4.0, 3.0});
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 250000; ++i) {
+        osmium::builder::add_node(buffer, _id(i), _version(1), _timestamp("2014-01-01T00:00:00Z"), _cid(1), _uid(1), _user("test"),
+                                  _location(i / 100000.0, 2.0), _tag("note", "a b"), _tag("ref", std::to_string(i)));
+        if (i % 1000 == 0) {
+            writer(std::move(buffer));
+            buffer = osmium::memory::Buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        }
+    }
+    osmium::builder::add_way(buffer, _id(1), _version(2), _nodes({1, 2}));
+    osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 1, "outer"));
+    writer(std::move(buffer));
+    writer.close();
+}
+
+TEST_CASE("Parallel o5m parsing gives the same result as serial parsing") {
+    const std::string filename{"test_reader_parallel_parsing.o5m"};
+    write_large_o5m_file(filename);
+
+    osmium::io::Header header;
+    const auto serial = read_summaries(osmium::io::File{filename});
+    REQUIRE(serial.size() == 250002);
+    REQUIRE(serial == read_summaries(osmium::io::File{filename, "o5m,parallel_parsing=true"}, &header));
+    REQUIRE(header.box() == osmium::Box(2.0, 1.0, 4.0, 3.0));
+
+    const auto ways = read_summaries(osmium::io::File{filename, "o5m,parallel_parsing=true"}, nullptr, osmium::osm_entity_bits::way);
+    REQUIRE(ways == std::vector<std::string>({"w1v2V"}));
+}
+
+TEST_CASE("Parallel o5m parsing reading only the header") {
+    const std::string filename{"test_reader_parallel_parsing_header.o5m"};
+    write_large_o5m_file(filename);
+
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{osmium::io::File{filename, "o5m,parallel_parsing=true"}, osmium::osm_entity_bits::nothing, pool};
+    REQUIRE(reader.header().box() == osmium::Box(2.0, 1.0, 4.0, 3.0));
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
+
+TEST_CASE("Parallel o5m parsing of broken file") {
+    const std::string truncated{"\xff\xe0\x04o5m2\xff\x10\x05\x02\x00\x01"};
+    REQUIRE_THROWS_AS(read_summaries(osmium::io::File{truncated.data(), truncated.size(), "o5m,parallel_parsing=true"}), const osmium::o5m_error&);
+
+    const std::string bad_reference{"\xff\xe0\x04o5m2\xff\x10\x05\x02\x00\x00\x00\x05"};
+    REQUIRE_THROWS_AS(read_summaries(osmium::io::File{bad_reference.data(), bad_reference.size(), "o5m,parallel_parsing=true"}), const osmium::o5m_error&);
+}
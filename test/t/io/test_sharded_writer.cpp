@@ -0,0 +1,128 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/pbf_concatenate.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/sharded_writer.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_buffer(const int first_id, const int last_id) {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = first_id; id <= last_id; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+    }
+    osmium::builder::add_way(buffer, _id(first_id), _version(1), _nodes({first_id, last_id}));
+    return buffer;
+}
+
+static std::vector<osmium::io::File> part_files(const std::string& prefix, const char* suffix, const int count) {
+    std::vector<osmium::io::File> files;
+    for (int n = 0; n < count; ++n) {
+        files.emplace_back(prefix + std::to_string(n) + suffix);
+    }
+    return files;
+}
+
+static std::string read_ids(const osmium::io::File& file) {
+    std::string result;
+    osmium::io::Reader reader{file};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            result += osmium::item_type_to_char(object.type());
+            result += std::to_string(object.id());
+            result += ' ';
+        }
+    }
+    reader.close();
+    return result;
+}
+
+TEST_CASE("ShardedWriter needs files") {
+    const std::vector<osmium::io::File> no_files;
+    REQUIRE_THROWS_AS(osmium::io::ShardedWriter(no_files, osmium::io::sharding::round_robin()), const std::invalid_argument&);
+}
+
+TEST_CASE("ShardedWriter id range must be positive") {
+    REQUIRE_THROWS_AS(osmium::io::sharding::id_range(0), const std::invalid_argument&);
+    REQUIRE(osmium::io::sharding::id_range(10).ids_per_shard() == 10);
+    REQUIRE_FALSE(osmium::io::sharding::id_range(10).is_round_robin());
+    REQUIRE(osmium::io::sharding::round_robin().is_round_robin());
+}
+
+TEST_CASE("ShardedWriter writing buffers round robin") {
+    const auto files = part_files("test-sharded-writer-rr-", ".opl", 2);
+    osmium::io::ShardedWriter writer{files, osmium::io::sharding::round_robin(), osmium::io::overwrite::allow};
+    REQUIRE(writer.size() == 2);
+    REQUIRE(writer.files().size() == 2);
+
+    writer(create_buffer(1, 2));
+    writer(create_buffer(3, 4));
+    writer(create_buffer(5, 6));
+    writer.close();
+
+    REQUIRE(read_ids(files[0]) == "n1 n2 w1 n5 n6 w5 ");
+    REQUIRE(read_ids(files[1]) == "n3 n4 w3 ");
+}
+
+TEST_CASE("ShardedWriter writing by id range") {
+    const auto files = part_files("test-sharded-writer-id-", ".opl", 3);
+    osmium::io::ShardedWriter writer{files, osmium::io::sharding::id_range(3), osmium::io::overwrite::allow};
+
+    SECTION("buffers") {
+        writer(create_buffer(1, 8));
+    }
+
+    SECTION("items") {
+        const auto buffer = create_buffer(1, 8);
+        for (const auto& item : buffer) {
+            writer(item);
+        }
+    }
+
+    writer.close();
+
+    REQUIRE(read_ids(files[0]) == "n1 n2 w1 ");
+    REQUIRE(read_ids(files[1]) == "n3 n4 n5 ");
+    REQUIRE(read_ids(files[2]) == "n6 n7 n8 ");
+}
+
+TEST_CASE("Concatenate PBF parts written by ShardedWriter") {
+    osmium::io::Header header;
+    header.set("generator", "test");
+
+    const auto files = part_files("test-sharded-writer-", ".osm.pbf", 2);
+    osmium::io::ShardedWriter writer{files, osmium::io::sharding::round_robin(), header, osmium::io::overwrite::allow};
+    writer(create_buffer(1, 2));
+    writer(create_buffer(3, 4));
+    writer.close();
+
+    const std::vector<std::string> inputs{files[0].filename(), files[1].filename()};
+    const osmium::io::File output{"test-sharded-writer-all.osm.pbf"};
+    REQUIRE(osmium::io::concatenate_pbf_files(inputs, output, header, osmium::io::overwrite::allow) > 0);
+
+    REQUIRE(read_ids(output) == "n1 n2 w1 n3 n4 w3 ");
+
+    osmium::io::Reader reader{output};
+    REQUIRE(reader.header().get("generator") == "test");
+    reader.close();
+}
+
+TEST_CASE("Concatenating PBF needs uncompressed PBF output") {
+    const std::vector<std::string> inputs{"test-sharded-writer-0.osm.pbf"};
+    const osmium::io::Header header;
+
+    REQUIRE_THROWS_AS(osmium::io::concatenate_pbf_files({}, osmium::io::File{"test-sharded-writer-x.osm.pbf"}, header), const std::invalid_argument&);
+    REQUIRE_THROWS_AS(osmium::io::concatenate_pbf_files(inputs, osmium::io::File{"test-sharded-writer-x.opl"}, header), const std::invalid_argument&);
+    REQUIRE_THROWS_AS(osmium::io::concatenate_pbf_files(inputs, osmium::io::File{"test-sharded-writer-x.osm.pbf.gz"}, header), const std::invalid_argument&);
+}
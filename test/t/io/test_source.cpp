@@ -0,0 +1,225 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/bzip2_compression.hpp>
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/source.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+    class TrackingSource : public osmium::io::Source {
+
+        osmium::io::MemorySource m_source;
+
+    public:
+
+        int prefetches = 0;
+        bool closed = false;
+
+        explicit TrackingSource(const std::string& data) :
+            m_source(data.data(), data.size()) {
+        }
+
+        std::size_t read(char* data, std::size_t size) override {
+            // Return only small pieces to exercise partial reads.
+            return m_source.read(data, std::min(size, std::size_t(7)));
+        }
+
+        void prefetch(std::size_t /*offset*/, std::size_t /*size*/) override {
+            ++prefetches;
+        }
+
+        std::size_t size() override {
+            return m_source.size();
+        }
+
+        void close() override {
+            closed = true;
+        }
+
+    }; // class TrackingSource
+
+    std::string read_file(const std::string& filename) {
+        std::ifstream file{filename, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+
+    std::string read_all(osmium::io::Decompressor& decompressor) {
+        std::string result;
+        std::string data;
+        while (!(data = decompressor.read()).empty()) {
+            result += data;
+        }
+        decompressor.close();
+        return result;
+    }
+
+    std::string decompress(const osmium::io::file_compression compression, const std::string& input) {
+        osmium::io::MemorySource source{input.data(), input.size()};
+        auto decompressor = osmium::io::CompressionFactory::instance().create_decompressor(compression, source);
+        REQUIRE(decompressor->file_size() == input.size());
+        return read_all(*decompressor);
+    }
+
+    std::string object_ids(osmium::io::Reader& reader) {
+        std::string result;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                result += osmium::item_type_to_char(object.type());
+                result += std::to_string(object.id());
+                result += ' ';
+            }
+        }
+        reader.close();
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("MemorySource read") {
+    const std::string data{"0123456789"};
+    osmium::io::MemorySource source{data.data(), data.size()};
+    REQUIRE(source.size() == 10);
+
+    char buffer[8];
+    REQUIRE(source.read(buffer, 8) == 8);
+    REQUIRE(std::string(buffer, 8) == "01234567");
+    REQUIRE(source.read(buffer, 8) == 2);
+    REQUIRE(std::string(buffer, 2) == "89");
+    REQUIRE(source.read(buffer, 8) == 0);
+}
+
+TEST_CASE("Scatter read from Source") {
+    const std::string data = read_file(with_data_dir("t/io/data.txt"));
+    REQUIRE(data.size() > 5);
+
+    char first[3];
+    std::vector<char> second(data.size());
+    const std::vector<osmium::io::source_buffer> buffers{{first, sizeof(first)}, {second.data(), second.size()}};
+
+    SECTION("default implementation") {
+        TrackingSource source{data};
+        REQUIRE(source.readv(buffers) == data.size());
+    }
+
+    SECTION("FdSource") {
+        const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/data.txt"));
+        REQUIRE(fd >= 0);
+        osmium::io::FdSource source{fd};
+        REQUIRE(source.size() == data.size());
+        REQUIRE(source.readv(buffers) == data.size());
+        source.close();
+        REQUIRE(source.fd() == -1);
+    }
+
+    REQUIRE(std::string(first, 3) == data.substr(0, 3));
+    REQUIRE(std::string(second.data(), data.size() - 3) == data.substr(3));
+}
+
+TEST_CASE("Reading uncompressed data from Source") {
+    const std::string data = read_file(with_data_dir("t/io/data.osm"));
+    TrackingSource source{data};
+
+    auto decompressor = osmium::io::CompressionFactory::instance().create_decompressor(osmium::io::file_compression::none, source);
+    REQUIRE(read_all(*decompressor) == data);
+    REQUIRE(decompressor->offset() == data.size());
+    REQUIRE(source.prefetches > 0);
+    REQUIRE(source.closed);
+}
+
+TEST_CASE("Reading gzip compressed data from Source") {
+    const std::string input = read_file(with_data_dir("t/io/data_gzip.txt.gz"));
+    const std::string expected = read_file(with_data_dir("t/io/data.txt"));
+
+    SECTION("single member") {
+        REQUIRE(decompress(osmium::io::file_compression::gzip, input) == expected);
+    }
+
+    SECTION("concatenated members") {
+        REQUIRE(decompress(osmium::io::file_compression::gzip, input + input) == expected + expected);
+    }
+
+    SECTION("small reads") {
+        TrackingSource source{input};
+        osmium::io::GzipSourceDecompressor decompressor{source};
+        REQUIRE(read_all(decompressor) == expected);
+        REQUIRE(source.closed);
+    }
+
+    SECTION("truncated") {
+        REQUIRE_THROWS_AS(decompress(osmium::io::file_compression::gzip, input.substr(0, input.size() - 4)), const osmium::gzip_error&);
+    }
+
+    SECTION("corrupt") {
+        const std::string corrupt = read_file(with_data_dir("t/io/corrupt_data_gzip.txt.gz"));
+        REQUIRE_THROWS_AS(decompress(osmium::io::file_compression::gzip, corrupt), const osmium::gzip_error&);
+    }
+}
+
+TEST_CASE("Reading bzip2 compressed data from Source") {
+    const std::string input = read_file(with_data_dir("t/io/data_bzip2.txt.bz2"));
+    const std::string expected = read_file(with_data_dir("t/io/data.txt"));
+
+    SECTION("single stream") {
+        REQUIRE(decompress(osmium::io::file_compression::bzip2, input) == expected);
+    }
+
+    SECTION("concatenated streams") {
+        REQUIRE(decompress(osmium::io::file_compression::bzip2, input + input) == expected + expected);
+    }
+
+    SECTION("small reads") {
+        TrackingSource source{input};
+        osmium::io::Bzip2SourceDecompressor decompressor{source};
+        REQUIRE(read_all(decompressor) == expected);
+        REQUIRE(source.closed);
+    }
+
+    SECTION("truncated") {
+        REQUIRE_THROWS_AS(decompress(osmium::io::file_compression::bzip2, input.substr(0, input.size() - 4)), const osmium::bzip2_error&);
+    }
+
+    SECTION("corrupt") {
+        const std::string corrupt = read_file(with_data_dir("t/io/corrupt_data_bzip2.txt.bz2"));
+        REQUIRE_THROWS_AS(decompress(osmium::io::file_compression::bzip2, corrupt), const osmium::bzip2_error&);
+    }
+}
+
+TEST_CASE("Reader with Source") {
+    osmium::io::Reader reader_normal{with_data_dir("t/io/data.osm")};
+    const auto expected = object_ids(reader_normal);
+    REQUIRE_FALSE(expected.empty());
+
+    SECTION("uncompressed") {
+        const std::string data = read_file(with_data_dir("t/io/data.osm"));
+        osmium::io::MemorySource source{data.data(), data.size()};
+        osmium::io::Reader reader{osmium::io::File{"remote.osm"}, source};
+        REQUIRE(reader.file_size() == data.size());
+        REQUIRE(object_ids(reader) == expected);
+    }
+
+    SECTION("gzip") {
+        const std::string data = read_file(with_data_dir("t/io/data.osm.gz"));
+        TrackingSource source{data};
+        osmium::io::Reader reader{osmium::io::File{"remote.osm.gz"}, source};
+        REQUIRE(object_ids(reader) == expected);
+        REQUIRE(source.closed);
+    }
+
+    SECTION("bzip2") {
+        const std::string data = read_file(with_data_dir("t/io/data.osm.bz2"));
+        osmium::io::MemorySource source{data.data(), data.size()};
+        osmium::io::Reader reader{osmium::io::File{"remote.osm.bz2"}, source};
+        REQUIRE(object_ids(reader) == expected);
+    }
+}
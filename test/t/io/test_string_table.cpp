@@ -138,3 +138,58 @@ TEST_CASE("Lots of strings in string table so chunk overflows") {
     REQUIRE(it == st.end());
 }
 
+
+TEST_CASE("Sort StringTable by frequency") {
+    osmium::io::detail::StringTable st;
+
+    REQUIRE(st.add("foo") == 1);
+    REQUIRE(st.add("bar") == 2);
+    REQUIRE(st.add("baz") == 3);
+    REQUIRE(st.add("baz") == 3);
+    REQUIRE(st.add("bar") == 2);
+    REQUIRE(st.add("baz") == 3);
+    REQUIRE(st.add("qux") == 4);
+
+    REQUIRE(st.count(1) == 1);
+    REQUIRE(st.count(2) == 2);
+    REQUIRE(st.count(3) == 3);
+    REQUIRE(st.count(4) == 1);
+
+    REQUIRE_FALSE(st.is_sorted());
+    st.sort_by_frequency();
+    REQUIRE(st.is_sorted());
+
+    REQUIRE(st.add("baz") == 1);
+    REQUIRE(st.add("bar") == 2);
+    REQUIRE(st.add("foo") == 3);
+    REQUIRE(st.add("qux") == 4);
+    REQUIRE(st.size() == 5);
+
+    const auto& sorted = st.sorted_strings();
+    REQUIRE(sorted.size() == 5);
+    REQUIRE(std::string{} == sorted[0]);
+    REQUIRE(std::string{"baz"} == sorted[1]);
+    REQUIRE(std::string{"bar"} == sorted[2]);
+    REQUIRE(std::string{"foo"} == sorted[3]);
+    REQUIRE(std::string{"qux"} == sorted[4]);
+
+    REQUIRE(st.add("new") == 5);
+    REQUIRE(st.sorted_strings().size() == 6);
+
+    st.clear();
+    REQUIRE_FALSE(st.is_sorted());
+    REQUIRE(st.size() == 1);
+    REQUIRE(st.add("bar") == 1);
+}
+
+TEST_CASE("Hash for strings of different lengths") {
+    const osmium::io::detail::str_hash hash;
+    const std::string s{"abcdefghijklmnopqrstuvwxyz"};
+
+    for (std::size_t len = 0; len < s.size(); ++len) {
+        const std::string a{s, 0, len};
+        const std::string b{s, 0, len + 1};
+        REQUIRE(hash(a.c_str()) == hash(std::string{a}.c_str()));
+        REQUIRE(hash(a.c_str()) != hash(b.c_str()));
+    }
+}
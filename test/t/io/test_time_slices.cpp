@@ -0,0 +1,115 @@
+#include "catch.hpp"
+
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/time_slices.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        explicit BufferSource(std::initializer_list<std::initializer_list<const char*>> buffers) {
+            for (const auto& lines : buffers) {
+                osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+                for (const char* line : lines) {
+                    REQUIRE(osmium::opl_parse(line, buffer));
+                }
+                m_buffers.push_back(std::move(buffer));
+            }
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+    std::string read_versions(const std::string& filename) {
+        std::string result;
+
+        osmium::io::Reader reader{filename};
+        while (const auto buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                result += osmium::item_type_to_char(object.type());
+                result += std::to_string(object.id());
+                result += 'v';
+                result += std::to_string(object.version());
+                result += ' ';
+            }
+        }
+        reader.close();
+
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Write time slices from history data") {
+    osmium::thread::Pool pool{2};
+
+    // The versions of n1 and n2 are spread over several buffers.
+    BufferSource source{
+        {"n1 v1 dV t2020-01-01T00:00:00Z", "n1 v2 dV t2020-03-01T00:00:00Z"},
+        {"n1 v3 dD t2020-05-01T00:00:00Z", "n2 v1 dV t2020-02-01T00:00:00Z"},
+        {"n2 v2 dV t2020-04-01T00:00:00Z"},
+        {},
+        {"n3 v1 dV t2020-04-15T00:00:00Z", "w1 v1 dV t2020-01-15T00:00:00Z", "w2 v1 dV t2020-06-01T00:00:00Z"}
+    };
+
+    const std::vector<osmium::Timestamp> points_in_time{
+        osmium::Timestamp{"2019-01-01T00:00:00Z"},
+        osmium::Timestamp{"2020-02-15T00:00:00Z"},
+        osmium::Timestamp{"2020-04-15T00:00:00Z"},
+        osmium::Timestamp{"2020-06-01T00:00:00Z"}
+    };
+
+    std::vector<std::unique_ptr<osmium::io::Writer>> writers;
+    std::vector<osmium::io::Writer*> writer_ptrs;
+    for (std::size_t n = 0; n < points_in_time.size(); ++n) {
+        writers.emplace_back(new osmium::io::Writer{"test-time-slice-" + std::to_string(n) + ".opl", osmium::io::overwrite::allow});
+        writer_ptrs.push_back(writers.back().get());
+    }
+
+    osmium::io::write_time_slices(source, points_in_time, writer_ptrs, pool);
+
+    for (auto& writer : writers) {
+        writer->close();
+    }
+
+    REQUIRE(read_versions("test-time-slice-0.opl").empty());
+    REQUIRE(read_versions("test-time-slice-1.opl") == "n1v1 n2v1 w1v1 ");
+    REQUIRE(read_versions("test-time-slice-2.opl") == "n1v2 n2v2 n3v1 w1v1 ");
+    REQUIRE(read_versions("test-time-slice-3.opl") == "n2v2 n3v1 w1v1 w2v1 ");
+}
+
+TEST_CASE("Write time slices with invalid arguments") {
+    BufferSource source{};
+    osmium::io::Writer writer{"test-time-slice-invalid.opl", osmium::io::overwrite::allow};
+
+    const std::vector<osmium::Timestamp> unordered{osmium::Timestamp{20}, osmium::Timestamp{10}};
+    REQUIRE_THROWS_AS(osmium::io::write_time_slices(source, unordered, {&writer, &writer}), const std::invalid_argument&);
+    REQUIRE_THROWS_AS(osmium::io::write_time_slices(source, {osmium::Timestamp{10}}, {}), const std::invalid_argument&);
+
+    writer.close();
+}
@@ -0,0 +1,156 @@
+#include "catch.hpp"
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/detail/write_thread.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+class RecordingCompressor final : public osmium::io::Compressor {
+
+    std::vector<std::vector<std::string>>& m_calls;
+    std::size_t m_size = 0;
+
+public:
+
+    explicit RecordingCompressor(std::vector<std::vector<std::string>>& calls) :
+        Compressor(osmium::io::fsync::no),
+        m_calls(calls) {
+    }
+
+    void write(const std::string& data) override {
+        m_calls.push_back({data});
+        m_size += data.size();
+    }
+
+    void write_blocks(const std::vector<std::string>& blocks) override {
+        m_calls.push_back(blocks);
+        for (const auto& block : blocks) {
+            m_size += block.size();
+        }
+    }
+
+    void close() override {
+    }
+
+    std::size_t file_size() const override {
+        return m_size;
+    }
+
+}; // class RecordingCompressor
+
+static std::vector<std::vector<std::string>> run_write_thread(std::size_t batch_size) {
+    osmium::io::detail::future_string_queue_type queue{100, "test"};
+    for (int i = 0; i < 10; ++i) {
+        osmium::io::detail::add_to_queue(queue, std::string(100, static_cast<char>('a' + i)));
+    }
+    osmium::io::detail::add_end_of_data_to_queue(queue);
+
+    std::vector<std::vector<std::string>> calls;
+    std::promise<std::size_t> promise;
+    auto future = promise.get_future();
+    osmium::io::detail::WriteThread write_thread{queue,
+                                                 std::unique_ptr<osmium::io::Compressor>{new RecordingCompressor{calls}},
+                                                 std::move(promise),
+                                                 batch_size};
+    write_thread();
+    REQUIRE(future.get() == 1000);
+
+    return calls;
+}
+
+TEST_CASE("Write thread without batching writes every block on its own") {
+    const auto calls = run_write_thread(0);
+    REQUIRE(calls.size() == 10);
+    for (const auto& call : calls) {
+        REQUIRE(call.size() == 1);
+    }
+}
+
+TEST_CASE("Write thread batches available blocks") {
+    const auto calls = run_write_thread(350);
+    REQUIRE(calls.size() == 3);
+    REQUIRE(calls[0].size() == 4);
+    REQUIRE(calls[1].size() == 4);
+    REQUIRE(calls[2].size() == 2);
+
+    std::string all;
+    for (const auto& call : calls) {
+        for (const auto& block : call) {
+            all += block;
+        }
+    }
+    REQUIRE(all.size() == 1000);
+    REQUIRE(all.front() == 'a');
+    REQUIRE(all.back() == 'j');
+    REQUIRE(std::is_sorted(all.begin(), all.end()));
+}
+
+TEST_CASE("Write thread passes on exceptions") {
+    osmium::io::detail::future_string_queue_type queue{100, "test"};
+    osmium::io::detail::add_to_queue(queue, std::string{"foo"});
+    osmium::io::detail::add_to_queue<std::string>(queue, std::make_exception_ptr(std::runtime_error{"error"}));
+    osmium::io::detail::add_end_of_data_to_queue(queue);
+
+    std::vector<std::vector<std::string>> calls;
+    std::promise<std::size_t> promise;
+    auto future = promise.get_future();
+    osmium::io::detail::WriteThread write_thread{queue,
+                                                 std::unique_ptr<osmium::io::Compressor>{new RecordingCompressor{calls}},
+                                                 std::move(promise),
+                                                 1000};
+    write_thread();
+    REQUIRE_THROWS_AS(future.get(), const std::runtime_error&);
+}
+
+TEST_CASE("reliable_writev writes all blocks in order") {
+    std::vector<std::string> blocks;
+    std::string expected;
+    for (int i = 0; i < 3000; ++i) {
+        blocks.emplace_back(std::to_string(i) + ",");
+        expected += blocks.back();
+    }
+    blocks.emplace_back();
+    blocks.emplace_back(5 * 1024 * 1024, 'x');
+    expected += blocks.back();
+
+    const std::string filename{"test_write_thread_writev.txt"};
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_writev(fd, blocks);
+    osmium::io::detail::reliable_close(fd);
+
+    std::ifstream file{filename, std::ios::binary};
+    const std::string result{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    REQUIRE(result == expected);
+}
+
+TEST_CASE("NoCompressor with batches and write behind") {
+    const std::string filename{"test_write_thread_no_compressor.txt"};
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::NoCompressor compressor{fd, osmium::io::fsync::no};
+    compressor.set_write_behind(64 * 1024);
+
+    std::string expected;
+    for (int i = 0; i < 100; ++i) {
+        std::vector<std::string> blocks{std::string(10000, static_cast<char>('a' + i % 26)), std::to_string(i)};
+        compressor.write_blocks(blocks);
+        compressor.write("\n");
+        expected += blocks[0] + blocks[1] + "\n";
+    }
+    compressor.close();
+    REQUIRE(compressor.file_size() == expected.size());
+
+    std::ifstream file{filename, std::ios::binary};
+    const std::string result{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    REQUIRE(result == expected);
+}
@@ -3,13 +3,16 @@
 #include "utils.hpp"
 
 #include <osmium/io/any_compression.hpp>
+#include <osmium/io/opl_output.hpp>
 #include <osmium/io/output_iterator.hpp>
 #include <osmium/io/xml_input.hpp>
 #include <osmium/io/xml_output.hpp>
 #include <osmium/memory/buffer.hpp>
 
 #include <algorithm>
+#include <fstream>
 #include <iterator>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -113,6 +116,68 @@ TEST_CASE("Writer: Successful writes writing items") {
     REQUIRE(buffer_check.select<osmium::OSMObject>().cbegin()->id() == 1);
 }
 
+TEST_CASE("Writer: Successful writes of shared buffer to several writers") {
+    const int count = count_fds();
+
+    const auto buffer = std::make_shared<const osmium::memory::Buffer>(get_buffer());
+    const auto committed = buffer->committed();
+    const auto num = std::distance(buffer->select<osmium::OSMObject>().cbegin(), buffer->select<osmium::OSMObject>().cend());
+    REQUIRE(num > 0);
+
+    osmium::io::Writer writer_xml{"test-writer-out-shared.osm", osmium::io::overwrite::allow};
+    osmium::io::Writer writer_opl{"test-writer-out-shared.opl", osmium::io::overwrite::allow};
+    writer_xml(buffer);
+    writer_opl(buffer);
+    writer_xml.close();
+    writer_opl.close();
+
+    REQUIRE(count == count_fds());
+    REQUIRE(writer_xml.stats().buffers == 1);
+    REQUIRE(writer_opl.stats().buffers == 1);
+
+    REQUIRE(buffer->committed() == committed);
+    REQUIRE(buffer->select<osmium::OSMObject>().cbegin()->id() == 1);
+
+    osmium::io::Reader reader_check{"test-writer-out-shared.osm"};
+    const osmium::memory::Buffer buffer_check = reader_check.read();
+    REQUIRE(buffer_check.select<osmium::OSMObject>().size() == num);
+    REQUIRE(buffer_check.select<osmium::OSMObject>().cbegin()->id() == 1);
+
+    std::ifstream opl_file{"test-writer-out-shared.opl"};
+    std::string line;
+    std::ptrdiff_t lines = 0;
+    while (std::getline(opl_file, line)) {
+        ++lines;
+    }
+    REQUIRE(lines == num);
+}
+
+TEST_CASE("Writer: Empty shared buffers are ignored") {
+    osmium::io::Writer writer{"test-writer-out-shared-empty.osm", osmium::io::overwrite::allow};
+    writer(std::shared_ptr<const osmium::memory::Buffer>{});
+    writer(std::make_shared<const osmium::memory::Buffer>());
+    writer(std::make_shared<const osmium::memory::Buffer>(1024));
+    writer.close();
+
+    REQUIRE(writer.stats().buffers == 0);
+}
+
+TEST_CASE("Writer: Keeps stats") {
+    auto buffer = get_buffer();
+
+    std::string filename = "test-writer-out-stats.osm";
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    const auto file_size = writer.close();
+
+    const auto stats = writer.stats();
+    REQUIRE(stats.buffers == 1);
+    REQUIRE(stats.bytes_written == file_size);
+    REQUIRE(stats.elapsed.count() > 0);
+    REQUIRE(stats.output_queue.name == "raw_output");
+    REQUIRE(stats.output_queue.push_count > 0);
+}
+
 TEST_CASE("Writer: Successful writes using output iterator") {
     const int count = count_fds();
 
@@ -223,3 +288,50 @@ TEST_CASE("Writer with user-provided pool with outlier positive number of thread
     REQUIRE(count == count_fds());
 }
 
+
+TEST_CASE("Writer: Synchronous writes") {
+    const int count = count_fds();
+
+    auto buffer = get_and_check_buffer();
+    const auto num = buffer.select<osmium::OSMObject>().size();
+
+    std::string filename = "test-writer-out-sync.osm";
+
+    SECTION("buffer") {
+        osmium::io::Writer writer{osmium::io::File{filename, "osm,synchronous=true"}, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        const auto file_size = writer.close();
+        REQUIRE(file_size > 0);
+        REQUIRE(writer.stats().bytes_written == file_size);
+        if (!osmium::thread::pipeline_queue_is_bounded) {
+            REQUIRE(writer.stats().output_queue.max_size == 0);
+        }
+    }
+
+    SECTION("items without close") {
+        osmium::io::Writer writer{osmium::io::File{filename, "osm,synchronous=true"}, osmium::io::overwrite::allow};
+        for (const auto& item : buffer) {
+            writer(item);
+        }
+    }
+
+    SECTION("compressed") {
+        filename += ".gz";
+        osmium::io::Writer writer{osmium::io::File{filename, "osm.gz,synchronous=true"}, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    REQUIRE(count == count_fds());
+
+    osmium::io::Reader reader_check{filename};
+    const osmium::memory::Buffer buffer_check = reader_check.read();
+    REQUIRE(buffer_check);
+    REQUIRE(buffer_check.select<osmium::OSMObject>().size() == num);
+    REQUIRE(buffer_check.select<osmium::OSMObject>().cbegin()->id() == 1);
+}
+
+TEST_CASE("Writer: Writing pre-encoded data is not supported for XML") {
+    osmium::io::Writer writer{"test-writer-out-encoded.osm", osmium::io::overwrite::allow};
+    REQUIRE_THROWS_AS(writer.write_encoded(std::string{"<node/>"}), const osmium::io_error&);
+}
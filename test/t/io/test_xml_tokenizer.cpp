@@ -0,0 +1,220 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using osmium::io::detail::xml_tokenizer;
+
+static std::string summary(const osmium::memory::Buffer& buffer) {
+    std::string result;
+    for (const auto& item : buffer.select<osmium::OSMEntity>()) {
+        if (item.type() == osmium::item_type::changeset) {
+            const auto& changeset = static_cast<const osmium::Changeset&>(item);
+            result += 'c' + std::to_string(changeset.id());
+            for (const auto& comment : changeset.discussion()) {
+                result += " [" + std::string{comment.user()} + ':' + comment.text() + ']';
+            }
+            for (const auto& tag : changeset.tags()) {
+                result += ' ' + std::string{tag.key()} + '=' + tag.value();
+            }
+            result += '\n';
+            continue;
+        }
+        const auto& object = static_cast<const osmium::OSMObject&>(item);
+        result += osmium::item_type_to_char(object.type());
+        result += std::to_string(object.id()) + 'v' + std::to_string(object.version());
+        result += object.visible() ? 'V' : 'D';
+        result += ' ' + std::string{object.user()} + ' ' + object.timestamp().to_iso();
+        if (object.type() == osmium::item_type::node) {
+            const auto& location = static_cast<const osmium::Node&>(object).location();
+            if (location.valid()) {
+                result += ' ' + std::to_string(location.x()) + ',' + std::to_string(location.y());
+            }
+        } else if (object.type() == osmium::item_type::way) {
+            for (const auto& node_ref : static_cast<const osmium::Way&>(object).nodes()) {
+                result += " n" + std::to_string(node_ref.ref());
+            }
+        } else if (object.type() == osmium::item_type::relation) {
+            for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                result += ' ' + std::string(1, osmium::item_type_to_char(member.type())) + std::to_string(member.ref()) + '@' + member.role();
+            }
+        }
+        for (const auto& tag : object.tags()) {
+            result += ' ' + std::string{tag.key()} + '=' + tag.value();
+        }
+        result += '\n';
+    }
+    return result;
+}
+
+static std::string parse(const std::string& data, xml_tokenizer tokenizer, std::size_t split = std::string::npos) {
+    osmium::io::detail::XMLContentParser parser{osmium::osm_entity_bits::all, nullptr, nullptr, nullptr, nullptr, tokenizer};
+    if (split < data.size()) {
+        parser.parse(data.substr(0, split), false);
+        parser.parse(data.substr(split), true);
+    } else {
+        parser.parse(data, true);
+    }
+    return summary(parser.release_buffer());
+}
+
+static const std::string test_document{
+    "\xef\xbb\xbf<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+    "<!-- a comment with <node id=\"9\"/> in it -->\n"
+    "<?some processing instruction?>\n"
+    "<osm version='0.6' generator=\"test\">\n"
+    "  <node id=\"1\" version=\"2\" timestamp=\"2015-01-01T01:00:00Z\" user=\"&lt;x&amp;y&gt; &quot;&apos;\" lat=\"1.5\" lon=\"-2.25\">\n"
+    "    <tag k=\"name\" v=\"M&#252;nchen &#x1F600; a&#10;b\"/>\n"
+    "    <tag k = 'multi' v='line\n\tvalue\r\nend'  />\n"
+    "    <tag k=\"&amp;&amp;\" v=\"a>b\"/>\n"
+    "  </node>\n"
+    "  <node id=\"2\" version=\"1\" visible=\"false\"/>\n"
+    "  <way id=\"3\" version=\"1\"><nd ref=\"1\"/><nd ref=\"2\" /><!-- <nd ref=\"4\"/> --></way>\n"
+    "  <relation id=\"4\" version=\"1\">\n"
+    "    <member type=\"node\" ref=\"1\" role=\"a&amp;b\"/>\n"
+    "    <member type=\"way\" ref=\"3\" role=\"\"/>\n"
+    "  </relation>\n"
+    "  <changeset id=\"5\" num_changes=\"1\" comments_count=\"2\">\n"
+    "    <tag k=\"comment\" v=\"x\"/>\n"
+    "    <discussion>\n"
+    "      <comment uid=\"1\" user=\"u\" date=\"2015-01-01T01:00:00Z\"><text>one &amp; two\r\nthree</text></comment>\n"
+    "      <comment uid=\"2\" user=\"v\" date=\"2015-01-01T01:00:00Z\"><text><![CDATA[<b>bold</b> & more]]> text</text></comment>\n"
+    "    </discussion>\n"
+    "  </changeset>\n"
+    "</osm >\n"
+    "<!-- trailing comment -->\n"
+};
+
+TEST_CASE("OSM XML tokenizer gives the same result as expat") {
+    const auto expected = parse(test_document, xml_tokenizer::expat);
+    REQUIRE(expected.find("user=") == std::string::npos);
+    REQUIRE(expected.find("<x&y> \"'") != std::string::npos);
+    REQUIRE(expected.find("M\xc3\xbcnchen \xf0\x9f\x98\x80 a\nb") != std::string::npos);
+    REQUIRE(expected.find("multi=line  value end") != std::string::npos);
+    REQUIRE(expected.find("[u:one & two\nthree]") != std::string::npos);
+    REQUIRE(expected.find("[v:<b>bold</b> & more text]") != std::string::npos);
+
+    REQUIRE(parse(test_document, xml_tokenizer::osm) == expected);
+}
+
+TEST_CASE("OSM XML tokenizer with data split anywhere") {
+    const auto expected = parse(test_document, xml_tokenizer::expat);
+    for (std::size_t split = 0; split < test_document.size(); ++split) {
+        REQUIRE(parse(test_document, xml_tokenizer::osm, split) == expected);
+    }
+}
+
+TEST_CASE("OSM XML tokenizer on test file") {
+    std::ifstream file{with_data_dir("t/io/data.osm"), std::ios::binary};
+    const std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    REQUIRE_FALSE(data.empty());
+
+    REQUIRE(parse(data, xml_tokenizer::osm) == parse(data, xml_tokenizer::expat));
+}
+
+TEST_CASE("OSM XML tokenizer falls back to expat") {
+    SECTION("DOCTYPE") {
+        const std::string data{"<?xml version='1.0'?>\n<!DOCTYPE osm>\n<osm version='0.6'><node id='1' version='1'/></osm>"};
+        const auto expected = parse(data, xml_tokenizer::expat);
+        REQUIRE(expected.substr(0, 5) == "n1v1V");
+        REQUIRE(parse(data, xml_tokenizer::osm) == expected);
+        REQUIRE(parse(data, xml_tokenizer::osm, 25) == expected);
+    }
+
+    SECTION("Entity declaration") {
+        const std::string data{"<?xml version='1.0'?>\n<!DOCTYPE osm [<!ENTITY x 'y'>]>\n<osm version='0.6'><node id='1' user='&x;'/></osm>"};
+        REQUIRE_THROWS_WITH(parse(data, xml_tokenizer::osm), "XML entities are not supported");
+    }
+
+    SECTION("Encoding") {
+        const std::string data{"<?xml version='1.0' encoding='ISO-8859-1'?>\n<osm version='0.6'><node id='1' user='\xe4'/></osm>"};
+        const auto expected = parse(data, xml_tokenizer::expat);
+        REQUIRE(expected.find("\xc3\xa4") != std::string::npos);
+        REQUIRE(parse(data, xml_tokenizer::osm) == expected);
+    }
+}
+
+TEST_CASE("OSM XML tokenizer rejects malformed input") {
+    const char* const documents[] = {
+        "",
+        "   ",
+        "<osm version='0.6'>",
+        "<osm version='0.6'><node id='1'></osm>",
+        "<osm version='0.6'></node></osm>",
+        "<osm version='0.6'/></osm>",
+        "<osm version='0.6'/><osm version='0.6'/>",
+        "<osm version='0.6'/>junk",
+        "junk<osm version='0.6'/>",
+        "<osm version='0.6'><node id='1' user='a<b'/></osm>",
+        "<osm version='0.6'><node id='1' user='a&b'/></osm>",
+        "<osm version='0.6'><node id='1' user='&unknown;'/></osm>",
+        "<osm version='0.6'><node id='1' user='&#0;'/></osm>",
+        "<osm version='0.6'><node id='1' user='&#xD800;'/></osm>",
+        "<osm version='0.6'><node id='1' user='&#x110000;'/></osm>",
+        "<osm version='0.6'><node id='1' user='&#12a;'/></osm>",
+        "<osm version='0.6'><node id='1' id='2'/></osm>",
+        "<osm version='0.6'><node id='1'user='a'/></osm>",
+        "<osm version='0.6'><node id/></osm>",
+        "<osm version='0.6'><node id='1/></osm>",
+        "<osm version='0.6'><node id='1' / ></osm>",
+        "<osm version='0.6'><1node/></osm>",
+        "<osm version='0.6'>< node/></osm>",
+        "<osm version='0.6'><node id='1'/><!-- unclosed</osm>",
+        "<osm version='0.6'><!ELEMENT x></osm>",
+        "<osm version='0.6'><node id='1'>&bad;</node></osm>",
+        "<osm version='0.6'></osm><!DOCTYPE osm>"
+    };
+
+    for (const auto* document : documents) {
+        INFO(document);
+        REQUIRE_THROWS_AS(parse(document, xml_tokenizer::expat), const osmium::xml_error&);
+        REQUIRE_THROWS_AS(parse(document, xml_tokenizer::osm), const osmium::xml_error&);
+    }
+}
+
+TEST_CASE("OSM XML tokenizer reports line of error") {
+    try {
+        parse("<osm version='0.6'>\n<node id='1'>\n</way>\n</osm>", xml_tokenizer::osm);
+        REQUIRE(false);
+    } catch (const osmium::xml_error& e) {
+        REQUIRE(e.line == 3);
+        REQUIRE(std::string{e.what()} == "XML parsing error at line 3: mismatched tag");
+    }
+}
+
+TEST_CASE("Reader with xml_tokenizer option") {
+    const std::string filename = with_data_dir("t/io/data.osm");
+
+    osmium::io::Reader reader_expat{filename};
+    const auto expected = summary(reader_expat.read());
+    reader_expat.close();
+
+    SECTION("serial") {
+        osmium::io::Reader reader{osmium::io::File{filename, "osm,xml_tokenizer=osm"}};
+        REQUIRE(summary(reader.read()) == expected);
+        reader.close();
+    }
+
+    SECTION("parallel") {
+        osmium::io::Reader reader{osmium::io::File{filename, "osm,xml_tokenizer=osm,parallel_parsing=true"}};
+        REQUIRE(summary(reader.read()) == expected);
+        reader.close();
+    }
+}
+
+TEST_CASE("Reader with invalid xml_tokenizer option") {
+    osmium::io::Reader reader{osmium::io::File{with_data_dir("t/io/data.osm"), "osm,xml_tokenizer=foo"}};
+    REQUIRE_THROWS_AS(reader.read(), const std::invalid_argument&);
+    reader.close();
+}
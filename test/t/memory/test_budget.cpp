@@ -0,0 +1,84 @@
+#include "catch.hpp"
+
+#include <osmium/memory/budget.hpp>
+
+#include <string>
+#include <utility>
+
+TEST_CASE("Memory budget with accounts") {
+    osmium::memory::MemoryBudget budget{1000};
+    REQUIRE(budget.limit() == 1000);
+    REQUIRE(budget.used() == 0);
+    REQUIRE(budget.available() == 1000);
+
+    auto a = budget.add_account("a");
+    auto b = budget.add_account("b");
+    REQUIRE(a.valid());
+    REQUIRE(a.budget() == &budget);
+
+    a.add(300);
+    b.set(500);
+    REQUIRE(a.used() == 300);
+    REQUIRE(b.used() == 500);
+    REQUIRE(budget.used() == 800);
+    REQUIRE(budget.available() == 200);
+
+    REQUIRE_FALSE(a.try_add(300));
+    REQUIRE(a.used() == 300);
+    REQUIRE(a.try_add(200));
+    REQUIRE(budget.available() == 0);
+    REQUIRE_FALSE(budget.exceeded());
+
+    b.add(100);
+    REQUIRE(budget.exceeded());
+    REQUIRE(budget.peak() == 1100);
+
+    a.sub(600);
+    REQUIRE(a.used() == 0);
+    REQUIRE(budget.used() == 600);
+    REQUIRE(budget.peak() == 1100);
+
+    b.reset();
+    REQUIRE_FALSE(b.valid());
+    REQUIRE(budget.used() == 0);
+}
+
+TEST_CASE("Memory budget accounts give back memory when destroyed") {
+    osmium::memory::MemoryBudget budget{1000};
+    {
+        auto a = budget.add_account("a");
+        a.set(700);
+        auto b = std::move(a);
+        REQUIRE_FALSE(a.valid()); // NOLINT(bugprone-use-after-move,hicpp-invalid-access-moved)
+        REQUIRE(b.used() == 700);
+        REQUIRE(budget.used() == 700);
+    }
+    REQUIRE(budget.used() == 0);
+}
+
+TEST_CASE("Default constructed memory budget account") {
+    osmium::memory::MemoryBudget::account account;
+    REQUIRE_FALSE(account.valid());
+    REQUIRE(account.try_add(1000));
+    account.add(10);
+    REQUIRE(account.used() == 0);
+}
+
+TEST_CASE("Memory budget report and check") {
+    osmium::memory::MemoryBudget budget{1000};
+    auto a = budget.add_account("queue");
+    auto b = budget.add_account("index");
+    {
+        auto c = budget.add_account("gone");
+        c.set(1);
+    }
+    a.set(400);
+    b.set(500);
+
+    REQUIRE(budget.report() == "memory budget 1000 bytes, used 900 bytes (peak 900): queue 400, index 500");
+    REQUIRE_NOTHROW(budget.check());
+
+    b.set(700);
+    REQUIRE_THROWS_AS(budget.check(), const osmium::memory_budget_exceeded&);
+    REQUIRE_THROWS_WITH(budget.check(), "memory budget 1000 bytes, used 1100 bytes (peak 1100): queue 400, index 700");
+}
@@ -0,0 +1,148 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_allocator.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/node.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace {
+
+    class CountingAllocator : public osmium::memory::BufferAllocator {
+
+    public:
+
+        int allocations = 0;
+        int deallocations = 0;
+        int reallocations = 0;
+        std::size_t bytes = 0;
+
+        unsigned char* allocate(std::size_t size) override {
+            ++allocations;
+            bytes += size;
+            return new unsigned char[size];
+        }
+
+        void deallocate(unsigned char* data, std::size_t size) noexcept override {
+            ++deallocations;
+            bytes -= size;
+            delete[] data;
+        }
+
+        unsigned char* reallocate(unsigned char* data, std::size_t old_size, std::size_t used, std::size_t new_size) override {
+            ++reallocations;
+            return BufferAllocator::reallocate(data, old_size, used, new_size);
+        }
+
+    }; // class CountingAllocator
+
+} // anonymous namespace
+
+TEST_CASE("Buffer with custom allocator") {
+    CountingAllocator allocator;
+
+    {
+        osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::yes, allocator};
+        REQUIRE(allocator.allocations == 1);
+        REQUIRE(allocator.bytes == 128);
+
+        osmium::builder::add_node(buffer, osmium::builder::attr::_id(1));
+        buffer.grow(1024);
+        REQUIRE(allocator.reallocations == 1);
+        REQUIRE(allocator.allocations == 2);
+        REQUIRE(allocator.deallocations == 1);
+        REQUIRE(allocator.bytes == 1024);
+        REQUIRE(buffer.get<osmium::Node>(0).id() == 1);
+    }
+
+    REQUIRE(allocator.allocations == allocator.deallocations);
+    REQUIRE(allocator.bytes == 0);
+}
+
+TEST_CASE("Internally growing buffer with custom allocator") {
+    CountingAllocator allocator;
+
+    {
+        osmium::memory::Buffer buffer{64, osmium::memory::Buffer::auto_grow::internal, allocator};
+        for (int i = 1; i <= 3; ++i) {
+            osmium::builder::add_node(buffer, osmium::builder::attr::_id(i));
+        }
+        REQUIRE(buffer.has_nested_buffers());
+        REQUIRE(allocator.allocations > 1);
+    }
+
+    REQUIRE(allocator.allocations == allocator.deallocations);
+    REQUIRE(allocator.bytes == 0);
+}
+
+TEST_CASE("Released buffer memory knows its allocator and size") {
+    CountingAllocator allocator;
+
+    osmium::memory::Buffer buffer{256, osmium::memory::Buffer::auto_grow::yes, allocator};
+    auto memory = buffer.release_memory();
+    REQUIRE_FALSE(buffer);
+    REQUIRE(memory.get_deleter().size() == 256);
+    REQUIRE(&memory.get_deleter().allocator() == &allocator);
+
+    memory.reset();
+    REQUIRE(allocator.deallocations == 1);
+}
+
+TEST_CASE("Buffer pool with custom allocator") {
+    CountingAllocator allocator;
+
+    {
+        osmium::memory::BufferPool pool{allocator};
+
+        auto buffer = pool.get(1024);
+        REQUIRE(allocator.allocations == 1);
+        REQUIRE(buffer.capacity() == 1024);
+
+        pool.put(std::move(buffer));
+        REQUIRE(pool.size() == 1);
+
+        auto buffer2 = pool.get(512);
+        REQUIRE(allocator.allocations == 1);
+        REQUIRE(buffer2.capacity() == 1024);
+    }
+
+    REQUIRE(allocator.allocations == allocator.deallocations);
+    REQUIRE(allocator.bytes == 0);
+}
+
+TEST_CASE("Buffer from unique_ptr uses default allocator") {
+    std::unique_ptr<unsigned char[]> data{new unsigned char[64]};
+    osmium::memory::Buffer buffer{std::move(data), 64, 0, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(buffer.capacity() == 64);
+    buffer.grow(128);
+    REQUIRE(buffer.capacity() == 128);
+}
+
+TEST_CASE("Counting buffer allocator") {
+    CountingAllocator base;
+    osmium::memory::CountingBufferAllocator allocator{base};
+
+    {
+        osmium::memory::Buffer buffer1{1024, osmium::memory::Buffer::auto_grow::yes, allocator};
+        REQUIRE(allocator.used_memory() == 1024);
+
+        {
+            const osmium::memory::Buffer buffer2{512, osmium::memory::Buffer::auto_grow::no, allocator};
+            REQUIRE(allocator.used_memory() == 1536);
+        }
+        REQUIRE(allocator.used_memory() == 1024);
+
+        buffer1.grow(4096);
+        REQUIRE(allocator.used_memory() == 4096);
+        REQUIRE(allocator.peak_memory() >= 4096);
+        REQUIRE(base.bytes == 4096);
+    }
+
+    REQUIRE(allocator.used_memory() == 0);
+    REQUIRE(allocator.peak_memory() >= 4096);
+    REQUIRE(base.allocations == base.deallocations);
+}
@@ -1,9 +1,13 @@
 #include "catch.hpp"
 
+#include <osmium/builder/attr.hpp>
 #include <osmium/memory/buffer.hpp>
 
+#include <algorithm>
 #include <array>
+#include <memory>
 #include <stdexcept>
+#include <string>
 
 TEST_CASE("Buffer basics") {
     osmium::memory::Buffer invalid_buffer1;
@@ -87,6 +91,32 @@ TEST_CASE("Reserve space in a growing buffer") {
     REQUIRE(buffer.written() == 1020);
 }
 
+TEST_CASE("Reserve space in an internally growing buffer") {
+    osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::internal};
+
+    unsigned char* committed_data = buffer.reserve_space(64);
+    std::fill_n(committed_data, 64, 'a');
+    buffer.commit();
+
+    unsigned char* uncommitted_data = buffer.reserve_space(32);
+    std::fill_n(uncommitted_data, 32, 'b');
+
+    // needs a new block for the uncommitted data plus 1000 bytes
+    REQUIRE(buffer.reserve_space(1000) != nullptr);
+    REQUIRE(buffer.has_nested_buffers());
+    REQUIRE(buffer.capacity() >= 1032);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(buffer.written() == 1032);
+    REQUIRE(std::all_of(buffer.data(), buffer.data() + 32, [](unsigned char c) {
+        return c == 'b';
+    }));
+
+    const auto nested = buffer.get_last_nested();
+    REQUIRE(nested->data() == committed_data);
+    REQUIRE(nested->committed() == 64);
+    REQUIRE_FALSE(buffer.has_nested_buffers());
+}
+
 TEST_CASE("Create buffer from existing data with good alignment works") {
     std::array<unsigned char, 128> data = {{0}};
 
@@ -129,3 +159,81 @@ TEST_CASE("Create buffer from existing data with bad alignment fails") {
     REQUIRE_THROWS_AS(l4(), const std::invalid_argument&);
 }
 
+
+TEST_CASE("Buffer content type") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(buffer.content_type() == osmium::item_type::undefined);
+
+    osmium::builder::add_node(buffer, _id(1));
+    buffer.set_content_type(osmium::item_type::node);
+    REQUIRE(buffer.content_type() == osmium::item_type::node);
+
+    osmium::memory::Buffer moved{std::move(buffer)};
+    REQUIRE(moved.content_type() == osmium::item_type::node);
+
+    SECTION("commit removes mark") {
+        osmium::builder::add_way(moved, _id(1));
+        REQUIRE(moved.content_type() == osmium::item_type::undefined);
+    }
+
+    SECTION("clear removes mark") {
+        moved.clear();
+        REQUIRE(moved.content_type() == osmium::item_type::undefined);
+    }
+}
+
+TEST_CASE("Buffer source data") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE_FALSE(buffer.source_data());
+    REQUIRE_FALSE(buffer.source_data_unchanged());
+
+    osmium::builder::add_node(buffer, _id(1), _tag("a", "b"));
+    buffer.set_source_data(std::make_shared<const std::string>("raw"));
+    REQUIRE(*buffer.source_data() == "raw");
+    REQUIRE(buffer.source_data_unchanged());
+
+    osmium::memory::Buffer moved{std::move(buffer)};
+    REQUIRE(moved.source_data_unchanged());
+
+    SECTION("changes are detected") {
+        moved.get<osmium::Node>(0).set_id(2);
+        REQUIRE(moved.source_data());
+        REQUIRE_FALSE(moved.source_data_unchanged());
+        moved.get<osmium::Node>(0).set_id(1);
+        REQUIRE(moved.source_data_unchanged());
+    }
+
+    SECTION("commit removes source data") {
+        osmium::builder::add_way(moved, _id(1));
+        REQUIRE_FALSE(moved.source_data());
+    }
+
+    SECTION("clear removes source data") {
+        moved.clear();
+        REQUIRE_FALSE(moved.source_data());
+    }
+}
+
+TEST_CASE("Buffer input end offset") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(buffer.input_end_offset() == 0);
+
+    osmium::builder::add_node(buffer, _id(1));
+    buffer.set_input_end_offset(123);
+
+    osmium::memory::Buffer moved{std::move(buffer)};
+    REQUIRE(moved.input_end_offset() == 123);
+
+    SECTION("commit keeps offset") {
+        osmium::builder::add_way(moved, _id(1));
+        REQUIRE(moved.input_end_offset() == 123);
+    }
+
+    SECTION("clear removes offset") {
+        moved.clear();
+        REQUIRE(moved.input_end_offset() == 0);
+    }
+}
@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/node.hpp>
+
+#include <array>
+#include <utility>
+
+TEST_CASE("Release memory from buffer") {
+    osmium::memory::Buffer buffer{1024};
+    const auto* data = buffer.data();
+    const auto memory = buffer.release_memory();
+    REQUIRE(memory.get() == data);
+    REQUIRE_FALSE(buffer);
+    REQUIRE(buffer.capacity() == 0);
+}
+
+TEST_CASE("Release memory from buffer with external memory") {
+    std::array<unsigned char, 128> data{};
+    osmium::memory::Buffer buffer{data.data(), data.size(), 0};
+    REQUIRE_FALSE(buffer.release_memory());
+    REQUIRE_FALSE(buffer);
+}
+
+TEST_CASE("Empty buffer pool creates new buffers") {
+    osmium::memory::BufferPool pool;
+    REQUIRE(pool.size() == 0);
+
+    const auto buffer = pool.get(1024, osmium::memory::Buffer::auto_grow::no);
+    REQUIRE(buffer);
+    REQUIRE(buffer.capacity() == 1024);
+    REQUIRE(buffer.committed() == 0);
+}
+
+TEST_CASE("Buffer pool reuses memory") {
+    osmium::memory::BufferPool pool;
+
+    osmium::memory::Buffer buffer{4096, osmium::memory::Buffer::auto_grow::no};
+    osmium::builder::add_node(buffer, osmium::builder::attr::_id(1));
+    REQUIRE(buffer.committed() > 0);
+    const auto* data = buffer.data();
+
+    pool.put(std::move(buffer));
+    REQUIRE_FALSE(buffer);
+    REQUIRE(pool.size() == 1);
+
+    SECTION("Reused if large enough") {
+        auto new_buffer = pool.get(2048, osmium::memory::Buffer::auto_grow::yes);
+        REQUIRE(pool.size() == 0);
+        REQUIRE(new_buffer.data() == data);
+        REQUIRE(new_buffer.capacity() == 4096);
+        REQUIRE(new_buffer.committed() == 0);
+        REQUIRE(new_buffer.written() == 0);
+
+        // recycled buffer has the requested auto_grow mode
+        new_buffer.reserve_space(8192);
+        REQUIRE(new_buffer.capacity() >= 8192);
+    }
+
+    SECTION("Not reused if too small") {
+        const auto new_buffer = pool.get(8192);
+        REQUIRE(pool.size() == 1);
+        REQUIRE(new_buffer.data() != data);
+        REQUIRE(new_buffer.capacity() == 8192);
+    }
+
+    SECTION("Clear pool") {
+        pool.clear();
+        REQUIRE(pool.size() == 0);
+        REQUIRE(pool.used_memory() == 0);
+    }
+}
+
+TEST_CASE("Buffer pool reports memory in pool") {
+    osmium::memory::BufferPool pool;
+    REQUIRE(pool.used_memory() == 0);
+
+    pool.put(osmium::memory::Buffer{1024});
+    pool.put(osmium::memory::Buffer{4096});
+    REQUIRE(pool.used_memory() == 1024 + 4096);
+
+    const auto buffer = pool.get(2048);
+    REQUIRE(pool.used_memory() == 1024);
+}
+
+TEST_CASE("Buffer pool takes memory of nested buffers") {
+    osmium::memory::BufferPool pool;
+
+    osmium::memory::Buffer buffer{64, osmium::memory::Buffer::auto_grow::internal};
+    for (int i = 1; i <= 3; ++i) {
+        osmium::builder::add_node(buffer, osmium::builder::attr::_id(i));
+    }
+    REQUIRE(buffer.has_nested_buffers());
+
+    pool.put(std::move(buffer));
+    REQUIRE(pool.size() >= 2);
+}
+
+TEST_CASE("Buffer pool has maximum size") {
+    osmium::memory::BufferPool pool{2};
+
+    for (int i = 0; i < 5; ++i) {
+        pool.put(osmium::memory::Buffer{1024});
+    }
+    REQUIRE(pool.size() == 2);
+}
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/shared_buffer_ring.hpp>
+#include <osmium/osm/node.hpp>
+
+#include <stdexcept>
+
+#ifndef _WIN32
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+using ring_type = osmium::memory::SharedBufferRing;
+
+TEST_CASE("Shared buffer ring with invalid parameters") {
+    const int fd = osmium::detail::create_tmp_file();
+    REQUIRE_THROWS_AS(ring_type(fd, 0, 1024), const std::invalid_argument&);
+    REQUIRE_THROWS_AS(ring_type(fd, 4, 1001), const std::invalid_argument&);
+    osmium::io::detail::reliable_close(fd);
+}
+
+TEST_CASE("Open shared buffer ring from invalid file") {
+    const int fd = osmium::detail::create_tmp_file();
+    REQUIRE_THROWS_AS(ring_type{fd}, const std::runtime_error&);
+    osmium::io::detail::reliable_close(fd);
+}
+
+TEST_CASE("Hand buffers through shared buffer ring") {
+    const int fd = osmium::detail::create_tmp_file();
+    ring_type producer{fd, 2, 1024};
+    ring_type consumer{fd};
+
+    REQUIRE(consumer.num_slots() == 2);
+    REQUIRE(consumer.slot_size() == 1024);
+
+    for (int i = 1; i <= 2; ++i) {
+        const auto slot = producer.acquire_for_writing();
+        auto buffer = producer.write_buffer(slot);
+        REQUIRE_FALSE(buffer.has_nested_buffers());
+        osmium::builder::add_node(buffer, osmium::builder::attr::_id(i));
+        osmium::builder::add_node(buffer, osmium::builder::attr::_id(i + 10));
+        producer.publish(slot, buffer);
+    }
+    producer.close();
+
+    int count = 0;
+    osmium::object_id_type sum = 0;
+    std::size_t slot = 0;
+    while ((slot = consumer.acquire_for_reading()) != ring_type::npos) {
+        const auto buffer = consumer.read_buffer(slot);
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            ++count;
+            sum += node.id();
+        }
+        consumer.release(slot);
+    }
+    REQUIRE(count == 4);
+    REQUIRE(sum == 1 + 11 + 2 + 12);
+
+    osmium::io::detail::reliable_close(fd);
+}
+
+TEST_CASE("Shared buffer ring slots can not grow") {
+    const int fd = osmium::detail::create_tmp_file();
+    ring_type ring{fd, 1, 64};
+
+    const auto slot = ring.acquire_for_writing();
+    auto buffer = ring.write_buffer(slot);
+    REQUIRE_THROWS_AS(buffer.reserve_space(128), const osmium::buffer_is_full&);
+
+    osmium::io::detail::reliable_close(fd);
+}
+
+#ifndef _WIN32
+TEST_CASE("Hand buffers to other process through shared buffer ring") {
+    const int fd = osmium::detail::create_tmp_file();
+    ring_type ring{fd, 2, 256};
+
+    const pid_t pid = ::fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        ring_type child_ring{fd};
+        osmium::object_id_type sum = 0;
+        std::size_t slot = 0;
+        while ((slot = child_ring.acquire_for_reading()) != ring_type::npos) {
+            for (const auto& node : child_ring.read_buffer(slot).select<osmium::Node>()) {
+                sum += node.id();
+            }
+            child_ring.release(slot);
+        }
+        ::_exit(sum == 5050 ? 0 : 1);
+    }
+
+    for (int i = 1; i <= 100; ++i) {
+        const auto slot = ring.acquire_for_writing();
+        auto buffer = ring.write_buffer(slot);
+        osmium::builder::add_node(buffer, osmium::builder::attr::_id(i));
+        ring.publish(slot, buffer);
+    }
+    ring.close();
+
+    int status = 0;
+    REQUIRE(::waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+
+    osmium::io::detail::reliable_close(fd);
+}
+#endif
@@ -0,0 +1,123 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/type_index.hpp>
+#include <osmium/osm.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer mixed_buffer() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 10; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _location(id, id));
+        if (id % 2 == 0) {
+            osmium::builder::add_way(buffer, _id(id), _nodes({id - 1, id}));
+        }
+        if (id % 5 == 0) {
+            osmium::builder::add_relation(buffer, _id(id), _member(osmium::item_type::way, id, ""));
+        }
+    }
+    return buffer;
+}
+
+TEST_CASE("Empty type index") {
+    const osmium::memory::TypeIndex index;
+    REQUIRE(index.count(osmium::item_type::node) == 0);
+    REQUIRE(index.offsets(osmium::osm_entity_bits::all).empty());
+
+    osmium::memory::Buffer buffer{1024};
+    REQUIRE_FALSE(index.valid_for(buffer));
+}
+
+TEST_CASE("Type index on mixed buffer") {
+    auto buffer = mixed_buffer();
+    const osmium::memory::TypeIndex index{buffer};
+
+    REQUIRE(index.valid_for(buffer));
+    REQUIRE(index.count(osmium::item_type::node) == 10);
+    REQUIRE(index.count(osmium::item_type::way) == 5);
+    REQUIRE(index.count(osmium::item_type::relation) == 2);
+    REQUIRE(index.count(osmium::item_type::area) == 0);
+    REQUIRE(index.count(osmium::item_type::changeset) == 0);
+    REQUIRE(index.used_memory() > 17 * sizeof(std::size_t));
+
+    SECTION("select gives the same objects as buffer select") {
+        std::vector<const osmium::Way*> expected;
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            expected.push_back(&way);
+        }
+
+        std::vector<const osmium::Way*> ways;
+        for (const auto& way : index.select<osmium::Way>(buffer)) {
+            ways.push_back(&way);
+        }
+        REQUIRE(ways == expected);
+
+        const auto range = index.select<osmium::Relation>(buffer);
+        REQUIRE(range.size() == 2);
+        REQUIRE(range.begin()->id() == 5);
+        REQUIRE((range.begin() + 1)->id() == 10);
+    }
+
+    SECTION("select gives random access iterators") {
+        const auto range = index.select<osmium::Node>(buffer);
+        auto it = range.end();
+        --it;
+        REQUIRE(it->id() == 10);
+        it -= 2;
+        REQUIRE(it->id() == 8);
+        REQUIRE((it - 1)->id() == 7);
+        REQUIRE((2 + it)->id() == 10);
+        REQUIRE(range.begin()[3].id() == 4);
+        REQUIRE(it - range.begin() == 7);
+        REQUIRE(range.begin() < it);
+        REQUIRE(it > range.begin());
+        REQUIRE(it <= it);
+        REQUIRE(range.end() >= it);
+        REQUIRE(std::distance(range.begin(), range.end()) == 10);
+
+        const auto found = std::lower_bound(range.begin(), range.end(), 6, [](const osmium::Node& node, osmium::object_id_type id) {
+            return node.id() < id;
+        });
+        REQUIRE(found->id() == 6);
+    }
+
+    SECTION("select on const buffer") {
+        const auto& cbuffer = buffer;
+        osmium::object_id_type id = 1;
+        for (const auto& node : index.select<osmium::Node>(cbuffer)) {
+            REQUIRE(node.id() == id);
+            REQUIRE(node.location().lon() == Approx(static_cast<double>(id)));
+            ++id;
+        }
+        REQUIRE(id == 11);
+    }
+
+    SECTION("offsets of several types are in buffer order") {
+        const auto offsets = index.offsets(osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation);
+        REQUIRE(offsets.size() == 7);
+
+        std::vector<std::size_t> expected;
+        for (auto it = buffer.select<osmium::OSMObject>().cbegin(); it != buffer.select<osmium::OSMObject>().cend(); ++it) {
+            if (it->type() != osmium::item_type::node) {
+                expected.push_back(static_cast<std::size_t>(it.data() - buffer.data()));
+            }
+        }
+        REQUIRE(offsets == expected);
+    }
+
+    SECTION("index is invalid after buffer changed") {
+        osmium::builder::add_node(buffer, _id(11));
+        REQUIRE_FALSE(index.valid_for(buffer));
+
+        osmium::memory::TypeIndex new_index;
+        new_index.build(buffer);
+        REQUIRE(new_index.valid_for(buffer));
+        REQUIRE(new_index.count(osmium::item_type::node) == 11);
+    }
+}
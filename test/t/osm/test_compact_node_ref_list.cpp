@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/compact_node_ref_list.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Empty compact node ref list") {
+    const osmium::CompactNodeRefList empty;
+    REQUIRE(empty.empty());
+    REQUIRE(empty.size() == 0);
+    REQUIRE(empty.begin() == empty.end());
+
+    osmium::memory::Buffer buffer{1024};
+    const auto pos = osmium::builder::add_way(buffer, _id(1));
+    std::vector<unsigned char> data;
+    osmium::encode_node_refs(buffer.get<osmium::Way>(pos).nodes(), data);
+    REQUIRE(data.size() == 1);
+
+    const osmium::CompactNodeRefList nodes{data.data()};
+    REQUIRE(nodes.empty());
+    REQUIRE(nodes.begin() == nodes.end());
+}
+
+TEST_CASE("Compact node ref list round trip") {
+    osmium::memory::Buffer buffer{1024};
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes({
+        {1, {1.0, 2.0}},
+        {2, {1.0000001, 2.0000002}},
+        {-5, osmium::Location{}},
+        {std::numeric_limits<int32_t>::max() + 10LL, {-179.9999999, -89.9999999}},
+        {3, {179.9999999, 89.9999999}},
+        {1, {1.0, 2.0}}
+    }));
+    const auto& nodes = buffer.get<osmium::Way>(pos).nodes();
+
+    std::vector<unsigned char> data{0xffU}; // other data before
+    osmium::encode_node_refs(nodes, data);
+    REQUIRE(data.size() < 1 + nodes.size() * sizeof(osmium::NodeRef));
+
+    const osmium::CompactNodeRefList compact{data.data() + 1};
+    REQUIRE(compact.size() == 6);
+    REQUIRE_FALSE(compact.empty());
+    REQUIRE(std::distance(compact.begin(), compact.end()) == 6);
+    REQUIRE(compact.front().ref() == 1);
+    REQUIRE(compact.back().ref() == 1);
+    REQUIRE(compact.is_closed());
+
+    auto it = nodes.begin();
+    for (const auto& nr : compact) {
+        REQUIRE(nr.ref() == it->ref());
+        REQUIRE(nr.location() == it->location());
+        ++it;
+    }
+    REQUIRE(it == nodes.end());
+
+    auto cit = compact.cbegin();
+    REQUIRE(cit->ref() == 1);
+    REQUIRE((cit++)->ref() == 1);
+    REQUIRE(cit->ref() == 2);
+    REQUIRE((*++cit).location().is_undefined());
+}
+
+TEST_CASE("Compact node ref list uses few bytes per node") {
+    osmium::memory::Buffer buffer{10240};
+    {
+        osmium::builder::WayBuilder builder{buffer};
+        osmium::builder::WayNodeListBuilder wnl_builder{builder};
+        for (int i = 0; i < 100; ++i) {
+            wnl_builder.add_node_ref(1000000000 + i, osmium::Location{120000000 + i * 37, 500000000 - i * 23});
+        }
+    }
+    const auto& nodes = buffer.get<osmium::Way>(buffer.commit()).nodes();
+
+    std::vector<unsigned char> data;
+    osmium::encode_node_refs(nodes, data);
+    REQUIRE(data.size() < 16 + 100 * 3);
+
+    const osmium::CompactNodeRefList compact{data.data()};
+    REQUIRE(std::equal(compact.begin(), compact.end(), nodes.begin()));
+    REQUIRE_FALSE(compact.is_closed());
+}
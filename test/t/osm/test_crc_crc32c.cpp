@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/crc.hpp>
+#include <osmium/osm/crc_crc32c.hpp>
+#include <osmium/osm/node.hpp>
+
+#include <cstddef>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("CRC32C of empty data") {
+    const osmium::CRC_crc32c crc;
+    REQUIRE(crc.checksum() == 0);
+    REQUIRE(crc.length() == 0);
+}
+
+TEST_CASE("CRC32C check value") {
+    const std::string data{"123456789"};
+
+    SECTION("process_bytes") {
+        osmium::CRC_crc32c crc;
+        crc.process_bytes(data.data(), data.size());
+        REQUIRE(crc.checksum() == 0xe3069283U);
+        REQUIRE(crc.length() == 9);
+    }
+
+    SECTION("process_byte") {
+        osmium::CRC_crc32c crc;
+        for (const char c : data) {
+            crc.process_byte(static_cast<unsigned char>(c));
+        }
+        REQUIRE(crc.checksum() == 0xe3069283U);
+        REQUIRE(crc.length() == 9);
+    }
+}
+
+TEST_CASE("CRC32C of longer data is independent of chunking") {
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data += std::to_string(i * 7919);
+    }
+
+    osmium::CRC_crc32c all;
+    all.process_bytes(data.data(), data.size());
+
+    osmium::CRC_crc32c chunked;
+    for (std::size_t pos = 0; pos < data.size(); pos += 13) {
+        chunked.process_bytes(data.data() + pos, std::min<std::size_t>(13, data.size() - pos));
+    }
+
+    REQUIRE(all.checksum() == chunked.checksum());
+}
+
+TEST_CASE("CRC32C checksums can be combined") {
+    std::string data;
+    for (int i = 0; i < 300; ++i) {
+        data += std::to_string(i);
+    }
+
+    osmium::CRC_crc32c all;
+    all.process_bytes(data.data(), data.size());
+
+    for (const std::size_t split : {std::size_t{0}, std::size_t{1}, std::size_t{8}, std::size_t{100}, data.size()}) {
+        osmium::CRC_crc32c first;
+        first.process_bytes(data.data(), split);
+        osmium::CRC_crc32c second;
+        second.process_bytes(data.data() + split, data.size() - split);
+        first.combine(second);
+        REQUIRE(first.checksum() == all.checksum());
+        REQUIRE(first.length() == data.size());
+    }
+}
+
+TEST_CASE("CRC32C of node") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(17), _version(2), _location(1.2, 3.4), _tag("highway", "bus_stop"));
+    const auto& node = buffer.get<osmium::Node>(0);
+
+    osmium::CRC<osmium::CRC_crc32c> crc1;
+    crc1.update(node);
+    osmium::CRC<osmium::CRC_crc32c> crc2;
+    crc2.update(node);
+
+    REQUIRE(crc1().checksum() != 0);
+    REQUIRE(crc1().checksum() == crc2().checksum());
+}
@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/envelope.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    osmium::Box extend_one_by_one(const std::vector<osmium::Location>& locations) {
+        osmium::Box box;
+        for (const auto& location : locations) {
+            box.extend(location);
+        }
+        return box;
+    }
+
+    std::vector<osmium::NodeRef> to_node_refs(const std::vector<osmium::Location>& locations) {
+        std::vector<osmium::NodeRef> node_refs;
+        osmium::object_id_type id = 0;
+        for (const auto& location : locations) {
+            node_refs.emplace_back(++id, location);
+        }
+        return node_refs;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Envelope of empty range is undefined") {
+    const std::vector<osmium::Location> locations;
+    REQUIRE_FALSE(osmium::envelope(locations.data(), locations.data()));
+}
+
+TEST_CASE("Envelope of one location") {
+    const std::vector<osmium::Location> locations{osmium::Location{1.5, 2.5}};
+    const auto box = osmium::envelope(locations.data(), locations.data() + locations.size());
+    REQUIRE(box.bottom_left() == osmium::Location(1.5, 2.5));
+    REQUIRE(box.top_right() == osmium::Location(1.5, 2.5));
+}
+
+TEST_CASE("Envelope ignores invalid locations") {
+    const std::vector<osmium::Location> locations{
+        osmium::Location{},
+        osmium::Location{3.0, 4.0},
+        osmium::Location{200.0, 1.0},
+        osmium::Location{1.0, -95.0},
+        osmium::Location{-1.0, -2.0},
+        osmium::Location{}
+    };
+    const auto box = osmium::envelope(locations.data(), locations.data() + locations.size());
+    REQUIRE(box.bottom_left() == osmium::Location(-1.0, -2.0));
+    REQUIRE(box.top_right() == osmium::Location(3.0, 4.0));
+    REQUIRE(box == extend_one_by_one(locations));
+
+    const std::vector<osmium::Location> invalid{osmium::Location{}, osmium::Location{181.0, 0.0}, osmium::Location{}};
+    REQUIRE_FALSE(osmium::envelope(invalid.data(), invalid.data() + invalid.size()));
+}
+
+TEST_CASE("Envelope at the bounds of the coordinate range") {
+    const std::vector<osmium::Location> locations{osmium::Location{-180.0, 90.0}, osmium::Location{180.0, -90.0}};
+    const auto box = osmium::envelope(locations.data(), locations.data() + locations.size());
+    REQUIRE(box.bottom_left() == osmium::Location(-180.0, -90.0));
+    REQUIRE(box.top_right() == osmium::Location(180.0, 90.0));
+}
+
+TEST_CASE("Envelope is the same as extending box one location at a time") {
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<int32_t> x_dist{-1900000000, 1900000000};
+    std::uniform_int_distribution<int32_t> y_dist{-1000000000, 1000000000};
+
+    for (std::size_t size = 0; size < 40; ++size) {
+        std::vector<osmium::Location> locations;
+        for (std::size_t i = 0; i < size; ++i) {
+            if (i % 7 == 3) {
+                locations.emplace_back();
+            } else {
+                locations.emplace_back(x_dist(gen), y_dist(gen));
+            }
+        }
+        const auto expected = extend_one_by_one(locations);
+        REQUIRE(osmium::envelope(locations.data(), locations.data() + locations.size()) == expected);
+
+        const auto node_refs = to_node_refs(locations);
+        REQUIRE(osmium::envelope(node_refs.data(), node_refs.data() + node_refs.size()) == expected);
+    }
+}
+
+TEST_CASE("Envelope of way") {
+    osmium::memory::Buffer buffer{1024};
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes({
+        osmium::NodeRef{1, osmium::Location{1.0, 5.0}},
+        osmium::NodeRef{2, osmium::Location{}},
+        osmium::NodeRef{3, osmium::Location{-2.0, 3.0}},
+        osmium::NodeRef{4, osmium::Location{4.0, -1.0}},
+        osmium::NodeRef{5, osmium::Location{2.0, 2.0}}
+    }));
+    const auto& way = buffer.get<osmium::Way>(pos);
+    const auto box = way.envelope();
+    REQUIRE(box.bottom_left() == osmium::Location(-2.0, -1.0));
+    REQUIRE(box.top_right() == osmium::Location(4.0, 5.0));
+}
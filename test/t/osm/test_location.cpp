@@ -430,3 +430,38 @@ TEST_CASE("set lon/lat from string with trailing characters using partial") {
     REQUIRE(*y == ' ');
 }
 
+
+TEST_CASE("Fast and general coordinate parsers give the same results") {
+    const char* const test_cases[] = {
+        "0.0", "-0.0", "1.5", "-1.5", "180.0", "-180.0", "90.1234567", "-90.1234567",
+        "12.3456789", "1.0000001", "0.0000001", "-0.0000001", "214.7483647", "214.7483648",
+        "999.9999999", "123.4", "7.25", "1234.5", "5.", ".5", "5", "-17.0000000"
+    };
+
+    for (const char* tc : test_cases) {
+        const std::string with_exponent = std::string{tc} + "e0";
+
+        const char* fast = tc;
+        const char* general = with_exponent.c_str();
+        int32_t fast_value = 0;
+        int32_t general_value = 0;
+        bool fast_ok = true;
+        bool general_ok = true;
+        try {
+            fast_value = osmium::detail::string_to_location_coordinate(&fast);
+        } catch (const osmium::invalid_location&) {
+            fast_ok = false;
+        }
+        try {
+            general_value = osmium::detail::string_to_location_coordinate(&general);
+        } catch (const osmium::invalid_location&) {
+            general_ok = false;
+        }
+
+        REQUIRE(fast_ok == general_ok);
+        if (fast_ok) {
+            REQUIRE(fast_value == general_value);
+            REQUIRE(fast == tc + std::strlen(tc));
+        }
+    }
+}
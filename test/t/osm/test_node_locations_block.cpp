@@ -0,0 +1,46 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_locations_block.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Default constructed NodeLocationsBlock is empty") {
+    const osmium::NodeLocationsBlock block;
+    REQUIRE(block.empty());
+    REQUIRE(block.size() == 0);
+    REQUIRE(block.tagged_nodes().committed() == 0);
+}
+
+TEST_CASE("NodeLocationsBlock from buffer") {
+    osmium::memory::Buffer buffer{1024 * 10};
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 2.0));
+    osmium::builder::add_node(buffer, _id(2), _location(3.0, 4.0), _tag("amenity", "bench"));
+    osmium::builder::add_way(buffer, _id(10), _nodes({1, 2}));
+    osmium::builder::add_node(buffer, _id(3));
+
+    osmium::NodeLocationsBlock block{buffer};
+    REQUIRE(block.size() == 3);
+    REQUIRE(block.ids() == (std::vector<osmium::object_id_type>{1, 2, 3}));
+    REQUIRE(block.locations()[0] == osmium::Location(1.0, 2.0));
+    REQUIRE(block.locations()[1] == osmium::Location(3.0, 4.0));
+    REQUIRE_FALSE(block.locations()[2].valid());
+
+    const auto nodes = block.tagged_nodes().select<osmium::Node>();
+    REQUIRE(nodes.size() == 1);
+    REQUIRE(nodes.begin()->id() == 2);
+    REQUIRE(std::string{nodes.begin()->tags().get_value_by_key("amenity")} == "bench");
+
+    block.add_location(4, osmium::Location{5.0, 6.0});
+    REQUIRE(block.size() == 4);
+
+    block.clear();
+    REQUIRE(block.empty());
+    REQUIRE(block.tagged_nodes().committed() == 0);
+}
@@ -2,6 +2,9 @@
 
 #include <osmium/osm/timestamp.hpp>
 
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -126,6 +129,31 @@ TEST_CASE("Valid timestamps") {
     }
 }
 
+TEST_CASE("Timestamps written to string match gmtime") {
+    // Step through the whole range of timestamps (with a prime number of
+    // seconds so that all times of day are hit) and the special values.
+    std::vector<uint64_t> values = {0, 1, 951782399, 951782400, 951868800, 4102444799, 4102444800, 4294967295};
+    for (uint64_t value = 0; value <= 0xffffffffULL; value += 86399 * 7) {
+        values.push_back(value);
+    }
+
+    for (const auto value : values) {
+        const auto sse = static_cast<time_t>(value);
+        std::tm tm; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+#ifndef _WIN32
+        gmtime_r(&sse, &tm);
+#else
+        gmtime_s(&tm, &sse);
+#endif
+        char ref[21];
+        std::strftime(ref, sizeof(ref), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+        std::string s;
+        osmium::detail::add_iso_timestamp_to_string(static_cast<uint32_t>(value), s);
+        REQUIRE(s == ref);
+    }
+}
+
 TEST_CASE("Invalid timestamps") {
     REQUIRE_THROWS_AS(osmium::Timestamp{""}, const std::invalid_argument&);
     REQUIRE_THROWS_AS(osmium::Timestamp{"x"}, const std::invalid_argument&);
@@ -151,3 +179,33 @@ TEST_CASE("Invalid timestamps") {
     REQUIRE_THROWS_AS(osmium::Timestamp{"2000-03-32T00:00:00Z"}, const std::invalid_argument&);
 }
 
+
+TEST_CASE("Parsed timestamps match timegm") {
+    for (int year = 1900; year <= 2105; year += 7) {
+        for (int month = 1; month <= 12; ++month) {
+            for (int day = 1; day <= 28; day += 3) {
+                char str[21];
+                std::snprintf(str, sizeof(str), "%04d-%02d-%02dT%02d:%02d:%02dZ", year, month, day, day % 24, (day * 7) % 60, (day * 11) % 61);
+
+                std::tm tm{}; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                tm.tm_year = year - 1900;
+                tm.tm_mon = month - 1;
+                tm.tm_mday = day;
+                tm.tm_hour = day % 24;
+                tm.tm_min = (day * 7) % 60;
+                tm.tm_sec = (day * 11) % 61;
+#ifndef _WIN32
+                const time_t expected = timegm(&tm);
+#else
+                const time_t expected = _mkgmtime(&tm);
+#endif
+
+                REQUIRE(osmium::detail::parse_timestamp(str) == expected);
+            }
+        }
+    }
+
+    // Leap day in a non-leap year continues into March like timegm() does
+    REQUIRE(osmium::detail::parse_timestamp("2001-02-29T00:00:00Z") == osmium::detail::parse_timestamp("2001-03-01T00:00:00Z"));
+    REQUIRE(osmium::Timestamp{"2016-12-31T23:59:60Z"}.to_iso() == "2017-01-01T00:00:00Z");
+}
@@ -6,6 +6,9 @@
 #include <osmium/relations/relations_database.hpp>
 #include <osmium/storage/item_stash.hpp>
 
+#include <string>
+#include <vector>
+
 osmium::memory::Buffer fill_buffer() {
     using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
     osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
@@ -192,3 +195,108 @@ TEST_CASE("Remove non-existing object from members database doesn't do anything"
     REQUIRE(mdb.size() == 6);
 }
 
+
+TEST_CASE("Member database lookups with and without prefilter") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    std::vector<member_type> members;
+    for (osmium::object_id_type id = 2; id <= 2000; id += 2) {
+        members.emplace_back(osmium::item_type::way, id);
+    }
+    osmium::builder::add_relation(buffer, _id(1), _members(members));
+
+    const bool use_prefilter = true;
+    for (const bool prefilter : {use_prefilter, !use_prefilter}) {
+        osmium::ItemStash stash;
+        osmium::relations::RelationsDatabase rdb{stash};
+        osmium::relations::MembersDatabase<osmium::Way> mdb{stash, rdb};
+        mdb.use_prefilter(prefilter);
+
+        auto handle = rdb.add(buffer.get<osmium::Relation>(0));
+        std::size_t n = 0;
+        for (const auto& member : handle->members()) {
+            mdb.track(handle, member.ref(), n++);
+        }
+        mdb.prepare_for_lookup();
+
+        if (prefilter) {
+            REQUIRE(mdb.used_memory() >= 1000 * 2);
+        }
+
+        for (osmium::object_id_type id = -10; id <= 4000; ++id) {
+            std::size_t pos = 0;
+            const bool expected = id > 0 && id <= 2000 && id % 2 == 0;
+            REQUIRE(mdb.find_position(id, pos) == expected);
+            if (expected) {
+                REQUIRE(pos == static_cast<std::size_t>(id / 2 - 1));
+            }
+            REQUIRE(mdb.get(id) == nullptr);
+        }
+    }
+}
+
+TEST_CASE("Member database with tag interning") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_relation(buffer,
+        _id(20),
+        _member(osmium::item_type::way, 10, "outer"),
+        _member(osmium::item_type::way, 11, "inner"),
+        _tag("type", "multipolygon")
+    );
+    osmium::builder::add_way(buffer, _id(10), _tag("building", "yes"));
+    osmium::builder::add_way(buffer, _id(11), _tag("building", "yes"));
+
+    osmium::ItemStash stash;
+    osmium::relations::RelationsDatabase rdb{stash};
+    osmium::relations::MembersDatabase<osmium::Way> mdb{stash, rdb};
+    mdb.intern_tags();
+
+    auto handle = rdb.add(buffer.get<osmium::Relation>(0));
+    int n = 0;
+    for (const auto& member : handle->members()) {
+        mdb.track(handle, member.ref(), n++);
+    }
+    mdb.prepare_for_lookup();
+
+    int complete = 0;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        mdb.add(way, [&](osmium::relations::RelationHandle& rel_handle) {
+            ++complete;
+            REQUIRE(std::string{rel_handle->tags().get_value_by_key("type")} == "multipolygon");
+        });
+    }
+    REQUIRE(complete == 1);
+    REQUIRE(stash.count_interned_tags() == 1);
+
+    REQUIRE(mdb.get(10)->tags().empty());
+    REQUIRE(mdb.get_tags(10) == mdb.get_tags(11));
+    REQUIRE(std::string{mdb.get_tags(11)->get_value_by_key("building")} == "yes");
+    REQUIRE(mdb.get_tags(12) == nullptr);
+}
+
+TEST_CASE("Id filter has no false negatives and few false positives") {
+    osmium::relations::detail::IdFilter filter;
+    REQUIRE(filter.empty());
+    REQUIRE(filter.maybe_contains(17));
+
+    filter.reset(10000);
+    for (osmium::object_id_type id = 0; id < 10000; ++id) {
+        filter.add(id * 7);
+    }
+
+    std::size_t false_positives = 0;
+    for (osmium::object_id_type id = 0; id < 70000; ++id) {
+        if (id % 7 == 0) {
+            REQUIRE(filter.maybe_contains(id));
+        } else if (filter.maybe_contains(id)) {
+            ++false_positives;
+        }
+    }
+    REQUIRE(false_positives < 60000 / 20);
+
+    filter.clear();
+    REQUIRE(filter.empty());
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/relations/manager_util.hpp>
+#include <osmium/relations/pbf_blob_index_reader.hpp>
+#include <osmium/relations/relations_manager.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    struct CompleteRM : public osmium::relations::RelationsManager<CompleteRM, true, true, true> {
+
+        std::size_t count_complete_rels = 0;
+        std::size_t count_members = 0;
+
+        void complete_relation(const osmium::Relation& relation) noexcept {
+            ++count_complete_rels;
+            count_members += relation.members().size();
+        }
+
+    }; // struct CompleteRM
+
+    // Write a PBF file with three node blobs, one way blob and one
+    // relation blob.
+    void write_test_file(const std::string& filename) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+        for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, id * 0.0001));
+        }
+        for (osmium::object_id_type id = 1; id <= 100; ++id) {
+            osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({id, id + 1}));
+        }
+        osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 10));
+        osmium::builder::add_relation(buffer, _id(2), _version(1), _member(osmium::item_type::way, 20), _member(osmium::item_type::node, 19999));
+        osmium::builder::add_relation(buffer, _id(3), _version(1), _member(osmium::item_type::relation, 1), _member(osmium::item_type::node, 19998));
+
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Read relations and members using PBF blob index") {
+    const std::string filename{"test_pbf_blob_index_reader.osm.pbf"};
+    write_test_file(filename);
+
+    const auto index = osmium::io::PBFBlobIndex::build(filename);
+    REQUIRE(index.size() == 5);
+
+    CompleteRM manager;
+    const auto stats = osmium::relations::read_with_blob_index(filename, index, manager);
+
+    REQUIRE(stats.blobs_total == 5);
+    REQUIRE(stats.relation_blobs == 1);
+    // last node blob, way blob, and relation blob
+    REQUIRE(stats.member_blobs == 3);
+
+    REQUIRE(manager.count_complete_rels == 3);
+    REQUIRE(manager.count_members == 5);
+
+    SECTION("same result as reading the file twice") {
+        CompleteRM manager2;
+        osmium::relations::read_relations(osmium::io::File{filename}, manager2);
+        osmium::io::Reader reader{filename};
+        osmium::apply(reader, manager2.handler());
+        reader.close();
+
+        REQUIRE(manager2.count_complete_rels == manager.count_complete_rels);
+        REQUIRE(manager2.count_members == manager.count_members);
+    }
+}
+
+TEST_CASE("Read using PBF blob index not matching the file") {
+    const std::string filename{"test_pbf_blob_index_reader_nomatch.osm.pbf"};
+    write_test_file(filename);
+
+    std::vector<osmium::io::pbf_blob_index_entry> entries(1);
+    entries[0].offset = 1000000000;
+    entries[0].size = 100;
+    entries[0].types = osmium::osm_entity_bits::relation;
+    const osmium::io::PBFBlobIndex index{std::move(entries)};
+
+    CompleteRM manager;
+    REQUIRE_THROWS_AS(osmium::relations::read_with_blob_index(filename, index, manager), const osmium::pbf_error&);
+}
@@ -2,11 +2,17 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
 #include <osmium/io/xml_input.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/relations/relations_manager.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
 
+#include <cstring>
 #include <iterator>
+#include <string>
+#include <vector>
 
 struct EmptyRM : public osmium::relations::RelationsManager<EmptyRM, true, true, true> {
 };
@@ -108,6 +114,97 @@ struct AnyRM : public osmium::relations::RelationsManager<AnyRM, true, true, tru
     }
 };
 
+struct NestedRM : public osmium::relations::RelationsManager<NestedRM, false, true, true> {
+
+    std::vector<osmium::object_id_type> complete;
+    std::vector<osmium::object_id_type> cycles;
+    std::size_t resolved_ways = 0;
+
+    static bool new_relation(const osmium::Relation& relation) noexcept {
+        const char* type = relation.tags()["type"];
+        return type && !std::strcmp(type, "super");
+    }
+
+    void count_ways(const osmium::Relation& relation) {
+        for (const auto& member : relation.members()) {
+            if (member.ref() == 0) {
+                continue;
+            }
+            if (member.type() == osmium::item_type::way) {
+                REQUIRE(get_member_way(member.ref()));
+                ++resolved_ways;
+            } else if (member.type() == osmium::item_type::relation) {
+                const auto* child = get_member_relation(member.ref());
+                REQUIRE(child);
+                count_ways(*child);
+            }
+        }
+    }
+
+    void complete_relation(const osmium::Relation& relation) {
+        complete.push_back(relation.id());
+        count_ways(relation);
+    }
+
+    void nested_relation_cycle(const osmium::Relation& relation, const osmium::RelationMember& member) {
+        cycles.push_back(relation.id());
+        REQUIRE(member.ref() == 4);
+    }
+
+};
+
+TEST_CASE("Relations manager resolving nested relations") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024 * 10, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_way(buffer, _id(10));
+    osmium::builder::add_way(buffer, _id(11));
+    osmium::builder::add_way(buffer, _id(12));
+
+    // routes and a route master
+    osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::way, 10), _member(osmium::item_type::way, 11));
+    osmium::builder::add_relation(buffer, _id(2), _member(osmium::item_type::way, 12));
+    osmium::builder::add_relation(buffer, _id(3), _tag("type", "super"), _member(osmium::item_type::relation, 1), _member(osmium::item_type::relation, 2));
+
+    // relations 4 and 5 are members of each other
+    osmium::builder::add_relation(buffer, _id(4), _tag("type", "super"), _member(osmium::item_type::relation, 5));
+    osmium::builder::add_relation(buffer, _id(5), _member(osmium::item_type::relation, 4), _member(osmium::item_type::way, 10));
+
+    // relation 99 is missing
+    osmium::builder::add_relation(buffer, _id(6), _tag("type", "super"), _member(osmium::item_type::relation, 99));
+
+    // relation 8 has no members we are interested in
+    osmium::builder::add_relation(buffer, _id(7), _tag("type", "super"), _member(osmium::item_type::relation, 8));
+    osmium::builder::add_relation(buffer, _id(8), _member(osmium::item_type::node, 1));
+
+    NestedRM manager;
+    manager.resolve_nested_relations();
+
+    for (const auto& relation : buffer.select<osmium::Relation>()) {
+        manager.relation(relation);
+    }
+    manager.prepare_for_lookup();
+
+    REQUIRE(manager.cycles == std::vector<osmium::object_id_type>{5});
+    REQUIRE(manager.complete == std::vector<osmium::object_id_type>{7});
+
+    osmium::apply(buffer, manager.handler());
+
+    REQUIRE(manager.complete == (std::vector<osmium::object_id_type>{7, 4, 3}));
+    REQUIRE(manager.resolved_ways == 4);
+
+    std::vector<osmium::object_id_type> incomplete;
+    manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
+        incomplete.push_back(handle->id());
+    });
+    REQUIRE(incomplete == std::vector<osmium::object_id_type>{6});
+
+    // all members except those of the incomplete relation are released
+    REQUIRE(manager.member_ways_database().count().tracked == 0);
+    REQUIRE(manager.member_ways_database().count().available == 0);
+    REQUIRE(manager.member_relations_database().count().tracked == 1);
+}
+
 TEST_CASE("Use RelationsManager without any overloaded functions in derived class") {
     osmium::io::File file{with_data_dir("t/relations/data.osm")};
 
@@ -175,6 +272,33 @@ TEST_CASE("Relations manager derived class") {
     REQUIRE(n == 1);
 }
 
+TEST_CASE("Relations manager with parallel member lookup") {
+    osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    TestRM manager;
+
+    osmium::relations::read_relations(file, manager);
+
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{file};
+    manager.read_members_parallel(reader, pool, 1);
+    reader.close();
+
+    REQUIRE(manager.count_new_rels      ==  3);
+    REQUIRE(manager.count_new_members   ==  5);
+    REQUIRE(manager.count_complete_rels ==  2);
+    REQUIRE(manager.count_before        == 10);
+    REQUIRE(manager.count_not_in_any    ==  6);
+    REQUIRE(manager.count_after         == 10);
+
+    int n = 0;
+    manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
+        ++n;
+        REQUIRE(handle->id() == 31);
+    });
+    REQUIRE(n == 1);
+}
+
 TEST_CASE("Relations manager with callback") {
     osmium::io::File file{with_data_dir("t/relations/data.osm")};
 
@@ -232,6 +356,42 @@ TEST_CASE("Access members via RelationsManager") {
     REQUIRE(nullptr == manager.get_member_relation(17));
 }
 
+struct TagsRM : public osmium::relations::RelationsManager<TagsRM, false, true, false> {
+
+    std::vector<std::string> member_tags;
+
+    void complete_relation(const osmium::Relation& relation) {
+        for (const auto& member : relation.members()) {
+            REQUIRE(get_member_way(member.ref())->tags().empty());
+            const auto* tags = get_member_tags(member);
+            REQUIRE(tags);
+            member_tags.emplace_back(tags->get_value_by_key("highway", ""));
+        }
+    }
+
+};
+
+TEST_CASE("Relations manager with tag interning") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_relation(buffer, _id(1), _tag("type", "route"),
+        _member(osmium::item_type::way, 10, ""),
+        _member(osmium::item_type::way, 11, ""),
+        _member(osmium::item_type::way, 12, ""));
+    osmium::builder::add_way(buffer, _id(10), _nodes({1, 2}), _tag("highway", "residential"));
+    osmium::builder::add_way(buffer, _id(11), _nodes({2, 3}), _tag("highway", "residential"));
+    osmium::builder::add_way(buffer, _id(12), _nodes({3, 4}), _tag("highway", "primary"));
+
+    TagsRM manager;
+    manager.member_ways_database().intern_tags();
+    osmium::apply(buffer, manager);
+    manager.prepare_for_lookup();
+    osmium::apply(buffer, manager.handler());
+
+    REQUIRE(manager.member_tags == (std::vector<std::string>{"residential", "residential", "primary"}));
+    REQUIRE(manager.stash().count_interned_tags() == 0);
+}
+
 TEST_CASE("Handle duplicate members correctly") {
     osmium::io::File file{with_data_dir("t/relations/dupl_member.osm")};
 
@@ -1,10 +1,14 @@
 #include "catch.hpp"
 
 #include <osmium/builder/attr.hpp>
+#include <osmium/memory/budget.hpp>
 #include <osmium/storage/item_stash.hpp>
 
+#include <algorithm>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 osmium::memory::Buffer generate_test_data() {
@@ -159,10 +163,415 @@ TEST_CASE("Fill item stash until it garbage collects") {
     REQUIRE(stash.size() == num_items / 10);
     REQUIRE(stash.count_removed() == num_items / 10 * 9);
 
-    // trigger compaction
-    stash.add_item(node);
+    // compaction is triggered when a new segment is started, fill up the
+    // current one until that happens
+    const auto removed = stash.count_removed();
+    std::size_t added = 0;
+    while (stash.count_removed() == removed) {
+        stash.add_item(node);
+        ++added;
+    }
+
+    REQUIRE(stash.size() == num_items / 10 + added);
+    REQUIRE(stash.count_removed() < removed);
+
+    // each step compacts only one segment
+    REQUIRE(removed - stash.count_removed() < 1024 * 1024 / node.padded_size());
+
+    stash.garbage_collect();
+    REQUIRE(stash.size() == num_items / 10 + added);
+    REQUIRE(stash.count_removed() == 0);
+
+    for (std::size_t i = 0; i < num_items; i += 10) {
+        REQUIRE(stash.get<osmium::Node>(handles[i]).id() == 1);
+    }
+}
+
+TEST_CASE("Item stash frees segments with only removed items") {
+    const auto buffer = generate_test_data();
+    const auto& node = buffer.get<osmium::Node>(0);
+
+    osmium::ItemStash stash;
+
+    std::vector<osmium::ItemStash::handle_type> handles;
+    const std::size_t num_items = 200 * 1000;
+    for (std::size_t i = 0; i < num_items; ++i) {
+        handles.push_back(stash.add_item(node));
+    }
+
+    const auto memory = stash.used_memory();
+
+    // remove the first half of the items, that will free whole segments
+    for (std::size_t i = 0; i < num_items / 2; ++i) {
+        stash.remove_item(handles[i]);
+    }
+
+    REQUIRE(stash.size() == num_items / 2);
+    REQUIRE(stash.count_removed() < num_items / 10);
+    REQUIRE(stash.used_memory() < memory * 2 / 3);
+
+    for (std::size_t i = num_items / 2; i < num_items; ++i) {
+        REQUIRE(stash.get_item(handles[i]).type() == osmium::item_type::node);
+    }
+}
+
+
+TEST_CASE("Item stash spilling to disk") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3, 4, 5, 6, 7, 8}));
+    const auto& way = buffer.get<osmium::Way>(0);
+
+    osmium::ItemStash stash;
+    REQUIRE(stash.used_disk_space() == 0);
+
+    std::vector<osmium::ItemStash::handle_type> handles;
+    const std::size_t num_items = 100 * 1000;
+    for (std::size_t i = 0; i < num_items / 2; ++i) {
+        handles.push_back(stash.add_item(way));
+    }
+
+    stash.set_max_memory(2 * 1024 * 1024);
+    for (std::size_t i = num_items / 2; i < num_items; ++i) {
+        handles.push_back(stash.add_item(way));
+    }
+
+    REQUIRE(stash.size() == num_items);
+    REQUIRE(stash.used_disk_space() > 10 * 1024 * 1024);
+    REQUIRE(stash.used_memory() < 6 * 1024 * 1024);
+
+    for (const auto handle : handles) {
+        const auto& w = stash.get<osmium::Way>(handle);
+        REQUIRE(w.id() == 1);
+        REQUIRE(w.nodes().size() == 8);
+    }
+
+    // removing items and compaction work with spilled segments
+    for (std::size_t i = 0; i < num_items; ++i) {
+        if (i % 4 != 0) {
+            stash.remove_item(handles[i]);
+        }
+    }
+    stash.garbage_collect();
+    REQUIRE(stash.size() == num_items / 4);
+    REQUIRE(stash.count_removed() == 0);
+    REQUIRE(stash.used_memory() < 6 * 1024 * 1024);
+
+    for (std::size_t i = 0; i < num_items; i += 4) {
+        REQUIRE(stash.get<osmium::Way>(handles[i]).nodes().back().ref() == 8);
+    }
+
+    stash.clear();
+    REQUIRE(stash.used_disk_space() == 0);
+}
+
+TEST_CASE("Item stash spilling to disk when memory budget is exceeded") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3, 4, 5, 6, 7, 8}));
+    const auto& way = buffer.get<osmium::Way>(0);
+
+    osmium::memory::MemoryBudget budget{4 * 1024 * 1024};
+    auto other = budget.add_account("other");
+
+    osmium::ItemStash stash;
+    stash.set_memory_budget(budget);
+
+    std::vector<osmium::ItemStash::handle_type> handles;
+    const std::size_t num_items = 50 * 1000;
+    for (std::size_t i = 0; i < num_items; ++i) {
+        handles.push_back(stash.add_item(way));
+    }
+    REQUIRE(stash.used_disk_space() > 0);
+    REQUIRE(budget.used() <= budget.limit());
+
+    // memory used by something else makes the stash spill more
+    const auto disk_space = stash.used_disk_space();
+    other.set(3 * 1024 * 1024);
+    for (std::size_t i = 0; i < num_items; ++i) {
+        handles.push_back(stash.add_item(way));
+    }
+    REQUIRE(stash.used_disk_space() > disk_space + 4 * 1024 * 1024);
+    REQUIRE(budget.used() <= budget.limit());
+    REQUIRE(budget.report().find("item_stash") != std::string::npos);
+
+    for (const auto handle : handles) {
+        REQUIRE(stash.get<osmium::Way>(handle).nodes().size() == 8);
+    }
+
+    stash.clear();
+    REQUIRE(budget.used() == 3 * 1024 * 1024);
+}
+
+TEST_CASE("Item stash interning tag lists") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _user("foo"), _nodes({1, 2, 3}), _tag("highway", "residential"));
+    osmium::builder::add_way(buffer, _id(2), _nodes({3, 4}), _tag("highway", "residential"));
+    osmium::builder::add_way(buffer, _id(3), _nodes({4, 5}), _tag("highway", "primary"));
+    osmium::builder::add_node(buffer, _id(4), _tag("highway", "residential"));
+    osmium::builder::add_relation(buffer, _id(5), _member(osmium::item_type::way, 1, "outer"), _tag("highway", "residential"));
+    osmium::builder::add_way(buffer, _id(6), _nodes({5, 6}));
+
+    osmium::ItemStash stash;
+    std::vector<osmium::ItemStash::handle_type> handles;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        handles.push_back(stash.add_object_interning_tags(object));
+    }
+
+    REQUIRE(stash.size() == 6);
+    REQUIRE(stash.count_interned_tags() == 2);
+
+    const auto& way = stash.get<osmium::Way>(handles[0]);
+    REQUIRE(way.id() == 1);
+    REQUIRE(std::string{way.user()} == "foo");
+    REQUIRE(way.nodes().size() == 3);
+    REQUIRE(way.tags().empty());
+
+    // the same tag list is returned for all objects with the same tags
+    REQUIRE(&stash.tags(handles[0]) == &stash.tags(handles[1]));
+    REQUIRE(&stash.tags(handles[0]) == &stash.tags(handles[3]));
+    REQUIRE(&stash.tags(handles[0]) == &stash.tags(handles[4]));
+    REQUIRE(&stash.tags(handles[0]) != &stash.tags(handles[2]));
+    REQUIRE(std::string{stash.tags(handles[2]).get_value_by_key("highway")} == "primary");
+    REQUIRE(stash.tags(handles[5]).empty());
+
+    REQUIRE(stash.get<osmium::Node>(handles[3]).id() == 4);
+    REQUIRE(stash.get<osmium::Relation>(handles[4]).members().size() == 1);
+    REQUIRE(std::string{stash.get<osmium::Relation>(handles[4]).members().begin()->role()} == "outer");
+
+    // tag lists are removed with the last object using them
+    stash.remove_item(handles[2]);
+    REQUIRE(stash.count_interned_tags() == 1);
+    stash.remove_item(handles[0]);
+    stash.remove_item(handles[1]);
+    REQUIRE(stash.count_interned_tags() == 1);
+    REQUIRE(std::string{stash.tags(handles[3]).get_value_by_key("highway")} == "residential");
+    stash.remove_item(handles[3]);
+    stash.remove_item(handles[4]);
+    REQUIRE(stash.count_interned_tags() == 0);
+    REQUIRE(stash.size() == 1);
+
+    // tags of items added normally
+    const auto handle = stash.add_item(buffer.get<osmium::Way>(0));
+    REQUIRE(std::string{stash.tags(handle).get_value_by_key("highway")} == "residential");
+
+    stash.clear();
+    REQUIRE(stash.count_interned_tags() == 0);
+}
+
+TEST_CASE("Item stash compacting way nodes") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _tag("highway", "primary"),
+        _nodes({{10, {1.0, 2.0}}, {11, {1.1, 2.1}}, {9, osmium::Location{}}, {10, {1.0, 2.0}}}));
+    const auto& orig = buffer.get<osmium::Way>(pos);
+
+    osmium::ItemStash stash;
+    const auto handle = stash.add_way_compacting_nodes(orig);
+    REQUIRE(stash.size() == 1);
+
+    const auto& way = stash.get<osmium::Way>(handle);
+    REQUIRE(way.id() == 1);
+    REQUIRE(way.nodes().empty());
+    REQUIRE(std::string{way.tags().get_value_by_key("highway")} == "primary");
+
+    const auto nodes = stash.compact_nodes(handle);
+    REQUIRE(nodes.size() == 4);
+    REQUIRE(nodes.is_closed());
+    REQUIRE(std::equal(nodes.begin(), nodes.end(), orig.nodes().begin()));
+    auto it = orig.nodes().begin();
+    for (const auto& nr : nodes) {
+        REQUIRE(nr.location() == it->location());
+        ++it;
+    }
+
+    // many ways with locations need much less memory than normal
+    for (osmium::object_id_type id = 2; id < 2000; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({{id * 10,     {id * 0.001, 1.0}},
+                                                          {id * 10 + 1, {id * 0.001 + 0.0001, 1.0}},
+                                                          {id * 10 + 2, {id * 0.001 + 0.0001, 1.0001}},
+                                                          {id * 10 + 3, {id * 0.001 + 0.0002, 1.0001}}}));
+    }
+    std::vector<osmium::ItemStash::handle_type> handles;
+    for (const auto& w : buffer.select<osmium::Way>()) {
+        if (w.id() > 1) {
+            handles.push_back(stash.add_way_compacting_nodes(w));
+        }
+    }
+    REQUIRE(stash.compact_nodes_size() * 2 < handles.size() * 4 * sizeof(osmium::NodeRef));
+    REQUIRE(stash.compact_nodes(handles[5]).front().ref() == 70);
+    REQUIRE(stash.compact_nodes(handles[5]).back().location() == (osmium::Location{0.0072, 1.0001}));
+
+    // node lists are compacted when ways are removed
+    for (std::size_t i = 0; i < handles.size() - 1; ++i) {
+        stash.remove_item(handles[i]);
+    }
+    stash.garbage_collect();
+    REQUIRE(stash.size() == 2);
+    REQUIRE(stash.compact_nodes(handles.back()).front().ref() == 19990);
+    REQUIRE(std::equal(stash.compact_nodes(handle).begin(), stash.compact_nodes(handle).end(), orig.nodes().begin()));
+
+    stash.remove_item(handle);
+    stash.remove_item(handles.back());
+    REQUIRE(stash.compact_nodes_size() == 0);
+
+    stash.clear();
+    REQUIRE(stash.compact_nodes_size() == 0);
+}
+
+#ifdef OSMIUM_WITH_LZ4
+TEST_CASE("Item stash compressing segments") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3, 4, 5, 6, 7, 8}));
+    const auto& way = buffer.get<osmium::Way>(0);
+
+    osmium::ItemStash stash;
+    stash.enable_compression(2);
+    stash.set_max_memory(2 * 1024 * 1024);
+
+    std::vector<osmium::ItemStash::handle_type> handles;
+    const std::size_t num_items = 100 * 1000;
+    for (std::size_t i = 0; i < num_items; ++i) {
+        handles.push_back(stash.add_item(way));
+    }
+
+    REQUIRE(stash.size() == num_items);
+    REQUIRE(stash.used_disk_space() == 0);
+    REQUIRE(stash.used_memory() < 6 * 1024 * 1024);
+
+    // all items are accessible, segments are decompressed as needed
+    for (const auto handle : handles) {
+        const auto& w = stash.get<osmium::Way>(handle);
+        REQUIRE(w.id() == 1);
+        REQUIRE(w.nodes().size() == 8);
+    }
+
+    // two items from different compressed segments at the same time
+    const auto& w1 = stash.get<osmium::Way>(handles[0]);
+    const auto& w2 = stash.get<osmium::Way>(handles[num_items / 2]);
+    REQUIRE(w1.nodes().front().ref() == 1);
+    REQUIRE(w2.nodes().back().ref() == 8);
 
-    REQUIRE(stash.size() == num_items / 10 + 1);
+    // removing items and compaction work with compressed segments
+    for (std::size_t i = 0; i < num_items; ++i) {
+        if (i % 4 != 0) {
+            stash.remove_item(handles[i]);
+        }
+    }
+    stash.garbage_collect();
+    REQUIRE(stash.size() == num_items / 4);
     REQUIRE(stash.count_removed() == 0);
+    REQUIRE(stash.used_memory() < 6 * 1024 * 1024);
+
+    for (std::size_t i = 0; i < num_items; i += 4) {
+        REQUIRE(stash.get<osmium::Way>(handles[i]).nodes().back().ref() == 8);
+    }
+
+    // removing all items of compressed segments frees them
+    for (std::size_t i = 0; i < num_items; i += 4) {
+        stash.remove_item(handles[i]);
+    }
+    REQUIRE(stash.size() == 0);
+
+    stash.clear();
+    REQUIRE(stash.used_disk_space() == 0);
 }
+#endif
 
+#ifdef OSMIUM_WITH_LZ4
+TEST_CASE("Item stash keeps references into many compressed segments valid") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::ItemStash stash;
+    stash.enable_compression(2);
+    stash.set_max_memory(2 * 1024 * 1024);
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<osmium::ItemStash::handle_type> handles;
+    const std::size_t num_items = 100 * 1000;
+    for (std::size_t i = 0; i < num_items; ++i) {
+        buffer.clear();
+        osmium::builder::add_way(buffer, _id(static_cast<osmium::object_id_type>(i + 1)), _nodes({1, 2, 3, 4, 5, 6, 7, 8}));
+        handles.push_back(stash.add_item(buffer.get<osmium::Way>(0)));
+    }
+    REQUIRE(stash.used_disk_space() == 0);
+
+    // Like the MultipolygonManager collecting all member ways of a
+    // relation before using them. The items are in many more compressed
+    // segments than the cache holds.
+    std::vector<const osmium::Way*> ways;
+    for (std::size_t i = 0; i < num_items / 2; i += 5000) {
+        ways.push_back(&stash.get<osmium::Way>(handles[i]));
+    }
+    REQUIRE(ways.size() == 10);
+    const auto memory_with_references = stash.used_memory();
+
+    std::size_t i = 0;
+    for (const auto* way : ways) {
+        REQUIRE(way->id() == static_cast<osmium::object_id_type>(i + 1));
+        REQUIRE(way->nodes().size() == 8);
+        REQUIRE(way->nodes().back().ref() == 8);
+        i += 5000;
+    }
+
+    // The next modification shrinks the cache again.
+    stash.remove_item(handles.back());
+    REQUIRE(stash.used_memory() < memory_with_references);
+    REQUIRE(stash.get<osmium::Way>(handles[0]).id() == 1);
+}
+#endif
+
+#ifdef OSMIUM_WITH_LZ4
+TEST_CASE("Item stash can be read from several threads with compressed segments") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::ItemStash stash;
+    stash.enable_compression(1);
+    stash.set_max_memory(1024 * 1024);
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<osmium::ItemStash::handle_type> handles;
+    const std::size_t num_items = 100 * 1000;
+    for (std::size_t i = 0; i < num_items; ++i) {
+        buffer.clear();
+        osmium::builder::add_way(buffer, _id(static_cast<osmium::object_id_type>(i + 1)), _nodes({1, 2, 3, 4, 5, 6, 7, 8}));
+        handles.push_back(stash.add_item(buffer.get<osmium::Way>(0)));
+    }
+
+    // Every thread reads items from all segments in a different order,
+    // so the cache grows while other threads are reading from it.
+    const std::size_t num_threads = 4;
+    std::vector<std::size_t> errors(num_threads, 0);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            const auto& cstash = stash;
+            std::vector<std::pair<std::size_t, const osmium::Way*>> ways;
+            for (std::size_t n = 0; n < num_items; n += 997) {
+                const std::size_t i = (n + t * 25000) % num_items;
+                ways.emplace_back(i, &cstash.get<osmium::Way>(handles[i]));
+            }
+            for (const auto& way : ways) {
+                if (way.second->id() != static_cast<osmium::object_id_type>(way.first + 1) ||
+                    way.second->nodes().back().ref() != 8) {
+                    ++errors[t];
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto e : errors) {
+        REQUIRE(e == 0);
+    }
+}
+#endif
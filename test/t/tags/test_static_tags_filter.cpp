@@ -0,0 +1,92 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/tags/static_tags_filter.hpp>
+#include <osmium/tags/taglist.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <vector>
+
+namespace {
+
+    constexpr const osmium::static_string highway_values[] = {"motorway", "trunk", "primary", ""};
+
+    constexpr const auto highway_filter = osmium::make_static_tags_filter(false,
+        osmium::static_tag_rule(false, "highway", "proposed"),
+        osmium::static_key_values_rule(true, "highway", highway_values),
+        osmium::static_key_rule(true, "railway"));
+
+} // anonymous namespace
+
+TEST_CASE("Static string") {
+    constexpr const osmium::static_string str{"highway"};
+    static_assert(str.size() == 7, "size of static string");
+    REQUIRE(str.equals("highway", 7));
+    REQUIRE_FALSE(str.equals("highwax", 7));
+    REQUIRE_FALSE(str.equals("Highway", 7));
+    REQUIRE_FALSE(str.equals("high", 4));
+
+    constexpr const osmium::static_string empty{""};
+    REQUIRE(empty.equals("", 0));
+    REQUIRE_FALSE(empty.equals("a", 1));
+}
+
+TEST_CASE("Static tags filter") {
+    static_assert(decltype(highway_filter)::count() == 3, "number of rules");
+    REQUIRE_FALSE(highway_filter.default_result());
+
+    REQUIRE(highway_filter("highway", "primary"));
+    REQUIRE(highway_filter("highway", "motorway"));
+    REQUIRE(highway_filter("highway", ""));
+    REQUIRE(highway_filter("railway", "rail"));
+    REQUIRE_FALSE(highway_filter("highway", "proposed"));
+    REQUIRE_FALSE(highway_filter("highway", "residential"));
+    REQUIRE_FALSE(highway_filter("highway", "primary_link"));
+    REQUIRE_FALSE(highway_filter("highways", "primary"));
+    REQUIRE_FALSE(highway_filter("Highway", "primary"));
+    REQUIRE_FALSE(highway_filter("", ""));
+    REQUIRE_FALSE(highway_filter("name", "primary"));
+}
+
+TEST_CASE("Static tags filter with non-bool result") {
+    const auto filter = osmium::make_static_tags_filter(0,
+        osmium::static_tag_rule(1, "building", "yes"),
+        osmium::static_key_rule(2, "building"));
+
+    REQUIRE(filter("building", "yes") == 1);
+    REQUIRE(filter("building", "house") == 2);
+    REQUIRE(filter("amenity", "yes") == 0);
+}
+
+TEST_CASE("Static tags filter without rules") {
+    const auto filter = osmium::make_static_tags_filter(true);
+    static_assert(decltype(filter)::count() == 0, "number of rules");
+    REQUIRE(filter("highway", "primary"));
+}
+
+TEST_CASE("Static tags filter gives same results as tags filter") {
+    osmium::TagsFilter filter{false};
+    filter.add_rule(false, "highway", "proposed");
+    filter.add_rule(true, "highway", osmium::StringMatcher::list{{"motorway", "trunk", "primary", ""}});
+    filter.add_rule(true, "railway");
+
+    osmium::memory::Buffer buffer{10240};
+    const auto pos = osmium::builder::add_tag_list(buffer,
+        osmium::builder::attr::_tags({
+            {"highway", "primary"},
+            {"highway", "proposed"},
+            {"highway", "trunk_link"},
+            {"railway", "rail"},
+            {"name", "Main Street"},
+            {"highway", ""}
+    }));
+    const osmium::TagList& tags = buffer.get<osmium::TagList>(pos);
+
+    for (const auto& tag : tags) {
+        REQUIRE(highway_filter(tag) == filter(tag));
+    }
+
+    REQUIRE(osmium::tags::match_any_of(tags, highway_filter));
+    REQUIRE_FALSE(osmium::tags::match_all_of(tags, highway_filter));
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <osmium/tags/string_table_tags_filter.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+static const std::vector<const char*> strings = {
+    "highway", "primary", "name", "Main Street", "amenity", "restaurant",
+    "building", "yes", "no", "highway_old", "residential", "source"
+};
+
+// Check that the compiled filter gives the same result as the filter
+// itself for all combinations of strings.
+template <typename TResult>
+static void check_all_pairs(const osmium::TagsFilterBase<TResult>& filter) {
+    osmium::StringTableTagsFilterBase<TResult> compiled{filter};
+    compiled.reset(strings.size());
+
+    // Run twice, the second time all results come from the cache.
+    for (int run = 0; run < 2; ++run) {
+        for (std::size_t k = 0; k < strings.size(); ++k) {
+            for (std::size_t v = 0; v < strings.size(); ++v) {
+                INFO("key=" << strings[k] << " value=" << strings[v]);
+                REQUIRE(compiled(k, strings[k], v, strings[v]) == filter(strings[k], strings[v]));
+            }
+        }
+    }
+}
+
+TEST_CASE("String table tags filter with key and value rules") {
+    osmium::TagsFilter filter{false};
+    filter.add_rule(false, "highway", "residential");
+    filter.add_rule(true, osmium::StringMatcher::prefix{"highway"});
+    filter.add_rule(true, "building", osmium::StringMatcher::list{{"yes", "no"}});
+    filter.add_rule(true, osmium::TagMatcher{"amenity", "restaurant", true});
+
+    check_all_pairs(filter);
+
+    osmium::StringTableTagsFilter compiled{filter};
+    compiled.reset(strings.size());
+    REQUIRE(compiled(0, strings[0], 1, strings[1]));
+    REQUIRE_FALSE(compiled(0, strings[0], 10, strings[10]));
+    REQUIRE(compiled(9, strings[9], 10, strings[10]));
+    REQUIRE(compiled(6, strings[6], 8, strings[8]));
+    REQUIRE_FALSE(compiled(4, strings[4], 5, strings[5]));
+    REQUIRE(compiled(4, strings[4], 7, strings[7]));
+    REQUIRE_FALSE(compiled(2, strings[2], 3, strings[3]));
+}
+
+TEST_CASE("String table tags filter with default result") {
+    osmium::TagsFilter filter{true};
+    filter.add_rule(false, "source");
+    check_all_pairs(filter);
+}
+
+TEST_CASE("String table tags filter without rules") {
+    const osmium::TagsFilter filter{true};
+    check_all_pairs(filter);
+}
+
+TEST_CASE("String table tags filter with many rules") {
+    // More rules than fit into one 64bit word, the first match decides.
+    osmium::TagsFilterBase<int> filter{-1};
+    for (int n = 0; n < 100; ++n) {
+        filter.add_rule(n, "key" + std::to_string(n));
+    }
+    filter.add_rule(100, "name", "Main Street");
+    filter.add_rule(101, "name");
+
+    std::vector<std::string> table;
+    for (int n = 0; n < 100; ++n) {
+        table.push_back("key" + std::to_string(n));
+    }
+    table.emplace_back("name");
+    table.emplace_back("Main Street");
+    table.emplace_back("other");
+
+    osmium::StringTableTagsFilterBase<int> compiled;
+    compiled.reset(filter, table.size());
+    for (std::size_t n = 0; n < 100; ++n) {
+        REQUIRE(compiled(n, table[n].c_str(), 102, table[102].c_str()) == static_cast<int>(n));
+    }
+    REQUIRE(compiled(100, "name", 101, "Main Street") == 100);
+    REQUIRE(compiled(100, "name", 102, "other") == 101);
+    REQUIRE(compiled(102, "other", 100, "name") == -1);
+
+    // Reset with a different filter.
+    osmium::TagsFilterBase<int> filter2{0};
+    filter2.add_rule(7, "other");
+    compiled.reset(filter2, table.size());
+    REQUIRE(compiled(102, "other", 100, "name") == 7);
+    REQUIRE(compiled(100, "name", 102, "other") == 0);
+}
@@ -209,6 +209,13 @@ TEST_CASE("empty keys and values are okay") {
     ++it;
     REQUIRE(it == tl.end());
 
+    it = tl.begin();
+    REQUIRE(it->key_size() == 11);
+    REQUIRE(it->value_size() == 0);
+    ++it;
+    REQUIRE(it->key_size() == 0);
+    REQUIRE(it->value_size() == 9);
+
     REQUIRE(std::string("") == tl.get_value_by_key("empty value"));
     REQUIRE(std::string("empty key") == tl.get_value_by_key(""));
 }
@@ -0,0 +1,69 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/tags/tag_list_index.hpp>
+
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Empty tag list index") {
+    const osmium::TagListIndex index;
+    REQUIRE(index.empty());
+    REQUIRE(index.size() == 0);
+    REQUIRE(index["highway"] == nullptr);
+    REQUIRE(std::string{"default"} == index.get_value_by_key("highway", "default"));
+    REQUIRE_FALSE(index.has_key("highway"));
+}
+
+TEST_CASE("Tag list index") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto pos = osmium::builder::add_tag_list(buffer,
+        _tag("name", "Main Street"),
+        _tag("highway", "primary"),
+        _tag("", "empty key"),
+        _tag("source", "GPS"),
+        _tag("highway", "secondary"),
+        _tag("ref", "")
+    );
+    const osmium::TagList& tags = buffer.get<osmium::TagList>(pos);
+
+    osmium::TagListIndex index{tags};
+    REQUIRE_FALSE(index.empty());
+    REQUIRE(index.size() == 6);
+
+    for (const auto& tag : tags) {
+        REQUIRE(index.has_key(tag.key()));
+        REQUIRE(std::string{tags[tag.key()]} == index[tag.key()]);
+    }
+
+    REQUIRE(std::string{"primary"} == index["highway"]);
+    REQUIRE(std::string{"empty key"} == index[""]);
+    REQUIRE(std::string{""} == index.get_value_by_key("ref", "default"));
+    REQUIRE(std::string{"default"} == index.get_value_by_key("foo", "default"));
+    REQUIRE(index["foo"] == nullptr);
+    REQUIRE(index["highwayx"] == nullptr);
+    REQUIRE(index["a"] == nullptr);
+    REQUIRE(index["z"] == nullptr);
+
+    REQUIRE(index.has_tag("highway", "primary"));
+    REQUIRE_FALSE(index.has_tag("highway", "secondary"));
+    REQUIRE_FALSE(index.has_tag("foo", "primary"));
+
+    SECTION("reset") {
+        const auto pos2 = osmium::builder::add_tag_list(buffer, _tag("amenity", "bench"));
+        index.reset(buffer.get<osmium::TagList>(pos2));
+        REQUIRE(index.size() == 1);
+        REQUIRE(std::string{"bench"} == index["amenity"]);
+        REQUIRE_FALSE(index.has_key("highway"));
+    }
+
+    SECTION("clear") {
+        index.clear();
+        REQUIRE(index.empty());
+        REQUIRE_FALSE(index.has_key("highway"));
+    }
+}
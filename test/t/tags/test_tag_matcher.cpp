@@ -115,6 +115,14 @@ TEST_CASE("Tag matcher") {
         REQUIRE(m(*tag_list.begin()));
         REQUIRE_FALSE(m(*std::next(tag_list.begin())));
     }
+
+    SECTION("Matching key prefix with key length") {
+        osmium::TagMatcher m{osmium::StringMatcher::prefix{"high"}};
+        REQUIRE(m.match_key("highway", 7));
+        REQUIRE_FALSE(m.match_key("hig", 3));
+        REQUIRE(m(*tag_list.begin()));
+        REQUIRE_FALSE(m(*std::next(tag_list.begin())));
+    }
 }
 
 TEST_CASE("Copy and move tag matcher") {
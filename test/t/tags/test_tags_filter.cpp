@@ -7,6 +7,7 @@
 #include <functional>
 #include <iterator>
 #include <string>
+#include <vector>
 
 TEST_CASE("Tags filter") {
     osmium::memory::Buffer buffer{10240};
@@ -172,3 +173,60 @@ TEST_CASE("TagsFilterBase") {
 
 }
 
+TEST_CASE("Tags filter with many indexed and other rules") {
+    // Mixes rules the filter can index by key or key and value with
+    // other rules, and checks that the first matching rule wins like
+    // when checking all rules in order.
+    osmium::TagsFilterBase<int> filter{-1};
+    int n = 0;
+    filter.add_rule(n++, osmium::StringMatcher::prefix{"addr:"});
+    for (int i = 0; i < 200; ++i) {
+        filter.add_rule(n++, "amenity", "value" + std::to_string(i));
+    }
+    filter.add_rule(n++, osmium::TagMatcher{"shop", "supermarket", true});
+    filter.add_rule(n++, "amenity", osmium::StringMatcher::substring{"1"});
+    for (int i = 0; i < 200; ++i) {
+        filter.add_rule(n++, "key" + std::to_string(i), std::vector<std::string>{"a", "b"});
+    }
+    filter.add_rule(n++, std::vector<std::string>{"name", "amenity", "shop"});
+    filter.add_rule(n++, "amenity", "value5");
+    filter.add_rule(n++, "key7");
+    REQUIRE(filter.count() == static_cast<std::size_t>(n));
+
+    const auto linear = [&filter](const char* key, const char* value) {
+        for (std::size_t r = 0; r < filter.count(); ++r) {
+            if (filter.rule_matcher(r)(key, value)) {
+                return filter.rule_result(r);
+            }
+        }
+        return filter.default_result();
+    };
+
+    std::vector<std::string> keys{"addr:street", "amenity", "shop", "name", "key7", "key8", "other", ""};
+    std::vector<std::string> values{"a", "b", "c", "supermarket", "value5", "value15", "value500", ""};
+    for (int i = 0; i < 10; ++i) {
+        keys.push_back("key" + std::to_string(i));
+        values.push_back("value" + std::to_string(i * 30));
+    }
+
+    for (const auto& key : keys) {
+        for (const auto& value : values) {
+            INFO("key=" << key << " value=" << value);
+            REQUIRE(filter(key.c_str(), value.c_str()) == linear(key.c_str(), value.c_str()));
+        }
+    }
+
+    REQUIRE(filter("addr:street", "value5") == 0);
+    REQUIRE(filter("amenity", "value5") == 6);
+    REQUIRE(filter("amenity", "value1000") == 202);
+    REQUIRE(filter("amenity", "value500") == 403);
+    REQUIRE(filter("shop", "bakery") == 201);
+    REQUIRE(filter("shop", "supermarket") == 403);
+    REQUIRE(filter("key7", "b") == 210);
+    REQUIRE(filter("key7", "c") == 405);
+    REQUIRE(filter("other", "a") == -1);
+
+    // Copies keep the index
+    const auto copy = filter;
+    REQUIRE(copy("amenity", "value5") == 6);
+}
@@ -0,0 +1,120 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/callback_buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/async_callback.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    struct CollectIds {
+
+        std::vector<osmium::object_id_type> ids;
+        std::thread::id thread_id;
+
+        void operator()(osmium::memory::Buffer&& buffer) {
+            thread_id = std::this_thread::get_id();
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                ids.push_back(node.id());
+            }
+        }
+
+    }; // struct CollectIds
+
+    void fill(osmium::memory::CallbackBuffer& cb, int count) {
+        for (int id = 1; id <= count; ++id) {
+            osmium::builder::add_node(cb.buffer(), _id(id));
+            cb.possibly_flush();
+        }
+        cb.flush();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("AsyncCallback with dedicated thread") {
+    CollectIds collect;
+    osmium::thread::AsyncCallback async{[&collect](osmium::memory::Buffer&& buffer) {
+        collect(std::move(buffer));
+    }, 2};
+
+    osmium::memory::CallbackBuffer cb{async.function(), 1024, 512};
+    fill(cb, 1000);
+    async.close();
+
+    REQUIRE(collect.ids.size() == 1000);
+    REQUIRE(std::is_sorted(collect.ids.begin(), collect.ids.end()));
+    REQUIRE(collect.thread_id != std::this_thread::get_id());
+
+    const auto stats = async.stats();
+    REQUIRE(stats.max_size == 2);
+    REQUIRE(stats.largest_size <= 2);
+    REQUIRE(stats.push_count > 10);
+
+    REQUIRE_THROWS_AS(async(osmium::memory::Buffer{1024}), const std::logic_error&);
+}
+
+TEST_CASE("AsyncCallback on thread pool") {
+    osmium::thread::Pool pool{3};
+    CollectIds collect;
+    osmium::thread::AsyncCallback async{[&collect](osmium::memory::Buffer&& buffer) {
+        collect(std::move(buffer));
+    }, pool, 3};
+
+    osmium::memory::CallbackBuffer cb{async.function(), 1024, 512};
+    fill(cb, 1000);
+    async.close();
+
+    REQUIRE(collect.ids.size() == 1000);
+    REQUIRE(std::is_sorted(collect.ids.begin(), collect.ids.end()));
+    REQUIRE(collect.thread_id != std::this_thread::get_id());
+    REQUIRE(async.stats().largest_size <= 3);
+}
+
+TEST_CASE("AsyncCallback without buffers") {
+    osmium::thread::Pool pool{2};
+    int count = 0;
+    osmium::thread::AsyncCallback async1{[&count](osmium::memory::Buffer&& /*buffer*/) {
+        ++count;
+    }};
+    osmium::thread::AsyncCallback async2{[&count](osmium::memory::Buffer&& /*buffer*/) {
+        ++count;
+    }, pool};
+    async1(osmium::memory::Buffer{});
+    async1.close();
+    async2.close();
+    async2.close();
+    REQUIRE(count == 0);
+}
+
+TEST_CASE("AsyncCallback rethrows exception from callback") {
+    osmium::thread::Pool pool{2};
+
+    for (const bool use_pool : {false, true}) {
+        int count = 0;
+        const auto callback = [&count](osmium::memory::Buffer&& /*buffer*/) {
+            if (++count == 3) {
+                throw std::runtime_error{"callback error"};
+            }
+        };
+        osmium::thread::AsyncCallback async_thread{callback};
+        osmium::thread::AsyncCallback async_pool{callback, pool};
+        auto& async = use_pool ? async_pool : async_thread;
+
+        osmium::memory::CallbackBuffer cb{async.function(), 1024, 512};
+        REQUIRE_THROWS_WITH(fill(cb, 1000), "callback error");
+        REQUIRE_THROWS_WITH(async.close(), "callback error");
+        REQUIRE(count == 3);
+    }
+}
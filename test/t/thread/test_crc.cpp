@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/osm/crc.hpp>
+#include <osmium/osm/crc_crc32c.hpp>
+#include <osmium/osm/crc_zlib.hpp>
+#include <osmium/thread/crc.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // Source returning the objects into buffers with the given number of
+    // objects each.
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        BufferSource(const std::vector<std::string>& lines, std::size_t objects_per_buffer) {
+            for (std::size_t i = 0; i < lines.size(); ++i) {
+                if (i % objects_per_buffer == 0) {
+                    m_buffers.emplace_back(1024, osmium::memory::Buffer::auto_grow::yes);
+                }
+                REQUIRE(osmium::opl_parse(lines[i].c_str(), m_buffers.back()));
+            }
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+    std::vector<std::string> test_data() {
+        std::vector<std::string> lines;
+        for (int id = 1; id <= 200; ++id) {
+            lines.push_back("n" + std::to_string(id) + " v1 x1." + std::to_string(id) + " y2.5 Tamenity=bench");
+        }
+        for (int id = 1; id <= 50; ++id) {
+            lines.push_back("w" + std::to_string(id) + " v2 Nn1,n2,n" + std::to_string(id + 2));
+        }
+        lines.emplace_back("r1 v1 Mw1@outer,w2@inner Ttype=multipolygon");
+        return lines;
+    }
+
+    template <typename TCRC>
+    unsigned long sequential_crc(const std::vector<std::string>& lines) { // NOLINT(google-runtime-int)
+        BufferSource source{lines, lines.size()};
+        const auto buffer = source.read();
+        osmium::CRC<TCRC> crc;
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            osmium::thread::detail::update_crc(crc, object);
+        }
+        return crc().checksum();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Parallel CRC32 is the same as sequential CRC32") {
+    osmium::thread::Pool pool{3};
+    const auto lines = test_data();
+    const auto expected = sequential_crc<osmium::CRC_zlib>(lines);
+
+    for (const std::size_t objects_per_buffer : {std::size_t{1}, std::size_t{7}, std::size_t{100}, lines.size()}) {
+        BufferSource source{lines, objects_per_buffer};
+        const auto crc = osmium::thread::parallel_crc<osmium::CRC_zlib>(source, pool);
+        REQUIRE(crc().checksum() == expected);
+    }
+}
+
+TEST_CASE("Parallel CRC32C is the same as sequential CRC32C") {
+    osmium::thread::Pool pool{3};
+    const auto lines = test_data();
+    const auto expected = sequential_crc<osmium::CRC_crc32c>(lines);
+
+    for (const std::size_t objects_per_buffer : {std::size_t{1}, std::size_t{7}, std::size_t{100}, lines.size()}) {
+        BufferSource source{lines, objects_per_buffer};
+        const auto crc = osmium::thread::parallel_crc<osmium::CRC_crc32c>(source, pool);
+        REQUIRE(crc().checksum() == expected);
+    }
+}
+
+TEST_CASE("Parallel CRC of empty input") {
+    osmium::thread::Pool pool{2};
+    BufferSource source{{}, 1};
+    const auto crc = osmium::thread::parallel_crc<osmium::CRC_zlib>(source, pool);
+    REQUIRE(crc().checksum() == osmium::CRC_zlib{}.checksum());
+}
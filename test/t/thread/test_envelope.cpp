@@ -0,0 +1,83 @@
+#include "catch.hpp"
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/thread/envelope.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // Source returning the objects into buffers with the given number of
+    // objects each.
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        BufferSource(const std::vector<std::string>& lines, std::size_t objects_per_buffer) {
+            for (std::size_t i = 0; i < lines.size(); ++i) {
+                if (i % objects_per_buffer == 0) {
+                    m_buffers.emplace_back(1024, osmium::memory::Buffer::auto_grow::yes);
+                }
+                REQUIRE(osmium::opl_parse(lines[i].c_str(), m_buffers.back()));
+            }
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+    std::vector<std::string> test_data() {
+        std::vector<std::string> lines;
+        for (int id = 1; id <= 10000; ++id) {
+            lines.push_back("n" + std::to_string(id) + " v1 x" + std::to_string(id % 100) + ".5 y" + std::to_string(id / 200) + ".25");
+        }
+        lines.emplace_back("n10001 v1 x200 y0");
+        lines.emplace_back("w1 v1 Nn1x-3.5y1,n2,n3x2y-4");
+        lines.emplace_back("r1 v1 Mn10001@");
+        return lines;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Envelope of buffer") {
+    BufferSource source{test_data(), 20000};
+    const auto buffer = source.read();
+    const auto box = osmium::thread::buffer_envelope(buffer);
+    REQUIRE(box.bottom_left() == osmium::Location(-3.5, -4.0));
+    REQUIRE(box.top_right() == osmium::Location(99.5, 50.25));
+
+    osmium::thread::Pool pool{3};
+    REQUIRE(osmium::thread::buffer_envelope(buffer, pool) == box);
+}
+
+TEST_CASE("Envelope of empty buffer") {
+    const osmium::memory::Buffer buffer{1024};
+    REQUIRE_FALSE(osmium::thread::buffer_envelope(buffer));
+
+    osmium::thread::Pool pool{2};
+    REQUIRE_FALSE(osmium::thread::buffer_envelope(buffer, pool));
+}
+
+TEST_CASE("Parallel envelope of source") {
+    osmium::thread::Pool pool{3};
+    for (const std::size_t objects_per_buffer : {1U, 7U, 1000U, 20000U}) {
+        BufferSource source{test_data(), objects_per_buffer};
+        const auto box = osmium::thread::parallel_envelope(source, pool);
+        REQUIRE(box.bottom_left() == osmium::Location(-3.5, -4.0));
+        REQUIRE(box.top_right() == osmium::Location(99.5, 50.25));
+    }
+}
@@ -0,0 +1,126 @@
+#include "catch.hpp"
+
+#include <osmium/thread/function_wrapper.hpp>
+
+#include <array>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    struct small_job {
+
+        std::shared_ptr<int> counter;
+
+        void operator()() const {
+            ++*counter;
+        }
+
+    }; // struct small_job
+
+    struct large_job {
+
+        std::shared_ptr<int> counter;
+        std::array<char, 1024> data{};
+
+        void operator()() const {
+            ++*counter;
+        }
+
+    }; // struct large_job
+
+    struct move_only_job {
+
+        std::unique_ptr<int> value;
+
+        void operator()() const {
+            ++*value;
+        }
+
+    }; // struct move_only_job
+
+} // anonymous namespace
+
+TEST_CASE("Default constructed function wrapper is empty") {
+    osmium::thread::function_wrapper wrapper;
+    REQUIRE_FALSE(wrapper);
+    REQUIRE_FALSE(wrapper.is_stored_inline());
+}
+
+TEST_CASE("Function wrapper for shutdown") {
+    osmium::thread::function_wrapper wrapper{0};
+    REQUIRE(wrapper);
+    REQUIRE(wrapper.is_stored_inline());
+    REQUIRE(wrapper());
+}
+
+TEST_CASE("Small functions are stored inside the function wrapper") {
+    const auto counter = std::make_shared<int>(0);
+
+    osmium::thread::function_wrapper wrapper{small_job{counter}};
+    REQUIRE(wrapper.is_stored_inline());
+    REQUIRE(counter.use_count() == 2);
+    REQUIRE_FALSE(wrapper());
+    REQUIRE(*counter == 1);
+
+    osmium::thread::function_wrapper moved{std::move(wrapper)};
+    REQUIRE_FALSE(wrapper); // NOLINT(bugprone-use-after-move,hicpp-invalid-access-moved)
+    REQUIRE(moved.is_stored_inline());
+    REQUIRE(counter.use_count() == 2);
+    moved();
+    REQUIRE(*counter == 2);
+
+    std::vector<osmium::thread::function_wrapper> wrappers;
+    for (int i = 0; i < 100; ++i) {
+        wrappers.emplace_back(small_job{counter});
+    }
+    REQUIRE(counter.use_count() == 102);
+    for (auto& w : wrappers) {
+        w();
+    }
+    REQUIRE(*counter == 102);
+
+    wrappers.clear();
+    moved = osmium::thread::function_wrapper{};
+    REQUIRE(counter.use_count() == 1);
+}
+
+TEST_CASE("Large functions are stored on the heap by the function wrapper") {
+    const auto counter = std::make_shared<int>(0);
+
+    large_job job;
+    job.counter = counter;
+    osmium::thread::function_wrapper wrapper{std::move(job)};
+    REQUIRE(wrapper);
+    REQUIRE_FALSE(wrapper.is_stored_inline());
+
+    osmium::thread::function_wrapper other{small_job{counter}};
+    other = std::move(wrapper);
+    REQUIRE_FALSE(other.is_stored_inline());
+    REQUIRE(counter.use_count() == 2);
+    other();
+    REQUIRE(*counter == 1);
+}
+
+TEST_CASE("Function wrapper with move-only functions") {
+    SECTION("move-only functor") {
+        osmium::thread::function_wrapper wrapper{move_only_job{std::unique_ptr<int>{new int{0}}}};
+        REQUIRE(wrapper.is_stored_inline());
+        osmium::thread::function_wrapper moved{std::move(wrapper)};
+        moved();
+    }
+
+    SECTION("packaged task") {
+        std::packaged_task<int()> task{[]() {
+            return 42;
+        }};
+        auto future = task.get_future();
+        osmium::thread::function_wrapper wrapper{std::move(task)};
+        REQUIRE(wrapper.is_stored_inline());
+        osmium::thread::function_wrapper moved{std::move(wrapper)};
+        moved();
+        REQUIRE(future.get() == 42);
+    }
+}
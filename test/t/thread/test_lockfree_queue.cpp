@@ -0,0 +1,196 @@
+#include "catch.hpp"
+
+#include <osmium/thread/lockfree_queue.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Basic use of lock-free queue") {
+    osmium::thread::LockFreeQueue<int> queue;
+    REQUIRE(queue.empty());
+    queue.push(22);
+    REQUIRE_FALSE(queue.empty());
+    REQUIRE(queue.size() == 1);
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 22);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Lock-free queue try_pop") {
+    osmium::thread::LockFreeQueue<int> queue{4, "test"};
+    int value = 0;
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    queue.push(1);
+    queue.push(2);
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 1);
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 2);
+    REQUIRE_FALSE(queue.try_pop(value));
+}
+
+TEST_CASE("Lock-free queue keeps order when wrapping around") {
+    osmium::thread::LockFreeQueue<int> queue{3};
+    int value = 0;
+    for (int i = 0; i < 10; ++i) {
+        queue.push(i);
+        queue.push(i + 100);
+        queue.wait_and_pop(value);
+        REQUIRE(value == i);
+        queue.wait_and_pop(value);
+        REQUIRE(value == i + 100);
+    }
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Lock-free queue blocks producer when full") {
+    osmium::thread::LockFreeQueue<int> queue{2};
+    queue.push(1);
+    queue.push(2);
+    REQUIRE(queue.size() == 2);
+
+    auto future = std::async(std::launch::async, [&queue] {
+        queue.push(3);
+    });
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    future.get();
+
+    queue.wait_and_pop(value);
+    REQUIRE(value == 2);
+    queue.wait_and_pop(value);
+    REQUIRE(value == 3);
+}
+
+TEST_CASE("Lock-free queue push_many keeps order and blocks when full") {
+    osmium::thread::LockFreeQueue<int> queue{3};
+    std::vector<int> values(50);
+    for (int i = 0; i < 50; ++i) {
+        values[static_cast<std::size_t>(i)] = i;
+    }
+
+    auto future = std::async(std::launch::async, [&queue, &values] {
+        queue.push_many(values.begin(), values.end());
+    });
+
+    for (int i = 0; i < 50; ++i) {
+        int value = -1;
+        queue.wait_and_pop(value);
+        REQUIRE(value == i);
+    }
+    future.get();
+    REQUIRE(queue.empty());
+    REQUIRE(queue.stats().push_count == 50);
+}
+
+TEST_CASE("Lock-free queue can be limited by bytes") {
+    osmium::thread::LockFreeQueue<int> queue{10, "bytes", 100};
+    queue.push(1, 60);
+    queue.push(2, 40);
+    REQUIRE(queue.bytes() == 100);
+
+    auto future = std::async(std::launch::async, [&queue] {
+        queue.push(3, 10);
+    });
+
+    REQUIRE(future.wait_for(std::chrono::milliseconds{20}) == std::future_status::timeout);
+    REQUIRE(queue.size() == 2);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    future.get();
+
+    REQUIRE(queue.bytes() == 50);
+    REQUIRE(queue.stats().max_bytes == 100);
+    REQUIRE(queue.stats().largest_bytes == 100);
+
+    // An element larger than the limit is taken if the queue is empty.
+    queue.wait_and_pop(value);
+    queue.wait_and_pop(value);
+    REQUIRE(value == 3);
+    queue.push(4, 1000);
+    REQUIRE(queue.bytes() == 1000);
+}
+
+TEST_CASE("Lock-free queue with many producers and consumers") {
+    constexpr const int num_threads = 4;
+    constexpr const int num_values = 10000;
+
+    osmium::thread::LockFreeQueue<int> queue{8};
+
+    std::vector<std::future<int64_t>> consumers;
+    for (int i = 0; i < num_threads; ++i) {
+        consumers.push_back(std::async(std::launch::async, [&queue] {
+            int64_t sum = 0;
+            while (true) {
+                int value = 0;
+                queue.wait_and_pop(value);
+                if (value < 0) {
+                    return sum;
+                }
+                sum += value;
+            }
+        }));
+    }
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < num_threads; ++i) {
+        producers.emplace_back([&queue] {
+            for (int n = 1; n <= num_values; ++n) {
+                queue.push(n);
+            }
+        });
+    }
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        queue.push(-1);
+    }
+
+    int64_t sum = 0;
+    for (auto& future : consumers) {
+        sum += future.get();
+    }
+    REQUIRE(sum == int64_t(num_threads) * num_values * (num_values + 1) / 2);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Lock-free queue keeps stats") {
+    osmium::thread::LockFreeQueue<int> queue{2, "stats"};
+    REQUIRE(queue.name() == "stats");
+
+    std::thread consumer{[&queue] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        int value = 0;
+        queue.wait_and_pop(value);
+    }};
+
+    queue.push(1);
+    queue.push(2);
+    queue.push(3); // blocks until the consumer has taken one element
+    consumer.join();
+
+    int value = 0;
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(queue.try_pop(value));
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.max_size == 2);
+    REQUIRE(stats.size == 0);
+    REQUIRE(stats.largest_size == 2);
+    REQUIRE(stats.push_count == 3);
+    REQUIRE(stats.full_count == 1);
+    REQUIRE(stats.push_wait > std::chrono::milliseconds{0});
+    REQUIRE(stats.pop_count == 4);
+    REQUIRE(stats.empty_count == 1);
+}
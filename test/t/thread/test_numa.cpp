@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <osmium/thread/numa.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+TEST_CASE("Parse CPU list") {
+    using osmium::thread::detail::parse_cpu_list;
+
+    REQUIRE(parse_cpu_list("").empty());
+    REQUIRE(parse_cpu_list("\n").empty());
+    REQUIRE(parse_cpu_list("0") == std::vector<int>{0});
+    REQUIRE(parse_cpu_list("0-3\n") == (std::vector<int>{0, 1, 2, 3}));
+    REQUIRE(parse_cpu_list("0-1,8,10-11") == (std::vector<int>{0, 1, 8, 10, 11}));
+}
+
+TEST_CASE("Parse invalid CPU list") {
+    using osmium::thread::detail::parse_cpu_list;
+
+    REQUIRE(parse_cpu_list("x").empty());
+    REQUIRE(parse_cpu_list("3-1").empty());
+    REQUIRE(parse_cpu_list("1-").empty());
+    REQUIRE(parse_cpu_list("1;2").empty());
+}
+
+TEST_CASE("NUMA node CPUs from missing directory") {
+    REQUIRE(osmium::thread::numa_node_cpus("/nonexistent/osmium/test").empty());
+}
+
+#ifndef _WIN32
+TEST_CASE("NUMA node CPUs from sysfs directory") {
+    char dir_template[] = "/tmp/osmium_numa_XXXXXX";
+    const char* dir = ::mkdtemp(dir_template);
+    REQUIRE(dir);
+    const std::string base{dir};
+
+    const auto write_file = [](const std::string& name, const char* content) {
+        std::ofstream file{name};
+        file << content;
+    };
+
+    ::mkdir((base + "/node0").c_str(), 0700);
+    ::mkdir((base + "/node1").c_str(), 0700);
+    write_file(base + "/online", "0-1\n");
+    write_file(base + "/node0/cpulist", "0-1,4-5\n");
+    write_file(base + "/node1/cpulist", "2-3,6-7\n");
+
+    const auto nodes = osmium::thread::numa_node_cpus(base);
+    REQUIRE(nodes.size() == 2);
+    REQUIRE(nodes[0] == (std::vector<int>{0, 1, 4, 5}));
+    REQUIRE(nodes[1] == (std::vector<int>{2, 3, 6, 7}));
+
+    REQUIRE(osmium::thread::current_numa_node({}) == -1);
+
+    std::remove((base + "/node0/cpulist").c_str());
+    std::remove((base + "/node1/cpulist").c_str());
+    std::remove((base + "/online").c_str());
+    ::rmdir((base + "/node0").c_str());
+    ::rmdir((base + "/node1").c_str());
+    ::rmdir(dir);
+}
+#endif
+
+TEST_CASE("Set thread affinity to nothing fails") {
+    REQUIRE_FALSE(osmium::thread::set_thread_affinity({}));
+}
+
+TEST_CASE("Thread pool with NUMA affinity") {
+    osmium::thread::Pool pool_none{2, 0, osmium::thread::Pool::scheduling::shared_queue, osmium::thread::Pool::affinity::none};
+    REQUIRE_FALSE(pool_none.pinned());
+
+    osmium::thread::Pool pool_spread{2, 0, osmium::thread::Pool::scheduling::shared_queue, osmium::thread::Pool::affinity::spread_nodes};
+    auto future_spread = pool_spread.submit([] { return 1; });
+    REQUIRE(future_spread.get() == 1);
+
+    osmium::thread::Pool pool_local{2, 0, osmium::thread::Pool::scheduling::work_stealing, osmium::thread::Pool::affinity::local_node};
+    auto future_local = pool_local.submit([] { return 2; });
+    REQUIRE(future_local.get() == 2);
+}
@@ -0,0 +1,249 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pipeline.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Source returning buffers with one node each with ids 1 to count.
+    class NodeSource {
+
+        int m_count;
+        int m_next = 1;
+        int m_throw_at;
+
+    public:
+
+        explicit NodeSource(int count, int throw_at = 0) :
+            m_count(count),
+            m_throw_at(throw_at) {
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_throw_at) {
+                throw std::runtime_error{"source error"};
+            }
+            if (m_next > m_count) {
+                return osmium::memory::Buffer{};
+            }
+            osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+            osmium::builder::add_node(buffer, _id(m_next++));
+            return buffer;
+        }
+
+    }; // class NodeSource
+
+    osmium::object_id_type first_id(const osmium::memory::Buffer& buffer) {
+        return buffer.get<osmium::Node>(0).id();
+    }
+
+    // Stage function which takes longer for some buffers.
+    osmium::memory::Buffer slow_for_some(osmium::memory::Buffer&& buffer) {
+        if (first_id(buffer) % 5 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{2});
+        }
+        return std::move(buffer);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Pipeline without stages and sinks") {
+    osmium::thread::Pool pool{2};
+    osmium::thread::Pipeline pipeline{pool};
+    NodeSource source{10};
+    pipeline.run(source);
+    REQUIRE(pipeline.stats().empty());
+}
+
+TEST_CASE("Pipeline with ordered, unordered, and stateful stages") {
+    osmium::thread::Pool pool{4};
+    osmium::thread::Pipeline pipeline{pool, 4};
+
+    std::vector<osmium::object_id_type> after_ordered;
+    std::vector<osmium::object_id_type> after_unordered;
+    std::atomic<int> concurrent{0};
+    std::atomic<int> max_concurrent{0};
+
+    pipeline.add_stage("ordered", osmium::thread::stage_mode::ordered, slow_for_some);
+    pipeline.add_stage("check order", osmium::thread::stage_mode::stateful, [&](osmium::memory::Buffer&& buffer) {
+        after_ordered.push_back(first_id(buffer));
+        return std::move(buffer);
+    });
+    pipeline.add_stage("unordered", osmium::thread::stage_mode::unordered, [&](osmium::memory::Buffer&& buffer) {
+        const int c = ++concurrent;
+        int m = max_concurrent.load();
+        while (c > m && !max_concurrent.compare_exchange_weak(m, c)) {
+        }
+        auto result = slow_for_some(std::move(buffer));
+        --concurrent;
+        return result;
+    });
+    pipeline.add_stage("collect", osmium::thread::stage_mode::stateful, [&](osmium::memory::Buffer&& buffer) {
+        after_unordered.push_back(first_id(buffer));
+        return std::move(buffer);
+    });
+    REQUIRE(pipeline.num_stages() == 4);
+
+    NodeSource source{100};
+    pipeline.run(source);
+
+    REQUIRE(after_ordered.size() == 100);
+    REQUIRE(std::is_sorted(after_ordered.begin(), after_ordered.end()));
+
+    REQUIRE(after_unordered.size() == 100);
+    REQUIRE(max_concurrent <= 4);
+    std::sort(after_unordered.begin(), after_unordered.end());
+    REQUIRE(after_unordered == after_ordered);
+
+    const auto stats = pipeline.stats();
+    REQUIRE(stats.size() == 4);
+    REQUIRE(stats[0].name == "ordered");
+    REQUIRE(stats[0].mode == osmium::thread::stage_mode::ordered);
+    REQUIRE(stats[2].mode == osmium::thread::stage_mode::unordered);
+    for (const auto& s : stats) {
+        REQUIRE(s.buffers == 100);
+        REQUIRE(s.bytes > 0);
+        REQUIRE(s.input_queue.max_size == 4);
+        REQUIRE(s.input_queue.largest_size <= 4);
+    }
+    REQUIRE(stats[0].busy.count() > 0);
+    REQUIRE(stats[0].bytes_per_second() > 0.0);
+
+    std::ostringstream out;
+    out << stats[2];
+    REQUIRE(out.str().find("stage 'unordered' (unordered) handled 100 buffers") == 0);
+}
+
+TEST_CASE("Pipeline stage can drop buffers") {
+    osmium::thread::Pool pool{2};
+    osmium::thread::Pipeline pipeline{pool};
+
+    pipeline.add_stage("filter", osmium::thread::stage_mode::ordered, [](osmium::memory::Buffer&& buffer) {
+        if (first_id(buffer) % 2 == 0) {
+            return osmium::memory::Buffer{};
+        }
+        return std::move(buffer);
+    });
+    std::vector<osmium::object_id_type> ids;
+    pipeline.add_stage("collect", osmium::thread::stage_mode::stateful, [&](osmium::memory::Buffer&& buffer) {
+        ids.push_back(first_id(buffer));
+        return osmium::memory::Buffer{};
+    });
+
+    NodeSource source{10};
+    pipeline.run(source);
+    REQUIRE(ids == std::vector<osmium::object_id_type>({1, 3, 5, 7, 9}));
+    REQUIRE(pipeline.stats()[1].buffers == 5);
+}
+
+TEST_CASE("Pipeline with several sinks") {
+    osmium::thread::Pool pool{2};
+    osmium::thread::Pipeline pipeline{pool};
+
+    std::vector<osmium::object_id_type> ids1;
+    std::vector<osmium::object_id_type> ids2;
+    pipeline.add_stage("ordered", osmium::thread::stage_mode::ordered, slow_for_some);
+    pipeline.add_sink("sink1", [&](const osmium::memory::Buffer& buffer) {
+        ids1.push_back(first_id(buffer));
+    });
+    pipeline.add_sink("sink2", [&](const osmium::memory::Buffer& buffer) {
+        ids2.push_back(first_id(buffer));
+    });
+    REQUIRE(pipeline.num_sinks() == 2);
+
+    NodeSource source{30};
+    pipeline.run(source);
+
+    REQUIRE(ids1.size() == 30);
+    REQUIRE(std::is_sorted(ids1.begin(), ids1.end()));
+    REQUIRE(ids1 == ids2);
+
+    const auto stats = pipeline.stats();
+    REQUIRE(stats.size() == 3);
+    REQUIRE(stats[1].name == "sink1");
+    REQUIRE(stats[1].mode == osmium::thread::stage_mode::stateful);
+    REQUIRE(stats[2].buffers == 30);
+
+    REQUIRE_THROWS_AS(pipeline.run(source), const std::logic_error&);
+}
+
+TEST_CASE("Pipeline with sinks but no stages") {
+    osmium::thread::Pool pool{2};
+    osmium::thread::Pipeline pipeline{pool};
+
+    std::vector<osmium::object_id_type> ids;
+    pipeline.add_sink("sink", [&](const osmium::memory::Buffer& buffer) {
+        ids.push_back(first_id(buffer));
+    });
+
+    NodeSource source{5};
+    pipeline.run(source);
+    REQUIRE(ids == std::vector<osmium::object_id_type>({1, 2, 3, 4, 5}));
+}
+
+TEST_CASE("Pipeline rethrows exception from stage") {
+    osmium::thread::Pool pool{2};
+
+    for (const auto mode : {osmium::thread::stage_mode::ordered, osmium::thread::stage_mode::unordered, osmium::thread::stage_mode::stateful}) {
+        osmium::thread::Pipeline pipeline{pool, 2};
+        pipeline.add_stage("throw", mode, [](osmium::memory::Buffer&& buffer) {
+            if (first_id(buffer) == 17) {
+                throw std::runtime_error{"stage error"};
+            }
+            return std::move(buffer);
+        });
+        int count = 0;
+        pipeline.add_sink("count", [&](const osmium::memory::Buffer& /*buffer*/) {
+            ++count;
+        });
+
+        NodeSource source{1000};
+        REQUIRE_THROWS_WITH(pipeline.run(source), "stage error");
+        REQUIRE(count < 1000);
+        REQUIRE(pipeline.stats()[0].buffers < 1000);
+    }
+}
+
+TEST_CASE("Pipeline rethrows exception from sink") {
+    osmium::thread::Pool pool{2};
+    osmium::thread::Pipeline pipeline{pool};
+    pipeline.add_stage("ordered", osmium::thread::stage_mode::ordered, slow_for_some);
+    pipeline.add_sink("throw", [](const osmium::memory::Buffer& buffer) {
+        if (first_id(buffer) == 3) {
+            throw std::runtime_error{"sink error"};
+        }
+    });
+
+    NodeSource source{100};
+    REQUIRE_THROWS_WITH(pipeline.run(source), "sink error");
+}
+
+TEST_CASE("Pipeline rethrows exception from source") {
+    osmium::thread::Pool pool{2};
+    osmium::thread::Pipeline pipeline{pool};
+    int count = 0;
+    pipeline.add_stage("count", osmium::thread::stage_mode::stateful, [&](osmium::memory::Buffer&& buffer) {
+        ++count;
+        return std::move(buffer);
+    });
+
+    NodeSource source{100, 8};
+    REQUIRE_THROWS_WITH(pipeline.run(source), "source error");
+    REQUIRE(count <= 7);
+}
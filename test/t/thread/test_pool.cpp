@@ -1,8 +1,21 @@
 #include "catch.hpp"
 
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
 #include <osmium/thread/pool.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <numeric>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 struct test_job_with_result {
     int operator()() const {
@@ -104,3 +117,278 @@ TEST_CASE("can throw from job in user provided thread pool") {
     REQUIRE_THROWS_AS(future.get(), const std::runtime_error&);
 }
 
+
+TEST_CASE("can use thread pool with shared queue") {
+    osmium::thread::Pool pool{2, 0, osmium::thread::Pool::scheduling::shared_queue};
+    REQUIRE_FALSE(pool.work_stealing());
+    auto future = pool.submit(test_job_with_result{});
+    REQUIRE(future.get() == 42);
+}
+
+TEST_CASE("can send job to work-stealing thread pool") {
+    osmium::thread::Pool pool{3, 0, osmium::thread::Pool::scheduling::work_stealing};
+    REQUIRE(pool.work_stealing());
+    REQUIRE(pool.queue_empty());
+
+    auto future = pool.submit(test_job_with_result{});
+    REQUIRE(future.get() == 42);
+
+    auto future_throw = pool.submit(test_job_throw{});
+    REQUIRE_THROWS_AS(future_throw.get(), const std::runtime_error&);
+}
+
+TEST_CASE("can send jobs from within work-stealing thread pool") {
+    osmium::thread::Pool pool{4, 0, osmium::thread::Pool::scheduling::work_stealing};
+
+    // Each outer job submits inner jobs to the local queue of its worker
+    // thread. They are picked up by the other workers. The outer jobs
+    // don't wait for the inner jobs so this can't deadlock.
+    std::vector<std::future<std::vector<std::future<int>>>> outer;
+    for (int i = 0; i < 20; ++i) {
+        outer.push_back(pool.submit([&pool, i] {
+            std::vector<std::future<int>> inner;
+            for (int j = 0; j < 50; ++j) {
+                inner.push_back(pool.submit([i, j] {
+                    return i * 100 + j;
+                }));
+            }
+            return inner;
+        }));
+    }
+
+    int64_t sum = 0;
+    for (auto& future : outer) {
+        for (auto& inner : future.get()) {
+            sum += inner.get();
+        }
+    }
+
+    int64_t expected = 0;
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 50; ++j) {
+            expected += i * 100 + j;
+        }
+    }
+    REQUIRE(sum == expected);
+}
+
+TEST_CASE("can submit batch of jobs to thread pool") {
+    osmium::thread::Pool pool{3, 0, osmium::thread::Pool::scheduling::shared_queue};
+
+    std::vector<std::function<int()>> jobs;
+    for (int i = 0; i < 100; ++i) {
+        jobs.emplace_back([i] {
+            return i * 2;
+        });
+    }
+
+    auto futures = pool.submit_batch(jobs.begin(), jobs.end());
+    REQUIRE(futures.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(futures[static_cast<std::size_t>(i)].get() == i * 2);
+    }
+
+    std::vector<test_job_throw> throwing(2);
+    auto futures_throw = pool.submit_batch(throwing.begin(), throwing.end());
+    REQUIRE_THROWS_AS(futures_throw[0].get(), const std::runtime_error&);
+    REQUIRE_THROWS_AS(futures_throw[1].get(), const std::runtime_error&);
+
+    REQUIRE(pool.submit_batch(jobs.begin(), jobs.begin()).empty());
+}
+
+TEST_CASE("can submit batch of jobs from within work-stealing thread pool") {
+    osmium::thread::Pool pool{4, 0, osmium::thread::Pool::scheduling::work_stealing};
+
+    std::vector<std::future<std::vector<std::future<int>>>> outer;
+    for (int i = 0; i < 10; ++i) {
+        outer.push_back(pool.submit([&pool, i] {
+            std::vector<std::function<int()>> jobs;
+            for (int j = 0; j < 20; ++j) {
+                jobs.emplace_back([i, j] {
+                    return i * 100 + j;
+                });
+            }
+            return pool.submit_batch(jobs.begin(), jobs.end());
+        }));
+    }
+
+    int64_t sum = 0;
+    for (auto& future : outer) {
+        for (auto& inner : future.get()) {
+            sum += inner.get();
+        }
+    }
+    REQUIRE(sum == 10 * (20 * 19 / 2) + 20 * 100 * (10 * 9 / 2));
+    REQUIRE(pool.queue_empty());
+}
+
+TEST_CASE("parallel for over range in thread pool") {
+    osmium::thread::Pool pool{3};
+
+    std::vector<int> values(1000);
+    std::iota(values.begin(), values.end(), 1);
+
+    SECTION("iterators") {
+        std::atomic<int64_t> sum{0};
+        pool.parallel_for(values.begin(), values.end(), [&sum](int value) {
+            sum += value;
+        });
+        REQUIRE(sum == 1000 * 1001 / 2);
+    }
+
+    SECTION("range modifying items") {
+        pool.parallel_for(values, [](int& value) {
+            value *= 2;
+        });
+        REQUIRE(std::accumulate(values.begin(), values.end(), 0) == 1000 * 1001);
+    }
+
+    SECTION("fewer items than chunks") {
+        std::atomic<int> count{0};
+        pool.parallel_for(values.begin(), values.begin() + 2, [&count](int /*value*/) {
+            ++count;
+        });
+        REQUIRE(count == 2);
+    }
+
+    SECTION("empty range") {
+        pool.parallel_for(values.begin(), values.begin(), [](int /*value*/) {
+            REQUIRE(false);
+        });
+    }
+
+    SECTION("exception") {
+        std::atomic<int> count{0};
+        REQUIRE_THROWS_AS(pool.parallel_for(values, [&count](int value) {
+            ++count;
+            if (value == 999) {
+                throw std::runtime_error{"999"};
+            }
+        }), const std::runtime_error&);
+        REQUIRE(count >= 1);
+    }
+}
+
+TEST_CASE("parallel for over objects in buffer") {
+    osmium::thread::Pool pool{2};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_node(buffer, osmium::builder::attr::_id(id));
+    }
+
+    pool.parallel_for(buffer.select<osmium::Node>(), [](osmium::Node& node) {
+        node.set_version(static_cast<osmium::object_version_type>(node.id()));
+    });
+
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        REQUIRE(node.version() == static_cast<osmium::object_version_type>(node.id()));
+    }
+}
+
+TEST_CASE("thread pool keeps stats") {
+    osmium::thread::Pool pool{2};
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 10; ++i) {
+        futures.push_back(pool.submit(test_job_with_result{}));
+    }
+    for (auto& future : futures) {
+        REQUIRE(future.get() == 42);
+    }
+
+    const auto stats = pool.stats();
+    REQUIRE(stats.num_threads == 2);
+    REQUIRE(stats.work_queue.name == "work");
+    REQUIRE(stats.work_queue.push_count == 10);
+    REQUIRE(stats.uptime.count() > 0);
+    REQUIRE(stats.utilization() >= 0.0);
+    REQUIRE(stats.utilization() <= 1.0);
+}
+
+TEST_CASE("can send jobs through pool client") {
+    osmium::thread::Pool pool{2};
+    osmium::thread::PoolClient client{pool};
+
+    REQUIRE(&client.pool() == &pool);
+    REQUIRE(client.max_in_flight() == 4);
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 20; ++i) {
+        futures.push_back(client.submit(test_job_with_result{}));
+    }
+    for (auto& future : futures) {
+        REQUIRE(future.get() == 42);
+    }
+
+    auto future = client.submit(test_job_throw{});
+    REQUIRE_THROWS_AS(future.get(), const std::runtime_error&);
+}
+
+TEST_CASE("pool client limits jobs in flight") {
+    osmium::thread::Pool pool{4};
+    osmium::thread::PoolClient client{pool, 1, 2};
+
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 20; ++i) {
+        futures.push_back(client.submit([&running, &max_running]() {
+            const int now = ++running;
+            int max = max_running;
+            while (now > max && !max_running.compare_exchange_weak(max, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            --running;
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    REQUIRE(max_running > 0);
+    REQUIRE(max_running <= 2);
+}
+
+TEST_CASE("pool clients share pool according to their weights") {
+    osmium::thread::Pool pool{1, 100, osmium::thread::Pool::scheduling::shared_queue};
+    osmium::thread::PoolClient client_a{pool, 1, 100};
+    osmium::thread::PoolClient client_b{pool, 3, 100};
+
+    // Block the only worker until all jobs are queued.
+    std::promise<void> start;
+    std::shared_future<void> started{start.get_future()};
+    auto blocker = pool.submit([started]() {
+        started.wait();
+    });
+
+    std::mutex mutex;
+    std::vector<char> order;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 8; ++i) {
+        futures.push_back(client_a.submit([&]() {
+            const std::lock_guard<std::mutex> lock{mutex};
+            order.push_back('a');
+        }));
+    }
+    for (int i = 0; i < 8; ++i) {
+        futures.push_back(client_b.submit([&]() {
+            const std::lock_guard<std::mutex> lock{mutex};
+            order.push_back('b');
+        }));
+    }
+
+    start.set_value();
+    blocker.get();
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    REQUIRE(order.size() == 16);
+
+    // Although all jobs of client a were submitted first, client b gets
+    // three times as many of the first jobs run.
+    const auto b_first = std::count(order.begin(), order.begin() + 8, 'b');
+    REQUIRE(b_first == 6);
+}
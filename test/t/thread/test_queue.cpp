@@ -1,7 +1,13 @@
 #include "catch.hpp"
 
+#include <osmium/memory/budget.hpp>
 #include <osmium/thread/queue.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 TEST_CASE("Basic use of thread-safe queue") {
     osmium::thread::Queue<int> queue;
     REQUIRE(queue.empty());
@@ -18,3 +24,161 @@ TEST_CASE("Queue can have max elements and can be named") {
     osmium::thread::Queue<int> queue{100, "Queue of max size 100"};
 }
 
+
+TEST_CASE("Queue keeps stats") {
+    osmium::thread::Queue<int> queue{2, "stats"};
+    queue.push(1);
+    queue.push(2);
+
+    int value = 0;
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(queue.try_pop(value));
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.name == "stats");
+    REQUIRE(stats.max_size == 2);
+    REQUIRE(stats.size == 0);
+    REQUIRE(stats.largest_size == 2);
+    REQUIRE(stats.push_count == 2);
+    REQUIRE(stats.full_count == 0);
+    REQUIRE(stats.pop_count == 3);
+    REQUIRE(stats.empty_count == 1);
+    REQUIRE(stats.push_wait.count() == 0);
+    REQUIRE(stats.pop_wait.count() == 0);
+}
+
+TEST_CASE("Queue stats record time blocked in pop") {
+    osmium::thread::Queue<int> queue{10, "stats"};
+
+    std::thread producer{[&queue] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        queue.push(1);
+    }};
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    producer.join();
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.empty_count == 1);
+    REQUIRE(stats.pop_wait > std::chrono::milliseconds{0});
+}
+
+TEST_CASE("Queue can be limited by bytes") {
+    osmium::thread::Queue<int> queue{0, "bytes", 100};
+    queue.push(1, 60);
+    queue.push(2, 40);
+    REQUIRE(queue.bytes() == 100);
+
+    std::thread producer{[&queue] {
+        queue.push(3, 10);
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    REQUIRE(queue.size() == 2);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    producer.join();
+
+    REQUIRE(queue.size() == 2);
+    REQUIRE(queue.bytes() == 50);
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.max_bytes == 100);
+    REQUIRE(stats.bytes == 50);
+    REQUIRE(stats.largest_bytes == 100);
+    REQUIRE(stats.full_count == 1);
+}
+
+TEST_CASE("Queue limited by bytes always takes element if empty") {
+    osmium::thread::Queue<int> queue{0, "bytes", 100};
+    queue.push(1, 1000);
+    REQUIRE(queue.bytes() == 1000);
+
+    int value = 0;
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(queue.bytes() == 0);
+}
+
+TEST_CASE("Queue push_many keeps order") {
+    osmium::thread::Queue<int> queue;
+    std::vector<int> values{1, 2, 3, 4, 5};
+    queue.push_many(values.begin(), values.end());
+    REQUIRE(queue.size() == 5);
+    REQUIRE(queue.stats().push_count == 5);
+
+    for (int i = 1; i <= 5; ++i) {
+        int value = 0;
+        queue.wait_and_pop(value);
+        REQUIRE(value == i);
+    }
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Queue push_many blocks when queue is full") {
+    osmium::thread::Queue<int> queue{2};
+    std::vector<int> values(100);
+    for (int i = 0; i < 100; ++i) {
+        values[static_cast<std::size_t>(i)] = i;
+    }
+
+    std::thread producer{[&queue, &values] {
+        queue.push_many(values.begin(), values.end());
+    }};
+
+    for (int i = 0; i < 100; ++i) {
+        int value = -1;
+        queue.wait_and_pop(value);
+        REQUIRE(value == i);
+    }
+    producer.join();
+    REQUIRE(queue.empty());
+    REQUIRE(queue.stats().largest_size <= 2);
+}
+
+TEST_CASE("Queue with memory budget blocks while budget is exhausted") {
+    osmium::memory::MemoryBudget budget{100};
+    auto other = budget.add_account("other");
+    osmium::thread::Queue<int> queue{0, "budget"};
+    queue.set_memory_budget(budget);
+
+    // always allowed into an empty queue
+    queue.push(1, 60);
+    REQUIRE(budget.used() == 60);
+    queue.push(2, 40);
+    REQUIRE(budget.used() == 100);
+
+    std::atomic<bool> pushed{false};
+    std::thread producer{[&] {
+        queue.push(3, 10);
+        pushed = true;
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    REQUIRE_FALSE(pushed);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    producer.join();
+    REQUIRE(pushed);
+    REQUIRE(budget.used() == 50);
+
+    // memory used elsewhere counts, too
+    other.set(60);
+    pushed = false;
+    std::thread producer2{[&] {
+        queue.push(4, 10);
+        pushed = true;
+    }};
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    REQUIRE_FALSE(pushed);
+    other.set(0);
+    producer2.join();
+    REQUIRE(pushed);
+    REQUIRE(queue.size() == 3);
+    REQUIRE(budget.report() == "memory budget 100 bytes, used 60 bytes (peak 110): other 0, budget 60");
+}
@@ -0,0 +1,55 @@
+#include "catch.hpp"
+
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+using value_type = std::pair<int, std::size_t>;
+
+static bool less_first(const value_type& lhs, const value_type& rhs) noexcept {
+    return lhs.first < rhs.first;
+}
+
+static std::vector<value_type> create_data(std::size_t size) {
+    std::vector<value_type> data;
+    data.reserve(size);
+    unsigned int x = 12345;
+    for (std::size_t i = 0; i < size; ++i) {
+        x = x * 1103515245U + 12345U;
+        data.emplace_back(static_cast<int>((x >> 16U) % 1000U), i);
+    }
+    return data;
+}
+
+TEST_CASE("Parallel stable sort of small range") {
+    osmium::thread::Pool pool{4};
+    auto data = create_data(100);
+    auto expected = data;
+    std::stable_sort(expected.begin(), expected.end(), less_first);
+
+    osmium::thread::parallel_stable_sort(data.begin(), data.end(), less_first, pool);
+    REQUIRE(data == expected);
+}
+
+TEST_CASE("Parallel stable sort of empty range") {
+    osmium::thread::Pool pool{4};
+    std::vector<value_type> data;
+    osmium::thread::parallel_stable_sort(data.begin(), data.end(), less_first, pool);
+    REQUIRE(data.empty());
+}
+
+TEST_CASE("Parallel stable sort of large range is stable") {
+    for (const int threads : {2, 3, 7}) {
+        osmium::thread::Pool pool{threads};
+        auto data = create_data(200000);
+        auto expected = data;
+        std::stable_sort(expected.begin(), expected.end(), less_first);
+
+        osmium::thread::parallel_stable_sort(data.begin(), data.end(), less_first, pool);
+        REQUIRE(data == expected);
+    }
+}
@@ -32,6 +32,37 @@ TEST_CASE("get_pool_threads") {
     REQUIRE(osmium::config::get_pool_threads() == 2);
 }
 
+TEST_CASE("get_pool_affinity") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_pool_affinity() == 0);
+    REQUIRE(osmium::detail::name == "OSMIUM_POOL_AFFINITY");
+    osmium::detail::env = "none";
+    REQUIRE(osmium::config::get_pool_affinity() == 0);
+    osmium::detail::env = "spread";
+    REQUIRE(osmium::config::get_pool_affinity() == 1);
+    osmium::detail::env = "LOCAL";
+    REQUIRE(osmium::config::get_pool_affinity() == 2);
+    osmium::detail::env = "foo";
+    REQUIRE(osmium::config::get_pool_affinity() == 0);
+}
+
+TEST_CASE("use_work_stealing_pool") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_work_stealing_pool());
+    REQUIRE(osmium::detail::name == "OSMIUM_POOL_WORK_STEALING");
+    osmium::detail::env = "";
+    REQUIRE_FALSE(osmium::config::use_work_stealing_pool());
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_work_stealing_pool());
+
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_work_stealing_pool());
+    osmium::detail::env = "TRUE";
+    REQUIRE(osmium::config::use_work_stealing_pool());
+    osmium::detail::env = "1";
+    REQUIRE(osmium::config::use_work_stealing_pool());
+}
+
 TEST_CASE("use_pool_threads_for_pbf_parsing") {
     osmium::detail::env = nullptr;
     REQUIRE(osmium::config::use_pool_threads_for_pbf_parsing());
@@ -81,3 +112,24 @@ TEST_CASE("get_max_queue_size") {
     REQUIRE(osmium::config::get_max_queue_size("NAME", 7) == 3);
 }
 
+
+TEST_CASE("get_max_queue_bytes") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 0);
+    REQUIRE(osmium::detail::name == "OSMIUM_MAX_NAME_QUEUE_BYTES");
+
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 0);
+    osmium::detail::env = "foo";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 0);
+    osmium::detail::env = "M";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 0);
+    osmium::detail::env = "1000";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 1000);
+    osmium::detail::env = "3k";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 3 * 1024);
+    osmium::detail::env = "64M";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 64 * 1024 * 1024);
+    osmium::detail::env = "2g";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 2ULL * 1024 * 1024 * 1024);
+}
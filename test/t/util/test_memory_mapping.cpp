@@ -3,6 +3,8 @@
 #include <osmium/util/file.hpp>
 #include <osmium/util/memory_mapping.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <limits>
 #include <utility>
@@ -408,3 +410,127 @@ TEST_CASE("Anonymous memory mapping class: remapping to smaller size should work
 }
 #endif
 
+
+TEST_CASE("Anonymous mapping with transparent huge pages should work") {
+    osmium::AnonymousMemoryMapping mapping{10 * 1024 * 1024, osmium::MemoryMapping::huge_pages_mode::transparent};
+    REQUIRE(mapping.size() == 10 * 1024 * 1024);
+#ifdef _WIN32
+    REQUIRE(mapping.huge_pages() == osmium::MemoryMapping::huge_pages_mode::none);
+#else
+    REQUIRE(mapping.huge_pages() == osmium::MemoryMapping::huge_pages_mode::transparent);
+#endif
+
+    auto* addr = mapping.get_addr<int>();
+    addr[0] = 42;
+    addr[1024 * 1024] = 43;
+    REQUIRE(addr[0] == 42);
+    REQUIRE(addr[1024 * 1024] == 43);
+
+    mapping.unmap();
+    REQUIRE(!mapping);
+}
+
+#ifdef __linux__
+TEST_CASE("Anonymous mapping with hugetlb should work or fall back to transparent huge pages") {
+    osmium::AnonymousMemoryMapping mapping{1000, osmium::MemoryMapping::huge_pages_mode::hugetlb};
+    REQUIRE(mapping.size() == 1000);
+    REQUIRE(mapping.huge_pages() != osmium::MemoryMapping::huge_pages_mode::none);
+
+    auto* addr1 = mapping.get_addr<int>();
+    addr1[0] = 42;
+    addr1[200] = 43;
+
+    mapping.resize(8 * 1024 * 1024);
+    REQUIRE(mapping.size() == 8 * 1024 * 1024);
+
+    auto* addr2 = mapping.get_addr<int>();
+    REQUIRE(addr2[0] == 42);
+    REQUIRE(addr2[200] == 43);
+    addr2[2 * 1024 * 1024 - 1] = 44;
+    REQUIRE(addr2[2 * 1024 * 1024 - 1] == 44);
+
+    mapping.resize(500);
+    REQUIRE(mapping.get_addr<int>()[0] == 42);
+}
+
+TEST_CASE("Typed anonymous mapping with huge pages should work") {
+    osmium::TypedMemoryMapping<uint64_t> mapping{100000, osmium::MemoryMapping::huge_pages_mode::hugetlb};
+    REQUIRE(mapping.size() == 100000);
+    REQUIRE(mapping.huge_pages() != osmium::MemoryMapping::huge_pages_mode::none);
+
+    std::fill(mapping.begin(), mapping.end(), 17);
+    mapping.resize(200000);
+    REQUIRE(mapping.size() == 200000);
+    REQUIRE(mapping.begin()[99999] == 17);
+}
+#endif
+
+TEST_CASE("File-based mapping with transparent huge pages should work") {
+    char filename[] = "test_mmap_huge_pages_XXXXXX";
+    const int fd = mkstemp(filename);
+    REQUIRE(fd > 0);
+
+    {
+        osmium::MemoryMapping mapping{4 * 1024 * 1024, osmium::MemoryMapping::mapping_mode::write_shared, fd, 0, osmium::MemoryMapping::huge_pages_mode::hugetlb};
+#ifdef _WIN32
+        REQUIRE(mapping.huge_pages() == osmium::MemoryMapping::huge_pages_mode::none);
+#else
+        REQUIRE(mapping.huge_pages() == osmium::MemoryMapping::huge_pages_mode::transparent);
+#endif
+        *mapping.get_addr<int>() = 1234;
+        mapping.resize(8 * 1024 * 1024);
+        REQUIRE(*mapping.get_addr<int>() == 1234);
+        mapping.unmap();
+    }
+
+    REQUIRE(osmium::file_size(fd) == 8 * 1024 * 1024);
+
+    REQUIRE(0 == close(fd));
+    REQUIRE(0 == unlink(filename));
+}
+
+TEST_CASE("Access hints on anonymous mapping") {
+    osmium::MemoryMapping mapping{10000, osmium::MemoryMapping::mapping_mode::write_private};
+    REQUIRE(mapping.access() == osmium::MemoryMapping::access_hint::normal);
+
+    mapping.advise(osmium::MemoryMapping::access_hint::sequential);
+    REQUIRE(mapping.access() == osmium::MemoryMapping::access_hint::sequential);
+
+    *mapping.get_addr<int>() = 42;
+#ifdef __linux__
+    mapping.resize(20000);
+    REQUIRE(mapping.access() == osmium::MemoryMapping::access_hint::sequential);
+#endif
+    REQUIRE(*mapping.get_addr<int>() == 42);
+
+    osmium::MemoryMapping other{std::move(mapping)};
+    REQUIRE(other.access() == osmium::MemoryMapping::access_hint::sequential);
+}
+
+TEST_CASE("Access hints on file-based mapping") {
+    char filename[] = "test_mmap_access_hint_XXXXXX";
+    const int fd = mkstemp(filename);
+    REQUIRE(fd > 0);
+
+    {
+        osmium::TypedMemoryMapping<uint64_t> mapping{1000, osmium::MemoryMapping::mapping_mode::write_shared, fd};
+        mapping.advise(osmium::MemoryMapping::access_hint::sequential);
+        std::fill(mapping.begin(), mapping.end(), 17);
+
+        mapping.advise(osmium::MemoryMapping::access_hint::random);
+        mapping.resize(100000);
+        REQUIRE(mapping.access() == osmium::MemoryMapping::access_hint::random);
+        REQUIRE(mapping.begin()[999] == 17);
+
+        mapping.advise(osmium::MemoryMapping::access_hint::willneed);
+        REQUIRE(mapping.access() == osmium::MemoryMapping::access_hint::willneed);
+        REQUIRE(mapping.begin()[0] == 17);
+        mapping.unmap();
+
+        // Setting a hint on an unmapped mapping does nothing.
+        mapping.advise(osmium::MemoryMapping::access_hint::normal);
+    }
+
+    REQUIRE(0 == close(fd));
+    REQUIRE(0 == unlink(filename));
+}
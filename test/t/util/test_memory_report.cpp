@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <osmium/util/memory_report.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct Part {
+        std::size_t bytes = 0;
+
+        std::size_t used_memory() const noexcept {
+            return bytes;
+        }
+    };
+
+} // anonymous namespace
+
+TEST_CASE("Empty memory report") {
+    const osmium::MemoryReport report;
+    REQUIRE(report.size() == 0);
+
+    const auto snapshot = report.snapshot();
+    REQUIRE(snapshot.entries.empty());
+    REQUIRE(snapshot.total() == 0);
+#ifdef __linux__
+    REQUIRE(snapshot.process_current > 0);
+    REQUIRE(snapshot.process_peak >= snapshot.process_current);
+#endif
+}
+
+TEST_CASE("Memory report queries registered parts") {
+    Part part;
+    std::size_t other = 100;
+
+    osmium::MemoryReport report;
+    report.add("part", part);
+    report.add("other", [&other]() { return other; });
+    REQUIRE(report.size() == 2);
+
+    auto snapshot = report.snapshot();
+    REQUIRE(snapshot.entries.size() == 2);
+    REQUIRE(snapshot.entries[0].name == "part");
+    REQUIRE(snapshot.entries[0].bytes == 0);
+    REQUIRE(snapshot.entries[1].name == "other");
+    REQUIRE(snapshot.entries[1].bytes == 100);
+    REQUIRE(snapshot.total() == 100);
+
+    part.bytes = 2048;
+    other = 1024 * 1024;
+    snapshot = report.snapshot();
+    REQUIRE(snapshot.entries[0].bytes == 2048);
+    REQUIRE(snapshot.total() == 2048 + 1024 * 1024);
+
+    std::ostringstream out;
+    out << snapshot;
+    REQUIRE(out.str().find("other") != std::string::npos);
+    REQUIRE(out.str().find("1.0 MB") != std::string::npos);
+    REQUIRE(out.str().find("total") != std::string::npos);
+
+    report.remove("part");
+    REQUIRE(report.size() == 1);
+    REQUIRE(report.snapshot().entries[0].name == "other");
+}
+
+TEST_CASE("Memory report sampling") {
+    Part part;
+    part.bytes = 42;
+
+    osmium::MemoryReport report;
+    report.add("part", part);
+    REQUIRE_FALSE(report.sample_if_due());
+
+    std::vector<std::size_t> samples;
+    report.set_sampling(std::chrono::hours{1}, [&samples](const osmium::memory_snapshot& snapshot) {
+        samples.push_back(snapshot.total());
+    });
+
+    REQUIRE(report.sample_if_due());
+    REQUIRE_FALSE(report.sample_if_due());
+    REQUIRE(samples.size() == 1);
+    REQUIRE(samples[0] == 42);
+
+    report.set_sampling(std::chrono::seconds{0}, [&samples](const osmium::memory_snapshot& snapshot) {
+        samples.push_back(snapshot.total());
+    });
+    part.bytes = 43;
+    REQUIRE(report.sample_if_due());
+    REQUIRE(report.sample_if_due());
+    REQUIRE(samples.size() == 3);
+    REQUIRE(samples[2] == 43);
+}
@@ -126,6 +126,63 @@ TEST_CASE("String matcher: list with add") {
     REQUIRE_FALSE(m.match(""));
 }
 
+TEST_CASE("String matcher: long list with duplicates") {
+    osmium::StringMatcher::list m;
+    for (int n = 500; n > 0; --n) {
+        m.add_string("value" + std::to_string(n));
+        m.add_string("value" + std::to_string(n));
+    }
+    REQUIRE(m.strings().size() == 1000);
+    for (int n = 1; n <= 500; ++n) {
+        REQUIRE(m.match(("value" + std::to_string(n)).c_str()));
+    }
+    REQUIRE_FALSE(m.match("value0"));
+    REQUIRE_FALSE(m.match("value501"));
+    REQUIRE_FALSE(m.match("value"));
+    REQUIRE_FALSE(m.match(""));
+}
+
+TEST_CASE("Get exact strings from StringMatcher") {
+    std::vector<std::string> strings;
+
+    REQUIRE(osmium::StringMatcher{"foo"}.get_exact_strings(strings));
+    REQUIRE(strings == std::vector<std::string>{"foo"});
+
+    const osmium::StringMatcher list{std::vector<std::string>{"a", "b"}};
+    REQUIRE(list.get_exact_strings(strings));
+    REQUIRE(strings == (std::vector<std::string>{"foo", "a", "b"}));
+
+    strings.clear();
+    REQUIRE_FALSE(osmium::StringMatcher{osmium::StringMatcher::prefix{"foo"}}.get_exact_strings(strings));
+    REQUIRE_FALSE(osmium::StringMatcher{true}.get_exact_strings(strings));
+    REQUIRE(strings.empty());
+}
+
+TEST_CASE("String matcher with string length") {
+    const std::vector<std::string> strings{"", "a", "foo", "foobar", "xfoo", "fo", "bar", "foox"};
+    std::vector<osmium::StringMatcher> matchers{
+        osmium::StringMatcher::always_false{},
+        osmium::StringMatcher::always_true{},
+        osmium::StringMatcher::equal{"foo"},
+        osmium::StringMatcher::equal{""},
+        osmium::StringMatcher::prefix{"foo"},
+        osmium::StringMatcher::prefix{""},
+        osmium::StringMatcher::substring{"foo"},
+        osmium::StringMatcher::list{{"bar", "foo", "a"}},
+        osmium::StringMatcher::list{}
+    };
+#ifdef OSMIUM_WITH_REGEX
+    matchers.emplace_back(std::regex{"^fo+$"});
+#endif
+
+    for (const auto& matcher : matchers) {
+        for (const auto& str : strings) {
+            INFO("matcher=" << matcher << " string=" << str);
+            REQUIRE(matcher(str.c_str(), str.size()) == matcher(str.c_str()));
+        }
+    }
+}
+
 TEST_CASE("Default constructed StringMatcher matches nothing") {
     osmium::StringMatcher m;
     REQUIRE_FALSE(m("foo"));
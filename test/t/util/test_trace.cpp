@@ -0,0 +1,76 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/handler.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/util/trace.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+TEST_CASE("Trace scope without tracer doesn't emit anything") {
+    osmium::util::ChromeTraceWriter tracer;
+    REQUIRE(osmium::util::get_tracer() == nullptr);
+    {
+        const osmium::util::TraceScope trace{osmium::util::trace_stage::decode, 1};
+    }
+    REQUIRE(tracer.size() == 0);
+}
+
+TEST_CASE("Trace scope emits begin and end events") {
+    osmium::util::ChromeTraceWriter tracer;
+    osmium::util::set_tracer(&tracer);
+    {
+        const osmium::util::TraceScope trace{osmium::util::trace_stage::decode, 17};
+    }
+    osmium::util::set_tracer(nullptr);
+
+    const auto events = tracer.events();
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].stage == osmium::util::trace_stage::decode);
+    REQUIRE(events[0].begin);
+    REQUIRE(events[0].sequence == 17);
+    REQUIRE_FALSE(events[1].begin);
+    REQUIRE(events[1].sequence == 17);
+    REQUIRE(events[0].thread == events[1].thread);
+    REQUIRE(events[0].time <= events[1].time);
+
+    std::ostringstream out;
+    tracer.write(out);
+    const std::string json = out.str();
+    REQUIRE(json.find(R"({"traceEvents":[)") == 0);
+    REQUIRE(json.find(R"("name":"decode","cat":"osmium","ph":"B")") != std::string::npos);
+    REQUIRE(json.find(R"("ph":"E")") != std::string::npos);
+    REQUIRE(json.find(R"("tid":1,"args":{"sequence":17}})") != std::string::npos);
+
+    tracer.clear();
+    REQUIRE(tracer.size() == 0);
+}
+
+TEST_CASE("Reader and apply() emit trace events") {
+    osmium::util::ChromeTraceWriter tracer;
+    osmium::util::set_tracer(&tracer);
+
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm")};
+    osmium::handler::Handler handler;
+    osmium::apply(reader, handler);
+    reader.close();
+
+    osmium::util::set_tracer(nullptr);
+
+    const auto events = tracer.events();
+    const auto count = [&events](osmium::util::trace_stage stage) {
+        return std::count_if(events.cbegin(), events.cend(), [stage](const osmium::util::trace_event& event) {
+            return event.stage == stage;
+        });
+    };
+
+    REQUIRE(count(osmium::util::trace_stage::read) >= 2);
+    REQUIRE(count(osmium::util::trace_stage::queue_wait) >= 2);
+    REQUIRE(count(osmium::util::trace_stage::handler) >= 2);
+    REQUIRE(count(osmium::util::trace_stage::read) % 2 == 0);
+    REQUIRE(count(osmium::util::trace_stage::handler) % 2 == 0);
+}